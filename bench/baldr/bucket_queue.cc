@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "baldr/bitmap_bucket_queue.h"
+#include "baldr/double_bucket_queue.h"
+
+using namespace valhalla;
+
+namespace {
+
+struct simple_label {
+  float c;
+  float sortcost() const {
+    return c;
+  }
+};
+
+// About the size of a BDEdgeLabel, so that reading the sort cost of a label costs a cache line
+struct fat_label {
+  float c;
+  char cold[76];
+  float sortcost() const {
+    return c;
+  }
+};
+
+// Simulates a label setting search: pop the cheapest label, then add a few successors which are a
+// bit more expensive and occasionally decrease the cost of one that is already queued. The spread
+// of the increments relative to the bucket range decides how often the overflow path is taken.
+template <typename queue_t, typename label_t = simple_label>
+void BM_Expansion(benchmark::State& state) {
+  const float range = static_cast<float>(state.range(0));
+  const float max_increment = static_cast<float>(state.range(1));
+  const size_t num_pops = 100000;
+
+  std::vector<label_t> labels;
+  std::vector<bool> queued;
+  labels.reserve(num_pops * 3 + 1);
+  queue_t queue(0, range, 1, &labels);
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> dis(0, 1);
+
+  for (auto _ : state) {
+    queue.clear();
+    labels.clear();
+    queued.clear();
+    labels.push_back(label_t{0.f});
+    queued.push_back(true);
+    queue.add(0);
+    for (size_t i = 0; i < num_pops; ++i) {
+      const uint32_t label = queue.pop();
+      if (label == baldr::kInvalidLabel) {
+        break;
+      }
+      queued[label] = false;
+      const float cost = labels[label].sortcost();
+      for (int j = 0; j < 3; ++j) {
+        const float newcost = std::floor(cost + 1 + dis(gen) * max_increment);
+        if (j == 0 && labels.size() > 1) {
+          const uint32_t other = static_cast<uint32_t>(dis(gen) * (labels.size() - 1));
+          if (queued[other] && newcost < labels[other].sortcost()) {
+            queue.decrease(other, newcost);
+            labels[other].c = newcost;
+          }
+          continue;
+        }
+        labels.push_back(label_t{newcost});
+        queued.push_back(true);
+        queue.add(labels.size() - 1);
+      }
+    }
+    benchmark::DoNotOptimize(labels.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_pops);
+}
+
+// {bucket range, max cost increment}: increments well within the range, about the range and far
+// beyond it (the latter stresses the overflow handling)
+#define QUEUE_ARGS                                                                                 \
+  Args({100000, 100})->Args({1000, 1000})->Args({200, 20000})->Unit(benchmark::kMillisecond)
+
+BENCHMARK_TEMPLATE(BM_Expansion, baldr::DoubleBucketQueue<simple_label>)->QUEUE_ARGS;
+BENCHMARK_TEMPLATE(BM_Expansion, baldr::BitmapBucketQueue<simple_label>)->QUEUE_ARGS;
+BENCHMARK_TEMPLATE(BM_Expansion, baldr::DoubleBucketQueue<fat_label>, fat_label)->QUEUE_ARGS;
+
+} // namespace
+
+BENCHMARK_MAIN();
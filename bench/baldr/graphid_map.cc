@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphid.h"
+#include "midgard/flat_hash.h"
+
+using namespace valhalla;
+
+namespace {
+
+// Edge ids as an expansion visits them: a handful of neighbouring tiles and runs of edges in each
+std::vector<baldr::GraphId> expansion_ids(const size_t count) {
+  std::vector<baldr::GraphId> ids;
+  ids.reserve(count);
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<uint32_t> tile(750000, 750016), edge(0, 200000), run(1, 8);
+  while (ids.size() < count) {
+    const auto t = tile(gen), e = edge(gen);
+    for (uint32_t i = run(gen); i > 0 && ids.size() < count; --i) {
+      ids.emplace_back(t, 2, e + i);
+    }
+  }
+  return ids;
+}
+
+// Inserts the ids as a search labels edges and then looks each one up a few times, as the
+// expansion does when it comes across an edge again and when it recovers the path
+template <typename map_t> void BM_InsertFind(benchmark::State& state) {
+  const auto ids = expansion_ids(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    map_t map;
+    uint32_t index = 0;
+    for (const auto& id : ids) {
+      map.emplace(id, index++);
+    }
+    uint64_t sum = 0;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+      for (const auto& id : ids) {
+        auto found = map.find(id);
+        sum += found == map.end() ? 0 : found->second;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * ids.size() * 4);
+}
+
+#define MAP_ARGS Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond)
+
+BENCHMARK_TEMPLATE(BM_InsertFind, std::unordered_map<baldr::GraphId, uint32_t>)->MAP_ARGS;
+BENCHMARK_TEMPLATE(BM_InsertFind, midgard::flat_map<baldr::GraphId, uint32_t>)->MAP_ARGS;
+BENCHMARK_TEMPLATE(BM_InsertFind, std::unordered_map<uint64_t, uint32_t>)->MAP_ARGS;
+BENCHMARK_TEMPLATE(BM_InsertFind, midgard::flat_map<uint64_t, uint32_t>)->MAP_ARGS;
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "baldr/predictedspeeds.h"
+
+using namespace valhalla;
+
+namespace {
+
+// Decodes the speed of a handful of profiles at buckets spread over the week, which is what
+// costing does for every edge a time dependent search relaxes
+void BM_DecompressSpeedBucket(benchmark::State& state) {
+  const uint32_t profile_count = 64;
+  std::vector<int16_t> profiles;
+  profiles.reserve(profile_count * baldr::kCoefficientCount);
+  for (uint32_t p = 0; p < profile_count; ++p) {
+    std::vector<float> speeds(baldr::kBucketsPerWeek);
+    for (uint32_t b = 0; b < baldr::kBucketsPerWeek; ++b) {
+      speeds[b] = 40.f + 20.f * std::sin((b + p * 13) / 30.f);
+    }
+    const auto coefficients = baldr::compress_speed_buckets(speeds.data());
+    profiles.insert(profiles.end(), coefficients.begin(), coefficients.end());
+  }
+
+  uint32_t i = 0;
+  for (auto _ : state) {
+    const auto* coefficients = &profiles[(i % profile_count) * baldr::kCoefficientCount];
+    benchmark::DoNotOptimize(
+        baldr::decompress_speed_bucket(coefficients, (i * 37) % baldr::kBucketsPerWeek));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_DecompressSpeedBucket);
+
+// Decodes the base64 speeds of an edge, which adding predicted traffic does for every edge of the
+// speed files
+void BM_DecodeCompressedSpeeds(benchmark::State& state) {
+  std::vector<float> speeds(baldr::kBucketsPerWeek);
+  for (uint32_t b = 0; b < baldr::kBucketsPerWeek; ++b) {
+    speeds[b] = 40.f + 20.f * std::sin(b / 30.f);
+  }
+  const auto coefficients = baldr::compress_speed_buckets(speeds.data());
+  const auto encoded = baldr::encode_compressed_speeds(coefficients.data());
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(baldr::decode_compressed_speeds(encoded));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_DecodeCompressedSpeeds);
+
+} // namespace
+
+BENCHMARK_MAIN();
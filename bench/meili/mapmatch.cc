@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 #include <benchmark/benchmark.h>
@@ -117,6 +119,74 @@ static void BM_ManyCases(benchmark::State& state) {
 
 BENCHMARK(BM_ManyCases)->DenseRange(0, kBenchmarkCases.size() - 1);
 
+// The alternatives are ranked after the best match so asking for more should cost little more
+BENCHMARK_DEFINE_F(OfflineMapmatchFixture, TopKOfflineMatch)(benchmark::State& state) {
+  logging::Configure({{"type", ""}});
+  rapidjson::Document doc;
+  doc.Parse(LoadFile(kBenchmarkCases[3]).c_str());
+  std::vector<Measurement> meas;
+  for (const auto& point : doc["shape"].GetArray()) {
+    meas.emplace_back(PointLL(point["lon"].GetDouble(), point["lat"].GetDouble()),
+                      kGpsAccuracyMeters, kSearchRadiusMeters);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mapmatcher_->OfflineMatch(meas, state.range(0)));
+  }
+}
+
+BENCHMARK_REGISTER_F(OfflineMapmatchFixture, TopKOfflineMatch)->Arg(1)->Arg(2)->Arg(4);
+
+std::vector<valhalla::baldr::GraphId> MatchedEdges(MapMatcherFactory& factory,
+                                                   const valhalla::Options& options,
+                                                   const std::vector<Measurement>& meas) {
+  std::unique_ptr<MapMatcher> matcher(factory.Create(options));
+  std::vector<valhalla::baldr::GraphId> edges;
+  for (const auto& result : matcher->OfflineMatch(meas).front().results) {
+    edges.push_back(result.edgeid);
+  }
+  return edges;
+}
+
+// Matching with the viterbi search pruned to a beam of the cheapest candidates of each measurement,
+// the agreement counter is the share of the measurements matched to the same edge as without it
+static void BM_BeamOfflineMatch(benchmark::State& state) {
+  logging::Configure({{"type", ""}});
+  boost::property_tree::ptree config;
+  rapidjson::read_json(VALHALLA_SOURCE_DIR "bench/meili/config.json", config);
+  valhalla::Options options;
+  const rapidjson::Document options_doc;
+  valhalla::sif::ParseCosting(options_doc, "/costing_options", options);
+  options.set_costing_type(valhalla::Costing::auto_);
+
+  rapidjson::Document doc;
+  doc.Parse(LoadFile(kBenchmarkCases[3]).c_str());
+  std::vector<Measurement> meas;
+  for (const auto& point : doc["shape"].GetArray()) {
+    meas.emplace_back(PointLL(point["lon"].GetDouble(), point["lat"].GetDouble()),
+                      kGpsAccuracyMeters, kSearchRadiusMeters);
+  }
+
+  MapMatcherFactory full_factory(config);
+  const auto expected = MatchedEdges(full_factory, options, meas);
+
+  config.put("meili.default.beam_width", state.range(0));
+  MapMatcherFactory factory(config);
+  std::unique_ptr<MapMatcher> matcher(factory.Create(options));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher->OfflineMatch(meas));
+  }
+
+  const auto edges = MatchedEdges(factory, options, meas);
+  size_t agreeing = 0;
+  for (size_t i = 0; i < std::min(edges.size(), expected.size()); ++i) {
+    agreeing += edges[i] == expected[i];
+  }
+  state.counters["agreement"] = expected.empty() ? 1. : double(agreeing) / expected.size();
+  state.SetItemsProcessed(state.iterations() * meas.size());
+}
+
+BENCHMARK(BM_BeamOfflineMatch)->Arg(0)->Arg(1)->Arg(2)->Arg(4);
+
 } // namespace
 
 BENCHMARK_MAIN();
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "midgard/util.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// A wiggly shape of the given number of points near the point being projected, along with a few
+// points to project onto it, which is what candidate search in loki and meili does for every edge
+struct projection_fixture_t {
+  explicit projection_fixture_t(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      points.emplace_back(13.26 + i * 0.0001, 38.15 + 0.00005 * std::sin(i * 0.7));
+    }
+    for (const auto& p : points) {
+      shape.lons.push_back(p.lng());
+      shape.lats.push_back(p.lat());
+    }
+    for (size_t i = 0; i < 8; ++i) {
+      projectors.emplace_back(PointLL(13.26 + i * 0.0002, 38.1502 - i * 0.00005));
+    }
+  }
+
+  std::vector<PointLL> points;
+  shape_soa_t shape;
+  std::vector<projector_t> projectors;
+};
+
+// Projects onto each segment in turn as loki and meili used to
+void BM_ProjectSegments(benchmark::State& state) {
+  projection_fixture_t fixture(state.range(0));
+  for (auto _ : state) {
+    for (const auto& projector : fixture.projectors) {
+      double best = std::numeric_limits<double>::max();
+      PointLL best_point;
+      for (size_t i = 0; i + 1 < fixture.points.size(); ++i) {
+        auto point = projector(fixture.points[i], fixture.points[i + 1]);
+        auto sq_distance = projector.approx.DistanceSquared(point);
+        if (sq_distance < best) {
+          best = sq_distance;
+          best_point = point;
+        }
+      }
+      benchmark::DoNotOptimize(best_point);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * fixture.projectors.size() *
+                          (fixture.points.size() - 1));
+}
+
+// Projects onto all of the segments of the decoded shape at once
+void BM_ProjectClosestSegment(benchmark::State& state) {
+  projection_fixture_t fixture(state.range(0));
+  for (auto _ : state) {
+    for (const auto& projector : fixture.projectors) {
+      PointLL point;
+      double sq_distance;
+      benchmark::DoNotOptimize(projector.closest_segment(fixture.shape, point, sq_distance));
+      benchmark::DoNotOptimize(point);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * fixture.projectors.size() *
+                          (fixture.points.size() - 1));
+}
+
+BENCHMARK(BM_ProjectSegments)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_ProjectClosestSegment)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+} // namespace
+
+BENCHMARK_MAIN();
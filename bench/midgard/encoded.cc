@@ -0,0 +1,154 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "midgard/encoded.h"
+#include "midgard/pointll.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// The byte at a time implementation encoded.h had before, kept as the baseline
+namespace reference {
+
+std::string encode(const std::vector<PointLL>& points, const int precision = ENCODE_PRECISION) {
+  std::string output;
+  output.reserve(points.size() * 8);
+  auto serialize = [&output](int number) {
+    number = number < 0 ? ~(static_cast<unsigned int>(number) << 1) : (number << 1);
+    while (number >= 0x20) {
+      output.push_back(static_cast<char>((0x20 | (number & 0x1f)) + 63));
+      number >>= 5;
+    }
+    output.push_back(static_cast<char>(number + 63));
+  };
+  int last_lon = 0, last_lat = 0;
+  for (const auto& p : points) {
+    int lon = static_cast<int>(std::round(static_cast<double>(p.first) * precision));
+    int lat = static_cast<int>(std::round(static_cast<double>(p.second) * precision));
+    serialize(lat - last_lat);
+    serialize(lon - last_lon);
+    last_lon = lon;
+    last_lat = lat;
+  }
+  return output;
+}
+
+std::vector<PointLL> decode(const std::string& encoded, const double precision = DECODE_PRECISION) {
+  const char* begin = encoded.data();
+  const char* end = begin + encoded.size();
+  auto next = [&](const int32_t previous) {
+    int byte, shift = 0, result = 0;
+    do {
+      if (begin == end) {
+        throw std::runtime_error("Bad encoded polyline");
+      }
+      byte = int32_t(*begin++) - 63;
+      result |= (byte & 0x1f) << shift;
+      shift += 5;
+    } while (byte >= 0x20);
+    return previous + (result & 1 ? ~(result >> 1) : (result >> 1));
+  };
+  std::vector<PointLL> points;
+  points.reserve(encoded.size() / 4);
+  int32_t lat = 0, lon = 0;
+  while (begin != end) {
+    lat = next(lat);
+    lon = next(lon);
+    points.emplace_back(double(lon) * precision, double(lat) * precision);
+  }
+  return points;
+}
+
+} // namespace reference
+
+// A random walk with steps of up to about 100m, like the shape of a route
+std::vector<PointLL> make_shape(const size_t size) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> step(-0.001, 0.001);
+  std::vector<PointLL> shape;
+  shape.reserve(size);
+  PointLL ll(5.1079374, 52.0887174);
+  for (size_t i = 0; i < size; ++i) {
+    ll = PointLL(ll.lng() + step(gen), ll.lat() + step(gen));
+    shape.push_back(ll);
+  }
+  return shape;
+}
+
+void BM_EncodeReference(benchmark::State& state) {
+  const auto shape = make_shape(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(reference::encode(shape));
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_Encode(benchmark::State& state) {
+  const auto shape = make_shape(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(encode(shape));
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_EncodeReusedBuffer(benchmark::State& state) {
+  const auto shape = make_shape(state.range(0));
+  std::string buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    encode(shape, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_Encode7(benchmark::State& state) {
+  const auto shape = make_shape(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(encode7(shape));
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_DecodeReference(benchmark::State& state) {
+  const auto encoded = encode(make_shape(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(reference::decode(encoded));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Decode(benchmark::State& state) {
+  const auto encoded = encode(make_shape(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(decode<std::vector<PointLL>>(encoded));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Decode7(benchmark::State& state) {
+  const auto encoded = encode7(make_shape(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(decode7<std::vector<PointLL>>(encoded));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// a short edge, a route and a long trace
+#define SHAPE_SIZES Arg(10)->Arg(1000)->Arg(100000)
+
+BENCHMARK(BM_EncodeReference)->SHAPE_SIZES;
+BENCHMARK(BM_Encode)->SHAPE_SIZES;
+BENCHMARK(BM_EncodeReusedBuffer)->SHAPE_SIZES;
+BENCHMARK(BM_Encode7)->SHAPE_SIZES;
+BENCHMARK(BM_DecodeReference)->SHAPE_SIZES;
+BENCHMARK(BM_Decode)->SHAPE_SIZES;
+BENCHMARK(BM_Decode7)->SHAPE_SIZES;
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <limits>
+#include <list>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "midgard/linesegment2.h"
+#include "midgard/pointll.h"
+#include "midgard/polyline2.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// The recursive implementation polyline2.cc had before, kept as the baseline
+namespace reference {
+
+template <class coord_t, class container_t>
+void DouglasPeucker(container_t& polyline,
+                    typename coord_t::value_type epsilon,
+                    const std::unordered_set<size_t>& exclusions) {
+  if (epsilon <= 0 || polyline.size() < 3)
+    return;
+
+  epsilon *= epsilon;
+  std::function<void(typename container_t::iterator, size_t, typename container_t::iterator, size_t)>
+      peucker;
+  peucker = [&peucker, &polyline, epsilon, &exclusions](typename container_t::iterator start,
+                                                        size_t s, typename container_t::iterator end,
+                                                        size_t e) {
+    typename coord_t::value_type dmax = std::numeric_limits<typename coord_t::value_type>::lowest();
+    typename container_t::iterator itr;
+    LineSegment2<coord_t> l{*start, *end};
+    size_t j = e - 1, k = 0;
+    coord_t tmp;
+    for (auto i = std::prev(end); i != start; --i, --j) {
+      if (exclusions.find(j) != exclusions.end()) {
+        itr = i;
+        dmax = epsilon;
+        k = j;
+        break;
+      }
+      auto d = l.DistanceSquared(*i, tmp);
+      if (d > dmax) {
+        itr = i;
+        dmax = d;
+        k = j;
+      }
+    }
+    if (dmax >= epsilon) {
+      if (e - k > 1)
+        peucker(itr, k, end, e);
+      if (k - s > 1)
+        peucker(start, s, itr, k);
+    } else
+      polyline.erase(std::next(start), end);
+  };
+
+  peucker(polyline.begin(), 0, std::prev(polyline.end()), polyline.size() - 1);
+}
+
+} // namespace reference
+
+// A random walk with steps of up to about 100m, like the outline of an isochrone or a long route
+template <class coord_t> std::vector<coord_t> make_shape(const size_t size) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> step(-0.001, 0.001);
+  std::vector<coord_t> shape;
+  shape.reserve(size);
+  coord_t ll(5.1079374, 52.0887174);
+  for (size_t i = 0; i < size; ++i) {
+    ll = coord_t(ll.first + step(gen), ll.second + step(gen));
+    shape.push_back(ll);
+  }
+  return shape;
+}
+
+// meters for the geographic shapes and degrees for the planar ones
+template <class coord_t> typename coord_t::value_type epsilon() {
+  return std::is_same<coord_t, PointLL>::value ? 20 : 0.0002;
+}
+
+template <class coord_t, class container_t>
+void BM_GeneralizeReference(benchmark::State& state) {
+  const auto shape = make_shape<coord_t>(state.range(0));
+  for (auto _ : state) {
+    container_t polyline(shape.begin(), shape.end());
+    reference::DouglasPeucker<coord_t>(polyline, epsilon<coord_t>(), {});
+    benchmark::DoNotOptimize(polyline);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+template <class coord_t, class container_t> void BM_Generalize(benchmark::State& state) {
+  const auto shape = make_shape<coord_t>(state.range(0));
+  for (auto _ : state) {
+    container_t polyline(shape.begin(), shape.end());
+    Polyline2<coord_t>::Generalize(polyline, epsilon<coord_t>(), {});
+    benchmark::DoNotOptimize(polyline);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+void BM_GeneralizeAvoidSelfIntersection(benchmark::State& state) {
+  const auto shape = make_shape<PointLL>(state.range(0));
+  for (auto _ : state) {
+    auto polyline = shape;
+    Polyline2<PointLL>::Generalize(polyline, epsilon<PointLL>(), {}, true);
+    benchmark::DoNotOptimize(polyline);
+  }
+  state.SetItemsProcessed(state.iterations() * shape.size());
+}
+
+// an edge, a route and a large isochrone contour
+#define SHAPE_SIZES Arg(10)->Arg(1000)->Arg(100000)
+
+BENCHMARK_TEMPLATE(BM_GeneralizeReference, PointLL, std::vector<PointLL>)->SHAPE_SIZES;
+BENCHMARK_TEMPLATE(BM_Generalize, PointLL, std::vector<PointLL>)->SHAPE_SIZES;
+BENCHMARK_TEMPLATE(BM_GeneralizeReference, PointLL, std::list<PointLL>)->SHAPE_SIZES;
+BENCHMARK_TEMPLATE(BM_Generalize, PointLL, std::list<PointLL>)->SHAPE_SIZES;
+BENCHMARK_TEMPLATE(BM_GeneralizeReference, PointXY<double>, std::vector<PointXY<double>>)
+    ->SHAPE_SIZES;
+BENCHMARK_TEMPLATE(BM_Generalize, PointXY<double>, std::vector<PointXY<double>>)->SHAPE_SIZES;
+BENCHMARK(BM_GeneralizeAvoidSelfIntersection)->SHAPE_SIZES;
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "loki/search.h"
+#include "midgard/pointll.h"
+#include "sif/costfactory.h"
+#include "test.h"
+#include "thor/astar_bss.h"
+#include "thor/bidirectional_astar_bss.h"
+#include <valhalla/proto/options.pb.h>
+
+using namespace valhalla;
+
+namespace {
+
+// A few locations around the bike share stations of the Marais. Origins and destinations are
+// constructed from these for the queries
+const std::vector<midgard::PointLL> paris_locations = {
+    {2.361374, 48.864655},   {2.36117, 48.859608},  {2.3716413, 48.8601411},
+    {2.3602581, 48.8594916}, {2.369113, 48.865020}, {2.36101, 48.859782},
+};
+
+template <class Algorithm> void BM_ParisBikeShare(benchmark::State& state) {
+  const auto config = test::make_config("test/data/paris_bss_tiles");
+  auto clean_reader = test::make_clean_graphreader(config.get_child("mjolnir"));
+
+  Options options;
+  options.set_costing_type(Costing::bikeshare);
+  rapidjson::Document doc;
+  sif::ParseCosting(doc, "/costing_options", options);
+  sif::TravelMode mode;
+  auto costs = sif::CostFactory().CreateModeCosting(options, mode);
+  auto cost = costs[static_cast<size_t>(mode)];
+
+  std::vector<baldr::Location> locations(paris_locations.begin(), paris_locations.end());
+  const auto projections = loki::Search(locations, *clean_reader, cost);
+  if (projections.size() != locations.size()) {
+    throw std::runtime_error("Found no matching locations");
+  }
+
+  // Route from every location to every other one
+  std::vector<valhalla::Location> origins;
+  std::vector<valhalla::Location> destinations;
+  for (const auto& from : locations) {
+    for (const auto& to : locations) {
+      if (&from == &to) {
+        continue;
+      }
+      origins.emplace_back();
+      baldr::PathLocation::toPBF(projections.at(from), &origins.back(), *clean_reader);
+      destinations.emplace_back();
+      baldr::PathLocation::toPBF(projections.at(to), &destinations.back(), *clean_reader);
+    }
+  }
+
+  std::size_t route_size = 0;
+  Algorithm astar;
+  for (auto _ : state) {
+    for (size_t i = 0; i < origins.size(); ++i) {
+      auto result = astar.GetBestPath(origins[i], destinations[i], *clean_reader, costs,
+                                      sif::TravelMode::kPedestrian);
+      astar.Clear();
+      route_size += !result.empty();
+    }
+  }
+  if (route_size == 0) {
+    throw std::runtime_error("Failed all routes");
+  }
+  state.counters["Routes"] = route_size;
+}
+
+BENCHMARK_TEMPLATE(BM_ParisBikeShare, thor::AStarBSSAlgorithm)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ParisBikeShare, thor::BidirectionalAStarBSS)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
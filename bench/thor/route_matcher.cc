@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "baldr/rapidjson_utils.h"
+#include "midgard/logging.h"
+#include "test.h"
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+// routes across Utrecht whose shapes are traced back onto the graph
+const std::vector<std::string> kRoutes = {
+    R"({"locations":[{"lon":5.115873,"lat":52.099247},{"lon":5.135983,"lat":52.110116}],
+        "costing":"auto"})",
+    R"({"locations":[{"lon":5.112481,"lat":52.074073},{"lon":5.095273,"lat":52.108956}],
+        "costing":"auto"})",
+    R"({"locations":[{"lon":5.110077,"lat":52.062043},{"lon":5.025595,"lat":52.067372}],
+        "costing":"auto"})",
+};
+
+// the trace_route requests for the shapes of the routes, matched the given way
+std::vector<std::string> make_traces(tyr::actor_t& actor, const std::string& shape_match) {
+  std::vector<std::string> traces;
+  for (const auto& route : kRoutes) {
+    rapidjson::Document response;
+    response.Parse(actor.route(route));
+    const auto& shape = response["trip"]["legs"][0]["shape"];
+    traces.push_back(R"({"encoded_polyline":")" +
+                     std::string(shape.GetString(), shape.GetStringLength()) +
+                     R"(","costing":"auto","shape_match":")" + shape_match + R"("})");
+  }
+  return traces;
+}
+
+// Traces the shapes of routes, which edge_walk expects, by walking the edges or by map matching
+void BM_TraceRouteShape(benchmark::State& state, const std::string& shape_match) {
+  logging::Configure({{"type", ""}});
+  tyr::actor_t actor(test::make_config("test/data/utrecht_tiles"), true);
+  const auto traces = make_traces(actor, shape_match);
+  size_t traced = 0;
+  for (auto _ : state) {
+    for (const auto& trace : traces) {
+      benchmark::DoNotOptimize(actor.trace_route(trace));
+      ++traced;
+    }
+  }
+  state.SetItemsProcessed(traced);
+}
+
+BENCHMARK_CAPTURE(BM_TraceRouteShape, edge_walk, std::string("edge_walk"))
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraceRouteShape, map_snap, std::string("map_snap"))
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,579 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/bitmap_bucket_queue.h"
+#include "baldr/double_bucket_queue.h"
+#include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
+#include "sif/costfactory.h"
+#include "sif/edgelabel.h"
+#include "thor/astarheuristic.h"
+#include "thor/pathalgorithm.h"
+
+using namespace valhalla;
+
+namespace {
+
+/*
+ * Replays the priority queue operations of real searches against several queue implementations.
+ * The traces come from A* searches over the Utrecht tiles with auto costing, done the way the
+ * bidirectional A* does one direction: edge labels sorted by cost plus heuristic, decreases when a
+ * cheaper way to a queued edge is found. Each trace is a sequence of adds, decreases and pops, so
+ * every queue gets the same realistic mix of the three.
+ */
+
+// Number of searches recorded and how far apart, as the crow flies, their ends must be
+constexpr size_t kTraceCount = 8;
+constexpr float kMinRouteLength = 12000.f;
+constexpr size_t kMaxOpsPerTrace = 4000000;
+
+struct queue_op_t {
+  enum kind_t : uint8_t { kAdd, kDecrease, kPop };
+  kind_t kind;
+  uint32_t label;
+  float cost;
+};
+
+struct trace_t {
+  std::vector<queue_op_t> ops;
+  uint32_t label_count = 0;
+  float mincost = 0;
+  uint32_t bucketsize = 1;
+};
+
+// the label the searches sort, only used while recording
+struct search_label_t {
+  float sortcost_;
+  float cost;
+  baldr::GraphId endnode;
+  float sortcost() const {
+    return sortcost_;
+  }
+};
+
+// About the size of a BDEdgeLabel so that the bucket queues pay for reading sort costs from labels
+// the way they do in the searches
+struct replay_label_t {
+  float c;
+  char cold[sizeof(sif::BDEdgeLabel) - sizeof(float)];
+  float sortcost() const {
+    return c;
+  }
+};
+
+// Records one search from the origin node until the destination node is settled
+trace_t record(baldr::GraphReader& reader,
+               const sif::cost_ptr_t& costing,
+               const baldr::GraphId& origin,
+               const baldr::GraphId& destination) {
+  trace_t trace;
+  thor::AStarHeuristic heuristic;
+  auto dest_tile = reader.GetGraphTile(destination);
+  heuristic.Init(dest_tile->get_node_ll(destination), costing->AStarCostFactor());
+  auto orig_tile = reader.GetGraphTile(origin);
+  trace.mincost = heuristic.Get(orig_tile->get_node_ll(origin));
+  trace.bucketsize = costing->UnitSize();
+
+  std::vector<search_label_t> labels;
+  std::vector<bool> settled;
+  std::unordered_map<baldr::GraphId, uint32_t> status;
+  baldr::DoubleBucketQueue<search_label_t> queue(trace.mincost,
+                                                 thor::kBucketCount * trace.bucketsize,
+                                                 trace.bucketsize, &labels);
+
+  auto expand = [&](const baldr::GraphId& node, const float pred_cost) {
+    auto tile = reader.GetGraphTile(node);
+    if (!tile) {
+      return;
+    }
+    const auto* nodeinfo = tile->node(node);
+    for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i) {
+      const uint32_t index = nodeinfo->edge_index() + i;
+      const auto* edge = tile->directededge(index);
+      if (edge->is_shortcut() || !costing->Allowed(edge, tile)) {
+        continue;
+      }
+      auto end_tile = reader.GetGraphTile(edge->endnode());
+      if (!end_tile) {
+        continue;
+      }
+      const float cost = pred_cost + costing->EdgeCost(edge, tile).cost;
+      const float sortcost = cost + heuristic.Get(end_tile->get_node_ll(edge->endnode()));
+      const baldr::GraphId edge_id(node.tileid(), node.level(), index);
+      auto found = status.find(edge_id);
+      if (found == status.end()) {
+        status.emplace(edge_id, labels.size());
+        labels.push_back({sortcost, cost, edge->endnode()});
+        settled.push_back(false);
+        queue.add(labels.size() - 1);
+        trace.ops.push_back({queue_op_t::kAdd, static_cast<uint32_t>(labels.size() - 1), sortcost});
+      } else if (!settled[found->second] && cost < labels[found->second].cost) {
+        // the queue needs the old cost to find the label
+        queue.decrease(found->second, sortcost);
+        labels[found->second] = {sortcost, cost, edge->endnode()};
+        trace.ops.push_back({queue_op_t::kDecrease, found->second, sortcost});
+      }
+    }
+  };
+
+  expand(origin, 0);
+  while (trace.ops.size() < kMaxOpsPerTrace) {
+    const uint32_t label = queue.pop();
+    if (label == baldr::kInvalidLabel) {
+      break;
+    }
+    trace.ops.push_back({queue_op_t::kPop, label, 0});
+    settled[label] = true;
+    if (labels[label].endnode == destination) {
+      break;
+    }
+    expand(labels[label].endnode, labels[label].cost);
+  }
+  trace.label_count = labels.size();
+  return trace;
+}
+
+std::vector<trace_t> record_traces() {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", "test/data/utrecht_tiles");
+  baldr::GraphReader reader(conf);
+
+  Options options;
+  options.set_costing_type(Costing::auto_);
+  (*options.mutable_costings())[Costing::auto_];
+  auto costing = sif::CostFactory{}.Create(options);
+
+  // every node of the local level, in a stable order so the traces are the same every run
+  const uint8_t level = baldr::TileHierarchy::levels().back().level;
+  std::vector<baldr::GraphId> nodes;
+  for (const auto& tile_id : reader.GetTileSet(level)) {
+    auto tile = reader.GetGraphTile(tile_id);
+    for (uint32_t i = 0; tile && i < tile->header()->nodecount(); ++i) {
+      nodes.emplace_back(tile_id.tileid(), level, i);
+    }
+  }
+  std::sort(nodes.begin(), nodes.end());
+  if (nodes.empty()) {
+    throw std::runtime_error("No nodes in the utrecht tiles");
+  }
+
+  // long searches between random nodes, short ones or ones that found nothing don't count
+  std::vector<trace_t> traces;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+  for (size_t attempt = 0; traces.size() < kTraceCount && attempt < kTraceCount * 100; ++attempt) {
+    const auto& origin = nodes[pick(gen)];
+    const auto& destination = nodes[pick(gen)];
+    const auto orig_ll = reader.GetGraphTile(origin)->get_node_ll(origin);
+    const auto dest_ll = reader.GetGraphTile(destination)->get_node_ll(destination);
+    if (orig_ll.Distance(dest_ll) < kMinRouteLength) {
+      continue;
+    }
+    auto trace = record(reader, costing, origin, destination);
+    if (trace.label_count > 10000) {
+      traces.emplace_back(std::move(trace));
+    }
+  }
+  if (traces.empty()) {
+    throw std::runtime_error("Could not record any searches");
+  }
+  return traces;
+}
+
+const std::vector<trace_t>& traces() {
+  static const std::vector<trace_t> recorded = record_traces();
+  return recorded;
+}
+
+/**
+ * Monotone radix heap on the bits of the float costs. Decreases push the label again and leave the
+ * old entry behind, stale entries are dropped when they come up. Costs below the last popped one
+ * are treated as equal to it, like the bucket queues do.
+ */
+template <typename label_t> class RadixHeap {
+public:
+  RadixHeap(const float mincost,
+            const float range,
+            const uint32_t bucketsize,
+            const std::vector<label_t>* labelcontainer) {
+    reuse(mincost, range, bucketsize, labelcontainer);
+  }
+
+  void reuse(const float, const float, const uint32_t, const std::vector<label_t>* labelcontainer) {
+    labelcontainer_ = labelcontainer;
+    last_ = 0;
+  }
+
+  void clear() {
+    for (auto& bucket : buckets_) {
+      bucket.clear();
+    }
+    keys_.clear();
+    last_ = 0;
+  }
+
+  void add(const uint32_t label) {
+    push(label, (*labelcontainer_)[label].sortcost());
+  }
+
+  void decrease(const uint32_t label, const float newcost) {
+    push(label, newcost);
+  }
+
+  uint32_t pop() {
+    while (true) {
+      if (buckets_[0].empty()) {
+        // the lowest non empty bucket has the new minimum, its entries all go to lower buckets
+        size_t i = 1;
+        while (i < kBuckets && buckets_[i].empty()) {
+          ++i;
+        }
+        if (i == kBuckets) {
+          return baldr::kInvalidLabel;
+        }
+        auto& bucket = buckets_[i];
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                    [this](const entry_t& e) { return keys_[e.label] != e.key; }),
+                     bucket.end());
+        if (bucket.empty()) {
+          continue;
+        }
+        last_ = std::min_element(bucket.begin(), bucket.end(), [](const auto& a, const auto& b) {
+                  return a.key < b.key;
+                })->key;
+        for (const auto& e : bucket) {
+          buckets_[index(e.key)].push_back(e);
+        }
+        bucket.clear();
+      }
+      const auto e = buckets_[0].back();
+      buckets_[0].pop_back();
+      if (keys_[e.label] == e.key) {
+        keys_[e.label] = kPopped;
+        return e.label;
+      }
+    }
+  }
+
+private:
+  static constexpr size_t kBuckets = 33;
+  static constexpr uint32_t kPopped = std::numeric_limits<uint32_t>::max();
+
+  struct entry_t {
+    uint32_t key;
+    uint32_t label;
+  };
+
+  // non negative floats sort the same as their bits
+  uint32_t to_key(const float cost) const {
+    const float positive = std::max(cost, 0.f);
+    uint32_t key;
+    std::memcpy(&key, &positive, sizeof(key));
+    return std::max(key, last_);
+  }
+
+  size_t index(const uint32_t key) const {
+    return key == last_ ? 0 : 32 - __builtin_clz(key ^ last_);
+  }
+
+  void push(const uint32_t label, const float cost) {
+    if (label >= keys_.size()) {
+      keys_.resize(label + 1, kPopped);
+    }
+    const uint32_t key = to_key(cost);
+    keys_[label] = key;
+    buckets_[index(key)].push_back({key, label});
+  }
+
+  const std::vector<label_t>* labelcontainer_;
+  std::vector<entry_t> buckets_[kBuckets];
+  std::vector<uint32_t> keys_;
+  uint32_t last_;
+};
+
+/**
+ * Indexed 4-ary min heap, the position of every label in the heap is kept for decreases.
+ */
+template <typename label_t> class QuaternaryHeap {
+public:
+  QuaternaryHeap(const float mincost,
+                 const float range,
+                 const uint32_t bucketsize,
+                 const std::vector<label_t>* labelcontainer) {
+    reuse(mincost, range, bucketsize, labelcontainer);
+  }
+
+  void reuse(const float, const float, const uint32_t, const std::vector<label_t>* labelcontainer) {
+    labelcontainer_ = labelcontainer;
+  }
+
+  void clear() {
+    heap_.clear();
+  }
+
+  void add(const uint32_t label) {
+    if (label >= positions_.size()) {
+      positions_.resize(label + 1);
+    }
+    heap_.push_back({(*labelcontainer_)[label].sortcost(), label});
+    sift_up(heap_.size() - 1);
+  }
+
+  void decrease(const uint32_t label, const float newcost) {
+    const uint32_t i = positions_[label];
+    heap_[i].first = newcost;
+    sift_up(i);
+  }
+
+  uint32_t pop() {
+    if (heap_.empty()) {
+      return baldr::kInvalidLabel;
+    }
+    const uint32_t top = heap_.front().second;
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+      sift_down(0);
+    }
+    return top;
+  }
+
+private:
+  using entry_t = std::pair<float, uint32_t>;
+
+  void place(const uint32_t i, const entry_t& e) {
+    heap_[i] = e;
+    positions_[e.second] = i;
+  }
+
+  void sift_up(uint32_t i) {
+    const entry_t e = heap_[i];
+    while (i > 0) {
+      const uint32_t parent = (i - 1) / 4;
+      if (heap_[parent].first <= e.first) {
+        break;
+      }
+      place(i, heap_[parent]);
+      i = parent;
+    }
+    place(i, e);
+  }
+
+  void sift_down(uint32_t i) {
+    const entry_t e = heap_[i];
+    const uint32_t n = heap_.size();
+    while (true) {
+      const uint32_t first = 4 * i + 1;
+      if (first >= n) {
+        break;
+      }
+      uint32_t best = first;
+      for (uint32_t c = first + 1; c < std::min(first + 4, n); ++c) {
+        if (heap_[c].first < heap_[best].first) {
+          best = c;
+        }
+      }
+      if (heap_[best].first >= e.first) {
+        break;
+      }
+      place(i, heap_[best]);
+      i = best;
+    }
+    place(i, e);
+  }
+
+  const std::vector<label_t>* labelcontainer_;
+  std::vector<entry_t> heap_;
+  std::vector<uint32_t> positions_;
+};
+
+/**
+ * Pairing heap with a node per label, decreases cut the label from its parent and meld it back
+ * with the root. Pops merge the children of the root in two passes.
+ */
+template <typename label_t> class PairingHeap {
+public:
+  PairingHeap(const float mincost,
+              const float range,
+              const uint32_t bucketsize,
+              const std::vector<label_t>* labelcontainer) {
+    reuse(mincost, range, bucketsize, labelcontainer);
+  }
+
+  void reuse(const float, const float, const uint32_t, const std::vector<label_t>* labelcontainer) {
+    labelcontainer_ = labelcontainer;
+  }
+
+  void clear() {
+    root_ = baldr::kInvalidLabel;
+  }
+
+  void add(const uint32_t label) {
+    if (label >= nodes_.size()) {
+      nodes_.resize(label + 1);
+    }
+    nodes_[label] = {(*labelcontainer_)[label].sortcost(), baldr::kInvalidLabel,
+                     baldr::kInvalidLabel, baldr::kInvalidLabel};
+    root_ = meld(root_, label);
+  }
+
+  void decrease(const uint32_t label, const float newcost) {
+    auto& node = nodes_[label];
+    node.key = newcost;
+    if (label == root_) {
+      return;
+    }
+    // cut it out of the list of children it is in
+    auto& prev = nodes_[node.prev];
+    if (prev.child == label) {
+      prev.child = node.sibling;
+    } else {
+      prev.sibling = node.sibling;
+    }
+    if (node.sibling != baldr::kInvalidLabel) {
+      nodes_[node.sibling].prev = node.prev;
+    }
+    node.sibling = node.prev = baldr::kInvalidLabel;
+    root_ = meld(root_, label);
+  }
+
+  uint32_t pop() {
+    const uint32_t top = root_;
+    if (top != baldr::kInvalidLabel) {
+      root_ = merge_pairs(nodes_[top].child);
+    }
+    return top;
+  }
+
+private:
+  struct node_t {
+    float key;
+    uint32_t child;
+    uint32_t sibling;
+    uint32_t prev; // the parent of a first child, the left sibling of the others
+  };
+
+  // makes the root with the larger key the first child of the other one
+  uint32_t meld(uint32_t a, uint32_t b) {
+    if (a == baldr::kInvalidLabel) {
+      return b;
+    }
+    if (b == baldr::kInvalidLabel) {
+      return a;
+    }
+    if (nodes_[b].key < nodes_[a].key) {
+      std::swap(a, b);
+    }
+    auto& parent = nodes_[a];
+    auto& child = nodes_[b];
+    child.sibling = parent.child;
+    if (parent.child != baldr::kInvalidLabel) {
+      nodes_[parent.child].prev = b;
+    }
+    child.prev = a;
+    parent.child = b;
+    return a;
+  }
+
+  uint32_t detach(const uint32_t label) {
+    nodes_[label].sibling = nodes_[label].prev = baldr::kInvalidLabel;
+    return label;
+  }
+
+  uint32_t merge_pairs(uint32_t first) {
+    pairs_.clear();
+    while (first != baldr::kInvalidLabel) {
+      const uint32_t second = nodes_[first].sibling;
+      if (second == baldr::kInvalidLabel) {
+        pairs_.push_back(detach(first));
+        break;
+      }
+      const uint32_t next = nodes_[second].sibling;
+      pairs_.push_back(meld(detach(first), detach(second)));
+      first = next;
+    }
+    uint32_t root = baldr::kInvalidLabel;
+    for (auto pair = pairs_.rbegin(); pair != pairs_.rend(); ++pair) {
+      root = meld(*pair, root);
+    }
+    return root;
+  }
+
+  const std::vector<label_t>* labelcontainer_;
+  std::vector<node_t> nodes_;
+  std::vector<uint32_t> pairs_;
+  uint32_t root_ = baldr::kInvalidLabel;
+};
+
+template <typename queue_t> void BM_ReplaySearches(benchmark::State& state) {
+  const auto& recorded = traces();
+  size_t max_labels = 0, ops = 0, decreases = 0;
+  for (const auto& trace : recorded) {
+    max_labels = std::max<size_t>(max_labels, trace.label_count);
+    ops += trace.ops.size();
+    for (const auto& op : trace.ops) {
+      decreases += op.kind == queue_op_t::kDecrease;
+    }
+  }
+
+  // the labels are allocated up front so that the queues can hold on to them
+  std::vector<replay_label_t> labels(max_labels);
+  std::vector<bool> queued(max_labels);
+  queue_t queue(0, 1, 1, &labels);
+  for (auto _ : state) {
+    for (const auto& trace : recorded) {
+      queue.clear();
+      queue.reuse(trace.mincost, thor::kBucketCount * trace.bucketsize, trace.bucketsize, &labels);
+      std::fill(queued.begin(), queued.begin() + trace.label_count, false);
+      for (const auto& op : trace.ops) {
+        switch (op.kind) {
+          case queue_op_t::kAdd:
+            labels[op.label].c = op.cost;
+            queued[op.label] = true;
+            queue.add(op.label);
+            break;
+          case queue_op_t::kDecrease:
+            // queues may break ties differently, a label this one popped already is left alone
+            if (queued[op.label]) {
+              queue.decrease(op.label, op.cost);
+              labels[op.label].c = op.cost;
+            }
+            break;
+          case queue_op_t::kPop: {
+            const uint32_t label = queue.pop();
+            if (label != baldr::kInvalidLabel) {
+              queued[label] = false;
+            }
+            break;
+          }
+        }
+      }
+      benchmark::DoNotOptimize(labels.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * ops);
+  state.counters["searches"] = recorded.size();
+  state.counters["decrease_ratio"] = static_cast<double>(decreases) / ops;
+}
+
+BENCHMARK_TEMPLATE(BM_ReplaySearches, baldr::DoubleBucketQueue<replay_label_t>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplaySearches, baldr::BitmapBucketQueue<replay_label_t>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplaySearches, RadixHeap<replay_label_t>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplaySearches, QuaternaryHeap<replay_label_t>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplaySearches, PairingHeap<replay_label_t>)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
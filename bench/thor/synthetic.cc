@@ -0,0 +1,77 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#include "synthetic.h"
+#include "test.h"
+#include "tyr/actor.h"
+
+using namespace valhalla;
+
+namespace {
+
+// the networks are only generated once for all the benchmarks of a size
+const gurka::map& network(uint32_t cities) {
+  static std::map<uint32_t, gurka::map> networks;
+  auto found = networks.find(cities);
+  if (found != networks.end()) {
+    return found->second;
+  }
+
+  gurka::synthetic::network_options options;
+  options.cities_x = options.cities_y = cities;
+  options.blocks = 20;
+  options.traffic_ratio = 0.2;
+  auto config = test::make_config("test/data/synthetic_" + std::to_string(cities),
+                                  {{"mjolnir.concurrency", "4"}});
+  return networks.emplace(cities, gurka::synthetic::buildtiles(options, config)).first->second;
+}
+
+std::string route_request(const midgard::PointLL& from, const midgard::PointLL& to) {
+  return R"({"locations":[{"lat":)" + std::to_string(from.lat()) +
+         R"(,"lon":)" + std::to_string(from.lng()) + R"(},{"lat":)" +
+         std::to_string(to.lat()) + R"(,"lon":)" + std::to_string(to.lng()) +
+         R"(}],"costing":"auto","date_time":{"type":0}})";
+}
+
+/**
+ * Routes on synthetic networks of range(0) by range(0) cities. The route either stays in the
+ * south west city, when range(1) is 0, or crosses the whole network to the north east city, so the
+ * two show how the size of the graph affects local and long searches.
+ */
+void BM_SyntheticRoute(benchmark::State& state) {
+  const auto cities = static_cast<uint32_t>(state.range(0));
+  const bool local = state.range(1) == 0;
+  const auto& map = network(cities);
+
+  const auto& from = map.nodes.at(gurka::synthetic::city(0, 0));
+  auto to = local ? midgard::PointLL(from.lng() + 0.01, from.lat() + 0.005)
+                  : map.nodes.at(gurka::synthetic::city(cities - 1, cities - 1));
+  const auto request = route_request(from, to);
+
+  tyr::actor_t actor(map.config, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(actor.route(request));
+  }
+  state.counters["Routes"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+
+void SyntheticSizes(benchmark::internal::Benchmark* b) {
+  for (int cities : {1, 2, 4, 8}) {
+    for (int across : {0, 1}) {
+      b->Args({cities, across});
+    }
+  }
+}
+
+BENCHMARK(BM_SyntheticRoute)
+    ->Apply(SyntheticSizes)
+    ->ArgNames({"cities", "across"})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "midgard/logging.h"
+#include "proto_conversions.h"
+#include "sif/dynamiccost.h"
+#include "test.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+#if !defined(VALHALLA_SOURCE_DIR)
+#define VALHALLA_SOURCE_DIR
+#endif
+
+// every allocation of the process, the difference over a request is what the request allocated
+std::atomic<uint64_t> allocations{0};
+
+} // namespace
+
+// count the allocations, memory is still handed out by malloc
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+struct request_t {
+  Options::Action action;
+  std::string json;
+};
+
+/*
+ * Reads a corpus of requests, one per line. Lines are either json requests, as in a .jsonl file, or
+ * the -j '{...}' lines of the test_requests files. The action of a request is its "action" member
+ * if it has one or the default action otherwise. Empty lines and lines starting with # are skipped
+ */
+std::vector<request_t> load_requests(const std::string& path, Options::Action default_action) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Could not open the request corpus " + path);
+  }
+  std::vector<request_t> requests;
+  std::string line;
+  while (std::getline(file, line)) {
+    auto begin = line.find_first_not_of(" \t");
+    if (begin == std::string::npos || line[begin] == '#') {
+      continue;
+    }
+    line = line.substr(begin);
+    if (line.compare(0, 3, "-j ") == 0) {
+      auto first = line.find('\'');
+      auto last = line.rfind('\'');
+      if (first == std::string::npos || last == first) {
+        continue;
+      }
+      line = line.substr(first + 1, last - first - 1);
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(line);
+    if (doc.HasParseError() || !doc.IsObject()) {
+      std::cerr << "Skipping a request which is not a json object in " << path << std::endl;
+      continue;
+    }
+    request_t request{default_action, {}};
+    auto action = doc.FindMember("action");
+    if (action != doc.MemberEnd()) {
+      if (!action->value.IsString() ||
+          !Options_Action_Enum_Parse(action->value.GetString(), &request.action)) {
+        std::cerr << "Skipping a request with an unknown action in " << path << std::endl;
+        continue;
+      }
+      doc.RemoveMember(action);
+    }
+    request.json = rapidjson::to_string(doc);
+    requests.push_back(std::move(request));
+  }
+  return requests;
+}
+
+/*
+ * Runs the requests of one action through the actor, one request per iteration in turn. Next to
+ * the mean time per request it reports the median and 99th percentile latency, the allocations per
+ * request and how many of the requests failed
+ */
+void BM_Action(benchmark::State& state,
+               tyr::actor_t* actor,
+               const std::vector<request_t>* requests) {
+  std::vector<double> latencies;
+  uint64_t allocated = 0;
+  size_t failures = 0;
+  size_t next = 0;
+  for (auto _ : state) {
+    const auto& request = (*requests)[next++ % requests->size()];
+    const auto before = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    try {
+      Api api;
+      ParseApi(request.json, request.action, api);
+      benchmark::DoNotOptimize(actor->act(api));
+    } catch (const std::exception&) { ++failures; }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    latencies.push_back(elapsed.count());
+    allocated += allocations.load(std::memory_order_relaxed) - before;
+  }
+
+  if (latencies.empty()) {
+    return;
+  }
+  if (failures == latencies.size()) {
+    state.SkipWithError("All of the requests failed");
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+  };
+  state.counters["p50_ms"] = percentile(0.5);
+  state.counters["p99_ms"] = percentile(0.99);
+  state.counters["allocs_per_request"] = static_cast<double>(allocated) / latencies.size();
+  state.counters["failures"] = failures;
+  state.counters["requests"] = requests->size();
+}
+
+/*
+ * Recosts the paths of the routes in the corpus under a handful of costings, the whole batch in
+ * each iteration, the way fleets or profiles are compared on the same paths
+ */
+void BM_Recost(benchmark::State& state,
+               tyr::actor_t* actor,
+               const std::vector<std::vector<baldr::GraphId>>* paths,
+               const std::vector<Costing>* costings) {
+  size_t recosts = 0, failures = 0;
+  for (auto _ : state) {
+    actor->recost(*paths, *costings,
+                  [&](size_t, size_t, const std::vector<sif::Cost>& elapsed) {
+                    ++recosts;
+                    failures += elapsed.empty();
+                  });
+  }
+  state.counters["recosts"] = benchmark::Counter(recosts, benchmark::Counter::kIsRate);
+  state.counters["failures"] =
+      static_cast<double>(failures) / std::max<size_t>(1, state.iterations());
+  state.counters["paths"] = paths->size();
+}
+
+} // namespace
+
+/*
+ * Benchmarks every action end to end through the actor, from parsing the json request to the
+ * serialized response. By default it runs the corpus in bench/tyr/fixtures against the Utrecht
+ * tiles, any tile set and corpus can be used instead:
+ *
+ *   --config=<file>    a valhalla config, its mjolnir section says where the tiles are
+ *   --requests=<file>  a corpus of requests, may be repeated, see load_requests for the format
+ *   --action=<action>  the action of the requests in a corpus without one, route by default
+ *
+ * Each action of the corpora gets a benchmark of its own, e.g. BM_Action/trace_attributes, and
+ * the paths of the routes are recosted in batches by BM_Recost
+ */
+int main(int argc, char** argv) {
+  logging::Configure({{"type", ""}});
+
+  std::string config_path;
+  std::vector<std::string> corpora;
+  Options::Action default_action = Options::route;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 9, "--config=") == 0) {
+      config_path = arg.substr(9);
+    } else if (arg.compare(0, 11, "--requests=") == 0) {
+      corpora.push_back(arg.substr(11));
+    } else if (arg.compare(0, 9, "--action=") == 0) {
+      if (!Options_Action_Enum_Parse(arg.substr(9), &default_action)) {
+        std::cerr << "Unknown action " << arg.substr(9) << std::endl;
+        return 1;
+      }
+    }
+  }
+  if (corpora.empty()) {
+    corpora.emplace_back(VALHALLA_SOURCE_DIR "bench/tyr/fixtures/utrecht.jsonl");
+  }
+
+  boost::property_tree::ptree config;
+  if (config_path.empty()) {
+    config = test::make_config("test/data/utrecht_tiles");
+  } else {
+    rapidjson::read_json(config_path, config);
+  }
+
+  // the requests of each action, in the order of the corpora
+  std::map<Options::Action, std::vector<request_t>> requests;
+  for (const auto& corpus : corpora) {
+    for (auto& request : load_requests(corpus, default_action)) {
+      requests[request.action].push_back(std::move(request));
+    }
+  }
+
+  tyr::actor_t actor(config, true);
+  for (const auto& action : requests) {
+    ::benchmark::RegisterBenchmark(("BM_Action/" + Options_Action_Enum_Name(action.first)).c_str(),
+                                   BM_Action, &actor, &action.second)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+
+  // the paths of the routes, one per leg, for recosting under some other costings
+  std::vector<std::vector<baldr::GraphId>> paths;
+  const auto routes = requests.find(Options::route);
+  for (const auto& request :
+       routes == requests.end() ? std::vector<request_t>{} : routes->second) {
+    try {
+      Api api;
+      ParseApi(request.json, request.action, api);
+      actor.act(api);
+      for (const auto& leg : api.trip().routes(0).legs()) {
+        paths.emplace_back();
+        for (const auto& node : leg.node()) {
+          if (node.has_edge()) {
+            paths.back().emplace_back(node.edge().id());
+          }
+        }
+      }
+    } catch (const std::exception&) {}
+  }
+  std::vector<Costing> costings;
+  for (const auto* costing : {"auto", "truck", "bus", "motorcycle", "bicycle", "pedestrian"}) {
+    rapidjson::Document doc;
+    doc.Parse(std::string(R"({"costing":")") + costing + R"("})");
+    costings.emplace_back();
+    sif::ParseCosting(doc, "", &costings.back());
+  }
+  if (!paths.empty()) {
+    ::benchmark::RegisterBenchmark("BM_Recost", BM_Recost, &actor, &paths, &costings)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+
+  ::benchmark::Initialize(&argc, argv);
+  ::benchmark::RunSpecifiedBenchmarks();
+}
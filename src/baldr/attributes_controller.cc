@@ -2,144 +2,206 @@
 #include "midgard/logging.h"
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace valhalla {
 namespace baldr {
 
+namespace {
+
+struct attribute_info_t {
+  Attribute key;
+  const char* name;
+  bool enabled;
+};
+
 /*
- * Map of attributes that a user can request to enable or disable, and their defaults.
- * Most attributes are enabled by default but a few additional attributes are disabled
- * unless explicitly included with the filter attributes request option.
+ * The attributes that a user can request to enable or disable, their names and their defaults in
+ * the order of their ids. Most attributes are enabled by default but a few additional attributes
+ * are disabled unless explicitly included with the filter attributes request option.
  */
-const std::unordered_map<std::string, bool> AttributesController::kDefaultAttributes = {
+constexpr attribute_info_t kAttributes[] = {
     // Edge keys
-    {kEdgeNames, true},
-    {kEdgeLength, true},
-    {kEdgeSpeed, true},
-    {kEdgeRoadClass, true},
-    {kEdgeBeginHeading, true},
-    {kEdgeEndHeading, true},
-    {kEdgeBeginShapeIndex, true},
-    {kEdgeEndShapeIndex, true},
-    {kEdgeTraversability, true},
-    {kEdgeUse, true},
-    {kEdgeToll, true},
-    {kEdgeUnpaved, true},
-    {kEdgeTunnel, true},
-    {kEdgeBridge, true},
-    {kEdgeRoundabout, true},
-    {kEdgeInternalIntersection, true},
-    {kEdgeDriveOnRight, true},
-    {kEdgeSurface, true},
-    {kEdgeSignExitNumber, true},
-    {kEdgeSignExitBranch, true},
-    {kEdgeSignExitToward, true},
-    {kEdgeSignExitName, true},
-    {kEdgeSignGuideBranch, true},
-    {kEdgeSignGuideToward, true},
-    {kEdgeSignJunctionName, true},
-    {kEdgeSignGuidanceViewJunction, true},
-    {kEdgeSignGuidanceViewSignboard, true},
-    {kEdgeTravelMode, true},
-    {kEdgeVehicleType, true},
-    {kEdgePedestrianType, true},
-    {kEdgeBicycleType, true},
-    {kEdgeTransitType, true},
-    {kEdgeTransitRouteInfoOnestopId, true},
-    {kEdgeTransitRouteInfoBlockId, true},
-    {kEdgeTransitRouteInfoTripId, true},
-    {kEdgeTransitRouteInfoShortName, true},
-    {kEdgeTransitRouteInfoLongName, true},
-    {kEdgeTransitRouteInfoHeadsign, true},
-    {kEdgeTransitRouteInfoColor, true},
-    {kEdgeTransitRouteInfoTextColor, true},
-    {kEdgeTransitRouteInfoDescription, true},
-    {kEdgeTransitRouteInfoOperatorOnestopId, true},
-    {kEdgeTransitRouteInfoOperatorName, true},
-    {kEdgeTransitRouteInfoOperatorUrl, true},
-    {kEdgeId, true},
-    {kEdgeWayId, true},
-    {kEdgeWeightedGrade, true},
-    {kEdgeMaxUpwardGrade, true},
-    {kEdgeMaxDownwardGrade, true},
-    {kEdgeMeanElevation, true},
-    {kEdgeLaneCount, true},
-    {kEdgeLaneConnectivity, true},
-    {kEdgeCycleLane, true},
-    {kEdgeBicycleNetwork, true},
-    {kEdgeSacScale, true},
-    {kEdgeShoulder, true},
-    {kEdgeSidewalk, true},
-    {kEdgeDensity, true},
-    {kEdgeSpeedLimit, true},
-    {kEdgeTruckSpeed, true},
-    {kEdgeTruckRoute, true},
-    {kEdgeDefaultSpeed, true},
-    {kEdgeDestinationOnly, true},
-    {kEdgeIsUrban, false},
-    {kEdgeTaggedValues, true},
-    {kEdgeIndoor, true},
+    {kEdgeNames, "edge.names", true},
+    {kEdgeLength, "edge.length", true},
+    {kEdgeSpeed, "edge.speed", true},
+    {kEdgeRoadClass, "edge.road_class", true},
+    {kEdgeBeginHeading, "edge.begin_heading", true},
+    {kEdgeEndHeading, "edge.end_heading", true},
+    {kEdgeBeginShapeIndex, "edge.begin_shape_index", true},
+    {kEdgeEndShapeIndex, "edge.end_shape_index", true},
+    {kEdgeTraversability, "edge.traversability", true},
+    {kEdgeUse, "edge.use", true},
+    {kEdgeToll, "edge.toll", true},
+    {kEdgeUnpaved, "edge.unpaved", true},
+    {kEdgeTunnel, "edge.tunnel", true},
+    {kEdgeBridge, "edge.bridge", true},
+    {kEdgeRoundabout, "edge.roundabout", true},
+    {kEdgeInternalIntersection, "edge.internal_intersection", true},
+    {kEdgeDriveOnRight, "edge.drive_on_right", true},
+    {kEdgeSurface, "edge.surface", true},
+    {kEdgeSignExitNumber, "edge.sign.exit_number", true},
+    {kEdgeSignExitBranch, "edge.sign.exit_branch", true},
+    {kEdgeSignExitToward, "edge.sign.exit_toward", true},
+    {kEdgeSignExitName, "edge.sign.exit_name", true},
+    {kEdgeSignGuideBranch, "edge.sign.guide_branch", true},
+    {kEdgeSignGuideToward, "edge.sign.guide_toward", true},
+    {kEdgeSignJunctionName, "edge.sign.junction_name", true},
+    {kEdgeSignGuidanceViewJunction, "edge.sign.guidance_view_junction", true},
+    {kEdgeSignGuidanceViewSignboard, "edge.sign.guidance_view_signboard", true},
+    {kEdgeTravelMode, "edge.travel_mode", true},
+    {kEdgeVehicleType, "edge.vehicle_type", true},
+    {kEdgePedestrianType, "edge.pedestrian_type", true},
+    {kEdgeBicycleType, "edge.bicycle_type", true},
+    {kEdgeTransitType, "edge.transit_type", true},
+    {kEdgeTransitRouteInfoOnestopId, "edge.transit_route_info.onestop_id", true},
+    {kEdgeTransitRouteInfoBlockId, "edge.transit_route_info.block_id", true},
+    {kEdgeTransitRouteInfoTripId, "edge.transit_route_info.trip_id", true},
+    {kEdgeTransitRouteInfoShortName, "edge.transit_route_info.short_name", true},
+    {kEdgeTransitRouteInfoLongName, "edge.transit_route_info.long_name", true},
+    {kEdgeTransitRouteInfoHeadsign, "edge.transit_route_info.headsign", true},
+    {kEdgeTransitRouteInfoColor, "edge.transit_route_info.color", true},
+    {kEdgeTransitRouteInfoTextColor, "edge.transit_route_info.text_color", true},
+    {kEdgeTransitRouteInfoDescription, "edge.transit_route_info.description", true},
+    {kEdgeTransitRouteInfoOperatorOnestopId, "edge.transit_route_info.operator_onestop_id", true},
+    {kEdgeTransitRouteInfoOperatorName, "edge.transit_route_info.operator_name", true},
+    {kEdgeTransitRouteInfoOperatorUrl, "edge.transit_route_info.operator_url", true},
+    {kEdgeId, "edge.id", true},
+    {kEdgeWayId, "edge.way_id", true},
+    {kEdgeWeightedGrade, "edge.weighted_grade", true},
+    {kEdgeMaxUpwardGrade, "edge.max_upward_grade", true},
+    {kEdgeMaxDownwardGrade, "edge.max_downward_grade", true},
+    {kEdgeMeanElevation, "edge.mean_elevation", true},
+    {kEdgeElevation, "edge.elevation", false},
+    {kEdgeLaneCount, "edge.lane_count", true},
+    {kEdgeLaneConnectivity, "edge.lane_connectivity", true},
+    {kEdgeCycleLane, "edge.cycle_lane", true},
+    {kEdgeBicycleNetwork, "edge.bicycle_network", true},
+    {kEdgeSacScale, "edge.sac_scale", true},
+    {kEdgeShoulder, "edge.shoulder", true},
+    {kEdgeSidewalk, "edge.sidewalk", true},
+    {kEdgeDensity, "edge.density", true},
+    {kEdgeSpeedLimit, "edge.speed_limit", true},
+    {kEdgeTruckSpeed, "edge.truck_speed", true},
+    {kEdgeTruckRoute, "edge.truck_route", true},
+    {kEdgeDefaultSpeed, "edge.default_speed", true},
+    {kEdgeDestinationOnly, "edge.destination_only", true},
+    {kEdgeIsUrban, "edge.is_urban", false},
+    {kEdgeTaggedValues, "edge.tagged_values", true},
+    {kEdgeIndoor, "edge.indoor", true},
 
     // Node keys
-    {kIncidents, false},
-    {kNodeIntersectingEdgeBeginHeading, true},
-    {kNodeIntersectingEdgeFromEdgeNameConsistency, true},
-    {kNodeIntersectingEdgeToEdgeNameConsistency, true},
-    {kNodeIntersectingEdgeDriveability, true},
-    {kNodeIntersectingEdgeCyclability, true},
-    {kNodeIntersectingEdgeWalkability, true},
-    {kNodeIntersectingEdgeUse, true},
-    {kNodeIntersectingEdgeRoadClass, true},
-    {kNodeIntersectingEdgeLaneCount, true},
-    {kNodeIntersectingEdgeSignInfo, true},
-    {kNodeElapsedTime, true},
-    {kNodeAdminIndex, true},
-    {kNodeType, true},
-    {kNodeFork, true},
-    {kNodeTransitPlatformInfoType, true},
-    {kNodeTransitPlatformInfoOnestopId, true},
-    {kNodeTransitPlatformInfoName, true},
-    {kNodeTransitPlatformInfoStationOnestopId, true},
-    {kNodeTransitPlatformInfoStationName, true},
-    {kNodeTransitPlatformInfoArrivalDateTime, true},
-    {kNodeTransitPlatformInfoDepartureDateTime, true},
-    {kNodeTransitPlatformInfoIsParentStop, true},
-    {kNodeTransitPlatformInfoAssumedSchedule, true},
-    {kNodeTransitPlatformInfoLatLon, true},
-    {kNodeTransitStationInfoOnestopId, true},
-    {kNodeTransitStationInfoName, true},
-    {kNodeTransitStationInfoLatLon, true},
-    {kNodeTransitEgressInfoOnestopId, true},
-    {kNodeTransitEgressInfoName, true},
-    {kNodeTransitEgressInfoLatLon, true},
-    {kNodeTimeZone, true},
-    {kNodeTransitionTime, true},
-
-    // Top level: admin list, full shape, and shape bounding box keys
-    {kOsmChangeset, true},
-    {kAdminCountryCode, true},
-    {kAdminCountryText, true},
-    {kAdminStateCode, true},
-    {kAdminStateText, true},
-    {kShape, true},
-    {kMatchedPoint, true},
-    {kMatchedType, true},
-    {kMatchedEdgeIndex, true},
-    {kMatchedBeginRouteDiscontinuity, true},
-    {kMatchedEndRouteDiscontinuity, true},
-    {kMatchedDistanceAlongEdge, true},
-    {kMatchedDistanceFromTracePoint, true},
-    {kConfidenceScore, true},
-    {kRawScore, true},
+    {kNodeIntersectingEdgeBeginHeading, "node.intersecting_edge.begin_heading", true},
+    {kNodeIntersectingEdgeFromEdgeNameConsistency,
+     "node.intersecting_edge.from_edge_name_consistency",
+     true},
+    {kNodeIntersectingEdgeToEdgeNameConsistency,
+     "node.intersecting_edge.to_edge_name_consistency",
+     true},
+    {kNodeIntersectingEdgeDriveability, "node.intersecting_edge.driveability", true},
+    {kNodeIntersectingEdgeCyclability, "node.intersecting_edge.cyclability", true},
+    {kNodeIntersectingEdgeWalkability, "node.intersecting_edge.walkability", true},
+    {kNodeIntersectingEdgeUse, "node.intersecting_edge.use", true},
+    {kNodeIntersectingEdgeRoadClass, "node.intersecting_edge.road_class", true},
+    {kNodeIntersectingEdgeLaneCount, "node.intersecting_edge.lane_count", true},
+    {kNodeIntersectingEdgeSignInfo, "node.intersecting_edge.sign_info", true},
+    {kNodeElapsedTime, "node.elapsed_time", true},
+    {kNodeAdminIndex, "node.admin_index", true},
+    {kNodeType, "node.type", true},
+    {kNodeFork, "node.fork", true},
+    {kNodeTransitPlatformInfoType, "node.transit_platform_info.type", true},
+    {kNodeTransitPlatformInfoOnestopId, "node.transit_platform_info.onestop_id", true},
+    {kNodeTransitPlatformInfoName, "node.transit_platform_info.name", true},
+    {kNodeTransitPlatformInfoStationOnestopId,
+     "node.transit_platform_info.station_onestop_id",
+     true},
+    {kNodeTransitPlatformInfoStationName, "node.transit_platform_info.station_name", true},
+    {kNodeTransitPlatformInfoArrivalDateTime, "node.transit_platform_info.arrival_date_time", true},
+    {kNodeTransitPlatformInfoDepartureDateTime,
+     "node.transit_platform_info.departure_date_time",
+     true},
+    {kNodeTransitPlatformInfoIsParentStop, "node.transit_platform_info.is_parent_stop", true},
+    {kNodeTransitPlatformInfoAssumedSchedule, "node.transit_platform_info.assumed_schedule", true},
+    {kNodeTransitPlatformInfoLatLon, "node.transit_platform_info.lat_lon", true},
+    {kNodeTransitStationInfoOnestopId, "node.transit_station_info.onestop_id", true},
+    {kNodeTransitStationInfoName, "node.transit_station_info.name", true},
+    {kNodeTransitStationInfoLatLon, "node.transit_station_info.lat_lon", true},
+    {kNodeTransitEgressInfoOnestopId, "node.transit_egress_info.onestop_id", true},
+    {kNodeTransitEgressInfoName, "node.transit_egress_info.name", true},
+    {kNodeTransitEgressInfoLatLon, "node.transit_egress_info.lat_lon", true},
+    {kNodeTimeZone, "node.time_zone", true},
+    {kNodeTransitionTime, "node.transition_time", true},
+
+    // Top level: osm changeset, admin list, and full shape keys
+    {kOsmChangeset, "osm_changeset", true},
+    {kAdminCountryCode, "admin.country_code", true},
+    {kAdminCountryText, "admin.country_text", true},
+    {kAdminStateCode, "admin.state_code", true},
+    {kAdminStateText, "admin.state_text", true},
+    {kShape, "shape", true},
+    {kIncidents, "incidents", false},
+
+    // Map matching ones nested to points and top level ones
+    {kMatchedPoint, "matched.point", true},
+    {kMatchedType, "matched.type", true},
+    {kMatchedEdgeIndex, "matched.edge_index", true},
+    {kMatchedBeginRouteDiscontinuity, "matched.begin_route_discontinuity", true},
+    {kMatchedEndRouteDiscontinuity, "matched.end_route_discontinuity", true},
+    {kMatchedDistanceAlongEdge, "matched.distance_along_edge", true},
+    {kMatchedDistanceFromTracePoint, "matched.distance_from_trace_point", true},
+    {kConfidenceScore, "confidence_score", true},
+    {kRawScore, "raw_score", true},
 
     // Per-shape attributes
-    {kShapeAttributesTime, false},
-    {kShapeAttributesLength, false},
-    {kShapeAttributesSpeed, false},
-    {kShapeAttributesSpeedLimit, false},
-    {kShapeAttributesClosure, false},
+    {kShapeAttributesTime, "shape_attributes.time", false},
+    {kShapeAttributesLength, "shape_attributes.length", false},
+    {kShapeAttributesSpeed, "shape_attributes.speed", false},
+    {kShapeAttributesSpeedLimit, "shape_attributes.speed_limit", false},
+    {kShapeAttributesClosure, "shape_attributes.closure", false},
 };
 
+static_assert(sizeof(kAttributes) / sizeof(kAttributes[0]) == kAttributeCount,
+              "Every attribute needs a name and a default");
+
+constexpr bool in_id_order() {
+  for (uint16_t i = 0; i < kAttributeCount; ++i) {
+    if (kAttributes[i].key != i) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(in_id_order(), "The attributes must be listed in the order of their ids");
+
+// names of the attributes by id
+const std::vector<std::string> kNames = []() {
+  std::vector<std::string> names;
+  for (const auto& attribute : kAttributes) {
+    names.emplace_back(attribute.name);
+  }
+  return names;
+}();
+
+// attributes by name, to parse the filters of a request
+const std::unordered_map<std::string, Attribute> kKeys = []() {
+  std::unordered_map<std::string, Attribute> keys;
+  for (const auto& attribute : kAttributes) {
+    keys.emplace(attribute.name, attribute.key);
+  }
+  return keys;
+}();
+
+} // namespace
+
+const std::bitset<kAttributeCount> AttributesController::kDefaultAttributes = []() {
+  std::bitset<kAttributeCount> defaults;
+  for (const auto& attribute : kAttributes) {
+    defaults[attribute.key] = attribute.enabled;
+  }
+  return defaults;
+}();
+
 AttributesController::AttributesController() {
   attributes = kDefaultAttributes;
 }
@@ -153,17 +215,23 @@ AttributesController::AttributesController(const Options& options, bool is_stric
       if (is_strict_filter)
         disable_all();
       for (const auto& filter_attribute : options.filter_attributes()) {
-        try {
-          attributes.at(filter_attribute) = true;
-        } catch (...) { LOG_ERROR("Invalid filter attribute " + filter_attribute); }
+        Attribute key;
+        if (find(filter_attribute, key)) {
+          attributes[key] = true;
+        } else {
+          LOG_ERROR("Invalid filter attribute " + filter_attribute);
+        }
       }
       break;
     }
     case (FilterAction::exclude): {
       for (const auto& filter_attribute : options.filter_attributes()) {
-        try {
-          attributes.at(filter_attribute) = false;
-        } catch (...) { LOG_ERROR("Invalid filter attribute " + filter_attribute); }
+        Attribute key;
+        if (find(filter_attribute, key)) {
+          attributes[key] = false;
+        } else {
+          LOG_ERROR("Invalid filter attribute " + filter_attribute);
+        }
       }
       break;
     }
@@ -173,21 +241,28 @@ AttributesController::AttributesController(const Options& options, bool is_stric
 }
 
 void AttributesController::disable_all() {
-  for (auto& pair : attributes) {
-    pair.second = false;
-  }
+  attributes.reset();
 }
 
-bool AttributesController::operator()(const std::string& key) const {
-  return attributes.at(key);
+const std::string& AttributesController::name(const Attribute key) {
+  return kNames[key];
+}
+
+bool AttributesController::find(const std::string& name, Attribute& key) {
+  auto found = kKeys.find(name);
+  if (found == kKeys.end()) {
+    return false;
+  }
+  key = found->second;
+  return true;
 }
 
 // Used to check if any keys starting with the `category` string are enabled.
 bool AttributesController::category_attribute_enabled(const std::string& category) const {
-  for (const auto& pair : attributes) {
+  for (uint16_t i = 0; i < kAttributeCount; ++i) {
     // if the key starts with the specified category and it is enabled
     // then return true
-    if ((pair.first.compare(0, category.size(), category) == 0) && pair.second) {
+    if (attributes[i] && kNames[i].compare(0, category.size(), category) == 0) {
       return true;
     }
   }
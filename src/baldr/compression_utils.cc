@@ -8,18 +8,28 @@ namespace baldr {
  * @param dst_func  function which modifies the stream to write more output
  * @param level     what compression level to use
  * @param gzip      whether or not to write a gzip header instead of a zlib one
+ * @param dictionary  preset dictionary to deflate with, only usable with the zlib wrapper
  * @return          returns true if the stream was successfully inflated, false otherwise
  */
 bool deflate(const std::function<int(z_stream&)>& src_func,
              const std::function<void(z_stream&)>& dst_func,
              int level,
-             bool gzip) {
+             bool gzip,
+             const std::string& dictionary) {
   // initialize the stream
   // add 16 to window bits for gzip header instead of zlib header, 9 is max speed
   z_stream stream{};
   if (deflateInit2(&stream, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 9, Z_DEFAULT_STRATEGY) != Z_OK)
     return false;
 
+  // the dictionary primes the window so that even small inputs find matches
+  if (!dictionary.empty() &&
+      (gzip || deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()),
+                                    static_cast<uInt>(dictionary.size())) != Z_OK)) {
+    deflateEnd(&stream);
+    return false;
+  }
+
   int flush = Z_NO_FLUSH;
   int code = Z_OK;
   do {
@@ -63,10 +73,12 @@ bool deflate(const std::function<int(z_stream&)>& src_func,
 /* Inflates gzip or zlib wrapped deflated data
  * @param src_func  function which modifies the stream to read more input
  * @param dst_func  function which modifies the stream to write more output
+ * @param dictionary  preset dictionary the data was deflated with, if any
  * @return          returns true if the stream was successfully inflated, false otherwise
  */
 bool inflate(const std::function<void(z_stream&)>& src_func,
-             const std::function<int(z_stream&)>& dst_func) {
+             const std::function<int(z_stream&)>& dst_func,
+             const std::string& dictionary) {
 
   // initialize the stream
   // MAX_WBITS is the max size of the window and should be 15, this will work with headerless
@@ -101,6 +113,13 @@ bool inflate(const std::function<void(z_stream&)>& src_func,
 
       // several fatal errors to worry about
       code = inflate(&stream, flush);
+      // the stream asks for its dictionary right after the header, we only know of the one
+      if (code == Z_NEED_DICT && !dictionary.empty()) {
+        code = inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()),
+                                    static_cast<uInt>(dictionary.size()));
+        if (code == Z_OK)
+          continue;
+      }
       switch (code) {
         case Z_STREAM_ERROR:
         case Z_NEED_DICT:
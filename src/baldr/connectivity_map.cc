@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <list>
 #include <random>
@@ -9,6 +11,7 @@
 #include "baldr/graphtile.h"
 #include "baldr/json.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/constants.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -18,6 +21,22 @@ using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
 namespace {
+
+// the file is this header followed by the colors of the tiles sorted by level and then tile id
+struct connectivity_header_t {
+  uint64_t version;
+  uint64_t tile_count;
+};
+
+constexpr uint64_t kConnectivityMapVersion = 1;
+
+// the color of a tile in the colors of a level, nullptr if the tile isn't there
+template <class T> const T* find_tile(const std::pair<const T*, const T*>& level, uint32_t tileid) {
+  auto color = std::lower_bound(level.first, level.second, tileid,
+                                [](const T& c, uint32_t id) { return c.tileid < id; });
+  return color != level.second && color->tileid == tileid ? color : nullptr;
+}
+
 /*
    { "type": "FeatureCollection",
     "features": [
@@ -107,14 +126,23 @@ std::string to_feature_collection(const std::unordered_map<size_t, polygon_t>& b
 namespace valhalla {
 namespace baldr {
 connectivity_map_t::connectivity_map_t(const boost::property_tree::ptree& pt,
-                                       const std::shared_ptr<GraphReader>& graph_reader) {
+                                       const std::shared_ptr<GraphReader>& graph_reader)
+    : transit_level(TileHierarchy::GetTransitLevel().level), colors_begin(nullptr),
+      colors_end(nullptr) {
+  // the colors valhalla_build_connectivity wrote save going through the whole tileset
+  const auto file_name = pt.get<std::string>("connectivity_map", "");
+  if (!file_name.empty() && map_colors(file_name)) {
+    LOG_INFO("Connectivity map " + file_name + " mapped with the colors of " +
+             std::to_string(colors_end - colors_begin) + " tiles");
+    return;
+  }
+
   // See what kind of tiles we are dealing with here by getting a graphreader
   std::shared_ptr<GraphReader> reader = graph_reader;
   if (!reader) {
     reader = std::make_shared<GraphReader>(pt);
   }
   auto tiles = reader->GetTileSet();
-  transit_level = TileHierarchy::GetTransitLevel().level;
 
   // Quick hack to remove connectivity between known unconnected regions
   // The only land connection from north to south america is through
@@ -130,6 +158,7 @@ connectivity_map_t::connectivity_map_t(const boost::property_tree::ptree& pt,
   // then use this map as input to this singleton (via geojson?)
 
   // Populate a map for each level of the tiles that exist
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, size_t>> colors;
   for (const auto& t : tiles) {
     auto& level_colors =
         colors.insert({t.level(), std::unordered_map<uint32_t, size_t>{}}).first->second;
@@ -148,22 +177,76 @@ connectivity_map_t::connectivity_map_t(const boost::property_tree::ptree& pt,
                                                               : decltype(not_neighbors){});
     }
   }
+
+  // keep them sorted so they are looked up the same way as the ones that are mapped
+  for (const auto& level : colors) {
+    for (const auto& color : level.second) {
+      built.push_back({level.first, color.first, color.second});
+    }
+  }
+  std::sort(built.begin(), built.end(), [](const tile_color_t& a, const tile_color_t& b) {
+    return a.level != b.level ? a.level < b.level : a.tileid < b.tileid;
+  });
+  colors_begin = built.data();
+  colors_end = built.data() + built.size();
 }
 
-bool connectivity_map_t::level_color_exists(const uint32_t level) const {
-  return colors.find(level) != colors.end();
+bool connectivity_map_t::map_colors(const std::string& file_name) {
+  if (!filesystem::exists(file_name)) {
+    return false;
+  }
+  size_t size = std::ifstream(file_name, std::ios::binary | std::ios::ate).tellg();
+  if (size < sizeof(connectivity_header_t)) {
+    LOG_WARN("Connectivity map " + file_name + " is too small to be a connectivity map");
+    return false;
+  }
+  mapped.map_readonly(file_name, size);
+  const auto* header = reinterpret_cast<const connectivity_header_t*>(mapped.get());
+  if (header->version != kConnectivityMapVersion ||
+      size != sizeof(connectivity_header_t) + header->tile_count * sizeof(tile_color_t)) {
+    LOG_WARN("Connectivity map " + file_name + " is not of this version or incomplete");
+    mapped.unmap();
+    return false;
+  }
+  colors_begin = reinterpret_cast<const tile_color_t*>(header + 1);
+  colors_end = colors_begin + header->tile_count;
+  return true;
 }
 
-size_t connectivity_map_t::get_color(const GraphId& id) const {
-  auto level = colors.find(id.level());
-  if (level == colors.cend()) {
-    return 0;
+void connectivity_map_t::Store(const std::string& file_name) const {
+  const auto partial = file_name + ".tmp";
+  {
+    connectivity_header_t header{kConnectivityMapVersion,
+                                 static_cast<uint64_t>(colors_end - colors_begin)};
+    std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(colors_begin),
+               (colors_end - colors_begin) * sizeof(tile_color_t));
+    if (!file) {
+      throw std::runtime_error("Could not write the connectivity map " + partial);
+    }
   }
-  auto color = level->second.find(id.tileid());
-  if (color == level->second.cend()) {
-    return 0;
+  if (!filesystem::rename(partial, file_name)) {
+    throw std::runtime_error("Could not move the connectivity map to " + file_name);
   }
-  return color->second;
+}
+
+std::pair<const connectivity_map_t::tile_color_t*, const connectivity_map_t::tile_color_t*>
+connectivity_map_t::level_colors(const uint32_t level) const {
+  auto begin = std::lower_bound(colors_begin, colors_end, level,
+                                [](const tile_color_t& c, uint32_t l) { return c.level < l; });
+  auto end = std::upper_bound(begin, colors_end, level,
+                              [](uint32_t l, const tile_color_t& c) { return l < c.level; });
+  return {begin, end};
+}
+
+bool connectivity_map_t::level_color_exists(const uint32_t level) const {
+  return has_data(level);
+}
+
+size_t connectivity_map_t::get_color(const GraphId& id) const {
+  const auto* color = find_tile(level_colors(id.level()), id.tileid());
+  return color ? color->color : 0;
 }
 
 std::unordered_set<size_t> connectivity_map_t::get_colors(const baldr::TileLevel& hierarchy_level,
@@ -171,8 +254,8 @@ std::unordered_set<size_t> connectivity_map_t::get_colors(const baldr::TileLevel
                                                           float radius) const {
 
   std::unordered_set<size_t> result;
-  auto level = colors.find(hierarchy_level.level);
-  if (level == colors.cend()) {
+  auto level = level_colors(hierarchy_level.level);
+  if (level.first == level.second) {
     return result;
   }
   std::vector<const decltype(location.edges)*> edge_sets{&location.edges, &location.filtered_edges};
@@ -187,9 +270,8 @@ std::unordered_set<size_t> connectivity_map_t::get_colors(const baldr::TileLevel
                           Point2(ll.lng() + lngdeg, ll.lat() + latdeg));
       std::vector<int32_t> tilelist = hierarchy_level.tiles.TileList(bbox);
       for (const auto& id : tilelist) {
-        auto color = level->second.find(id);
-        if (color != level->second.cend()) {
-          result.emplace(color->second);
+        if (const auto* color = find_tile(level, id)) {
+          result.emplace(color->color);
         }
       }
     }
@@ -209,15 +291,13 @@ std::string connectivity_map_t::to_geojson(const uint32_t hierarchy_level) const
   // make a region map (inverse mapping of color to lists of tiles)
   // could cache this but shouldnt need to call it much
   std::unordered_map<size_t, std::unordered_set<uint32_t>> regions;
-  auto level = colors.find(hierarchy_level);
-  if (level != colors.cend()) {
-    for (const auto& tile : level->second) {
-      auto region = regions.find(tile.second);
-      if (region == regions.end()) {
-        regions.emplace(tile.second, std::unordered_set<uint32_t>{tile.first});
-      } else {
-        region->second.emplace(tile.first);
-      }
+  auto level = level_colors(hierarchy_level);
+  for (const auto* tile = level.first; tile != level.second; ++tile) {
+    auto region = regions.find(tile->color);
+    if (region == regions.end()) {
+      regions.emplace(tile->color, std::unordered_set<uint32_t>{tile->tileid});
+    } else {
+      region->second.emplace(tile->tileid);
     }
   }
 
@@ -248,13 +328,10 @@ std::vector<size_t> connectivity_map_t::to_image(const uint32_t hierarchy_level)
                                 : TileHierarchy::levels()[hierarchy_level].tiles;
 
   std::vector<size_t> tiles(level_tiles.nrows() * level_tiles.ncolumns(), 0);
-  auto level = colors.find(hierarchy_level);
-  if (level != colors.cend()) {
-    for (size_t i = 0; i < tiles.size(); ++i) {
-      const auto color = level->second.find(static_cast<uint32_t>(i));
-      if (color != level->second.cend()) {
-        tiles[i] = color->second;
-      }
+  auto level = level_colors(hierarchy_level);
+  for (const auto* tile = level.first; tile != level.second; ++tile) {
+    if (tile->tileid < tiles.size()) {
+      tiles[tile->tileid] = tile->color;
     }
   }
 
@@ -2,6 +2,7 @@
 #include "midgard/logging.h"
 #include "midgard/util.h"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -21,6 +22,9 @@
 
 namespace {
 
+// How many connections a batch may open to the same host when it cannot multiplex
+constexpr long kMaxHostConnections = 8;
+
 struct curl_singleton_t {
   curl_singleton_t() {
     curl_global_init(CURL_GLOBAL_DEFAULT);
@@ -69,50 +73,67 @@ struct curler_t::pimpl_t {
     }
     assert_curl(curl_easy_setopt(connection.get(), CURLOPT_ERRORBUFFER, error),
                 "Failed to set error buffer ");
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_FOLLOWLOCATION, 1L),
+    init_connection(connection.get());
+  }
+
+  // Options shared by every request a connection makes
+  void init_connection(CURL* handle) const {
+    assert_curl(curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L),
                 "Failed to set redirect option ");
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_WRITEFUNCTION, write_callback),
+    assert_curl(curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback),
                 "Failed to set writer ");
     // this is less secure but we'll worry about that later
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_SSL_VERIFYPEER, 0L),
+    assert_curl(curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L),
                 "Failed to disable peer verification ");
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_SSL_VERIFYHOST, 0L),
+    assert_curl(curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L),
                 "Failed to disable host verification ");
   }
 
-  // TODO: retries?
-  std::vector<char> fetch(const std::string& url,
-                          long& http_code,
-                          bool gzipped,
-                          const curler_t::interrupt_t* interrupt) const {
+  // Options which depend on the request
+  void prepare(CURL* handle,
+               const std::string& url,
+               bool gzipped,
+               const curler_t::interrupt_t* interrupt,
+               std::vector<char>* result) const {
     if (interrupt) {
-      assert_curl(curl_easy_setopt(connection.get(), CURLOPT_XFERINFOFUNCTION, progress_callback),
+      assert_curl(curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, progress_callback),
                   "Failed to set custom progress callback ");
-      assert_curl(curl_easy_setopt(connection.get(), CURLOPT_XFERINFODATA, interrupt),
+      assert_curl(curl_easy_setopt(handle, CURLOPT_XFERINFODATA, interrupt),
                   "Failed to set custom progress data");
-      assert_curl(curl_easy_setopt(connection.get(), CURLOPT_NOPROGRESS, 0L),
+      assert_curl(curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L),
                   "Failed to turn the progress callback on ");
+    } else {
+      // a reused handle must not call back into an interrupt from an earlier request
+      assert_curl(curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L),
+                  "Failed to turn the progress callback off ");
     }
 
     // use gzip compression in any case
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_ACCEPT_ENCODING, "gzip"),
+    assert_curl(curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip"),
                 "Failed to set content encoding header ");
     // Curler do uncompressing by default. So if user asks for compressed data,
     // we just disable default uncompressing
     if (gzipped) {
-      assert_curl(curl_easy_setopt(connection.get(), CURLOPT_HTTP_CONTENT_DECODING, 0L),
+      assert_curl(curl_easy_setopt(handle, CURLOPT_HTTP_CONTENT_DECODING, 0L),
                   "Failed to disable decoding ");
     }
     // set the user agent
     if (!user_agent.empty())
-      assert_curl(curl_easy_setopt(connection.get(), CURLOPT_USERAGENT, user_agent.c_str()),
+      assert_curl(curl_easy_setopt(handle, CURLOPT_USERAGENT, user_agent.c_str()),
                   "Failed to set User-Agent ");
     // set the url
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_URL, url.c_str()), "Failed to set URL ");
+    assert_curl(curl_easy_setopt(handle, CURLOPT_URL, url.c_str()), "Failed to set URL ");
     // set the location of the result
+    assert_curl(curl_easy_setopt(handle, CURLOPT_WRITEDATA, result), "Failed to set write data ");
+  }
+
+  // TODO: retries?
+  std::vector<char> fetch(const std::string& url,
+                          long& http_code,
+                          bool gzipped,
+                          const curler_t::interrupt_t* interrupt) const {
     std::vector<char> result;
-    assert_curl(curl_easy_setopt(connection.get(), CURLOPT_WRITEDATA, &result),
-                "Failed to set write data ");
+    prepare(connection.get(), url, gzipped, interrupt, &result);
     // get the url
     assert_curl(curl_easy_perform(connection.get()), "Failed to get URL ");
     // grab the return code
@@ -121,6 +142,92 @@ struct curler_t::pimpl_t {
     return result;
   }
 
+  std::vector<std::vector<char>> fetch(const std::vector<std::string>& urls,
+                                       std::vector<long>& http_codes,
+                                       bool gzipped,
+                                       const curler_t::interrupt_t* interrupt) {
+    // The multi handle keeps the connections alive between batches
+    if (!multi) {
+      multi.reset(curl_multi_init(), [](CURLM* m) { curl_multi_cleanup(m); });
+      if (!multi) {
+        LOG_ERROR("Failed to created CURL multi handle");
+        throw std::runtime_error("Failed to created CURL multi handle");
+      }
+#ifdef CURLPIPE_MULTIPLEX
+      curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+      curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, kMaxHostConnections);
+    }
+    while (transfers.size() < urls.size()) {
+      transfers.emplace_back(init_curl());
+      if (!transfers.back()) {
+        transfers.pop_back();
+        LOG_ERROR("Failed to created CURL connection");
+        throw std::runtime_error("Failed to created CURL connection");
+      }
+      init_connection(transfers.back().get());
+      // rather wait for a connection to multiplex over than open a new one
+      curl_easy_setopt(transfers.back().get(), CURLOPT_PIPEWAIT, 1L);
+      curl_easy_setopt(transfers.back().get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    }
+
+    std::vector<std::vector<char>> results(urls.size());
+    http_codes.assign(urls.size(), 0);
+    // no matter how we leave, the handles must not stay attached to the multi handle
+    size_t added = 0;
+    const auto detach = [&]() {
+      for (size_t i = 0; i < added; ++i) {
+        curl_multi_remove_handle(multi.get(), transfers[i].get());
+      }
+    };
+    try {
+      for (; added < urls.size(); ++added) {
+        prepare(transfers[added].get(), urls[added], gzipped, interrupt, &results[added]);
+        assert_multi(curl_multi_add_handle(multi.get(), transfers[added].get()),
+                     "Failed to add transfer ");
+      }
+
+      int running = 0;
+      do {
+        assert_multi(curl_multi_perform(multi.get(), &running), "Failed to get URLs ");
+        if (running) {
+          assert_multi(curl_multi_wait(multi.get(), nullptr, 0, 1000, nullptr),
+                       "Failed to wait for URLs ");
+        }
+      } while (running);
+
+      // grab the return codes, a failed transfer fails the batch like it would a single fetch
+      std::string failure;
+      int queued = 0;
+      while (CURLMsg* message = curl_multi_info_read(multi.get(), &queued)) {
+        if (message->msg != CURLMSG_DONE) {
+          continue;
+        }
+        const auto transfer =
+            std::find_if(transfers.begin(), transfers.begin() + urls.size(),
+                         [message](const auto& t) { return t.get() == message->easy_handle; });
+        if (message->data.result != CURLE_OK) {
+          failure = curl_easy_strerror(message->data.result);
+        } else if (transfer != transfers.begin() + urls.size()) {
+          curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE,
+                            &http_codes[transfer - transfers.begin()]);
+        }
+      }
+      if (!failure.empty()) {
+        std::string what = "Failed to get URL " + failure;
+        LOG_ERROR(what);
+        throw std::runtime_error(what);
+      }
+    } catch (...) {
+      detach();
+      throw;
+    }
+    detach();
+
+    // hand over the results
+    return results;
+  }
+
   void assert_curl(CURLcode code, const std::string& msg) const {
     if (code != CURLE_OK) {
       std::string what = msg + error;
@@ -129,9 +236,19 @@ struct curler_t::pimpl_t {
     }
   }
 
+  void assert_multi(CURLMcode code, const std::string& msg) const {
+    if (code != CURLM_OK) {
+      std::string what = msg + curl_multi_strerror(code);
+      LOG_ERROR(what);
+      throw std::runtime_error(what);
+    }
+  }
+
   std::shared_ptr<CURL> connection;
   char error[CURL_ERROR_SIZE]{};
   std::string user_agent;
+  std::shared_ptr<CURLM> multi;
+  std::vector<std::shared_ptr<CURL>> transfers;
 };
 
 curler_t::curler_t(const std::string& user_agent) : pimpl(new pimpl_t(user_agent)) {
@@ -144,6 +261,13 @@ std::vector<char> curler_t::operator()(const std::string& url,
   return pimpl->fetch(url, http_code, gzipped, interrupt);
 }
 
+std::vector<std::vector<char>> curler_t::operator()(const std::vector<std::string>& urls,
+                                                    std::vector<long>& http_codes,
+                                                    bool gzipped,
+                                                    const curler_t::interrupt_t* interrupt) const {
+  return pimpl->fetch(urls, http_codes, gzipped, interrupt);
+}
+
 // curler_pool_t
 
 curler_pool_t::curler_pool_t(const size_t pool_size, const std::string& user_agent)
@@ -189,6 +313,14 @@ curler_t::operator()(const std::string&, long&, bool gzipped, const curler_t::in
   throw std::runtime_error("This version of libvalhalla was not built with CURL support");
 }
 
+std::vector<std::vector<char>> curler_t::operator()(const std::vector<std::string>&,
+                                                    std::vector<long>&,
+                                                    bool,
+                                                    const curler_t::interrupt_t*) const {
+  LOG_ERROR("This version of libvalhalla was not built with CURL support");
+  throw std::runtime_error("This version of libvalhalla was not built with CURL support");
+}
+
 curler_pool_t::curler_pool_t(const size_t pool_size, const std::string&) : size_(pool_size) {
 }
 
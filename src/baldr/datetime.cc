@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <bitset>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -41,6 +42,77 @@ from_cache(const TP& tp,
   infos.emplace_back(tp.get_info());
   return infos.back();
 }
+
+// The offset from UTC which applies over a range of seconds since epoch
+struct offset_range_t {
+  int64_t begin;
+  int64_t end;
+  int32_t offset;
+  std::string abbrev;
+};
+
+// Get the offset range of a timezone containing a point in time. Each thread caches the ranges of
+// the timezones it converted times of, sorted and without overlap, so that a conversion is a binary
+// search rather than a search of the transitions of the timezone
+const offset_range_t& offset_range(const int64_t seconds, const date::time_zone* tz) {
+  static thread_local std::unordered_map<const date::time_zone*, std::vector<offset_range_t>> cache;
+  auto& ranges = cache[tz];
+  auto range = std::upper_bound(ranges.begin(), ranges.end(), seconds,
+                                [](int64_t s, const offset_range_t& r) { return s < r.end; });
+  if (range != ranges.end() && range->begin <= seconds) {
+    return *range;
+  }
+
+  // the range is new, it goes right before the first range ending after it
+  const auto info = tz->get_info(date::sys_seconds(std::chrono::seconds(seconds)));
+  return *ranges.insert(range, offset_range_t{info.begin.time_since_epoch().count(),
+                                              info.end.time_since_epoch().count(),
+                                              static_cast<int32_t>(info.offset.count()),
+                                              info.abbrev});
+}
+
+// Append a number zero padded to the width
+void append_digits(std::string& str, uint32_t value, size_t width) {
+  char digits[10];
+  for (size_t i = width; i > 0; --i, value /= 10) {
+    digits[i - 1] = static_cast<char>('0' + value % 10);
+  }
+  str.append(digits, width);
+}
+
+// Format seconds since epoch as 2015-05-06T08:00, with the seconds 2015-05-06T08:00:15
+std::string format_date_time(const int64_t seconds, const bool with_seconds = false) {
+  const auto days = date::floor<date::days>(date::sys_seconds(std::chrono::seconds(seconds)));
+  const date::year_month_day ymd(days);
+  const auto since_midnight = static_cast<uint32_t>(
+      seconds - days.time_since_epoch().count() * int64_t(valhalla::midgard::kSecondsPerDay));
+
+  std::string str;
+  str.reserve(32);
+  append_digits(str, static_cast<uint32_t>(int(ymd.year())), 4);
+  str.push_back('-');
+  append_digits(str, unsigned(ymd.month()), 2);
+  str.push_back('-');
+  append_digits(str, unsigned(ymd.day()), 2);
+  str.push_back('T');
+  append_digits(str, since_midnight / 3600, 2);
+  str.push_back(':');
+  append_digits(str, since_midnight / 60 % 60, 2);
+  if (with_seconds) {
+    str.push_back(':');
+    append_digits(str, since_midnight % 60, 2);
+  }
+  return str;
+}
+
+// Append an offset from UTC as +02:00
+void append_offset(std::string& str, const int32_t offset) {
+  str.push_back(offset < 0 ? '-' : '+');
+  const auto minutes = static_cast<uint32_t>(std::abs(offset)) / 60;
+  append_digits(str, minutes / 60, 2);
+  str.push_back(':');
+  append_digits(str, minutes % 60, 2);
+}
 } // namespace
 
 using namespace valhalla::baldr;
@@ -119,10 +191,9 @@ uint32_t days_from_pivot_date(const date::local_seconds& date_time) {
 std::string iso_date_time(const date::time_zone* time_zone) {
   if (!time_zone)
     return "";
-  std::ostringstream iso_date_time;
-  const auto date = date::make_zoned(time_zone, std::chrono::system_clock::now());
-  iso_date_time << date::format("%FT%R", date);
-  return iso_date_time.str();
+  const auto now = date::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+  const auto seconds = now.time_since_epoch().count();
+  return format_date_time(seconds + offset_range(seconds, time_zone).offset);
 }
 
 // Get the seconds since epoch time is already adjusted based on TZ
@@ -145,15 +216,18 @@ int timezone_diff(const uint64_t seconds,
   if (!origin_tz || !dest_tz || origin_tz == dest_tz) {
     return 0;
   }
+  if (!cache) {
+    return utc_offset(seconds, dest_tz) - utc_offset(seconds, origin_tz);
+  }
   std::chrono::seconds dur(seconds);
   std::chrono::time_point<std::chrono::system_clock> tp(dur);
 
   const auto origin = date::make_zoned(origin_tz, tp);
   const auto dest = date::make_zoned(dest_tz, tp);
 
-  // if we have a cache use it
-  const auto& origin_info = cache ? from_cache(origin, origin_tz, *cache) : origin.get_info();
-  const auto& dest_info = cache ? from_cache(dest, dest_tz, *cache) : dest.get_info();
+  // use the cache we were given
+  const auto& origin_info = from_cache(origin, origin_tz, *cache);
+  const auto& dest_info = from_cache(dest, dest_tz, *cache);
   return static_cast<int>(
       std::chrono::duration_cast<std::chrono::seconds>(dest_info.offset - origin_info.offset)
           .count());
@@ -162,26 +236,25 @@ int timezone_diff(const uint64_t seconds,
 std::string
 seconds_to_date(const uint64_t seconds, const date::time_zone* time_zone, bool tz_format) {
 
-  std::string iso_date;
   if (seconds == 0 || !time_zone) {
-    return iso_date;
+    return "";
   }
 
-  std::chrono::seconds dur(seconds);
-  std::chrono::time_point<std::chrono::system_clock> tp(dur);
-  const auto date = date::make_zoned(time_zone, tp);
-
-  std::ostringstream iso_date_time;
+  const auto offset = offset_range(seconds, time_zone).offset;
+  auto iso_date = format_date_time(seconds + offset);
   if (tz_format)
-    iso_date_time << date::format("%FT%R%z", date);
-  else
-    iso_date_time << date::format("%FT%R", date);
-  iso_date = iso_date_time.str();
-  if (tz_format)
-    iso_date.insert(19, 1, ':');
+    append_offset(iso_date, offset);
   return iso_date;
 }
 
+std::string seconds_to_date_utc(const uint64_t seconds) {
+  return format_date_time(seconds, true) + 'Z';
+}
+
+int32_t utc_offset(const uint64_t seconds, const date::time_zone* time_zone) {
+  return time_zone ? offset_range(seconds, time_zone).offset : 0;
+}
+
 // Get the date from seconds and timezone.
 void seconds_to_date(const uint64_t origin_seconds,
                      const uint64_t dest_seconds,
@@ -241,17 +314,15 @@ get_duration(const std::string& date_time, const uint32_t seconds, const date::t
 
   date::local_seconds date;
   date = get_formatted_date(date_time);
-  if (date < pivot_date_)
+  if (date < pivot_date_ || !time_zone)
     return "";
 
-  std::chrono::seconds dur(seconds_since_epoch(date_time, time_zone) + seconds);
-  std::chrono::time_point<std::chrono::system_clock> tp(dur);
-  std::ostringstream iso_date_time;
-
-  const auto origin = date::make_zoned(time_zone, tp);
-  iso_date_time << date::format("%FT%R%z %Z", origin);
-  std::string iso_date = iso_date_time.str();
-  iso_date.insert(19, 1, ':');
+  const int64_t utc = seconds_since_epoch(date_time, time_zone) + seconds;
+  const auto& range = offset_range(utc, time_zone);
+  auto iso_date = format_date_time(utc + range.offset);
+  append_offset(iso_date, range.offset);
+  iso_date.push_back(' ');
+  iso_date.append(range.abbrev);
   return iso_date;
 }
 
@@ -281,14 +352,12 @@ bool is_conditional_active(const bool type,
   std::chrono::minutes b_td = std::chrono::hours(0);
   std::chrono::minutes e_td = std::chrono::hours(23) + std::chrono::minutes(59);
 
-  std::chrono::seconds dur(current_time);
-  std::chrono::time_point<std::chrono::system_clock> tp(dur);
-
   uint32_t e_year = 0, b_year = 0;
-  const auto in_local_time = date::make_zoned(time_zone, tp);
-  auto date = date::floor<date::days>(in_local_time.get_local_time());
+  const date::local_seconds in_local_time(
+      std::chrono::seconds(current_time + utc_offset(current_time, time_zone)));
+  auto date = date::floor<date::days>(in_local_time);
   auto d = date::year_month_day(date);
-  auto t = date::make_time(in_local_time.get_local_time() - date); // Yields time_of_day type
+  auto t = date::make_time(in_local_time - date); // Yields time_of_day type
   std::chrono::minutes td = t.hours() + t.minutes();               // Yields time_of_day type
 
   try {
@@ -510,9 +579,8 @@ bool is_conditional_active(const bool type,
 
 uint32_t second_of_week(uint32_t epoch_time, const date::time_zone* time_zone) {
   // get the date time in this timezone
-  std::chrono::seconds dur(epoch_time);
-  std::chrono::time_point<std::chrono::system_clock> utp(dur);
-  const auto tp = date::make_zoned(time_zone, utp).get_local_time();
+  const date::local_seconds tp(std::chrono::seconds(int64_t(epoch_time) +
+                                                    utc_offset(epoch_time, time_zone)));
   // floor to midnight of that day
   auto days = date::floor<date::days>(tp);
   // get the ordinal day of the week
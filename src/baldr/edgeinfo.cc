@@ -3,6 +3,9 @@
 
 #include "midgard/encoded.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace valhalla::baldr;
 
 namespace {
@@ -37,8 +40,40 @@ json::ArrayPtr names_json(const std::vector<std::string>& names) {
 namespace valhalla {
 namespace baldr {
 
-EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length)
-    : names_list_(names_list), names_list_length_(names_list_length) {
+// The number of samples and the first one as 16 bit values followed by the differences between
+// the samples, the profile isn't aligned within the tile
+ElevationProfile::ElevationProfile(const char* encoded) {
+  uint16_t size, first_bin;
+  std::memcpy(&size, encoded, sizeof(size));
+  std::memcpy(&first_bin, encoded + sizeof(size), sizeof(first_bin));
+  size_ = size;
+  first_bin_ = first_bin;
+  deltas_ = reinterpret_cast<const int8_t*>(encoded + sizeof(size) + sizeof(first_bin));
+}
+
+float ElevationProfile::at(const double percent_along) const {
+  if (empty()) {
+    return kNoElevationData;
+  }
+
+  // walk up to the sample before the position and interpolate to the one after it
+  const double position = std::min(std::max(percent_along, 0.0), 1.0) * (size_ - 1);
+  const uint32_t before = std::min(static_cast<uint32_t>(position), size_ - 2);
+  int32_t bin = first_bin_;
+  for (uint32_t i = 0; i < before; ++i) {
+    bin += deltas_[i];
+  }
+  const float elevation = kMinElevation + bin * kElevationProfileBinSize;
+  return elevation + (position - before) * deltas_[before] * kElevationProfileBinSize;
+}
+
+EdgeInfo::EdgeInfo(char* ptr,
+                   const char* names_list,
+                   const size_t names_list_length,
+                   const char* shared_list,
+                   const size_t shared_list_length)
+    : names_list_(names_list), names_list_length_(names_list_length), shared_list_(shared_list),
+      shared_list_length_(shared_list_length) {
 
   ei_ = *reinterpret_cast<EdgeInfoInner*>(ptr);
   ptr += sizeof(EdgeInfoInner);
@@ -61,6 +96,9 @@ EdgeInfo::EdgeInfo(char* ptr, const char* names_list, const size_t names_list_le
     extended_wayid3_ = static_cast<uint8_t>(*ptr);
     ptr += sizeof(uint8_t);
   }
+
+  // Optional elevation profile
+  encoded_elevation_ = ei_.has_elevation_ ? ptr : nullptr;
 }
 
 EdgeInfo::~EdgeInfo() {
@@ -87,8 +125,8 @@ std::vector<std::string> EdgeInfo::GetNames() const {
     if (ni->tagged_)
       continue;
 
-    if (ni->name_offset_ < names_list_length_) {
-      names.push_back(names_list_ + ni->name_offset_);
+    if (ni->name_offset_ < text_size()) {
+      names.push_back(text(ni->name_offset_));
     } else {
       throw std::runtime_error("GetNames: offset exceeds size of text list");
     }
@@ -108,15 +146,15 @@ std::vector<std::pair<std::string, bool>> EdgeInfo::GetNames(bool include_tagged
       continue;
     }
     if (ni->tagged_) {
-      if (ni->name_offset_ < names_list_length_) {
-        std::string name = names_list_ + ni->name_offset_;
+      if (ni->name_offset_ < text_size()) {
+        std::string name = text(ni->name_offset_);
         if (IsNameTag(name[0])) {
           name_type_pairs.push_back({name.substr(1), false});
         }
       } else
         throw std::runtime_error("GetNames: offset exceeds size of text list");
-    } else if (ni->name_offset_ < names_list_length_) {
-      name_type_pairs.push_back({names_list_ + ni->name_offset_, ni->is_route_num_});
+    } else if (ni->name_offset_ < text_size()) {
+      name_type_pairs.push_back({text(ni->name_offset_), ni->is_route_num_});
     } else {
       throw std::runtime_error("GetNames: offset exceeds size of text list");
     }
@@ -134,8 +172,8 @@ std::vector<std::string> EdgeInfo::GetTaggedValues(bool only_pronunciations) con
     if (!ni->tagged_)
       continue;
 
-    if (ni->name_offset_ < names_list_length_) {
-      const auto* name = names_list_ + ni->name_offset_;
+    if (ni->name_offset_ < text_size()) {
+      const auto* name = text(ni->name_offset_);
       try {
         TaggedValue tv = static_cast<baldr::TaggedValue>(name[0]);
         if (tv == baldr::TaggedValue::kPronunciation) {
@@ -179,15 +217,15 @@ EdgeInfo::GetNamesAndTypes(bool include_tagged_values) const {
       continue;
     }
     if (ni->tagged_) {
-      if (ni->name_offset_ < names_list_length_) {
-        std::string name = names_list_ + ni->name_offset_;
+      if (ni->name_offset_ < text_size()) {
+        std::string name = text(ni->name_offset_);
         if (IsNameTag(name[0])) {
           name_type_pairs.push_back({name.substr(1), false, static_cast<uint8_t>(name.at(0))});
         }
       } else
         throw std::runtime_error("GetNamesAndTypes: offset exceeds size of text list");
-    } else if (ni->name_offset_ < names_list_length_) {
-      name_type_pairs.push_back({names_list_ + ni->name_offset_, ni->is_route_num_, 0});
+    } else if (ni->name_offset_ < text_size()) {
+      name_type_pairs.push_back({text(ni->name_offset_), ni->is_route_num_, 0});
     } else {
       throw std::runtime_error("GetNamesAndTypes: offset exceeds size of text list");
     }
@@ -206,8 +244,8 @@ const std::multimap<TaggedValue, std::string>& EdgeInfo::GetTags() const {
     for (uint32_t i = 0; i < name_count(); i++, ni++) {
       // Skip any non tagged names
       if (ni->tagged_) {
-        if (ni->name_offset_ < names_list_length_) {
-          std::string name = names_list_ + ni->name_offset_;
+        if (ni->name_offset_ < text_size()) {
+          std::string name = text(ni->name_offset_);
           try {
             TaggedValue tv = static_cast<baldr::TaggedValue>(name[0]);
             if (tv != baldr::TaggedValue::kPronunciation)
@@ -234,8 +272,8 @@ std::unordered_map<uint8_t, std::pair<uint8_t, std::string>> EdgeInfo::GetPronun
     if (!ni->tagged_)
       continue;
 
-    if (ni->name_offset_ < names_list_length_) {
-      const auto* name = names_list_ + ni->name_offset_;
+    if (ni->name_offset_ < text_size()) {
+      const auto* name = text(ni->name_offset_);
       try {
         TaggedValue tv = static_cast<baldr::TaggedValue>(name[0]);
         if (tv == baldr::TaggedValue::kPronunciation) {
@@ -299,6 +337,14 @@ std::string EdgeInfo::encoded_shape() const {
                                    : std::string(encoded_shape_, ei_.encoded_shape_size_);
 }
 
+std::string EdgeInfo::encoded_elevation() const {
+  if (!ei_.has_elevation_) {
+    return {};
+  }
+  const auto size = ElevationProfile::encoded_size(elevation_profile().size());
+  return std::string(encoded_elevation_, size);
+}
+
 int8_t EdgeInfo::layer() const {
   const auto& tags = GetTags();
   auto itr = tags.find(TaggedValue::kLayer);
@@ -1,16 +1,31 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
+#include "baldr/compression_utils.h"
 #include "baldr/connectivity_map.h"
 #include "baldr/curl_tilegetter.h"
 #include "baldr/graphreader.h"
+#include "baldr/textdictionary.h"
 #include "filesystem.h"
 #include "incident_singleton.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
+#include "midgard/numa.h"
+#include "midgard/tracepoints.h"
 #include "shortcut_recovery.h"
 
 using namespace valhalla::midgard;
@@ -20,6 +35,18 @@ namespace {
 constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; // 1 gig
 constexpr size_t AVERAGE_TILE_SIZE = 2097152;         // 2 megs
 constexpr size_t AVERAGE_MM_TILE_SIZE = 1024;         // 1k
+constexpr size_t PREFETCH_BATCH_SIZE = 16;            // tiles downloaded together
+constexpr size_t WARMUP_PAGE_STRIDE = 4096;           // bytes between the reads of a warm up
+
+// locks the mutex of a shared cache, counting the times another thread held it already
+std::unique_lock<std::mutex> lock_counting_waits(std::mutex& mutex, std::atomic<size_t>& waits) {
+  std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    waits.fetch_add(1, std::memory_order_relaxed);
+    lock.lock();
+  }
+  return lock;
+}
 
 struct tile_index_entry {
   uint64_t offset;  // byte offset from the beginning of the tar
@@ -27,6 +54,63 @@ struct tile_index_entry {
   uint32_t size;    // size of the tile in bytes
 };
 
+// A compressed extract starts with this header, followed by the preset dictionary padded to 8
+// bytes and then one entry for each of its tiles
+struct compressed_index_header {
+  uint32_t dictionary_size; // size of the dictionary in bytes
+  uint32_t tile_count;      // number of entries after the dictionary
+};
+
+struct compressed_tile_index_entry {
+  uint64_t offset;        // byte offset of the deflated tile from the beginning of the tar
+  uint32_t tile_id;       // just level and tileindex hence fitting in 32bits
+  uint32_t size;          // size of the deflated tile in bytes
+  uint32_t inflated_size; // size of the tile once it is inflated
+  uint32_t spare;
+};
+
+// Every reader of the process shares the dictionary, it is only read again if the file changes
+void register_text_dictionary(const std::string& file_name) {
+  static std::mutex mutex;
+  static std::string registered_file;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (registered_file != file_name || !valhalla::baldr::TextDictionary::Registered()) {
+    valhalla::baldr::TextDictionary::Register(valhalla::baldr::TextDictionary::Load(file_name));
+    registered_file = file_name;
+  }
+}
+
+// Applies the advice configured for the extracts to the map of one, see mjolnir.extract_advice
+void advise_extract(valhalla::midgard::mem_map<char>& map,
+                    const boost::property_tree::ptree& pt,
+                    const std::string& kind) {
+  const auto advice = pt.get_child_optional("extract_advice");
+  if (!advice) {
+    return;
+  }
+  for (const auto& kv : *advice) {
+    const auto value = kv.second.get_value<std::string>();
+    bool taken = true;
+    if (value == "random") {
+      taken = map.advise(POSIX_MADV_RANDOM);
+    } else if (value == "sequential") {
+      taken = map.advise(POSIX_MADV_SEQUENTIAL);
+    } else if (value == "willneed") {
+      taken = map.advise(POSIX_MADV_WILLNEED);
+    } else if (value == "hugepage") {
+      taken = map.advise_huge_pages();
+    } else if (value == "populate") {
+      map.populate();
+    } else {
+      LOG_WARN("Unknown extract advice: " + value);
+      continue;
+    }
+    if (!taken) {
+      LOG_WARN("The " + kind + " extract did not take the advice: " + value);
+    }
+  }
+}
+
 } // namespace
 
 namespace valhalla {
@@ -48,12 +132,36 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
   auto index_loader = [this, &traffic_from_index](const std::string& filename,
                                                   const char* index_begin, const char* file_begin,
                                                   size_t size) -> decltype(midgard::tar::contents) {
-    // has to be our specially named index.bin file
+    // a compressed extract has an index of its own with the inflated sizes and the dictionary
+    decltype(midgard::tar::contents) contents;
+    if (filename == "compressed_index.bin" && !traffic_from_index &&
+        size >= sizeof(compressed_index_header)) {
+      compressed_index_header header;
+      std::memcpy(&header, index_begin, sizeof(header));
+      const size_t entries_offset = sizeof(header) + (header.dictionary_size + 7) / 8 * 8;
+      if (entries_offset + header.tile_count * sizeof(compressed_tile_index_entry) > size) {
+        LOG_ERROR("Compressed tile extract index is truncated");
+        return {};
+      }
+      dictionary.assign(index_begin + sizeof(header), header.dictionary_size);
+      auto entries = midgard::iterable_t<const compressed_tile_index_entry>(
+          reinterpret_cast<const compressed_tile_index_entry*>(index_begin + entries_offset),
+          header.tile_count);
+      for (const auto& entry : entries) {
+        auto position = std::make_pair(const_cast<char*>(file_begin + entry.offset),
+                                       static_cast<size_t>(entry.size));
+        contents.insert(std::make_pair(std::to_string(entry.tile_id), position));
+        tiles.emplace(entry.tile_id, position);
+        inflated_sizes.emplace(entry.tile_id, entry.inflated_size);
+      }
+      return contents;
+    }
+
+    // otherwise it has to be our specially named index.bin file
     if (filename != "index.bin")
       return {};
 
     // get the info
-    decltype(midgard::tar::contents) contents;
     auto entries = midgard::iterable_t<tile_index_entry>(reinterpret_cast<tile_index_entry*>(
                                                              const_cast<char*>(index_begin)),
                                                          size / sizeof(tile_index_entry));
@@ -113,6 +221,33 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
         if (archive->corrupt_blocks) {
           LOG_WARN("Tile extract had " + std::to_string(archive->corrupt_blocks) + " corrupt blocks");
         }
+        advise_extract(archive->mm, pt, "tile");
+
+        // lock the tiles of the levels every route goes through so reading them never faults
+        std::unordered_set<uint32_t> lock_levels;
+        if (const auto levels = pt.get_child_optional("extract_lock_levels")) {
+          for (const auto& kv : *levels) {
+            lock_levels.insert(kv.second.get_value<uint32_t>());
+          }
+        }
+        if (!lock_levels.empty()) {
+          size_t locked = 0, failed = 0;
+          for (const auto& tile : tiles) {
+            if (lock_levels.count(GraphId(tile.first).level())) {
+              const size_t offset = tile.second.first - archive->mm.get();
+              if (archive->mm.lock(offset, tile.second.second)) {
+                locked += tile.second.second;
+              } else {
+                ++failed;
+              }
+            }
+          }
+          LOG_INFO("Locked " + std::to_string(locked) + " bytes of tiles of the tile extract");
+          if (failed) {
+            LOG_WARN("Could not lock " + std::to_string(failed) +
+                     " tiles of the tile extract, is RLIMIT_MEMLOCK high enough?");
+          }
+        }
       }
     } catch (const std::exception& e) {
       LOG_ERROR(e.what());
@@ -155,6 +290,7 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
           LOG_WARN("Traffic tile extract had " + std::to_string(traffic_archive->corrupt_blocks) +
                    " corrupt blocks");
         }
+        advise_extract(traffic_archive->mm, pt, "traffic");
       }
     } catch (const std::exception& e) {
       LOG_WARN(e.what());
@@ -163,12 +299,30 @@ GraphReader::tile_extract_t::tile_extract_t(const boost::property_tree::ptree& p
   }
 }
 
+std::shared_ptr<const GraphReader::tile_extract_t>
+GraphReader::get_extract_instance(const boost::property_tree::ptree& pt, bool traffic_readonly) {
+  // the extracts stay loaded as long as any reader uses them
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const tile_extract_t>> extracts;
+  const auto key = pt.get<std::string>("tile_extract", "") + '\n' +
+                   pt.get<std::string>("traffic_extract", "") + '\n' +
+                   std::to_string(traffic_readonly);
+  std::lock_guard<std::mutex> lock(mutex);
+  auto extract = extracts[key].lock();
+  if (!extract) {
+    extract = std::make_shared<const tile_extract_t>(pt, traffic_readonly);
+    extracts[key] = extract;
+  }
+  return extract;
+}
+
 // ----------------------------------------------------------------------------
 // FlatTileCache implementation
 // ----------------------------------------------------------------------------
 
 // Constructor.
-FlatTileCache::FlatTileCache(size_t max_size) : cache_size_(0), max_cache_size_(max_size) {
+FlatTileCache::FlatTileCache(size_t max_size)
+    : cache_size_(0), max_cache_size_(max_size), evictions_(0) {
   index_offsets_[0] = 0;
   index_offsets_[1] = index_offsets_[0] + TileHierarchy::levels()[0].tiles.TileCount();
   index_offsets_[2] = index_offsets_[1] + TileHierarchy::levels()[1].tiles.TileCount();
@@ -191,8 +345,14 @@ bool FlatTileCache::OverCommitted() const {
   return cache_size_ > max_cache_size_;
 }
 
+void FlatTileCache::SetMaxSize(size_t max_size) {
+  max_cache_size_ = max_size;
+}
+
 // Clears the cache.
 void FlatTileCache::Clear() {
+  VALHALLA_TRACE(cache_clear, cache_.size());
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
   // TODO: this could be optimized by using the remaining bits in tileid. we need to track a 7bit
@@ -224,12 +384,17 @@ void FlatTileCache::Trim() {
   Clear();
 }
 
+size_t FlatTileCache::Evictions() const {
+  return evictions_;
+}
+
 // ----------------------------------------------------------------------------
 // SimpleTileCache implementation
 // ----------------------------------------------------------------------------
 
 // Constructor.
-SimpleTileCache::SimpleTileCache(size_t max_size) : cache_size_(0), max_cache_size_(max_size) {
+SimpleTileCache::SimpleTileCache(size_t max_size)
+    : cache_size_(0), max_cache_size_(max_size), evictions_(0) {
 }
 
 // Reserves enough cache to hold (max_cache_size / tile_size) items.
@@ -247,8 +412,14 @@ bool SimpleTileCache::OverCommitted() const {
   return cache_size_ > max_cache_size_;
 }
 
+void SimpleTileCache::SetMaxSize(size_t max_size) {
+  max_cache_size_ = max_size;
+}
+
 // Clears the cache.
 void SimpleTileCache::Clear() {
+  VALHALLA_TRACE(cache_clear, cache_.size());
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
 }
@@ -272,13 +443,17 @@ void SimpleTileCache::Trim() {
   Clear();
 }
 
+size_t SimpleTileCache::Evictions() const {
+  return evictions_;
+}
+
 // ----------------------------------------------------------------------------
 // TileCacheLRU implementation
 // ----------------------------------------------------------------------------
 
 // Constructor.
 TileCacheLRU::TileCacheLRU(size_t max_size, MemoryLimitControl mem_control)
-    : mem_control_(mem_control), cache_size_(0), max_cache_size_(max_size) {
+    : mem_control_(mem_control), cache_size_(0), max_cache_size_(max_size), evictions_(0) {
 }
 
 void TileCacheLRU::Reserve(size_t tile_size) {
@@ -296,7 +471,13 @@ bool TileCacheLRU::OverCommitted() const {
   return cache_size_ > max_cache_size_;
 }
 
+void TileCacheLRU::SetMaxSize(size_t max_size) {
+  max_cache_size_ = max_size;
+}
+
 void TileCacheLRU::Clear() {
+  VALHALLA_TRACE(cache_clear, cache_.size());
+  evictions_ += cache_.size();
   cache_size_ = 0;
   cache_.clear();
   key_val_lru_list_.clear();
@@ -306,6 +487,10 @@ void TileCacheLRU::Trim() {
   TrimToFit(0);
 }
 
+size_t TileCacheLRU::Evictions() const {
+  return evictions_;
+}
+
 graph_tile_ptr TileCacheLRU::Get(const GraphId& graphid) const {
   auto cached = cache_.find(graphid);
   if (cached == cache_.cend()) {
@@ -324,10 +509,12 @@ size_t TileCacheLRU::TrimToFit(const size_t required_size) {
          !key_val_lru_list_.empty()) {
     const KeyValue& entry_to_evict = key_val_lru_list_.back();
     const auto tile_size = entry_to_evict.tile->header()->end_offset();
+    VALHALLA_TRACE(tile_evict, entry_to_evict.id.value, tile_size);
     cache_size_ -= tile_size;
     freed_space += tile_size;
     cache_.erase(entry_to_evict.id);
     key_val_lru_list_.pop_back();
+    ++evictions_;
   }
   return freed_space;
 }
@@ -382,8 +569,10 @@ graph_tile_ptr TileCacheLRU::Put(const GraphId& graphid, graph_tile_ptr tile, si
 // ----------------------------------------------------------------------------
 
 // Constructor.
-SynchronizedTileCache::SynchronizedTileCache(TileCache& cache, std::mutex& mutex)
-    : cache_(cache), mutex_ref_(mutex) {
+SynchronizedTileCache::SynchronizedTileCache(TileCache& cache,
+                                             std::mutex& mutex,
+                                             std::shared_ptr<const void> owner)
+    : cache_(cache), mutex_ref_(mutex), owner_(std::move(owner)), lock_waits_(0) {
 }
 
 // Reserves enough cache to hold (max_cache_size / tile_size) items.
@@ -394,7 +583,7 @@ void SynchronizedTileCache::Reserve(size_t tile_size) {
 
 // Checks if tile exists in the cache.
 bool SynchronizedTileCache::Contains(const GraphId& graphid) const {
-  std::lock_guard<std::mutex> lock(mutex_ref_);
+  auto lock = lock_counting_waits(mutex_ref_, lock_waits_);
   return cache_.Contains(graphid);
 }
 
@@ -404,6 +593,11 @@ bool SynchronizedTileCache::OverCommitted() const {
   return cache_.OverCommitted();
 }
 
+void SynchronizedTileCache::SetMaxSize(size_t max_size) {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  cache_.SetMaxSize(max_size);
+}
+
 // Clears the cache.
 void SynchronizedTileCache::Clear() {
   std::lock_guard<std::mutex> lock(mutex_ref_);
@@ -415,20 +609,417 @@ void SynchronizedTileCache::Trim() {
   cache_.Trim();
 }
 
+size_t SynchronizedTileCache::Evictions() const {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  return cache_.Evictions();
+}
+
 // Get a pointer to a graph tile object given a GraphId.
 graph_tile_ptr SynchronizedTileCache::Get(const GraphId& graphid) const {
-  std::lock_guard<std::mutex> lock(mutex_ref_);
+  auto lock = lock_counting_waits(mutex_ref_, lock_waits_);
   return cache_.Get(graphid);
 }
 
 // Puts a copy of a tile of into the cache.
 graph_tile_ptr SynchronizedTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
-  std::lock_guard<std::mutex> lock(mutex_ref_);
+  auto lock = lock_counting_waits(mutex_ref_, lock_waits_);
   return cache_.Put(graphid, std::move(tile), size);
 }
 
+// ----------------------------------------------------------------------------
+// ShardedTileCache implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+ShardedTileCache::ShardedTileCache(size_t max_size,
+                                   size_t shard_count,
+                                   bool use_lru,
+                                   TileCacheLRU::MemoryLimitControl mem_control)
+    : shards_(std::make_shared<std::vector<std::unique_ptr<shard_t>>>()), lock_waits_(0) {
+  shard_count = std::max(shard_count, static_cast<size_t>(1));
+  shards_->reserve(shard_count);
+  for (size_t i = 0; i < shard_count; ++i) {
+    shards_->emplace_back(new shard_t);
+    auto shard_size = max_size / shard_count;
+    shards_->back()->cache.reset(use_lru ? static_cast<TileCache*>(
+                                               new TileCacheLRU(shard_size, mem_control))
+                                         : new SimpleTileCache(shard_size));
+  }
+}
+
+// Copy constructor, shares the shards
+ShardedTileCache::ShardedTileCache(const ShardedTileCache& other)
+    : shards_(other.shards_), lock_waits_(0) {
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void ShardedTileCache::Reserve(size_t tile_size) {
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->cache->Reserve(tile_size);
+  }
+}
+
+// Checks if tile exists in the cache.
+bool ShardedTileCache::Contains(const GraphId& graphid) const {
+  auto& shard = get_shard(graphid);
+  auto lock = lock_counting_waits(shard.mutex, lock_waits_);
+  return shard.cache->Contains(graphid);
+}
+
+// Lets you know if the cache is too large.
+bool ShardedTileCache::OverCommitted() const {
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    if (shard->cache->OverCommitted()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Each shard gets its part of the new size
+void ShardedTileCache::SetMaxSize(size_t max_size) {
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->cache->SetMaxSize(max_size / shards_->size());
+  }
+}
+
+// Clears the cache.
+void ShardedTileCache::Clear() {
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->cache->Clear();
+  }
+}
+
+void ShardedTileCache::Trim() {
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    if (shard->cache->OverCommitted()) {
+      shard->cache->Trim();
+    }
+  }
+}
+
+size_t ShardedTileCache::Evictions() const {
+  size_t evictions = 0;
+  for (auto& shard : *shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    evictions += shard->cache->Evictions();
+  }
+  return evictions;
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr ShardedTileCache::Get(const GraphId& graphid) const {
+  auto& shard = get_shard(graphid);
+  auto lock = lock_counting_waits(shard.mutex, lock_waits_);
+  return shard.cache->Get(graphid);
+}
+
+// Puts a copy of a tile of into the cache.
+graph_tile_ptr ShardedTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  auto& shard = get_shard(graphid);
+  auto lock = lock_counting_waits(shard.mutex, lock_waits_);
+  return shard.cache->Put(graphid, std::move(tile), size);
+}
+
+// ----------------------------------------------------------------------------
+// ClockTileCache implementation
+// ----------------------------------------------------------------------------
+
+struct ClockTileCache::state_t {
+  // Entries are made in chunks which never move so readers can get at them without the lock
+  static constexpr uint32_t kChunkBits = 10;
+  static constexpr uint32_t kChunkSize = 1 << kChunkBits;
+
+  // One cached tile. Its key and tile are guarded by the pin, which readers hold only while they
+  // copy the pointer, the rest is only touched under the mutex
+  struct entry_t {
+    mutable std::atomic_flag pin = ATOMIC_FLAG_INIT;
+    std::atomic<bool> referenced{false};
+    uint64_t key = kInvalidGraphId;
+    graph_tile_ptr tile;
+    size_t size = 0;
+    uint32_t offset = 0;
+  };
+
+  struct pin_t {
+    explicit pin_t(const entry_t& entry) : entry(entry) {
+      while (entry.pin.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+    }
+    ~pin_t() {
+      entry.pin.clear(std::memory_order_release);
+    }
+    const entry_t& entry;
+  };
+
+  explicit state_t(size_t max_size) : max_size(max_size) {
+    index_offsets[0] = 0;
+    index_offsets[1] = index_offsets[0] + TileHierarchy::levels()[0].tiles.TileCount();
+    index_offsets[2] = index_offsets[1] + TileHierarchy::levels()[1].tiles.TileCount();
+    index_offsets[3] = index_offsets[2] + TileHierarchy::levels()[2].tiles.TileCount();
+    index_offsets[4] = index_offsets[3] + TileHierarchy::GetTransitLevel().tiles.TileCount();
+    // zero is no entry so the value initialized index starts out empty
+    index.reset(new std::atomic<uint32_t>[index_offsets[4]]());
+    chunks.reset(new std::atomic<entry_t*>[(index_offsets[4] + kChunkSize - 1) / kChunkSize]());
+  }
+
+  uint32_t get_offset(const GraphId& graphid) const {
+    if (graphid.level() >= 4) {
+      return index_offsets[4];
+    }
+    uint32_t offset = index_offsets[graphid.level()] + graphid.tileid();
+    return offset < index_offsets[graphid.level() + 1] ? offset : index_offsets[4];
+  }
+
+  entry_t& get_entry(uint32_t i) const {
+    return chunks[i >> kChunkBits].load(std::memory_order_acquire)[i & (kChunkSize - 1)];
+  }
+
+  entry_t* find(const GraphId& graphid) const {
+    auto offset = get_offset(graphid);
+    if (offset == index_offsets[4]) {
+      return nullptr;
+    }
+    auto i = index[offset].load(std::memory_order_acquire);
+    return i ? &get_entry(i - 1) : nullptr;
+  }
+
+  // the entry of a tile which isn't cached yet, the mutex must be held
+  uint32_t take_entry() {
+    if (!free.empty()) {
+      auto i = free.back();
+      free.pop_back();
+      return i;
+    }
+    if ((entry_count & (kChunkSize - 1)) == 0) {
+      storage.emplace_back(new entry_t[kChunkSize]);
+      chunks[entry_count >> kChunkBits].store(storage.back().get(), std::memory_order_release);
+    }
+    return entry_count++;
+  }
+
+  // drops the tile of the entry, the mutex must be held
+  void evict(uint32_t i) {
+    auto& entry = get_entry(i);
+    index[entry.offset].store(0, std::memory_order_release);
+    graph_tile_ptr tile;
+    {
+      pin_t pin(entry);
+      entry.key = kInvalidGraphId;
+      tile.swap(entry.tile);
+    }
+    size.fetch_sub(entry.size, std::memory_order_relaxed);
+    entry.size = 0;
+    free.push_back(i);
+    evictions.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // sweeps the hand on to the next tile which wasn't used since the last sweep and drops it, the
+  // mutex must be held and there must be a tile in the cache
+  void evict_next() {
+    while (true) {
+      if (hand >= entry_count) {
+        hand = 0;
+      }
+      auto i = hand++;
+      auto& entry = get_entry(i);
+      if (!entry.tile || entry.referenced.exchange(false, std::memory_order_relaxed)) {
+        continue;
+      }
+      evict(i);
+      return;
+    }
+  }
+
+  uint32_t cached() const {
+    return entry_count - free.size();
+  }
+
+  // index of each tile id into the entries plus one, zero when the tile isn't cached
+  std::unique_ptr<std::atomic<uint32_t>[]> index;
+  std::array<uint32_t, 5> index_offsets;
+  std::unique_ptr<std::atomic<entry_t*>[]> chunks;
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<entry_t[]>> storage;
+  std::vector<uint32_t> free;
+  uint32_t entry_count = 0;
+  uint32_t hand = 0;
+
+  std::atomic<size_t> size{0};
+  std::atomic<size_t> max_size;
+  std::atomic<size_t> evictions{0};
+};
+
+// Constructor.
+ClockTileCache::ClockTileCache(size_t max_size)
+    : state_(std::make_shared<state_t>(max_size)), lock_waits_(0) {
+}
+
+// Copy constructor, shares the tiles
+ClockTileCache::ClockTileCache(const ClockTileCache& other)
+    : state_(other.state_), lock_waits_(0) {
+}
+
+// Entries are made as tiles are put
+void ClockTileCache::Reserve(size_t) {
+}
+
+// Checks if tile exists in the cache.
+bool ClockTileCache::Contains(const GraphId& graphid) const {
+  return state_->find(graphid) != nullptr;
+}
+
+// Lets you know if the cache is too large.
+bool ClockTileCache::OverCommitted() const {
+  return state_->size.load(std::memory_order_relaxed) >
+         state_->max_size.load(std::memory_order_relaxed);
+}
+
+void ClockTileCache::SetMaxSize(size_t max_size) {
+  state_->max_size.store(max_size, std::memory_order_relaxed);
+}
+
+// Clears the cache.
+void ClockTileCache::Clear() {
+  auto lock = lock_counting_waits(state_->mutex, lock_waits_);
+  for (uint32_t i = 0; i < state_->entry_count; ++i) {
+    if (state_->get_entry(i).tile) {
+      state_->evict(i);
+    }
+  }
+  state_->hand = 0;
+}
+
+// Evicts tiles until the cache is within its limit
+void ClockTileCache::Trim() {
+  auto lock = lock_counting_waits(state_->mutex, lock_waits_);
+  while (OverCommitted() && state_->cached() > 0) {
+    state_->evict_next();
+  }
+}
+
+size_t ClockTileCache::Evictions() const {
+  return state_->evictions.load(std::memory_order_relaxed);
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr ClockTileCache::Get(const GraphId& graphid) const {
+  auto* entry = state_->find(graphid);
+  if (!entry) {
+    return nullptr;
+  }
+  graph_tile_ptr tile;
+  {
+    // the entry may have been given to another tile since we found it
+    state_t::pin_t pin(*entry);
+    if (entry->key == graphid.Tile_Base().value) {
+      tile = entry->tile;
+    }
+  }
+  // only write the bit when it changes so hits on a hot tile don't bounce its cache line around
+  if (tile && !entry->referenced.load(std::memory_order_relaxed)) {
+    entry->referenced.store(true, std::memory_order_relaxed);
+  }
+  return tile;
+}
+
+// Puts a copy of a tile of into the cache.
+graph_tile_ptr ClockTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  auto& state = *state_;
+  auto offset = state.get_offset(graphid);
+  if (offset == state.index_offsets[4]) {
+    return tile;
+  }
+
+  auto lock = lock_counting_waits(state.mutex, lock_waits_);
+  // replace the tile if its already cached
+  if (auto i = state.index[offset].load(std::memory_order_relaxed)) {
+    auto& entry = state.get_entry(i - 1);
+    graph_tile_ptr old = tile;
+    {
+      state_t::pin_t pin(entry);
+      old.swap(entry.tile);
+    }
+    state.size.fetch_add(size - entry.size, std::memory_order_relaxed);
+    entry.size = size;
+    entry.referenced.store(true, std::memory_order_relaxed);
+    return tile;
+  }
+
+  // make room for it, a tile larger than the cache is still put and overcommits it
+  while (state.size.load(std::memory_order_relaxed) + size >
+             state.max_size.load(std::memory_order_relaxed) &&
+         state.cached() > 0) {
+    state.evict_next();
+  }
+  auto i = state.take_entry();
+  auto& entry = state.get_entry(i);
+  {
+    state_t::pin_t pin(entry);
+    entry.key = graphid.Tile_Base().value;
+    entry.tile = tile;
+  }
+  entry.size = size;
+  entry.offset = offset;
+  entry.referenced.store(false, std::memory_order_relaxed);
+  state.size.fetch_add(size, std::memory_order_relaxed);
+  state.index[offset].store(i + 1, std::memory_order_release);
+  return tile;
+}
+
+// Get the decoded shape of an edge, decoding and caching it if needed
+const std::vector<PointLL>& EdgeShapeCache::Get(const graph_tile_ptr& tile, const DirectedEdge* edge) {
+  // edgeinfo offsets fit in 25 bits and so do tile ids without the id within the tile
+  const uint64_t key = tile->id().value | (edge->edgeinfo_offset() << 25);
+  const auto found = index_.find(key);
+  if (found != index_.end()) {
+    lru_.splice(lru_.begin(), lru_, found->second);
+    return found->second->shape;
+  }
+
+  // decode it into the scratch space
+  scratch_.clear();
+  auto shape = tile->edgeinfo(edge).lazy_shape();
+  while (!shape.empty()) {
+    scratch_.push_back(shape.pop());
+  }
+  const auto entry_size = EntrySize(scratch_);
+  if (entry_size > max_size_) {
+    return scratch_;
+  }
+
+  // make room for it, the storage of the last shape evicted becomes the next scratch space
+  std::vector<PointLL> recycled;
+  while (size_ + entry_size > max_size_) {
+    auto& last = lru_.back();
+    size_ -= EntrySize(last.shape);
+    index_.erase(last.key);
+    recycled.swap(last.shape);
+    lru_.pop_back();
+  }
+  lru_.push_front(Entry{key, std::move(scratch_)});
+  scratch_ = std::move(recycled);
+  index_.emplace(key, lru_.begin());
+  size_ += entry_size;
+  return lru_.front().shape;
+}
+
+void EdgeShapeCache::Clear() {
+  lru_.clear();
+  index_.clear();
+  size_ = 0;
+}
+
 // Constructs tile cache.
-TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
+TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt,
+                                             uint64_t epoch) {
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
 
   bool use_lru_cache = pt.get<bool>("use_lru_mem_cache", false);
@@ -438,23 +1029,77 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 
   bool use_simple_cache = pt.get<bool>("use_simple_mem_cache", false);
 
+  bool use_clock_cache = pt.get<bool>("use_clock_mem_cache", false);
+
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
+    // readers of threads pinned to a NUMA node can share a replica of the cache per node, each
+    // replica as large as the cache, so that their tiles are allocated on the node reading them
+    const uint32_t replica =
+        pt.get<bool>("numa_cache_replicas", false) ? midgard::numa_t::current() : 0;
+    // the tiles of a replaced extract are cached apart from the new ones until the last reader on
+    // the old extract lets go of them
+    const auto key = std::make_pair(epoch, replica);
+    const auto drop_replaced = [epoch](auto& caches) {
+      for (auto cache = caches.begin(); cache != caches.end();) {
+        cache = cache->first.first < epoch ? caches.erase(cache) : std::next(cache);
+      }
+    };
+
+    // the clock cache is thread-safe by itself and its hits don't lock so it needs no shards
+    if (use_clock_cache) {
+      static std::map<std::pair<uint64_t, uint32_t>, std::shared_ptr<ClockTileCache>> clockCaches;
+      static std::mutex factoryMutex;
+      std::lock_guard<std::mutex> lock(factoryMutex);
+      drop_replaced(clockCaches);
+      auto& globalClockTileCache_ = clockCaches[key];
+      if (!globalClockTileCache_) {
+        globalClockTileCache_.reset(new ClockTileCache(max_cache_size));
+      }
+      // the copy shares the tiles with the global instance
+      return new ClockTileCache(*globalClockTileCache_);
+    }
+
+    // spread the tiles over independently locked shards to avoid contention on a single mutex
+    size_t shard_count = pt.get<size_t>("global_cache_shards", 1);
+    if (shard_count > 1) {
+      static std::map<std::pair<uint64_t, uint32_t>, std::shared_ptr<ShardedTileCache>>
+          shardedCaches;
+      static std::mutex factoryMutex;
+      std::lock_guard<std::mutex> lock(factoryMutex);
+      drop_replaced(shardedCaches);
+      auto& globalShardedTileCache_ = shardedCaches[key];
+      if (!globalShardedTileCache_) {
+        globalShardedTileCache_.reset(
+            new ShardedTileCache(max_cache_size, shard_count, use_lru_cache, lru_mem_control));
+      }
+      // the copy shares the shards with the global instance
+      return new ShardedTileCache(*globalShardedTileCache_);
+    }
+
     // Handle synchronization of cache
-    static std::mutex globalCacheMutex_;
-    static std::shared_ptr<TileCache> globalTileCache_;
+    struct global_cache_t {
+      std::mutex mutex;
+      std::shared_ptr<TileCache> cache;
+    };
+    // the readers share ownership of their mutex and cache, which outlive a replaced extract
+    static std::map<std::pair<uint64_t, uint32_t>, std::shared_ptr<global_cache_t>>
+        globalTileCaches_;
     // We need to lock the factory method itself to prevent races
     static std::mutex factoryMutex;
     std::lock_guard<std::mutex> lock(factoryMutex);
-    if (!globalTileCache_) {
+    drop_replaced(globalTileCaches_);
+    auto& global = globalTileCaches_[key];
+    if (!global) {
+      global = std::make_shared<global_cache_t>();
       if (use_lru_cache) {
-        globalTileCache_.reset(new TileCacheLRU(max_cache_size, lru_mem_control));
+        global->cache.reset(new TileCacheLRU(max_cache_size, lru_mem_control));
       } else {
-        // globalTileCache_.reset(new SimpleTileCache(max_cache_size));
-        globalTileCache_.reset(new FlatTileCache(max_cache_size));
+        // global->cache.reset(new SimpleTileCache(max_cache_size));
+        global->cache.reset(new FlatTileCache(max_cache_size));
       }
     }
-    return new SynchronizedTileCache(*globalTileCache_, globalCacheMutex_);
+    return new SynchronizedTileCache(*global->cache, global->mutex, global);
   }
 
   // or do you want to use an LRU cache
@@ -462,6 +1107,11 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
     return new TileCacheLRU(max_cache_size, lru_mem_control);
   }
 
+  // or one which evicts the tiles least recently used with the clock algorithm
+  if (use_clock_cache) {
+    return new ClockTileCache(max_cache_size);
+  }
+
   // maybe you want a basic hashmap of tiles
   if (use_simple_cache) {
     return new SimpleTileCache(max_cache_size);
@@ -472,14 +1122,388 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 }
 
 // Constructor using separate tile files
+// Loads tiles on a few background threads and holds on to them until GetGraphTile asks for them.
+// The loaded tiles only enter the cache on the thread that owns the reader so the cache need not
+// be synchronized
+struct GraphReader::tile_prefetcher_t {
+  // How many tiles may be queued, loading or waiting to be picked up at any one time
+  static constexpr size_t kMaxTiles = 128;
+
+  using loader_t =
+      std::function<std::vector<graph_tile_ptr>(const std::vector<GraphId>&, std::vector<size_t>&)>;
+  enum class state_t { kQueued, kLoading, kDone };
+  struct entry_t {
+    state_t state;
+    graph_tile_ptr tile;
+    size_t size;
+  };
+
+  tile_prefetcher_t(size_t thread_count, size_t batch_size, loader_t loader)
+      : batch_size_(batch_size), loader_(std::move(loader)) {
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back(&tile_prefetcher_t::work, this);
+    }
+  }
+
+  ~tile_prefetcher_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    queued_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void request(const GraphId& base) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.find(base) != entries_.end()) {
+        return;
+      }
+      // Loaded tiles nobody picked up yet are likely not needed anymore, make room for new ones
+      if (entries_.size() >= kMaxTiles) {
+        drop_done();
+        if (entries_.size() >= kMaxTiles) {
+          return;
+        }
+      }
+      entries_.emplace(base, entry_t{state_t::kQueued, nullptr, 0});
+      queue_.push_back(base);
+    }
+    queued_.notify_one();
+  }
+
+  // Hands over a prefetched tile, waiting for it if it is being loaded at the moment. Returns false
+  // if the tile was never requested or not started on yet, in which case the caller loads it
+  bool take(const GraphId& base, graph_tile_ptr& tile, size_t& size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto entry = entries_.find(base);
+    if (entry == entries_.end()) {
+      return false;
+    }
+    if (entry->second.state == state_t::kQueued) {
+      entries_.erase(entry);
+      return false;
+    }
+    done_.wait(lock, [&]() {
+      entry = entries_.find(base);
+      return entry == entries_.end() || entry->second.state == state_t::kDone;
+    });
+    if (entry == entries_.end()) {
+      return false;
+    }
+    tile = std::move(entry->second.tile);
+    size = entry->second.size;
+    entries_.erase(entry);
+    return tile != nullptr;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drop_done();
+  }
+
+  // Expects the lock to be held
+  void drop_done() {
+    for (auto entry = entries_.begin(); entry != entries_.end();) {
+      entry = entry->second.state == state_t::kDone ? entries_.erase(entry) : std::next(entry);
+    }
+  }
+
+  void work() {
+    std::vector<GraphId> bases;
+    std::vector<graph_tile_ptr> tiles;
+    std::vector<size_t> sizes;
+    while (true) {
+      bases.clear();
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (stop_) {
+          return;
+        }
+        // Take a batch, remote tiles are then fetched together
+        while (!queue_.empty() && bases.size() < batch_size_) {
+          const auto base = queue_.front();
+          queue_.pop_front();
+          // The reader may have loaded it itself in the meantime
+          auto entry = entries_.find(base);
+          if (entry != entries_.end() && entry->second.state == state_t::kQueued) {
+            entry->second.state = state_t::kLoading;
+            bases.push_back(base);
+          }
+        }
+      }
+      if (bases.empty()) {
+        continue;
+      }
+
+      try {
+        tiles = loader_(bases, sizes);
+      } catch (...) {
+        // An interrupted download for example, the reader will try again if it needs the tiles
+        tiles.assign(bases.size(), nullptr);
+        sizes.assign(bases.size(), 0);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < bases.size(); ++i) {
+          auto entry = entries_.find(bases[i]);
+          if (entry != entries_.end()) {
+            entry->second = entry_t{state_t::kDone, std::move(tiles[i]), sizes[i]};
+          }
+        }
+      }
+      done_.notify_all();
+    }
+  }
+
+  const size_t batch_size_;
+  loader_t loader_;
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable done_;
+  std::deque<GraphId> queue_;
+  std::unordered_map<GraphId, entry_t> entries_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+// Counts the sampled tile accesses of all the readers of the process which write to the same file
+// and writes them out every so often, the most used tiles first. Each line is level/tileid and the
+// count, the format the warm up list takes
+struct GraphReader::tile_usage_t {
+  tile_usage_t(const std::string& file, std::chrono::seconds interval)
+      : file_(file), interval_(interval), last_write_(std::chrono::steady_clock::now()) {
+  }
+
+  ~tile_usage_t() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!counts_.empty()) {
+      write();
+    }
+  }
+
+  // the readers writing to the same file share the counts
+  static std::shared_ptr<tile_usage_t> get(const std::string& file, std::chrono::seconds interval) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<tile_usage_t>> usages;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto usage = usages[file].lock();
+    if (!usage) {
+      usage = std::make_shared<tile_usage_t>(file, interval);
+      usages[file] = usage;
+    }
+    return usage;
+  }
+
+  void record(const GraphId& base) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++counts_[base];
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_write_ >= interval_) {
+      last_write_ = now;
+      write();
+    }
+  }
+
+protected:
+  // replaces the file in one go so that readers of it never see half of it
+  void write() const {
+    std::vector<std::pair<GraphId, uint64_t>> counts(counts_.begin(), counts_.end());
+    std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+      return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    const auto partial = file_ + ".tmp";
+    std::ofstream out(partial, std::ios::trunc);
+    for (const auto& count : counts) {
+      out << count.first.level() << '/' << count.first.tileid() << ' ' << count.second << '\n';
+    }
+    out.close();
+    if (!out || !filesystem::rename(partial, file_)) {
+      LOG_WARN("Could not write the tile usage to " + file_);
+    }
+  }
+
+  const std::string file_;
+  const std::chrono::seconds interval_;
+  std::chrono::steady_clock::time_point last_write_;
+  std::mutex mutex_;
+  std::unordered_map<GraphId, uint64_t> counts_;
+};
+
+// Watches the files of an extract and loads them again in the background once they were replaced,
+// e.g. by moving the files of a new tile build over them. The readers switch to the loaded extract
+// with UpdateExtract when it suits them
+struct GraphReader::extract_reloader_t {
+  extract_reloader_t(const boost::property_tree::ptree& pt, bool traffic_readonly)
+      : config_(pt), traffic_readonly_(traffic_readonly),
+        interval_(pt.get<uint32_t>("extract_reload_seconds")),
+        files_{pt.get<std::string>("tile_extract", ""), pt.get<std::string>("traffic_extract", "")},
+        loaded_(states()), seen_(loaded_), epoch_(0), done_(false) {
+    thread_ = std::thread([this]() { watch(); });
+  }
+
+  ~extract_reloader_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+  }
+
+  // the readers of the same files share the watching and the loaded extracts
+  static std::shared_ptr<extract_reloader_t> get(const boost::property_tree::ptree& pt,
+                                                 bool traffic_readonly) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<extract_reloader_t>> reloaders;
+    const auto key = pt.get<std::string>("tile_extract", "") + '\n' +
+                     pt.get<std::string>("traffic_extract", "") + '\n' +
+                     std::to_string(traffic_readonly);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto reloader = reloaders[key].lock();
+    if (!reloader) {
+      reloader = std::make_shared<extract_reloader_t>(pt, traffic_readonly);
+      reloaders[key] = reloader;
+    }
+    return reloader;
+  }
+
+  const boost::property_tree::ptree& config() const {
+    return config_;
+  }
+
+  // the epoch of the extract loaded last, cheap enough to ask in between every request
+  uint64_t epoch() const {
+    return epoch_.load(std::memory_order_acquire);
+  }
+
+  std::shared_ptr<const extract_snapshot_t> snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_;
+  }
+
+protected:
+  // what tells a replaced file apart, a file moved over the old one has another inode
+  struct file_state_t {
+    uint64_t inode;
+    uint64_t size;
+    int64_t modified;
+    bool operator==(const file_state_t& other) const {
+      return inode == other.inode && size == other.size && modified == other.modified;
+    }
+    bool operator!=(const file_state_t& other) const {
+      return !(*this == other);
+    }
+  };
+  using states_t = std::pair<file_state_t, file_state_t>;
+
+  states_t states() const {
+    const auto state = [](const std::string& file) -> file_state_t {
+      struct stat s;
+      if (file.empty() || stat(file.c_str(), &s) != 0) {
+        return {0, 0, 0};
+      }
+      return {static_cast<uint64_t>(s.st_ino), static_cast<uint64_t>(s.st_size),
+              static_cast<int64_t>(s.st_mtime)};
+    };
+    return {state(files_.first), state(files_.second)};
+  }
+
+  void watch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, interval_, [this]() { return done_; })) {
+      // files written in place are only loaded once they stopped changing for a whole interval
+      const auto current = states();
+      const bool settled = current == seen_;
+      seen_ = current;
+      if (!settled || current == loaded_ || current.first == file_state_t{0, 0, 0}) {
+        continue;
+      }
+      lock.unlock();
+      auto snapshot = load(epoch() + 1);
+      lock.lock();
+      loaded_ = current;
+      if (snapshot) {
+        snapshot_ = std::move(snapshot);
+        epoch_.store(snapshot_->epoch, std::memory_order_release);
+      }
+    }
+  }
+
+  // loads the extract with a reader of its own, which also fills the shortcut recovery if asked to
+  std::shared_ptr<const extract_snapshot_t> load(uint64_t epoch) const {
+    LOG_INFO("Reloading the tile extract " + files_.first + " and traffic extract " +
+             files_.second);
+    try {
+      // the loading reader needs none of the state the readers of the process share
+      auto pt = config_;
+      pt.put("extract_reload_seconds", 0);
+      pt.put("global_synchronized_cache", false);
+      pt.put("shortcut_caching", false);
+      for (const auto* key : {"incident_log", "incident_dir", "tile_usage", "tile_url",
+                              "tile_prefetch_threads", "shared_memory_cache",
+                              "cache_memory_fraction"}) {
+        pt.erase(key);
+      }
+      GraphReader reader(pt, nullptr, traffic_readonly_);
+      if (!files_.first.empty() && reader.tile_extract_->tiles.empty()) {
+        LOG_ERROR("The replaced tile extract has no tiles, keeping the one loaded before");
+        return nullptr;
+      }
+
+      auto snapshot = std::make_shared<extract_snapshot_t>();
+      snapshot->epoch = epoch;
+      snapshot->extract = reader.tile_extract_;
+      const bool shortcut_caching = config_.get<bool>("shortcut_caching", false);
+      const auto shortcut_index = config_.get<std::string>("shortcut_index", "");
+      if (shortcut_caching || !shortcut_index.empty()) {
+        std::shared_ptr<const shortcut_recovery_t> recovery =
+            shortcut_recovery_t::create(shortcut_caching ? &reader : nullptr, shortcut_index);
+        snapshot->recover_shortcut = [recovery](const GraphId& shortcut_id, GraphReader& reader) {
+          return recovery->get(shortcut_id, reader);
+        };
+      }
+      LOG_INFO("Reloaded the extracts as epoch " + std::to_string(epoch));
+      return snapshot;
+    } catch (const std::exception& e) {
+      LOG_ERROR("Could not reload the extracts, keeping the ones loaded before: " +
+                std::string(e.what()));
+      return nullptr;
+    }
+  }
+
+  const boost::property_tree::ptree config_;
+  const bool traffic_readonly_;
+  const std::chrono::seconds interval_;
+  const std::pair<std::string, std::string> files_;
+  // the states of the files as of the last load and the last look at them
+  states_t loaded_;
+  states_t seen_;
+  std::atomic<uint64_t> epoch_;
+  std::shared_ptr<const extract_snapshot_t> snapshot_;
+  bool done_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+};
+
 GraphReader::GraphReader(const boost::property_tree::ptree& pt,
                          std::unique_ptr<tile_getter_t>&& tile_getter,
                          bool traffic_readonly)
-    : tile_extract_(new tile_extract_t(pt, traffic_readonly)),
+    : tile_extract_(pt.get<bool>("global_synchronized_cache", false)
+                        ? get_extract_instance(pt, traffic_readonly)
+                        : std::make_shared<const tile_extract_t>(pt, traffic_readonly)),
       tile_dir_(tile_extract_->tiles.empty() ? pt.get<std::string>("tile_dir", "") : ""),
+      tile_dir_mmap_(pt.get<bool>("tile_dir_mmap", false)),
       tile_getter_(std::move(tile_getter)),
       max_concurrent_users_(pt.get<size_t>("max_concurrent_reader_users", 1)),
-      tile_url_(pt.get<std::string>("tile_url", "")), cache_(TileCacheFactory::createTileCache(pt)) {
+      tile_url_(pt.get<std::string>("tile_url", "")), cache_(TileCacheFactory::createTileCache(pt)),
+      shape_cache_(pt.get<size_t>("edge_shape_cache_size", 0)) {
 
   // Make a tile fetcher if we havent passed one in from somewhere else
   if (!tile_getter_ && !tile_url_.empty()) {
@@ -492,9 +1516,37 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
   if (!tile_url_.empty() && tile_url_.find(GraphTile::kTilePathPattern) == std::string::npos)
     throw std::runtime_error("Not found tilePath pattern in tile url");
 
+  // Only serve the local tiles of a region if the deployment is sharded
+  const auto shard_tiles = pt.get<std::string>("shard.tiles", "");
+  if (!shard_tiles.empty()) {
+    shard_ = tile_shard_t::get_instance(shard_tiles);
+  }
+
+  // Share the tiles read from disk or downloaded with the other processes on the host
+  const auto shared_memory_cache = pt.get<std::string>("shared_memory_cache", "");
+  if (!shared_memory_cache.empty() && tile_extract_->tiles.empty() &&
+      (!tile_dir_.empty() || tile_getter_)) {
+    shm_cache_ = shm_tile_cache_t::get_instance(shared_memory_cache,
+                                                pt.get<size_t>("max_cache_size",
+                                                               DEFAULT_MAX_CACHE_SIZE));
+  }
+
+  // Size the cache by the memory the process may use if asked to
+  memory_budget_ = memory_budget_t::get(pt);
+  if (memory_budget_) {
+    max_cache_size_ = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
+    global_cache_ = pt.get<bool>("global_synchronized_cache", false);
+    if (!global_cache_) {
+      memory_share_ = memory_budget_->Join();
+    }
+    FitMemoryBudget();
+  }
+
   // Reserve cache (based on whether using individual tile files or shared,
   // mmap'd file
-  cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+  const bool mapped = tile_extract_->tiles.empty() ? tile_dir_mmap_
+                                                  : tile_extract_->inflated_sizes.empty();
+  cache_->Reserve(mapped ? AVERAGE_MM_TILE_SIZE : AVERAGE_TILE_SIZE);
 
   // Initialize the incident cache singleton if we have any kind of configuration to do so. if the
   // configuration is wrong or any kind of problem occurs this throws. the call below will spawn a
@@ -507,17 +1559,95 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
                                                            : GetTileSet());
   }
 
-  // Fill shortcut recovery cache if requested or by default in memmap mode
-  if (pt.get<bool>("shortcut_caching", false)) {
-    shortcut_recovery_t::get_instance(this);
+  // Map the shortcut index the tile build wrote if there is one, otherwise fill the shortcut
+  // recovery cache if requested
+  const bool shortcut_caching = pt.get<bool>("shortcut_caching", false);
+  const auto shortcut_index = pt.get<std::string>("shortcut_index", "");
+  if (shortcut_caching || !shortcut_index.empty()) {
+    shortcut_recovery_t::get_instance(shortcut_caching ? this : nullptr, shortcut_index);
+  }
+
+  // Tiles built with a text dictionary can only be read with it
+  const auto text_dictionary = pt.get<std::string>("text_dictionary", "");
+  if (!text_dictionary.empty() && filesystem::exists(text_dictionary)) {
+    register_text_dictionary(text_dictionary);
+  }
+
+  // Sample the tile accesses if asked to
+  const auto tile_usage_file = pt.get<std::string>("tile_usage.file", "");
+  if (!tile_usage_file.empty()) {
+    tile_usage_sample_rate_ = std::max(pt.get<uint32_t>("tile_usage.sample_rate", 64), 1u);
+    tile_usage_countdown_ = tile_usage_sample_rate_;
+    const std::chrono::seconds interval(pt.get<uint32_t>("tile_usage.interval", 300));
+    tile_usage_ = tile_usage_t::get(tile_usage_file, interval);
+  }
+
+  // Watch the extracts for replacements and start from the one loaded last if there is one
+  if (pt.get<uint32_t>("extract_reload_seconds", 0) > 0 &&
+      (!pt.get<std::string>("tile_extract", "").empty() ||
+       !pt.get<std::string>("traffic_extract", "").empty())) {
+    extract_reloader_ = extract_reloader_t::get(pt, traffic_readonly);
+    UpdateExtract();
+  }
+
+  // Tiles from an extract are mapped already, prefetching only pays off for files and downloads
+  const auto prefetch_threads = pt.get<size_t>("tile_prefetch_threads", 0);
+  if (prefetch_threads > 0 && tile_extract_->tiles.empty() && (!tile_dir_.empty() || tile_getter_)) {
+    // Downloads are batched so that they share connections, disk reads are better spread out
+    const size_t batch_size = tile_getter_ ? PREFETCH_BATCH_SIZE : 1;
+    prefetcher_ = std::make_shared<tile_prefetcher_t>(prefetch_threads, batch_size,
+                                                      [this](const std::vector<GraphId>& bases,
+                                                             std::vector<size_t>& sizes) {
+                                                        return LoadGraphTiles(bases, sizes);
+                                                      });
   }
 }
 
+// Switches to the extract loaded last if it is not the one in use
+bool GraphReader::UpdateExtract() {
+  if (!extract_reloader_ || extract_reloader_->epoch() == ExtractEpoch()) {
+    return false;
+  }
+  auto snapshot = extract_reloader_->snapshot();
+  if (!snapshot || snapshot == extract_snapshot_) {
+    return false;
+  }
+
+  // the tiles handed out so far keep the old extract mapped until they are gone
+  extract_snapshot_ = std::move(snapshot);
+  tile_extract_ = extract_snapshot_->extract;
+  cache_.reset(TileCacheFactory::createTileCache(extract_reloader_->config(),
+                                                 extract_snapshot_->epoch));
+  cache_limit_ = 0;
+  FitMemoryBudget();
+  const bool mapped = tile_extract_->tiles.empty() ? tile_dir_mmap_
+                                                  : tile_extract_->inflated_sizes.empty();
+  cache_->Reserve(mapped ? AVERAGE_MM_TILE_SIZE : AVERAGE_TILE_SIZE);
+  shape_cache_.Clear();
+  {
+    std::lock_guard<std::mutex> lock(_404s_lock);
+    _404s.clear();
+  }
+
+  // nothing of the old traffic generations carries over, an empty list means all tiles changed
+  traffic_generations_.clear();
+  traffic_polled_ = false;
+  for (const auto& observer : traffic_observers_) {
+    observer({});
+  }
+  LOG_INFO("Switched to the extracts of epoch " + std::to_string(extract_snapshot_->epoch));
+  return true;
+}
+
 // Method to test if tile exists
 bool GraphReader::DoesTileExist(const GraphId& graphid) const {
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
     return false;
   }
+  // tiles of other shards are as good as missing
+  if (shard_ && !shard_->Contains(graphid)) {
+    return false;
+  }
   // if you are using an extract only check that
   if (!tile_extract_->tiles.empty()) {
     return tile_extract_->tiles.find(graphid) != tile_extract_->tiles.cend();
@@ -547,39 +1677,62 @@ private:
   const std::shared_ptr<midgard::tar> archive_;
 };
 
+class InflatedGraphMemory final : public GraphMemory {
+public:
+  InflatedGraphMemory(std::vector<char>&& memory) : memory_(std::move(memory)) {
+    data = const_cast<char*>(memory_.data());
+    size = memory_.size();
+  }
+
+private:
+  const std::vector<char> memory_;
+};
+
+class SharedGraphMemory final : public GraphMemory {
+public:
+  SharedGraphMemory(std::shared_ptr<shm_tile_cache_t> cache, std::pair<char*, size_t> position)
+      : cache_(std::move(cache)) {
+    data = position.first;
+    size = position.second;
+  }
+
+private:
+  const std::shared_ptr<shm_tile_cache_t> cache_;
+};
+
 // Get a pointer to a graph tile object given a GraphId. Return nullptr
 // if the tile is not found/empty
 graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
-  // Return nullptr if not a valid tile
-  if (!graphid.Is_Valid()) {
+  // Return nullptr if not a valid tile or one of another shard
+  if (!graphid.Is_Valid() || (shard_ && !shard_->Contains(graphid))) {
     return nullptr;
   }
 
   // Check if the level/tileid combination is in the cache
   auto base = graphid.Tile_Base();
+  if (tile_usage_ && --tile_usage_countdown_ == 0) {
+    tile_usage_countdown_ = tile_usage_sample_rate_;
+    tile_usage_->record(base);
+  }
   if (const auto& cached = cache_->Get(base)) {
     // LOG_DEBUG("Memory cache hit " + GraphTile::FileSuffix(base));
+    ++cache_stats_.hits;
     return cached;
   }
+  ++cache_stats_.misses;
+  const auto start = std::chrono::steady_clock::now();
+  auto loaded = [this, &start, &base](size_t size) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    VALHALLA_TRACE(tile_load, base.value, size, static_cast<uint64_t>(elapsed.count() * 1000));
+    cache_stats_.load_ms += elapsed.count();
+    ++cache_stats_.tiles_loaded;
+    cache_stats_.bytes_loaded += size;
+  };
 
   // Try getting it from the memmapped tar extract
   if (!tile_extract_->tiles.empty()) {
-    // Do we have this tile
-    auto t = tile_extract_->tiles.find(base);
-    if (t == tile_extract_->tiles.cend()) {
-      // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
-      return nullptr;
-    }
-    auto memory = std::make_unique<TarballGraphMemory>(tile_extract_->archive, t->second);
-
-    auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
-
-    // This initializes the tile from mmap
-    auto tile = GraphTile::Create(base, std::move(memory), std::move(traffic_memory));
+    size_t size = 0;
+    auto tile = LoadExtractTile(base, size);
     if (!tile) {
       // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
       return nullptr;
@@ -587,50 +1740,337 @@ graph_tile_ptr GraphReader::GetGraphTile(const GraphId& graphid) {
     // LOG_DEBUG("Memory map cache hit " + GraphTile::FileSuffix(base));
 
     // Keep a copy in the cache and return it
-    const size_t size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
+    loaded(size);
     return cache_->Put(base, std::move(tile), size);
   } // Try getting it from flat file
   else {
+    size_t size = 0;
+    graph_tile_ptr tile;
+    // One of the prefetch threads may have it already or be busy loading it
+    if (!prefetcher_ || !prefetcher_->take(base, tile, size)) {
+      tile = LoadGraphTile(base, size);
+    }
+    if (!tile) {
+      return nullptr;
+    }
+
+    // Keep a copy in the cache and return it
+    loaded(size);
+    return cache_->Put(base, std::move(tile), size);
+  }
+}
+
+graph_tile_ptr GraphReader::LoadExtractTile(const GraphId& base, size_t& size) const {
+  // Do we have this tile
+  auto t = tile_extract_->tiles.find(base);
+  if (t == tile_extract_->tiles.cend()) {
+    return nullptr;
+  }
+
+  auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
+  auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
+                            ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
+                                                                   traffic_ptr->second)
+                            : nullptr;
+
+  // This initializes the tile from mmap
+  auto inflated_size = tile_extract_->inflated_sizes.find(base);
+  if (inflated_size == tile_extract_->inflated_sizes.cend()) {
+    size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
+    auto memory = std::make_unique<TarballGraphMemory>(tile_extract_->archive, t->second);
+    return GraphTile::Create(base, std::move(memory), std::move(traffic_memory));
+  }
+
+  // Or inflate it onto the heap, one byte more than the index says so that the buffer only fills
+  // up if the tile is bigger than it should be
+  std::vector<char> data(inflated_size->second + 1);
+  auto src_func = [&t](z_stream& s) -> void {
+    s.next_in = reinterpret_cast<Byte*>(t->second.first);
+    s.avail_in = static_cast<unsigned int>(t->second.second);
+  };
+  size_t inflated = 0;
+  auto dst_func = [&data, &inflated](z_stream& s) -> int {
+    if (s.total_out == 0 && s.next_out == nullptr) {
+      s.next_out = reinterpret_cast<Byte*>(data.data());
+      s.avail_out = static_cast<unsigned int>(data.size());
+    } else if (s.avail_out == 0) {
+      throw std::runtime_error("Tile inflates to more than its indexed size");
+    }
+    inflated = s.total_out;
+    return Z_NO_FLUSH;
+  };
+  if (!baldr::inflate(src_func, dst_func, tile_extract_->dictionary) ||
+      inflated != inflated_size->second) {
+    LOG_ERROR("Failed to inflate " + GraphTile::FileSuffix(base) + " from the tile extract");
+    return nullptr;
+  }
+  data.pop_back();
+
+  size = data.size();
+  auto memory = std::make_unique<InflatedGraphMemory>(std::move(data));
+  return GraphTile::Create(base, std::move(memory), std::move(traffic_memory));
+}
+
+graph_tile_ptr GraphReader::LoadGraphTile(const GraphId& base, size_t& size) {
+  std::vector<size_t> sizes;
+  auto tiles = LoadGraphTiles({base}, sizes);
+  size = sizes.front();
+  return std::move(tiles.front());
+}
+
+std::vector<graph_tile_ptr> GraphReader::LoadGraphTiles(const std::vector<GraphId>& bases,
+                                                        std::vector<size_t>& sizes) {
+  std::vector<graph_tile_ptr> tiles(bases.size());
+  sizes.assign(bases.size(), 0);
+  std::vector<size_t> remote;
+  auto traffic_memory = [this](const GraphId& base) -> std::unique_ptr<const GraphMemory> {
     auto traffic_ptr = tile_extract_->traffic_tiles.find(base);
-    auto traffic_memory = traffic_ptr != tile_extract_->traffic_tiles.end()
-                              ? std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
-                                                                     traffic_ptr->second)
-                              : nullptr;
+    if (traffic_ptr == tile_extract_->traffic_tiles.end()) {
+      return nullptr;
+    }
+    return std::make_unique<TarballGraphMemory>(tile_extract_->traffic_archive,
+                                                traffic_ptr->second);
+  };
+  // The tile from shared memory, it lives there rather than on the heap
+  auto shared = [this, &traffic_memory](const GraphId& base, graph_tile_ptr& tile, size_t& size) {
+    auto position = shm_cache_->find(base);
+    if (!position.first) {
+      return false;
+    }
+    auto memory = std::make_unique<SharedGraphMemory>(shm_cache_, position);
+    tile = GraphTile::Create(base, std::move(memory), traffic_memory(base));
+    size = AVERAGE_MM_TILE_SIZE;
+    return true;
+  };
+  // Copies a tile we loaded into shared memory and swaps it for the copy there
+  auto share = [this, &shared](const GraphId& base, graph_tile_ptr& tile, size_t& size) {
+    if (shm_cache_ && shm_cache_->insert(base, reinterpret_cast<const char*>(tile->header()),
+                                         tile->header()->end_offset())) {
+      shared(base, tile, size);
+    }
+  };
+
+  for (size_t i = 0; i < bases.size(); ++i) {
+    const auto& base = bases[i];
+    if (shard_ && !shard_->Contains(base)) {
+      continue;
+    }
+
+    // Another process on the host may have loaded it already
+    if (shm_cache_ && shared(base, tiles[i], sizes[i])) {
+      continue;
+    }
 
     // Try to get it from disk and if we cant..
-    graph_tile_ptr tile = GraphTile::Create(tile_dir_, base, std::move(traffic_memory));
-    if (!tile || !tile->header()) {
-      if (!tile_getter_) {
-        return nullptr;
+    auto tile = GraphTile::Create(tile_dir_, base, traffic_memory(base), tile_dir_mmap_);
+    if (tile && tile->header()) {
+      // LOG_DEBUG("Disk cache hit " + GraphTile::FileSuffix(base));
+      // Only uncompressed tiles on disk get mapped, gzipped ones are on the heap. Mapped tiles
+      // live in the page cache not the heap
+      struct stat buffer;
+      const bool mapped = tile_dir_mmap_ && stat((tile_dir_ + filesystem::path::preferred_separator +
+                                                  GraphTile::FileSuffix(base))
+                                                     .c_str(),
+                                                 &buffer) == 0;
+      sizes[i] = mapped ? AVERAGE_MM_TILE_SIZE : tile->header()->end_offset();
+      tiles[i] = std::move(tile);
+      if (!mapped) {
+        share(base, tiles[i], sizes[i]);
       }
+      continue;
+    }
+    if (!tile_getter_) {
+      continue;
+    }
 
-      {
-        std::lock_guard<std::mutex> lock(_404s_lock);
-        if (_404s.find(base) != _404s.end()) {
-          // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(base));
-          return nullptr;
-        }
+    std::lock_guard<std::mutex> lock(_404s_lock);
+    if (_404s.find(base) == _404s.end()) {
+      remote.push_back(i);
+    } else {
+      // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(base));
+    }
+  }
+  if (remote.empty()) {
+    return tiles;
+  }
+
+  // Get them from the url and cache them to disk if you can
+  std::vector<graph_tile_ptr> downloaded;
+  if (remote.size() == 1) {
+    downloaded.push_back(
+        GraphTile::CacheTileURL(tile_url_, bases[remote.front()], tile_getter_.get(), tile_dir_));
+  } else {
+    std::vector<GraphId> remote_bases;
+    remote_bases.reserve(remote.size());
+    for (const auto i : remote) {
+      remote_bases.push_back(bases[i]);
+    }
+    downloaded = GraphTile::CacheTileURLs(tile_url_, remote_bases, tile_getter_.get(), tile_dir_);
+  }
+  for (size_t j = 0; j < remote.size(); ++j) {
+    const auto i = remote[j];
+    if (!downloaded[j]) {
+      std::lock_guard<std::mutex> lock(_404s_lock);
+      _404s.insert(bases[i]);
+      // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(bases[i]));
+      continue;
+    }
+    // LOG_DEBUG("Url cache hit " + GraphTile::FileSuffix(bases[i]));
+    sizes[i] = downloaded[j]->header()->end_offset();
+    tiles[i] = std::move(downloaded[j]);
+    share(bases[i], tiles[i], sizes[i]);
+  }
+  return tiles;
+}
+
+void GraphReader::Prefetch(const std::vector<GraphId>& tile_ids) {
+  if (!prefetcher_) {
+    return;
+  }
+  for (const auto& tile_id : tile_ids) {
+    const auto base = tile_id.Tile_Base();
+    if (base.Is_Valid() && base.level() <= TileHierarchy::get_max_level() &&
+        !cache_->Contains(base)) {
+      prefetcher_->request(base);
+    }
+  }
+}
+
+void GraphReader::PrefetchNeighborsOf(const GraphId& tile_id) {
+  last_prefetched_tile_ = tile_id;
+  if (tile_id.level() > TileHierarchy::get_max_level() ||
+      !prefetched_tiles_.insert(tile_id).second) {
+    return;
+  }
+
+  // The eight tiles around this one, wrapping around the antimeridian
+  const auto& tiles = TileHierarchy::get_tiling(tile_id.level());
+  const auto row_col = tiles.GetRowColumn(tile_id.tileid());
+  std::vector<GraphId> neighbors;
+  neighbors.reserve(8);
+  for (int32_t row = row_col.first - 1; row <= row_col.first + 1; ++row) {
+    if (row < 0 || row >= tiles.nrows()) {
+      continue;
+    }
+    for (int32_t offset = -1; offset <= 1; ++offset) {
+      const int32_t col = (row_col.second + offset + tiles.ncolumns()) % tiles.ncolumns();
+      if (row != row_col.first || col != row_col.second) {
+        neighbors.emplace_back(tiles.TileId(col, row), tile_id.level(), 0);
       }
+    }
+  }
+  Prefetch(neighbors);
+}
 
-      // Get it from the url and cache it to disk if you can
-      tile = GraphTile::CacheTileURL(tile_url_, base, tile_getter_.get(), tile_dir_);
-      if (!tile) {
-        std::lock_guard<std::mutex> lock(_404s_lock);
-        _404s.insert(base);
-        // LOG_DEBUG("Url cache miss " + GraphTile::FileSuffix(base));
-        return nullptr;
+void GraphReader::PrefetchCorridor(const midgard::PointLL& a, const midgard::PointLL& b) {
+  if (!prefetcher_) {
+    return;
+  }
+
+  std::vector<std::pair<double, GraphId>> tiles;
+  const std::vector<midgard::PointLL> line{a, b};
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile : level.tiles.Intersect(line)) {
+      const auto center = level.tiles.Center(tile.first);
+      tiles.emplace_back(std::min(center.Distance(a), center.Distance(b)),
+                         GraphId(tile.first, level.level, 0));
+    }
+  }
+  std::sort(tiles.begin(), tiles.end(),
+            [](const auto& x, const auto& y) { return x.first < y.first; });
+
+  std::vector<GraphId> tile_ids;
+  tile_ids.reserve(tiles.size());
+  for (const auto& tile : tiles) {
+    tile_ids.push_back(tile.second);
+  }
+  Prefetch(tile_ids);
+}
+
+void GraphReader::DropPrefetched() {
+  if (prefetcher_) {
+    prefetcher_->clear();
+    prefetched_tiles_.clear();
+    last_prefetched_tile_ = {};
+  }
+}
+
+GraphReader::WarmupStats GraphReader::Warmup(const std::vector<GraphId>& tile_ids, size_t threads) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // The tiles which are not cached yet, each once and in the order they were asked for
+  std::vector<GraphId> bases;
+  std::unordered_set<GraphId> seen;
+  for (const auto& tile_id : tile_ids) {
+    const auto base = tile_id.Tile_Base();
+    if (base.Is_Valid() && base.level() <= TileHierarchy::get_max_level() &&
+        (!shard_ || shard_->Contains(base)) && !cache_->Contains(base) &&
+        seen.insert(base).second) {
+      bases.push_back(base);
+    }
+  }
+  threads = std::max<size_t>(1, std::min(threads, bases.size()));
+
+  // Each thread reads every threads'th tile, a tar extract is mapped already so only its pages
+  // need to be read for the tiles to be in memory
+  std::vector<graph_tile_ptr> tiles(bases.size());
+  std::vector<size_t> sizes(bases.size(), 0);
+  auto read = [&](size_t first) {
+    for (size_t i = first; i < bases.size(); i += threads) {
+      if (tile_extract_->tiles.empty()) {
+        tiles[i] = LoadGraphTile(bases[i], sizes[i]);
+        continue;
       }
-      // LOG_DEBUG("Url cache hit " + GraphTile::FileSuffix(base));
-    } else {
-      // LOG_DEBUG("Disk cache hit " + GraphTile::FileSuffix(base));
+      // compressed tiles have to be inflated anyway, that is where the time goes
+      if (!tile_extract_->inflated_sizes.empty()) {
+        tiles[i] = LoadExtractTile(bases[i], sizes[i]);
+        continue;
+      }
+      auto t = tile_extract_->tiles.find(bases[i]);
+      if (t == tile_extract_->tiles.cend()) {
+        continue;
+      }
+      const volatile char* bytes = t->second.first;
+      char touched = 0;
+      for (size_t offset = 0; offset < t->second.second; offset += WARMUP_PAGE_STRIDE) {
+        touched ^= bytes[offset];
+      }
+      static_cast<void>(touched);
+      sizes[i] = t->second.second;
     }
+  };
+  std::vector<std::thread> readers;
+  for (size_t first = 1; first < threads; ++first) {
+    readers.emplace_back(read, first);
+  }
+  read(0);
+  for (auto& reader : readers) {
+    reader.join();
+  }
 
-    // Keep a copy in the cache and return it
-    const size_t size = tile->header()->end_offset();
-    return cache_->Put(base, std::move(tile), size);
+  // The cache keeps the loaded tiles it has room for
+  WarmupStats stats{};
+  for (size_t i = 0; i < bases.size(); ++i) {
+    if (sizes[i] == 0) {
+      continue;
+    }
+    ++stats.tiles;
+    stats.bytes += sizes[i];
+    if (tiles[i] && !cache_->OverCommitted()) {
+      ++cache_stats_.tiles_loaded;
+      cache_stats_.bytes_loaded += sizes[i];
+      cache_->Put(bases[i], std::move(tiles[i]), sizes[i]);
+    }
   }
+  stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                 .count();
+  warmup_stats_.tiles += stats.tiles;
+  warmup_stats_.bytes += stats.bytes;
+  warmup_stats_.ms += stats.ms;
+  return stats;
 }
 
+
 // Convenience method to get an opposing directed edge graph Id.
 GraphId GraphReader::GetOpposingEdgeId(const GraphId& edgeid, graph_tile_ptr& opp_tile) {
   // If you cant get the tile you get an invalid id
@@ -826,9 +2266,17 @@ GraphId GraphReader::GetShortcut(const GraphId& id) {
 
 // Unpack edges for a given shortcut edge
 std::vector<GraphId> GraphReader::RecoverShortcut(const GraphId& shortcut_id) {
+  if (extract_snapshot_ && extract_snapshot_->recover_shortcut) {
+    return extract_snapshot_->recover_shortcut(shortcut_id, *this);
+  }
   return shortcut_recovery_t::get_instance().get(shortcut_id, *this);
 }
 
+// Write the superseded edges of all shortcuts to an index
+void GraphReader::WriteShortcutIndex(const std::string& index_file) {
+  shortcut_recovery_t::write_index(*this, index_file);
+}
+
 // Convenience method to get the relative edge density (from the
 // begin node of an edge).
 uint32_t GraphReader::GetEdgeDensity(const GraphId& edgeid) {
@@ -899,6 +2347,13 @@ std::unordered_set<GraphId> GraphReader::GetTileSet() const {
     }
   }
 
+  // leave out the tiles of other shards
+  if (shard_) {
+    for (auto tile = tiles.begin(); tile != tiles.end();) {
+      tile = shard_->Contains(*tile) ? std::next(tile) : tiles.erase(tile);
+    }
+  }
+
   // give them back
   return tiles;
 }
@@ -929,6 +2384,11 @@ std::unordered_set<GraphId> GraphReader::GetTileSet(const uint8_t level) const {
       }
     }
   }
+  if (shard_) {
+    for (auto tile = tiles.begin(); tile != tiles.end();) {
+      tile = shard_->Contains(*tile) ? std::next(tile) : tiles.erase(tile);
+    }
+  }
   return tiles;
 }
 
@@ -981,6 +2441,49 @@ GraphReader::GetIncidentTile(const GraphId& tile_id) const {
                            : std::shared_ptr<valhalla::IncidentsTile>{};
 }
 
+std::vector<GraphId> GraphReader::PollTrafficUpdates() {
+  std::vector<GraphId> updated;
+  for (const auto& traffic_tile : tile_extract_->traffic_tiles) {
+    if (traffic_tile.second.second < sizeof(TrafficTileHeader)) {
+      continue;
+    }
+    const auto* header =
+        reinterpret_cast<const volatile TrafficTileHeader*>(traffic_tile.second.first);
+    if (header->traffic_tile_version != TRAFFIC_TILE_VERSION) {
+      continue;
+    }
+    uint32_t generation = header->generation;
+    auto inserted = traffic_generations_.emplace(traffic_tile.first, generation);
+    if (!inserted.second && inserted.first->second != generation) {
+      inserted.first->second = generation;
+      updated.emplace_back(traffic_tile.first);
+    }
+  }
+
+  // the first time around there is nothing to compare to
+  if (!traffic_polled_) {
+    traffic_polled_ = true;
+    updated.clear();
+  }
+
+  if (!updated.empty()) {
+    for (const auto& observer : traffic_observers_) {
+      observer(updated);
+    }
+  }
+  return updated;
+}
+
+uint32_t GraphReader::GetTrafficGeneration(const GraphId& tile_id) const {
+  auto traffic_tile = tile_extract_->traffic_tiles.find(tile_id.Tile_Base());
+  if (traffic_tile == tile_extract_->traffic_tiles.cend() ||
+      traffic_tile->second.second < sizeof(TrafficTileHeader)) {
+    return 0;
+  }
+  const auto* header = reinterpret_cast<const volatile TrafficTileHeader*>(traffic_tile->second.first);
+  return header->traffic_tile_version == TRAFFIC_TILE_VERSION ? header->generation : 0;
+}
+
 IncidentResult GraphReader::GetIncidents(const GraphId& edge_id, graph_tile_ptr& tile) {
   // if we are not doing this for any reason then bail
   std::shared_ptr<const valhalla::IncidentsTile> itile;
@@ -8,8 +8,10 @@
 #include "filesystem.h"
 #include "midgard/aabb2.h"
 #include "midgard/pointll.h"
+#include "midgard/sequence.h"
 #include "midgard/tiles.h"
 
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <chrono>
 #include <cmath>
@@ -31,6 +33,15 @@ namespace {
 const AABB2<PointLL> world_box(PointLL(-180, -90), PointLL(180, 90));
 constexpr float COMPRESSION_HINT = 3.5f;
 
+// the edge a complex restriction is looked up by, where it ends going forward and where it starts
+// going in reverse
+inline uint64_t
+restriction_key(const char* restrictions, const uint32_t offset, const bool forward) {
+  const auto* cr =
+      reinterpret_cast<const valhalla::baldr::ComplexRestriction*>(restrictions + offset);
+  return forward ? cr->to_graphid().value : cr->from_graphid().value;
+}
+
 // the point of this function is to avoid race conditions for writing a tile between threads
 // so the easiest thing to do is just use the thread id to differentiate
 std::string GenerateTmpSuffix() {
@@ -56,6 +67,18 @@ private:
   const std::vector<char> memory_;
 };
 
+class MappedGraphMemory final : public GraphMemory {
+public:
+  MappedGraphMemory(const std::string& file_name, size_t file_size) {
+    file_.map_readonly(file_name, file_size);
+    data = file_.get();
+    size = file_.size();
+  }
+
+private:
+  midgard::mem_map<char> file_;
+};
+
 graph_tile_ptr GraphTile::DecompressTile(const GraphId& graphid,
                                          const std::vector<char>& compressed) {
   // for setting where to read compressed data from
@@ -96,7 +119,8 @@ graph_tile_ptr GraphTile::DecompressTile(const GraphId& graphid,
 // Constructor given a filename. Reads the graph data into memory.
 graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
                                  const GraphId& graphid,
-                                 std::unique_ptr<const GraphMemory>&& traffic_memory) {
+                                 std::unique_ptr<const GraphMemory>&& traffic_memory,
+                                 bool memory_map) {
   if (!graphid.Is_Valid()) {
     LOG_ERROR("Failed to build GraphTile. Error: GraphId is invalid");
     return nullptr;
@@ -115,6 +139,17 @@ graph_tile_ptr GraphTile::Create(const std::string& tile_dir,
   // Open to the end of the file so we can immediately get size
   const std::string file_location =
       tile_dir + filesystem::path::preferred_separator + FileSuffix(graphid.Tile_Base());
+
+  // Map the file rather than reading it, the pages are then shared with every other process
+  // mapping the same tile and only get loaded when touched
+  struct stat file_stat;
+  if (memory_map && stat(file_location.c_str(), &file_stat) == 0 && file_stat.st_size > 0) {
+    return graph_tile_ptr{
+        new GraphTile(graphid,
+                      std::make_unique<const MappedGraphMemory>(file_location, file_stat.st_size),
+                      std::move(traffic_memory))};
+  }
+
   std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
   if (file.is_open()) {
     // Read binary file into memory. TODO - protect against failure to allocate memory
@@ -234,6 +269,47 @@ graph_tile_ptr GraphTile::CacheTileURL(const std::string& tile_url,
   auto fname = valhalla::baldr::GraphTile::FileSuffix(graphid.Tile_Base(),
                                                       valhalla::baldr::SUFFIX_NON_COMPRESSED, false);
   auto result = tile_getter->get(baldr::make_single_point_url(tile_url, fname));
+  return FromResponse(graphid, tile_getter, cache_location, result);
+}
+
+std::vector<graph_tile_ptr> GraphTile::CacheTileURLs(const std::string& tile_url,
+                                                     const std::vector<GraphId>& graphids,
+                                                     tile_getter_t* tile_getter,
+                                                     const std::string& cache_location) {
+  std::vector<graph_tile_ptr> tiles(graphids.size());
+  if (!tile_getter) {
+    return tiles;
+  }
+
+  // Don't bother with invalid ids
+  std::vector<size_t> requested;
+  std::vector<std::string> urls;
+  for (size_t i = 0; i < graphids.size(); ++i) {
+    const auto& graphid = graphids[i];
+    if (graphid.Is_Valid() && graphid.level() <= TileHierarchy::get_max_level()) {
+      auto fname = valhalla::baldr::GraphTile::FileSuffix(graphid.Tile_Base(),
+                                                          valhalla::baldr::SUFFIX_NON_COMPRESSED,
+                                                          false);
+      urls.emplace_back(baldr::make_single_point_url(tile_url, fname));
+      requested.push_back(i);
+    }
+  }
+  if (urls.empty()) {
+    return tiles;
+  }
+
+  auto results = tile_getter->get_multi(urls);
+  for (size_t i = 0; i < requested.size(); ++i) {
+    tiles[requested[i]] =
+        FromResponse(graphids[requested[i]], tile_getter, cache_location, results[i]);
+  }
+  return tiles;
+}
+
+graph_tile_ptr GraphTile::FromResponse(const GraphId& graphid,
+                                       const tile_getter_t* tile_getter,
+                                       const std::string& cache_location,
+                                       tile_getter_t::response_t& result) {
   if (result.status_ != tile_getter_t::status_code_t::SUCCESS) {
     return nullptr;
   }
@@ -351,22 +427,55 @@ void GraphTile::Initialize(const GraphId& graphid) {
   textlist_ = tile_ptr + header_->textlist_offset();
   textlist_size_ = header_->lane_connectivity_offset() - header_->textlist_offset();
 
+  // Text offsets below the size of the dictionary the tile was built with are into the dictionary
+  if (header_->shared_textlist_size()) {
+    shared_text_ = TextDictionary::Registered();
+    if (!shared_text_ || shared_text_->size() != header_->shared_textlist_size() ||
+        shared_text_->checksum() != header_->shared_textlist_checksum()) {
+      throw std::runtime_error("Tile " + std::to_string(graphid.value) +
+                               " was built with a text dictionary which isn't loaded");
+    }
+    shared_textlist_ = shared_text_->data();
+    shared_textlist_size_ = shared_text_->size();
+  }
+
   // Start of lane connections and their size
   lane_connectivity_ =
       reinterpret_cast<LaneConnectivity*>(tile_ptr + header_->lane_connectivity_offset());
-  lane_connectivity_size_ = header_->predictedspeeds_offset() - header_->lane_connectivity_offset();
-
   // Start of predicted speed data.
+  uint32_t lane_connectivity_end = header_->end_offset();
   if (header_->predictedspeeds_count() > 0) {
     char* ptr1 = tile_ptr + header_->predictedspeeds_offset();
     char* ptr2 = ptr1 + (header_->directededgecount() * sizeof(int32_t));
     predictedspeeds_.set_offset(reinterpret_cast<uint32_t*>(ptr1));
     predictedspeeds_.set_profiles(reinterpret_cast<int16_t*>(ptr2));
 
-    lane_connectivity_size_ = header_->predictedspeeds_offset() - header_->lane_connectivity_offset();
+    lane_connectivity_end = header_->predictedspeeds_offset();
+  }
+
+  // Hot directed edge attributes (if available). They are appended to the end of the tile so the
+  // predicted speeds may come before or after them
+  if (header_->has_hot_directededge()) {
+    hot_directededges_ =
+        reinterpret_cast<DirectedEdgeHot*>(tile_ptr + header_->hot_directededge_offset());
+    lane_connectivity_end = std::min(lane_connectivity_end, header_->hot_directededge_offset());
+  }
+
+  // Index of the complex restrictions, right after the lane connections. Older tiles don't have
+  // one so it is built for them
+  if (header_->complex_restriction_index_offset()) {
+    const auto* index =
+        reinterpret_cast<const uint32_t*>(tile_ptr + header_->complex_restriction_index_offset());
+    complex_restriction_forward_count_ = index[0];
+    complex_restriction_reverse_count_ = index[1];
+    complex_restriction_forward_index_ = index + 2;
+    complex_restriction_reverse_index_ = index + 2 + complex_restriction_forward_count_;
+    lane_connectivity_end =
+        std::min(lane_connectivity_end, header_->complex_restriction_index_offset());
   } else {
-    lane_connectivity_size_ = header_->end_offset() - header_->lane_connectivity_offset();
+    IndexRestrictions();
   }
+  lane_connectivity_size_ = lane_connectivity_end - header_->lane_connectivity_offset();
 
   // For reference - how to use the end offset to set size of an object (that
   // is not fixed size and count).
@@ -378,6 +487,47 @@ void GraphTile::Initialize(const GraphId& graphid) {
   if (graphid.level() == 3) {
     AssociateOneStopIds(graphid);
   }
+
+  // Index the departures by line and hour
+  IndexDepartures();
+}
+
+void GraphTile::IndexDepartures() {
+  // Departures are sorted by line Id and then by departure time
+  const uint32_t count = header_->departurecount();
+  for (uint32_t begin = 0; begin < count;) {
+    const uint32_t lineid = departures_[begin].lineid();
+    uint32_t end = begin;
+    while (end < count && departures_[end].lineid() == lineid) {
+      ++end;
+    }
+
+    // A frequency schedule can end after fixed departures which leave later, so each hour starts
+    // at the first departure which is still usable at the start of it
+    auto& line = line_departures_[lineid];
+    line.begin = begin;
+    line.end = end;
+    for (uint32_t i = begin; i < end; ++i) {
+      const auto& d = departures_[i];
+      const uint32_t last = d.type() == kFixedSchedule ? d.departure_time() : d.end_time();
+      while (line.hours.size() <= last / kSecondsPerHour) {
+        line.hours.push_back(i);
+      }
+    }
+    begin = end;
+  }
+}
+
+uint32_t
+GraphTile::FirstDeparture(const uint32_t lineid, const uint32_t current_time, uint32_t& end) const {
+  const auto line = line_departures_.find(lineid);
+  if (line == line_departures_.cend()) {
+    end = 0;
+    return end;
+  }
+  end = line->second.end;
+  const auto hour = current_time / kSecondsPerHour;
+  return hour < line->second.hours.size() ? line->second.hours[hour] : end;
 }
 
 // For transit tiles we need to save off the pair<tileid,lineid> lookup via
@@ -667,35 +817,51 @@ iterable_t<const DirectedEdgeExt> GraphTile::GetDirectedEdgeExts(const size_t id
 }
 
 EdgeInfo GraphTile::edgeinfo(const DirectedEdge* edge) const {
-  return EdgeInfo(edgeinfo_ + edge->edgeinfo_offset(), textlist_, textlist_size_);
+  return EdgeInfo(edgeinfo_ + edge->edgeinfo_offset(), textlist_, textlist_size_, shared_textlist_,
+                  shared_textlist_size_);
 }
 
 // Get the complex restrictions in the forward or reverse order based on
 // the id and modes.
-std::vector<ComplexRestriction*>
+ComplexRestrictions
 GraphTile::GetRestrictions(const bool forward, const GraphId id, const uint64_t modes) const {
-  size_t offset = 0;
-  std::vector<ComplexRestriction*> cr_vector;
-  if (forward) {
-    while (offset < complex_restriction_forward_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_forward_ + offset);
-      if (cr->to_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
-    }
-  } else {
-    while (offset < complex_restriction_reverse_size_) {
-      ComplexRestriction* cr =
-          reinterpret_cast<ComplexRestriction*>(complex_restriction_reverse_ + offset);
-      if (cr->from_graphid() == id && (cr->modes() & modes)) {
-        cr_vector.push_back(cr);
-      }
-      offset += cr->SizeOf();
+  char* restrictions = forward ? complex_restriction_forward_ : complex_restriction_reverse_;
+  const uint32_t* begin =
+      forward ? complex_restriction_forward_index_ : complex_restriction_reverse_index_;
+  const uint32_t* end =
+      begin + (forward ? complex_restriction_forward_count_ : complex_restriction_reverse_count_);
+  begin = std::lower_bound(begin, end, id.value, [&](const uint32_t offset, const uint64_t value) {
+    return restriction_key(restrictions, offset, forward) < value;
+  });
+  end = std::upper_bound(begin, end, id.value, [&](const uint64_t value, const uint32_t offset) {
+    return value < restriction_key(restrictions, offset, forward);
+  });
+  return ComplexRestrictions(begin, end, restrictions, modes);
+}
+
+// Builds the index of the complex restrictions for tiles that don't have one
+void GraphTile::IndexRestrictions() {
+  const auto index = [this](const bool forward) {
+    char* restrictions = forward ? complex_restriction_forward_ : complex_restriction_reverse_;
+    const size_t size =
+        forward ? complex_restriction_forward_size_ : complex_restriction_reverse_size_;
+    const auto begin = complex_restriction_index_.size();
+    for (size_t offset = 0; offset < size;) {
+      complex_restriction_index_.push_back(offset);
+      offset += reinterpret_cast<const ComplexRestriction*>(restrictions + offset)->SizeOf();
     }
-  }
-  return cr_vector;
+    std::stable_sort(complex_restriction_index_.begin() + begin, complex_restriction_index_.end(),
+                     [&](const uint32_t a, const uint32_t b) {
+                       return restriction_key(restrictions, a, forward) <
+                              restriction_key(restrictions, b, forward);
+                     });
+    return complex_restriction_index_.size() - begin;
+  };
+  complex_restriction_forward_count_ = index(true);
+  complex_restriction_reverse_count_ = index(false);
+  complex_restriction_forward_index_ = complex_restriction_index_.data();
+  complex_restriction_reverse_index_ =
+      complex_restriction_index_.data() + complex_restriction_forward_count_;
 }
 
 // Get the directed edges outbound from the specified node index.
@@ -730,7 +896,7 @@ uint16_t GraphTile::GetTypes(const DirectedEdge* edge) const {
 AdminInfo GraphTile::admininfo(const size_t idx) const {
   if (idx < header_->admincount()) {
     const Admin& admin = admins_[idx];
-    return AdminInfo(textlist_ + admin.country_offset(), textlist_ + admin.state_offset(),
+    return AdminInfo(text(admin.country_offset()), text(admin.state_offset()),
                      admin.country_iso(), admin.state_iso());
   }
   throw std::runtime_error("GraphTile AdminInfo index out of bounds");
@@ -746,8 +912,8 @@ const Admin* GraphTile::admin(const size_t idx) const {
 
 // Convenience method to get the text/name for a given offset to the textlist
 std::string GraphTile::GetName(const uint32_t textlist_offset) const {
-  if (textlist_offset < textlist_size_) {
-    return textlist_ + textlist_offset;
+  if (textlist_offset < text_size()) {
+    return text(textlist_offset);
   } else {
     throw std::runtime_error("GetName: offset exceeds size of text list");
   }
@@ -756,56 +922,31 @@ std::string GraphTile::GetName(const uint32_t textlist_offset) const {
 // Convenience method to process the signs for an edge given the
 // directed edge or node index.
 std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx, bool signs_on_node) const {
-  uint32_t count = header_->signcount();
   std::vector<SignInfo> signs;
-  if (count == 0) {
+  if (header_->signcount() == 0) {
     return signs;
   }
 
-  // Signs are sorted by edge index.
-  // Binary search to find a sign with matching edge index.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& sign = signs_[mid];
-    // matching edge index
-    if (idx == sign.index()) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller index
-    else if (idx < sign.index()) {
-      high = mid - 1;
-    } // need a bigger index
-    else {
-      low = mid + 1;
-    }
-  }
-
   // Add signs
-  for (; found < count && signs_[found].index() == idx; ++found) {
-    if (signs_[found].text_offset() < textlist_size_) {
+  for (const auto& sign : this->signs(idx)) {
+    if (sign.text_offset() < text_size()) {
 
-      std::string text = (textlist_ + signs_[found].text_offset());
+      std::string text = this->text(sign.text_offset());
 
       // only add named signs when asking for signs at the node and
       // only add edge signs when asking for signs at the edges.
       // is_route_num_type indicates if this phonome is for a node or not; therefore,
       // we only return a node phoneme when is_route_num_type and signs_on_node are both true and
       // we only return an edge phoneme when is_route_num_type and signs_on_node are both false
-      if (((signs_[found].type() == Sign::Type::kJunctionName ||
-            (signs_[found].type() == Sign::Type::kPronunciation &&
-             signs_[found].is_route_num_type())) &&
+      if (((sign.type() == Sign::Type::kJunctionName ||
+            (sign.type() == Sign::Type::kPronunciation && sign.is_route_num_type())) &&
            signs_on_node) ||
-          (((signs_[found].type() != Sign::Type::kJunctionName &&
-             signs_[found].type() != Sign::Type::kPronunciation) ||
-            (signs_[found].type() == Sign::Type::kPronunciation &&
-             !signs_[found].is_route_num_type())) &&
+          (((sign.type() != Sign::Type::kJunctionName &&
+             sign.type() != Sign::Type::kPronunciation) ||
+            (sign.type() == Sign::Type::kPronunciation && !sign.is_route_num_type())) &&
            !signs_on_node))
-        signs.emplace_back(signs_[found].type(), signs_[found].is_route_num_type(),
-                           signs_[found].tagged(), false, 0, 0, text);
+        signs.emplace_back(sign.type(), sign.is_route_num_type(), sign.tagged(), false, 0, 0,
+                           text);
     } else {
       throw std::runtime_error("GetSigns: offset exceeds size of text list");
     }
@@ -822,45 +963,22 @@ std::vector<SignInfo> GraphTile::GetSigns(
     const uint32_t idx,
     std::unordered_map<uint32_t, std::pair<uint8_t, std::string>>& index_pronunciation_map,
     bool signs_on_node) const {
-  uint32_t count = header_->signcount();
   std::vector<SignInfo> signs;
-  if (count == 0) {
+  if (header_->signcount() == 0) {
     return signs;
   }
-  index_pronunciation_map.reserve(count);
-
-  // Signs are sorted by edge index.
-  // Binary search to find a sign with matching edge index.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& sign = signs_[mid];
-    // matching edge index
-    if (idx == sign.index()) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller index
-    else if (idx < sign.index()) {
-      high = mid - 1;
-    } // need a bigger index
-    else {
-      low = mid + 1;
-    }
-  }
+  index_pronunciation_map.reserve(header_->signcount());
 
   // Add signs
-  for (; found < count && signs_[found].index() == idx; ++found) {
-    if (signs_[found].text_offset() < textlist_size_) {
+  for (const auto& sign : this->signs(idx)) {
+    if (sign.text_offset() < text_size()) {
 
-      const auto* text = (textlist_ + signs_[found].text_offset());
-      if (signs_[found].tagged() && signs_[found].type() == Sign::Type::kPronunciation) {
+      const auto* text = this->text(sign.text_offset());
+      if (sign.tagged() && sign.type() == Sign::Type::kPronunciation) {
 
         // is_route_num_type indicates if this phonome is for a node or not
-        if ((signs_[found].is_route_num_type() && signs_on_node) ||
-            (!signs_[found].is_route_num_type() && !signs_on_node)) {
+        if ((sign.is_route_num_type() && signs_on_node) ||
+            (!sign.is_route_num_type() && !signs_on_node)) {
           size_t pos = 0;
           while (pos < strlen(text)) {
             const auto header = midgard::unaligned_read<linguistic_text_header_t>(text + pos);
@@ -885,10 +1003,10 @@ std::vector<SignInfo> GraphTile::GetSigns(
 
       // only add named signs when asking for signs at the node and
       // only add edge signs when asking for signs at the edges.
-      if ((signs_[found].type() == Sign::Type::kJunctionName && signs_on_node) ||
-          (signs_[found].type() != Sign::Type::kJunctionName && !signs_on_node))
-        signs.emplace_back(signs_[found].type(), signs_[found].is_route_num_type(),
-                           signs_[found].tagged(), false, 0, 0, text);
+      if ((sign.type() == Sign::Type::kJunctionName && signs_on_node) ||
+          (sign.type() != Sign::Type::kJunctionName && !signs_on_node))
+        signs.emplace_back(sign.type(), sign.is_route_num_type(), sign.tagged(), false, 0, 0,
+                           text);
     } else {
       throw std::runtime_error("GetSigns: offset exceeds size of text list");
     }
@@ -899,45 +1017,41 @@ std::vector<SignInfo> GraphTile::GetSigns(
   return signs;
 }
 
+// Get the signs of an edge or node without copying them. They are sorted by index
+midgard::iterable_t<const Sign> GraphTile::signs(const uint32_t idx) const {
+  const auto* begin = signs_;
+  const auto* end = begin + header_->signcount();
+  const auto* first = std::lower_bound(begin, end, idx, [](const Sign& sign, uint32_t i) {
+    return sign.index() < i;
+  });
+  const auto* last = std::upper_bound(first, end, idx, [](uint32_t i, const Sign& sign) {
+    return i < sign.index();
+  });
+  return {first, last};
+}
+
 // Get lane connections ending on this edge.
 std::vector<LaneConnectivity> GraphTile::GetLaneConnectivity(const uint32_t idx) const {
-  uint32_t count = lane_connectivity_size_ / sizeof(LaneConnectivity);
-  std::vector<LaneConnectivity> lcs;
-  if (count == 0) {
+  const auto lane_connections = this->lane_connections(idx);
+  if (lane_connections.size() == 0) {
     LOG_ERROR("No lane connections found for idx = " + std::to_string(idx));
-    return lcs;
-  }
-
-  // Lane connections are sorted by edge index.
-  // Binary search to find a sign with matching edge index.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& lc = lane_connectivity_[mid];
-    // matching edge index
-    if (idx == lc.to()) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller index
-    else if (idx < lc.to()) {
-      high = mid - 1;
-    } // need a bigger index
-    else {
-      low = mid + 1;
-    }
   }
+  return std::vector<LaneConnectivity>(lane_connections.begin(), lane_connections.end());
+}
 
-  // Add Lane connections
-  for (; found < count && lane_connectivity_[found].to() == idx; ++found) {
-    lcs.emplace_back(lane_connectivity_[found]);
-  }
-  if (lcs.size() == 0) {
-    LOG_ERROR("No lane connections found for idx = " + std::to_string(idx));
-  }
-  return lcs;
+// Get the lane connections ending on this edge without copying them. They are sorted by edge index
+midgard::iterable_t<const LaneConnectivity>
+GraphTile::lane_connections(const uint32_t idx) const {
+  const auto* begin = lane_connectivity_;
+  const auto* end = begin + lane_connectivity_size_ / sizeof(LaneConnectivity);
+  const auto* first =
+      std::lower_bound(begin, end, idx, [](const LaneConnectivity& lc, uint32_t i) {
+        return lc.to() < i;
+      });
+  const auto* last = std::upper_bound(first, end, idx, [](uint32_t i, const LaneConnectivity& lc) {
+    return i < lc.to();
+  });
+  return {first, last};
 }
 
 // Get the next departure given the directed line Id and the current
@@ -949,40 +1063,18 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
                                                     bool date_before_tile,
                                                     bool wheelchair,
                                                     bool bicycle) const {
-  uint32_t count = header_->departurecount();
-  if (count == 0) {
-    return nullptr;
-  }
+  // Start at the first departure of the line within the hour
+  uint32_t end;
+  auto found = FirstDeparture(lineid, current_time, end);
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& dep = departures_[mid];
-    // matching lineid and a workable time
-    if (lineid == dep.lineid() &&
-        ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
-         (current_time <= dep.end_time() && dep.type() == kFrequencySchedule))) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    } // either need a bigger lineid or a later time
-    else {
-      low = mid + 1;
-    }
-  }
-
-  // Iterate through departures until one is found with valid date, dow or
+  // Iterate through departures until one is found with a workable time, valid date, dow or
   // calendar date, and does not have a calendar exception.
-  for (; found < count && departures_[found].lineid() == lineid; ++found) {
+  for (; found < end; ++found) {
     // Make sure it falls within the schedule and departure props are valid
     const auto& d = departures_[found];
+    if ((d.type() == kFixedSchedule ? d.departure_time() : d.end_time()) < current_time) {
+      continue;
+    }
     if ((wheelchair && !d.wheelchair_accessible()) || (bicycle && !d.bicycle_accessible()) ||
         !GetTransitSchedule(d.schedule_index())->IsValid(day, dow, date_before_tile)) {
       continue;
@@ -1020,38 +1112,15 @@ const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
 const TransitDeparture* GraphTile::GetTransitDeparture(const uint32_t lineid,
                                                        const uint32_t tripid,
                                                        const uint32_t current_time) const {
-  uint32_t count = header_->departurecount();
-  if (count == 0) {
-    return nullptr;
-  }
+  // Start at the first departure of the line within the hour
+  uint32_t end;
+  auto found = FirstDeparture(lineid, current_time, end);
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& dep = departures_[mid];
-    // find the first matching lineid in the list
-    if (lineid == dep.lineid() &&
-        ((current_time <= dep.departure_time() && dep.type() == kFixedSchedule) ||
-         (current_time <= dep.end_time() && dep.type() == kFrequencySchedule))) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    } // need a bigger lineid
-    else {
-      low = mid + 1;
-    }
-  }
-
-  // Iterate through departures until one is found with matching trip id
-  for (; found < count && departures_[found].lineid() == lineid; ++found) {
-    if (departures_[found].tripid() == tripid) {
+  // Iterate through departures until one is found with matching trip id and a workable time
+  for (; found < end; ++found) {
+    const auto& dep = departures_[found];
+    if (dep.tripid() == tripid &&
+        (dep.type() == kFixedSchedule ? dep.departure_time() : dep.end_time()) >= current_time) {
 
       if (departures_[found].type() == kFixedSchedule) {
         return &departures_[found];
@@ -1081,6 +1150,16 @@ const TransitDeparture* GraphTile::GetTransitDeparture(const uint32_t lineid,
   return nullptr;
 }
 
+// Get the departures of a line
+midgard::iterable_t<const TransitDeparture>
+GraphTile::GetLineDepartures(const uint32_t lineid) const {
+  const auto line = line_departures_.find(lineid);
+  if (line == line_departures_.cend()) {
+    return {departures_, departures_};
+  }
+  return {departures_ + line->second.begin, departures_ + line->second.end};
+}
+
 // Get a map of departures based on lineid.  No dups exist in the map.
 std::unordered_map<uint32_t, TransitDeparture*> GraphTile::GetTransitDepartures() const {
 
@@ -1151,45 +1230,31 @@ const TransitSchedule* GraphTile::GetTransitSchedule(const uint32_t idx) const {
 // Get the access restriction given its directed edge index
 std::vector<AccessRestriction> GraphTile::GetAccessRestrictions(const uint32_t idx,
                                                                 const uint32_t access) const {
-
-  std::vector<AccessRestriction> restrictions;
-  uint32_t count = header_->access_restriction_count();
-  if (count == 0) {
-    return restrictions;
-  }
-
-  // Access restriction are sorted by edge Id.
-  // Binary search to find a access restriction with matching edge Id.
-  int32_t low = 0;
-  int32_t high = count - 1;
-  int32_t mid;
-  auto found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& res = access_restrictions_[mid];
-    // find the first matching index in the list
-    if (idx == res.edgeindex()) {
-      found = mid;
-      high = mid - 1;
-    } // need a smaller index
-    else if (idx < res.edgeindex()) {
-      high = mid - 1;
-    } // need a bigger index
-    else {
-      low = mid + 1;
-    }
-  }
-
   // Add restrictions for only the access that we are interested in
-  for (; found < count && access_restrictions_[found].edgeindex() == idx; ++found) {
-    if (access_restrictions_[found].modes() & access) {
-      restrictions.emplace_back(access_restrictions_[found]);
+  std::vector<AccessRestriction> restrictions;
+  for (const auto& restriction : access_restrictions(idx)) {
+    if (restriction.modes() & access) {
+      restrictions.emplace_back(restriction);
     }
   }
-
   return restrictions;
 }
 
+// Get the access restrictions of an edge without copying them. They are sorted by edge index
+midgard::iterable_t<const AccessRestriction>
+GraphTile::access_restrictions(const uint32_t idx) const {
+  const auto* begin = access_restrictions_;
+  const auto* end = begin + header_->access_restriction_count();
+  const auto* first =
+      std::lower_bound(begin, end, idx, [](const AccessRestriction& r, uint32_t i) {
+        return r.edgeindex() < i;
+      });
+  const auto* last = std::upper_bound(first, end, idx, [](uint32_t i, const AccessRestriction& r) {
+    return i < r.edgeindex();
+  });
+  return {first, last};
+}
+
 // Get the array of graphids for this bin
 midgard::iterable_t<GraphId> GraphTile::GetBin(size_t column, size_t row) const {
   auto offsets = header_->bin_offset(column, row);
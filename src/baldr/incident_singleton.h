@@ -22,13 +22,17 @@ constexpr size_t DEFAULT_MAX_LATENT_COUNT = 5;
 struct incident_singleton_t {
 protected:
   // parameter pack to share state between daemon thread and singleton instance
+  using cache_t = std::unordered_map<uint64_t, std::shared_ptr<const valhalla::IncidentsTile>>;
   struct state_t {
     std::atomic<bool> initialized;  // whether or not the watcher thread has done 1 load of incidents
-    std::atomic<bool> lock_free;    // whether or not we can skip locking around cache operations
+    std::atomic<bool> lock_free;    // whether or not readers can use the preallocated cache directly
     std::condition_variable signal; // how the watcher tells the main thread its done its first load
-    std::mutex mutex;               // for locking on cache operations
-    // the actual cache where tiles are stored
-    std::unordered_map<uint64_t, std::shared_ptr<const valhalla::IncidentsTile>> cache;
+    std::mutex mutex;               // for waiting on the signal
+    // the actual cache where tiles are stored, its layout only changes on the watcher thread
+    cache_t cache;
+    // when the tileset isnt static readers get an immutable copy of the cache instead, the watcher
+    // swaps in a new one after every scan in which something changed
+    std::shared_ptr<const cache_t> snapshot;
   };
   // we use a shared_ptr to wrap the state between the watcher thread and the main threads singleton
   // instance. this gives the responsibility to the last living thread to deallocate the state object.
@@ -129,7 +133,7 @@ protected:
                           decltype(state_t::cache)::iterator* hint = nullptr) {
     // see if we have a slot
     auto found = hint ? *hint : state->cache.find(tile_id);
-    // if we dont have a slot make one, this must be synchronized
+    // if we dont have a slot make one, readers only see it once the next snapshot is published
     if (found == state->cache.cend()) {
       // this shouldnt happen in lock free mode but can if you put unexpected tiles in the log/dir
       if (state->lock_free.load()) {
@@ -137,14 +141,7 @@ protected:
                  " because it was not found in the configured tile extract");
         return false;
       }
-      // actually make a spot in the cache synchronously
-      try {
-        std::unique_lock<std::mutex> lock(state->mutex);
-        found = state->cache.insert({tile_id, {}}).first;
-      } // if anything went wrong we have to catch it so that the mutex is unlocked
-      catch (...) {
-        LOG_ERROR("Incident watcher failed to add incident tile to cache");
-      }
+      found = state->cache.insert({tile_id, {}}).first;
     }
     // atomically store the tile shared_ptr, could be actually nullptr when there are no incidents
     std::atomic_store_explicit(&found->second, tile, std::memory_order_release);
@@ -153,6 +150,28 @@ protected:
     return true;
   }
 
+  /**
+   * Hands readers a copy of the cache with the tiles that have incidents in it. Readers never wait
+   * on this, they keep using the snapshot they loaded until they load the next one. Does nothing in
+   * lock free mode where readers use the cache directly
+   * @param state     the state to publish
+   */
+  static void publish(const std::shared_ptr<state_t>& state) {
+    if (state->lock_free.load()) {
+      return;
+    }
+    auto snapshot = std::make_shared<cache_t>();
+    snapshot->reserve(state->cache.size());
+    for (const auto& entry : state->cache) {
+      auto tile = std::atomic_load_explicit(&entry.second, std::memory_order_acquire);
+      if (tile) {
+        snapshot->emplace(entry.first, std::move(tile));
+      }
+    }
+    std::atomic_store_explicit(&state->snapshot, std::shared_ptr<const cache_t>(std::move(snapshot)),
+                               std::memory_order_release);
+  }
+
   /**
    * Thread work function that continually checks for updates to incident tiles. The thread begins by
    * deciding whether its just scanning the directory (works for a small number of incidents) or using
@@ -174,11 +193,14 @@ protected:
    * of two parts. The first 25 bits are the tile id and level (the same format as a normal graphid)
    * the remaining 39 bits are the timestamp. Any tile entry in the log which has a timestamp later or
    * equal to the timestamp of the last scan that was performed will be read into the incident cache.
-   * Tiles which are in the cache but were not found on the disk in the last scan will b epurged as
-   * they have been removed from the log. If a static tileset was provided any tiles which are found
-   * in the log but are nto part of the tileset will be ignored. When the timestamp for the last check
-   * is older than a timestamp for a given file that file is replaced with whatever its contents are
-   * on disk.
+   * The entries of the previous scan are kept so that only the slots of the log which changed
+   * since then are looked at in detail, a slot whose entry is the same and older than the last scan
+   * costs a single comparison. Tiles are counted by the slots of the log they are in, the ones no
+   * slot holds any more are purged as they have been removed from the log, without a pass over the
+   * whole cache.
+   * If a static tileset was provided any tiles which are found in the log but are not part of the
+   * tileset will be ignored. When the timestamp for the last check is older than a timestamp for a
+   * given file that file is replaced with whatever its contents are on disk.
    *
    * @param config     lets the function know where to look for incidents and desired update frequency
    * @param tileset    if not empty, the static list of tiles to track (other tiles will be ignored).
@@ -231,6 +253,10 @@ protected:
         config.get<time_t>("incident_max_loading_latency", DEFAULT_MAX_LOADING_LATENCY);
     std::unordered_set<uint64_t> seen;
     seen.reserve(tileset.size());
+    // the changelog as of the last scan and how many of its slots each tile is in
+    std::vector<uint64_t> entries;
+    std::unordered_map<uint64_t, uint32_t> slots;
+    std::vector<uint64_t> released;
 
     // wait for someone to tell us to stop
     do {
@@ -252,15 +278,28 @@ protected:
           break;
         }
 
-        // check all of the timestamps/tile_ids
+        // check all of the timestamps/tile_ids against what they were last time
+        constexpr uint64_t tile_mask = (uint64_t(1) << 25) - 1;
+        size_t slot = 0;
+        released.clear();
         for (auto entry : *changelog) {
-          // first 25 bits are the tile id
-          valhalla::baldr::GraphId tile_id(((uint64_t(1) << 25) - 1) & entry);
-          seen.insert(tile_id);
           // spare last 39 bits are the timestamp, leaves us with something like 17k years
           int64_t timestamp = (entry >> 25) & ((uint64_t(1) << 39) - 1);
-          // check the timestamp part of the tile id to see if its newer
-          if (last_scan <= timestamp) {
+          // a slot which changed always has a new tile to read, one which didnt only if the tile
+          // was written again within the same second as the last scan started
+          bool changed = slot >= entries.size() || entries[slot] != entry;
+          if (changed || last_scan <= timestamp) {
+            // first 25 bits are the tile id
+            valhalla::baldr::GraphId tile_id(tile_mask & entry);
+            if (changed) {
+              ++slots[tile_id];
+              if (slot < entries.size()) {
+                released.push_back(tile_mask & entries[slot]);
+                entries[slot] = entry;
+              } else {
+                entries.push_back(entry);
+              }
+            }
             // concoct a file name from the tile_id
             auto file_location = inc_log_path;
             file_location.replace_filename(
@@ -268,6 +307,26 @@ protected:
             // update the tile
             update_count += update_tile(state, tile_id, read_tile(file_location.string()));
           }
+          ++slot;
+        }
+
+        // the slots past the end are gone if the log got shorter
+        for (size_t i = slot; i < entries.size(); ++i) {
+          released.push_back(tile_mask & entries[i]);
+        }
+        entries.resize(slot);
+
+        // the tiles which are no longer in any slot have been removed from the changelog
+        for (auto tile_id : released) {
+          auto count = slots.find(tile_id);
+          if (count == slots.end() || --count->second > 0) {
+            continue;
+          }
+          slots.erase(count);
+          auto found = state->cache.find(tile_id);
+          if (found != state->cache.end() && found->second) {
+            update_count += update_tile(state, valhalla::baldr::GraphId(tile_id), nullptr, &found);
+          }
         }
       } // we are in directory scan mode
       else if (!inc_dir.string().empty()) {
@@ -295,15 +354,20 @@ protected:
         }
       }
 
-      // for all the ones we didnt see, they have been removed from the filesystem or changelog
+      // for all the ones we didnt see, they have been removed from the filesystem
       // no locking is needed because we don't realloc here we just null out some values
-      for (auto entry = state->cache.begin(); entry != state->cache.end(); ++entry) {
+      for (auto entry = state->cache.begin(); !changelog && entry != state->cache.end(); ++entry) {
         auto found = seen.find(entry->first);
         if (found == seen.cend() && entry->second) {
           update_count += update_tile(state, valhalla::baldr::GraphId(entry->first), nullptr, &entry);
         }
       }
 
+      // let readers see what changed
+      if (update_count > 0 || run_count == 0) {
+        publish(state);
+      }
+
       // if this round finished but was slower than we want
       last_scan = current_scan;
       auto latency = time(nullptr) - current_scan;
@@ -347,15 +411,22 @@ public:
     static incident_singleton_t singleton{config, tileset};
 
     // return the tile from the cache or an empty one if its not there
-    auto scoped_lock = singleton.state->lock_free.load()
-                           ? std::unique_lock<std::mutex>()
-                           : std::unique_lock<std::mutex>(singleton.state->mutex);
-    auto found = singleton.state->cache.find(tile_id);
-    if (found == singleton.state->cache.cend()) {
+    if (singleton.state->lock_free.load()) {
+      auto found = singleton.state->cache.find(tile_id);
+      if (found == singleton.state->cache.cend()) {
+        return {};
+      }
+      auto tile = std::atomic_load_explicit(&found->second, std::memory_order_acquire);
+      return tile;
+    }
+
+    // otherwise from the latest snapshot the watcher published
+    auto snapshot = std::atomic_load_explicit(&singleton.state->snapshot, std::memory_order_acquire);
+    if (!snapshot) {
       return {};
     }
-    auto tile = std::atomic_load_explicit(&found->second, std::memory_order_acquire);
-    return tile;
+    auto found = snapshot->find(tile_id);
+    return found == snapshot->cend() ? nullptr : found->second;
   }
 };
 } // namespace
@@ -0,0 +1,54 @@
+#include "baldr/landmarkdistances.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+namespace valhalla {
+namespace baldr {
+
+std::shared_ptr<const LandmarkDistances> LandmarkDistances::Map(const std::string& file_name) {
+  if (file_name.empty() || !filesystem::exists(file_name)) {
+    return nullptr;
+  }
+  size_t size = std::ifstream(file_name, std::ios::binary | std::ios::ate).tellg();
+  if (size < sizeof(header_t)) {
+    LOG_WARN("Landmark distances " + file_name + " are too small to be landmark distances");
+    return nullptr;
+  }
+
+  std::shared_ptr<LandmarkDistances> distances(new LandmarkDistances());
+  distances->mapped_.map_readonly(file_name, size);
+  const auto* header = reinterpret_cast<const header_t*>(distances->mapped_.get());
+  if (header->version != kVersion || header->landmark_count == 0 ||
+      size != sizeof(header_t) + header->tile_count * sizeof(tile_t) +
+                  header->node_count * header->landmark_count * sizeof(uint32_t)) {
+    LOG_WARN("Landmark distances " + file_name + " are not of this version or incomplete");
+    return nullptr;
+  }
+
+  distances->landmark_count_ = static_cast<uint32_t>(header->landmark_count);
+  distances->tiles_begin_ = reinterpret_cast<const tile_t*>(header + 1);
+  distances->tiles_end_ = distances->tiles_begin_ + header->tile_count;
+  distances->distances_ = reinterpret_cast<const uint32_t*>(distances->tiles_end_);
+  LOG_INFO("Landmark distances " + file_name + " mapped with " +
+           std::to_string(header->landmark_count) + " landmarks and " +
+           std::to_string(header->node_count) + " nodes");
+  return distances;
+}
+
+const uint32_t* LandmarkDistances::get(const GraphId& node, const uint32_t node_count) const {
+  const uint64_t tile_id = node.Tile_Base().value;
+  auto tile = std::lower_bound(tiles_begin_, tiles_end_, tile_id,
+                               [](const tile_t& t, uint64_t id) { return t.tile_id < id; });
+  if (tile == tiles_end_ || tile->tile_id != tile_id || tile->node_count != node_count ||
+      node.id() >= tile->node_count) {
+    return nullptr;
+  }
+  return distances_ + (tile->offset + node.id()) * landmark_count_;
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -0,0 +1,196 @@
+#include "baldr/memory_budget.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "filesystem.h"
+#include "midgard/logging.h"
+
+namespace {
+
+// The pressure halves the budget at every look down to this share of it
+constexpr float kMinScale = 1.f / 16.f;
+// and it grows back by this share at every look without pressure
+constexpr float kScaleStep = 1.f / 8.f;
+// Using more than this share of the memory limit counts as pressure too
+constexpr float kMaxUsedShare = 0.9f;
+
+std::string read_file(const std::string& path) {
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// the value of a key in a list of key value lines, as in /proc/meminfo or memory.stat
+size_t read_value(const std::string& contents, const std::string& key) {
+  std::istringstream lines(contents);
+  std::string name;
+  size_t value;
+  while (lines >> name >> value) {
+    if (name == key) {
+      return value;
+    }
+    lines.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return 0;
+}
+
+// the directory of the cgroup (v2) of the process, empty if it has none
+std::string cgroup_dir() {
+  std::ifstream file("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.rfind("0::", 0) == 0) {
+      const auto dir = "/sys/fs/cgroup" + line.substr(3);
+      if (filesystem::exists(dir + "/memory.max")) {
+        return dir;
+      }
+    }
+  }
+  // in a container of its own the cgroup of the process is mounted as the root
+  return filesystem::exists("/sys/fs/cgroup/memory.max") ? "/sys/fs/cgroup" : "";
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+memory_budget_t::memory_budget_t(float fraction, float max_pressure, std::chrono::seconds interval)
+    : fraction_(fraction), max_pressure_(max_pressure), budget_(0), scale_(1.f), shares_(0),
+      done_(false) {
+  if (interval.count() <= 0) {
+    return;
+  }
+  Update(Read());
+  LOG_INFO("Tile caches get " + std::to_string(budget_.load() >> 20) + " MB of memory");
+  thread_ = std::thread([this, interval]() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, interval, [this]() { return done_; })) {
+      lock.unlock();
+      Update(Read());
+      lock.lock();
+    }
+  });
+}
+
+memory_budget_t::~memory_budget_t() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  wake_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<memory_budget_t> memory_budget_t::get(const boost::property_tree::ptree& pt) {
+  const auto fraction = pt.get<float>("cache_memory_fraction", 0.f);
+  if (fraction <= 0.f) {
+    return nullptr;
+  }
+  const auto max_pressure = pt.get<float>("cache_memory_pressure", 10.f);
+  const auto interval = pt.get<uint32_t>("cache_memory_check_seconds", 5);
+
+  // the budget lasts as long as any reader uses it
+  static std::mutex mutex;
+  static std::map<std::tuple<float, float, uint32_t>, std::weak_ptr<memory_budget_t>> budgets;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& weak = budgets[std::make_tuple(fraction, max_pressure, interval)];
+  auto budget = weak.lock();
+  if (!budget) {
+    budget = std::make_shared<memory_budget_t>(fraction, max_pressure,
+                                               std::chrono::seconds(std::max(interval, 1u)));
+    weak = budget;
+  }
+  return budget;
+}
+
+std::shared_ptr<void> memory_budget_t::Join() {
+  ++shares_;
+  auto self = shared_from_this();
+  return std::shared_ptr<void>(nullptr, [self](void*) { --self->shares_; });
+}
+
+size_t memory_budget_t::Limit(size_t max_size, bool shared) const {
+  const size_t budget = budget_.load(std::memory_order_relaxed) * scale_.load();
+  // without a memory limit to go by the caches keep their own
+  if (budget == 0) {
+    return max_size;
+  }
+  const auto share = shared ? budget : budget / std::max<size_t>(shares_.load(), 1);
+  return std::min(max_size, std::max(share, kMinCacheSize));
+}
+
+void memory_budget_t::Update(const reading_t& reading) {
+  budget_.store(static_cast<size_t>(reading.limit * fraction_), std::memory_order_relaxed);
+  const bool pressured = reading.pressure > max_pressure_ ||
+                         (reading.limit > 0 && reading.used > reading.limit * kMaxUsedShare);
+  const auto scale = scale_.load();
+  scale_.store(pressured ? std::max(scale / 2.f, kMinScale) : std::min(scale + kScaleStep, 1.f));
+}
+
+memory_budget_t::reading_t memory_budget_t::Read() {
+  reading_t reading;
+  const auto meminfo = read_file("/proc/meminfo");
+  const auto total = read_value(meminfo, "MemTotal:") * 1024;
+  const auto available = read_value(meminfo, "MemAvailable:") * 1024;
+  reading.limit = total;
+  reading.used = total > available ? total - available : 0;
+
+  // a cgroup limit counts if it's below what the machine has, without one it's "max" or a huge
+  // number. The page cache the cgroup could drop (inactive files) doesn't count as used
+  std::string pressure;
+  const auto dir = cgroup_dir();
+  size_t limit, usage, inactive;
+  if (!dir.empty()) {
+    limit = ParseBytes(read_file(dir + "/memory.max"));
+    usage = ParseBytes(read_file(dir + "/memory.current"));
+    inactive = read_value(read_file(dir + "/memory.stat"), "inactive_file");
+    pressure = read_file(dir + "/memory.pressure");
+  } else {
+    limit = ParseBytes(read_file("/sys/fs/cgroup/memory/memory.limit_in_bytes"));
+    usage = ParseBytes(read_file("/sys/fs/cgroup/memory/memory.usage_in_bytes"));
+    inactive = read_value(read_file("/sys/fs/cgroup/memory/memory.stat"), "total_inactive_file");
+  }
+  if (limit > 0 && (total == 0 || limit < total)) {
+    reading.limit = limit;
+    reading.used = usage > inactive ? usage - inactive : 0;
+  }
+
+  if (pressure.empty()) {
+    pressure = read_file("/proc/pressure/memory");
+  }
+  reading.pressure = ParsePressure(pressure);
+  return reading;
+}
+
+size_t memory_budget_t::ParseBytes(const std::string& contents) {
+  try {
+    return std::stoull(contents);
+  } catch (...) { return 0; }
+}
+
+float memory_budget_t::ParsePressure(const std::string& contents) {
+  // e.g. "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+  std::istringstream lines(contents);
+  std::string line;
+  while (std::getline(lines, line)) {
+    const auto avg10 = line.find("avg10=");
+    if (line.rfind("some", 0) == 0 && avg10 != std::string::npos) {
+      try {
+        return std::stof(line.substr(avg10 + 6));
+      } catch (...) { return 0.f; }
+    }
+  }
+  return 0.f;
+}
+
+} // namespace baldr
+} // namespace valhalla
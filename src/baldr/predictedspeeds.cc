@@ -1,5 +1,7 @@
 #include "baldr/predictedspeeds.h"
 
+#include <cctype>
+
 namespace valhalla {
 namespace baldr {
 
@@ -8,9 +10,29 @@ constexpr float k1OverSqrt2 = 0.707106781f; // 1 / sqrt(2)
 constexpr float kPiBucketConstant = 3.14159265f / 2016.0f;
 constexpr float kSpeedNormalization = 0.031497039f; // sqrt(2.0f / 2016.0f);
 
+// Number of partial sums used when decoding a speed, must divide kCoefficientCount
+constexpr uint32_t kDecompressLanes = 8;
+static_assert(kCoefficientCount % kDecompressLanes == 0, "Coefficients must fill all lanes");
+
 // Size of the cos table for the buckets
 constexpr uint32_t kCosBucketTableSize = kCoefficientCount * kBucketsPerWeek;
 
+// The 6 bits each character of the base64 alphabet stands for, kNotBase64 for any other character
+constexpr uint8_t kNotBase64 = 0xff;
+constexpr std::array<uint8_t, 256> MakeBase64Values() {
+  constexpr const char* kAlphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::array<uint8_t, 256> values{};
+  for (auto& value : values) {
+    value = kNotBase64;
+  }
+  for (uint8_t i = 0; i < 64; ++i) {
+    values[static_cast<uint8_t>(kAlphabet[i])] = i;
+  }
+  return values;
+}
+constexpr std::array<uint8_t, 256> kBase64Values = MakeBase64Values();
+
 // Precompute a cos table for each bucket of the week as a singleton.
 class BucketCosTable final {
 public:
@@ -55,10 +77,10 @@ std::array<int16_t, kCoefficientCount> compress_speed_buckets(const float* speed
   std::array<float, kCoefficientCount> coefficients;
   coefficients.fill(0.f);
 
-  // DCT-II with speed normalization
-  for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
-    // Get a pointer to the precomputed cos values for this bucket
-    const float* cos_values = BucketCosTable::GetInstance().get(bucket);
+  // DCT-II with speed normalization. The cos values of the buckets follow each other in the table
+  // and each bucket adds to every coefficient at once, which the compiler vectorizes
+  const float* cos_values = BucketCosTable::GetInstance().get(0);
+  for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket, cos_values += kCoefficientCount) {
     for (uint32_t c = 0; c < kCoefficientCount; ++c) {
       coefficients[c] += cos_values[c] * speeds[bucket];
     }
@@ -76,11 +98,18 @@ float decompress_speed_bucket(const int16_t* coefficients, uint32_t bucket_idx)
   // Get a pointer to the precomputed cos values for this bucket
   const float* b = BucketCosTable::GetInstance().get(bucket_idx);
 
-  // DCT-III with speed normalization
-  float speed = *coefficients * k1OverSqrt2;
-  const auto* coef_end = coefficients + kCoefficientCount;
-  for (++b, ++coefficients; coefficients < coef_end; ++coefficients, ++b) {
-    speed += *coefficients * *b;
+  // DCT-III with speed normalization. The sum is split over independent partial sums so that the
+  // compiler can keep them in vector registers, a single running sum forces one add after another
+  float partial[kDecompressLanes] = {};
+  for (uint32_t i = 0; i < kCoefficientCount; i += kDecompressLanes) {
+    for (uint32_t lane = 0; lane < kDecompressLanes; ++lane) {
+      partial[lane] += coefficients[i + lane] * b[i + lane];
+    }
+  }
+  // The first coefficient is weighted by 1/sqrt(2) rather than cos(0) = 1
+  float speed = coefficients[0] * (k1OverSqrt2 - 1.f);
+  for (uint32_t lane = 0; lane < kDecompressLanes; ++lane) {
+    speed += partial[lane];
   }
   return speed * kSpeedNormalization;
 }
@@ -96,19 +125,43 @@ std::string encode_compressed_speeds(const int16_t* coefficients) {
   return midgard::encode64(result);
 }
 
-std::array<int16_t, kCoefficientCount> decode_compressed_speeds(const std::string& encoded) {
-  const std::string& decoded_str = midgard::decode64(encoded);
-  if (decoded_str.size() != kDecodedSpeedSize) {
-    throw std::runtime_error(
-        "Decoded speed string size expected= " + std::to_string(kDecodedSpeedSize) +
-        " actual=" + std::to_string(decoded_str.size()));
+std::array<int16_t, kCoefficientCount> decode_compressed_speeds(std::string_view encoded) {
+  // Decode the base64 straight into the bytes, skipping white space up to the padding. This is done
+  // for every edge when adding predicted traffic to the tiles so no strings are made along the way
+  uint8_t raw[kDecodedSpeedSize];
+  size_t decoded_size = 0;
+  uint32_t bits = 0, bit_count = 0;
+  for (const char c : encoded) {
+    if (c == '=') {
+      break;
+    }
+    const auto value = kBase64Values[static_cast<uint8_t>(c)];
+    if (value == kNotBase64) {
+      if (std::isspace(static_cast<unsigned char>(c))) {
+        continue;
+      }
+      throw std::runtime_error("Invalid base64 character in the speeds");
+    }
+    bits = ((bits << 6) | value) & 0xfff;
+    bit_count += 6;
+    if (bit_count >= 8) {
+      bit_count -= 8;
+      if (decoded_size < kDecodedSpeedSize) {
+        raw[decoded_size] = static_cast<uint8_t>(bits >> bit_count);
+      }
+      ++decoded_size;
+    }
+  }
+  if (decoded_size != kDecodedSpeedSize) {
+    throw std::runtime_error("Decoded speed string size expected= " +
+                             std::to_string(kDecodedSpeedSize) +
+                             " actual=" + std::to_string(decoded_size));
   }
-  const int8_t* raw = reinterpret_cast<const int8_t*>(decoded_str.data());
   // Create the coefficients. Each group of 2 bytes represents a signed, int16 number
   // (big endian). Convert to little endian.
   std::array<int16_t, kCoefficientCount> coefficients;
   for (uint32_t i = 0, idx = 0; i < kCoefficientCount; ++i, idx += 2) {
-    coefficients[i] = midgard::to_little_endian(*(reinterpret_cast<const uint16_t*>(&raw[idx])));
+    coefficients[i] = static_cast<int16_t>((raw[idx] << 8) | raw[idx + 1]);
   }
   return coefficients;
 }
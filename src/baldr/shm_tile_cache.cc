@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "baldr/shm_tile_cache.h"
+#include "midgard/logging.h"
+
+namespace {
+
+constexpr uint32_t kFresh = 0;     // a new segment is all zeros
+constexpr uint32_t kLayingOut = 1; // the process which created it is setting it up
+constexpr uint32_t kReady = 2;
+constexpr uint32_t kVersion = 1;
+
+// bytes of tiles per slot of the index, most tiles are larger than that so it stays sparse
+constexpr size_t kBytesPerSlot = 4096;
+constexpr size_t kMinSlots = 64;
+constexpr size_t kPageSize = 4096;
+
+// how long to wait for another process to set up the segment
+constexpr std::chrono::seconds kLayoutTimeout(10);
+
+inline uint64_t slot_hash(const valhalla::baldr::GraphId& base) {
+  return (base.value * 0x9E3779B97F4A7C15ull) >> 32;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+struct shm_tile_cache_t::header_t {
+  std::atomic<uint32_t> state;
+  uint32_t version;
+  uint64_t slot_count;
+  uint64_t data_offset;
+  uint64_t data_size;
+  std::atomic<uint64_t> used;
+};
+
+// the key is zero for an empty slot, otherwise the base id plus one shifted up by a bit which is
+// set once the offset and size are filled in
+struct shm_tile_cache_t::slot_t {
+  std::atomic<uint64_t> key;
+  uint64_t offset;
+  uint64_t size;
+};
+
+// the atomics are shared with other processes so they have to work without a lock
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory needs lock free atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory needs lock free atomics");
+
+shm_tile_cache_t::shm_tile_cache_t(const std::string& name, size_t size)
+    : name_(name), memory_(nullptr), size_(size), header_(nullptr) {
+#ifdef _WIN32
+  throw std::runtime_error("Shared memory tile caches are not supported on this platform");
+#else
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open shared memory segment " + name + ": " +
+                             strerror(errno));
+  }
+
+  // the first process sizes the segment, the others take it as it is
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (st.st_size == 0 && ftruncate(fd, size) != 0)) {
+    close(fd);
+    throw std::runtime_error("Could not size shared memory segment " + name + ": " +
+                             strerror(errno));
+  }
+  size_ = st.st_size == 0 ? size : st.st_size;
+  if (size_ < sizeof(header_t) + kMinSlots * sizeof(slot_t) + kPageSize) {
+    close(fd);
+    throw std::runtime_error("Shared memory segment " + name + " is too small");
+  }
+
+  void* memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("Could not map shared memory segment " + name + ": " +
+                             strerror(errno));
+  }
+  memory_ = static_cast<char*>(memory);
+  header_ = reinterpret_cast<header_t*>(memory_);
+
+  // whoever gets to it first lays the segment out, the index gets at most an eighth of it
+  uint32_t state = kFresh;
+  if (header_->state.compare_exchange_strong(state, kLayingOut, std::memory_order_acquire)) {
+    size_t slot_count = kMinSlots;
+    while (slot_count * kBytesPerSlot < size_ &&
+           slot_count * 2 * sizeof(slot_t) <= size_ / 8) {
+      slot_count *= 2;
+    }
+    header_->version = kVersion;
+    header_->slot_count = slot_count;
+    header_->data_offset =
+        (sizeof(header_t) + slot_count * sizeof(slot_t) + kPageSize - 1) / kPageSize * kPageSize;
+    header_->data_size = size_ - header_->data_offset;
+    header_->used.store(0, std::memory_order_relaxed);
+    header_->state.store(kReady, std::memory_order_release);
+    LOG_INFO("Created shared memory tile cache " + name + " of " + std::to_string(size_) +
+             " bytes");
+  } else {
+    const auto deadline = std::chrono::steady_clock::now() + kLayoutTimeout;
+    while (header_->state.load(std::memory_order_acquire) != kReady) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        munmap(memory_, size_);
+        throw std::runtime_error("Shared memory segment " + name + " was never set up");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  if (header_->version != kVersion) {
+    munmap(memory_, size_);
+    throw std::runtime_error("Shared memory segment " + name + " has an unknown layout");
+  }
+#endif
+}
+
+shm_tile_cache_t::~shm_tile_cache_t() {
+#ifndef _WIN32
+  if (memory_) {
+    munmap(memory_, size_);
+  }
+#endif
+}
+
+std::shared_ptr<shm_tile_cache_t> shm_tile_cache_t::get_instance(const std::string& name,
+                                                                 size_t size) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<shm_tile_cache_t>> instances;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto instance = instances[name].lock();
+  if (!instance) {
+    try {
+      instance = std::make_shared<shm_tile_cache_t>(name, size);
+      instances[name] = instance;
+    } catch (const std::exception& e) {
+      LOG_ERROR(e.what());
+    }
+  }
+  return instance;
+}
+
+bool shm_tile_cache_t::remove(const std::string& name) {
+#ifdef _WIN32
+  return false;
+#else
+  return shm_unlink(name.c_str()) == 0;
+#endif
+}
+
+shm_tile_cache_t::slot_t* shm_tile_cache_t::slots() const {
+  return reinterpret_cast<slot_t*>(memory_ + sizeof(header_t));
+}
+
+char* shm_tile_cache_t::data() const {
+  return memory_ + header_->data_offset;
+}
+
+std::pair<char*, size_t> shm_tile_cache_t::find(const GraphId& base) const {
+  const uint64_t key = (base.value + 1) << 1;
+  const uint64_t mask = header_->slot_count - 1;
+  auto* slots = this->slots();
+  uint64_t i = slot_hash(base) & mask;
+  for (uint64_t probes = 0; probes <= mask; ++probes, i = (i + 1) & mask) {
+    const auto k = slots[i].key.load(std::memory_order_acquire);
+    if (k == 0) {
+      break;
+    }
+    // a tile another process is still copying in isn't there yet
+    if ((k & ~1ull) == key) {
+      return k & 1 ? std::make_pair(data() + slots[i].offset, static_cast<size_t>(slots[i].size))
+                   : std::make_pair(static_cast<char*>(nullptr), size_t(0));
+    }
+  }
+  return {nullptr, 0};
+}
+
+bool shm_tile_cache_t::insert(const GraphId& base, const char* data, size_t size) {
+  if (size == 0 || find(base).first) {
+    return false;
+  }
+
+  // take the room for the bytes first so the slot can be filled in right after claiming it. once
+  // the bytes run out the end stays past them and nothing else is added
+  const uint64_t aligned = (size + 7) & ~7ull;
+  const uint64_t offset = header_->used.fetch_add(aligned, std::memory_order_relaxed);
+  if (offset + aligned > header_->data_size) {
+    return false;
+  }
+  std::memcpy(this->data() + offset, data, size);
+
+  const uint64_t key = (base.value + 1) << 1;
+  const uint64_t mask = header_->slot_count - 1;
+  auto* slots = this->slots();
+  uint64_t i = slot_hash(base) & mask;
+  for (uint64_t probes = 0; probes <= mask; ++probes, i = (i + 1) & mask) {
+    uint64_t k = 0;
+    if (slots[i].key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+      slots[i].offset = offset;
+      slots[i].size = size;
+      slots[i].key.store(key | 1, std::memory_order_release);
+      return true;
+    }
+    // another process added the same tile in the meantime, its copy wins
+    if ((k & ~1ull) == key) {
+      return false;
+    }
+  }
+  return false;
+}
+
+size_t shm_tile_cache_t::used() const {
+  return std::min(header_->used.load(std::memory_order_relaxed), header_->data_size);
+}
+
+size_t shm_tile_cache_t::capacity() const {
+  return header_->data_size;
+}
+
+} // namespace baldr
+} // namespace valhalla
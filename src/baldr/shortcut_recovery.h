@@ -2,14 +2,38 @@
 
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/logging.h"
+#include "midgard/sequence.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace {
+
+// the shortcut index is this header, the entries sorted by shortcut id and then the superseded
+// edges of all the entries one after the other
+struct shortcut_index_header_t {
+  uint64_t version;
+  uint64_t entry_count;
+  uint64_t edge_count;
+};
+
+struct shortcut_index_entry_t {
+  uint64_t shortcut_id;
+  // where the superseded edges of the shortcut start and how many there are
+  uint64_t offset;
+  uint32_t count;
+  uint32_t spare;
+};
+
+constexpr uint64_t kShortcutIndexVersion = 1;
+
 // TODO: break this out into a private header
 // a static cache for shortcut recovery that we can optionally pre-fill
 struct shortcut_recovery_t {
@@ -19,26 +43,52 @@ protected:
    * graphreader passed in is null nothing is cached and revoery will happen on the fly
    * @param reader
    */
-  shortcut_recovery_t(valhalla::baldr::GraphReader* reader) {
+  shortcut_recovery_t(valhalla::baldr::GraphReader* reader, const std::string& index_file = "")
+      : unrecovered(0), superseded(0) {
+    // the index the tile build wrote saves recovering anything
+    if (!index_file.empty() && map_index(index_file)) {
+      LOG_INFO("Shortcut recovery index " + index_file + " mapped with " +
+               std::to_string(index_entry_count()) + " shortcuts");
+      return;
+    }
+
     // do nothing if the reader is no good
     if (!reader) {
       LOG_INFO("Shortcut recovery cache disabled");
       return;
     }
     LOG_INFO("Shortcut recovery cache enabled");
+    recover_all(*reader, shortcuts, unrecovered, superseded);
+    LOG_INFO(std::to_string(shortcuts.size()) + " shortcuts recovered as " +
+             std::to_string(superseded) + " superseded edges. " + std::to_string(unrecovered) +
+             " shortcuts could not be recovered.");
+  }
 
+  /**
+   * Recovers all the shortcuts of a graphreaders tileset, including the ones which fail to recover
+   * so that they are not tried again
+   * @param reader       the tileset to recover
+   * @param shortcuts    the superseded edges of each shortcut
+   * @param unrecovered  how many shortcuts could not be recovered
+   * @param superseded   how many edges the recovered shortcuts supersede
+   */
+  static void
+  recover_all(valhalla::baldr::GraphReader& reader,
+              std::unordered_map<uint64_t, std::vector<valhalla::baldr::GraphId>>& shortcuts,
+              size_t& unrecovered,
+              size_t& superseded) {
     // completely skip the levels that dont have shortcuts
     for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
       // we dont get shortcuts on level 2 and up
       if (level.level > 1)
         continue;
       // for each tile
-      for (auto tile_id : reader->GetTileSet(level.level)) {
+      for (auto tile_id : reader.GetTileSet(level.level)) {
         // cull cache if we are over allocated
-        if (reader->OverCommitted())
-          reader->Trim();
+        if (reader.OverCommitted())
+          reader.Trim();
         // this shouldnt fail but garbled files could cause it
-        auto tile = reader->GetGraphTile(tile_id);
+        auto tile = reader.GetGraphTile(tile_id);
         assert(tile);
         // for each edge in the tile
         for (const auto& edge : tile->GetDirectedEdges()) {
@@ -51,7 +101,7 @@ protected:
           if (shortcuts.find(shortcut_id) != shortcuts.end())
             continue;
           // recover the shortcut and make a copy for opposing direction
-          auto recovered = recover_shortcut(*reader, shortcut_id);
+          auto recovered = recover_shortcut(reader, shortcut_id);
           decltype(recovered) opp_recovered = recovered;
           std::reverse_copy(recovered.cbegin(), recovered.cend(), opp_recovered.begin());
           // save some stats
@@ -63,12 +113,12 @@ protected:
 
           // its cheaper to get the opposing without crawling the graph
           auto opp_tile = tile;
-          auto opp_id = reader->GetOpposingEdgeId(shortcut_id, opp_tile);
+          auto opp_id = reader.GetOpposingEdgeId(shortcut_id, opp_tile);
           if (!opp_id.Is_Valid())
             continue; // dont store edges which arent in our tileset
 
           for (auto& id : opp_recovered) {
-            id = reader->GetOpposingEdgeId(id, opp_tile);
+            id = reader.GetOpposingEdgeId(id, opp_tile);
             if (!id.Is_Valid()) {
               opp_recovered = {opp_id};
               break;
@@ -84,9 +134,6 @@ protected:
       }
     }
 
-    LOG_INFO(std::to_string(shortcuts.size()) + " shortcuts recovered as " +
-             std::to_string(superseded) + " superseded edges. " + std::to_string(unrecovered) +
-             " shortcuts could not be recovered.");
   }
 
   /**
@@ -95,9 +142,9 @@ protected:
    * @param  shortcutid  Graph Id of the shortcut edge.
    * @return Returns the edgeids of the directed edges this shortcut represents.
    */
-  std::vector<valhalla::baldr::GraphId>
+  static std::vector<valhalla::baldr::GraphId>
   recover_shortcut(valhalla::baldr::GraphReader& reader,
-                   const valhalla::baldr::GraphId& shortcut_id) const {
+                   const valhalla::baldr::GraphId& shortcut_id) {
     using namespace valhalla::baldr;
     // grab the shortcut edge
     auto tile = reader.GetGraphTile(shortcut_id);
@@ -194,25 +241,127 @@ protected:
     return edges;
   }
 
+  /**
+   * Maps an index written by write_index, leaves nothing mapped if the file is not a complete index
+   * @param index_file  the index to map
+   * @return true if the index is mapped
+   */
+  bool map_index(const std::string& index_file) {
+    if (!filesystem::exists(index_file)) {
+      return false;
+    }
+    size_t size = std::ifstream(index_file, std::ios::binary | std::ios::ate).tellg();
+    if (size < sizeof(shortcut_index_header_t)) {
+      LOG_WARN("Shortcut recovery index " + index_file + " is too small to be an index");
+      return false;
+    }
+    index.map_readonly(index_file, size);
+    const auto* header = reinterpret_cast<const shortcut_index_header_t*>(index.get());
+    if (header->version != kShortcutIndexVersion ||
+        size != sizeof(shortcut_index_header_t) +
+                    header->entry_count * sizeof(shortcut_index_entry_t) +
+                    header->edge_count * sizeof(uint64_t)) {
+      LOG_WARN("Shortcut recovery index " + index_file + " is not of this version or incomplete");
+      index.unmap();
+      return false;
+    }
+    return true;
+  }
+
+  size_t index_entry_count() const {
+    return index ? reinterpret_cast<const shortcut_index_header_t*>(index.get())->entry_count : 0;
+  }
+
   // a place to cache the recovered shortcuts
   std::unordered_map<uint64_t, std::vector<valhalla::baldr::GraphId>> shortcuts;
+  // or the index of them the tile build wrote
+  valhalla::midgard::mem_map<char> index;
   // a place to keep some stats about the recovery
   size_t unrecovered;
   size_t superseded;
 
 public:
   /**
-   * returns a static instance of the cache after prefilling it. if on the first call,
-   * the reader is nullptr then the cache will not be filled and recovery will be on the fly
+   * returns a static instance of the cache after prefilling it. if on the first call there is an
+   * index it is mapped instead. if the reader is nullptr and there is no index then the cache will
+   * not be filled and recovery will be on the fly
    *
    * @param reader       the reader used to initialize the cache the first time
+   * @param index_file   the index written by the tile build to use the first time if it exists
    * @return a filled cache mapping shortcuts to superceeded edges
    */
-  static shortcut_recovery_t& get_instance(valhalla::baldr::GraphReader* reader = nullptr) {
-    static shortcut_recovery_t cache{reader};
+  static shortcut_recovery_t& get_instance(valhalla::baldr::GraphReader* reader = nullptr,
+                                           const std::string& index_file = "") {
+    static shortcut_recovery_t cache{reader, index_file};
     return cache;
   }
 
+  /**
+   * returns an instance of its own rather than the static one, for a tileset which replaced the one
+   * the static instance was made for
+   *
+   * @param reader       the reader of the tileset used to fill the cache, nullptr to not fill it
+   * @param index_file   the index written by the tile build of the tileset to map if it exists
+   * @return a cache mapping shortcuts to superceded edges
+   */
+  static std::shared_ptr<shortcut_recovery_t> create(valhalla::baldr::GraphReader* reader,
+                                                     const std::string& index_file = "") {
+    return std::shared_ptr<shortcut_recovery_t>(new shortcut_recovery_t{reader, index_file});
+  }
+
+  /**
+   * Recovers all the shortcuts of a graphreaders tileset and writes them to an index which the
+   * services can map when they start instead of recovering the shortcuts again. The index is
+   * written next to the file and moved over it when complete so that it is safe to replace an index
+   * which is mapped
+   *
+   * @param reader       the tileset to recover, its opposing edges must be set
+   * @param index_file   where to write the index
+   */
+  static void write_index(valhalla::baldr::GraphReader& reader, const std::string& index_file) {
+    std::unordered_map<uint64_t, std::vector<valhalla::baldr::GraphId>> shortcuts;
+    size_t unrecovered = 0, superseded = 0;
+    recover_all(reader, shortcuts, unrecovered, superseded);
+
+    std::vector<uint64_t> ids;
+    ids.reserve(shortcuts.size());
+    for (const auto& shortcut : shortcuts) {
+      ids.push_back(shortcut.first);
+    }
+    std::sort(ids.begin(), ids.end());
+
+    std::vector<shortcut_index_entry_t> entries;
+    entries.reserve(ids.size());
+    std::vector<uint64_t> edges;
+    for (auto id : ids) {
+      const auto& recovered = shortcuts[id];
+      entries.push_back({id, edges.size(), static_cast<uint32_t>(recovered.size()), 0});
+      for (const auto& edge : recovered) {
+        edges.push_back(edge.value);
+      }
+    }
+
+    const auto partial = index_file + ".tmp";
+    {
+      shortcut_index_header_t header{kShortcutIndexVersion, entries.size(), edges.size()};
+      std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(entries.data()),
+                 entries.size() * sizeof(shortcut_index_entry_t));
+      file.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(uint64_t));
+      if (!file) {
+        throw std::runtime_error("Could not write the shortcut recovery index " + partial);
+      }
+    }
+    if (!filesystem::rename(partial, index_file)) {
+      throw std::runtime_error("Could not move the shortcut recovery index to " + index_file);
+    }
+    LOG_INFO("Shortcut recovery index " + index_file + " written with " +
+             std::to_string(entries.size()) + " shortcuts as " + std::to_string(superseded) +
+             " superseded edges. " + std::to_string(unrecovered) +
+             " shortcuts could not be recovered.");
+  }
+
   /**
    * returns the list of graphids of the edges superceded by the provided shortcut. saddly because we
    * may have to recover the shortcut on the fly we cannot return const reference here
@@ -222,6 +371,22 @@ public:
    */
   std::vector<valhalla::baldr::GraphId> get(const valhalla::baldr::GraphId& shortcut_id,
                                             valhalla::baldr::GraphReader& reader) const {
+    // the index has the shortcuts sorted by id
+    if (index) {
+      const auto* header = reinterpret_cast<const shortcut_index_header_t*>(index.get());
+      const auto* entries = reinterpret_cast<const shortcut_index_entry_t*>(header + 1);
+      const auto* edges = reinterpret_cast<const uint64_t*>(entries + header->entry_count);
+      const auto* entry =
+          std::lower_bound(entries, entries + header->entry_count, shortcut_id.value,
+                           [](const shortcut_index_entry_t& e, uint64_t id) {
+                             return e.shortcut_id < id;
+                           });
+      if (entry == entries + header->entry_count || entry->shortcut_id != shortcut_id.value)
+        return recover_shortcut(reader, shortcut_id);
+      return std::vector<valhalla::baldr::GraphId>(edges + entry->offset,
+                                                   edges + entry->offset + entry->count);
+    }
+
     // in the case that we didnt fill the cache we fallback to recovering on the fly
     auto itr = shortcuts.find(shortcut_id);
     if (itr == shortcuts.cend())
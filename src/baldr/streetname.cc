@@ -55,14 +55,19 @@ std::string StreetName::GetPostCardinalDir() const {
 }
 
 std::string StreetName::GetBaseName() const {
-  std::string pre_dir = GetPreDir();
-  std::string post_dir = GetPostDir();
+  return std::string(BaseName());
+}
+
+std::string_view StreetName::BaseName() const {
+  const auto pre_dir_size = GetPreDir().size();
+  const auto post_dir_size = GetPostDir().size();
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return std::string_view(value_).substr(pre_dir_size,
+                                         (value_.size() - pre_dir_size - post_dir_size));
 }
 
 bool StreetName::HasSameBaseName(const StreetName& rhs) const {
-  return (GetBaseName() == rhs.GetBaseName());
+  return (BaseName() == rhs.BaseName());
 }
 
 } // namespace baldr
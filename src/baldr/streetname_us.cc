@@ -49,14 +49,32 @@ std::string StreetNameUs::GetPostCardinalDir() const {
 }
 
 std::string StreetNameUs::GetBaseName() const {
-  std::string pre_dir = GetPreDir();
-  std::string post_dir = GetPostDir();
+  return std::string(BaseName());
+}
+
+std::string_view StreetNameUs::BaseName() const {
+  // only the sizes of the directions are needed so they aren't copied out
+  size_t pre_dir_size = 0;
+  for (const auto& pre_dir : StreetNameUs::pre_dirs_) {
+    if (StartsWith(pre_dir)) {
+      pre_dir_size = pre_dir.size();
+      break;
+    }
+  }
+  size_t post_dir_size = 0;
+  for (const auto& post_dir : StreetNameUs::post_dirs_) {
+    if (EndsWith(post_dir)) {
+      post_dir_size = post_dir.size();
+      break;
+    }
+  }
 
-  return value_.substr(pre_dir.size(), (value_.size() - pre_dir.size() - post_dir.size()));
+  return std::string_view(value_).substr(pre_dir_size,
+                                         (value_.size() - pre_dir_size - post_dir_size));
 }
 
 bool StreetNameUs::HasSameBaseName(const StreetName& rhs) const {
-  return (GetBaseName() == rhs.GetBaseName());
+  return (BaseName() == rhs.BaseName());
 }
 
 } // namespace baldr
@@ -147,6 +147,32 @@ StreetNames::FindCommonBaseNames(const StreetNames& other_street_names) const {
   return common_base_names;
 }
 
+size_t StreetNames::CountCommonStreetNames(const StreetNames& other_street_names) const {
+  size_t count = 0;
+  for (const auto& street_name : *this) {
+    for (const auto& other_street_name : other_street_names) {
+      if (*street_name == *other_street_name) {
+        ++count;
+        break;
+      }
+    }
+  }
+  return count;
+}
+
+size_t StreetNames::CountCommonBaseNames(const StreetNames& other_street_names) const {
+  size_t count = 0;
+  for (const auto& street_name : *this) {
+    for (const auto& other_street_name : other_street_names) {
+      if (street_name->HasSameBaseName(*other_street_name)) {
+        ++count;
+        break;
+      }
+    }
+  }
+  return count;
+}
+
 std::unique_ptr<StreetNames> StreetNames::GetRouteNumbers() const {
   std::unique_ptr<StreetNames> route_numbers = std::make_unique<StreetNames>();
   for (const auto& street_name : *this) {
@@ -0,0 +1,71 @@
+#include "baldr/textdictionary.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace {
+
+std::mutex registered_mutex;
+std::shared_ptr<const valhalla::baldr::TextDictionary> registered;
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+TextDictionary::TextDictionary(std::vector<char>&& text) : text_(std::move(text)) {
+  // offset 0 is the empty string in every text list
+  if (text_.empty() || text_.front() != '\0' || text_.back() != '\0') {
+    throw std::runtime_error("Text dictionary has to start with an empty string and end with a "
+                             "null terminator");
+  }
+  checksum_ = crc32(0L, Z_NULL, 0);
+  checksum_ = crc32(checksum_, reinterpret_cast<const Bytef*>(text_.data()),
+                    static_cast<uInt>(text_.size()));
+}
+
+std::shared_ptr<const TextDictionary> TextDictionary::Load(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open text dictionary " + file_name);
+  }
+  std::vector<char> text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return std::make_shared<const TextDictionary>(std::move(text));
+}
+
+void TextDictionary::Store(const std::string& file_name) const {
+  std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not write text dictionary " + file_name);
+  }
+  file.write(text_.data(), text_.size());
+}
+
+void TextDictionary::Register(std::shared_ptr<const TextDictionary> dictionary) {
+  std::lock_guard<std::mutex> lock(registered_mutex);
+  registered = std::move(dictionary);
+}
+
+std::shared_ptr<const TextDictionary> TextDictionary::Registered() {
+  std::lock_guard<std::mutex> lock(registered_mutex);
+  return registered;
+}
+
+uint32_t TextDictionary::find(const std::string& text) const {
+  std::call_once(indexed_, [this]() {
+    for (uint32_t offset = 0; offset < text_.size();) {
+      std::string entry(text_.data() + offset);
+      const auto length = static_cast<uint32_t>(entry.size());
+      offsets_.emplace(std::move(entry), offset);
+      offset += length + 1;
+    }
+  });
+  auto found = offsets_.find(text);
+  return found == offsets_.cend() ? kNotFound : found->second;
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "baldr/graphreader.h"
+#include "baldr/tile_shard.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+
+namespace valhalla {
+namespace baldr {
+
+tile_shard_t::tile_shard_t(std::unordered_set<uint32_t> tileids) : tileids_(std::move(tileids)) {
+}
+
+tile_shard_t tile_shard_t::from_file(const std::string& file) {
+  std::ifstream list(file);
+  if (!list) {
+    throw std::runtime_error("Could not open the shard tile list " + file);
+  }
+
+  const auto local_level = TileHierarchy::levels().back().level;
+  std::unordered_set<uint32_t> tileids;
+  std::string line;
+  while (std::getline(list, line)) {
+    std::istringstream fields(line);
+    std::string tile;
+    if (!(fields >> tile) || tile.front() == '#') {
+      continue;
+    }
+    try {
+      GraphId id;
+      if (tile.find('.') != std::string::npos) {
+        id = GraphTile::GetTileId(tile);
+      } else if (tile.find('/') != std::string::npos) {
+        const auto slashes = std::count(tile.begin(), tile.end(), '/');
+        id = GraphId(slashes == 1 ? tile + "/0" : tile);
+      } else {
+        id = GraphId(std::stoul(tile), local_level, 0);
+      }
+      if (id.level() != local_level) {
+        LOG_WARN("Skipping " + tile + " in the shard tile list, it is not a local tile");
+        continue;
+      }
+      tileids.insert(id.tileid());
+    } catch (const std::exception&) { LOG_WARN("Skipping " + tile + " in the shard tile list"); }
+  }
+  return tile_shard_t(std::move(tileids));
+}
+
+std::shared_ptr<const tile_shard_t> tile_shard_t::get_instance(const std::string& file) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const tile_shard_t>> shards;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& shard = shards[file];
+  if (!shard) {
+    shard = std::make_shared<const tile_shard_t>(from_file(file));
+    LOG_INFO("Serving the " + std::to_string(shard->size()) + " local tiles of the shard " + file);
+  }
+  return shard;
+}
+
+bool tile_shard_t::Contains(const GraphId& tile) const {
+  // transit tiles are on the same grid as the local ones so they go with them
+  return tile.level() < TileHierarchy::levels().back().level ||
+         tileids_.find(tile.tileid()) != tileids_.cend();
+}
+
+std::vector<tile_shard_t::crossing_t> tile_shard_t::Crossings(GraphReader& reader) const {
+  const auto local_level = TileHierarchy::levels().back().level;
+  std::vector<crossing_t> crossings;
+  for (const auto tileid : tileids_) {
+    auto tile = reader.GetGraphTile(GraphId(tileid, local_level, 0));
+    if (!tile) {
+      continue;
+    }
+    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i) {
+      const auto* node = tile->node(i);
+      GraphId edge_id = tile->id();
+      edge_id.set_id(node->edge_index());
+      for (uint32_t j = 0; j < node->edge_count(); ++j, ++edge_id) {
+        const auto* edge = tile->directededge(edge_id);
+        // transitions and shortcuts stay on the levels every shard has
+        if (edge->is_shortcut() || edge->endnode().level() != local_level ||
+            Contains(edge->endnode())) {
+          continue;
+        }
+        crossings.push_back({edge_id, edge->endnode()});
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  return crossings;
+}
+
+std::pair<GraphId, float>
+tile_shard_t::Stitch(const std::unordered_map<GraphId, float>& to_boundary,
+                     const std::unordered_map<GraphId, float>& from_boundary) {
+  // go over the smaller side and look each node up on the other
+  const bool to_smaller = to_boundary.size() <= from_boundary.size();
+  const auto& smaller = to_smaller ? to_boundary : from_boundary;
+  const auto& larger = to_smaller ? from_boundary : to_boundary;
+  std::pair<GraphId, float> best{GraphId(), std::numeric_limits<float>::max()};
+  for (const auto& node : smaller) {
+    auto other = larger.find(node.first);
+    if (other != larger.cend() && node.second + other->second < best.second) {
+      best = {node.first, node.second + other->second};
+    }
+  }
+  return best;
+}
+
+} // namespace baldr
+} // namespace valhalla
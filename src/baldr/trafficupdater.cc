@@ -0,0 +1,113 @@
+#include "baldr/trafficupdater.h"
+#include "baldr/graphtile.h"
+#include "midgard/sequence.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace valhalla {
+namespace baldr {
+
+TrafficUpdater::TrafficUpdater(const std::string& traffic_extract)
+    : extract_(new midgard::tar(traffic_extract, false)) {
+  for (const auto& c : extract_->contents) {
+    try {
+      if (c.second.second >= sizeof(TrafficTileHeader)) {
+        tiles_.emplace(GraphTile::GetTileId(c.first),
+                       std::make_pair(const_cast<char*>(c.second.first), c.second.second));
+      }
+    } catch (...) {
+      // other files can be in the tar as well, like the index
+    }
+  }
+}
+
+TrafficUpdater::~TrafficUpdater() = default;
+
+size_t TrafficUpdater::update(std::vector<TrafficUpdate> updates,
+                              uint32_t threads,
+                              uint64_t timestamp) {
+  if (timestamp == 0) {
+    timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  }
+
+  // group the updates by tile keeping their order within it so the last one of an edge wins
+  std::stable_sort(updates.begin(), updates.end(), [](const auto& a, const auto& b) {
+    return a.edge_id.Tile_Base() < b.edge_id.Tile_Base();
+  });
+  std::vector<size_t> tile_starts;
+  for (size_t i = 0; i < updates.size(); ++i) {
+    if (i == 0 || updates[i].edge_id.Tile_Base() != updates[i - 1].edge_id.Tile_Base()) {
+      tile_starts.push_back(i);
+    }
+  }
+  tile_starts.push_back(updates.size());
+
+  // each thread takes the next tile until there are none left
+  std::atomic<size_t> next_tile(0);
+  std::atomic<size_t> written(0);
+  auto write_tiles = [&]() {
+    for (size_t k = next_tile++; k + 1 < tile_starts.size(); k = next_tile++) {
+      auto tile = tiles_.find(updates[tile_starts[k]].edge_id.Tile_Base());
+      if (tile == tiles_.end()) {
+        continue;
+      }
+      auto* header = reinterpret_cast<volatile TrafficTileHeader*>(tile->second.first);
+      auto* speeds =
+          reinterpret_cast<volatile uint64_t*>(tile->second.first + sizeof(TrafficTileHeader));
+      const uint64_t edge_count =
+          std::min<uint64_t>(header->directed_edge_count,
+                             (tile->second.second - sizeof(TrafficTileHeader)) / sizeof(uint64_t));
+      if (header->traffic_tile_version != TRAFFIC_TILE_VERSION) {
+        continue;
+      }
+
+      // a single store per edge, readers see either the old or the new speed
+      size_t count = 0;
+      for (size_t i = tile_starts[k]; i < tile_starts[k + 1]; ++i) {
+        if (updates[i].edge_id.id() >= edge_count) {
+          continue;
+        }
+        uint64_t speed;
+        std::memcpy(&speed, &updates[i].speed, sizeof(speed));
+        speeds[updates[i].edge_id.id()] = speed;
+        ++count;
+      }
+      if (count == 0) {
+        continue;
+      }
+
+      // the speeds have to be in place before readers are told the tile changed
+      std::atomic_thread_fence(std::memory_order_release);
+      header->last_update = timestamp;
+      header->generation = header->generation + 1;
+      written += count;
+    }
+  };
+
+  threads = std::max<uint32_t>(1, std::min<size_t>(threads, tile_starts.size() - 1));
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < threads; ++i) {
+    workers.emplace_back(write_tiles);
+  }
+  write_tiles();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return written;
+}
+
+TrafficSpeed TrafficUpdater::speed(uint32_t kph, uint32_t congestion) {
+  const uint32_t encoded = std::min(kph, MAX_TRAFFIC_SPEED_KPH) >> 1;
+  congestion = std::min<uint32_t>(congestion, MAX_CONGESTION_VAL);
+  // a single subsegment covering the whole edge
+  return TrafficSpeed{encoded, encoded, encoded, encoded, 255, 0, congestion, 0, 0, false};
+}
+
+} // namespace baldr
+} // namespace valhalla
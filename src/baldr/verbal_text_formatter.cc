@@ -4,6 +4,21 @@
 #include "baldr/verbal_text_formatter.h"
 #include "midgard/util.h"
 
+namespace {
+
+using valhalla::baldr::VerbalTextPattern;
+
+// Pattern to find numbers, (\D*)(\d+)(\D*)
+const VerbalTextPattern
+    kNumberSplitPattern({VerbalTextPattern::Set(1, VerbalTextPattern::NonDigits(), 0,
+                                                VerbalTextPattern::kUnbounded),
+                         VerbalTextPattern::Set(2, VerbalTextPattern::Digits(), 1,
+                                                VerbalTextPattern::kUnbounded),
+                         VerbalTextPattern::Set(3, VerbalTextPattern::NonDigits(), 0,
+                                                VerbalTextPattern::kUnbounded)});
+
+} // namespace
+
 namespace valhalla {
 namespace baldr {
 
@@ -56,7 +71,7 @@ std::string VerbalTextFormatter::Format(const std::string& text) const {
   return verbal_text;
 }
 
-std::string VerbalTextFormatter::ProcessNumberSplitMatch(const std::smatch& m) const {
+std::string VerbalTextFormatter::ProcessNumberSplitMatch(const VerbalTextPattern::Match& m) const {
   std::string tts;
   if (m[1].matched) {
     tts += m[1].str();
@@ -80,9 +95,10 @@ std::string VerbalTextFormatter::ProcessNumberSplitMatch(const std::smatch& m) c
 std::string VerbalTextFormatter::FormNumberSplitTts(const std::string& source) const {
 
   std::string tts;
-  for (std::sregex_iterator it(source.begin(), source.end(), kNumberSplitRegex), end_it; it != end_it;
-       ++it) {
-    tts += ProcessNumberSplitMatch(*it);
+  VerbalTextPattern::Match match;
+  for (size_t position = 0; kNumberSplitPattern.Search(source, position, match);
+       position = match[0].end) {
+    tts += ProcessNumberSplitMatch(match);
   }
   return tts.empty() ? source : tts;
 }
@@ -1,10 +1,187 @@
-#include <iostream>
+#include <array>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "baldr/verbal_text_formatter.h"
 #include "baldr/verbal_text_formatter_us.h"
 #include "midgard/util.h"
 
+namespace {
+
+using Pattern = valhalla::baldr::VerbalTextPattern;
+
+const Pattern::CharSet kDigits = Pattern::Digits();
+const Pattern::CharSet kNonDigits = Pattern::NonDigits();
+const Pattern::CharSet kLetters = Pattern::Letters();
+const Pattern::CharSet kOneToNine = Pattern::Range('1', '9');
+const Pattern::CharSet kSeparators = Pattern::Chars(" -");
+
+// (\D*)(\d+)(st|nd|rd|th)?(\D*) ignoring case
+const Pattern kUsNumberSplitPattern({Pattern::Set(1, kNonDigits, 0, Pattern::kUnbounded),
+                                     Pattern::Set(2, kDigits, 1, Pattern::kUnbounded),
+                                     Pattern::AnyText(3, {"st", "nd", "rd", "th"}).Optional(),
+                                     Pattern::Set(4, kNonDigits, 0, Pattern::kUnbounded)},
+                                    true);
+
+// (\bI)([ -])(H)?(\d{1,3}) ignoring case
+const Pattern kInterstatePattern({Pattern::WordBoundary(1), Pattern::Text(1, "I"),
+                                  Pattern::Set(2, kSeparators), Pattern::Text(3, "H").Optional(),
+                                  Pattern::Set(4, kDigits, 1, 3)},
+                                 true);
+const std::string kInterstateOutPattern = "Interstate $3$4";
+
+// (\bUS)([ -])(Highway )?(\d{1,3}) ignoring case
+const Pattern kUsHighwayPattern({Pattern::WordBoundary(1), Pattern::Text(1, "US"),
+                                 Pattern::Set(2, kSeparators),
+                                 Pattern::Text(3, "Highway ").Optional(),
+                                 Pattern::Set(4, kDigits, 1, 3)},
+                                true);
+const std::string kUsHighwayOutPattern = "U.S. $3$4";
+
+// ( )(0)([1-9])
+const Pattern kLeadingOhPattern({Pattern::Set(1, Pattern::Chars(" ")), Pattern::Text(2, "0"),
+                                 Pattern::Set(3, kOneToNine)});
+const std::string kLeadingOhOutPattern = "$1o$3";
+
+// (^|\D)([1-9]{1,2})(<zeros>$), (^|\D)([1-9]{1,2})(<zeros>th) ignoring case,
+// (^|\D)([1-9]{1,2})(<zeros>)( |-) and (^|\D)([1-9]{1,2})(<zeros>)(\D)
+std::array<std::pair<Pattern, std::string>, 4> RoundNumbers(const std::string& zeros,
+                                                            const std::string& word) {
+  return {{{Pattern({Pattern::BeginOrSet(1, kNonDigits), Pattern::Set(2, kOneToNine, 1, 2),
+                     Pattern::Text(3, zeros), Pattern::End(3)}),
+            "$1$2 " + word},
+           {Pattern({Pattern::BeginOrSet(1, kNonDigits), Pattern::Set(2, kOneToNine, 1, 2),
+                     Pattern::Text(3, zeros + "th")},
+                    true),
+            "$1$2 " + word + "th"},
+           {Pattern({Pattern::BeginOrSet(1, kNonDigits), Pattern::Set(2, kOneToNine, 1, 2),
+                     Pattern::Text(3, zeros), Pattern::Set(4, kSeparators)}),
+            "$1$2 " + word + " "},
+           {Pattern({Pattern::BeginOrSet(1, kNonDigits), Pattern::Set(2, kOneToNine, 1, 2),
+                     Pattern::Text(3, zeros), Pattern::Set(4, kNonDigits)}),
+            "$1$2 " + word + " $4"}}};
+}
+
+const std::array<std::pair<Pattern, std::string>, 4> kThousandFindReplace =
+    RoundNumbers("000", "thousand");
+
+const std::array<std::pair<Pattern, std::string>, 4> kHundredFindReplace =
+    RoundNumbers("00", "hundred");
+
+// (\b<abbreviation>)([ -])(\d{1,<digits>}) ignoring case
+Pattern StateRoute(const std::string& abbreviation, const size_t digits) {
+  return Pattern({Pattern::WordBoundary(1), Pattern::Text(1, abbreviation),
+                  Pattern::Set(2, kSeparators), Pattern::Set(3, kDigits, 1, digits)},
+                 true);
+}
+
+// In order, the first which changes the text is used. SR and SH need no separator, FL can have
+// an A before the number and MO can be followed by one or two letters.
+const std::array<std::pair<Pattern, std::string>, 53> kStateRoutes = {
+    {{Pattern({Pattern::WordBoundary(1), Pattern::Text(1, "SR"),
+               Pattern::Set(2, kSeparators).Optional(), Pattern::Set(3, kDigits, 1, 4)},
+              true),
+      "State Route $3"},
+     {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, "SH"),
+               Pattern::Set(2, kSeparators).Optional(), Pattern::Set(3, kDigits, 1, 4)},
+              true),
+      "State Highway $3"},
+     {StateRoute("CA", 3), "California $3"},
+     {StateRoute("TX", 3), "Texas $3"},
+     {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, "FL"), Pattern::Set(2, kSeparators),
+               Pattern::Text(3, "A").Optional(), Pattern::Set(4, kDigits, 1, 3)},
+              true),
+      "Florida $3$4"},
+     {StateRoute("NY", 3), "New York $3"},
+     {StateRoute("IL", 3), "Illinois $3"},
+     {StateRoute("PA", 3), "Pennsylvania $3"},
+     {StateRoute("OH", 3), "Ohio $3"},
+     {StateRoute("GA", 3), "Georgia $3"},
+     {StateRoute("NC", 3), "North Carolina $3"},
+     {StateRoute("M", 3), "Michigan $3"},
+     {StateRoute("NJ", 3), "New Jersey $3"},
+     {StateRoute("VA", 3), "Virginia $3"},
+     {StateRoute("WA", 3), "Washington $3"},
+     {StateRoute("MA", 3), "Massachusetts $3"},
+     {StateRoute("AZ", 3), "Arizona $3"},
+     {StateRoute("IN", 3), "Indiana $3"},
+     {StateRoute("TN", 3), "Tennessee $3"},
+     {StateRoute("MO", 3), "Missouri $3"},
+     {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, "MO"), Pattern::Set(2, kSeparators),
+               Pattern::Set(3, kLetters, 1, 2), Pattern::WordBoundary(3)},
+              true),
+      "Missouri $3"},
+     {StateRoute("MD", 3), "Maryland $3"},
+     {StateRoute("WI", 3), "Wisconsin $3"},
+     {StateRoute("MN", 3), "Minnesota $3"},
+     {StateRoute("AL", 3), "Alabama $3"},
+     {StateRoute("SC", 3), "South Carolina $3"},
+     {StateRoute("LA", 4), "Louisiana $3"},
+     {StateRoute("KY", 4), "Kentucky $3"},
+     {StateRoute("OR", 3), "Oregon $3"},
+     {StateRoute("OK", 3), "Oklahoma $3"},
+     {StateRoute("CT", 3), "Connecticut $3"},
+     {StateRoute("IA", 3), "Iowa $3"},
+     {StateRoute("MS", 3), "Mississippi $3"},
+     {StateRoute("AR", 3), "Arkansas $3"},
+     {StateRoute("UT", 3), "Utah $3"},
+     {StateRoute("KS", 3), "Kansas $3"},
+     {StateRoute("NV", 3), "Nevada $3"},
+     {StateRoute("NM", 4), "New Mexico $3"},
+     {StateRoute("NE", 3), "Nebraska $3"},
+     {StateRoute("WV", 3), "West Virginia $3"},
+     {StateRoute("ID", 3), "Idaho $3"},
+     {StateRoute("HI", 4), "Hawaii $3"},
+     {StateRoute("ME", 3), "Maine $3"},
+     {StateRoute("NH", 3), "New Hampshire $3"},
+     {StateRoute("RI", 3), "Rhode Island $3"},
+     {StateRoute("MT", 3), "Montana $3"},
+     {StateRoute("DE", 3), "Delaware $3"},
+     {StateRoute("SD", 4), "South Dakota $3"},
+     {StateRoute("ND", 4), "North Dakota $3"},
+     {StateRoute("AK", 3), "Alaska $3"},
+     {StateRoute("DC", 3), "D C $3"},
+     {StateRoute("VT", 3), "Vermont $3"},
+     {StateRoute("WY", 3), "Wyoming $3"}}};
+
+// (\b<county>)(\d{1,4})([[:alpha:]]{1,2})?\b,
+// (\b<county>)([ -])([[:alpha:]]{1,2})?(\d{1,4})([[:alpha:]]{1,2})?\b and
+// (\b<county>)([ -])([[:alpha:]]{1,2})\b ignoring case
+std::array<std::pair<Pattern, std::string>, 3> CountyRoutes(const std::string& county) {
+  return {{{Pattern({Pattern::WordBoundary(1), Pattern::Text(1, county),
+                     Pattern::Set(2, kDigits, 1, 4), Pattern::Set(3, kLetters, 1, 2).Optional(),
+                     Pattern::WordBoundary(0)},
+                    true),
+            "County Route $2$3"},
+           {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, county),
+                     Pattern::Set(2, kSeparators), Pattern::Set(3, kLetters, 1, 2).Optional(),
+                     Pattern::Set(4, kDigits, 1, 4), Pattern::Set(5, kLetters, 1, 2).Optional(),
+                     Pattern::WordBoundary(0)},
+                    true),
+            "County Route $3$4$5"},
+           {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, county),
+                     Pattern::Set(2, kSeparators), Pattern::Set(3, kLetters, 1, 2),
+                     Pattern::WordBoundary(0)},
+                    true),
+            "County Route $3"}}};
+}
+
+const std::array<std::pair<Pattern, std::string>, 3> kCrRoutes = CountyRoutes("CR");
+const std::array<std::pair<Pattern, std::string>, 3> kCSpaceRRoutes = CountyRoutes("C R");
+
+// The CR and C R routes followed by (\bCO)([ -])?(\d{1,4})([[:alpha:]]{1,2})?\b ignoring case
+const std::array<std::pair<Pattern, std::string>, 7> kCountyRoutes = {
+    {kCrRoutes[0], kCrRoutes[1], kCrRoutes[2], kCSpaceRRoutes[0], kCSpaceRRoutes[1],
+     kCSpaceRRoutes[2],
+     {Pattern({Pattern::WordBoundary(1), Pattern::Text(1, "CO"),
+               Pattern::Set(2, kSeparators).Optional(), Pattern::Set(3, kDigits, 1, 4),
+               Pattern::Set(4, kLetters, 1, 2).Optional(), Pattern::WordBoundary(0)},
+              true),
+      "County Road $3$4"}}};
+
+} // namespace
+
 namespace valhalla {
 namespace baldr {
 
@@ -34,7 +211,8 @@ std::string VerbalTextFormatterUs::Format(const std::string& text) const {
   return verbal_text;
 }
 
-std::string VerbalTextFormatterUs::ProcessNumberSplitMatch(const std::smatch& m) const {
+std::string
+VerbalTextFormatterUs::ProcessNumberSplitMatch(const VerbalTextPattern::Match& m) const {
   std::string tts;
   if (m[1].matched) {
     tts += m[1].str();
@@ -65,19 +243,20 @@ std::string VerbalTextFormatterUs::ProcessNumberSplitMatch(const std::smatch& m)
 std::string VerbalTextFormatterUs::FormNumberSplitTts(const std::string& source) const {
 
   std::string tts;
-  for (std::sregex_iterator it(source.begin(), source.end(), kUsNumberSplitRegex), end_it;
-       it != end_it; ++it) {
-    tts += ProcessNumberSplitMatch(*it);
+  VerbalTextPattern::Match match;
+  for (size_t position = 0; kUsNumberSplitPattern.Search(source, position, match);
+       position = match[0].end) {
+    tts += ProcessNumberSplitMatch(match);
   }
   return tts.empty() ? source : tts;
 }
 
 std::string VerbalTextFormatterUs::FormInterstateTts(const std::string& source) const {
-  return std::regex_replace(source, kInterstateRegex, kInterstateOutPattern);
+  return kInterstatePattern.Replace(source, kInterstateOutPattern);
 }
 
 std::string VerbalTextFormatterUs::FormUsHighwayTts(const std::string& source) const {
-  return std::regex_replace(source, kUsHighwayRegex, kUsHighwayOutPattern);
+  return kUsHighwayPattern.Replace(source, kUsHighwayOutPattern);
 }
 
 std::string VerbalTextFormatterUs::ProcessStatesTts(const std::string& source) const {
@@ -94,11 +273,11 @@ std::string VerbalTextFormatterUs::ProcessStatesTts(const std::string& source) c
 }
 
 bool VerbalTextFormatterUs::FormStateTts(const std::string& source,
-                                         const std::regex& state_regex,
+                                         const VerbalTextPattern& state_pattern,
                                          const std::string& state_output_pattern,
                                          std::string& tts) const {
 
-  tts = std::regex_replace(source, state_regex, state_output_pattern);
+  tts = state_pattern.Replace(source, state_output_pattern);
 
   // Return true if transformed
   return (tts != source);
@@ -118,11 +297,11 @@ std::string VerbalTextFormatterUs::ProcessCountysTts(const std::string& source)
 }
 
 bool VerbalTextFormatterUs::FormCountyTts(const std::string& source,
-                                          const std::regex& county_regex,
+                                          const VerbalTextPattern& county_pattern,
                                           const std::string& county_output_pattern,
                                           std::string& tts) const {
 
-  tts = std::regex_replace(source, county_regex, county_output_pattern);
+  tts = county_pattern.Replace(source, county_output_pattern);
 
   // Return true if transformed
   return (tts != source);
@@ -138,9 +317,9 @@ std::string VerbalTextFormatterUs::ProcessThousandTts(const std::string& source)
 }
 
 std::string VerbalTextFormatterUs::FormThousandTts(const std::string& source,
-                                                   const std::regex& thousand_regex,
+                                                   const VerbalTextPattern& thousand_pattern,
                                                    const std::string& thousand_output_pattern) const {
-  return std::regex_replace(source, thousand_regex, thousand_output_pattern);
+  return thousand_pattern.Replace(source, thousand_output_pattern);
 }
 
 std::string VerbalTextFormatterUs::ProcessHundredTts(const std::string& source) const {
@@ -153,13 +332,13 @@ std::string VerbalTextFormatterUs::ProcessHundredTts(const std::string& source)
 }
 
 std::string VerbalTextFormatterUs::FormHundredTts(const std::string& source,
-                                                  const std::regex& hundred_regex,
+                                                  const VerbalTextPattern& hundred_pattern,
                                                   const std::string& hundred_output_pattern) const {
-  return std::regex_replace(source, hundred_regex, hundred_output_pattern);
+  return hundred_pattern.Replace(source, hundred_output_pattern);
 }
 
 std::string VerbalTextFormatterUs::FormLeadingOhTts(const std::string& source) const {
-  return std::regex_replace(source, kLeadingOhRegex, kLeadingOhOutPattern);
+  return kLeadingOhPattern.Replace(source, kLeadingOhOutPattern);
 }
 
 } // namespace baldr
@@ -6,6 +6,20 @@
 #include "baldr/verbal_text_formatter_us_co.h"
 #include "midgard/util.h"
 
+namespace {
+
+using valhalla::baldr::VerbalTextPattern;
+
+// (\bCO)([ -])(\d{1,3}) ignoring case
+const VerbalTextPattern
+    kColoradoPattern({VerbalTextPattern::WordBoundary(1), VerbalTextPattern::Text(1, "CO"),
+                      VerbalTextPattern::Set(2, VerbalTextPattern::Chars(" -")),
+                      VerbalTextPattern::Set(3, VerbalTextPattern::Digits(), 1, 3)},
+                     true);
+const std::string kColoradoOutPattern = "Colorado $3";
+
+} // namespace
+
 namespace valhalla {
 namespace baldr {
 
@@ -20,7 +34,7 @@ VerbalTextFormatterUsCo::~VerbalTextFormatterUsCo() {
 std::string VerbalTextFormatterUsCo::ProcessStatesTts(const std::string& source) const {
 
   std::string tts;
-  if (FormStateTts(source, kColoradoRegex, kColoradoOutPattern, tts)) {
+  if (FormStateTts(source, kColoradoPattern, kColoradoOutPattern, tts)) {
     // Colorado has been found and transformed - so return
     return tts;
   }
@@ -6,6 +6,31 @@
 #include "baldr/verbal_text_formatter_us_tx.h"
 #include "midgard/util.h"
 
+namespace {
+
+using valhalla::baldr::VerbalTextPattern;
+
+// (\b<first>[ -]?M)([ -])?(\d{1,4}) ignoring case
+VerbalTextPattern ToMarketRoad(const std::string& first) {
+  const auto separators = VerbalTextPattern::Chars(" -");
+  return VerbalTextPattern({VerbalTextPattern::WordBoundary(1), VerbalTextPattern::Text(1, first),
+                            VerbalTextPattern::Set(1, separators, 0, 1),
+                            VerbalTextPattern::Text(1, "M"),
+                            VerbalTextPattern::Set(2, separators).Optional(),
+                            VerbalTextPattern::Set(3, VerbalTextPattern::Digits(), 1, 4)},
+                           true);
+}
+
+// Farm to Market
+const VerbalTextPattern kFmPattern = ToMarketRoad("F");
+const std::string kFmOutPattern = "Farm to Market Road $3";
+
+// Ranch to Market
+const VerbalTextPattern kRmPattern = ToMarketRoad("R");
+const std::string kRmOutPattern = "Ranch to Market Road $3";
+
+} // namespace
+
 namespace valhalla {
 namespace baldr {
 
@@ -26,10 +51,10 @@ std::string VerbalTextFormatterUsTx::Format(const std::string& text) const {
 }
 
 std::string VerbalTextFormatterUsTx::FormFmTts(const std::string& source) const {
-  return std::regex_replace(source, kFmRegex, kFmOutPattern);
+  return kFmPattern.Replace(source, kFmOutPattern);
 }
 std::string VerbalTextFormatterUsTx::FormRmTts(const std::string& source) const {
-  return std::regex_replace(source, kRmRegex, kRmOutPattern);
+  return kRmPattern.Replace(source, kRmOutPattern);
 }
 
 } // namespace baldr
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "baldr/verbal_text_pattern.h"
+
+namespace {
+
+constexpr size_t kNotTaken = std::string::npos;
+
+inline bool is_digit(const char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline bool is_letter(const char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool is_word(const char c) {
+  return is_digit(c) || is_letter(c) || c == '_';
+}
+
+inline char lower(const char c) {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+VerbalTextPattern::CharSet VerbalTextPattern::Chars(const std::string& chars) {
+  CharSet set;
+  for (const auto c : chars) {
+    set.set(static_cast<uint8_t>(c));
+  }
+  return set;
+}
+
+VerbalTextPattern::CharSet VerbalTextPattern::Range(const char first, const char last) {
+  CharSet set;
+  for (auto c = static_cast<uint8_t>(first); c <= static_cast<uint8_t>(last); ++c) {
+    set.set(c);
+  }
+  return set;
+}
+
+VerbalTextPattern::CharSet VerbalTextPattern::Digits() {
+  return Range('0', '9');
+}
+
+VerbalTextPattern::CharSet VerbalTextPattern::NonDigits() {
+  return ~Digits();
+}
+
+VerbalTextPattern::CharSet VerbalTextPattern::Letters() {
+  return Range('a', 'z') | Range('A', 'Z');
+}
+
+VerbalTextPattern::Element VerbalTextPattern::Set(const uint8_t group,
+                                                  const CharSet& chars,
+                                                  const size_t min,
+                                                  const size_t max) {
+  return {Element::Type::kChars, group, min, max, false, chars, {}};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::Text(const uint8_t group, const std::string& text) {
+  return {Element::Type::kText, group, 1, 1, false, {}, {text}};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::AnyText(const uint8_t group,
+                                                      const std::vector<std::string>& texts) {
+  return {Element::Type::kText, group, 1, 1, false, {}, texts};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::WordBoundary(const uint8_t group) {
+  return {Element::Type::kWordBoundary, group, 0, 0, false, {}, {}};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::Begin(const uint8_t group) {
+  return {Element::Type::kBegin, group, 0, 0, false, {}, {}};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::End(const uint8_t group) {
+  return {Element::Type::kEnd, group, 0, 0, false, {}, {}};
+}
+
+VerbalTextPattern::Element VerbalTextPattern::BeginOrSet(const uint8_t group,
+                                                         const CharSet& chars) {
+  return {Element::Type::kBeginOrChars, group, 1, 1, false, chars, {}};
+}
+
+VerbalTextPattern::VerbalTextPattern(std::initializer_list<Element> elements,
+                                     const bool ignore_case)
+    : elements_(elements), ignore_case_(ignore_case), groups_(0) {
+  if (elements_.size() > kMaxElements) {
+    throw std::invalid_argument("Verbal text patterns have at most " +
+                                std::to_string(kMaxElements) + " elements");
+  }
+  for (const auto& element : elements_) {
+    groups_ = std::max(groups_, element.group);
+  }
+  if (groups_ >= std::tuple_size<decltype(Match::groups_)>::value) {
+    throw std::invalid_argument("Too many groups in verbal text pattern");
+  }
+
+  // Compare texts in lower case when the case doesn't matter
+  if (ignore_case_) {
+    for (auto& element : elements_) {
+      for (auto& text : element.texts) {
+        for (auto& c : text) {
+          c = lower(c);
+        }
+      }
+    }
+  }
+}
+
+bool VerbalTextPattern::Search(const std::string& text, const size_t position, Match& match) const {
+  Spans spans;
+  for (size_t start = position; start <= text.size(); ++start) {
+    if (!MatchAt(text, 0, start, spans)) {
+      continue;
+    }
+
+    // The groups run from the first element in them to the last, those left out are not matched
+    for (auto& group : match.groups_) {
+      group = {false, 0, 0, &text};
+    }
+    match.groups_[0] = {true, start, spans[elements_.size()].first, &text};
+    for (size_t i = 0; i < elements_.size(); ++i) {
+      auto& group = match.groups_[elements_[i].group];
+      if (elements_[i].group == 0 || spans[i].first == kNotTaken) {
+        continue;
+      }
+      if (!group.matched) {
+        group.matched = true;
+        group.begin = spans[i].first;
+      }
+      group.end = spans[i].second;
+    }
+    return true;
+  }
+  return false;
+}
+
+std::string VerbalTextPattern::Replace(const std::string& text, const std::string& format) const {
+  std::string replaced;
+  size_t position = 0;
+  Match match;
+  while (position <= text.size() && Search(text, position, match)) {
+    replaced.append(text, position, match[0].begin - position);
+
+    // $n and $nn are groups, $$ is a dollar sign and anything else is copied as is
+    for (size_t i = 0; i < format.size(); ++i) {
+      if (format[i] != '$' || i + 1 == format.size()) {
+        replaced.push_back(format[i]);
+      } else if (format[i + 1] == '$') {
+        replaced.push_back('$');
+        ++i;
+      } else if (is_digit(format[i + 1])) {
+        size_t group = format[++i] - '0';
+        if (i + 1 < format.size() && is_digit(format[i + 1])) {
+          group = group * 10 + (format[++i] - '0');
+        }
+        if (group <= groups_) {
+          replaced += match[group].str();
+        }
+      } else {
+        replaced.push_back(format[i]);
+      }
+    }
+
+    // A match that took nothing lets the character after it through
+    position = match[0].end;
+    if (match[0].begin == match[0].end) {
+      if (position < text.size()) {
+        replaced.push_back(text[position]);
+      }
+      ++position;
+    }
+  }
+  if (position < text.size()) {
+    replaced.append(text, position, std::string::npos);
+  }
+  return replaced;
+}
+
+bool VerbalTextPattern::MatchAt(const std::string& text,
+                                const size_t index,
+                                const size_t position,
+                                Spans& spans) const {
+  if (index == elements_.size()) {
+    spans[index] = {position, position};
+    return true;
+  }
+
+  const auto& element = elements_[index];
+  const auto rest = [&](const size_t end) {
+    spans[index] = {position, end};
+    return MatchAt(text, index + 1, end, spans);
+  };
+  switch (element.type) {
+    case Element::Type::kChars: {
+      // Take as many as we can and give them back one at a time
+      size_t count = 0;
+      while (count < element.max && position + count < text.size() &&
+             element.chars[static_cast<uint8_t>(text[position + count])]) {
+        ++count;
+      }
+      for (size_t taken = count + 1; taken-- > element.min;) {
+        if (rest(position + taken)) {
+          return true;
+        }
+      }
+      break;
+    }
+    case Element::Type::kText:
+      for (const auto& candidate : element.texts) {
+        if (position + candidate.size() > text.size()) {
+          continue;
+        }
+        size_t i = 0;
+        while (i < candidate.size() && (ignore_case_ ? lower(text[position + i])
+                                                     : text[position + i]) == candidate[i]) {
+          ++i;
+        }
+        if (i == candidate.size() && rest(position + i)) {
+          return true;
+        }
+      }
+      break;
+    case Element::Type::kWordBoundary: {
+      const bool before = position > 0 && is_word(text[position - 1]);
+      const bool after = position < text.size() && is_word(text[position]);
+      if (before != after && rest(position)) {
+        return true;
+      }
+      break;
+    }
+    case Element::Type::kBegin:
+      if (position == 0 && rest(position)) {
+        return true;
+      }
+      break;
+    case Element::Type::kEnd:
+      if (position == text.size() && rest(position)) {
+        return true;
+      }
+      break;
+    case Element::Type::kBeginOrChars:
+      if (position == 0 && rest(position)) {
+        return true;
+      }
+      if (position < text.size() && element.chars[static_cast<uint8_t>(text[position])] &&
+          rest(position + 1)) {
+        return true;
+      }
+      break;
+  }
+
+  // An optional group can be left out
+  if (element.optional) {
+    spans[index] = {kNotTaken, kNotTaken};
+    return MatchAt(text, index + 1, position, spans);
+  }
+  return false;
+}
+
+} // namespace baldr
+} // namespace valhalla
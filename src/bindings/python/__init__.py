@@ -3,5 +3,5 @@ try:
 except ModuleNotFoundError:
     from python_valhalla import *
 
-from .actor import Actor
+from .actor import Actor, ActorPool
 from .config import get_config
@@ -1,10 +1,10 @@
 import json
-from typing import Union
+from typing import List, Union
 
 try:
-    from .python_valhalla import _Actor
+    from .python_valhalla import _Actor, _ActorPool
 except ModuleNotFoundError:
-    from python_valhalla import _Actor
+    from python_valhalla import _Actor, _ActorPool
 
 
 # TODO: wasteful for dict input/output; more reasonable would be to extend
@@ -24,7 +24,7 @@ def dict_or_str(func):
     return wrapped
 
 
-class Actor(_Actor):
+class _Actions:
     @dict_or_str
     def route(self, req: Union[str, dict]):
         return super().route(req)
@@ -37,17 +37,21 @@ class Actor(_Actor):
     def isochrone(self, req: Union[str, dict]):
         return super().isochrone(req)
 
+    @dict_or_str
+    def optimized_route(self, req: Union[str, dict]):
+        return super().optimized_route(req)
+
     @dict_or_str
     def matrix(self, req: Union[str, dict]):
         return super().matrix(req)
 
     @dict_or_str
     def trace_route(self, req: Union[str, dict]):
-        return super().traceRoute(req)
+        return super().trace_route(req)
 
     @dict_or_str
     def trace_attributes(self, req: Union[str, dict]):
-        return super().traceAttributes(req)
+        return super().trace_attributes(req)
 
     @dict_or_str
     def height(self, req: Union[str, dict]):
@@ -68,3 +72,38 @@ class Actor(_Actor):
     @dict_or_str
     def status(self, req: Union[str, dict] = ""):
         return super().status(req)
+
+
+class Actor(_Actions, _Actor):
+    """
+    Answers requests one at a time, threads sharing it take turns. Valhalla releases the GIL while
+    it works on a request.
+    """
+    pass
+
+
+class ActorPool(_Actions, _ActorPool):
+    """
+    Answers requests of many threads at the same time with ``size`` actors, by default one per
+    cpu core. The actors share one tile cache and tile extract.
+
+    Besides the single requests it works on whole batches in parallel without holding the GIL:
+    ``batch`` takes a list of requests of one action, ``matrix_arrays`` a matrix between (n, 2)
+    arrays of lon, lat and ``trace_arrays`` a list of such arrays to map match.
+    """
+
+    def batch(self, action: str, requests: List[Union[str, bytes, dict]]) -> list:
+        """
+        Works on the requests in parallel, each response is at the index of its request. Requests
+        are json str, dict or serialized valhalla.Api bytes. Responses of requests asking for the
+        pbf format are bytes, the others are str or dict like their request. Failed requests get
+        their error as the response.
+        """
+        is_dict = [isinstance(req, dict) for req in requests]
+        responses = super().batch(
+            action, [json.dumps(req) if d else req for req, d in zip(requests, is_dict)]
+        )
+        return [
+            json.loads(resp) if d and isinstance(resp, str) else resp
+            for resp, d in zip(responses, is_dict)
+        ]
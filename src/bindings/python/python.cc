@@ -1,18 +1,33 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include "baldr/rapidjson_utils.h"
 #include <boost/make_shared.hpp>
 #include <boost/noncopyable.hpp>
+#include <atomic>
 #include <boost/property_tree/ptree.hpp>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "baldr/rapidjson_utils.h"
 #include "midgard/logging.h"
+#include "midgard/executor.h"
 #include "midgard/util.h"
+#include "proto_conversions.h"
 #include "tyr/actor.h"
+#include "worker.h"
 
+namespace py = pybind11;
 namespace vt = valhalla::tyr;
+using valhalla::Api;
+using valhalla::Options;
+
 namespace {
 
 // configuring multiple times is wasteful/ineffectual but not harmful
@@ -34,50 +49,342 @@ const boost::property_tree::ptree configure(const std::string& config) {
 
   return pt;
 }
-} // namespace
 
-namespace py = pybind11;
+using action_t = std::string (vt::actor_t::*)(const std::string&,
+                                              const std::function<void()>*,
+                                              Api*);
+
+struct action_info_t {
+  const char* name;
+  action_t action;
+  const char* doc;
+};
+
+const std::vector<action_info_t>& actions() {
+  static const std::vector<action_info_t> actions{
+      {"route", &vt::actor_t::route, "Calculates a route."},
+      {"locate", &vt::actor_t::locate, "Provides information about nodes and edges."},
+      {"optimized_route", &vt::actor_t::optimized_route,
+       "Optimizes the order of a set of waypoints by time."},
+      {"matrix", &vt::actor_t::matrix,
+       "Computes the time and distance between a set of locations and returns them as a matrix table."},
+      {"isochrone", &vt::actor_t::isochrone, "Calculates isochrones and isodistances."},
+      {"trace_route", &vt::actor_t::trace_route,
+       "Map-matching for a set of input locations, e.g. from a GPS."},
+      {"trace_attributes", &vt::actor_t::trace_attributes,
+       "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace."},
+      {"height", &vt::actor_t::height, "Provides elevation data for a set of input geometries."},
+      {"transit_available", &vt::actor_t::transit_available,
+       "Lookup if transit stops are available in a defined radius around a set of input locations."},
+      {"expansion", &vt::actor_t::expansion,
+       "Returns all road segments which were touched by the routing algorithm during the graph traversal."},
+      {"centroid", &vt::actor_t::centroid,
+       "Returns routes from all the input locations to the minimum cost meeting point of those paths."},
+      {"status", &vt::actor_t::status,
+       "Returns nothing or optionally details about Valhalla's configuration."},
+  };
+  return actions;
+}
+
+// the actions of the batches go by the names the http api uses, matrix is sources_to_targets there
+Options::Action parse_action(const std::string& name) {
+  Options::Action action;
+  if (name == "matrix") {
+    return Options::sources_to_targets;
+  }
+  if (!Options_Action_Enum_Parse(name, &action)) {
+    throw std::invalid_argument("Unknown action: " + name);
+  }
+  return action;
+}
+
+action_t find_action(const std::string& name) {
+  for (const auto& info : actions()) {
+    if (name == info.name) {
+      return info.action;
+    }
+  }
+  throw std::invalid_argument("Unknown action: " + name);
+}
+
+// the options shared by all the requests built from arrays, parsed once from json
+Api parse_options(const std::string& options, Options::Action action) {
+  Api api;
+  valhalla::ParseApi(options.empty() ? "{}" : options, action, api);
+  api.mutable_options()->set_format(Options::pbf);
+  return api;
+}
+
+// an n x 2 array of lon, lat pairs
+using coords_t = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+void add_locations(const coords_t& coords,
+                   google::protobuf::RepeatedPtrField<valhalla::Location>* locations) {
+  if (coords.ndim() != 2 || coords.shape(1) != 2) {
+    throw std::invalid_argument("Coordinates must be an array of shape (n, 2) with lon, lat rows");
+  }
+  auto lonlat = coords.unchecked<2>();
+  for (py::ssize_t i = 0; i < lonlat.shape(0); ++i) {
+    auto* ll = locations->Add()->mutable_ll();
+    ll->set_lng(lonlat(i, 0));
+    ll->set_lat(lonlat(i, 1));
+  }
+}
+
+// the response of a batch request, errors are responses too so one bad request keeps the rest
+std::string act_or_error(vt::actor_t& actor,
+                         action_t action,
+                         const std::string& request,
+                         Api& api,
+                         bool& pbf) {
+  try {
+    auto response = action ? (actor.*action)(request, nullptr, &api) : actor.act(api);
+    // pbf responses drop the options unless they were selected
+    pbf = !api.has_options() || api.options().format() == Options::pbf;
+    return response;
+  } catch (const valhalla::valhalla_exception_t& e) {
+    actor.cleanup();
+    pbf = api.options().format() == Options::pbf;
+    return valhalla::serialize_error(e, api);
+  } catch (const std::exception& e) {
+    actor.cleanup();
+    pbf = api.options().format() == Options::pbf;
+    return valhalla::serialize_error({499, std::string(e.what())}, api);
+  }
+}
+
+// a single actor which python threads can share, they take turns using it
+class locked_actor_t {
+public:
+  explicit locked_actor_t(const boost::property_tree::ptree& config) : actor_(config, true) {
+  }
+
+  std::string act(action_t action, const std::string& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (actor_.*action)(request, nullptr, nullptr);
+  }
+
+private:
+  vt::actor_t actor_;
+  std::mutex mutex_;
+};
+
+// a fixed number of actors on one tile cache and tile extract, each request borrows an idle one so
+// that as many python threads as there are actors can have requests worked on at the same time
+class actor_pool_t {
+public:
+  actor_pool_t(boost::property_tree::ptree config, size_t size) {
+    config.put("mjolnir.global_synchronized_cache", true);
+    size = size ? size : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < size; ++i) {
+      actors_.emplace_back(new vt::actor_t(config, true));
+      idle_.push_back(actors_.back().get());
+    }
+  }
+
+  std::string act(action_t action, const std::string& request) {
+    auto* actor = borrow();
+    // the actor goes back to the pool whether the request worked or not
+    try {
+      auto response = (actor->*action)(request, nullptr, nullptr);
+      release(actor);
+      return response;
+    } catch (...) {
+      release(actor);
+      throw;
+    }
+  }
+
+  size_t size() const {
+    return actors_.size();
+  }
+
+  // runs the work for each index on as many actors as there are and as it takes
+  void for_each(size_t count, const std::function<void(vt::actor_t&, size_t)>& work) {
+    std::atomic<size_t> next(0);
+    auto slots = static_cast<uint32_t>(std::min(actors_.size(), count));
+    valhalla::midgard::executor_t::shared().run(slots, [&](uint32_t) {
+      auto* actor = borrow();
+      try {
+        for (size_t i = next++; i < count; i = next++) {
+          work(*actor, i);
+        }
+      } catch (...) {
+        // the other slots run out of work, the executor rethrows this
+        next = count;
+        actor->cleanup();
+        release(actor);
+        throw;
+      }
+      release(actor);
+    });
+  }
+
+  // json or pbf requests of one action, pbf responses come back as bytes and the rest as str
+  py::list batch(const std::string& name, const py::list& requests) {
+    const auto action = parse_action(name);
+    const auto json_action = find_action(name);
+    std::vector<std::string> bodies;
+    std::vector<bool> pbf_in;
+    for (const auto& request : requests) {
+      pbf_in.push_back(py::isinstance<py::bytes>(request));
+      bodies.push_back(request.cast<std::string>());
+    }
+
+    std::vector<std::string> responses(bodies.size());
+    std::vector<char> pbf_out(bodies.size(), false);
+    {
+      py::gil_scoped_release no_gil;
+      for_each(bodies.size(), [&](vt::actor_t& actor, size_t i) {
+        Api api;
+        if (pbf_in[i]) {
+          if (!api.ParseFromString(bodies[i])) {
+            api.Clear();
+            responses[i] =
+                valhalla::serialize_error({499, "Request is not a serialized valhalla.Api"}, api);
+            return;
+          }
+          api.mutable_options()->set_action(action);
+        }
+        bool pbf = false;
+        responses[i] = act_or_error(actor, pbf_in[i] ? nullptr : json_action, bodies[i], api, pbf);
+        pbf_out[i] = pbf;
+      });
+    }
+
+    py::list results;
+    for (size_t i = 0; i < responses.size(); ++i) {
+      if (pbf_out[i]) {
+        results.append(py::bytes(responses[i]));
+      } else {
+        results.append(py::str(responses[i]));
+      }
+    }
+    return results;
+  }
+
+  // one matrix from arrays of lon, lat, the times and distances come back as sources x targets
+  py::tuple
+  matrix_arrays(const coords_t& sources, const coords_t& targets, const std::string& options) {
+    auto api = parse_options(options, Options::sources_to_targets);
+    add_locations(sources, api.mutable_options()->mutable_sources());
+    add_locations(targets, api.mutable_options()->mutable_targets());
+    // the arrays are filled in process, there are no bytes to save by compacting them
+    api.mutable_options()->set_compact_matrix(false);
+    const auto rows = api.options().sources_size();
+    const auto columns = api.options().targets_size();
+    {
+      py::gil_scoped_release no_gil;
+      auto* actor = borrow();
+      try {
+        actor->matrix("", nullptr, &api);
+      } catch (...) {
+        actor->cleanup();
+        release(actor);
+        throw;
+      }
+      release(actor);
+    }
+
+    const auto& matrix = api.matrix();
+    if (matrix.times_size() != rows * columns || matrix.distances_size() != rows * columns) {
+      throw std::runtime_error("Matrix response does not match the number of sources and targets");
+    }
+    const std::vector<py::ssize_t> shape{rows, columns};
+    return py::make_tuple(py::array_t<float>(shape, matrix.times().data()),
+                          py::array_t<float>(shape, matrix.distances().data()));
+  }
+
+  // map matches each array of lon, lat, the responses are serialized valhalla.Api messages
+  py::list trace_arrays(const std::string& name,
+                        const std::vector<coords_t>& shapes,
+                        const std::string& options) {
+    const auto action = parse_action(name);
+    if (action != Options::trace_route && action != Options::trace_attributes) {
+      throw std::invalid_argument("Shapes are map matched with trace_route or trace_attributes");
+    }
+    const auto base = parse_options(options, action);
+    std::vector<Api> requests(shapes.size());
+    for (size_t i = 0; i < shapes.size(); ++i) {
+      requests[i].mutable_options()->CopyFrom(base.options());
+      add_locations(shapes[i], requests[i].mutable_options()->mutable_shape());
+    }
+
+    std::vector<std::string> responses(requests.size());
+    {
+      py::gil_scoped_release no_gil;
+      for_each(requests.size(), [&](vt::actor_t& actor, size_t i) {
+        bool pbf = false;
+        responses[i] = act_or_error(actor, nullptr, "", requests[i], pbf);
+      });
+    }
+
+    py::list results;
+    for (const auto& response : responses) {
+      results.append(py::bytes(response));
+    }
+    return results;
+  }
+
+private:
+  vt::actor_t* borrow() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    returned_.wait(lock, [this]() { return !idle_.empty(); });
+    auto* actor = idle_.back();
+    idle_.pop_back();
+    return actor;
+  }
+
+  void release(vt::actor_t* actor) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      idle_.push_back(actor);
+    }
+    returned_.notify_one();
+  }
+
+  std::vector<std::unique_ptr<vt::actor_t>> actors_;
+  std::vector<vt::actor_t*> idle_;
+  std::mutex mutex_;
+  std::condition_variable returned_;
+};
+
+// the actions release the gil while valhalla works on the request
+template <typename actor_type> void def_actions(py::class_<actor_type>& actor) {
+  for (const auto& info : actions()) {
+    auto action = info.action;
+    actor.def(
+        info.name,
+        [action](actor_type& self, const std::string& req) { return self.act(action, req); },
+        info.doc, py::call_guard<py::gil_scoped_release>());
+  }
+}
+} // namespace
 
 PYBIND11_MODULE(python_valhalla, m) {
-  py::class_<vt::actor_t>(m, "_Actor", "Valhalla Actor class")
-      .def(py::init<>([](std::string config) { return vt::actor_t(configure(config), true); }))
-      .def(
-          "route", [](vt::actor_t& self, std::string& req) { return self.route(req); },
-          "Calculates a route.")
-      .def(
-          "locate", [](vt::actor_t& self, std::string& req) { return self.locate(req); },
-          "Provides information about nodes and edges.")
-      .def(
-          "optimized_route",
-          [](vt::actor_t& self, std::string& req) { return self.optimized_route(req); },
-          "Optimizes the order of a set of waypoints by time.")
-      .def(
-          "matrix", [](vt::actor_t& self, std::string& req) { return self.matrix(req); },
-          "Computes the time and distance between a set of locations and returns them as a matrix table.")
-      .def(
-          "isochrone", [](vt::actor_t& self, std::string& req) { return self.isochrone(req); },
-          "Calculates isochrones and isodistances.")
-      .def(
-          "trace_route", [](vt::actor_t& self, std::string& req) { return self.trace_route(req); },
-          "Map-matching for a set of input locations, e.g. from a GPS.")
-      .def(
-          "trace_attributes",
-          [](vt::actor_t& self, std::string& req) { return self.trace_attributes(req); },
-          "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace.")
-      .def(
-          "height", [](vt::actor_t& self, std::string& req) { return self.height(req); },
-          "Provides elevation data for a set of input geometries.")
-      .def(
-          "transit_available",
-          [](vt::actor_t& self, std::string& req) { return self.transit_available(req); },
-          "Lookup if transit stops are available in a defined radius around a set of input locations.")
-      .def(
-          "expansion", [](vt::actor_t& self, std::string& req) { return self.expansion(req); },
-          "Returns all road segments which were touched by the routing algorithm during the graph traversal.")
-      .def(
-          "centroid", [](vt::actor_t& self, std::string& req) { return self.centroid(req); },
-          "Returns routes from all the input locations to the minimum cost meeting point of those paths.")
-      .def(
-          "status", [](vt::actor_t& self, std::string& req) { return self.status(req); },
-          "Returns nothing or optionally details about Valhalla's configuration.");
+  py::class_<locked_actor_t> actor(m, "_Actor", "Valhalla Actor class");
+  actor.def(py::init([](const std::string& config) {
+    return std::make_unique<locked_actor_t>(configure(config));
+  }));
+  def_actions(actor);
+
+  py::class_<actor_pool_t> pool(m, "_ActorPool",
+                                "Valhalla Actors sharing one tile cache for use from many threads");
+  pool.def(py::init([](const std::string& config, size_t size) {
+             return std::make_unique<actor_pool_t>(configure(config), size);
+           }),
+           py::arg("config"), py::arg("size") = 0);
+  pool.def_property_readonly("size", &actor_pool_t::size);
+  def_actions(pool);
+  pool.def("batch", &actor_pool_t::batch, py::arg("action"), py::arg("requests"),
+           "Works on a list of requests of one action in parallel. Requests are json str or "
+           "serialized valhalla.Api bytes, responses are bytes for pbf and str otherwise.");
+  pool.def("matrix_arrays", &actor_pool_t::matrix_arrays, py::arg("sources"), py::arg("targets"),
+           py::arg("options") = "",
+           "Computes a matrix between (n, 2) arrays of lon, lat and returns the times and the "
+           "distances as arrays of shape (sources, targets), -1 where no route was found.");
+  pool.def("trace_arrays", &actor_pool_t::trace_arrays, py::arg("action"), py::arg("shapes"),
+           py::arg("options") = "",
+           "Map matches a list of (n, 2) arrays of lon, lat in parallel and returns the serialized "
+           "valhalla.Api of each.");
 }
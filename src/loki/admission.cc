@@ -0,0 +1,132 @@
+#include "loki/admission.h"
+#include "midgard/constants.h"
+#include "proto_conversions.h"
+#include "worker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+using namespace valhalla::midgard;
+
+namespace valhalla {
+namespace loki {
+
+namespace {
+
+// the backlog of the admitted requests shared by all the workers of the process
+std::mutex backlog_lock;
+double backlog = 0;
+std::chrono::steady_clock::time_point drained = std::chrono::steady_clock::now();
+
+// kilometers a minute of the time contours of an isochrone reaches for the costing
+double contour_speed(const Costing::Type costing) {
+  switch (costing) {
+    case Costing::pedestrian:
+      return 5. / 60;
+    case Costing::bicycle:
+    case Costing::bikeshare:
+      return 20. / 60;
+    default:
+      return 1;
+  }
+}
+
+// kilometers along the locations one after the other
+template <typename locations_t> double length(const locations_t& locations) {
+  double km = 0;
+  for (int i = 1; i < locations.size(); ++i) {
+    km += to_ll(locations.Get(i - 1)).Distance(to_ll(locations.Get(i))) * kKmPerMeter;
+  }
+  return km;
+}
+
+} // namespace
+
+AdmissionControl::AdmissionControl(const boost::property_tree::ptree& config)
+    : expensive_cost_(config.get<double>("expensive_cost", 10000)),
+      throughput_(std::max(1., config.get<double>("throughput", 100000))),
+      max_wait_(config.get<double>("max_wait", 0)) {
+}
+
+void AdmissionControl::admit(const Options& options) {
+  if (max_wait_ <= 0) {
+    return;
+  }
+  const auto cost = estimate(options);
+
+  std::lock_guard<std::mutex> lock(backlog_lock);
+  // the service got through some of the backlog since the last request
+  const auto now = std::chrono::steady_clock::now();
+  backlog -= std::chrono::duration<double>(now - drained).count() * throughput_;
+  backlog = std::max(0., backlog);
+  drained = now;
+
+  // expensive requests would wait for too long behind what is already admitted
+  const auto wait = backlog / throughput_;
+  if (cost >= expensive_cost_ && wait > max_wait_) {
+    throw valhalla_exception_t{174, std::to_string(static_cast<int>(std::ceil(wait))) +
+                                        " seconds of work queued"};
+  }
+  backlog += cost;
+}
+
+double AdmissionControl::estimate(const Options& options) {
+  switch (options.action()) {
+    case Options::route:
+    case Options::centroid:
+      return length(options.locations());
+    case Options::trace_route:
+    case Options::trace_attributes:
+      return length(options.shape());
+    case Options::sources_to_targets:
+    case Options::optimized_route: {
+      // every source or target expands across the extent of all of them
+      const auto& sources = options.sources_size() ? options.sources() : options.locations();
+      const auto& targets = options.targets_size() ? options.targets() : options.locations();
+      double min_lat = 90, max_lat = -90, min_lng = 180, max_lng = -180;
+      for (const auto* locations : {&sources, &targets}) {
+        for (const auto& location : *locations) {
+          min_lat = std::min<double>(min_lat, location.ll().lat());
+          max_lat = std::max<double>(max_lat, location.ll().lat());
+          min_lng = std::min<double>(min_lng, location.ll().lng());
+          max_lng = std::max<double>(max_lng, location.ll().lng());
+        }
+      }
+      const double span =
+          min_lat > max_lat
+              ? 0
+              : PointLL(min_lng, min_lat).Distance(PointLL(max_lng, max_lat)) * kKmPerMeter;
+      return std::min(sources.size(), targets.size()) * std::max(1., span);
+    }
+    case Options::isochrone:
+    case Options::expansion: {
+      if (options.action() == Options::expansion && options.expansion_action() == Options::route) {
+        return length(options.locations());
+      }
+      // the area within the largest contour, as if there were a kilometer of road per square one
+      double radius = 0;
+      for (const auto& contour : options.contours()) {
+        if (contour.has_time_case()) {
+          radius = std::max(radius, contour.time() * contour_speed(options.costing_type()));
+        }
+        if (contour.has_distance_case()) {
+          radius = std::max<double>(radius, contour.distance());
+        }
+      }
+      return options.locations_size() * kPiDouble * radius * radius;
+    }
+    default:
+      return 0;
+  }
+}
+
+void AdmissionControl::reset() {
+  std::lock_guard<std::mutex> lock(backlog_lock);
+  backlog = 0;
+  drained = std::chrono::steady_clock::now();
+}
+
+} // namespace loki
+} // namespace valhalla
@@ -0,0 +1,70 @@
+#include "loki/bin_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace valhalla::baldr;
+using namespace valhalla::loki;
+
+namespace {
+
+// narrow the bounds to floats without letting the box shrink
+BinIndex::box_t to_box(double minx, double miny, double maxx, double maxy) {
+  constexpr auto lowest = std::numeric_limits<float>::lowest();
+  constexpr auto highest = std::numeric_limits<float>::max();
+  return {std::nextafter(static_cast<float>(minx), lowest),
+          std::nextafter(static_cast<float>(miny), lowest),
+          std::nextafter(static_cast<float>(maxx), highest),
+          std::nextafter(static_cast<float>(maxy), highest)};
+}
+
+} // namespace
+
+namespace valhalla {
+namespace loki {
+
+const std::vector<BinIndex::box_t>*
+BinIndex::get(const graph_tile_ptr& tile, uint16_t bin, GraphReader& reader) {
+  if (!max_bins_ || !tile)
+    return nullptr;
+
+  // the bin fits in the id part of the tiles id
+  GraphId key = tile->id();
+  key.set_id(bin);
+  auto found = bins_.find(key.value);
+  if (found != bins_.end())
+    return &found->second;
+
+  if (bins_.size() >= max_bins_)
+    bins_.clear();
+  auto& boxes = bins_[key.value];
+
+  // edges which cross into this tile from a neighbour live in the neighbour
+  auto edges = tile->GetBin(bin);
+  boxes.reserve(edges.size());
+  graph_tile_ptr edge_tile = tile;
+  for (auto edge_id : edges) {
+    // if we cant look at the shape the box must not rule the edge out
+    if (!reader.GetGraphTile(edge_id, edge_tile)) {
+      boxes.push_back(to_box(-180, -90, 180, 90));
+      continue;
+    }
+
+    auto shape = edge_tile->edgeinfo(edge_tile->directededge(edge_id)).lazy_shape();
+    double minx = 180, miny = 90, maxx = -180, maxy = -90;
+    while (!shape.empty()) {
+      const auto p = shape.pop();
+      minx = std::min(minx, p.lng());
+      miny = std::min(miny, p.lat());
+      maxx = std::max(maxx, p.lng());
+      maxy = std::max(maxy, p.lat());
+    }
+    boxes.push_back(minx <= maxx ? to_box(minx, miny, maxx, maxy) : to_box(-180, -90, 180, 90));
+  }
+
+  return &boxes;
+}
+
+} // namespace loki
+} // namespace valhalla
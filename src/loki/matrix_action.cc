@@ -38,10 +38,11 @@ void check_distance(Api& request,
                                             " meters"};
       };
 
-      // unset the date_time if beyond the limit
+      // unset the date_time if beyond the limit, the departure times too
       if (static_cast<size_t>(path_distance) > max_timedep_distance) {
         source.set_date_time("");
         target.set_date_time("");
+        options.clear_departure_times();
         if (max_timedep_distance && !added_warning) {
           add_warning(request, 200);
           added_warning = true;
@@ -72,6 +73,9 @@ void loki_worker_t::init_matrix(Api& request) {
     // create new sources and targets from locations
     options.mutable_targets()->CopyFrom(options.locations());
     options.mutable_sources()->CopyFrom(options.locations());
+
+    // the optimizer needs the one matrix
+    options.clear_departure_times();
   }
 
   // sanitize
@@ -113,6 +117,15 @@ void loki_worker_t::matrix(Api& request) {
     throw valhalla_exception_t{150, std::to_string(max)};
   };
 
+  // a matrix is computed at each departure time, bikeshare only has the one
+  if (options.departure_times_size() > static_cast<int>(max_matrix_departure_times)) {
+    throw valhalla_exception_t{173, std::to_string(max_matrix_departure_times)};
+  }
+  if (options.departure_times_size() && costing_name == "bikeshare") {
+    options.clear_departure_times();
+    add_warning(request, 207);
+  }
+
   // check the distances
   auto max_location_distance = std::numeric_limits<float>::min();
   check_distance(request, max_matrix_distance.find(costing_name)->second, max_location_distance,
@@ -130,7 +143,7 @@ void loki_worker_t::matrix(Api& request) {
   // correlate the various locations to the underlying graph
   std::unordered_map<size_t, size_t> color_counts;
   try {
-    const auto searched = loki::Search(sources_targets, *reader, costing);
+    const auto searched = search(request, sources_targets);
     for (size_t i = 0; i < sources_targets.size(); ++i) {
       const auto& l = sources_targets[i];
       const auto& projection = searched.at(l);
@@ -166,39 +166,54 @@ expand_bbox_across_boundaries(const vm::AABB2<vm::PointLL>& bbox,
   return boxes;
 }
 
-// for each bounding box in boxes, calculate the intersection and merge all the
-// results together, then return it.
-std::unordered_map<int32_t, std::unordered_set<uint16_t>>
-merge_intersections(const std::vector<vm::AABB2<vm::PointLL>>& boxes,
+// for each of the bounding boxes, expand it across the tile and bin boundaries and calculate its
+// intersection. the result maps each tile to its bins and each bin to the indices of the boxes
+// which touched it, so that every bin is only visited once no matter how many boxes share it.
+using bin_boxes_t = std::unordered_map<uint16_t, std::vector<uint32_t>>;
+std::unordered_map<int32_t, bin_boxes_t>
+merge_intersections(const std::vector<vm::AABB2<vm::PointLL>>& bboxes,
                     const vm::Tiles<vm::PointLL>& tiles) {
 
-  std::unordered_map<int32_t, std::unordered_set<uint16_t>> result;
-
-  for (const auto& box : boxes) {
-    auto intersection = tiles.Intersect(box);
-
-    for (const auto& entry : intersection) {
-      result[entry.first].insert(entry.second.begin(), entry.second.end());
+  std::unordered_map<int32_t, bin_boxes_t> result;
+
+  for (uint32_t i = 0; i < bboxes.size(); ++i) {
+    // if the bbox only touches the edge of the tile or bin, then we need to
+    // include neighbouring bins as well, in case both the edge and its opposite
+    // were tie-broken into a bin which doesn't intersect the original bbox.
+    for (const auto& box : expand_bbox_across_boundaries(bboxes[i], tiles)) {
+      for (const auto& entry : tiles.Intersect(box)) {
+        auto& bins = result[entry.first];
+        for (auto bin_id : entry.second) {
+          // the expanded boxes of one bbox may share bins near the anti-meridian
+          auto& boxes = bins[bin_id];
+          if (boxes.empty() || boxes.back() != i) {
+            boxes.push_back(i);
+          }
+        }
+      }
     }
   }
 
   return result;
 }
 
+// a node found while walking the bins along with its position, which is kept so
+// that the node can be handed out to every bounding box which contains it.
+struct candidate_node {
+  vb::GraphId id;
+  vm::PointLL ll;
+};
+
 struct filtered_nodes {
-  explicit filtered_nodes(const vm::AABB2<vm::PointLL>& b, std::vector<vb::GraphId>& nodes)
-      : m_box(b), m_nodes(nodes) {
+  explicit filtered_nodes(std::vector<candidate_node>& nodes) : m_nodes(nodes) {
   }
 
   inline void push_back(vb::GraphId id, const vm::PointLL& ll) {
-    if (m_box.Contains(ll)) {
-      m_nodes.push_back(id);
-    }
+    m_nodes.push_back({id, ll});
   }
 
 private:
-  vm::AABB2<vm::PointLL> m_box;
-  std::vector<vb::GraphId>& m_nodes;
+  std::vector<candidate_node>& m_nodes;
 };
 
 // functor to sort GraphId objects by level, tile then id within the tile.
@@ -366,26 +381,31 @@ namespace loki {
 
 std::vector<baldr::GraphId> nodes_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
                                           baldr::GraphReader& reader) {
-  std::vector<vb::GraphId> nodes;
+  return std::move(nodes_in_bboxes({bbox}, reader).front());
+}
+
+std::vector<std::vector<baldr::GraphId>>
+nodes_in_bboxes(const std::vector<vm::AABB2<vm::PointLL>>& bboxes, baldr::GraphReader& reader) {
+  std::vector<std::vector<vb::GraphId>> nodes(bboxes.size());
+  if (bboxes.empty()) {
+    return nodes;
+  }
 
   const auto& tiles = vb::TileHierarchy::levels().back().tiles;
   const uint8_t bin_level = vb::TileHierarchy::levels().back().level;
 
-  // if the bbox only touches the edge of the tile or bin, then we need to
-  // include neighbouring bins as well, in case both the edge and its opposite
-  // were tie-broken into a bin which doesn't intersect the original bbox.
-  auto expanded_bboxes = expand_bbox_across_boundaries(bbox, tiles);
-  auto intersections = merge_intersections(expanded_bboxes, tiles);
+  // the union of the bins touched by any of the boxes, each one is visited once
+  auto intersections = merge_intersections(bboxes, tiles);
 
   // we cache the last tile lookup, since the nodes and tweeners arrays are in
   // order then this guarantees the smallest number of times we have to look up
   // a new tile from the reader.
   tile_cache cache(reader);
 
-  // wrap the nodes in a filter so that only nodes contained within the bounding
-  // box are appended to the vector. there might be duplicates, so we have to
-  // sort and uniq the vector later.
-  filtered_nodes filtered(bbox, nodes);
+  // the nodes reachable from the bins, regardless of the box. there might be
+  // duplicates, so we have to sort and uniq the vector later.
+  std::vector<candidate_node> candidates;
+  filtered_nodes filtered(candidates);
 
   // a wrapper process which aims to order the lookups against tiles into a
   // number of sequential passes through the set of tiles.
@@ -400,8 +420,8 @@ std::vector<baldr::GraphId> nodes_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
       continue;
     }
 
-    for (auto bin_id : entry.second) {
-      for (auto edge_id : tile.tile()->GetBin(bin_id)) {
+    for (const auto& bin : entry.second) {
+      for (auto edge_id : tile.tile()->GetBin(bin.first)) {
         collector.add_edge(edge_id);
       }
     }
@@ -412,34 +432,57 @@ std::vector<baldr::GraphId> nodes_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
   collector.finish();
 
   // erase the duplicates
-  std::sort(nodes.begin(), nodes.end());
-  auto uniq_end = std::unique(nodes.begin(), nodes.end());
-
-  // remove any of the space at the end of the nodes array which is unused since
-  // duplicates were removed.
-  nodes.erase(uniq_end, nodes.end());
+  std::sort(candidates.begin(), candidates.end(),
+            [](const candidate_node& a, const candidate_node& b) { return a.id < b.id; });
+  auto uniq_end =
+      std::unique(candidates.begin(), candidates.end(),
+                  [](const candidate_node& a, const candidate_node& b) { return a.id == b.id; });
+  candidates.erase(uniq_end, candidates.end());
+
+  // hand the nodes out to the boxes which contain them. ordering the candidates by latitude lets
+  // each box only look at the band of nodes it spans rather than at all of them.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const candidate_node& a, const candidate_node& b) {
+                     return a.ll.lat() < b.ll.lat();
+                   });
+  for (size_t i = 0; i < bboxes.size(); ++i) {
+    const auto& bbox = bboxes[i];
+    auto itr = std::lower_bound(candidates.begin(), candidates.end(), bbox.miny(),
+                                [](const candidate_node& a, double lat) {
+                                  return a.ll.lat() < lat;
+                                });
+    for (; itr != candidates.end() && itr->ll.lat() <= bbox.maxy(); ++itr) {
+      if (bbox.Contains(itr->ll)) {
+        nodes[i].push_back(itr->id);
+      }
+    }
+    std::sort(nodes[i].begin(), nodes[i].end());
+  }
 
   return nodes;
 }
 
 std::vector<baldr::GraphId> edges_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
                                           baldr::GraphReader& reader) {
+  return std::move(edges_in_bboxes({bbox}, reader).front());
+}
 
-  auto tiles = vb::TileHierarchy::levels().back().tiles;
+std::vector<std::vector<baldr::GraphId>>
+edges_in_bboxes(const std::vector<vm::AABB2<vm::PointLL>>& bboxes, baldr::GraphReader& reader) {
+  std::vector<std::vector<vb::GraphId>> edge_ids(bboxes.size());
+
+  const auto& tiles = vb::TileHierarchy::levels().back().tiles;
   const uint8_t bin_level = vb::TileHierarchy::levels().back().level;
 
-  // if the bbox only touches the edge of the tile or bin, then we need to
-  // include neighbouring bins as well, in case both the edge and its opposite
-  // were tie-broken into a bin which doesn't intersect the original bbox.
-  auto expanded_bboxes = expand_bbox_across_boundaries(bbox, tiles);
-  auto intersections = merge_intersections(expanded_bboxes, tiles);
+  // the union of the bins touched by any of the boxes, each one is visited once
+  // and its edges are given to all the boxes which touched it
+  auto intersections = merge_intersections(bboxes, tiles);
 
   // we cache the last tile lookup, since the nodes and tweeners arrays are in
   // order then this guarantees the smallest number of times we have to look up
   // a new tile from the reader.
   tile_cache cache(reader);
 
-  std::vector<vb::GraphId> edge_ids;
   for (const auto& entry : intersections) {
     vb::GraphId tile_id(entry.first, bin_level, 0);
     // tile might not exist - the Tiles::Intersect routine returns all tiles
@@ -449,26 +492,20 @@ std::vector<baldr::GraphId> edges_in_bbox(const vm::AABB2<vm::PointLL>& bbox,
       continue;
     }
 
-    for (auto bin_id : entry.second) {
-      for (auto edge_id : tile.tile()->GetBin(bin_id)) {
-        edge_ids.push_back(edge_id);
+    for (const auto& bin : entry.second) {
+      auto bin_edges = tile.tile()->GetBin(bin.first);
+      for (auto box_index : bin.second) {
+        edge_ids[box_index].insert(edge_ids[box_index].end(), bin_edges.begin(), bin_edges.end());
       }
     }
   }
 
-  // erase the duplicates by sorting
-  {
-    std::sort(edge_ids.begin(), edge_ids.end(), [](const auto a, const auto b) {
-      // This ordering means when we iterate over this list, it'll be
-      // cache friendly, in-memory-order
-      if (a.level() == b.level())
-        return a.tileid() < b.tileid();
-      if (a.tileid() == b.tileid())
-        return a.id() < b.id();
-      return a.level() < b.level();
-    });
-    auto uniq_end = std::unique(edge_ids.begin(), edge_ids.end());
-    edge_ids.erase(uniq_end, edge_ids.end());
+  // erase the duplicates by sorting. this ordering means when we iterate over
+  // this list, it'll be cache friendly, in-memory-order
+  for (auto& ids : edge_ids) {
+    std::sort(ids.begin(), ids.end(), sort_by_tile());
+    auto uniq_end = std::unique(ids.begin(), ids.end());
+    ids.erase(uniq_end, ids.end());
   }
 
   return edge_ids;
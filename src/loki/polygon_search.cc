@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/register/point.hpp>
 #include <boost/geometry/geometries/register/ring.hpp>
@@ -5,6 +12,7 @@
 #include <valhalla/baldr/json.h>
 #include <valhalla/loki/polygon_search.h>
 #include <valhalla/midgard/constants.h>
+#include <valhalla/midgard/executor.h>
 #include <valhalla/midgard/logging.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -20,14 +28,17 @@ BOOST_GEOMETRY_REGISTER_RING(std::vector<vm::PointLL>)
 
 namespace {
 // register a few boost.geometry types
-using line_bg_t = bg::model::linestring<vm::PointLL>;
 using ring_bg_t = std::vector<vm::PointLL>;
 using namespace vb::json;
 
-// map of tile for map of bin ids & their ring ids
-// TODO: simplify the logic behind this a little
-using bins_collector =
-    std::unordered_map<uint32_t, std::unordered_map<unsigned short, std::vector<size_t>>>;
+// map of tile for its bin ids
+using bins_t = std::unordered_map<int32_t, std::unordered_set<unsigned short>>;
+
+// how many prepared rings are kept for requests sending the same polygons again
+constexpr size_t kCachedRings = 64;
+
+// how many edges a thread takes at once for the exact tests
+constexpr size_t kEdgesPerTask = 64;
 
 static const auto Haversine = [] {
   return bg::strategy::distance::haversine<float>(vm::kRadEarthMeters);
@@ -56,6 +67,194 @@ ring_bg_t PBFToRing(const valhalla::Ring& ring_pbf) {
   return new_ring;
 }
 
+// sign of the turn from a to b to c, 0 if they are on a line
+int orientation(const vm::PointLL& a, const vm::PointLL& b, const vm::PointLL& c) {
+  double cross =
+      (b.lng() - a.lng()) * (c.lat() - a.lat()) - (b.lat() - a.lat()) * (c.lng() - a.lng());
+  return (cross > 0) - (cross < 0);
+}
+
+// whether c, on the line through a and b, is between them
+bool on_segment(const vm::PointLL& a, const vm::PointLL& b, const vm::PointLL& c) {
+  return std::min(a.lng(), b.lng()) <= c.lng() && c.lng() <= std::max(a.lng(), b.lng()) &&
+         std::min(a.lat(), b.lat()) <= c.lat() && c.lat() <= std::max(a.lat(), b.lat());
+}
+
+// whether the segments a-b and c-d touch or cross
+bool segments_intersect(const vm::PointLL& a,
+                        const vm::PointLL& b,
+                        const vm::PointLL& c,
+                        const vm::PointLL& d) {
+  int o1 = orientation(a, b, c), o2 = orientation(a, b, d);
+  int o3 = orientation(c, d, a), o4 = orientation(c, d, b);
+  if (o1 != o2 && o3 != o4)
+    return true;
+  return (o1 == 0 && on_segment(a, b, c)) || (o2 == 0 && on_segment(a, b, d)) ||
+         (o3 == 0 && on_segment(c, d, a)) || (o4 == 0 && on_segment(c, d, b));
+}
+
+/**
+ * A ring prepared for testing many edges against it. Its segments are sorted into bands of
+ * latitude so that a test only looks at the segments near the edge, and the ring is rasterized
+ * onto the bins of the graph: the bins its boundary crosses need the exact test, the bins it
+ * covers entirely have all of their edges inside it and those of any other bin are outside of it.
+ * The tests are planar in degrees, the segments of the rings and edges are short enough for that.
+ */
+struct prepared_ring_t {
+  prepared_ring_t(ring_bg_t r, const vm::Tiles<vm::PointLL>& tiles)
+      : ring(std::move(r)), box(ring), length(bg::perimeter(ring, Haversine())) {
+    // the segments of the ring by the bands of latitude they span
+    size_t band_count = std::max(std::min(ring.size() / 8, size_t(1024)), size_t(1));
+    band_height = box.Height() > 0 ? box.Height() / band_count : 1.;
+    bands.resize(band_count);
+    for (uint32_t i = 0; i + 1 < ring.size(); ++i) {
+      auto first = band(std::min(ring[i].lat(), ring[i + 1].lat()));
+      auto last = band(std::max(ring[i].lat(), ring[i + 1].lat()));
+      for (auto b = first; b <= last; ++b) {
+        bands[b].push_back(i);
+      }
+    }
+
+    // the bins crossed by the boundary and the bins covered entirely
+    boundary = tiles.Intersect(ring);
+    const auto bin_size = tiles.SubdivisionSize();
+    for (const auto& tile_bins : tiles.Intersect(box)) {
+      const auto tile_box = tiles.TileBounds(tile_bins.first);
+      const auto* crossed = boundary.count(tile_bins.first) ? &boundary[tile_bins.first] : nullptr;
+      for (auto bin : tile_bins.second) {
+        if (crossed && crossed->count(bin)) {
+          continue;
+        }
+        // nothing of the boundary is in the bin so its center tells where all of it is
+        const auto column = bin % tiles.nsubdivisions();
+        const auto row = bin / tiles.nsubdivisions();
+        vm::PointLL center(tile_box.minx() + (column + .5) * bin_size,
+                           tile_box.miny() + (row + .5) * bin_size);
+        if (contains(center)) {
+          interior[tile_bins.first].insert(bin);
+        }
+      }
+    }
+  }
+
+  size_t band(double lat) const {
+    auto b = static_cast<size_t>(std::max((lat - box.miny()) / band_height, 0.));
+    return std::min(b, bands.size() - 1);
+  }
+
+  // crossing number of a ray from the point to the east, only the band of the point has segments
+  // reaching its latitude
+  bool contains(const vm::PointLL& p) const {
+    if (!box.Contains(p)) {
+      return false;
+    }
+    bool inside = false;
+    for (auto i : bands[band(p.lat())]) {
+      const auto& a = ring[i];
+      const auto& b = ring[i + 1];
+      if ((a.lat() > p.lat()) != (b.lat() > p.lat()) &&
+          p.lng() < a.lng() + (p.lat() - a.lat()) * (b.lng() - a.lng()) / (b.lat() - a.lat())) {
+        inside = !inside;
+      }
+    }
+    return inside;
+  }
+
+  // whether the segment touches or crosses the boundary of the ring
+  bool crosses(const vm::PointLL& a, const vm::PointLL& b) const {
+    if (!box.Intersects(vm::AABB2<vm::PointLL>(std::min(a.lng(), b.lng()),
+                                               std::min(a.lat(), b.lat()),
+                                               std::max(a.lng(), b.lng()),
+                                               std::max(a.lat(), b.lat())))) {
+      return false;
+    }
+    auto last = band(std::max(a.lat(), b.lat()));
+    for (auto i = band(std::min(a.lat(), b.lat())); i <= last; ++i) {
+      for (auto s : bands[i]) {
+        if (segments_intersect(a, b, ring[s], ring[s + 1])) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // whether the shape of an edge is inside or crosses the ring
+  bool intersects(const std::vector<vm::PointLL>& shape) const {
+    if (shape.empty() || !box.Intersects(vm::AABB2<vm::PointLL>(shape))) {
+      return false;
+    }
+    if (contains(shape.front())) {
+      return true;
+    }
+    for (size_t i = 0; i + 1 < shape.size(); ++i) {
+      if (crosses(shape[i], shape[i + 1])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  ring_bg_t ring;
+  vm::AABB2<vm::PointLL> box;
+  double length;
+  double band_height;
+  std::vector<std::vector<uint32_t>> bands;
+  bins_t boundary;
+  bins_t interior;
+};
+
+size_t hash_ring(const ring_bg_t& ring) {
+  size_t seed = ring.size();
+  for (const auto& p : ring) {
+    seed ^= std::hash<double>{}(p.first) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<double>{}(p.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
+bool same_ring(const ring_bg_t& a, const ring_bg_t& b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](const vm::PointLL& p, const vm::PointLL& q) {
+           return p.first == q.first && p.second == q.second;
+         });
+}
+
+// the most recently prepared rings, shared by the workers of the process
+std::shared_ptr<const prepared_ring_t> prepare_ring(ring_bg_t ring,
+                                                    const vm::Tiles<vm::PointLL>& tiles) {
+  static std::mutex mutex;
+  static std::list<std::pair<size_t, std::shared_ptr<const prepared_ring_t>>> recent;
+
+  auto hash = hash_ring(ring);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = recent.begin(); it != recent.end(); ++it) {
+      if (it->first == hash && same_ring(it->second->ring, ring)) {
+        recent.splice(recent.begin(), recent, it);
+        return recent.front().second;
+      }
+    }
+  }
+
+  auto prepared = std::make_shared<const prepared_ring_t>(std::move(ring), tiles);
+  std::lock_guard<std::mutex> lock(mutex);
+  recent.emplace_front(hash, prepared);
+  if (recent.size() > kCachedRings) {
+    recent.pop_back();
+  }
+  return prepared;
+}
+
+// an edge in a bin of a ring, whether the bin is inside of a ring or which rings cross it
+struct candidate_t {
+  vb::GraphId edge_id;
+  vb::GraphId opp_id;
+  vb::graph_tile_ptr tile;
+  bool inside;
+  std::vector<size_t> rings;
+};
+
 #ifdef LOGGING_LEVEL_TRACE
 // serializes an edge to geojson
 std::string to_geojson(const std::unordered_set<vb::GraphId>& edge_ids, vb::GraphReader& reader) {
@@ -98,53 +297,68 @@ std::unordered_set<vb::GraphId>
 edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Ring>& rings_pbf,
                baldr::GraphReader& reader,
                const std::shared_ptr<sif::DynamicCost>& costing,
-               float max_length) {
+               float max_length,
+               uint32_t threads) {
   // protect for bogus input
   if (rings_pbf.empty() || rings_pbf.Get(0).coords().empty() ||
       !rings_pbf.Get(0).coords()[0].has_lat_case() || !rings_pbf.Get(0).coords()[0].has_lng_case()) {
     return {};
   }
 
-  // convert to bg object and check length restriction
+  // Get the lowest level and tiles
+  const auto tiles = vb::TileHierarchy::levels().back().tiles;
+  const auto bin_level = vb::TileHierarchy::levels().back().level;
+
+  // prepare the rings and check length restriction
   double rings_length = 0;
-  std::vector<ring_bg_t> rings_bg;
+  std::vector<std::shared_ptr<const prepared_ring_t>> rings;
   for (const auto& ring_pbf : rings_pbf) {
-    rings_bg.push_back(PBFToRing(ring_pbf));
-    const ring_bg_t ring_bg = rings_bg.back();
-    rings_length += bg::perimeter(ring_bg, Haversine());
+    rings.push_back(prepare_ring(PBFToRing(ring_pbf), tiles));
+    rings_length += rings.back()->length;
   }
   if (rings_length > max_length) {
     throw valhalla_exception_t(167, std::to_string(static_cast<size_t>(max_length)) + " meters");
   }
 
-  // Get the lowest level and tiles
-  const auto tiles = vb::TileHierarchy::levels().back().tiles;
-  const auto bin_level = vb::TileHierarchy::levels().back().level;
-
-  // keep track which tile's bins intersect which rings
-  bins_collector bins_intersected;
-  std::unordered_set<vb::GraphId> avoid_edge_ids;
-
-  // first pull out all *unique* bins which intersect the rings
-  for (size_t ring_idx = 0; ring_idx < rings_bg.size(); ring_idx++) {
-    auto ring = rings_bg[ring_idx];
-    auto line_intersected = tiles.Intersect(ring);
-    for (const auto& tb : line_intersected) {
+  // first pull out all *unique* bins which the rings cross or cover, and which rings cross them
+  std::map<int32_t, std::map<unsigned short, std::pair<bool, std::vector<size_t>>>> bins;
+  for (size_t ring_idx = 0; ring_idx < rings.size(); ring_idx++) {
+    for (const auto& tb : rings[ring_idx]->boundary) {
+      for (const auto& b : tb.second) {
+        bins[tb.first][b].second.push_back(ring_idx);
+      }
+    }
+    for (const auto& tb : rings[ring_idx]->interior) {
       for (const auto& b : tb.second) {
-        bins_intersected[static_cast<uint32_t>(tb.first)][b].push_back(ring_idx);
+        bins[tb.first][b].first = true;
       }
     }
   }
-  for (const auto& intersection : bins_intersected) {
-    auto tile = reader.GetGraphTile({intersection.first, bin_level, 0});
+
+  // then the edges of those bins we would be allowed on, each edge once
+  std::vector<candidate_t> candidates;
+  std::unordered_map<vb::GraphId, size_t> candidate_index;
+  for (const auto& intersection : bins) {
+    auto tile = reader.GetGraphTile({static_cast<uint32_t>(intersection.first), bin_level, 0});
     if (!tile) {
       continue;
     }
     for (const auto& bin : intersection.second) {
       // tile will be mutated most likely in the loop
-      reader.GetGraphTile({intersection.first, bin_level, 0}, tile);
+      reader.GetGraphTile({static_cast<uint32_t>(intersection.first), bin_level, 0}, tile);
       for (const auto& edge_id : tile->GetBin(bin.first)) {
-        if (avoid_edge_ids.count(edge_id) != 0) {
+        auto found = candidate_index.find(edge_id);
+        if (found != candidate_index.end()) {
+          if (found->second < candidates.size()) {
+            auto& candidate = candidates[found->second];
+            candidate.inside = candidate.inside || bin.second.first;
+            for (auto ring_idx : bin.second.second) {
+              if (std::find(candidate.rings.begin(), candidate.rings.end(), ring_idx) ==
+                  candidate.rings.end()) {
+                candidate.rings.push_back(ring_idx);
+              }
+            }
+          }
           continue;
         }
         // TODO: optimize the tile switching by enqueuing edges
@@ -162,27 +376,64 @@ edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Ring>& rings_p
         if (!costing->Allowed(edge, tile) &&
             (!(opp_id = reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile)).Is_Valid() ||
              !costing->Allowed(opp_edge, opp_tile))) {
+          candidate_index.emplace(edge_id, std::numeric_limits<size_t>::max());
           continue;
         }
 
-        // TODO: some logic to set percent_along for origin/destination edges
-        // careful: polygon can intersect a single edge multiple times
-        auto edge_info = tile->edgeinfo(edge);
-        bool intersects = false;
-        for (const auto& ring_loc : bin.second) {
-          intersects = bg::intersects(rings_bg[ring_loc],
-                                      line_bg_t(edge_info.shape().begin(), edge_info.shape().end()));
-          if (intersects) {
+        candidate_index.emplace(edge_id, candidates.size());
+        candidates.push_back({edge_id, opp_id, tile, bin.second.first, bin.second.second});
+      }
+    }
+  }
+
+  // the edges in bins covered by a ring are inside it, the others need the exact test which the
+  // threads share in blocks of edges
+  // TODO: some logic to set percent_along for origin/destination edges
+  // careful: polygon can intersect a single edge multiple times
+  std::vector<char> intersects(candidates.size(), false);
+  std::atomic<size_t> next_candidate{0};
+  auto test_candidates = [&](uint32_t) {
+    size_t first;
+    while ((first = next_candidate.fetch_add(kEdgesPerTask)) < candidates.size()) {
+      for (size_t i = first; i < std::min(first + kEdgesPerTask, candidates.size()); ++i) {
+        const auto& candidate = candidates[i];
+        if (candidate.inside) {
+          intersects[i] = true;
+          continue;
+        }
+        const auto* edge = candidate.tile->directededge(candidate.edge_id);
+        const auto shape = candidate.tile->edgeinfo(edge).shape();
+        for (auto ring_idx : candidate.rings) {
+          if (rings[ring_idx]->intersects(shape)) {
+            intersects[i] = true;
             break;
           }
         }
-        if (intersects) {
-          avoid_edge_ids.emplace(edge_id);
-          avoid_edge_ids.emplace(
-              opp_id.Is_Valid() ? opp_id : reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile));
-        }
       }
     }
+  };
+  if (threads > 1 && candidates.size() > kEdgesPerTask) {
+    auto slots = std::min<size_t>(threads, (candidates.size() + kEdgesPerTask - 1) / kEdgesPerTask);
+    vm::executor_t::shared().run(static_cast<uint32_t>(slots), test_candidates);
+  } else {
+    test_candidates(0);
+  }
+
+  // exclude both directions of the edges in the rings
+  std::unordered_set<vb::GraphId> avoid_edge_ids;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (!intersects[i]) {
+      continue;
+    }
+    const auto& candidate = candidates[i];
+    avoid_edge_ids.emplace(candidate.edge_id);
+    if (candidate.opp_id.Is_Valid()) {
+      avoid_edge_ids.emplace(candidate.opp_id);
+    } else {
+      auto opp_tile = candidate.tile;
+      const baldr::DirectedEdge* opp_edge = nullptr;
+      avoid_edge_ids.emplace(reader.GetOpposingEdgeId(candidate.edge_id, opp_edge, opp_tile));
+    }
   }
 
 // log the GeoJSON of avoided edges
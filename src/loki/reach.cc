@@ -1,10 +1,59 @@
 #include "loki/reach.h"
+#include "baldr/rapidjson_utils.h"
+#include "proto_conversions.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
 
 using namespace valhalla::baldr;
 
 namespace valhalla {
 namespace loki {
 
+namespace {
+
+// the default costings of the modes whose reach mjolnir can store in the tiles, serialized
+const std::unordered_map<int, std::pair<std::string, uint32_t>>& stored_reach_costings() {
+  static const auto costings = [] {
+    rapidjson::Document doc;
+    doc.SetObject();
+    std::unordered_map<int, std::pair<std::string, uint32_t>> costings;
+    for (const auto& mode : {std::make_pair(Costing::auto_, kAutoAccess),
+                             std::make_pair(Costing::pedestrian, kPedestrianAccess),
+                             std::make_pair(Costing::bicycle, kBicycleAccess)}) {
+      Costing costing;
+      sif::ParseCosting(doc, "/costing_options/" + Costing_Enum_Name(mode.first), &costing,
+                        mode.first);
+      costings.emplace(mode.first, std::make_pair(costing.SerializeAsString(), mode.second));
+    }
+    return costings;
+  }();
+  return costings;
+}
+
+} // namespace
+
+void ReachCache::use_costing(const Options& options, bool use_stored) {
+  // no caching when the costing has edges excluded just for this request
+  costing_key_ = 0;
+  stored_access_ = 0;
+  auto costing = options.costings().find(options.costing_type());
+  if (costing == options.costings().cend() || costing->second.options().exclude_edges_size())
+    return;
+
+  // the serialized costing covers the type and every option that could affect Allowed
+  auto serialized = costing->second.SerializeAsString();
+
+  // is it a default costing whose reach could be in the tiles
+  auto stored = stored_reach_costings().find(options.costing_type());
+  if (use_stored && stored != stored_reach_costings().cend() && stored->second.first == serialized)
+    stored_access_ = stored->second.second;
+
+  if (max_size_)
+    costing_key_ = std::hash<std::string>{}(std::to_string(options.costing_type()) + serialized) | 1;
+}
+
 Reach::Reach() : Dijkstras() {
   // Mock up the Location struct with the important stuff missing
   auto* path_edge = locations_.Add()->mutable_correlation()->add_edges();
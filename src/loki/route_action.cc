@@ -38,6 +38,12 @@ void check_distance(const google::protobuf::RepeatedPtrField<valhalla::Location>
   }
 }
 
+// the costings which route with a single mode and can be compared with each other
+bool comparable(Costing::Type costing) {
+  return costing != Costing::none_ && costing != Costing::multimodal &&
+         costing != Costing::transit && costing != Costing::bikeshare;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -53,6 +59,46 @@ void loki_worker_t::init_route(Api& request) {
   parse_costing(request);
 }
 
+std::vector<sif::cost_ptr_t> loki_worker_t::parse_comparisons(Api& request) {
+  auto& options = *request.mutable_options();
+  if (options.comparisons_size() == 0) {
+    return {};
+  }
+  if (options.action() != Options::route || options.alternates() > 0 ||
+      !comparable(options.costing_type())) {
+    throw valhalla_exception_t{145};
+  }
+  if (static_cast<size_t>(options.comparisons_size()) > max_comparisons) {
+    throw valhalla_exception_t{176, std::to_string(max_comparisons)};
+  }
+
+  // the avoids of the request are for every costing
+  const auto& excluded =
+      options.costings().find(options.costing_type())->second.options().exclude_edges();
+  std::vector<sif::cost_ptr_t> costings;
+  for (auto& comparison : *options.mutable_comparisons()) {
+    const auto& costing_name = Costing_Enum_Name(comparison.type());
+    if (!comparable(comparison.type())) {
+      throw valhalla_exception_t{145};
+    }
+    const auto locations_limit = max_locations.find(costing_name);
+    const auto distance_limit = max_distance.find(costing_name);
+    if (locations_limit == max_locations.cend() || distance_limit == max_distance.cend()) {
+      throw valhalla_exception_t{125, "'" + costing_name + "'"};
+    }
+    check_locations(options.locations_size(), locations_limit->second);
+    check_distance(options.locations(), distance_limit->second, false);
+
+    comparison.mutable_options()->mutable_exclude_edges()->MergeFrom(excluded);
+    try {
+      costings.push_back(factory.Create(comparison));
+    } catch (const std::runtime_error&) {
+      throw valhalla_exception_t{125, "'" + costing_name + "'"};
+    }
+  }
+  return costings;
+}
+
 void loki_worker_t::route(Api& request) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request);
@@ -68,6 +114,9 @@ void loki_worker_t::route(Api& request) {
     check_distance(options.locations(), max_distance.find(costing_name)->second, false);
   }
 
+  // the other costings to route with share the correlation of the locations
+  const auto comparisons = parse_comparisons(request);
+
   // check distance for hierarchy pruning
   check_hierarchy_distance(request);
 
@@ -102,7 +151,7 @@ void loki_worker_t::route(Api& request) {
   std::unordered_map<size_t, size_t> color_counts;
   try {
     auto locations = PathLocation::fromPBF(options.locations(), true);
-    const auto projections = loki::Search(locations, *reader, costing);
+    const auto projections = search(request, locations, comparisons);
     for (size_t i = 0; i < locations.size(); ++i) {
       const auto& correlated = projections.at(locations[i]);
       PathLocation::toPBF(correlated, options.mutable_locations(i), *reader);
@@ -1,8 +1,10 @@
 #include "loki/search.h"
 #include "baldr/graphconstants.h"
 #include "baldr/tilehierarchy.h"
+#include "loki/bin_index.h"
 #include "loki/reach.h"
 #include "midgard/distanceapproximator.h"
+#include "midgard/flat_hash.h"
 #include "midgard/linesegment2.h"
 #include "midgard/util.h"
 
@@ -244,20 +246,29 @@ struct projector_wrapper {
 struct bin_handler_t {
   std::vector<projector_wrapper> pps;
   valhalla::baldr::GraphReader& reader;
+  // the edges any of the costings allow are candidates, the first one is the costing of the request
+  std::vector<std::shared_ptr<DynamicCost>> costings;
   std::shared_ptr<DynamicCost> costing;
   unsigned int max_reach_limit;
   std::vector<candidate_t> bin_candidates;
-  std::unordered_set<uint64_t> correlated_edges;
+  flat_set<uint64_t> correlated_edges;
+  // decoded shape of the edge being projected onto, reused for every edge
+  shape_soa_t edge_shape;
   Reach reach_finder;
+  ReachCache* reach_cache;
+  BinIndex* bin_boxes;
 
   // keep track of edges whose reachability we've already computed
   // TODO: dont use pointers as keys, its safe for now but fancy caching one day could be bad
-  std::unordered_map<const DirectedEdge*, directed_reach> directed_reaches;
+  flat_map<const DirectedEdge*, directed_reach> directed_reaches;
 
   bin_handler_t(const std::vector<valhalla::baldr::Location>& locations,
                 valhalla::baldr::GraphReader& reader,
-                const std::shared_ptr<DynamicCost>& costing)
-      : reader(reader), costing(costing) {
+                const std::vector<std::shared_ptr<DynamicCost>>& costings,
+                ReachCache* reach_cache,
+                BinIndex* bin_index)
+      : reader(reader), costings(costings), costing(costings.front()), reach_cache(reach_cache),
+        bin_boxes(bin_index) {
     // get the unique set of input locations and the max reachability of them all
     std::unordered_set<Location> uniq_locations(locations.begin(), locations.end());
     pps.reserve(uniq_locations.size());
@@ -313,7 +324,7 @@ struct bin_handler_t {
                           GetOffsetForHeading(edge->classification(), edge->use()), edge->forward());
         auto layer = info.layer();
         // do we want this edge
-        if (costing->Allowed(edge, tile, kDisallowShortcut)) {
+        if (allowed(edge, tile)) {
           auto reach = get_reach(id, edge);
           PathLocation::PathEdge
               path_edge{id,   0, node_ll, distance, PathLocation::NONE, reach.outbound, reach.inbound,
@@ -332,7 +343,7 @@ struct bin_handler_t {
         if (!other_edge)
           continue;
 
-        if (costing->Allowed(other_edge, other_tile, kDisallowShortcut)) {
+        if (allowed(other_edge, other_tile)) {
           auto opp_angle = std::fmod(angle + 180.f, 360.f);
           auto reach = get_reach(other_id, other_edge);
           PathLocation::PathEdge path_edge{other_id,
@@ -422,7 +433,7 @@ struct bin_handler_t {
       graph_tile_ptr other_tile;
       auto opposing_edge_id = reader.GetOpposingEdgeId(candidate.edge_id, other_edge, other_tile);
 
-      if (other_edge && costing->Allowed(other_edge, other_tile, kDisallowShortcut)) {
+      if (other_edge && allowed(other_edge, other_tile)) {
         auto opp_angle = std::fmod(angle + 180.f, 360.f);
         reach = get_reach(opposing_edge_id, other_edge);
         PathLocation::PathEdge other_path_edge{opposing_edge_id, 1 - length_ratio, candidate.point,
@@ -439,18 +450,63 @@ struct bin_handler_t {
     }
   }
 
+  // whether any of the costings allows the edge
+  bool allowed(const DirectedEdge* edge, const graph_tile_ptr& tile) const {
+    for (const auto& c : costings) {
+      if (c->Allowed(edge, tile, kDisallowShortcut)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // the first of the costings which allows the edge, the reach is found with that one
+  const std::shared_ptr<DynamicCost>& reach_costing(const GraphId edge_id,
+                                                    const DirectedEdge* edge) const {
+    if (costings.size() > 1) {
+      const auto tile = reader.GetGraphTile(edge_id);
+      for (const auto& c : costings) {
+        if (tile && c->Allowed(edge, tile, kDisallowShortcut)) {
+          return c;
+        }
+      }
+    }
+    return costing;
+  }
+
   directed_reach get_reach(const GraphId edge_id, const DirectedEdge* edge) {
     // if its in cache return it
     auto itr = directed_reaches.find(edge);
     if (itr != directed_reaches.cend())
       return itr->second;
 
-    // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    auto reach = find_reach(edge_id, edge);
     directed_reaches[edge] = reach;
     return reach;
   }
 
+  // compute the reach or get it from the tiles or the cross request cache if we have one
+  directed_reach find_reach(const GraphId edge_id, const DirectedEdge* edge) {
+    directed_reach reach;
+    // the cache only has the reaches of the costing of the request, not those of edges which only
+    // another costing allows
+    const auto& reach_cost = reach_costing(edge_id, edge);
+    auto* cache = reach_cost == costing ? reach_cache : nullptr;
+    if (cache && cache->has_stored() &&
+        cache->find_stored(reader.GetGraphTile(edge_id), edge_id, max_reach_limit, reach))
+      return reach;
+    if (cache && cache->find(edge_id, max_reach_limit, reach))
+      return reach;
+    // notice we do both directions here because in the end we use this reach for all input locations
+    auto start = std::chrono::steady_clock::now();
+    reach = reach_finder(edge, edge_id, max_reach_limit, reader, reach_cost, kInbound | kOutbound);
+    if (cache) {
+      cache->add_expansion(std::chrono::steady_clock::now() - start);
+      cache->insert(edge_id, max_reach_limit, reach);
+    }
+    return reach;
+  }
+
   // do a mini network expansion or maybe not
   directed_reach check_reachability(std::vector<projector_wrapper>::iterator begin,
                                     std::vector<projector_wrapper>::iterator end,
@@ -479,8 +535,7 @@ struct bin_handler_t {
     if (!check)
       return {max_reach_limit, max_reach_limit};
 
-    // notice we do both directions here because in the end we use this reach for all input locations
-    auto reach = reach_finder(edge, edge_id, max_reach_limit, reader, costing, kInbound | kOutbound);
+    auto reach = find_reach(edge_id, edge);
     directed_reaches[edge] = reach;
 
     // if the inbound reach is not 0 and the outbound reach is not 0 and the opposing edge is not
@@ -488,19 +543,56 @@ struct bin_handler_t {
 
     const DirectedEdge* opp_edge = nullptr;
     if (reach.outbound > 0 && reach.inbound > 0 && (opp_edge = reader.GetOpposingEdge(edge, tile)) &&
-        costing->Allowed(opp_edge, tile, kDisallowShortcut)) {
+        allowed(opp_edge, tile)) {
       directed_reaches[opp_edge] = reach;
     }
     return reach;
   }
 
+  // whether an edge within the box could change what any of the candidates found so far. it cant
+  // when, for every one of them, the box is outside of the radius and further than its best
+  // reachable and unreachable findings and than the closest reachable one outside of the radius.
+  // when a location doesnt ask for any reach every edge is reachable for it so its unreachable
+  // findings dont matter
+  bool out_of_range(std::vector<projector_wrapper>::iterator begin,
+                    std::vector<projector_wrapper>::iterator end,
+                    const BinIndex::box_t& box) const {
+    for (auto p_itr = begin; p_itr != end; ++p_itr) {
+      if (p_itr->reachable.empty()) {
+        return false;
+      }
+      auto sq_distance =
+          p_itr->project.approx.DistanceSquared(box.closest(p_itr->location.latlng_));
+      if (sq_distance < p_itr->sq_radius || sq_distance < p_itr->reachable.back().sq_distance ||
+          sq_distance < p_itr->closest_external_reachable) {
+        return false;
+      }
+      if ((p_itr->location.min_outbound_reach_ || p_itr->location.min_inbound_reach_) &&
+          (p_itr->unreachable.empty() ||
+           sq_distance < p_itr->unreachable.back().sq_distance)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   // handle a bin for the range of candidates that share it
   void handle_bin(std::vector<projector_wrapper>::iterator begin,
                   std::vector<projector_wrapper>::iterator end) {
     // iterate over the edges in the bin
     auto tile = begin->cur_tile;
     auto edges = tile->GetBin(begin->bin_index);
-    for (auto edge_id : edges) {
+    // the boxes of the edges let us skip the ones which are too far away to matter
+    const auto* boxes = bin_boxes ? bin_boxes->get(tile, begin->bin_index, reader) : nullptr;
+    if (boxes && boxes->size() != edges.size()) {
+      boxes = nullptr;
+    }
+    for (size_t i = 0; i < edges.size(); ++i) {
+      auto edge_id = edges[i];
+      if (boxes && out_of_range(begin, end, (*boxes)[i])) {
+        continue;
+      }
+
       // get the tile and edge
       if (!reader.GetGraphTile(edge_id, tile)) {
         continue;
@@ -508,11 +600,11 @@ struct bin_handler_t {
 
       // if this edge is filtered
       const auto* edge = tile->directededge(edge_id);
-      if (!costing->Allowed(edge, tile, kDisallowShortcut)) {
+      if (!allowed(edge, tile)) {
         // then we try its opposing edge
         edge_id = reader.GetOpposingEdgeId(edge_id, edge, tile);
         // but if we couldnt get it or its filtered too then we move on
-        if (!edge_id.Is_Valid() || !costing->Allowed(edge, tile, kDisallowShortcut))
+        if (!edge_id.Is_Valid() || !allowed(edge, tile))
           continue;
       }
 
@@ -545,32 +637,18 @@ struct bin_handler_t {
 
       // get some shape of the edge
       auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge));
-      auto shape = edge_info->lazy_shape();
-      PointLL v;
-      if (!shape.empty()) {
-        v = shape.pop();
-      }
+      edge_shape.assign(reader.edge_shape(tile, edge));
 
-      // iterate along this edges segments projecting each of the points
-      for (size_t i = 0; !shape.empty(); ++i) {
-        auto u = v;
-        v = shape.pop();
-        // for each input point
+      // find the closest point along this edges segments for each of the input points
+      if (edge_shape.size() > 1) {
         c_itr = bin_candidates.begin();
         for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
           // skip updating this candidate because it was prefiltered
           if (c_itr->prefiltered) {
             continue;
           }
-          // how close is the input to this segment
-          auto point = p_itr->project(u, v);
-          auto sq_distance = p_itr->project.approx.DistanceSquared(point);
-          // do we want to keep it
-          if (sq_distance < c_itr->sq_distance) {
-            c_itr->sq_distance = sq_distance;
-            c_itr->point = std::move(point);
-            c_itr->index = i;
-          }
+          c_itr->index =
+              p_itr->project.closest_segment(edge_shape, c_itr->point, c_itr->sq_distance);
         }
       }
 
@@ -592,7 +670,7 @@ struct bin_handler_t {
         GraphId opp_edgeid;
         // it's possible that it isnt reachable but the opposing is, switch to that if so
         if (!reachable && (opp_edgeid = reader.GetOpposingEdgeId(edge_id, opp_edge, opp_tile)) &&
-            costing->Allowed(opp_edge, opp_tile, kDisallowShortcut)) {
+            allowed(opp_edge, opp_tile)) {
           auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge, opp_edgeid);
           if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
               opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
@@ -681,13 +759,17 @@ struct bin_handler_t {
   }
 
   // we keep the points sorted at each round such that unfinished ones
-  // are at the front of the sorted list
+  // are at the front of the sorted list. only the range we just handled moved to other bins so
+  // rather than sorting everything again we sort that range and merge it back in with its sorted
+  // neighbours, which keeps large batches (matrices, traces) linear per bin instead of n log n
   void search() {
     std::sort(pps.begin(), pps.end());
     while (pps.front().has_bin()) {
       auto range = find_best_range(pps);
       handle_bin(range.first, range.second);
-      std::sort(pps.begin(), pps.end());
+      std::sort(range.first, range.second);
+      std::inplace_merge(pps.begin(), range.first, range.second);
+      std::inplace_merge(pps.begin(), range.second, pps.end());
     }
   }
 
@@ -801,9 +883,22 @@ namespace loki {
 std::unordered_map<valhalla::baldr::Location, PathLocation>
 Search(const std::vector<valhalla::baldr::Location>& locations,
        GraphReader& reader,
-       const std::shared_ptr<DynamicCost>& costing) {
+       const std::shared_ptr<DynamicCost>& costing,
+       ReachCache* reach_cache,
+       BinIndex* bin_index) {
+  return Search(locations, reader, std::vector<std::shared_ptr<DynamicCost>>{costing}, reach_cache,
+                bin_index);
+}
+
+std::unordered_map<valhalla::baldr::Location, PathLocation>
+Search(const std::vector<valhalla::baldr::Location>& locations,
+       GraphReader& reader,
+       const std::vector<std::shared_ptr<DynamicCost>>& costings,
+       ReachCache* reach_cache,
+       BinIndex* bin_index) {
   // we cannot continue without costing
-  if (!costing)
+  if (costings.empty() ||
+      std::any_of(costings.begin(), costings.end(), [](const auto& c) { return !c; }))
     throw std::runtime_error("No costing was provided for edge candidate search");
 
   // trivially finished already
@@ -811,7 +906,7 @@ Search(const std::vector<valhalla::baldr::Location>& locations,
     return std::unordered_map<valhalla::baldr::Location, PathLocation>{};
 
   // setup the unique list of locations
-  bin_handler_t handler(locations, reader, costing);
+  bin_handler_t handler(locations, reader, costings, reach_cache, bin_index);
   // search over the bins doing multiple locations per bin
   handler.search();
   // turn each locations candidate set into path locations
@@ -55,6 +55,8 @@ void loki_worker_t::status(Api& request) const {
   if (!request.options().verbose() || !allow_verbose)
     return;
 
+  add_allocation_counters(*add_service_counters(request, service_name(), *reader));
+
   // get _some_ tile
   const static baldr::graph_tile_ptr tile = get_graphtile(reader);
 
@@ -2,7 +2,6 @@
 
 #include "baldr/connectivity_map.h"
 #include "loki/worker.h"
-#include "midgard/distanceapproximator.h"
 #include "tyr/serializers.h"
 
 using namespace valhalla;
@@ -25,23 +24,16 @@ std::string loki_worker_t::transit_available(Api& request) {
   init_transit_available(request);
   auto locations = PathLocation::fromPBF(request.options().locations());
   std::unordered_set<baldr::Location> found;
+  // without any transit tiles there are no stops to look for
+  const auto transit_level = TileHierarchy::GetTransitLevel().level;
+  if (connectivity_map && !connectivity_map->level_color_exists(transit_level))
+    return tyr::serializeTransitAvailable(request, locations, found);
+
   try {
-    const auto& tiles = TileHierarchy::levels().back().tiles;
-    for (const auto& location : locations) {
-      // Get a list of tiles required within the radius of the projected point
-      const auto& ll = location.latlng_;
-      DistanceApproximator<PointLL> approximator(ll);
-      double latdeg = double(location.radius_) / kMetersPerDegreeLat;
-      double lngdeg = location.radius_ / DistanceApproximator<PointLL>::MetersPerLngDegree(ll.lat());
-      AABB2<PointLL> bbox(Point2d(ll.lng() - lngdeg, ll.lat() - latdeg),
-                          Point2d(ll.lng() + lngdeg, ll.lat() + latdeg));
-      std::vector<int32_t> tilelist = tiles.TileList(bbox);
-      for (auto id : tilelist) {
-        // transit is level hierarchy level 3
-        auto color = connectivity_map->get_color(GraphId(id, 3, 0));
-        if (color != 0) {
-          found.emplace(location);
-        }
+    const auto has_stops = transit_stops.has_stops(locations, *reader);
+    for (size_t i = 0; i < locations.size(); ++i) {
+      if (has_stops[i]) {
+        found.emplace(locations[i]);
       }
     }
   } catch (const std::exception&) { throw valhalla_exception_t{170}; }
@@ -0,0 +1,83 @@
+#include "loki/transit_stop_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "baldr/tilehierarchy.h"
+#include "midgard/distanceapproximator.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::loki;
+
+namespace valhalla {
+namespace loki {
+
+const std::vector<TransitStopIndex::stop_t>& TransitStopIndex::get(const GraphId& tile_id,
+                                                                   GraphReader& reader) {
+  auto found = tiles_.find(tile_id.tileid());
+  if (found != tiles_.end())
+    return found->second;
+
+  // a tile which isn't there is remembered as one without stops
+  auto& stops = tiles_[tile_id.tileid()];
+  auto tile = reader.GetGraphTile(tile_id.Tile_Base());
+  if (!tile)
+    return stops;
+
+  const auto& base_ll = tile->header()->base_ll();
+  for (const auto& node : tile->GetNodes()) {
+    const auto type = node.type();
+    if (type == NodeType::kTransitEgress || type == NodeType::kTransitStation ||
+        type == NodeType::kMultiUseTransitPlatform) {
+      const auto ll = node.latlng(base_ll);
+      stops.push_back({static_cast<float>(ll.lat()), static_cast<float>(ll.lng())});
+    }
+  }
+  std::sort(stops.begin(), stops.end(),
+            [](const stop_t& a, const stop_t& b) { return a.lat < b.lat; });
+  stops.shrink_to_fit();
+  return stops;
+}
+
+std::vector<bool> TransitStopIndex::has_stops(const std::vector<baldr::Location>& locations,
+                                              GraphReader& reader) {
+  const auto& level = TileHierarchy::GetTransitLevel();
+  std::vector<bool> found(locations.size(), false);
+  for (size_t i = 0; i < locations.size(); ++i) {
+    const auto& ll = locations[i].latlng_;
+    const double radius = locations[i].radius_;
+
+    // without a radius any stop in the tile of the location will do
+    if (radius <= 0) {
+      const auto tile_id = level.tiles.TileId(ll);
+      found[i] = tile_id >= 0 && !get(GraphId(tile_id, level.level, 0), reader).empty();
+      continue;
+    }
+
+    // otherwise look through the stops in the latitude band of the radius in each tile it touches
+    DistanceApproximator<PointLL> approximator(ll);
+    const double latdeg = radius / kMetersPerDegreeLat;
+    const double lngdeg = radius / DistanceApproximator<PointLL>::MetersPerLngDegree(ll.lat());
+    const double max_distance = radius * radius;
+    AABB2<PointLL> bbox(ll.lng() - lngdeg, ll.lat() - latdeg, ll.lng() + lngdeg, ll.lat() + latdeg);
+    for (auto tile_id : level.tiles.TileList(bbox)) {
+      const auto& stops = get(GraphId(tile_id, level.level, 0), reader);
+      auto stop = std::lower_bound(stops.begin(), stops.end(), ll.lat() - latdeg,
+                                   [](const stop_t& s, double lat) { return s.lat < lat; });
+      for (; stop != stops.end() && stop->lat <= ll.lat() + latdeg; ++stop) {
+        if (std::abs(stop->lng - ll.lng()) <= lngdeg &&
+            approximator.DistanceSquared(PointLL(stop->lng, stop->lat)) <= max_distance) {
+          found[i] = true;
+          break;
+        }
+      }
+      if (found[i])
+        break;
+    }
+  }
+  return found;
+}
+
+} // namespace loki
+} // namespace valhalla
@@ -85,8 +85,8 @@ void loki_worker_t::parse_costing(Api& api, bool allow_none) {
   } catch (const std::runtime_error&) { throw valhalla_exception_t{125, "'" + costing_str + "'"}; }
 
   if (options.exclude_polygons_size()) {
-    const auto edges =
-        edges_in_rings(options.exclude_polygons(), *reader, costing, max_exclude_polygons_length);
+    const auto edges = edges_in_rings(options.exclude_polygons(), *reader, costing,
+                                      max_exclude_polygons_length, exclude_polygons_threads);
     auto& co = *options.mutable_costings()->find(options.costing_type())->second.mutable_options();
     for (const auto& edge_id : edges) {
       auto* avoid = co.add_exclude_edges();
@@ -147,6 +147,10 @@ void loki_worker_t::parse_costing(Api& api, bool allow_none) {
     options.set_alternates(max_alternates);
   if (options.action() == Options::trace_attributes && options.alternates() > max_trace_alternates)
     options.set_alternates(max_trace_alternates);
+
+  // bind the reach cache to this costing, after any traffic updates have cleared it
+  reader->PollTrafficUpdates();
+  reach_cache.use_costing(options, !reader->HasLiveTraffic());
 }
 
 loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
@@ -163,7 +167,10 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
       max_trace_shape(config.get<size_t>("service_limits.trace.max_shape")),
       sample(config.get<std::string>("additional_data.elevation", "")),
       max_elevation_shape(config.get<size_t>("service_limits.skadi.max_shape")),
-      min_resample(config.get<float>("service_limits.skadi.min_resample")) {
+      min_resample(config.get<float>("service_limits.skadi.min_resample")),
+      reach_cache(config.get<size_t>("loki.reach_cache_size", 65536)),
+      bin_index(config.get<size_t>("loki.bin_index_size", 1024)),
+      admission(config.get_child("loki.admission", boost::property_tree::ptree())) {
 
   // Keep a string noting which actions we support, throw if one isnt supported
   Options::Action action;
@@ -185,9 +192,10 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
     if (kv.first == "max_exclude_locations" || kv.first == "max_reachability" ||
         kv.first == "max_radius" || kv.first == "max_timedep_distance" ||
         kv.first == "max_timedep_distance_matrix" || kv.first == "max_alternates" ||
-        kv.first == "max_exclude_polygons_length" ||
+        kv.first == "max_exclude_polygons_length" || kv.first == "max_matrix_departure_times" ||
         kv.first == "max_distance_disable_hierarchy_culling" || kv.first == "skadi" ||
-        kv.first == "status") {
+        kv.first == "status" || kv.first == "max_expansion_edges" ||
+        kv.first == "max_comparisons") {
       continue;
     }
     if (kv.first != "trace") {
@@ -228,6 +236,7 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
 
   max_exclude_locations = config.get<size_t>("service_limits.max_exclude_locations");
   max_exclude_polygons_length = config.get<float>("service_limits.max_exclude_polygons_length");
+  exclude_polygons_threads = config.get<uint32_t>("loki.exclude_polygons_threads", 1);
   max_reachability = config.get<unsigned int>("service_limits.max_reachability");
   default_reachability = config.get<unsigned int>("loki.service_defaults.minimum_reachability");
   max_radius = config.get<unsigned int>("service_limits.max_radius");
@@ -245,28 +254,84 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
   max_trace_alternates = config.get<unsigned int>("service_limits.trace.max_alternates");
   max_trace_alternates_shape = config.get<size_t>("service_limits.trace.max_alternates_shape");
   max_alternates = config.get<unsigned int>("service_limits.max_alternates");
+  max_comparisons = config.get<size_t>("service_limits.max_comparisons", 4);
   allow_verbose = config.get<bool>("service_limits.status.allow_verbose", false);
   max_timedep_dist_matrix = config.get<size_t>("service_limits.max_timedep_distance_matrix", 0);
+  max_matrix_departure_times =
+      config.get<size_t>("service_limits.max_matrix_departure_times", 96);
   // assign max_distance_disable_hierarchy_culling
   max_distance_disable_hierarchy_culling =
       config.get<float>("service_limits.max_distance_disable_hierarchy_culling", 0.f);
 
+  // closures from live traffic change reachability so forget what we know when traffic changes
+  reader->AddTrafficObserver([this](const std::vector<GraphId>&) { reach_cache.clear(); });
+  // and what is derived from the tiles themselves once the reader switched to a replaced extract
+  reader->AddTrafficObserver([this](const std::vector<GraphId>& tile_ids) {
+    if (!tile_ids.empty()) {
+      return;
+    }
+    bin_index.clear();
+    transit_stops.clear();
+    if (connectivity_map) {
+      connectivity_map.reset(new connectivity_map_t(this->config.get_child("mjolnir"), reader));
+    }
+  });
+
+  // read the busy tiles before taking any traffic
+  warm_up(*reader, config, service_name());
+
   // signal that the worker started successfully
   started();
 }
 
 void loki_worker_t::cleanup() {
   service_worker_t::cleanup();
+  // in between requests is when a replaced extract can be switched to
+  reader->UpdateExtract();
   if (reader->OverCommitted()) {
     reader->Trim();
   }
 }
 
+void loki_worker_t::check_action(const Api& request) const {
+  if (actions.find(request.options().action()) == actions.cend()) {
+    throw valhalla_exception_t{106, action_str};
+  }
+}
+
+void loki_worker_t::admit(const Api& request) {
+  admission.admit(request.options());
+}
+
 void loki_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
   interrupt = interrupt_function;
   reader->SetInterrupt(interrupt);
 }
 
+std::unordered_map<baldr::Location, baldr::PathLocation>
+loki_worker_t::search(Api& request,
+                      const std::vector<baldr::Location>& locations,
+                      const std::vector<sif::cost_ptr_t>& comparisons) {
+  std::unordered_map<baldr::Location, baldr::PathLocation> projections;
+  {
+    auto _ = measure_phase(request, "loki.search");
+    if (comparisons.empty()) {
+      projections = loki::Search(locations, *reader, costing, &reach_cache, &bin_index);
+    } else {
+      std::vector<sif::cost_ptr_t> costings{costing};
+      costings.insert(costings.end(), comparisons.begin(), comparisons.end());
+      projections = loki::Search(locations, *reader, costings, &reach_cache, &bin_index);
+    }
+  }
+  // the reach expansions are part of the search but they are often what makes it slow
+  auto expansions = reach_cache.take_expansions();
+  if (expansions.first > 0) {
+    record_phase(request, "loki.reach", expansions.second);
+    record_phase_amount(request, "loki.reach", "expansions", expansions.first);
+  }
+  return projections;
+}
+
 // Check if total arc distance exceeds the max distance limit for disable_hierarchy_pruning.
 // If true, add a warning and set the disable_hierarchy_pruning costing option to false.
 void loki_worker_t::check_hierarchy_distance(Api& request) {
@@ -324,7 +389,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
   // grab the request info and make sure to record any metrics before we are done
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Loki Request " + std::to_string(info.id));
-  Api request;
+  Api& request = api_arena.next();
   prime_server::worker_t::result_t result{true, {}, ""};
   try {
     // request parsing
@@ -334,13 +399,12 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
     ParseApi(http_request, request);
     const auto& options = request.options();
 
-    // check there is a valid action
-    if (actions.find(options.action()) == actions.cend()) {
-      throw valhalla_exception_t{106, action_str};
-    }
+    // check there is a valid action and that the service has time for it
+    check_action(request);
+    admit(request);
 
-    // Set the interrupt function
-    service_worker_t::set_interrupt(&interrupt_function);
+    // Set the interrupt function, it also stops the request at its deadline
+    service_worker_t::set_interrupt(watch_deadline(request, &interrupt_function, 175));
     // do request specific processing
     switch (options.action()) {
       case Options::route:
@@ -27,6 +27,8 @@ public:
 
 private:
   baldr::GraphReader& reader_;
+  // decoded shape of the edge being projected onto, reused for every edge
+  mutable midgard::shape_soa_t shape_;
 };
 
 template <typename edgeid_iterator_t>
@@ -63,11 +65,12 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
     }
 
     // Get at the shape
-    auto shape = tile->edgeinfo(edge).lazy_shape();
+    const auto& shape = reader_.edge_shape(tile, edge);
     if (shape.empty()) {
       // Otherwise Project will fail
       continue;
     }
+    shape_.assign(shape);
 
     // Projection information
     midgard::PointLL point;
@@ -83,7 +86,7 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
 
     if (edge_included) {
       std::tie(point, sq_distance, segment, offset) =
-          helpers::Project(projector, shape, kSnapToNodeDistance);
+          helpers::Project(projector, shape_, kSnapToNodeDistance);
 
       if (sq_distance <= sq_search_radius) {
         const double dist = edge->forward() ? offset : 1.0 - offset;
@@ -103,7 +106,7 @@ CandidateCollector::WithinSquaredDistance(const midgard::PointLL& location,
       // No need to project again if we already did it above
       if (!edge_included) {
         std::tie(point, sq_distance, segment, offset) =
-            helpers::Project(projector, shape, kSnapToNodeDistance);
+            helpers::Project(projector, shape_, kSnapToNodeDistance);
       }
       if (sq_distance <= sq_search_radius) {
         const double dist = opp_edge->forward() ? offset : 1.0 - offset;
@@ -168,10 +171,49 @@ void IndexBin(const graph_tile_ptr& tile,
   }
 }
 
+size_t CandidateGridCache::key_hash_t::operator()(const key_t& key) const {
+  size_t seed = std::hash<int32_t>()(key.bin_id);
+  seed ^= std::hash<float>()(key.cell_width) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  seed ^= std::hash<float>()(key.cell_height) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+std::shared_ptr<const CandidateGridCache::grid_t>
+CandidateGridCache::Get(int32_t bin_id, float cell_width, float cell_height) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = grids_.find({bin_id, cell_width, cell_height});
+  return it == grids_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const CandidateGridCache::grid_t>
+CandidateGridCache::Put(int32_t bin_id,
+                        float cell_width,
+                        float cell_height,
+                        std::shared_ptr<const grid_t> grid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // grids that are still held by a query stay alive when we drop them here
+  if (grids_.size() >= max_size_) {
+    grids_.clear();
+  }
+  return grids_.emplace(key_t{bin_id, cell_width, cell_height}, std::move(grid)).first->second;
+}
+
+size_t CandidateGridCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return grids_.size();
+}
+
+void CandidateGridCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  grids_.clear();
+}
+
 CandidateGridQuery::CandidateGridQuery(baldr::GraphReader& reader,
                                        float cell_width,
-                                       float cell_height)
-    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_() {
+                                       float cell_height,
+                                       std::shared_ptr<CandidateGridCache> shared_cache)
+    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_(),
+      shared_cache_(std::move(shared_cache)) {
   bin_level_ = baldr::TileHierarchy::levels().back().level;
 }
 
@@ -184,7 +226,14 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   // Check if the bin is in the cache
   const auto it = grid_cache_.find(bin_id);
   if (it != grid_cache_.end()) {
-    return &(it->second);
+    return it->second.get();
+  }
+
+  // Some other query may have indexed it already
+  if (shared_cache_) {
+    if (auto grid = shared_cache_->Get(bin_id, cell_width_, cell_height_)) {
+      return grid_cache_.emplace(bin_id, std::move(grid)).first->second.get();
+    }
   }
 
   // Not in the cache. Get the tile and Index the bin within the tile.
@@ -202,11 +251,14 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   int32_t bin_col = rc.second % ndiv;
   int32_t bin_index = (bin_row * ndiv) + bin_col;
 
-  // Insert the bin into the cache and index the bin
-  const auto inserted =
-      grid_cache_.emplace(bin_id, grid_t(tile->BoundingBox(), cell_width_, cell_height_));
-  IndexBin(tile, bin_index, reader_, inserted.first->second);
-  return &(inserted.first->second);
+  // Index the bin and insert it into the cache
+  auto grid = std::make_shared<grid_t>(tile->BoundingBox(), cell_width_, cell_height_);
+  IndexBin(tile, bin_index, reader_, *grid);
+  std::shared_ptr<const grid_t> cached = std::move(grid);
+  if (shared_cache_) {
+    cached = shared_cache_->Put(bin_id, cell_width_, cell_height_, std::move(cached));
+  }
+  return grid_cache_.emplace(bin_id, std::move(cached)).first->second.get();
 }
 
 std::unordered_set<baldr::GraphId>
@@ -54,6 +54,7 @@ void Config::CandidateSearch::Read(const boost::property_tree::ptree& params) {
 
   ReadParamOptional(cache_size, params, "grid.cache_size");
   ReadParamOptional(grid_size, params, "grid.size");
+  ReadParamOptional(shared_grid_cache, params, "grid.shared_cache");
 }
 
 void Config::TransitionCost::Read(const boost::property_tree::ptree& params) {
@@ -83,6 +84,11 @@ void Config::TransitionCost::Read(const boost::property_tree::ptree& params) {
   if (const auto node = params.get_child_optional("customizable")) {
     is_turn_penalty_factor_customizable = FindValue(*node, "turn_penalty_factor");
   }
+
+  ReadParamOptional(route_cache_size, params, "route_cache.size");
+  ReadParamOptional(route_cache_distance, params, "route_cache.distance");
+  CHECK_THROWS(route_cache_distance > 0.f,
+               POSITIVE_VALUE_MSG(route_cache_distance, "route_cache.distance"));
 }
 
 void Config::EmissionCost::Read(const boost::property_tree::ptree& params) {
@@ -106,6 +112,13 @@ void Config::Routing::Read(const boost::property_tree::ptree& params) {
   if (const auto node = params.get_child_optional("customizable")) {
     is_interpolation_distance_customizable = FindValue(*node, "interpolation_distance");
   }
+
+  ReadParamOptional(max_online_lag, params, "default.max_online_lag");
+  CHECK_THROWS(max_online_lag > 0, POSITIVE_VALUE_MSG(max_online_lag, "max_online_lag"));
+
+  ReadParamOptional(beam_width, params, "default.beam_width");
+  ReadParamOptional(beam_cost, params, "default.beam_cost");
+  CHECK_THROWS(beam_cost >= 0.f, NONNEGATIVE_VALUE_MSG(beam_cost, "beam_cost"));
 }
 
 } // namespace meili
@@ -17,38 +17,36 @@ namespace helpers {
 // snapped point, squared distance, segment index, offset
 std::tuple<PointLL, double, typename std::vector<PointLL>::size_type, double>
 Project(const projector_t& p, Shape7Decoder<midgard::PointLL>& shape, double snap_distance) {
-  PointLL first_point(shape.pop());
+  shape_soa_t decoded;
+  decoded.decode(shape);
+  return Project(p, decoded, snap_distance);
+}
+
+// snapped point, squared distance, segment index, offset
+std::tuple<PointLL, double, typename std::vector<PointLL>::size_type, double>
+Project(const projector_t& p, shape_soa_t& shape, double snap_distance) {
+  const auto first_point = shape.point(0);
+  const auto last_point = shape.point(shape.size() - 1);
   auto closest_point = first_point;
-  auto closest_segment_point = first_point;
   double closest_distance = std::numeric_limits<double>::max();
   size_t closest_segment = 0;
+
+  // find the closest segment in one pass over all of them
+  if (shape.size() > 1) {
+    closest_segment = p.closest_segment(shape, closest_point, closest_distance);
+  }
+
+  // total edge length and the length up to the closest segment
   double closest_partial_length = 0.0;
   double total_length = 0.0;
-
-  // for each segment
-  auto u = first_point;
   size_t i = 0;
-  for (; !shape.empty(); ++i) {
-    // project a onto b where b is the origin vector representing this segment
-    // and a is the origin vector to the point we are projecting, (a.b/b.b)*b
-    auto v = shape.pop();
-
-    auto projection = p(u, v);
-
-    // check if this point is better
-    const auto distance = p.approx.DistanceSquared(projection);
-    if (distance < closest_distance) {
-      closest_point = std::move(projection);
-      closest_distance = distance;
-      closest_segment = i;
+  for (; i + 1 < shape.size(); ++i) {
+    if (i == closest_segment) {
       closest_partial_length = total_length;
-      closest_segment_point = u;
     }
-
-    // total edge length
-    total_length += u.Distance(v);
-    u = v;
+    total_length += shape.point(i).Distance(shape.point(i + 1));
   }
+  const auto closest_segment_point = shape.point(closest_segment);
 
   // percent_along is a double between 0 and 1 representing the location of
   // the closest point on LineString to the given Point, as a fraction
@@ -87,7 +85,7 @@ Project(const projector_t& p, Shape7Decoder<midgard::PointLL>& shape, double sna
     closest_segment = 0;
     percent_along = 0.f;
   } else if (total_length * (1.f - percent_along) <= snap_distance) {
-    closest_point = u;
+    closest_point = last_point;
     closest_distance = p.approx.DistanceSquared(closest_point);
     closest_segment = i - 1;
     percent_along = 1.f;
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include "meili/emission_cost_model.h"
 #include "meili/geometry_helpers.h"
@@ -6,6 +8,7 @@
 #include "meili/routing.h"
 #include "meili/transition_cost_model.h"
 #include "midgard/distanceapproximator.h"
+#include "midgard/tracepoints.h"
 #include "worker.h"
 
 #include <array>
@@ -456,6 +459,42 @@ std::vector<MatchResult> FindMatchResults(const MapMatcher& mapmatcher,
   return results;
 }
 
+// Put the interpolated results in between the results of the states they were interpolated from.
+// Only the results of the states before the end time are kept
+std::vector<MatchResult>
+MergeInterpolated(const MapMatcher& mapmatcher,
+                  const std::vector<StateId>& state_ids,
+                  const std::vector<MatchResult>& results,
+                  const std::unordered_map<StateId::Time, std::vector<Measurement>>& interpolated,
+                  StateId::Time end) {
+  std::vector<MatchResult> merged;
+  merged.reserve(end);
+  for (StateId::Time time = 0; time < end; time++) {
+    // Add in this states result
+    merged.emplace_back(results[time]);
+
+    // See if there were any interpolated points with this state move on if not
+    const auto it = interpolated.find(time);
+    if (it == interpolated.end()) {
+      continue;
+    }
+
+    // Interpolate the points between this and the next state
+    const auto& this_stateid = state_ids[time];
+    const auto& next_stateid = time + 1 < state_ids.size() ? state_ids[time + 1] : StateId();
+
+    const auto& first_result = results[time];
+    const auto& last_result = results[time + 1];
+    const auto interpolated_results =
+        InterpolateMeasurements(mapmatcher, it->second, this_stateid, next_stateid, first_result,
+                                last_result);
+
+    // Copy the interpolated match results into the final set
+    merged.insert(merged.cend(), interpolated_results.cbegin(), interpolated_results.cend());
+  }
+  return merged;
+}
+
 struct path_t {
   path_t(const std::vector<EdgeSegment>& segments) {
     edges.reserve(segments.size());
@@ -492,7 +531,9 @@ MapMatcher::MapMatcher(const Config& config,
                        baldr::GraphReader& graphreader,
                        CandidateQuery& candidatequery,
                        const sif::mode_costing_t& mode_costing,
-                       sif::TravelMode travelmode)
+                       sif::TravelMode travelmode,
+                       RouteCache* route_cache,
+                       size_t costing_key)
     : config_(config), graphreader_(graphreader), candidatequery_(candidatequery),
       mode_costing_(mode_costing), travelmode_(travelmode), interrupt_(nullptr), vs_(), ts_(vs_),
       container_(), emission_cost_model_(graphreader_, container_, config_.emission_cost),
@@ -502,9 +543,12 @@ MapMatcher::MapMatcher(const Config& config,
                              container_,
                              mode_costing_,
                              travelmode_,
-                             config_.transition_cost) {
+                             config_.transition_cost,
+                             route_cache,
+                             costing_key) {
   vs_.set_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
+  vs_.set_beam(config_.routing.beam_width, config_.routing.beam_cost);
 }
 
 MapMatcher::~MapMatcher() {
@@ -512,11 +556,13 @@ MapMatcher::~MapMatcher() {
 
 void MapMatcher::Clear() {
   vs_.Clear();
+  transition_cost_model_.Clear();
   // reset cost models because they were possibly replaced by topk
   vs_.set_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
   ts_.Clear();
   container_.Clear();
+  online_interpolated_.clear();
 }
 
 void MapMatcher::RemoveRedundancies(const std::vector<StateId>& result,
@@ -706,85 +752,69 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   bool found_discontinuity = false;
 
   // Separate the measurements we are using for matching from the ones we'll just interpolate
-  auto interpolated = AppendMeasurements(measurements);
+  interpolated_t interpolated;
+  AppendMeasurements(measurements, interpolated, true);
   // Without minimum number of edge candidates, throw a 443 - NoSegment error code.
   if (!container_.HasMinimumCandidates()) {
     throw valhalla_exception_t{443};
   }
 
-  // For k paths
+  // For k paths, the alternatives are ranked once we have the best one
   std::vector<StateId> state_ids;
   state_ids.reserve(container_.size());
+  std::vector<StateId> original_state_ids;
+  std::unique_ptr<ListViterbiSearch> alternatives;
   while (best_paths.size() < k && !found_discontinuity) {
-    // Get the states for the kth best path in reversed order then fix the order
-    state_ids.clear();
     double accumulated_cost = 0.f;
-    while (state_ids.size() < container_.size()) {
-      // Get the time at the last column of states
-      const auto time = container_.size() - state_ids.size() - 1;
-      // Find the most probable path
-      std::copy(vs_.SearchPathVS(time, false), vs_.PathEnd(), std::back_inserter(state_ids));
-      // See what the last state was that we reached
-      const auto& winner = vs_.SearchWinner(time);
-      // If we got all the way to the end there were no discontinuities and the cost is a normal value
-      if (winner.IsValid()) {
-        accumulated_cost += vs_.AccumulatedCost(winner);
-      } // We got a discontinuity before reaching the last state
-      else {
-        // TODO need a sane constant cost for invalid state
-        accumulated_cost += MAX_ACCUMULATED_COST;
-        found_discontinuity = true;
-      }
+    if (!alternatives) {
+      // Get the states for the best path in reversed order then fix the order
+      state_ids.clear();
+      while (state_ids.size() < container_.size()) {
+        // Get the time at the last column of states
+        const auto time = container_.size() - state_ids.size() - 1;
+        // Find the most probable path
+        std::copy(vs_.SearchPathVS(time, false), vs_.PathEnd(), std::back_inserter(state_ids));
+        // See what the last state was that we reached
+        const auto& winner = vs_.SearchWinner(time);
+        // If we got all the way to the end there were no discontinuities and the cost is a normal
+        // value
+        if (winner.IsValid()) {
+          accumulated_cost += vs_.AccumulatedCost(winner);
+        } // We got a discontinuity before reaching the last state
+        else {
+          // TODO need a sane constant cost for invalid state
+          accumulated_cost += MAX_ACCUMULATED_COST;
+          found_discontinuity = true;
+        }
 
-      // if we need to match more we add a penalty for connecting over the discontinuity
-      if (state_ids.size() < container_.size()) {
-        found_discontinuity = true;
-        accumulated_cost += MAX_ACCUMULATED_COST;
+        // if we need to match more we add a penalty for connecting over the discontinuity
+        if (state_ids.size() < container_.size()) {
+          found_discontinuity = true;
+          accumulated_cost += MAX_ACCUMULATED_COST;
+        }
+      }
+      original_state_ids.assign(state_ids.rbegin(), state_ids.rend());
+    } else {
+      // The next best path other than the best one which doesnt use any of the states removed
+      // since the ranking started. Without one any other path would have to break so we dont
+      // return it as an alternative
+      do {
+        accumulated_cost = alternatives->Next(original_state_ids);
+      } while (0 <= accumulated_cost &&
+               (original_state_ids == state_ids ||
+                std::any_of(original_state_ids.begin(), original_state_ids.end(),
+                            [this](const StateId& stateid) { return ts_.IsRemoved(stateid); })));
+      if (accumulated_cost < 0) {
+        break;
       }
-    }
-
-    // we dont return additional paths (alternatives) if the have discontinuities
-    if (!best_paths.empty() && found_discontinuity) {
-      break;
-    }
-
-    // Get back the real state ids in order
-    std::vector<StateId> original_state_ids;
-    original_state_ids.reserve(state_ids.size());
-    for (auto s_itr = state_ids.rbegin(); s_itr != state_ids.rend(); ++s_itr) {
-      original_state_ids.push_back(ts_.GetOrigin(*s_itr, *s_itr));
     }
 
     // Get the match result for each of the states
     auto results = FindMatchResults(*this, original_state_ids, graphreader_);
 
     // Insert the interpolated results into the result list
-    std::vector<MatchResult> best_path;
-    best_path.reserve(measurements.size());
-    for (StateId::Time time = 0; time < original_state_ids.size(); time++) {
-      // Add in this states result
-      best_path.emplace_back(results[time]);
-
-      // See if there were any interpolated points with this state move on if not
-      const auto it = interpolated.find(time);
-      if (it == interpolated.end()) {
-        continue;
-      }
-
-      // Interpolate the points between this and the next state
-      const auto& this_stateid = original_state_ids[time];
-      const auto& next_stateid =
-          time + 1 < original_state_ids.size() ? original_state_ids[time + 1] : StateId();
-
-      const auto& first_result = results[time];
-      const auto& last_result = results[time + 1];
-      const auto interpolated_results =
-          InterpolateMeasurements(*this, it->second, this_stateid, next_stateid, first_result,
-                                  last_result);
-
-      // Copy the interpolated match results into the final set
-      best_path.insert(best_path.cend(), interpolated_results.cbegin(), interpolated_results.cend());
-    }
+    auto best_path = MergeInterpolated(*this, original_state_ids, results, interpolated,
+                                       original_state_ids.size());
 
     // Construct a result
     auto segments = ConstructRoute(*this, best_path);
@@ -804,10 +834,21 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
     if (!found_discontinuity && best_paths.size() < k) {
       // Remove all the candidates pairs whose paths are redundant with this one
       RemoveRedundancies(original_state_ids, results);
-      // Remove this particular sequence of stateids
-      ts_.RemovePath(state_ids);
-      // Prepare for a fresh search in the next search iteration
-      vs_.ClearSearch();
+      // Rank the paths over the states that are left, this routes nothing new since the above
+      // routed every state that is left
+      if (!alternatives) {
+        state_ids = original_state_ids;
+        std::vector<std::vector<StateId>> columns(container_.size());
+        for (StateId::Time time = 0; time < container_.size(); ++time) {
+          for (const auto& state : container_.column(time)) {
+            if (!ts_.IsRemoved(state.stateid())) {
+              columns[time].push_back(state.stateid());
+            }
+          }
+        }
+        alternatives.reset(new ListViterbiSearch(columns, vs_.emission_cost_model(),
+                                                 vs_.transition_cost_model()));
+      }
     }
   }
 
@@ -820,37 +861,155 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
   return best_paths;
 }
 
-std::unordered_map<StateId::Time, std::vector<Measurement>>
-MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
+std::vector<MatchResult> MapMatcher::OnlineMatch(const std::vector<Measurement>& measurements) {
+  // Nothing to do
+  if (measurements.empty()) {
+    return {};
+  }
+
+  // We dont know which measurement will be the last so we cant force matching it here
+  AppendMeasurements(measurements, online_interpolated_, false);
+
+  // Extend the search to the new columns and see how far back the paths agree
+  const auto last_time = container_.size() - 1;
+  vs_.SearchWinner(last_time);
+  auto stateid = vs_.ConvergedStateId();
+  auto time = stateid.IsValid() ? stateid.time() : 0;
+
+  // If they disagree for too long we settle on the best path so far to keep the memory bounded
+  const auto max_lag = config_.routing.max_online_lag;
+  if (max_lag < last_time - time) {
+    time = last_time - max_lag / 2;
+    auto state_itr = vs_.SearchPathVS(last_time);
+    for (auto t = last_time; t > time; --t) {
+      ++state_itr;
+    }
+    stateid = *state_itr;
+  }
+
+  // Nothing became final
+  if (time == 0) {
+    return {};
+  }
+
+  // Get the path up to the converged state, the results before it are final. The result of the
+  // converged state itself depends on the path after it so it will come with a later chunk
+  std::vector<StateId> state_ids;
+  std::copy(StateIdIterator(vs_, time, stateid), vs_.PathEnd(), std::back_inserter(state_ids));
+  std::reverse(state_ids.begin(), state_ids.end());
+  const auto results = FindMatchResults(*this, state_ids, graphreader_);
+  auto finished = MergeInterpolated(*this, state_ids, results, online_interpolated_, time);
+
+  // Forget everything before the converged state
+  RestartOnlineMatch(time, stateid);
+  return finished;
+}
+
+std::vector<MatchResult> MapMatcher::FinishOnlineMatch() {
+  // Nothing to do
+  if (container_.size() == 0) {
+    Clear();
+    return {};
+  }
+
+  // Like the offline match the last measurement is always matched rather than interpolated
+  auto found = online_interpolated_.find(container_.size() - 1);
+  if (found != online_interpolated_.end() && !found->second.empty()) {
+    std::vector<Measurement> last{found->second.back()};
+    found->second.pop_back();
+    AppendMeasurements(last, online_interpolated_, true);
+  }
+
+  // Everything that is left is final now
+  std::vector<StateId> state_ids;
+  std::copy(vs_.SearchPathVS(container_.size() - 1), vs_.PathEnd(), std::back_inserter(state_ids));
+  std::reverse(state_ids.begin(), state_ids.end());
+  const auto results = FindMatchResults(*this, state_ids, graphreader_);
+  auto finished =
+      MergeInterpolated(*this, state_ids, results, online_interpolated_, state_ids.size());
+
+  Clear();
+  return finished;
+}
+
+void MapMatcher::RestartOnlineMatch(StateId::Time time, const StateId& stateid) {
+  // Keep what we need of the columns that aren't final yet
+  std::vector<Measurement> measurements;
+  std::vector<double> leave_times;
+  std::vector<std::vector<baldr::PathLocation>> candidates;
+  for (auto t = time; t < container_.size(); ++t) {
+    measurements.push_back(container_.measurement(t));
+    leave_times.push_back(container_.leave_time(t));
+    candidates.emplace_back();
+    for (const auto& state : container_.column(t)) {
+      // The converged state is the only one left in its column
+      if (t != time || state.stateid() == stateid) {
+        candidates.back().push_back(state.candidate());
+      }
+    }
+  }
+  interpolated_t interpolated;
+  for (auto& measurements : online_interpolated_) {
+    if (time <= measurements.first) {
+      interpolated.emplace(measurements.first - time, std::move(measurements.second));
+    }
+  }
+
+  // Start over with the converged state as the first one. The search from it is the same as the
+  // one before, except the first route out of it doesnt know how we got to it
+  Clear();
+  for (size_t i = 0; i < measurements.size(); ++i) {
+    const auto t = container_.AppendMeasurement(measurements[i]);
+    container_.SetMeasurementLeaveTime(t, leave_times[i]);
+    for (const auto& candidate : candidates[i]) {
+      vs_.AddStateId(container_.AppendCandidate(candidate));
+    }
+  }
+  online_interpolated_ = std::move(interpolated);
+}
+
+void MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements,
+                                    interpolated_t& interpolated,
+                                    bool match_last) {
+  if (measurements.empty()) {
+    return;
+  }
+
   const float sq_max_search_radius = config_.candidate_search.max_search_radius_meters *
                                      config_.candidate_search.max_search_radius_meters;
   const float sq_interpolation_distance =
       config_.routing.interpolation_distance_meters * config_.routing.interpolation_distance_meters;
-  std::unordered_map<StateId::Time, std::vector<Measurement>> interpolated;
-
-  // Always match the first measurement
-  auto last = measurements.cbegin();
-  auto time = AppendMeasurement(*last, sq_max_search_radius);
-  double interpolated_epoch_time = -1;
-  for (auto m = std::next(last); m != measurements.end(); ++m) {
-    const auto sq_distance = GreatCircleDistanceSquared(*last, *m);
+
+  // Always match the first measurement unless we are continuing from the last one we matched
+  auto m = measurements.cbegin();
+  if (container_.size() == 0) {
+    AppendMeasurement(*m++, sq_max_search_radius);
+  }
+  auto time = container_.size() - 1;
+  auto last = container_.measurement(time);
+  const auto found = interpolated.find(time);
+  double interpolated_epoch_time =
+      found == interpolated.cend() || found->second.empty() ? -1 : found->second.back().epoch_time();
+  for (; m != measurements.end(); ++m) {
+    const auto sq_distance = GreatCircleDistanceSquared(last, *m);
     // Always match the last measurement and if its far enough away
-    if (sq_interpolation_distance < sq_distance || std::next(m) == measurements.end()) {
+    if (sq_interpolation_distance < sq_distance ||
+        (match_last && std::next(m) == measurements.end())) {
       // If there were interpolated points between these two points with time information
       if (interpolated_epoch_time != -1) {
         // Project the last interpolated point onto the line between the two match points
-        auto p = interpolated[time].back().lnglat().Project(last->lnglat(), m->lnglat());
+        auto p = interpolated[time].back().lnglat().Project(last.lnglat(), m->lnglat());
         // If its significantly closer to the previous match point then it looks like the trace
         // lingered so we use the time information of the last interpolation point as the actual
         // time they started traveling towards the next match point which will help us determine
         // what paths are really likely
-        if (p.Distance(last->lnglat()) / last->lnglat().Distance(m->lnglat()) < .2f) {
+        if (p.Distance(last.lnglat()) / last.lnglat().Distance(m->lnglat()) < .2f) {
           container_.SetMeasurementLeaveTime(time, interpolated_epoch_time);
         }
       }
       // This one isnt interpolated so we make room for its state
       time = AppendMeasurement(*m, sq_max_search_radius);
-      last = m;
+      last = *m;
       interpolated_epoch_time = -1;
     } // TODO: if its the last measurement and it wants to be interpolated
     // then what we need to do is make last match interpolated
@@ -862,8 +1021,6 @@ MapMatcher::AppendMeasurements(const std::vector<Measurement>& measurements) {
       interpolated_epoch_time = m->epoch_time();
     }
   }
-
-  return interpolated;
 }
 
 StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
@@ -880,6 +1037,7 @@ StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
       candidatequery_.Query(measurement.lnglat(), measurement.stop_type(), sq_radius, costing());
 
   const auto time = container_.AppendMeasurement(measurement);
+  VALHALLA_TRACE(map_match_column, time, candidates.size());
 
   for (const auto& candidate : candidates) {
     const auto& stateid = container_.AppendCandidate(candidate);
@@ -889,5 +1047,71 @@ StateId::Time MapMatcher::AppendMeasurement(const Measurement& measurement,
   return time;
 }
 
+std::vector<size_t> FindBreakages(const Config& config,
+                                  const std::vector<Measurement>& measurements) {
+  // No route between the candidates of two measurements can be shorter than the distance between
+  // the measurements less the search radius on either side, with some room for the approximations
+  const float sq_interpolation_distance =
+      config.routing.interpolation_distance_meters * config.routing.interpolation_distance_meters;
+  const float breakage = (config.transition_cost.breakage_distance_meters +
+                          2.f * config.candidate_search.max_search_radius_meters) *
+                         1.1f;
+  const float sq_breakage = breakage * breakage;
+
+  // Follow which measurements AppendMeasurements would match, a cut goes between two matched
+  // measurements in a row which are too far apart for a route. Every part needs at least two
+  // matched measurements to be matched on its own
+  std::vector<size_t> firsts{0};
+  size_t last = 0, first_column = 0, column = 0;
+  for (size_t i = 1; i < measurements.size(); ++i) {
+    const auto sq_distance = GreatCircleDistanceSquared(measurements[last], measurements[i]);
+    if (!(sq_interpolation_distance < sq_distance) && i + 1 < measurements.size()) {
+      continue;
+    }
+    ++column;
+    if (last + 1 == i && sq_breakage < sq_distance && column - first_column > 1) {
+      firsts.push_back(i);
+      first_column = column;
+    }
+    last = i;
+  }
+  // The last part may have come up short
+  if (firsts.size() > 1 && column - first_column < 1) {
+    firsts.pop_back();
+  }
+  return firsts;
+}
+
+MatchResults JoinMatchResults(std::vector<MatchResults>&& parts) {
+  std::vector<MatchResult> results;
+  std::vector<EdgeSegment> segments;
+  double score = 0;
+  for (auto& part : parts) {
+    // Like OfflineMatch we add the penalty for connecting over the discontinuity and mark that the
+    // route breaks off there
+    if (!results.empty()) {
+      score += MAX_ACCUMULATED_COST;
+      if (!segments.empty()) {
+        segments.back().discontinuity = true;
+      }
+    }
+    score += part.score;
+
+    // The segments point at the results by their index in the whole trace
+    const int offset = static_cast<int>(results.size());
+    for (auto& segment : part.segments) {
+      if (segment.first_match_idx != -1) {
+        segment.first_match_idx += offset;
+      }
+      if (segment.last_match_idx != -1) {
+        segment.last_match_idx += offset;
+      }
+      segments.push_back(segment);
+    }
+    results.insert(results.end(), part.results.begin(), part.results.end());
+  }
+  return {std::move(results), std::move(segments), static_cast<float>(score)};
+}
+
 } // namespace meili
 } // namespace valhalla
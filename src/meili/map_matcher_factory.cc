@@ -1,7 +1,9 @@
+#include <mutex>
 #include <string>
 
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
+#include "midgard/util.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/costconstants.h"
@@ -10,6 +12,7 @@
 
 #include "meili/candidate_search.h"
 #include "meili/map_matcher.h"
+#include "meili/route_cache.h"
 
 #include "meili/map_matcher_factory.h"
 
@@ -20,6 +23,17 @@ inline float local_tile_size() {
   return tiles.TileSize();
 }
 
+// One grid cache for the whole process, it is sized by whichever factory asks for it first
+std::shared_ptr<valhalla::meili::CandidateGridCache> global_grid_cache(size_t max_size) {
+  static std::shared_ptr<valhalla::meili::CandidateGridCache> cache;
+  static std::mutex cache_mutex;
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (!cache) {
+    cache = std::make_shared<valhalla::meili::CandidateGridCache>(max_size);
+  }
+  return cache;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -30,9 +44,24 @@ MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root,
     : config_(root.get_child("meili")), graphreader_(graph_reader) {
   if (!graphreader_)
     graphreader_.reset(new baldr::GraphReader(root.get_child("mjolnir")));
+  std::shared_ptr<CandidateGridCache> grid_cache;
+  if (config_.candidate_search.shared_grid_cache) {
+    grid_cache = global_grid_cache(config_.candidate_search.cache_size);
+  }
   candidatequery_.reset(
       new CandidateGridQuery(*graphreader_, local_tile_size() / config_.candidate_search.grid_size,
-                             local_tile_size() / config_.candidate_search.grid_size));
+                             local_tile_size() / config_.candidate_search.grid_size, grid_cache));
+
+  // live traffic changes the times of the paths in the trees
+  if (config_.transition_cost.route_cache_size) {
+    route_cache_ = std::make_shared<RouteCache>(config_.transition_cost.route_cache_size,
+                                                config_.transition_cost.route_cache_distance);
+    std::weak_ptr<RouteCache> route_cache = route_cache_;
+    graphreader_->AddTrafficObserver([route_cache](const std::vector<baldr::GraphId>&) {
+      if (auto cache = route_cache.lock())
+        cache->clear();
+    });
+  }
 }
 
 MapMatcherFactory::~MapMatcherFactory() {
@@ -47,8 +76,23 @@ MapMatcher* MapMatcherFactory::Create(const Options& options) {
 
   mode_costing_[static_cast<uint32_t>(mode)] = cost;
 
+  // The trees in the route cache are only good for the costing and turn penalty they were built
+  // with. Check for traffic updates which make them stale
+  size_t costing_key = 0;
+  if (route_cache_) {
+    const auto costing = options.costings().find(options.costing_type());
+    costing_key = std::hash<std::string>{}(
+        costing != options.costings().end() ? costing->second.SerializeAsString() : "");
+    midgard::hash_combine(costing_key, static_cast<int>(options.costing_type()));
+    midgard::hash_combine(costing_key, config.transition_cost.turn_penalty_factor);
+    if (graphreader_->HasLiveTraffic()) {
+      graphreader_->PollTrafficUpdates();
+    }
+  }
+
   // TODO investigate exception safety
-  return new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode);
+  return new MapMatcher(config, *graphreader_, *candidatequery_, mode_costing_, mode,
+                        route_cache_.get(), costing_key);
 }
 
 Config MapMatcherFactory::MergeConfig(const Options& options) const {
@@ -92,6 +136,9 @@ void MapMatcherFactory::ClearFullCache() {
 void MapMatcherFactory::ClearCache() {
   graphreader_->Clear();
   candidatequery_->Clear();
+  if (route_cache_) {
+    route_cache_->clear();
+  }
 }
 
 } // namespace meili
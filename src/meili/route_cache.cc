@@ -0,0 +1,36 @@
+#include "meili/route_cache.h"
+
+namespace valhalla {
+namespace meili {
+
+route_tree_ptr_t RouteCache::find(size_t costing, const baldr::GraphId& edgeid, bool& build) {
+  auto trees = trees_.find(costing);
+  if (trees != trees_.end()) {
+    auto found = trees->second.find(edgeid.value);
+    if (found != trees->second.end()) {
+      build = !found->second;
+      return found->second;
+    }
+  }
+
+  // the first time the edge is asked for just remember it
+  if (size_ >= max_size_) {
+    clear();
+  }
+  trees_[costing].emplace(edgeid.value, nullptr);
+  ++size_;
+  build = false;
+  return nullptr;
+}
+
+void RouteCache::put(size_t costing, route_tree_ptr_t tree) {
+  auto inserted = trees_[costing].emplace(tree->edgeid.value, tree);
+  if (inserted.second) {
+    ++size_;
+  } else {
+    inserted.first->second = std::move(tree);
+  }
+}
+
+} // namespace meili
+} // namespace valhalla
@@ -1,3 +1,4 @@
+#include <limits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -400,8 +401,10 @@ find_shortest_path(baldr::GraphReader& reader,
     baldr::GraphId edgeid = {node.tileid(), node.level(), nodeinfo->edge_index()};
     const baldr::DirectedEdge* directededge = tile->directededge(edgeid);
     for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid) {
-      // Skip it if its a shortcut or transit connection
-      if (directededge->is_shortcut() || directededge->use() == baldr::Use::kTransitConnection) {
+      // Skip it if its a shortcut or transit connection, without touching the whole edge when
+      // the tile has the hot directed edges
+      const auto hot = tile->hot_directededge(edgeid.id());
+      if (hot.is_shortcut() || hot.use() == baldr::Use::kTransitConnection) {
         continue;
       }
 
@@ -476,6 +479,9 @@ find_shortest_path(baldr::GraphReader& reader,
   // Load destinations
   set_destinations(reader, destinations, node_dests, edge_dests);
 
+  // With nothing to look for but the origin the search runs until it settles everything in reach
+  const bool exhaust = destinations.size() == 1;
+
   // TODO: use faster unordered_map impl like matrix PR does
   std::unordered_map<uint16_t, uint32_t> results;
   while (true) {
@@ -502,7 +508,7 @@ find_shortest_path(baldr::GraphReader& reader,
       }
 
       // Congrats!
-      if (node_dests.empty() && edge_dests.empty()) {
+      if (!exhaust && node_dests.empty() && edge_dests.empty()) {
         LOG_TRACE("The last node destination was found");
         break;
       }
@@ -526,7 +532,7 @@ find_shortest_path(baldr::GraphReader& reader,
       }
 
       // Congrats!
-      if (edge_dests.empty() && node_dests.empty()) {
+      if (!exhaust && edge_dests.empty() && node_dests.empty()) {
         LOG_TRACE("The last edge destination was found");
         break;
       }
@@ -617,6 +623,267 @@ find_shortest_path(baldr::GraphReader& reader,
   return results;
 }
 
+// Where along their edge the trees start, right at the beginning the origin would be the node
+constexpr double kTreeOrigin = std::numeric_limits<double>::denorm_min();
+
+route_tree_ptr_t build_route_tree(baldr::GraphReader& reader,
+                                  const baldr::GraphId& edgeid,
+                                  const sif::cost_ptr_t& costing,
+                                  const float turn_cost_table[181],
+                                  const float max_dist) {
+  auto tree = std::make_shared<RouteTree>();
+  tree->edgeid = edgeid;
+  tree->distance = max_dist;
+  tree->labelset = std::make_shared<LabelSet>(max_dist);
+
+  // There is nothing to head for so there is no heuristic either
+  baldr::PathLocation origin(baldr::Location({0., 0.}));
+  origin.edges.emplace_back(edgeid, kTreeOrigin, midgard::PointLL{0., 0.}, 0.);
+  const midgard::DistanceApproximator<midgard::PointLL> approximator(midgard::PointLL{0., 0.});
+  find_shortest_path(reader, {origin}, 0, tree->labelset, approximator,
+                     std::numeric_limits<float>::infinity(), costing, nullptr, turn_cost_table,
+                     max_dist, -1.f);
+
+  // A label is updated in place when a node is reached more cheaply so each node has one
+  for (uint32_t label_idx = 0; label_idx < tree->labelset->size(); ++label_idx) {
+    const auto& label = tree->labelset->label(label_idx);
+    if (label.nodeid().Is_Valid()) {
+      tree->nodes.emplace(label.nodeid(), label_idx);
+    }
+  }
+  return tree;
+}
+
+bool find_shortest_path_in_trees(
+    baldr::GraphReader& reader,
+    const std::vector<baldr::PathLocation>& destinations,
+    labelset_ptr_t labelset,
+    const sif::cost_ptr_t& costing,
+    const Label* edgelabel,
+    const float turn_cost_table[181],
+    const float max_dist,
+    const float max_time,
+    const std::function<route_tree_ptr_t(const baldr::GraphId&)>& get_tree,
+    std::unordered_map<uint16_t, uint32_t>& results) {
+  const sif::TravelMode travelmode = costing->travel_mode();
+  const auto& origin = destinations.front();
+
+  // The label the search would start from
+  Label origin_label = edgelabel ? *edgelabel : Label();
+  origin_label.InitAsOrigin(travelmode, 0, {});
+  const bool allows_immediate_uturn = origin.stoptype_ == baldr::Location::StopType::BREAK ||
+                                      origin.stoptype_ == baldr::Location::StopType::VIA;
+
+  // The origin edges the search would leave on along with their trees. The labels of a tree are
+  // from the beginning of the edge so the part of the edge before the origin comes off their cost
+  struct start_t {
+    const baldr::PathLocation::PathEdge* edge;
+    const baldr::DirectedEdge* directededge;
+    sif::Cost edge_cost;
+    sif::Cost offset;
+    route_tree_ptr_t tree;
+    std::unordered_map<uint32_t, uint32_t> copied;
+  };
+  std::vector<start_t> starts;
+  starts.reserve(origin.edges.size());
+  for (const auto& origin_edge : origin.edges) {
+    // From a node the search goes out on every edge, not just the ones of the trees
+    if (origin_edge.begin_node() || origin_edge.end_node()) {
+      return false;
+    }
+
+    // Skip the edges the search would skip
+    graph_tile_ptr tile;
+    const auto* directededge = reader.directededge(origin_edge.id, tile);
+    uint8_t restriction_idx = -1;
+    if (!directededge || !IsEdgeAllowed(directededge, origin_edge.id, costing, origin_label, tile,
+                                        restriction_idx)) {
+      continue;
+    }
+    if (!allows_immediate_uturn && origin_label.edgeid().Is_Valid() &&
+        origin_label.edgeid() != origin_edge.id &&
+        origin_label.opp_local_idx() == directededge->localedgeidx()) {
+      continue;
+    }
+
+    // A restriction which is under way goes on past the origin but the tree knows nothing of it
+    if (restriction_idx != static_cast<uint8_t>(-1)) {
+      return false;
+    }
+
+    auto tree = get_tree(origin_edge.id);
+    if (!tree) {
+      return false;
+    }
+
+    // The tree has to reach as far as the search would go from this far along the edge
+    const sif::Cost edge_cost(directededge->length(), costing->EdgeCost(directededge, tile).secs);
+    const auto offset = edge_cost * origin_edge.percent_along;
+    if (max_dist + offset.cost > tree->distance) {
+      return false;
+    }
+
+    // And it has to have left the edge the way the search would
+    const auto end_node = tree->nodes.find(directededge->endnode());
+    if (end_node == tree->nodes.cend()
+            ? directededge->length() < tree->distance
+            : tree->labelset->label(end_node->second).restriction_idx() != restriction_idx) {
+      return false;
+    }
+
+    starts.push_back({&origin_edge, directededge, edge_cost, offset, std::move(tree), {}});
+  }
+
+  const auto within_limits = [max_dist, max_time](const sif::Cost& cost) {
+    return cost.cost < max_dist && (max_time < 0 || cost.secs < max_time);
+  };
+
+  // The best path to each destination. It leaves the tree of its start after the label of the
+  // tree onto the edge of the destination, or ends at the node of the label when there is no
+  // edge. Without a label it stays on the origin edge
+  struct path_t {
+    start_t* start;
+    uint32_t tree_idx;
+    const baldr::PathLocation::PathEdge* edge;
+    const baldr::DirectedEdge* directededge;
+    sif::Cost cost;
+    float turn_cost;
+    uint8_t restriction_idx;
+  };
+  std::vector<path_t> paths(destinations.size(), path_t{nullptr});
+  for (uint16_t dest = 1; dest < destinations.size(); ++dest) {
+    auto& best = paths[dest];
+    for (const auto& dest_edge : destinations[dest].edges) {
+      graph_tile_ptr tile;
+      const auto* directededge = reader.directededge(dest_edge.id, tile);
+      if (!directededge) {
+        continue;
+      }
+
+      // Destinations at nodes are found at the labels of the nodes
+      if (dest_edge.begin_node() || dest_edge.end_node()) {
+        const auto edge_nodes = reader.GetDirectedEdgeNodes(tile, directededge);
+        const auto nodeid = dest_edge.begin_node() ? edge_nodes.first : edge_nodes.second;
+        for (auto& start : starts) {
+          const auto node = start.tree->nodes.find(nodeid);
+          if (node == start.tree->nodes.cend()) {
+            continue;
+          }
+          const auto& label = start.tree->labelset->label(node->second);
+          const auto cost = label.cost() - start.offset;
+          if (within_limits(cost) && (!best.start || cost.cost < best.cost.cost)) {
+            best = {&start, node->second, nullptr, nullptr, cost, 0.f, 0};
+          }
+        }
+        continue;
+      }
+
+      // Destinations ahead on an origin edge are reached without leaving it
+      for (auto& start : starts) {
+        const auto ahead = dest_edge.percent_along - start.edge->percent_along;
+        if (start.edge->id == dest_edge.id && ahead >= 0) {
+          const auto cost = start.edge_cost * static_cast<float>(ahead);
+          if (within_limits(cost) && (!best.start || cost.cost < best.cost.cost)) {
+            best = {&start, baldr::kInvalidLabel, &dest_edge, start.directededge, cost,
+                    origin_label.turn_cost(), static_cast<uint8_t>(-1)};
+          }
+        }
+      }
+
+      // Otherwise along their edges they are found by expanding the node at its beginning, from
+      // its label or from the labels of the nodes it transitions to
+      if (directededge->is_shortcut() || directededge->use() == baldr::Use::kTransitConnection) {
+        continue;
+      }
+      const auto nodeid = reader.GetDirectedEdgeNodes(tile, directededge).first;
+      const auto* nodeinfo = tile->node(nodeid);
+      if (!costing->Allowed(nodeinfo)) {
+        continue;
+      }
+      std::vector<baldr::GraphId> expanded{nodeid};
+      if (nodeinfo->transition_count() > 0) {
+        const baldr::NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+        for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+          graph_tile_ptr trans_tile = reader.GetGraphTile(trans->endnode());
+          if (trans_tile && costing->Allowed(trans_tile->node(trans->endnode()))) {
+            expanded.push_back(trans->endnode());
+          }
+        }
+      }
+      const auto outbound_hdg = get_outbound_edge_heading(tile, directededge, nodeinfo);
+      const sif::Cost along(directededge->length() * dest_edge.percent_along,
+                            costing->EdgeCost(directededge, tile).secs * dest_edge.percent_along);
+      for (auto& start : starts) {
+        for (const auto& expanded_node : expanded) {
+          const auto node = start.tree->nodes.find(expanded_node);
+          if (node == start.tree->nodes.cend()) {
+            continue;
+          }
+          const auto& label = start.tree->labelset->label(node->second);
+          uint8_t restriction_idx = -1;
+          if (!IsEdgeAllowed(directededge, dest_edge.id, costing, label, tile, restriction_idx)) {
+            continue;
+          }
+          const auto inbound_hdg = get_inbound_edgelabel_heading(reader, label, nodeinfo);
+          const auto turn_cost =
+              label.turn_cost() +
+              turn_cost_table[midgard::get_turn_degree180(inbound_hdg, outbound_hdg)];
+          const auto cost = label.cost() - start.offset + along;
+          if (within_limits(cost) && (!best.start || cost.cost < best.cost.cost)) {
+            best = {&start,     node->second, &dest_edge,     directededge,
+                    cost,       turn_cost,    restriction_idx};
+          }
+        }
+      }
+    }
+  }
+
+  // Copies the path to a label of a tree, sharing what the paths before it already copied
+  const auto copy_path = [&labelset](start_t& start, uint32_t tree_idx) {
+    std::vector<uint32_t> path;
+    const auto& tree_labels = *start.tree->labelset;
+    while (tree_idx != 0 && start.copied.find(tree_idx) == start.copied.cend()) {
+      path.push_back(tree_idx);
+      tree_idx = tree_labels.label(tree_idx).predecessor();
+    }
+    uint32_t label_idx = tree_idx == 0 ? 0 : start.copied[tree_idx];
+    for (auto idx = path.crbegin(); idx != path.crend(); ++idx) {
+      Label label = tree_labels.label(*idx);
+      if (label.predecessor() == 0) {
+        label.set_source(start.edge->percent_along);
+      }
+      label.Rebase(label_idx, start.offset);
+      label_idx = labelset->append(label);
+      start.copied.emplace(*idx, label_idx);
+    }
+    return label_idx;
+  };
+
+  // Put the paths together behind the origin like the search would have
+  labelset->put(static_cast<uint16_t>(0), travelmode, edgelabel);
+  results[0] = 0;
+  for (uint16_t dest = 1; dest < destinations.size(); ++dest) {
+    const auto& path = paths[dest];
+    if (!path.start) {
+      continue;
+    }
+    if (!path.edge) {
+      results[dest] = copy_path(*path.start, path.tree_idx);
+      continue;
+    }
+    const bool on_origin_edge = path.tree_idx == baldr::kInvalidLabel;
+    const auto predecessor = on_origin_edge ? 0 : copy_path(*path.start, path.tree_idx);
+    const float source = on_origin_edge ? path.start->edge->percent_along : 0.f;
+    results[dest] = labelset->append({baldr::GraphId(), dest, path.edge->id, source,
+                                      static_cast<float>(path.edge->percent_along), path.cost,
+                                      path.turn_cost, path.cost.cost, predecessor,
+                                      path.directededge, travelmode, path.restriction_idx});
+  }
+  labelset->clear_queue();
+  labelset->clear_status();
+  return true;
+}
+
 } // namespace meili
 
 } // namespace valhalla
@@ -1,5 +1,8 @@
 #include "meili/topk_search.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace valhalla {
 namespace meili {
 
@@ -140,5 +143,172 @@ StateId TopKSearch::GetOrigin(const StateId& stateid, const StateId& not_found)
   return found->second;
 }
 
+namespace {
+
+constexpr uint32_t kNoPredecessor = std::numeric_limits<uint32_t>::max();
+
+// orders the candidate heaps so the cheapest path is on top
+template <typename path_t> bool costlier(const path_t& lhs, const path_t& rhs) {
+  return lhs.cost > rhs.cost;
+}
+
+} // namespace
+
+ListViterbiSearch::ListViterbiSearch(const std::vector<std::vector<StateId>>& columns,
+                                     const IEmissionCostModel& emission_cost_model,
+                                     const ITransitionCostModel& transition_cost_model)
+    : next_rank_(0) {
+  columns_.reserve(columns.size() + 1);
+  for (const auto& column : columns) {
+    const auto* previous = columns_.empty() ? nullptr : &columns_.back();
+    columns_.emplace_back();
+    auto& nodes = columns_.back();
+    nodes.reserve(column.size());
+    for (const auto& stateid : column) {
+      const auto emission_cost = emission_cost_model(stateid);
+      if (emission_cost < 0) {
+        continue;
+      }
+      nodes.push_back({stateid, emission_cost, {}, {}, {}, false, false});
+      auto& node = nodes.back();
+
+      // paths start with any state in the first column
+      if (!previous) {
+        node.paths.push_back({emission_cost, kNoPredecessor, 0, 0});
+        continue;
+      }
+
+      // otherwise the best path here extends the best path into one of the previous states
+      for (uint32_t i = 0; i < previous->size(); ++i) {
+        const auto& predecessor = (*previous)[i];
+        if (predecessor.paths.empty()) {
+          continue;
+        }
+        const auto transition_cost = transition_cost_model(predecessor.stateid, stateid);
+        if (transition_cost < 0) {
+          continue;
+        }
+        node.predecessors.emplace_back(i, transition_cost);
+        const double cost = predecessor.paths.front().cost + transition_cost + emission_cost;
+        if (node.paths.empty() || cost < node.paths.front().cost) {
+          node.paths.assign(1, {cost, i, 0, transition_cost});
+        }
+      }
+    }
+  }
+
+  // every path ends in the one node of the extra last column
+  columns_.emplace_back();
+  columns_.back().push_back({StateId(), 0, {}, {}, {}, false, false});
+  auto& end = columns_.back().back();
+  if (columns_.size() < 2) {
+    return;
+  }
+  const auto& last = columns_[columns_.size() - 2];
+  for (uint32_t i = 0; i < last.size(); ++i) {
+    if (last[i].paths.empty()) {
+      continue;
+    }
+    end.predecessors.emplace_back(i, 0.f);
+    if (end.paths.empty() || last[i].paths.front().cost < end.paths.front().cost) {
+      end.paths.assign(1, {last[i].paths.front().cost, i, 0, 0.f});
+    }
+  }
+}
+
+double ListViterbiSearch::Next(std::vector<StateId>& path) {
+  path.clear();
+  const auto end_time = columns_.size() - 1;
+  if (end_time == 0 || !HasPath(end_time, 0, next_rank_)) {
+    return -1;
+  }
+
+  // walk the path back from its end
+  const auto& end = columns_[end_time].front().paths[next_rank_++];
+  path.resize(end_time);
+  const auto* step = &end;
+  for (auto time = end_time; time-- > 0;) {
+    const auto& node = columns_[time][step->predecessor];
+    path[time] = node.stateid;
+    step = &node.paths[step->rank];
+  }
+  return end.cost;
+}
+
+bool ListViterbiSearch::HasPath(size_t time, uint32_t index, uint32_t rank) {
+  const auto& target = columns_[time][index];
+  if (rank < target.paths.size()) {
+    return true;
+  }
+  if (target.exhausted) {
+    return false;
+  }
+
+  // The next path of a state needs the next path into the predecessor of its last path, which may
+  // need the one into the predecessor before it and so on. Instead of recursing through the whole
+  // trace we go back until a path is already known and then work them out forwards
+  std::vector<std::pair<size_t, uint32_t>> chain;
+  while (true) {
+    chain.emplace_back(time, index);
+    const auto& node = columns_[time][index];
+    if (time == 0 || node.paths.empty()) {
+      break;
+    }
+    const auto& last = node.paths.back();
+    const auto& predecessor = columns_[time - 1][last.predecessor];
+    if (last.rank + 1 < predecessor.paths.size() || predecessor.exhausted) {
+      break;
+    }
+    --time;
+    index = last.predecessor;
+  }
+  for (auto link = chain.rbegin(); link != chain.rend(); ++link) {
+    NextPath(link->first, link->second);
+  }
+  return rank < target.paths.size();
+}
+
+void ListViterbiSearch::NextPath(size_t time, uint32_t index) {
+  auto& node = columns_[time][index];
+  if (time == 0 || node.paths.empty()) {
+    node.exhausted = true;
+    return;
+  }
+
+  // The first time around the best paths into the other predecessors become candidates
+  if (!node.expanded) {
+    node.expanded = true;
+    const auto best = node.paths.front().predecessor;
+    for (const auto& predecessor : node.predecessors) {
+      if (predecessor.first != best) {
+        node.candidates.push_back(
+            {columns_[time - 1][predecessor.first].paths.front().cost + predecessor.second +
+                 node.emission_cost,
+             predecessor.first, 0, predecessor.second});
+      }
+    }
+    std::make_heap(node.candidates.begin(), node.candidates.end(), costlier<path_t>);
+  }
+
+  // As does the next path into the predecessor of the last path
+  const auto last = node.paths.back();
+  const auto& predecessor = columns_[time - 1][last.predecessor];
+  if (last.rank + 1 < predecessor.paths.size()) {
+    node.candidates.push_back({predecessor.paths[last.rank + 1].cost + last.transition_cost +
+                                   node.emission_cost,
+                               last.predecessor, last.rank + 1, last.transition_cost});
+    std::push_heap(node.candidates.begin(), node.candidates.end(), costlier<path_t>);
+  }
+
+  // The cheapest of them is the next path
+  if (node.candidates.empty()) {
+    node.exhausted = true;
+    return;
+  }
+  std::pop_heap(node.candidates.begin(), node.candidates.end(), costlier<path_t>);
+  node.paths.push_back(node.candidates.back());
+  node.candidates.pop_back();
+}
+
 } // namespace meili
 } // namespace valhalla
@@ -48,7 +48,9 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
                                          const StateContainer& container,
                                          const sif::mode_costing_t& mode_costing,
                                          const sif::TravelMode travelmode,
-                                         const Config::TransitionCost& config)
+                                         const Config::TransitionCost& config,
+                                         RouteCache* route_cache,
+                                         size_t costing_key)
     : TransitionCostModel(graphreader,
                           vs,
                           ts,
@@ -60,6 +62,8 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
                           config.max_route_distance_factor,
                           config.max_route_time_factor,
                           config.turn_penalty_factor) {
+  route_cache_ = route_cache;
+  costing_key_ = costing_key;
 }
 
 float TransitionCostModel::operator()(const StateId& lhs, const StateId& rhs) const {
@@ -109,27 +113,32 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     edgelabel = prev_state.last_label(left);
   }
 
-  // Prepare locations and stateids
-  const auto& right_column = container_.column(right.stateid().time());
-  std::vector<baldr::PathLocation> locations;
-  locations.reserve(1 + right_column.size());
-  locations.push_back(left.candidate());
+  // Prepare locations and stateids, the destinations are the same for every state in the left
+  // column so they are only copied once per column and the origin is swapped in at the front
+  const auto right_time = right.stateid().time();
+  const auto& right_column = container_.column(right_time);
+  if (destinations_time_ != right_time || unreached_stateids_.size() != right_column.size()) {
+    locations_.clear();
+    locations_.reserve(1 + right_column.size());
+    locations_.push_back(left.candidate());
+    unreached_stateids_.clear();
+    unreached_stateids_.reserve(right_column.size());
+    for (const auto& state : right_column) {
+      locations_.push_back(state.candidate());
+      unreached_stateids_.push_back(state.stateid());
+      LOG_TRACE("Routing to: " + std::to_string(state.stateid().time()) + "." +
+                std::to_string(state.stateid().id()) + "   [" +
+                std::to_string(locations_.back().edges.front().projected.lng()) + "," +
+                std::to_string(locations_.back().edges.front().projected.lat()) + "],");
+    }
+    destinations_time_ = right_time;
+  } else {
+    locations_.front() = left.candidate();
+  }
   LOG_TRACE("Routing from: " + std::to_string(left.stateid().time()) + "." +
             std::to_string(left.stateid().id()) + " [" +
-            std::to_string(locations.back().edges.front().projected.lng()) + "," +
-            std::to_string(locations.back().edges.front().projected.lat()) + "],");
-  std::vector<StateId> unreached_stateids;
-  unreached_stateids.reserve(right_column.size());
-  for (const auto& state : right_column) {
-    // if (!vs_.Predecessor(state.stateid()).IsValid()) {
-    locations.push_back(state.candidate());
-    unreached_stateids.push_back(state.stateid());
-    LOG_TRACE("Routing to: " + std::to_string(state.stateid().time()) + "." +
-              std::to_string(state.stateid().id()) + "   [" +
-              std::to_string(locations.back().edges.front().projected.lng()) + "," +
-              std::to_string(locations.back().edges.front().projected.lat()) + "],");
-    //}
-  }
+            std::to_string(locations_.front().edges.front().projected.lng()) + "," +
+            std::to_string(locations_.front().edges.front().projected.lat()) + "],");
 
   const auto& left_measurement = container_.measurement(lhs.time());
   const auto& right_measurement = container_.measurement(rhs.time());
@@ -149,13 +158,52 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     max_route_time = std::ceil(max_route_time);
   }
 
-  labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance);
-  const auto& results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
-                                           right_measurement.search_radius(),
-                                           mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
+  // Short transitions out of edges whose trees are kept need no search
+  const auto& costing = mode_costing_[static_cast<size_t>(travelmode_)];
+  if (route_cache_ && max_route_distance < route_cache_->distance()) {
+    const auto get_tree = [this, &costing](const baldr::GraphId& edgeid) {
+      bool build;
+      auto tree = route_cache_->find(costing_key_, edgeid, build);
+      if (build) {
+        tree = build_route_tree(graphreader_, edgeid, costing, turn_cost_table_,
+                                route_cache_->distance());
+        route_cache_->put(costing_key_, tree);
+      }
+      return tree;
+    };
+    auto labelset = std::make_shared<LabelSet>(max_route_distance);
+    std::unordered_map<uint16_t, uint32_t> results;
+    if (find_shortest_path_in_trees(graphreader_, locations_, labelset, costing, edgelabel,
+                                    turn_cost_table_, max_route_distance, max_route_time, get_tree,
+                                    results)) {
+      left.SetRoute(unreached_stateids_, results, labelset);
+      return;
+    }
+  }
+
+  // All the states of the left column expand into one label set one after another. The limits
+  // only depend on the two measurements so its queue fits all of them, and each expansion
+  // leaves the labels of the previous ones untouched for the path recovery of their states
+  if (column_labelsets_.size() <= lhs.time()) {
+    column_labelsets_.resize(lhs.time() + 1);
+  }
+  auto& column_labelset = column_labelsets_[lhs.time()];
+  if (!column_labelset.second || column_labelset.first != right_time) {
+    column_labelset = {right_time, std::make_shared<LabelSet>(max_route_distance)};
+  }
+  const auto& labelset = column_labelset.second;
+  const auto& results = find_shortest_path(graphreader_, locations_, 0, labelset, approximator,
+                                           right_measurement.search_radius(), costing, edgelabel,
                                            turn_cost_table_, max_route_distance, max_route_time);
 
-  left.SetRoute(unreached_stateids, results, labelset);
+  left.SetRoute(unreached_stateids_, results, labelset);
+}
+
+void TransitionCostModel::Clear() {
+  column_labelsets_.clear();
+  destinations_time_ = kInvalidTime;
+  locations_.clear();
+  unreached_stateids_.clear();
 }
 
 } // namespace meili
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "meili/map_matcher_factory.h"
+#include "meili/measurement.h"
+#include "midgard/logging.h"
+#include "midgard/util.h"
+#include "sif/costfactory.h"
+
+#include "config.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::meili;
+using namespace valhalla::midgard;
+
+// args
+boost::property_tree::ptree config;
+std::string input_file, output_file, costing_name;
+unsigned int num_threads;
+size_t batch_size;
+
+namespace {
+
+// what we know about how fast an edge was traversed
+struct aggregate_t {
+  uint32_t count;
+  double meters;
+  double seconds;
+};
+
+using aggregates_t = std::unordered_map<uint64_t, aggregate_t>;
+
+// what a worker got done
+struct stats {
+  size_t traces;
+  size_t failed;
+  aggregates_t aggregates;
+};
+
+// The traces come in one after another as a point count followed by that many points, each of
+// them a longitude, a latitude and a time in seconds since the epoch. All of it in the native byte
+// order, uint32_t for the count and doubles for the rest
+class trace_reader_t {
+public:
+  trace_reader_t(std::FILE* file) : file_(file) {
+  }
+
+  // hands out the next batch of traces, false when the input is done
+  bool next(std::vector<std::vector<Measurement>>& batch, float gps_accuracy, float search_radius) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch.clear();
+    while (batch.size() < batch_size) {
+      uint32_t count;
+      if (std::fread(&count, sizeof(count), 1, file_) != 1) {
+        break;
+      }
+      points_.resize(count * 3);
+      if (std::fread(points_.data(), sizeof(double), points_.size(), file_) != points_.size()) {
+        throw std::runtime_error("Input ended in the middle of a trace");
+      }
+      batch.emplace_back();
+      batch.back().reserve(count);
+      for (size_t i = 0; i < points_.size(); i += 3) {
+        batch.back().emplace_back(PointLL{points_[i], points_[i + 1]}, gps_accuracy, search_radius,
+                                  points_[i + 2]);
+      }
+    }
+    return !batch.empty();
+  }
+
+private:
+  std::FILE* file_;
+  std::mutex mutex_;
+  std::vector<double> points_;
+};
+
+// a matched measurement at its distance along the matched path
+struct timed_t {
+  double distance;
+  double time;
+};
+
+// the time at the distance along the path, if the measurements surround it
+bool time_at(const std::vector<timed_t>& timed, double distance, double& time) {
+  auto after = std::lower_bound(timed.begin(), timed.end(), distance,
+                                [](const timed_t& t, double d) { return t.distance < d; });
+  if (after == timed.end() || (after == timed.begin() && after->distance > distance)) {
+    return false;
+  }
+  if (after->distance == distance) {
+    time = after->time;
+    return true;
+  }
+  auto before = std::prev(after);
+  time = before->time + (after->time - before->time) * (distance - before->distance) /
+                            (after->distance - before->distance);
+  return true;
+}
+
+// Works out how long it took to go over each whole edge of the matched path from the times of the
+// measurements matched before and after it. Where the path breaks off the distances start over
+void aggregate(const MatchResults& match, GraphReader& reader, aggregates_t& aggregates) {
+  const auto& segments = match.segments;
+  graph_tile_ptr tile;
+  std::vector<double> lengths(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const auto* edge = reader.directededge(segments[i].edgeid, tile);
+    lengths[i] = edge ? edge->length() * (segments[i].target - segments[i].source) : 0;
+  }
+
+  size_t segment = 0;
+  auto result = match.results.cbegin();
+  while (segment < segments.size()) {
+    // the stretch of path up to where it breaks off
+    size_t end = segment;
+    while (end < segments.size() && !segments[end++].discontinuity) {
+    }
+
+    // place the matched measurements on it, in order and only moving forward in space and time
+    std::vector<timed_t> timed;
+    double distance = 0;
+    for (auto s = segment; s < end; ++s) {
+      for (; result != match.results.cend(); ++result) {
+        if (!result->HasState() || result->epoch_time < 0) {
+          continue;
+        }
+        if (result->edgeid != segments[s].edgeid || result->distance_along < segments[s].source ||
+            result->distance_along > segments[s].target) {
+          break;
+        }
+        const auto along = distance + lengths[s] * (result->distance_along - segments[s].source) /
+                                          std::max(segments[s].target - segments[s].source, 1e-6);
+        if (timed.empty() ||
+            (timed.back().distance < along && timed.back().time < result->epoch_time)) {
+          timed.push_back({along, result->epoch_time});
+        }
+      }
+      distance += lengths[s];
+    }
+
+    // the edges the trace went all the way over and which it has times on both ends of
+    distance = 0;
+    for (auto s = segment; s < end; ++s) {
+      double enter, exit;
+      if (segments[s].source == 0 && segments[s].target == 1 && lengths[s] > 0 &&
+          time_at(timed, distance, enter) && time_at(timed, distance + lengths[s], exit) &&
+          enter < exit) {
+        auto& aggregate = aggregates[segments[s].edgeid.value];
+        ++aggregate.count;
+        aggregate.meters += lengths[s];
+        aggregate.seconds += exit - enter;
+      }
+      distance += lengths[s];
+    }
+
+    segment = end;
+  }
+}
+
+// each worker matches batches of traces with a matcher of its own until the input runs out
+void work(trace_reader_t& traces, const Options& options, std::promise<stats>& result) {
+  try {
+    stats stat{};
+    MapMatcherFactory factory(config);
+    std::shared_ptr<MapMatcher> matcher(factory.Create(options));
+    const auto gps_accuracy = matcher->config().emission_cost.gps_accuracy_meters;
+    const auto search_radius = matcher->config().candidate_search.search_radius_meters;
+    std::vector<std::vector<Measurement>> batch;
+    while (traces.next(batch, gps_accuracy, search_radius)) {
+      for (const auto& trace : batch) {
+        ++stat.traces;
+        try {
+          aggregate(matcher->OfflineMatch(trace).front(), matcher->graphreader(), stat.aggregates);
+        } catch (...) { ++stat.failed; }
+      }
+      factory.ClearFullCache();
+    }
+    result.set_value(std::move(stat));
+  } catch (...) { result.set_exception(std::current_exception()); }
+}
+
+} // namespace
+
+bool ParseArguments(int argc, char* argv[]) {
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_aggregate_speeds",
+      "valhalla_aggregate_speeds " VALHALLA_VERSION "\n\n"
+      "valhalla_aggregate_speeds map matches a stream of probe traces on many threads and\n"
+      "writes out how fast the edges were traveled.\n\n"
+      "Input is binary, for every trace a uint32 point count followed by that many points of\n"
+      "three doubles: longitude, latitude and seconds since the epoch.\n"
+      "Output is binary, for every traveled edge its uint64 id, the uint32 number of traversals\n"
+      "and the float speed in kph (the total length over the total time of the traversals).\n"
+      "Both are in the native byte order.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>())
+      ("i,inline-config", "Inline json config.", cxxopts::value<std::string>())
+      ("j,concurrency", "Number of threads to use.", cxxopts::value<unsigned int>(num_threads)->default_value(std::to_string(std::thread::hardware_concurrency())))
+      ("b,batch", "Number of traces a thread takes from the input at a time.", cxxopts::value<size_t>(batch_size)->default_value("64"))
+      ("m,costing", "Costing to match the traces with.", cxxopts::value<std::string>(costing_name)->default_value("auto"))
+      ("input", "Traces to match [default=stdin].", cxxopts::value<std::string>(input_file))
+      ("o,output", "Where to write the speeds [default=stdout].", cxxopts::value<std::string>(output_file));
+    // clang-format on
+
+    options.parse_positional({"input"});
+    options.positional_help("[input]");
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      exit(0);
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_aggregate_speeds " << VALHALLA_VERSION << "\n";
+      exit(0);
+    }
+
+    // Read the config file
+    if (result.count("inline-config")) {
+      std::stringstream ss;
+      ss << result["inline-config"].as<std::string>();
+      rapidjson::read_json(ss, config);
+    } else if (result.count("config")) {
+      rapidjson::read_json(result["config"].as<std::string>(), config);
+    } else {
+      std::cerr << "Configuration is required\n\n" << options.help() << "\n\n";
+      return false;
+    }
+
+    num_threads = std::max(num_threads, 1u);
+    batch_size = std::max(batch_size, size_t(1));
+    return true;
+  } catch (cxxopts::OptionException& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return false;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (!ParseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+
+  // configure logging
+  auto logging_subtree = config.get_child_optional("meili.logging");
+  if (logging_subtree) {
+    auto logging_config =
+        ToMap<const boost::property_tree::ptree&, std::unordered_map<std::string, std::string>>(
+            logging_subtree.get());
+    logging::Configure(logging_config);
+  }
+
+  // the threads share one tile cache
+  config.put("mjolnir.global_synchronized_cache", true);
+
+  Options options;
+  Costing::Type costing;
+  if (!Costing_Enum_Parse(costing_name, &costing)) {
+    std::cerr << "Unknown costing " << costing_name << "\n";
+    return EXIT_FAILURE;
+  }
+  options.set_costing_type(costing);
+  rapidjson::Document doc;
+  sif::ParseCosting(doc, "/costing_options", options);
+
+  std::FILE* input = input_file.empty() ? stdin : std::fopen(input_file.c_str(), "rb");
+  if (!input) {
+    std::cerr << "Unable to open " << input_file << "\n";
+    return EXIT_FAILURE;
+  }
+  trace_reader_t traces(input);
+
+  LOG_INFO("Matching traces with " + std::to_string(num_threads) + " threads");
+  std::list<std::promise<stats>> results;
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    results.emplace_back();
+    threads.emplace_back(work, std::ref(traces), std::cref(options), std::ref(results.back()));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (input != stdin) {
+    std::fclose(input);
+  }
+
+  // put together what the threads found, in the order of the edge ids
+  size_t traces_count = 0, failed_count = 0;
+  std::map<uint64_t, aggregate_t> aggregates;
+  for (auto& result : results) {
+    try {
+      auto stat = result.get_future().get();
+      traces_count += stat.traces;
+      failed_count += stat.failed;
+      for (const auto& edge : stat.aggregates) {
+        auto& aggregate = aggregates[edge.first];
+        aggregate.count += edge.second.count;
+        aggregate.meters += edge.second.meters;
+        aggregate.seconds += edge.second.seconds;
+      }
+    } catch (const std::exception& e) {
+      LOG_ERROR(e.what());
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::FILE* output = output_file.empty() ? stdout : std::fopen(output_file.c_str(), "wb");
+  if (!output) {
+    std::cerr << "Unable to open " << output_file << "\n";
+    return EXIT_FAILURE;
+  }
+  for (const auto& edge : aggregates) {
+    const float kph = static_cast<float>(edge.second.meters / edge.second.seconds * 3.6);
+    std::fwrite(&edge.first, sizeof(edge.first), 1, output);
+    std::fwrite(&edge.second.count, sizeof(edge.second.count), 1, output);
+    std::fwrite(&kph, sizeof(kph), 1, output);
+  }
+  if (output != stdout) {
+    std::fclose(output);
+  }
+
+  LOG_INFO("Matched " + std::to_string(traces_count - failed_count) + " of " +
+           std::to_string(traces_count) + " traces onto " + std::to_string(aggregates.size()) +
+           " edges");
+  return EXIT_SUCCESS;
+}
@@ -377,6 +377,11 @@ bool ViterbiSearch::AddStateId(const StateId& stateid) {
   }
   unreached_states_by_time[stateid.time()].push_back(stateid);
 
+  if (slots_by_time_.size() <= stateid.time()) {
+    slots_by_time_.resize(stateid.time() + 1);
+  }
+  slots_by_time_[stateid.time()].push_back(Slot{});
+
   return true;
 }
 
@@ -391,6 +396,8 @@ bool ViterbiSearch::RemoveStateId(const StateId& stateid) {
   if (it == column.end()) {
     throw std::logic_error("the state must exist in the column");
   }
+  slots_by_time_[stateid.time()].erase(slots_by_time_[stateid.time()].begin() +
+                                       (it - column.begin()));
   column.erase(it);
   return true;
 }
@@ -427,45 +434,144 @@ StateId ViterbiSearch::SearchWinner(StateId::Time time) {
 }
 
 StateId ViterbiSearch::Predecessor(const StateId& stateid) const {
-  const auto it = scanned_labels_.find(stateid);
-  if (it == scanned_labels_.end()) {
+  const auto* slot = FindSlot(stateid);
+  if (!slot || !slot->scanned) {
     return {};
   } else {
-    return (it->second).predecessor();
+    return slot->predecessor;
   }
 }
 
 double ViterbiSearch::AccumulatedCost(const StateId& stateid) const {
-  const auto it = scanned_labels_.find(stateid);
-  if (it == scanned_labels_.end()) {
+  const auto* slot = FindSlot(stateid);
+  if (!slot || !slot->scanned) {
     return -1.f;
   } else {
-    return it->second.costsofar();
+    return slot->costsofar;
+  }
+}
+
+StateId ViterbiSearch::ConvergedStateId() const {
+  // The last winner hasn't had its successors added yet, so along with the labels in the queue it
+  // is where every future path will come from
+  if (winner_by_time.empty() || !winner_by_time.back().IsValid()) {
+    return {};
+  }
+
+  // Remember the path of the last winner by time
+  const auto& winner = winner_by_time.back();
+  std::vector<StateId> path(winner.time() + 1);
+  for (auto stateid = winner; stateid.IsValid(); stateid = Predecessor(stateid)) {
+    path[stateid.time()] = stateid;
+  }
+
+  // Every other path has to merge into it at or before the time converged so far. Once two paths
+  // share a state they share everything before it too
+  auto converged = winner.time();
+  for (const auto& entry : queue_) {
+    // Nothing can come from these anymore
+    if (!IsLive(entry) || entry.stateid.time() < earliest_time_) {
+      continue;
+    }
+    // The label isn't scanned yet so its first step back is its own predecessor
+    auto stateid = entry.stateid;
+    const auto predecessor = FindSlot(stateid)->predecessor;
+    while (stateid.IsValid() && (converged < stateid.time() || path[stateid.time()] != stateid)) {
+      stateid = stateid == entry.stateid ? predecessor : Predecessor(stateid);
+    }
+    if (!stateid.IsValid()) {
+      return {};
+    }
+    converged = stateid.time();
   }
+
+  return path[converged];
 }
 
 void ViterbiSearch::Clear() {
   IViterbiSearch::Clear();
   states_by_time.clear();
+  // Keep the slot columns around for the next trace
+  for (auto& slots : slots_by_time_) {
+    slots.clear();
+  }
   ClearSearch();
 }
 
 void ViterbiSearch::ClearSearch() {
   earliest_time_ = 0;
   queue_.clear();
-  scanned_labels_.clear();
+  scanned_by_time_.clear();
+  for (auto& slots : slots_by_time_) {
+    std::fill(slots.begin(), slots.end(), Slot{});
+  }
   winner_by_time.clear();
   unreached_states_by_time = states_by_time;
 }
 
-void ViterbiSearch::InitQueue(const std::vector<StateId>& column) {
+ViterbiSearch::Slot* ViterbiSearch::FindSlot(const StateId& stateid) {
+  return const_cast<Slot*>(static_cast<const ViterbiSearch*>(this)->FindSlot(stateid));
+}
+
+const ViterbiSearch::Slot* ViterbiSearch::FindSlot(const StateId& stateid) const {
+  if (states_by_time.size() <= stateid.time()) {
+    return nullptr;
+  }
+  // State IDs are usually their index in the column, otherwise look for them
+  const auto& column = states_by_time[stateid.time()];
+  size_t index = stateid.id();
+  if (column.size() <= index || column[index] != stateid) {
+    const auto it = std::find(column.begin(), column.end(), stateid);
+    if (it == column.end()) {
+      return nullptr;
+    }
+    index = it - column.begin();
+  }
+  return &slots_by_time_[stateid.time()][index];
+}
+
+bool ViterbiSearch::IsLive(const QueueEntry& entry) const {
+  const auto* slot = FindSlot(entry.stateid);
+  return slot && slot->queued && slot->costsofar == entry.costsofar;
+}
+
+void ViterbiSearch::PushLabel(double costsofar, const StateId& stateid, const StateId& predecessor) {
+  auto* slot = FindSlot(stateid);
+  if (!slot) {
+    throw std::logic_error("the state must exist in the column");
+  }
+  if ((slot->scanned || slot->queued) && !(costsofar < slot->costsofar)) {
+    return;
+  }
+  if (slot->scanned) {
+    throw std::logic_error("the principle of optimality is violated in the viterbi search,"
+                           " probably negative costs occurred");
+  }
+  slot->costsofar = costsofar;
+  slot->predecessor = predecessor;
+  slot->queued = true;
+  queue_.push_back({costsofar, stateid});
+  std::push_heap(queue_.begin(), queue_.end());
+}
+
+void ViterbiSearch::ClearQueue() {
+  for (const auto& entry : queue_) {
+    auto* slot = FindSlot(entry.stateid);
+    if (slot) {
+      slot->queued = false;
+    }
+  }
   queue_.clear();
+}
+
+void ViterbiSearch::InitQueue(const std::vector<StateId>& column) {
+  ClearQueue();
   for (const auto stateid : column) {
     const auto emission_cost = EmissionCost(stateid);
     if (IsInvalidCost(emission_cost)) {
       continue;
     }
-    queue_.push(StateLabel(emission_cost, stateid, {}));
+    PushLabel(emission_cost, stateid, {});
   }
 }
 
@@ -475,11 +581,11 @@ void ViterbiSearch::AddSuccessorsToQueue(const StateId& stateid) {
                            " is impossible to have successors");
   }
 
-  const auto it = scanned_labels_.find(stateid);
-  if (it == scanned_labels_.end()) {
+  const auto* slot = FindSlot(stateid);
+  if (!slot || !slot->scanned) {
     throw std::logic_error("the state must be scanned");
   }
-  const auto costsofar = it->second.costsofar();
+  const auto costsofar = slot->costsofar;
   if (IsInvalidCost(costsofar)) {
     // All invalid ones should be filtered out before pushing labels
     // into the queue
@@ -504,7 +610,7 @@ void ViterbiSearch::AddSuccessorsToQueue(const StateId& stateid) {
       continue;
     }
 
-    queue_.push(StateLabel(next_costsofar, next_stateid, stateid));
+    PushLabel(next_costsofar, next_stateid, stateid);
   }
 }
 
@@ -543,9 +649,17 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
     // Pop up the state with the optimal cost. Note it is not
     // necessarily to be the winner at its time yet, unless it is the
     // first one found at the time
-    const auto label = queue_.top();
-    const auto& stateid = label.stateid();
-    queue_.pop();
+    std::pop_heap(queue_.begin(), queue_.end());
+    const auto entry = queue_.back();
+    const auto& stateid = entry.stateid;
+    queue_.pop_back();
+
+    // Skip entries that were superseded by a cheaper label for the same state
+    if (!IsLive(entry)) {
+      continue;
+    }
+    auto* slot = FindSlot(stateid);
+    slot->queued = false;
 
     // Skip labels that are earlier than the earliest time, since they
     // are impossible to be part of the path to future winners
@@ -553,12 +667,12 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
       continue;
     }
 
-    // Mark it as scanned and remember its cost and predecessor
-    const auto& inserted = scanned_labels_.emplace(stateid, label);
-    if (!inserted.second) {
-      throw std::logic_error("the principle of optimality is violated in the viterbi search,"
-                             " probably negative costs occurred");
+    // Mark it as scanned, its cost and predecessor are final now
+    slot->scanned = true;
+    if (scanned_by_time_.size() <= stateid.time()) {
+      scanned_by_time_.resize(stateid.time() + 1);
     }
+    const auto rank = scanned_by_time_[stateid.time()]++;
 
     // Remove it from its column
     auto& column = unreached_states_by_time[stateid.time()];
@@ -596,6 +710,13 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
       break;
     }
 
+    // Outside of the beam the state is a dead end, the winner of its column is always in it
+    if ((beam_width_ && beam_width_ <= rank) ||
+        (beam_cost_ > 0 &&
+         FindSlot(winner_by_time[stateid.time()])->costsofar + beam_cost_ < entry.costsofar)) {
+      continue;
+    }
+
     AddSuccessorsToQueue(stateid);
   }
 
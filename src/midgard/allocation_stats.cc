@@ -0,0 +1,155 @@
+#include "midgard/allocation_stats.h"
+
+#include <algorithm>
+
+#ifdef ENABLE_ALLOCATION_STATS
+#include <cstdlib>
+#include <new>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+
+namespace {
+
+// the counters of the calling thread, plain integers so that the hook itself never allocates
+struct counters_t {
+  uint64_t allocations;
+  uint64_t bytes;
+  int64_t live;
+  int64_t peak;
+};
+thread_local counters_t counters{};
+
+#ifdef ENABLE_ALLOCATION_STATS
+size_t usable_size(void* ptr) {
+#ifdef __APPLE__
+  return malloc_size(ptr);
+#else
+  return malloc_usable_size(ptr);
+#endif
+}
+
+void* allocated(void* ptr) {
+  if (ptr) {
+    const auto size = static_cast<int64_t>(usable_size(ptr));
+    ++counters.allocations;
+    counters.bytes += size;
+    counters.live += size;
+    counters.peak = std::max(counters.peak, counters.live);
+  }
+  return ptr;
+}
+
+void freed(void* ptr) {
+  if (ptr) {
+    counters.live -= static_cast<int64_t>(usable_size(ptr));
+    std::free(ptr);
+  }
+}
+
+void* allocate(std::size_t size) {
+  // like the default operator new, keep asking the new handler until it gives up
+  for (;;) {
+    if (auto* ptr = allocated(std::malloc(size ? size : 1))) {
+      return ptr;
+    }
+    auto handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void* allocate(std::size_t size, std::align_val_t align) {
+  const auto alignment = std::max(static_cast<std::size_t>(align), sizeof(void*));
+  for (;;) {
+    void* ptr = nullptr;
+    if (!posix_memalign(&ptr, alignment, size ? size : 1) && allocated(ptr)) {
+      return ptr;
+    }
+    auto handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+#endif
+
+} // namespace
+
+#ifdef ENABLE_ALLOCATION_STATS
+// the replacements of the global allocation functions, all the others forward to these
+void* operator new(std::size_t size) {
+  return allocate(size);
+}
+void* operator new[](std::size_t size) {
+  return allocate(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+  return allocate(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return allocate(size, align);
+}
+void operator delete(void* ptr) noexcept {
+  freed(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+  freed(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+  freed(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+  freed(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  freed(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  freed(ptr);
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  freed(ptr);
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  freed(ptr);
+}
+#endif
+
+namespace valhalla {
+namespace midgard {
+
+allocation_stats_t::mark_t allocation_stats_t::start() {
+  mark_t mark{counters.allocations, counters.bytes, counters.live, counters.peak};
+  // the peak from here on, the outer measurements get theirs back when this one ends
+  counters.peak = counters.live;
+  return mark;
+}
+
+allocation_stats_t allocation_stats_t::since(const mark_t& mark) {
+  allocation_stats_t stats;
+  stats.allocations = counters.allocations - mark.allocations;
+  stats.bytes = counters.bytes - mark.bytes;
+  stats.peak_bytes = static_cast<uint64_t>(std::max<int64_t>(counters.peak - mark.live, 0));
+  counters.peak = std::max(counters.peak, mark.peak);
+  return stats;
+}
+
+} // namespace midgard
+} // namespace valhalla
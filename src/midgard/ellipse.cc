@@ -156,6 +156,15 @@ template <class coord_t> bool Ellipse<coord_t>::Contains(const coord_t& pt) cons
   return ((k1_ * sqr(dx)) + (k2_ * dx * dy) + (k3_ * sqr(dy)) - 1) < kEpsilon;
 }
 
+// Get the axis-aligned bounding box. The axis of half length a points along the rotation and
+// the one of half length b across it, projecting both onto x and y gives the half extents.
+template <class coord_t> AABB2<coord_t> Ellipse<coord_t>::BoundingBox() const {
+  const float half_width = std::sqrt(sqr(a * c) + sqr(b * s));
+  const float half_height = std::sqrt(sqr(a * s) + sqr(b * c));
+  return AABB2<coord_t>(center_.x() - half_width, center_.y() - half_height,
+                        center_.x() + half_width, center_.y() + half_height);
+}
+
 // Explicit instantiation
 template class Ellipse<Point2>;
 template class Ellipse<PointLL>;
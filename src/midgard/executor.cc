@@ -0,0 +1,98 @@
+#include "midgard/executor.h"
+
+#include <algorithm>
+
+namespace valhalla {
+namespace midgard {
+
+executor_t::executor_t(uint32_t threads) : stopping_(false) {
+  for (uint32_t i = 0; i < threads; ++i) {
+    threads_.emplace_back(&executor_t::loop, this);
+  }
+}
+
+executor_t::~executor_t() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+executor_t& executor_t::shared() {
+  static executor_t executor(std::max(1u, std::thread::hardware_concurrency()));
+  return executor;
+}
+
+void executor_t::run(uint32_t slots, const std::function<void(uint32_t)>& work) {
+  // nothing to lend
+  if (slots < 2 || threads_.empty()) {
+    work(0);
+    return;
+  }
+
+  batch_t batch{&work, 0, nullptr, {}};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t slot = 1; slot < slots; ++slot) {
+      jobs_.push_back({&batch, slot});
+    }
+  }
+  wake_.notify_all();
+
+  std::exception_ptr error;
+  try {
+    work(0);
+  } catch (...) { error = std::current_exception(); }
+
+  // once this thread is done every task was taken, the slots which didnt start have nothing left
+  std::unique_lock<std::mutex> lock(mutex_);
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                             [&batch](const job_t& job) { return job.batch == &batch; }),
+              jobs_.end());
+  batch.done.wait(lock, [&batch]() { return batch.running == 0; });
+  if (!error) {
+    error = batch.error;
+  }
+  lock.unlock();
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void executor_t::loop() {
+  while (true) {
+    job_t job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return;
+      }
+      job = jobs_.front();
+      jobs_.pop_front();
+      ++job.batch->running;
+    }
+
+    std::exception_ptr error;
+    try {
+      (*job.batch->work)(job.slot);
+    } catch (...) { error = std::current_exception(); }
+
+    // the batch lives on the stack of its caller, it may only be touched under the lock
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !job.batch->error) {
+      job.batch->error = error;
+    }
+    if (--job.batch->running == 0) {
+      job.batch->done.notify_all();
+    }
+  }
+}
+
+} // namespace midgard
+} // namespace valhalla
@@ -1,8 +1,11 @@
 #include "midgard/logging.h"
 #include "filesystem.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
@@ -10,6 +13,7 @@
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -51,6 +55,17 @@ std::string TimeStamp() {
   return buffer;
 }
 
+// a whole line of output, with its time stamp and new line
+std::string FormatLine(const std::string& message, const std::string& custom_directive) {
+  std::string output;
+  output.reserve(message.length() + 64);
+  output.append(TimeStamp());
+  output.append(custom_directive);
+  output.append(message);
+  output.push_back('\n');
+  return output;
+}
+
 // the Log levels we support
 struct EnumHasher {
   template <typename T> std::size_t operator()(T t) const {
@@ -85,6 +100,9 @@ namespace midgard {
 
 namespace logging {
 
+// wraps loggers which write lines in an async logger, defined below with the loggers
+Logger* MakeAsync(const LoggingConfig& config, Logger* logger);
+
 // a factory that can create loggers (that derive from 'logger') via function pointers
 // this way you could make your own logger that sends log messages to who knows where
 Logger* LoggerFactory::Produce(const LoggingConfig& config) const {
@@ -96,6 +114,10 @@ Logger* LoggerFactory::Produce(const LoggingConfig& config) const {
   // grab the logger
   auto found = find(type->second);
   if (found != end()) {
+    auto async = config.find("async");
+    if (async != config.end() && async->second == "true") {
+      return MakeAsync(config, found->second(config));
+    }
     return found->second(config);
   }
   // couldn't get a logger
@@ -124,45 +146,54 @@ bool logger_registered = RegisterLogger("", [](const LoggingConfig& config) {
   return l;
 });
 
-// logger that writes to standard out
-class StdOutLogger : public Logger {
+// loggers which format each message into a line and then write it somewhere, the async logger
+// takes over the writing so that the lines of many messages are written at once
+class LineLogger : public Logger {
 public:
-  StdOutLogger() = delete;
-  StdOutLogger(const LoggingConfig& config)
+  LineLogger() = delete;
+  LineLogger(const LoggingConfig& config)
       : Logger(config),
         levels(config.find("color") != config.end() && config.find("color")->second == "true"
                    ? colored
                    : uncolored) {
   }
   virtual void Log(const std::string& message, const LogLevel level) {
+    Log(message, Directive(level));
+  }
+  virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
+    Write(FormatLine(message, custom_directive));
+  }
+  const std::string& Directive(const LogLevel level) const {
+    return levels.find(level)->second;
+  }
+  // writes and flushes one or more whole lines
+  virtual void Write(const std::string& lines) = 0;
+
+protected:
+  const std::unordered_map<LogLevel, std::string, EnumHasher> levels;
+};
+
+// logger that writes to standard out
+class StdOutLogger : public LineLogger {
+public:
+  using LineLogger::LineLogger;
 #ifdef __ANDROID__
+  virtual void Log(const std::string& message, const LogLevel level) {
     __android_log_print(android_levels.find(level)->second, "valhalla", "%s", message.c_str());
-#else
-    Log(message, levels.find(level)->second);
-#endif
   }
   virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
-#ifdef __ANDROID__
     std::string tmp = custom_directive; // to prevent -Wunused-parameter
     __android_log_print(ANDROID_LOG_INFO, "valhalla", "%s", message.c_str());
-#else
-    std::string output;
-    output.reserve(message.length() + 64);
-    output.append(TimeStamp());
-    output.append(custom_directive);
-    output.append(message);
-    output.push_back('\n');
+  }
+#endif
+  virtual void Write(const std::string& lines) {
     // cout is thread safe, to avoid multiple threads interleaving on one line
     // though, we make sure to only call the << operator once on std::cout
     // otherwise the << operators from different threads could interleave
     // obviously we dont care if flushes interleave
-    std::cout << output;
+    std::cout << lines;
     std::cout.flush();
-#endif
   }
-
-protected:
-  const std::unordered_map<LogLevel, std::string, EnumHasher> levels;
 };
 bool std_out_logger_registered = RegisterLogger("std_out", [](const LoggingConfig& config) {
   Logger* l = new StdOutLogger(config);
@@ -171,20 +202,15 @@ bool std_out_logger_registered = RegisterLogger("std_out", [](const LoggingConfi
 
 class StdErrLogger : public StdOutLogger {
   using StdOutLogger::StdOutLogger;
-  virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
 #ifdef __ANDROID__
+  virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
     std::string tmp = custom_directive; // to prevent -Wunused-parameter
     __android_log_print(ANDROID_LOG_ERROR, "valhalla", "%s", message.c_str());
-#else
-    std::string output;
-    output.reserve(message.length() + 64);
-    output.append(TimeStamp());
-    output.append(custom_directive);
-    output.append(message);
-    output.push_back('\n');
-    std::cerr << output;
-    std::cerr.flush();
+  }
 #endif
+  virtual void Write(const std::string& lines) {
+    std::cerr << lines;
+    std::cerr.flush();
   }
 };
 bool std_err_logger_registered = RegisterLogger("std_err", [](const LoggingConfig& config) {
@@ -194,10 +220,10 @@ bool std_err_logger_registered = RegisterLogger("std_err", [](const LoggingConfi
 
 // TODO: add log rolling
 // logger that writes to file
-class FileLogger : public Logger {
+class FileLogger : public LineLogger {
 public:
   FileLogger() = delete;
-  FileLogger(const LoggingConfig& config) : Logger(config) {
+  FileLogger(const LoggingConfig& config) : LineLogger(withoutColor(config)) {
     // grab the file name
     auto name = config.find("file_name");
     if (name == config.end()) {
@@ -219,24 +245,20 @@ public:
     // crack the file open
     ReOpen();
   }
-  virtual void Log(const std::string& message, const LogLevel level) {
-    Log(message, uncolored.find(level)->second);
-  }
-  virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
-    std::string output;
-    output.reserve(message.length() + 64);
-    output.append(TimeStamp());
-    output.append(custom_directive);
-    output.append(message);
-    output.push_back('\n');
+  virtual void Write(const std::string& lines) {
     lock.lock();
-    file << output;
+    file << lines;
     file.flush();
     lock.unlock();
     ReOpen();
   }
 
 protected:
+  // files never get colored directives
+  static LoggingConfig withoutColor(LoggingConfig config) {
+    config.erase("color");
+    return config;
+  }
   void ReOpen() {
     // TODO: use CLOCK_MONOTONIC_COARSE
     // check if it should be closed and reopened
@@ -265,6 +287,7 @@ protected:
         try {
           file.close();
         } catch (...) {}
+        lock.unlock();
         throw e;
       }
     }
@@ -280,6 +303,154 @@ bool file_logger_registered = RegisterLogger("file", [](const LoggingConfig& con
   return l;
 });
 
+// logger that formats the lines on the calling thread and hands them to a thread which writes them
+// in batches so that logging never waits on the output. the lines go through a bounded lock free
+// queue (a ring of slots with sequence numbers), when it is full the line is dropped and counted
+// and the writer logs how many were dropped
+class AsyncLogger : public Logger {
+public:
+  AsyncLogger() = delete;
+  AsyncLogger(const LoggingConfig& config, LineLogger* sink) : Logger(config), sink(sink) {
+    size_t size = 8192;
+    auto queue_size = config.find("async_queue_size");
+    if (queue_size != config.end()) {
+      try {
+        size = std::max(std::stoul(queue_size->second), 2ul);
+      } catch (...) {
+        throw std::runtime_error(queue_size->second + " is not a valid async queue size");
+      }
+    }
+    flush_interval = std::chrono::milliseconds(100);
+    auto interval = config.find("async_flush_interval");
+    if (interval != config.end()) {
+      try {
+        flush_interval = std::chrono::milliseconds(std::stoul(interval->second));
+      } catch (...) {
+        throw std::runtime_error(interval->second + " is not a valid async flush interval");
+      }
+    }
+
+    // the ring is a power of 2 so that positions wrap with a mask
+    capacity = 1;
+    while (capacity < size) {
+      capacity <<= 1;
+    }
+    slots.reset(new slot_t[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer = std::thread(&AsyncLogger::Drain, this);
+  }
+  virtual ~AsyncLogger() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopped = true;
+    }
+    wake.notify_one();
+    writer.join();
+  }
+  virtual void Log(const std::string& message, const LogLevel level) {
+    Push(FormatLine(message, sink->Directive(level)));
+  }
+  virtual void Log(const std::string& message, const std::string& custom_directive = " [TRACE] ") {
+    Push(FormatLine(message, custom_directive));
+  }
+
+protected:
+  struct slot_t {
+    std::atomic<size_t> sequence;
+    std::string line;
+  };
+
+  void Push(std::string&& line) {
+    size_t position = head.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots[position & (capacity - 1)];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - position);
+      // the slot is free, claim it
+      if (diff == 0) {
+        if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.line = std::move(line);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          break;
+        }
+        // the writer has not gotten to this slot yet so the ring is full
+      } else if (diff < 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+        // another thread claimed the slot
+      } else {
+        position = head.load(std::memory_order_relaxed);
+      }
+    }
+    // wake the writer early when half the ring is used rather than waiting for the interval
+    if ((position & (capacity / 2 - 1)) == 0) {
+      wake.notify_one();
+    }
+  }
+
+  // appends the oldest line to the batch, false if there is none
+  bool Pop(std::string& batch) {
+    auto& slot = slots[tail & (capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+      return false;
+    }
+    batch.append(slot.line);
+    slot.line.clear();
+    slot.sequence.store(tail + capacity, std::memory_order_release);
+    ++tail;
+    return true;
+  }
+
+  void Drain() {
+    std::string batch;
+    while (true) {
+      batch.clear();
+      for (size_t lines = 0; lines < capacity && Pop(batch); ++lines) {
+      }
+      auto lost = dropped.exchange(0, std::memory_order_relaxed);
+      if (lost > 0) {
+        batch.append(FormatLine("Dropped " + std::to_string(lost) + " log lines",
+                                sink->Directive(LogLevel::LogWarn)));
+      }
+      // write the whole batch at once
+      if (!batch.empty()) {
+        try {
+          sink->Write(batch);
+        } catch (...) {}
+        continue;
+      }
+      // nothing left to write, wait for more or for the logger to go away
+      std::unique_lock<std::mutex> guard(lock);
+      if (stopped) {
+        break;
+      }
+      wake.wait_for(guard, flush_interval);
+    }
+  }
+
+  std::unique_ptr<LineLogger> sink;
+  std::unique_ptr<slot_t[]> slots;
+  size_t capacity;
+  std::atomic<size_t> head{0};
+  size_t tail{0}; // only the writer moves it
+  std::atomic<uint64_t> dropped{0};
+  std::chrono::milliseconds flush_interval;
+  std::condition_variable wake;
+  bool stopped{false};
+  std::thread writer;
+};
+
+Logger* MakeAsync(const LoggingConfig& config, Logger* logger) {
+#ifndef __ANDROID__
+  if (auto* sink = dynamic_cast<LineLogger*>(logger)) {
+    return new AsyncLogger(config, sink);
+  }
+#endif
+  return logger;
+}
+
 } // namespace logging
 
 // statically get a logger using the factory
@@ -0,0 +1,93 @@
+#include "midgard/numa.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+thread_local uint32_t current_node = 0;
+
+std::vector<std::vector<uint32_t>> list_nodes() {
+  std::vector<std::vector<uint32_t>> nodes;
+#ifdef __linux__
+  // the nodes are numbered from 0 without gaps on all but the most exotic machines
+  for (uint32_t node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) {
+      break;
+    }
+    auto cpus = valhalla::midgard::numa_t::parse_cpu_list(list);
+    if (!cpus.empty()) {
+      nodes.emplace_back(std::move(cpus));
+    }
+  }
+#endif
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    for (uint32_t cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+      nodes.back().push_back(cpu);
+    }
+  }
+  return nodes;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace midgard {
+
+const std::vector<std::vector<uint32_t>>& numa_t::nodes() {
+  static const auto nodes = list_nodes();
+  return nodes;
+}
+
+bool numa_t::pin(uint32_t node) {
+  node %= nodes().size();
+  current_node = node;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : nodes()[node]) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+uint32_t numa_t::current() {
+  return current_node;
+}
+
+std::vector<uint32_t> numa_t::parse_cpu_list(const std::string& list) {
+  std::vector<uint32_t> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    try {
+      const auto dash = range.find('-');
+      const uint32_t first = std::stoul(range.substr(0, dash));
+      const uint32_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (uint32_t cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (...) {
+      // not a cpu or a range of them, e.g. the newline of an empty list
+    }
+  }
+  return cpus;
+}
+
+} // namespace midgard
+} // namespace valhalla
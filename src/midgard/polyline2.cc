@@ -4,7 +4,11 @@
 #include "midgard/point_tile_index.h"
 #include "midgard/util.h"
 
+#include <limits>
 #include <list>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace valhalla {
 namespace midgard {
@@ -70,6 +74,185 @@ template <typename coord_t> std::vector<coord_t> Polyline2<coord_t>::GetSelfInte
   return intersections;
 }
 
+namespace {
+
+// the polylines of the scratch space are released once they are larger than this
+constexpr size_t kMaxScratchPoints = 1 << 20;
+
+/**
+ * Scratch space of the generalizations on a thread. It is kept between calls so that generalizing
+ * does not allocate once the thread has seen a polyline of the size.
+ */
+template <typename coord_t> struct generalize_scratch_t {
+  // the polyline copied into contiguous memory when it is not a vector
+  std::vector<coord_t> points;
+  // the squared distances of the points between the ends of a range to its segment
+  std::vector<typename coord_t::value_type> distances;
+  // the ranges of points still to simplify, the next one at the back
+  std::vector<std::pair<size_t, size_t>> ranges;
+  // whether each point is kept and whether it must not be generalized
+  std::vector<char> keep;
+  std::vector<char> excluded;
+
+  static generalize_scratch_t& get() {
+    thread_local generalize_scratch_t scratch;
+    return scratch;
+  }
+
+  void prepare(size_t count, const std::unordered_set<size_t>& exclusions) {
+    if (distances.capacity() > kMaxScratchPoints) {
+      points = {};
+      distances = {};
+      keep = {};
+      excluded = {};
+    }
+    distances.resize(count);
+    ranges.clear();
+    keep.assign(count, false);
+    excluded.assign(exclusions.empty() ? 0 : count, false);
+    for (auto idx : exclusions) {
+      if (idx < count) {
+        excluded[idx] = true;
+      }
+    }
+  }
+
+  // the rightmost point between the ends of the range which must not be generalized, if any
+  bool find_exclusion(size_t s, size_t e, size_t& idx) const {
+    if (excluded.empty()) {
+      return false;
+    }
+    for (idx = e - 1; idx > s; --idx) {
+      if (excluded[idx]) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/**
+ * Squared distances of contiguous points to the segment from a to b, computed as
+ * LineSegment2::DistanceSquared does but in a loop without calls or branches which compilers
+ * vectorize for planar points.
+ */
+template <typename PrecisionT>
+void distances_squared(const PointXY<PrecisionT>& a,
+                       const PointXY<PrecisionT>& b,
+                       const PointXY<PrecisionT>* points,
+                       size_t count,
+                       PrecisionT* distances) {
+  const PrecisionT vx = b.first - a.first;
+  const PrecisionT vy = b.second - a.second;
+  const PrecisionT d = vx * vx + vy * vy;
+  for (size_t i = 0; i < count; ++i) {
+    const PrecisionT wx = points[i].first - a.first;
+    const PrecisionT wy = points[i].second - a.second;
+    const PrecisionT n = wx * vx + wy * vy;
+    const PrecisionT t = n / d;
+    const PrecisionT x = n <= 0 ? a.first : (d <= n ? b.first : a.first + vx * t);
+    const PrecisionT y = n <= 0 ? a.second : (d <= n ? b.second : a.second + vy * t);
+    distances[i] = (x - points[i].first) * (x - points[i].first) +
+                   (y - points[i].second) * (y - points[i].second);
+  }
+}
+
+/**
+ * The distances of geographic points are approximated at the latitude of the closest point of the
+ * segment, which takes a cosine per point and leaves nothing for the compiler to vectorize.
+ */
+template <typename PrecisionT>
+void distances_squared(const GeoPoint<PrecisionT>& a,
+                       const GeoPoint<PrecisionT>& b,
+                       const GeoPoint<PrecisionT>* points,
+                       size_t count,
+                       PrecisionT* distances) {
+  LineSegment2<GeoPoint<PrecisionT>> segment{a, b};
+  GeoPoint<PrecisionT> closest;
+  for (size_t i = 0; i < count; ++i) {
+    distances[i] = segment.DistanceSquared(points[i], closest);
+  }
+}
+
+/**
+ * The Douglas-Peucker simplification of contiguous points. The ranges to look at are kept on a
+ * stack instead of recursing and the points kept are only marked, so that the polyline is written
+ * once at the end.
+ */
+template <typename coord_t>
+void douglas_peucker(const coord_t* points,
+                     size_t count,
+                     typename coord_t::value_type epsilon_sq,
+                     generalize_scratch_t<coord_t>& scratch) {
+  using prec_t = typename coord_t::value_type;
+  scratch.keep.front() = scratch.keep.back() = true;
+  scratch.ranges.emplace_back(0, count - 1);
+  while (!scratch.ranges.empty()) {
+    size_t s, e;
+    std::tie(s, e) = scratch.ranges.back();
+    scratch.ranges.pop_back();
+
+    // special points we dont want to generalize no matter what take precidence, otherwise find
+    // the point furthest from the line, the rightmost one of equally far points
+    size_t k = s;
+    prec_t dmax = std::numeric_limits<prec_t>::lowest();
+    if (scratch.find_exclusion(s, e, k)) {
+      dmax = epsilon_sq;
+    } else {
+      auto* distances = scratch.distances.data();
+      distances_squared(points[s], points[e], points + s + 1, e - s - 1, distances);
+      for (size_t j = e - 1; j > s; --j) {
+        if (distances[j - s - 1] > dmax) {
+          dmax = distances[j - s - 1];
+          k = j;
+        }
+      }
+    }
+
+    // there are some high frequency details between start and end so we need to look for flatter
+    // sections between them, otherwise nothing sticks out and everything between goes away
+    if (dmax >= epsilon_sq) {
+      scratch.keep[k] = true;
+      if (k - s > 1)
+        scratch.ranges.emplace_back(s, k);
+      if (e - k > 1)
+        scratch.ranges.emplace_back(k, e);
+    }
+  }
+}
+
+/**
+ * Runs the simplification over the points of the polyline in contiguous memory and then keeps the
+ * marked points of the polyline.
+ */
+template <typename coord_t>
+void generalize_contiguous(std::vector<coord_t>& polyline,
+                           typename coord_t::value_type epsilon_sq,
+                           generalize_scratch_t<coord_t>& scratch) {
+  douglas_peucker(polyline.data(), polyline.size(), epsilon_sq, scratch);
+  size_t kept = 0;
+  for (size_t i = 0; i < polyline.size(); ++i) {
+    if (scratch.keep[i]) {
+      polyline[kept++] = polyline[i];
+    }
+  }
+  polyline.resize(kept);
+}
+
+template <typename coord_t>
+void generalize_contiguous(std::list<coord_t>& polyline,
+                           typename coord_t::value_type epsilon_sq,
+                           generalize_scratch_t<coord_t>& scratch) {
+  scratch.points.assign(polyline.begin(), polyline.end());
+  douglas_peucker(scratch.points.data(), scratch.points.size(), epsilon_sq, scratch);
+  size_t i = 0;
+  for (auto p = polyline.begin(); p != polyline.end(); ++i) {
+    p = scratch.keep[i] ? std::next(p) : polyline.erase(p);
+  }
+}
+
+} // namespace
+
 /**
  * A Douglas-Peucker line simplification algorithm that will not generate
  * self-intersections.
@@ -78,135 +261,139 @@ template <typename coord_t> std::vector<coord_t> Polyline2<coord_t>::GetSelfInte
  * this routine employs the PointTileIndex, which indexes space using
  * lats/lons. Hence, this routine only works with PointLL's (aka
  * GeoPoint<double>'s).
+ *
+ * The ranges are simplified from right to left off a stack, the same order the recursion had,
+ * which matters because simplifying a range removes its points from the index.
  */
 void peucker_avoid_self_intersections(PointTileIndex& point_tile_index,
                                       const double& epsilon_sq,
-                                      const std::unordered_set<size_t>& exclusions,
-                                      size_t sidx,
-                                      size_t eidx) {
-
-  while ((exclusions.find(sidx) != exclusions.end()) && (sidx < eidx)) {
-    sidx++;
-  }
-  while ((exclusions.find(eidx) != exclusions.end()) && (eidx > sidx)) {
-    eidx--;
-  }
-  if (sidx >= eidx)
-    return;
+                                      generalize_scratch_t<PointLL>& scratch) {
+  scratch.ranges.emplace_back(0, point_tile_index.points.size() - 1);
+  while (!scratch.ranges.empty()) {
+    size_t sidx, eidx;
+    std::tie(sidx, eidx) = scratch.ranges.back();
+    scratch.ranges.pop_back();
+
+    while (!scratch.excluded.empty() && scratch.excluded[sidx] && (sidx < eidx)) {
+      sidx++;
+    }
+    while (!scratch.excluded.empty() && scratch.excluded[eidx] && (eidx > sidx)) {
+      eidx--;
+    }
+    if (sidx >= eidx)
+      continue;
 
-  const PointLL& start = point_tile_index.points[sidx];
-  const PointLL& end = point_tile_index.points[eidx];
+    const PointLL& start = point_tile_index.points[sidx];
+    const PointLL& end = point_tile_index.points[eidx];
 
-  double dmax = std::numeric_limits<double>::lowest();
-  LineSegment2<PointLL> line_segment{start, end};
+    double dmax = std::numeric_limits<double>::lowest();
+    LineSegment2<PointLL> line_segment{start, end};
 
-  // hfidx is the index of the highest freq detail (the dividing point)
-  size_t hfidx = sidx;
+    // hfidx is the index of the highest freq detail (the dividing point)
+    size_t hfidx = sidx;
 
-  // find the point furthest from the line-segment formed by {start, end}
-  PointLL tmp;
-  for (size_t idx = sidx + 1; idx < eidx; idx++) {
-    // special points we dont want to generalize no matter what take precedence
-    if (exclusions.find(idx) != exclusions.end()) {
-      dmax = epsilon_sq;
-      hfidx = idx;
-      break;
-    }
+    // find the point furthest from the line-segment formed by {start, end}
+    PointLL tmp;
+    for (size_t idx = sidx + 1; idx < eidx; idx++) {
+      // special points we dont want to generalize no matter what take precedence
+      if (!scratch.excluded.empty() && scratch.excluded[idx]) {
+        dmax = epsilon_sq;
+        hfidx = idx;
+        break;
+      }
 
-    const PointLL& c = point_tile_index.points[idx];
+      const PointLL& c = point_tile_index.points[idx];
 
-    // test if this is the highest frequency detail so far
-    auto d = line_segment.DistanceSquared(c, tmp);
-    if (d > dmax) {
-      dmax = d;
-      hfidx = idx;
+      // test if this is the highest frequency detail so far
+      auto d = line_segment.DistanceSquared(c, tmp);
+      if (d > dmax) {
+        dmax = d;
+        hfidx = idx;
+      }
     }
-  }
 
-  // If (dmax < epsilon_sq) then we have a relatively straight line between (start,end).
-  // A standard Douglas-Peucker algorithm would immediately decimate all the points
-  // between (start,end). In this modified version, we use our tiled-point-space to
-  // determine if decimating the line would result in a self-intersection.
-  //
-  // We use our tiled space to determine the points along the "epsilon buffer zone" of
-  // the line (start,end). Because our tiled-point-space is coarse, our
-  // "get_points_near_segment" query will contain points both of interest and not.
-  // Consider this amazing ascii art example:
-  //
-  //                i             k
-  //                 \           /
-  //                  \         /
-  //                   \       /
-  //                    \     /
-  //   s - - - - - - - - - - - - - - - - - - - - - - - - - - - - e
-  //     `  .             \ /                             `
-  //            `  .       j                 .
-  //                  `  c        `
-  //
-  // s=start, e=end. c is a point along the polyline between s & e. We are considering
-  // getting rid of c because it is within epsilon of (a,b).
-  //
-  // All the points shown in this hypothetical example are returned from the call to
-  // "get_points_near_segment".
-  //
-  // As you can see, a completely separate portion of our polygon (i, j, k) would
-  // self-intersect if we simplified. To detect this, we perform a triangle
-  // containment test of point j using the triangle (s, c, e), see that its contained,
-  // and decide not to simplify. While this example only has one point c between
-  // (a,b), there is typically more than one. The logic below will create a triangle
-  // using every point c between start and end and perform containment tests for all
-  // "nearby" points for every (start,c,end) triangle. We can stop as soon as we find
-  // an unexpected point inside our triangle.
-  if (dmax < epsilon_sq) {
-    // This returns the points in the "epsilon buffer zone" along the line (start, end).
-    std::unordered_set<size_t> line_buffer_points =
-        point_tile_index.get_points_near_segment(LineSegment2<PointLL>(start, end));
-
-    // We only care about checking for triangle containment for points that are not
-    // along the polyline [start,end] - so we can remove those straightaway.
-    for (size_t i = sidx; i <= eidx; i++) {
-      line_buffer_points.erase(i);
-    }
+    // If (dmax < epsilon_sq) then we have a relatively straight line between (start,end).
+    // A standard Douglas-Peucker algorithm would immediately decimate all the points
+    // between (start,end). In this modified version, we use our tiled-point-space to
+    // determine if decimating the line would result in a self-intersection.
+    //
+    // We use our tiled space to determine the points along the "epsilon buffer zone" of
+    // the line (start,end). Because our tiled-point-space is coarse, our
+    // "get_points_near_segment" query will contain points both of interest and not.
+    // Consider this amazing ascii art example:
+    //
+    //                i             k
+    //                 \           /
+    //                  \         /
+    //                   \       /
+    //                    \     /
+    //   s - - - - - - - - - - - - - - - - - - - - - - - - - - - - e
+    //     `  .             \ /                             `
+    //            `  .       j                 .
+    //                  `  c        `
+    //
+    // s=start, e=end. c is a point along the polyline between s & e. We are considering
+    // getting rid of c because it is within epsilon of (a,b).
+    //
+    // All the points shown in this hypothetical example are returned from the call to
+    // "get_points_near_segment".
+    //
+    // As you can see, a completely separate portion of our polygon (i, j, k) would
+    // self-intersect if we simplified. To detect this, we perform a triangle
+    // containment test of point j using the triangle (s, c, e), see that its contained,
+    // and decide not to simplify. While this example only has one point c between
+    // (a,b), there is typically more than one. The logic below will create a triangle
+    // using every point c between start and end and perform containment tests for all
+    // "nearby" points for every (start,c,end) triangle. We can stop as soon as we find
+    // an unexpected point inside our triangle.
+    if (dmax < epsilon_sq) {
+      // This returns the points in the "epsilon buffer zone" along the line (start, end).
+      std::unordered_set<size_t> line_buffer_points =
+          point_tile_index.get_points_near_segment(LineSegment2<PointLL>(start, end));
+
+      // We only care about checking for triangle containment for points that are not
+      // along the polyline [start,end] - so we can remove those straightaway.
+      for (size_t i = sidx; i <= eidx; i++) {
+        line_buffer_points.erase(i);
+      }
+
+      bool can_simplify = true;
+      for (size_t cidx = sidx + 1; (cidx < eidx) && can_simplify; cidx++) {
+        const PointLL& c = point_tile_index.points[cidx];
+        for (size_t point_idx : line_buffer_points) {
+          const PointLL& p = point_tile_index.points[point_idx];
+          if (triangle_contains(start, c, end, p)) {
+            can_simplify = false;
+            break;
+          }
+        }
 
-    bool can_simplify = true;
-    for (size_t cidx = sidx + 1; (cidx < eidx) && can_simplify; cidx++) {
-      const PointLL& c = point_tile_index.points[cidx];
-      for (size_t point_idx : line_buffer_points) {
-        const PointLL& p = point_tile_index.points[point_idx];
-        if (triangle_contains(start, c, end, p)) {
-          can_simplify = false;
+        // the moment we realize we cannot simplify we can stop
+        if (!can_simplify) {
           break;
         }
       }
 
-      // the moment we realize we cannot simplify we can stop
-      if (!can_simplify) {
-        break;
+      if (can_simplify) {
+        // Simplify the polyline by removing all points between sidx and eidx
+        // from the point-tile-index (but don't remove sidx or eidx).
+        point_tile_index.remove_points(sidx + 1, eidx);
+      } else {
+        // Simplifying this polyline would result in a self-intersection, so
+        // we cannot. Force a split around hfidx.
+        dmax = epsilon_sq;
       }
     }
 
-    if (can_simplify) {
-      // Simplify the polyline by removing all points between sidx and eidx
-      // from the point-tile-index (but don't remove sidx or eidx).
-      point_tile_index.remove_points(sidx + 1, eidx);
-    } else {
-      // Simplifying this polyline would result in a self-intersection, so
-      // we cannot. Force recursion around hfidx.
-      dmax = epsilon_sq;
+    // if (dmax >= epsilon_sq) there are some high frequency details between start
+    // and end so we need to look for flatter sections between them, the right one first
+    if (dmax >= epsilon_sq) {
+      if (hfidx - sidx > 1)
+        scratch.ranges.emplace_back(sidx, hfidx);
+      if (eidx - hfidx > 1)
+        scratch.ranges.emplace_back(hfidx, eidx);
     }
   }
-
-  // if (dmax >= epsilon_sq) there are some high frequency details between start
-  // and end so we need to look for flatter sections between them.
-  if (dmax >= epsilon_sq) {
-    // we recurse from right to left for two reasons:
-    // 1. we want to preserve iterator validity in the vector version
-    // 2. its the only way to preserve the indices in the keep set
-    if (eidx - hfidx > 1)
-      peucker_avoid_self_intersections(point_tile_index, epsilon_sq, exclusions, hfidx, eidx);
-    if (hfidx - sidx > 1)
-      peucker_avoid_self_intersections(point_tile_index, epsilon_sq, exclusions, sidx, hfidx);
-  }
 }
 
 template <class coord_t, class container_t>
@@ -220,8 +407,9 @@ void DouglastPeuckerAvoidSelfIntersection(container_t& polyline,
   double epsilon_deg = epsilon_m / meters_per_deg;
   PointTileIndex point_tile_index(epsilon_deg, polyline);
 
-  peucker_avoid_self_intersections(point_tile_index, epsilon_m * epsilon_m, exclusions, 0,
-                                   polyline.size() - 1);
+  auto& scratch = generalize_scratch_t<PointLL>::get();
+  scratch.prepare(polyline.size(), exclusions);
+  peucker_avoid_self_intersections(point_tile_index, epsilon_m * epsilon_m, scratch);
 
   // copy the simplified 'points' into 'polyline'
   polyline.clear();
@@ -240,54 +428,9 @@ void DouglasPeucker(container_t& polyline,
   if (epsilon <= 0 || polyline.size() < 3)
     return;
 
-  // the recursive bit
-  epsilon *= epsilon;
-  std::function<void(typename container_t::iterator, size_t, typename container_t::iterator, size_t)>
-      peucker;
-  peucker = [&peucker, &polyline, epsilon, &exclusions](typename container_t::iterator start,
-                                                        size_t s, typename container_t::iterator end,
-                                                        size_t e) {
-    // find the point furthest from the line
-    typename coord_t::value_type dmax = std::numeric_limits<typename coord_t::value_type>::lowest();
-    typename container_t::iterator itr;
-    LineSegment2<coord_t> l{*start, *end};
-    size_t j = e - 1, k = 0;
-    coord_t tmp;
-    for (auto i = std::prev(end); i != start; --i, --j) {
-      // special points we dont want to generalize no matter what take precidence
-      if (exclusions.find(j) != exclusions.end()) {
-        itr = i;
-        dmax = epsilon;
-        k = j;
-        break;
-      }
-
-      // if this is the highest frequency detail so far
-      auto d = l.DistanceSquared(*i, tmp);
-      if (d > dmax) {
-        itr = i;
-        dmax = d;
-        k = j;
-      }
-    }
-
-    // there are some high frequency details between start and end
-    // so we need to look for flatter sections between them
-    if (dmax >= epsilon) {
-      // we recurse from right to left for two reasons:
-      // 1. we want to preserve iterator validity in the vector version
-      // 2. its the only way to preserve the indices in the keep set
-      if (e - k > 1)
-        peucker(itr, k, end, e);
-      if (k - s > 1)
-        peucker(start, s, itr, k);
-    } // nothing sticks out between start and end so simplify everything between away
-    else
-      polyline.erase(std::next(start), end);
-  };
-
-  // recurse!
-  peucker(polyline.begin(), 0, std::prev(polyline.end()), polyline.size() - 1);
+  auto& scratch = generalize_scratch_t<coord_t>::get();
+  scratch.prepare(polyline.size(), exclusions);
+  generalize_contiguous(polyline, epsilon * epsilon, scratch);
 }
 
 /**
@@ -1,5 +1,6 @@
 #include <array>
 #include <cmath>
+#include <limits>
 #include <queue>
 #include <unordered_set>
 #include <vector>
@@ -14,33 +15,38 @@
 
 namespace {
 
-// this is modified to include all pixels that are intersected by the floating point line
-// at each step it decides to either move in the x or y direction based on which pixels midpoint
-// forms a smaller triangle with the line. to avoid edge cases we allow set_pixel to make the
-// the loop bail if we leave the valid drawing region
-void bresenham_line(double x0,
-                    double y0,
-                    double x1,
-                    double y1,
-                    const std::function<bool(int32_t, int32_t)>& set_pixel) {
+// walks all the pixels crossed by the floating point line in the order it crosses them. at each
+// step it moves into the pixel across whichever pixel boundary the line reaches first, how far
+// along the line the next boundary in x and in y is kept up to date so each step only compares and
+// adds. to avoid edge cases we allow set_pixel to make the loop bail if we leave the valid drawing
+// region
+template <class set_pixel_t>
+void dda_line(double x0, double y0, double x1, double y1, set_pixel_t&& set_pixel) {
+  int32_t x = std::floor(x0), y = std::floor(y0);
+  const int32_t end_x = std::floor(x1), end_y = std::floor(y1);
   // this one for sure
-  bool outside = set_pixel(std::floor(x0), std::floor(y0));
-  // steps in the proper direction and constants for shoelace formula
-  double sx = x0 < x1 ? 1 : -1, dx = x1 - x0, x = std::floor(x0) + .5f;
-  double sy = y0 < y1 ? 1 : -1, dy = y1 - y0, y = std::floor(y0) + .5f;
-  // keep going until we make it to the ending pixel
-  while (std::floor(x) != std::floor(x1) || std::floor(y) != std::floor(y1)) {
-    double tx = std::abs(dx * (y - y0) - dy * ((x + sx) - x0));
-    double ty = std::abs(dx * ((y + sy) - y0) - dy * (x - x0));
-    // less error moving in the x
-    if (tx < ty || (tx == ty && y0 == y1)) {
+  bool outside = set_pixel(x, y);
+  // steps in the proper direction, how far along the line a whole pixel is in each direction and
+  // how far along it the next pixel boundary is
+  const double dx = x1 - x0, dy = y1 - y0;
+  const int32_t sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  const double delta_x = dx != 0 ? std::abs(1 / dx) : inf;
+  const double delta_y = dy != 0 ? std::abs(1 / dy) : inf;
+  double next_x = dx != 0 ? (sx > 0 ? x + 1 - x0 : x0 - x) * delta_x : inf;
+  double next_y = dy != 0 ? (sy > 0 ? y + 1 - y0 : y0 - y) * delta_y : inf;
+  // every step gets one pixel closer to the ending pixel, once a coordinate is reached rounding
+  // can't take the line past it
+  for (int32_t steps = std::abs(end_x - x) + std::abs(end_y - y); steps > 0; --steps) {
+    if (y == end_y || (x != end_x && (next_x < next_y || (next_x == next_y && dy == 0)))) {
       x += sx;
-    } // less error moving in the y
-    else {
+      next_x += delta_x;
+    } else {
       y += sy;
+      next_y += delta_y;
     }
     // mark this pixel
-    bool o = set_pixel(std::floor(x), std::floor(y));
+    bool o = set_pixel(x, y);
     if (outside == false && o == true) {
       return;
     }
@@ -241,45 +247,41 @@ template <class coord_t> std::vector<int> Tiles<coord_t>::TileList(const AABB2<c
   return tilelist;
 }
 
-// Get the list of tiles that lie within the specified bounding box. The method finds the tile
-// at the ellipse center. It successively finds neighbors and checks if they are inside or intersect
-// with the ellipse.
+// Get the list of tiles that lie within the specified ellipse.
 template <class coord_t>
 std::vector<int32_t> Tiles<coord_t>::TileList(const Ellipse<coord_t>& e) const {
-  // Create a queue of tiles to check, initialize with the tile at the center of the ellipse
-  int32_t tileid = TileId(e.center());
-  std::queue<int32_t> check_queue;
-  check_queue.push(tileid);
-
-  // Record any tiles added to the check_queue
-  robin_hood::unordered_set<int32_t> checked_tiles;
-  checked_tiles.insert(tileid);
-
-  // Successively check a tile from the queue - if tile bounds are not outside the ellipse then
-  // add to the tile list and find its neighbors. Add them to the check list if not in the checked
-  // tiles list.
   std::vector<int32_t> tile_list;
-  while (!check_queue.empty()) {
-    tileid = check_queue.front();
-    check_queue.pop();
-
-    // Test if the tile bounds is not outside the ellipse (if not the ellipse is inside the tile,
-    // the tile is inside the ellipse, or the tile bounds intersects the ellipse).
-    if (e.DoesIntersect(TileBounds(tileid)) != IntersectCase::kOutside) {
-      tile_list.push_back(tileid);
-
-      // Add neighboring tiles that have not already been checked
-      std::array<int32_t, 4> neighbors = {BottomNeighbor(tileid), TopNeighbor(tileid),
-                                          LeftNeighbor(tileid), RightNeighbor(tileid)};
-      for (const auto nb : neighbors) {
-        if (checked_tiles.find(nb) == checked_tiles.end()) {
-          check_queue.push(nb);
-          checked_tiles.insert(nb);
-        }
+  TileList(e, tile_list);
+  return tile_list;
+}
+
+// Append the tiles that lie within the specified ellipse. Since the ellipse is convex the tiles it
+// touches in a row of its bounding box are next to each other, each row is scanned until they end.
+template <class coord_t>
+void Tiles<coord_t>::TileList(const Ellipse<coord_t>& e, std::vector<int32_t>& tiles) const {
+  const auto box = e.BoundingBox();
+  if (!box.Intersects(tilebounds_)) {
+    return;
+  }
+  const auto bb = box.Intersection(tilebounds_);
+  int32_t minrow = std::max(Row(bb.miny()), 0);
+  int32_t maxrow = std::max(Row(bb.maxy()), 0);
+  int32_t mincol = std::max(Col(bb.minx()), 0);
+  int32_t maxcol = std::max(Col(bb.maxx()), 0);
+  for (int32_t row = minrow; row <= maxrow; ++row) {
+    bool inside = false;
+    int32_t tileid = TileId(mincol, row);
+    for (int32_t col = mincol; col <= maxcol; ++col, ++tileid) {
+      // Test if the tile bounds is not outside the ellipse (if not the ellipse is inside the tile,
+      // the tile is inside the ellipse, or the tile bounds intersects the ellipse).
+      if (e.DoesIntersect(TileBounds(tileid)) != IntersectCase::kOutside) {
+        tiles.push_back(tileid);
+        inside = true;
+      } else if (inside) {
+        break;
       }
     }
   }
-  return tile_list;
 }
 
 // Color a "connectivity map" starting with a sparse map of uncolored tiles.
@@ -351,18 +353,55 @@ void Tiles<coord_t>::ColorMap(std::unordered_map<uint32_t, size_t>& connectivity
   }
 }
 
+template <class coord_t>
+template <class container_t, class set_cell_t>
+void Tiles<coord_t>::Rasterize(const container_t& linestring, set_cell_t&& set_cell) const {
+  // protect against empty linestring
+  if (linestring.empty()) {
+    return;
+  }
+
+  // if coord_t is spherical and the segment uv is sufficiently long then the geodesic along it
+  // cannot be approximated with linear constructs so instead we resample it at a sufficiently
+  // small interval so as to approximate the arc with piecewise linear segments
+  container_t resampled;
+  auto max_meters =
+      std::max(1., subdivision_size_ * .25 *
+                       DistanceApproximator<coord_t>::MetersPerLngDegree(linestring.front().second));
+  if (coord_t::IsSpherical() && Polyline2<coord_t>::Length(linestring) > max_meters) {
+    resampled = resample_spherical_polyline(linestring, max_meters, true);
+  }
+
+  // figure out global subdivision coordinates
+  const auto x = [this](const coord_t& p) {
+    return (p.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
+  };
+  const auto y = [this](const coord_t& p) {
+    return (p.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
+  };
+
+  // a single point is a line that goes nowhere
+  const auto& line = resampled.size() ? resampled : linestring;
+  if (line.size() == 1) {
+    set_cell(static_cast<int32_t>(std::floor(x(line.front()))),
+             static_cast<int32_t>(std::floor(y(line.front()))));
+    return;
+  }
+
+  // pretend the subdivisions are pixels and we are doing line rasterization of each segment
+  for (auto u = line.cbegin(), v = std::next(u); v != line.cend(); u = v++) {
+    dda_line(x(*u), y(*u), x(*v), y(*v), set_cell);
+  }
+}
+
 template <class coord_t>
 template <class container_t>
 std::unordered_map<int32_t, std::unordered_set<unsigned short>>
 Tiles<coord_t>::Intersect(const container_t& linestring) const {
   std::unordered_map<int32_t, std::unordered_set<unsigned short>> intersection;
-  // protect against empty linestring
-  if (linestring.empty()) {
-    return {};
-  }
 
   // what to do when we want to mark a subdivision as containing a segment of this linestring
-  const auto set_pixel = [this, &intersection](int32_t x, int32_t y) {
+  Rasterize(linestring, [this, &intersection](int32_t x, int32_t y) {
     // cant mark ones that are outside the valid range of tiles
     // TODO: wrap coordinates around x and y?
     if (x < 0 || y < 0 || x >= nsubdivisions_ * ncolumns_ || y >= nsubdivisions_ * nrows_) {
@@ -376,61 +415,28 @@ Tiles<coord_t>::Intersect(const container_t& linestring) const {
     unsigned short subdivision = (y % nsubdivisions_) * nsubdivisions_ + (x % nsubdivisions_);
     intersection[tile].insert(subdivision);
     return false;
-  };
+  });
 
-  // if coord_t is spherical and the segment uv is sufficiently long then the geodesic along it
-  // cannot be approximated with linear constructs so instead we resample it at a sufficiently
-  // small interval so as to approximate the arc with piecewise linear segments
-  container_t resampled;
-  auto max_meters =
-      std::max(1., subdivision_size_ * .25 *
-                       DistanceApproximator<coord_t>::MetersPerLngDegree(linestring.front().second));
-  if (coord_t::IsSpherical() && Polyline2<coord_t>::Length(linestring) > max_meters) {
-    resampled = resample_spherical_polyline(linestring, max_meters, true);
-  }
+  // give them back
+  return intersection;
+}
 
-  // for each segment
-  const auto& line = resampled.size() ? resampled : linestring;
-  auto ui = line.cbegin(), vi = line.cbegin();
-  while (vi != line.cend()) {
-    // figure out what the segment is
-    auto u = *ui;
-    auto v = u;
-    std::advance(vi, 1);
-    if (vi != line.cend()) {
-      v = *vi;
-    } else if (line.size() > 1) {
-      return intersection;
-    }
-    ui = vi;
-
-    // figure out global subdivision start and end points
-    auto x0 = (u.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y0 = (u.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
-    auto x1 = (v.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y1 = (v.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
-
-    int ix0 = std::floor(x0), ix1 = std::floor(x1);
-    int iy0 = std::floor(y0), iy1 = std::floor(y1);
-    int dx = ix0 - ix1, dy = iy0 - iy1;
-    int ds = dx * dx + dy * dy;
-    // its likely for our use case that its all in one cell
-    if (ds == 0) {
-      set_pixel(ix0, iy0);
-    }
-    // if not the next most likley thing is adjacent cells
-    else if (ds == 1) {
-      set_pixel(ix0, iy0);
-      set_pixel(ix1, iy1);
+template <class coord_t>
+template <class container_t>
+void Tiles<coord_t>::Intersect(const container_t& linestring, std::vector<cell_t>& cells) const {
+  // segments start in the cell the one before them ended in, which we only keep once
+  const auto first = cells.size();
+  Rasterize(linestring, [this, &cells, first](int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= nsubdivisions_ * ncolumns_ || y >= nsubdivisions_ * nrows_) {
+      return true;
     }
-    // pretend the subdivisions are pixels and we are doing line rasterization
-    else {
-      bresenham_line(x0, y0, x1, y1, set_pixel);
+    cell_t cell((y / nsubdivisions_) * ncolumns_ + x / nsubdivisions_,
+                (y % nsubdivisions_) * nsubdivisions_ + (x % nsubdivisions_));
+    if (cells.size() == first || cells.back() != cell) {
+      cells.push_back(cell);
     }
-  }
-
-  // give them back
-  return intersection;
+    return false;
+  });
 }
 
 template <class coord_t>
@@ -494,6 +500,14 @@ template class std::unordered_map<int32_t, std::unordered_set<unsigned short>>
 Tiles<Point2>::Intersect(const std::vector<Point2>&) const;
 template class std::unordered_map<int32_t, std::unordered_set<unsigned short>>
 Tiles<PointLL>::Intersect(const std::vector<PointLL>&) const;
+template void Tiles<Point2>::Intersect(const std::list<Point2>&,
+                                       std::vector<Tiles<Point2>::cell_t>&) const;
+template void Tiles<PointLL>::Intersect(const std::list<PointLL>&,
+                                        std::vector<Tiles<PointLL>::cell_t>&) const;
+template void Tiles<Point2>::Intersect(const std::vector<Point2>&,
+                                       std::vector<Tiles<Point2>::cell_t>&) const;
+template void Tiles<PointLL>::Intersect(const std::vector<PointLL>&,
+                                        std::vector<Tiles<PointLL>::cell_t>&) const;
 
 } // namespace midgard
 } // namespace valhalla
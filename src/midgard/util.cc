@@ -12,6 +12,7 @@
 #include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <limits>
 #include <list>
 #include <sstream>
 #include <stdlib.h>
@@ -502,6 +503,25 @@ bool triangle_contains(const coord_t& a, const coord_t& b, const coord_t& c, con
   return (u >= 1e-16) && (v >= 1e-16) && (u + v < 1);
 }
 
+uint64_t hilbert_index(uint32_t x, uint32_t y, const uint32_t order) {
+  const uint32_t last = order >= 32 ? std::numeric_limits<uint32_t>::max() : (1u << order) - 1;
+  uint64_t index = 0;
+  for (uint32_t s = (last >> 1) + 1; s > 0; s >>= 1) {
+    const uint32_t rx = (x & s) > 0;
+    const uint32_t ry = (y & s) > 0;
+    index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+    // rotate the quadrant so the curve through it starts and ends where the next one continues
+    if (ry == 0) {
+      if (rx == 1) {
+        x = last - x;
+        y = last - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+
 template bool triangle_contains(const PointXY<float>& a,
                                 const PointXY<float>& b,
                                 const PointXY<float>& c,
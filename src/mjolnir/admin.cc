@@ -3,8 +3,11 @@
 #include "filesystem.h"
 #include "midgard/logging.h"
 #include "mjolnir/util.h"
+#include <algorithm>
+#include <iterator>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
 
 #include <spatialite.h>
 
@@ -28,15 +31,22 @@ sqlite3* GetDBHandle(const std::string& database) {
   return db_handle;
 }
 
-// Get the polygon index.  Used by tz and admin areas.  Checks if the pointLL is covered_by the
-// poly.
-uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys,
-                        const PointLL& ll,
-                        GraphTileBuilder& graphtile) {
+namespace {
+
+const multi_polygon_type& geometry(const multi_polygon_type& poly) {
+  return poly;
+}
+
+const multi_polygon_type& geometry(const multi_polygon_type* poly) {
+  return *poly;
+}
+
+template <typename polys_t>
+uint32_t FindMultiPolyId(const polys_t& polys, const PointLL& ll, GraphTileBuilder& graphtile) {
   uint32_t index = 0;
   point_type p(ll.lng(), ll.lat());
   for (const auto& poly : polys) {
-    if (boost::geometry::covered_by(p, poly.second)) {
+    if (boost::geometry::covered_by(p, geometry(poly.second))) {
       const auto& admin = graphtile.admins_builder(poly.first);
       if (!admin.state_offset())
         index = poly.first;
@@ -47,18 +57,180 @@ uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys
   return index;
 }
 
-// Get the polygon index.  Used by tz and admin areas.  Checks if the pointLL is covered_by the
-// poly.
-uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys, const PointLL& ll) {
+template <typename polys_t> uint32_t FindMultiPolyId(const polys_t& polys, const PointLL& ll) {
   uint32_t index = 0;
   point_type p(ll.lng(), ll.lat());
   for (const auto& poly : polys) {
-    if (boost::geometry::covered_by(p, poly.second))
+    if (boost::geometry::covered_by(p, geometry(poly.second)))
       return poly.first;
   }
   return index;
 }
 
+// Read all the rows of an admin query, the columns are those of the queries in GetAdminInfo
+void ReadAdmins(sqlite3* db_handle, const std::string& sql, std::vector<PolygonIndex::Area>& areas) {
+  sqlite3_stmt* stmt = 0;
+  uint32_t ret = sqlite3_prepare_v2(db_handle, sql.c_str(), sql.length(), &stmt, 0);
+  if (ret == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      PolygonIndex::Area area{};
+      if (sqlite3_column_type(stmt, 0) == SQLITE_TEXT) {
+        area.country_name = (char*)sqlite3_column_text(stmt, 0);
+      }
+      if (sqlite3_column_type(stmt, 1) == SQLITE_TEXT) {
+        area.state_name = (char*)sqlite3_column_text(stmt, 1);
+      }
+      if (sqlite3_column_type(stmt, 2) == SQLITE_TEXT) {
+        area.country_iso = (char*)sqlite3_column_text(stmt, 2);
+      }
+      if (sqlite3_column_type(stmt, 3) == SQLITE_TEXT) {
+        area.state_iso = (char*)sqlite3_column_text(stmt, 3);
+      }
+      area.drive_on_right = true;
+      if (sqlite3_column_type(stmt, 4) == SQLITE_INTEGER) {
+        area.drive_on_right = sqlite3_column_int(stmt, 4);
+      }
+      area.allow_intersection_names = false;
+      if (sqlite3_column_type(stmt, 5) == SQLITE_INTEGER) {
+        area.allow_intersection_names = sqlite3_column_int(stmt, 5);
+      }
+      if (sqlite3_column_type(stmt, 6) == SQLITE_TEXT) {
+        boost::geometry::read_wkt((char*)sqlite3_column_text(stmt, 6), area.geom);
+      }
+      areas.emplace_back(std::move(area));
+    }
+  }
+  if (stmt) {
+    sqlite3_finalize(stmt);
+  }
+}
+
+} // namespace
+
+PolygonIndex::PolygonIndex(std::vector<Area> areas) : areas_(std::move(areas)) {
+  // the range constructor packs the tree in one go instead of inserting box by box
+  std::vector<value_type> boxes;
+  boxes.reserve(areas_.size());
+  for (uint32_t i = 0; i < areas_.size(); ++i) {
+    boxes.emplace_back(boost::geometry::return_envelope<box_type>(areas_[i].geom), i);
+  }
+  rtree_ = decltype(rtree_)(boxes.begin(), boxes.end());
+}
+
+std::vector<const PolygonIndex::Area*> PolygonIndex::Intersecting(const AABB2<PointLL>& aabb) const {
+  box_type box(point_type(aabb.minx(), aabb.miny()), point_type(aabb.maxx(), aabb.maxy()));
+  std::vector<value_type> candidates;
+  rtree_.query(boost::geometry::index::intersects(box), std::back_inserter(candidates));
+  std::sort(candidates.begin(), candidates.end(),
+            [](const value_type& a, const value_type& b) { return a.second < b.second; });
+
+  // the boxes only narrow it down, the polygons themselves have to intersect the tile
+  std::vector<const Area*> areas;
+  for (const auto& candidate : candidates) {
+    const auto& area = areas_[candidate.second];
+    if (boost::geometry::intersects(box, area.geom)) {
+      areas.push_back(&area);
+    }
+  }
+  return areas;
+}
+
+// Get the polygon index.  Used by tz and admin areas.  Checks if the pointLL is covered_by the
+// poly.
+uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys,
+                        const PointLL& ll,
+                        GraphTileBuilder& graphtile) {
+  return FindMultiPolyId(polys, ll, graphtile);
+}
+
+// Get the polygon index.  Used by tz and admin areas.  Checks if the pointLL is covered_by the
+// poly.
+uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys, const PointLL& ll) {
+  return FindMultiPolyId(polys, ll);
+}
+
+// Get the polygon index from the polygons an index found for a tile.
+uint32_t GetMultiPolyId(const polygon_refs& polys, const PointLL& ll, GraphTileBuilder& graphtile) {
+  return FindMultiPolyId(polys, ll, graphtile);
+}
+
+// Get the polygon index from the polygons an index found for a tile.
+uint32_t GetMultiPolyId(const polygon_refs& polys, const PointLL& ll) {
+  return FindMultiPolyId(polys, ll);
+}
+
+// Load all the admin polys of the db into an index.
+std::shared_ptr<const PolygonIndex> LoadAdmins(sqlite3* db_handle) {
+  if (!db_handle) {
+    return nullptr;
+  }
+  auto db_conn = make_spatialite_cache(db_handle);
+
+  // states before countries, the same order GetAdminInfo adds them to a tile in
+  std::vector<PolygonIndex::Area> areas;
+  std::string sql = "SELECT country.name, state.name, country.iso_code, ";
+  sql +=
+      "state.iso_code, state.drive_on_right, state.allow_intersection_names, st_astext(state.geom) ";
+  sql += "from admins state, admins country where ";
+  sql += "country.rowid = state.parent_admin and state.admin_level=4 order by state.rowid;";
+  ReadAdmins(db_handle, sql, areas);
+
+  sql =
+      "SELECT name, \"\", iso_code, \"\", drive_on_right, allow_intersection_names, st_astext(geom) from ";
+  sql += " admins where admin_level=2 order by rowid;";
+  ReadAdmins(db_handle, sql, areas);
+
+  LOG_INFO("Loaded " + std::to_string(areas.size()) + " admin polygons");
+  return std::make_shared<const PolygonIndex>(std::move(areas));
+}
+
+// Load all the timezone polys of the db into an index.
+std::shared_ptr<const PolygonIndex> LoadTimeZones(sqlite3* db_handle) {
+  if (!db_handle) {
+    return nullptr;
+  }
+  auto db_conn = make_spatialite_cache(db_handle);
+
+  std::vector<PolygonIndex::Area> areas;
+  sqlite3_stmt* stmt = 0;
+  std::string sql = "select TZID, st_astext(geom) from tz_world order by rowid;";
+  uint32_t ret = sqlite3_prepare_v2(db_handle, sql.c_str(), sql.length(), &stmt, 0);
+  if (ret == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      std::string tz_id;
+      if (sqlite3_column_type(stmt, 0) == SQLITE_TEXT) {
+        tz_id = (char*)sqlite3_column_text(stmt, 0);
+      }
+      uint32_t idx = DateTime::get_tz_db().to_index(tz_id);
+      if (idx == 0) {
+        continue;
+      }
+
+      PolygonIndex::Area area{};
+      area.tz_index = idx;
+      if (sqlite3_column_type(stmt, 1) == SQLITE_TEXT) {
+        boost::geometry::read_wkt((char*)sqlite3_column_text(stmt, 1), area.geom);
+      }
+      areas.emplace_back(std::move(area));
+    }
+  }
+  if (stmt) {
+    sqlite3_finalize(stmt);
+  }
+
+  LOG_INFO("Loaded " + std::to_string(areas.size()) + " timezone polygons");
+  return std::make_shared<const PolygonIndex>(std::move(areas));
+}
+
+// Get the timezone polys from the index
+polygon_refs GetTimeZones(const PolygonIndex& timezones, const AABB2<PointLL>& aabb) {
+  polygon_refs polys;
+  for (const auto* area : timezones.Intersecting(aabb)) {
+    polys.emplace(area->tz_index, &area->geom);
+  }
+  return polys;
+}
+
 // Get the timezone polys from the db
 std::multimap<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle,
                                                          const AABB2<PointLL>& aabb) {
@@ -235,6 +407,23 @@ GetAdminInfo(sqlite3* db_handle,
   return polys;
 }
 
+// Get the admin polys from the index that intersect with the tile bounding box.
+polygon_refs GetAdminInfo(const PolygonIndex& admins,
+                          std::unordered_map<uint32_t, bool>& drive_on_right,
+                          std::unordered_map<uint32_t, bool>& allow_intersection_names,
+                          const AABB2<PointLL>& aabb,
+                          GraphTileBuilder& tilebuilder) {
+  polygon_refs polys;
+  for (const auto* area : admins.Intersecting(aabb)) {
+    uint32_t index = tilebuilder.AddAdmin(area->country_name, area->state_name, area->country_iso,
+                                          area->state_iso);
+    polys.emplace(index, &area->geom);
+    drive_on_right.emplace(index, area->drive_on_right);
+    allow_intersection_names.emplace(index, area->allow_intersection_names);
+  }
+  return polys;
+}
+
 // Get all the country access records from the db and save them to a map.
 std::unordered_map<std::string, std::vector<int>> GetCountryAccess(sqlite3* db_handle) {
 
@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "baldr/graphconstants.h"
@@ -34,34 +40,35 @@ using namespace valhalla::midgard;
 namespace {
 
 /**
- * a simple singleton to wrap geos setup and tear down as well as conversion to and from boost types
+ * wraps a geos context per thread, the admins are assembled on several threads so we use the
+ * reentrant api, as well as conversion to and from boost types
  */
 struct geos_helper_t {
-  static const geos_helper_t& get() {
-    static geos_helper_t singleton;
-    return singleton;
+  static GEOSContextHandle_t get() {
+    static thread_local geos_helper_t context;
+    return context.handle;
   }
   template <typename striped_container_t>
   static GEOSGeometry* from_striped_container(const striped_container_t& coords) {
     // sadly we dont layout the memory in parallel arrays so we have to copy to geos
-    GEOSCoordSequence* geos_coords = GEOSCoordSeq_create(coords.size(), 2);
+    GEOSCoordSequence* geos_coords = GEOSCoordSeq_create_r(get(), coords.size(), 2);
     for (unsigned int i = 0; i < static_cast<unsigned int>(coords.size()); ++i) {
-      GEOSCoordSeq_setX(geos_coords, i, coords[i].first);
-      GEOSCoordSeq_setY(geos_coords, i, coords[i].second);
+      GEOSCoordSeq_setX_r(get(), geos_coords, i, coords[i].first);
+      GEOSCoordSeq_setY_r(get(), geos_coords, i, coords[i].second);
     }
-    return GEOSGeom_createLinearRing(geos_coords);
+    return GEOSGeom_createLinearRing_r(get(), geos_coords);
   }
   template <typename striped_container_t>
   static striped_container_t to_striped_container(const GEOSGeometry* geometry) {
     // sadly we dont layout the memory in parallel arrays so we have to copy from geos
-    auto* coords = GEOSGeom_getCoordSeq(geometry);
+    auto* coords = GEOSGeom_getCoordSeq_r(get(), geometry);
     unsigned int coords_size;
-    GEOSCoordSeq_getSize(coords, &coords_size);
+    GEOSCoordSeq_getSize_r(get(), coords, &coords_size);
     striped_container_t container;
     container.resize(coords_size);
     for (unsigned int i = 0; i < coords_size; ++i) {
-      GEOSCoordSeq_getX(coords, i, &container[i].first);
-      GEOSCoordSeq_getY(coords, i, &container[i].second);
+      GEOSCoordSeq_getX_r(get(), coords, i, &container[i].first);
+      GEOSCoordSeq_getY_r(get(), coords, i, &container[i].second);
     }
     return container;
   }
@@ -73,12 +80,14 @@ protected:
     vprintf(fmt, ap);
     va_end(ap);
   }
-  geos_helper_t() {
-    initGEOS(message_handler, message_handler);
+  geos_helper_t() : handle(GEOS_init_r()) {
+    GEOSContext_setNoticeHandler_r(handle, message_handler);
+    GEOSContext_setErrorHandler_r(handle, message_handler);
   }
   ~geos_helper_t() {
-    finishGEOS();
+    GEOS_finish_r(handle);
   }
+  GEOSContextHandle_t handle;
 };
 
 /**
@@ -89,29 +98,31 @@ protected:
  * @param inners if some kind of self intersection should cause inners to be created we push them here
  */
 void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<ring_t>& inners) {
+  auto geos = geos_helper_t::get();
   // for collecting polygons
   auto add = [&](auto* geos_poly) {
-    rings.emplace_back(geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing(geos_poly)));
-    for (int i = 0; i < GEOSGetNumInteriorRings(geos_poly); ++i) {
-      auto* inner = GEOSGetInteriorRingN(geos_poly, i);
+    rings.emplace_back(
+        geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing_r(geos, geos_poly)));
+    for (int i = 0; i < GEOSGetNumInteriorRings_r(geos, geos_poly); ++i) {
+      auto* inner = GEOSGetInteriorRingN_r(geos, geos_poly, i);
       inners.push_back(geos_helper_t::to_striped_container<ring_t>(inner));
     }
   };
 
   auto* outer_ring = geos_helper_t::from_striped_container(ring);
-  auto* geos_poly = GEOSGeom_createPolygon(outer_ring, nullptr, 0);
-  auto* buffered = GEOSBuffer(geos_poly, 0, 8);
-  GEOSNormalize(buffered);
-  auto geom_type = GEOSGeomTypeId(buffered);
+  auto* geos_poly = GEOSGeom_createPolygon_r(geos, outer_ring, nullptr, 0);
+  auto* buffered = GEOSBuffer_r(geos, geos_poly, 0, 8);
+  GEOSNormalize_r(geos, buffered);
+  auto geom_type = GEOSGeomTypeId_r(geos, buffered);
   switch (geom_type) {
     case GEOS_POLYGON: {
       add(buffered);
       break;
     }
     case GEOS_MULTIPOLYGON: {
-      for (int i = 0; i < GEOSGetNumGeometries(buffered); ++i) {
-        auto* geom = GEOSGetGeometryN(buffered, i);
-        if (GEOSGeomTypeId(geom) != GEOS_POLYGON)
+      for (int i = 0; i < GEOSGetNumGeometries_r(geos, buffered); ++i) {
+        auto* geom = GEOSGetGeometryN_r(geos, buffered, i);
+        if (GEOSGeomTypeId_r(geos, geom) != GEOS_POLYGON)
           throw std::runtime_error("Unusable geometry type after buffering");
         add(geom);
       }
@@ -120,8 +131,8 @@ void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<rin
     default:
       throw std::runtime_error("Unusable geometry type after buffering");
   }
-  GEOSGeom_destroy(geos_poly);
-  GEOSGeom_destroy(buffered);
+  GEOSGeom_destroy_r(geos, geos_poly);
+  GEOSGeom_destroy_r(geos, buffered);
 }
 
 /**
@@ -129,12 +140,14 @@ void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<rin
  * @param multipolygon  any resulting polygons are output here
  */
 void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
+  auto geos = geos_helper_t::get();
   // for collecting polygons
   auto add = [&](auto* geos_poly) {
     auto& poly = *multipolygon.emplace(multipolygon.end());
-    poly.outer() = geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing(geos_poly));
-    for (int i = 0; i < GEOSGetNumInteriorRings(geos_poly); ++i) {
-      auto* inner = GEOSGetInteriorRingN(geos_poly, i);
+    poly.outer() =
+        geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing_r(geos, geos_poly));
+    for (int i = 0; i < GEOSGetNumInteriorRings_r(geos, geos_poly); ++i) {
+      auto* inner = GEOSGetInteriorRingN_r(geos, geos_poly, i);
       poly.inners().push_back(geos_helper_t::to_striped_container<ring_t>(inner));
     }
   };
@@ -144,19 +157,20 @@ void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
   inner_rings.reserve(polygon.inners().size());
   for (const auto& inner : polygon.inners())
     inner_rings.push_back(geos_helper_t::from_striped_container(inner));
-  auto* geos_poly = GEOSGeom_createPolygon(outer_ring, &inner_rings.front(), inner_rings.size());
-  auto* buffered = GEOSBuffer(geos_poly, 0, 8);
-  GEOSNormalize(buffered);
-  auto geom_type = GEOSGeomTypeId(buffered);
+  auto* geos_poly =
+      GEOSGeom_createPolygon_r(geos, outer_ring, &inner_rings.front(), inner_rings.size());
+  auto* buffered = GEOSBuffer_r(geos, geos_poly, 0, 8);
+  GEOSNormalize_r(geos, buffered);
+  auto geom_type = GEOSGeomTypeId_r(geos, buffered);
   switch (geom_type) {
     case GEOS_POLYGON: {
       add(buffered);
       break;
     }
     case GEOS_MULTIPOLYGON: {
-      for (int i = 0; i < GEOSGetNumGeometries(buffered); ++i) {
-        auto* geom = GEOSGetGeometryN(buffered, i);
-        if (GEOSGeomTypeId(geom) != GEOS_POLYGON)
+      for (int i = 0; i < GEOSGetNumGeometries_r(geos, buffered); ++i) {
+        auto* geom = GEOSGetGeometryN_r(geos, buffered, i);
+        if (GEOSGeomTypeId_r(geos, geom) != GEOS_POLYGON)
           throw std::runtime_error("Unusable geometry type after buffering");
         add(geom);
       }
@@ -165,8 +179,8 @@ void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
     default:
       throw std::runtime_error("Unusable geometry type after buffering");
   }
-  GEOSGeom_destroy(geos_poly);
-  GEOSGeom_destroy(buffered);
+  GEOSGeom_destroy_r(geos, geos_poly);
+  GEOSGeom_destroy_r(geos, buffered);
 }
 
 /**
@@ -351,6 +365,138 @@ multipolygon_t to_multipolygon(const std::pair<std::string, uint64_t>& admin_inf
   return multipolygon;
 }
 
+/**
+ * Assembles the polygons of an admin from the shapes of its member ways
+ * @param admin_data  used to look up ways shape (nodes)
+ * @param admin       the admin to assemble
+ * @return the multipolygon of the admin in wkt or an empty string if it is degenerate
+ */
+std::string to_wkt(const OSMAdminData& admin_data, const OSMAdmin& admin) {
+  std::pair<std::string, uint64_t> admin_info(admin_data.name_offset_map.name(admin.name_index),
+                                              admin.id);
+  LOG_DEBUG("Building admin: " + admin_info.first);
+
+  // do inners and outers separately
+  bool complete = true;
+  std::array<std::vector<ring_t>, 2> outers_inners;
+  for (bool outer : {true, false}) {
+    // grab the ring segments and a lookup to find them when connecting them
+    std::vector<ring_t> lines;
+    std::unordered_multimap<valhalla::midgard::PointLL, size_t> line_lookup;
+    if (!to_segments(admin_data, admin, admin_info.first, outer, lines, line_lookup)) {
+      complete = false;
+      break;
+    }
+    // connect them into a series of one or more rings
+    to_rings(admin_info, lines, line_lookup, outers_inners[!outer], outers_inners[1]);
+  }
+
+  // if we didn't have a complete relation (ie some members were missing) we bail
+  if (!complete || outers_inners.front().empty()) {
+    LOG_WARN(admin_info.first + " (" + std::to_string(admin_info.second) +
+             ") is degenerate and will be skipped");
+    return "";
+  }
+
+  // convert the rings into multipolygons
+  auto multipolygon = to_multipolygon(admin_info, outers_inners.front(), outers_inners.back());
+
+  // convert that into wkt format so we can put it into sqlite
+  std::stringstream ss;
+  ss << std::setprecision(7) << boost::geometry::wkt(multipolygon);
+  return ss.str();
+}
+
+/**
+ * Assembles the admins on several threads and hands their wkt to the one thread writing them to
+ * sqlite, in the order of the admins so the db does not depend on the thread count. The assembly
+ * only runs so far ahead of the writer, so the wkt of the whole planet is never held at once.
+ */
+class AdminAssembler {
+public:
+  AdminAssembler(const OSMAdminData& admin_data, unsigned int thread_count)
+      : admin_data_(admin_data), wkts_(admin_data.admins.size()),
+        assembled_(admin_data.admins.size(), false), window_(64 * thread_count), next_(0),
+        written_(0) {
+    for (unsigned int i = 0; i < thread_count; ++i) {
+      threads_.emplace_back(std::make_shared<std::thread>(&AdminAssembler::Assemble, this));
+    }
+  }
+
+  ~AdminAssembler() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      next_ = admin_data_.admins.size();
+    }
+    changed_.notify_all();
+    for (auto& thread : threads_) {
+      thread->join();
+    }
+  }
+
+  /**
+   * Blocks until the next admin in order is assembled, rethrows what went wrong assembling it.
+   * @param wkt  the multipolygon of the admin or empty if it was degenerate
+   * @return false once all of the admins were taken
+   */
+  bool Next(std::string& wkt) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (written_ == wkts_.size()) {
+      return false;
+    }
+    changed_.wait(lock, [this]() { return error_ || assembled_[written_]; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    wkt = std::move(wkts_[written_++]);
+    lock.unlock();
+    changed_.notify_all();
+    return true;
+  }
+
+protected:
+  void Assemble() {
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() {
+          return error_ || next_ >= wkts_.size() || next_ < written_ + window_;
+        });
+        if (error_ || next_ >= wkts_.size()) {
+          return;
+        }
+        i = next_++;
+      }
+
+      std::string wkt;
+      try {
+        wkt = to_wkt(admin_data_, admin_data_.admins[i]);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wkts_[i] = std::move(wkt);
+        assembled_[i] = true;
+      }
+      changed_.notify_all();
+    }
+  }
+
+  const OSMAdminData& admin_data_;
+  std::vector<std::string> wkts_;
+  std::vector<bool> assembled_;
+  const size_t window_;
+  size_t next_;
+  size_t written_;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<std::shared_ptr<std::thread>> threads_;
+};
+
 } // anonymous namespace
 
 namespace valhalla {
@@ -507,47 +653,22 @@ bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
     return false;
   }
 
-  // initialize geos
-  geos_helper_t::get();
+  // assemble the polygons in parallel while this thread alone writes them
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  LOG_INFO("Assembling " + std::to_string(admin_data.admins.size()) + " admins with " +
+           std::to_string(threads) + " threads...");
+  AdminAssembler assembler(admin_data, threads);
 
   // for each admin area (relation)
   uint32_t count = 0;
+  std::string wkt;
   for (const auto& admin : admin_data.admins) {
+    if (!assembler.Next(wkt) || wkt.empty())
+      continue;
     std::pair<std::string, uint64_t> admin_info(admin_data.name_offset_map.name(admin.name_index),
                                                 admin.id);
-    LOG_DEBUG("Building admin: " + admin_info.first);
-
-    // do inners and outers separately
-    bool complete = true;
-    std::array<std::vector<ring_t>, 2> outers_inners;
-    for (bool outer : {true, false}) {
-      // grab the ring segments and a lookup to find them when connecting them
-      std::vector<ring_t> lines;
-      std::unordered_multimap<valhalla::midgard::PointLL, size_t> line_lookup;
-      if (!to_segments(admin_data, admin, admin_info.first, outer, lines, line_lookup)) {
-        complete = false;
-        break;
-      }
-      // connect them into a series of one or more rings
-      to_rings(admin_info, lines, line_lookup, outers_inners[!outer], outers_inners[1]);
-    }
-
-    // if we didn't have a complete relation (ie some members were missing) we bail
-    if (!complete || outers_inners.front().empty()) {
-      LOG_WARN(admin_info.first + " (" + std::to_string(admin_info.second) +
-               ") is degenerate and will be skipped");
-      continue;
-    }
-
-    // convert the rings into multipolygons
-    auto multipolygon = to_multipolygon(admin_info, outers_inners.front(), outers_inners.back());
-
-    // convert that into wkt format so we can put it into sqlite
-    std::stringstream ss;
-    ss << std::setprecision(7) << boost::geometry::wkt(multipolygon);
-    auto wkt = ss.str();
-    if (wkt.empty())
-      continue;
 
     // load it into sqlite
     count++;
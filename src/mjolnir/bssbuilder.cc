@@ -5,21 +5,21 @@
 #include "mjolnir/graphtilebuilder.h"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <list>
-#include <mutex>
+#include <map>
 #include <thread>
 #include <tuple>
 #include <vector>
 
-#include <boost/range/algorithm.hpp>
-
 #include "baldr/graphconstants.h"
 #include "baldr/graphreader.h"
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
 #include "midgard/logging.h"
 #include "midgard/sequence.h"
+#include "midgard/tiles.h"
 #include "midgard/util.h"
 #include "mjolnir/osmnode.h"
 
@@ -153,6 +153,146 @@ const static auto VALID_EDGE_USES = std::unordered_set<Use>{
 
 };
 
+// The edges of a tile which stations can be connected to, binned into a grid over the tile so that
+// each station only projects onto the edges near it rather than onto all of them
+class EdgeGrid {
+public:
+  struct Candidate {
+    const DirectedEdge* directededge;
+    uint32_t startnode;
+    std::vector<PointLL> shape; // in the direction of the edge
+  };
+
+  explicit EdgeGrid(const GraphTile& tile)
+      : grid_(tile.header()->base_ll(),
+              TileHierarchy::levels().back().tiles.TileSize(),
+              1,
+              1,
+              kGridDim,
+              false),
+        cells_(kGridDim * kGridDim) {
+    std::vector<Tiles<PointLL>::cell_t> crossed;
+    for (uint32_t i = 0; i < tile.header()->nodecount(); ++i) {
+      const NodeInfo* node = tile.node(i);
+      for (uint32_t j = 0; j < node->edge_count(); ++j) {
+        const DirectedEdge* directededge = tile.directededge(node->edge_index() + j);
+        if (!VALID_EDGE_USES.count(directededge->use())) {
+          continue;
+        }
+
+        if ((!(directededge->forwardaccess() & kBicycleAccess) &&
+             !(directededge->forwardaccess() & kPedestrianAccess)) ||
+            directededge->is_shortcut()) {
+          continue;
+        }
+
+        std::vector<PointLL> shape = tile.edgeinfo(directededge).shape();
+        if (!directededge->forward()) {
+          std::reverse(shape.begin(), shape.end());
+        }
+
+        // the parts of an edge outside of the tile are not in the grid so it has to be checked for
+        // every station, the few that leave the tile are easier to always check
+        uint32_t index = candidates_.size();
+        if (std::any_of(shape.begin(), shape.end(), [this](const PointLL& p) {
+              return !grid_.TileBounds().Contains(p);
+            })) {
+          outside_.push_back(index);
+        } else {
+          crossed.clear();
+          grid_.Intersect(shape, crossed);
+          for (const auto& cell : crossed) {
+            auto& bin = cells_[cell.second];
+            if (bin.empty() || bin.back() != index) {
+              bin.push_back(index);
+            }
+          }
+        }
+        candidates_.push_back({directededge, i, std::move(shape)});
+      }
+    }
+    visited_.resize(candidates_.size(), 0);
+  }
+
+  /**
+   * Finds the closest edges with pedestrian and with bicycle access. Ties go to the edge which
+   * comes first in the tile.
+   * @param bss_ll        the station
+   * @param best_ped      the closest edge pedestrians can use, its startnode is left unset if none
+   * @param best_bicycle  the closest edge bicycles can use, its startnode is left unset if none
+   */
+  void Project(const PointLL& bss_ll, BestProjection& best_ped, BestProjection& best_bicycle) {
+    float mindist_ped = std::numeric_limits<float>::max();
+    float mindist_bicycle = std::numeric_limits<float>::max();
+    uint32_t index_ped = 0, index_bicycle = 0;
+    ++stamp_;
+
+    auto project = [&](uint32_t index) {
+      if (visited_[index] == stamp_) {
+        return;
+      }
+      visited_[index] = stamp_;
+      const auto& candidate = candidates_[index];
+      auto this_closest = bss_ll.Project(candidate.shape);
+      auto distance = std::get<1>(this_closest);
+
+      auto update = [&](BestProjection& best, float& mindist, uint32_t& best_index) {
+        if (distance < mindist || (distance == mindist && index < best_index)) {
+          mindist = distance;
+          best_index = index;
+          best.directededge = candidate.directededge;
+          best.startnode = candidate.startnode;
+          best.closest = this_closest;
+        }
+      };
+      if (candidate.directededge->forwardaccess() & kPedestrianAccess) {
+        update(best_ped, mindist_ped, index_ped);
+      }
+      if (candidate.directededge->forwardaccess() & kBicycleAccess) {
+        update(best_bicycle, mindist_bicycle, index_bicycle);
+      }
+    };
+
+    // cells come closest first, once a cell is further than both best edges nothing in it or
+    // beyond it can be closer. the slack covers the rounding of the cell distances
+    auto closest = grid_.ClosestFirst(bss_ll);
+    for (size_t i = 0; i < cells_.size(); ++i) {
+      auto cell = closest();
+      if (std::get<2>(cell) > std::max(mindist_ped, mindist_bicycle) + kSlackMeters) {
+        break;
+      }
+      if (std::get<0>(cell) != 0) {
+        continue;
+      }
+      for (auto index : cells_[std::get<1>(cell)]) {
+        project(index);
+      }
+    }
+    for (auto index : outside_) {
+      project(index);
+    }
+
+    // only the winners need their shapes copied
+    if (best_ped.directededge) {
+      best_ped.shape = candidates_[index_ped].shape;
+    }
+    if (best_bicycle.directededge) {
+      best_bicycle.shape = candidates_[index_bicycle].shape;
+    }
+  }
+
+private:
+  static constexpr unsigned short kGridDim = 32;
+  static constexpr float kSlackMeters = 1.f;
+
+  Tiles<PointLL> grid_;
+  std::vector<Candidate> candidates_;           // in the order of the nodes and their edges
+  std::vector<std::vector<uint32_t>> cells_;    // the candidates crossing each cell
+  std::vector<uint32_t> outside_;               // the candidates leaving the tile
+  std::vector<uint32_t> visited_;               // the station a candidate was last projected for
+  uint32_t stamp_ = 0;
+};
+
 std::vector<BSSConnection> project(const GraphTile& local_tile, const std::vector<OSMNode>& osm_bss) {
   auto t1 = std::chrono::high_resolution_clock::now();
   auto scoped_finally = make_finally([&t1, size = osm_bss.size()]() {
@@ -165,65 +305,17 @@ std::vector<BSSConnection> project(const GraphTile& local_tile, const std::vecto
   std::vector<BSSConnection> res;
   auto local_level = TileHierarchy::levels().back().level;
 
-  std::map<GraphId, size_t> edge_count;
-
-  // In this loop, we try to find the way on which to project the bss node by iterating all nodes in
-  // its corresponding tile... Not a good idea in term of performance... any better idea???
+  // the edges are looked at once per tile rather than once per station
+  EdgeGrid edges(local_tile);
   for (const auto& bss : osm_bss) {
 
     auto latlng = bss.latlng();
     auto bss_ll = PointLL{latlng.first, latlng.second};
 
-    float mindist_ped = std::numeric_limits<float>::max();
-    float mindist_bicycle = std::numeric_limits<float>::max();
-
     auto best_ped = BestProjection{};
     auto best_bicycle = BestProjection{};
+    edges.Project(bss_ll, best_ped, best_bicycle);
 
-    // Loop over all nodes in the tile to find the nearest edge
-    for (uint32_t i = 0; i < local_tile.header()->nodecount(); ++i) {
-      const NodeInfo* node = local_tile.node(i);
-      for (uint32_t j = 0; j < node->edge_count(); ++j) {
-        const DirectedEdge* directededge = local_tile.directededge(node->edge_index() + j);
-        auto edgeinfo = local_tile.edgeinfo(directededge);
-
-        auto found = VALID_EDGE_USES.count(directededge->use());
-        if (!found) {
-          continue;
-        }
-
-        if ((!(directededge->forwardaccess() & kBicycleAccess) &&
-             !(directededge->forwardaccess() & kPedestrianAccess)) ||
-            directededge->is_shortcut()) {
-          continue;
-        }
-
-        std::vector<PointLL> this_shape = edgeinfo.shape();
-        if (!directededge->forward()) {
-          std::reverse(this_shape.begin(), this_shape.end());
-        }
-        auto this_closest = bss_ll.Project(this_shape);
-
-        if (directededge->forwardaccess() & kPedestrianAccess) {
-          if (std::get<1>(this_closest) < mindist_ped) {
-            mindist_ped = std::get<1>(this_closest);
-            best_ped.directededge = directededge;
-            best_ped.shape = this_shape;
-            best_ped.closest = this_closest;
-            best_ped.startnode = i;
-          }
-        }
-        if (directededge->forwardaccess() & kBicycleAccess) {
-          if (std::get<1>(this_closest) < mindist_bicycle) {
-            mindist_bicycle = std::get<1>(this_closest);
-            best_bicycle.directededge = directededge;
-            best_bicycle.shape = this_shape;
-            best_bicycle.closest = this_closest;
-            best_bicycle.startnode = i;
-          }
-        }
-      }
-    }
     if (best_ped.startnode == static_cast<uint32_t>(-1) ||
         best_bicycle.startnode == static_cast<uint32_t>(-1)) {
       LOG_ERROR("Cannot find any edge to project the BSS: " + std::to_string(bss.osmid_));
@@ -276,14 +368,12 @@ std::vector<BSSConnection> project(const GraphTile& local_tile, const std::vecto
 void add_bss_nodes_and_edges(GraphTileBuilder& tilebuilder_local,
                              const GraphTile& tile,
                              const OSMData& osm_data,
-                             std::mutex& lock,
                              std::vector<BSSConnection>& new_connections) {
   auto local_level = TileHierarchy::levels().back().level;
-  auto scoped_finally = make_finally([&tilebuilder_local, &tile, &lock]() {
+  auto scoped_finally = make_finally([&tilebuilder_local, &tile]() {
     LOG_INFO("Storing local tile data with bss nodes, tile id: " +
              std::to_string(tile.id().tileid()));
     UNUSED(tile);
-    std::lock_guard<std::mutex> l(lock);
     tilebuilder_local.StoreTileData();
   });
 
@@ -338,42 +428,36 @@ void add_bss_nodes_and_edges(GraphTileBuilder& tilebuilder_local,
   }
 }
 
+// Each thread takes the next tile until there are none left. Every tile is read, projected onto and
+// written by a single thread so they need no locking, the connections are kept per tile
 void project_and_add_bss_nodes(const boost::property_tree::ptree& pt,
-                               std::mutex& lock,
-                               bss_by_tile_t::const_iterator tile_start,
-                               bss_by_tile_t::const_iterator tile_end,
+                               std::atomic<size_t>& next_tile,
+                               const std::vector<bss_by_tile_t::const_iterator>& tiles,
                                const OSMData& osm_data,
-                               std::vector<BSSConnection>& all) {
+                               std::vector<std::vector<BSSConnection>>& connections) {
 
   GraphReader reader_local_level(pt);
-  for (; tile_start != tile_end; ++tile_start) {
-
-    graph_tile_ptr local_tile = nullptr;
-    std::unique_ptr<GraphTileBuilder> tilebuilder_local = nullptr;
-    {
-      std::lock_guard<std::mutex> l(lock);
+  for (size_t i = next_tile++; i < tiles.size(); i = next_tile++) {
+    auto tile_id = tiles[i]->first;
+    graph_tile_ptr local_tile = reader_local_level.GetGraphTile(tile_id);
+    GraphTileBuilder tilebuilder_local{reader_local_level.tile_dir(), tile_id, true};
 
-      auto tile_id = tile_start->first;
-      local_tile = reader_local_level.GetGraphTile(tile_id);
-      tilebuilder_local.reset(new GraphTileBuilder{reader_local_level.tile_dir(), tile_id, true});
-    }
+    connections[i] = project(*local_tile, tiles[i]->second);
+    add_bss_nodes_and_edges(tilebuilder_local, *local_tile, osm_data, connections[i]);
 
-    auto new_connections = project(*local_tile, tile_start->second);
-    add_bss_nodes_and_edges(*tilebuilder_local, *local_tile, osm_data, lock, new_connections);
-    {
-      std::lock_guard<std::mutex> l{lock};
-      std::move(new_connections.begin(), new_connections.end(), std::back_inserter(all));
+    // only the tile cache is needed across tiles, the tile itself is not looked at again
+    if (reader_local_level.OverCommitted()) {
+      reader_local_level.Trim();
     }
   }
 }
 
 void create_edges(GraphTileBuilder& tilebuilder_local,
                   const GraphTile& tile,
-                  std::mutex& lock,
                   const std::vector<BSSConnection>& bss_connections) {
   auto t1 = std::chrono::high_resolution_clock::now();
 
-  auto scoped_finally = make_finally([&tilebuilder_local, &tile, &lock, t1]() {
+  auto scoped_finally = make_finally([&tilebuilder_local, &tile, t1]() {
     auto t2 = std::chrono::high_resolution_clock::now();
     uint32_t secs = std::chrono::duration_cast<std::chrono::seconds>(t2 - t1).count();
 
@@ -381,7 +465,6 @@ void create_edges(GraphTileBuilder& tilebuilder_local,
              " seconds to create edges. Now storing local tile data with new edges");
     UNUSED(tile);
     UNUSED(secs);
-    std::lock_guard<std::mutex> l(lock);
     tilebuilder_local.StoreTileData();
   });
 
@@ -488,25 +571,24 @@ void create_edges(GraphTileBuilder& tilebuilder_local,
   LOG_INFO(std::string("Added: ") + std::to_string(added_edges) + " edges");
 }
 
+using connections_by_tile_t = std::map<GraphId, std::vector<BSSConnection>>;
+
+// Each thread takes the next tile of way nodes until there are none left
 void create_edges_from_way_node(
     const boost::property_tree::ptree& pt,
-    std::mutex& lock,
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_start,
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_end) {
+    std::atomic<size_t>& next_tile,
+    const std::vector<connections_by_tile_t::const_iterator>& tiles) {
 
   GraphReader reader_local_level(pt);
-  for (; tile_start != tile_end; ++tile_start) {
-
-    graph_tile_ptr local_tile = nullptr;
-    std::unique_ptr<GraphTileBuilder> tilebuilder_local = nullptr;
-    {
-      std::lock_guard<std::mutex> l(lock);
-
-      auto tile_id = tile_start->first;
-      local_tile = reader_local_level.GetGraphTile(tile_id);
-      tilebuilder_local.reset(new GraphTileBuilder{reader_local_level.tile_dir(), tile_id, true});
+  for (size_t i = next_tile++; i < tiles.size(); i = next_tile++) {
+    auto tile_id = tiles[i]->first;
+    graph_tile_ptr local_tile = reader_local_level.GetGraphTile(tile_id);
+    GraphTileBuilder tilebuilder_local{reader_local_level.tile_dir(), tile_id, true};
+    create_edges(tilebuilder_local, *local_tile, tiles[i]->second);
+
+    if (reader_local_level.OverCommitted()) {
+      reader_local_level.Trim();
     }
-    create_edges(*tilebuilder_local, *local_tile, lock, tile_start->second);
   }
 }
 
@@ -616,80 +698,62 @@ void BssBuilder::Build(const boost::property_tree::ptree& pt,
   size_t nb_threads =
       std::max(static_cast<uint32_t>(1),
                pt.get<uint32_t>("mjolnir.concurrency", std::thread::hardware_concurrency()));
-  std::vector<std::shared_ptr<std::thread>> threads(nb_threads);
 
-  // An atomic object we can use to do the synchronization
-  std::mutex lock;
+  // the tiles go out one at a time so a thread with a tile full of stations doesn't hold up the
+  // rest, they are in id order so that the connections come out the same for any thread count
+  std::vector<bss_by_tile_t::const_iterator> bss_tiles;
+  for (auto it = bss_by_tile.cbegin(); it != bss_by_tile.cend(); ++it) {
+    bss_tiles.push_back(it);
+  }
+  std::sort(bss_tiles.begin(), bss_tiles.end(),
+            [](const auto& a, const auto& b) { return a->first < b->first; });
+  nb_threads = std::min(nb_threads, std::max<size_t>(bss_tiles.size(), 1));
 
   // Start the threads
   LOG_INFO("Adding " + std::to_string(osm_nodes.size()) + " bike share stations to " +
            std::to_string(bss_by_tile.size()) + " local graphs with " + std::to_string(nb_threads) +
            " thread(s)");
 
-  std::vector<BSSConnection> all;
+  std::vector<std::vector<BSSConnection>> connections(bss_tiles.size());
   {
-    size_t floor = bss_by_tile.size() / threads.size();
-    size_t at_ceiling = bss_by_tile.size() - (threads.size() * floor);
-    bss_by_tile_t::const_iterator tile_start, tile_end = bss_by_tile.begin();
-
-    for (size_t i = 0; i < threads.size(); ++i) {
-      // Figure out how many this thread will work on (either ceiling or floor)
-      size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-      // Where the range begins
-      tile_start = tile_end;
-      // Where the range ends
-      std::advance(tile_end, tile_count);
-      // Make the thread
-      threads[i].reset(new std::thread(project_and_add_bss_nodes, std::cref(pt.get_child("mjolnir")),
-                                       std::ref(lock), tile_start, tile_end, std::cref(osmdata),
-                                       std::ref(all)));
+    std::atomic<size_t> next_tile(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nb_threads; ++i) {
+      threads.emplace_back(project_and_add_bss_nodes, std::cref(pt.get_child("mjolnir")),
+                           std::ref(next_tile), std::cref(bss_tiles), std::cref(osmdata),
+                           std::ref(connections));
     }
-
     for (auto& thread : threads) {
-      thread->join();
+      thread.join();
     }
   }
 
-  // the collection is sorted so that the search will be much faster later.
-  boost::sort(all);
-
-  // outboud edges from way node are grouped by tiles.
-  std::unordered_map<GraphId, std::vector<BSSConnection>> map;
-  if (!all.empty()) {
-    auto chunk_start = all.begin();
-    do {
-      auto tileid = chunk_start->way_node_id.tileid();
-      auto chunk_end = std::stable_partition(chunk_start, all.end(), [tileid](const auto& conn) {
-        return tileid == conn.way_node_id.tileid();
-      });
-
-      std::move(chunk_start, chunk_end, std::back_inserter(map[{tileid, local_level, 0}]));
-
-      chunk_start = chunk_end;
+  // outbound edges from way nodes are grouped by tiles and sorted by way node so that the search
+  // will be much faster later
+  connections_by_tile_t map;
+  for (auto& tile_connections : connections) {
+    for (auto& conn : tile_connections) {
+      auto& way_node_tile = map[{conn.way_node_id.tileid(), local_level, 0}];
+      way_node_tile.emplace_back(std::move(conn));
+    }
+  }
+  connections.clear();
 
-    } while (chunk_start != all.end());
+  std::vector<connections_by_tile_t::const_iterator> way_node_tiles;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    std::stable_sort(it->second.begin(), it->second.end());
+    way_node_tiles.push_back(it);
   }
 
   {
-    size_t floor = map.size() / threads.size();
-    size_t at_ceiling = map.size() - (threads.size() * floor);
-    std::unordered_map<GraphId, std::vector<BSSConnection>>::const_iterator tile_start,
-        tile_end = map.begin();
-
-    for (size_t i = 0; i < threads.size(); ++i) {
-      // Figure out how many this thread will work on (either ceiling or floor)
-      size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-      // Where the range begins
-      tile_start = tile_end;
-      // Where the range ends
-      std::advance(tile_end, tile_count);
-      // Make the thread
-      threads[i].reset(new std::thread(create_edges_from_way_node, std::cref(pt.get_child("mjolnir")),
-                                       std::ref(lock), tile_start, tile_end));
+    std::atomic<size_t> next_tile(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(nb_threads, std::max<size_t>(way_node_tiles.size(), 1)); ++i) {
+      threads.emplace_back(create_edges_from_way_node, std::cref(pt.get_child("mjolnir")),
+                           std::ref(next_tile), std::cref(way_node_tiles));
     }
-
     for (auto& thread : threads) {
-      thread->join();
+      thread.join();
     }
   }
 }
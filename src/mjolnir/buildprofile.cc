@@ -0,0 +1,207 @@
+#include "mjolnir/buildprofile.h"
+
+#include "baldr/graphreader.h"
+#include "baldr/json.h"
+#include "midgard/logging.h"
+
+#include <cpp-statsd-client/StatsdClient.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// reads a number following a key out of a /proc/self file, 0 if it cannot
+uint64_t read_proc_value(const std::string& file, const std::string& key) {
+  std::ifstream proc(file);
+  std::string line;
+  while (std::getline(proc, line)) {
+    if (line.compare(0, key.size(), key) == 0) {
+      return std::stoull(line.substr(key.size()));
+    }
+  }
+  return 0;
+}
+
+// linux lets a process reset its peak resident memory so that each stage gets its own peak
+bool reset_peak_rss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  return static_cast<bool>(clear_refs << "5" << std::flush);
+}
+
+uint64_t peak_rss_bytes() {
+  // VmHWM follows the resets, ru_maxrss is the peak of the whole process
+  auto peak = read_proc_value("/proc/self/status", "VmHWM:") * 1024;
+#ifndef _WIN32
+  if (peak == 0) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    peak = usage.ru_maxrss;
+#else
+    peak = usage.ru_maxrss * 1024;
+#endif
+  }
+#endif
+  return peak;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+BuildProfile::BuildProfile(const boost::property_tree::ptree& config)
+    : config_(config), concurrency_(1), running_(false), stage_(BuildStage::kInvalid), start_{} {
+  concurrency_ = std::max(config.get<unsigned int>("mjolnir.concurrency",
+                                                   std::thread::hardware_concurrency()),
+                          1u);
+}
+
+BuildProfile::Usage BuildProfile::Sample() {
+  Usage usage{std::chrono::steady_clock::now(), 0, 0, 0};
+#ifndef _WIN32
+  rusage self{};
+  getrusage(RUSAGE_SELF, &self);
+  usage.cpu_secs = self.ru_utime.tv_sec + self.ru_utime.tv_usec / 1e6 + self.ru_stime.tv_sec +
+                   self.ru_stime.tv_usec / 1e6;
+  // storage io of the process where linux tells it, blocks of 512 bytes elsewhere
+  usage.bytes_read = read_proc_value("/proc/self/io", "read_bytes:");
+  usage.bytes_written = read_proc_value("/proc/self/io", "write_bytes:");
+  if (usage.bytes_read == 0 && usage.bytes_written == 0) {
+    usage.bytes_read = static_cast<uint64_t>(self.ru_inblock) * 512;
+    usage.bytes_written = static_cast<uint64_t>(self.ru_oublock) * 512;
+  }
+#endif
+  return usage;
+}
+
+void BuildProfile::Start(BuildStage stage) {
+  Stop();
+  reset_peak_rss();
+  stage_ = stage;
+  running_ = true;
+  start_ = Sample();
+}
+
+void BuildProfile::Stop() {
+  if (!running_) {
+    return;
+  }
+  running_ = false;
+  auto end = Sample();
+
+  Stage stage{};
+  stage.stage = stage_;
+  stage.wall_secs = std::chrono::duration<double>(end.time - start_.time).count();
+  stage.cpu_secs = end.cpu_secs - start_.cpu_secs;
+  stage.peak_rss_bytes = peak_rss_bytes();
+  stage.bytes_read = end.bytes_read - start_.bytes_read;
+  stage.bytes_written = end.bytes_written - start_.bytes_written;
+  if (BuildStage::kBuild <= stage_ && stage_ <= BuildStage::kValidate) {
+    GraphReader reader(config_.get_child("mjolnir"));
+    stage.tiles = reader.GetTileSet().size();
+  }
+  if (stage.wall_secs > 0) {
+    stage.tiles_per_sec = stage.tiles / stage.wall_secs;
+    stage.thread_utilization = stage.cpu_secs / (stage.wall_secs * concurrency_);
+  }
+  stages_.push_back(stage);
+
+  LOG_INFO("Stage " + to_string(stage.stage) + " took " + std::to_string(stage.wall_secs) +
+           "s wall, " + std::to_string(stage.cpu_secs) + "s cpu, peak rss " +
+           std::to_string(stage.peak_rss_bytes >> 20) + "MB");
+}
+
+std::string BuildProfile::ToJson() const {
+  auto stages = json::array({});
+  double wall_secs = 0, cpu_secs = 0;
+  uint64_t peak_rss = 0, bytes_read = 0, bytes_written = 0;
+  for (const auto& stage : stages_) {
+    stages->emplace_back(json::map({
+        {"stage", to_string(stage.stage)},
+        {"wall_secs", json::fixed_t{stage.wall_secs, 3}},
+        {"cpu_secs", json::fixed_t{stage.cpu_secs, 3}},
+        {"peak_rss_bytes", stage.peak_rss_bytes},
+        {"bytes_read", stage.bytes_read},
+        {"bytes_written", stage.bytes_written},
+        {"tiles", stage.tiles},
+        {"tiles_per_sec", json::fixed_t{stage.tiles_per_sec, 3}},
+        {"thread_utilization", json::fixed_t{stage.thread_utilization, 3}},
+    }));
+    wall_secs += stage.wall_secs;
+    cpu_secs += stage.cpu_secs;
+    peak_rss = std::max(peak_rss, stage.peak_rss_bytes);
+    bytes_read += stage.bytes_read;
+    bytes_written += stage.bytes_written;
+  }
+  std::stringstream report;
+  report << *json::map({
+      {"concurrency", static_cast<uint64_t>(concurrency_)},
+      {"wall_secs", json::fixed_t{wall_secs, 3}},
+      {"cpu_secs", json::fixed_t{cpu_secs, 3}},
+      {"peak_rss_bytes", peak_rss},
+      {"bytes_read", bytes_read},
+      {"bytes_written", bytes_written},
+      {"stages", stages},
+  });
+  return report.str();
+}
+
+void BuildProfile::Report() {
+  Stop();
+  auto report = ToJson();
+  LOG_INFO("Build profile: " + report);
+
+  auto file = config_.get<std::string>("mjolnir.build_profile", "");
+  if (!file.empty()) {
+    std::ofstream handle(file);
+    handle << report;
+    if (!handle) {
+      LOG_ERROR("Could not write the build profile to " + file);
+    }
+  }
+
+  auto host = config_.get<std::string>("statsd.host", "");
+  if (host.empty()) {
+    return;
+  }
+  Statsd::StatsdClient statsd(host, config_.get<int>("statsd.port", 8125),
+                              config_.get<std::string>("statsd.prefix", ""),
+                              config_.get<uint64_t>("statsd.batch_size", 500), 0);
+  if (!statsd.errorMessage().empty()) {
+    LOG_ERROR(statsd.errorMessage());
+    return;
+  }
+  std::vector<std::string> tags;
+  if (auto added_tags = config_.get_child_optional("statsd.tags")) {
+    for (const auto& tag : *added_tags) {
+      tags.push_back(tag.second.data());
+    }
+  }
+  for (const auto& stage : stages_) {
+    const auto key = "mjolnir.build." + to_string(stage.stage) + ".";
+    auto gauge = [&](const std::string& name, double value) {
+      statsd.gauge(key + name, static_cast<unsigned int>(value + 0.5), 1.f, tags);
+    };
+    statsd.timing(key + "wall", static_cast<unsigned int>(stage.wall_secs * 1000 + 0.5), 1.f, tags);
+    statsd.timing(key + "cpu", static_cast<unsigned int>(stage.cpu_secs * 1000 + 0.5), 1.f, tags);
+    gauge("peak_rss_mb", stage.peak_rss_bytes / 1048576.0);
+    gauge("read_mb", stage.bytes_read / 1048576.0);
+    gauge("written_mb", stage.bytes_written / 1048576.0);
+    gauge("tiles_per_sec", stage.tiles_per_sec);
+    gauge("thread_utilization_pct", stage.thread_utilization * 100);
+  }
+  statsd.flush();
+}
+
+} // namespace mjolnir
+} // namespace valhalla
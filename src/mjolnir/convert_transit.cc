@@ -9,6 +9,7 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "baldr/rapidjson_utils.h"
@@ -542,6 +543,9 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 
   std::set<uint64_t> added_stations;
   std::set<uint64_t> added_egress;
+  // the stops of the neighbouring pbf tiles transit lines end in, every line ending there would
+  // read the whole tile again otherwise
+  std::unordered_map<GraphId, Transit> end_tiles;
 
   // Data looks like the following.stop_index(
   // Egress1_for_Station_A
@@ -900,15 +904,19 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
         endstopname = endplatform.name();
         endll = {endplatform.lon(), endplatform.lat()};
       } else {
-        // Get Transit PBF data for this tile
-        // Get transit pbf tile
-        std::string file_name = GraphTile::FileSuffix(
-            GraphId(end_platform_graphid.tileid(), end_platform_graphid.level(), 0));
-        boost::algorithm::trim_if(file_name, boost::is_any_of(".gph"));
-        file_name += ".pbf";
-        const std::string file = transit_dir + filesystem::path::preferred_separator + file_name;
-        Transit endtransit = read_pbf(file, lock);
-        const Transit_Node& endplatform = endtransit.nodes(end_platform_graphid.id());
+        // Get Transit PBF data for this tile, only its stops are kept
+        auto end_tile = end_tiles.find(end_platform_graphid.Tile_Base());
+        if (end_tile == end_tiles.end()) {
+          std::string file_name = GraphTile::FileSuffix(end_platform_graphid.Tile_Base());
+          boost::algorithm::trim_if(file_name, boost::is_any_of(".gph"));
+          file_name += ".pbf";
+          const std::string file = transit_dir + filesystem::path::preferred_separator + file_name;
+          Transit endtransit = read_pbf(file, lock);
+          Transit endstops;
+          endstops.mutable_nodes()->Swap(endtransit.mutable_nodes());
+          end_tile = end_tiles.emplace(end_platform_graphid.Tile_Base(), std::move(endstops)).first;
+        }
+        const Transit_Node& endplatform = end_tile->second.nodes(end_platform_graphid.id());
         endstopname = endplatform.name();
         endll = {endplatform.lon(), endplatform.lat()};
       }
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <ostream>
 
@@ -32,6 +33,43 @@ void EdgeInfoBuilder::set_mean_elevation(const float mean_elev) {
   }
 }
 
+// Set the elevation profile. The first sample is stored as its bin, the others as the difference
+// to the bin of the sample before them.
+void EdgeInfoBuilder::set_elevation(const std::vector<float>& elevation) {
+  encoded_elevation_.clear();
+  if (elevation.size() < 2) {
+    return;
+  }
+  if (elevation.size() > kMaxElevationSamples) {
+    LOG_WARN("Exceeding max elevation samples: " + std::to_string(elevation.size()));
+    return;
+  }
+
+  const auto bin = [](const float elev) {
+    const float max_bin = (kMaxElevation - kMinElevation) / kElevationProfileBinSize;
+    return static_cast<int32_t>(
+        std::round(std::min(std::max((elev - kMinElevation) / kElevationProfileBinSize, 0.f),
+                            max_bin)));
+  };
+  const uint16_t count = static_cast<uint16_t>(elevation.size());
+  const uint16_t first_bin = static_cast<uint16_t>(bin(elevation.front()));
+  encoded_elevation_.append(reinterpret_cast<const char*>(&count), sizeof(count));
+  encoded_elevation_.append(reinterpret_cast<const char*>(&first_bin), sizeof(first_bin));
+
+  // the differences are relative to what was stored so errors don't add up along the edge
+  int32_t stored = first_bin;
+  for (auto elev = std::next(elevation.cbegin()); elev != elevation.cend(); ++elev) {
+    const int32_t delta = std::min(std::max(bin(*elev) - stored, -128), 127);
+    encoded_elevation_.push_back(static_cast<char>(static_cast<int8_t>(delta)));
+    stored += delta;
+  }
+}
+
+// Set the encoded elevation profile.
+void EdgeInfoBuilder::set_encoded_elevation(const std::string& encoded_elevation) {
+  encoded_elevation_ = encoded_elevation;
+}
+
 // Sets the bike network mask indicating which (if any) bicycle networks are
 // along this edge. See baldr/directededge.h for definitions.
 void EdgeInfoBuilder::set_bike_network(const uint32_t bike_network) {
@@ -86,6 +124,7 @@ std::size_t EdgeInfoBuilder::BaseSizeOf() const {
   size += (name_info_list_.size() * sizeof(NameInfo));
   size += (encoded_shape_.size() * sizeof(std::string::value_type));
   size += ei_.extended_wayid_size_;
+  size += encoded_elevation_.size();
   return size;
 }
 
@@ -111,6 +150,7 @@ std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& eib) {
     name_count = kMaxNamesPerEdge;
   }
   ei.name_count_ = name_count;
+  ei.has_elevation_ = !eib.encoded_elevation_.empty();
 
   // Check if we are exceeding the max encoded size
   if (eib.encoded_shape_.size() > kMaxEncodedShapeSize) {
@@ -131,6 +171,7 @@ std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& eib) {
   if (ei.extended_wayid_size_ > 1) {
     os.write(reinterpret_cast<const char*>(&eib.extended_wayid3_), sizeof(eib.extended_wayid3_));
   }
+  os << eib.encoded_elevation_;
 
   // Pad to a 4 byte boundary
   std::size_t padding = (eib.BaseSizeOf() % 4);
@@ -1,6 +1,9 @@
 #include "mjolnir/elevationbuilder.h"
 
+#include <algorithm>
+#include <cmath>
 #include <future>
+#include <map>
 #include <thread>
 #include <utility>
 
@@ -8,6 +11,7 @@
 
 #include "baldr/graphconstants.h"
 #include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -69,15 +73,19 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
       // Grade estimation and max slopes
       std::tuple<double, double, double, double> forward_grades(0.0, 0.0, 0.0, 0.0);
       std::tuple<double, double, double, double> reverse_grades(0.0, 0.0, 0.0, 0.0);
+      std::vector<float> profile;
       if (!directededge.tunnel() && directededge.use() != Use::kFerry) {
         // Evenly sample the shape. If it is really short or a bridge just do both ends
-        auto interval = POSTING_INTERVAL;
+        double interval = length;
         std::vector<PointLL> resampled;
         if (length < POSTING_INTERVAL * 3 || directededge.bridge()) {
           resampled = {shape.front(), shape.back()};
-          interval = length;
         } else {
-          resampled = valhalla::midgard::resample_spherical_polyline(shape, interval);
+          // samples at the same spacing all the way to the end so they make the profile as well
+          auto samples = std::min<uint32_t>(std::round(length / POSTING_INTERVAL) + 1,
+                                            kMaxElevationSamples);
+          resampled = uniform_resample_spherical_polyline(shape, length, samples);
+          interval = length / (resampled.size() - 1);
         }
 
         // Get the heights at each sampled point. Compute "weighted"
@@ -86,6 +94,13 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
         // mapped to a value between 0 to 15 for use in costing.
         auto heights = sample->get_all(resampled);
         auto grades = valhalla::skadi::weighted_grade(heights, interval);
+
+        // Keep the heights as the profile of the edge unless some of them are missing
+        if (std::none_of(heights.begin(), heights.end(), [](const double height) {
+              return height == valhalla::skadi::get_no_data_value();
+            })) {
+          profile.assign(heights.begin(), heights.end());
+        }
         if (length < kMinimumInterval) {
           // Keep the default grades - but set the mean elevation
           forward_grades = std::make_tuple(0.0, 0.0, 0.0, std::get<3>(grades));
@@ -115,6 +130,7 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
                                      mean_elevation == valhalla::skadi::get_no_data_value()
                                          ? kNoElevationData
                                          : mean_elevation);
+      tilebuilder.set_elevation(edge_info_offset, profile);
     }
 
     // Edge elevation information. If the edge is forward (with respect to the shape)
@@ -128,7 +144,8 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
     directededge.set_max_down_slope(max_down_slope);
   }
 
-  // Update the tile
+  // Update the tile, the profiles made the edge infos bigger
+  tilebuilder.UpdateEdgeInfoOffsets();
   tilebuilder.StoreTileData();
 
   // Check if we need to clear the tile cache
@@ -140,10 +157,11 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
 }
 
 /**
- * Adds elevation to a set of tiles. Each thread pulls a tile of the queue
+ * Adds elevation to a set of tiles. Each thread pulls a group of tiles sharing an elevation tile
+ * off the queue
  */
 void add_elevations_to_multiple_tiles(const boost::property_tree::ptree& pt,
-                                      std::deque<GraphId>& tilequeue,
+                                      std::deque<std::vector<GraphId>>& groupqueue,
                                       std::mutex& lock,
                                       const std::unique_ptr<valhalla::skadi::sample>& sample,
                                       std::promise<uint32_t>& /*result*/) {
@@ -158,31 +176,49 @@ void add_elevations_to_multiple_tiles(const boost::property_tree::ptree& pt,
   // Check for more tiles
   while (true) {
     lock.lock();
-    if (tilequeue.empty()) {
+    if (groupqueue.empty()) {
       lock.unlock();
       break;
     }
-    // Get the next tile Id
-    GraphId tile_id = tilequeue.front();
-    tilequeue.pop_front();
+    // Get the next group of tiles
+    std::vector<GraphId> tile_ids = std::move(groupqueue.front());
+    groupqueue.pop_front();
     lock.unlock();
 
-    add_elevations_to_single_tile(graphreader, lock, geo_attribute_cache, sample, tile_id);
+    for (auto& tile_id : tile_ids) {
+      add_elevations_to_single_tile(graphreader, lock, geo_attribute_cache, sample, tile_id);
+    }
   }
 }
 
 std::deque<GraphId> get_tile_ids(const boost::property_tree::ptree& pt) {
   std::deque<GraphId> tilequeue;
   GraphReader reader(pt.get_child("mjolnir"));
-  // Create a randomized queue of tiles (at all levels) to work from
   auto tileset = reader.GetTileSet();
   for (const auto& id : tileset)
     tilequeue.emplace_back(id);
+  return tilequeue;
+}
 
-  std::random_device rd;
-  std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(rd()));
+/**
+ * Groups the tiles by the 1x1 degree elevation tile their base lies in. A thread works through a
+ * whole group so the elevation tile is inflated once for it. The groups are ordered row by row so
+ * the threads work on neighbouring groups at the same time, whose elevation tiles the edges crossing
+ * over into them have likely put in the cache already.
+ */
+std::deque<std::vector<GraphId>> group_by_elevation_tile(const std::deque<GraphId>& tile_ids) {
+  std::map<std::pair<int32_t, int32_t>, std::vector<GraphId>> groups;
+  for (const auto& tile_id : tile_ids) {
+    auto base = TileHierarchy::get_tiling(tile_id.level()).Base(tile_id.tileid());
+    std::pair<int32_t, int32_t> row_column(std::floor(base.lat()), std::floor(base.lng()));
+    groups[row_column].push_back(tile_id);
+  }
 
-  return tilequeue;
+  std::deque<std::vector<GraphId>> groupqueue;
+  for (auto& group : groups) {
+    groupqueue.emplace_back(std::move(group.second));
+  }
+  return groupqueue;
 }
 
 } // namespace
@@ -206,16 +242,19 @@ void ElevationBuilder::Build(const boost::property_tree::ptree& pt,
   if (tile_ids.empty())
     tile_ids = get_tile_ids(pt);
 
+  auto groups = group_by_elevation_tile(tile_ids);
+
   std::vector<std::shared_ptr<std::thread>> threads(nthreads);
   std::vector<std::promise<uint32_t>> results(nthreads);
 
-  LOG_INFO("Adding elevation to " + std::to_string(tile_ids.size()) + " tiles with " +
-           std::to_string(nthreads) + " threads...");
+  LOG_INFO("Adding elevation to " + std::to_string(tile_ids.size()) + " tiles in " +
+           std::to_string(groups.size()) + " elevation tiles with " + std::to_string(nthreads) +
+           " threads...");
   std::mutex lock;
-  for (auto& thread : threads) {
-    results.emplace_back();
-    thread.reset(new std::thread(add_elevations_to_multiple_tiles, std::cref(pt), std::ref(tile_ids),
-                                 std::ref(lock), std::ref(sample), std::ref(results.back())));
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].reset(new std::thread(add_elevations_to_multiple_tiles, std::cref(pt),
+                                     std::ref(groups), std::ref(lock), std::ref(sample),
+                                     std::ref(results[i])));
   }
 
   for (auto& thread : threads) {
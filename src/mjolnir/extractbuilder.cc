@@ -0,0 +1,219 @@
+#include "mjolnir/extractbuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphtile.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using header_t = valhalla::midgard::tar::header_t;
+constexpr uint64_t kBlockSize = sizeof(header_t);
+// the bytes of every tile start on a page so that they can be mapped and advised on their own
+constexpr uint64_t kPageSize = 4096;
+// fills the gaps in front of the tiles which don't end right before a page
+constexpr const char* kPaddingName = ".padding";
+
+// the same entries as the index.bin the graph reader reads
+struct tile_index_entry {
+  uint64_t offset;  // byte offset from the beginning of the tar
+  uint32_t tile_id; // just level and tileindex hence fitting in 32bits
+  uint32_t size;    // size of the tile in bytes
+};
+
+struct tile_member_t {
+  std::string path; // where the tile is in the tile dir
+  std::string name; // what it is called in the tar
+  uint64_t offset;  // where its header goes in the tar, the bytes follow it
+  uint64_t size;
+};
+
+uint64_t padded(uint64_t size) {
+  return (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+}
+
+header_t make_header(const std::string& name, uint64_t size) {
+  header_t header{};
+  if (name.size() >= sizeof(header.name)) {
+    throw std::runtime_error("Tile name " + name + " is too long for the tar header");
+  }
+  std::strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+  std::snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+  std::snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+  std::snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+  std::snprintf(header.size, sizeof(header.size), "%011llo", static_cast<unsigned long long>(size));
+  std::snprintf(header.mtime, sizeof(header.mtime), "%011llo",
+                static_cast<unsigned long long>(std::time(nullptr)));
+  header.typeflag = '0';
+  std::memcpy(header.magic, "ustar", 6);
+  std::memcpy(header.version, "00", 2);
+
+  // the checksum is taken with blanks in its place
+  std::memset(header.chksum, ' ', sizeof(header.chksum));
+  unsigned int sum = 0;
+  for (size_t i = 0; i < sizeof(header); ++i) {
+    sum += reinterpret_cast<const unsigned char*>(&header)[i];
+  }
+  std::snprintf(header.chksum, sizeof(header.chksum) - 1, "%06o", sum);
+  return header;
+}
+
+/**
+ * Copies tiles into their place in the extract. Each thread takes the next tile until there are
+ * none left or one of them failed.
+ */
+void copy_tiles(const std::string& extract,
+                const std::vector<tile_member_t>& tiles,
+                std::atomic<size_t>& next,
+                std::mutex& lock,
+                std::string& error) {
+  std::fstream file(extract, std::ios::in | std::ios::out | std::ios::binary);
+  std::string bytes;
+  for (size_t i = next++; i < tiles.size(); i = next++) {
+    const auto& tile = tiles[i];
+    std::ifstream in(tile.path, std::ios::binary);
+    bytes.resize(tile.size);
+    bool read = in.read(&bytes[0], bytes.size()) && in.peek() == std::ifstream::traits_type::eof();
+    const auto header = make_header(tile.name, tile.size);
+    file.seekp(tile.offset);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(bytes.data(), bytes.size());
+    if (!read || !file) {
+      std::lock_guard<std::mutex> l(lock);
+      error = read ? "Could not write " + tile.name + " to " + extract
+                   : "Tile " + tile.path + " could not be read or changed size";
+      next = tiles.size();
+      return;
+    }
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ExtractBuilder::Build(const boost::property_tree::ptree& pt) {
+  if (!pt.get<bool>("mjolnir.build_extract", false)) {
+    return;
+  }
+  auto extract = pt.get_optional<std::string>("mjolnir.tile_extract");
+  if (!extract) {
+    LOG_WARN("mjolnir.build_extract is set but there is no mjolnir.tile_extract to write");
+    return;
+  }
+
+  // the tiles in the order valhalla_build_extract puts them in
+  const auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  std::vector<std::pair<GraphId, tile_member_t>> found;
+  for (filesystem::recursive_directory_iterator i(tile_dir), end; i != end; ++i) {
+    const auto path = i->path().string();
+    if (!i->is_regular_file() || path.size() < 4 || path.compare(path.size() - 4, 4, ".gph")) {
+      continue;
+    }
+    try {
+      auto id = GraphTile::GetTileId(path);
+      auto name = GraphTile::FileSuffix(id);
+      std::replace(name.begin(), name.end(), filesystem::path::preferred_separator, '/');
+      found.push_back({id, {path, name, 0, i->file_size()}});
+    } catch (...) {}
+  }
+  if (found.empty()) {
+    LOG_WARN("There are no tiles in " + tile_dir + " to write to " + *extract);
+    return;
+  }
+  std::sort(found.begin(), found.end(),
+            [](const auto& a, const auto& b) { return a.second.name < b.second.name; });
+
+  // the sizes of the tiles are all it takes to know where everything goes, the index comes first
+  std::vector<tile_member_t> tiles;
+  std::vector<tile_index_entry> index;
+  std::vector<std::pair<uint64_t, uint64_t>> paddings;
+  uint64_t offset = kBlockSize + padded(found.size() * sizeof(tile_index_entry));
+  for (auto& tile : found) {
+    if (tile.second.size > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("Tile " + tile.second.path + " is too large for the index");
+    }
+    // a padding member takes up the room up to the header in front of the next page
+    const auto gap = (kPageSize - (offset + kBlockSize) % kPageSize) % kPageSize;
+    if (gap) {
+      paddings.emplace_back(offset, gap);
+      offset += gap;
+    }
+    tile.second.offset = offset;
+    index.push_back({offset + kBlockSize, static_cast<uint32_t>(tile.first.value),
+                     static_cast<uint32_t>(tile.second.size)});
+    offset += kBlockSize + padded(tile.second.size);
+    tiles.emplace_back(std::move(tile.second));
+  }
+  // a tar ends with two empty blocks
+  const uint64_t size = offset + 2 * kBlockSize;
+
+  // lay out the index and the padding, everything else is zeros until the tiles are copied in
+  const auto temp = *extract + ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    const auto header = make_header("index.bin", index.size() * sizeof(tile_index_entry));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(index.front()));
+    for (const auto& padding : paddings) {
+      const auto header = make_header(kPaddingName, padding.second - kBlockSize);
+      file.seekp(padding.first);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    file.seekp(size - 1);
+    file.put('\0');
+    if (!file) {
+      throw std::runtime_error("Could not write " + temp);
+    }
+  }
+
+  // copy the tiles in at once
+  auto nthreads = std::max(static_cast<unsigned int>(1),
+                           pt.get<unsigned int>("mjolnir.concurrency",
+                                                std::thread::hardware_concurrency()));
+  nthreads = std::min(nthreads, static_cast<unsigned int>(tiles.size()));
+  LOG_INFO("Writing " + std::to_string(tiles.size()) + " tiles to " + *extract + " with " +
+           std::to_string(nthreads) + " threads");
+  std::atomic<size_t> next(0);
+  std::mutex lock;
+  std::string error;
+  std::list<std::thread> threads;
+  for (unsigned int i = 0; i < nthreads; ++i) {
+    threads.emplace_back(copy_tiles, std::cref(temp), std::cref(tiles), std::ref(next),
+                         std::ref(lock), std::ref(error));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (!error.empty()) {
+    std::remove(temp.c_str());
+    throw std::runtime_error(error);
+  }
+
+  // readers which have the old extract mapped keep it until they let go
+  if (std::rename(temp.c_str(), extract->c_str()) != 0 &&
+      (std::remove(extract->c_str()) != 0 || std::rename(temp.c_str(), extract->c_str()) != 0)) {
+    throw std::runtime_error("Could not move " + temp + " to " + *extract);
+  }
+  LOG_INFO("Finished writing " + std::to_string(size) + " bytes to " + *extract);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
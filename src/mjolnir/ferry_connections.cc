@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <atomic>
 #include <queue>
+#include <thread>
 #include <unordered_map>
 
 #include "baldr/graphconstants.h"
@@ -8,21 +11,71 @@
 namespace valhalla {
 namespace mjolnir {
 
-// Get the best classification for any driveable non-ferry and non-link
-// edges from a node. Skip any reclassified ferry edges
-uint32_t GetBestNonFerryClass(const std::map<Edge, size_t>& edges) {
-  uint32_t bestrc = kAbsurdRoadClass;
-  for (const auto& edge : edges) {
-    uint16_t fwd_access = edge.first.fwd_access & baldr::kVehicularAccess;
-    uint16_t rev_access = edge.first.rev_access & baldr::kVehicularAccess;
-    if (!edge.first.attributes.driveable_ferry && !edge.first.attributes.link &&
-        !edge.first.attributes.reclass_ferry && (fwd_access || rev_access)) {
-      if (edge.first.attributes.importance < bestrc) {
-        bestrc = edge.first.attributes.importance;
+namespace {
+
+// The edges connecting to the ferries from which the expansions start. They are reclassified one
+// after the other once their expansions are done. The expansions run in parallel so each one has to
+// see the start edges which were reclassified before it and none of the later ones, whichever
+// thread gets to them first.
+class StartEdges {
+public:
+  // Adds the next start edge, returns its position in the order they are reclassified
+  uint32_t Add(size_t edge_index, bool reclass_ferry) {
+    upgrades_[edge_index].emplace_back(count_, reclass_ferry);
+    return count_++;
+  }
+
+  // The best classification at the edges seen by the expansions of the given start edge
+  uint32_t BestNonFerryClass(const std::map<Edge, size_t>& edges, uint32_t before) const {
+    uint32_t bestrc = kAbsurdRoadClass;
+    for (const auto& edge : edges) {
+      uint32_t importance = edge.first.attributes.importance;
+      bool reclass_ferry = edge.first.attributes.reclass_ferry;
+      auto found = upgrades_.find(edge.second);
+      if (found != upgrades_.end()) {
+        // the last time it was a start edge before the given one
+        for (const auto& upgrade : found->second) {
+          if (upgrade.first >= before) {
+            break;
+          }
+          importance = kFerryUpClass;
+          reclass_ferry = upgrade.second;
+        }
+      }
+      uint16_t fwd_access = edge.first.fwd_access & baldr::kVehicularAccess;
+      uint16_t rev_access = edge.first.rev_access & baldr::kVehicularAccess;
+      if (!edge.first.attributes.driveable_ferry && !edge.first.attributes.link && !reclass_ferry &&
+          (fwd_access || rev_access)) {
+        bestrc = std::min(bestrc, importance);
       }
     }
+    return bestrc;
+  }
+
+  uint32_t size() const {
+    return count_;
   }
-  return bestrc;
+
+private:
+  std::unordered_map<size_t, std::vector<std::pair<uint32_t, bool>>> upgrades_;
+  uint32_t count_ = 0;
+};
+
+// An expansion from the edge connecting to a ferry
+struct Expansion {
+  uint32_t start_node_idx;
+  uint32_t node_idx;
+  bool inbound;
+  bool remove_destonly;
+  uint32_t start_edge; // position of the start edge in StartEdges
+};
+
+} // namespace
+
+// Get the best classification for any driveable non-ferry and non-link
+// edges from a node. Skip any reclassified ferry edges
+uint32_t GetBestNonFerryClass(const std::map<Edge, size_t>& edges) {
+  return StartEdges().BestNonFerryClass(edges, 0);
 }
 
 // Cost comparator for priority_queue
@@ -35,14 +88,15 @@ public:
 
 // Form the shortest path from the start node until a node that
 // touches the specified road classification.
-uint32_t ShortestPath(const uint32_t start_node_idx,
-                      const uint32_t node_idx,
-                      sequence<OSMWay>& ways,
-                      sequence<OSMWayNode>& way_nodes,
-                      sequence<Edge>& edges,
-                      sequence<Node>& nodes,
-                      const bool inbound,
-                      const bool first_edge_destonly) {
+std::vector<size_t> ShortestPath(const uint32_t start_node_idx,
+                                 const uint32_t node_idx,
+                                 sequence<OSMWay>& ways,
+                                 sequence<OSMWayNode>& way_nodes,
+                                 sequence<Edge>& edges,
+                                 sequence<Node>& nodes,
+                                 const bool inbound,
+                                 const bool first_edge_destonly,
+                                 const BestClassFunction& best_class) {
   // Method to get the shape for an edge - since LL is stored as a pair of
   // floats we need to change into PointLL to get length of an edge
   const auto EdgeShape = [&way_nodes](size_t idx, const size_t count) {
@@ -54,9 +108,9 @@ uint32_t ShortestPath(const uint32_t start_node_idx,
     return shape;
   };
 
-  // total edge count for all reclassified paths
+  // edges of all the paths to reclassify
   // and determine for how many modes we need to ensure access (hint: only the ones using hierarchies)
-  uint32_t edge_count = 0;
+  std::vector<size_t> path_edges;
 
   uint16_t overall_access_before = baldr::kVehicularAccess;
   uint16_t overall_access_after = 0;
@@ -116,7 +170,7 @@ uint32_t ShortestPath(const uint32_t start_node_idx,
       // Have seen cases where the immediate connections are high class roads
       // but then there are service roads (lanes) immediately after (like
       // Twawwassen Terminal near Vancouver,BC)
-      if (n > 400 && GetBestNonFerryClass(expanded_bundle.node_edges) <= kFerryUpClass) {
+      if (n > 400 && best_class(expanded_bundle.node_edges) <= kFerryUpClass) {
         break;
       }
       n++;
@@ -198,7 +252,7 @@ uint32_t ShortestPath(const uint32_t start_node_idx,
     // classification - or we cannot expand due to driveability
     if (node_labels.size() == 1) {
       LOG_DEBUG("Only 1 edge reclassified");
-      return 0;
+      return path_edges;
     }
 
     // Trace shortest path backwards and upgrade edge classifications
@@ -214,19 +268,12 @@ uint32_t ShortestPath(const uint32_t start_node_idx,
       for (auto& edge : bundle2.node_edges) {
         bool forward = edge.first.sourcenode_ == pred_node;
         if (forward || edge.first.targetnode_ == pred_node) {
-          sequence<Edge>::iterator element = edges[edge.second];
-          auto update_edge = *element;
           if ((forward && inbound) || (!forward && !inbound)) {
-            path_access &= update_edge.rev_access;
+            path_access &= edge.first.rev_access;
           } else if ((forward && !inbound) || (!forward && inbound)) {
-            path_access &= update_edge.fwd_access;
-          }
-          if (update_edge.attributes.importance > kFerryUpClass) {
-            update_edge.attributes.importance = kFerryUpClass;
-            update_edge.attributes.reclass_ferry = true;
-            element = update_edge;
-            edge_count++;
+            path_access &= edge.first.fwd_access;
           }
+          path_edges.push_back(edge.second);
         }
       }
 
@@ -241,7 +288,7 @@ uint32_t ShortestPath(const uint32_t start_node_idx,
     overall_access_after |= path_access;
   }
 
-  return edge_count;
+  return path_edges;
 }
 
 // Check if the ferry included in this node bundle is short. Must be
@@ -302,7 +349,8 @@ bool ShortFerry(const uint32_t node_index,
 void ReclassifyFerryConnections(const std::string& ways_file,
                                 const std::string& way_nodes_file,
                                 const std::string& nodes_file,
-                                const std::string& edges_file) {
+                                const std::string& edges_file,
+                                const unsigned int concurrency) {
   LOG_INFO("Reclassifying ferry connection graph edges...");
 
   sequence<OSMWay> ways(ways_file, false);
@@ -310,20 +358,54 @@ void ReclassifyFerryConnections(const std::string& ways_file,
   sequence<Edge> edges(edges_file, false);
   sequence<Node> nodes(nodes_file, false);
 
+  // The threads only read the sequences until all of the expansions are done
+  const size_t threads = std::max(1u, concurrency);
+  const auto run = [threads](const std::function<void(size_t)>& work) {
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; ++i) {
+      pool.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  };
+
   // Need to expand from the end of the ferry until we meet a road with the
   // specified classification. Want to do simple shortest path (time based
   // only) and obey driveability.
 
   // Iterate through nodes and find any that connect to both a ferry and a
   // regular (non-ferry) edge. Skip short ferry edges (river crossing?)
-  uint32_t ferry_endpoint_count = 0;
-  uint32_t total_count = 0;
-  sequence<Node>::iterator node_itr = nodes.begin();
-  while (node_itr != nodes.end()) {
-    auto bundle = collect_node_edges(node_itr, nodes, edges);
-    if (bundle.node.ferry_edge_ && bundle.node.non_ferry_edge_ &&
-        GetBestNonFerryClass(bundle.node_edges) > kFerryUpClass &&
-        !ShortFerry(node_itr.position(), bundle, edges, nodes, way_nodes)) {
+  auto ranges = split_node_bundles(nodes, threads);
+  std::vector<std::vector<size_t>> ferry_nodes(threads);
+  run([&](size_t i) {
+    sequence<Node>::iterator node_itr = nodes[ranges[i]];
+    while (node_itr.position() < ranges[i + 1]) {
+      auto bundle = collect_node_edges(node_itr, nodes, edges);
+      if (bundle.node.ferry_edge_ && bundle.node.non_ferry_edge_ &&
+          !ShortFerry(node_itr.position(), bundle, edges, nodes, way_nodes)) {
+        ferry_nodes[i].push_back(node_itr.position());
+      }
+
+      // Go to the next node
+      node_itr += bundle.node_count;
+    }
+  });
+
+  // In node order, as if one after the other, find the expansions from each ferry node. The start
+  // edges are reclassified by a node's expansions which later nodes have to see
+  StartEdges start_edges;
+  std::vector<Expansion> expansions;
+  std::vector<std::pair<size_t, bool>> start_edge_updates;
+  for (const auto& range : ferry_nodes) {
+    for (auto position : range) {
+      sequence<Node>::iterator node_itr = nodes[position];
+      auto bundle = collect_node_edges(node_itr, nodes, edges);
+      if (start_edges.BestNonFerryClass(bundle.node_edges, start_edges.size()) <= kFerryUpClass) {
+        continue;
+      }
+
       // Form shortest path from node along each edge connected to the ferry,
       // track until the specified RC is reached
       for (const auto& edge : bundle.node_edges) {
@@ -336,15 +418,18 @@ void ReclassifyFerryConnections(const std::string& ways_file,
         }
 
         // Expand/reclassify from the end node of this edge.
-        uint32_t end_node_idx = (edge.first.sourcenode_ == node_itr.position())
-                                    ? edge.first.targetnode_
-                                    : edge.first.sourcenode_;
+        uint32_t start_node_idx = position;
+        uint32_t end_node_idx = (edge.first.sourcenode_ == position) ? edge.first.targetnode_
+                                                                     : edge.first.sourcenode_;
 
         // if the non-ferry edge connecting on land is dest_only, we will unset dest_only
         // for all ways encountered during the expansion, to counteract a popular mapping
         // error, see https://github.com/valhalla/valhalla/issues/3942
         const bool remove_destonly = (*ways[edge.first.wayindex_]).destination_only();
 
+        // The expansions only see the start edges reclassified before this one
+        uint32_t start_edge = start_edges.size();
+
         // Check if edge is oneway towards the ferry or outbound from the
         // ferry. If edge is drivable both ways we need to expand it twice-
         // once with a driveable path towards the ferry and once with a
@@ -352,35 +437,63 @@ void ReclassifyFerryConnections(const std::string& ways_file,
         if (edge_fwd_access == edge_rev_access) {
           // Driveable in both directions - get an inbound path and an
           // outbound path.
-          total_count += ShortestPath(node_itr.position(), end_node_idx, ways, way_nodes, edges,
-                                      nodes, true, remove_destonly);
-          total_count += ShortestPath(node_itr.position(), end_node_idx, ways, way_nodes, edges,
-                                      nodes, false, remove_destonly);
+          expansions.push_back({start_node_idx, end_node_idx, true, remove_destonly, start_edge});
+          expansions.push_back({start_node_idx, end_node_idx, false, remove_destonly, start_edge});
         } else {
           // Check if oneway inbound to the ferry
-          bool inbound =
-              (edge.first.sourcenode_ == node_itr.position()) ? edge_rev_access : edge_fwd_access;
-          total_count += ShortestPath(node_itr.position(), end_node_idx, ways, way_nodes, edges,
-                                      nodes, inbound, remove_destonly);
+          bool inbound = (edge.first.sourcenode_ == position) ? edge_rev_access : edge_fwd_access;
+          expansions.push_back(
+              {start_node_idx, end_node_idx, inbound, remove_destonly, start_edge});
         }
-        ferry_endpoint_count++;
-
         // Reclassify the first/start edge. Do this AFTER finding shortest path so
         // we do not immediately determine we hit the specified classification
-        sequence<Edge>::iterator element = edges[edge.second];
+        start_edges.Add(edge.second, remove_destonly);
+        start_edge_updates.emplace_back(edge.second, remove_destonly);
+      }
+    }
+  }
+
+  // Each thread takes the next expansion until there are none left
+  std::vector<std::vector<size_t>> paths(expansions.size());
+  std::atomic<size_t> next_expansion(0);
+  run([&](size_t) {
+    for (size_t i = next_expansion++; i < expansions.size(); i = next_expansion++) {
+      const auto& expansion = expansions[i];
+      paths[i] = ShortestPath(expansion.start_node_idx, expansion.node_idx, ways, way_nodes, edges,
+                              nodes, expansion.inbound, expansion.remove_destonly,
+                              [&start_edges, &expansion](const std::map<Edge, size_t>& node_edges) {
+                                return start_edges.BestNonFerryClass(node_edges,
+                                                                     expansion.start_edge);
+                              });
+    }
+  });
+
+  // Reclassify the paths and then their start edge in the order they were found in
+  uint32_t total_count = 0;
+  size_t e = 0;
+  for (uint32_t start_edge = 0; start_edge < start_edge_updates.size(); ++start_edge) {
+    for (; e < expansions.size() && expansions[e].start_edge == start_edge; ++e) {
+      for (auto edge_index : paths[e]) {
+        sequence<Edge>::iterator element = edges[edge_index];
         auto update_edge = *element;
-        update_edge.attributes.importance = kFerryUpClass;
-        update_edge.attributes.reclass_ferry = remove_destonly;
-        element = update_edge;
-        total_count++;
+        if (update_edge.attributes.importance > kFerryUpClass) {
+          update_edge.attributes.importance = kFerryUpClass;
+          update_edge.attributes.reclass_ferry = true;
+          element = update_edge;
+          total_count++;
+        }
       }
     }
 
-    // Go to the next node
-    node_itr += bundle.node_count;
+    sequence<Edge>::iterator element = edges[start_edge_updates[start_edge].first];
+    auto update_edge = *element;
+    update_edge.attributes.importance = kFerryUpClass;
+    update_edge.attributes.reclass_ferry = start_edge_updates[start_edge].second;
+    element = update_edge;
+    total_count++;
   }
   LOG_INFO("Finished ReclassifyFerryEdges: ferry_endpoint_count = " +
-           std::to_string(ferry_endpoint_count) + ", " + std::to_string(total_count) +
+           std::to_string(start_edge_updates.size()) + ", " + std::to_string(total_count) +
            " edges reclassified.");
 }
 
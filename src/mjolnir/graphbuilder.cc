@@ -27,6 +27,7 @@
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/linkclassification.h"
 #include "mjolnir/node_expander.h"
+#include "mjolnir/tilepipeline.h"
 #include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
@@ -35,22 +36,47 @@ using namespace valhalla::mjolnir;
 
 namespace {
 
+// Nodes are ordered along a hilbert curve through cells of 2^12 units of their fixed 7 digit
+// precision coordinates, about 45m, which covers the 2^32 units of each coordinate in 20 bits
+constexpr uint32_t kHilbertCellBits = 12;
+constexpr uint32_t kHilbertOrder = 32 - kHilbertCellBits;
+
+uint64_t hilbert_key(const OSMNode& node) {
+  return hilbert_index(node.lng7_ >> kHilbertCellBits, node.lat7_ >> kHilbertCellBits,
+                       kHilbertOrder);
+}
+
 /**
  * we need the nodes to be sorted by graphid and then by osmid to make a set of tiles
  * we also need to then update the edges that pointed to them
  *
+ * optionally the nodes of a tile are sorted along a hilbert curve before the osmid, so that nodes
+ * near each other get ids near each other and so do their edges, which are added node by node
  */
-std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::string& edges_file) {
+std::map<GraphId, size_t> SortGraph(const std::string& nodes_file,
+                                    const std::string& edges_file,
+                                    size_t sort_memory,
+                                    unsigned int threads,
+                                    bool hilbert_order) {
   LOG_INFO("Sorting graph...");
 
-  // Sort nodes by graphid then by osmid, so its basically a set of tiles
+  // Sort nodes by graphid then by osmid, so its basically a set of tiles. Duplicates of a node
+  // share its location so they stay next to each other along the hilbert curve too
   sequence<Node> nodes(nodes_file, false);
-  nodes.sort([](const Node& a, const Node& b) {
-    if (a.graph_id == b.graph_id) {
-      return a.node.osmid_ < b.node.osmid_;
-    }
-    return a.graph_id < b.graph_id;
-  });
+  nodes.sort(
+      [hilbert_order](const Node& a, const Node& b) {
+        if (a.graph_id == b.graph_id) {
+          if (hilbert_order) {
+            const auto a_key = hilbert_key(a.node), b_key = hilbert_key(b.node);
+            if (a_key != b_key) {
+              return a_key < b_key;
+            }
+          }
+          return a.node.osmid_ < b.node.osmid_;
+        }
+        return a.graph_id < b.graph_id;
+      },
+      sort_memory, threads);
 
   // run through the sorted nodes, going back to the edges they reference and updating each edge
   // to point to the first (out of the duplicates) nodes index. at the end of this there will be
@@ -113,8 +139,8 @@ std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::st
   auto cmp = [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
     return a.first < b.first;
   };
-  starts->sort(cmp);
-  ends->sort(cmp);
+  starts->sort(cmp, sort_memory, threads);
+  ends->sort(cmp, sort_memory, threads);
 
   sequence<Edge> edges(edges_file, false);
 
@@ -395,6 +421,9 @@ void BuildTileSet(const std::string& ways_file,
                   std::map<GraphId, size_t>::const_iterator tile_end,
                   const uint32_t tile_creation_date,
                   const boost::property_tree::ptree& pt,
+                  const PolygonIndex* admins,
+                  const PolygonIndex* timezones,
+                  TilePipeline* pipeline,
                   std::promise<DataQuality>& result) {
 
   sequence<OSMWay> ways(ways_file, false);
@@ -409,31 +438,11 @@ void BuildTileSet(const std::string& ways_file,
   };
   sequence<OSMPronunciation> pronunciation(pronunciation_file, false);
 
-  auto database = pt.get_optional<std::string>("admin");
   bool infer_internal_intersections =
       pt.get<bool>("data_processing.infer_internal_intersections", true);
   bool use_urban_tag = pt.get<bool>("data_processing.use_urban_tag", false);
   bool use_admin_db = pt.get<bool>("data_processing.use_admin_db", true);
 
-  // Initialize the admin DB (if it exists)
-  sqlite3* admin_db_handle = (database && use_admin_db) ? GetDBHandle(*database) : nullptr;
-  if (!database && use_admin_db) {
-    LOG_WARN("Admin db not found.  Not saving admin information.");
-  } else if (!admin_db_handle && use_admin_db) {
-    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
-  }
-  auto admin_conn = make_spatialite_cache(admin_db_handle);
-
-  database = pt.get_optional<std::string>("timezone");
-  // Initialize the tz DB (if it exists)
-  sqlite3* tz_db_handle = database ? GetDBHandle(*database) : nullptr;
-  if (!database) {
-    LOG_WARN("Time zone db not found.  Not saving time zone information.");
-  } else if (!tz_db_handle) {
-    LOG_WARN("Time zone db " + *database + " not found.  Not saving time zone information.");
-  }
-  auto tz_conn = make_spatialite_cache(tz_db_handle);
-
   const auto& tiling = TileHierarchy::levels().back().tiles;
 
   // Method to get the shape for an edge - since LL is stored as a pair of
@@ -475,12 +484,12 @@ void BuildTileSet(const std::string& ways_file,
       // Get the admin polygons. If only one exists for the tile check if the
       // tile is entirely inside the polygon
       bool tile_within_one_admin = false;
-      std::multimap<uint32_t, multi_polygon_type> admin_polys;
+      polygon_refs admin_polys;
       std::unordered_map<uint32_t, bool> drive_on_right;
       std::unordered_map<uint32_t, bool> allow_intersection_names;
 
-      if (admin_db_handle) {
-        admin_polys = GetAdminInfo(admin_db_handle, drive_on_right, allow_intersection_names,
+      if (admins) {
+        admin_polys = GetAdminInfo(*admins, drive_on_right, allow_intersection_names,
                                    tiling.TileBounds(id), graphtile);
         if (admin_polys.size() == 1) {
           // TODO - check if tile bounding box is entirely inside the polygon...
@@ -489,9 +498,9 @@ void BuildTileSet(const std::string& ways_file,
       }
 
       bool tile_within_one_tz = false;
-      std::multimap<uint32_t, multi_polygon_type> tz_polys;
-      if (tz_db_handle) {
-        tz_polys = GetTimeZones(tz_db_handle, tiling.TileBounds(id));
+      polygon_refs tz_polys;
+      if (timezones) {
+        tz_polys = GetTimeZones(*timezones, tiling.TileBounds(id));
         if (tz_polys.size() == 1) {
           tile_within_one_tz = true;
         }
@@ -1099,6 +1108,9 @@ void BuildTileSet(const std::string& ways_file,
 
       // Write the actual tile to disk
       graphtile.StoreTileData();
+      if (pipeline) {
+        pipeline->Done(tile_start->first.Tile_Base());
+      }
 
       // Made a tile
       LOG_DEBUG((boost::format("Wrote tile %1%: %2% bytes") % tile_start->first %
@@ -1113,14 +1125,6 @@ void BuildTileSet(const std::string& ways_file,
     }
   }
 
-  if (admin_db_handle) {
-    sqlite3_close(admin_db_handle);
-  }
-
-  if (tz_db_handle) {
-    sqlite3_close(tz_db_handle);
-  }
-
   // Let the main thread see how this thread faired
   result.set_value(stats);
 }
@@ -1138,11 +1142,39 @@ void BuildLocalTiles(const unsigned int thread_count,
                      const std::map<GraphId, size_t>& tiles,
                      const std::string& tile_dir,
                      DataQuality& stats,
-                     const boost::property_tree::ptree& pt) {
+                     const boost::property_tree::ptree& pt,
+                     TilePipeline* pipeline) {
   auto tz = DateTime::get_tz_db().from_index(DateTime::get_tz_db().to_index("America/New_York"));
   uint32_t tile_creation_date =
       DateTime::days_from_pivot_date(DateTime::get_formatted_date(DateTime::iso_date_time(tz)));
 
+  // Load the admin and tz polygons up front, all the threads look them up in memory
+  const auto& mjolnir_pt = pt.get_child("mjolnir");
+  auto database = mjolnir_pt.get_optional<std::string>("admin");
+  bool use_admin_db = mjolnir_pt.get<bool>("data_processing.use_admin_db", true);
+  sqlite3* admin_db_handle = (database && use_admin_db) ? GetDBHandle(*database) : nullptr;
+  if (!database && use_admin_db) {
+    LOG_WARN("Admin db not found.  Not saving admin information.");
+  } else if (!admin_db_handle && use_admin_db) {
+    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
+  }
+  auto admins = LoadAdmins(admin_db_handle);
+  if (admin_db_handle) {
+    sqlite3_close(admin_db_handle);
+  }
+
+  database = mjolnir_pt.get_optional<std::string>("timezone");
+  sqlite3* tz_db_handle = database ? GetDBHandle(*database) : nullptr;
+  if (!database) {
+    LOG_WARN("Time zone db not found.  Not saving time zone information.");
+  } else if (!tz_db_handle) {
+    LOG_WARN("Time zone db " + *database + " not found.  Not saving time zone information.");
+  }
+  auto timezones = LoadTimeZones(tz_db_handle);
+  if (tz_db_handle) {
+    sqlite3_close(tz_db_handle);
+  }
+
   LOG_INFO("Building " + std::to_string(tiles.size()) + " tiles with " +
            std::to_string(thread_count) + " threads...");
 
@@ -1172,7 +1204,8 @@ void BuildLocalTiles(const unsigned int thread_count,
                                      std::cref(complex_to_restriction_file),
                                      std::cref(pronunciation_file), std::cref(tile_dir),
                                      std::cref(osmdata), tile_start, tile_end, tile_creation_date,
-                                     std::cref(pt.get_child("mjolnir")), std::ref(results[i])));
+                                     std::cref(mjolnir_pt), admins.get(), timezones.get(),
+                                     pipeline, std::ref(results[i])));
   }
 
   // Join all the threads to wait for them to finish up their work
@@ -1214,7 +1247,11 @@ std::map<GraphId, size_t> GraphBuilder::BuildEdges(const boost::property_tree::p
       [&level](const OSMNode& node) { return TileHierarchy::GetGraphId(node.latlng(), level); },
       pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true));
 
-  return SortGraph(nodes_file, edges_file);
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  return SortGraph(nodes_file, edges_file, pt.get<size_t>("mjolnir.sort_memory", 1024 * 1024 * 512),
+                   threads, pt.get<bool>("mjolnir.hilbert_node_order", false));
 }
 
 // Build the graph from the input
@@ -1227,28 +1264,29 @@ void GraphBuilder::Build(const boost::property_tree::ptree& pt,
                          const std::string& complex_from_restriction_file,
                          const std::string& complex_to_restriction_file,
                          const std::string& pronunciation_file,
-                         const std::map<GraphId, size_t>& tiles) {
+                         const std::map<GraphId, size_t>& tiles,
+                         TilePipeline* pipeline) {
   // Reclassify links (ramps). Cannot do this when building tiles since the
   // edge list needs to be modified
   DataQuality stats;
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
   if (pt.get<bool>("mjolnir.reclassify_links", true)) {
     ReclassifyLinks(ways_file, nodes_file, edges_file, way_nodes_file, osmdata,
-                    pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true));
+                    pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true), threads);
   } else {
     LOG_WARN("Not reclassifying link graph edges");
   }
 
   // Reclassify ferry connection edges - uses RoadClass::kPrimary (highway classification) as cutoff
-  ReclassifyFerryConnections(ways_file, way_nodes_file, nodes_file, edges_file);
-  unsigned int threads =
-      std::max(static_cast<unsigned int>(1),
-               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  ReclassifyFerryConnections(ways_file, way_nodes_file, nodes_file, edges_file, threads);
 
   // Build tiles at the local level. Form connected graph from nodes and edges.
   std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
   BuildLocalTiles(threads, osmdata, ways_file, way_nodes_file, nodes_file, edges_file,
                   complex_from_restriction_file, complex_to_restriction_file, pronunciation_file,
-                  tiles, tile_dir, stats, pt);
+                  tiles, tile_dir, stats, pt, pipeline);
   stats.LogStatistics();
 }
 
@@ -42,6 +42,7 @@
 #include "midgard/sequence.h"
 #include "midgard/util.h"
 #include "mjolnir/osmaccess.h"
+#include "mjolnir/tilepipeline.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -1303,7 +1304,7 @@ bool ConsistentNames(const std::string& country_code,
   }
 
   // Return true (consistent) if the common base names are not empty
-  return (!(street_names1->FindCommonBaseNames(*street_names2)->empty()));
+  return street_names1->CountCommonBaseNames(*street_names2) > 0;
 }
 
 // We make sure to lock on reading and writing because we dont want to race
@@ -1313,6 +1314,7 @@ void enhance(const boost::property_tree::ptree& pt,
              const std::string& access_file,
              const boost::property_tree::ptree& hierarchy_properties,
              std::queue<GraphId>& tilequeue,
+             TilePipeline* pipeline,
              std::mutex& lock,
              std::promise<enhancer_stats>& result) {
 
@@ -1338,8 +1340,14 @@ void enhance(const boost::property_tree::ptree& pt,
   std::unordered_map<std::string, std::vector<int>> country_access =
       GetCountryAccess(admin_db_handle);
 
-  // Local Graphreader
-  GraphReader reader(hierarchy_properties);
+  // Local Graphreader, when the tiles are still being built it waits for the ones it reads
+  std::unique_ptr<GraphReader> local_reader;
+  if (pipeline) {
+    local_reader.reset(new PipelineGraphReader(hierarchy_properties, *pipeline));
+  } else {
+    local_reader.reset(new GraphReader(hierarchy_properties));
+  }
+  GraphReader& reader = *local_reader;
 
   // Config driven speed assignment
   auto speeds_config = pt.get_optional<std::string>("default_speeds_config");
@@ -1352,15 +1360,23 @@ void enhance(const boost::property_tree::ptree& pt,
 
   // Iterate through the tiles in the queue and perform enhancements
   while (true) {
-    // Get the next tile Id from the queue and get writeable and readable
-    // tile. Lock while we access the tile queue and get the tile.
-    lock.lock();
-    if (tilequeue.empty()) {
-      lock.unlock();
-      break;
+    // Get the next tile Id from the queue (or the next one built) and get writeable
+    // and readable tile. Lock while we access the tile queue and get the tile.
+    GraphId tile_id;
+    if (pipeline) {
+      if (!pipeline->Next(tile_id)) {
+        break;
+      }
+      lock.lock();
+    } else {
+      lock.lock();
+      if (tilequeue.empty()) {
+        lock.unlock();
+        break;
+      }
+      tile_id = tilequeue.front();
+      tilequeue.pop();
     }
-    GraphId tile_id = tilequeue.front();
-    tilequeue.pop();
 
     // Get a readable tile.If the tile is empty, skip it. Empty tiles are
     // added where ways go through a tile but no end not is within the tile.
@@ -1752,7 +1768,9 @@ namespace mjolnir {
 // Enhance the local level of the graph
 void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
                             const OSMData& osmdata,
-                            const std::string& access_file) {
+                            const std::string& access_file,
+                            const std::unordered_set<GraphId>* tiles,
+                            TilePipeline* pipeline) {
   LOG_INFO("Enhancing local graph...");
 
   // A place to hold worker threads and their results, exceptions or otherwise
@@ -1763,17 +1781,22 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
   // A place to hold the results of those threads, exceptions or otherwise
   std::list<std::promise<enhancer_stats>> results;
 
-  // Create a randomized queue of tiles to work from
+  // Create a randomized queue of tiles to work from, unless they come from the pipeline
+  // as they are built
   std::deque<GraphId> tempqueue;
   boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
-  auto local_level = TileHierarchy::levels().back().level;
-  GraphReader reader(hierarchy_properties);
-  auto local_tiles = reader.GetTileSet(local_level);
-  for (const auto& tile_id : local_tiles) {
-    tempqueue.emplace_back(tile_id);
+  if (!pipeline) {
+    auto local_level = TileHierarchy::levels().back().level;
+    GraphReader reader(hierarchy_properties);
+    auto local_tiles = reader.GetTileSet(local_level);
+    for (const auto& tile_id : local_tiles) {
+      if (!tiles || tiles->count(tile_id)) {
+        tempqueue.emplace_back(tile_id);
+      }
+    }
+    std::random_device rd;
+    std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(rd()));
   }
-  std::random_device rd;
-  std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(rd()));
   std::queue<GraphId> tilequeue(tempqueue);
 
   // An atomic object we can use to do the synchronization
@@ -1784,7 +1807,8 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
     results.emplace_back();
     thread.reset(new std::thread(enhance, std::cref(hierarchy_properties), std::cref(osmdata),
                                  std::cref(access_file), std::ref(hierarchy_properties),
-                                 std::ref(tilequeue), std::ref(lock), std::ref(results.back())));
+                                 std::ref(tilequeue), pipeline, std::ref(lock),
+                                 std::ref(results.back())));
   }
 
   // Wait for them to finish up their work
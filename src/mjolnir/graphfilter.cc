@@ -2,7 +2,11 @@
 #include "mjolnir/graphtilebuilder.h"
 
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -22,28 +26,52 @@ using namespace valhalla::mjolnir;
 
 namespace {
 
-uint32_t n_original_edges = 0;
-uint32_t n_original_nodes = 0;
-uint32_t n_filtered_edges = 0;
-uint32_t n_filtered_nodes = 0;
-uint32_t can_aggregate = 0;
+// What a thread filtered out of its tiles
+struct filter_stats_t {
+  uint32_t n_original_edges = 0;
+  uint32_t n_original_nodes = 0;
+  uint32_t n_filtered_edges = 0;
+  uint32_t n_filtered_nodes = 0;
+  uint32_t can_aggregate = 0;
+
+  filter_stats_t& operator+=(const filter_stats_t& other) {
+    n_original_edges += other.n_original_edges;
+    n_original_nodes += other.n_original_nodes;
+    n_filtered_edges += other.n_filtered_edges;
+    n_filtered_nodes += other.n_filtered_nodes;
+    can_aggregate += other.can_aggregate;
+    return *this;
+  }
+};
+
+// The new node Id of each original node of a tile, indexed by the original node's id within the
+// tile and invalid if the node was filtered. Every tile has its entry before the threads start so
+// that each thread only writes the entries of its own tiles.
+using node_map_t = std::unordered_map<GraphId, std::vector<GraphId>>;
 
 // Group wheelchair and pedestrian access together
 constexpr uint32_t kAllPedestrianAccess = (kPedestrianAccess | kWheelchairAccess);
 
 /**
- * Filter edges to optionally remove edges by access.
- * @param  reader  Graph reader.
+ * Filter edges to optionally remove edges by access. Each thread takes the next tile until there
+ * are none left.
+ * @param  pt  Mjolnir configuration to create the graph reader of this thread.
+ * @param  local_tiles  The tiles to filter.
+ * @param  next_tile  Index of the next tile to filter, shared by the threads.
  * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
  * @param  include_driving  Include edge if driving (any vehicular) access in either direction.
  * @param  include_bicycle  Include edge if bicycle access in either direction.
  * @param  include_pedestrian  Include edge if pedestrian or wheelchair access in either direction.
+ * @param  stats  What this thread filtered.
  */
-void FilterTiles(GraphReader& reader,
-                 std::unordered_map<GraphId, GraphId>& old_to_new,
+void FilterTiles(const boost::property_tree::ptree& pt,
+                 const std::vector<GraphId>& local_tiles,
+                 std::atomic<size_t>& next_tile,
+                 node_map_t& old_to_new,
                  const bool include_driving,
                  const bool include_bicycle,
-                 const bool include_pedestrian) {
+                 const bool include_pedestrian,
+                 filter_stats_t& stats) {
 
   // lambda to check if an edge should be included
   auto include_edge = [&include_driving, &include_bicycle,
@@ -59,17 +87,20 @@ void FilterTiles(GraphReader& reader,
            (pedestrian_access && include_pedestrian);
   };
 
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
+  // Iterate through the tiles in the local level
+  GraphReader reader(pt);
+  for (size_t t = next_tile++; t < local_tiles.size(); t = next_tile++) {
+    const auto& tile_id = local_tiles[t];
     // Create a new tilebuilder - should copy header information
     GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-    n_original_nodes += tilebuilder.header()->nodecount();
-    n_original_edges += tilebuilder.header()->directededgecount();
+    stats.n_original_nodes += tilebuilder.header()->nodecount();
+    stats.n_original_edges += tilebuilder.header()->directededgecount();
 
     // Get the graph tile. Read from this tile to create the new tile.
     graph_tile_ptr tile = reader.GetGraphTile(tile_id);
     assert(tile);
+    auto& new_nodes = old_to_new.find(tile_id)->second;
+    new_nodes.resize(tile->header()->nodecount());
 
     std::hash<std::string> hasher;
     GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
@@ -89,7 +120,7 @@ void FilterTiles(GraphReader& reader,
         // Check if the directed edge should be included
         const DirectedEdge* directededge = tile->directededge(edgeid);
         if (!include_edge(directededge)) {
-          ++n_filtered_edges;
+          ++stats.n_filtered_edges;
           continue;
         }
 
@@ -183,15 +214,15 @@ void FilterTiles(GraphReader& reader,
         }
 
         // Associate the old node to the new node.
-        old_to_new[nodeid] = new_node;
+        new_nodes[nodeid.id()] = new_node;
 
         // Check if edges at this node can be aggregated. Only 2 edges, same way Id (so that
         // edge attributes should match), don't end at same node (no loops).
         if (edge_count == 2 && wayid[0] == wayid[1] && endnode[0] != endnode[1]) {
-          ++can_aggregate;
+          ++stats.can_aggregate;
         }
       } else {
-        ++n_filtered_nodes;
+        ++stats.n_filtered_nodes;
       }
     }
 
@@ -210,26 +241,24 @@ void FilterTiles(GraphReader& reader,
       reader.Trim();
     }
   }
-  LOG_INFO("Filtered " + std::to_string(n_filtered_nodes) + " nodes out of " +
-           std::to_string(n_original_nodes));
-  LOG_INFO("Filtered " + std::to_string(n_filtered_edges) + " directededges out of " +
-           std::to_string(n_original_edges));
-  LOG_INFO("Can aggregate: " + std::to_string(can_aggregate));
 }
 
 /**
- * Update end nodes of all directed edges.
- * @param  reader  Graph reader.
+ * Update end nodes of all directed edges. Each thread takes the next tile until there are none
+ * left.
+ * @param  pt  Mjolnir configuration to create the graph reader of this thread.
+ * @param  local_tiles  The tiles which are left after filtering.
+ * @param  next_tile  Index of the next tile to update, shared by the threads.
  * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
  */
-void UpdateEndNodes(GraphReader& reader, std::unordered_map<GraphId, GraphId>& old_to_new) {
-  LOG_INFO("Update end nodes of directed edges");
-
-  int found = 0;
-
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
+void UpdateEndNodes(const boost::property_tree::ptree& pt,
+                    const std::vector<GraphId>& local_tiles,
+                    std::atomic<size_t>& next_tile,
+                    const node_map_t& old_to_new) {
+  // Iterate through the tiles in the local level
+  GraphReader reader(pt);
+  for (size_t t = next_tile++; t < local_tiles.size(); t = next_tile++) {
+    const auto& tile_id = local_tiles[t];
     // Get the graph tile. Skip if no tile exists (should not happen!?)
     graph_tile_ptr tile = reader.GetGraphTile(tile_id);
     assert(tile);
@@ -252,12 +281,12 @@ void UpdateEndNodes(GraphReader& reader, std::unordered_map<GraphId, GraphId>& o
 
       // Find the end node in the old_to_new mapping
       GraphId end_node;
-      auto iter = old_to_new.find(edge->endnode());
-      if (iter == old_to_new.end()) {
+      auto iter = old_to_new.find(edge->endnode().Tile_Base());
+      if (iter == old_to_new.end() || edge->endnode().id() >= iter->second.size() ||
+          !iter->second[edge->endnode().id()].Is_Valid()) {
         LOG_ERROR("UpdateEndNodes - failed to find associated node");
       } else {
-        end_node = iter->second;
-        found++;
+        end_node = iter->second[edge->endnode().id()];
       }
 
       // Copy the edge to the directededges vector and update the end node
@@ -283,8 +312,6 @@ namespace mjolnir {
 // Optionally filter edges and nodes based on access.
 void GraphFilter::Filter(const boost::property_tree::ptree& pt) {
 
-  // TODO: thread this. Could be difficult due to sequence creates to associate nodes
-
   // Edge filtering (optionally exclude edges)
   bool include_driving = pt.get_child("mjolnir").get<bool>("include_driving", true);
   if (!include_driving) {
@@ -304,21 +331,63 @@ void GraphFilter::Filter(const boost::property_tree::ptree& pt) {
     return;
   }
 
-  // Map of old node Ids to new node Ids (after filtering).
-  std::unordered_map<baldr::GraphId, baldr::GraphId> old_to_new;
+  const auto& mjolnir_pt = pt.get_child("mjolnir");
+  auto concurrency =
+      std::max(static_cast<uint32_t>(1),
+               mjolnir_pt.get<uint32_t>("concurrency", std::thread::hardware_concurrency()));
+  auto local_level = TileHierarchy::levels().back().level;
+  auto get_tiles = [&mjolnir_pt, local_level]() {
+    auto tile_set = GraphReader(mjolnir_pt).GetTileSet(local_level);
+    std::vector<GraphId> tiles(tile_set.begin(), tile_set.end());
+    std::sort(tiles.begin(), tiles.end());
+    return tiles;
+  };
+  auto run = [concurrency](size_t tile_count, const std::function<void(size_t)>& work) {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(concurrency, tile_count); ++i) {
+      threads.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  };
 
-  // Construct GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
+  // Map of old node Ids to new node Ids (after filtering).
+  auto local_tiles = get_tiles();
+  node_map_t old_to_new;
+  for (const auto& tile_id : local_tiles) {
+    old_to_new[tile_id];
+  }
 
-  // Filter edges (and nodes) by access
-  FilterTiles(reader, old_to_new, include_driving, include_bicycle, include_pedestrian);
+  // Filter edges (and nodes) by access, each tile is rewritten on its own
+  std::atomic<size_t> next_tile(0);
+  std::vector<filter_stats_t> stats(concurrency);
+  run(local_tiles.size(), [&](size_t i) {
+    FilterTiles(mjolnir_pt, local_tiles, next_tile, old_to_new, include_driving, include_bicycle,
+                include_pedestrian, stats[i]);
+  });
+  filter_stats_t total;
+  for (const auto& s : stats) {
+    total += s;
+  }
+  LOG_INFO("Filtered " + std::to_string(total.n_filtered_nodes) + " nodes out of " +
+           std::to_string(total.n_original_nodes));
+  LOG_INFO("Filtered " + std::to_string(total.n_filtered_edges) + " directededges out of " +
+           std::to_string(total.n_original_edges));
+  LOG_INFO("Can aggregate: " + std::to_string(total.can_aggregate));
 
   // TODO - aggregate / combine edges across false nodes (only 2 directed edges)
   // where way Ids are equal
 
-  // Update end nodes. Clear the GraphReader cache first.
-  reader.Clear();
-  UpdateEndNodes(reader, old_to_new);
+  // Update end nodes once every tile is filtered since edges end in the nodes of other tiles. The
+  // tiles which had everything filtered are gone.
+  LOG_INFO("Update end nodes of directed edges");
+  local_tiles = get_tiles();
+  next_tile = 0;
+  run(local_tiles.size(), [&](size_t) {
+    UpdateEndNodes(mjolnir_pt, local_tiles, next_tile, old_to_new);
+  });
 
   LOG_INFO("Done GraphFilter");
 }
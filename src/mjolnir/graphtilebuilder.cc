@@ -2,6 +2,7 @@
 
 #include "baldr/datetime.h"
 #include "baldr/edgeinfo.h"
+#include "baldr/textdictionary.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
@@ -18,6 +19,32 @@ namespace mjolnir {
 
 namespace {
 
+// Writes the hot attributes of the directed edges where the tile file keeps them
+void WriteHotDirectedEdges(std::ofstream& file,
+                           const GraphTileHeader& header,
+                           const DirectedEdge* directededges) {
+  std::vector<DirectedEdgeHot> hot;
+  hot.reserve(header.directededgecount());
+  for (uint32_t i = 0; i < header.directededgecount(); ++i) {
+    hot.emplace_back(directededges[i]);
+  }
+  file.seekp(header.hot_directededge_offset());
+  file.write(reinterpret_cast<const char*>(hot.data()), hot.size() * sizeof(DirectedEdgeHot));
+}
+
+// Tiles which are rewritten in place are written beside where they go and then moved there, so
+// that readers of the tile in other threads never see it half written
+filesystem::path PartialTilePath(const filesystem::path& filename) {
+  return filesystem::path(filename.string() + ".partial");
+}
+
+void ReplaceTile(const filesystem::path& partial, const filesystem::path& filename) {
+  if (!filesystem::rename(partial, filename)) {
+    filesystem::remove(partial);
+    throw std::runtime_error("Failed to replace file " + filename.string());
+  }
+}
+
 std::vector<ComplexRestrictionBuilder> DeserializeRestrictions(char* restrictions,
                                                                size_t restrictions_size) {
   std::vector<ComplexRestrictionBuilder> builders;
@@ -191,6 +218,7 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
       eib.AddNameInfo(info);
     }
     eib.set_encoded_shape(ei.encoded_shape());
+    eib.set_encoded_elevation(ei.encoded_elevation());
     edge_info_offset_ += eib.SizeOf();
     edgeinfo_list_.emplace_back(std::move(eib));
 
@@ -198,20 +226,34 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
     edgeinfo_offset_map_[offset] = &edgeinfo_list_.back();
   }
 
-  // Text list
+  // Text list. The text a tile shares through a text dictionary is copied back into the list so
+  // that the offsets AddName hands out stay valid, StoreTileData shares it again
+  std::unordered_map<uint32_t, uint32_t> plain_offsets;
   for (auto ni = name_info.begin(); ni != name_info.end(); ++ni) {
-    // compute the width of the entry by looking at the next offset or the end if its the last one
-    auto next = std::next(ni);
-    auto width = next != name_info.end() ? (next->name_offset_ - ni->name_offset_)
-                                         : (textlist_size_ - ni->name_offset_);
-
-    // Keep the bytes for this entry....remove null terminating char as it is added in StoreTileData
-    textlistbuilder_.emplace_back(textlist_ + ni->name_offset_, width - 1);
+    if (ni->name_offset_ < shared_textlist_size_) {
+      textlistbuilder_.emplace_back(shared_textlist_ + ni->name_offset_);
+    } else {
+      // compute the width of the entry by looking at the next offset or the end if its the last
+      auto next = std::next(ni);
+      auto width = next != name_info.end() ? (next->name_offset_ - ni->name_offset_)
+                                           : (text_size() - ni->name_offset_);
+
+      // Keep the bytes for this entry....remove null terminating char as it is added in
+      // StoreTileData
+      textlistbuilder_.emplace_back(text(ni->name_offset_), width - 1);
+    }
+    if (shared_textlist_size_) {
+      plain_offsets.emplace(ni->name_offset_, text_list_offset_);
+    }
     // Remember what offset they had
-    text_offset_map_.emplace(textlistbuilder_.back(), ni->name_offset_);
+    text_offset_map_.emplace(textlistbuilder_.back(), text_list_offset_);
     // Keep track of how large it is for storing it back to disk later
     text_list_offset_ += textlistbuilder_.back().length() + 1;
   }
+  if (shared_textlist_size_) {
+    RemapText(plain_offsets);
+    header_builder_.set_shared_textlist(0, 0);
+  }
 
   // Lane connectivity
   lane_connectivity_offset_ = lane_connectivity_size_;
@@ -237,6 +279,35 @@ void GraphTileBuilder::StoreTileData() {
     filesystem::create_directories(filename.parent_path());
   }
 
+  // Text which is in the text dictionary is left out of the tile. Tiles with transit keep all of
+  // their text since the transit structures aren't remapped. The name offsets have 24 bits so
+  // tiles whose own text doesn't fit after the dictionary keep all of their text too
+  auto dictionary = text_dictionary_;
+  std::unordered_map<uint32_t, uint32_t> shared_offsets;
+  std::vector<const std::string*> own_text;
+  uint32_t own_text_size = text_list_offset_;
+  if (dictionary && departure_builder_.empty() && stop_builder_.empty() && route_builder_.empty()) {
+    uint32_t plain_offset = 0, own_offset = 0;
+    for (const auto& text : textlistbuilder_) {
+      auto offset = dictionary->find(text);
+      if (offset == TextDictionary::kNotFound) {
+        offset = dictionary->size() + own_offset;
+        own_offset += text.length() + 1;
+        own_text.push_back(&text);
+      }
+      shared_offsets.emplace(plain_offset, offset);
+      plain_offset += text.length() + 1;
+    }
+    if (static_cast<uint64_t>(dictionary->size()) + own_offset <= kMaxNameOffset) {
+      own_text_size = own_offset;
+      RemapText(shared_offsets);
+    } else {
+      dictionary.reset();
+    }
+  } else {
+    dictionary.reset();
+  }
+
   // Open file and truncate
   std::stringstream in_mem;
   std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
@@ -329,9 +400,24 @@ void GraphTileBuilder::StoreTileData() {
         // TODO - once transit transfers are added need to update here
         (signs_builder_.size() * sizeof(Sign)) + (turnlanes_builder_.size() * sizeof(TurnLanes)) +
         (admins_builder_.size() * sizeof(Admin)));
+    // Sort them by the edge they are looked up by so the index of them is in the same order
+    std::stable_sort(complex_restriction_forward_builder_.begin(),
+                     complex_restriction_forward_builder_.end(),
+                     [](const ComplexRestrictionBuilder& a, const ComplexRestrictionBuilder& b) {
+                       return a.to_graphid().value < b.to_graphid().value;
+                     });
+    std::stable_sort(complex_restriction_reverse_builder_.begin(),
+                     complex_restriction_reverse_builder_.end(),
+                     [](const ComplexRestrictionBuilder& a, const ComplexRestrictionBuilder& b) {
+                       return a.from_graphid().value < b.from_graphid().value;
+                     });
+    std::vector<uint32_t> restriction_index{
+        static_cast<uint32_t>(complex_restriction_forward_builder_.size()),
+        static_cast<uint32_t>(complex_restriction_reverse_builder_.size())};
     uint32_t forward_restriction_size = 0;
     for (auto& complex_restriction : complex_restriction_forward_builder_) {
       in_mem << complex_restriction;
+      restriction_index.push_back(forward_restriction_size);
       forward_restriction_size += complex_restriction.SizeOf();
     }
 
@@ -341,6 +427,7 @@ void GraphTileBuilder::StoreTileData() {
     uint32_t reverse_restriction_size = 0;
     for (auto& complex_restriction : complex_restriction_reverse_builder_) {
       in_mem << complex_restriction;
+      restriction_index.push_back(reverse_restriction_size);
       reverse_restriction_size += complex_restriction.SizeOf();
     }
 
@@ -353,8 +440,23 @@ void GraphTileBuilder::StoreTileData() {
 
     // Write the names
     header_builder_.set_textlist_offset(header_builder_.edgeinfo_offset() + edge_info_offset_);
-    for (const auto& text : textlistbuilder_) {
-      in_mem << text << '\0';
+    if (dictionary) {
+      header_builder_.set_shared_textlist(dictionary->size(), dictionary->checksum());
+      for (const auto* text : own_text) {
+        in_mem << *text << '\0';
+      }
+
+      // Put the offsets back in case more is added to the builder
+      std::unordered_map<uint32_t, uint32_t> plain_offsets;
+      for (const auto& offsets : shared_offsets) {
+        plain_offsets.emplace(offsets.second, offsets.first);
+      }
+      RemapText(plain_offsets);
+    } else {
+      header_builder_.set_shared_textlist(0, 0);
+      for (const auto& text : textlistbuilder_) {
+        in_mem << text << '\0';
+      }
     }
 
     // Add padding (if needed) to align to 8-byte word.
@@ -366,14 +468,27 @@ void GraphTileBuilder::StoreTileData() {
 
     // Write lane connections
     header_builder_.set_lane_connectivity_offset(header_builder_.textlist_offset() +
-                                                 text_list_offset_ + padding);
+                                                 own_text_size + padding);
     std::sort(lane_connectivity_builder_.begin(), lane_connectivity_builder_.end());
     in_mem.write(reinterpret_cast<const char*>(lane_connectivity_builder_.data()),
                  lane_connectivity_builder_.size() * sizeof(LaneConnectivity));
 
+    // Write the index of the complex restrictions, padded to align to 8-byte word
+    header_builder_.set_complex_restriction_index_offset(
+        header_builder_.lane_connectivity_offset() +
+        (lane_connectivity_builder_.size() * sizeof(LaneConnectivity)));
+    if (restriction_index.size() % 2) {
+      restriction_index.push_back(0);
+    }
+    in_mem.write(reinterpret_cast<const char*>(restriction_index.data()),
+                 restriction_index.size() * sizeof(uint32_t));
+
     // Set the end offset
-    header_builder_.set_end_offset(header_builder_.lane_connectivity_offset() +
-                                   (lane_connectivity_builder_.size() * sizeof(LaneConnectivity)));
+    header_builder_.set_end_offset(header_builder_.complex_restriction_index_offset() +
+                                   (restriction_index.size() * sizeof(uint32_t)));
+
+    // The hot directed edges are only added once the tiles are complete
+    header_builder_.set_hot_directededge_offset(0);
 
     // Sanity check for the end offset
     uint32_t curr =
@@ -408,6 +523,20 @@ void GraphTileBuilder::StoreTileData() {
 // tile contents remains the same.
 void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
                               const std::vector<DirectedEdge>& directededges) {
+  // keep the extended directed edge attributes the tile already has
+  std::vector<DirectedEdgeExt> directededges_ext;
+  if (header_->has_ext_directededge()) {
+    directededges_ext.assign(ext_directededges_,
+                             ext_directededges_ + header_->directededgecount());
+  }
+  Update(nodes, directededges, directededges_ext);
+}
+
+// Update a graph tile with new nodes, directed edges and extended directed edges.
+// The rest of the tile contents remains the same.
+void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
+                              const std::vector<DirectedEdge>& directededges,
+                              const std::vector<DirectedEdgeExt>& directededges_ext) {
   // Get the name of the file
   filesystem::path filename =
       tile_dir_ + filesystem::path::preferred_separator + GraphTile::FileSuffix(header_->graphid());
@@ -417,37 +546,79 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
     filesystem::create_directories(filename.parent_path());
   }
 
+  // Make sure node and edge counts match.
+  if (nodes.size() != header_->nodecount()) {
+    throw std::runtime_error("GraphTileBuilder::Update - node count has changed");
+  }
+  if (directededges.size() != header_->directededgecount()) {
+    throw std::runtime_error("GraphTileBuilder::Update - directed edge count has changed");
+  }
+  if (!directededges_ext.empty() && directededges_ext.size() != directededges.size()) {
+    throw std::runtime_error(
+        "GraphTileBuilder::Update - directed edge extensions do not match directed edges");
+  }
+
+  // Adding or removing the extended attributes moves everything after them
+  GraphTileHeader header = *header_;
+  const int64_t old_ext_size =
+      header.has_ext_directededge() ? header.directededgecount() * sizeof(DirectedEdgeExt) : 0;
+  const int64_t shift =
+      static_cast<int64_t>(directededges_ext.size() * sizeof(DirectedEdgeExt)) - old_ext_size;
+  if (shift != 0) {
+    header.set_has_ext_directededge(!directededges_ext.empty());
+    header.set_complex_restriction_forward_offset(header.complex_restriction_forward_offset() +
+                                                  shift);
+    header.set_complex_restriction_reverse_offset(header.complex_restriction_reverse_offset() +
+                                                  shift);
+    header.set_edgeinfo_offset(header.edgeinfo_offset() + shift);
+    header.set_textlist_offset(header.textlist_offset() + shift);
+    header.set_lane_connectivity_offset(header.lane_connectivity_offset() + shift);
+    if (header.predictedspeeds_count() > 0) {
+      header.set_predictedspeeds_offset(header.predictedspeeds_offset() + shift);
+    }
+    if (header.has_hot_directededge()) {
+      header.set_hot_directededge_offset(header.hot_directededge_offset() + shift);
+    }
+    if (header.complex_restriction_index_offset()) {
+      header.set_complex_restriction_index_offset(header.complex_restriction_index_offset() +
+                                                  shift);
+    }
+    header.set_end_offset(header.end_offset() + shift);
+  }
+
   // Open file. Truncate so we replace the contents.
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  const auto partial = PartialTilePath(filename);
+  std::ofstream file(partial.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
     // Write the header
-    file.write(reinterpret_cast<const char*>(header_), sizeof(GraphTileHeader));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(GraphTileHeader));
 
-    // Write the updated nodes. Make sure node count matches.
-    if (nodes.size() != header_->nodecount()) {
-      throw std::runtime_error("GraphTileBuilder::Update - node count has changed");
-    }
+    // Write the updated nodes
     file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(NodeInfo));
 
     // Write node transitions
     file.write(reinterpret_cast<const char*>(transitions_),
                header_->transitioncount() * sizeof(NodeTransition));
 
-    // Write the updated directed edges. Make sure edge count matches.
-    if (directededges.size() != header_->directededgecount()) {
-      throw std::runtime_error("GraphTileBuilder::Update - directed edge count has changed");
-    }
+    // Write the updated directed edges
     file.write(reinterpret_cast<const char*>(directededges.data()),
                directededges.size() * sizeof(DirectedEdge));
 
-    // If there are extended directed edge attributes they would need to be written out here
-    // (and likely added to the method)
+    // Write the extended directed edge attributes
+    file.write(reinterpret_cast<const char*>(directededges_ext.data()),
+               directededges_ext.size() * sizeof(DirectedEdgeExt));
 
     // Write the rest of the tiles
     auto begin = reinterpret_cast<const char*>(&access_restrictions_[0]);
-    auto end = reinterpret_cast<const char*>(header()) + header()->end_offset();
+    auto end = reinterpret_cast<const char*>(header_) + header_->end_offset();
     file.write(begin, end - begin);
+
+    // Keep the hot directed edges in step with the updated directed edges
+    if (header.has_hot_directededge()) {
+      WriteHotDirectedEdges(file, header, directededges.data());
+    }
     file.close();
+    ReplaceTile(partial, filename);
   } else {
     throw std::runtime_error("GraphTileBuilder::Update - Failed to open file " + filename.string());
   }
@@ -860,6 +1031,76 @@ void GraphTileBuilder::set_mean_elevation(const uint32_t offset, const float ele
   e->second->set_mean_elevation(elev);
 }
 
+// Set the elevation profile of the EdgeInfo given the edge info offset. This requires
+// a serialized tile builder.
+void GraphTileBuilder::set_elevation(const uint32_t offset, const std::vector<float>& elevation) {
+  auto e = edgeinfo_offset_map_.find(offset);
+  if (e == edgeinfo_offset_map_.end()) {
+    LOG_ERROR("set_elevation - could not find the EdgeInfo index given the offset");
+    return;
+  }
+  e->second->set_elevation(elevation);
+}
+
+// Recompute the EdgeInfo offsets from their sizes and update the directed edges to match
+void GraphTileBuilder::UpdateEdgeInfoOffsets() {
+  std::unordered_map<const EdgeInfoBuilder*, uint32_t> new_offsets;
+  edge_info_offset_ = 0;
+  for (const auto& edgeinfo : edgeinfo_list_) {
+    new_offsets.emplace(&edgeinfo, edge_info_offset_);
+    edge_info_offset_ += edgeinfo.SizeOf();
+  }
+
+  std::unordered_map<uint32_t, uint32_t> remap;
+  std::unordered_map<uint32_t, EdgeInfoBuilder*> edgeinfo_offset_map;
+  for (const auto& e : edgeinfo_offset_map_) {
+    auto offset = new_offsets[e.second];
+    remap.emplace(e.first, offset);
+    edgeinfo_offset_map.emplace(offset, e.second);
+  }
+  edgeinfo_offset_map_ = std::move(edgeinfo_offset_map);
+
+  for (auto& directededge : directededges_builder_) {
+    auto found = remap.find(directededge.edgeinfo_offset());
+    if (found != remap.end()) {
+      directededge.set_edgeinfo_offset(found->second);
+    }
+  }
+  for (auto& e : edge_offset_map_) {
+    auto found = remap.find(e.second);
+    if (found != remap.end()) {
+      e.second = found->second;
+    }
+  }
+}
+
+// Changes the text offsets of everything but the transit structures
+void GraphTileBuilder::RemapText(const std::unordered_map<uint32_t, uint32_t>& offsets) {
+  // turn lanes which aren't serialized keep offsets which aren't into the text list
+  auto remap = [&offsets](const uint32_t offset) {
+    auto found = offsets.find(offset);
+    return found == offsets.cend() ? offset : found->second;
+  };
+  for (auto& edgeinfo : edgeinfo_list_) {
+    auto name_info = edgeinfo.name_info_list();
+    for (auto& info : name_info) {
+      info.name_offset_ = remap(info.name_offset_);
+    }
+    edgeinfo.set_name_info_list(name_info);
+  }
+  for (auto& sign : signs_builder_) {
+    sign = Sign(sign.index(), sign.type(), sign.is_route_num_type(), sign.tagged(),
+                remap(sign.text_offset()));
+  }
+  for (auto& turnlanes : turnlanes_builder_) {
+    turnlanes = TurnLanes(turnlanes.edgeindex(), remap(turnlanes.text_offset()));
+  }
+  for (auto& admin : admins_builder_) {
+    admin = Admin(remap(admin.country_offset()), remap(admin.state_offset()), admin.country_iso(),
+                  admin.state_iso());
+  }
+}
+
 // Add a name to the text list
 uint32_t GraphTileBuilder::AddName(const std::string& name) {
   if (name.empty()) {
@@ -1061,6 +1302,7 @@ std::array<std::vector<GraphId>, kBinCount> GraphTileBuilder::BinEdges(const gra
 
   // each edge please
   std::unordered_set<uint64_t> ids(tile->header()->directededgecount() / 2);
+  std::vector<Tiles<PointLL>::cell_t> cells;
   const auto* start_edge = tile->directededge(0);
   for (const DirectedEdge* edge = start_edge; edge < start_edge + tile->header()->directededgecount();
        ++edge) {
@@ -1090,25 +1332,33 @@ std::array<std::vector<GraphId>, kBinCount> GraphTileBuilder::BinEdges(const gra
       continue;
     }
 
-    // for each bin that got intersected
-    auto intersection = tiles.Intersect(shape);
+    // for each bin that got intersected, once each and grouped by tile
+    cells.clear();
+    tiles.Intersect(shape, cells);
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
     GraphId edge_id(tile->header()->graphid().tileid(), tile->header()->graphid().level(),
                     edge - start_edge);
-    for (const auto& i : intersection) {
+    for (auto i = cells.cbegin(); i != cells.cend();) {
+      // the bins of this tile
+      const auto tile_id = i->first;
+      const auto end = std::find_if(i, cells.cend(),
+                                    [tile_id](const auto& cell) { return cell.first != tile_id; });
       // as per the rules above about when to add intersections
-      auto originating = i.first == start_id;
-      auto terminating = i.first == end_id;
-      auto loop_back = i.first != start_id && i.first != end_id && start_id == end_id;
+      auto originating = tile_id == start_id;
+      auto terminating = tile_id == end_id;
+      auto loop_back = tile_id != start_id && tile_id != end_id && start_id == end_id;
       if (originating || (intermediate && !terminating) || loop_back) {
         // which set of bins, either this local set or tweeners to be added later
         auto& out_bins = originating && max
                              ? bins
-                             : tweeners.insert({GraphId(i.first, max_level, 0), {}}).first->second;
+                             : tweeners.insert({GraphId(tile_id, max_level, 0), {}}).first->second;
         // keep the edge id
-        for (auto bin : i.second) {
-          out_bins[bin].push_back(edge_id);
+        for (; i != end; ++i) {
+          out_bins[i->second].push_back(edge_id);
         }
       }
+      i = end;
     }
   }
 
@@ -1144,6 +1394,15 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   header.set_edgeinfo_offset(header.edgeinfo_offset() + shift);
   header.set_textlist_offset(header.textlist_offset() + shift);
   header.set_lane_connectivity_offset(header.lane_connectivity_offset() + shift);
+  if (header.predictedspeeds_count() > 0) {
+    header.set_predictedspeeds_offset(header.predictedspeeds_offset() + shift);
+  }
+  if (header.has_hot_directededge()) {
+    header.set_hot_directededge_offset(header.hot_directededge_offset() + shift);
+  }
+  if (header.complex_restriction_index_offset()) {
+    header.set_complex_restriction_index_offset(header.complex_restriction_index_offset() + shift);
+  }
   header.set_end_offset(header.end_offset() + shift);
   // rewrite the tile
   filesystem::path filename =
@@ -1151,7 +1410,8 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   if (!filesystem::exists(filename.parent_path())) {
     filesystem::create_directories(filename.parent_path());
   }
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  const auto partial = PartialTilePath(filename);
+  std::ofstream file(partial.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
   // open it
   if (file.is_open()) {
     // new header
@@ -1168,12 +1428,48 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
     begin = reinterpret_cast<const char*>(tile->GetBin(kBinsDim - 1, kBinsDim - 1).end());
     end = reinterpret_cast<const char*>(tile->header()) + tile->header()->end_offset();
     file.write(begin, end - begin);
+    file.close();
+    ReplaceTile(partial, filename);
   } // failed
   else {
     throw std::runtime_error("Failed to open file " + filename.string());
   }
 }
 
+// Appends the hot directed edge attributes to the end of the tile or refreshes the ones it has
+void GraphTileBuilder::AddHotDirectedEdges(const std::string& tile_dir,
+                                           const graph_tile_ptr& tile) {
+  assert(tile);
+  GraphTileHeader header = *tile->header();
+  const uint32_t size = header.end_offset();
+  if (!header.has_hot_directededge()) {
+    // keep them aligned to 8-byte words
+    const uint32_t offset = (size + 7) & ~7u;
+    header.set_hot_directededge_offset(offset);
+    header.set_end_offset(offset + header.directededgecount() * sizeof(DirectedEdgeHot));
+  }
+
+  // rewrite the tile
+  filesystem::path filename =
+      tile_dir + filesystem::path::preferred_separator + GraphTile::FileSuffix(header.graphid());
+  if (!filesystem::exists(filename.parent_path())) {
+    filesystem::create_directories(filename.parent_path());
+  }
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open file " + filename.string());
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(GraphTileHeader));
+  const auto* begin = reinterpret_cast<const char*>(tile->header()) + sizeof(GraphTileHeader);
+  const auto* end = reinterpret_cast<const char*>(tile->header()) + size;
+  file.write(begin, end - begin);
+  // pad up to the hot directed edges when they are appended
+  if (header.hot_directededge_offset() > size) {
+    file.write("\0\0\0\0\0\0\0", header.hot_directededge_offset() - size);
+  }
+  WriteHotDirectedEdges(file, header, tile->GetDirectedEdges().begin());
+}
+
 // Add a predicted speed profile for a directed edge.
 void GraphTileBuilder::AddPredictedSpeed(const uint32_t idx,
                                          const std::array<int16_t, kCoefficientCount>& coefficients,
@@ -1253,6 +1549,11 @@ void GraphTileBuilder::UpdatePredictedSpeeds(const std::vector<DirectedEdge>& di
     // Write the rest of the tiles. TBD (if anything is added after the speed profiles
     // then this will need to be updated)
 
+    // The hot directed edges come before the speed profiles, refresh them with the new speeds
+    if (header_builder_.has_hot_directededge()) {
+      WriteHotDirectedEdges(file, header_builder_, directededges.data());
+    }
+
     // Close the file
     file.close();
   }
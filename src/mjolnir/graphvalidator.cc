@@ -3,11 +3,11 @@
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/util.h"
 
+#include <atomic>
 #include <boost/format.hpp>
 #include <future>
 #include <iostream>
 #include <list>
-#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <queue>
@@ -245,10 +245,14 @@ uint32_t GetOpposingEdgeIndex(const GraphId& startnode,
 }
 
 using tweeners_t = GraphTileBuilder::tweeners_t;
+
+// Each thread keeps what it finds to itself and the results are merged once they are all done.
+// Threads take the next tile by bumping an atomic index and read their neighbours' tiles without
+// locking since the tiles are replaced whole when they are rewritten
 void validate(
     const boost::property_tree::ptree& pt,
-    std::deque<GraphId>& tilequeue,
-    std::mutex& lock,
+    const std::vector<GraphId>& tiles_to_validate,
+    std::atomic<size_t>& next_tile,
     std::promise<std::tuple<std::vector<uint32_t>, std::vector<std::vector<float>>, tweeners_t>>&
         result) {
   // Our local copy of edges binned to tiles that they pass through (dont start or end in)
@@ -269,16 +273,9 @@ void validate(
   std::set<uint32_t> problem_ways;
 
   // Check for more tiles
-  while (true) {
-    lock.lock();
-    if (tilequeue.empty()) {
-      lock.unlock();
-      break;
-    }
+  for (size_t t = next_tile++; t < tiles_to_validate.size(); t = next_tile++) {
     // Get the next tile Id
-    GraphId tile_id = tilequeue.front();
-    tilequeue.pop_front();
-    lock.unlock();
+    GraphId tile_id = tiles_to_validate[t];
 
     // Point tiles to the set we need for current level
     const auto& tiles = tile_id.level() == TileHierarchy::GetTransitLevel().level
@@ -295,9 +292,7 @@ void validate(
     std::vector<DirectedEdge> directededges;
 
     // Get this tile
-    lock.lock();
     graph_tile_ptr tile = graph_reader.GetGraphTile(tile_id);
-    lock.unlock();
 
     // Iterate through the nodes and the directed edges
     uint32_t dupcount = 0;
@@ -372,9 +367,7 @@ void validate(
           directededge.set_leaves_tile(true);
 
           // Get the end node tile
-          lock.lock();
           endnode_tile = graph_reader.GetGraphTile(directededge.endnode());
-          lock.unlock();
           // make sure this is set to false as access tag logic could of set this to true.
         } else {
           directededge.set_leaves_tile(false);
@@ -407,7 +400,7 @@ void validate(
           uint32_t modes = 0;
           for (uint32_t mode = 1; mode < kAllAccess; mode *= 2) {
             if ((de->end_restriction() & mode) &&
-                tile->GetRestrictions(true, edgeid, mode).size() > 0) {
+                !tile->GetRestrictions(true, edgeid, mode).empty()) {
               modes |= mode;
             }
           }
@@ -417,7 +410,7 @@ void validate(
           uint32_t modes = 0;
           for (uint32_t mode = 1; mode < kAllAccess; mode *= 2) {
             if ((de->start_restriction() & mode) &&
-                tile->GetRestrictions(false, edgeid, mode).size() > 0) {
+                !tile->GetRestrictions(false, edgeid, mode).empty()) {
               modes |= mode;
             }
           }
@@ -455,7 +448,6 @@ void validate(
     auto bins = GraphTileBuilder::BinEdges(tile, tweeners);
 
     // Write the new tile
-    lock.lock();
     tilebuilder.Update(nodes, directededges);
 
     // Write the bins to it
@@ -468,7 +460,6 @@ void validate(
     if (graph_reader.OverCommitted()) {
       graph_reader.Trim();
     }
-    lock.unlock();
 
     // Add possible duplicates to return class
     duplicates[level] += dupcount;
@@ -485,10 +476,10 @@ void validate(
 
 // take tweeners from different tiles' perspectives and merge into a single tweener
 // per tile that needs to update its bins
-void merge(const tweeners_t& in, tweeners_t& out) {
-  for (const auto& t : in) {
+void merge(tweeners_t&& in, tweeners_t& out) {
+  for (auto& t : in) {
     // shove it in
-    auto inserted = out.insert(t);
+    auto inserted = out.try_emplace(t.first, std::move(t.second));
     // had this tile already
     if (!inserted.second) {
       // so have to merge
@@ -502,21 +493,13 @@ void merge(const tweeners_t& in, tweeners_t& out) {
 
 // crack open tiles and bin edges that pass through them but dont end or begin in them
 void bin_tweeners(const std::string& tile_dir,
-                  tweeners_t::iterator& start,
-                  const tweeners_t::iterator& end,
-                  uint64_t dataset_id,
-                  std::mutex& lock) {
+                  const std::vector<const tweeners_t::value_type*>& tiles_to_bin,
+                  std::atomic<size_t>& next_tile,
+                  uint64_t dataset_id) {
   // go while we have tiles to update
-  while (true) {
-    lock.lock();
-    if (start == end) {
-      lock.unlock();
-      break;
-    }
+  for (size_t t = next_tile++; t < tiles_to_bin.size(); t = next_tile++) {
     // grab this tile and its extra bin edges
-    const auto& tile_bin = *start;
-    ++start;
-    lock.unlock();
+    const auto& tile_bin = *tiles_to_bin[t];
 
     // some tiles are just there because edges' shapes passes through them (no edges/nodes, just bins)
     // if that's the case we need to make a tile to store the spatial index (binned edges) there
@@ -543,9 +526,10 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   std::string tile_dir = hierarchy_properties.get<std::string>("tile_dir");
 
   // Create a randomized queue of tiles (at all levels) to work from
-  std::deque<GraphId> tilequeue;
+  std::vector<GraphId> tilequeue;
   GraphReader reader(pt.get_child("mjolnir"));
   auto tileset = reader.GetTileSet();
+  tilequeue.reserve(tileset.size());
   for (const auto& id : tileset) {
     tilequeue.emplace_back(id);
   }
@@ -557,8 +541,8 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   assert(tilequeue.size() && first_tile);
   auto dataset_id = first_tile->header()->dataset_id();
 
-  // An mutex we can use to do the synchronization
-  std::mutex lock;
+  // The index of the next tile a thread takes
+  std::atomic<size_t> next_tile(0);
 
   // Setup threads
   std::vector<std::shared_ptr<std::thread>> threads(
@@ -573,8 +557,8 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   // Spawn the threads
   for (auto& thread : threads) {
     results.emplace_back();
-    thread.reset(new std::thread(validate, std::cref(pt), std::ref(tilequeue), std::ref(lock),
-                                 std::ref(results.back())));
+    thread.reset(new std::thread(validate, std::cref(pt), std::cref(tilequeue),
+                                 std::ref(next_tile), std::ref(results.back())));
   }
 
   // Wait for threads to finish
@@ -595,17 +579,21 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
       }
     }
     // keep track of tweeners
-    merge(std::get<2>(data), tweeners);
+    merge(std::move(std::get<2>(data)), tweeners);
   }
   LOG_INFO("Finished");
 
   // run a pass to add the edges that binned to tweener tiles
   LOG_INFO("Binning inter-tile edges...");
-  auto start = tweeners.begin();
-  auto end = tweeners.end();
+  std::vector<const tweeners_t::value_type*> tiles_to_bin;
+  tiles_to_bin.reserve(tweeners.size());
+  for (const auto& tile_bin : tweeners) {
+    tiles_to_bin.push_back(&tile_bin);
+  }
+  next_tile = 0;
   for (auto& thread : threads) {
-    thread.reset(new std::thread(bin_tweeners, std::cref(tile_dir), std::ref(start), std::cref(end),
-                                 dataset_id, std::ref(lock)));
+    thread.reset(new std::thread(bin_tweeners, std::cref(tile_dir), std::cref(tiles_to_bin),
+                                 std::ref(next_tile), dataset_id));
   }
   for (auto& thread : threads) {
     thread->join();
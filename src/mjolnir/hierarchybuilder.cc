@@ -4,11 +4,17 @@
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -68,23 +74,29 @@ bool AddUpwardTransition(const GraphId& node, GraphTileBuilder* tilebuilder) {
   }
 }
 
-void SortSequences(const std::string& new_to_old_file, const std::string& old_to_new_file) {
+void SortSequences(const std::string& new_to_old_file,
+                   const std::string& old_to_new_file,
+                   size_t sort_memory,
+                   unsigned int threads) {
   // Sort the new nodes. Sort so highway level is first
   sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-  new_to_old.sort([](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
-    if (a.first.level() == b.first.level()) {
-      if (a.first.tileid() == b.first.tileid()) {
-        return a.first.id() < b.first.id();
-      }
-      return a.first.tileid() < b.first.tileid();
-    }
-    return a.first.level() < b.first.level();
-  });
+  new_to_old.sort(
+      [](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
+        if (a.first.level() == b.first.level()) {
+          if (a.first.tileid() == b.first.tileid()) {
+            return a.first.id() < b.first.id();
+          }
+          return a.first.tileid() < b.first.tileid();
+        }
+        return a.first.level() < b.first.level();
+      },
+      sort_memory, threads);
 
   // Sort old to new by node Id
   sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
   old_to_new.sort(
-      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
+      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; },
+      sort_memory, threads);
 }
 
 // Convenience method to find the node association.
@@ -121,16 +133,12 @@ bool OpposingEdgeInfoMatches(const graph_tile_ptr& tile, const DirectedEdge* edg
   return false;
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader,
-                         const std::string& new_to_old_file,
-                         const std::string& old_to_new_file) {
-  // Use the sequence that associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-
+// Form a tile in the new level from its range of the new nodes.
+void FormTile(GraphReader& reader,
+              sequence<std::pair<GraphId, GraphId>>& new_to_old,
+              sequence<OldToNewNodes>& old_to_new,
+              size_t begin,
+              size_t end) {
   // lambda to indicate whether a directed edge should be included
   auto include_edge = [&old_to_new](const DirectedEdge* directededge, const GraphId& base_node,
                                     const uint8_t current_level) {
@@ -158,39 +166,17 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
   };
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
+  // New tilebuilder for the tile of the new nodes. Set the base ll for this tile
   bool added = false;
-  uint8_t current_level = std::numeric_limits<uint8_t>::max();
-  GraphId tile_id;
   std::hash<std::string> hasher;
-  PointLL base_ll;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
-    GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
-      }
+  GraphId tile_id = (*new_to_old.at(begin)).first.Tile_Base();
+  uint8_t current_level = tile_id.level();
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+  PointLL base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
+  tilebuilder.header_builder().set_base_ll(base_ll);
 
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
-
-      // Set the base ll for this tile
-      base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
-      tilebuilder->header_builder().set_base_ll(base_ll);
-
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Trim();
-      }
-    }
+  for (auto new_node = new_to_old.at(begin); new_node != new_to_old.at(end); new_node++) {
+    GraphId nodea = (*new_node).first;
 
     // Get the node in the base level
     GraphId base_node = (*new_node).second;
@@ -201,25 +187,25 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
 
     // Copy the data version
-    tilebuilder->header_builder().set_dataset_id(tile->header()->dataset_id());
+    tilebuilder.header_builder().set_dataset_id(tile->header()->dataset_id());
 
     // Copy node information and set the node lat,lon offsets within the new tile
     NodeInfo baseni = *(tile->node(base_node.id()));
-    tilebuilder->nodes().push_back(baseni);
+    tilebuilder.nodes().push_back(baseni);
     const auto& admin = tile->admininfo(baseni.admin_index());
-    NodeInfo& node = tilebuilder->nodes().back();
+    NodeInfo& node = tilebuilder.nodes().back();
     node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
-    node.set_edge_index(tilebuilder->directededges().size());
+    node.set_edge_index(tilebuilder.directededges().size());
     node.set_timezone(baseni.timezone());
-    node.set_admin_index(tilebuilder->AddAdmin(admin.country_text(), admin.state_text(),
-                                               admin.country_iso(), admin.state_iso()));
+    node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                              admin.country_iso(), admin.state_iso()));
 
     // Update node LL based on tile base
     // Density at this node
     uint32_t density1 = baseni.density();
 
     // Current edge count
-    size_t edge_count = tilebuilder->directededges().size();
+    size_t edge_count = tilebuilder.directededges().size();
 
     // Iterate through directed edges of the base node to get remaining
     // directed edges (based on classification/importance cutoff)
@@ -273,13 +259,13 @@ void FormTilesInNewLevel(GraphReader& reader,
         if (signs.size() == 0) {
           LOG_ERROR("Base edge should have signs, but none found");
         }
-        tilebuilder->AddSigns(tilebuilder->directededges().size(), signs);
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
 
       // Get turn lanes from the base directed edge
       if (directededge->turnlanes()) {
         uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
-        tilebuilder->AddTurnLanes(tilebuilder->directededges().size(), tile->GetName(offset));
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
       }
 
       // Get access restrictions from the base directed edge. Add these to
@@ -288,8 +274,8 @@ void FormTilesInNewLevel(GraphReader& reader,
       if (directededge->access_restriction()) {
         auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
         for (const auto& res : restrictions) {
-          tilebuilder->AddAccessRestriction(AccessRestriction(tilebuilder->directededges().size(),
-                                                              res.type(), res.modes(), res.value()));
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
       }
 
@@ -300,9 +286,9 @@ void FormTilesInNewLevel(GraphReader& reader,
           LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
         for (auto& lc : laneconnectivity) {
-          lc.set_to(tilebuilder->directededges().size());
+          lc.set_to(tilebuilder.directededges().size());
         }
-        tilebuilder->AddLaneConnectivity(laneconnectivity);
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
       }
 
       // Do we need to force adding edgeinfo (opposing edge could have diff names)?
@@ -319,43 +305,43 @@ void FormTilesInNewLevel(GraphReader& reader,
       std::string encoded_shape = edgeinfo.encoded_shape();
       uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
       uint32_t edge_info_offset =
-          tilebuilder->AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                   edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
-                                   edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
-                                   edgeinfo.GetTaggedValues(true), edgeinfo.GetTypes(), added,
-                                   diff_names);
+          tilebuilder.AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                  edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
+                                  edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
+                                  edgeinfo.GetTaggedValues(true), edgeinfo.GetTypes(), added,
+                                  diff_names);
 
       newedge.set_edgeinfo_offset(edge_info_offset);
 
       // Add directed edge
-      tilebuilder->directededges().emplace_back(std::move(newedge));
+      tilebuilder.directededges().emplace_back(std::move(newedge));
     }
 
     // Add node transitions
-    uint32_t index = tilebuilder->transitions().size();
+    uint32_t index = tilebuilder.transitions().size();
     auto new_nodes = find_nodes(old_to_new, base_node);
     if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddDownwardTransition(new_nodes.arterial_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 1) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 2) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddUpwardTransition(new_nodes.arterial_node, &tilebuilder);
     } else {
       throw std::logic_error("current_level was never set");
     }
 
     // Set the node transition count and index
-    uint32_t count = tilebuilder->transitions().size() - index;
+    uint32_t count = tilebuilder.transitions().size() - index;
     if (count > 0) {
       node.set_transition_count(count);
       node.set_transition_index(index);
     }
 
     // Set the edge count for the new node
-    node.set_edge_count(tilebuilder->directededges().size() - edge_count);
+    node.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
     // Get named signs from the base node
     if (baseni.named_intersection()) {
@@ -364,27 +350,107 @@ void FormTilesInNewLevel(GraphReader& reader,
         LOG_ERROR("Base node should have signs, but none found");
       }
       node.set_named_intersection(true);
-      tilebuilder->AddSigns(tilebuilder->nodes().size() - 1, signs);
+      tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
     }
   }
 
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
+  // Store the tile
+  tilebuilder.StoreTileData();
+}
+
+// Form the tiles of the queue until it is empty. Each thread reads through a reader of its own.
+void FormTiles(const boost::property_tree::ptree& hierarchy_properties,
+               const std::string& new_to_old_file,
+               const std::string& old_to_new_file,
+               std::deque<std::pair<size_t, size_t>>& tilequeue,
+               std::mutex& lock,
+               std::promise<void>& result) {
+  try {
+    GraphReader reader(hierarchy_properties);
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+    while (true) {
+      lock.lock();
+      if (tilequeue.empty()) {
+        lock.unlock();
+        break;
+      }
+      auto range = tilequeue.front();
+      tilequeue.pop_front();
+      lock.unlock();
+
+      FormTile(reader, new_to_old, old_to_new, range.first, range.second);
+
+      // Check if we need to clear the base/local tile cache
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+    result.set_value();
+  } catch (...) { result.set_exception(std::current_exception()); }
+}
+
+// Form tiles in the new level.
+void FormTilesInNewLevel(const boost::property_tree::ptree& hierarchy_properties,
+                         const std::string& new_to_old_file,
+                         const std::string& old_to_new_file,
+                         unsigned int thread_count) {
+  // The new nodes are sorted by tile, highway level first. Each tile is a range of them. The tiles
+  // of the upper levels are formed from the nodes of any local tiles, so the local tiles are only
+  // replaced by the ones of the new local level once those are done. A new local tile is formed
+  // from its own local tile only.
+  std::deque<std::pair<size_t, size_t>> upper_tiles, local_tiles;
+  {
+    const auto local_level = TileHierarchy::levels().back().level;
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    GraphId tile_id;
+    size_t index = 0;
+    new_to_old.enumerate([&](const std::pair<GraphId, GraphId>& new_node) {
+      if (new_node.first.Tile_Base() != tile_id) {
+        tile_id = new_node.first.Tile_Base();
+        (tile_id.level() == local_level ? local_tiles : upper_tiles).emplace_back(index, index);
+      }
+      (tile_id.level() == local_level ? local_tiles : upper_tiles).back().second = ++index;
+    });
+  }
+
+  for (auto* tilequeue : {&upper_tiles, &local_tiles}) {
+    LOG_INFO("Forming " + std::to_string(tilequeue->size()) + " tiles with " +
+             std::to_string(thread_count) + " threads");
+    std::mutex lock;
+    std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+    std::list<std::promise<void>> results;
+    for (auto& thread : threads) {
+      results.emplace_back();
+      thread.reset(new std::thread(FormTiles, std::cref(hierarchy_properties),
+                                   std::cref(new_to_old_file), std::cref(old_to_new_file),
+                                   std::ref(*tilequeue), std::ref(lock), std::ref(results.back())));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+
+    // If something bad went down this will rethrow it
+    for (auto& result : results) {
+      result.get_future().get();
+    }
   }
 }
 
 /**
  * Create node associations between "new" nodes placed into respective
- * hierarchy levels and the existing nodes on the base/local level. The
- * associations go both ways: from the "old" nodes on the base/local level
- * to new nodes (using a mapping in memory) and from new nodes to old nodes
- * using a sequence (file).
+ * hierarchy levels and the existing nodes on a range of the base/local tiles.
+ * The associations go both ways: from the "old" nodes on the base/local level
+ * to new nodes and from new nodes to old nodes, both stored in sequences (files).
+ * The new node Ids count from 0 in every new tile, the caller shifts them by
+ * the number of new nodes the ranges before this one put in the same tile.
  */
-void CreateNodeAssociations(GraphReader& reader,
-                            const std::string& new_to_old_file,
-                            const std::string& old_to_new_file) {
+void AssociateNodes(const boost::property_tree::ptree& hierarchy_properties,
+                    std::vector<GraphId>::const_iterator tile_start,
+                    std::vector<GraphId>::const_iterator tile_end,
+                    const std::string& new_to_old_file,
+                    const std::string& old_to_new_file,
+                    std::promise<std::unordered_map<GraphId, uint32_t>>& result) {
   // Map of tiles vs. count of nodes. Used to construct new node Ids.
   std::unordered_map<GraphId, uint32_t> new_nodes;
 
@@ -402,90 +468,170 @@ void CreateNodeAssociations(GraphReader& reader,
     }
   };
 
-  // Create a sequence to associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, true);
+  try {
+    GraphReader reader(hierarchy_properties);
 
-  // Create a sequence to associate new nodes to old nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
+    // Create a sequence to associate new nodes to old nodes
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, true);
 
-  // Hierarchy level information
-  const auto& arterial_level = TileHierarchy::levels()[1];
-  uint32_t al = static_cast<uint32_t>(arterial_level.level);
-  const auto& highway_level = TileHierarchy::levels()[0];
-  uint32_t hl = static_cast<uint32_t>(highway_level.level);
-
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet();
-  for (const auto& base_tile_id : local_tiles) {
-    // We keep all transit data inside the transit hierarchy
-    if (base_tile_id.level() == TileHierarchy::GetTransitLevel().level) {
-      continue;
-    }
+    // Create a sequence to associate new nodes to old nodes
+    sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
 
-    // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
-    graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
-    if (!tile) {
-      continue;
-    }
+    // Hierarchy level information
+    const auto& arterial_level = TileHierarchy::levels()[1];
+    uint32_t al = static_cast<uint32_t>(arterial_level.level);
+    const auto& highway_level = TileHierarchy::levels()[0];
+    uint32_t hl = static_cast<uint32_t>(highway_level.level);
 
-    // Iterate through the nodes. Add nodes to the new level when
-    // best road class <= the new level classification cutoff
-    bool levels[3];
-    uint32_t nodecount = tile->header()->nodecount();
-    GraphId basenode = base_tile_id;
-    GraphId edgeid = base_tile_id;
-    PointLL base_ll = tile->header()->base_ll();
-    const NodeInfo* nodeinfo = tile->node(basenode);
-    for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
-      // Iterate through the edges to see which levels this node exists.
-      levels[0] = levels[1] = levels[2] = false;
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
-        // Update the flag for the level of this edge (skip transit
-        // connection edges)
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (directededge->bss_connection()) {
-          // Despite the road class, Bike Share Stations' connections are always at local level
-          levels[2] = true;
-        } else if (directededge->use() != Use::kTransitConnection &&
-                   directededge->use() != Use::kEgressConnection &&
-                   directededge->use() != Use::kPlatformConnection) {
-          levels[TileHierarchy::get_level(directededge->classification())] = true;
-        }
-      }
+    // Iterate through the local tiles of the range
+    for (; tile_start != tile_end; ++tile_start) {
+      const auto& base_tile_id = *tile_start;
 
-      // Associate new nodes to base nodes and base node to new nodes
-      GraphId highway_node, arterial_node, local_node;
-      if (levels[0]) {
-        // New node is on the highway level. Associate back to base/local node
-        GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
-        highway_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(highway_node, basenode));
-      }
-      if (levels[1]) {
-        // New node is on the arterial level. Associate back to base/local node
-        GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
-        arterial_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(arterial_node, basenode));
+      // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+      graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
+      if (!tile) {
+        continue;
       }
-      if (levels[2]) {
-        // New node is on the local level. Associate back to base/local node
-        local_node = get_new_node(base_tile_id);
-        new_to_old.push_back(std::make_pair(local_node, basenode));
+
+      // Iterate through the nodes. Add nodes to the new level when
+      // best road class <= the new level classification cutoff
+      bool levels[3];
+      uint32_t nodecount = tile->header()->nodecount();
+      GraphId basenode = base_tile_id;
+      GraphId edgeid = base_tile_id;
+      PointLL base_ll = tile->header()->base_ll();
+      const NodeInfo* nodeinfo = tile->node(basenode);
+      for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
+        // Iterate through the edges to see which levels this node exists.
+        levels[0] = levels[1] = levels[2] = false;
+        for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
+          // Update the flag for the level of this edge (skip transit
+          // connection edges)
+          const DirectedEdge* directededge = tile->directededge(edgeid);
+          if (directededge->bss_connection()) {
+            // Despite the road class, Bike Share Stations' connections are always at local level
+            levels[2] = true;
+          } else if (directededge->use() != Use::kTransitConnection &&
+                     directededge->use() != Use::kEgressConnection &&
+                     directededge->use() != Use::kPlatformConnection) {
+            levels[TileHierarchy::get_level(directededge->classification())] = true;
+          }
+        }
+
+        // Associate new nodes to base nodes and base node to new nodes
+        GraphId highway_node, arterial_node, local_node;
+        if (levels[0]) {
+          // New node is on the highway level. Associate back to base/local node
+          GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
+          highway_node = get_new_node(new_tile);
+          new_to_old.push_back(std::make_pair(highway_node, basenode));
+        }
+        if (levels[1]) {
+          // New node is on the arterial level. Associate back to base/local node
+          GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
+          arterial_node = get_new_node(new_tile);
+          new_to_old.push_back(std::make_pair(arterial_node, basenode));
+        }
+        if (levels[2]) {
+          // New node is on the local level. Associate back to base/local node
+          local_node = get_new_node(base_tile_id);
+          new_to_old.push_back(std::make_pair(local_node, basenode));
+        }
+
+        if (!levels[0] && !levels[1] && !levels[2]) {
+          LOG_ERROR("No valid level for this node!");
+        }
+
+        // Associate the old node to the new node(s). Entries in the tuple
+        // that are invalid nodes indicate no node exists in the new level.
+        OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
+        old_to_new.push_back(assoc);
       }
 
-      if (!levels[0] && !levels[1] && !levels[2]) {
-        LOG_ERROR("No valid level for this node!");
+      // Check if we need to clear the tile cache
+      if (reader.OverCommitted()) {
+        reader.Trim();
       }
+    }
+  } catch (...) {
+    result.set_exception(std::current_exception());
+    return;
+  }
+  result.set_value(std::move(new_nodes));
+}
 
-      // Associate the old node to the new node(s). Entries in the tuple
-      // that are invalid nodes indicate no node exists in the new level.
-      OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
-      old_to_new.push_back(assoc);
+/**
+ * Create node associations for all base/local tiles. The tiles are split in
+ * ranges which are associated in parallel, their sequences are then appended
+ * in order with the node Ids shifted so that they come out the same as when
+ * the tiles are associated one after the other.
+ */
+void CreateNodeAssociations(GraphReader& reader,
+                            const boost::property_tree::ptree& hierarchy_properties,
+                            const std::string& new_to_old_file,
+                            const std::string& old_to_new_file,
+                            unsigned int thread_count) {
+  // We keep all transit data inside the transit hierarchy
+  std::vector<GraphId> local_tiles;
+  for (const auto& base_tile_id : reader.GetTileSet()) {
+    if (base_tile_id.level() != TileHierarchy::GetTransitLevel().level) {
+      local_tiles.push_back(base_tile_id);
     }
+  }
+  LOG_INFO("Associating the nodes of " + std::to_string(local_tiles.size()) + " tiles with " +
+           std::to_string(thread_count) + " threads");
+
+  // Divvy up the work
+  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+  std::vector<std::promise<std::unordered_map<GraphId, uint32_t>>> results(threads.size());
+  size_t floor = local_tiles.size() / threads.size();
+  size_t at_ceiling = local_tiles.size() - (threads.size() * floor);
+  std::vector<GraphId>::const_iterator tile_start, tile_end = local_tiles.begin();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
+    tile_start = tile_end;
+    std::advance(tile_end, tile_count);
+    threads[i].reset(new std::thread(AssociateNodes, std::cref(hierarchy_properties), tile_start,
+                                     tile_end, new_to_old_file + "." + std::to_string(i),
+                                     old_to_new_file + "." + std::to_string(i),
+                                     std::ref(results[i])));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  // Number of new nodes the ranges so far put in each new tile
+  std::unordered_map<GraphId, uint32_t> new_nodes;
+  auto shift = [&new_nodes](const GraphId& node) {
+    auto count = node.Is_Valid() ? new_nodes.find(node.Tile_Base()) : new_nodes.end();
+    return count == new_nodes.end() ? node
+                                    : GraphId(node.tileid(), node.level(), node.id() + count->second);
+  };
 
-    // Check if we need to clear the tile cache
-    if (reader.OverCommitted()) {
-      reader.Trim();
+  // Append the ranges in order
+  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, true);
+  sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    // If something bad went down this will rethrow it
+    auto range_nodes = results[i].get_future().get();
+    {
+      sequence<std::pair<GraphId, GraphId>> range_new_to_old(new_to_old_file + "." +
+                                                                 std::to_string(i),
+                                                             false);
+      range_new_to_old.enumerate([&](const std::pair<GraphId, GraphId>& assoc) {
+        new_to_old.push_back(std::make_pair(shift(assoc.first), assoc.second));
+      });
+      sequence<OldToNewNodes> range_old_to_new(old_to_new_file + "." + std::to_string(i), false);
+      range_old_to_new.enumerate([&](const OldToNewNodes& assoc) {
+        old_to_new.push_back(OldToNewNodes(assoc.node_id, shift(assoc.highway_node),
+                                           shift(assoc.arterial_node), shift(assoc.local_node),
+                                           assoc.density));
+      });
+    }
+    filesystem::remove(new_to_old_file + "." + std::to_string(i));
+    filesystem::remove(old_to_new_file + "." + std::to_string(i));
+    for (const auto& count : range_nodes) {
+      new_nodes[count.first] += count.second;
     }
   }
 }
@@ -585,30 +731,30 @@ namespace mjolnir {
 void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
                              const std::string& new_to_old_file,
                              const std::string& old_to_new_file) {
-
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
-
   // Construct GraphReader
   LOG_INFO("HierarchyBuilder");
-  GraphReader reader(pt.get_child("mjolnir"));
+  auto hierarchy_properties = pt.get_child("mjolnir");
+  GraphReader reader(hierarchy_properties);
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
 
   // Association of old nodes to new nodes
-  CreateNodeAssociations(reader, new_to_old_file, old_to_new_file);
+  CreateNodeAssociations(reader, hierarchy_properties, new_to_old_file, old_to_new_file, threads);
 
   // Sort the sequences
-  SortSequences(new_to_old_file, old_to_new_file);
+  SortSequences(new_to_old_file, old_to_new_file,
+                pt.get<size_t>("mjolnir.sort_memory", 1024 * 1024 * 512), threads);
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, new_to_old_file, old_to_new_file);
+  FormTilesInNewLevel(hierarchy_properties, new_to_old_file, old_to_new_file, threads);
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
   RemoveUnusedLocalTiles(reader.tile_dir(), old_to_new_file);
 
   // Update the end nodes to all transit connections in the transit hierarchy
-  auto hierarchy_properties = pt.get_child("mjolnir");
   auto transit_dir = hierarchy_properties.get_optional<std::string>("transit_dir");
   if (transit_dir && filesystem::exists(*transit_dir) && filesystem::is_directory(*transit_dir)) {
     UpdateTransitConnections(reader, old_to_new_file);
@@ -2,9 +2,11 @@
 #define VALHALLA_MJOLNIR_IDTABLE_H
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <mutex>
 #include <vector>
 
 #include <robin_hood.h>
@@ -14,23 +16,39 @@
 namespace valhalla {
 namespace mjolnir {
 
+/**
+ * A sparse bitset over OSM ids. The ids are split into pages of 512 and only the pages which have
+ * an id set are allocated, so the memory follows the number of ids marked rather than how large
+ * the ids are. The pages are spread over shards with their own lock so that several threads can
+ * set and get ids at the same time.
+ */
 class UnorderedIdTable final {
 public:
   /**
    * Constructor
-   * @param   size_hint   Hint about the total number of ids.
+   * @param   size_hint   Hint about the number of ids which will be set, nothing is reserved
+   *                      up front when it is 0.
    */
-  UnorderedIdTable(const uint64_t size_hint) {
-    bitmarkers_.reserve((size_hint / 64) + 1);
+  explicit UnorderedIdTable(const uint64_t size_hint = 0) {
+    if (size_hint > 0) {
+      for (auto& shard : shards_) {
+        shard.pages.reserve(size_hint / kPageIds / kShards + 1);
+      }
+    }
   }
 
+  UnorderedIdTable(const UnorderedIdTable&) = delete;
+  UnorderedIdTable& operator=(const UnorderedIdTable&) = delete;
+
   /**
    * Sets the OSM Id as used.
    * @param   osmid   OSM Id of the way/node/relation.
    */
   inline void set(const uint64_t id) {
-    uint64_t idx = id / 64;
-    bitmarkers_[idx] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    const uint64_t page = id / kPageIds;
+    auto& shard = shards_[page % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.pages[page][(id % kPageIds) / 64] |= static_cast<uint64_t>(1) << (id % 64);
   }
 
   /**
@@ -40,14 +58,29 @@ public:
    */
 
   inline bool get(const uint64_t id) const {
-    uint64_t idx = id / 64;
-    auto found = bitmarkers_.find(idx);
-    return found != bitmarkers_.cend() &&
-           found->second & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
+    const uint64_t page = id / kPageIds;
+    const auto& shard = shards_[page % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.pages.find(page);
+    return found != shard.pages.cend() &&
+           (found->second[(id % kPageIds) / 64] & (static_cast<uint64_t>(1) << (id % 64)));
   }
 
   /**
-   * Serializes the table to file
+   * @return the number of pages allocated
+   */
+  size_t page_count() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      count += shard.pages.size();
+    }
+    return count;
+  }
+
+  /**
+   * Serializes the table to file. Each 64 ids with one of them set are written as the index of
+   * the 64 followed by their bits.
    * @param file_name  the file to which we should serialize the table
    * @return true if the table could be serialized
    */
@@ -56,14 +89,27 @@ public:
     if (!file.is_open()) {
       return false;
     }
-    // TODO: do more than one entry at a time, buffer 10k of them into a vector and write that
-    // Write key/value pairs
-    for (const auto& i : bitmarkers_) {
-      // key
-      file.write(reinterpret_cast<const char*>(&i.first), sizeof(uint64_t));
-      // value
-      file.write(reinterpret_cast<const char*>(&i.second), sizeof(uint64_t));
+    // Write key/value pairs a buffer at a time
+    std::vector<uint64_t> buffer;
+    buffer.reserve(kBufferWords);
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const auto& page : shard.pages) {
+        for (uint64_t i = 0; i < kPageWords; ++i) {
+          if (page.second[i] == 0) {
+            continue;
+          }
+          buffer.push_back(page.first * kPageWords + i);
+          buffer.push_back(page.second[i]);
+          if (buffer.size() == kBufferWords) {
+            file.write(reinterpret_cast<const char*>(buffer.data()),
+                       buffer.size() * sizeof(uint64_t));
+            buffer.clear();
+          }
+        }
+      }
     }
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(uint64_t));
     file.close();
     return true;
   }
@@ -78,17 +124,22 @@ public:
     if (!file.is_open()) {
       return false;
     }
-    uint64_t entries = static_cast<uint64_t>(file.tellg()) / 2;
+    uint64_t words = static_cast<uint64_t>(file.tellg()) / sizeof(uint64_t);
     file.seekg(0, std::ios::beg);
 
-    // TODO: do more than one entry at a time, buffer 10k of them into a vector and read that
-    // Read the count and then the via ids
-    bitmarkers_.reserve(entries);
-    uint64_t key, value;
-    while (file && entries--) {
-      file.read(reinterpret_cast<char*>(&key), sizeof(key));
-      file.read(reinterpret_cast<char*>(&value), sizeof(value));
-      bitmarkers_[key] = value;
+    // Read the key/value pairs a buffer at a time
+    std::vector<uint64_t> buffer(kBufferWords);
+    words -= words % 2;
+    while (file && words > 0) {
+      auto count = std::min<uint64_t>(words, buffer.size());
+      file.read(reinterpret_cast<char*>(buffer.data()), count * sizeof(uint64_t));
+      for (uint64_t i = 0; i < count; i += 2) {
+        const uint64_t page = buffer[i] / kPageWords;
+        auto& shard = shards_[page % kShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.pages[page][buffer[i] % kPageWords] |= buffer[i + 1];
+      }
+      words -= count;
     }
     file.close();
     return true;
@@ -100,11 +151,28 @@ public:
    * @return
    */
   bool operator==(const UnorderedIdTable& other) const {
-    return bitmarkers_ == other.bitmarkers_;
+    for (size_t i = 0; i < kShards; ++i) {
+      if (shards_[i].pages != other.shards_[i].pages) {
+        return false;
+      }
+    }
+    return true;
   }
 
 private:
-  robin_hood::unordered_map<uint64_t, uint64_t> bitmarkers_;
+  static constexpr uint64_t kPageWords = 8;
+  static constexpr uint64_t kPageIds = kPageWords * 64;
+  static constexpr size_t kShards = 64;
+  static constexpr size_t kBufferWords = 2 * 10000;
+
+  using page_t = std::array<uint64_t, kPageWords>;
+
+  // on their own cache lines so threads setting ids in different shards don't slow each other
+  struct alignas(64) shard_t {
+    mutable std::mutex mutex;
+    robin_hood::unordered_map<uint64_t, page_t> pages;
+  };
+  std::array<shard_t, kShards> shards_;
 };
 
 } // namespace mjolnir
@@ -0,0 +1,300 @@
+#include "mjolnir/incrementalbuilder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include "baldr/graphreader.h"
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/aabb2.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+#include "mjolnir/node_expander.h"
+#include "mjolnir/osmdata.h"
+#include "mjolnir/osmway.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// the osm elements an osc file of changes mentions
+struct osc_changes_t {
+  std::unordered_set<uint64_t> node_ids;
+  std::unordered_set<uint64_t> way_ids;
+  std::vector<PointLL> points;
+};
+
+// pulls an attribute out of the text of a tag, the tags of an osc file are simple enough that we
+// get away without an xml parser
+bool attribute(const std::string& tag, const char* name, std::string& value) {
+  const std::string key = std::string(" ") + name + "=";
+  auto pos = tag.find(key);
+  if (pos == std::string::npos || pos + key.size() >= tag.size()) {
+    return false;
+  }
+  pos += key.size();
+  auto end = tag.find(tag[pos], pos + 1);
+  if (end == std::string::npos) {
+    return false;
+  }
+  value = tag.substr(pos + 1, end - pos - 1);
+  return true;
+}
+
+// collects the nodes and ways which were created, modified or deleted and the members of changed
+// relations, their old and new locations are what we need to rebuild
+osc_changes_t read_osc(const std::string& osc_file) {
+  std::ifstream osc(osc_file);
+  if (!osc) {
+    throw std::runtime_error("Could not open osc file " + osc_file);
+  }
+
+  osc_changes_t changes;
+  std::string text, tag, id, lat, lon, type;
+  while (std::getline(osc, text, '>')) {
+    auto open = text.rfind('<');
+    if (open == std::string::npos) {
+      continue;
+    }
+    tag = text.substr(open + 1);
+    tag.push_back(' ');
+    if (tag.compare(0, 5, "node ") == 0 && attribute(tag, "id", id)) {
+      changes.node_ids.insert(std::stoull(id));
+      // deleted nodes are gone from the new data so only the osc tells us where they were
+      if (attribute(tag, "lat", lat) && attribute(tag, "lon", lon)) {
+        changes.points.emplace_back(std::stod(lon), std::stod(lat));
+      }
+    } else if (tag.compare(0, 3, "nd ") == 0 && attribute(tag, "ref", id)) {
+      changes.node_ids.insert(std::stoull(id));
+    } else if (tag.compare(0, 4, "way ") == 0 && attribute(tag, "id", id)) {
+      changes.way_ids.insert(std::stoull(id));
+    } else if (tag.compare(0, 7, "member ") == 0 && attribute(tag, "type", type) &&
+               attribute(tag, "ref", id)) {
+      if (type == "node") {
+        changes.node_ids.insert(std::stoull(id));
+      } else if (type == "way") {
+        changes.way_ids.insert(std::stoull(id));
+      }
+    }
+  }
+  return changes;
+}
+
+// the tiles in which the changes are in the new data, and in the old data of the snapshot
+void add_changed_tiles(const boost::property_tree::ptree& pt,
+                       const std::string& ways_file,
+                       const std::string& way_nodes_file,
+                       std::unordered_set<GraphId>& affected) {
+  const auto& local = TileHierarchy::levels().back();
+  auto changes = read_osc(pt.get<std::string>("mjolnir.update.osc"));
+  LOG_INFO("Found " + std::to_string(changes.node_ids.size()) + " nodes and " +
+           std::to_string(changes.way_ids.size()) + " ways in the osc file");
+  for (const auto& point : changes.points) {
+    if (local.tiles.TileBounds().Contains(point)) {
+      affected.emplace(local.tiles.TileId(point), local.level, 0);
+    }
+  }
+
+  // where the changed ways are now
+  std::unordered_set<uint32_t> way_indices;
+  {
+    sequence<OSMWay> ways(ways_file, false);
+    uint32_t way_index = 0;
+    ways.enumerate([&changes, &way_indices, &way_index](const OSMWay& way) {
+      if (changes.way_ids.count(way.way_id())) {
+        way_indices.insert(way_index);
+      }
+      ++way_index;
+    });
+  }
+  sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+  way_nodes.enumerate([&](const OSMWayNode& way_node) {
+    if (way_indices.count(way_node.way_index) || changes.node_ids.count(way_node.node.osmid_)) {
+      auto point = way_node.node.latlng();
+      if (point.IsValid()) {
+        affected.emplace(local.tiles.TileId(point), local.level, 0);
+      }
+    }
+  });
+
+  // and where they were
+  auto snapshot = pt.get_child("mjolnir");
+  snapshot.put("tile_dir", pt.get<std::string>("mjolnir.snapshot_dir"));
+  GraphReader reader(snapshot);
+  for (const auto& tile_id : reader.GetTileSet(local.level)) {
+    if (affected.count(tile_id)) {
+      continue;
+    }
+    auto tile = reader.GetGraphTile(tile_id);
+    for (uint32_t i = 0; tile && i < tile->header()->directededgecount(); ++i) {
+      if (changes.way_ids.count(tile->edgeinfo(tile->directededge(i)).wayid())) {
+        affected.insert(tile_id);
+        break;
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+}
+
+// copies a tile from one tile directory to another
+void copy_tile(const std::string& from_dir, const std::string& to_dir, const GraphId& tile_id) {
+  const auto suffix = GraphTile::FileSuffix(tile_id);
+  const std::string destination_path = to_dir + filesystem::path::preferred_separator + suffix;
+  filesystem::path root = destination_path;
+  root.replace_filename("");
+  filesystem::create_directories(root);
+  std::ifstream in(from_dir + filesystem::path::preferred_separator + suffix,
+                   std::ios_base::in | std::ios_base::binary);
+  std::ofstream out(destination_path,
+                    std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+  out << in.rdbuf();
+  if (!out) {
+    throw std::runtime_error("Could not copy tile " + suffix + " to " + to_dir);
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+bool IncrementalBuilder::Updating(const boost::property_tree::ptree& pt) {
+  auto update = pt.get_child_optional("mjolnir.update");
+  return update && !update->empty();
+}
+
+std::unordered_set<GraphId>
+IncrementalBuilder::AffectedTiles(const boost::property_tree::ptree& pt,
+                                  const std::map<GraphId, size_t>& tiles,
+                                  const std::string& ways_file,
+                                  const std::string& way_nodes_file,
+                                  const std::string& edges_file) {
+  auto snapshot_dir = pt.get_optional<std::string>("mjolnir.snapshot_dir");
+  if (!snapshot_dir || filesystem::path(*snapshot_dir).string() ==
+                           filesystem::path(pt.get<std::string>("mjolnir.tile_dir")).string()) {
+    throw std::runtime_error("Updating tiles requires a mjolnir.snapshot_dir of an earlier build "
+                             "other than the mjolnir.tile_dir");
+  }
+
+  // the tiles of the update
+  const auto& local = TileHierarchy::levels().back();
+  std::unordered_set<GraphId> affected;
+  if (auto bbox = pt.get_optional<std::string>("mjolnir.update.bbox")) {
+    std::vector<std::string> coords;
+    boost::algorithm::split(coords, *bbox, boost::algorithm::is_any_of(","));
+    if (coords.size() != 4) {
+      throw std::runtime_error("mjolnir.update.bbox must be min_lon,min_lat,max_lon,max_lat");
+    }
+    AABB2<PointLL> box{std::stod(coords[0]), std::stod(coords[1]), std::stod(coords[2]),
+                       std::stod(coords[3])};
+    for (auto tile_id : local.tiles.TileList(box)) {
+      affected.emplace(tile_id, local.level, 0);
+    }
+  }
+  if (auto ids = pt.get_optional<std::string>("mjolnir.update.tiles")) {
+    std::vector<std::string> tile_ids;
+    boost::algorithm::split(tile_ids, *ids, boost::algorithm::is_any_of(","));
+    for (const auto& tile_id : tile_ids) {
+      affected.emplace(std::stoul(tile_id), local.level, 0);
+    }
+  }
+  if (pt.get_optional<std::string>("mjolnir.update.osc")) {
+    add_changed_tiles(pt, ways_file, way_nodes_file, affected);
+  }
+
+  // edges of the tiles next to the update point at nodes in it, their ids may have moved
+  std::vector<std::pair<size_t, GraphId>> starts;
+  for (const auto& tile : tiles) {
+    starts.emplace_back(tile.second, tile.first.Tile_Base());
+  }
+  auto tile_of = [&starts](uint32_t node_index) {
+    auto start = std::upper_bound(starts.begin(), starts.end(), node_index,
+                                  [](size_t index, const std::pair<size_t, GraphId>& start) {
+                                    return index < start.first;
+                                  });
+    return std::prev(start)->second;
+  };
+  std::unordered_set<GraphId> neighbors;
+  sequence<Edge> edges(edges_file, false);
+  edges.enumerate([&](const Edge& edge) {
+    auto source = tile_of(edge.sourcenode_);
+    auto target = tile_of(edge.targetnode_);
+    if (source != target && affected.count(source) != affected.count(target)) {
+      neighbors.insert(affected.count(source) ? target : source);
+    }
+  });
+  affected.insert(neighbors.begin(), neighbors.end());
+
+  LOG_INFO("Rebuilding " + std::to_string(affected.size()) + " local tiles of which " +
+           std::to_string(neighbors.size()) + " neighbor the update");
+  return affected;
+}
+
+void IncrementalBuilder::RestoreSnapshot(const boost::property_tree::ptree& pt,
+                                         const std::unordered_set<GraphId>& affected) {
+  auto snapshot = pt.get_child("mjolnir");
+  snapshot.put("tile_dir", pt.get<std::string>("mjolnir.snapshot_dir"));
+  GraphReader reader(snapshot);
+  auto tile_ids = reader.GetTileSet(TileHierarchy::levels().back().level);
+  if (tile_ids.empty()) {
+    throw std::runtime_error("No local tiles in the mjolnir.snapshot_dir, run a full build first");
+  }
+
+  size_t restored = 0;
+  for (const auto& tile_id : tile_ids) {
+    if (!affected.count(tile_id)) {
+      copy_tile(snapshot.get<std::string>("tile_dir"), pt.get<std::string>("mjolnir.tile_dir"),
+                tile_id);
+      ++restored;
+    }
+  }
+  LOG_INFO("Restored " + std::to_string(restored) + " local tiles from the snapshot");
+}
+
+void IncrementalBuilder::StoreSnapshot(const boost::property_tree::ptree& pt,
+                                       const std::unordered_set<GraphId>* affected) {
+  auto snapshot_dir = pt.get_optional<std::string>("mjolnir.snapshot_dir");
+  if (!snapshot_dir) {
+    return;
+  }
+  const auto& tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  const auto local_level = TileHierarchy::levels().back().level;
+
+  // a full build replaces all of it
+  if (!affected) {
+    filesystem::remove_all(*snapshot_dir + filesystem::path::preferred_separator +
+                           std::to_string(local_level));
+    GraphReader reader(pt.get_child("mjolnir"));
+    for (const auto& tile_id : reader.GetTileSet(local_level)) {
+      copy_tile(tile_dir, *snapshot_dir, tile_id);
+    }
+    LOG_INFO("Stored the local tiles in the snapshot");
+    return;
+  }
+
+  // an update only the tiles it rebuilt, some of which may be gone now
+  for (const auto& tile_id : *affected) {
+    const auto suffix = GraphTile::FileSuffix(tile_id);
+    if (filesystem::exists(tile_dir + filesystem::path::preferred_separator + suffix)) {
+      copy_tile(tile_dir, *snapshot_dir, tile_id);
+    } else if (filesystem::exists(*snapshot_dir + filesystem::path::preferred_separator + suffix)) {
+      filesystem::remove(*snapshot_dir + filesystem::path::preferred_separator + suffix);
+    }
+  }
+  LOG_INFO("Stored the " + std::to_string(affected->size()) + " rebuilt local tiles in the snapshot");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -4,6 +4,7 @@
 #include <functional>
 #include <future>
 #include <iostream>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -88,22 +89,69 @@ struct tile_transit_info_t {
   }
 };
 
-struct feed_cache_t {
-  std::unordered_map<std::string, gtfs::Feed> cache;
+// the parsed feeds shared by all the threads writing tiles. parsing a feed is by far the most
+// expensive part of ingesting it, so each is parsed once and kept for the next tiles needing it.
+// at most max_feeds stay cached, the least recently used one is dropped first but stays alive for
+// the threads still writing a tile with it
+struct shared_feeds_t {
+  using feed_ptr_t = std::shared_ptr<const gtfs::Feed>;
+
   std::string gtfs_dir;
+  size_t max_feeds;
+  std::mutex lock;
+  // most recently used first
+  std::list<std::string> recent;
+  std::unordered_map<std::string,
+                     std::pair<std::shared_future<feed_ptr_t>, std::list<std::string>::iterator>>
+      cache;
+
+  shared_feeds_t(const std::string& gtfs_dir, size_t max_feeds)
+      : gtfs_dir(gtfs_dir), max_feeds(std::max(max_feeds, static_cast<size_t>(1))) {
+  }
 
-  feed_cache_t(const std::string& gtfs_dir) : gtfs_dir(gtfs_dir) {
+  feed_ptr_t operator()(const std::string& feed_name) {
+    std::unique_lock<std::mutex> guard(lock);
+    auto found = cache.find(feed_name);
+    if (found != cache.end()) {
+      recent.splice(recent.begin(), recent, found->second.second);
+      // another thread may still be parsing it
+      auto feed = found->second.first;
+      guard.unlock();
+      return feed.get();
+    }
+
+    std::promise<feed_ptr_t> promise;
+    recent.push_front(feed_name);
+    cache.emplace(feed_name, std::make_pair(promise.get_future().share(), recent.begin()));
+    while (cache.size() > max_feeds) {
+      cache.erase(recent.back());
+      recent.pop_back();
+    }
+    guard.unlock();
+
+    // parse it without holding up the others
+    auto feed = std::make_shared<gtfs::Feed>(gtfs_dir + feed_name);
+    feed->read_feed();
+    promise.set_value(feed);
+    return feed;
+  }
+};
+
+// the feeds of the tile being written, they can't be dropped from the shared ones in the meantime
+struct feed_cache_t {
+  std::unordered_map<std::string, shared_feeds_t::feed_ptr_t> cache;
+  shared_feeds_t& shared;
+
+  feed_cache_t(shared_feeds_t& shared) : shared(shared) {
   }
 
   const gtfs::Feed& operator()(const feed_object_t& feed_object) {
     auto found = cache.find(feed_object.feed);
     if (found != cache.end()) {
-      return found->second;
+      return *found->second;
     }
 
-    auto inserted = cache.insert({feed_object.feed, gtfs::Feed(gtfs_dir + feed_object.feed)});
-    inserted.first->second.read_feed();
-    return inserted.first->second;
+    return *cache.emplace(feed_object.feed, shared(feed_object.feed)).first->second;
   }
 };
 
@@ -150,10 +198,9 @@ std::string get_onestop_id_base(const std::string& stop_id, const std::string& f
   return feed_name + "_" + stop_id;
 }
 
-// Read from GTFS feed, sort data into the unique tiles they belong to
-std::priority_queue<tile_transit_info_t> select_transit_tiles(const std::string& gtfs_path) {
-
-  std::set<GraphId> tiles;
+// Sort the data of one GTFS feed into the unique tiles they belong to
+std::unordered_map<GraphId, tile_transit_info_t> select_feed_tiles(const std::string& feed_path,
+                                                                    const std::string& feed_name) {
   const auto& local_tiles = TileHierarchy::levels().back().tiles;
   std::unordered_map<GraphId, tile_transit_info_t> tile_map;
 
@@ -166,83 +213,132 @@ std::priority_queue<tile_transit_info_t> select_transit_tiles(const std::string&
     return tile_map.insert({graphid, tile_transit_info_t{graphid}}).first->second;
   };
 
-  filesystem::recursive_directory_iterator gtfs_feed_itr(gtfs_path);
-  filesystem::recursive_directory_iterator end_file_itr;
-  for (; gtfs_feed_itr != end_file_itr; ++gtfs_feed_itr) {
-    const auto& feed_path = gtfs_feed_itr->path();
-    if (filesystem::is_directory(feed_path)) {
-      // feed_path has a trailing separator
-      const auto feed_name = feed_path.filename().string();
-
-      LOG_INFO("Loading " + feed_name);
-      gtfs::Feed feed(feed_path.string());
-      feed.read_feed();
-      LOG_INFO("Done loading, now parsing " + feed_name);
-
-      const auto& stops = feed.get_stops();
-      // 1st pass to add all the stations, so we can add stops to its children in a 2nd pass
-      for (const auto& stop : stops) {
-        if (stop.location_type == gtfs::StopLocationType::Station) {
-          auto& tile_info = get_tile_info(stop);
-          tile_info.stations.insert({stop.stop_id, feed_name});
-        }
+  LOG_INFO("Loading " + feed_name);
+  gtfs::Feed feed(feed_path);
+  feed.read_feed();
+  LOG_INFO("Done loading, now parsing " + feed_name);
+
+  const auto& stops = feed.get_stops();
+  // 1st pass to add all the stations, so we can add stops to its children in a 2nd pass
+  for (const auto& stop : stops) {
+    if (stop.location_type == gtfs::StopLocationType::Station) {
+      auto& tile_info = get_tile_info(stop);
+      tile_info.stations.insert({stop.stop_id, feed_name});
+    }
+  }
+
+  // 2nd pass to add the platforms/stops
+  for (const auto& stop : stops) {
+    // TODO: GenericNode & BoardingArea could be useful at some point
+    if (!(stop.location_type == gtfs::StopLocationType::StopOrPlatform) &&
+        !(stop.location_type == gtfs::StopLocationType::EntranceExit)) {
+      continue;
+    }
+
+    auto& tile_info = get_tile_info(stop);
+
+    // if this station doesn't exist, we need to create it: we use the fact that this entry is
+    // not a station type to fake a station object in write_stops()
+    auto station_in_tile = tile_info.stations.find({stop.parent_station, feed_name});
+    if (station_in_tile != tile_info.stations.end()) {
+      tile_info.station_children.insert({{stop.parent_station, feed_name}, stop.stop_id});
+    } else {
+      // we don't have the parent station, if
+      // 1) this stop has none or 2) its parent station is in another tile
+      // TODO: need to handle the 2nd case somehow! Fow now, log it as ERROR
+      auto parent_station = feed.get_stop(stop.parent_station);
+      if (parent_station &&
+          tile_info.graphid !=
+              GraphId(local_tiles.TileId(parent_station->stop_lat, parent_station->stop_lon),
+                      TileHierarchy::GetTransitLevel().level, 0)) {
+        LOG_WARN("Station ID " + stop.parent_station + " is not in stop's " + stop.stop_id +
+                 " tile: " + std::to_string(tile_info.graphid));
       }
+      tile_info.stations.insert({stop.stop_id, feed_name});
+      tile_info.station_children.insert({{stop.stop_id, feed_name}, stop.stop_id});
+    }
 
-      // 2nd pass to add the platforms/stops
-      for (const auto& stop : stops) {
-        // TODO: GenericNode & BoardingArea could be useful at some point
-        if (!(stop.location_type == gtfs::StopLocationType::StopOrPlatform) &&
-            !(stop.location_type == gtfs::StopLocationType::EntranceExit)) {
-          continue;
-        }
+    for (const auto& stopTime : feed.get_stop_times_for_stop(stop.stop_id)) {
+      // add trip, route, agency and service_id from stop_time, it's the only place with that info
+      // TODO: should we throw here?
+      auto trip = feed.get_trip(stopTime.trip_id);
+      auto route = feed.get_route(trip->route_id);
+      if (!trip || !route || trip->service_id.empty()) {
+        LOG_ERROR("Missing trip or route or service_id for trip");
+        continue;
+      }
 
-        auto& tile_info = get_tile_info(stop);
-
-        // if this station doesn't exist, we need to create it: we use the fact that this entry is
-        // not a station type to fake a station object in write_stops()
-        auto station_in_tile = tile_info.stations.find({stop.parent_station, feed_name});
-        if (station_in_tile != tile_info.stations.end()) {
-          tile_info.station_children.insert({{stop.parent_station, feed_name}, stop.stop_id});
-        } else {
-          // we don't have the parent station, if
-          // 1) this stop has none or 2) its parent station is in another tile
-          // TODO: need to handle the 2nd case somehow! Fow now, log it as ERROR
-          auto parent_station = feed.get_stop(stop.parent_station);
-          if (parent_station &&
-              tile_info.graphid !=
-                  GraphId(local_tiles.TileId(parent_station->stop_lat, parent_station->stop_lon),
-                          TileHierarchy::GetTransitLevel().level, 0)) {
-            LOG_WARN("Station ID " + stop.parent_station + " is not in stop's " + stop.stop_id +
-                     " tile: " + std::to_string(tile_info.graphid));
-          }
-          tile_info.stations.insert({stop.stop_id, feed_name});
-          tile_info.station_children.insert({{stop.stop_id, feed_name}, stop.stop_id});
-        }
+      tile_info.trips.insert({trip->trip_id, feed_name});
+      tile_info.routes.insert({{route->route_id, feed_name}, tile_info.routes.size()});
 
-        for (const auto& stopTime : feed.get_stop_times_for_stop(stop.stop_id)) {
-          // add trip, route, agency and service_id from stop_time, it's the only place with that info
-          // TODO: should we throw here?
-          auto trip = feed.get_trip(stopTime.trip_id);
-          auto route = feed.get_route(trip->route_id);
-          if (!trip || !route || trip->service_id.empty()) {
-            LOG_ERROR("Missing trip or route or service_id for trip");
-            continue;
-          }
+      // shapes are optional, don't keep non-existing shapes around
+      if (!trip->shape_id.empty()) {
+        tile_info.shapes.insert({{trip->shape_id, feed_name}, tile_info.shapes.size()});
+      }
+    }
+  }
 
-          tile_info.trips.insert({trip->trip_id, feed_name});
-          tile_info.routes.insert({{route->route_id, feed_name}, tile_info.routes.size()});
+  LOG_INFO("Done parsing " + std::to_string(tile_map.size()) + " transit tiles for GTFS feed " +
+           feed_name);
+  return tile_map;
+}
 
-          // shapes are optional, don't keep non-existing shapes around
-          if (!trip->shape_id.empty()) {
-            tile_info.shapes.insert({{trip->shape_id, feed_name}, tile_info.shapes.size()});
-          }
-        }
+// Read from GTFS feeds, sort data into the unique tiles they belong to. The feeds are parsed in
+// parallel, each by one thread, and their tiles merged as they finish
+std::priority_queue<tile_transit_info_t> select_transit_tiles(const std::string& gtfs_path,
+                                                              const unsigned int thread_count) {
+  std::vector<filesystem::path> feed_paths;
+  filesystem::recursive_directory_iterator gtfs_feed_itr(gtfs_path);
+  filesystem::recursive_directory_iterator end_file_itr;
+  for (; gtfs_feed_itr != end_file_itr; ++gtfs_feed_itr) {
+    if (filesystem::is_directory(gtfs_feed_itr->path())) {
+      feed_paths.push_back(gtfs_feed_itr->path());
+    }
+  }
+
+  std::mutex lock;
+  size_t next_feed = 0;
+  std::unordered_map<GraphId, tile_transit_info_t> tile_map;
+  auto select = [&]() {
+    while (true) {
+      std::unique_lock<std::mutex> guard(lock);
+      if (next_feed == feed_paths.size()) {
+        return;
       }
+      const auto& feed_path = feed_paths[next_feed++];
+      guard.unlock();
 
-      LOG_INFO("Done parsing " + std::to_string(tile_map.size()) + " transit tiles for GTFS feed " +
-               feed_name);
+      // feed_path has a trailing separator
+      auto feed_tiles = select_feed_tiles(feed_path.string(), feed_path.filename().string());
+
+      // the ids are unique per feed, so only the indices of routes and shapes need renumbering
+      guard.lock();
+      for (auto& feed_tile : feed_tiles) {
+        auto inserted = tile_map.emplace(feed_tile.first, tile_transit_info_t{feed_tile.first});
+        auto& tile_info = inserted.first->second;
+        auto& feed_info = feed_tile.second;
+        tile_info.station_children.insert(feed_info.station_children.begin(),
+                                          feed_info.station_children.end());
+        tile_info.stations.insert(feed_info.stations.begin(), feed_info.stations.end());
+        tile_info.trips.insert(feed_info.trips.begin(), feed_info.trips.end());
+        for (const auto& route : feed_info.routes) {
+          tile_info.routes.insert({route.first, tile_info.routes.size()});
+        }
+        for (const auto& shape : feed_info.shapes) {
+          tile_info.shapes.insert({shape.first, tile_info.shapes.size()});
+        }
+      }
     }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < std::min(static_cast<size_t>(thread_count), feed_paths.size()); ++i) {
+    threads.emplace_back(select);
   }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
   std::priority_queue<tile_transit_info_t> queue;
   for (auto it = tile_map.begin(); it != tile_map.end(); it++) {
     queue.push(it->second);
@@ -666,7 +762,7 @@ void write_shapes(Transit& tile, const tile_transit_info_t& tile_info, feed_cach
 }
 
 // pre-processes feed data and writes to the pbfs (calls the 'write' functions)
-void ingest_tiles(const std::string& gtfs_dir,
+void ingest_tiles(shared_feeds_t& shared_feeds,
                   const std::string& transit_dir,
                   const uint32_t pbf_trip_limit,
                   std::priority_queue<tile_transit_info_t>& queue,
@@ -694,7 +790,7 @@ void ingest_tiles(const std::string& gtfs_dir,
     auto current_path = tile_path;
 
     // collect all the feeds in this tile
-    feed_cache_t feeds(gtfs_dir);
+    feed_cache_t feeds(shared_feeds);
     for (const auto& route : current.routes) {
       feeds(route.first);
     }
@@ -873,7 +969,7 @@ std::list<GraphId> ingest_transit(const boost::property_tree::ptree& pt) {
                                                            std::thread::hardware_concurrency()));
   // go get information about what transit tiles we should be fetching
   LOG_INFO("Tiling GTFS Feeds");
-  auto tiles = select_transit_tiles(gtfs_dir);
+  auto tiles = select_transit_tiles(gtfs_dir, thread_count);
 
   LOG_INFO("Writing " + std::to_string(tiles.size()) + " transit pbf tiles with " +
            std::to_string(thread_count) + " threads...");
@@ -884,9 +980,10 @@ std::list<GraphId> ingest_transit(const boost::property_tree::ptree& pt) {
   std::vector<std::promise<std::list<GraphId>>> promises(threads.size());
 
   auto pbf_trip_limit = pt.get<uint32_t>("mjolnir.transit_pbf_limit");
+  shared_feeds_t shared_feeds(gtfs_dir, pt.get<size_t>("mjolnir.transit_feed_cache_size", 4));
 
   for (size_t i = 0; i < threads.size(); ++i) {
-    threads[i].reset(new std::thread(ingest_tiles, std::cref(gtfs_dir), std::cref(transit_dir),
+    threads[i].reset(new std::thread(ingest_tiles, std::ref(shared_feeds), std::cref(transit_dir),
                                      pbf_trip_limit, std::ref(tiles), std::ref(uniques),
                                      std::ref(promises[i])));
   }
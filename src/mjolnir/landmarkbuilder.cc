@@ -0,0 +1,261 @@
+#include "mjolnir/landmarkbuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <list>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/landmarkdistances.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/constants.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+constexpr uint32_t kDefaultLandmarkCount = 8;
+constexpr uint64_t kNotIndexed = std::numeric_limits<uint64_t>::max();
+
+/**
+ * Where the nodes of each tile of the road levels are in the distances, the tiles sorted by id.
+ */
+struct node_index_t {
+  std::vector<LandmarkDistances::tile_t> tiles;
+  uint64_t node_count = 0;
+
+  explicit node_index_t(GraphReader& reader) {
+    for (const auto& level : TileHierarchy::levels()) {
+      for (const auto& tile_id : reader.GetTileSet(level.level)) {
+        auto tile = reader.GetGraphTile(tile_id);
+        if (tile && tile->header()->nodecount() > 0) {
+          tiles.push_back({tile_id.value, 0, tile->header()->nodecount(), 0});
+        }
+        if (reader.OverCommitted()) {
+          reader.Trim();
+        }
+      }
+    }
+    std::sort(tiles.begin(), tiles.end(),
+              [](const auto& a, const auto& b) { return a.tile_id < b.tile_id; });
+    for (auto& tile : tiles) {
+      tile.offset = node_count;
+      node_count += tile.node_count;
+    }
+  }
+
+  // the index of the node in the distances, kNotIndexed for nodes of other levels
+  uint64_t index(const GraphId& node) const {
+    const uint64_t tile_id = node.Tile_Base().value;
+    auto tile = std::lower_bound(tiles.begin(), tiles.end(), tile_id,
+                                 [](const auto& t, uint64_t id) { return t.tile_id < id; });
+    if (tile == tiles.end() || tile->tile_id != tile_id || node.id() >= tile->node_count) {
+      return kNotIndexed;
+    }
+    return tile->offset + node.id();
+  }
+
+  GraphId node(uint64_t index) const {
+    auto tile = std::upper_bound(tiles.begin(), tiles.end(), index,
+                                 [](uint64_t i, const auto& t) { return i < t.offset; });
+    --tile;
+    return GraphId(tile->tile_id) + (index - tile->offset);
+  }
+};
+
+/**
+ * Picks the landmarks among the nodes of the highway level, or of the first level below it with
+ * nodes if it has none. The bounding box of those nodes is split into count sectors around its
+ * center and the node farthest from the center in each sector is its landmark, so that the
+ * landmarks are spread around the edge of the graph.
+ */
+std::vector<GraphId>
+pick_landmarks(GraphReader& reader, const node_index_t& index, const uint32_t count) {
+  std::vector<std::pair<GraphId, PointLL>> candidates;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (const auto& tile_id : reader.GetTileSet(level.level)) {
+      auto tile = reader.GetGraphTile(tile_id);
+      if (!tile) {
+        continue;
+      }
+      for (uint32_t i = 0; i < tile->header()->nodecount(); ++i) {
+        const GraphId node_id = tile_id + i;
+        candidates.emplace_back(node_id, tile->get_node_ll(node_id));
+      }
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+    if (!candidates.empty()) {
+      break;
+    }
+  }
+  if (candidates.empty()) {
+    return {};
+  }
+
+  double min_lat = 90, max_lat = -90, min_lng = 180, max_lng = -180;
+  for (const auto& candidate : candidates) {
+    min_lat = std::min<double>(min_lat, candidate.second.lat());
+    max_lat = std::max<double>(max_lat, candidate.second.lat());
+    min_lng = std::min<double>(min_lng, candidate.second.lng());
+    max_lng = std::max<double>(max_lng, candidate.second.lng());
+  }
+  const double center_lat = (min_lat + max_lat) / 2;
+  const double center_lng = (min_lng + max_lng) / 2;
+  const double lng_scale = std::cos(center_lat * kRadPerDegD);
+
+  std::vector<std::pair<GraphId, double>> farthest(count, {GraphId(), -1});
+  for (const auto& candidate : candidates) {
+    const double y = candidate.second.lat() - center_lat;
+    const double x = (candidate.second.lng() - center_lng) * lng_scale;
+    const double angle = std::atan2(y, x) + kPiDouble;
+    auto sector = std::min<uint32_t>(count - 1, angle / (2 * kPiDouble) * count);
+    const double distance = x * x + y * y;
+    if (distance > farthest[sector].second && index.index(candidate.first) != kNotIndexed) {
+      farthest[sector] = {candidate.first, distance};
+    }
+  }
+
+  std::vector<GraphId> landmarks;
+  for (const auto& landmark : farthest) {
+    if (landmark.first.Is_Valid()) {
+      landmarks.push_back(landmark.first);
+    }
+  }
+  return landmarks;
+}
+
+/**
+ * Finds the distances of all the nodes from the landmarks with a dijkstra over every edge but the
+ * shortcuts regardless of direction and access, crossing between levels through the transitions.
+ * Each thread takes the next landmark until there are none left and writes its distances into its
+ * column of the mapped distances.
+ */
+void find_distances(const boost::property_tree::ptree& pt,
+                    const node_index_t& index,
+                    const std::vector<GraphId>& landmarks,
+                    std::atomic<size_t>& next_landmark,
+                    uint32_t* distances) {
+  GraphReader reader(pt.get_child("mjolnir"));
+  std::vector<uint32_t> dist;
+  using entry_t = std::pair<uint32_t, uint64_t>;
+  for (size_t k = next_landmark++; k < landmarks.size(); k = next_landmark++) {
+    dist.assign(index.node_count, LandmarkDistances::kUnreachable);
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    const auto start = index.index(landmarks[k]);
+    dist[start] = 0;
+    queue.emplace(0, start);
+
+    while (!queue.empty()) {
+      const auto current = queue.top();
+      queue.pop();
+      if (current.first > dist[current.second]) {
+        continue;
+      }
+
+      const auto node_id = index.node(current.second);
+      auto tile = reader.GetGraphTile(node_id);
+      if (!tile) {
+        continue;
+      }
+      const auto relax = [&](const GraphId& end_node, uint32_t length) {
+        const auto end = index.index(end_node);
+        if (end != kNotIndexed && current.first + length < dist[end]) {
+          dist[end] = current.first + length;
+          queue.emplace(dist[end], end);
+        }
+      };
+      const auto* node = tile->node(node_id);
+      for (const auto& edge : tile->GetDirectedEdges(node)) {
+        if (!edge.is_shortcut()) {
+          relax(edge.endnode(), edge.length());
+        }
+      }
+      for (const auto& transition : tile->GetNodeTransitions(node)) {
+        relax(transition.endnode(), 0);
+      }
+
+      if (reader.OverCommitted()) {
+        reader.Trim();
+      }
+    }
+
+    const auto count = landmarks.size();
+    for (uint64_t i = 0; i < index.node_count; ++i) {
+      distances[i * count + k] = dist[i];
+    }
+    LOG_INFO("Found the distances from landmark " + std::to_string(k));
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void LandmarkBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file_name = pt.get<std::string>("mjolnir.landmarks", "");
+  if (file_name.empty()) {
+    return;
+  }
+
+  GraphReader reader(pt.get_child("mjolnir"));
+  const node_index_t index(reader);
+  const auto count = pt.get<uint32_t>("mjolnir.landmark_count", kDefaultLandmarkCount);
+  const auto landmarks = pick_landmarks(reader, index, std::max(1u, count));
+  if (landmarks.empty()) {
+    LOG_WARN("No nodes to pick landmarks from, not writing landmark distances");
+    return;
+  }
+  LOG_INFO("Finding the distances of " + std::to_string(index.node_count) + " nodes from " +
+           std::to_string(landmarks.size()) + " landmarks");
+
+  // the distances are written straight into the mapped file, next to it until they are complete
+  const auto partial = file_name + ".tmp";
+  filesystem::remove(partial);
+  const size_t tiles_size = index.tiles.size() * sizeof(LandmarkDistances::tile_t);
+  const size_t size = sizeof(LandmarkDistances::header_t) + tiles_size +
+                      index.node_count * landmarks.size() * sizeof(uint32_t);
+  {
+    mem_map<char> file;
+    file.create(partial, size);
+    LandmarkDistances::header_t header{LandmarkDistances::kVersion, landmarks.size(),
+                                       index.tiles.size(), index.node_count};
+    std::memcpy(file.get(), &header, sizeof(header));
+    std::memcpy(file.get() + sizeof(header), index.tiles.data(), tiles_size);
+    auto* distances = reinterpret_cast<uint32_t*>(file.get() + sizeof(header) + tiles_size);
+
+    const auto nthreads = std::min<size_t>(
+        landmarks.size(), std::max(1u, pt.get<uint32_t>("mjolnir.concurrency",
+                                                        std::thread::hardware_concurrency())));
+    std::atomic<size_t> next_landmark(0);
+    std::list<std::thread> threads;
+    for (size_t i = 0; i < nthreads; ++i) {
+      threads.emplace_back(find_distances, std::cref(pt), std::cref(index), std::cref(landmarks),
+                           std::ref(next_landmark), distances);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  if (!filesystem::rename(partial, file_name)) {
+    throw std::runtime_error("Could not move the landmark distances to " + file_name);
+  }
+  LOG_INFO("Wrote the landmark distances " + file_name);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
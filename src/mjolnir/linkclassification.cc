@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <list>
 #include <optional>
 #include <queue>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -19,6 +23,8 @@ namespace mjolnir {
 constexpr uint32_t kMaxClassification = 8;
 constexpr uint32_t kMaxLinkEdges = 32;
 constexpr uint32_t kServiceClass = static_cast<uint32_t>(RoadClass::kServiceOther);
+// Exits whose link graphs are built at once before they are reclassified
+constexpr size_t kExitBatchSize = 4096;
 using nodelist_t = std::vector<std::vector<sequence<Node>::iterator>>;
 
 // Structure that keeps information about link graph node (NOTE: assuming that
@@ -104,31 +110,56 @@ float CalcEdgesLength(Data& data, const std::vector<uint32_t>& edges) {
   return total_length;
 }
 
+// Run the work on the given number of threads, each is passed its index
+void RunThreads(size_t threads, const std::function<void(size_t)>& work) {
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i) {
+    pool.emplace_back(work, i);
+  }
+  work(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
 // Form a list of all nodes - sorted by highest classification of non-link
-// edges at the node.
-nodelist_t FormExitNodes(sequence<Node>& nodes, sequence<Edge>& edges) {
-  nodelist_t exit_nodes(kMaxClassification);
-  sequence<Node>::iterator node_itr = nodes.begin();
-  while (node_itr != nodes.end()) {
-    // If the node has a both links and non links at it
-    auto bundle = collect_node_edges(node_itr, nodes, edges);
-    if (bundle.node.link_edge_ && bundle.node.non_link_edge_) {
-      // Check if this node has a link edge that is driveable from the node
-      for (const auto& edge : bundle.node_edges) {
-        if (edge.first.attributes.link && (edge.first.attributes.driveforward)) {
-          // Get the highest classification of non-link edges at this node.
-          // Add to the exit node list if a valid classification...if no
-          // connecting edge is driveable the node will be skipped.
-          uint32_t rc = GetBestNonLinkClass(bundle.node_edges);
-          if (rc < kMaxClassification) {
-            exit_nodes[rc].push_back(node_itr);
+// edges at the node. Each thread scans a range of the nodes.
+nodelist_t FormExitNodes(sequence<Node>& nodes, sequence<Edge>& edges, size_t threads) {
+  auto ranges = split_node_bundles(nodes, threads);
+  std::vector<nodelist_t> thread_exit_nodes(threads, nodelist_t(kMaxClassification));
+  RunThreads(threads, [&](size_t i) {
+    auto& exit_nodes = thread_exit_nodes[i];
+    sequence<Node>::iterator node_itr = nodes[ranges[i]];
+    while (node_itr.position() < ranges[i + 1]) {
+      // If the node has a both links and non links at it
+      auto bundle = collect_node_edges(node_itr, nodes, edges);
+      if (bundle.node.link_edge_ && bundle.node.non_link_edge_) {
+        // Check if this node has a link edge that is driveable from the node
+        for (const auto& edge : bundle.node_edges) {
+          if (edge.first.attributes.link && (edge.first.attributes.driveforward)) {
+            // Get the highest classification of non-link edges at this node.
+            // Add to the exit node list if a valid classification...if no
+            // connecting edge is driveable the node will be skipped.
+            uint32_t rc = GetBestNonLinkClass(bundle.node_edges);
+            if (rc < kMaxClassification) {
+              exit_nodes[rc].push_back(node_itr);
+            }
           }
         }
       }
+
+      // Go to the next node
+      node_itr += bundle.node_count;
     }
+  });
 
-    // Go to the next node
-    node_itr += bundle.node_count;
+  // The ranges are in node order
+  nodelist_t exit_nodes(kMaxClassification);
+  for (auto& ranges_exit_nodes : thread_exit_nodes) {
+    for (uint32_t rc = 0; rc < kMaxClassification; rc++) {
+      exit_nodes[rc].insert(exit_nodes[rc].end(), ranges_exit_nodes[rc].begin(),
+                            ranges_exit_nodes[rc].end());
+    }
   }
 
   // Output exit counts for each class
@@ -747,7 +778,8 @@ bool IsTurnChannel(Data& data, const std::vector<uint32_t>& link_edges) {
 std::pair<uint32_t, uint32_t> ReclassifyLinkGraph(std::vector<LinkGraphNode>& link_graph,
                                                   uint32_t exit_classification,
                                                   Data& data,
-                                                  bool infer_turn_channels) {
+                                                  bool infer_turn_channels,
+                                                  std::unordered_set<size_t>& updated_edges) {
   // number of reclassified edges
   uint32_t reclass_count = 0;
   uint32_t tc_count = 0;
@@ -867,6 +899,7 @@ std::pair<uint32_t, uint32_t> ReclassifyLinkGraph(std::vector<LinkGraphNode>& li
         // the updated edge back to the sequence.
         edge.attributes.reclass_link = true;
         element = edge;
+        updated_edges.insert(edge_idx);
       }
     } // for each leaf parent
   }   // for each leaf
@@ -886,29 +919,67 @@ void ReclassifyLinks(const std::string& ways_file,
                      const std::string& edges_file,
                      const std::string& way_nodes_file,
                      const OSMData& osmdata,
-                     bool infer_turn_channels) {
+                     bool infer_turn_channels,
+                     unsigned int concurrency) {
   LOG_INFO("Reclassifying_V2 link graph edges...");
 
+  const size_t threads = std::max(1u, concurrency);
   Data data(nodes_file, edges_file, ways_file, way_nodes_file, osmdata);
   // Find list of exit nodes - nodes where driveable outbound links connect to
   // non-link edges. Group by best road class of the non-link connecting edges.
-  nodelist_t exit_nodes = FormExitNodes(data.nodes, data.edges);
+  nodelist_t exit_nodes = FormExitNodes(data.nodes, data.edges, threads);
 
   // Iterate through the exit node list by classification so exits from major
   // roads are considered before exits from minor roads.
   uint32_t reclass_count = 0;
   uint32_t tc_count = 0;
 
+  // Link graphs only read the edges so a batch of them is built on all threads. They are then
+  // reclassified in order, a graph which has an edge at its nodes that was updated by one before it
+  // in the batch is built again so that it comes out as if they were done one after the other.
+  std::vector<std::optional<std::vector<LinkGraphNode>>> link_graphs;
+  std::unordered_set<size_t> updated_edges;
   for (uint32_t classification = 0; classification < kMaxClassification; classification++) {
-    for (auto& node : exit_nodes[classification]) {
-      LinkGraphBuilder build_graph(data);
-      // build link graph
-      auto link_graph = build_graph(node, classification);
-      // reclassify links and infer turn channels
-      auto counts = ReclassifyLinkGraph(link_graph, classification, data, infer_turn_channels);
-      // update counters
-      reclass_count += counts.first;
-      tc_count += counts.second;
+    auto& nodes = exit_nodes[classification];
+    for (size_t batch = 0; batch < nodes.size(); batch += kExitBatchSize) {
+      const size_t batch_size = std::min(kExitBatchSize, nodes.size() - batch);
+      link_graphs.assign(batch_size, std::nullopt);
+      std::atomic<size_t> next_exit(0);
+      RunThreads(threads, [&](size_t) {
+        for (size_t i = next_exit++; i < batch_size; i = next_exit++) {
+          auto node = nodes[batch + i];
+          try {
+            link_graphs[i] = LinkGraphBuilder(data)(node, classification);
+          } catch (const std::exception&) {
+            // built again below to throw in order
+          }
+        }
+      });
+
+      updated_edges.clear();
+      for (size_t i = 0; i < batch_size; ++i) {
+        auto& link_graph = link_graphs[i];
+        bool stale = !link_graph;
+        for (size_t j = 0; !stale && j < link_graph->size(); ++j) {
+          for (const auto& edge : (*link_graph)[j].bundle.node_edges) {
+            if (updated_edges.count(edge.second)) {
+              stale = true;
+              break;
+            }
+          }
+        }
+        // build link graph
+        if (stale) {
+          link_graph = LinkGraphBuilder(data)(nodes[batch + i], classification);
+        }
+        // reclassify links and infer turn channels
+        auto counts = ReclassifyLinkGraph(*link_graph, classification, data, infer_turn_channels,
+                                          updated_edges);
+        // update counters
+        reclass_count += counts.first;
+        tc_count += counts.second;
+        link_graph.reset();
+      }
     }
   }
 
@@ -0,0 +1,1854 @@
+#include "mjolnir/nativetagtransform.h"
+
+#include "midgard/logging.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// lua/graph.lua looks most of the tag values up in tables, a missing entry is nil there and a
+// nullptr (or an empty optional) here
+using StrTable = std::unordered_map<std::string, const char*>;
+using IntTable = std::unordered_map<std::string, int>;
+
+// one key or value per mode, in the order of kForward
+using Modes = std::array<const char*, 8>;
+
+const Modes kForward = {"auto_forward",       "truck_forward",      "bus_forward",
+                        "taxi_forward",       "moped_forward",      "motorcycle_forward",
+                        "pedestrian_forward", "bike_forward"};
+const Modes kBackward = {"auto_backward",       "truck_backward",      "bus_backward",
+                         "taxi_backward",       "moped_backward",      "motorcycle_backward",
+                         "pedestrian_backward", "bike_backward"};
+constexpr size_t kPedestrian = 6;
+
+const StrTable kAccess = {
+    {"yes", "true"}, {"private", "true"}, {"no", "false"}, {"permissive", "true"},
+    {"agricultural", "false"}, {"use_sidepath", "true"}, {"delivery", "true"}, {"designated", "true"},
+    {"dismount", "true"}, {"discouraged", "false"}, {"forestry", "false"}, {"destination", "true"},
+    {"customers", "true"}, {"official", "false"}, {"public", "true"}, {"restricted", "true"},
+    {"allowed", "true"}, {"emergency", "false"}, {"psv", "false"}, {"permit", "true"},
+    {"residents", "true"}
+};
+
+const StrTable kPrivate = {
+    {"private", "true"}, {"destination", "true"}, {"customers", "true"}, {"delivery", "true"},
+    {"permit", "true"}, {"residents", "true"}
+};
+
+const StrTable kNoThruTraffic = {
+    {"destination", "true"}, {"customers", "true"}, {"delivery", "true"}, {"permit", "true"},
+    {"residents", "true"}
+};
+
+const StrTable kMotorVehicle = {
+    {"yes", "true"}, {"private", "true"}, {"no", "false"}, {"permissive", "true"},
+    {"agricultural", "false"}, {"delivery", "true"}, {"designated", "true"}, {"discouraged", "false"},
+    {"forestry", "false"}, {"destination", "true"}, {"customers", "true"}, {"official", "false"},
+    {"public", "true"}, {"restricted", "true"}, {"allowed", "true"}, {"permit", "true"},
+    {"residents", "true"}
+};
+
+const StrTable kMoped = {
+    {"yes", "true"}, {"designated", "true"}, {"private", "true"}, {"permissive", "true"},
+    {"destination", "true"}, {"delivery", "true"}, {"dismount", "true"}, {"no", "false"},
+    {"unknown", "false"}, {"agricultural", "false"}, {"permit", "true"}, {"residents", "true"}
+};
+
+const StrTable kFoot = {
+    {"yes", "true"}, {"private", "true"}, {"no", "false"}, {"permissive", "true"},
+    {"agricultural", "false"}, {"use_sidepath", "true"}, {"delivery", "true"}, {"designated", "true"},
+    {"discouraged", "false"}, {"forestry", "false"}, {"destination", "true"}, {"customers", "true"},
+    {"official", "true"}, {"public", "true"}, {"restricted", "true"}, {"crossing", "true"},
+    {"sidewalk", "true"}, {"allowed", "true"}, {"passable", "true"}, {"footway", "true"},
+    {"permit", "true"}, {"residents", "true"}
+};
+
+const StrTable kWheelchair = {
+    {"no", "false"}, {"yes", "true"}, {"designated", "true"}, {"limited", "true"},
+    {"official", "true"}, {"destination", "true"}, {"public", "true"}, {"permissive", "true"},
+    {"only", "true"}, {"private", "true"}, {"impassable", "false"}, {"partial", "false"},
+    {"bad", "false"}, {"half", "false"}, {"assisted", "true"}, {"permit", "true"},
+    {"residents", "true"}
+};
+
+const StrTable kBus = {
+    {"no", "false"}, {"yes", "true"}, {"designated", "true"}, {"urban", "true"},
+    {"permissive", "true"}, {"restricted", "true"}, {"destination", "true"}, {"delivery", "false"},
+    {"official", "false"}, {"permit", "true"}
+};
+
+const StrTable kTaxi = {
+    {"no", "false"}, {"yes", "true"}, {"designated", "true"}, {"urban", "true"},
+    {"permissive", "true"}, {"restricted", "true"}, {"destination", "true"}, {"delivery", "false"},
+    {"official", "false"}, {"permit", "true"}
+};
+
+const StrTable kPsv = {
+    {"bus", "true"}, {"taxi", "true"}, {"no", "false"}, {"yes", "true"}, {"designated", "true"},
+    {"permissive", "true"}, {"1", "true"}, {"2", "true"}
+};
+
+const StrTable kTruck = {
+    {"designated", "true"}, {"yes", "true"}, {"no", "false"}, {"destination", "true"},
+    {"delivery", "true"}, {"local", "true"}, {"agricultural", "false"}, {"private", "true"},
+    {"discouraged", "false"}, {"permissive", "false"}, {"unsuitable", "false"},
+    {"agricultural;forestry", "false"}, {"official", "false"}, {"forestry", "false"},
+    {"destination;delivery", "true"}, {"permit", "true"}, {"residents", "true"}
+};
+
+const StrTable kHazmat = {
+    {"designated", "true"}, {"yes", "true"}, {"no", "false"}, {"destination", "false"},
+    {"delivery", "false"}
+};
+
+const StrTable kShoulder = {{"yes", "true"}, {"both", "true"}, {"no", "false"}};
+
+const StrTable kShoulderRight = {{"right", "true"}};
+
+const StrTable kShoulderLeft = {{"left", "true"}};
+
+const StrTable kBicycle = {
+    {"yes", "true"}, {"designated", "true"}, {"use_sidepath", "true"}, {"no", "false"},
+    {"permissive", "true"}, {"destination", "true"}, {"dismount", "true"}, {"lane", "true"},
+    {"track", "true"}, {"shared", "true"}, {"shared_lane", "true"}, {"sidepath", "true"},
+    {"share_busway", "true"}, {"none", "false"}, {"allowed", "true"}, {"private", "true"},
+    {"official", "true"}, {"permit", "true"}, {"residents", "true"}
+};
+
+const StrTable kCycleway = {
+    {"yes", "true"}, {"designated", "true"}, {"use_sidepath", "true"}, {"permissive", "true"},
+    {"destination", "true"}, {"dismount", "true"}, {"lane", "true"}, {"track", "true"},
+    {"shared", "true"}, {"shared_lane", "true"}, {"sidepath", "true"}, {"share_busway", "true"},
+    {"allowed", "true"}, {"private", "true"}, {"cyclestreet", "true"}, {"crossing", "true"}
+};
+
+const StrTable kBikeReverse = {
+    {"opposite", "true"}, {"opposite_lane", "true"}, {"opposite_track", "true"}
+};
+
+const StrTable kBusReverse = {{"opposite", "true"}, {"opposite_lane", "true"}};
+
+const StrTable kOneway = {
+    {"no", "false"}, {"false", "false"}, {"-1", "true"}, {"yes", "true"}, {"true", "true"},
+    {"1", "true"}, {"reversible", "false"}, {"alternating", "false"}
+};
+
+const StrTable kBridge = {{"yes", "true"}, {"no", "false"}, {"1", "true"}};
+
+const StrTable kTunnel = {
+    {"yes", "true"}, {"no", "false"}, {"1", "true"}, {"building_passage", "true"}
+};
+
+const StrTable kToll = {
+    {"yes", "true"}, {"no", "false"}, {"true", "true"}, {"false", "false"}, {"1", "true"},
+    {"interval", "true"}, {"snowmobile", "true"}
+};
+
+const StrTable kLit = {
+    {"yes", "true"}, {"no", "false"}, {"24/7", "true"}, {"automatic", "true"}, {"limited", "false"},
+    {"disused", "false"}, {"dusk-dawn", "true"}, {"sunset-sunrise", "true"}
+};
+
+const IntTable kRoadClass = {
+    {"motorway", 0}, {"motorway_link", 0}, {"trunk", 1}, {"trunk_link", 1}, {"primary", 2},
+    {"primary_link", 2}, {"secondary", 3}, {"secondary_link", 3}, {"tertiary", 4},
+    {"tertiary_link", 4}, {"unclassified", 5}, {"residential", 6}, {"residential_link", 6}
+};
+
+const IntTable kRestriction = {
+    {"no_left_turn", 0}, {"no_right_turn", 1}, {"no_straight_on", 2}, {"no_u_turn", 3},
+    {"only_right_turn", 4}, {"only_left_turn", 5}, {"only_straight_on", 6}, {"no_entry", 7},
+    {"no_exit", 8}, {"no_turn", 9}
+};
+
+const IntTable kUse = {
+    {"driveway", 4}, {"alley", 5}, {"parking_aisle", 6}, {"emergency_access", 7}, {"drive-through", 8}
+};
+
+const IntTable kShared = {{"shared_lane", 1}, {"share_busway", 1}, {"shared", 1}};
+
+const IntTable kBuffer = {{"yes", 2}};
+
+const IntTable kDedicated = {{"opposite_lane", 2}, {"lane", 2}, {"buffered_lane", 2}};
+
+const IntTable kSeparated = {{"opposite_track", 3}, {"track", 3}};
+
+const IntTable kMotorVehicleNode = {
+    {"yes", 1}, {"private", 1}, {"no", 0}, {"permissive", 1}, {"agricultural", 0}, {"delivery", 1},
+    {"designated", 1}, {"discouraged", 0}, {"forestry", 0}, {"destination", 1}, {"customers", 1},
+    {"official", 0}, {"public", 1}, {"restricted", 1}, {"allowed", 1}, {"permit", 1}, {"residents", 1}
+};
+
+const IntTable kBicycleNode = {
+    {"yes", 4}, {"designated", 4}, {"use_sidepath", 4}, {"no", 0}, {"permissive", 4},
+    {"destination", 4}, {"dismount", 4}, {"lane", 4}, {"track", 4}, {"shared", 4}, {"shared_lane", 4},
+    {"sidepath", 4}, {"share_busway", 4}, {"none", 0}, {"allowed", 4}, {"private", 4},
+    {"official", 4}, {"permit", 4}, {"residents", 4}
+};
+
+const IntTable kFootNode = {
+    {"yes", 2}, {"private", 2}, {"no", 0}, {"permissive", 2}, {"agricultural", 0},
+    {"use_sidepath", 2}, {"delivery", 2}, {"designated", 2}, {"discouraged", 0}, {"forestry", 0},
+    {"destination", 2}, {"customers", 2}, {"official", 2}, {"public", 2}, {"restricted", 2},
+    {"crossing", 2}, {"sidewalk", 2}, {"allowed", 2}, {"passable", 2}, {"footway", 2}, {"permit", 2},
+    {"residents", 2}
+};
+
+const IntTable kWheelchairNode = {
+    {"no", 0}, {"yes", 256}, {"designated", 256}, {"limited", 256}, {"official", 256},
+    {"destination", 256}, {"public", 256}, {"permissive", 256}, {"only", 256}, {"private", 256},
+    {"impassable", 0}, {"partial", 0}, {"bad", 0}, {"half", 0}, {"assisted", 256}, {"permit", 256},
+    {"residents", 256}
+};
+
+const IntTable kMopedNode = {
+    {"yes", 512}, {"designated", 512}, {"private", 512}, {"permissive", 512}, {"destination", 512},
+    {"delivery", 512}, {"dismount", 512}, {"no", 0}, {"unknown", 0}, {"agricultural", 0},
+    {"permit", 512}, {"residents", 512}
+};
+
+const IntTable kMotorCycleNode = {
+    {"yes", 1024}, {"private", 1024}, {"no", 0}, {"permissive", 1024}, {"agricultural", 0},
+    {"delivery", 1024}, {"designated", 1024}, {"discouraged", 0}, {"forestry", 0},
+    {"destination", 1024}, {"customers", 1024}, {"official", 0}, {"public", 1024},
+    {"restricted", 1024}, {"allowed", 1024}, {"permit", 1024}
+};
+
+const IntTable kBusNode = {
+    {"no", 0}, {"yes", 64}, {"designated", 64}, {"urban", 64}, {"permissive", 64}, {"restricted", 64},
+    {"destination", 64}, {"delivery", 0}, {"official", 0}, {"permit", 64}
+};
+
+const IntTable kTaxiNode = {
+    {"no", 0}, {"yes", 32}, {"designated", 32}, {"urban", 32}, {"permissive", 32}, {"restricted", 32},
+    {"destination", 32}, {"delivery", 0}, {"official", 0}, {"permit", 32}
+};
+
+const IntTable kTruckNode = {
+    {"designated", 8}, {"yes", 8}, {"no", 0}, {"destination", 8}, {"delivery", 8}, {"local", 8},
+    {"agricultural", 0}, {"private", 8}, {"discouraged", 0}, {"permissive", 0}, {"unsuitable", 0},
+    {"agricultural;forestry", 0}, {"official", 0}, {"forestry", 0}, {"destination;delivery", 8},
+    {"permit", 8}, {"residents", 8}
+};
+
+const IntTable kPsvBusNode = {
+    {"bus", 64}, {"no", 0}, {"yes", 64}, {"designated", 64}, {"permissive", 64}, {"1", 64}, {"2", 64}
+};
+
+const IntTable kPsvTaxiNode = {
+    {"taxi", 32}, {"no", 0}, {"yes", 32}, {"designated", 32}, {"permissive", 32}, {"1", 32}, {"2", 32}
+};
+
+const std::unordered_map<std::string, Modes> kHighway = {
+    {"motorway", {"true", "true", "true", "true", "false", "true", "false", "false"}},
+    {"motorway_link", {"true", "true", "true", "true", "false", "true", "false", "false"}},
+    {"trunk", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"trunk_link", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"primary", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"primary_link", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"secondary", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"secondary_link", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"residential", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"residential_link", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"service", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"tertiary", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"tertiary_link", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"road", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"track", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"unclassified", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"undefined", {"false", "false", "false", "false", "false", "false", "false", "false"}},
+    {"unknown", {"false", "false", "false", "false", "false", "false", "false", "false"}},
+    {"living_street", {"true", "true", "true", "true", "true", "true", "true", "true"}},
+    {"footway", {"false", "false", "false", "false", "false", "false", "true", "false"}},
+    {"pedestrian", {"false", "false", "false", "false", "false", "false", "true", "false"}},
+    {"steps", {"false", "false", "false", "false", "false", "false", "true", "true"}},
+    {"bridleway", {"false", "false", "false", "false", "false", "false", "false", "false"}},
+    {"cycleway", {"false", "false", "false", "false", "false", "false", "false", "true"}},
+    {"path", {"false", "false", "false", "false", "false", "false", "true", "true"}},
+    {"bus_guideway", {"false", "false", "true", "false", "false", "false", "false", "false"}},
+    {"busway", {"false", "false", "true", "false", "false", "false", "false", "false"}},
+    {"corridor", {"false", "false", "false", "false", "false", "false", "true", "false"}},
+    {"elevator", {"false", "false", "false", "false", "false", "false", "true", "false"}},
+    {"platform", {"false", "false", "false", "false", "false", "false", "true", "false"}}
+};
+
+// indexed by road class, the default speed of tracks is lowered afterwards
+const std::array<int, 8> kDefaultSpeed = {105, 90, 75, 60, 50, 40, 35, 25};
+
+const char* get(const Tags& kv, const char* key) {
+  auto found = kv.find(key);
+  return found == kv.end() ? nullptr : found->second.c_str();
+}
+
+bool is(const Tags& kv, const char* key, const char* value) {
+  auto found = kv.find(key);
+  return found != kv.end() && found->second == value;
+}
+
+bool equals(const char* a, const char* b) {
+  return a != nullptr && std::strcmp(a, b) == 0;
+}
+
+const char* lookup(const StrTable& table, const char* key) {
+  if (key == nullptr) {
+    return nullptr;
+  }
+  auto found = table.find(key);
+  return found == table.end() ? nullptr : found->second;
+}
+
+std::optional<int> lookup(const IntTable& table, const char* key) {
+  if (key == nullptr) {
+    return {};
+  }
+  auto found = table.find(key);
+  return found == table.end() ? std::optional<int>{} : found->second;
+}
+
+// the first value which isnt nil, like chaining them with lua's or
+const char* first_of(std::initializer_list<const char*> values) {
+  for (const auto* value : values) {
+    if (value != nullptr) {
+      return value;
+    }
+  }
+  return nullptr;
+}
+
+// setting a key to nil removes it
+void set(Tags& kv, const char* key, const char* value) {
+  if (value == nullptr) {
+    kv.erase(key);
+    return;
+  }
+  auto& current = kv[key];
+  if (current.c_str() != value) {
+    current = value;
+  }
+}
+
+// numbers become strings the way lua's tostring makes them
+void set_number(Tags& kv, const char* key, const std::optional<double>& number) {
+  if (!number) {
+    kv.erase(key);
+  } else if (std::isnan(*number)) {
+    kv[key] = "nan";
+  } else if (std::isinf(*number)) {
+    kv[key] = *number < 0 ? "-inf" : "inf";
+  } else {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.14g", *number);
+    kv[key] = buffer;
+  }
+}
+
+void swap(Tags& kv, const char* a, const char* b) {
+  auto first = kv.find(a);
+  auto second = kv.find(b);
+  if (first != kv.end() && second != kv.end()) {
+    std::swap(first->second, second->second);
+  } else if (first != kv.end()) {
+    auto value = std::move(first->second);
+    kv.erase(first);
+    kv[b] = std::move(value);
+  } else if (second != kv.end()) {
+    auto value = std::move(second->second);
+    kv.erase(second);
+    kv[a] = std::move(value);
+  }
+}
+
+// sets the access of all modes in one direction, vehicles only leaves out pedestrians
+void set_modes(Tags& kv, const Modes& keys, const char* value, bool pedestrian = true) {
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (pedestrian || i != kPedestrian) {
+      kv[keys[i]] = value;
+    }
+  }
+}
+
+bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool is_space(char c) {
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// lua's tonumber, surrounding white space is fine but nothing else may follow the number
+std::optional<double> to_number(const char* str) {
+  if (str == nullptr) {
+    return {};
+  }
+  char* end = nullptr;
+  double number = std::strtod(str, &end);
+  if (end == str) {
+    return {};
+  }
+  while (is_space(*end)) {
+    ++end;
+  }
+  if (*end != '\0') {
+    return {};
+  }
+  return number;
+}
+
+double lua_round(double value) {
+  return std::floor(value + 0.5);
+}
+
+double lua_round(double value, int digits) {
+  double scale = std::pow(10.0, digits);
+  return std::floor(value * scale + 0.5) / scale;
+}
+
+// the non negative number at the beginning of the string
+std::optional<std::string> numeric_prefix(const char* str, bool allow_decimals) {
+  if (str == nullptr) {
+    return {};
+  }
+  size_t index = 0;
+  bool seen_dot = false;
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (!is_digit(*c)) {
+      if (*c != '.' || !allow_decimals || seen_dot) {
+        break;
+      }
+      seen_dot = true;
+    }
+    ++index;
+  }
+  if (index == 0) {
+    return {};
+  }
+  return std::string(str, index);
+}
+
+// the type of a conditional restriction like no_left_turn @ (07:00-09:00,15:30-17:30)
+std::optional<std::string> restriction_prefix(const char* str) {
+  if (str == nullptr) {
+    return {};
+  }
+  size_t index = 0;
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (*c == '@') {
+      // this counts the characters which arent spaces but keeps the spaces in the result
+      return std::string(str, index);
+    }
+    if (*c != ' ') {
+      ++index;
+    }
+  }
+  return {};
+}
+
+// the date and time of a conditional restriction
+std::optional<std::string> restriction_suffix(const char* str) {
+  if (str == nullptr) {
+    return {};
+  }
+  size_t index = 0;
+  bool found = false;
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (found) {
+      if (*c != ' ') {
+        ++index;
+        break;
+      }
+    } else if (*c == '@') {
+      found = true;
+    }
+    ++index;
+  }
+  if (!found) {
+    return {};
+  }
+  // index is one past the first character of the result, lua strings start at 1
+  size_t length = std::strlen(str);
+  return index - 1 < length ? std::string(str + index - 1) : std::string();
+}
+
+std::optional<double> normalize_speed(const char* speed) {
+  auto prefix = numeric_prefix(speed, false);
+  if (!prefix) {
+    return {};
+  }
+  double number = std::strtod(prefix->c_str(), nullptr);
+  size_t length = std::strlen(speed);
+  if (length >= 3 && std::strcmp(speed + length - 3, "mph") == 0) {
+    number = lua_round(number * 1.609344);
+  }
+  if (number > 150 || number < 10) {
+    return {};
+  }
+  return number;
+}
+
+std::optional<double> normalize_weight(const char* weight) {
+  if (weight == nullptr) {
+    return {};
+  }
+  std::string w(weight);
+  w.erase(std::remove_if(w.begin(), w.end(), is_space), w.end());
+  auto prefix = numeric_prefix(w.c_str(), true);
+  if (!prefix) {
+    return {};
+  }
+  // a lone dot is a prefix which isnt a number, the lua version fails on it
+  auto number = to_number(prefix->c_str());
+  if (!number) {
+    throw std::runtime_error("Invalid weight " + w);
+  }
+  if (w == *prefix + "lb" || w == *prefix + "lbs") {
+    return lua_round(*number / 2000, 2);
+  }
+  if (w == *prefix + "kg") {
+    return lua_round(*number / 1000, 2);
+  }
+  // tons, tonnes or no unit at all
+  return lua_round(*number, 2);
+}
+
+std::optional<double> normalize_measurement(const char* measurement) {
+  if (measurement == nullptr) {
+    return {};
+  }
+  // turn commas into dots to handle European-style decimal separators
+  std::string m(measurement);
+  std::replace(m.begin(), m.end(), ',', '.');
+
+  // the simple case is a plain number
+  if (auto number = to_number(m.c_str())) {
+    return lua_round(*number, 2);
+  }
+
+  // otherwise sum up terms like 3ft6in, each a number followed by its unit
+  double sum = 0;
+  int count = 0;
+  size_t i = 0;
+  while (i < m.size()) {
+    if (!is_digit(m[i])) {
+      ++i;
+      continue;
+    }
+    size_t start = i;
+    while (i < m.size() && is_digit(m[i])) {
+      ++i;
+    }
+    if (i < m.size() && m[i] == '.') {
+      ++i;
+    }
+    while (i < m.size() && is_digit(m[i])) {
+      ++i;
+    }
+    auto item = to_number(m.substr(start, i - start).c_str());
+    while (i < m.size() && m[i] == ' ') {
+      ++i;
+    }
+    std::string unit;
+    while (i < m.size() && ((m[i] >= 'a' && m[i] <= 'z') || (m[i] >= 'A' && m[i] <= 'Z') ||
+                            m[i] == '"' || m[i] == '\'')) {
+      unit.push_back(m[i] >= 'A' && m[i] <= 'Z' ? m[i] - 'A' + 'a' : m[i]);
+      ++i;
+    }
+    if (!item) {
+      return {};
+    }
+
+    if (unit == "m" || unit == "meter" || unit == "meters") {
+      sum += *item;
+    } else if (unit == "cm") {
+      sum += *item * 0.01;
+    } else if (unit == "ft" || unit == "feet" || unit == "foot" || unit == "'") {
+      sum += *item * 0.3048;
+    } else if (unit == "in" || unit == "inches" || unit == "inch" || unit == "\"" ||
+               unit == "''") {
+      sum += *item * 0.0254;
+    } else {
+      return {};
+    }
+    ++count;
+  }
+
+  if (count > 0) {
+    return lua_round(sum, 2);
+  }
+  return {};
+}
+
+// whether the only payment types present are cash: cash, notes or coins. Any value but no counts
+// as accepting the payment type.
+bool is_cash_only_payment(const Tags& kv) {
+  bool allows_cash_payment = false;
+  bool allows_noncash_payment = false;
+  for (const auto& tag : kv) {
+    if (tag.first.compare(0, 8, "payment:") != 0) {
+      continue;
+    }
+    auto type = tag.first.substr(8);
+    bool is_cash_payment_type = type == "cash" || type == "notes" || type == "coins";
+    const auto& value = tag.second;
+    bool says_no = value.size() == 2 && std::toupper(static_cast<unsigned char>(value[0])) == 'N' &&
+                   std::toupper(static_cast<unsigned char>(value[1])) == 'O';
+    if (is_cash_payment_type && !allows_cash_payment) {
+      allows_cash_payment = !says_no;
+    }
+    if (!is_cash_payment_type && !allows_noncash_payment) {
+      allows_noncash_payment = !says_no;
+    }
+  }
+  return allows_cash_payment && !allows_noncash_payment;
+}
+
+// returns 1 if the way should be filtered 0 otherwise
+int filter_tags_generic(Tags& kv) {
+  if ((is(kv, "highway", "construction") && get(kv, "construction") == nullptr) ||
+      is(kv, "highway", "proposed")) {
+    return 1;
+  }
+
+  // figure out what basic type of road it is
+  const Modes* forward = nullptr;
+  const char* highway_type =
+      get(kv, is(kv, "highway", "construction") ? "construction" : "highway");
+  if (highway_type != nullptr) {
+    auto highway = kHighway.find(highway_type);
+    if (highway != kHighway.end()) {
+      forward = &highway->second;
+    }
+  }
+  bool ferry = is(kv, "route", "ferry");
+  bool rail = is(kv, "route", "shuttle_train");
+  const char* access = lookup(kAccess, get(kv, "access"));
+
+  kv["emergency_forward"] = "false";
+  kv["emergency_backward"] = "false";
+
+  if (ferry || rail || get(kv, "highway") != nullptr) {
+    if (is(kv, "access", "emergency") || is(kv, "emergency", "yes") ||
+        is(kv, "service", "emergency_access")) {
+      kv["emergency_forward"] = "true";
+      kv["emergency_tag"] = "true";
+    }
+    if (is(kv, "emergency", "no")) {
+      kv["emergency_tag"] = "false";
+    }
+  }
+
+  bool blocked = is(kv, "impassable", "yes") || equals(access, "false") ||
+                 (is(kv, "access", "private") &&
+                  (is(kv, "emergency", "yes") || is(kv, "service", "emergency_access")));
+
+  const char* motor_vehicle = lookup(kMotorVehicle, get(kv, "motor_vehicle"));
+  const char* auto_tag = first_of({lookup(kMotorVehicle, get(kv, "motorcar")), motor_vehicle});
+  const char* truck_tag = first_of({lookup(kTruck, get(kv, "hgv")), motor_vehicle});
+  const char* psv = first_of(
+      {lookup(kPsv, get(kv, "psv")), lookup(kPsv, get(kv, "lanes:psv:forward")), motor_vehicle});
+  const char* bus_tag = first_of({lookup(kBus, get(kv, "bus")), psv});
+  const char* taxi_tag = first_of({lookup(kTaxi, get(kv, "taxi")), psv});
+  const char* foot_tag =
+      first_of({lookup(kFoot, get(kv, "foot")), lookup(kFoot, get(kv, "pedestrian"))});
+  const char* bike_tag =
+      first_of({lookup(kBicycle, get(kv, "bicycle")), lookup(kCycleway, get(kv, "cycleway")),
+                lookup(kBicycle, get(kv, "bicycle_road")), lookup(kBicycle, get(kv, "cyclestreet"))});
+  const char* moped_tag = first_of(
+      {lookup(kMoped, get(kv, "moped")), lookup(kMoped, get(kv, "mofa")), motor_vehicle});
+  const char* motorcycle_tag =
+      first_of({lookup(kMotorVehicle, get(kv, "motorcycle")), motor_vehicle});
+
+  if (forward) {
+    for (size_t i = 0; i < kForward.size(); ++i) {
+      kv[kForward[i]] = (*forward)[i];
+    }
+
+    if (blocked) {
+      set_modes(kv, kForward, "false");
+      set_modes(kv, kBackward, "false");
+    } else if (is(kv, "vehicle", "no")) {
+      // don't change ped access
+      set_modes(kv, kForward, "false", false);
+      set_modes(kv, kBackward, "false", false);
+    }
+
+    // check for overrides of the forward access
+    set(kv, "auto_forward", first_of({auto_tag, get(kv, "auto_forward")}));
+    set(kv, "auto_tag", auto_tag);
+    set(kv, "truck_forward", first_of({truck_tag, get(kv, "truck_forward")}));
+    set(kv, "truck_tag", truck_tag);
+    set(kv, "bus_forward", first_of({bus_tag, get(kv, "bus_forward")}));
+    set(kv, "bus_tag", bus_tag);
+    set(kv, "taxi_forward", first_of({taxi_tag, get(kv, "taxi_forward")}));
+    set(kv, "taxi_tag", taxi_tag);
+    set(kv, "pedestrian_forward", first_of({foot_tag, get(kv, "pedestrian_forward")}));
+    set(kv, "foot_tag", foot_tag);
+    set(kv, "bike_forward", first_of({bike_tag, get(kv, "bike_forward")}));
+    set(kv, "bike_tag", bike_tag);
+    set(kv, "moped_forward", first_of({moped_tag, get(kv, "moped_forward")}));
+    set(kv, "moped_tag", moped_tag);
+    set(kv, "motorcycle_forward", first_of({motorcycle_tag, get(kv, "motorcycle_forward")}));
+    set(kv, "motorcycle_tag", motorcycle_tag);
+  } else {
+    // if its a ferry and these tags dont show up we want to set them to true
+    const char* default_val = ferry || rail ? "true" : "false";
+
+    if ((!ferry && !rail) || blocked) {
+      set_modes(kv, kForward, "false");
+      set_modes(kv, kBackward, "false");
+    } else {
+      const char* ped_val = default_val;
+      if (is(kv, "vehicle", "no")) {
+        // don't change ped access
+        default_val = "false";
+      }
+
+      // check for overrides of the forward access
+      set(kv, "auto_forward", first_of({auto_tag, default_val}));
+      set(kv, "auto_tag", auto_tag);
+      set(kv, "truck_forward", first_of({lookup(kTruck, get(kv, "hgv")), get(kv, "truck_forward"),
+                                         motor_vehicle, default_val}));
+      set(kv, "truck_tag", truck_tag);
+      set(kv, "bus_forward", first_of({bus_tag, default_val}));
+      set(kv, "bus_tag", bus_tag);
+      set(kv, "taxi_forward", first_of({taxi_tag, default_val}));
+      set(kv, "taxi_tag", taxi_tag);
+      set(kv, "pedestrian_forward", first_of({foot_tag, ped_val}));
+      set(kv, "foot_tag", foot_tag);
+      set(kv, "bike_forward", first_of({bike_tag, default_val}));
+      set(kv, "bike_tag", bike_tag);
+      set(kv, "moped_forward", first_of({moped_tag, default_val}));
+      set(kv, "moped_tag", moped_tag);
+      set(kv, "motorcycle_forward", first_of({motorcycle_tag, default_val}));
+      set(kv, "motorcycle_tag", motorcycle_tag);
+    }
+  }
+
+  // only roads, ferries and trains which are not blocked get these
+  if (forward || ((ferry || rail) && !blocked)) {
+    if (bike_tag == nullptr) {
+      if (is(kv, "sac_scale", "hiking")) {
+        kv["bike_forward"] = "true";
+        kv["bike_tag"] = "true";
+      } else if (get(kv, "sac_scale") != nullptr) {
+        kv["bike_forward"] = "false";
+      }
+    }
+
+    if (is(kv, "access", "psv")) {
+      kv["taxi_forward"] = "true";
+      kv["taxi_tag"] = "true";
+      kv["bus_forward"] = "true";
+      kv["bus_tag"] = "true";
+    }
+
+    if (is(kv, "motorroad", "yes")) {
+      kv["motorroad_tag"] = "true";
+    }
+  }
+
+  // TODO: handle Time conditional restrictions if available for HOVs with oneway = reversible
+  if ((is(kv, "access", "permissive") || is(kv, "access", "hov") || is(kv, "access", "taxi")) &&
+      is(kv, "oneway", "reversible")) {
+    // for now enable only for buses if the tag exists and they are allowed
+    if (!is(kv, "bus_forward", "true")) {
+      return 1;
+    }
+    kv["auto_forward"] = "false";
+    kv["truck_forward"] = "false";
+    kv["pedestrian_forward"] = "false";
+    kv["bike_forward"] = "false";
+    kv["moped_forward"] = "false";
+    kv["motorcycle_forward"] = "false";
+  }
+
+  // service=driveway means all are routable
+  if (is(kv, "service", "driveway") && get(kv, "access") == nullptr) {
+    set_modes(kv, kForward, "true");
+  }
+
+  // check the oneway-ness and traversability against the direction of the geom
+  const char* oneway_bike = nullptr;
+  if ((is(kv, "oneway", "yes") && is(kv, "oneway:bicycle", "no")) ||
+      is(kv, "bicycle:backward", "yes") || is(kv, "bicycle:backward", "no")) {
+    kv["bike_backward"] = "true";
+  }
+  if (get(kv, "bike_backward") == nullptr || is(kv, "bike_backward", "false")) {
+    set(kv, "bike_backward",
+        first_of({lookup(kBikeReverse, get(kv, "cycleway")),
+                  lookup(kBikeReverse, get(kv, "cycleway:left")),
+                  lookup(kBikeReverse, get(kv, "cycleway:right")), "false"}));
+  }
+  if (is(kv, "bike_backward", "true")) {
+    oneway_bike = lookup(kOneway, get(kv, "oneway:bicycle"));
+  }
+
+  const char* oneway_bus = nullptr;
+  if (get(kv, "oneway:bus") == nullptr && get(kv, "oneway:psv") != nullptr) {
+    set(kv, "oneway:bus", get(kv, "oneway:psv"));
+  }
+  if ((is(kv, "oneway", "yes") && is(kv, "oneway:bus", "no")) || is(kv, "bus:backward", "yes") ||
+      is(kv, "bus:backward", "designated")) {
+    kv["bus_backward"] = "true";
+  }
+  if (get(kv, "bus_backward") == nullptr || is(kv, "bus_backward", "false")) {
+    set(kv, "bus_backward",
+        first_of({lookup(kBusReverse, get(kv, "busway")),
+                  lookup(kBusReverse, get(kv, "busway:left")),
+                  lookup(kBusReverse, get(kv, "busway:right")),
+                  lookup(kPsv, get(kv, "lanes:psv:backward")), "false"}));
+  }
+  if (is(kv, "bus_backward", "true")) {
+    oneway_bus = lookup(kOneway, get(kv, "oneway:bus"));
+    if (equals(oneway_bus, "false") && is(kv, "bus:backward", "yes")) {
+      oneway_bus = "true";
+    }
+  }
+
+  const char* oneway_taxi = nullptr;
+  if (get(kv, "oneway:taxi") == nullptr && get(kv, "oneway:psv") != nullptr) {
+    set(kv, "oneway:taxi", get(kv, "oneway:psv"));
+  }
+  if ((is(kv, "oneway", "yes") && is(kv, "oneway:taxi", "no")) || is(kv, "taxi:backward", "yes") ||
+      is(kv, "taxi:backward", "designated")) {
+    kv["taxi_backward"] = "true";
+  }
+  if (get(kv, "taxi_backward") == nullptr || is(kv, "taxi_backward", "false")) {
+    set(kv, "taxi_backward", first_of({lookup(kPsv, get(kv, "lanes:psv:backward")), "false"}));
+  }
+  if (is(kv, "taxi_backward", "true")) {
+    oneway_taxi = lookup(kOneway, get(kv, "oneway:taxi"));
+    if (equals(oneway_taxi, "false") && is(kv, "taxi:backward", "yes")) {
+      oneway_taxi = "true";
+    }
+  }
+
+  const char* oneway_moped = nullptr;
+  if (get(kv, "moped_backward") == nullptr) {
+    kv["moped_backward"] = "false";
+  }
+  if ((is(kv, "oneway", "yes") && (is(kv, "oneway:moped", "no") || is(kv, "oneway:mofa", "no"))) ||
+      is(kv, "moped:backward", "yes") || is(kv, "mofa:backward", "yes")) {
+    kv["moped_backward"] = "true";
+  }
+  if (is(kv, "moped_backward", "true")) {
+    oneway_moped = first_of(
+        {lookup(kOneway, get(kv, "oneway:moped")), lookup(kOneway, get(kv, "oneway:mofa"))});
+  }
+
+  const char* oneway_motorcycle = nullptr;
+  if (get(kv, "motorcycle_backward") == nullptr) {
+    kv["motorcycle_backward"] = "false";
+  }
+  if ((is(kv, "oneway", "yes") && is(kv, "oneway:motorcycle", "no")) ||
+      is(kv, "motorcycle:backward", "yes")) {
+    kv["motorcycle_backward"] = "true";
+  }
+  if (is(kv, "motorcycle_backward", "true")) {
+    oneway_motorcycle = lookup(kOneway, get(kv, "oneway:motorcycle"));
+  }
+
+  const char* oneway_foot = nullptr;
+  if (get(kv, "pedestrian_backward") == nullptr) {
+    kv["pedestrian_backward"] = "false";
+  }
+  if ((is(kv, "oneway", "yes") && is(kv, "oneway:foot", "no")) || is(kv, "foot:backward", "yes")) {
+    kv["pedestrian_backward"] = "true";
+  }
+  if (is(kv, "pedestrian_backward", "true")) {
+    oneway_foot = lookup(kOneway, get(kv, "oneway:foot"));
+  }
+
+  bool oneway_reverse = is(kv, "oneway", "-1");
+  const char* oneway_norm = lookup(kOneway, get(kv, "oneway"));
+  if (is(kv, "junction", "roundabout") || is(kv, "junction", "circular")) {
+    oneway_norm = "true";
+    kv["roundabout"] = "true";
+  } else {
+    kv["roundabout"] = "false";
+  }
+  set(kv, "oneway", oneway_norm);
+
+  // a oneway in the reverse direction of a mode only shuts off its forward access, if the mode
+  // is allowed both ways on the oneway it opens it up
+  auto oneway_mode = [&kv](const char* backward, const char* forward, const char* oneway) {
+    if (is(kv, backward, "true")) {
+      if (equals(oneway, "true")) {
+        kv[forward] = "false";
+      } else if (equals(oneway, "false")) {
+        kv[forward] = "true";
+      }
+    }
+  };
+  // the mode can go both ways on a way which is not oneway unless it has a oneway of its own
+  auto not_oneway = [&kv](const char* key) {
+    return get(kv, key) == nullptr || is(kv, key, "no");
+  };
+
+  if (equals(oneway_norm, "true")) {
+    kv["auto_backward"] = "false";
+    kv["truck_backward"] = "false";
+    kv["emergency_backward"] = "false";
+
+    oneway_mode("bike_backward", "bike_forward", oneway_bike);
+    oneway_mode("bus_backward", "bus_forward", oneway_bus);
+    oneway_mode("taxi_backward", "taxi_forward", oneway_taxi);
+    oneway_mode("moped_backward", "moped_forward", oneway_moped);
+    oneway_mode("motorcycle_backward", "motorcycle_forward", oneway_motorcycle);
+    // don't apply oneway tag unless oneway:foot or pedestrian only way
+    if (is(kv, "highway", "footway") || is(kv, "highway", "pedestrian") ||
+        is(kv, "highway", "steps") || is(kv, "highway", "path") ||
+        get(kv, "oneway:foot") != nullptr) {
+      oneway_mode("pedestrian_backward", "pedestrian_forward", oneway_foot);
+    } else {
+      set(kv, "pedestrian_backward", get(kv, "pedestrian_forward"));
+    }
+  } else {
+    set(kv, "auto_backward", get(kv, "auto_forward"));
+    set(kv, "truck_backward", get(kv, "truck_forward"));
+    set(kv, "emergency_backward", get(kv, "emergency_forward"));
+
+    // a string is never equal to false in lua so the oneway:<mode> tag has to be missing or no
+    if (is(kv, "bike_backward", "false") && !is(kv, "oneway:bicycle", "-1") &&
+        not_oneway("oneway:bicycle")) {
+      set(kv, "bike_backward", get(kv, "bike_forward"));
+    }
+    if (is(kv, "bus_backward", "false") && !is(kv, "oneway:bus", "-1") &&
+        get(kv, "oneway:bus") == nullptr) {
+      set(kv, "bus_backward", get(kv, "bus_forward"));
+    }
+    if (is(kv, "taxi_backward", "false") && !is(kv, "oneway:taxi", "-1") &&
+        get(kv, "oneway:taxi") == nullptr) {
+      set(kv, "taxi_backward", get(kv, "taxi_forward"));
+    }
+    if (is(kv, "moped_backward", "false") && not_oneway("oneway:moped") &&
+        not_oneway("oneway:mofa")) {
+      set(kv, "moped_backward", get(kv, "moped_forward"));
+    }
+    if (is(kv, "motorcycle_backward", "false") && !is(kv, "oneway:motorcycle", "-1") &&
+        not_oneway("oneway:motorcycle")) {
+      set(kv, "motorcycle_backward", get(kv, "motorcycle_forward"));
+    }
+    if (is(kv, "pedestrian_backward", "false") && not_oneway("oneway:foot")) {
+      set(kv, "pedestrian_backward", get(kv, "pedestrian_forward"));
+    }
+  }
+
+  // bike forward / backward overrides
+  auto cycle_lane = [&kv](const char* key) {
+    const char* value = get(kv, key);
+    return lookup(kShared, value) || lookup(kSeparated, value) || lookup(kDedicated, value);
+  };
+  if (cycle_lane("cycleway:both") || (cycle_lane("cycleway:right") && cycle_lane("cycleway:left"))) {
+    kv["bike_forward"] = "true";
+    kv["bike_backward"] = "true";
+  }
+
+  if (is(kv, "busway", "lane") || (is(kv, "busway:left", "lane") && is(kv, "busway:right", "lane"))) {
+    kv["bus_forward"] = "true";
+    kv["bus_backward"] = "true";
+  }
+
+  // flip the onewayness
+  kv["oneway_reverse"] = oneway_reverse ? "true" : "false";
+  if (oneway_reverse) {
+    swap(kv, "auto_forward", "auto_backward");
+    swap(kv, "truck_forward", "truck_backward");
+    swap(kv, "emergency_forward", "emergency_backward");
+    swap(kv, "bus_forward", "bus_backward");
+    swap(kv, "taxi_forward", "taxi_backward");
+    swap(kv, "bike_forward", "bike_backward");
+    swap(kv, "moped_forward", "moped_backward");
+    swap(kv, "motorcycle_forward", "motorcycle_backward");
+    swap(kv, "pedestrian_forward", "pedestrian_backward");
+  }
+
+  if (is(kv, "oneway:bicycle", "-1")) {
+    swap(kv, "bike_forward", "bike_backward");
+  }
+  if (is(kv, "oneway:moped", "-1") || is(kv, "oneway:mofa", "-1")) {
+    swap(kv, "moped_forward", "moped_backward");
+  }
+  if (is(kv, "oneway:motorcycle", "-1")) {
+    swap(kv, "motorcycle_forward", "motorcycle_backward");
+  }
+  if (is(kv, "oneway:foot", "-1")) {
+    swap(kv, "pedestrian_forward", "pedestrian_backward");
+  }
+  if (is(kv, "oneway:bus", "-1")) {
+    swap(kv, "bus_forward", "bus_backward");
+  }
+
+  // bus only logic
+  if (is(kv, "lanes:bus", "1")) {
+    kv["bus_forward"] = "true";
+    kv["bus_backward"] = "false";
+  } else if (is(kv, "lanes:bus", "2")) {
+    kv["bus_forward"] = "true";
+    kv["bus_backward"] = "true";
+  }
+
+  if (is(kv, "oneway:taxi", "-1")) {
+    swap(kv, "taxi_forward", "taxi_backward");
+  }
+
+  if (is(kv, "lanes:psv", "1")) {
+    kv["taxi_forward"] = "true";
+    kv["taxi_backward"] = "false";
+  } else if (is(kv, "lanes:psv", "2")) {
+    kv["taxi_forward"] = "true";
+    kv["taxi_backward"] = "true";
+  }
+
+  // if none of the modes were set we are done looking at this, bridleways are saved for the
+  // country access logic
+  bool no_access = true;
+  for (const auto* key :
+       {"auto_forward", "truck_forward", "bus_forward", "bike_forward", "emergency_forward",
+        "moped_forward", "motorcycle_forward", "pedestrian_forward", "auto_backward",
+        "truck_backward", "bus_backward", "bike_backward", "emergency_backward", "moped_backward",
+        "motorcycle_backward", "pedestrian_backward"}) {
+    no_access = no_access && is(kv, key, "false");
+  }
+  if (no_access && !is(kv, "highway", "bridleway")) {
+    return 1;
+  }
+
+  // toss actual areas
+  if (is(kv, "area", "yes")) {
+    return 1;
+  }
+
+  kv.erase("FIXME");
+  kv.erase("note");
+  kv.erase("source");
+
+  // set a few flags
+  bool construction = is(kv, "highway", "construction");
+  bool has_highway = get(kv, "highway") != nullptr;
+  auto rc = lookup(kRoadClass, get(kv, construction ? "construction" : "highway"));
+  if (!has_highway && ferry) {
+    rc = 2; // TODO:  can we weight based on ferry types?
+  } else if (!has_highway && (get(kv, "railway") != nullptr || rail)) {
+    rc = 2; // TODO:  can we weight based on rail types?
+  } else if (!rc) {
+    // service and other
+    rc = 7;
+  }
+  set_number(kv, "road_class", *rc);
+
+  // lower the default speed for driveways
+  double default_speed = kDefaultSpeed[*rc];
+  if (is(kv, "service", "driveway")) {
+    default_speed = std::floor(default_speed * 0.5);
+  }
+
+  set(kv, "lit", lookup(kLit, get(kv, "lit")));
+
+  auto use = lookup(kUse, get(kv, "service"));
+  auto closed_to = [&kv](std::initializer_list<const char*> keys) {
+    return std::all_of(keys.begin(), keys.end(),
+                       [&kv](const char* key) { return is(kv, key, "false"); });
+  };
+  if (has_highway) {
+    if (construction) {
+      use = 43;
+    } else if (is(kv, "highway", "track")) {
+      use = 3;
+    } else if (is(kv, "highway", "living_street")) {
+      use = 10;
+    } else if (!use && is(kv, "highway", "service")) {
+      use = 11;
+    } else if (is(kv, "highway", "cycleway")) {
+      use = 20;
+    } else if (closed_to({"pedestrian_forward", "auto_forward", "auto_backward"}) &&
+               (is(kv, "bike_forward", "true") || is(kv, "bike_backward", "true"))) {
+      use = 20;
+    } else if (is(kv, "highway", "footway") && is(kv, "footway", "sidewalk")) {
+      use = 24;
+    } else if (is(kv, "highway", "footway") && is(kv, "footway", "crossing")) {
+      use = 32;
+    } else if (is(kv, "highway", "footway")) {
+      use = 25;
+    } else if (is(kv, "highway", "elevator")) {
+      use = 33;
+    } else if (is(kv, "highway", "steps") && get(kv, "conveying") != nullptr) {
+      use = 34; // escalator
+    } else if (is(kv, "highway", "steps")) {
+      use = 26;
+    } else if (is(kv, "highway", "path")) {
+      use = 27;
+    } else if (is(kv, "highway", "pedestrian")) {
+      use = 28;
+    } else if (is(kv, "highway", "platform")) {
+      use = 35;
+    } else if (is(kv, "pedestrian_forward", "true") &&
+               closed_to({"auto_forward", "auto_backward", "truck_forward", "truck_backward",
+                          "bus_forward", "bus_backward", "bike_forward", "bike_backward",
+                          "moped_forward", "moped_backward", "motorcycle_forward",
+                          "motorcycle_backward"})) {
+      use = 28;
+    } else if (is(kv, "highway", "bridleway")) {
+      use = 29;
+    }
+  }
+
+  if (!use && get(kv, "service") != nullptr) {
+    use = 40; // other
+  } else if (!use) {
+    use = 0; // general road, no special use
+  }
+
+  // do not override 'construction' use
+  if (use != 43 && (is(kv, "access", "emergency") || is(kv, "emergency", "yes")) &&
+      closed_to({"auto_forward", "auto_backward", "truck_forward", "truck_backward", "bus_forward",
+                 "bus_backward", "bike_forward", "bike_backward", "moped_forward",
+                 "moped_backward", "motorcycle_forward", "motorcycle_backward"})) {
+    use = 7;
+  }
+  set_number(kv, "use", *use);
+
+  const char* r_shoulder = first_of(
+      {lookup(kShoulder, get(kv, "shoulder")), lookup(kShoulder, get(kv, "shoulder:both"))});
+  const char* l_shoulder = r_shoulder;
+  if (r_shoulder == nullptr) {
+    r_shoulder = first_of({lookup(kShoulder, get(kv, "shoulder:right")),
+                           lookup(kShoulderRight, get(kv, "shoulder")), "false"});
+    l_shoulder = first_of({lookup(kShoulder, get(kv, "shoulder:left")),
+                           lookup(kShoulderLeft, get(kv, "shoulder")), "false"});
+
+    // If the road is oneway and one shoulder is tagged but not the other, we set both to true so
+    // that when setting the shoulder in graphbuilder, driving on the right side vs the left side
+    // doesn't cause the edge to miss the shoulder tag
+    if (equals(oneway_norm, "true") && equals(r_shoulder, "true") && equals(l_shoulder, "false")) {
+      l_shoulder = "true";
+    } else if (equals(oneway_norm, "true") && equals(r_shoulder, "false") &&
+               equals(l_shoulder, "true")) {
+      r_shoulder = "true";
+    }
+  }
+  kv["shoulder_right"] = r_shoulder;
+  kv["shoulder_left"] = l_shoulder;
+
+  const char* cycle_lane_right_opposite = "false";
+  const char* cycle_lane_left_opposite = "false";
+  int cycle_lane_right = 0;
+  int cycle_lane_left = 0;
+
+  // We have special use cases for cycle lanes when on a cycleway, footway, or path
+  if ((use == 20 || use == 25 || use == 27) &&
+      (is(kv, "bike_forward", "true") || is(kv, "bike_backward", "true"))) {
+    if (is(kv, "pedestrian_forward", "false")) {
+      cycle_lane_right = 3; // separated
+    } else if (is(kv, "segregated", "yes")) {
+      cycle_lane_right = 2; // dedicated
+    } else if (is(kv, "segregated", "no")) {
+      cycle_lane_right = 1; // shared
+    } else if (use == 20) {
+      // If no segregated tag but it is tagged as a cycleway then we assume separated lanes
+      cycle_lane_right = 2;
+    } else {
+      // If no segregated tag and it's tagged as a footway or path then we assume shared lanes
+      cycle_lane_right = 1;
+    }
+    cycle_lane_left = cycle_lane_right;
+  } else {
+    // Set flags if any of the lanes are marked "opposite" (contraflow)
+    cycle_lane_right_opposite = first_of({lookup(kBikeReverse, get(kv, "cycleway")), "false"});
+    cycle_lane_left_opposite = cycle_lane_right_opposite;
+    if (equals(cycle_lane_right_opposite, "false")) {
+      cycle_lane_right_opposite =
+          first_of({lookup(kBikeReverse, get(kv, "cycleway:right")), "false"});
+      cycle_lane_left_opposite = first_of({lookup(kBikeReverse, get(kv, "cycleway:left")), "false"});
+    }
+
+    // Figure out which side of the road has what cyclelane
+    auto lane_type = [&kv](const char* key, const char* buffer) {
+      const char* value = get(kv, key);
+      auto type = lookup(kShared, value);
+      type = type ? type : lookup(kSeparated, value);
+      type = type ? type : lookup(kDedicated, value);
+      type = type ? type : lookup(kBuffer, get(kv, buffer));
+      return type.value_or(0);
+    };
+    cycle_lane_right = lane_type("cycleway", "cycleway:both:buffer");
+    cycle_lane_left = cycle_lane_right;
+    if (cycle_lane_right == 0) {
+      cycle_lane_right = lane_type("cycleway:right", "cycleway:right:buffer");
+      cycle_lane_left = lane_type("cycleway:left", "cycleway:left:buffer");
+    }
+
+    // If we have the oneway:bicycle=no tag and there are not "opposite_lane/opposite_track" tags
+    // then there are certain situations where the cyclelane is considered a two-way. (Based off of
+    // some examples on wiki.openstreetmap.org/wiki/Bicycle)
+    if (is(kv, "oneway:bicycle", "no") && equals(cycle_lane_right_opposite, "false") &&
+        equals(cycle_lane_left_opposite, "false")) {
+      if (cycle_lane_right == 2 || cycle_lane_right == 3) {
+        if (equals(oneway_norm, "true")) {
+          // Example M1 or M2d but on the right side
+          cycle_lane_left = cycle_lane_right;
+          cycle_lane_left_opposite = "true";
+        } else if (cycle_lane_left == 0) {
+          // Example L1b
+          cycle_lane_left = cycle_lane_right;
+        }
+      } else if (cycle_lane_left == 2 || cycle_lane_left == 3) {
+        if (equals(oneway_norm, "true")) {
+          // Example M2d
+          cycle_lane_right = cycle_lane_left;
+          cycle_lane_right_opposite = "true";
+        } else if (cycle_lane_right == 0) {
+          // Example L1b but on the left side
+          cycle_lane_right = cycle_lane_left;
+        }
+      }
+    }
+  }
+  set_number(kv, "cycle_lane_right", cycle_lane_right);
+  set_number(kv, "cycle_lane_left", cycle_lane_left);
+  kv["cycle_lane_right_opposite"] = cycle_lane_right_opposite;
+  kv["cycle_lane_left_opposite"] = cycle_lane_left_opposite;
+
+  const char* link_type = get(kv, construction ? "construction" : "highway");
+  if (link_type != nullptr && std::strstr(link_type, "_link") != nullptr) {
+    kv["link"] = "true"; // do we need to add more?  turnlane?
+  }
+
+  kv["private"] = first_of({lookup(kPrivate, get(kv, "access")),
+                            lookup(kPrivate, get(kv, "motor_vehicle")), "false"});
+  kv["no_thru_traffic"] = first_of({lookup(kNoThruTraffic, get(kv, "access")), "false"});
+  kv["ferry"] = ferry ? "true" : "false";
+  kv["rail"] = is(kv, "auto_forward", "true") && (is(kv, "railway", "rail") || rail) ? "true"
+                                                                                      : "false";
+
+  if (is(kv, "maxspeed", "none")) {
+    // special case unlimited speed limit (german autobahn)
+    kv["max_speed"] = "unlimited";
+  } else {
+    set_number(kv, "max_speed", normalize_speed(get(kv, "maxspeed")));
+  }
+  set_number(kv, "advisory_speed", normalize_speed(get(kv, "maxspeed:advisory")));
+  set_number(kv, "average_speed", normalize_speed(get(kv, "maxspeed:practical")));
+  set_number(kv, "backward_speed", normalize_speed(get(kv, "maxspeed:backward")));
+  set_number(kv, "forward_speed", normalize_speed(get(kv, "maxspeed:forward")));
+  set(kv, "wheelchair", lookup(kWheelchair, get(kv, "wheelchair")));
+
+  // lower the default speed for tracks
+  if (is(kv, "highway", "track")) {
+    default_speed = 5;
+    if (is(kv, "tracktype", "grade1")) {
+      default_speed = 20;
+    } else if (is(kv, "tracktype", "grade2")) {
+      default_speed = 15;
+    } else if (is(kv, "tracktype", "grade3")) {
+      default_speed = 12;
+    } else if (is(kv, "tracktype", "grade4")) {
+      default_speed = 10;
+    }
+  }
+  set_number(kv, "default_speed", default_speed);
+
+  // use unsigned_ref if all the conditions are met
+  if (get(kv, "name") == nullptr && get(kv, "name:en") == nullptr &&
+      get(kv, "alt_name") == nullptr && get(kv, "official_name") == nullptr &&
+      get(kv, "ref") == nullptr && get(kv, "int_ref") == nullptr &&
+      (is(kv, "highway", "motorway") || is(kv, "highway", "trunk") ||
+       is(kv, "highway", "primary")) &&
+      get(kv, "unsigned_ref") != nullptr) {
+    set(kv, "ref", get(kv, "unsigned_ref"));
+  }
+
+  auto lane_count = [&kv](const char* key) -> std::optional<double> {
+    auto prefix = numeric_prefix(get(kv, key), false);
+    if (!prefix) {
+      return {};
+    }
+    double count = std::strtod(prefix->c_str(), nullptr);
+    if (count > 15) {
+      return {};
+    }
+    return count;
+  };
+  set_number(kv, "lanes", lane_count("lanes"));
+  set_number(kv, "forward_lanes", lane_count("lanes:forward"));
+  set_number(kv, "backward_lanes", lane_count("lanes:backward"));
+
+  kv["bridge"] = first_of({lookup(kBridge, get(kv, "bridge")), "false"});
+
+  // TODO access:conditional
+  if (get(kv, "seasonal") != nullptr && !is(kv, "seasonal", "no")) {
+    kv["seasonal"] = "true";
+  }
+
+  kv["hov_tag"] = "true";
+  if (is(kv, "hov", "no")) {
+    kv["hov_forward"] = "false";
+    kv["hov_backward"] = "false";
+  } else {
+    set(kv, "hov_forward", get(kv, "auto_forward"));
+    set(kv, "hov_backward", get(kv, "auto_backward"));
+  }
+
+  // hov restrictions
+  if ((get(kv, "hov") != nullptr && !is(kv, "hov", "no")) || get(kv, "hov:lanes") != nullptr ||
+      get(kv, "hov:minimum") != nullptr) {
+    bool only_hov_allowed = is(kv, "hov", "designated");
+
+    // If "hov:lanes" is specified ensure all lanes are tagged "designated"
+    const char* hov_lanes = get(kv, "hov:lanes");
+    if (only_hov_allowed && hov_lanes != nullptr) {
+      std::string lanes = std::string(hov_lanes) + '|';
+      for (size_t start = 0, end; (end = lanes.find('|', start)) != std::string::npos;
+           start = end + 1) {
+        if (lanes.compare(start, end - start, "designated") != 0) {
+          only_hov_allowed = false;
+        }
+      }
+    }
+
+    // I want to be strict with the "hov:minimum" tag: I will only accept the values 2 or 3. We
+    // want to be strict because routing onto an HOV lane without the correct number of occupants
+    // is illegal.
+    if (only_hov_allowed) {
+      if (is(kv, "hov:minimum", "2")) {
+        kv["hov_type"] = "HOV2";
+      } else if (is(kv, "hov:minimum", "3")) {
+        kv["hov_type"] = "HOV3";
+      } else {
+        only_hov_allowed = false;
+      }
+    }
+
+    // HOV lanes are sometimes time-conditional and can change direction. We avoid these. Also, we
+    // expect "hov_type" to be set.
+    if (only_hov_allowed) {
+      only_hov_allowed =
+          !(is(kv, "oneway", "alternating") || is(kv, "oneway", "reversible") ||
+            is(kv, "oneway", "false") || get(kv, "oneway:conditional") != nullptr ||
+            get(kv, "access:conditional") != nullptr);
+    }
+
+    if (only_hov_allowed) {
+      // If we get here we know the way is a true hov-only-lane (not mixed). As a result, none of
+      // the following costings can use it.
+      if (get(kv, "auto_tag") == nullptr) {
+        kv["auto_forward"] = "false";
+        kv["auto_backward"] = "false";
+      }
+      if (get(kv, "truck_tag") == nullptr) {
+        kv["truck_forward"] = "false";
+        kv["truck_backward"] = "false";
+      }
+      if (get(kv, "foot_tag") == nullptr) {
+        kv["pedestrian_forward"] = "false";
+        kv["pedestrian_backward"] = "false";
+      }
+      if (get(kv, "bike_tag") == nullptr) {
+        kv["bike_forward"] = "false";
+        kv["bike_backward"] = "false";
+      }
+    } else {
+      // This is not an hov-only lane.
+      kv["hov_forward"] = "false";
+      kv["hov_backward"] = "false";
+    }
+  }
+
+  kv["tunnel"] = first_of({lookup(kTunnel, get(kv, "tunnel")), "false"});
+  kv["toll"] = first_of({lookup(kToll, get(kv, "toll")), "false"});
+
+  // truck goodies
+  auto maxheight = normalize_measurement(get(kv, "maxheight"));
+  set_number(kv, "maxheight", maxheight ? maxheight
+                                        : normalize_measurement(get(kv, "maxheight:physical")));
+  auto maxwidth = normalize_measurement(get(kv, "maxwidth"));
+  set_number(kv, "maxwidth",
+             maxwidth ? maxwidth : normalize_measurement(get(kv, "maxwidth:physical")));
+  set_number(kv, "maxlength", normalize_measurement(get(kv, "maxlength")));
+  set_number(kv, "maxweight", normalize_weight(get(kv, "maxweight")));
+  set_number(kv, "maxaxleload", normalize_weight(get(kv, "maxaxleload")));
+  set_number(kv, "maxaxles", to_number(get(kv, "maxaxles")));
+
+  // TODO: hazmat really should have subcategories
+  set(kv, "hazmat",
+      first_of({lookup(kHazmat, get(kv, "hazmat")), lookup(kHazmat, get(kv, "hazmat:water")),
+                lookup(kHazmat, get(kv, "hazmat:A")), lookup(kHazmat, get(kv, "hazmat:B")),
+                lookup(kHazmat, get(kv, "hazmat:C")), lookup(kHazmat, get(kv, "hazmat:D")),
+                lookup(kHazmat, get(kv, "hazmat:E"))}));
+  set_number(kv, "maxspeed:hgv", normalize_speed(get(kv, "maxspeed:hgv")));
+
+  if (get(kv, "hgv:national_network") != nullptr || get(kv, "hgv:state_network") != nullptr ||
+      is(kv, "hgv", "local") || is(kv, "hgv", "designated")) {
+    kv["truck_route"] = "true";
+  }
+
+  int bike_mask = 0;
+  if (get(kv, "ncn_ref") != nullptr || is(kv, "ncn", "yes")) {
+    bike_mask = 1;
+  }
+  if (get(kv, "rcn_ref") != nullptr || is(kv, "rcn", "yes")) {
+    bike_mask |= 2;
+  }
+  if (get(kv, "lcn_ref") != nullptr || is(kv, "lcn", "yes")) {
+    bike_mask |= 4;
+  }
+  if (is(kv, "mtb", "yes")) {
+    bike_mask |= 8;
+  }
+  set(kv, "bike_national_ref", get(kv, "ncn_ref"));
+  set(kv, "bike_regional_ref", get(kv, "rcn_ref"));
+  set(kv, "bike_local_ref", get(kv, "lcn_ref"));
+  set_number(kv, "bike_network_mask", bike_mask);
+
+  // turn semicolon into colon due to challenges to store ";" in string
+  auto level = kv.find("level");
+  if (level != kv.end()) {
+    std::replace(level->second.begin(), level->second.end(), ';', ':');
+  }
+
+  // Explicitly turn off access for construction type. It's done for backward compatibility of
+  // valhalla tiles and valhalla routing. In case we allow non-zero access then older versions of
+  // router will work with new tiles incorrectly. They would start to route on roads under
+  // construction because they're not aware about new 'Use::kConstruction' and use only access mode
+  // to check if an edge is routable or not.
+  if (construction) {
+    set_modes(kv, kForward, "false");
+    set_modes(kv, kBackward, "false");
+    kv["hov_forward"] = "false";
+    kv["hov_backward"] = "false";
+    kv["emergency_forward"] = "false";
+    kv["emergency_backward"] = "false";
+  }
+
+  return 0;
+}
+
+void nodes_proc(Tags& kv) {
+  auto iso = kv.find("iso:3166_2");
+  if (iso != kv.end()) {
+    const auto& code = iso->second;
+    auto dash = code.find('-');
+    if (dash == 2) {
+      if (code.size() == 6 || code.size() == 5) {
+        kv["state_iso_code"] = code.substr(3);
+      }
+    } else if (dash == std::string::npos) {
+      if (code.size() == 2 || code.size() == 3) {
+        kv["state_iso_code"] = code;
+      } else if (code.size() == 4 || code.size() == 5) {
+        kv["state_iso_code"] = code.substr(2);
+      }
+    }
+  }
+
+  // normalize a few tags that we care about
+  const char* initial_access = lookup(kAccess, get(kv, "access"));
+  const char* access = initial_access ? initial_access : "true";
+  if (is(kv, "impassable", "yes") ||
+      (is(kv, "access", "private") &&
+       (is(kv, "emergency", "yes") || is(kv, "service", "emergency_access")))) {
+    access = "false";
+  }
+
+  std::optional<int> hov_tag;
+  if ((get(kv, "hov") != nullptr && !is(kv, "hov", "no")) || get(kv, "hov:lanes") != nullptr ||
+      get(kv, "hov:minimum") != nullptr) {
+    hov_tag = 128;
+  }
+
+  auto foot_tag = lookup(kFootNode, get(kv, "foot"));
+  auto wheelchair_tag = lookup(kWheelchairNode, get(kv, "wheelchair"));
+  auto bike_tag = lookup(kBicycleNode, get(kv, "bicycle"));
+  auto truck_tag = lookup(kTruckNode, get(kv, "hgv"));
+  auto auto_tag = lookup(kMotorVehicleNode, get(kv, "motorcar"));
+  auto motor_vehicle_tag = lookup(kMotorVehicleNode, get(kv, "motor_vehicle"));
+  auto moped_tag = lookup(kMopedNode, get(kv, "moped"));
+  if (!moped_tag) {
+    moped_tag = lookup(kMopedNode, get(kv, "mofa"));
+  }
+  auto motorcycle_tag = lookup(kMotorCycleNode, get(kv, "motorcycle"));
+
+  if (!auto_tag) {
+    auto_tag = motor_vehicle_tag;
+  }
+  std::optional<int> bus_tag;
+  std::optional<int> taxi_tag;
+  if (is(kv, "access", "psv")) {
+    bus_tag = 64;
+    taxi_tag = 32;
+  } else {
+    bus_tag = lookup(kBusNode, get(kv, "bus"));
+    taxi_tag = lookup(kTaxiNode, get(kv, "taxi"));
+  }
+
+  if (!bus_tag) {
+    bus_tag = lookup(kPsvBusNode, get(kv, "psv"));
+  }
+  // if bus was not set and car is
+  if (!bus_tag && auto_tag == 1) {
+    bus_tag = 64;
+  }
+  // if wheelchair was not set and foot is
+  if (!wheelchair_tag && foot_tag == 2) {
+    wheelchair_tag = 256;
+  }
+  // if hov was not set and car is
+  if (!hov_tag && auto_tag == 1) {
+    hov_tag = 128;
+  }
+  if (!taxi_tag) {
+    taxi_tag = lookup(kPsvTaxiNode, get(kv, "psv"));
+  }
+  // if taxi was not set and car is
+  if (!taxi_tag && auto_tag == 1) {
+    taxi_tag = 32;
+  }
+  // if truck was not set and car is
+  if (!truck_tag && auto_tag == 1) {
+    truck_tag = 8;
+  }
+
+  // must shut these off if motor_vehicle = 0
+  if (motor_vehicle_tag == 0) {
+    hov_tag = hov_tag.value_or(0);
+    bus_tag = bus_tag.value_or(0);
+    taxi_tag = taxi_tag.value_or(0);
+    truck_tag = truck_tag.value_or(0);
+    moped_tag = moped_tag.value_or(0);
+    motorcycle_tag = motorcycle_tag.value_or(0);
+  }
+
+  std::optional<int> emergency_tag;
+  if (is(kv, "access", "emergency") || is(kv, "emergency", "yes") ||
+      is(kv, "service", "emergency_access")) {
+    emergency_tag = 16;
+  }
+
+  // do not shut off bike access if there is a highway crossing
+  if (bike_tag == 0 && is(kv, "highway", "crossing")) {
+    bike_tag = 4;
+  }
+
+  // if tag exists use it, otherwise access allowed for all modes unless access = false or
+  // kv["hov"] == "designated" or kv["vehicle"] == "no"). if access=private use allowed modes, but
+  // consider private_access tag as true.
+  int auto_mask = auto_tag.value_or(1);
+  int truck = truck_tag.value_or(8);
+  int bus = bus_tag.value_or(64);
+  int taxi = taxi_tag ? *taxi_tag : auto_tag.value_or(32);
+  int foot = foot_tag.value_or(2);
+  int wheelchair = wheelchair_tag.value_or(256);
+  int bike = bike_tag.value_or(4);
+  int emergency = emergency_tag.value_or(16);
+  int hov = hov_tag ? *hov_tag : auto_tag.value_or(128);
+  int moped = moped_tag.value_or(512);
+  int motorcycle = motorcycle_tag.value_or(1024);
+
+  // if access = false use tag if exists, otherwise no access for that mode
+  if (equals(access, "false") || is(kv, "vehicle", "no") || is(kv, "hov", "designated")) {
+    auto_mask = auto_tag.value_or(0);
+    truck = truck_tag.value_or(0);
+    bus = bus_tag.value_or(0);
+    taxi = taxi_tag.value_or(0);
+    // don't change ped if kv["vehicle"] == "no"
+    if (equals(access, "false") || is(kv, "hov", "designated")) {
+      foot = foot_tag.value_or(0);
+    }
+    wheelchair = wheelchair_tag.value_or(0);
+    bike = bike_tag.value_or(0);
+    moped = moped_tag.value_or(0);
+    motorcycle = motorcycle_tag.value_or(0);
+    emergency = emergency_tag.value_or(0);
+    hov = hov_tag.value_or(0);
+  }
+
+  // check for gates, bollards, and sump_busters
+  bool gate = is(kv, "barrier", "gate") || is(kv, "barrier", "yes") ||
+              is(kv, "barrier", "lift_gate") || is(kv, "barrier", "swing_gate");
+  bool bollard = false;
+  bool sump_buster = false;
+  if (!gate) {
+    // if there was a bollard cars can't get through it
+    bollard = is(kv, "barrier", "bollard") || is(kv, "barrier", "block") ||
+              is(kv, "barrier", "jersey_barrier") || is(kv, "bollard", "removable");
+
+    // if sump_buster then no access for auto, hov, and taxi unless a tag exists
+    sump_buster = is(kv, "barrier", "sump_buster");
+
+    // save the following as gates
+    if (bollard && is(kv, "bollard", "rising")) {
+      gate = true;
+      bollard = false;
+    }
+
+    if (bollard && initial_access == nullptr) {
+      // bollard = true shuts off access when access is not originally specified
+      auto_mask = auto_tag.value_or(0);
+      truck = truck_tag.value_or(0);
+      bus = bus_tag.value_or(0);
+      taxi = taxi_tag.value_or(0);
+      foot = foot_tag.value_or(2);
+      wheelchair = wheelchair_tag.value_or(256);
+      bike = bike_tag.value_or(4);
+      moped = moped_tag.value_or(0);
+      motorcycle = motorcycle_tag.value_or(0);
+      emergency = emergency_tag.value_or(0);
+      hov = hov_tag.value_or(0);
+    } else if (sump_buster) {
+      // sump_buster = true shuts off access unless the tag exists
+      auto_mask = auto_tag.value_or(0);
+      truck = truck_tag.value_or(8);
+      bus = bus_tag.value_or(64);
+      taxi = taxi_tag.value_or(0);
+      foot = foot_tag.value_or(2);
+      wheelchair = wheelchair_tag.value_or(256);
+      bike = bike_tag.value_or(4);
+      moped = moped_tag.value_or(512);
+      motorcycle = motorcycle_tag.value_or(1024);
+      emergency = emergency_tag.value_or(16);
+      hov = hov_tag.value_or(0);
+    }
+  }
+
+  // if nothing blocks access at this node assume access is allowed
+  if (!gate && !bollard && !sump_buster && equals(access, "true")) {
+    if (is(kv, "highway", "crossing") || is(kv, "railway", "crossing") ||
+        is(kv, "footway", "crossing") || is(kv, "cycleway", "crossing") ||
+        is(kv, "foot", "crossing") || is(kv, "bicycle", "crossing") ||
+        is(kv, "pedestrian", "crossing") || get(kv, "crossing") != nullptr) {
+      auto_mask = auto_tag.value_or(1);
+      truck = truck_tag.value_or(8);
+      bus = bus_tag.value_or(64);
+      taxi = taxi_tag.value_or(32);
+      foot = foot_tag.value_or(2);
+      wheelchair = wheelchair_tag.value_or(256);
+      bike = bike_tag.value_or(4);
+      moped = moped_tag.value_or(512);
+      motorcycle = motorcycle_tag.value_or(1024);
+      emergency = emergency_tag.value_or(16);
+      hov = hov_tag.value_or(128);
+    }
+  }
+
+  // store the gate and bollard info
+  kv["gate"] = gate ? "true" : "false";
+  kv["bollard"] = bollard ? "true" : "false";
+  kv["sump_buster"] = sump_buster ? "true" : "false";
+
+  if (is(kv, "barrier", "border_control")) {
+    kv["border_control"] = "true";
+  } else if (is(kv, "barrier", "toll_booth")) {
+    kv["toll_booth"] = "true";
+    if (is_cash_only_payment(kv)) {
+      kv["cash_only_toll"] = "true";
+    }
+  } else if (is(kv, "highway", "toll_gantry")) {
+    kv["toll_gantry"] = "true";
+  } else if (is(kv, "entrance", "yes") && is(kv, "indoor", "yes")) {
+    kv["building_entrance"] = "true";
+  } else if (is(kv, "highway", "elevator")) {
+    kv["elevator"] = "true";
+  }
+
+  if (is(kv, "amenity", "bicycle_rental") ||
+      (is(kv, "shop", "bicycle") && is(kv, "service:bicycle:rental", "yes"))) {
+    kv["bicycle_rental"] = "true";
+  }
+
+  bool named = get(kv, "public_transport") == nullptr && get(kv, "name") != nullptr;
+  if (is(kv, "traffic_signals:direction", "forward")) {
+    kv["forward_signal"] = "true";
+    if (named) {
+      kv["junction"] = "named";
+    }
+  }
+  if (is(kv, "traffic_signals:direction", "backward")) {
+    kv["backward_signal"] = "true";
+    if (named) {
+      kv["junction"] = "named";
+    }
+  }
+
+  // stop signs and yield signs only in one direction are stored on the node, without a direction
+  // the highway tag goes unless the sign is tagged on its own as well
+  auto sign = [&kv](const char* highway, const char* forward, const char* backward) {
+    if (!is(kv, "highway", highway)) {
+      return;
+    }
+    if (is(kv, "direction", "both")) {
+      kv[forward] = "true";
+      kv[backward] = "true";
+    } else if (is(kv, "direction", "forward")) {
+      kv[forward] = "true";
+    } else if (is(kv, "direction", "backward") || is(kv, "direction", "reverse")) {
+      kv[backward] = "true";
+    } else if (get(kv, "direction") != nullptr && get(kv, highway) == nullptr) {
+      kv.erase("highway");
+    }
+  };
+  sign("stop", "forward_stop", "backward_stop");
+  sign("give_way", "forward_yield", "backward_yield");
+
+  if (named) {
+    if (is(kv, "highway", "traffic_signals")) {
+      if (!is(kv, "junction", "yes")) {
+        kv["junction"] = "named";
+      }
+    } else if (is(kv, "junction", "yes") || is(kv, "reference_point", "yes")) {
+      kv["junction"] = "named";
+    }
+  }
+
+  kv["private"] = first_of({lookup(kPrivate, get(kv, "access")),
+                            lookup(kPrivate, get(kv, "motor_vehicle")), "false"});
+
+  // store a mask denoting access
+  set_number(kv, "access_mask",
+             auto_mask | emergency | truck | bike | foot | wheelchair | bus | hov | moped |
+                 motorcycle | taxi);
+
+  // if no information about access is given
+  bool tagged_access = initial_access || auto_tag || truck_tag || bus_tag || taxi_tag ||
+                       foot_tag || wheelchair_tag || bike_tag || moped_tag || motorcycle_tag ||
+                       emergency_tag || hov_tag;
+  kv["tagged_access"] = tagged_access ? "1" : "0";
+}
+
+// returns 1 if the relation should be filtered 0 otherwise
+int rels_proc(Tags& kv) {
+  if (is(kv, "type", "connectivity")) {
+    return 0;
+  }
+  if (!is(kv, "type", "route") && !is(kv, "type", "restriction")) {
+    return 1;
+  }
+
+  if (get(kv, "restriction:probable") != nullptr &&
+      (get(kv, "restriction") != nullptr || get(kv, "restriction:conditional") != nullptr)) {
+    kv.erase("restriction:probable");
+  }
+
+  auto restrict = lookup(kRestriction, get(kv, "restriction"));
+  if (!restrict) {
+    auto prefix = restriction_prefix(get(kv, "restriction:conditional"));
+    restrict = lookup(kRestriction, prefix ? prefix->c_str() : nullptr);
+  }
+  if (!restrict) {
+    auto prefix = restriction_prefix(get(kv, "restriction:probable"));
+    restrict = lookup(kRestriction, prefix ? prefix->c_str() : nullptr);
+  }
+
+  const std::array<const char*, 9> typed = {"restriction:hgv",      "restriction:emergency",
+                                            "restriction:taxi",     "restriction:motorcar",
+                                            "restriction:bus",      "restriction:bicycle",
+                                            "restriction:hazmat",   "restriction:motorcycle",
+                                            "restriction:foot"};
+  std::optional<int> restrict_type;
+  for (const auto* key : typed) {
+    if ((restrict_type = lookup(kRestriction, get(kv, key)))) {
+      break;
+    }
+  }
+
+  // restrictions with type win over just restriction key.  people enter both.
+  if (restrict_type) {
+    restrict = restrict_type;
+  }
+
+  if (is(kv, "type", "restriction") || get(kv, "restriction:conditional") != nullptr ||
+      get(kv, "restriction:probable") != nullptr) {
+    if (!restrict) {
+      return 1;
+    }
+
+    for (const auto* key : {"restriction:conditional", "restriction:probable"}) {
+      auto suffix = restriction_suffix(get(kv, key));
+      if (suffix) {
+        kv[key] = std::move(*suffix);
+      } else {
+        kv.erase(key);
+      }
+    }
+    for (const auto* key : typed) {
+      auto value = lookup(kRestriction, get(kv, key));
+      set_number(kv, key, value ? std::optional<double>(*value) : std::nullopt);
+    }
+
+    if (!restrict_type) {
+      set_number(kv, "restriction", *restrict);
+    } else {
+      kv.erase("restriction");
+    }
+    return 0;
+  }
+
+  if (is(kv, "route", "bicycle") || is(kv, "route", "mtb")) {
+    int bike_mask = 0;
+    if (is(kv, "network", "mtb") || is(kv, "route", "mtb")) {
+      bike_mask = 8;
+    }
+    if (is(kv, "network", "ncn")) {
+      bike_mask |= 1;
+    } else if (is(kv, "network", "rcn")) {
+      bike_mask |= 2;
+    } else if (is(kv, "network", "lcn")) {
+      bike_mask |= 4;
+    }
+    set_number(kv, "bike_network_mask", bike_mask);
+
+    kv.erase("day_on");
+    kv.erase("day_off");
+    kv.erase("restriction");
+    return 0;
+  }
+
+  // has a restiction but type is not restriction...ignore
+  if (restrict) {
+    return 1;
+  }
+  kv.erase("day_on");
+  kv.erase("day_off");
+  kv.erase("restriction");
+  return 0;
+}
+
+} // namespace
+
+Tags NativeTagTransform::Transform(OSMType type, uint64_t osmid, const Tags& tags) {
+  // elements without tags are of no interest unless they are nodes
+  if (type == OSMType::kWay && tags.empty()) {
+    return {};
+  }
+
+  Tags kv(tags);
+  try {
+    int filter = 0;
+    if (type == OSMType::kNode) {
+      nodes_proc(kv);
+    } else if (type == OSMType::kWay) {
+      filter = filter_tags_generic(kv);
+    } else {
+      filter = rels_proc(kv);
+    }
+    if (filter) {
+      kv.clear();
+    }
+  } catch (const std::exception& e) {
+    // the lua version drops the element when the script fails on it
+    LOG_ERROR("Failed to transform the tags of osm element " + std::to_string(osmid) + ": " +
+              e.what());
+    kv.clear();
+  }
+  return kv;
+}
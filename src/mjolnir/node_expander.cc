@@ -1,5 +1,7 @@
 #include "mjolnir/node_expander.h"
 
+#include <algorithm>
+
 namespace valhalla {
 namespace mjolnir {
 
@@ -70,5 +72,22 @@ node_bundle collect_node_edges(const sequence<Node>::iterator& node_itr,
   return bundle;
 }
 
+std::vector<size_t> split_node_bundles(sequence<Node>& nodes, size_t count) {
+  std::vector<size_t> starts{0};
+  count = std::max<size_t>(count, 1);
+  for (size_t i = 1; i < count; ++i) {
+    // move forward to the first node of the next bundle, duplicates of a node are next to each
+    // other
+    size_t start = std::max(starts.back(), nodes.size() * i / count);
+    uint64_t osmid = start > 0 && start < nodes.size() ? (*nodes[start - 1]).node.osmid_ : 0;
+    while (start > 0 && start < nodes.size() && (*nodes[start]).node.osmid_ == osmid) {
+      ++start;
+    }
+    starts.push_back(start);
+  }
+  starts.push_back(nodes.size());
+  return starts;
+}
+
 } // namespace mjolnir
 } // namespace valhalla
@@ -27,7 +27,11 @@
 
 // This is largely based off of: https://github.com/CanalTP/libosmpbfreader
 // there have been some minor changes for our own purposes but its largely the same
+#include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
 #ifdef _MSC_VER
 #include <winsock2.h> // ntohl
 #else
@@ -81,9 +85,7 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
+std::string read_blob(std::ifstream& file, const BlobHeader& header) {
   // is the size of the following blob sane
   int32_t sz = header.datasize();
   if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
@@ -91,31 +93,41 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   }
 
   // pull out the bytes
-  if (!file.read(buffer, sz)) {
+  std::string bytes(sz, '\0');
+  if (!file.read(&bytes[0], sz)) {
     throw std::runtime_error("unable to read blob from file");
   }
+  return bytes;
+}
 
+int32_t unpack_blob(const std::string& bytes, std::string& unpack_buffer) {
   // turn it into a protobuf object
-  if (!blob.ParseFromArray(buffer, sz)) {
+  Blob blob;
+  if (!blob.ParseFromString(bytes)) {
     throw std::runtime_error("unable to parse blob");
   }
 
   // if the blob was uncompressed
   if (blob.has_raw()) {
     // check that raw_size is set correctly and move it to the final buffer
-    sz = blob.raw().size();
+    int32_t sz = blob.raw().size();
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    unpack_buffer = std::move(*blob.mutable_raw());
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
-    sz = blob.zlib_data().size();
+    if (blob.raw_size() > MAX_UNCOMPRESSED_BLOB_SIZE) {
+      throw std::runtime_error("uncompressed blob-size is bigger than allowed");
+    }
+    if (unpack_buffer.size() < static_cast<size_t>(blob.raw_size())) {
+      unpack_buffer.resize(blob.raw_size());
+    }
     z_stream z;
     z.next_in = (unsigned char*)blob.zlib_data().c_str();
-    z.avail_in = sz;
-    z.next_out = (unsigned char*)unpack_buffer;
+    z.avail_in = blob.zlib_data().size();
+    z.next_out = (unsigned char*)&unpack_buffer[0];
     z.avail_out = blob.raw_size();
     z.zalloc = Z_NULL;
     z.zfree = Z_NULL;
@@ -151,16 +163,20 @@ template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::Primitiv
   return result;
 }
 
-void parse_primitive_block(char* unpack_buffer,
-                           int32_t sz,
-                           const Interest interest,
-                           Callback& callback) {
-  // turn the blob bytes into a protobuf object
-  PrimitiveBlock primblock;
-  if (!primblock.ParseFromArray(unpack_buffer, sz)) {
+std::unique_ptr<PrimitiveBlock> decode_primitive_block(const std::string& bytes) {
+  // inflate the blob and turn its bytes into a protobuf object
+  std::string unpack_buffer;
+  int32_t sz = unpack_blob(bytes, unpack_buffer);
+  auto primblock = std::make_unique<PrimitiveBlock>();
+  if (!primblock->ParseFromArray(unpack_buffer.data(), sz)) {
     throw std::runtime_error("unable to parse primitive block");
   }
+  return primblock;
+}
 
+void parse_primitive_block(const PrimitiveBlock& primblock,
+                           const Interest interest,
+                           Callback& callback) {
   // for each primitive group
   for (const auto& primitive_group : primblock.primitivegroup()) {
 
@@ -262,10 +278,12 @@ void parse_primitive_block(char* unpack_buffer,
   }
 }
 
-void parse_header_block(char* unpack_buffer, int32_t sz) {
+void parse_header_block(const std::string& bytes) {
   // turn the blob bytes into a protobuf object
+  std::string unpack_buffer;
+  int32_t sz = unpack_blob(bytes, unpack_buffer);
   HeaderBlock header_block;
-  if (!header_block.ParseFromArray(unpack_buffer, sz)) {
+  if (!header_block.ParseFromArray(unpack_buffer.data(), sz)) {
     throw std::runtime_error("unable to parse header block");
   }
 
@@ -285,38 +303,65 @@ Member::Member(Member&& other)
     : member_type(other.member_type), member_id(other.member_id), role(std::move(other.role)) {
 }
 
-void Parser::parse(std::ifstream& file, const Interest interest, Callback& callback) {
-  char* buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-  char* unpack_buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
+void Parser::parse(std::ifstream& file,
+                   const Interest interest,
+                   Callback& callback,
+                   unsigned int threads) {
+  // we never decode more than this many blocks ahead of the callback
+  threads = std::max(threads, 1u);
+  const size_t max_in_flight = threads * 2;
+  std::deque<std::future<std::unique_ptr<PrimitiveBlock>>> in_flight;
+
+  // the callbacks have to see the blocks in file order, so we only hand them over from the front
+  auto dispatch_front = [&]() {
+    auto primblock = in_flight.front().get();
+    in_flight.pop_front();
+    parse_primitive_block(*primblock, interest, callback);
+  };
 
   // start from the top
   file.clear();
   file.seekg(0, std::ios::beg);
 
-  // while there is more to read
+  // reading the file is sequential but inflating and decoding the blocks is done in the background
+  // while the callback is busy with the blocks that came before
+  std::string header_buffer(MAX_BLOB_HEADER_SIZE, '\0');
   while (!file.eof()) {
     // grab the blob header
     bool finished = false;
-    BlobHeader header = read_header(buffer, file, finished);
+    BlobHeader header = read_header(&header_buffer[0], file, finished);
     // if we didnt hit the end
     if (!finished) {
       // grab the blob that goes with the blob header
-      int32_t sz = read_blob(buffer, unpack_buffer, file, header);
+      std::string bytes = read_blob(file, header);
       // if its data parse it
       if (header.type() == "OSMData") {
-        parse_primitive_block(unpack_buffer, sz, interest, callback);
+        // single threaded we just do it inline
+        if (threads == 1) {
+          parse_primitive_block(*decode_primitive_block(bytes), interest, callback);
+          continue;
+        }
+        // make room and then decode it in the background
+        if (in_flight.size() >= max_in_flight) {
+          dispatch_front();
+        }
+        in_flight.emplace_back(
+            std::async(std::launch::async, [bytes = std::move(bytes)]() {
+              return decode_primitive_block(bytes);
+            }));
         // if its something other than a header
       } else if (header.type() == "OSMHeader") {
-        parse_header_block(unpack_buffer, sz);
+        parse_header_block(bytes);
       } else {
         LOG_WARN("Unknown blob type: " + header.type());
       }
     }
   }
 
-  // done with protobuf and buffers
-  delete[] buffer;
-  delete[] unpack_buffer;
+  // hand over whatever is left
+  while (!in_flight.empty()) {
+    dispatch_front();
+  }
 }
 
 void Parser::free() {
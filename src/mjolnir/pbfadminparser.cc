@@ -18,11 +18,6 @@ using namespace valhalla::baldr;
 using namespace valhalla::mjolnir;
 
 namespace {
-// This value controls the initial size of the Id table. If this is exceeded
-// the table will be resized. We should keep this number just higher than
-// reality to maintain performance
-constexpr uint64_t kMaxOSMNodesHint = 1300000000;
-
 struct admin_callback : public OSMPBF::Callback {
 public:
   admin_callback() = delete;
@@ -32,8 +27,8 @@ public:
   // Construct PBFAdminParser based on properties file and input PBF extract
   admin_callback(const boost::property_tree::ptree& pt, OSMAdminData& osmdata)
       : lua_(std::string(lua_admin_lua, lua_admin_lua + lua_admin_lua_len)),
-        shape_(pt.get<unsigned long>("id_table_size", kMaxOSMNodesHint)),
-        members_(pt.get<unsigned long>("id_table_size", kMaxOSMNodesHint)), osm_admin_data_(osmdata) {
+        shape_(pt.get<uint64_t>("id_table_size", 0)),
+        members_(pt.get<uint64_t>("id_table_size", 0)), osm_admin_data_(osmdata) {
   }
 
   virtual void
@@ -124,8 +119,7 @@ public:
   // Lua Tag Transformation class
   LuaTagTransform lua_;
 
-  // Mark the OSM Ids used by the ways and relations
-  // TODO: just use robin_hood::unordered_set<uint64_t> since these are probably relatively small
+  // Mark the OSM Ids used by the ways and relations, they only take memory for the ids marked
   UnorderedIdTable shape_, members_;
 
   // Pointer to all the OSM data (for use by callbacks)
@@ -1,4 +1,5 @@
 #include <future>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <utility>
@@ -19,6 +20,7 @@
 #include "midgard/sequence.h"
 #include "midgard/tiles.h"
 #include "mjolnir/luatagtransform.h"
+#include "mjolnir/nativetagtransform.h"
 #include "mjolnir/osmaccess.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/osmpronunciation.h"
@@ -149,7 +151,7 @@ public:
   }
 
   graph_callback(const boost::property_tree::ptree& pt, OSMData& osmdata)
-      : lua_(get_lua(pt)), osmdata_(osmdata) {
+      : tag_transform_(get_tag_transform(pt)), osmdata_(osmdata) {
     current_way_node_index_ = last_node_ = last_way_ = last_relation_ = 0;
 
     highway_cutoff_rc_ = RoadClass::kPrimary;
@@ -171,9 +173,9 @@ public:
     use_rest_area_ = pt.get<bool>("data_processing.use_rest_area", false);
     use_admin_db_ = pt.get<bool>("data_processing.use_admin_db", true);
 
-    empty_node_results_ = lua_.Transform(OSMType::kNode, 0, {});
-    empty_way_results_ = lua_.Transform(OSMType::kWay, 0, {});
-    empty_relation_results_ = lua_.Transform(OSMType::kRelation, 0, {});
+    empty_node_results_ = tag_transform_->Transform(OSMType::kNode, 0, {});
+    empty_way_results_ = tag_transform_->Transform(OSMType::kWay, 0, {});
+    empty_relation_results_ = tag_transform_->Transform(OSMType::kRelation, 0, {});
 
     tag_handlers_["driving_side"] = [this]() {
       if (!use_admin_db_) {
@@ -1425,6 +1427,21 @@ public:
     return std::string(lua_graph_lua, lua_graph_lua + lua_graph_lua_len);
   }
 
+  static std::unique_ptr<TagTransform> get_tag_transform(const boost::property_tree::ptree& pt) {
+    auto tag_transform = pt.get<std::string>("tag_transform", "lua");
+    if (tag_transform == "native") {
+      // the native one is the default script, custom ones need lua
+      if (pt.get_optional<std::string>("graph_lua_name")) {
+        throw std::runtime_error("graph_lua_name requires the lua tag_transform");
+      }
+      return std::make_unique<NativeTagTransform>();
+    }
+    if (tag_transform != "lua") {
+      throw std::runtime_error("Unknown tag_transform: " + tag_transform);
+    }
+    return std::make_unique<LuaTagTransform>(get_lua(pt));
+  }
+
   virtual void node_callback(const uint64_t osmid,
                              const double lng,
                              const double lat,
@@ -1440,7 +1457,7 @@ public:
     if (bss_nodes_) {
       // Get tags - do't bother with Lua callout if the taglist is empty
       if (tags.size() > 0) {
-        results = lua_.Transform(OSMType::kNode, osmid, tags);
+        results = tag_transform_->Transform(OSMType::kNode, osmid, tags);
       } else {
         results = empty_node_results_;
       }
@@ -1510,7 +1527,7 @@ public:
     // Get tags if not already available.  Don't bother calling Lua if there
     // are no OSM tags to process.
     if (tags.size() > 0) {
-      results = results ? results : lua_.Transform(OSMType::kNode, osmid, tags);
+      results = results ? results : tag_transform_->Transform(OSMType::kNode, osmid, tags);
     } else {
       results = results ? results : empty_node_results_;
     }
@@ -1713,8 +1730,8 @@ public:
 
     // Transform tags. If no results that means the way does not have tags
     // suitable for use in routing.
-    Tags results =
-        tags.size() == 0 ? empty_way_results_ : lua_.Transform(OSMType::kWay, osmid_, tags);
+    Tags results = tags.size() == 0 ? empty_way_results_
+                                    : tag_transform_->Transform(OSMType::kWay, osmid_, tags);
     if (results.size() == 0) {
       return;
     }
@@ -2212,8 +2229,8 @@ public:
     last_relation_ = osmid;
 
     // Get tags
-    Tags results =
-        tags.empty() ? empty_relation_results_ : lua_.Transform(OSMType::kRelation, osmid, tags);
+    Tags results = tags.empty() ? empty_relation_results_
+                                : tag_transform_->Transform(OSMType::kRelation, osmid, tags);
     if (results.size() == 0) {
       return;
     }
@@ -2995,8 +3012,8 @@ public:
   // Road class assignment needs to be set to the highway cutoff for ferries and auto trains.
   RoadClass highway_cutoff_rc_;
 
-  // Lua Tag Transformation class
-  LuaTagTransform lua_;
+  // Turns the osm tags into the ones we parse, one per callback as lua states cant be shared
+  std::unique_ptr<TagTransform> tag_transform_;
 
   // Pointer to all the OSM data (for use by callbacks)
   OSMData& osmdata_;
@@ -3042,12 +3059,13 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
                                   const std::string& way_nodes_file,
                                   const std::string& access_file,
                                   const std::string& pronunciation_file) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the callbacks need to see the elements in file order (way indices, sorted node ids) so they
+  // stay on this thread, the blocks are inflated and decoded in parallel ahead of them though
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // how much memory the sorts of the intermediate files may use across those threads
+  size_t sort_memory = pt.get<size_t>("sort_memory", 1024 * 1024 * 512);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   OSMData osmdata{};
@@ -3078,7 +3096,7 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
 
   // Clarifies types of loop roads and saves fixed ways.
@@ -3092,7 +3110,8 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm access tags by way id...");
   {
     sequence<OSMAccess> access(access_file, false);
-    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
+    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); },
+                sort_memory, threads);
   }
 
   // we need to sort the pronunciation indexes so that we can easily find them.
@@ -3100,9 +3119,13 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   {
     sequence<OSMPronunciation> pronunciation(pronunciation_file, false);
     pronunciation.sort(
-        [](const OSMPronunciation& a, const OSMPronunciation& b) { return a.way_id() < b.way_id(); });
+        [](const OSMPronunciation& a, const OSMPronunciation& b) { return a.way_id() < b.way_id(); },
+        sort_memory, threads);
   }
 
+  // the access restrictions are looked up by way id from here on
+  osmdata.sort();
+
   LOG_INFO("Finished");
 
   // Return OSM data
@@ -3115,12 +3138,13 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
                                     const std::string& complex_restriction_from_file,
                                     const std::string& complex_restriction_to_file,
                                     OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the callbacks need to see the elements in file order (way indices, sorted node ids) so they
+  // stay on this thread, the blocks are inflated and decoded in parallel ahead of them though
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // how much memory the sorts of the intermediate files may use across those threads
+  size_t sort_memory = pt.get<size_t>("sort_memory", 1024 * 1024 * 512);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -3153,8 +3177,10 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
+  // the relation data is looked up by way id from here on
+  osmdata.sort();
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) + " simple restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
            " lane connections");
@@ -3166,7 +3192,8 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   {
     sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
     complex_restrictions_from.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; }, sort_memory,
+        threads);
   }
 
   // Sort complex restrictions. Keep this scoped so the file handles are closed when done sorting.
@@ -3174,7 +3201,8 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   {
     sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
     complex_restrictions_to.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; }, sort_memory,
+        threads);
   }
   LOG_INFO("Finished");
 }
@@ -3184,12 +3212,13 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
                                 const std::string& way_nodes_file,
                                 const std::string& bss_nodes_file,
                                 OSMData& osmdata) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
-  //  unsigned int threads =
-  //      std::max(static_cast<unsigned int>(1),
-  //               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // the callbacks need to see the elements in file order (way indices, sorted node ids) so they
+  // stay on this thread, the blocks are inflated and decoded in parallel ahead of them though
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  // how much memory the sorts of the intermediate files may use across those threads
+  size_t sort_memory = pt.get<size_t>("sort_memory", 1024 * 1024 * 512);
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   graph_callback callback(pt, osmdata);
@@ -3221,7 +3250,7 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
       callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
                      new sequence<OSMNode>(bss_nodes_file, create));
       OSMPBF::Parser::parse(file_handle, static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES),
-                            callback);
+                            callback, threads);
       create = false;
     }
     // Since the sequence must be flushed before reading it...
@@ -3238,7 +3267,8 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
     way_nodes.sort(
-        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; });
+        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; },
+        sort_memory, threads);
   }
 
   // Parse node in all the input files. Skip any that are not marked from
@@ -3255,7 +3285,7 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   uint64_t max_osm_id = callback.last_node_;
   callback.reset(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
@@ -3267,13 +3297,15 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by way index and node shape index...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
-      if (a.way_index == b.way_index) {
-        // TODO: if its equal we have screwed something up, should we check and throw here?
-        return a.way_shape_node_index < b.way_shape_node_index;
-      }
-      return a.way_index < b.way_index;
-    });
+    way_nodes.sort(
+        [](const OSMWayNode& a, const OSMWayNode& b) {
+          if (a.way_index == b.way_index) {
+            // TODO: if its equal we have screwed something up, should we check and throw here?
+            return a.way_shape_node_index < b.way_shape_node_index;
+          }
+          return a.way_index < b.way_index;
+        },
+        sort_memory, threads);
   }
 
   // Some OSM extracts do not have changeset Ids. For these set the max changeset Id
@@ -0,0 +1,176 @@
+#include "mjolnir/reachbuilder.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphconstants.h"
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "loki/reach.h"
+#include "midgard/logging.h"
+#include "mjolnir/graphtilebuilder.h"
+#include "proto_conversions.h"
+#include "sif/costfactory.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// the modes whose default costings get their reach stored
+const std::vector<std::pair<valhalla::Costing::Type, uint32_t>> kReachModes = {
+    {valhalla::Costing::auto_, kAutoAccess},
+    {valhalla::Costing::pedestrian, kPedestrianAccess},
+    {valhalla::Costing::bicycle, kBicycleAccess},
+};
+
+using results_t = std::unordered_map<GraphId, std::vector<DirectedEdgeExt>>;
+
+/**
+ * Computes the reach of all the edges of the tiles in the queue. Each thread pulls a tile off of
+ * the queue. Nothing is written here because the expansions read the neighbouring tiles.
+ */
+void compute_reach(const boost::property_tree::ptree& pt,
+                   uint32_t reach_limit,
+                   std::deque<GraphId>& tilequeue,
+                   std::mutex& lock,
+                   results_t& results,
+                   std::promise<uint32_t>& result) {
+  // Local Graphreader
+  GraphReader graphreader(pt.get_child("mjolnir"));
+
+  // default costings, parsed the same way requests without costing options are
+  rapidjson::Document doc;
+  doc.SetObject();
+  valhalla::sif::CostFactory factory;
+  std::vector<std::pair<valhalla::sif::cost_ptr_t, uint32_t>> costings;
+  for (const auto& mode : kReachModes) {
+    valhalla::Costing costing;
+    valhalla::sif::ParseCosting(doc, "/costing_options/" + valhalla::Costing_Enum_Name(mode.first),
+                                &costing, mode.first);
+    costings.emplace_back(factory.Create(costing), mode.second);
+  }
+
+  valhalla::loki::Reach reach_finder;
+  uint32_t edge_count = 0;
+  while (true) {
+    // Get the next tile Id
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    GraphId tile_id = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    auto tile = graphreader.GetGraphTile(tile_id);
+    if (!tile) {
+      continue;
+    }
+
+    // keep whatever extended attributes the tile already has
+    const auto count = tile->header()->directededgecount();
+    std::vector<DirectedEdgeExt> exts;
+    if (tile->header()->has_ext_directededge()) {
+      auto existing = tile->GetDirectedEdgeExts();
+      exts.assign(existing.begin(), existing.end());
+    } else {
+      exts.resize(count);
+    }
+
+    // find the reach of each edge for each mode
+    GraphId edge_id = tile_id;
+    for (uint32_t i = 0; i < count; ++i, ++edge_id) {
+      const auto* edge = tile->directededge(i);
+      auto& ext = exts[i];
+      ext.set_reach_limit(reach_limit);
+      for (const auto& costing : costings) {
+        auto reach = reach_finder(edge, edge_id, reach_limit, graphreader, costing.first);
+        ext.set_reach(costing.second, reach.outbound, reach.inbound);
+      }
+    }
+    edge_count += count;
+
+    lock.lock();
+    results.emplace(tile_id, std::move(exts));
+    lock.unlock();
+
+    // the expansions wander so dont let the cache grow without bound
+    if (graphreader.OverCommitted()) {
+      graphreader.Trim();
+    }
+  }
+  result.set_value(edge_count);
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void ReachBuilder::Build(const boost::property_tree::ptree& pt) {
+  uint32_t reach_limit = std::min(pt.get<uint32_t>("mjolnir.reach_limit", 0),
+                                  DirectedEdgeExt::kMaxStoredReach);
+  if (reach_limit == 0) {
+    LOG_INFO("Skipping reach builder");
+    return;
+  }
+
+  // Create a randomized queue of tiles (at all levels) to work from
+  std::deque<GraphId> tilequeue;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    for (const auto& id : reader.GetTileSet()) {
+      tilequeue.emplace_back(id);
+    }
+  }
+  std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(3));
+
+  std::uint32_t nthreads =
+      std::max(static_cast<std::uint32_t>(1),
+               pt.get<std::uint32_t>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+  LOG_INFO("Computing reach up to " + std::to_string(reach_limit) + " for " +
+           std::to_string(tilequeue.size()) + " tiles with " + std::to_string(nthreads) +
+           " threads...");
+
+  // compute everything first since the expansions need to read the tiles we are changing
+  results_t results;
+  std::mutex lock;
+  std::vector<std::shared_ptr<std::thread>> threads(nthreads);
+  std::list<std::promise<uint32_t>> promises;
+  for (auto& thread : threads) {
+    promises.emplace_back();
+    thread.reset(new std::thread(compute_reach, std::cref(pt), reach_limit, std::ref(tilequeue),
+                                 std::ref(lock), std::ref(results), std::ref(promises.back())));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  uint32_t edge_count = 0;
+  for (auto& promise : promises) {
+    edge_count += promise.get_future().get();
+  }
+
+  // then write it all out
+  const auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  for (auto& result : results) {
+    GraphTileBuilder tilebuilder(tile_dir, result.first, false);
+    auto nodes = tilebuilder.GetNodes();
+    auto edges = tilebuilder.GetDirectedEdges();
+    tilebuilder.Update(std::vector<NodeInfo>(nodes.begin(), nodes.end()),
+                       std::vector<DirectedEdge>(edges.begin(), edges.end()), result.second);
+  }
+
+  LOG_INFO("Finished storing reach of " + std::to_string(edge_count) + " edges");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
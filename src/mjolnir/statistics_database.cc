@@ -35,8 +35,9 @@ void statistics::build_db() {
 
   LOG_INFO("Writing statistics database");
 
-  // Turn on foreign keys
-  std::string sql = "PRAGMA foreign_keys = ON";
+  // Turn on foreign keys. The database is made from scratch every time so there is nothing for a
+  // rollback journal or syncing to protect
+  std::string sql = "PRAGMA foreign_keys = ON; PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF";
   ret = sqlite3_exec(db_handle, sql.c_str(), NULL, NULL, &err_msg);
   if (ret != SQLITE_OK) {
     LOG_ERROR("Error: " + std::string(err_msg));
@@ -76,15 +77,6 @@ void statistics::build_db() {
     return;
   }
 
-  sql = "VACUUM";
-  ret = sqlite3_exec(db_handle, sql.c_str(), NULL, NULL, &err_msg);
-  if (ret != SQLITE_OK) {
-    LOG_ERROR("Error: " + std::string(err_msg));
-    sqlite3_free(err_msg);
-    sqlite3_close(db_handle);
-    return;
-  }
-
   sql = "ANALYZE";
   ret = sqlite3_exec(db_handle, sql.c_str(), NULL, NULL, &err_msg);
   if (ret != SQLITE_OK) {
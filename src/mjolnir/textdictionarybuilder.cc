@@ -0,0 +1,191 @@
+#include "mjolnir/textdictionarybuilder.h"
+
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/textdictionary.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "mjolnir/graphtilebuilder.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// default limit on the size of the dictionary
+constexpr size_t kDefaultMaxDictionarySize = 4 * 1024 * 1024;
+
+using text_counts_t = std::unordered_map<std::string, uint32_t>;
+
+/**
+ * Counts in how many tiles each string is. Each thread pulls a tile off of the queue.
+ */
+void count_text(const boost::property_tree::ptree& pt,
+                std::deque<GraphId>& tilequeue,
+                std::mutex& lock,
+                text_counts_t& counts) {
+  GraphReader graphreader(pt);
+  text_counts_t local_counts;
+  while (true) {
+    GraphId tile_id;
+    {
+      std::lock_guard<std::mutex> l(lock);
+      if (tilequeue.empty()) {
+        break;
+      }
+      tile_id = tilequeue.front();
+      tilequeue.pop_front();
+    }
+
+    // the same string is only in the text list of a tile once
+    auto tile = graphreader.GetGraphTile(tile_id);
+    const auto textlist = tile->textlist();
+    std::unordered_set<std::string> tile_text;
+    for (auto text = textlist.begin(); text < textlist.end();) {
+      std::string entry(text, std::find(text, textlist.end(), '\0'));
+      text += entry.size() + 1;
+      if (!entry.empty()) {
+        tile_text.emplace(std::move(entry));
+      }
+    }
+    for (auto& text : tile_text) {
+      ++local_counts[text];
+    }
+
+    if (graphreader.OverCommitted()) {
+      graphreader.Trim();
+    }
+  }
+
+  std::lock_guard<std::mutex> l(lock);
+  for (const auto& count : local_counts) {
+    counts[count.first] += count.second;
+  }
+}
+
+/**
+ * Stores the tiles again so that they leave out the text in the dictionary.
+ */
+void share_text(const std::string& tile_dir,
+                const std::shared_ptr<const TextDictionary>& dictionary,
+                std::deque<GraphId>& tilequeue,
+                std::mutex& lock) {
+  while (true) {
+    GraphId tile_id;
+    {
+      std::lock_guard<std::mutex> l(lock);
+      if (tilequeue.empty()) {
+        break;
+      }
+      tile_id = tilequeue.front();
+      tilequeue.pop_front();
+    }
+    GraphTileBuilder tilebuilder(tile_dir, tile_id, true);
+    tilebuilder.set_text_dictionary(dictionary);
+    tilebuilder.StoreTileData();
+  }
+}
+
+/**
+ * The text in more than one tile, the text that saves the most bytes first, up to the max size.
+ */
+std::vector<char> select_text(const text_counts_t& counts, size_t max_size) {
+  std::vector<std::pair<const std::string*, uint64_t>> shared;
+  for (const auto& count : counts) {
+    if (count.second > 1) {
+      shared.emplace_back(&count.first,
+                          static_cast<uint64_t>(count.second - 1) * (count.first.size() + 1));
+    }
+  }
+  std::sort(shared.begin(), shared.end(), [](const auto& a, const auto& b) {
+    return a.second != b.second ? a.second > b.second : *a.first < *b.first;
+  });
+
+  // offset 0 is the empty string like it is in the text list of a tile
+  std::vector<char> text(1, '\0');
+  for (const auto& entry : shared) {
+    if (text.size() + entry.first->size() + 1 > max_size) {
+      continue;
+    }
+    text.insert(text.end(), entry.first->begin(), entry.first->end());
+    text.push_back('\0');
+  }
+  return text;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void TextDictionaryBuilder::Build(const boost::property_tree::ptree& pt) {
+  const auto file_name = pt.get<std::string>("mjolnir.text_dictionary", "");
+  if (file_name.empty()) {
+    return;
+  }
+
+  std::deque<GraphId> tiles;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    for (const auto& id : reader.GetTileSet()) {
+      tiles.emplace_back(id);
+    }
+  }
+  std::uint32_t nthreads =
+      std::max(static_cast<std::uint32_t>(1),
+               pt.get<std::uint32_t>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+
+  // reuse the dictionary other extracts were built with so their tiles can be read together
+  std::shared_ptr<const TextDictionary> dictionary;
+  if (filesystem::exists(file_name)) {
+    dictionary = TextDictionary::Load(file_name);
+    LOG_INFO("Using the text dictionary " + file_name);
+  } else {
+    LOG_INFO("Counting the text of " + std::to_string(tiles.size()) + " tiles with " +
+             std::to_string(nthreads) + " threads...");
+    const auto& mjolnir = pt.get_child("mjolnir");
+    auto queue = tiles;
+    text_counts_t counts;
+    std::mutex lock;
+    std::list<std::thread> threads;
+    for (std::uint32_t i = 0; i < nthreads; ++i) {
+      threads.emplace_back(count_text, std::cref(mjolnir), std::ref(queue), std::ref(lock),
+                           std::ref(counts));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    const auto max_size =
+        pt.get<size_t>("mjolnir.text_dictionary_max_size", kDefaultMaxDictionarySize);
+    dictionary = std::make_shared<const TextDictionary>(select_text(counts, max_size));
+    dictionary->Store(file_name);
+    LOG_INFO("Wrote the text dictionary " + file_name + " of " +
+             std::to_string(dictionary->size()) + " bytes");
+  }
+
+  // store the tiles again without the text in the dictionary, reading them needs it registered
+  TextDictionary::Register(dictionary);
+  const auto tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  std::mutex lock;
+  std::list<std::thread> threads;
+  for (std::uint32_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back(share_text, std::cref(tile_dir), std::cref(dictionary), std::ref(tiles),
+                         std::ref(lock));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  LOG_INFO("Finished sharing the text of the tiles through the text dictionary");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
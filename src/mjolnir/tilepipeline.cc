@@ -0,0 +1,65 @@
+#include "mjolnir/tilepipeline.h"
+
+#include <utility>
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace mjolnir {
+
+TilePipeline::TilePipeline(std::unordered_set<GraphId> tiles)
+    : pending_(std::move(tiles)), closed_(false) {
+}
+
+void TilePipeline::Done(const GraphId& tile_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_.erase(tile_id)) {
+      return;
+    }
+    done_.push_back(tile_id);
+  }
+  changed_.notify_all();
+}
+
+void TilePipeline::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  changed_.notify_all();
+}
+
+void TilePipeline::Wait(const GraphId& tile_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this, &tile_id]() { return closed_ || !pending_.count(tile_id); });
+}
+
+bool TilePipeline::Next(GraphId& tile_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this]() { return closed_ || !done_.empty(); });
+  if (done_.empty()) {
+    return false;
+  }
+  tile_id = done_.front();
+  done_.pop_front();
+  return true;
+}
+
+PipelineGraphReader::PipelineGraphReader(const boost::property_tree::ptree& pt,
+                                         TilePipeline& pipeline)
+    : GraphReader(pt), pipeline_(pipeline) {
+}
+
+bool PipelineGraphReader::DoesTileExist(const GraphId& graphid) const {
+  pipeline_.Wait(graphid.Tile_Base());
+  return GraphReader::DoesTileExist(graphid);
+}
+
+graph_tile_ptr PipelineGraphReader::GetGraphTile(const GraphId& graphid) {
+  pipeline_.Wait(graphid.Tile_Base());
+  return GraphReader::GetGraphTile(graphid);
+}
+
+} // namespace mjolnir
+} // namespace valhalla
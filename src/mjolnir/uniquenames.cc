@@ -0,0 +1,209 @@
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "midgard/logging.h"
+#include "mjolnir/uniquenames.h"
+
+namespace {
+
+constexpr uint64_t kEmptySlot = std::numeric_limits<uint64_t>::max();
+constexpr size_t kInitialSlots = 64;
+
+// count of names, count of slots and bytes of names before the offsets, slots and names
+constexpr size_t kHeaderSize = 3 * sizeof(uint64_t);
+
+// fnv-1a with a final mix so that the upper bits are as good as the lower
+uint32_t hash(const std::string& name) {
+  uint64_t h = 14695981039346656037ull;
+  for (const auto c : name) {
+    h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return static_cast<uint32_t>(h >> 32);
+}
+
+// slots keep the hash above the index so the table can grow without touching the names
+inline uint64_t slot(const uint32_t hash, const uint32_t index) {
+  return (static_cast<uint64_t>(hash) << 32) | index;
+}
+
+inline uint32_t slot_hash(const uint64_t slot) {
+  return static_cast<uint32_t>(slot >> 32);
+}
+
+inline uint32_t slot_index(const uint64_t slot) {
+  return static_cast<uint32_t>(slot);
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+uint32_t UniqueNames::index(const std::string& name) {
+  // Find the name in the table. If it is there return the index.
+  const auto h = hash(name);
+  auto i = find(name, h);
+  if (slots_[i] != kEmptySlot) {
+    return slot_index(slots_[i]);
+  }
+
+  // Not in the table, append the name and take the empty slot
+  uint32_t index = Size() + 1;
+  names_.insert(names_.end(), name.begin(), name.end());
+  offsets_.push_back(names_.size());
+  slots_[i] = slot(h, index);
+  if ((index + 1) * 2 > slots_.size()) {
+    grow();
+  }
+  return index;
+}
+
+std::string UniqueNames::name(const uint32_t index) const {
+  auto v = view(index <= Size() ? index : 0);
+  return std::string(v.first, v.second);
+}
+
+void UniqueNames::Clear() {
+  mapped_.reset();
+  mapped_count_ = 0;
+  mapped_offsets_ = nullptr;
+  mapped_names_ = nullptr;
+  names_.clear();
+  offsets_.assign(1, 0);
+  slots_.assign(kInitialSlots, kEmptySlot);
+
+  // Insert dummy so index 0 is never used
+  index("");
+}
+
+bool UniqueNames::Write(const std::string& file_name) {
+  // Writing over the mapped file would pull the names out from under us
+  if (mapped_ && mapped_->name() == file_name) {
+    unmap();
+  }
+
+  std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open output file: " + file_name);
+    return false;
+  }
+
+  // The mapped names come first, the offsets of the ones in memory continue from them
+  const uint64_t mapped_size = mapped_count_ ? mapped_offsets_[mapped_count_] : 0;
+  const uint64_t header[] = {Size() + 1, slots_.size(), mapped_size + names_.size()};
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(mapped_offsets_), mapped_count_ * sizeof(uint64_t));
+  std::vector<uint64_t> offsets(offsets_);
+  for (auto& offset : offsets) {
+    offset += mapped_size;
+  }
+  file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  file.write(reinterpret_cast<const char*>(slots_.data()), slots_.size() * sizeof(uint64_t));
+  file.write(mapped_names_, mapped_size);
+  file.write(names_.data(), names_.size());
+  return !file.fail();
+}
+
+bool UniqueNames::Read(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open input file: " + file_name);
+    return false;
+  }
+  const uint64_t size = file.tellg();
+  file.close();
+
+  // Check that the sizes in the header add up to the file before using any of it
+  auto mapped = std::make_shared<midgard::mem_map<char>>();
+  uint64_t header[3] = {};
+  if (size >= kHeaderSize) {
+    mapped->map_readonly(file_name, size);
+    std::memcpy(header, mapped->get(), kHeaderSize);
+  }
+  const auto count = header[0], slot_count = header[1], names_size = header[2];
+  if (count == 0 || count > std::numeric_limits<uint32_t>::max() || slot_count < count ||
+      (slot_count & (slot_count - 1)) != 0 ||
+      size != kHeaderSize + (count + 1 + slot_count) * sizeof(uint64_t) + names_size) {
+    LOG_ERROR("Invalid unique names file: " + file_name);
+    return false;
+  }
+
+  // The names and offsets stay in the file, only the table is copied so names can be added
+  auto offsets = reinterpret_cast<const uint64_t*>(mapped->get() + kHeaderSize);
+  mapped_offsets_ = offsets;
+  mapped_names_ = mapped->get() + kHeaderSize + (count + 1 + slot_count) * sizeof(uint64_t);
+  mapped_count_ = count;
+  mapped_ = std::move(mapped);
+  names_.clear();
+  offsets_.assign(1, 0);
+  slots_.assign(offsets + count + 1, offsets + count + 1 + slot_count);
+  return true;
+}
+
+std::pair<const char*, size_t> UniqueNames::view(const uint32_t index) const {
+  if (index < mapped_count_) {
+    return {mapped_names_ + mapped_offsets_[index],
+            mapped_offsets_[index + 1] - mapped_offsets_[index]};
+  }
+  const auto i = index - mapped_count_;
+  return {names_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]};
+}
+
+size_t UniqueNames::find(const std::string& name, const uint32_t hash) const {
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const auto s = slots_[i];
+    if (s == kEmptySlot) {
+      return i;
+    }
+    if (slot_hash(s) == hash) {
+      auto v = view(slot_index(s));
+      if (v.second == name.size() && std::memcmp(v.first, name.data(), v.second) == 0) {
+        return i;
+      }
+    }
+  }
+}
+
+void UniqueNames::grow() {
+  std::vector<uint64_t> slots(slots_.size() * 2, kEmptySlot);
+  const size_t mask = slots.size() - 1;
+  for (const auto s : slots_) {
+    if (s != kEmptySlot) {
+      auto i = slot_hash(s) & mask;
+      while (slots[i] != kEmptySlot) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = s;
+    }
+  }
+  slots_.swap(slots);
+}
+
+void UniqueNames::unmap() {
+  if (!mapped_) {
+    return;
+  }
+
+  // The mapped names go in front of the ones added since
+  const uint64_t mapped_size = mapped_offsets_[mapped_count_];
+  std::vector<char> names(mapped_names_, mapped_names_ + mapped_size);
+  names.insert(names.end(), names_.begin(), names_.end());
+  std::vector<uint64_t> offsets(mapped_offsets_, mapped_offsets_ + mapped_count_);
+  for (const auto offset : offsets_) {
+    offsets.push_back(offset + mapped_size);
+  }
+  names_.swap(names);
+  offsets_.swap(offsets);
+  mapped_count_ = 0;
+  mapped_offsets_ = nullptr;
+  mapped_names_ = nullptr;
+  mapped_.reset();
+}
+
+} // namespace mjolnir
+} // namespace valhalla
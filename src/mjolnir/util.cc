@@ -1,5 +1,6 @@
 #include "mjolnir/util.h"
 
+#include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/aabb2.h"
@@ -7,22 +8,33 @@
 #include "midgard/point2.h"
 #include "midgard/polyline2.h"
 #include "mjolnir/bssbuilder.h"
+#include "mjolnir/buildprofile.h"
 #include "mjolnir/elevationbuilder.h"
+#include "mjolnir/extractbuilder.h"
 #include "mjolnir/graphbuilder.h"
 #include "mjolnir/graphenhancer.h"
 #include "mjolnir/graphfilter.h"
+#include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
+#include "mjolnir/incrementalbuilder.h"
+#include "mjolnir/landmarkbuilder.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
+#include "mjolnir/reachbuilder.h"
 #include "mjolnir/restrictionbuilder.h"
 #include "mjolnir/shortcutbuilder.h"
+#include "mjolnir/textdictionarybuilder.h"
+#include "mjolnir/tilepipeline.h"
 #include "mjolnir/transitbuilder.h"
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <exception>
+#include <thread>
+
 using namespace valhalla::midgard;
 
 namespace {
@@ -56,6 +68,42 @@ const std::string cr_to_file = "complex_to_restrictions.bin";
 const std::string new_to_old_file = "new_nodes_to_old_nodes.bin";
 const std::string old_to_new_file = "old_nodes_to_new_nodes.bin";
 const std::string intersections_file = "intersections.bin";
+
+// Shortcuts are only formed in the tiles of the levels above the local one, so elevation is added
+// to the local and transit tiles meanwhile and to the rest once the shortcuts are in them
+void BuildShortcutsAndElevation(const boost::property_tree::ptree& config) {
+  std::deque<valhalla::baldr::GraphId> shortcut_tiles, other_tiles;
+  {
+    valhalla::baldr::GraphReader reader(config.get_child("mjolnir"));
+    const auto local_level = valhalla::baldr::TileHierarchy::levels().back().level;
+    for (const auto& tile_id : reader.GetTileSet()) {
+      (tile_id.level() < local_level ? shortcut_tiles : other_tiles).push_back(tile_id);
+    }
+  }
+
+  std::exception_ptr elevation_error;
+  std::thread elevation([&config, &other_tiles, &elevation_error]() {
+    try {
+      if (!other_tiles.empty()) {
+        valhalla::mjolnir::ElevationBuilder::Build(config, other_tiles);
+      }
+    } catch (...) { elevation_error = std::current_exception(); }
+  });
+  try {
+    valhalla::mjolnir::ShortcutBuilder::Build(config);
+  } catch (...) {
+    elevation.join();
+    throw;
+  }
+  elevation.join();
+  if (elevation_error) {
+    std::rethrow_exception(elevation_error);
+  }
+
+  if (!shortcut_tiles.empty()) {
+    valhalla::mjolnir::ElevationBuilder::Build(config, shortcut_tiles);
+  }
+}
 const std::string shapes_file = "shapes.bin";
 
 } // namespace
@@ -195,9 +243,14 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     tile_dir.push_back(filesystem::path::preferred_separator);
   }
 
+  // Measures each stage, the build stage includes enhancing when the two run at the same time and
+  // the shortcuts stage includes elevation when they do
+  BuildProfile profile(config);
+
   // During the initialize stage the tile directory will be purged (if it already exists)
   // and will be created if it does not already exist
   if (start_stage == BuildStage::kInitialize) {
+    profile.Start(BuildStage::kInitialize);
     // set up the directories and purge old tiles if starting at the parsing stage
     for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
       auto level_dir = tile_dir + std::to_string(level.level);
@@ -238,6 +291,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
 
   // Parse the ways
   if (start_stage <= BuildStage::kParseWays && BuildStage::kParseWays <= end_stage) {
+    profile.Start(BuildStage::kParseWays);
     // Read the OSM protocol buffer file. Callbacks for ways are defined within the PBFParser class
     osm_data = PBFGraphParser::ParseWays(config.get_child("mjolnir"), input_files, ways_bin,
                                          way_nodes_bin, access_bin, pronunciation_bin);
@@ -255,7 +309,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
 
   // Parse OSM data
   if (start_stage <= BuildStage::kParseRelations && BuildStage::kParseRelations <= end_stage) {
-
+    profile.Start(BuildStage::kParseRelations);
     // Read the OSM protocol buffer file. Callbacks for relations are defined within the PBFParser
     // class
     PBFGraphParser::ParseRelations(config.get_child("mjolnir"), input_files, cr_from_bin, cr_to_bin,
@@ -274,6 +328,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
 
   // Parse OSM data
   if (start_stage <= BuildStage::kParseNodes && BuildStage::kParseNodes <= end_stage) {
+    profile.Start(BuildStage::kParseNodes);
     // Read the OSM protocol buffer file. Callbacks for nodes
     // are defined within the PBFParser class
     PBFGraphParser::ParseNodes(config.get_child("mjolnir"), input_files, way_nodes_bin, bss_nodes_bin,
@@ -293,7 +348,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   // Construct edges
   std::map<baldr::GraphId, size_t> tiles;
   if (start_stage <= BuildStage::kConstructEdges && BuildStage::kConstructEdges <= end_stage) {
-
+    profile.Start(BuildStage::kConstructEdges);
     // Read OSMData from files if construct edges is the first stage
     if (start_stage == BuildStage::kConstructEdges)
       osm_data.read_from_temp_files(tile_dir);
@@ -304,8 +359,18 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     manifest.LogToFile(tile_manifest);
   }
 
+  // An update only builds and enhances the local tiles it touches, the rest come from the snapshot
+  const bool updating = IncrementalBuilder::Updating(config);
+  std::unordered_set<baldr::GraphId> update_tiles;
+
+  // Adjacent stages which allow it start on the tiles the stage before them is done with
+  const bool pipeline_stages = config.get<bool>("mjolnir.pipeline_stages", true);
+  const bool enhance_while_building = pipeline_stages && start_stage <= BuildStage::kBuild &&
+                                      BuildStage::kEnhance <= end_stage;
+
   // Build Valhalla routing tiles
   if (start_stage <= BuildStage::kBuild && BuildStage::kBuild <= end_stage) {
+    profile.Start(BuildStage::kBuild);
     if (start_stage == BuildStage::kBuild) {
       // Read OSMData from files if building tiles is the first stage
       osm_data.read_from_temp_files(tile_dir);
@@ -319,34 +384,84 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
       }
     }
 
+    if (updating) {
+      update_tiles =
+          IncrementalBuilder::AffectedTiles(config, tiles, ways_bin, way_nodes_bin, edges_bin);
+      IncrementalBuilder::RestoreSnapshot(config, update_tiles);
+      for (auto tile = tiles.begin(); tile != tiles.end();) {
+        tile = update_tiles.count(tile->first.Tile_Base()) ? std::next(tile) : tiles.erase(tile);
+      }
+    }
+
     // Build the graph using the OSMNodes and OSMWays from the parser
-    GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin, cr_from_bin,
-                        cr_to_bin, pronunciation_bin, tiles);
+    if (!enhance_while_building) {
+      GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin,
+                          cr_from_bin, cr_to_bin, pronunciation_bin, tiles);
+    } else {
+      // Enhance each tile as soon as it is written, the enhancer waits for any it reads around it
+      std::unordered_set<baldr::GraphId> built;
+      for (const auto& tile : tiles) {
+        built.insert(tile.first.Tile_Base());
+      }
+      TilePipeline pipeline(std::move(built));
+      std::exception_ptr enhance_error;
+      std::thread enhancer([&]() {
+        try {
+          GraphEnhancer::Enhance(config, osm_data, access_bin, updating ? &update_tiles : nullptr,
+                                 &pipeline);
+        } catch (...) { enhance_error = std::current_exception(); }
+      });
+      try {
+        GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin,
+                            cr_from_bin, cr_to_bin, pronunciation_bin, tiles, &pipeline);
+      } catch (...) {
+        pipeline.Close();
+        enhancer.join();
+        throw;
+      }
+      pipeline.Close();
+      enhancer.join();
+      if (enhance_error) {
+        std::rethrow_exception(enhance_error);
+      }
+    }
   }
 
   // Enhance the local level of the graph. This adds information to the local
   // level that is usable across all levels (density, administrative
   // information (and country based attribution), edge transition logic, etc.
   if (start_stage <= BuildStage::kEnhance && BuildStage::kEnhance <= end_stage) {
+    profile.Start(BuildStage::kEnhance);
     // Read OSMData names from file if enhancing tiles is the first stage
     if (start_stage == BuildStage::kEnhance) {
       osm_data.read_from_unique_names_file(tile_dir);
+      if (updating) {
+        tiles = TileManifest::ReadFromFile(tile_manifest).tileset;
+        update_tiles =
+            IncrementalBuilder::AffectedTiles(config, tiles, ways_bin, way_nodes_bin, edges_bin);
+      }
+    }
+    if (!enhance_while_building) {
+      GraphEnhancer::Enhance(config, osm_data, access_bin, updating ? &update_tiles : nullptr);
     }
-    GraphEnhancer::Enhance(config, osm_data, access_bin);
+    IncrementalBuilder::StoreSnapshot(config, updating ? &update_tiles : nullptr);
   }
 
   // Perform optional edge filtering (remove edges and nodes for specific access modes)
   if (start_stage <= BuildStage::kFilter && BuildStage::kFilter <= end_stage) {
+    profile.Start(BuildStage::kFilter);
     GraphFilter::Filter(config);
   }
 
   // Add transit
   if (start_stage <= BuildStage::kTransit && BuildStage::kTransit <= end_stage) {
+    profile.Start(BuildStage::kTransit);
     TransitBuilder::Build(config);
   }
 
   // Build bike share stations
   if (start_stage <= BuildStage::kBss && BuildStage::kBss <= end_stage) {
+    profile.Start(BuildStage::kBss);
     if (start_stage == BuildStage::kBss) {
       osm_data.read_from_unique_names_file(tile_dir);
     }
@@ -355,9 +470,11 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
 
   // Builds additional hierarchies if specified within config file. Connections
   // (directed edges) are formed between nodes at adjacent levels.
+  bool elevation_built = false;
   auto build_hierarchy = config.get<bool>("mjolnir.hierarchy", true);
   if (build_hierarchy) {
     if (start_stage <= BuildStage::kHierarchy && BuildStage::kHierarchy <= end_stage) {
+      profile.Start(BuildStage::kHierarchy);
       HierarchyBuilder::Build(config, new_to_old_bin, old_to_new_bin);
     }
 
@@ -366,7 +483,15 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     auto build_shortcuts = config.get<bool>("mjolnir.shortcuts", true);
     if (build_shortcuts) {
       if (start_stage <= BuildStage::kShortcuts && BuildStage::kShortcuts <= end_stage) {
-        ShortcutBuilder::Build(config);
+        profile.Start(BuildStage::kShortcuts);
+        auto elevation = config.get_optional<std::string>("additional_data.elevation");
+        elevation_built = pipeline_stages && BuildStage::kElevation <= end_stage && elevation &&
+                          filesystem::exists(*elevation);
+        if (elevation_built) {
+          BuildShortcutsAndElevation(config);
+        } else {
+          ShortcutBuilder::Build(config);
+        }
       }
     } else {
       LOG_INFO("Skipping shortcut builder");
@@ -376,7 +501,9 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   }
 
   // Add elevation to the tiles
-  if (start_stage <= BuildStage::kElevation && BuildStage::kElevation <= end_stage) {
+  if (start_stage <= BuildStage::kElevation && BuildStage::kElevation <= end_stage &&
+      !elevation_built) {
+    profile.Start(BuildStage::kElevation);
     ElevationBuilder::Build(config);
   }
 
@@ -385,16 +512,42 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   // elevation into the tiles reads each tile and serializes the data to "builders"
   // within the tile. However, there is no serialization currently available for complex restrictions.
   if (start_stage <= BuildStage::kRestrictions && BuildStage::kRestrictions <= end_stage) {
+    profile.Start(BuildStage::kRestrictions);
     RestrictionBuilder::Build(config, cr_from_bin, cr_to_bin);
   }
 
   // Validate the graph and add information that cannot be added until full graph is formed.
   if (start_stage <= BuildStage::kValidate && BuildStage::kValidate <= end_stage) {
+    profile.Start(BuildStage::kValidate);
+    // Storing the tiles again drops the edge bins so the text is shared before they are added
+    TextDictionaryBuilder::Build(config);
     GraphValidator::Validate(config);
+    // Reach needs the complete graph with valid opposing edges
+    ReachBuilder::Build(config);
+    // So does recovering the shortcuts
+    if (build_hierarchy && config.get<bool>("mjolnir.shortcuts", true)) {
+      ShortcutBuilder::BuildIndex(config);
+    }
+    // And the distances of the nodes from the landmarks
+    LandmarkBuilder::Build(config);
+    // The hot directed edges copy the final directed edges so they go last
+    if (config.get<bool>("mjolnir.hot_directededges", false)) {
+      LOG_INFO("Adding hot directed edges");
+      baldr::GraphReader reader(config.get_child("mjolnir"));
+      for (const auto& tile_id : reader.GetTileSet()) {
+        GraphTileBuilder::AddHotDirectedEdges(tile_dir, reader.GetGraphTile(tile_id));
+        if (reader.OverCommitted()) {
+          reader.Trim();
+        }
+      }
+    }
+    // The tiles are final so they can go into the extract
+    ExtractBuilder::Build(config);
   }
 
   // Cleanup bin files
   if (start_stage <= BuildStage::kCleanup && BuildStage::kCleanup <= end_stage) {
+    profile.Start(BuildStage::kCleanup);
     LOG_INFO("Cleaning up temporary *.bin files within " + tile_dir);
     remove_temp_file(ways_bin);
     remove_temp_file(way_nodes_bin);
@@ -410,6 +563,7 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     remove_temp_file(tile_manifest);
     OSMData::cleanup_temp_files(tile_dir);
   }
+  profile.Report();
   return true;
 }
 
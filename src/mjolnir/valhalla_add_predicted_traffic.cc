@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cmath>
 #include <cstdint>
 #include <deque>
@@ -7,13 +9,13 @@
 #include <optional>
 #include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
 
 #include <boost/archive/iterators/base64_from_binary.hpp>
 #include <boost/archive/iterators/binary_from_base64.hpp>
 #include <boost/archive/iterators/transform_width.hpp>
 #include <boost/property_tree/ptree.hpp>
-#include <boost/tokenizer.hpp>
 #include <cxxopts.hpp>
 
 #include "baldr/graphreader.h"
@@ -21,6 +23,7 @@
 #include "baldr/rapidjson_utils.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
+#include "midgard/sequence.h"
 #include "midgard/util.h"
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/util.h"
@@ -65,95 +68,123 @@ struct TrafficSpeeds {
   std::optional<std::array<int16_t, kCoefficientCount>> coefficients;
 };
 
+// the field up to the next separator, which is removed from the rest along with the field
+std::string_view next_field(std::string_view& rest, const char separator) {
+  const auto end = rest.find(separator);
+  const auto field = rest.substr(0, end);
+  rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+  return field;
+}
+
+// the field without surrounding white space, including the carriage returns of windows line endings
+std::string_view trim(std::string_view field) {
+  constexpr const char* kWhiteSpace = " \t\r";
+  const auto first = field.find_first_not_of(kWhiteSpace);
+  if (first == std::string_view::npos)
+    return {};
+  return field.substr(first, field.find_last_not_of(kWhiteSpace) - first + 1);
+}
+
+// parses a number which makes up the whole field
+template <typename T> bool parse_number(std::string_view field, T& value) {
+  field = trim(field);
+  const auto* end = field.data() + field.size();
+  const auto parsed = std::from_chars(field.data(), end, value);
+  return parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+// parses the id of the edge within its tile from a graph id of the form level/tile_id/id
+bool parse_edge_id(std::string_view field, uint32_t& edge_id) {
+  uint32_t level, tile_id;
+  if (!parse_number(next_field(field, '/'), level) ||
+      !parse_number(next_field(field, '/'), tile_id) || !parse_number(field, edge_id))
+    return false;
+  try {
+    edge_id = GraphId(tile_id, level, edge_id).id();
+  } catch (std::exception& e) {
+    return false;
+  }
+  return true;
+}
+
 /**
- * Read speed CSV file and update the tile_speeds in unique_data
+ * Read speed CSV file and update the tile_speeds in unique_data. The files are mapped and split
+ * into lines and fields in place rather than streamed and tokenized into strings
  */
 std::unordered_map<uint32_t, TrafficSpeeds>
 ParseTrafficFile(const std::vector<std::string>& filenames, stats& stat) {
-  typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
-  boost::char_separator<char> sep{","};
   std::unordered_map<uint32_t, TrafficSpeeds> ts;
 
   // for each traffic tile
   for (const auto& full_filename : filenames) {
-    // Open file
-    std::string line;
-    std::ifstream file(full_filename);
+    // Map the file
+    vm::mem_map<char> file;
+    try {
+      filesystem::directory_entry entry(full_filename);
+      if (!entry.exists())
+        throw std::runtime_error("no such file");
+      file.map_readonly(full_filename, entry.file_size(), POSIX_MADV_SEQUENTIAL);
+    } catch (std::exception& e) {
+      LOG_ERROR("Could not open file: " + full_filename);
+      continue;
+    }
+    std::string_view rest(file.get(), file.size());
+
+    // for each row in the file
     uint32_t line_num = 0;
-    if (file.is_open()) {
-      // for each row in the file
-      while (getline(file, line) && ++line_num) {
-        decltype(ts)::iterator traffic = ts.end();
-        tokenizer tok{line, sep};
-        uint32_t field_num = 0;
-        bool has_error = false;
-        // for each column in the row
-        for (const auto& t : tok) {
-          if (has_error)
-            break;
-          // parse each column
-          switch (field_num) {
-            case 0: {
-              try {
-                auto inserted = ts.insert(decltype(ts)::value_type(GraphId(t).id(), {}));
-                traffic = inserted.first;
-                // skip duplicates
-                if (!inserted.second) {
-                  ++stat.dup_count;
-                  has_error = true;
-                  traffic = ts.end();
-                }
-              } catch (std::exception& e) {
-                LOG_WARN("Invalid GraphId in file: " + full_filename + " line number " +
-                         std::to_string(line_num));
-                has_error = true;
-              }
-            } break;
-            case 1: {
-              try {
-                traffic->second.free_flow_speed = std::stoi(t);
-                stat.free_flow_count++;
-              } catch (std::exception& e) {
-                LOG_WARN("Invalid free flow speed in file: " + full_filename + " line number " +
-                         std::to_string(line_num));
-                has_error = true;
-              }
-            } break;
-            case 2: {
-              try {
-                traffic->second.constrained_flow_speed = std::stoi(t);
-                stat.constrained_count++;
-              } catch (std::exception& e) {
-                LOG_WARN("Invalid constrained flow speed in file: " + full_filename +
-                         " line number " + std::to_string(line_num));
-                has_error = true;
-              }
-            } break;
-            case 3: {
-              if (t.size()) {
-                try {
-                  // Decode the base64 predicted speeds
-                  traffic->second.coefficients = decode_compressed_speeds(t);
-                  stat.compressed_count++;
-                } catch (std::exception& e) {
-                  LOG_WARN("Invalid compressed speeds in file: " + full_filename + " line number " +
-                           std::to_string(line_num) + "; error='" + e.what() + "'");
-                  has_error = true;
-                }
-              }
-            } break;
-            default:
-              break;
-          }
-          field_num++;
+    while (!rest.empty()) {
+      auto line = next_field(rest, '\n');
+      ++line_num;
+      if (trim(line).empty())
+        continue;
+
+      // the edge, skipping duplicates
+      uint32_t edge_id;
+      if (!parse_edge_id(next_field(line, ','), edge_id)) {
+        LOG_WARN("Invalid GraphId in file: " + full_filename + " line number " +
+                 std::to_string(line_num));
+        continue;
+      }
+      auto inserted = ts.insert(decltype(ts)::value_type(edge_id, {}));
+      if (!inserted.second) {
+        ++stat.dup_count;
+        continue;
+      }
+      auto& traffic = inserted.first->second;
+
+      // its speeds, empty ones are left unset but if any of them is invalid lets not keep it
+      const auto parse_speed = [&](uint8_t& speed, uint32_t& count, const char* name) {
+        const auto field = trim(next_field(line, ','));
+        int value;
+        if (field.empty())
+          return true;
+        if (!parse_number(field, value)) {
+          LOG_WARN(std::string("Invalid ") + name + " speed in file: " + full_filename +
+                   " line number " + std::to_string(line_num));
+          return false;
+        }
+        speed = value;
+        ++count;
+        return true;
+      };
+      if (!parse_speed(traffic.free_flow_speed, stat.free_flow_count, "free flow") ||
+          !parse_speed(traffic.constrained_flow_speed, stat.constrained_count, "constrained flow")) {
+        ts.erase(inserted.first);
+        continue;
+      }
+
+      const auto encoded = trim(next_field(line, ','));
+      if (encoded.size()) {
+        try {
+          // Decode the base64 predicted speeds
+          traffic.coefficients = decode_compressed_speeds(encoded);
+          stat.compressed_count++;
+        } catch (std::exception& e) {
+          LOG_WARN("Invalid compressed speeds in file: " + full_filename + " line number " +
+                   std::to_string(line_num) + "; error='" + e.what() + "'");
+          ts.erase(inserted.first);
         }
-        // if this one was erroneous lets not keep it
-        if (has_error && traffic != ts.end())
-          ts.erase(traffic);
       }
-      file.close();
-    } else {
-      LOG_ERROR("Could not open file: " + full_filename);
     }
   }
 
@@ -215,26 +246,26 @@ void update_tile(const std::string& tile_dir,
  * We expect the files to be named as <quadtreeID>.constrained.csv and
  * <quadtreeID>.freeflow.csv. (e.g., 1202021.constrained.csv and 1202021.freeflow.csv)
  */
-void update_tiles(
-    const std::string& tile_dir,
-    std::vector<std::pair<GraphId, std::vector<std::string>>>::const_iterator tile_start,
-    std::vector<std::pair<GraphId, std::vector<std::string>>>::const_iterator tile_end,
-    std::promise<stats>& result) {
+void update_tiles(const std::string& tile_dir,
+                  const std::vector<std::pair<GraphId, std::vector<std::string>>>& traffic_tiles,
+                  std::atomic<size_t>& next_tile,
+                  std::promise<stats>& result) {
 
   std::stringstream thread_name;
   thread_name << std::this_thread::get_id();
 
-  // Iterate through the tiles and parse them
-  size_t total = tile_end - tile_start;
-  double count = 0;
+  // Take the next tile until there are none left, so no thread idles while others have a long list
+  // of large tiles ahead of them
+  const size_t total = traffic_tiles.size();
   stats stat{};
-  for (; tile_start != tile_end; ++tile_start) {
-    LOG_INFO(thread_name.str() + " parsing traffic data for " + std::to_string(tile_start->first));
-    auto traffic = ParseTrafficFile(tile_start->second, stat);
-    LOG_INFO(thread_name.str() + " add traffic data to " + std::to_string(tile_start->first));
-    update_tile(tile_dir, tile_start->first, traffic, stat);
-    LOG_INFO(thread_name.str() + " finished " + std::to_string(tile_start->first) + "(" +
-             std::to_string(++count / total * 100.0) + ")");
+  for (size_t i = next_tile++; i < total; i = next_tile++) {
+    const auto& tile = traffic_tiles[i];
+    LOG_INFO(thread_name.str() + " parsing traffic data for " + std::to_string(tile.first));
+    auto traffic = ParseTrafficFile(tile.second, stat);
+    LOG_INFO(thread_name.str() + " add traffic data to " + std::to_string(tile.first));
+    update_tile(tile_dir, tile.first, traffic, stat);
+    LOG_INFO(thread_name.str() + " finished " + std::to_string(tile.first) + "(" +
+             std::to_string((i + 1) * 100.0 / total) + ")");
   }
 
   result.set_value(stat);
@@ -338,27 +369,21 @@ int main(int argc, char** argv) {
   std::shuffle(traffic_tiles.begin(), traffic_tiles.end(), std::mt19937(rd()));
 
   LOG_INFO("Adding predicted traffic with " + std::to_string(num_threads) + " threads");
-  std::vector<std::shared_ptr<std::thread>> threads(num_threads);
+  std::vector<std::shared_ptr<std::thread>> threads(std::max(1u, num_threads));
 
   std::cout << traffic_tile_dir << std::endl;
 
   LOG_INFO("Parsing speeds from " + std::to_string(traffic_tiles.size()) + " tiles.");
-  size_t floor = traffic_tiles.size() / threads.size();
-  size_t at_ceiling = traffic_tiles.size() - (threads.size() * floor);
-  decltype(traffic_tiles)::const_iterator tile_start, tile_end = traffic_tiles.begin();
   auto tile_dir = config.get<std::string>("mjolnir.tile_dir");
   // A place to hold the results of those threads (exceptions, stats)
   std::list<std::promise<stats>> results;
-  // Atomically pass around stats info
+  // The threads take the tiles one at a time
+  std::atomic<size_t> next_tile(0);
   for (size_t i = 0; i < threads.size(); ++i) {
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    tile_end += (i < at_ceiling ? floor + 1 : floor);
     // Make the thread
     results.emplace_back();
-    threads[i].reset(
-        new std::thread(update_tiles, tile_dir, tile_start, tile_end, std::ref(results.back())));
+    threads[i].reset(new std::thread(update_tiles, tile_dir, std::cref(traffic_tiles),
+                                     std::ref(next_tile), std::ref(results.back())));
   }
 
   // wait for it to finish
@@ -34,7 +34,8 @@ bool ParseArguments(int argc, char* argv[]) {
       "valhalla_build_connectivity",
       "valhalla_build_connectivity " VALHALLA_VERSION "\n\n"
       "valhalla_build_connectivity is a program that creates a PPM image file representing\n"
-      "the connectivity between tiles.\n\n");
+      "the connectivity between tiles. If mjolnir.connectivity_map is configured it also\n"
+      "writes the connectivity there for the services to map when they start.\n\n");
 
     options.add_options()
       ("h,help", "Print this help message.")
@@ -95,8 +96,16 @@ int main(int argc, char** argv) {
   boost::property_tree::ptree pt;
   rapidjson::read_json(config_file_path.string(), pt);
 
-  // Get something we can use to fetch tiles
-  valhalla::baldr::connectivity_map_t connectivity_map(pt.get_child("mjolnir"));
+  // Get something we can use to fetch tiles, going through the tiles rather than mapping the
+  // connectivity this writes
+  auto mjolnir = pt.get_child("mjolnir");
+  const auto connectivity_file = mjolnir.get<std::string>("connectivity_map", "");
+  mjolnir.erase("connectivity_map");
+  valhalla::baldr::connectivity_map_t connectivity_map(mjolnir);
+  if (!connectivity_file.empty()) {
+    connectivity_map.Store(connectivity_file);
+    std::cout << "Wrote the connectivity map " << connectivity_file << std::endl;
+  }
 
   uint32_t transit_level = TileHierarchy::levels().back().level + 1;
   for (uint32_t level = 0; level <= transit_level; level++) {
@@ -3,13 +3,13 @@
 #include "statistics.h"
 
 #include "baldr/rapidjson_utils.h"
+#include <atomic>
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <cxxopts.hpp>
 #include <future>
 #include <iostream>
 #include <list>
-#include <mutex>
 #include <ostream>
 #include <queue>
 #include <sstream>
@@ -361,25 +361,18 @@ void AddStatistics(statistics& stats,
 }
 
 void build(const boost::property_tree::ptree& pt,
-           std::deque<GraphId>& tilequeue,
-           std::mutex& lock,
+           const std::deque<GraphId>& tilequeue,
+           std::atomic<size_t>& next_tile,
            std::promise<statistics>& result) {
   // Our local class for gathering the stats
   statistics stats;
   // Local Graphreader
   GraphReader graph_reader(pt.get_child("mjolnir"));
 
-  // Check for more tiles
-  while (true) {
-    lock.lock();
-    if (tilequeue.empty()) {
-      lock.unlock();
-      break;
-    }
+  // Check for more tiles, the threads only share the index of the next one
+  for (size_t t = next_tile++; t < tilequeue.size(); t = next_tile++) {
     // Get the next tile Id
-    GraphId tile_id = tilequeue.front();
-    tilequeue.pop_front();
-    lock.unlock();
+    GraphId tile_id = tilequeue[t];
 
     // Point tiles to the set we need for current level
     auto level = tile_id.level();
@@ -487,11 +480,9 @@ void build(const boost::property_tree::ptree& pt,
     stats.add_tile_geom(tileid, tiles.TileBounds(tileid));
 
     // Check if we need to clear the tile cache
-    lock.lock();
     if (graph_reader.OverCommitted()) {
       graph_reader.Trim();
     }
-    lock.unlock();
   }
 
   // Fill promise with statistics
@@ -534,8 +525,8 @@ void BuildStatistics(const boost::property_tree::ptree& pt) {
   std::random_device rd;
   std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(rd()));
 
-  // A mutex we can use to do the synchronization
-  std::mutex lock;
+  // The index of the next tile a thread takes
+  std::atomic<size_t> next_tile(0);
 
   LOG_INFO("Gathering information about the tiles in " + pt.get<std::string>("mjolnir.tile_dir"));
 
@@ -550,8 +541,8 @@ void BuildStatistics(const boost::property_tree::ptree& pt) {
   // Spawn the threads
   for (auto& thread : threads) {
     results.emplace_back();
-    thread.reset(new std::thread(build, std::cref(pt), std::ref(tilequeue), std::ref(lock),
-                                 std::ref(results.back())));
+    thread.reset(new std::thread(build, std::cref(pt), std::cref(tilequeue),
+                                 std::ref(next_tile), std::ref(results.back())));
   }
 
   // Wait for threads to finish
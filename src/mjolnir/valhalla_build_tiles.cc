@@ -48,6 +48,9 @@ int main(int argc, char** argv) {
       ("i,inline-config", "Inline JSON config", cxxopts::value<std::string>())
       ("s,start", "Starting stage of the build pipeline", cxxopts::value<std::string>()->default_value("initialize"))
       ("e,end", "End stage of the build pipeline", cxxopts::value<std::string>()->default_value("cleanup"))
+      ("update-osc", "Only build and enhance the local tiles touched by the changes in this (uncompressed) osc file, the others are taken from mjolnir.snapshot_dir", cxxopts::value<std::string>())
+      ("update-bbox", "Only build and enhance the local tiles within this min_lon,min_lat,max_lon,max_lat, the others are taken from mjolnir.snapshot_dir", cxxopts::value<std::string>())
+      ("update-tiles", "Only build and enhance these comma separated local tile ids, the others are taken from mjolnir.snapshot_dir", cxxopts::value<std::string>())
       ("input_files", "positional arguments", cxxopts::value<std::vector<std::string>>(input_files));
     // clang-format on
 
@@ -80,6 +83,14 @@ int main(int argc, char** argv) {
       return EXIT_FAILURE;
     }
 
+    // which part of the tiles to update
+    for (const auto& update : {"osc", "bbox", "tiles"}) {
+      if (result.count(std::string("update-") + update)) {
+        pt.put(std::string("mjolnir.update.") + update,
+               result[std::string("update-") + update].as<std::string>());
+      }
+    }
+
     // configure logging
     auto logging_subtree = pt.get_child_optional("mjolnir.logging");
     if (logging_subtree) {
@@ -1,8 +1,10 @@
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
-#include <unordered_map>
+#include <thread>
 #include <vector>
 
 #include "config.h"
@@ -19,21 +21,68 @@
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
+#include "midgard/sequence.h"
 
 using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
 filesystem::path config_file_path;
 boost::property_tree::ptree pt;
+unsigned int num_threads;
+size_t memory_budget;
+
+// Structure holding an OSM way Id with one of its edges and the edge's forward flag. These are
+// spilled to disk and sorted by way there so memory stays bounded however many ways there are
+struct WayEdge {
+  uint64_t wayid;
+  uint64_t edgeid : 63;
+  uint64_t forward : 1;
+
+  bool operator<(const WayEdge& other) const {
+    return wayid == other.wayid ? edgeid < other.edgeid : wayid < other.wayid;
+  }
+};
+
+// Collects the edges of auto-driveable ways from the tiles the thread takes, batching them into the
+// sequence shared with the other threads
+void collect_way_edges(const std::vector<GraphId>& tiles,
+                       std::atomic<size_t>& next_tile,
+                       sequence<WayEdge>& way_edges,
+                       std::mutex& lock) {
+  GraphReader reader(pt.get_child("mjolnir"));
+  std::vector<WayEdge> batch;
+  for (size_t k = next_tile++; k < tiles.size(); k = next_tile++) {
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+
+    GraphId edge_id = tiles[k];
+    graph_tile_ptr tile = reader.GetGraphTile(edge_id);
+    for (uint32_t n = 0; n < tile->header()->directededgecount(); n++, ++edge_id) {
+      const DirectedEdge* edge = tile->directededge(edge_id);
+      if (edge->IsTransitLine() || edge->use() == Use::kTransitConnection ||
+          edge->use() == Use::kEgressConnection || edge->use() == Use::kPlatformConnection ||
+          edge->is_shortcut()) {
+        continue;
+      }
 
-// Structure holding an edge Id and forward flag
-struct EdgeAndDirection {
-  bool forward;
-  GraphId edgeid;
+      // Skip if the edge does not allow auto use
+      if (!(edge->forwardaccess() & kAutoAccess)) {
+        continue;
+      }
 
-  EdgeAndDirection(const bool f, const GraphId& id) : forward(f), edgeid(id) {
+      // Get the way Id
+      batch.push_back({tile->edgeinfo(edge).wayid(), edge_id.value, edge->forward()});
+    }
+
+    // Hand the tile's edges over to the file
+    std::lock_guard<std::mutex> guard(lock);
+    for (const auto& way_edge : batch) {
+      way_edges.push_back(way_edge);
+    }
+    batch.clear();
   }
-};
+}
 
 bool ParseArguments(int argc, char* argv[]) {
   try {
@@ -47,6 +96,8 @@ bool ParseArguments(int argc, char* argv[]) {
       ("h,help", "Print this help message.")
       ("i,inline-config", "Inline JSON config", cxxopts::value<std::string>())
       ("v,version", "Print the version of this software.")
+      ("j,concurrency", "Number of threads to use.", cxxopts::value<unsigned int>(num_threads)->default_value(std::to_string(std::thread::hardware_concurrency())))
+      ("m,memory", "Megabytes of memory to sort the way edges in, more of them are sorted on disk.", cxxopts::value<size_t>(memory_budget)->default_value("512"))
       ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>());
     // clang-format on
 
@@ -92,54 +143,74 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
-  // Create an unordered map of OSM ways Ids and their associated graph edges
-  std::unordered_map<uint64_t, std::vector<EdgeAndDirection>> ways_edges;
+  // Find the tiles to read
+  std::vector<GraphId> tiles;
+  {
+    GraphReader reader(pt.get_child("mjolnir"));
+    for (const auto& tile_id : reader.GetTileSet()) {
+      if (reader.DoesTileExist(tile_id)) {
+        tiles.push_back(tile_id);
+      }
+    }
+  }
 
-  GraphReader reader(pt.get_child("mjolnir"));
-  // Iterate through all tiles
-  for (auto edge_id : reader.GetTileSet()) {
-    // If tile exists add it to the queue
-    if (!reader.DoesTileExist(edge_id)) {
-      continue;
+  // Write the edges of each way to a file next to the tiles, the threads take the tiles one at a
+  // time
+  std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
+  std::string way_edges_bin = tile_dir + filesystem::path::preferred_separator + "way_edges.bin";
+  num_threads = std::max(1u, num_threads);
+  {
+    sequence<WayEdge> way_edges(way_edges_bin, true);
+    std::atomic<size_t> next_tile(0);
+    std::mutex lock;
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    for (unsigned int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&, i]() {
+        try {
+          collect_way_edges(tiles, next_tile, way_edges, lock);
+        } catch (...) { errors[i] = std::current_exception(); }
+      });
     }
-    if (reader.OverCommitted()) {
-      reader.Trim();
+    for (auto& thread : threads) {
+      thread.join();
     }
-
-    graph_tile_ptr tile = reader.GetGraphTile(edge_id);
-    for (uint32_t n = 0; n < tile->header()->directededgecount(); n++, ++edge_id) {
-      const DirectedEdge* edge = tile->directededge(edge_id);
-      if (edge->IsTransitLine() || edge->use() == Use::kTransitConnection ||
-          edge->use() == Use::kEgressConnection || edge->use() == Use::kPlatformConnection ||
-          edge->is_shortcut()) {
-        continue;
-      }
-
-      // Skip if the edge does not allow auto use
-      if (!(edge->forwardaccess() & kAutoAccess)) {
-        continue;
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
       }
-
-      // Get the way Id
-      uint64_t wayid = tile->edgeinfo(edge).wayid();
-      ways_edges[wayid].push_back({edge->forward(), edge_id});
     }
+
+    // Sort them by way, whatever doesnt fit in memory is merged from disk
+    LOG_INFO("Sorting " + std::to_string(way_edges.size()) + " way edges");
+    way_edges.sort(std::less<WayEdge>(), memory_budget * 1024 * 1024, num_threads);
   }
 
+  // Stream the ways out one after the other
   std::ofstream ways_file;
-  std::string fname = pt.get<std::string>("mjolnir.tile_dir") +
-                      filesystem::path::preferred_separator + "way_edges.txt";
+  std::string fname = tile_dir + filesystem::path::preferred_separator + "way_edges.txt";
   ways_file.open(fname, std::ofstream::out | std::ofstream::trunc);
-  for (const auto& way : ways_edges) {
-    ways_file << way.first;
-    for (auto edge : way.second) {
-      ways_file << "," << (uint32_t)edge.forward << "," << (uint64_t)edge.edgeid;
+  size_t way_count = 0;
+  {
+    sequence<WayEdge> way_edges(way_edges_bin, false);
+    uint64_t wayid = 0;
+    for (auto element : way_edges) {
+      const WayEdge way_edge = element;
+      if (way_count == 0 || way_edge.wayid != wayid) {
+        ways_file << (way_count++ ? "\n" : "") << (wayid = way_edge.wayid);
+      }
+      ways_file << "," << static_cast<uint32_t>(way_edge.forward) << ","
+                << static_cast<uint64_t>(way_edge.edgeid);
+    }
+    if (way_count) {
+      ways_file << std::endl;
     }
-    ways_file << std::endl;
   }
   ways_file.close();
 
-  LOG_INFO("Finished with " + std::to_string(ways_edges.size()) + " ways.");
+  filesystem::remove(way_edges_bin);
+
+  LOG_INFO("Finished with " + std::to_string(way_count) + " ways.");
 
   return EXIT_SUCCESS;
 }
@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "midgard/executor.h"
 #include "midgard/logging.h"
 #include "odin/directionsbuilder.h"
 #include "odin/enhancedtrippath.h"
@@ -25,42 +31,80 @@ namespace odin {
 // and trip path. This method calls ManeuversBuilder::Build and
 // NarrativeBuilder::Build to form the maneuver list. This method
 // calls PopulateDirectionsLeg to transform the maneuver list into the
-// trip directions.
-void DirectionsBuilder::Build(Api& api, const MarkupFormatter& markup_formatter) {
+// trip directions. The legs of all routes are spread over up to threads
+// slots of the shared executor.
+void DirectionsBuilder::Build(Api& api,
+                              const MarkupFormatter& markup_formatter,
+                              const uint32_t threads) {
   const auto& options = api.options();
+
+  // Lay out the directions of every leg of every route up front, the legs are then narrated
+  // independently of each other and each fills in its own place so the order is kept
+  std::vector<std::pair<TripLeg*, DirectionsLeg*>> legs;
   for (auto& trip_route : *api.mutable_trip()->mutable_routes()) {
     auto& directions_route = *api.mutable_directions()->mutable_routes()->Add();
     for (auto& trip_path : *trip_route.mutable_legs()) {
-      auto& trip_directions = *directions_route.mutable_legs()->Add();
-
       // Validate trip path node list
       if (trip_path.node_size() < 1) {
         throw valhalla_exception_t{210};
       }
+      legs.emplace_back(&trip_path, directions_route.mutable_legs()->Add());
+    }
+  }
 
-      // Create an enhanced trip path from the specified trip_path
-      EnhancedTripLeg etp(trip_path);
-
-      // Produce maneuvers if desired
-      std::list<Maneuver> maneuvers;
-      if (options.directions_type() != DirectionsType::none) {
-        // Update the heading of ~0 length edges
-        UpdateHeading(&etp);
-
-        ManeuversBuilder maneuversBuilder(options, &etp);
-        maneuvers = maneuversBuilder.Build();
-
-        // Create the instructions if desired
-        if (options.directions_type() == DirectionsType::instructions) {
-          std::unique_ptr<NarrativeBuilder> narrative_builder =
-              NarrativeBuilderFactory::Create(options, &etp, markup_formatter);
-          narrative_builder->Build(maneuvers);
+  // the time of each phase is summed over the legs, each slot keeps its own sums
+  const uint32_t slots = std::max<uint32_t>(1, std::min<size_t>(threads, legs.size()));
+  std::vector<std::chrono::steady_clock::duration> maneuvers_times(slots), narrative_times(slots);
+  std::atomic<size_t> next_leg(0);
+  midgard::executor_t::shared().run(slots, [&](uint32_t slot) {
+    for (size_t i = next_leg++; i < legs.size(); i = next_leg++) {
+      try {
+        // Create an enhanced trip path from the specified trip_path
+        EnhancedTripLeg etp(*legs[i].first);
+
+        // Produce maneuvers if desired
+        std::list<Maneuver> maneuvers;
+        if (options.directions_type() != DirectionsType::none) {
+          auto start = std::chrono::steady_clock::now();
+          // Update the heading of ~0 length edges
+          UpdateHeading(&etp);
+
+          ManeuversBuilder maneuversBuilder(options, &etp);
+          maneuvers = maneuversBuilder.Build();
+          maneuvers_times[slot] += std::chrono::steady_clock::now() - start;
+
+          // Create the instructions if desired
+          if (options.directions_type() == DirectionsType::instructions) {
+            start = std::chrono::steady_clock::now();
+            std::unique_ptr<NarrativeBuilder> narrative_builder =
+                NarrativeBuilderFactory::Create(options, &etp, markup_formatter);
+            narrative_builder->Build(maneuvers);
+            narrative_times[slot] += std::chrono::steady_clock::now() - start;
+          }
         }
-      }
 
-      // Return trip directions
-      PopulateDirectionsLeg(options, &etp, maneuvers, trip_directions);
+        // Return trip directions
+        PopulateDirectionsLeg(options, &etp, maneuvers, *legs[i].second);
+      } catch (...) {
+        // make the other slots run out of legs
+        next_leg = legs.size();
+        throw;
+      }
     }
+  });
+
+  std::chrono::steady_clock::duration maneuvers_time{}, narrative_time{};
+  for (uint32_t slot = 0; slot < slots; ++slot) {
+    maneuvers_time += maneuvers_times[slot];
+    narrative_time += narrative_times[slot];
+  }
+  if (options.directions_type() != DirectionsType::none) {
+    record_phase(api, "odin.maneuvers",
+                 std::chrono::duration<double, std::milli>(maneuvers_time).count());
+  }
+  if (options.directions_type() == DirectionsType::instructions) {
+    record_phase(api, "odin.narrative",
+                 std::chrono::duration<double, std::milli>(narrative_time).count());
   }
 }
 
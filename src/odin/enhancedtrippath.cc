@@ -227,11 +227,15 @@ namespace odin {
 ///////////////////////////////////////////////////////////////////////////////
 // EnhancedTripLeg
 
-EnhancedTripLeg::EnhancedTripLeg(TripLeg& trip_path) : trip_path_(trip_path) {
+EnhancedTripLeg::EnhancedTripLeg(TripLeg& trip_path)
+    : trip_path_(trip_path), xedge_summaries_(trip_path.node_size()) {
 }
 
 std::unique_ptr<EnhancedTripLeg_Node> EnhancedTripLeg::GetEnhancedNode(const int node_index) {
-  return std::make_unique<EnhancedTripLeg_Node>(mutable_node(node_index));
+  auto* summary = static_cast<size_t>(node_index) < xedge_summaries_.size()
+                      ? &xedge_summaries_[node_index]
+                      : nullptr;
+  return std::make_unique<EnhancedTripLeg_Node>(mutable_node(node_index), summary);
 }
 
 std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetPrevEdge(const int node_index, int delta) {
@@ -1429,7 +1433,50 @@ EnhancedTripLeg_IntersectingEdge::GetTravelModeTraversability(const TravelMode t
 ///////////////////////////////////////////////////////////////////////////////
 // EnhancedTripLeg_Node
 
-EnhancedTripLeg_Node::EnhancedTripLeg_Node(TripLeg_Node* mutable_node) : mutable_node_(mutable_node) {
+EnhancedTripLeg_Node::EnhancedTripLeg_Node(TripLeg_Node* mutable_node,
+                                           IntersectingEdgeSummary* summary)
+    : mutable_node_(mutable_node), summary_(summary) {
+  Summarize();
+}
+
+void EnhancedTripLeg_Node::Summarize() {
+  if (!summary_ || summary_->summarized) {
+    return;
+  }
+  if (intersecting_edge_size() > IntersectingEdgeSummary::kMaxIntersectingEdges) {
+    summary_ = nullptr;
+    return;
+  }
+
+  for (int i = 0; i < intersecting_edge_size(); ++i) {
+    EnhancedTripLeg_IntersectingEdge xedge(mutable_intersecting_edge(i));
+    for (int mode = 0; mode < TravelMode_ARRAYSIZE; ++mode) {
+      if (xedge.IsTraversable(static_cast<TravelMode>(mode))) {
+        summary_->traversable[mode] |= uint64_t(1) << i;
+      }
+      if (xedge.IsTraversableOutbound(static_cast<TravelMode>(mode))) {
+        summary_->traversable_outbound[mode] |= uint64_t(1) << i;
+      }
+    }
+  }
+  summary_->summarized = true;
+}
+
+bool EnhancedTripLeg_Node::IsIntersectingEdgeTraversable(int index, const TravelMode travel_mode) {
+  if (summary_) {
+    return (summary_->traversable[travel_mode] >> index) & 1;
+  }
+  return EnhancedTripLeg_IntersectingEdge(mutable_intersecting_edge(index))
+      .IsTraversable(travel_mode);
+}
+
+bool EnhancedTripLeg_Node::IsIntersectingEdgeTraversableOutbound(int index,
+                                                                 const TravelMode travel_mode) {
+  if (summary_) {
+    return (summary_->traversable_outbound[travel_mode] >> index) & 1;
+  }
+  return EnhancedTripLeg_IntersectingEdge(mutable_intersecting_edge(index))
+      .IsTraversableOutbound(travel_mode);
 }
 
 bool EnhancedTripLeg_Node::HasIntersectingEdges() const {
@@ -1463,7 +1510,7 @@ bool EnhancedTripLeg_Node::HasNonBackwardTraversableSameNameRampIntersectingEdge
     // Check if the intersecting edges have the same names as the path edges
     // and if the intersecting edge is traversable based on the route path travel mode
     if ((xedge->prev_name_consistency() || xedge->curr_name_consistency()) &&
-        xedge->IsTraversable(travel_mode) && (xedge->use() == TripLeg_Use_kRampUse)) {
+        IsIntersectingEdgeTraversable(i, travel_mode) && (xedge->use() == TripLeg_Use_kRampUse)) {
       // Calculate the intersecting edge turn degree to make sure it is not in the opposing direction
       uint32_t intersecting_turn_degree = GetTurnDegree(from_heading, xedge->begin_heading());
       bool non_backward = !((intersecting_turn_degree > kBackwardTurnDegreeLowerBound) &&
@@ -1485,8 +1532,24 @@ void EnhancedTripLeg_Node::CalculateRightLeftIntersectingEdgeCounts(
     uint32_t from_heading,
     const TravelMode travel_mode,
     IntersectingEdgeCounts& xedge_counts) {
+  // Same as the last time they were asked for at this node
+  const auto counts_for = std::make_pair(from_heading, travel_mode);
+  if (summary_ && summary_->counts_for == counts_for) {
+    xedge_counts = summary_->counts;
+    return;
+  }
+
   xedge_counts.clear();
+  CountRightLeftIntersectingEdges(from_heading, travel_mode, xedge_counts);
+  if (summary_) {
+    summary_->counts_for = counts_for;
+    summary_->counts = xedge_counts;
+  }
+}
 
+void EnhancedTripLeg_Node::CountRightLeftIntersectingEdges(uint32_t from_heading,
+                                                           const TravelMode travel_mode,
+                                                           IntersectingEdgeCounts& xedge_counts) {
   // No turn - just return
   if (intersecting_edge_size() == 0) {
     return;
@@ -1496,7 +1559,7 @@ void EnhancedTripLeg_Node::CalculateRightLeftIntersectingEdgeCounts(
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     uint32_t intersecting_turn_degree =
         GetTurnDegree(from_heading, intersecting_edge(i).begin_heading());
-    bool xedge_traversable_outbound = GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode);
+    bool xedge_traversable_outbound = IsIntersectingEdgeTraversableOutbound(i, travel_mode);
 
     if (path_turn_degree > 180) {
       if ((intersecting_turn_degree > path_turn_degree) || (intersecting_turn_degree < 180)) {
@@ -1565,7 +1628,7 @@ bool EnhancedTripLeg_Node::HasForwardTraversableIntersectingEdge(uint32_t from_h
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     if (is_forward(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) &&
-        GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode)) {
+        IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       return true;
     }
   }
@@ -1577,11 +1640,14 @@ bool EnhancedTripLeg_Node::HasRoadForkTraversableIntersectingEdge(uint32_t from_
                                                                   bool allow_service_road) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     if (is_fork_forward(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode) && xedge->prev_name_consistency() &&
-        (xedge->use() != TripLeg_Use_kRampUse) && (xedge->use() != TripLeg_Use_kTurnChannelUse) &&
-        (xedge->use() != TripLeg_Use_kFerryUse) && (xedge->use() != TripLeg_Use_kRailFerryUse)) {
+        xedge->prev_name_consistency() && (xedge->use() != TripLeg_Use_kRampUse) &&
+        (xedge->use() != TripLeg_Use_kTurnChannelUse) && (xedge->use() != TripLeg_Use_kFerryUse) &&
+        (xedge->use() != TripLeg_Use_kRailFerryUse)) {
       // If service roads are not allowed then skip intersecting service roads
       if (!allow_service_road && (xedge->road_class() == kServiceOther)) {
         continue;
@@ -1598,12 +1664,13 @@ bool EnhancedTripLeg_Node::HasForwardTraversableSignificantRoadClassXEdge(
     RoadClass path_road_class) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     // if the intersecting edge is forward
-    // and is traversable based on mode
     // and is a significant road class as compared to the path road class
     if (is_forward(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode) &&
         ((xedge->road_class() - path_road_class) <= kSignificantRoadClassThreshold)) {
       return true;
     }
@@ -1616,12 +1683,14 @@ bool EnhancedTripLeg_Node::HasForwardTraversableUseXEdge(uint32_t from_heading,
                                                          const TripLeg_Use use) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     // if the intersecting edge is forward
-    // and is traversable based on mode
     // and use matches specified use
     if (is_forward(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode) && (xedge->use() == use)) {
+        (xedge->use() == use)) {
       return true;
     }
   }
@@ -1634,14 +1703,15 @@ bool EnhancedTripLeg_Node::HasSimilarStraightSignificantRoadClassXEdge(uint32_t
                                                                        RoadClass path_road_class) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     uint32_t xedge_turn_degree = GetTurnDegree(from_heading, xedge->begin_heading());
     int path_xedge_turn_degree_delta = get_turn_degree_delta(path_turn_degree, xedge_turn_degree);
     // if the intersecting edge is straight
-    // and is traversable based on mode
     // and is a significant road class as compared to the path road class
     if (is_relative_straight(path_turn_degree) && is_relative_straight(xedge_turn_degree) &&
-        xedge->IsTraversableOutbound(travel_mode) &&
         (path_xedge_turn_degree_delta <= kSimilarStraightThreshold) &&
         ((xedge->road_class() - path_road_class) <= kSignificantRoadClassThreshold)) {
       return true;
@@ -1656,14 +1726,15 @@ bool EnhancedTripLeg_Node::HasSimilarStraightNonRampOrSameNameRampXEdge(
     const TravelMode travel_mode) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     uint32_t xedge_turn_degree = GetTurnDegree(from_heading, xedge->begin_heading());
     int path_xedge_turn_degree_delta = get_turn_degree_delta(path_turn_degree, xedge_turn_degree);
     // if the intersecting edge is straight
-    // and is traversable based on mode
     // and is not a ramp OR ramp with same previous edge name
     if (is_relative_straight(path_turn_degree) && is_relative_straight(xedge_turn_degree) &&
-        xedge->IsTraversableOutbound(travel_mode) &&
         (path_xedge_turn_degree_delta <= kSimilarStraightThreshold) &&
         ((xedge->use() != TripLeg_Use_kRampUse) ||
          ((xedge->use() == TripLeg_Use_kRampUse) && xedge->prev_name_consistency()))) {
@@ -1692,7 +1763,7 @@ bool EnhancedTripLeg_Node::HasOnlyForwardTraversableRoadClassXEdges(uint32_t fro
 
     if ((path_road_class >= xedge->road_class()) &&
         is_fork_forward(GetTurnDegree(from_heading, xedge->begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode)) {
+        IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       continue;
     } else {
       return false;
@@ -1706,7 +1777,7 @@ bool EnhancedTripLeg_Node::HasWiderForwardTraversableIntersectingEdge(uint32_t f
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     if (is_wider_forward(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) &&
-        GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode)) {
+        IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       return true;
     }
   }
@@ -1717,9 +1788,12 @@ bool EnhancedTripLeg_Node::HasWiderForwardTraversableHighwayXEdge(uint32_t from_
                                                                   const TravelMode travel_mode) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     if (is_wider_forward(GetTurnDegree(from_heading, xedge->begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode) && xedge->IsHighway()) {
+        xedge->IsHighway()) {
       return true;
     }
   }
@@ -1727,9 +1801,12 @@ bool EnhancedTripLeg_Node::HasWiderForwardTraversableHighwayXEdge(uint32_t from_
 }
 
 bool EnhancedTripLeg_Node::HasTraversableIntersectingEdge(const TravelMode travel_mode) {
+  if (summary_) {
+    return summary_->traversable[travel_mode] != 0;
+  }
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
-    if (GetIntersectingEdge(i)->IsTraversable(travel_mode)) {
+    if (IsIntersectingEdgeTraversable(i, travel_mode)) {
       return true;
     }
   }
@@ -1737,9 +1814,12 @@ bool EnhancedTripLeg_Node::HasTraversableIntersectingEdge(const TravelMode trave
 }
 
 bool EnhancedTripLeg_Node::HasTraversableOutboundIntersectingEdge(const TravelMode travel_mode) {
+  if (summary_) {
+    return summary_->traversable_outbound[travel_mode] != 0;
+  }
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
-    if (GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode)) {
+    if (IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       return true;
     }
   }
@@ -1750,10 +1830,12 @@ bool EnhancedTripLeg_Node::HasTraversableExcludeUseXEdge(const TravelMode travel
                                                          const TripLeg_Use exclude_use) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
-    // If is traversable based on mode
-    // and the intersecting edge use does not equal the specified exclude use
-    if (xedge->IsTraversableOutbound(travel_mode) && (xedge->use() != exclude_use)) {
+    // If the intersecting edge use does not equal the specified exclude use
+    if (xedge->use() != exclude_use) {
       return true;
     }
   }
@@ -1765,12 +1847,14 @@ bool EnhancedTripLeg_Node::HasForwardTraversableExcludeUseXEdge(uint32_t from_he
                                                                 const TripLeg_Use exclude_use) {
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
+    if (!IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
+      continue;
+    }
     auto xedge = GetIntersectingEdge(i);
     // if the intersecting edge is forward
-    // and the intersecting edge is traversable based on mode
     // and the intersecting edge use does not equal the specified exclude use
     if (is_forward(GetTurnDegree(from_heading, xedge->begin_heading())) &&
-        xedge->IsTraversableOutbound(travel_mode) && (xedge->use() != exclude_use)) {
+        (xedge->use() != exclude_use)) {
       return true;
     }
   }
@@ -1783,7 +1867,7 @@ bool EnhancedTripLeg_Node::HasSpecifiedTurnXEdge(const Turn::Type turn_type,
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     // Only process the traversable outbound edges
-    if (GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode) &&
+    if (IsIntersectingEdgeTraversableOutbound(i, travel_mode) &&
         (Turn::GetType(GetTurnDegree(from_heading, intersecting_edge(i).begin_heading())) ==
          turn_type)) {
       // return true if an intersecting edge of the specified turn type exists
@@ -1822,7 +1906,7 @@ uint32_t EnhancedTripLeg_Node::GetStraightestTraversableIntersectingEdgeTurnDegr
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     auto xedge = GetIntersectingEdge(i);
     uint32_t intersecting_turn_degree = GetTurnDegree(from_heading, xedge->begin_heading());
-    bool xedge_traversable_outbound = xedge->IsTraversableOutbound(travel_mode);
+    bool xedge_traversable_outbound = IsIntersectingEdgeTraversableOutbound(i, travel_mode);
     uint32_t straight_delta = (intersecting_turn_degree > 180) ? (360 - intersecting_turn_degree)
                                                                : intersecting_turn_degree;
     if (xedge_traversable_outbound && (straight_delta < staightest_delta)) {
@@ -1887,7 +1971,7 @@ uint32_t EnhancedTripLeg_Node::GetRightMostTurnDegree(uint32_t turn_degree,
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     // Only process traversable outbound edges
-    if (GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode)) {
+    if (IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       // Get the intersecting edge turn degree and right turn delta
       uint32_t xturn_degree = GetTurnDegree(from_heading, intersecting_edge(i).begin_heading());
       uint32_t right_delta = get_right_delta(xturn_degree);
@@ -1920,7 +2004,7 @@ uint32_t EnhancedTripLeg_Node::GetLeftMostTurnDegree(uint32_t turn_degree,
 
   for (int i = 0; i < intersecting_edge_size(); ++i) {
     // Only process traversable outbound edges
-    if (GetIntersectingEdge(i)->IsTraversableOutbound(travel_mode)) {
+    if (IsIntersectingEdgeTraversableOutbound(i, travel_mode)) {
       // Get the intersecting edge turn degree and left turn delta
       uint32_t xturn_degree = GetTurnDegree(from_heading, intersecting_edge(i).begin_heading());
       uint32_t left_delta = get_left_delta(xturn_degree);
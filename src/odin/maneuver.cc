@@ -231,9 +231,9 @@ bool Maneuver::HasSameNames(const Maneuver* other_maneuver,
     // and other maneuver exists
     if (HasStreetNames() && other_maneuver) {
       // other and this maneuvers have same names
-      std::unique_ptr<StreetNames> same_street_names =
-          other_maneuver->street_names().FindCommonStreetNames(street_names());
-      if (!same_street_names->empty() && (street_names().size() == same_street_names->size())) {
+      const auto same_street_names =
+          other_maneuver->street_names().CountCommonStreetNames(street_names());
+      if (same_street_names > 0 && (street_names().size() == same_street_names)) {
         return true;
       }
     }
@@ -251,9 +251,9 @@ bool Maneuver::HasSimilarNames(const Maneuver* other_maneuver,
     // and other maneuver exists
     if (HasStreetNames() && other_maneuver) {
       // other and this maneuvers have similar names
-      std::unique_ptr<StreetNames> similar_street_names =
-          other_maneuver->street_names().FindCommonBaseNames(street_names());
-      if (!similar_street_names->empty() && (street_names().size() == similar_street_names->size())) {
+      const auto similar_street_names =
+          other_maneuver->street_names().CountCommonBaseNames(street_names());
+      if (similar_street_names > 0 && (street_names().size() == similar_street_names)) {
         return true;
       }
     }
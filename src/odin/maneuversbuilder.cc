@@ -316,28 +316,43 @@ std::list<Maneuver> ManeuversBuilder::Produce() {
 void ManeuversBuilder::Combine(std::list<Maneuver>& maneuvers) {
   bool maneuvers_have_been_combined = true;
 
+  // Whether a maneuver is combined with the next one only depends on the maneuver before it and on
+  // the one after the next, so the maneuvers ahead of the first combine of a pass are decided the
+  // same way in the following pass. Each pass starts two maneuvers before the first combine of the
+  // pass before it, the end iterator marks starting from the first maneuver
+  auto pass_begin = maneuvers.end();
+
   // Continue trying to combine maneuvers until no maneuvers have been combined
   while (maneuvers_have_been_combined) {
     maneuvers_have_been_combined = false;
 
-    auto prev_man = maneuvers.begin();
-    auto curr_man = maneuvers.begin();
-    auto next_man = maneuvers.begin();
+    auto curr_man = pass_begin == maneuvers.end() ? maneuvers.begin() : pass_begin;
+    auto prev_man = curr_man == maneuvers.begin() ? curr_man : std::prev(curr_man);
+    auto next_man = curr_man;
 
     if (next_man != maneuvers.end()) {
       ++next_man;
     }
 
     while (next_man != maneuvers.end()) {
-      // Process common base names
-      std::unique_ptr<StreetNames> common_base_names =
-          curr_man->street_names().FindCommonBaseNames(next_man->street_names());
+      // Only needed for same name straight maneuvers so only looked for when it comes to those
+      std::unique_ptr<StreetNames> common_base_names;
+      const auto has_common_base_names = [&]() {
+        common_base_names = curr_man->street_names().FindCommonBaseNames(next_man->street_names());
+        return !common_base_names->empty();
+      };
 
       // Get the begin edge of the next maneuver
       auto next_man_begin_edge = trip_path_->GetCurrEdge(next_man->begin_node_index());
 
       bool is_first_man = (curr_man == maneuvers.begin());
 
+      // Where the next pass starts if this is the first combine of this one
+      const bool first_combine = !maneuvers_have_been_combined;
+      const auto combine_pass_begin =
+          prev_man == curr_man || prev_man == maneuvers.begin() ? maneuvers.end()
+                                                                : std::prev(prev_man);
+
       LOG_TRACE("+++ Combine TOP ++++++++++++++++++++++++++++++++++++++++++++");
       // Collapse the TransitConnectionStart Maneuver
       // if the transit connection stop is a simple stop (not a station)
@@ -530,7 +545,7 @@ void ManeuversBuilder::Combine(std::list<Maneuver>& maneuvers) {
       else if ((next_man->begin_relative_direction() == Maneuver::RelativeDirection::kKeepStraight) &&
                (next_man_begin_edge && !next_man_begin_edge->IsTurnChannelUse()) &&
                !next_man->internal_intersection() && !curr_man->ramp() && !next_man->ramp() &&
-               !curr_man->roundabout() && !next_man->roundabout() && !common_base_names->empty()) {
+               !curr_man->roundabout() && !next_man->roundabout() && has_common_base_names()) {
 
         LOG_TRACE("+++ Combine: Several factors +++");
         // If needed, set the begin street names
@@ -604,6 +619,10 @@ void ManeuversBuilder::Combine(std::list<Maneuver>& maneuvers) {
         ++next_man;
       }
 
+      if (first_combine && maneuvers_have_been_combined) {
+        pass_begin = combine_pass_begin;
+      }
+
       LOG_TRACE("+++ Combine BOTTOM +++++++++++++++++++++++++++++++++++++++++");
     }
   }
@@ -1472,9 +1491,7 @@ void ManeuversBuilder::FinalizeManeuver(Maneuver& maneuver, int node_index) {
       (curr_edge->name_size() > 1)) {
     std::unique_ptr<StreetNames> curr_edge_names =
         StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->name());
-    std::unique_ptr<StreetNames> common_base_names =
-        curr_edge_names->FindCommonBaseNames(maneuver.street_names());
-    if (curr_edge_names->size() > common_base_names->size()) {
+    if (curr_edge_names->size() > curr_edge_names->CountCommonBaseNames(maneuver.street_names())) {
       maneuver.set_begin_street_names(std::move(curr_edge_names));
     }
   }
@@ -2313,12 +2330,11 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
   // Determine previous edge names and common base names
   std::unique_ptr<StreetNames> prev_edge_names =
       StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), prev_edge->name());
-  std::unique_ptr<StreetNames> common_base_names =
-      prev_edge_names->FindCommonBaseNames(maneuver.street_names());
+  const bool has_common_base_names = prev_edge_names->CountCommonBaseNames(maneuver.street_names());
 
   /////////////////////////////////////////////////////////////////////////////
   // Process 'T' intersection
-  if (IsTee(node_index, prev_edge.get(), curr_edge.get(), !common_base_names->empty())) {
+  if (IsTee(node_index, prev_edge.get(), curr_edge.get(), has_common_base_names)) {
     maneuver.set_tee(true);
     LOG_TRACE("T intersection");
     return false;
@@ -2338,8 +2354,8 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process common base names
-  if (!common_base_names->empty()) {
-    maneuver.set_street_names(std::move(common_base_names));
+  if (has_common_base_names) {
+    maneuver.set_street_names(prev_edge_names->FindCommonBaseNames(maneuver.street_names()));
     return true;
   }
 
@@ -2745,14 +2761,11 @@ bool ManeuversBuilder::IsLeftPencilPointUturn(int node_index,
     std::unique_ptr<StreetNames> curr_edge_names =
         StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->name());
 
-    // Process common base names
-    std::unique_ptr<StreetNames> common_base_names =
-        prev_edge_names->FindCommonBaseNames(*curr_edge_names);
-
     // If no intersecting traversable left road exists
     // and the from and to edges have a common base name
     // then it is a left pencil point u-turn
-    if ((xedge_counts.left_traversable_outbound == 0) && !common_base_names->empty()) {
+    if ((xedge_counts.left_traversable_outbound == 0) &&
+        prev_edge_names->CountCommonBaseNames(*curr_edge_names) > 0) {
       return true;
     }
   }
@@ -2784,14 +2797,11 @@ bool ManeuversBuilder::IsRightPencilPointUturn(int node_index,
     std::unique_ptr<StreetNames> curr_edge_names =
         StreetNamesFactory::Create(trip_path_->GetCountryCode(node_index), curr_edge->name());
 
-    // Process common base names
-    std::unique_ptr<StreetNames> common_base_names =
-        prev_edge_names->FindCommonBaseNames(*curr_edge_names);
-
     // If no intersecting traversable right road exists
     // and the from and to edges have a common base name
     // then it is a right pencil point u-turn
-    if ((xedge_counts.right_traversable_outbound == 0) && !common_base_names->empty()) {
+    if ((xedge_counts.right_traversable_outbound == 0) &&
+        prev_edge_names->CountCommonBaseNames(*curr_edge_names) > 0) {
       return true;
     }
   }
@@ -3174,12 +3184,9 @@ void ManeuversBuilder::ProcessRoundabouts(std::list<Maneuver>& maneuvers) {
 
       if (!non_route_numbers->empty()) {
         // Determine if there are street name matches between incoming and outgoing names
-        std::unique_ptr<StreetNames> prev_common_base_names =
-            non_route_numbers->FindCommonBaseNames(prev_man->street_names());
-        std::unique_ptr<StreetNames> next_common_base_names =
-            non_route_numbers->FindCommonBaseNames(next_man->street_names());
         // Use roundabout name if did not match incoming and outgoing names
-        if (prev_common_base_names->empty() && next_common_base_names->empty()) {
+        if (non_route_numbers->CountCommonBaseNames(prev_man->street_names()) == 0 &&
+            non_route_numbers->CountCommonBaseNames(next_man->street_names()) == 0) {
           // Set roundabout name
           curr_man->set_street_names(std::move(non_route_numbers));
         }
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <stdexcept>
 
 #include <boost/property_tree/ptree.hpp>
@@ -35,6 +36,41 @@ std::unordered_map<K, V> as_unordered_map(boost::property_tree::ptree const& pt,
 namespace valhalla {
 namespace odin {
 
+PhraseTemplate::PhraseTemplate(const std::string& phrase) {
+  size_t text_begin = 0;
+  size_t pos = 0;
+  while ((pos = phrase.find('<', pos)) != std::string::npos) {
+    // A tag is made of upper case letters and underscores between angle brackets
+    size_t end = pos + 1;
+    while (end < phrase.size() && (std::isupper(static_cast<unsigned char>(phrase[end])) ||
+                                   phrase[end] == '_')) {
+      ++end;
+    }
+    if (end == pos + 1 || end == phrase.size() || phrase[end] != '>') {
+      pos = end;
+      continue;
+    }
+    if (pos > text_begin) {
+      tokens_.push_back({phrase.substr(text_begin, pos - text_begin), false});
+    }
+    tokens_.push_back({phrase.substr(pos, end + 1 - pos), true});
+    text_begin = pos = end + 1;
+  }
+  if (text_begin < phrase.size()) {
+    tokens_.push_back({phrase.substr(text_begin), false});
+  }
+  text_size_ = phrase.size();
+}
+
+void PhraseTemplate::Render(const PhraseTagValues& values, std::string& instruction) const {
+  instruction.clear();
+  instruction.reserve(text_size_);
+  for (const auto& token : tokens_) {
+    const std::string* value = token.is_tag ? values.Find(token.text) : nullptr;
+    instruction.append(value ? *value : token.text);
+  }
+}
+
 NarrativeDictionary::NarrativeDictionary(const std::string& language_tag,
                                          const boost::property_tree::ptree& narrative_pt) {
   this->language_tag = language_tag;
@@ -341,6 +377,12 @@ void NarrativeDictionary::Load(PhraseSet& phrase_handle,
                                const boost::property_tree::ptree& phrase_pt) {
 
   phrase_handle.phrases = as_unordered_map<std::string, std::string>(phrase_pt, kPhrasesKey);
+
+  // Split the phrases into text and tags once rather than for every instruction
+  phrase_handle.templates.clear();
+  for (const auto& phrase : phrase_handle.phrases) {
+    phrase_handle.templates.emplace(phrase.first, PhraseTemplate(phrase.second));
+  }
 }
 
 void NarrativeDictionary::Load(StartSubset& start_handle,
@@ -46,7 +46,14 @@ NarrativeBuilder::NarrativeBuilder(const Options& options,
                                    const NarrativeDictionary& dictionary,
                                    const MarkupFormatter& markup_formatter)
     : options_(options), trip_path_(trip_path), dictionary_(dictionary),
-      markup_formatter_(markup_formatter), articulated_preposition_enabled_(false) {
+      markup_formatter_(markup_formatter), articulated_preposition_enabled_(false),
+      text_instructions_(options.instruction_types().empty()),
+      verbal_instructions_(options.instruction_types().empty()) {
+  // Only form the instruction types that were asked for, all of them by default
+  for (auto type : options.instruction_types()) {
+    text_instructions_ = text_instructions_ || type == Options::text;
+    verbal_instructions_ = verbal_instructions_ || type == Options::verbal;
+  }
 }
 
 void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
@@ -58,52 +65,63 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
       case DirectionsLeg_Maneuver_Type_kStartLeft:
       case DirectionsLeg_Maneuver_Type_kFerryExit:
       case DirectionsLeg_Maneuver_Type_kPostTransitConnectionDestination: {
-        // Set instruction
-        maneuver.set_instruction(FormStartInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormStartInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctStartTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctStartTransitionInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalStartInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalStartInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kDestinationRight:
       case DirectionsLeg_Maneuver_Type_kDestination:
       case DirectionsLeg_Maneuver_Type_kDestinationLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormDestinationInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormDestinationInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(
-            FormVerbalAlertDestinationInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertDestinationInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalDestinationInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalDestinationInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kBecomes: {
         if (prev_maneuver) {
-          // Set instruction
-          maneuver.set_instruction(FormBecomesInstruction(maneuver, prev_maneuver));
+          if (text_instructions_) {
+            // Set instruction
+            maneuver.set_instruction(FormBecomesInstruction(maneuver, prev_maneuver));
+          }
 
-          // Set verbal pre transition instruction
-          maneuver.set_verbal_pre_transition_instruction(
-              FormVerbalBecomesInstruction(maneuver, prev_maneuver));
+          if (verbal_instructions_) {
+            // Set verbal pre transition instruction
+            maneuver.set_verbal_pre_transition_instruction(
+                FormVerbalBecomesInstruction(maneuver, prev_maneuver));
+          }
         }
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver,
-                                                maneuver
-                                                    .HasBeginStreetNames())); // Set verbal succinct
-                                                                              // transition
-                                                                              // instruction
+        if (verbal_instructions_) {
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kSlightRight:
@@ -112,107 +130,138 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
       case DirectionsLeg_Maneuver_Type_kSharpRight:
       case DirectionsLeg_Maneuver_Type_kSharpLeft:
       case DirectionsLeg_Maneuver_Type_kLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormTurnInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTurnInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctTurnTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctTurnTransitionInstruction(maneuver));
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertTurnInstruction(maneuver));
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertTurnInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalTurnInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalTurnInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kUturnRight:
       case DirectionsLeg_Maneuver_Type_kUturnLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormUturnInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormUturnInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctUturnTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctUturnTransitionInstruction(maneuver));
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertUturnInstruction(maneuver));
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertUturnInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalUturnInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalUturnInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kRampStraight: {
-        // Set instruction
-        maneuver.set_instruction(FormRampStraightInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormRampStraightInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(
-            FormVerbalAlertRampStraightInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertRampStraightInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalRampStraightInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalRampStraightInstruction(maneuver));
+        }
 
         // Only set verbal post if > min ramp length
         // or contains obvious maneuver
         // or has collapsed merge maneuver
         if ((maneuver.length() > kVerbalPostMinimumRampLength) ||
             maneuver.contains_obvious_maneuver() || maneuver.has_collapsed_merge_maneuver()) {
-          // Set verbal post transition instruction
-          maneuver.set_verbal_post_transition_instruction(
-              FormVerbalPostTransitionInstruction(maneuver));
+          if (verbal_instructions_) {
+            // Set verbal post transition instruction
+            maneuver.set_verbal_post_transition_instruction(
+                FormVerbalPostTransitionInstruction(maneuver));
+          }
         }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kRampRight:
       case DirectionsLeg_Maneuver_Type_kRampLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormRampInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormRampInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertRampInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertRampInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalRampInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalRampInstruction(maneuver));
+        }
 
         // Only set verbal post if > min ramp length
         // or contains obvious maneuver
         // or has collapsed merge maneuver
         if ((maneuver.length() > kVerbalPostMinimumRampLength) ||
             maneuver.contains_obvious_maneuver() || maneuver.has_collapsed_merge_maneuver()) {
-          // Set verbal post transition instruction
-          maneuver.set_verbal_post_transition_instruction(
-              FormVerbalPostTransitionInstruction(maneuver));
+          if (verbal_instructions_) {
+            // Set verbal post transition instruction
+            maneuver.set_verbal_post_transition_instruction(
+                FormVerbalPostTransitionInstruction(maneuver));
+          }
         }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kExitRight:
       case DirectionsLeg_Maneuver_Type_kExitLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormExitInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormExitInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertExitInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertExitInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalExitInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalExitInstruction(maneuver));
+        }
 
         // Only set verbal post if > min ramp length
         // or contains obvious maneuver
         // or has collapsed merge maneuver
         if ((maneuver.length() > kVerbalPostMinimumRampLength) ||
             maneuver.contains_obvious_maneuver() || maneuver.has_collapsed_merge_maneuver()) {
-          // Set verbal post transition instruction
-          maneuver.set_verbal_post_transition_instruction(
-              FormVerbalPostTransitionInstruction(maneuver));
+          if (verbal_instructions_) {
+            // Set verbal post transition instruction
+            maneuver.set_verbal_post_transition_instruction(
+                FormVerbalPostTransitionInstruction(maneuver));
+          }
         }
         break;
       }
@@ -220,49 +269,67 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
       case DirectionsLeg_Maneuver_Type_kStayRight:
       case DirectionsLeg_Maneuver_Type_kStayLeft: {
         if (maneuver.to_stay_on()) {
-          // Set stay on instruction
-          maneuver.set_instruction(FormKeepToStayOnInstruction(maneuver));
+          if (text_instructions_) {
+            // Set stay on instruction
+            maneuver.set_instruction(FormKeepToStayOnInstruction(maneuver));
+          }
 
-          // Set verbal transition alert instruction
-          maneuver.set_verbal_transition_alert_instruction(
-              FormVerbalAlertKeepToStayOnInstruction(maneuver));
+          if (verbal_instructions_) {
+            // Set verbal transition alert instruction
+            maneuver.set_verbal_transition_alert_instruction(
+                FormVerbalAlertKeepToStayOnInstruction(maneuver));
 
-          // Set verbal pre transition instruction
-          maneuver.set_verbal_pre_transition_instruction(FormVerbalKeepToStayOnInstruction(maneuver));
+            // Set verbal pre transition instruction
+            maneuver.set_verbal_pre_transition_instruction(
+                FormVerbalKeepToStayOnInstruction(maneuver));
+          }
 
           // For a ramp - only set verbal post if > min ramp length
           if (maneuver.ramp() && !maneuver.has_collapsed_merge_maneuver()) {
             if (maneuver.length() > kVerbalPostMinimumRampLength) {
+              if (verbal_instructions_) {
+                // Set verbal post transition instruction
+                maneuver.set_verbal_post_transition_instruction(
+                    FormVerbalPostTransitionInstruction(maneuver));
+              }
+            }
+          } else {
+            if (verbal_instructions_) {
               // Set verbal post transition instruction
               maneuver.set_verbal_post_transition_instruction(
                   FormVerbalPostTransitionInstruction(maneuver));
             }
-          } else {
-            // Set verbal post transition instruction
-            maneuver.set_verbal_post_transition_instruction(
-                FormVerbalPostTransitionInstruction(maneuver));
           }
         } else {
-          // Set instruction
-          maneuver.set_instruction(FormKeepInstruction(maneuver));
+          if (text_instructions_) {
+            // Set instruction
+            maneuver.set_instruction(FormKeepInstruction(maneuver));
+          }
 
-          // Set verbal transition alert instruction
-          maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertKeepInstruction(maneuver));
+          if (verbal_instructions_) {
+            // Set verbal transition alert instruction
+            maneuver.set_verbal_transition_alert_instruction(
+                FormVerbalAlertKeepInstruction(maneuver));
 
-          // Set verbal pre transition instruction
-          maneuver.set_verbal_pre_transition_instruction(FormVerbalKeepInstruction(maneuver));
+            // Set verbal pre transition instruction
+            maneuver.set_verbal_pre_transition_instruction(FormVerbalKeepInstruction(maneuver));
+          }
 
           // For a ramp - only set verbal post if > min ramp length
           if (maneuver.ramp() && !maneuver.has_collapsed_merge_maneuver()) {
             if (maneuver.length() > kVerbalPostMinimumRampLength) {
+              if (verbal_instructions_) {
+                // Set verbal post transition instruction
+                maneuver.set_verbal_post_transition_instruction(
+                    FormVerbalPostTransitionInstruction(maneuver));
+              }
+            }
+          } else {
+            if (verbal_instructions_) {
               // Set verbal post transition instruction
               maneuver.set_verbal_post_transition_instruction(
                   FormVerbalPostTransitionInstruction(maneuver));
             }
-          } else {
-            // Set verbal post transition instruction
-            maneuver.set_verbal_post_transition_instruction(
-                FormVerbalPostTransitionInstruction(maneuver));
           }
         }
         break;
@@ -270,252 +337,342 @@ void NarrativeBuilder::Build(std::list<Maneuver>& maneuvers) {
       case DirectionsLeg_Maneuver_Type_kMerge:
       case DirectionsLeg_Maneuver_Type_kMergeRight:
       case DirectionsLeg_Maneuver_Type_kMergeLeft: {
-        // Set instruction
-        maneuver.set_instruction(FormMergeInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormMergeInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctMergeTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctMergeTransitionInstruction(maneuver));
+        }
 
         // Set verbal transition alert instruction if previous maneuver
         // is greater than 2 km
         if (prev_maneuver && (prev_maneuver->length(Options::kilometers) >
                               kVerbalAlertMergePriorManeuverMinimumLength)) {
-          maneuver.set_verbal_transition_alert_instruction(FormVerbalAlertMergeInstruction(maneuver));
+          if (verbal_instructions_) {
+            maneuver.set_verbal_transition_alert_instruction(
+                FormVerbalAlertMergeInstruction(maneuver));
+          }
         }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalMergeInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalMergeInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kRoundaboutEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormEnterRoundaboutInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormEnterRoundaboutInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctEnterRoundaboutTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctEnterRoundaboutTransitionInstruction(maneuver));
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(
-            FormVerbalAlertEnterRoundaboutInstruction(maneuver));
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertEnterRoundaboutInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalEnterRoundaboutInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalEnterRoundaboutInstruction(maneuver));
+        }
 
         // If the maneuver has a combined enter exit roundabout instruction
         // then set verbal post transition instruction
         if (maneuver.has_combined_enter_exit_roundabout()) {
-          maneuver.set_verbal_post_transition_instruction(
-              FormVerbalPostTransitionInstruction(maneuver,
-                                                  maneuver.HasRoundaboutExitBeginStreetNames()));
+                                                  if (verbal_instructions_) {
+            maneuver.set_verbal_post_transition_instruction(
+                FormVerbalPostTransitionInstruction(maneuver,
+                                                    maneuver.HasRoundaboutExitBeginStreetNames()));
+                                                  }
         }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kRoundaboutExit: {
-        // Set instruction
-        maneuver.set_instruction(FormExitRoundaboutInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormExitRoundaboutInstruction(maneuver));
+        }
 
-        // Set verbal succinct transition instruction
-        maneuver.set_verbal_succinct_transition_instruction(
-            FormVerbalSuccinctExitRoundaboutTransitionInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal succinct transition instruction
+          maneuver.set_verbal_succinct_transition_instruction(
+              FormVerbalSuccinctExitRoundaboutTransitionInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalExitRoundaboutInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalExitRoundaboutInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver, maneuver.HasBeginStreetNames()));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kFerryEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormEnterFerryInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormEnterFerryInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(
-            FormVerbalAlertEnterFerryInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertEnterFerryInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalEnterFerryInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalEnterFerryInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransitConnectionStart: {
-        // Set instruction
-        maneuver.set_instruction(FormTransitConnectionStartInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitConnectionStartInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalTransitConnectionStartInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalTransitConnectionStartInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransitConnectionTransfer: {
-        // Set instruction
-        maneuver.set_instruction(FormTransitConnectionTransferInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitConnectionTransferInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalTransitConnectionTransferInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalTransitConnectionTransferInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransitConnectionDestination: {
-        // Set instruction
-        maneuver.set_instruction(FormTransitConnectionDestinationInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitConnectionDestinationInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalTransitConnectionDestinationInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalTransitConnectionDestinationInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransit: {
-        // Set depart instruction
-        maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        if (text_instructions_) {
+          // Set depart instruction
+          maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        }
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal depart instruction
+          maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        }
 
-        // Set instruction
-        maneuver.set_instruction(FormTransitInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalTransitInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalTransitInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionTransitInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionTransitInstruction(maneuver));
+        }
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        if (text_instructions_) {
+          // Set arrive instruction
+          maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        }
 
-        // Set verbal arrive instruction
-        maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal arrive instruction
+          maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        }
 
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransitRemainOn: {
-        // Set depart instruction
-        maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        if (text_instructions_) {
+          // Set depart instruction
+          maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        }
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal depart instruction
+          maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        }
 
-        // Set instruction
-        maneuver.set_instruction(FormTransitRemainOnInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitRemainOnInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalTransitRemainOnInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalTransitRemainOnInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionTransitInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionTransitInstruction(maneuver));
+        }
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        if (text_instructions_) {
+          // Set arrive instruction
+          maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        }
 
-        // Set verbal arrive instruction
-        maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal arrive instruction
+          maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        }
 
         break;
       }
       case DirectionsLeg_Maneuver_Type_kTransitTransfer: {
-        // Set depart instruction
-        maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        if (text_instructions_) {
+          // Set depart instruction
+          maneuver.set_depart_instruction(FormDepartInstruction(maneuver));
+        }
 
-        // Set verbal depart instruction
-        maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal depart instruction
+          maneuver.set_verbal_depart_instruction(FormVerbalDepartInstruction(maneuver));
+        }
 
-        // Set instruction
-        maneuver.set_instruction(FormTransitTransferInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormTransitTransferInstruction(maneuver));
+        }
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(
-            FormVerbalTransitTransferInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(
+              FormVerbalTransitTransferInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionTransitInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionTransitInstruction(maneuver));
+        }
 
-        // Set arrive instruction
-        maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        if (text_instructions_) {
+          // Set arrive instruction
+          maneuver.set_arrive_instruction(FormArriveInstruction(maneuver));
+        }
 
-        // Set verbal arrive instruction
-        maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal arrive instruction
+          maneuver.set_verbal_arrive_instruction(FormVerbalArriveInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kElevatorEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormElevatorInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormElevatorInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kStepsEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormStepsInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormStepsInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kEscalatorEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormEscalatorInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormEscalatorInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kBuildingEnter: {
-        // Set instruction
-        maneuver.set_instruction(FormEnterBuildingInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormEnterBuildingInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kBuildingExit: {
-        // Set instruction
-        maneuver.set_instruction(FormExitBuildingInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormExitBuildingInstruction(maneuver));
+        }
         break;
       }
       case DirectionsLeg_Maneuver_Type_kContinue:
       default: {
-        // Set instruction
-        maneuver.set_instruction(FormContinueInstruction(maneuver));
+        if (text_instructions_) {
+          // Set instruction
+          maneuver.set_instruction(FormContinueInstruction(maneuver));
+        }
 
-        // Set verbal transition alert instruction
-        maneuver.set_verbal_transition_alert_instruction(
-            FormVerbalAlertContinueInstruction(maneuver));
+        if (verbal_instructions_) {
+          // Set verbal transition alert instruction
+          maneuver.set_verbal_transition_alert_instruction(
+              FormVerbalAlertContinueInstruction(maneuver));
 
-        // Set verbal pre transition instruction
-        maneuver.set_verbal_pre_transition_instruction(FormVerbalContinueInstruction(maneuver));
+          // Set verbal pre transition instruction
+          maneuver.set_verbal_pre_transition_instruction(FormVerbalContinueInstruction(maneuver));
 
-        // Set verbal post transition instruction
-        maneuver.set_verbal_post_transition_instruction(
-            FormVerbalPostTransitionInstruction(maneuver));
+          // Set verbal post transition instruction
+          maneuver.set_verbal_post_transition_instruction(
+              FormVerbalPostTransitionInstruction(maneuver));
+        }
         break;
       }
     }
-    maneuver.set_instruction(FormBssManeuverType(maneuver.bss_maneuver_type()) +
-                             maneuver.instruction());
+    if (text_instructions_) {
+      maneuver.set_instruction(FormBssManeuverType(maneuver.bss_maneuver_type()) +
+                               maneuver.instruction());
+    }
 
     // Update previous maneuver
     prev_maneuver = &maneuver;
   }
 
   // Iterate over maneuvers to form verbal multi-cue instructions
-  FormVerbalMultiCue(maneuvers);
+  if (verbal_instructions_) {
+    FormVerbalMultiCue(maneuvers);
+  }
 }
 
 std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
@@ -524,14 +681,14 @@ std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
   instruction.reserve(kInstructionInitialCapacity);
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.approach_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
-                                dictionary_.approach_verbal_alert_subset.us_customary_lengths));
-  boost::replace_all(instruction, kCurrentVerbalCueTag, verbal_cue);
+  tag_values_.Set(kLengthTag,
+                  FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
+                             dictionary_.approach_verbal_alert_subset.us_customary_lengths));
+  tag_values_.Set(kCurrentVerbalCueTag, verbal_cue);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.approach_verbal_alert_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -589,13 +746,13 @@ std::string NarrativeBuilder::FormStartInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kCardinalDirectionTag, cardinal_direction);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.start_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -676,16 +833,16 @@ std::string NarrativeBuilder::FormVerbalStartInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  tag_values_.Set(kCardinalDirectionTag, cardinal_direction);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kLengthTag,
+                  FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                             dictionary_.start_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.start_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -729,15 +886,15 @@ std::string NarrativeBuilder::FormDestinationInstruction(Maneuver& maneuver) {
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_subset.phrases.at(std::to_string(phrase_id));
-
   if (phrase_id > 0) {
     // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    tag_values_.Set(kRelativeDirectionTag, relative_direction);
+    tag_values_.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.destination_subset, phrase_id, instruction);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -785,15 +942,15 @@ std::string NarrativeBuilder::FormVerbalAlertDestinationInstruction(Maneuver& ma
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
   if (phrase_id > 0) {
     // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    tag_values_.Set(kRelativeDirectionTag, relative_direction);
+    tag_values_.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.destination_verbal_alert_subset, phrase_id, instruction);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -841,15 +998,15 @@ std::string NarrativeBuilder::FormVerbalDestinationInstruction(Maneuver& maneuve
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   if (phrase_id > 0) {
     // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
+    tag_values_.Set(kRelativeDirectionTag, relative_direction);
+    tag_values_.Set(kDestinationTag, destination);
   }
 
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.destination_verbal_subset, phrase_id, instruction);
+
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
     FormArticulatedPrepositions(instruction);
@@ -871,12 +1028,12 @@ std::string NarrativeBuilder::FormBecomesInstruction(Maneuver& maneuver, Maneuve
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  tag_values_.Set(kPreviousStreetNamesTag, prev_street_names);
+  tag_values_.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.becomes_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -906,12 +1063,12 @@ std::string NarrativeBuilder::FormVerbalBecomesInstruction(Maneuver& maneuver,
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  tag_values_.Set(kPreviousStreetNamesTag, prev_street_names);
+  tag_values_.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.becomes_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -957,13 +1114,13 @@ std::string NarrativeBuilder::FormContinueInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.continue_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1013,13 +1170,13 @@ std::string NarrativeBuilder::FormVerbalAlertContinueInstruction(Maneuver& maneu
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.continue_verbal_alert_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1078,16 +1235,16 @@ std::string NarrativeBuilder::FormVerbalContinueInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
-                                dictionary_.continue_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kLengthTag,
+                  FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
+                             dictionary_.continue_verbal_subset.us_customary_lengths));
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.continue_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1163,16 +1320,16 @@ std::string NarrativeBuilder::FormTurnInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(*subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1271,16 +1428,16 @@ std::string NarrativeBuilder::FormVerbalTurnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(*subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1341,17 +1498,17 @@ std::string NarrativeBuilder::FormUturnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_subset.relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(),
+                                           dictionary_.uturn_subset.relative_directions));
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kCrossStreetNamesTag, cross_street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.uturn_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1496,15 +1653,15 @@ std::string NarrativeBuilder::FormVerbalUturnInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_dir);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kCrossStreetNamesTag, cross_street_names);
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.uturn_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1550,13 +1707,13 @@ std::string NarrativeBuilder::FormRampStraightInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.ramp_straight_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1655,13 +1812,13 @@ std::string NarrativeBuilder::FormVerbalRampStraightInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.ramp_straight_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1729,16 +1886,16 @@ std::string NarrativeBuilder::FormRampInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.ramp_subset.relative_directions));
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(),
+                                           dictionary_.ramp_subset.relative_directions));
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.ramp_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1889,14 +2046,14 @@ std::string NarrativeBuilder::FormVerbalRampInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_dir);
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.ramp_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1974,17 +2131,17 @@ std::string NarrativeBuilder::FormExitInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.exit_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(),
+                                           dictionary_.exit_subset.relative_directions));
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2145,15 +2302,15 @@ std::string NarrativeBuilder::FormVerbalExitInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_dir);
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kBranchSignTag, exit_branch_sign);
+  tag_values_.Set(kTowardSignTag, exit_toward_sign);
+  tag_values_.Set(kNameSignTag, exit_name_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2234,16 +2391,16 @@ std::string NarrativeBuilder::FormKeepInstruction(Maneuver& maneuver,
     phrase_id += 4;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(),
-                                                dictionary_.keep_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeThreeDirection(maneuver.type(),
+                                             dictionary_.keep_subset.relative_directions));
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.keep_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2425,14 +2582,14 @@ std::string NarrativeBuilder::FormVerbalKeepInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_dir);
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.keep_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2484,16 +2641,16 @@ std::string NarrativeBuilder::FormKeepToStayOnInstruction(Maneuver& maneuver,
     phrase_id += 2;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
-                                                                     .relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
+                                                                  .relative_directions));
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.keep_to_stay_on_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2583,14 +2740,14 @@ std::string NarrativeBuilder::FormVerbalKeepToStayOnInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_dir);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kNumberSignTag, exit_number_sign);
+  tag_values_.Set(kTowardSignTag, toward_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.keep_to_stay_on_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2641,13 +2798,13 @@ std::string NarrativeBuilder::FormMergeInstruction(Maneuver& maneuver,
         FormRelativeTwoDirection(maneuver.type(), dictionary_.merge_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_direction);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.merge_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2716,13 +2873,13 @@ std::string NarrativeBuilder::FormVerbalMergeInstruction(Maneuver& maneuver,
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_direction);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.merge_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2839,16 +2996,15 @@ std::string NarrativeBuilder::FormEnterRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  tag_values_.Set(kOrdinalValueTag, ordinal_value);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+  tag_values_.Set(kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
+  tag_values_.Set(kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_roundabout_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2991,16 +3147,15 @@ std::string NarrativeBuilder::FormVerbalEnterRoundaboutInstruction(Maneuver& man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  tag_values_.Set(kOrdinalValueTag, ordinal_value);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+  tag_values_.Set(kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
+  tag_values_.Set(kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_roundabout_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3054,13 +3209,13 @@ std::string NarrativeBuilder::FormExitRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_roundabout_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3118,13 +3273,13 @@ std::string NarrativeBuilder::FormVerbalExitRoundaboutInstruction(Maneuver& mane
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kBeginStreetNamesTag, begin_street_names);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_roundabout_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3168,13 +3323,13 @@ std::string NarrativeBuilder::FormEnterFerryInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kFerryLabelTag, ferry_label);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_ferry_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3235,13 +3390,13 @@ std::string NarrativeBuilder::FormVerbalEnterFerryInstruction(Maneuver& maneuver
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kStreetNamesTag, street_names);
+  tag_values_.Set(kFerryLabelTag, ferry_label);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_ferry_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3274,12 +3429,12 @@ std::string NarrativeBuilder::FormTransitConnectionStartInstruction(Maneuver& ma
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_start_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_start_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3312,13 +3467,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionStartInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_start_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3351,12 +3505,12 @@ std::string NarrativeBuilder::FormTransitConnectionTransferInstruction(Maneuver&
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_transfer_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_transfer_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3389,13 +3543,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionTransferInstruction(Man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_transfer_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3428,13 +3581,12 @@ std::string NarrativeBuilder::FormTransitConnectionDestinationInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_destination_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3467,13 +3619,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionDestinationInstruction(
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  tag_values_.Set(kTransitPlatformTag, transit_stop);
+  tag_values_.Set(kStationLabelTag, station_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_connection_destination_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3496,13 +3647,13 @@ std::string NarrativeBuilder::FormDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  tag_values_.Set(kTransitPlatformTag, transit_stop_name);
+  tag_values_.Set(kTimeTag,
+                  get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.depart_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3525,13 +3676,13 @@ std::string NarrativeBuilder::FormVerbalDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  tag_values_.Set(kTransitPlatformTag, transit_stop_name);
+  tag_values_.Set(kTimeTag,
+                  get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.depart_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3554,13 +3705,13 @@ std::string NarrativeBuilder::FormArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  tag_values_.Set(kTransitPlatformTag, transit_stop_name);
+  tag_values_.Set(kTimeTag,
+                  get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.arrive_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3583,13 +3734,13 @@ std::string NarrativeBuilder::FormVerbalArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  tag_values_.Set(kTransitPlatformTag, transit_stop_name);
+  tag_values_.Set(kTimeTag,
+                  get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.arrive_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3616,16 +3767,16 @@ std::string NarrativeBuilder::FormTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitPlatformCountTag,
+                  std::to_string(stop_count)); // TODO: locale specific numerals
+  tag_values_.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3648,14 +3799,14 @@ std::string NarrativeBuilder::FormVerbalTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_verbal_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver,
+                                  dictionary_.transit_verbal_subset.empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3683,17 +3834,17 @@ std::string NarrativeBuilder::FormTransitRemainOnInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_remain_on_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver,
+                                  dictionary_.transit_remain_on_subset.empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitPlatformCountTag,
+                  std::to_string(stop_count)); // TODO: locale specific numerals
+  tag_values_.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_remain_on_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3716,14 +3867,14 @@ std::string NarrativeBuilder::FormVerbalTransitRemainOnInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
+                                                .empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_remain_on_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3751,17 +3902,17 @@ std::string NarrativeBuilder::FormTransitTransferInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_transfer_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver,
+                                  dictionary_.transit_transfer_subset.empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitPlatformCountTag,
+                  std::to_string(stop_count)); // TODO: locale specific numerals
+  tag_values_.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_transfer_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3784,14 +3935,14 @@ std::string NarrativeBuilder::FormVerbalTransitTransferInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  tag_values_.Set(kTransitNameTag,
+                  FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
+                                                .empty_transit_name_labels));
+  tag_values_.Set(kTransitHeadSignTag, transit_headsign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.transit_transfer_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3832,14 +3983,14 @@ std::string NarrativeBuilder::FormVerbalPostTransitionInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transition_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  tag_values_.Set(kLengthTag,
+                  FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                             dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  tag_values_.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.post_transition_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3860,14 +4011,13 @@ std::string NarrativeBuilder::FormVerbalPostTransitionTransitInstruction(Maneuve
       FormTransitPlatformCountLabel(stop_count, dictionary_.post_transition_transit_verbal_subset
                                                     .transit_stop_count_labels);
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.post_transition_transit_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  tag_values_.Set(kTransitPlatformCountTag,
+                  std::to_string(stop_count)); // TODO: locale specific numerals
+  tag_values_.Set(kTransitPlatformCountLabelTag, stop_count_label);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.post_transition_transit_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3911,14 +4061,14 @@ std::string NarrativeBuilder::FormVerbalSuccinctStartTransitionInstruction(Maneu
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  tag_values_.Set(kCardinalDirectionTag, cardinal_direction);
+  tag_values_.Set(kLengthTag,
+                  FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                             dictionary_.start_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.start_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3977,14 +4127,14 @@ NarrativeBuilder::FormVerbalSuccinctTurnTransitionInstruction(Maneuver& maneuver
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(*subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4023,15 +4173,16 @@ NarrativeBuilder::FormVerbalSuccinctUturnTransitionInstruction(Maneuver& maneuve
         maneuver.signs().GetJunctionNameString(element_max_count, limit_by_consecutive_count, delim,
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
 
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_verbal_subset.relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag,
+                  FormRelativeTwoDirection(maneuver.type(),
+                                           dictionary_.uturn_verbal_subset.relative_directions));
+  tag_values_.Set(kJunctionNameTag, junction_name);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.uturn_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4075,12 +4226,12 @@ NarrativeBuilder::FormVerbalSuccinctMergeTransitionInstruction(Maneuver& maneuve
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kRelativeDirectionTag, relative_direction);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.merge_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4123,12 +4274,12 @@ std::string NarrativeBuilder::FormVerbalSuccinctEnterRoundaboutTransitionInstruc
                                                         &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  tag_values_.Set(kOrdinalValueTag, ordinal_value);
+  tag_values_.Set(kTowardSignTag, guide_sign);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_roundabout_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4159,10 +4310,10 @@ std::string NarrativeBuilder::FormVerbalSuccinctExitRoundaboutTransitionInstruct
                                                  maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  tag_values_.Set(kTowardSignTag, guide_sign);
 
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_roundabout_verbal_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4188,11 +4339,11 @@ std::string NarrativeBuilder::FormElevatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.elevator_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  tag_values_.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.elevator_subset, phrase_id, instruction);
 
   return instruction;
 }
@@ -4213,11 +4364,11 @@ std::string NarrativeBuilder::FormStepsInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.steps_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  tag_values_.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.steps_subset, phrase_id, instruction);
 
   return instruction;
 }
@@ -4238,11 +4389,11 @@ std::string NarrativeBuilder::FormEscalatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.escalator_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  tag_values_.Set(kLevelTag, end_level);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.escalator_subset, phrase_id, instruction);
 
   return instruction;
 }
@@ -4265,11 +4416,11 @@ std::string NarrativeBuilder::FormEnterBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_building_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  tag_values_.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.enter_building_subset, phrase_id, instruction);
 
   return instruction;
 }
@@ -4292,11 +4443,11 @@ std::string NarrativeBuilder::FormExitBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_building_subset.phrases.at(std::to_string(phrase_id));
-
   // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  tag_values_.Set(kStreetNamesTag, street_names);
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.exit_building_subset, phrase_id, instruction);
 
   return instruction;
 }
@@ -4720,14 +4871,16 @@ std::string NarrativeBuilder::FormVerbalMultiCue(Maneuver& maneuver,
   if (maneuver.distant_verbal_multi_cue()) {
     phrase_id = 1;
   }
-  instruction = dictionary_.verbal_multi_cue_subset.phrases.at(std::to_string(phrase_id));
 
   // Replace phrase tags with values
-  boost::replace_all(instruction, kCurrentVerbalCueTag, first_verbal_cue);
-  boost::replace_all(instruction, kNextVerbalCueTag, second_verbal_cue);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  tag_values_.Set(kCurrentVerbalCueTag, first_verbal_cue);
+  tag_values_.Set(kNextVerbalCueTag, second_verbal_cue);
+  tag_values_.Set(kLengthTag,
+                  FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
+                             dictionary_.post_transition_verbal_subset.us_customary_lengths));
+
+  // Set instruction to the determined tagged phrase
+  FormPhrase(dictionary_.verbal_multi_cue_subset, phrase_id, instruction);
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4826,5 +4979,12 @@ std::string NarrativeBuilder::FormBssManeuverType(DirectionsLeg_Maneuver_BssMane
       return "";
   }
 }
+
+void NarrativeBuilder::FormPhrase(const PhraseSet& subset,
+                                  uint8_t phrase_id,
+                                  std::string& instruction) {
+  subset.templates.at(std::to_string(phrase_id)).Render(tag_values_, instruction);
+  tag_values_.clear();
+}
 } // namespace odin
 } // namespace valhalla
@@ -6,6 +6,8 @@
 
 #include <cctype>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <sstream>
 
@@ -37,37 +39,65 @@ constexpr size_t kScriptIndex = 2;
 constexpr size_t kRegionIndex = 3;
 constexpr size_t kPrivateuseIndex = 4;
 
-valhalla::odin::locales_singleton_t load_narrative_locals() {
-  valhalla::odin::locales_singleton_t locales;
-  // for each locale
-  for (const auto& json : locales_json) {
-    LOG_TRACE("LOCALES");
-    LOG_TRACE("-------");
-    LOG_TRACE("- " + json.first);
+// A locale whose dictionary is only built the first time it is asked for
+struct locale_entry_t {
+  const std::string* name;
+  const std::string* json;
+  std::once_flag loaded;
+  std::shared_ptr<const valhalla::odin::NarrativeDictionary> dictionary;
+};
+
+// Every locale by its name and its aliases, which only takes reading the aliases of each json
+struct locale_index_t {
+  std::vector<std::unique_ptr<locale_entry_t>> entries;
+  std::unordered_map<std::string, locale_entry_t*> names;
+
+  locale_index_t() {
+    entries.reserve(locales_json.size());
+    for (const auto& json : locales_json) {
+      entries.emplace_back(new locale_entry_t{&json.first, &json.second, {}, {}});
+      names.emplace(json.first, entries.back().get());
+    }
+    // aliases go in once all names are there so that one clashing with a name is caught
+    for (const auto& entry : entries) {
+      rapidjson::Document doc;
+      doc.Parse(entry->json->c_str());
+      const auto* aliases = doc.HasParseError() ? nullptr : rapidjson::Pointer("/aliases").Get(doc);
+      if (!aliases || !aliases->IsArray()) {
+        throw std::logic_error("Json locale '" + *entry->name + "' has no aliases");
+      }
+      for (const auto& alias : aliases->GetArray()) {
+        const std::string name = alias.IsString() ? alias.GetString() : "";
+        auto inserted = names.emplace(name, entry.get());
+        if (!inserted.second) {
+          throw std::logic_error("Alias '" + name + "' in json locale '" + *entry->name +
+                                 "' has duplicate with locale '" + *inserted.first->second->name +
+                                 "'");
+        }
+      }
+    }
+  }
+};
+
+const locale_index_t& get_locale_index() {
+  // thread safe static initializer for singleton
+  static const locale_index_t index;
+  return index;
+}
+
+const std::shared_ptr<const valhalla::odin::NarrativeDictionary>& load(locale_entry_t& entry) {
+  std::call_once(entry.loaded, [&entry]() {
+    LOG_TRACE("Loading locale " + *entry.name);
     // load the json
     boost::property_tree::ptree narrative_pt;
     std::stringstream ss;
-    ss << json.second;
+    ss << *entry.json;
     rapidjson::read_json(ss, narrative_pt);
-    LOG_TRACE("JSON read");
-    // parse it into an object and add it to the map
-    auto narrative_dictionary =
-        std::make_shared<valhalla::odin::NarrativeDictionary>(json.first, narrative_pt);
-    LOG_TRACE("NarrativeDictionary created");
-    locales.insert(std::make_pair(json.first, narrative_dictionary));
-    // insert all the aliases as this same object
-    auto aliases = narrative_pt.get_child("aliases");
-    for (const auto& alias : aliases) {
-      auto name = alias.second.get_value<std::string>();
-      auto inserted = locales.insert(std::make_pair(name, narrative_dictionary));
-      if (!inserted.second) {
-        throw std::logic_error("Alias '" + name + "' in json locale '" + json.first +
-                               "' has duplicate with posix_locale '" +
-                               inserted.first->second->GetLocale().name());
-      }
-    }
-  }
-  return locales;
+    // parse it into an object which from here on is only read
+    entry.dictionary =
+        std::make_shared<const valhalla::odin::NarrativeDictionary>(*entry.name, narrative_pt);
+  });
+  return entry.dictionary;
 }
 
 } // namespace
@@ -145,9 +175,33 @@ std::string get_localized_date(const std::string& date_time, const std::locale&
   return date::format(locale, "%x", local_tp);
 }
 
+std::shared_ptr<const NarrativeDictionary> get_locale(const std::string& locale) {
+  const auto& names = get_locale_index().names;
+  auto found = names.find(locale);
+  return found == names.cend() ? nullptr : load(*found->second);
+}
+
+bool is_locale_supported(const std::string& locale) {
+  return get_locale_index().names.count(locale) > 0;
+}
+
+void preload_locales(const std::vector<std::string>& locales) {
+  for (const auto& locale : locales) {
+    if (!get_locale(locale)) {
+      LOG_WARN("Unknown locale '" + locale + "' is not preloaded");
+    }
+  }
+}
+
 const locales_singleton_t& get_locales() {
-  // thread safe static initializer for singleton
-  static locales_singleton_t locales(load_narrative_locals());
+  // thread safe static initializer for singleton, the names and aliases of a locale share it
+  static const locales_singleton_t locales([]() {
+    locales_singleton_t locales;
+    for (const auto& name : get_locale_index().names) {
+      locales.emplace(name.first, load(*name.second));
+    }
+    return locales;
+  }());
   return locales;
 }
 
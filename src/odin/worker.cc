@@ -28,7 +28,15 @@ namespace valhalla {
 namespace odin {
 
 odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config)
-    : service_worker_t(config), markup_formatter_(config) {
+    : service_worker_t(config), markup_formatter_(config),
+      directions_threads_(config.get<uint32_t>("odin.directions_threads", 1)) {
+  // the narrative locales are loaded when first asked for, unless they are to be ready up front
+  std::vector<std::string> locales;
+  for (const auto& kv : config.get_child("odin.preload_locales", {})) {
+    locales.push_back(kv.second.get_value<std::string>());
+  }
+  preload_locales(locales);
+
   // signal that the worker started successfully
   started();
 }
@@ -42,10 +50,11 @@ std::string odin_worker_t::narrate(Api& request) const {
 
   // get some annotated directions
   try {
-    odin::DirectionsBuilder().Build(request, markup_formatter_);
+    odin::DirectionsBuilder().Build(request, markup_formatter_, directions_threads_);
   } catch (...) { throw valhalla_exception_t{202}; }
 
   // serialize those to the proper format
+  auto serialization = measure_phase(request, "tyr.serialize");
   return tyr::serializeDirections(request);
 }
 
@@ -67,7 +76,7 @@ odin_worker_t::work(const std::list<zmq::message_t>& job,
                     const std::function<void()>& interrupt_function) {
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Odin Request " + std::to_string(info.id));
-  Api request;
+  Api& request = api_arena.next();
   prime_server::worker_t::result_t result{false, {}, {}};
   try {
     // Set the interrupt function
@@ -377,6 +377,18 @@ bool Options_ExpansionProperties_Enum_Parse(const std::string& prop,
   return true;
 }
 
+bool Options_InstructionType_Enum_Parse(const std::string& type, Options::InstructionType* t) {
+  static const std::unordered_map<std::string, Options::InstructionType> types{
+      {"text", Options::text},
+      {"verbal", Options::verbal},
+  };
+  auto i = types.find(type);
+  if (i == types.cend())
+    return false;
+  *t = i->second;
+  return true;
+}
+
 const std::unordered_map<int, std::string> vehicle_to_string{
     {static_cast<int>(VehicleType::kCar), "car"},
     {static_cast<int>(VehicleType::kMotorcycle), "motorcycle"},
@@ -140,6 +140,10 @@ public:
   virtual ~AutoCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<AutoCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
@@ -340,6 +344,11 @@ public:
 
   // Density factor used in edge transition costing
   std::vector<float> trans_density_factor_;
+
+  // The highway and surface terms of the edge factor baked for these options, by road class and
+  // by surface, so that edge costing only looks them up
+  float road_class_factor_[sizeof(kHighwayFactor) / sizeof(kHighwayFactor[0])];
+  float surface_type_factor_[sizeof(kSurfaceFactor) / sizeof(kSurfaceFactor[0])];
 };
 
 // Constructor
@@ -418,6 +427,14 @@ AutoCost::AutoCost(const Costing& costing, uint32_t access_mask)
   for (uint32_t d = 0; d < 16; d++) {
     density_factor_[d] = 0.85f + (d * 0.025f);
   }
+
+  // Bake the road class and surface terms of the edge factor
+  for (size_t c = 0; c < sizeof(kHighwayFactor) / sizeof(kHighwayFactor[0]); ++c) {
+    road_class_factor_[c] = highway_factor_ * kHighwayFactor[c];
+  }
+  for (size_t s = 0; s < sizeof(kSurfaceFactor) / sizeof(kSurfaceFactor[0]); ++s) {
+    surface_type_factor_[s] = surface_factor_ * kSurfaceFactor[s];
+  }
 }
 
 // Check if access is allowed on the specified edge.
@@ -519,8 +536,8 @@ Cost AutoCost::EdgeCost(const baldr::DirectedEdge* edge,
       break;
   }
 
-  factor += highway_factor_ * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
-            surface_factor_ * kSurfaceFactor[static_cast<uint32_t>(edge->surface())] +
+  factor += road_class_factor_[static_cast<uint32_t>(edge->classification())] +
+            surface_type_factor_[static_cast<uint32_t>(edge->surface())] +
             SpeedPenalty(edge, tile, time_info, flow_sources, edge_speed) +
             edge->toll() * toll_factor_;
 
@@ -733,6 +750,10 @@ public:
   virtual ~BusCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<BusCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -864,6 +885,10 @@ public:
   virtual ~TaxiCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<TaxiCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -1049,9 +1074,13 @@ public:
   using AutoCost::gate_cost_;
   using AutoCost::height_;
   using AutoCost::maneuver_penalty_;
+  using AutoCost::node_class;
+  using AutoCost::node_transition_costs_;
+  using AutoCost::private_access_cost_;
   using AutoCost::service_factor_;
   using AutoCost::service_penalty_;
   using AutoCost::toll_booth_cost_;
+  using AutoCost::use_transition_costs_;
   using AutoCost::width_;
 };
 
@@ -1262,6 +1291,36 @@ TEST(AutoCost, testAutoCostParams) {
     EXPECT_EQ(tester->flow_mask_, expected);
   }
 }
+
+TEST(AutoCost, testTransitionTables) {
+  auto tester = make_autocost_from_json("gate_penalty", 42);
+  const auto node_cost = [&tester](baldr::NodeType type, bool private_access, bool tagged) {
+    baldr::NodeInfo node;
+    node.set_type(type);
+    node.set_private_access(private_access);
+    node.set_tagged_access(tagged);
+    return tester->node_transition_costs_[tester->node_class(&node)];
+  };
+
+  EXPECT_EQ(node_cost(baldr::NodeType::kStreetIntersection, false, false).cost, 0.f);
+  EXPECT_EQ(node_cost(baldr::NodeType::kGate, false, false).cost, tester->gate_cost_.cost);
+  EXPECT_EQ(node_cost(baldr::NodeType::kGate, false, true).cost, 0.f);
+  EXPECT_EQ(node_cost(baldr::NodeType::kGate, true, false).cost,
+            tester->gate_cost_.cost + tester->private_access_cost_.cost);
+  EXPECT_EQ(node_cost(baldr::NodeType::kBollard, true, true).secs,
+            tester->private_access_cost_.secs);
+  EXPECT_EQ(node_cost(baldr::NodeType::kBorderControl, false, false).secs,
+            tester->country_crossing_cost_.secs);
+
+  const auto use_cost = [&tester](baldr::Use use) {
+    return tester->use_transition_costs_[static_cast<size_t>(use)];
+  };
+  EXPECT_EQ(use_cost(baldr::Use::kFerry).secs, tester->ferry_transition_cost_.secs);
+  EXPECT_EQ(use_cost(baldr::Use::kAlley).cost, tester->alley_penalty_);
+  EXPECT_EQ(use_cost(baldr::Use::kAlley).secs, 0.f);
+  EXPECT_EQ(use_cost(baldr::Use::kServiceRoad).cost, tester->service_penalty_);
+  EXPECT_EQ(use_cost(baldr::Use::kRoad).cost, 0.f);
+}
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -236,6 +236,10 @@ public:
   virtual ~BicycleCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<BicycleCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -1,4 +1,5 @@
 #include <boost/optional.hpp>
+#include <unordered_map>
 #include <utility>
 
 #include "baldr/graphconstants.h"
@@ -485,15 +486,36 @@ void ParseBaseCostOptions(const rapidjson::Value& json,
 void ParseCosting(const rapidjson::Document& doc,
                   const std::string& costing_options_key,
                   Options& options) {
+  // every costing parsed from nothing, which is what most of the costings of a request get since it
+  // only specifies the options of the costing it uses if any
+  static const auto defaults = []() {
+    std::unordered_map<int, Costing> defaults;
+    const rapidjson::Document empty;
+    for (auto i = Costing::Type_MIN; i <= Costing::Type_MAX; i = Costing::Type(i + 1)) {
+      if (!valhalla::Costing_Enum_Name(i).empty()) {
+        ParseCosting(empty, "/costing_options/" + valhalla::Costing_Enum_Name(i), &defaults[i], i);
+      }
+    }
+    return defaults;
+  }();
+
   // if specified, get the costing options in there
+  auto json = rapidjson::get_child_optional(doc, costing_options_key.c_str());
   for (auto i = Costing::Type_MIN; i <= Costing::Type_MAX; i = Costing::Type(i + 1)) {
     // Create the costing options key
     const auto& costing_str = valhalla::Costing_Enum_Name(i);
     if (costing_str.empty())
       continue;
+    // Without json or pbf options for the costing it gets the defaults, no need to parse them
+    auto& costings = *options.mutable_costings();
+    if ((!json || !json->IsObject() || !json->HasMember(costing_str.c_str())) &&
+        costings.find(i) == costings.end()) {
+      costings[i] = defaults.at(i);
+      continue;
+    }
     const auto key = costing_options_key + "/" + costing_str;
     // Parse the costing options
-    auto& costing = (*options.mutable_costings())[i];
+    auto& costing = costings[i];
     ParseCosting(doc, key, &costing, i);
   }
 }
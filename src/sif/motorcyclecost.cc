@@ -106,6 +106,10 @@ public:
 
   virtual ~MotorcycleCost();
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<MotorcycleCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
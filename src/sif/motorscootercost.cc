@@ -159,6 +159,10 @@ public:
   virtual ~MotorScooterCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<MotorScooterCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
@@ -37,6 +37,10 @@ public:
   virtual ~NoCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<NoCost>(*this);
+  }
+
   /**
    * Checks if access is allowed for the provided directed edge.
    * This is generally based on mode of travel and the access modes
@@ -248,6 +248,10 @@ public:
   virtual ~PedestrianCost() {
   }
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<PedestrianCost>(*this);
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed hierarchy
    * limits).
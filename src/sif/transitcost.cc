@@ -67,6 +67,10 @@ public:
 
   virtual ~TransitCost();
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<TransitCost>(*this);
+  }
+
   /**
    * Get the wheelchair required flag.
    * @return  Returns true if wheelchair is required.
@@ -125,6 +125,10 @@ public:
 
   virtual ~TruckCost();
 
+  std::shared_ptr<DynamicCost> Clone() const override {
+    return std::make_shared<TruckCost>(*this);
+  }
+
   /**
    * Does the costing allow hierarchy transitions. Truck costing will allow
    * transitions by default.
@@ -304,6 +308,9 @@ public:
 
   // Density factor used in edge transition costing
   std::vector<float> trans_density_factor_;
+
+  // The highway term of the edge factor baked for these options by road class
+  float road_class_factor_[sizeof(kHighwayFactor) / sizeof(kHighwayFactor[0])];
 };
 
 // Constructor
@@ -361,6 +368,11 @@ TruckCost::TruckCost(const Costing& costing)
   for (uint32_t d = 0; d < 16; d++) {
     density_factor_[d] = 0.85f + (d * 0.025f);
   }
+
+  // Bake the road class term of the edge factor
+  for (size_t c = 0; c < sizeof(kHighwayFactor) / sizeof(kHighwayFactor[0]); ++c) {
+    road_class_factor_[c] = highway_factor_ * kHighwayFactor[c];
+  }
 }
 
 // Destructor
@@ -496,7 +508,7 @@ Cost TruckCost::EdgeCost(const baldr::DirectedEdge* edge,
       break;
     default:
       factor = density_factor_[edge->density()] +
-               highway_factor_ * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
+               road_class_factor_[static_cast<uint32_t>(edge->classification())] +
                kSurfaceFactor[static_cast<uint32_t>(edge->surface())] +
                SpeedPenalty(edge, tile, time_info, flow_sources, edge_speed);
       break;
@@ -1,11 +1,14 @@
 #include "skadi/sample.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <fstream>
 #include <future>
 #include <limits>
 #include <list>
+#include <numeric>
 #include <optional>
 #include <regex>
 #include <set>
@@ -59,17 +62,29 @@ enum class format_t { UNKNOWN = 0, RAW = 1, GZIP = 2, LZ4 = 3 };
 
 class cache_item_t {
 private:
-  format_t format;
+  std::atomic<format_t> format;
   valhalla::midgard::mem_map<char> data;
-  int usages;
-  const char* unpacked;
+  // the tile bytes, either mapped from its own file or pointing into the extract
+  const char* bytes;
+  size_t bytes_size;
+  // set once bytes are mapped so that they can be read without holding the cache lock
+  std::atomic<bool> mapped;
+  std::atomic<int> usages;
+  // only published once the tile is completely unpacked
+  std::atomic<const char*> unpacked;
 
 public:
-  cache_item_t() : format(format_t::UNKNOWN), usages(0), unpacked(nullptr) {
+  cache_item_t()
+      : format(format_t::UNKNOWN), bytes(nullptr), bytes_size(0), mapped(false), usages(0),
+        unpacked(nullptr) {
+  }
+  cache_item_t(cache_item_t&& other)
+      : format(other.format.load()), data(std::move(other.data)), bytes(other.bytes),
+        bytes_size(other.bytes_size), mapped(other.mapped.load()), usages(other.usages.load()),
+        unpacked(other.unpacked.exchange(nullptr)) {
   }
-  cache_item_t(cache_item_t&&) = default;
   ~cache_item_t() {
-    free((void*)unpacked);
+    free((void*)unpacked.load());
   }
 
   bool init(const std::string& path, format_t format) {
@@ -79,44 +94,59 @@ public:
     }
     this->format = format;
     data.map(path, size, POSIX_MADV_SEQUENTIAL, true);
+    bytes = data.get();
+    bytes_size = data.size();
+    mapped = true;
+    return true;
+  }
+
+  bool init(const char* extract_bytes, size_t size, format_t format) {
+    if (format == format_t::RAW && size != HGT_BYTES) {
+      return false;
+    }
+    this->format = format;
+    bytes = extract_bytes;
+    bytes_size = size;
+    mapped = true;
     return true;
   }
 
   inline const char* get_data() const {
-    return data.get();
+    return mapped ? bytes : nullptr;
   }
 
   inline format_t get_format() const {
     return format;
   }
 
-  inline int& get_usages() {
+  inline std::atomic<int>& get_usages() {
     return usages;
   }
 
-  inline const char* get_unpacked() {
+  inline const char* get_unpacked() const {
     return unpacked;
   }
 
   inline const char* detach_unpacked() {
-    auto rv = unpacked;
-    unpacked = nullptr;
-    return rv;
+    return unpacked.exchange(nullptr);
   }
 
-  bool unpack(const char* unpacked) {
-    this->unpacked = unpacked;
+  inline void attach_unpacked(const char* buffer) {
+    unpacked = buffer;
+  }
 
+  // unpacks into the buffer, which is not attached to the item so that no one sees it half done
+  bool unpack(char* buffer) {
     if (format == format_t::GZIP) {
       // for setting where to read compressed data from
       auto src_func = [this](z_stream& s) -> void {
-        s.next_in = static_cast<Byte*>(static_cast<void*>(data.get()));
-        s.avail_in = static_cast<unsigned int>(data.size());
+        s.next_in = static_cast<Byte*>(static_cast<void*>(const_cast<char*>(bytes)));
+        s.avail_in = static_cast<unsigned int>(bytes_size);
       };
 
       // for setting where to write the uncompressed data to
-      auto dst_func = [this](z_stream& s) -> int {
-        s.next_out = (Byte*)(this->unpacked);
+      auto dst_func = [buffer](z_stream& s) -> int {
+        s.next_out = (Byte*)buffer;
         s.avail_out = HGT_BYTES;
         return Z_FINISH; // we know the output will hold all the input
       };
@@ -133,13 +163,13 @@ public:
       LZ4F_createDecompressionContext(&decode, LZ4F_VERSION);
 
       // Take these two values locally, since LZ4F_decompress expects pointers...
-      size_t src_size = data.size();
+      size_t src_size = bytes_size;
       size_t dest_size = HGT_BYTES;
       size_t result;
 
       do {
-        result = LZ4F_decompress(decode, const_cast<char*>(this->unpacked), &dest_size, data.get(),
-                                 &src_size, &options);
+        result =
+            LZ4F_decompress(decode, buffer, &dest_size, bytes, &src_size, &options);
         if (LZ4F_isError(result)) {
           LZ4F_freeDecompressionContext(decode);
           LOG_WARN("Corrupt lz4 elevation data");
@@ -277,6 +307,38 @@ public:
     // if we were missing some we need to adjust by that
     return value / adjust;
   }
+
+  // same as above but for a run of fractional pixels at once. the branches are replaced with
+  // selects so that the compiler can spread the loop over simd lanes
+  void get(const double* u, const double* v, double* values, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+      size_t x = std::floor(u[i]);
+      size_t y = std::floor(v[i]);
+
+      double u_ratio = u[i] - x;
+      double v_ratio = v[i] - y;
+      double u_inv = 1 - u_ratio;
+      double v_inv = 1 - v_ratio;
+
+      // the last row has nothing below it so we read it twice and give the second read no weight
+      bool last_row = y >= HGT_DIM - 1;
+      size_t below = last_row ? y : y + 1;
+
+      auto a = flip(data[y * HGT_DIM + x]);
+      auto b = flip(data[y * HGT_DIM + x + 1]);
+      auto c = flip(data[below * HGT_DIM + x]);
+      auto d = flip(data[below * HGT_DIM + x + 1]);
+      double a_coef = out_of_range(a) ? 0 : u_inv * v_inv;
+      double b_coef = out_of_range(b) ? 0 : u_ratio * v_inv;
+      double c_coef = last_row || out_of_range(c) ? 0 : u_inv * v_ratio;
+      double d_coef = last_row || out_of_range(d) ? 0 : u_ratio * v_ratio;
+
+      // summed in the same order as the single sample so both give identical results
+      double value = (a * a_coef + b * b_coef) + (c * c_coef + d * d_coef);
+      double adjust = (a_coef + b_coef) + (c_coef + d_coef);
+      values[i] = adjust == 0 ? get_no_data_value() : value / adjust;
+    }
+  }
 };
 
 struct cache_t {
@@ -287,18 +349,19 @@ struct cache_t {
   // Map of pending tiles. No matter how many requests received, only one inflate job per tile
   // started.
   std::unordered_map<uint16_t, std::shared_future<tile_data>> pending_tiles;
-  // Guards access to the pending_tiles
-  std::recursive_mutex mutex;
+  // Guards access to the pending_tiles, reusable and lazy mapping of tiles. Tiles which are raw or
+  // already unpacked are handed out without it
+  std::mutex mutex;
   // Elevation tile path
   std::string data_source;
+  // Tar of decompressed tiles which are used straight from the mapping
+  std::unique_ptr<midgard::tar> extract;
 
   void increment_usages(uint16_t index) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
     cache[index].get_usages()++;
   }
 
   void decrement_usages(uint16_t index) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
     cache[index].get_usages()--;
   }
 
@@ -317,21 +380,24 @@ bool cache_t::insert(size_t pos, const std::string& path, format_t format) {
   if (pos >= cache.size())
     return false;
 
-  std::lock_guard<std::recursive_mutex> lock(mutex);
+  std::lock_guard<std::mutex> lock(mutex);
   return cache[pos].init(path, format);
 }
 
 tile_data cache_t::source(uint16_t index) {
   // bail if it's out of bounds
-  if (index >= TILE_COUNT) {
+  if (index >= cache.size()) {
     return {};
   }
 
   // if we don't have anything maybe it's lazy loaded
   auto& item = cache[index];
-  if (item.get_data() == nullptr) {
-    auto f = data_source + get_hgt_file_name(index);
-    item.init(f, format_t::RAW);
+  if (item.get_data() == nullptr && !data_source.empty()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (item.get_data() == nullptr) {
+      auto f = data_source + get_hgt_file_name(index);
+      item.init(f, format_t::RAW);
+    }
   }
 
   // it wasn't in cache and when we tried to load it the file was of unknown type
@@ -344,50 +410,69 @@ tile_data cache_t::source(uint16_t index) {
     return {this, index, false, (const int16_t*)item.get_data()};
   }
 
+  // item in cache is already unpacked. we take a usage before looking at the buffer while eviction
+  // detaches the buffer before looking at the usages, so one of us always sees the other
+  item.get_usages()++;
+  if (const char* unpacked = item.get_unpacked()) {
+    tile_data rv(this, index, true, (const int16_t*)unpacked);
+    item.get_usages()--;
+    return rv;
+  }
+  item.get_usages()--;
+
   // we were able to load it but the format wasn't RAW, which only leaves compressed formats
-  mutex.lock();
+  std::unique_lock<std::mutex> lock(mutex);
   auto it = pending_tiles.find(index);
   if (it != pending_tiles.end()) {
     auto future = it->second;
-    mutex.unlock();
+    lock.unlock();
     return future.get();
   }
 
-  // item in cache is already unpacked
-  const char* unpacked = item.get_unpacked();
-  if (unpacked) {
-    auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-    mutex.unlock();
-    return rv;
+  // it may have been unpacked, or put back by an eviction, while we waited for the lock
+  if (const char* unpacked = item.get_unpacked()) {
+    return {this, index, true, (const int16_t*)unpacked};
+  }
+  if (item.get_format() == format_t::UNKNOWN) {
+    return {};
   }
 
   std::promise<tile_data> promise;
   it = pending_tiles.emplace(index, promise.get_future()).first;
 
+  char* buffer = nullptr;
   if (reusable.size() >= UNPACKED_TILES_COUNT) {
-    for (auto i : reusable) {
-      if (cache[i].get_usages() <= 0) {
+    for (auto i = reusable.begin(); i != reusable.end(); ++i) {
+      auto* detached = cache[*i].detach_unpacked();
+      if (cache[*i].get_usages() <= 0) {
+        buffer = const_cast<char*>(detached);
         reusable.erase(i);
-        unpacked = cache[i].detach_unpacked();
         break;
       }
+      cache[*i].attach_unpacked(detached);
     }
   }
-  if (!unpacked) {
-    unpacked = (char*)malloc(HGT_BYTES);
+  if (!buffer) {
+    buffer = (char*)malloc(HGT_BYTES);
   }
   reusable.insert(index);
-  auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-  mutex.unlock();
+  auto rv = tile_data(this, index, true, (const int16_t*)buffer);
+  lock.unlock();
 
-  if (!item.unpack(unpacked)) {
+  bool unpacked = item.unpack(buffer);
+  if (unpacked) {
+    item.attach_unpacked(buffer);
+  } else {
     rv = tile_data();
+    free(buffer);
   }
 
-  mutex.lock();
+  lock.lock();
+  if (!unpacked) {
+    reusable.erase(index);
+  }
   promise.set_value(rv);
   pending_tiles.erase(it);
-  mutex.unlock();
   return rv;
 }
 
@@ -428,6 +513,11 @@ sample::sample(const boost::property_tree::ptree& pt)
 
   // this line used only for testing, for more details check elevation_builder.cc
   remote_path_ = pt.get<std::string>("additional_data.elevation_dir", "");
+
+  auto extract = pt.get<std::string>("additional_data.elevation_extract", "");
+  if (!extract.empty()) {
+    extract_initialisation(extract);
+  }
 }
 
 sample::sample(const std::string& data_source) {
@@ -446,18 +536,8 @@ template <class coord_t> double sample::get(const coord_t& coord, tile_data& til
   auto index = static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
 
   // the caller can pass a cached tile, so we only fetch one if its not the one they already have
-  if (index != tile.get_index()) {
-    {
-      std::lock_guard<std::mutex> _(cache_lck);
-      tile = cache_->source(index);
-    }
-    if (!tile) {
-      if (!fetch(index))
-        return get_no_data_value();
-
-      if (!(tile = cache_->source(index)))
-        return get_no_data_value();
-    }
+  if (index != tile.get_index() && !get_tile(index, tile)) {
+    return get_no_data_value();
   }
 
   // figure out what row and column we need from the array of data
@@ -476,17 +556,106 @@ template <class coord_t> double sample::get(const coord_t& coord) {
 }
 
 template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) {
-  std::vector<double> values;
-  values.reserve(coords.size());
+  // work out the tile and fractional pixel of every posting up front
+  std::vector<uint16_t> tiles;
+  std::vector<double> us, vs;
+  tiles.reserve(coords.size());
+  us.reserve(coords.size());
+  vs.reserve(coords.size());
+  for (const auto& coord : coords) {
+    auto lon = std::floor(coord.first);
+    auto lat = std::floor(coord.second);
+    tiles.push_back(get_tile_index(coord));
+    us.push_back((coord.first - lon) * (HGT_DIM - 1));
+    vs.push_back((1.0 - (coord.second - lat)) * (HGT_DIM - 1));
+  }
+
+  // shapes usually walk through each tile once, in which case the postings are already grouped by
+  // tile. otherwise we sort them so that every tile is only looked up (and locked) once
+  std::vector<uint16_t> distinct;
+  // where a tile is (or would go) in the sorted distinct tiles. for the handful of tiles a request
+  // usually touches counting is cheaper than a binary search's mispredicted branches
+  const auto position = [&distinct](uint16_t tile) -> size_t {
+    if (distinct.size() > 32) {
+      return std::lower_bound(distinct.begin(), distinct.end(), tile) - distinct.begin();
+    }
+    size_t pos = 0;
+    for (auto t : distinct) {
+      pos += t < tile;
+    }
+    return pos;
+  };
+  bool grouped = true;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (i == 0 || tiles[i] != tiles[i - 1]) {
+      auto pos = position(tiles[i]);
+      if (pos < distinct.size() && distinct[pos] == tiles[i]) {
+        grouped = false;
+      } else {
+        distinct.insert(distinct.begin() + pos, tiles[i]);
+      }
+    }
+  }
+
+  // counting sort on the distinct tiles, there are only ever a handful of them
+  std::vector<uint32_t> order;
+  if (!grouped) {
+    std::vector<uint32_t> buckets(tiles.size()), offsets(distinct.size() + 1, 0);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      buckets[i] = position(tiles[i]);
+      ++offsets[buckets[i] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    order.resize(tiles.size());
+    std::vector<double> sorted_us(us.size()), sorted_vs(vs.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      auto pos = offsets[buckets[i]]++;
+      order[pos] = i;
+      sorted_us[pos] = us[i];
+      sorted_vs[pos] = vs[i];
+      tiles[pos] = distinct[buckets[i]];
+    }
+    us.swap(sorted_us);
+    vs.swap(sorted_vs);
+  }
 
+  // sample each run of postings that fall in the same tile in one go
+  std::vector<double> values(tiles.size(), get_no_data_value());
   tile_data tile;
-  for (const auto& coord : coords) {
-    values.emplace_back(get(coord, tile));
+  for (size_t begin = 0, end = 0; begin < tiles.size(); begin = end) {
+    while (end < tiles.size() && tiles[end] == tiles[begin]) {
+      ++end;
+    }
+    if (tiles[begin] == tile.get_index() || get_tile(tiles[begin], tile)) {
+      tile.get(&us[begin], &vs[begin], &values[begin], end - begin);
+    }
+  }
+
+  // put them back in the order they were asked for
+  if (!grouped) {
+    std::vector<double> unsorted(values.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      unsorted[order[i]] = values[i];
+    }
+    values.swap(unsorted);
   }
 
   return values;
 }
 
+bool sample::get_tile(uint16_t index, tile_data& tile) {
+  // the cache does its own locking, and none at all for tiles that are ready to use
+  tile = cache_->source(index);
+  if (!tile) {
+    if (!fetch(index))
+      return false;
+
+    if (!(tile = cache_->source(index)))
+      return false;
+  }
+  return true;
+}
+
 bool sample::store(const std::string& elev, const std::vector<char>& raw_data) {
   // data_source never changes so we do not lock it. it is set only in sample constructor
   auto fpath = cache_->data_source + elev;
@@ -632,6 +801,33 @@ void sample::cache_initialisation(const std::string& data_source) {
   }
 }
 
+// we don't need lock as this method is called in constructor only
+void sample::extract_initialisation(const std::string& extract_path) {
+  try {
+    cache_->extract = std::make_unique<midgard::tar>(extract_path);
+  } catch (const std::exception& e) {
+    LOG_WARN("Could not load elevation extract: " + std::string(e.what()));
+    return;
+  }
+  cache_->cache.resize(TILE_COUNT);
+
+  // tiles in the extract take precedence over the ones found in the directory
+  size_t tile_count = 0;
+  for (const auto& entry : cache_->extract->contents) {
+    auto data = cache_item_t::parse_hgt_name(filesystem::path::preferred_separator + entry.first);
+    if (!data) {
+      continue;
+    }
+    if (data->second != format_t::UNKNOWN &&
+        cache_->cache[data->first].init(entry.second.first, entry.second.second, data->second)) {
+      ++tile_count;
+    } else {
+      LOG_WARN("Corrupt elevation data in extract: " + entry.first);
+    }
+  }
+  LOG_INFO("Memory mapped " + std::to_string(tile_count) + " elevation tiles from " + extract_path);
+}
+
 double get_no_data_value() {
   return NO_DATA_VALUE;
 }
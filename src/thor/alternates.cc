@@ -1,3 +1,4 @@
+#include <array>
 #include <iostream>
 #include <vector>
 
@@ -148,40 +149,44 @@ bool validate_alternate_by_stretch(const std::vector<PathInfo>& optimal_path,
 // Limited Sharing. Compare length of edge segments shared between optimal path and
 // candidate path. If they share more than kAtMostShared throw out this alternate.
 // Note that you should recover all shortcuts before call this function.
-bool validate_alternate_by_sharing(std::vector<std::unordered_set<GraphId>>& shared_edgeids,
+bool validate_alternate_by_sharing(shared_edges_t& shared_edges,
                                    const std::vector<std::vector<PathInfo>>& paths,
                                    const std::vector<PathInfo>& candidate_path,
                                    float at_most_shared) {
 
   // we will calculate the overlap in edge duration between the candidate_path and paths (paths is a
   // vector of the fastest path + any alternates already chosen)
-  if (paths.size() > shared_edgeids.size())
-    shared_edgeids.resize(paths.size());
-
-  // we check each accepted path against the candidate
-  for (size_t i = 0; i < paths.size(); ++i) {
-    // cache edge ids encountered on the current best path. Don't care about shortcuts because they
-    // have already been recovered.
-    auto& shared = shared_edgeids[i];
-    if (shared.empty()) {
-      for (const auto& pi : paths[i])
-        shared.insert(pi.edgeid);
-    }
+  const size_t path_count = std::min(paths.size(), kMaxSharedPaths);
+
+  // cache the edge ids of the paths chosen since the last call, one bit per path. Don't care about
+  // shortcuts because they have already been recovered.
+  for (; shared_edges.path_count < path_count; ++shared_edges.path_count) {
+    const uint64_t bit = uint64_t(1) << shared_edges.path_count;
+    for (const auto& pi : paths[shared_edges.path_count])
+      shared_edges.paths[pi.edgeid] |= bit;
+  }
 
-    // if an edge on the candidate_path is encountered that is also on one of the existing paths,
-    // we count it as a "shared" edge
-    float shared_length = 0.f;
-    for (const auto& cpi : candidate_path) {
-      const auto length = &cpi == &candidate_path.front()
-                              ? cpi.path_distance
-                              : cpi.path_distance - (&cpi - 1)->path_distance;
-      if (shared.find(cpi.edgeid) != shared.end()) {
-        shared_length += length;
+  // if an edge on the candidate_path is encountered that is also on one of the existing paths,
+  // we count it as a "shared" edge of each of them, a single lookup tells us which
+  std::array<float, kMaxSharedPaths> shared_length{};
+  for (const auto& cpi : candidate_path) {
+    auto found = shared_edges.paths.find(cpi.edgeid);
+    if (found == shared_edges.paths.end()) {
+      continue;
+    }
+    const auto length = &cpi == &candidate_path.front()
+                            ? cpi.path_distance
+                            : cpi.path_distance - (&cpi - 1)->path_distance;
+    for (size_t i = 0; i < path_count; ++i) {
+      if (found->second & (uint64_t(1) << i)) {
+        shared_length[i] += length;
       }
     }
+  }
 
-    // throw this alternate away if any of the chosen paths shares more than at_most_shared with it
-    if (shared_length > at_most_shared * paths[i].back().path_distance) {
+  // throw this alternate away if any of the chosen paths shares more than at_most_shared with it
+  for (size_t i = 0; i < path_count; ++i) {
+    if (shared_length[i] > at_most_shared * paths[i].back().path_distance) {
       LOG_DEBUG("Candidate alternate rejected by sharing");
       return false;
     }
@@ -40,9 +40,11 @@ AStarBSSAlgorithm::~AStarBSSAlgorithm() {
 
 // Clear the temporary information generated during path construction.
 void AStarBSSAlgorithm::Clear() {
+  label_reservation_.Record(LabelCount());
+
   // Reduce edge labels capacity if it's more than limit
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
+  if (edgelabels_.capacity() > reservation) {
     edgelabels_.resize(reservation);
     edgelabels_.shrink_to_fit();
   }
@@ -52,8 +54,8 @@ void AStarBSSAlgorithm::Clear() {
   edgelabels_.clear();
   destinations_.clear();
   adjacencylist_.clear();
-  pedestrian_edgestatus_.clear();
-  bicycle_edgestatus_.clear();
+  pedestrian_edgestatus_.clear(reservation);
+  bicycle_edgestatus_.clear(reservation);
 
   // Set the ferry flag to false
   has_ferry_ = false;
@@ -81,16 +83,18 @@ void AStarBSSAlgorithm::Init(const midgard::PointLL& origll, const midgard::Poin
 
   // Reserve size for edge labels - do this here rather than in constructor so
   // to limit how much extra memory is used for persistent objects.
-  // TODO - reserve based on estimate based on distance and route type.
-  edgelabels_.reserve(max_reserved_labels_count_);
+  edgelabels_.reserve(label_reservation_.Estimate(travel_mode_t::kPedestrian,
+                                                  origll.Distance(destll),
+                                                  max_reserved_labels_count_,
+                                                  max_reserved_labels_count_));
 
   // Construct adjacency list, clear edge status.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = std::max(pedestrian_costing_->UnitSize(), bicycle_costing_->UnitSize());
   float range = kBucketCount * bucketsize;
   adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_);
-  pedestrian_edgestatus_.clear();
-  bicycle_edgestatus_.clear();
+  pedestrian_edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
+  bicycle_edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
 }
 
 // Expand from the node along the forward search path. Immediately expands
@@ -41,6 +41,27 @@ inline float find_percent_along(const valhalla::Location& location, const GraphI
   throw std::logic_error("Could not find candidate edge for the location");
 }
 
+// The landmark distances of the end nodes of the candidate edges of a location, each with how far
+// the location is from it along the edge. Empty if any of them isn't in the landmark distances
+std::vector<std::pair<const uint32_t*, float>>
+landmark_targets(const LandmarkDistances& landmarks,
+                 GraphReader& graphreader,
+                 const valhalla::Location& location) {
+  std::vector<std::pair<const uint32_t*, float>> targets;
+  for (const auto& e : location.correlation().edges()) {
+    graph_tile_ptr tile;
+    const auto* edge = graphreader.directededge(GraphId(e.graph_id()), tile);
+    const auto end_tile = edge ? graphreader.GetGraphTile(edge->endnode()) : nullptr;
+    const auto* distances =
+        end_tile ? landmarks.get(edge->endnode(), end_tile->header()->nodecount()) : nullptr;
+    if (!distances) {
+      return {};
+    }
+    targets.emplace_back(distances, (1.0f - e.percent_along()) * edge->length());
+  }
+  return targets;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -62,6 +83,7 @@ BidirectionalAStar::BidirectionalAStar(const boost::property_tree::ptree& config
   pruning_disabled_at_origin_ = false;
   pruning_disabled_at_destination_ = false;
   ignore_hierarchy_limits_ = false;
+  hierarchy_pruned_ = 0;
 }
 
 // Destructor
@@ -70,12 +92,13 @@ BidirectionalAStar::~BidirectionalAStar() {
 
 // Clear the temporary information generated during path construction.
 void BidirectionalAStar::Clear() {
+  label_reservation_.Record(LabelCount());
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_forward_.size() > reservation) {
+  if (edgelabels_forward_.capacity() > reservation) {
     edgelabels_forward_.resize(reservation);
     edgelabels_forward_.shrink_to_fit();
   }
-  if (edgelabels_reverse_.size() > reservation) {
+  if (edgelabels_reverse_.capacity() > reservation) {
     edgelabels_reverse_.resize(reservation);
     edgelabels_reverse_.shrink_to_fit();
   }
@@ -84,8 +107,8 @@ void BidirectionalAStar::Clear() {
 
   adjacencylist_forward_.clear();
   adjacencylist_reverse_.clear();
-  edgestatus_forward_.clear();
-  edgestatus_reverse_.clear();
+  edgestatus_forward_.clear(reservation);
+  edgestatus_reverse_.clear(reservation);
 
   // Set the ferry flag to false
   has_ferry_ = false;
@@ -106,9 +129,14 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   astarheuristic_reverse_.Init(origll, factor);
 
   // Reserve size for edge labels - do this here rather than in constructor so
-  // to limit how much extra memory is used for persistent objects
-  edgelabels_forward_.reserve(kInitialEdgeLabelCountBidirAstar);
-  edgelabels_reverse_.reserve(kInitialEdgeLabelCountBidirAstar);
+  // to limit how much extra memory is used for persistent objects. The estimate
+  // covers both directions which each get half of it
+  const uint32_t labels =
+      label_reservation_.Estimate(mode_, origll.Distance(destll),
+                                  2 * kInitialEdgeLabelCountBidirAstar,
+                                  2 * max_reserved_labels_count_);
+  edgelabels_forward_.reserve(labels / 2);
+  edgelabels_reverse_.reserve(labels / 2);
 
   // Construct adjacency list and initialize edge status lookup.
   // Set bucket size and cost range based on DynamicCost.
@@ -120,8 +148,8 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   const float mincostr = astarheuristic_reverse_.Get(destll);
   adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_);
 
-  edgestatus_forward_.clear();
-  edgestatus_reverse_.clear();
+  edgestatus_forward_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
+  edgestatus_reverse_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
 
   // Set the cost diff between forward and reverse searches (due to distance
   // approximator differences). This is used to "even" the forward and reverse
@@ -153,6 +181,7 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
                   });
   // Set this flag to 'true' if we can expand edges at all hierarchy levels without limits
   ignore_hierarchy_limits_ = ignore_forward_limits && ignore_reverse_limits;
+  hierarchy_pruned_ = 0;
 }
 
 // Runs in the inner loop of `Expand`, essentially evaluating if
@@ -180,6 +209,9 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     return false;
   }
 
+  // Bind the costing once, the virtual calls below happen for every relaxed edge
+  const sif::DynamicCost& costing = *costing_;
+
   graph_tile_ptr t2 = nullptr;
   baldr::GraphId opp_edge_id;
   const auto get_opp_edge_data = [&t2, &opp_edge_id, &graphreader, &meta, &tile]() {
@@ -256,17 +288,17 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     // We can set is_dest incorrectly in the second case, but it is the rare case.
     // The result path will be correct, because there are cosing.Allowed calls inside recost_forward
     // function in second time.
-    if (!costing_->Allowed(meta.edge, false, pred, tile, meta.edge_id, localtime,
-                           time_info.timezone_index, restriction_idx) ||
-        costing_->Restricted(meta.edge, pred, edgelabels_forward_, tile, meta.edge_id, true,
-                             &edgestatus_forward_, localtime, time_info.timezone_index)) {
+    if (!costing.Allowed(meta.edge, false, pred, tile, meta.edge_id, localtime,
+                          time_info.timezone_index, restriction_idx) ||
+        costing.Restricted(meta.edge, pred, edgelabels_forward_, tile, meta.edge_id, true,
+                            &edgestatus_forward_, localtime, time_info.timezone_index)) {
       return false;
     }
   } else {
-    if (!costing_->AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime,
-                                  time_info.timezone_index, restriction_idx) ||
-        costing_->Restricted(meta.edge, pred, edgelabels_reverse_, tile, meta.edge_id, false,
-                             &edgestatus_reverse_, localtime, time_info.timezone_index)) {
+    if (!costing.AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime,
+                                 time_info.timezone_index, restriction_idx) ||
+        costing.Restricted(meta.edge, pred, edgelabels_reverse_, tile, meta.edge_id, false,
+                            &edgestatus_reverse_, localtime, time_info.timezone_index)) {
       return false;
     }
   }
@@ -274,16 +306,16 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
   // Get cost
   uint8_t flow_sources;
   sif::Cost newcost =
-      pred.cost() + (FORWARD ? costing_->EdgeCost(meta.edge, tile, time_info, flow_sources)
-                             : costing_->EdgeCost(opp_edge, t2, time_info, flow_sources));
+      pred.cost() + (FORWARD ? costing.EdgeCost(meta.edge, tile, time_info, flow_sources)
+                             : costing.EdgeCost(opp_edge, t2, time_info, flow_sources));
 
   // Separate out transition cost.
   sif::Cost transition_cost =
-      FORWARD ? costing_->TransitionCost(meta.edge, nodeinfo, pred)
-              : costing_->TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge,
-                                                opp_pred_edge,
-                                                static_cast<bool>(flow_sources & kDefaultFlowMask),
-                                                pred.internal_turn());
+      FORWARD ? costing.TransitionCost(meta.edge, nodeinfo, pred)
+              : costing.TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge,
+                                               opp_pred_edge,
+                                               static_cast<bool>(flow_sources & kDefaultFlowMask),
+                                               pred.internal_turn());
   newcost += transition_cost;
 
   // Check if edge is temporarily labeled and this path has less cost. If
@@ -310,12 +342,14 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     return false;
 
   // Find the sort cost (with A* heuristic) using the lat,lng at the
-  // end node of the directed edge.
+  // end node of the directed edge. The lat,lng is decoded once for both heuristics
+  const auto endll = t2->get_node_ll(meta.edge->endnode());
+  const auto nodecount = t2->header()->nodecount();
   float dist = 0.0f;
   float sortcost =
-      newcost.cost + (FORWARD
-                          ? astarheuristic_forward_.Get(t2->get_node_ll(meta.edge->endnode()), dist)
-                          : astarheuristic_reverse_.Get(t2->get_node_ll(meta.edge->endnode()), dist));
+      newcost.cost +
+      (FORWARD ? astarheuristic_forward_.Get(endll, meta.edge->endnode(), nodecount, dist)
+               : astarheuristic_reverse_.Get(endll, meta.edge->endnode(), nodecount, dist));
 
   // not_thru_pruning_ is only set to false on the 2nd pass in route_action.
   bool thru = not_thru_pruning_ ? (pred.not_thru_pruning() || !meta.edge->not_thru()) : false;
@@ -327,13 +361,13 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     if (hierarchy_limits_forward_[meta.edge_id.level()].max_up_transitions != kUnlimitedTransitions) {
       // Override distance to the destination with a distance from the origin.
       // It will be used by hierarchy limits
-      dist = astarheuristic_reverse_.GetDistance(t2->get_node_ll(meta.edge->endnode()));
+      dist = astarheuristic_reverse_.GetDistance(endll);
     }
     edgelabels_forward_.emplace_back(pred_idx, meta.edge_id, opp_edge_id, meta.edge, newcost,
                                      sortcost, dist, mode_, transition_cost, thru,
-                                     (pred.closure_pruning() || !costing_->IsClosed(meta.edge, tile)),
+                                     (pred.closure_pruning() || !costing.IsClosed(meta.edge, tile)),
                                      static_cast<bool>(flow_sources & kDefaultFlowMask),
-                                     costing_->TurnType(pred.opp_local_idx(), nodeinfo, meta.edge),
+                                     costing.TurnType(pred.opp_local_idx(), nodeinfo, meta.edge),
                                      restriction_idx);
     adjacencylist_forward_.add(idx);
   } else {
@@ -341,14 +375,14 @@ inline bool BidirectionalAStar::ExpandInner(baldr::GraphReader& graphreader,
     if (hierarchy_limits_reverse_[meta.edge_id.level()].max_up_transitions != kUnlimitedTransitions) {
       // Override distance to the origin with a distance from the destination.
       // It will be used by hierarchy limits
-      dist = astarheuristic_forward_.GetDistance(t2->get_node_ll(meta.edge->endnode()));
+      dist = astarheuristic_forward_.GetDistance(endll);
     }
     edgelabels_reverse_.emplace_back(pred_idx, meta.edge_id, opp_edge_id, meta.edge, newcost,
                                      sortcost, dist, mode_, transition_cost, thru,
-                                     (pred.closure_pruning() || !costing_->IsClosed(meta.edge, tile)),
+                                     (pred.closure_pruning() || !costing.IsClosed(meta.edge, tile)),
                                      static_cast<bool>(flow_sources & kDefaultFlowMask),
-                                     costing_->TurnType(meta.edge->localedgeidx(), nodeinfo, opp_edge,
-                                                        opp_pred_edge),
+                                     costing.TurnType(meta.edge->localedgeidx(), nodeinfo, opp_edge,
+                                                       opp_pred_edge),
                                      restriction_idx);
     adjacencylist_reverse_.add(idx);
   }
@@ -381,6 +415,8 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
   if (tile == nullptr) {
     return false;
   }
+  // Start loading the tiles this part of the frontier is heading into
+  graphreader.PrefetchNeighbors(node);
   const NodeInfo* nodeinfo = tile->node(node);
 
   // Keep track of superseded edges
@@ -438,10 +474,13 @@ bool BidirectionalAStar::Expand(baldr::GraphReader& graphreader,
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
       // if this is a downward transition (ups are always allowed) AND we are no longer allowed OR
       // we cant get the tile at that level (local extracts could have this problem) THEN bail
-      graph_tile_ptr trans_tile = nullptr;
-      if ((!trans->up() && !ignore_hierarchy_limits_ &&
-           hierarchy_limits[trans->endnode().level()].StopExpanding(pred.distance())) ||
-          !(trans_tile = graphreader.GetGraphTile(trans->endnode()))) {
+      if (!trans->up() && !ignore_hierarchy_limits_ &&
+          hierarchy_limits[trans->endnode().level()].StopExpanding(pred.distance())) {
+        ++hierarchy_pruned_;
+        continue;
+      }
+      graph_tile_ptr trans_tile = graphreader.GetGraphTile(trans->endnode());
+      if (!trans_tile) {
         continue;
       }
 
@@ -498,7 +537,7 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
   desired_paths_count_ = 1;
   if (options.has_alternates_case() && options.alternates())
-    desired_paths_count_ += options.alternates();
+    desired_paths_count_ += std::min<uint32_t>(options.alternates(), kMaxSharedPaths - 1);
 
   // Initialize - create adjacency list, edgestatus support, A*, etc.
   PointLL origin_new(origin.correlation().edges(0).ll().lng(),
@@ -506,26 +545,30 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
   PointLL destination_new(destination.correlation().edges(0).ll().lng(),
                           destination.correlation().edges(0).ll().lat());
   Init(origin_new, destination_new);
+  graphreader.PrefetchCorridor(origin_new, destination_new);
+
+  // Tighten the heuristics with the landmark distances of the other end, each search can end on any
+  // of its candidate edges
+  if (landmarks_) {
+    const auto destination_targets = landmark_targets(*landmarks_, graphreader, destination);
+    if (!destination_targets.empty()) {
+      astarheuristic_forward_.SetLandmarks(landmarks_.get(), destination_targets);
+    }
+    const auto origin_targets = landmark_targets(*landmarks_, graphreader, origin);
+    if (!origin_targets.empty()) {
+      astarheuristic_reverse_.SetLandmarks(landmarks_.get(), origin_targets);
+    }
+  }
 
-  // we use a non varying time for all time dependent routes until we can figure out how to vary the
-  // time during the path computation in the bidirectional algorithm
-  bool invariant = options.date_time_type() != Options::no_time;
-  // Get time information for forward and backward searches
+  // Get time information for forward and backward searches. Only the end with the date_time has a
+  // valid one, the search from that end tracks the time as its paths lengthen so that its edges
+  // are costed at the time they are reached (unless the time is invariant). The search from the
+  // other end has no time to go by and uses time independent costs, which only approximate the
+  // time dependent ones, but the path it forms is recosted at the times it is traversed
+  const bool invariant = options.date_time_type() == Options::invariant;
   auto forward_time_info = TimeInfo::make(origin, graphreader, &tz_cache_);
   auto reverse_time_info = TimeInfo::make(destination, graphreader, &tz_cache_);
 
-  // When a timedependent route is too long in distance it gets sent to this algorithm. It used to be
-  // the case that this algorithm called EdgeCost without a time component. This would result in
-  // timedependent routes falling back to time independent routing. Now that this algorithm is time
-  // aware we will be tracking time in one direction of the search. To revert to previous behavior
-  // you can uncomment the code below and get a time independent route in the fallback scenario.
-  //  if (!invariant) {
-  //    auto o = origin; o.mutable_date_time()->clear();
-  //    forward_time_info = TimeInfo::make(o, graphreader, &tz_cache_);
-  //    auto d = destination; d.mutable_date_time()->clear();
-  //    reverse_time_info = TimeInfo::make(d, graphreader, &tz_cache_);
-  //  }
-
   // Set origin and destination locations - seeds the adj. lists
   // Note: because we can correlate to more than one place for a given
   // PathLocation using edges.front here means we are only setting the
@@ -556,7 +599,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
     // Terminate if the iterations threshold has been exceeded.
     if ((edgelabels_reverse_.size() + edgelabels_forward_.size()) > iterations_threshold_) {
-      return FormPath(graphreader, options, origin, destination, forward_time_info);
+      return FormPath(graphreader, options, origin, destination, forward_time_info,
+                      reverse_time_info);
     }
 
     // Get the next predecessor (based on which direction was expanded in prior step)
@@ -570,7 +614,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
         // Terminate if the cost threshold has been exceeded.
         if (fwd_pred.sortcost() + cost_diff_ > cost_threshold_) {
-          return FormPath(graphreader, options, origin, destination, forward_time_info);
+          return FormPath(graphreader, options, origin, destination, forward_time_info,
+                          reverse_time_info);
         }
 
         // Check if the edge on the forward search connects to a settled edge on the
@@ -589,7 +634,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       } else {
         // Search is exhausted. If a connection has been found, return it
         if (!best_connections_.empty()) {
-          return FormPath(graphreader, options, origin, destination, forward_time_info);
+          return FormPath(graphreader, options, origin, destination, forward_time_info,
+                          reverse_time_info);
         }
         LOG_ERROR("Forward search exhausted: n = " + std::to_string(edgelabels_forward_.size()) +
                   "," + std::to_string(edgelabels_reverse_.size()));
@@ -620,7 +666,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
         // Terminate if the cost threshold has been exceeded.
         if (rev_pred.sortcost() > cost_threshold_) {
-          return FormPath(graphreader, options, origin, destination, forward_time_info);
+          return FormPath(graphreader, options, origin, destination, forward_time_info,
+                          reverse_time_info);
         }
 
         // Check if the edge on the reverse search connects to a settled edge on the
@@ -639,7 +686,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       } else {
         // Search is exhausted. If a connection has been found, return it
         if (!best_connections_.empty()) {
-          return FormPath(graphreader, options, origin, destination, forward_time_info);
+          return FormPath(graphreader, options, origin, destination, forward_time_info,
+                          reverse_time_info);
         }
         LOG_ERROR("Reverse search exhausted: n = " + std::to_string(edgelabels_reverse_.size()) +
                   "," + std::to_string(edgelabels_forward_.size()));
@@ -709,10 +757,13 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
       // Prune path if predecessor is not a through edge or if the maximum
       // number of upward transitions has been exceeded on this hierarchy level.
-      if ((fwd_pred.not_thru() && fwd_pred.not_thru_pruning()) ||
-          (!ignore_hierarchy_limits_ &&
-           hierarchy_limits_forward_[fwd_pred.endnode().level()].StopExpanding(
-               fwd_pred.distance()))) {
+      if (fwd_pred.not_thru() && fwd_pred.not_thru_pruning()) {
+        continue;
+      }
+      if (!ignore_hierarchy_limits_ &&
+          hierarchy_limits_forward_[fwd_pred.endnode().level()].StopExpanding(
+              fwd_pred.distance())) {
+        ++hierarchy_pruned_;
         continue;
       }
 
@@ -723,10 +774,12 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
         const auto tile = graphreader.GetGraphTile(fwd_pred.endnode());
         if (tile != nullptr) {
           // Estimate lower bound cost for the shortest path that goes through the current edge.
+          float dist = 0.0f;
           float route_lower_bound =
               edgelabels_forward_[fwd_pred.predecessor()].cost().cost +
               fwd_pred.transition_cost().cost + rev_pred.sortcost() -
-              astarheuristic_reverse_.Get(tile->get_node_ll(fwd_pred.endnode()));
+              astarheuristic_reverse_.Get(tile->get_node_ll(fwd_pred.endnode()), fwd_pred.endnode(),
+                                          tile->header()->nodecount(), dist);
           // Prune this edge if estimated lower bound cost exceeds the cost threshold.
           if (route_lower_bound > cost_threshold_) {
             continue;
@@ -752,10 +805,13 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       }
 
       // Prune path if predecessor is not a through edge
-      if ((rev_pred.not_thru() && rev_pred.not_thru_pruning()) ||
-          (!ignore_hierarchy_limits_ &&
-           hierarchy_limits_reverse_[rev_pred.endnode().level()].StopExpanding(
-               rev_pred.distance()))) {
+      if (rev_pred.not_thru() && rev_pred.not_thru_pruning()) {
+        continue;
+      }
+      if (!ignore_hierarchy_limits_ &&
+          hierarchy_limits_reverse_[rev_pred.endnode().level()].StopExpanding(
+              rev_pred.distance())) {
+        ++hierarchy_pruned_;
         continue;
       }
 
@@ -774,10 +830,12 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
         const auto tile = graphreader.GetGraphTile(rev_pred.endnode());
         if (tile != nullptr) {
           // Estimate lower bound cost for the shortest path that goes through the current edge.
+          float dist = 0.0f;
           float route_lower_bound =
               edgelabels_reverse_[rev_pred.predecessor()].cost().cost +
               rev_pred.transition_cost().cost + fwd_pred.sortcost() -
-              astarheuristic_forward_.Get(tile->get_node_ll(rev_pred.endnode()));
+              astarheuristic_forward_.Get(tile->get_node_ll(rev_pred.endnode()), rev_pred.endnode(),
+                                          tile->header()->nodecount(), dist);
           // Prune this edge if estimated lower bound cost exceeds the cost threshold.
           if (route_lower_bound > cost_threshold_) {
             continue;
@@ -1118,11 +1176,13 @@ void BidirectionalAStar::SetDestination(GraphReader& graphreader,
 }
 
 // Form the path from the adjacency list.
-std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& graphreader,
-                                                                const Options& options,
-                                                                const valhalla::Location& origin,
-                                                                const valhalla::Location& dest,
-                                                                const baldr::TimeInfo& time_info) {
+std::vector<std::vector<PathInfo>>
+BidirectionalAStar::FormPath(GraphReader& graphreader,
+                             const Options& options,
+                             const valhalla::Location& origin,
+                             const valhalla::Location& dest,
+                             const baldr::TimeInfo& time_info,
+                             const baldr::TimeInfo& reverse_time_info) {
   LOG_DEBUG("Found connections before stretch filter: " + std::to_string(best_connections_.size()));
 
   if (desired_paths_count_ > 1) {
@@ -1131,7 +1191,13 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     filter_alternates_by_stretch(best_connections_);
   }
   // For looking up edge ids on previously chosen best paths
-  std::vector<std::unordered_set<GraphId>> shared_edgeids;
+  shared_edges_t shared_edges;
+
+  // The forward and reverse labels of the paths formed so far, each with the mask of the paths it
+  // is on. A candidate whose labels are both on the same formed path lies on the plateau of that
+  // path and would form it again
+  std::unordered_map<uint32_t, uint64_t> forward_plateaus, reverse_plateaus;
+  size_t formed_count = 0;
 
   // get maximum amount of sharing parameter based on origin->destination distance
   float max_sharing = desired_paths_count_ > 1 ? get_max_sharing(origin, dest) : 0.f;
@@ -1175,6 +1241,24 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     uint32_t idx1 = edgestatus_forward_.Get(best_connection->edgeid).index();
     uint32_t idx2 = edgestatus_reverse_.Get(best_connection->opp_edgeid).index();
 
+    // Skip the candidates which form a path already formed, rather than recovering and recosting
+    // it to have it rejected by sharing
+    if (desired_paths_count_ > 1) {
+      auto fwd_plateau = forward_plateaus.find(idx1);
+      auto rev_plateau = reverse_plateaus.find(idx2);
+      if (fwd_plateau != forward_plateaus.end() && rev_plateau != reverse_plateaus.end() &&
+          (fwd_plateau->second & rev_plateau->second)) {
+        LOG_DEBUG("Candidate alternate on the plateau of a formed path");
+        continue;
+      }
+    }
+    const uint64_t formed_bit =
+        desired_paths_count_ > 1 && formed_count < kMaxSharedPaths ? uint64_t(1) << formed_count : 0;
+    ++formed_count;
+    if (formed_bit) {
+      reverse_plateaus[idx2] |= formed_bit;
+    }
+
     // Metrics (TODO - more accurate cost)
     uint32_t pathcost = edgelabels_forward_[idx1].cost().cost + edgelabels_reverse_[idx2].cost().cost;
     LOG_DEBUG("path_cost::" + std::to_string(pathcost));
@@ -1193,6 +1277,9 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     for (auto edgelabel_index = idx1; edgelabel_index != kInvalidLabel;
          edgelabel_index = edgelabels_forward_[edgelabel_index].predecessor()) {
       const BDEdgeLabel& edgelabel = edgelabels_forward_[edgelabel_index];
+      if (formed_bit) {
+        forward_plateaus[edgelabel_index] |= formed_bit;
+      }
 
       const DirectedEdge* edge = graphreader.directededge(edgelabel.edgeid(), tile);
       if (edge == nullptr) {
@@ -1222,6 +1309,9 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
          edgelabel_index != kInvalidLabel;
          edgelabel_index = edgelabels_reverse_[edgelabel_index].predecessor()) {
       const BDEdgeLabel& edgelabel = edgelabels_reverse_[edgelabel_index];
+      if (formed_bit) {
+        reverse_plateaus[edgelabel_index] |= formed_bit;
+      }
       const DirectedEdge* opp_edge = nullptr;
       GraphId opp_edge_id = graphreader.GetOpposingEdgeId(edgelabel.edgeid(), opp_edge, tile);
       if (opp_edge == nullptr) {
@@ -1278,17 +1368,26 @@ std::vector<std::vector<PathInfo>> BidirectionalAStar::FormPath(GraphReader& gra
     // TODO: actually we should not ignore access restrictions: if the reverse path
     //   traversed a closed edge due to time restrictions, we could do a mini traversal
     //   to circumvent the closed edge(s)
+    // A route which only has a time at the destination departs about as long before it as the two
+    // searches took to meet, the path is recosted from then on
+    TimeInfo departure_time_info = time_info;
+    if (!time_info.valid && reverse_time_info.valid) {
+      departure_time_info =
+          reverse_time_info.reverse(edgelabels_forward_[idx1].cost().secs +
+                                        edgelabels_reverse_[idx2].cost().secs,
+                                    static_cast<int>(reverse_time_info.timezone_index));
+    }
     try {
       bool invariant = options.date_time_type() == Options::invariant;
       sif::recost_forward(graphreader, *costing_, edge_cb, label_cb, source_pct, target_pct,
-                          time_info, invariant, true);
+                          departure_time_info, invariant, true);
     } catch (const std::exception& e) {
       LOG_ERROR(std::string("Bi-directional astar failed to recost final path: ") + e.what());
       continue;
     }
 
     // For the first path just add it for subsequent paths only add if it passes viability tests
-    if (paths.empty() || (validate_alternate_by_sharing(shared_edgeids, paths, path, max_sharing) &&
+    if (paths.empty() || (validate_alternate_by_sharing(shared_edges, paths, path, max_sharing) &&
                           validate_alternate_by_stretch(paths.front(), path) &&
                           validate_alternate_by_local_optimality(path))) {
       paths.emplace_back(std::move(path));
@@ -1384,7 +1483,7 @@ bool IsBridgingEdgeRestricted(GraphReader& graphreader,
     const auto* edge = tile->directededge(edgeid);
     if (edge->end_restriction() & costing->access_mode()) {
       auto restrictions = tile->GetRestrictions(true, edgeid, costing->access_mode());
-      if (restrictions.size() == 0) {
+      if (restrictions.empty()) {
         // TODO Should we actually throw here? Or assert to gracefully continue in release?
         // This implies corrupt data or logic bug
         throw std::logic_error(
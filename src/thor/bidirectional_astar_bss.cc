@@ -0,0 +1,680 @@
+#include "thor/bidirectional_astar_bss.h"
+#include "baldr/datetime.h"
+#include "midgard/logging.h"
+
+#include <algorithm>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+// Threshold to extend the search once the first connection has been found
+constexpr float kThresholdDelta = 420.0f;
+
+travel_mode_t get_other_travel_mode(const travel_mode_t current_mode) {
+  return current_mode == travel_mode_t::kPedestrian ? travel_mode_t::kBicycle
+                                                    : travel_mode_t::kPedestrian;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+// Default constructor
+BidirectionalAStarBSS::BidirectionalAStarBSS(const boost::property_tree::ptree& config)
+    : PathAlgorithm(config.get<uint32_t>("max_reserved_labels_count_bidir_astar",
+                                         kInitialEdgeLabelCountBidirAstar),
+                    config.get<bool>("clear_reserved_memory", false)),
+      cost_threshold_(0), cost_diff_(0), connection_mode_(travel_mode_t::kPedestrian) {
+}
+
+// Destructor
+BidirectionalAStarBSS::~BidirectionalAStarBSS() {
+}
+
+// Clear the temporary information generated during path construction.
+void BidirectionalAStarBSS::Clear() {
+  label_reservation_.Record(LabelCount());
+  auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
+  if (edgelabels_forward_.capacity() > reservation) {
+    edgelabels_forward_.resize(reservation);
+    edgelabels_forward_.shrink_to_fit();
+  }
+  if (edgelabels_reverse_.capacity() > reservation) {
+    edgelabels_reverse_.resize(reservation);
+    edgelabels_reverse_.shrink_to_fit();
+  }
+
+  // Clear the edge labels, the locations and the adjacency lists and edge status of both modes
+  edgelabels_forward_.clear();
+  edgelabels_reverse_.clear();
+  origin_percents_.clear();
+  destination_percents_.clear();
+  adjacencylist_forward_.clear();
+  adjacencylist_reverse_.clear();
+  pedestrian_edgestatus_forward_.clear(reservation);
+  bicycle_edgestatus_forward_.clear(reservation);
+  pedestrian_edgestatus_reverse_.clear(reservation);
+  bicycle_edgestatus_reverse_.clear(reservation);
+
+  // Set the ferry flag to false
+  has_ferry_ = false;
+}
+
+// Initialize the A* heuristics and adjacency lists for both the forward
+// and reverse search.
+void BidirectionalAStarBSS::Init(const midgard::PointLL& origll, const midgard::PointLL& destll) {
+  // The heuristics of both modes have to underestimate, so take the lower factor of the two
+  auto common_astar_cost =
+      std::min(pedestrian_costing_->AStarCostFactor(), bicycle_costing_->AStarCostFactor());
+  astarheuristic_forward_.Init(destll, common_astar_cost);
+  astarheuristic_reverse_.Init(origll, common_astar_cost);
+
+  // Reserve size for edge labels - do this here rather than in constructor so
+  // to limit how much extra memory is used for persistent objects. The estimate
+  // covers both directions which each get half of it
+  const uint32_t labels =
+      label_reservation_.Estimate(travel_mode_t::kPedestrian, origll.Distance(destll),
+                                  2 * max_reserved_labels_count_, 2 * max_reserved_labels_count_);
+  edgelabels_forward_.reserve(labels / 2);
+  edgelabels_reverse_.reserve(labels / 2);
+
+  // Set up the adjacency lists of both directions, the bucket size fits both modes
+  uint32_t bucketsize = std::max(pedestrian_costing_->UnitSize(), bicycle_costing_->UnitSize());
+  float range = kBucketCount * bucketsize;
+  float mincostf = astarheuristic_forward_.Get(origll);
+  adjacencylist_forward_.reuse(mincostf, range, bucketsize, &edgelabels_forward_);
+  float mincostr = astarheuristic_reverse_.Get(destll);
+  adjacencylist_reverse_.reuse(mincostr, range, bucketsize, &edgelabels_reverse_);
+
+  auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
+  pedestrian_edgestatus_forward_.clear(reservation);
+  bicycle_edgestatus_forward_.clear(reservation);
+  pedestrian_edgestatus_reverse_.clear(reservation);
+  bicycle_edgestatus_reverse_.clear(reservation);
+
+  // Set the cost diff between forward and reverse searches (due to distance
+  // approximator differences). This is used to "even" the forward and reverse
+  // searches.
+  cost_diff_ = mincostf - mincostr;
+
+  // No connection yet
+  best_connection_ = {GraphId(), GraphId(), std::numeric_limits<float>::max()};
+  cost_threshold_ = std::numeric_limits<float>::max();
+}
+
+// Expand from the node along the forward search path. Immediately expands
+// from the end node of any transition edge and, at bike share stations, in
+// the other mode.
+void BidirectionalAStarBSS::ExpandForward(GraphReader& graphreader,
+                                          const GraphId& node,
+                                          const BDEdgeLabel& pred,
+                                          const uint32_t pred_idx,
+                                          const travel_mode_t mode,
+                                          const bool from_transition,
+                                          const bool from_bss) {
+  // Get the tile and the node info. Skip if tile is null (can happen
+  // with regional data sets) or if no access at the node.
+  graph_tile_ptr tile = graphreader.GetGraphTile(node);
+  if (tile == nullptr) {
+    return;
+  }
+  const NodeInfo* nodeinfo = tile->node(node);
+  const auto& current_costing = costing(mode);
+  if (!current_costing->Allowed(nodeinfo)) {
+    return;
+  }
+
+  GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
+  EdgeStatusInfo* es = edgestatus(true, mode).GetPtr(edgeid, tile);
+  const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+  for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
+    // Walks and rides stay on the local edges, skip shortcuts and the edges settled in this mode
+    if (directededge->is_shortcut() || es->set() == EdgeSet::kPermanent) {
+      continue;
+    }
+
+    uint8_t restriction_idx = kInvalidRestriction;
+    if (!current_costing->Allowed(directededge, false, pred, tile, edgeid, 0, 0, restriction_idx) ||
+        current_costing->Restricted(directededge, pred, edgelabels_forward_, tile, edgeid, true)) {
+      continue;
+    }
+
+    graph_tile_ptr t2 =
+        directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+    if (t2 == nullptr) {
+      continue;
+    }
+
+    // The turn onto this edge is costed in the mode it is travelled
+    auto edge_cost = current_costing->EdgeCost(directededge, tile);
+    Cost normalized_edge_cost = {edge_cost.cost * current_costing->GetModeFactor(), edge_cost.secs};
+    Cost transition_cost = current_costing->TransitionCost(directededge, nodeinfo, pred);
+    Cost newcost = pred.cost() + normalized_edge_cost + transition_cost;
+
+    // Check if edge is temporarily labeled and this path has less cost. If
+    // less cost the predecessor is updated and the sort cost is decremented
+    // by the difference in real cost (A* heuristic doesn't change)
+    if (es->set() == EdgeSet::kTemporary) {
+      BDEdgeLabel& lab = edgelabels_forward_[es->index()];
+      if (newcost.cost < lab.cost().cost) {
+        float newsortcost = lab.sortcost() - (lab.cost().cost - newcost.cost);
+        adjacencylist_forward_.decrease(es->index(), newsortcost);
+        lab.Update(pred_idx, newcost, newsortcost, transition_cost, restriction_idx);
+      }
+      continue;
+    }
+
+    float dist = 0.0f;
+    float sortcost =
+        newcost.cost + astarheuristic_forward_.Get(t2->get_node_ll(directededge->endnode()), dist);
+
+    uint32_t idx = edgelabels_forward_.size();
+    edgelabels_forward_.emplace_back(pred_idx, edgeid, t2->GetOpposingEdgeId(directededge),
+                                     directededge, newcost, sortcost, dist, mode, transition_cost,
+                                     false, true, false, InternalTurn::kNoTurn, restriction_idx);
+    *es = {EdgeSet::kTemporary, idx};
+    adjacencylist_forward_.add(idx);
+
+    // setting this edge as reached
+    if (expansion_callback_) {
+      expansion_callback_(graphreader, edgeid, "bidirectional_astar_bss", "r", newcost.secs, 0,
+                          newcost.cost);
+    }
+  }
+
+  // Bikes are rented and returned at bike share stations
+  if (!from_bss && nodeinfo->type() == NodeType::kBikeShare) {
+    ExpandForward(graphreader, node, pred, pred_idx, get_other_travel_mode(mode), from_transition,
+                  true);
+  }
+
+  // Handle transitions - expand from the end node of each transition
+  if (!from_transition && nodeinfo->transition_count() > 0) {
+    const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+    for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+      ExpandForward(graphreader, trans->endnode(), pred, pred_idx, mode, true, from_bss);
+    }
+  }
+}
+
+// Expand from the node along the reverse search path. Immediately expands
+// from the end node of any transition edge and, at bike share stations, in
+// the other mode.
+void BidirectionalAStarBSS::ExpandReverse(GraphReader& graphreader,
+                                          const GraphId& node,
+                                          const BDEdgeLabel& pred,
+                                          const uint32_t pred_idx,
+                                          const DirectedEdge* opp_pred_edge,
+                                          const travel_mode_t mode,
+                                          const bool from_transition,
+                                          const bool from_bss) {
+  // Get the tile and the node info. Skip if tile is null (can happen
+  // with regional data sets) or if no access at the node.
+  graph_tile_ptr tile = graphreader.GetGraphTile(node);
+  if (tile == nullptr) {
+    return;
+  }
+  const NodeInfo* nodeinfo = tile->node(node);
+  const auto& current_costing = costing(mode);
+  if (!current_costing->Allowed(nodeinfo)) {
+    return;
+  }
+
+  GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
+  EdgeStatusInfo* es = edgestatus(false, mode).GetPtr(edgeid, tile);
+  const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+  for (uint32_t i = 0; i < nodeinfo->edge_count(); ++i, ++directededge, ++edgeid, ++es) {
+    // Walks and rides stay on the local edges, skip shortcuts and the edges settled in this mode
+    if (directededge->is_shortcut() || es->set() == EdgeSet::kPermanent ||
+        !(directededge->reverseaccess() & current_costing->access_mode())) {
+      continue;
+    }
+
+    // Get end node tile, opposing edge Id, and opposing directed edge.
+    graph_tile_ptr t2 =
+        directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : tile;
+    if (t2 == nullptr) {
+      continue;
+    }
+    GraphId opp_edge_id = t2->GetOpposingEdgeId(directededge);
+    const DirectedEdge* opp_edge = t2->directededge(opp_edge_id);
+
+    uint8_t restriction_idx = kInvalidRestriction;
+    if (!current_costing->AllowedReverse(directededge, pred, opp_edge, t2, opp_edge_id, 0, 0,
+                                         restriction_idx) ||
+        current_costing->Restricted(directededge, pred, edgelabels_reverse_, tile, edgeid, false)) {
+      continue;
+    }
+
+    // The turn at this node is onto the edge of the predecessor, so it is costed in the mode the
+    // predecessor is travelled to cost the same as the forward search does
+    auto edge_cost = current_costing->EdgeCost(opp_edge, t2);
+    Cost normalized_edge_cost = {edge_cost.cost * current_costing->GetModeFactor(), edge_cost.secs};
+    Cost transition_cost =
+        costing(pred.mode())
+            ->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge, opp_pred_edge,
+                                    false, pred.internal_turn());
+    Cost newcost = pred.cost() + normalized_edge_cost + transition_cost;
+
+    // Check if edge is temporarily labeled and this path has less cost. If
+    // less cost the predecessor is updated and the sort cost is decremented
+    // by the difference in real cost (A* heuristic doesn't change)
+    if (es->set() == EdgeSet::kTemporary) {
+      BDEdgeLabel& lab = edgelabels_reverse_[es->index()];
+      if (newcost.cost < lab.cost().cost) {
+        float newsortcost = lab.sortcost() - (lab.cost().cost - newcost.cost);
+        adjacencylist_reverse_.decrease(es->index(), newsortcost);
+        lab.Update(pred_idx, newcost, newsortcost, transition_cost, restriction_idx);
+      }
+      continue;
+    }
+
+    float dist = 0.0f;
+    float sortcost =
+        newcost.cost + astarheuristic_reverse_.Get(t2->get_node_ll(directededge->endnode()), dist);
+
+    uint32_t idx = edgelabels_reverse_.size();
+    edgelabels_reverse_.emplace_back(pred_idx, edgeid, opp_edge_id, directededge, newcost, sortcost,
+                                     dist, mode, transition_cost, false, true, false,
+                                     InternalTurn::kNoTurn, restriction_idx);
+    *es = {EdgeSet::kTemporary, idx};
+    adjacencylist_reverse_.add(idx);
+
+    // setting this edge as reached, sending the opposing because this is the reverse tree
+    if (expansion_callback_) {
+      expansion_callback_(graphreader, opp_edge_id, "bidirectional_astar_bss", "r", newcost.secs, 0,
+                          newcost.cost);
+    }
+  }
+
+  // Bikes are rented and returned at bike share stations
+  if (!from_bss && nodeinfo->type() == NodeType::kBikeShare) {
+    ExpandReverse(graphreader, node, pred, pred_idx, opp_pred_edge, get_other_travel_mode(mode),
+                  from_transition, true);
+  }
+
+  // Handle transitions - expand from the end node of each transition
+  if (!from_transition && nodeinfo->transition_count() > 0) {
+    const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+    for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+      ExpandReverse(graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge, mode, true,
+                    from_bss);
+    }
+  }
+}
+
+// Calculate best path using bidirectional A* walking and riding shared bikes.
+std::vector<std::vector<PathInfo>>
+BidirectionalAStarBSS::GetBestPath(valhalla::Location& origin,
+                                   valhalla::Location& destination,
+                                   GraphReader& graphreader,
+                                   const sif::mode_costing_t& mode_costing,
+                                   const travel_mode_t,
+                                   const Options&) {
+  pedestrian_costing_ = mode_costing[static_cast<uint32_t>(travel_mode_t::kPedestrian)];
+  bicycle_costing_ = mode_costing[static_cast<uint32_t>(travel_mode_t::kBicycle)];
+
+  // Initialize - create adjacency list, edgestatus support, A*, etc.
+  midgard::PointLL origin_new(origin.correlation().edges(0).ll().lng(),
+                              origin.correlation().edges(0).ll().lat());
+  midgard::PointLL destination_new(destination.correlation().edges(0).ll().lng(),
+                                   destination.correlation().edges(0).ll().lat());
+  Init(origin_new, destination_new);
+
+  // Set origin and destination locations - seeds the adj. lists
+  SetOrigin(graphreader, origin);
+  SetDestination(graphreader, destination);
+
+  // Find shortest path. Switch between a forward direction and a reverse
+  // direction search based on the current costs.
+  uint32_t forward_pred_idx = kInvalidLabel, reverse_pred_idx = kInvalidLabel;
+  BDEdgeLabel fwd_pred, rev_pred;
+  bool expand_forward = true;
+  bool expand_reverse = true;
+  size_t total_labels = 0;
+  while (true) {
+    // Allow this process to be aborted
+    size_t current_labels = edgelabels_forward_.size() + edgelabels_reverse_.size();
+    if (interrupt && total_labels / kInterruptIterationsInterval <
+                         current_labels / kInterruptIterationsInterval) {
+      (*interrupt)();
+    }
+    total_labels = current_labels;
+
+    // Get the next predecessor (based on which direction was expanded in prior step)
+    if (expand_forward) {
+      forward_pred_idx = adjacencylist_forward_.pop();
+      if (forward_pred_idx != kInvalidLabel) {
+        fwd_pred = edgelabels_forward_[forward_pred_idx];
+
+        // Forward path to this edge can't be improved, so we can settle it right now.
+        edgestatus(true, fwd_pred.mode()).Update(fwd_pred.edgeid(), EdgeSet::kPermanent);
+
+        // Terminate if the cost threshold has been exceeded.
+        if (fwd_pred.sortcost() + cost_diff_ > cost_threshold_) {
+          return {FormPath(graphreader)};
+        }
+
+        // Check if the edge connects to an edge settled in the same mode on the reverse search
+        // tree, or to a destination edge not pulled out of the queue yet.
+        const auto opp_status =
+            edgestatus(false, fwd_pred.mode()).Get(fwd_pred.opp_edgeid());
+        if (opp_status.set() == EdgeSet::kPermanent ||
+            (opp_status.set() == EdgeSet::kTemporary &&
+             edgelabels_reverse_[opp_status.index()].predecessor() == kInvalidLabel)) {
+          SetConnection(graphreader, fwd_pred, edgelabels_reverse_[opp_status.index()]);
+          if (opp_status.set() == EdgeSet::kPermanent) {
+            continue;
+          }
+        }
+      }
+    }
+    if (expand_reverse) {
+      reverse_pred_idx = adjacencylist_reverse_.pop();
+      if (reverse_pred_idx != kInvalidLabel) {
+        rev_pred = edgelabels_reverse_[reverse_pred_idx];
+
+        // Reverse path to this edge can't be improved, so we can settle it right now.
+        edgestatus(false, rev_pred.mode()).Update(rev_pred.edgeid(), EdgeSet::kPermanent);
+
+        // Terminate if the cost threshold has been exceeded.
+        if (rev_pred.sortcost() > cost_threshold_) {
+          return {FormPath(graphreader)};
+        }
+
+        // Check if the edge connects to an edge settled in the same mode on the forward search
+        // tree, or to an origin edge not pulled out of the queue yet.
+        const auto opp_status = edgestatus(true, rev_pred.mode()).Get(rev_pred.opp_edgeid());
+        if (opp_status.set() == EdgeSet::kPermanent ||
+            (opp_status.set() == EdgeSet::kTemporary &&
+             edgelabels_forward_[opp_status.index()].predecessor() == kInvalidLabel)) {
+          SetConnection(graphreader, edgelabels_forward_[opp_status.index()], rev_pred);
+          if (opp_status.set() == EdgeSet::kPermanent) {
+            continue;
+          }
+        }
+      }
+    }
+
+    // If both directions have exhausted, return the best connection if there is one
+    bool forward_exhausted = forward_pred_idx == kInvalidLabel;
+    bool reverse_exhausted = reverse_pred_idx == kInvalidLabel;
+    if (forward_exhausted && reverse_exhausted) {
+      if (best_connection_.edgeid.Is_Valid()) {
+        return {FormPath(graphreader)};
+      }
+      LOG_ERROR("Bi-directional bike share route failure - search exhausted: n = " +
+                std::to_string(edgelabels_forward_.size()) + "," +
+                std::to_string(edgelabels_reverse_.size()));
+      return {};
+    }
+
+    // Expand from the search direction with lower sort cost
+    // Note: If one direction is exhausted, we force search in the remaining
+    // direction
+    if (!forward_exhausted &&
+        (reverse_exhausted || (fwd_pred.sortcost() + cost_diff_) < rev_pred.sortcost())) {
+      // Expand forward - set to get next edge from forward adj. list on the next pass
+      expand_forward = true;
+      expand_reverse = false;
+
+      // setting this edge as settled
+      if (expansion_callback_) {
+        expansion_callback_(graphreader, fwd_pred.edgeid(), "bidirectional_astar_bss", "s",
+                            fwd_pred.cost().secs, 0, fwd_pred.cost().cost);
+      }
+
+      ExpandForward(graphreader, fwd_pred.endnode(), fwd_pred, forward_pred_idx, fwd_pred.mode(),
+                    false, false);
+    } else {
+      // Expand reverse - set to get next edge from reverse adj. list on the next pass
+      expand_forward = false;
+      expand_reverse = true;
+
+      // setting this edge as settled, sending the opposing because this is the reverse tree
+      if (expansion_callback_) {
+        expansion_callback_(graphreader, rev_pred.opp_edgeid(), "bidirectional_astar_bss", "s",
+                            rev_pred.cost().secs, 0, rev_pred.cost().cost);
+      }
+
+      // Get the opposing predecessor directed edge
+      graph_tile_ptr rev_pred_tile = graphreader.GetGraphTile(rev_pred.opp_edgeid());
+      if (rev_pred_tile == nullptr) {
+        continue;
+      }
+      const DirectedEdge* opp_pred_edge = rev_pred_tile->directededge(rev_pred.opp_edgeid());
+
+      ExpandReverse(graphreader, rev_pred.endnode(), rev_pred, reverse_pred_idx, opp_pred_edge,
+                    rev_pred.mode(), false, false);
+    }
+  }
+  return {}; // If we are here the route failed
+}
+
+// Cost of the path through the connection
+Cost BidirectionalAStarBSS::ConnectionCost(GraphReader& graphreader,
+                                           const BDEdgeLabel& fwd_pred,
+                                           const BDEdgeLabel& rev_pred) {
+  // The cost to the start of the forward edge, plus the cost from the start of the reverse edge,
+  // plus the turn onto it
+  if (fwd_pred.predecessor() != kInvalidLabel) {
+    return edgelabels_forward_[fwd_pred.predecessor()].cost() + rev_pred.cost() +
+           fwd_pred.transition_cost();
+  }
+
+  // The forward edge is an origin edge. The cost from its end on the reverse path
+  if (rev_pred.predecessor() != kInvalidLabel) {
+    return fwd_pred.cost() + edgelabels_reverse_[rev_pred.predecessor()].cost() +
+           rev_pred.transition_cost();
+  }
+
+  // The origin and destination are on the same edge, walk between them
+  float from = origin_percents_[fwd_pred.edgeid()];
+  float to = destination_percents_[fwd_pred.edgeid()];
+  graph_tile_ptr tile = graphreader.GetGraphTile(fwd_pred.edgeid());
+  if (tile == nullptr || to < from) {
+    return {-1.0f, -1.0f};
+  }
+  return pedestrian_costing_->EdgeCost(tile->directededge(fwd_pred.edgeid()), tile) * (to - from);
+}
+
+// Keep the connection if it is the best one and lower the threshold to extend the search.
+void BidirectionalAStarBSS::SetConnection(GraphReader& graphreader,
+                                          const BDEdgeLabel& fwd_pred,
+                                          const BDEdgeLabel& rev_pred) {
+  Cost c = ConnectionCost(graphreader, fwd_pred, rev_pred);
+  if (c.cost < 0.0f || c.cost >= best_connection_.cost) {
+    return;
+  }
+
+  best_connection_ = {fwd_pred.edgeid(), rev_pred.edgeid(), c.cost};
+  connection_mode_ = fwd_pred.mode();
+  cost_threshold_ = c.cost + kThresholdDelta;
+
+  // setting this edge as connected
+  if (expansion_callback_) {
+    expansion_callback_(graphreader, fwd_pred.edgeid(), "bidirectional_astar_bss", "c",
+                        fwd_pred.cost().secs, 0, fwd_pred.cost().cost);
+  }
+}
+
+// Add edges at the origin to the forward adjacency list.
+void BidirectionalAStarBSS::SetOrigin(GraphReader& graphreader, valhalla::Location& origin) {
+  // Only skip inbound edges if we have other options
+  bool has_other_edges =
+      std::any_of(origin.correlation().edges().begin(), origin.correlation().edges().end(),
+                  [](const valhalla::PathEdge& e) { return !e.end_node(); });
+
+  // Iterate through edges and add to adjacency list
+  const NodeInfo* closest_ni = nullptr;
+  for (const auto& edge : origin.correlation().edges()) {
+    // If origin is at a node - skip any inbound edge (dist = 1)
+    if (has_other_edges && edge.end_node()) {
+      continue;
+    }
+
+    // Disallow any user avoid edges if the avoid location is ahead of the origin along the edge
+    GraphId edgeid(edge.graph_id());
+    if (pedestrian_costing_->AvoidAsOriginEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+
+    // Get the directed edge and the tile at its end node
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    graph_tile_ptr endtile = graphreader.GetGraphTile(directededge->endnode());
+    if (endtile == nullptr) {
+      continue;
+    }
+
+    // Get cost and sort cost (based on distance from endnode of this edge
+    // to the destination
+    const NodeInfo* nodeinfo = endtile->node(directededge->endnode());
+    Cost cost = pedestrian_costing_->EdgeCost(directededge, tile) * (1.0f - edge.percent_along());
+    if (closest_ni == nullptr) {
+      closest_ni = nodeinfo;
+    }
+
+    // We need to penalize this location based on its score (distance in meters from input)
+    // We assume the slowest speed you could travel to cover that distance to start/end the route
+    cost.cost += edge.distance();
+    float dist = astarheuristic_forward_.GetDistance(endtile->get_node_ll(directededge->endnode()));
+    float sortcost = cost.cost + astarheuristic_forward_.Get(dist);
+
+    // Add EdgeLabel to the adjacency list. Set the predecessor edge index
+    // to invalid to indicate the origin of the path.
+    uint32_t idx = edgelabels_forward_.size();
+    pedestrian_edgestatus_forward_.Set(edgeid, EdgeSet::kTemporary, idx, tile);
+    GraphId opp_edge_id = endtile->GetOpposingEdgeId(directededge);
+    edgelabels_forward_.emplace_back(kInvalidLabel, edgeid, opp_edge_id, directededge, cost,
+                                     sortcost, dist, travel_mode_t::kPedestrian, Cost{}, false,
+                                     true, false, InternalTurn::kNoTurn, kInvalidRestriction);
+    adjacencylist_forward_.add(idx);
+    origin_percents_[edgeid] = edge.percent_along();
+  }
+
+  // Set the origin timezone
+  if (closest_ni != nullptr && !origin.date_time().empty() && origin.date_time() == "current") {
+    origin.set_date_time(
+        DateTime::iso_date_time(DateTime::get_tz_db().from_index(closest_ni->timezone())));
+  }
+}
+
+// Add destination edges to the reverse path adjacency list.
+void BidirectionalAStarBSS::SetDestination(GraphReader& graphreader,
+                                           const valhalla::Location& dest) {
+  // Only skip outbound edges if we have other options
+  bool has_other_edges =
+      std::any_of(dest.correlation().edges().begin(), dest.correlation().edges().end(),
+                  [](const valhalla::PathEdge& e) { return !e.begin_node(); });
+
+  // Iterate through edges and add to adjacency list
+  for (const auto& edge : dest.correlation().edges()) {
+    // If the destination is at a node, skip any outbound edges (so any
+    // opposing inbound edges are not considered)
+    if (has_other_edges && edge.begin_node()) {
+      continue;
+    }
+
+    // Disallow any user avoided edges if the avoid location is behind the destination along the
+    // edge
+    GraphId edgeid(edge.graph_id());
+    if (pedestrian_costing_->AvoidAsDestinationEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+
+    // Get the directed edge and its opposing edge, continue if we cannot get it
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    graph_tile_ptr opp_tile = tile;
+    const DirectedEdge* opp_dir_edge = nullptr;
+    GraphId opp_edge_id = graphreader.GetOpposingEdgeId(edgeid, opp_dir_edge, opp_tile);
+    if (opp_dir_edge == nullptr) {
+      continue;
+    }
+
+    // Get cost and sort cost (based on distance from endnode of this edge
+    // to the origin. Use the directed edge for costing, as this is the
+    // forward direction along the destination edge.
+    Cost cost = pedestrian_costing_->EdgeCost(directededge, tile) * edge.percent_along();
+
+    // We need to penalize this location based on its score (distance in meters from input)
+    // We assume the slowest speed you could travel to cover that distance to start/end the route
+    cost.cost += edge.distance();
+    float dist = astarheuristic_reverse_.GetDistance(tile->get_node_ll(opp_dir_edge->endnode()));
+    float sortcost = cost.cost + astarheuristic_reverse_.Get(dist);
+
+    // Add EdgeLabel to the adjacency list. Set the predecessor edge index
+    // to invalid to indicate the origin of the path. Make sure the opposing
+    // edge (edgeid) is set.
+    uint32_t idx = edgelabels_reverse_.size();
+    pedestrian_edgestatus_reverse_.Set(opp_edge_id, EdgeSet::kTemporary, idx, opp_tile);
+    edgelabels_reverse_.emplace_back(kInvalidLabel, opp_edge_id, edgeid, opp_dir_edge, cost,
+                                     sortcost, dist, travel_mode_t::kPedestrian, Cost{}, false,
+                                     true, false, InternalTurn::kNoTurn, kInvalidRestriction);
+    adjacencylist_reverse_.add(idx);
+    destination_percents_[edgeid] = edge.percent_along();
+  }
+}
+
+// Form the path from the best connection. Labels hold the cost to the end of their edge in the
+// direction they were searched, so the elapsed cost along the reverse part is what is left of the
+// whole cost once the rest of the reverse path is taken off.
+std::vector<PathInfo> BidirectionalAStarBSS::FormPath(GraphReader& graphreader) {
+  const auto fwd_idx = edgestatus(true, connection_mode_).Get(best_connection_.edgeid).index();
+  const auto rev_idx = edgestatus(false, connection_mode_).Get(best_connection_.opp_edgeid).index();
+  const BDEdgeLabel& fwd_label = edgelabels_forward_[fwd_idx];
+  const BDEdgeLabel& rev_label = edgelabels_reverse_[rev_idx];
+  const Cost total = ConnectionCost(graphreader, fwd_label, rev_label);
+
+  LOG_DEBUG("path_cost::" + std::to_string(total.cost));
+  LOG_DEBUG("FormPath path_iterations::" + std::to_string(edgelabels_forward_.size()) + "," +
+            std::to_string(edgelabels_reverse_.size()));
+
+  // The cost still to go from the end of the edge of a reverse label
+  const auto remaining = [this](const BDEdgeLabel& label) {
+    return label.predecessor() == kInvalidLabel
+               ? Cost{}
+               : edgelabels_reverse_[label.predecessor()].cost() + label.transition_cost();
+  };
+
+  // Work backwards on the forward path, from the edge of the connection
+  std::vector<PathInfo> path;
+  path.emplace_back(fwd_label.mode(), total - remaining(rev_label), fwd_label.edgeid(), 0, 0,
+                    fwd_label.restriction_idx(), fwd_label.transition_cost());
+  has_ferry_ = has_ferry_ || fwd_label.use() == Use::kFerry;
+  for (auto edgelabel_index = fwd_label.predecessor(); edgelabel_index != kInvalidLabel;
+       edgelabel_index = edgelabels_forward_[edgelabel_index].predecessor()) {
+    const BDEdgeLabel& edgelabel = edgelabels_forward_[edgelabel_index];
+    path.emplace_back(edgelabel.mode(), edgelabel.cost(), edgelabel.edgeid(), 0, 0,
+                      edgelabel.restriction_idx(), edgelabel.transition_cost());
+    has_ferry_ = has_ferry_ || edgelabel.use() == Use::kFerry;
+  }
+  std::reverse(path.begin(), path.end());
+
+  // Append the reverse path to the destination using the opposing edges. The turn onto each edge
+  // is kept on the label before it
+  Cost transition_cost = rev_label.transition_cost();
+  for (auto edgelabel_index = rev_label.predecessor(); edgelabel_index != kInvalidLabel;
+       edgelabel_index = edgelabels_reverse_[edgelabel_index].predecessor()) {
+    const BDEdgeLabel& edgelabel = edgelabels_reverse_[edgelabel_index];
+    path.emplace_back(edgelabel.mode(), total - remaining(edgelabel), edgelabel.opp_edgeid(), 0, 0,
+                      kInvalidRestriction, transition_cost);
+    transition_cost = edgelabel.transition_cost();
+    has_ferry_ = has_ferry_ || edgelabel.use() == Use::kFerry;
+  }
+
+  return path;
+}
+
+} // namespace thor
+} // namespace valhalla
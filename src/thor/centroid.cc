@@ -1,4 +1,5 @@
 #include "thor/centroid.h"
+#include "midgard/executor.h"
 
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
@@ -69,9 +70,9 @@ PathIntersection::PathIntersection(uint64_t edge_id, uint64_t opp_id, uint8_t lo
 bool PathIntersection::AddPath(uint8_t path_id) const {
   assert(path_id < 128);
   if (path_id < 64) {
-    lower_mask_ |= 1 << static_cast<uint64_t>(path_id);
+    lower_mask_ |= 1ull << static_cast<uint64_t>(path_id);
   } else {
-    upper_mask_ |= 1 << static_cast<uint64_t>(path_id - 64);
+    upper_mask_ |= 1ull << static_cast<uint64_t>(path_id - 64);
   }
   // this will only be true once all the bits are flipped to true
   return (lower_mask_ & upper_mask_) == 0xffffffffffffffff;
@@ -81,9 +82,9 @@ bool PathIntersection::AddPath(uint8_t path_id) const {
 bool PathIntersection::HasConverged(uint8_t path_id) const {
   assert(path_id < 128);
   if (path_id < 64) {
-    return lower_mask_ & (1 << static_cast<uint64_t>(path_id));
+    return lower_mask_ & (1ull << static_cast<uint64_t>(path_id));
   } else {
-    return upper_mask_ & (1 << static_cast<uint64_t>(path_id - 64));
+    return upper_mask_ & (1ull << static_cast<uint64_t>(path_id - 64));
   }
 }
 
@@ -92,6 +93,51 @@ bool PathIntersection::operator==(const PathIntersection& i) const {
   return edge_id_ == i.edge_id_;
 }
 
+SharedIntersections::SharedIntersections(uint8_t location_count)
+    : location_count_(location_count),
+      best_(baldr::kInvalidGraphId, baldr::kInvalidGraphId, location_count),
+      bound_(std::numeric_limits<float>::max()) {
+}
+
+// the path reached the edge, the edge is a centroid once all paths did
+void SharedIntersections::AddPath(uint64_t edge_id, uint64_t opp_id, uint8_t path_id, float cost) {
+  PathIntersection intersection(edge_id, opp_id, location_count_);
+  auto& shard = shards_[intersection.edge_id_ % shards_.size()];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto& found =
+      shard.intersections.emplace(intersection.edge_id_, std::make_pair(intersection, 0.f))
+          .first->second;
+
+  // a path can settle both directions of the edge, only the first one counts
+  if (found.first.HasConverged(path_id)) {
+    return;
+  }
+  found.second = std::max(found.second, cost);
+  if (!found.first.AddPath(path_id)) {
+    return;
+  }
+
+  // keep the centroid whose most expensive path is the cheapest, the lower id on a tie
+  std::lock_guard<std::mutex> best_lock(best_mutex_);
+  if (found.second < bound_.load() ||
+      (found.second == bound_.load() && found.first.edge_id_ < best_.edge_id_)) {
+    best_ = found.first;
+    bound_ = found.second;
+  }
+}
+
+Centroid::Centroid(const boost::property_tree::ptree& config) : Dijkstras(config) {
+  // Extra expansions for groups of locations, they only get to run once readers are set
+  const auto threads = config.get<uint32_t>("matrix_threads", 1);
+  if (threads > 1) {
+    auto worker_config = config;
+    worker_config.put("matrix_threads", 1);
+    for (uint32_t i = 1; i < threads; ++i) {
+      workers_.emplace_back(new Centroid(worker_config));
+    }
+  }
+}
+
 // main entry point to the functionality
 std::vector<std::vector<PathInfo>> Centroid::Expand(const ExpansionType& expansion_type,
                                                     valhalla::Api& api,
@@ -111,11 +157,75 @@ std::vector<std::vector<PathInfo>> Centroid::Expand(const ExpansionType& expansi
   // tell dijkstras we want to track the locations' paths separately/concurrently
   multipath_ = true;
 
+  // with more threads the locations are expanded in groups, one on each thread. the expansion of
+  // the multimodal graph and a tracked expansion stay on this thread
+  const uint32_t group_count = std::min<uint32_t>(thread_count(), location_count_);
+  if (group_count > 1 && expansion_type != ExpansionType::multimodal && !expansion_callback_) {
+    auto& locations = *api.mutable_options()->mutable_locations();
+    if (expansion_type == ExpansionType::forward) {
+      ComputeGroups<ExpansionType::forward>(locations, reader, costings, mode, group_count);
+    } else {
+      ComputeGroups<ExpansionType::reverse>(locations, reader, costings, mode, group_count);
+    }
+    return FormPaths(expansion_type, api.options().locations(), &Centroid::bdedgelabels_, reader,
+                     centroid);
+  }
+
   // compute the expansion
+  group_count_ = 1;
+  group_ = 0;
   Dijkstras::Expand(expansion_type, api, reader, costings, mode);
 
   // create the paths from the labelset
-  return FormPaths(expansion_type, api.options().locations(), bdedgelabels_, reader, centroid);
+  return FormPaths(expansion_type, api.options().locations(), &Centroid::bdedgelabels_, reader,
+                   centroid);
+}
+
+template <const ExpansionType expansion_direction>
+void Centroid::ComputeGroups(google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                             baldr::GraphReader& reader,
+                             const sif::mode_costing_t& costings,
+                             const sif::TravelMode mode,
+                             const uint32_t group_count) {
+  SharedIntersections shared(location_count_);
+  const auto compute_group = [&](Centroid& expansion, baldr::GraphReader& group_reader,
+                                 const uint8_t group) {
+    google::protobuf::RepeatedPtrField<valhalla::Location> group_locations;
+    for (int i = group; i < locations.size(); i += group_count) {
+      group_locations.Add()->CopyFrom(locations.Get(i));
+    }
+    expansion.multipath_ = true;
+    expansion.shared_ = &shared;
+    expansion.group_count_ = group_count;
+    expansion.group_ = group;
+    expansion.Compute<expansion_direction>(group_locations, group_reader, costings, mode);
+    expansion.shared_ = nullptr;
+  };
+
+  // this thread takes the first group and idle threads of the shared pool the others
+  try {
+    midgard::executor_t::shared().run(group_count, [&](uint32_t slot) {
+      try {
+        if (slot == 0) {
+          compute_group(*this, reader, 0);
+        } else {
+          compute_group(*workers_[slot - 1], *thread_readers_[slot - 1], slot);
+        }
+      } catch (...) {
+        // make the other groups stop expanding
+        shared.Stop();
+        throw;
+      }
+    });
+  } catch (...) {
+    shared_ = nullptr;
+    for (auto& worker : workers_) {
+      worker->shared_ = nullptr;
+      worker->Clear();
+    }
+    throw;
+  }
+  best_intersection_ = shared.best();
 }
 
 // this is fired when the edge in the label has been settled (shortest path found) so we need to check
@@ -125,6 +235,11 @@ thor::ExpansionRecommendation Centroid::ShouldExpand(baldr::GraphReader& reader,
                                                      const thor::ExpansionType) {
   // TODO: we should quit earlier if finding a centroid isnt working out
 
+  // an expansion of a group of locations stops once no path it finds could meet for less
+  if (shared_ && label.cost().cost >= shared_->bound()) {
+    return thor::ExpansionRecommendation::stop_expansion;
+  }
+
   // TODO: refactor dijkstras a bit to get the tile and send it to us so we dont have to
 
   // grab the opposing edge if you can
@@ -135,6 +250,13 @@ thor::ExpansionRecommendation Centroid::ShouldExpand(baldr::GraphReader& reader,
     opp_id.set_id(node->edge_index() + label.opp_index());
   }
 
+  // the expansions of the groups share the intersections
+  if (shared_) {
+    shared_->AddPath(label.edgeid(), opp_id, label.path_id() * group_count_ + group_,
+                     label.cost().cost);
+    return thor::ExpansionRecommendation::continue_expansion;
+  }
+
   // see if we have seen this edge before
   PathIntersection intersection(label.edgeid(), opp_id, location_count_);
   auto found = intersections_.find(intersection);
@@ -172,6 +294,13 @@ void Centroid::GetExpansionHints(uint32_t& bucket_count, uint32_t& edge_label_re
 void Centroid::Clear() {
   intersections_.clear();
   Dijkstras::Clear();
+  for (auto& worker : workers_) {
+    if (clear_reserved_memory_) {
+      worker->Release();
+    } else {
+      worker->Clear();
+    }
+  }
 }
 
 // walk edge labels to form paths for each location to the centroid
@@ -179,7 +308,7 @@ template <typename label_container_t>
 std::vector<std::vector<PathInfo>>
 Centroid::FormPaths(const ExpansionType& expansion_type,
                     const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
-                    const label_container_t& labels,
+                    label_container_t Dijkstras::*group_labels,
                     baldr::GraphReader& reader,
                     valhalla::Location& centroid) const {
   // construct a centroid where all the paths meet
@@ -205,9 +334,14 @@ Centroid::FormPaths(const ExpansionType& expansion_type,
       continue;
     path.reserve(path_reservation);
 
+    // the expansion of the group of this location has its labels
+    const auto& expansion = group(path_id % group_count_);
+    const auto& labels = expansion.*group_labels;
+    const uint8_t group_path_id = path_id / group_count_;
+
     // grab the edge statuses for both potential paths to two edges at the centroid
-    auto status = edgestatus_.Get(edge_id, path_id);
-    auto opp_status = edgestatus_.Get(opp_id, path_id);
+    auto status = expansion.edgestatus_.Get(edge_id, group_path_id);
+    auto opp_status = expansion.edgestatus_.Get(opp_id, group_path_id);
 
     // check the edge status for both edges and find the label that was on the cheapest path
     // if the first status either wasnt settled (or even reached) or it was but it wasnt cheapest
@@ -245,14 +379,14 @@ Centroid::FormPaths(const ExpansionType& expansion_type,
 template std::vector<std::vector<PathInfo>> Centroid::FormPaths<decltype(Dijkstras::bdedgelabels_)>(
     const ExpansionType&,
     const google::protobuf::RepeatedPtrField<valhalla::Location>&,
-    const decltype(Dijkstras::bdedgelabels_)&,
+    decltype(Dijkstras::bdedgelabels_) Dijkstras::*,
     baldr::GraphReader&,
     valhalla::Location&) const;
 
 template std::vector<std::vector<PathInfo>> Centroid::FormPaths<decltype(Dijkstras::mmedgelabels_)>(
     const ExpansionType&,
     const google::protobuf::RepeatedPtrField<valhalla::Location>&,
-    const decltype(Dijkstras::mmedgelabels_)&,
+    decltype(Dijkstras::mmedgelabels_) Dijkstras::*,
     baldr::GraphReader&,
     valhalla::Location&) const;
 
@@ -0,0 +1,670 @@
+#include "thor/connection_scan.h"
+#include "baldr/datetime.h"
+#include "baldr/tilehierarchy.h"
+#include "baldr/time_info.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/logging.h"
+#include "worker.h"
+#include <algorithm>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::sif;
+
+namespace {
+
+// Seconds to stay at a stop to change from one trip to another there
+constexpr uint32_t kStaySecs = 30;
+
+// A profile query looks at the departures within this long of the requested time
+constexpr uint32_t kProfileWindow = kSecondsPerHour;
+
+// Only departures within this long of the last time to leave the origin are scanned
+constexpr uint32_t kScanHorizon = 4 * kSecondsPerHour;
+
+// Transit lines may leave the box around the origin and destination, it is widened by half the
+// distance between them but at least by this many meters
+constexpr float kMinBoxMargin = 10000.0f;
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+ConnectionScan::ConnectionScan(const boost::property_tree::ptree& config)
+    : PathAlgorithm(config.get<uint32_t>("max_reserved_labels_count_astar",
+                                         kInitialEdgeLabelCountAstar),
+                    config.get<bool>("clear_reserved_memory", false)),
+      max_walking_dist_(0), max_transfer_distance_(0), start_time_(0), stay_secs_(kStaySecs),
+      enter_secs_(0), transfer_secs_(0), scanned_(0), best_time_(kInvalidLabel),
+      best_stop_(kInvalidLabel), direct_time_(kInvalidLabel), direct_label_(kInvalidLabel) {
+}
+
+ConnectionScan::~ConnectionScan() {
+}
+
+void ConnectionScan::Clear() {
+  auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
+  if (walk_labels_.capacity() > reservation) {
+    walk_labels_.resize(reservation);
+    walk_labels_.shrink_to_fit();
+  }
+  walk_labels_.clear();
+  adjacencylist_.clear();
+  edgestatus_.clear(reservation);
+  destinations_.clear();
+  stops_.clear();
+  stop_index_.clear();
+  connections_.clear();
+  boarded_.clear();
+  egress_.clear();
+  footpaths_.clear();
+  scanned_ = 0;
+  best_time_ = kInvalidLabel;
+  best_stop_ = kInvalidLabel;
+  direct_time_ = kInvalidLabel;
+  direct_label_ = kInvalidLabel;
+  has_ferry_ = false;
+}
+
+std::vector<std::vector<PathInfo>>
+ConnectionScan::GetBestPath(valhalla::Location& origin,
+                            valhalla::Location& destination,
+                            GraphReader& graphreader,
+                            const sif::mode_costing_t& mode_costing,
+                            const travel_mode_t,
+                            const Options& options) {
+  // Walks may use transit connections, the transit costing decides which lines may be ridden
+  const auto& pc = mode_costing[static_cast<uint32_t>(travel_mode_t::kPedestrian)];
+  const auto& tc = mode_costing[static_cast<uint32_t>(travel_mode_t::kPublicTransit)];
+  pc->SetAllowTransitConnections(true);
+  const auto& pedestrian = options.costings().find(Costing::pedestrian)->second;
+  max_walking_dist_ = pedestrian.options().transit_start_end_max_distance();
+  max_transfer_distance_ = pc->GetMaxTransferDistanceMM();
+  enter_secs_ = tc->DefaultTransferCost().secs;
+  transfer_secs_ = tc->TransferCost().secs;
+
+  // For now the date_time must be set on the origin. Resolve a current time to the local time
+  if (origin.date_time().empty()) {
+    return {};
+  }
+  TimeInfo::make(origin, graphreader, &tz_cache_);
+  start_time_ = DateTime::seconds_from_midnight(origin.date_time());
+  const uint32_t window = options.alternates() ? kProfileWindow : 0;
+
+  // The timetable of the lines around the origin and destination
+  PointLL a(origin.ll().lng(), origin.ll().lat());
+  PointLL b(destination.ll().lng(), destination.ll().lat());
+  const float margin = std::max(static_cast<float>(a.Distance(b)) * 0.5f, kMinBoxMargin);
+  const float lat = (a.lat() + b.lat()) * 0.5f;
+  const float lat_margin = margin / kMetersPerDegreeLat;
+  const float lng_margin = margin / DistanceApproximator<PointLL>::MetersPerLngDegree(lat);
+  AABB2<PointLL> box(std::min(a.lng(), b.lng()) - lng_margin,
+                     std::min(a.lat(), b.lat()) - lat_margin,
+                     std::max(a.lng(), b.lng()) + lng_margin,
+                     std::max(a.lat(), b.lat()) + lat_margin);
+  LoadConnections(graphreader, box, tc, origin.date_time(), start_time_ + window + kScanHorizon);
+
+  // The walks to the destination and from the origin, the latter may reach the destination too
+  WalkToDestination(graphreader, destination, pc);
+  const auto access = WalkFromOrigin(graphreader, origin, destination, pc);
+  if (egress_.empty() && direct_label_ == kInvalidLabel) {
+    throw valhalla_exception_t{440};
+  }
+
+  // The stops walked to from the origin and how long it takes
+  std::unordered_map<uint32_t, uint32_t> access_stops;
+  for (const auto& reached : access) {
+    auto stop = stop_index_.find(reached.first);
+    if (stop != stop_index_.cend()) {
+      access_stops.emplace(stop->second, reached.second);
+    }
+  }
+
+  // The times to leave the origin, latest first, the requested time is the last. For a profile
+  // they are the times which just make a connection leaving a stop near the origin
+  std::vector<uint32_t> departures;
+  if (window) {
+    for (const auto& connection : connections_) {
+      auto stop = access_stops.find(connection.from);
+      if (stop == access_stops.cend()) {
+        continue;
+      }
+      const uint32_t lead = walk_labels_[stop->second].cost().secs + enter_secs_;
+      if (connection.departure >= start_time_ + lead &&
+          connection.departure - lead <= start_time_ + window) {
+        departures.push_back(connection.departure - lead);
+      }
+    }
+    std::sort(departures.begin(), departures.end(), std::greater<uint32_t>());
+    departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
+    if (!departures.empty() && departures.back() == start_time_) {
+      departures.pop_back();
+    }
+  }
+  departures.push_back(start_time_);
+
+  // Each run keeps the times of the later ones, any it improves on at the destination is a journey
+  std::vector<std::vector<PathInfo>> journeys;
+  for (const auto leave : departures) {
+    const auto before = best_time_;
+    for (const auto& stop : access_stops) {
+      const uint32_t secs = walk_labels_[stop.second].cost().secs;
+      Reach(stop.first, {leave + secs, Via::kAccess, stop.second, kInvalidLabel}, enter_secs_);
+    }
+    // Only leaving right away may walk all the way
+    if (leave == start_time_ && direct_label_ != kInvalidLabel &&
+        start_time_ + direct_time_ < best_time_) {
+      best_time_ = start_time_ + direct_time_;
+      best_stop_ = kInvalidLabel;
+    }
+    Scan(graphreader, pc, leave);
+    if (best_time_ < before) {
+      journeys.emplace_back(FormPath(graphreader));
+    }
+  }
+  if (journeys.empty() || journeys.back().empty()) {
+    LOG_ERROR("Route failed after scanning " + std::to_string(scanned_) + " connections");
+    return {};
+  }
+
+  // The earliest arrival first and then the alternates leaving after it
+  std::reverse(journeys.begin(), journeys.end());
+  journeys.resize(std::min<size_t>(journeys.size(), options.alternates() + 1));
+  return journeys;
+}
+
+void ConnectionScan::LoadConnections(GraphReader& graphreader,
+                                     const AABB2<PointLL>& box,
+                                     const cost_ptr_t& tc,
+                                     const std::string& date_time,
+                                     const uint32_t end_time) {
+  const uint32_t date = DateTime::days_from_pivot_date(DateTime::get_formatted_date(date_time));
+  const uint32_t dow = DateTime::day_of_week_mask(date_time);
+  const EdgeLabel none;
+  const auto& level = TileHierarchy::GetTransitLevel();
+  for (const auto tile_index : level.tiles.TileList(box)) {
+    const GraphId tileid(tile_index, level.level, 0);
+    if (!graphreader.DoesTileExist(tileid)) {
+      continue;
+    }
+    auto tile = graphreader.GetGraphTile(tileid);
+    if (tile == nullptr) {
+      continue;
+    }
+    tc->AddToExcludeList(tile);
+
+    // Schedules count their days from when the transit data was fetched
+    const uint32_t date_created = tile->header()->date_created();
+    const bool date_before_tile = date < date_created;
+    const uint32_t day = date_before_tile ? 0 : date - date_created;
+
+    GraphId nodeid = tileid;
+    for (uint32_t n = 0; n < tile->header()->nodecount(); ++n, ++nodeid) {
+      const NodeInfo* node = tile->node(n);
+      if (node->type() != NodeType::kMultiUseTransitPlatform || tc->IsExcluded(tile, node)) {
+        continue;
+      }
+
+      GraphId edgeid(tileid.tileid(), tileid.level(), node->edge_index());
+      const DirectedEdge* edge = tile->directededge(node->edge_index());
+      for (uint32_t i = 0; i < node->edge_count(); ++i, ++edge, ++edgeid) {
+        uint8_t restriction_idx = kInvalidRestriction;
+        if (!edge->IsTransitLine() || tc->IsExcluded(tile, edge) ||
+            !tc->Allowed(edge, false, none, tile, edgeid, 0, 0, restriction_idx)) {
+          continue;
+        }
+
+        const uint32_t from = StopIndex(nodeid);
+        const uint32_t to = StopIndex(edge->endnode());
+        for (const auto& departure : tile->GetLineDepartures(edge->lineid())) {
+          if ((tc->wheelchair() && !departure.wheelchair_accessible()) ||
+              (tc->bicycle() && !departure.bicycle_accessible()) ||
+              !tile->GetTransitSchedule(departure.schedule_index())
+                   ->IsValid(day, dow, date_before_tile)) {
+            continue;
+          }
+
+          // A frequency schedule runs every so often until its end, skip the runs already gone
+          const bool frequent =
+              departure.type() == kFrequencySchedule && departure.frequency() > 0;
+          const uint32_t last = frequent ? departure.end_time() : departure.departure_time();
+          uint32_t time = departure.departure_time();
+          uint32_t run = 0;
+          if (frequent && time < start_time_) {
+            run = (start_time_ - time + departure.frequency() - 1) / departure.frequency();
+            time += run * departure.frequency();
+          }
+          for (; time <= last && time < end_time; time += departure.frequency(), ++run) {
+            if (time >= start_time_) {
+              connections_.push_back({time, time + departure.elapsed_time(), from, to,
+                                      (static_cast<uint64_t>(departure.tripid()) << 32) | run,
+                                      departure.tripid(), edgeid});
+            }
+            if (!frequent) {
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  std::sort(connections_.begin(), connections_.end(),
+            [](const connection_t& a, const connection_t& b) {
+              return a.departure < b.departure ||
+                     (a.departure == b.departure && a.arrival < b.arrival);
+            });
+}
+
+uint32_t ConnectionScan::StopIndex(const GraphId& node) {
+  auto inserted = stop_index_.emplace(node, stops_.size());
+  if (inserted.second) {
+    stops_.push_back({node, {}, {}});
+  }
+  return inserted.first->second;
+}
+
+void ConnectionScan::Walk(GraphReader& graphreader,
+                          const cost_ptr_t& pc,
+                          const uint32_t max_distance,
+                          std::unordered_map<uint64_t, uint32_t>& reached) {
+  size_t total_labels = 0;
+  uint32_t predindex;
+  while ((predindex = adjacencylist_.pop()) != kInvalidLabel) {
+    // Allow this process to be aborted
+    size_t current_labels = walk_labels_.size();
+    if (interrupt &&
+        total_labels / kInterruptIterationsInterval <
+            current_labels / kInterruptIterationsInterval) {
+      (*interrupt)();
+    }
+    total_labels = current_labels;
+
+    // Walks do not go through stops, they end there
+    const EdgeLabel pred = walk_labels_[predindex];
+    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+    auto tile = graphreader.GetGraphTile(pred.endnode());
+    if (tile == nullptr) {
+      continue;
+    }
+    if (tile->node(pred.endnode())->type() == NodeType::kMultiUseTransitPlatform) {
+      reached.emplace(pred.endnode(), predindex);
+      continue;
+    }
+    ExpandWalk(graphreader, pred.endnode(), pred, predindex, pc, max_distance, false);
+  }
+}
+
+void ConnectionScan::ExpandWalk(GraphReader& graphreader,
+                                const GraphId& node,
+                                const EdgeLabel& pred,
+                                const uint32_t pred_idx,
+                                const cost_ptr_t& pc,
+                                const uint32_t max_distance,
+                                const bool from_transition) {
+  auto tile = graphreader.GetGraphTile(node);
+  if (tile == nullptr) {
+    return;
+  }
+  const NodeInfo* nodeinfo = tile->node(node);
+  if (!pc->Allowed(nodeinfo)) {
+    return;
+  }
+
+  GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
+  EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile);
+  const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+  for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++, ++edgeid, ++es) {
+    // Transit lines are ridden in the scan, not walked
+    if (directededge->is_shortcut() || directededge->IsTransitLine() ||
+        es->set() == EdgeSet::kPermanent) {
+      continue;
+    }
+
+    // Do not go into a station and straight back out to the street
+    if (nodeinfo->type() == NodeType::kTransitEgress && pred.use() == Use::kTransitConnection &&
+        directededge->use() == Use::kTransitConnection) {
+      continue;
+    }
+
+    uint8_t restriction_idx = kInvalidRestriction;
+    const uint32_t path_distance = pred.path_distance() + directededge->length();
+    if (path_distance > max_distance ||
+        !pc->Allowed(directededge, false, pred, tile, edgeid, 0, 0, restriction_idx)) {
+      continue;
+    }
+
+    const Cost transition_cost = pc->TransitionCost(directededge, nodeinfo, pred);
+    const Cost newcost = pred.cost() + pc->EdgeCost(directededge, tile) + transition_cost;
+    if (es->set() == EdgeSet::kTemporary) {
+      EdgeLabel& lab = walk_labels_[es->index()];
+      if (newcost.cost < lab.cost().cost) {
+        adjacencylist_.decrease(es->index(), newcost.cost);
+        lab.Update(pred_idx, newcost, newcost.cost, path_distance, transition_cost,
+                   restriction_idx);
+      }
+      continue;
+    }
+
+    uint32_t idx = walk_labels_.size();
+    walk_labels_.emplace_back(pred_idx, edgeid, directededge, newcost, newcost.cost, 0.0f,
+                              travel_mode_t::kPedestrian, path_distance, transition_cost,
+                              restriction_idx, true, false, InternalTurn::kNoTurn);
+    *es = {EdgeSet::kTemporary, idx};
+    adjacencylist_.add(idx);
+  }
+
+  // Handle transitions - expand from the end node each transition
+  if (!from_transition && nodeinfo->transition_count() > 0) {
+    const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+    for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+      ExpandWalk(graphreader, trans->endnode(), pred, pred_idx, pc, max_distance, true);
+    }
+  }
+}
+
+void ConnectionScan::WalkToDestination(GraphReader& graphreader,
+                                       const valhalla::Location& destination,
+                                       const cost_ptr_t& pc) {
+  uint32_t bucketsize = pc->UnitSize();
+  adjacencylist_.reuse(0.0f, kBucketCount * bucketsize, bucketsize, &walk_labels_);
+  edgestatus_.clear();
+
+  // Only skip outbound edges if we have other options
+  bool has_other_edges = std::any_of(destination.correlation().edges().begin(),
+                                     destination.correlation().edges().end(),
+                                     [](const valhalla::PathEdge& e) { return !e.begin_node(); });
+
+  // Walk backwards along the opposing edges, from the destination to their starts
+  for (const auto& edge : destination.correlation().edges()) {
+    GraphId edgeid(edge.graph_id());
+    if ((has_other_edges && edge.begin_node()) ||
+        pc->AvoidAsDestinationEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    destinations_[edgeid] = pc->EdgeCost(directededge, tile) * (1.0f - edge.percent_along());
+
+    graph_tile_ptr opp_tile = tile;
+    GraphId oppedge = graphreader.GetOpposingEdgeId(edgeid, opp_tile);
+    if (!oppedge.Is_Valid()) {
+      continue;
+    }
+    const DirectedEdge* opp_diredge = opp_tile->directededge(oppedge);
+    Cost cost = pc->EdgeCost(opp_diredge, opp_tile) * edge.percent_along();
+    uint32_t length = static_cast<uint32_t>(opp_diredge->length() * edge.percent_along());
+    uint32_t idx = walk_labels_.size();
+    walk_labels_.emplace_back(kInvalidLabel, oppedge, opp_diredge, cost, cost.cost, 0.0f,
+                              travel_mode_t::kPedestrian, length, Cost{}, kInvalidRestriction,
+                              true, false, InternalTurn::kNoTurn);
+    adjacencylist_.add(idx);
+    edgestatus_.Set(oppedge, EdgeSet::kTemporary, idx, opp_tile);
+  }
+
+  std::unordered_map<uint64_t, uint32_t> reached;
+  Walk(graphreader, pc, max_walking_dist_, reached);
+  for (const auto& stop : reached) {
+    auto index = stop_index_.find(stop.first);
+    if (index != stop_index_.cend()) {
+      egress_.emplace(index->second,
+                      std::make_pair(walk_labels_[stop.second].cost().secs, stop.second));
+    }
+  }
+}
+
+std::unordered_map<uint64_t, uint32_t>
+ConnectionScan::WalkFromOrigin(GraphReader& graphreader,
+                               valhalla::Location& origin,
+                               const valhalla::Location& destination,
+                               const cost_ptr_t& pc) {
+  uint32_t bucketsize = pc->UnitSize();
+  adjacencylist_.reuse(0.0f, kBucketCount * bucketsize, bucketsize, &walk_labels_);
+  edgestatus_.clear();
+
+  // Only skip inbound edges if we have other options
+  bool has_other_edges = std::any_of(origin.correlation().edges().begin(),
+                                     origin.correlation().edges().end(),
+                                     [](const valhalla::PathEdge& e) { return !e.end_node(); });
+
+  for (const auto& edge : origin.correlation().edges()) {
+    GraphId edgeid(edge.graph_id());
+    if ((has_other_edges && edge.end_node()) ||
+        pc->AvoidAsOriginEdge(edgeid, edge.percent_along())) {
+      continue;
+    }
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    Cost cost = pc->EdgeCost(directededge, tile) * (1.0f - edge.percent_along());
+    uint32_t length = static_cast<uint32_t>(directededge->length() * (1.0f - edge.percent_along()));
+    uint32_t idx = walk_labels_.size();
+    walk_labels_.emplace_back(kInvalidLabel, edgeid, directededge, cost, cost.cost, 0.0f,
+                              travel_mode_t::kPedestrian, length, Cost{}, kInvalidRestriction,
+                              true, false, InternalTurn::kNoTurn);
+    adjacencylist_.add(idx);
+    edgestatus_.Set(edgeid, EdgeSet::kTemporary, idx, tile);
+  }
+
+  std::unordered_map<uint64_t, uint32_t> reached;
+  Walk(graphreader, pc, max_walking_dist_, reached);
+
+  // Walking all the way, an origin edge only gets there if the destination is ahead on it
+  for (const auto& dest : destinations_) {
+    GraphId edgeid(dest.first);
+    graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const EdgeStatusInfo* es = edgestatus_.GetPtr(edgeid, tile);
+    if (es->set() == EdgeSet::kUnreachedOrReset || es->set() == EdgeSet::kSkipped) {
+      continue;
+    }
+    const EdgeLabel& label = walk_labels_[es->index()];
+    if (label.predecessor() == kInvalidLabel && !IsTrivial(edgeid, origin, destination)) {
+      continue;
+    }
+    const uint32_t secs = std::max(label.cost().secs - dest.second.secs, 0.0f);
+    if (secs < direct_time_) {
+      direct_time_ = secs;
+      direct_label_ = es->index();
+    }
+  }
+  return reached;
+}
+
+const std::vector<ConnectionScan::footpath_t>&
+ConnectionScan::Footpaths(GraphReader& graphreader, const cost_ptr_t& pc, const uint32_t stop) {
+  auto found = footpaths_.find(stop);
+  if (found != footpaths_.cend()) {
+    return found->second;
+  }
+
+  uint32_t bucketsize = pc->UnitSize();
+  adjacencylist_.reuse(0.0f, kBucketCount * bucketsize, bucketsize, &walk_labels_);
+  edgestatus_.clear();
+  ExpandWalk(graphreader, stops_[stop].node, EdgeLabel(), kInvalidLabel, pc, max_transfer_distance_,
+             false);
+  std::unordered_map<uint64_t, uint32_t> reached;
+  Walk(graphreader, pc, max_transfer_distance_, reached);
+
+  auto& footpaths = footpaths_[stop];
+  for (const auto& other : reached) {
+    auto index = stop_index_.find(other.first);
+    if (index != stop_index_.cend() && index->second != stop) {
+      footpaths.push_back({index->second,
+                           static_cast<uint32_t>(walk_labels_[other.second].cost().secs),
+                           other.second});
+    }
+  }
+  return footpaths;
+}
+
+bool ConnectionScan::Reach(const uint32_t stop,
+                           const reach_t& arrival,
+                           const uint32_t boarding_delay) {
+  auto& reached = stops_[stop];
+  reach_t boarding = arrival;
+  boarding.time += boarding_delay;
+  if (boarding.time < reached.boarding.time) {
+    reached.boarding = boarding;
+  }
+  if (arrival.time >= reached.arrival.time) {
+    return false;
+  }
+  reached.arrival = arrival;
+
+  // Walk to the destination from here, unless it was only walked through
+  auto egress = arrival.via == Via::kAccess ? egress_.cend() : egress_.find(stop);
+  if (egress != egress_.cend() && arrival.time + egress->second.first < best_time_) {
+    best_time_ = arrival.time + egress->second.first;
+    best_stop_ = stop;
+  }
+  return true;
+}
+
+void ConnectionScan::Scan(GraphReader& graphreader,
+                          const cost_ptr_t& pc,
+                          const uint32_t from_time) {
+  boarded_.clear();
+  auto first = std::lower_bound(connections_.cbegin(), connections_.cend(), from_time,
+                                [](const connection_t& c, const uint32_t time) {
+                                  return c.departure < time;
+                                });
+  for (uint32_t i = first - connections_.cbegin(); i < connections_.size(); ++i) {
+    // Allow this process to be aborted
+    if (interrupt && (i % kInterruptIterationsInterval) == 0) {
+      (*interrupt)();
+    }
+
+    // Nothing leaving later gets to the destination any earlier
+    const auto& connection = connections_[i];
+    if (connection.departure >= best_time_) {
+      break;
+    }
+    ++scanned_;
+
+    // Stay on a trip once on it, otherwise get on if there is time to
+    auto trip = boarded_.find(connection.run);
+    if (trip == boarded_.end()) {
+      if (stops_[connection.from].boarding.time > connection.departure) {
+        continue;
+      }
+      trip = boarded_.emplace(connection.run, i).first;
+    }
+    if (!Reach(connection.to, {connection.arrival, Via::kRide, i, trip->second}, stay_secs_)) {
+      continue;
+    }
+
+    // Getting off here earlier than before, walk over to the stops around
+    for (const auto& footpath : Footpaths(graphreader, pc, connection.to)) {
+      Reach(footpath.to,
+            {connection.arrival + footpath.secs, Via::kWalk, connection.to, footpath.label},
+            transfer_secs_);
+    }
+  }
+}
+
+std::vector<PathInfo> ConnectionScan::FormPath(GraphReader& graphreader) {
+  std::vector<PathInfo> path;
+
+  // Walking all the way, the last edge ends at the destination rather than at its end node
+  if (best_stop_ == kInvalidLabel) {
+    AppendWalk(graphreader, direct_label_, start_time_, false, path);
+    path.back().elapsed_cost = Cost(direct_time_, direct_time_);
+    return path;
+  }
+
+  // Follow the stops back to the origin, each ride back to where its trip was boarded. The time to
+  // board includes the transfer made after getting to the stop
+  std::vector<std::pair<reach_t, uint32_t>> legs{{stops_[best_stop_].arrival, 0}};
+  while (legs.back().first.via != Via::kAccess) {
+    const auto& leg = legs.back().first;
+    if (leg.via == Via::kRide) {
+      const auto& boarding = stops_[connections_[leg.second].from].boarding;
+      legs.emplace_back(boarding, boarding.via == Via::kAccess
+                                      ? enter_secs_
+                                      : (boarding.via == Via::kWalk ? transfer_secs_ : stay_secs_));
+    } else if (leg.via == Via::kWalk) {
+      legs.emplace_back(stops_[leg.first].arrival, 0);
+    } else {
+      LOG_ERROR("Connection scan lost its way back to the origin");
+      return {};
+    }
+  }
+
+  for (auto leg = legs.crbegin(); leg != legs.crend(); ++leg) {
+    const auto& reach = leg->first;
+    if (reach.via == Via::kRide) {
+      const auto& last = connections_[reach.first];
+      for (uint32_t i = reach.second; i <= reach.first; ++i) {
+        const auto& connection = connections_[i];
+        if (connection.run != last.run) {
+          continue;
+        }
+        auto tile = graphreader.GetGraphTile(connection.edgeid);
+        const float length = tile ? tile->directededge(connection.edgeid)->length() : 0.0f;
+        const float secs = connection.arrival - start_time_;
+        path.emplace_back(travel_mode_t::kPublicTransit, Cost(secs, secs), connection.edgeid,
+                          connection.tripid,
+                          (path.empty() ? 0.0f : path.back().path_distance) + length);
+      }
+    } else {
+      // The walk ends at the time the stop was reached
+      const uint32_t label = reach.via == Via::kAccess ? reach.first : reach.second;
+      const uint32_t reached = reach.time - leg->second;
+      AppendWalk(graphreader, label, reached - walk_labels_[label].cost().secs, false, path);
+    }
+  }
+
+  // And walk from the last stop to the destination
+  const auto& egress = egress_.find(best_stop_)->second;
+  AppendWalk(graphreader, egress.second, stops_[best_stop_].arrival.time, true, path);
+  return path;
+}
+
+void ConnectionScan::AppendWalk(GraphReader& graphreader,
+                                const uint32_t label,
+                                const uint32_t start_time,
+                                const bool reverse,
+                                std::vector<PathInfo>& path) {
+  std::vector<uint32_t> labels;
+  for (auto idx = label; idx != kInvalidLabel; idx = walk_labels_[idx].predecessor()) {
+    labels.push_back(idx);
+  }
+  const float distance = path.empty() ? 0.0f : path.back().path_distance;
+  const float elapsed = static_cast<float>(start_time) - start_time_;
+
+  // Walking forwards the labels are in reverse order
+  if (!reverse) {
+    for (auto idx = labels.crbegin(); idx != labels.crend(); ++idx) {
+      const auto& walk = walk_labels_[*idx];
+      const float secs = elapsed + walk.cost().secs;
+      path.emplace_back(travel_mode_t::kPedestrian, Cost(secs, secs), walk.edgeid(), 0,
+                        distance + walk.path_distance(), walk.restriction_idx(),
+                        walk.transition_cost());
+    }
+    return;
+  }
+
+  // Walking backwards from the destination the labels are in order but on the opposing edges.
+  // The end of each edge is where the next label starts, what is left is the cost of that label
+  const auto& total = walk_labels_[labels.front()];
+  for (size_t i = 0; i < labels.size(); ++i) {
+    const auto& walk = walk_labels_[labels[i]];
+    const EdgeLabel* rest = i + 1 < labels.size() ? &walk_labels_[labels[i + 1]] : nullptr;
+    const float secs = elapsed + total.cost().secs - (rest ? rest->cost().secs : 0.0f);
+    const float walked = total.path_distance() - (rest ? rest->path_distance() : 0);
+    path.emplace_back(travel_mode_t::kPedestrian, Cost(secs, secs),
+                      graphreader.GetOpposingEdgeId(walk.edgeid()), 0, distance + walked);
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
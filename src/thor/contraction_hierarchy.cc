@@ -0,0 +1,465 @@
+#include "thor/contraction_hierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr char kMagic[4] = {'V', 'H', 'C', 'H'};
+constexpr uint32_t kVersion = 1;
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+using cost_node_t = std::pair<float, uint32_t>;
+using min_queue_t =
+    std::priority_queue<cost_node_t, std::vector<cost_node_t>, std::greater<cost_node_t>>;
+
+// A cheapest arc between the node being contracted and one of its neighbors
+struct Neighbor {
+  uint32_t node;
+  uint32_t arc;
+  float weight;
+};
+
+// Adds or improves the arc to a neighbor so that parallel arcs are only looked at once
+void add_neighbor(std::vector<Neighbor>& neighbors, uint32_t node, uint32_t arc, float weight) {
+  for (auto& neighbor : neighbors) {
+    if (neighbor.node == node) {
+      if (weight < neighbor.weight) {
+        neighbor.arc = arc;
+        neighbor.weight = weight;
+      }
+      return;
+    }
+  }
+  neighbors.push_back({node, arc, weight});
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+namespace {
+
+/**
+ * Does the bookkeeping while contracting: the arcs still connecting uncontracted nodes and the
+ * searches for witness paths.
+ */
+class Contractor {
+public:
+  Contractor(uint32_t node_count,
+             std::vector<uint32_t>& rank,
+             std::vector<ContractionHierarchy::Edge>& arcs,
+             std::vector<std::pair<uint32_t, uint32_t>>& children,
+             uint32_t max_witness_nodes)
+      : rank_(rank), arcs_(arcs), children_(children), max_witness_nodes_(max_witness_nodes),
+        out_(node_count), in_(node_count), contracted_neighbors_(node_count, 0),
+        distance_(node_count, kInfinity) {
+    for (uint32_t i = 0; i < arcs_.size(); ++i) {
+      out_[arcs_[i].from].push_back(i);
+      in_[arcs_[i].to].push_back(i);
+    }
+  }
+
+  /**
+   * Works out which shortcuts contracting a node would need.
+   * @param node       the node to contract
+   * @param shortcuts  filled with {in arc, out arc} pairs which need a shortcut
+   * @return the number of arcs to uncontracted neighbors which would be removed
+   */
+  uint32_t Simulate(uint32_t node, std::vector<std::pair<uint32_t, uint32_t>>& shortcuts) {
+    shortcuts.clear();
+    Gather(node);
+    for (const auto& in : ins_) {
+      // Only paths as long as the longest one through the node need to be looked at
+      float max_cost = 0.f;
+      for (const auto& out : outs_) {
+        if (out.node != in.node) {
+          max_cost = std::max(max_cost, in.weight + out.weight);
+        }
+      }
+      Witness(in.node, node, max_cost);
+      for (const auto& out : outs_) {
+        if (out.node != in.node && in.weight + out.weight < distance_[out.node]) {
+          shortcuts.emplace_back(in.arc, out.arc);
+        }
+      }
+    }
+    return static_cast<uint32_t>(ins_.size() + outs_.size());
+  }
+
+  /**
+   * @param node  the node to rate
+   * @return how much contracting the node now would add to the hierarchy, lower goes first
+   */
+  int Priority(uint32_t node) {
+    const uint32_t removed = Simulate(node, shortcuts_);
+    return static_cast<int>(shortcuts_.size()) - static_cast<int>(removed) +
+           static_cast<int>(contracted_neighbors_[node]);
+  }
+
+  /**
+   * Contracts the node, adding the shortcuts it needs. Must directly follow a call to Priority for
+   * the same node, whose simulation it reuses.
+   * @param node  the node to contract
+   * @param rank  its position in the contraction order
+   * @return the number of shortcuts added
+   */
+  uint32_t Contract(uint32_t node, uint32_t rank) {
+    for (const auto& shortcut : shortcuts_) {
+      const uint32_t from = arcs_[shortcut.first].from;
+      const uint32_t to = arcs_[shortcut.second].to;
+      const float weight = arcs_[shortcut.first].weight + arcs_[shortcut.second].weight;
+      const uint32_t index = static_cast<uint32_t>(arcs_.size());
+      arcs_.push_back({from, to, weight, 0});
+      children_.push_back(shortcut);
+      out_[from].push_back(index);
+      in_[to].push_back(index);
+    }
+    rank_[node] = rank;
+    for (const auto& neighbor : ins_) {
+      ++contracted_neighbors_[neighbor.node];
+    }
+    for (const auto& neighbor : outs_) {
+      ++contracted_neighbors_[neighbor.node];
+    }
+    return static_cast<uint32_t>(shortcuts_.size());
+  }
+
+private:
+  bool Contracted(uint32_t node) const {
+    return rank_[node] != ContractionHierarchy::kInvalidIndex;
+  }
+
+  // Collects the cheapest arc to every uncontracted neighbor in each direction
+  void Gather(uint32_t node) {
+    ins_.clear();
+    outs_.clear();
+    for (const auto arc : in_[node]) {
+      const auto from = arcs_[arc].from;
+      if (from != node && !Contracted(from)) {
+        add_neighbor(ins_, from, arc, arcs_[arc].weight);
+      }
+    }
+    for (const auto arc : out_[node]) {
+      const auto to = arcs_[arc].to;
+      if (to != node && !Contracted(to)) {
+        add_neighbor(outs_, to, arc, arcs_[arc].weight);
+      }
+    }
+  }
+
+  // Bounded Dijkstra from the source which does not pass the node being contracted, leaves the
+  // distances it found in distance_
+  void Witness(uint32_t source, uint32_t skip, float max_cost) {
+    for (const auto node : touched_) {
+      distance_[node] = kInfinity;
+    }
+    touched_.clear();
+
+    min_queue_t queue;
+    distance_[source] = 0.f;
+    touched_.push_back(source);
+    queue.emplace(0.f, source);
+    uint32_t settled = 0;
+    while (!queue.empty() && settled < max_witness_nodes_) {
+      const auto current = queue.top();
+      queue.pop();
+      if (current.first > distance_[current.second]) {
+        continue;
+      }
+      if (current.first > max_cost) {
+        break;
+      }
+      ++settled;
+      for (const auto arc : out_[current.second]) {
+        const auto to = arcs_[arc].to;
+        if (to == skip || Contracted(to)) {
+          continue;
+        }
+        const float cost = current.first + arcs_[arc].weight;
+        if (cost < distance_[to]) {
+          if (distance_[to] == kInfinity) {
+            touched_.push_back(to);
+          }
+          distance_[to] = cost;
+          queue.emplace(cost, to);
+        }
+      }
+    }
+  }
+
+  std::vector<uint32_t>& rank_;
+  std::vector<ContractionHierarchy::Edge>& arcs_;
+  std::vector<std::pair<uint32_t, uint32_t>>& children_;
+  uint32_t max_witness_nodes_;
+
+  std::vector<std::vector<uint32_t>> out_;
+  std::vector<std::vector<uint32_t>> in_;
+  std::vector<uint32_t> contracted_neighbors_;
+
+  std::vector<float> distance_;
+  std::vector<uint32_t> touched_;
+  std::vector<Neighbor> ins_;
+  std::vector<Neighbor> outs_;
+  std::vector<std::pair<uint32_t, uint32_t>> shortcuts_;
+};
+
+// Distance and the arc it was reached by for one direction of a query
+using labels_t = std::unordered_map<uint32_t, std::pair<float, uint32_t>>;
+
+// Settles the next node of one direction of the query
+void step(min_queue_t& queue,
+          labels_t& labels,
+          const labels_t& other,
+          const std::vector<uint32_t>& offsets,
+          const std::vector<uint32_t>& indices,
+          const std::function<uint32_t(uint32_t)>& next,
+          const std::function<float(uint32_t)>& weight,
+          float& best,
+          uint32_t& meet) {
+  const auto current = queue.top();
+  queue.pop();
+  if (current.first > labels[current.second].first) {
+    return;
+  }
+  auto found = other.find(current.second);
+  if (found != other.end() && current.first + found->second.first < best) {
+    best = current.first + found->second.first;
+    meet = current.second;
+  }
+  for (uint32_t i = offsets[current.second]; i < offsets[current.second + 1]; ++i) {
+    const uint32_t arc = indices[i];
+    const uint32_t node = next(arc);
+    const float cost = current.first + weight(arc);
+    auto label = labels.find(node);
+    if (label == labels.end() || cost < label->second.first) {
+      labels[node] = {cost, arc};
+      queue.emplace(cost, node);
+    }
+  }
+}
+
+template <typename T> void write_vector(std::ofstream& file, const std::vector<T>& values) {
+  const uint64_t size = values.size();
+  file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  file.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * size);
+}
+
+template <typename T> void read_vector(std::ifstream& file, std::vector<T>& values) {
+  uint64_t size = 0;
+  file.read(reinterpret_cast<char*>(&size), sizeof(size));
+  values.resize(size);
+  file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * size);
+}
+
+} // namespace
+
+ContractionHierarchy ContractionHierarchy::Build(uint32_t node_count,
+                                                 const std::vector<Edge>& edges,
+                                                 uint32_t max_witness_nodes) {
+  ContractionHierarchy ch;
+  ch.rank_.assign(node_count, kInvalidIndex);
+
+  // Self loops are never part of a shortest path so they are dropped right away
+  std::vector<Edge> arcs;
+  std::vector<std::pair<uint32_t, uint32_t>> children;
+  arcs.reserve(edges.size());
+  for (const auto& edge : edges) {
+    if (edge.from >= node_count || edge.to >= node_count) {
+      throw std::runtime_error("Edge refers to a node outside of the graph");
+    }
+    if (!(edge.weight >= 0.f) || std::isinf(edge.weight)) {
+      throw std::runtime_error("Edge weights must be finite and non-negative");
+    }
+    if (edge.from != edge.to) {
+      arcs.push_back(edge);
+      children.emplace_back(kInvalidIndex, kInvalidIndex);
+    }
+  }
+
+  // Contract the nodes in order of priority. Priorities only ever get worse as neighbors go away
+  // so they are updated lazily, a node is only contracted if it is still the best after a recheck
+  Contractor contractor(node_count, ch.rank_, arcs, children, max_witness_nodes);
+  using priority_node_t = std::pair<int, uint32_t>;
+  std::priority_queue<priority_node_t, std::vector<priority_node_t>, std::greater<priority_node_t>>
+      queue;
+  for (uint32_t node = 0; node < node_count; ++node) {
+    queue.emplace(contractor.Priority(node), node);
+  }
+  uint32_t rank = 0;
+  while (!queue.empty()) {
+    const uint32_t node = queue.top().second;
+    queue.pop();
+    const int priority = contractor.Priority(node);
+    if (!queue.empty() && priority > queue.top().first) {
+      queue.emplace(priority, node);
+      continue;
+    }
+    ch.shortcut_count_ += contractor.Contract(node, rank++);
+  }
+
+  ch.arcs_.reserve(arcs.size());
+  for (size_t i = 0; i < arcs.size(); ++i) {
+    ch.arcs_.push_back(Arc{arcs[i].from, arcs[i].to, arcs[i].weight, children[i].first,
+                           children[i].second, arcs[i].id});
+  }
+  ch.BuildSearchGraph();
+  return ch;
+}
+
+void ContractionHierarchy::BuildSearchGraph() {
+  up_offsets_.assign(rank_.size() + 1, 0);
+  down_offsets_.assign(rank_.size() + 1, 0);
+  for (const auto& arc : arcs_) {
+    if (rank_[arc.to] > rank_[arc.from]) {
+      ++up_offsets_[arc.from + 1];
+    } else {
+      ++down_offsets_[arc.to + 1];
+    }
+  }
+  for (size_t i = 1; i < up_offsets_.size(); ++i) {
+    up_offsets_[i] += up_offsets_[i - 1];
+    down_offsets_[i] += down_offsets_[i - 1];
+  }
+
+  up_arcs_.resize(up_offsets_.back());
+  down_arcs_.resize(down_offsets_.back());
+  std::vector<uint32_t> up_fill(up_offsets_.begin(), up_offsets_.end() - 1);
+  std::vector<uint32_t> down_fill(down_offsets_.begin(), down_offsets_.end() - 1);
+  for (uint32_t i = 0; i < arcs_.size(); ++i) {
+    const auto& arc = arcs_[i];
+    if (rank_[arc.to] > rank_[arc.from]) {
+      up_arcs_[up_fill[arc.from]++] = i;
+    } else {
+      down_arcs_[down_fill[arc.to]++] = i;
+    }
+  }
+}
+
+bool ContractionHierarchy::Query(uint32_t source, uint32_t target, Path& path) const {
+  if (source >= node_count() || target >= node_count()) {
+    throw std::runtime_error("Query node outside of the graph");
+  }
+  path.cost = 0.f;
+  path.edges.clear();
+  if (source == target) {
+    return true;
+  }
+
+  labels_t forward, backward;
+  min_queue_t forward_queue, backward_queue;
+  forward[source] = {0.f, kInvalidIndex};
+  backward[target] = {0.f, kInvalidIndex};
+  forward_queue.emplace(0.f, source);
+  backward_queue.emplace(0.f, target);
+
+  const auto weight = [this](uint32_t arc) { return arcs_[arc].weight; };
+  const auto up = [this](uint32_t arc) { return arcs_[arc].to; };
+  const auto down = [this](uint32_t arc) { return arcs_[arc].from; };
+
+  // Alternate between the directions until neither can improve on the best meeting point
+  float best = kInfinity;
+  uint32_t meet = kInvalidIndex;
+  while (true) {
+    const bool go_forward = !forward_queue.empty() && forward_queue.top().first < best;
+    const bool go_backward = !backward_queue.empty() && backward_queue.top().first < best;
+    if (!go_forward && !go_backward) {
+      break;
+    }
+    if (go_forward) {
+      step(forward_queue, forward, backward, up_offsets_, up_arcs_, up, weight, best, meet);
+    }
+    if (go_backward) {
+      step(backward_queue, backward, forward, down_offsets_, down_arcs_, down, weight, best, meet);
+    }
+  }
+  if (meet == kInvalidIndex) {
+    return false;
+  }
+
+  // Walk from the meeting point back to the source, then on to the target
+  std::vector<uint32_t> arcs;
+  for (uint32_t node = meet; node != source;) {
+    const uint32_t arc = forward.find(node)->second.second;
+    arcs.push_back(arc);
+    node = arcs_[arc].from;
+  }
+  std::reverse(arcs.begin(), arcs.end());
+  for (uint32_t node = meet; node != target;) {
+    const uint32_t arc = backward.find(node)->second.second;
+    arcs.push_back(arc);
+    node = arcs_[arc].to;
+  }
+
+  path.cost = best;
+  for (const auto arc : arcs) {
+    Unpack(arc, path.edges);
+  }
+  return true;
+}
+
+void ContractionHierarchy::Unpack(uint32_t arc, std::vector<uint64_t>& edges) const {
+  // Shortcuts nest, so expand them with a stack rather than recursion
+  std::vector<uint32_t> stack{arc};
+  while (!stack.empty()) {
+    const auto& current = arcs_[stack.back()];
+    stack.pop_back();
+    if (current.first == kInvalidIndex) {
+      edges.push_back(current.id);
+    } else {
+      stack.push_back(current.second);
+      stack.push_back(current.first);
+    }
+  }
+}
+
+void ContractionHierarchy::Write(const std::string& file) const {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Could not open " + file + " for writing");
+  }
+  out.write(kMagic, sizeof(kMagic));
+  out.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  out.write(reinterpret_cast<const char*>(&shortcut_count_), sizeof(shortcut_count_));
+  write_vector(out, rank_);
+  write_vector(out, arcs_);
+  if (!out) {
+    throw std::runtime_error("Failed writing " + file);
+  }
+}
+
+ContractionHierarchy ContractionHierarchy::Read(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open " + file + " for reading");
+  }
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion) {
+    throw std::runtime_error(file + " is not a contraction hierarchy of version " +
+                             std::to_string(kVersion));
+  }
+
+  ContractionHierarchy ch;
+  in.read(reinterpret_cast<char*>(&ch.shortcut_count_), sizeof(ch.shortcut_count_));
+  read_vector(in, ch.rank_);
+  read_vector(in, ch.arcs_);
+  if (!in) {
+    throw std::runtime_error("Failed reading " + file);
+  }
+  ch.BuildSearchGraph();
+  return ch;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -1,13 +1,15 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <vector>
 
+#include "midgard/executor.h"
+#include "midgard/flat_hash.h"
 #include "midgard/logging.h"
 #include "sif/recost.h"
 #include "thor/costmatrix.h"
 #include "worker.h"
 
-#include <robin_hood.h>
 
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
@@ -41,7 +43,7 @@ inline float find_percent_along(const valhalla::Location& location, const GraphI
 namespace valhalla {
 namespace thor {
 
-class CostMatrix::TargetMap : public robin_hood::unordered_map<uint64_t, std::vector<uint32_t>> {};
+class CostMatrix::TargetMap : public midgard::flat_map<uint64_t, std::vector<uint32_t>> {};
 
 // Constructor with cost threshold.
 CostMatrix::CostMatrix(const boost::property_tree::ptree& config)
@@ -49,7 +51,19 @@ CostMatrix::CostMatrix(const boost::property_tree::ptree& config)
       remaining_sources_(0), target_count_(0), remaining_targets_(0),
       current_cost_threshold_(0), targets_{new TargetMap},
       max_reserved_labels_count_(config.get<uint32_t>("max_reserved_labels_count_bidir_dijkstras",
-                                                      kInitialEdgeLabelCountBidirDijkstra)) {
+                                                      kInitialEdgeLabelCountBidirDijkstra)),
+      block_size_(config.get<uint32_t>("costmatrix_block_size", 0)),
+      matrix_threads_(config.get<uint32_t>("matrix_threads", 1)),
+      parallel_locations_(config.get<uint32_t>("costmatrix_parallel_locations", 64)),
+      label_count_(0), deferred_(false), interrupt_(nullptr) {
+  // Extra matrices for computing blocks in parallel, they only get to run once readers are set
+  if (block_size_ > 0 && matrix_threads_ > 1) {
+    auto worker_config = config;
+    worker_config.put("matrix_threads", 1);
+    for (uint32_t i = 1; i < matrix_threads_; ++i) {
+      workers_.emplace_back(new CostMatrix(worker_config));
+    }
+  }
 }
 
 CostMatrix::~CostMatrix() {
@@ -115,6 +129,11 @@ void CostMatrix::clear() {
   source_status_.clear();
   target_status_.clear();
   best_connection_.clear();
+  deferred_ = false;
+  deferred_status_.clear();
+  deferred_status_.shrink_to_fit();
+  deferred_targets_.clear();
+  deferred_targets_.shrink_to_fit();
 }
 
 // Form a time distance matrix from the set of source locations
@@ -128,6 +147,108 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     const float max_matrix_distance,
     const bool has_time,
     const bool invariant) {
+  label_count_ = 0;
+  for (auto& worker : workers_) {
+    worker->label_count_ = 0;
+  }
+  if (block_size_ > 0 && (static_cast<uint32_t>(source_location_list.size()) > block_size_ ||
+                          static_cast<uint32_t>(target_location_list.size()) > block_size_)) {
+    return ComputeBlocks(source_location_list, target_location_list, graphreader, mode_costing,
+                         mode, max_matrix_distance, has_time, invariant);
+  }
+  return ComputeMatrix(source_location_list, target_location_list, graphreader, mode_costing, mode,
+                       max_matrix_distance, has_time, invariant, matrix_threads_);
+}
+
+// Split the matrix into blocks of sources and targets and compute them one after the other, each
+// thread holds the labels of one block at a time
+std::vector<TimeDistance> CostMatrix::ComputeBlocks(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    baldr::GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const sif::travel_mode_t mode,
+    const float max_matrix_distance,
+    const bool has_time,
+    const bool invariant) {
+  const size_t source_count = source_location_list.size();
+  const size_t target_count = target_location_list.size();
+  const size_t source_blocks = (source_count + block_size_ - 1) / block_size_;
+  const size_t target_blocks = (target_count + block_size_ - 1) / block_size_;
+  const size_t block_count = source_blocks * target_blocks;
+  std::vector<TimeDistance> matrix(source_count * target_count);
+
+  std::atomic<size_t> next_block(0);
+  const auto compute_blocks = [&](CostMatrix& costmatrix, baldr::GraphReader& reader) {
+    google::protobuf::RepeatedPtrField<valhalla::Location> sources, targets;
+    for (size_t block = next_block++; block < block_count; block = next_block++) {
+      const size_t source_begin = (block / target_blocks) * block_size_;
+      const size_t source_end = std::min<size_t>(source_begin + block_size_, source_count);
+      const size_t target_begin = (block % target_blocks) * block_size_;
+      const size_t target_end = std::min<size_t>(target_begin + block_size_, target_count);
+      sources.Clear();
+      for (size_t i = source_begin; i < source_end; ++i) {
+        sources.Add()->CopyFrom(source_location_list.Get(i));
+      }
+      targets.Clear();
+      for (size_t i = target_begin; i < target_end; ++i) {
+        targets.Add()->CopyFrom(target_location_list.Get(i));
+      }
+
+      auto block_matrix = costmatrix.ComputeMatrix(sources, targets, reader, mode_costing, mode,
+                                                   max_matrix_distance, has_time, invariant);
+      costmatrix.clear();
+      const size_t columns = target_end - target_begin;
+      for (size_t i = 0; i < block_matrix.size(); ++i) {
+        const size_t row = source_begin + i / columns;
+        const size_t column = target_begin + i % columns;
+        matrix[row * target_count + column] = std::move(block_matrix[i]);
+      }
+    }
+  };
+
+  // this thread takes the first slot and idle threads of the shared pool the workers' slots
+  const size_t thread_count =
+      std::min(1 + std::min(workers_.size(), thread_readers_.size()), block_count);
+  if (thread_count <= 1) {
+    compute_blocks(*this, graphreader);
+    return matrix;
+  }
+  try {
+    midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+      try {
+        if (slot == 0) {
+          compute_blocks(*this, graphreader);
+        } else {
+          compute_blocks(*workers_[slot - 1], *thread_readers_[slot - 1]);
+        }
+      } catch (...) {
+        // make the other slots run out of blocks
+        next_block = block_count;
+        throw;
+      }
+    });
+  } catch (...) {
+    clear();
+    for (auto& worker : workers_) {
+      worker->clear();
+    }
+    throw;
+  }
+  return matrix;
+}
+
+// Compute the whole matrix with one search from every source and target
+std::vector<TimeDistance> CostMatrix::ComputeMatrix(
+    google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    baldr::GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const sif::travel_mode_t mode,
+    const float max_matrix_distance,
+    const bool has_time,
+    const bool invariant,
+    const uint32_t threads) {
 
   LOG_INFO("matrix::CostMatrix");
 
@@ -150,18 +271,57 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
   SetSources(graphreader, source_location_list, time_infos);
   SetTargets(graphreader, target_location_list);
 
+  // The steps of the searches of each direction are shared out to the threads when there are
+  // enough locations to keep them busy
+  uint32_t slots = 1;
+  if (source_count_ + target_count_ >= parallel_locations_) {
+    slots = std::min(threads, static_cast<uint32_t>(thread_readers_.size()) + 1);
+  }
+  // the timezone cache can't be shared by the threads so their searches go without it
+  auto search_infos = time_infos;
+  if (slots > 1) {
+    deferred_status_.resize(std::max(source_count_, target_count_));
+    deferred_targets_.resize(target_count_);
+    for (auto& time_info : search_infos) {
+      time_info.tz_cache = nullptr;
+    }
+  }
+
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
   // spaces is checked during the forward search.
   int n = 0;
   while (true) {
+    // Allow this process to be aborted
+    if (interrupt_ && (n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Iterate all target locations in a backwards search
-    for (uint32_t i = 0; i < target_count_; i++) {
-      if (target_status_[i].threshold > 0) {
-        target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        // if we didn't see this
-        if (target_status_[i].threshold == 0) {
+    Expand(
+        target_count_, slots, graphreader,
+        [&](uint32_t i, GraphReader& reader) {
+          if (target_status_[i].threshold > 0) {
+            target_status_[i].threshold--;
+            BackwardSearch(i, reader);
+          }
+        },
+        [&](uint32_t i) {
+          // the updates the search of this target made to the sources
+          if (!deferred_targets_.empty()) {
+            for (const auto& edgeid : deferred_targets_[i]) {
+              (*targets_)[edgeid].push_back(i);
+            }
+            deferred_targets_[i].clear();
+            for (const auto& update : deferred_status_[i]) {
+              UpdateSourceStatus(update.first, i, update.second);
+            }
+            deferred_status_[i].clear();
+          }
+          // if we didn't see this, only a target searched in this step can be at 0
+          if (target_status_[i].threshold != 0) {
+            return;
+          }
           for (uint32_t source = 0; source < source_count_; source++) {
             //  Get all targets remaining for the origin
             auto& targets = source_status_[source].remaining_locations;
@@ -180,16 +340,29 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
           if (remaining_targets_ > 0) {
             remaining_targets_--;
           }
-        }
-      }
-    }
+        });
 
     // Iterate all source locations in a forward search
-    for (uint32_t i = 0; i < source_count_; i++) {
-      if (source_status_[i].threshold > 0) {
-        source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader, time_infos[i], invariant);
-        if (source_status_[i].threshold == 0) {
+    Expand(
+        source_count_, slots, graphreader,
+        [&](uint32_t i, GraphReader& reader) {
+          if (source_status_[i].threshold > 0) {
+            source_status_[i].threshold--;
+            ForwardSearch(i, n, reader, search_infos[i], invariant);
+          }
+        },
+        [&](uint32_t i) {
+          // the updates the search of this source made to the targets
+          if (!deferred_status_.empty()) {
+            for (const auto& update : deferred_status_[i]) {
+              UpdateTargetStatus(i, update.first, update.second);
+            }
+            deferred_status_[i].clear();
+          }
+          // only a source searched in this step can be at 0
+          if (source_status_[i].threshold != 0) {
+            return;
+          }
           for (uint32_t target = 0; target < target_count_; target++) {
             //  Get all sources remaining for the destination
             auto& sources = target_status_[target].remaining_locations;
@@ -208,9 +381,7 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
           if (remaining_sources_ > 0) {
             remaining_sources_--;
           }
-        }
-      }
-    }
+        });
 
     // Break out when remaining sources and targets to expand are both 0
     if (remaining_sources_ == 0 && remaining_targets_ == 0) {
@@ -247,9 +418,57 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     }
     count++;
   }
+  for (const auto& labels : source_edgelabel_) {
+    label_count_ += labels.size();
+  }
+  for (const auto& labels : target_edgelabel_) {
+    label_count_ += labels.size();
+  }
   return td;
 }
 
+// Run one step of the searches of a direction, in parallel when there is more than one slot
+void CostMatrix::Expand(const uint32_t count,
+                        const uint32_t slots,
+                        GraphReader& graphreader,
+                        const std::function<void(uint32_t, GraphReader&)>& search,
+                        const std::function<void(uint32_t)>& finish) {
+  if (slots <= 1) {
+    for (uint32_t i = 0; i < count; ++i) {
+      search(i, graphreader);
+      finish(i);
+    }
+    return;
+  }
+
+  // the searches only touch their own location until they are all done
+  std::atomic<uint32_t> next(0);
+  deferred_ = true;
+  try {
+    midgard::executor_t::shared().run(slots, [&](uint32_t slot) {
+      auto& reader = slot == 0 ? graphreader : *thread_readers_[slot - 1];
+      try {
+        for (uint32_t i = next++; i < count; i = next++) {
+          search(i, reader);
+        }
+      } catch (...) {
+        // make the other slots run out of locations
+        next = count;
+        throw;
+      }
+    });
+  } catch (...) {
+    deferred_ = false;
+    throw;
+  }
+  deferred_ = false;
+
+  // then they make their updates to the other locations in the order the serial steps would
+  for (uint32_t i = 0; i < count; ++i) {
+    finish(i);
+  }
+}
+
 // Initialize all time distance to "not found". Any locations that
 // are the same get set to 0 time, distance and do not add to the
 // remaining locations set.
@@ -340,7 +559,7 @@ void CostMatrix::ForwardSearch(const uint32_t index,
     // Forward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t target = 0; target < target_count_; target++) {
-      UpdateStatus(index, target);
+      UpdateStatus(index, target, true);
     }
     source_status_[index].threshold = 0;
     return;
@@ -532,7 +751,8 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
     // If this edge has been reached then a shortest path has been found
     // to the end node of this directed edge.
-    EdgeStatusInfo oppedgestatus = edgestate.Get(oppedge);
+    EdgeStatusInfo oppedgestatus =
+        deferred_ ? edgestate.GetShared(oppedge) : edgestate.Get(oppedge);
     if (oppedgestatus.set() != EdgeSet::kUnreachedOrReset) {
       const auto& edgelabels = target_edgelabel_[target];
       uint32_t predidx = edgelabels[oppedgestatus.index()].predecessor();
@@ -553,7 +773,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
         // Update status and update threshold if this is the last location
         // to find for this source or target
-        UpdateStatus(source, target);
+        UpdateStatus(source, target, true);
       } else {
         float oppcost = (predidx == kInvalidLabel) ? 0 : edgelabels[predidx].cost().cost;
         float c = pred.cost().cost + oppcost + opp_el.transition_cost().cost;
@@ -575,7 +795,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
           // Update status and update threshold if this is the last location
           // to find for this source or target
-          UpdateStatus(source, target);
+          UpdateStatus(source, target, true);
         }
       }
     }
@@ -583,8 +803,28 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 }
 
 // Update status when a connection is found.
-void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
+void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target, const bool forward) {
+  const int threshold =
+      GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+
   // Remove the target from the source status
+  if (!deferred_ || forward) {
+    UpdateSourceStatus(source, target, threshold);
+  } else {
+    deferred_status_[target].emplace_back(source, threshold);
+  }
+
+  // Remove the source from the target status
+  if (!deferred_ || !forward) {
+    UpdateTargetStatus(source, target, threshold);
+  } else {
+    deferred_status_[source].emplace_back(target, threshold);
+  }
+}
+
+void CostMatrix::UpdateSourceStatus(const uint32_t source,
+                                    const uint32_t target,
+                                    const int threshold) {
   auto& s = source_status_[source].remaining_locations;
   auto it = s.find(target);
   if (it != s.end()) {
@@ -592,21 +832,22 @@ void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
     if (s.empty() && source_status_[source].threshold > 0) {
       // At least 1 connection has been found to each target for this source.
       // Set a threshold to continue search for a limited number of times.
-      source_status_[source].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      source_status_[source].threshold = threshold;
     }
   }
+}
 
-  // Remove the source from the target status
+void CostMatrix::UpdateTargetStatus(const uint32_t source,
+                                    const uint32_t target,
+                                    const int threshold) {
   auto& t = target_status_[target].remaining_locations;
-  it = t.find(source);
+  auto it = t.find(source);
   if (it != t.end()) {
     t.erase(it);
     if (t.empty() && target_status_[target].threshold > 0) {
       // At least 1 connection has been found to each source for this target.
       // Set a threshold to continue search for a limited number of times.
-      target_status_[target].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      target_status_[target].threshold = threshold;
     }
   }
 }
@@ -621,7 +862,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     // Backward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t source = 0; source < source_count_; source++) {
-      UpdateStatus(source, index);
+      UpdateStatus(source, index, false);
     }
     target_status_[index].threshold = 0;
     return;
@@ -741,7 +982,11 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
       adj.add(idx);
 
       // Add to the list of targets that have reached this edge
-      (*targets_)[edgeid].push_back(index);
+      if (deferred_) {
+        deferred_targets_[index].push_back(edgeid);
+      } else {
+        (*targets_)[edgeid].push_back(index);
+      }
     }
 
     // Handle transitions - expand from the end node of the transition
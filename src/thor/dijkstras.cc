@@ -44,7 +44,8 @@ Dijkstras::Dijkstras(const boost::property_tree::ptree& config)
     : mode_(travel_mode_t::kDrive), access_mode_(kAutoAccess),
       max_reserved_labels_count_(config.get<uint32_t>("max_reserved_labels_count_dijkstras",
                                                       kInitialEdgeLabelCountDijkstras)),
-      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)), multipath_(false) {
+      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)), multipath_(false),
+      interrupt_(nullptr) {
 }
 
 // Clear the temporary information generated during path construction.
@@ -52,12 +53,12 @@ void Dijkstras::Clear() {
   // Clear the edge labels, edge status flags, and adjacency list
   // TODO - clear only the edge label set that was used?
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (bdedgelabels_.size() > reservation) {
+  if (bdedgelabels_.capacity() > reservation) {
     bdedgelabels_.resize(reservation);
     bdedgelabels_.shrink_to_fit();
   }
   bdedgelabels_.clear();
-  if (mmedgelabels_.size() > reservation) {
+  if (mmedgelabels_.capacity() > reservation) {
     mmedgelabels_.resize(reservation);
     mmedgelabels_.shrink_to_fit();
   }
@@ -65,7 +66,7 @@ void Dijkstras::Clear() {
 
   adjacencylist_.clear();
   mmadjacencylist_.clear();
-  edgestatus_.clear();
+  edgestatus_.clear(reservation);
 }
 
 // Initialize - create adjacency list, edgestatus support, and reserve
@@ -117,12 +118,16 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
                             const baldr::TimeInfo& time_info) {
 
   constexpr bool FORWARD = expansion_direction == ExpansionType::forward;
+  // Bind the costing once, the virtual calls below happen for every relaxed edge
+  const sif::DynamicCost& costing = *costing_;
   // Get the tile and the node info. Skip if tile is null (can happen
   // with regional data sets) or if no access at the node.
   graph_tile_ptr tile = graphreader.GetGraphTile(node);
   if (tile == nullptr) {
     return;
   }
+  // Start loading the tiles this part of the frontier is heading into
+  graphreader.PrefetchNeighbors(node);
 
   // Get the nodeinfo
   const NodeInfo* nodeinfo = tile->node(node);
@@ -136,7 +141,7 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
   }
 
   // Bail if we cant expand from here
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     return;
   }
 
@@ -185,22 +190,22 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     if (offset_time.valid) {
       // With date time we check time dependent restrictions and access
       const bool allowed =
-          FORWARD ? costing_->Allowed(directededge, is_dest, pred, tile, edgeid,
-                                      offset_time.local_time, nodeinfo->timezone(), restriction_idx)
-                  : costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedgeid,
-                                             offset_time.local_time, nodeinfo->timezone(),
-                                             restriction_idx);
-      if (!allowed || costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true,
-                                           todo, offset_time.local_time, nodeinfo->timezone())) {
+          FORWARD ? costing.Allowed(directededge, is_dest, pred, tile, edgeid,
+                                     offset_time.local_time, nodeinfo->timezone(), restriction_idx)
+                  : costing.AllowedReverse(directededge, pred, opp_edge, t2, oppedgeid,
+                                            offset_time.local_time, nodeinfo->timezone(),
+                                            restriction_idx);
+      if (!allowed || costing.Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true,
+                                          todo, offset_time.local_time, nodeinfo->timezone())) {
         continue;
       }
     } else {
-      const bool allowed = FORWARD ? costing_->Allowed(directededge, is_dest, pred, tile, edgeid, 0,
-                                                       0, restriction_idx)
-                                   : costing_->AllowedReverse(directededge, pred, opp_edge, t2,
-                                                              oppedgeid, 0, 0, restriction_idx);
+      const bool allowed = FORWARD ? costing.Allowed(directededge, is_dest, pred, tile, edgeid, 0,
+                                                      0, restriction_idx)
+                                   : costing.AllowedReverse(directededge, pred, opp_edge, t2,
+                                                             oppedgeid, 0, 0, restriction_idx);
 
-      if (!allowed || costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true)) {
+      if (!allowed || costing.Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true)) {
         continue;
       }
     }
@@ -210,16 +215,16 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     uint8_t flow_sources;
 
     if (FORWARD) {
-      transition_cost = costing_->TransitionCost(directededge, nodeinfo, pred);
-      newcost = pred.cost() + costing_->EdgeCost(directededge, tile, offset_time, flow_sources) +
+      transition_cost = costing.TransitionCost(directededge, nodeinfo, pred);
+      newcost = pred.cost() + costing.EdgeCost(directededge, tile, offset_time, flow_sources) +
                 transition_cost;
     } else {
       transition_cost =
-          costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
-                                          opp_pred_edge, pred.has_measured_speed(),
-                                          pred.internal_turn());
+          costing.TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
+                                         opp_pred_edge, pred.has_measured_speed(),
+                                         pred.internal_turn());
       newcost =
-          pred.cost() + costing_->EdgeCost(opp_edge, t2, offset_time, flow_sources) + transition_cost;
+          pred.cost() + costing.EdgeCost(opp_edge, t2, offset_time, flow_sources) + transition_cost;
     }
     uint32_t path_dist = pred.path_distance() + directededge->length();
 
@@ -248,12 +253,12 @@ void Dijkstras::ExpandInner(baldr::GraphReader& graphreader,
     *es = {EdgeSet::kTemporary, idx};
     bdedgelabels_.emplace_back(pred_idx, edgeid, oppedgeid, directededge, newcost, mode_,
                                transition_cost, path_dist, false,
-                               (pred.closure_pruning() || !costing_->IsClosed(directededge, tile)),
+                               (pred.closure_pruning() || !costing.IsClosed(directededge, tile)),
                                static_cast<bool>(flow_sources & kDefaultFlowMask),
                                (expansion_direction == ExpansionType::forward)
-                                   ? costing_->TurnType(pred.opp_local_idx(), nodeinfo, directededge)
-                                   : costing_->TurnType(directededge->localedgeidx(), nodeinfo,
-                                                        opp_edge, opp_pred_edge),
+                                   ? costing.TurnType(pred.opp_local_idx(), nodeinfo, directededge)
+                                   : costing.TurnType(directededge->localedgeidx(), nodeinfo,
+                                                       opp_edge, opp_pred_edge),
                                restriction_idx, pred.path_id());
     adjacencylist_.add(idx);
   }
@@ -337,7 +342,13 @@ void Dijkstras::Compute(google::protobuf::RepeatedPtrField<valhalla::Location>&
 
   // Compute the isotile
   auto cb_decision = ExpansionRecommendation::continue_expansion;
+  int n = 0;
   while (cb_decision != ExpansionRecommendation::stop_expansion) {
+    // Allow this process to be aborted
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_.pop();
@@ -406,6 +417,7 @@ void Dijkstras::ExpandForwardMultiModal(GraphReader& graphreader,
   if (tile == nullptr) {
     return;
   }
+  graphreader.PrefetchNeighbors(node);
 
   // Get the nodeinfo
   const NodeInfo* nodeinfo = tile->node(node);
@@ -718,7 +730,13 @@ void Dijkstras::ComputeMultiModal(
 
   // Expand using adjacency list until we exceed threshold
   auto cb_decision = ExpansionRecommendation::continue_expansion;
+  int n = 0;
   while (cb_decision != ExpansionRecommendation::stop_expansion) {
+    // Allow this process to be aborted
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
     // Get next element from adjacency list. Check that it is valid. An
     // invalid label indicates there are no edges that can be expanded.
     const uint32_t predindex = mmadjacencylist_.pop();
@@ -6,18 +6,31 @@
 #include "midgard/logging.h"
 #include "midgard/polyline2.h"
 #include "midgard/util.h"
+#include "tyr/serializers.h"
 
 using namespace rapidjson;
 using namespace valhalla::midgard;
 
-namespace valhalla {
-namespace thor {
+namespace {
 
 // indices correspond to Options::ExpansionProperties enum
-const std::string kPropPaths[5] = {"/features/0/properties/costs", "/features/0/properties/durations",
-                                   "/features/0/properties/distances",
-                                   "/features/0/properties/statuses",
-                                   "/features/0/properties/edge_ids"};
+const char* kPropKeys[5] = {"costs", "durations", "distances", "statuses", "edge_ids"};
+
+// indices correspond to Expansion::EdgeStatus enum
+const char* kStatuses[3] = {"r", "s", "c"};
+
+valhalla::Expansion::EdgeStatus to_status(const char* status) {
+  if (status && status[0] == 's')
+    return valhalla::Expansion::settled;
+  if (status && status[0] == 'c')
+    return valhalla::Expansion::connected;
+  return valhalla::Expansion::reached;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
 
 std::string thor_worker_t::expansion(Api& request) {
   // time this whole method and save that statistic
@@ -27,33 +40,61 @@ std::string thor_worker_t::expansion(Api& request) {
   auto options = request.options();
   auto exp_action = options.expansion_action();
   bool skip_opps = options.skip_opposites();
+  bool pbf = options.format() == Options::pbf;
   std::unordered_set<baldr::GraphId> opp_edges;
   std::unordered_set<Options::ExpansionProperties> exp_props;
+  for (const auto& prop : options.expansion_properties()) {
+    exp_props.insert(static_cast<Options_ExpansionProperties>(prop));
+  }
 
   // default generalization to ~ zoom level 15
   float gen_factor = options.has_generalize_case() ? options.generalize() : 10.f;
 
-  // default the expansion geojson so its easy to add to as we go
-  Document dom;
-  dom.SetObject();
-  // set algorithm to Dijkstra, will be overwritten by other algos
-  SetValueByPointer(dom, "/type", "FeatureCollection");
-  SetValueByPointer(dom, "/features/0/type", "Feature");
-  SetValueByPointer(dom, "/features/0/geometry/type", "MultiLineString");
-  SetValueByPointer(dom, "/features/0/geometry/coordinates", Value(kArrayType));
-  SetValueByPointer(dom, "/features/0/properties", Value(kObjectType));
-  for (const auto& prop : options.expansion_properties()) {
-    rapidjson::Pointer(kPropPaths[prop]).Set(dom, Value(kArrayType));
-    exp_props.insert(static_cast<Options_ExpansionProperties>(prop));
+  // the request may track fewer edges than the service allows but not more, and may only track
+  // every nth edge
+  uint32_t max_edges = options.expansion_max_edges();
+  if (max_expansion_edges && (!max_edges || max_edges > max_expansion_edges)) {
+    max_edges = max_expansion_edges;
   }
+  uint32_t sample_interval = std::max(options.expansion_sample_interval(), 1u);
+  uint32_t edge_count = 0;
+  uint32_t tracked_count = 0;
 
-  // a lambda that the path algorithm can call to add stuff to the dom
+  // the properties are kept as plain numbers until the end, the geometry of the geojson is written
+  // out as the edges come in so that no document is built for it
+  Expansion exp;
+  StringBuffer buffer;
+  Writer<StringBuffer> writer(buffer);
+  writer.SetMaxDecimalPlaces(5);
+  if (!pbf) {
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("FeatureCollection");
+    writer.Key("features");
+    writer.StartArray();
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("Feature");
+    writer.Key("geometry");
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("MultiLineString");
+    writer.Key("coordinates");
+    writer.StartArray();
+  }
+
+  // a lambda that the path algorithm can call to add stuff to the output
   // route and isochrone produce different GeoJSON properties
-  auto track_expansion = [&dom, &opp_edges, &gen_factor, &skip_opps,
-                          &exp_props](baldr::GraphReader& reader, baldr::GraphId edgeid,
-                                      const char* algorithm = nullptr, const char* status = nullptr,
-                                      const float duration = 0.f, const uint32_t distance = 0,
-                                      const float cost = 0.f) {
+  auto track_expansion = [&](baldr::GraphReader& reader, baldr::GraphId edgeid,
+                             const char* algorithm = nullptr, const char* status = nullptr,
+                             const float duration = 0.f, const uint32_t distance = 0,
+                             const float cost = 0.f) {
+    // once the limit is reached there is nothing more to track
+    if (max_edges && tracked_count >= max_edges) {
+      exp.set_truncated(true);
+      return;
+    }
+
     auto tile = reader.GetGraphTile(edgeid);
     if (tile == nullptr) {
       LOG_ERROR("thor_worker_t::expansion error, tile no longer available" +
@@ -64,8 +105,6 @@ std::string thor_worker_t::expansion(Api& request) {
     // unfortunately we have to call this before checking if we can skip
     // else the tile could change underneath us when we get the opposing
     auto shape = tile->edgeinfo(edge).shape();
-    auto names = tile->edgeinfo(edge).GetNames();
-    auto is_forward = edge->forward();
 
     // if requested, skip this edge in case its opposite edge has been added
     // before (i.e. lower cost) else add this edge's id to the lookup container
@@ -76,20 +115,33 @@ std::string thor_worker_t::expansion(Api& request) {
       opp_edges.insert(edgeid);
     }
 
+    // only every nth edge is kept when sampling
+    if (edge_count++ % sample_interval) {
+      return;
+    }
+    ++tracked_count;
+
     if (!edge->forward())
       std::reverse(shape.begin(), shape.end());
     Polyline2<PointLL>::Generalize(shape, gen_factor, {}, false);
 
     // make the geom
-    auto& a = dom.GetAllocator();
-    auto* coords = GetValueByPointer(dom, "/features/0/geometry/coordinates");
-    coords->GetArray().PushBack(Value(kArrayType), a);
-    auto& linestring = (*coords)[coords->Size() - 1];
-    for (const auto& p : shape) {
-      linestring.GetArray().PushBack(Value(kArrayType), a);
-      auto point = linestring[linestring.Size() - 1].GetArray();
-      point.PushBack(p.first, a);
-      point.PushBack(p.second, a);
+    if (pbf) {
+      auto* coords = exp.add_geometries()->mutable_coords();
+      coords->Reserve(shape.size() * 2);
+      for (const auto& p : shape) {
+        coords->Add(static_cast<int32_t>(std::round(p.first * 1e6)));
+        coords->Add(static_cast<int32_t>(std::round(p.second * 1e6)));
+      }
+    } else {
+      writer.StartArray();
+      for (const auto& p : shape) {
+        writer.StartArray();
+        writer.Double(p.first);
+        writer.Double(p.second);
+        writer.EndArray();
+      }
+      writer.EndArray();
     }
 
     // no properties asked for, don't collect any
@@ -98,35 +150,18 @@ std::string thor_worker_t::expansion(Api& request) {
     }
 
     // make the properties
-    SetValueByPointer(dom, "/properties/algorithm", algorithm);
-    if (exp_props.count(Options_ExpansionProperties_durations)) {
-      Pointer(kPropPaths[Options_ExpansionProperties_durations])
-          .Get(dom)
-          ->GetArray()
-          .PushBack(Value{}.SetUint(static_cast<uint32_t>(duration)), a);
-    }
-    if (exp_props.count(Options_ExpansionProperties_distances)) {
-      Pointer(kPropPaths[Options_ExpansionProperties_distances])
-          .Get(dom)
-          ->GetArray()
-          .PushBack(Value{}.SetUint(distance), a);
-    }
-    if (exp_props.count(Options_ExpansionProperties_costs)) {
-      Pointer(kPropPaths[Options_ExpansionProperties_costs])
-          .Get(dom)
-          ->GetArray()
-          .PushBack(Value{}.SetUint(static_cast<uint32_t>(cost)), a);
-    }
+    if (algorithm && exp.algorithm() != algorithm)
+      exp.set_algorithm(algorithm);
+    if (exp_props.count(Options_ExpansionProperties_durations))
+      exp.add_durations(static_cast<uint32_t>(duration));
+    if (exp_props.count(Options_ExpansionProperties_distances))
+      exp.add_distances(distance);
+    if (exp_props.count(Options_ExpansionProperties_costs))
+      exp.add_costs(static_cast<uint32_t>(cost));
     if (exp_props.count(Options_ExpansionProperties_statuses))
-      Pointer(kPropPaths[Options_ExpansionProperties_statuses])
-          .Get(dom)
-          ->GetArray()
-          .PushBack(Value{}.SetString(status, a), a);
+      exp.add_statuses(to_status(status));
     if (exp_props.count(Options_ExpansionProperties_edge_ids))
-      Pointer(kPropPaths[Options_ExpansionProperties_edge_ids])
-          .Get(dom)
-          ->GetArray()
-          .PushBack(Value{}.SetUint64(static_cast<uint64_t>(edgeid)), a);
+      exp.add_edge_ids(static_cast<uint64_t>(edgeid));
   };
 
   // tell all the algorithms how to track expansion
@@ -136,11 +171,15 @@ std::string thor_worker_t::expansion(Api& request) {
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &bss_bidir_astar,
        }) {
     alg->set_track_expansion(track_expansion);
   }
   isochrone_gen.SetInnerExpansionCallback(track_expansion);
 
+  // the wrapped action must not serialize to pbf, that would select the expansion and drop its own
+  // response before we get to fill in the expansion
+  request.mutable_options()->set_format(Options::json);
   try {
     // track the expansion
     if (exp_action == Options::route) {
@@ -152,16 +191,77 @@ std::string thor_worker_t::expansion(Api& request) {
     // we swallow exceptions because we actually want to see what the heck the expansion did
     // anyway
   }
+  request.mutable_options()->set_format(options.format());
 
   // tell all the algorithms to stop tracking the expansion
   for (auto* alg : std::vector<PathAlgorithm*>{&multi_modal_astar, &timedep_forward, &timedep_reverse,
-                                               &bidir_astar, &bss_astar}) {
+                                               &bidir_astar, &bss_astar, &bss_bidir_astar}) {
     alg->set_track_expansion(nullptr);
   }
   isochrone_gen.SetInnerExpansionCallback(nullptr);
 
   // serialize it
-  return to_string(dom, 5);
+  if (pbf) {
+    request.mutable_expansion()->Swap(&exp);
+    return tyr::serializePbf(request);
+  }
+
+  // close the geometry and add the properties in the order they were asked for
+  writer.EndArray();
+  writer.EndObject();
+  writer.Key("properties");
+  writer.StartObject();
+  std::unordered_set<int> written;
+  for (const auto& prop : options.expansion_properties()) {
+    if (!written.insert(prop).second || prop < 0 || prop >= 5)
+      continue;
+    writer.Key(kPropKeys[prop]);
+    writer.StartArray();
+    switch (prop) {
+      case Options_ExpansionProperties_costs:
+        for (auto value : exp.costs())
+          writer.Uint(value);
+        break;
+      case Options_ExpansionProperties_durations:
+        for (auto value : exp.durations())
+          writer.Uint(value);
+        break;
+      case Options_ExpansionProperties_distances:
+        for (auto value : exp.distances())
+          writer.Uint(value);
+        break;
+      case Options_ExpansionProperties_statuses:
+        for (auto value : exp.statuses())
+          writer.String(kStatuses[value]);
+        break;
+      case Options_ExpansionProperties_edge_ids:
+        for (auto value : exp.edge_ids())
+          writer.Uint64(value);
+        break;
+    }
+    writer.EndArray();
+  }
+  writer.EndObject();
+  writer.EndObject();
+  writer.EndArray();
+
+  // the algorithm is only given along with the properties, and whether edges were left out
+  if (!exp.algorithm().empty() || exp.truncated()) {
+    writer.Key("properties");
+    writer.StartObject();
+    if (!exp.algorithm().empty()) {
+      writer.Key("algorithm");
+      writer.String(exp.algorithm().c_str());
+    }
+    if (exp.truncated()) {
+      writer.Key("truncated");
+      writer.Bool(true);
+    }
+    writer.EndObject();
+  }
+  writer.EndObject();
+
+  return std::string(buffer.GetString(), buffer.GetSize());
 }
 
 } // namespace thor
@@ -14,6 +14,9 @@ namespace {
 
 constexpr float METRIC_PADDING = 10.f;
 
+// blocks of the grid kept for the next isochrone, about 64MB
+constexpr size_t kInitialIsochroneGridBlocks = 8192;
+
 template <typename PrecisionT>
 std::vector<GeoPoint<PrecisionT>> OriginEdgeShape(const std::vector<GeoPoint<PrecisionT>>& pts,
                                                   double distance_along) {
@@ -32,6 +35,40 @@ std::vector<GeoPoint<PrecisionT>> OriginEdgeShape(const std::vector<GeoPoint<Pre
   return pts;
 }
 
+// the rectangle of cells around those which were reached, empty if none of them was
+struct crop_t {
+  int32_t min_col;
+  int32_t min_row;
+  int32_t max_col;
+  int32_t max_row;
+};
+
+template <typename reached_t> crop_t Crop(const GriddedData<2>& grid, const reached_t& reached) {
+  crop_t crop{grid.ncolumns(), grid.nrows(), -1, -1};
+  for (int32_t row = 0; row < grid.nrows(); ++row) {
+    for (int32_t col = 0; col < grid.ncolumns(); ++col) {
+      if (reached(grid.TileId(col, row))) {
+        crop.min_col = std::min(crop.min_col, col);
+        crop.max_col = std::max(crop.max_col, col);
+        crop.min_row = std::min(crop.min_row, row);
+        crop.max_row = std::max(crop.max_row, row);
+      }
+    }
+  }
+  return crop;
+}
+
+// where the cells of a raster are, they start at the south west corner
+template <typename raster_t>
+void SetRasterGeometry(const GriddedData<2>& grid, const crop_t& crop, raster_t& raster) {
+  auto corner = grid.Base(grid.TileId(crop.min_col, crop.min_row));
+  raster.set_min_lon(corner.lng());
+  raster.set_min_lat(corner.lat());
+  raster.set_cell_size(grid.TileSize());
+  raster.set_columns(crop.max_col - crop.min_col + 1);
+  raster.set_rows(crop.max_row - crop.min_row + 1);
+}
+
 } // namespace
 
 namespace valhalla {
@@ -39,7 +76,25 @@ namespace thor {
 
 // Default constructor
 Isochrone::Isochrone(const boost::property_tree::ptree& config)
-    : Dijkstras(config), shape_interval_(50.0f) {
+    : Dijkstras(config), shape_interval_(50.0f),
+      max_reserved_grid_blocks_(config.get<size_t>("max_reserved_isochrone_grid_blocks",
+                                                   kInitialIsochroneGridBlocks)),
+      contour_limits_{-1.f, -1.f}, catchment_metric_(0), expansion_type_(ExpansionType::forward),
+      location_(0) {
+}
+
+// Clear the temporary information generated during the expansion
+void Isochrone::Clear() {
+  Dijkstras::Clear();
+  catchments_.reset();
+  label_locations_.clear();
+  seed_locations_.clear();
+  // someone else still holds on to the grid so the next isochrone cannot reuse it
+  if (!isotile_ || clear_reserved_memory_ || isotile_.use_count() > 1) {
+    isotile_.reset();
+    return;
+  }
+  isotile_->ReleaseBlocks(max_reserved_grid_blocks_);
 }
 
 // Construct the isotile. Use a fixed grid size. Convert time in minutes to
@@ -135,8 +190,13 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
   AABB2<PointLL> bounds(loc_bounds.minx() - dlon, loc_bounds.miny() - dlat, loc_bounds.maxx() + dlon,
                         loc_bounds.maxy() + dlat);
 
-  // Create isotile (gridded data)
-  isotile_.reset(new GriddedData<2>(bounds, grid_size, {max_minutes, max_km}));
+  // Create isotile (gridded data), reusing the blocks of the last one if nobody else holds it
+  if (isotile_ && isotile_.use_count() == 1) {
+    isotile_->Reset(bounds, grid_size, {max_minutes, max_km});
+  } else {
+    isotile_ = std::make_shared<GriddedData<2>>(bounds, grid_size,
+                                                GriddedData<2>::value_type{max_minutes, max_km});
+  }
 
   // Find the center of the grid that the location lies within. Shift the
   // tilebounds so the location lies in the center of a tile.
@@ -153,10 +213,161 @@ void Isochrone::ConstructIsoTile(const bool multimodal,
              std::to_string(center_ll.lng() - grid_center.lng()));
   }
 
+  // the largest contour of each metric, rasters only have the cells reached within them
+  contour_limits_ = {has_time ? max_minutes - METRIC_PADDING : -1.f,
+                     has_distance ? max_km - METRIC_PADDING : -1.f};
+
+  // the nearest location of each cell is decided on time if there is a time contour
+  catchments_.reset();
+  if (api.options().catchments()) {
+    catchments_.reset(new GriddedData<1>(bounds, grid_size, {-1.f}));
+    catchments_->ShiftTileBounds(shift);
+    catchment_metric_ = has_time ? 0 : 1;
+  }
+
   // initialize the time at these locations
+  location_ = 0;
   for (const auto& location : api.options().locations()) {
     auto tile_id = isotile_->TileId({location.ll().lng(), location.ll().lat()});
-    isotile_->SetIfLessThan(tile_id, {has_time ? 0.0f : max_minutes, has_distance ? 0.0f : max_km});
+    MarkTile(tile_id, has_time ? 0.0f : max_minutes, has_distance ? 0.0f : max_km);
+    ++location_;
+  }
+}
+
+void Isochrone::InitializeCatchments(const valhalla::Api& api,
+                                     GraphReader& reader,
+                                     const ExpansionType expansion_type) {
+  expansion_type_ = expansion_type;
+  label_locations_.clear();
+  seed_locations_.clear();
+  if (!catchments_) {
+    return;
+  }
+
+  // the expansion starts with a label for each edge of each location in the order of the
+  // locations, skipping the edges at the wrong end of a node when there are others
+  const bool reverse = expansion_type == ExpansionType::reverse;
+  for (int i = 0; i < api.options().locations_size(); ++i) {
+    const auto& edges = api.options().locations(i).correlation().edges();
+    bool has_other_edges = std::any_of(edges.begin(), edges.end(), [reverse](const PathEdge& e) {
+      return reverse ? !e.begin_node() : !e.end_node();
+    });
+    for (const auto& edge : edges) {
+      if (has_other_edges && (reverse ? edge.begin_node() : edge.end_node())) {
+        continue;
+      }
+      GraphId edge_id(edge.graph_id());
+      if (reverse) {
+        graph_tile_ptr tile;
+        edge_id = reader.GetOpposingEdgeId(edge_id, tile);
+      }
+      if (edge_id.Is_Valid()) {
+        seed_locations_[edge_id].first.push_back(i);
+      }
+    }
+  }
+}
+
+uint32_t Isochrone::LocationOf(const sif::EdgeLabel& label) {
+  // the label of an edge is found through its status, labels come after their predecessors so
+  // the locations are resolved in the order of the labels
+  auto index = edgestatus_.Get(label.edgeid()).index();
+  auto resolve = [this, index](const auto& labels) {
+    for (auto i = label_locations_.size(); i <= index && i < labels.size(); ++i) {
+      auto predecessor = labels[i].predecessor();
+      if (predecessor != kInvalidLabel) {
+        label_locations_.push_back(label_locations_[predecessor]);
+        continue;
+      }
+      // a label the expansion started with takes the next location at its edge
+      auto seed = seed_locations_.find(labels[i].edgeid());
+      if (seed == seed_locations_.end()) {
+        label_locations_.push_back(0);
+        continue;
+      }
+      auto& next = seed->second.second;
+      label_locations_.push_back(seed->second.first[std::min(next, seed->second.first.size() - 1)]);
+      ++next;
+    }
+    return index < label_locations_.size() ? label_locations_[index] : 0;
+  };
+  return expansion_type_ == ExpansionType::multimodal ? resolve(mmedgelabels_)
+                                                      : resolve(bdedgelabels_);
+}
+
+void Isochrone::MarkTile(const int tile_id, const float minutes, const float km) {
+  if (catchments_ && tile_id >= 0 && tile_id < isotile_->nrows() * isotile_->ncolumns()) {
+    const auto value = catchment_metric_ == 0 ? minutes : km;
+    if (value < isotile_->Value(tile_id)[catchment_metric_]) {
+      catchments_->Set(tile_id, {static_cast<float>(location_)});
+    }
+  }
+  isotile_->SetIfLessThan(tile_id, {minutes, km});
+}
+
+void Isochrone::Catchments(valhalla::Isochrone::Catchments& catchments) const {
+  catchments.Clear();
+  if (!catchments_ || !isotile_) {
+    return;
+  }
+
+  // crop the raster to the cells reached within the largest contour
+  auto reached = [this](int32_t tile_id) {
+    return isotile_->Value(tile_id)[catchment_metric_] <= contour_limits_[catchment_metric_] &&
+           catchments_->Value(tile_id)[0] >= 0.f;
+  };
+  auto crop = Crop(*isotile_, reached);
+  if (crop.max_col < crop.min_col) {
+    return;
+  }
+
+  SetRasterGeometry(*isotile_, crop, catchments);
+  catchments.mutable_locations()->Reserve(catchments.columns() * catchments.rows());
+  for (int32_t row = crop.min_row; row <= crop.max_row; ++row) {
+    for (int32_t col = crop.min_col; col <= crop.max_col; ++col) {
+      auto tile_id = isotile_->TileId(col, row);
+      catchments.add_locations(
+          reached(tile_id) ? static_cast<int32_t>(catchments_->Value(tile_id)[0]) : -1);
+    }
+  }
+}
+
+void Isochrone::Raster(valhalla::Isochrone::Raster& raster) const {
+  raster.Clear();
+  if (!isotile_) {
+    return;
+  }
+
+  // crop the raster to the cells reached within the largest contour of either metric
+  auto reached = [this](int32_t tile_id, size_t metric) {
+    return isotile_->Value(tile_id)[metric] <= contour_limits_[metric];
+  };
+  auto crop = Crop(*isotile_, [&reached](int32_t tile_id) {
+    return reached(tile_id, 0) || reached(tile_id, 1);
+  });
+  if (crop.max_col < crop.min_col) {
+    return;
+  }
+
+  SetRasterGeometry(*isotile_, crop, raster);
+  const auto cells = raster.columns() * raster.rows();
+  if (contour_limits_[0] >= 0.f) {
+    raster.mutable_times()->Reserve(cells);
+  }
+  if (contour_limits_[1] >= 0.f) {
+    raster.mutable_distances()->Reserve(cells);
+  }
+  for (int32_t row = crop.min_row; row <= crop.max_row; ++row) {
+    for (int32_t col = crop.min_col; col <= crop.max_col; ++col) {
+      auto tile_id = isotile_->TileId(col, row);
+      const auto& value = isotile_->Value(tile_id);
+      if (contour_limits_[0] >= 0.f) {
+        raster.add_times(reached(tile_id, 0) ? value[0] : -1.f);
+      }
+      if (contour_limits_[1] >= 0.f) {
+        raster.add_distances(reached(tile_id, 1) ? value[1] : -1.f);
+      }
+    }
   }
 }
 
@@ -168,6 +379,7 @@ std::shared_ptr<const GriddedData<2>> Isochrone::Expand(const ExpansionType& exp
                                                         const travel_mode_t mode) {
   // Initialize and create the isotile
   ConstructIsoTile(expansion_type == ExpansionType::multimodal, api, mode);
+  InitializeCatchments(api, reader, expansion_type);
   // Compute the expansion
   Dijkstras::Expand(expansion_type, api, reader, mode_costing, mode);
   return isotile_;
@@ -184,17 +396,19 @@ void Isochrone::UpdateIsoTileAlongSegment(const midgard::PointLL& from,
   auto tile1 = isotile_->TileId(from);
   auto tile2 = isotile_->TileId(to);
   if (tile1 == tile2) {
-    isotile_->SetIfLessThan(tile1, {minutes, km});
+    MarkTile(tile1, minutes, km);
   } else if (isotile_->AreNeighbors(tile1, tile2)) {
     // If tile 2 is directly east, west, north, or south of tile 1 then the
     // segment will not intersect any other tiles other than tile1 and tile2.
-    isotile_->SetIfLessThan(tile1, {minutes, km});
-    isotile_->SetIfLessThan(tile2, {minutes, km});
+    MarkTile(tile1, minutes, km);
+    MarkTile(tile2, minutes, km);
   } else {
-    // Find intersecting tiles (using a Bresenham method)
-    auto tiles = isotile_->Intersect(std::list<PointLL>{from, to});
-    for (const auto& t : tiles) {
-      isotile_->SetIfLessThan(t.first, {minutes, km});
+    // Find intersecting tiles by walking the cells the segment crosses
+    segment_.assign({from, to});
+    crossed_cells_.clear();
+    isotile_->Intersect(segment_, crossed_cells_);
+    for (const auto& cell : crossed_cells_) {
+      MarkTile(cell.first, minutes, km);
     }
   }
 }
@@ -235,8 +449,7 @@ void Isochrone::UpdateIsoTile(const EdgeLabel& pred,
     PointLL ll0 = tile->get_node_ll(t2->directededge(opp)->endnode());
     if (pred.origin()) {
       // interpolate ll0 for origin edge using edge_label.path_distance()
-      auto edge_info = tile->edgeinfo(edge);
-      const auto& shape = edge_info.shape();
+      const auto& shape = graphreader.edge_shape(tile, edge);
       const auto& ordered_shape =
           edge->forward() ? shape : std::vector<midgard::PointLL>(shape.rbegin(), shape.rend());
       auto origin_edge_shape = OriginEdgeShape(ordered_shape, pred.path_distance());
@@ -250,8 +463,7 @@ void Isochrone::UpdateIsoTile(const EdgeLabel& pred,
   // the shape interval to get regular spacing. Use the faster resample method.
   // This does not use spherical interpolation - so it is not as accurate but
   // interpolation is over short distances so accuracy should be fine.
-  auto edge_info = tile->edgeinfo(edge);
-  const auto& shape = edge_info.shape();
+  const auto& shape = graphreader.edge_shape(tile, edge);
   auto resampled = resample_polyline(shape, edge->length(), shape_interval_);
   if (!edge->forward()) {
     std::reverse(resampled.begin(), resampled.end());
@@ -285,6 +497,9 @@ void Isochrone::ExpandingNode(baldr::GraphReader& graphreader,
   // Update the isotile
   float secs0 = previous ? previous->cost().secs : 0.0f;
   float dist0 = previous ? static_cast<float>(previous->path_distance()) : 0.0f;
+  if (catchments_) {
+    location_ = LocationOf(current);
+  }
   UpdateIsoTile(current, graphreader, node->latlng(tile->header()->base_ll()), secs0, dist0);
 }
 
@@ -1,7 +1,10 @@
+#include "midgard/executor.h"
 #include "midgard/util.h"
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <atomic>
+
 using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
@@ -37,23 +40,118 @@ std::string thor_worker_t::isochrones(Api& request) {
   auto expansion_type = costing == "multimodal" || costing == "transit"
                             ? ExpansionType::multimodal
                             : (reverse ? ExpansionType::reverse : ExpansionType::forward);
-  auto grid = isochrone_gen.Expand(expansion_type, request, *reader, mode_costing, mode);
+
+  // a batch of isochrones, one for each location
+  if (options.per_location() && options.action() != Options_Action_expansion) {
+    return isochrones_per_location(request, contours, expansion_type);
+  }
+
+  std::shared_ptr<const GriddedData<2>> grid;
+  {
+    auto _ = measure_phase(request, "thor.isochrone");
+    mark_used(isochrone_gen);
+    isochrone_gen.set_interrupt(interrupt);
+    grid = isochrone_gen.Expand(expansion_type, request, *reader, mode_costing, mode);
+  }
 
   // e.g. in case of /expansion request
   if (options.action() == Options_Action_expansion)
     return "";
 
+  // the nearest location of each cell comes from the same expansion
+  if (options.catchments()) {
+    isochrone_gen.Catchments(*request.mutable_isochrone()->mutable_catchments());
+  }
+
+  // the grid as it is without any contouring or generalization
+  if (options.raster()) {
+    isochrone_gen.Raster(*request.mutable_isochrone()->mutable_raster());
+    contours.clear();
+    GriddedData<2>::contours_t no_isolines;
+    return tyr::serializeIsochrones(request, contours, no_isolines, options.polygons(),
+                                    options.show_locations());
+  }
+
   // we have parallel vectors of contour properties and the actual geojson features
   // this method sorts the contour specifications by metric (time or distance) and then by value
   // with the largest values coming first. eg (60min, 30min, 10min, 40km, 10km)
-  auto isolines =
-      grid->GenerateContours(contours, options.polygons(), options.denoise(), options.generalize());
+  GriddedData<2>::contours_t isolines;
+  {
+    auto _ = measure_phase(request, "thor.contours");
+    isolines = grid->GenerateContours(contours, options.polygons(), options.denoise(),
+                                      options.generalize());
+  }
 
   // make the final json
-  std::string ret = tyr::serializeIsochrones(request, contours, isolines, options.polygons(),
-                                             options.show_locations());
+  auto serialization = measure_phase(request, "tyr.serialize");
+  return tyr::serializeIsochrones(request, contours, isolines, options.polygons(),
+                                  options.show_locations());
+}
+
+std::string
+thor_worker_t::isochrones_per_location(Api& request,
+                                       std::vector<GriddedData<2>::contour_interval_t>& contours,
+                                       const ExpansionType expansion_type) {
+  const auto& options = request.options();
+  const size_t location_count = options.locations_size();
+
+  // Each location is expanded on its own from a copy of the options with only that location
+  Api base;
+  *base.mutable_options() = options;
+  base.mutable_options()->clear_locations();
+  std::vector<std::vector<GriddedData<2>::contour_interval_t>> intervals(location_count, contours);
+  std::vector<GriddedData<2>::contours_t> isolines(location_count);
+
+  // The locations are handed out one at a time to this thread and the leg workers, every worker
+  // reuses its expansion and its grid from one location to the next
+  std::atomic<size_t> next_location(0);
+  const auto expand_locations = [&](thor_worker_t& worker) {
+    worker.mark_used(worker.isochrone_gen);
+    // only this thread may check the interrupt
+    worker.isochrone_gen.set_interrupt(&worker == this ? interrupt : nullptr);
+    for (size_t i = next_location++; i < location_count; i = next_location++) {
+      Api single = base;
+      single.mutable_options()->mutable_locations()->Add()->CopyFrom(options.locations(i));
+      auto grid =
+          worker.isochrone_gen.Expand(expansion_type, single, *worker.reader, worker.mode_costing,
+                                      worker.mode);
+      isolines[i] = grid->GenerateContours(intervals[i], options.polygons(), options.denoise(),
+                                           options.generalize());
+      grid.reset();
+      worker.isochrone_gen.Clear();
+    }
+  };
 
-  return ret;
+  const size_t thread_count = std::min(leg_workers.size() + 1, location_count);
+  midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+    try {
+      if (slot == 0) {
+        expand_locations(*this);
+      } else {
+        auto& worker = *leg_workers[slot - 1];
+        worker.parse_costing(request);
+        expand_locations(worker);
+      }
+    } catch (...) {
+      // make the other slots run out of locations
+      next_location = location_count;
+      throw;
+    }
+  });
+
+  // the contours of all the locations one after the other
+  contours.clear();
+  GriddedData<2>::contours_t all_isolines;
+  std::vector<uint32_t> interval_locations;
+  for (size_t i = 0; i < location_count; ++i) {
+    for (size_t j = 0; j < intervals[i].size(); ++j) {
+      contours.push_back(std::move(intervals[i][j]));
+      all_isolines.push_back(std::move(isolines[i][j]));
+      interval_locations.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  return tyr::serializeIsochrones(request, contours, all_isolines, options.polygons(),
+                                  options.show_locations(), interval_locations);
 }
 
 } // namespace thor
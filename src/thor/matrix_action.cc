@@ -1,7 +1,11 @@
+#include <numeric>
+
+#include "midgard/tracepoints.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/pedestriancost.h"
 #include "thor/costmatrix.h"
+#include "thor/search_tree_cache.h"
 #include "thor/timedistancebssmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
@@ -19,6 +23,56 @@ namespace thor {
 
 constexpr uint32_t kCostMatrixThreshold = 5;
 
+namespace {
+
+// the timezone of a location, that of the nodes of the first edge it was correlated to
+uint32_t location_timezone(const valhalla::Location& location, GraphReader& reader) {
+  if (location.correlation().edges().empty()) {
+    return 0;
+  }
+  graph_tile_ptr tile;
+  const auto nodes =
+      reader.GetDirectedEdgeNodes(GraphId(location.correlation().edges(0).graph_id()), tile);
+  if (!tile) {
+    return 0;
+  }
+  const auto timezone = reader.GetTimezone(nodes.first, tile);
+  return timezone ? timezone : reader.GetTimezone(nodes.second, tile);
+}
+
+/**
+ * Finds the locations of a matrix in the table and the bucket of the departure of each source.
+ * Departures are only looked up for depart_at requests, other times aren't in the table.
+ * @return true if the table has some of the pairs, the indices are -1 for locations not in it
+ */
+bool table_locations(const MatrixTable& table,
+                     const Options& options,
+                     std::vector<int32_t>& buckets,
+                     std::vector<int32_t>& sources,
+                     std::vector<int32_t>& targets) {
+  bool known_source = false, known_target = false;
+  for (const auto& target : options.targets()) {
+    if (!target.date_time().empty()) {
+      return false;
+    }
+    targets.push_back(table.Find(target));
+    known_target = known_target || targets.back() >= 0;
+  }
+  for (const auto& source : options.sources()) {
+    const auto bucket = table.Bucket(source.date_time());
+    if (bucket < 0 ||
+        (!source.date_time().empty() && options.date_time_type() != Options::depart_at)) {
+      return false;
+    }
+    buckets.push_back(bucket);
+    sources.push_back(table.Find(source));
+    known_source = known_source || sources.back() >= 0;
+  }
+  return known_source && known_target;
+}
+
+} // namespace
+
 std::string thor_worker_t::matrix(Api& request) {
   // time this whole method and save that statistic
   auto _ = measure_scope_time(request);
@@ -27,30 +81,90 @@ std::string thor_worker_t::matrix(Api& request) {
   adjust_scores(options);
   auto costing = parse_costing(request);
 
+  // Allow the matrices to be aborted
+  costmatrix_.set_interrupt(interrupt);
+  time_distance_matrix_.set_interrupt(interrupt);
+  time_distance_bss_matrix_.set_interrupt(interrupt);
+
   // Distance scaling (miles or km)
   double distance_scale = (options.units() == Options::miles) ? kMilePerMeter : kKmPerMeter;
 
   // lambdas to do the real work
   auto costmatrix = [&](const bool has_time) {
-    return costmatrix_.SourceToTarget(*options.mutable_sources(), *options.mutable_targets(), *reader,
-                                      mode_costing, mode, max_matrix_distance.find(costing)->second,
-                                      has_time, options.date_time_type() == Options::invariant);
+    auto _ = measure_phase(request, "thor.costmatrix");
+    VALHALLA_TRACE(search_start, "CostMatrix");
+    auto time_distances =
+        costmatrix_.SourceToTarget(*options.mutable_sources(), *options.mutable_targets(), *reader,
+                                   mode_costing, mode, max_matrix_distance.find(costing)->second,
+                                   has_time, options.date_time_type() == Options::invariant);
+    VALHALLA_TRACE(search_done, "CostMatrix", costmatrix_.LabelCount());
+    record_phase_amount(request, "thor.costmatrix", "labels", costmatrix_.LabelCount());
+    return time_distances;
+  };
+  auto timedistancematrix = [&]() -> std::vector<TimeDistance> {
+    auto _ = measure_phase(request, "thor.timedistancematrix");
+    // many sources to a target asked about before grow the search kept from back then
+    if (search_trees.cacheable(options)) {
+      const auto key = SearchTreeCache::key(options);
+      auto* tree = search_trees.find(key);
+      if (!tree) {
+        tree = search_trees.insert(key, std::make_unique<SearchTree>(
+                                            options.targets(0),
+                                            mode_costing[static_cast<uint32_t>(mode)], mode,
+                                            max_matrix_distance.find(costing)->second,
+                                            options.date_time_type() == Options::invariant,
+                                            *reader));
+      }
+      tree->set_interrupt(interrupt);
+      return tree->Query(options.sources(), *reader);
+    }
+    mark_used(time_distance_matrix_);
+    VALHALLA_TRACE(search_start, "TimeDistanceMatrix");
+    auto time_distances =
+        time_distance_matrix_.SourceToTarget(*options.mutable_sources(), *options.mutable_targets(),
+                                             *reader, mode_costing, mode,
+                                             max_matrix_distance.find(costing)->second,
+                                             options.matrix_locations(),
+                                             options.date_time_type() == Options::invariant);
+    VALHALLA_TRACE(search_done, "TimeDistanceMatrix", time_distance_matrix_.LabelCount());
+    record_phase_amount(request, "thor.timedistancematrix", "labels",
+                        time_distance_matrix_.LabelCount());
+    return time_distances;
   };
-  auto timedistancematrix = [&]() {
-    return time_distance_matrix_.SourceToTarget(*options.mutable_sources(),
-                                                *options.mutable_targets(), *reader, mode_costing,
-                                                mode, max_matrix_distance.find(costing)->second,
-                                                options.matrix_locations(),
-                                                options.date_time_type() == Options::invariant);
+
+  auto serialize = [&](const std::vector<TimeDistance>& time_distances, MatrixType type) {
+    auto _ = measure_phase(request, "tyr.serialize");
+    return tyr::serializeMatrix(request, time_distances, distance_scale, type);
   };
 
+  // a matrix at each of the departure times, the rows of all of them computed by the same workers
+  if (options.departure_times_size()) {
+    auto time_distances = [&]() {
+      auto _ = measure_phase(request, "thor.timedistancematrix");
+      mark_used(time_distance_matrix_);
+      auto time_distances =
+          time_distance_matrix_.SourceToTargetAtTimes(options.sources(), *options.mutable_targets(),
+                                                      *reader, mode_costing, mode,
+                                                      max_matrix_distance.find(costing)->second,
+                                                      options.departure_times(),
+                                                      options.matrix_locations());
+      record_phase_amount(request, "thor.timedistancematrix", "labels",
+                          time_distance_matrix_.LabelCount());
+      return time_distances;
+    }();
+    return serialize(time_distances, MatrixType::TimeDist);
+  }
+
   if (costing == "bikeshare") {
-    const auto& time_distances =
-        time_distance_bss_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
-                                                 mode_costing, mode,
-                                                 max_matrix_distance.find(costing)->second,
-                                                 options.matrix_locations());
-    return tyr::serializeMatrix(request, time_distances, distance_scale, MatrixType::TimeDist);
+    auto time_distances = [&]() {
+      auto _ = measure_phase(request, "thor.timedistancebssmatrix");
+      mark_used(time_distance_bss_matrix_);
+      return time_distance_bss_matrix_.SourceToTarget(options.sources(), options.targets(), *reader,
+                                                      mode_costing, mode,
+                                                      max_matrix_distance.find(costing)->second,
+                                                      options.matrix_locations());
+    }();
+    return serialize(time_distances, MatrixType::TimeDist);
   }
 
   MatrixType matrix_type = MatrixType::Cost;
@@ -83,26 +197,115 @@ std::string thor_worker_t::matrix(Api& request) {
 
   // similar to routing: prefer the exact unidirectional algo if not requested otherwise
   // don't use matrix_type, we only need it to set the right warnings for what will be used
-  bool has_time =
-      check_matrix_time(request,
-                        options.prioritize_bidirectional() ? MatrixType::Cost : MatrixType::TimeDist);
-  if (has_time && !options.prioritize_bidirectional() && source_to_target_algorithm != COST_MATRIX) {
-    return tyr::serializeMatrix(request, timedistancematrix(), distance_scale, MatrixType::TimeDist);
-  } else if (has_time && options.prioritize_bidirectional() &&
-             source_to_target_algorithm != TIME_DISTANCE_MATRIX) {
-    return tyr::serializeMatrix(request, costmatrix(has_time), distance_scale, MatrixType::Cost);
-  } else if (matrix_type == MatrixType::Cost) {
-    // if this happens, the server config only allows for timedist matrix
-    if (has_time && !options.prioritize_bidirectional()) {
-      add_warning(request, 301);
+  auto search = [&]() -> std::pair<std::vector<TimeDistance>, MatrixType> {
+    bool has_time =
+        check_matrix_time(request, options.prioritize_bidirectional() ? MatrixType::Cost
+                                                                      : MatrixType::TimeDist);
+    if (has_time && !options.prioritize_bidirectional() &&
+        source_to_target_algorithm != COST_MATRIX) {
+      return {timedistancematrix(), MatrixType::TimeDist};
+    } else if (has_time && options.prioritize_bidirectional() &&
+               source_to_target_algorithm != TIME_DISTANCE_MATRIX) {
+      return {costmatrix(has_time), MatrixType::Cost};
+    } else if (matrix_type == MatrixType::Cost) {
+      // if this happens, the server config only allows for timedist matrix
+      if (has_time && !options.prioritize_bidirectional()) {
+        add_warning(request, 301);
+      }
+      return {costmatrix(has_time), MatrixType::Cost};
+    } else {
+      if (has_time && options.prioritize_bidirectional()) {
+        add_warning(request, 300);
+      }
+      return {timedistancematrix(), MatrixType::TimeDist};
     }
-    return tyr::serializeMatrix(request, costmatrix(has_time), distance_scale, MatrixType::Cost);
-  } else {
-    if (has_time && options.prioritize_bidirectional()) {
-      add_warning(request, 300);
+  };
+
+  // the pairs of locations in the table built ahead of time are looked up, only the sources and
+  // targets which aren't in it are searched for
+  std::vector<int32_t> buckets, sources, targets;
+  if (matrix_table && matrix_table->costing() == MatrixTable::Key(options) &&
+      table_locations(*matrix_table, options, buckets, sources, targets)) {
+    std::vector<TimeDistance> time_distances(sources.size() * targets.size());
+    std::vector<int32_t> known_sources, other_sources, other_targets;
+    {
+      auto _ = measure_phase(request, "thor.matrix_table");
+      for (size_t j = 0; j < targets.size(); ++j) {
+        if (targets[j] < 0) {
+          other_targets.push_back(j);
+        }
+      }
+      for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i] < 0) {
+          other_sources.push_back(i);
+          continue;
+        }
+        known_sources.push_back(i);
+        const auto& source = options.sources(i);
+        const auto* origin_tz =
+            source.date_time().empty()
+                ? nullptr
+                : DateTime::get_tz_db().from_index(location_timezone(source, *reader));
+        for (size_t j = 0; j < targets.size(); ++j) {
+          if (targets[j] < 0) {
+            continue;
+          }
+          const auto& entry = matrix_table->Get(buckets[i], sources[i], targets[j]);
+          auto& td = time_distances[i * targets.size() + j];
+          if (entry.time == MatrixTable::kUnreachable) {
+            td = TimeDistance(kMaxCost, kMaxCost);
+          } else if (!origin_tz) {
+            td = TimeDistance(entry.time, entry.dist);
+          } else {
+            const auto* dest_tz =
+                DateTime::get_tz_db().from_index(location_timezone(options.targets(j), *reader));
+            const auto departure = DateTime::seconds_since_epoch(source.date_time(), origin_tz);
+            td = TimeDistance(entry.time, entry.dist,
+                              DateTime::seconds_to_date(departure + entry.time, dest_tz, false));
+          }
+        }
+      }
+      record_phase_amount(request, "thor.matrix_table", "pairs",
+                          known_sources.size() * (targets.size() - other_targets.size()));
     }
-    return tyr::serializeMatrix(request, timedistancematrix(), distance_scale, MatrixType::TimeDist);
+
+    // the sources which aren't in the table to all the targets and the others to the targets which
+    // aren't in it
+    MatrixType type = MatrixType::TimeDist;
+    auto search_between = [&](const std::vector<int32_t>& part_sources,
+                              const std::vector<int32_t>& part_targets) {
+      if (part_sources.empty() || part_targets.empty()) {
+        return;
+      }
+      google::protobuf::RepeatedPtrField<valhalla::Location> all_sources, all_targets;
+      all_sources.Swap(options.mutable_sources());
+      all_targets.Swap(options.mutable_targets());
+      for (const auto i : part_sources) {
+        *options.add_sources() = all_sources.Get(i);
+      }
+      for (const auto j : part_targets) {
+        *options.add_targets() = all_targets.Get(j);
+      }
+      auto searched = search();
+      type = searched.second;
+      for (size_t k = 0; k < part_sources.size(); ++k) {
+        for (size_t l = 0; l < part_targets.size(); ++l) {
+          time_distances[part_sources[k] * targets.size() + part_targets[l]] =
+              std::move(searched.first[k * part_targets.size() + l]);
+        }
+      }
+      all_sources.Swap(options.mutable_sources());
+      all_targets.Swap(options.mutable_targets());
+    };
+    std::vector<int32_t> all_targets(targets.size());
+    std::iota(all_targets.begin(), all_targets.end(), 0);
+    search_between(other_sources, all_targets);
+    search_between(known_sources, other_targets);
+    return serialize(time_distances, type);
   }
+
+  auto searched = search();
+  return serialize(searched.first, searched.second);
 }
 } // namespace thor
 } // namespace valhalla
@@ -0,0 +1,169 @@
+#include "thor/matrix_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "baldr/datetime.h"
+#include "filesystem.h"
+#include "midgard/constants.h"
+#include "midgard/logging.h"
+
+using valhalla::midgard::kSecondsPerDay;
+using valhalla::midgard::kSecondsPerWeek;
+
+namespace {
+
+// FNV-1a, the key has to be the same in the process that builds the table and those that read it
+uint64_t fnv1a(const std::string& bytes) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto c : bytes) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+std::shared_ptr<const MatrixTable> MatrixTable::Map(const std::string& file_name) {
+  if (file_name.empty() || !filesystem::exists(file_name)) {
+    return nullptr;
+  }
+  size_t size = std::ifstream(file_name, std::ios::binary | std::ios::ate).tellg();
+  if (size < sizeof(header_t)) {
+    LOG_WARN("Matrix table " + file_name + " is too small to be a matrix table");
+    return nullptr;
+  }
+
+  std::shared_ptr<MatrixTable> table(new MatrixTable());
+  table->mapped_.map_readonly(file_name, size);
+  const auto* header = reinterpret_cast<const header_t*>(table->mapped_.get());
+  const uint64_t locations = header->location_count;
+  if (header->version != kVersion || header->bucket_count == 0 ||
+      (header->bucket_count > 1 && header->bucket_seconds == 0) ||
+      size != sizeof(header_t) + locations * sizeof(location_t) +
+                  header->bucket_count * locations * locations * sizeof(entry_t)) {
+    LOG_WARN("Matrix table " + file_name + " is not of this version or incomplete");
+    return nullptr;
+  }
+
+  table->costing_ = header->costing;
+  table->location_count_ = header->location_count;
+  table->bucket_count_ = header->bucket_count;
+  table->bucket_seconds_ = header->bucket_seconds;
+  table->locations_ = reinterpret_cast<const location_t*>(header + 1);
+  table->entries_ = reinterpret_cast<const entry_t*>(table->locations_ + locations);
+  LOG_INFO("Matrix table " + file_name + " mapped with " + std::to_string(locations) +
+           " locations and " + std::to_string(header->bucket_count) + " buckets");
+  return table;
+}
+
+bool MatrixTable::Write(const std::string& file_name,
+                        const uint64_t costing,
+                        const uint32_t bucket_seconds,
+                        const std::vector<location_t>& locations,
+                        const std::vector<std::vector<entry_t>>& buckets) {
+  const size_t count = locations.size();
+  if (buckets.empty() || (buckets.size() > 1 && bucket_seconds == 0) ||
+      std::any_of(buckets.begin(), buckets.end(),
+                  [count](const std::vector<entry_t>& b) { return b.size() != count * count; })) {
+    LOG_ERROR("Matrix table needs an entry for every pair of locations in every bucket");
+    return false;
+  }
+
+  // the locations are looked up by their coordinates so they go in sorted and the rows and columns
+  // of the buckets with them
+  std::vector<uint32_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&locations](uint32_t a, uint32_t b) { return locations[a] < locations[b]; });
+  for (size_t i = 1; i < count; ++i) {
+    if (locations[order[i - 1]] == locations[order[i]]) {
+      LOG_ERROR("Matrix table locations must be unique");
+      return false;
+    }
+  }
+
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  header_t header{kVersion,
+                  costing,
+                  static_cast<uint32_t>(count),
+                  static_cast<uint32_t>(buckets.size()),
+                  bucket_seconds,
+                  0};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto i : order) {
+    file.write(reinterpret_cast<const char*>(&locations[i]), sizeof(location_t));
+  }
+  std::vector<entry_t> row(count);
+  for (const auto& bucket : buckets) {
+    for (const auto source : order) {
+      for (size_t j = 0; j < count; ++j) {
+        row[j] = bucket[source * count + order[j]];
+      }
+      file.write(reinterpret_cast<const char*>(row.data()), count * sizeof(entry_t));
+    }
+  }
+  return static_cast<bool>(file);
+}
+
+uint64_t MatrixTable::Key(const Options& options) {
+  // the same options must always serialize to the same bytes, map fields otherwise wouldnt
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream stream(&bytes);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    coded.WriteVarint32(options.costing_type());
+    auto costing = options.costings().find(options.costing_type());
+    if (costing != options.costings().end()) {
+      costing->second.SerializeToCodedStream(&coded);
+    }
+  }
+  return fnv1a(bytes);
+}
+
+MatrixTable::location_t MatrixTable::Round(const valhalla::Location& location) {
+  return {static_cast<int32_t>(std::lround(location.ll().lat() * 1e6)),
+          static_cast<int32_t>(std::lround(location.ll().lng() * 1e6))};
+}
+
+int32_t MatrixTable::Find(const valhalla::Location& location) const {
+  const auto rounded = Round(location);
+  const auto* end = locations_ + location_count_;
+  const auto* found = std::lower_bound(locations_, end, rounded);
+  return found == end || !(*found == rounded) ? -1 : static_cast<int32_t>(found - locations_);
+}
+
+int32_t MatrixTable::Bucket(const std::string& date_time) const {
+  if (date_time.empty()) {
+    return 0;
+  }
+  if (bucket_count_ == 1) {
+    return -1;
+  }
+
+  int64_t local;
+  try {
+    local = baldr::DateTime::get_formatted_date(date_time, true).time_since_epoch().count();
+  } catch (...) { return -1; }
+  // the epoch was a thursday and the week starts on monday
+  const int64_t seconds = local + 3 * static_cast<int64_t>(kSecondsPerDay);
+  const auto second_of_week = static_cast<uint32_t>((seconds % kSecondsPerWeek + kSecondsPerWeek) %
+                                                    kSecondsPerWeek);
+
+  // the closest slot, the one at the start of the week follows the last one
+  const uint32_t slot = ((second_of_week + bucket_seconds_ / 2) / bucket_seconds_) %
+                        ((kSecondsPerWeek + bucket_seconds_ - 1) / bucket_seconds_);
+  return slot + 1 < bucket_count_ ? static_cast<int32_t>(slot + 1) : -1;
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -66,7 +66,7 @@ void MultiModalPathAlgorithm::Init(const midgard::PointLL& destll,
   uint32_t bucketsize = costing->UnitSize();
   float range = kBucketCount * bucketsize;
   adjacencylist_.reuse(0.0f, range, bucketsize, &edgelabels_);
-  edgestatus_.clear();
+  edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
 
   // Get hierarchy limits from the costing. Get a copy since we increment
   // transition counts (i.e., this is not a const reference).
@@ -76,7 +76,7 @@ void MultiModalPathAlgorithm::Init(const midgard::PointLL& destll,
 // Clear the temporary information generated during path construction.
 void MultiModalPathAlgorithm::Clear() {
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
+  if (edgelabels_.capacity() > reservation) {
     edgelabels_.resize(reservation);
     edgelabels_.shrink_to_fit();
   }
@@ -89,7 +89,7 @@ void MultiModalPathAlgorithm::Clear() {
   adjacencylist_.clear();
 
   // Clear the edge status flags
-  edgestatus_.clear();
+  edgestatus_.clear(reservation);
 
   // Set the ferry flag to false
   has_ferry_ = false;
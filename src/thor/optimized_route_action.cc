@@ -28,6 +28,7 @@ void thor_worker_t::optimized_route(Api& request) {
 
   // Use CostMatrix to find costs from each location to every other location
   CostMatrix costmatrix;
+  costmatrix.set_interrupt(interrupt);
   std::vector<TimeDistance> td =
       costmatrix.SourceToTarget(*options.mutable_sources(), *options.mutable_targets(), *reader,
                                 mode_costing, mode, max_matrix_distance.find(costing)->second,
@@ -54,7 +55,7 @@ void thor_worker_t::optimized_route(Api& request) {
     time_costs.emplace_back(static_cast<float>(td[i].time));
   }
 
-  Optimizer optimizer;
+  Optimizer optimizer(optimizer_threads, optimizer_max_time);
   // returns the optimal order of the path_locations
   auto optimal_order = optimizer.Solve(correlated.size(), time_costs);
   // put the optimal order into the locations array
@@ -63,8 +64,10 @@ void thor_worker_t::optimized_route(Api& request) {
     options.mutable_locations()->Add()->CopyFrom(correlated.Get(optimal_order[i]));
   }
 
-  // run the route
-  path_depart_at(request, costing);
+  // run the route, the legs at once if we have the threads for it
+  if (!path_legs_in_parallel(request, costing)) {
+    path_depart_at(request, costing);
+  }
 }
 
 } // namespace thor
@@ -1,6 +1,9 @@
 #include "thor/optimizer.h"
+#include "midgard/executor.h"
 #include "midgard/logging.h"
 
+#include <atomic>
+
 namespace valhalla {
 namespace thor {
 
@@ -21,152 +24,153 @@ std::vector<uint32_t> Optimizer::Solve(const uint32_t count, const std::vector<f
     return (TourCost(costs, tour1) < TourCost(costs, tour2)) ? tour1 : tour2;
   }
 
-  // Populate the initial tour with a random order. The first and last
-  // locations must remain fixed as the tour begin and end locations do not
-  // change.
-  CreateRandomTour();
-
-  // Copy current tour to best tour and get the tour cost. Set the initial
-  // temperature based on tour cost
-  best_tour_ = tour_;
-  best_cost_ = TourCost(costs, tour_);
-  float temperature = best_cost_ / count_;
-
-  // Perform simulated annealing. Set a run limit per annealing step and a
-  // success limit to break out early if enough successes are found.
-  ntry_ = 0;
-  attempts_ = 400 * count_;
-  successes_ = 40 * count_;
-  for (uint32_t i = 0; i < 100; i++) {
-    // Break if no successes were found during this annealing step.
-    if (Anneal(costs, temperature) == 0) {
-      break;
+  // Each start keeps its own tour so the best one can be picked in start order no matter
+  // which thread finished first, a start that was never run keeps an empty tour
+  const auto deadline = clock_t::now() + std::chrono::milliseconds(max_time_ms_);
+  std::vector<std::vector<uint32_t>> tours(starts_);
+  std::atomic<uint32_t> next_start(0);
+  const auto run_starts = [&]() {
+    for (uint32_t start = next_start++; start < starts_; start = next_start++) {
+      // The first start always runs so there is a tour to return
+      if (start > 0 && max_time_ms_ > 0 && clock_t::now() > deadline) {
+        break;
+      }
+      std::mt19937 random(seed_ + start);
+      auto tour = NearestNeighborTour(costs, start == 0 ? nullptr : &random);
+      LocalSearch(costs, tour, deadline);
+      tours[start] = std::move(tour);
     }
-
-    // Reduce temperature
-    temperature *= kCoolingRate;
-  }
+  };
+
+  // this thread runs the first slot and idle threads of the shared pool the others
+  midgard::executor_t::shared().run(std::min(threads_, starts_), [&](uint32_t) {
+    try {
+      run_starts();
+    } catch (...) {
+      // make the other slots run out of starts
+      next_start = starts_;
+      throw;
+    }
+  });
 
   // Return the best tour
-  LOG_DEBUG("Best tour cost = " + std::to_string(best_cost_) + " ntries = " + std::to_string(ntry_));
-  return best_tour_;
-}
-
-// Perform the annealing process.
-uint32_t Optimizer::Anneal(const std::vector<float>& costs, float temperature) {
-  uint32_t success_count = 0;
-  for (uint32_t i = 0; i < attempts_; i++) {
-    // Select a potential tour alteration. Get temperature difference.
-    TourAlteration alteration = GetTourAlteration();
-    float diff = TemperatureDifference(costs, alteration);
-    ntry_++;
-
-    // Check if we should keep this as the new best path. The idea behind
-    // simulated annealing is that it tries to avoid becoming trapped in local
-    // optima by occasionally allowing worse solutions at a probability that
-    // declines with time.
-    // (http://www.technical-recipes.com/2012/c-implementation-of-hill-climbing-and-simulated-annealing-applied-to-travelling-salesman-problems/
-    if (diff < 0.0f || r01() < std::exp(-diff / temperature)) {
-      if (alteration.alt == kReverse) {
-        // Alter the tour by reversing the locations in the tour between a
-        // start and end location. Add 1 to the end index since STL algorithm
-        // reverse does not include the iterator at position it2.
-        auto it1 = tour_.begin() + alteration.start;
-        auto it2 = tour_.begin() + alteration.end + 1;
-        std::reverse(it1, it2);
-      } else {
-        // Alter the tour by rotating the locations about a middle point.
-        // The middle location becomes the new first location. Add 1 to
-        // the end index so that is included in the rotated set.
-        auto it1 = tour_.begin() + alteration.start;
-        auto it2 = tour_.begin() + alteration.mid;
-        auto it3 = tour_.begin() + alteration.end + 1;
-        std::rotate(it1, it2, it3);
-      }
-      success_count++;
-
-      // Get the tour cost and update the best tour if less cost
-      float cost = TourCost(costs, tour_);
-      if (cost < best_cost_) {
-        best_cost_ = cost;
-        best_tour_ = tour_;
+  uint32_t best = 0;
+  float best_cost = TourCost(costs, tours[0]);
+  for (uint32_t start = 1; start < starts_; ++start) {
+    if (!tours[start].empty()) {
+      float cost = TourCost(costs, tours[start]);
+      if (cost < best_cost) {
+        best = start;
+        best_cost = cost;
       }
     }
-    if (success_count >= successes_) {
-      break;
-    }
   }
-  return success_count;
+  LOG_DEBUG("Best tour cost = " + std::to_string(best_cost) + " start = " + std::to_string(best));
+  return std::move(tours[best]);
 }
 
-// Create a random initial tour. The first and last locations must remain
-// fixed as the tour begin and end locations do not change.
-void Optimizer::CreateRandomTour() {
-  tour_.clear();
+// Build a tour with a nearest neighbor heuristic. The destination is only
+// appended once all the other locations are visited.
+std::vector<uint32_t> Optimizer::NearestNeighborTour(const std::vector<float>& costs,
+                                                     std::mt19937* random) const {
+  std::vector<uint32_t> tour{0};
+  tour.reserve(count_);
+  std::vector<uint32_t> unvisited;
   for (uint32_t i = 1; i < count_ - 1; i++) {
-    tour_.push_back(i);
+    unvisited.push_back(i);
   }
-  std::random_device rd;
-  std::shuffle(tour_.begin(), tour_.end(), std::mt19937(rd()));
-  tour_.insert(tour_.begin(), 0);
-  tour_.push_back(count_ - 1);
+
+  while (!unvisited.empty()) {
+    // Order the few nearest locations first, the plain tour takes the nearest
+    // and the randomized ones any of them
+    const uint32_t from = tour.back();
+    const auto candidates = std::min<size_t>(random ? kNearestCandidates : 1, unvisited.size());
+    std::partial_sort(unvisited.begin(), unvisited.begin() + candidates, unvisited.end(),
+                      [&](const uint32_t a, const uint32_t b) {
+                        float ca = Cost(costs, from, a);
+                        float cb = Cost(costs, from, b);
+                        return ca < cb || (ca == cb && a < b);
+                      });
+    auto next = unvisited.begin();
+    if (random) {
+      next += std::uniform_int_distribution<size_t>(0, candidates - 1)(*random);
+    }
+    tour.push_back(*next);
+    unvisited.erase(next);
+  }
+  tour.push_back(count_ - 1);
+  return tour;
 }
 
-// Select a potential alteration of the tour.
-TourAlteration Optimizer::GetTourAlteration() {
-  // Select three unique locations between 1 and count-2
-  std::vector<uint32_t> loc(3);
-  while (true) {
-    loc[0] = get_random_location();
-    loc[1] = get_random_location();
-    loc[2] = get_random_location();
-    if (loc[0] != loc[1] && loc[0] != loc[2] && loc[1] != loc[2]) {
+// Improve a tour with 2-opt and Or-opt moves until neither finds a better
+// tour or the deadline passes.
+void Optimizer::LocalSearch(const std::vector<float>& costs,
+                            std::vector<uint32_t>& tour,
+                            const clock_t::time_point& deadline) const {
+  while (TwoOpt(costs, tour) || OrOpt(costs, tour)) {
+    if (max_time_ms_ > 0 && clock_t::now() > deadline) {
       break;
     }
   }
-
-  // Sort location indexes so they have increasing values to use as
-  // a start location index, mid location index (for rotation), and an
-  // end location index.
-  std::sort(loc.begin(), loc.end());
-
-  // Randomly select the alteration type and return the
-  // tour alteration (indexes and type).
-  AlterationType t = (r01() < 0.5f) ? kReverse : kRotate;
-  return {loc[0], loc[1], loc[2], t};
 }
 
-float Optimizer::TemperatureDifference(const std::vector<float>& costs,
-                                       const TourAlteration& alteration) {
-  float c = 0;
-  uint32_t start = alteration.start;
-  uint32_t end = alteration.end;
-  if (alteration.alt == kRotate) {
-    // Subtract costs of connections that are broken
-    uint32_t mid = alteration.mid;
-    c -= Cost(costs, tour_[start - 1], tour_[start]);
-    c -= Cost(costs, tour_[end], tour_[end + 1]);
-    c -= Cost(costs, tour_[mid - 1], tour_[mid]);
+// Apply the first improving 2-opt move found: reverse the locations between
+// two positions.
+bool Optimizer::TwoOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  // Running costs along the tour in both directions so the cost of any part of the
+  // tour, forward or reversed, is a difference of two of them
+  std::vector<float> forward(count_, 0.0f), backward(count_, 0.0f);
+  for (uint32_t i = 1; i < count_; i++) {
+    forward[i] = forward[i - 1] + Cost(costs, tour[i - 1], tour[i]);
+    backward[i] = backward[i - 1] + Cost(costs, tour[i], tour[i - 1]);
+  }
 
-    // Add costs for the new connections
-    c += Cost(costs, tour_[start - 1], tour_[mid]);
-    c += Cost(costs, tour_[end], tour_[start]);
-    c += Cost(costs, tour_[mid - 1], tour_[end + 1]);
-  } else {
-    // Reverse tour locations between a start and an end index.
-    // Subtract costs between successive locations from start-1 to end+1
-    for (uint32_t i = start - 1, j = i + 1; i <= end; i++, j++) {
-      c -= Cost(costs, tour_[i], tour_[j]);
+  // Reverse the locations from start to end, neither the origin nor the destination move
+  for (uint32_t start = 1; start < count_ - 2; start++) {
+    for (uint32_t end = start + 1; end < count_ - 1; end++) {
+      float before = Cost(costs, tour[start - 1], tour[start]) + (forward[end] - forward[start]) +
+                     Cost(costs, tour[end], tour[end + 1]);
+      float after = Cost(costs, tour[start - 1], tour[end]) + (backward[end] - backward[start]) +
+                    Cost(costs, tour[start], tour[end + 1]);
+      if (after < before - kMinImprovement) {
+        std::reverse(tour.begin() + start, tour.begin() + end + 1);
+        return true;
+      }
     }
+  }
+  return false;
+}
 
-    // Add costs for the new connections and the reversed order
-    c += Cost(costs, tour_[start - 1], tour_[end]);
-    c += Cost(costs, tour_[start], tour_[end + 1]);
-    for (uint32_t i = end, j = i - 1; i > start; i--, j--) {
-      c += Cost(costs, tour_[i], tour_[j]);
+// Apply the first improving Or-opt move found: move a run of up to
+// kMaxOrOptLength consecutive locations elsewhere in the tour.
+bool Optimizer::OrOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  for (uint32_t length = 1; length <= kMaxOrOptLength; length++) {
+    // The run goes from start to end, neither the origin nor the destination move
+    for (uint32_t start = 1; start + length < count_; start++) {
+      uint32_t end = start + length - 1;
+      float removed = Cost(costs, tour[start - 1], tour[start]) +
+                      Cost(costs, tour[end], tour[end + 1]) -
+                      Cost(costs, tour[start - 1], tour[end + 1]);
+
+      // Insert the run between the locations at position i and i + 1
+      for (uint32_t i = 0; i < count_ - 1; i++) {
+        if (i + 1 >= start && i <= end) {
+          continue;
+        }
+        float added = Cost(costs, tour[i], tour[start]) + Cost(costs, tour[end], tour[i + 1]) -
+                      Cost(costs, tour[i], tour[i + 1]);
+        if (added < removed - kMinImprovement) {
+          if (i < start) {
+            std::rotate(tour.begin() + i + 1, tour.begin() + start, tour.begin() + end + 1);
+          } else {
+            std::rotate(tour.begin() + start, tour.begin() + end + 1, tour.begin() + i + 1);
+          }
+          return true;
+        }
+      }
     }
   }
-  return (c / static_cast<float>(count_));
+  return false;
 }
 
 // Get the cost for the specified tour (order of locations).
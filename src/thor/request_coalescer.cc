@@ -0,0 +1,100 @@
+#include "thor/request_coalescer.h"
+#include "worker.h"
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// how long a waiting request sleeps between checking its own interrupt
+constexpr std::chrono::milliseconds kWaitInterval(10);
+
+// the responses being computed by the workers of the process, by the keys of their requests
+std::mutex inflight_lock;
+std::unordered_map<std::string, std::shared_future<std::string>> inflight;
+
+// whether the error is the answer to the request rather than something which stopped computing it
+bool answers(const std::exception_ptr& error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (const valhalla::valhalla_exception_t& e) {
+    return e.code != 175 && e.code != 446;
+  } catch (...) {
+    return false;
+  }
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+bool RequestCoalescer::coalescable(const Api& request) {
+  switch (request.options().action()) {
+    case Options::route:
+    case Options::optimized_route:
+    case Options::sources_to_targets:
+    case Options::isochrone:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::string RequestCoalescer::share(const std::string& key,
+                                    const std::function<std::string()>& compute,
+                                    const std::function<void()>* interrupt,
+                                    bool& shared) {
+  std::promise<std::string> promise;
+  std::shared_future<std::string> response;
+  {
+    std::lock_guard<std::mutex> lock(inflight_lock);
+    auto found = inflight.find(key);
+    shared = found != inflight.end();
+    if (shared) {
+      response = found->second;
+    } else {
+      response = promise.get_future().share();
+      inflight.emplace(key, response);
+    }
+  }
+
+  // wait for the identical request, our own deadline still applies
+  if (shared) {
+    while (response.wait_for(kWaitInterval) != std::future_status::ready) {
+      if (interrupt) {
+        (*interrupt)();
+      }
+    }
+    try {
+      return response.get();
+    } catch (...) {
+      if (answers(std::current_exception())) {
+        throw;
+      }
+    }
+    // the computation was stopped for reasons of its own request, we take over
+    return share(key, compute, interrupt, shared);
+  }
+
+  // later requests compute their own response once this one is ready
+  const auto done = [&key]() {
+    std::lock_guard<std::mutex> lock(inflight_lock);
+    inflight.erase(key);
+  };
+  try {
+    auto computed = compute();
+    done();
+    promise.set_value(computed);
+    return computed;
+  } catch (...) {
+    done();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
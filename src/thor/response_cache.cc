@@ -0,0 +1,101 @@
+#include "thor/response_cache.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+namespace {
+
+bool leaves_now(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
+  for (const auto& location : locations) {
+    if (location.date_time() == "current")
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+bool ResponseCache::cacheable(const Api& request) const {
+  if (!max_size_)
+    return false;
+
+  const auto& options = request.options();
+  switch (options.action()) {
+    case Options::route:
+    case Options::optimized_route:
+    case Options::sources_to_targets:
+      break;
+    default:
+      return false;
+  }
+
+  return options.date_time_type() != Options::current && !leaves_now(options.locations()) &&
+         !leaves_now(options.sources()) && !leaves_now(options.targets());
+}
+
+std::string ResponseCache::key(const Api& request) {
+  // the deadline differs between otherwise identical requests
+  const Options* options = &request.options();
+  Options without_deadline;
+  if (options->deadline()) {
+    without_deadline = *options;
+    without_deadline.clear_deadline();
+    options = &without_deadline;
+  }
+
+  // the same options must always serialize to the same bytes, map fields otherwise wouldnt
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream stream(&key);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    options->SerializeToCodedStream(&coded);
+    for (const auto& warning : request.info().warnings()) {
+      warning.SerializeToCodedStream(&coded);
+    }
+  }
+  return key;
+}
+
+const std::string* ResponseCache::find(const std::string& key) {
+  auto found = index_.find(key);
+  if (found == index_.end())
+    return nullptr;
+
+  auto entry = found->second;
+  if (ttl_ && clock_t::now() > entry->expires) {
+    erase(entry);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry);
+  return &entry->response;
+}
+
+void ResponseCache::insert(const std::string& key, std::string response) {
+  auto found = index_.find(key);
+  if (found != index_.end())
+    erase(found->second);
+
+  const auto entry_size = key.size() + response.size();
+  if (entry_size > max_size_)
+    return;
+  while (bytes_ + entry_size > max_size_)
+    erase(std::prev(entries_.end()));
+
+  entries_.push_front({key, std::move(response), clock_t::now() + std::chrono::seconds(ttl_)});
+  index_.emplace(entries_.front().key, entries_.begin());
+  bytes_ += entry_size;
+}
+
+void ResponseCache::erase(std::list<entry_t>::iterator entry) {
+  bytes_ -= entry->key.size() + entry->response.size();
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+} // namespace thor
+} // namespace valhalla
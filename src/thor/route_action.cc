@@ -1,11 +1,14 @@
 #include "thor/worker.h"
+#include <atomic>
 #include <cstdint>
 
 #include "baldr/attributes_controller.h"
 #include "baldr/json.h"
 #include "baldr/rapidjson_utils.h"
 #include "midgard/constants.h"
+#include "midgard/executor.h"
 #include "midgard/logging.h"
+#include "midgard/tracepoints.h"
 #include "midgard/util.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
@@ -171,6 +174,21 @@ opposing) { loc.mutable_correlation()->mutable_edges()->SwapElements(i, loc.path
   }
 }*/
 
+// a request of its own for each comparison, on the same locations but with its costing
+std::vector<Api> comparison_requests(const Api& api) {
+  const auto& options = api.options();
+  std::vector<Api> comparisons(options.comparisons_size());
+  for (int i = 0; i < options.comparisons_size(); ++i) {
+    auto& comparison_options = *comparisons[i].mutable_options();
+    comparison_options = options;
+    comparison_options.clear_comparisons();
+    const auto& costing = options.comparisons(i);
+    comparison_options.set_costing_type(costing.type());
+    (*comparison_options.mutable_costings())[costing.type()] = costing;
+  }
+  return comparisons;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -188,6 +206,7 @@ void thor_worker_t::centroid(Api& request) {
   valhalla::Location destination;
 
   // get all the routes
+  mark_used(centroid_gen);
   auto paths =
       centroid_gen.Expand(ExpansionType::forward, request, *reader, mode_costing, mode, destination);
 
@@ -201,8 +220,11 @@ void thor_worker_t::centroid(Api& request) {
     // actually build the route object
     auto* route = request.mutable_trip()->mutable_routes()->Add();
     auto& leg = *route->mutable_legs()->Add();
-    thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(), path.end(),
-                                *origin, dest, leg, {"centroid"}, interrupt);
+    {
+      auto _ = measure_phase(request, "thor.trip_leg_builder");
+      thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
+                                  path.end(), *origin, dest, leg, {"centroid"}, interrupt);
+    }
 
     // TODO: set the time at the destination if time dependent
 
@@ -219,13 +241,20 @@ void thor_worker_t::route(Api& request) {
   adjust_scores(options);
   controller = AttributesController(options);
   auto costing = parse_costing(request);
+  // the comparisons start from the locations before this route changes them
+  auto comparisons = comparison_requests(request);
 
-  // get all the legs
+  // get all the legs, at once if they don't depend on each other and we have the threads for it
   if (options.date_time_type() == Options::arrive_by) {
     path_arrive_by(request, costing);
-  } else {
+  } else if (!path_legs_in_parallel(request, costing)) {
     path_depart_at(request, costing);
   }
+
+  // then the same locations with the other costings
+  if (!comparisons.empty()) {
+    path_comparisons(request, comparisons);
+  }
 }
 
 thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routetype,
@@ -235,41 +264,54 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
   // make sure they are all cancelable
   for (auto* alg : std::vector<PathAlgorithm*>{
            &multi_modal_astar,
+           &connection_scan,
            &timedep_forward,
            &timedep_reverse,
            &bidir_astar,
            &bss_astar,
+           &bss_bidir_astar,
        }) {
     alg->set_interrupt(interrupt);
   }
 
-  // Have to use multimodal for transit based routing
+  // Have to use multimodal for transit based routing, either over the graph or the timetable
   if (routetype == "multimodal" || routetype == "transit") {
+    if (use_connection_scan) {
+      return &connection_scan;
+    }
     return &multi_modal_astar;
   }
 
   // Have to use bike share station algorithm
   if (routetype == "bikeshare") {
+    if (use_bidirectional_bss) {
+      return &bss_bidir_astar;
+    }
     return &bss_astar;
   }
 
+  // Time dependent routes between locations closer than both the maximum and the bidirectional
+  // time dependent distance are searched from the end with the date_time only. Further apart
+  // bidirectional a* tracks the time on that end and uses time independent costs on the other
+  const float timedep_distance = std::min(max_timedep_distance, bidirectional_timedep_distance);
+
   // If the origin has date_time set use timedep_forward method if the distance
-  // between location is below some maximum distance (TBD).
+  // between location is below the time dependent distance.
   if (!origin.date_time().empty() && options.date_time_type() != Options::invariant &&
       !options.prioritize_bidirectional()) {
     PointLL ll1(origin.ll().lng(), origin.ll().lat());
     PointLL ll2(destination.ll().lng(), destination.ll().lat());
-    if (ll1.Distance(ll2) < max_timedep_distance) {
+    if (ll1.Distance(ll2) < timedep_distance) {
       return &timedep_forward;
     }
   }
 
   // If the destination has date_time set use timedep_reverse method if the distance
-  // between location is below some maximum distance (TBD).
+  // between location is below the time dependent distance.
   if (!destination.date_time().empty() && options.date_time_type() != Options::invariant) {
     PointLL ll1(origin.ll().lng(), origin.ll().lat());
     PointLL ll2(destination.ll().lng(), destination.ll().lat());
-    if (ll1.Distance(ll2) < max_timedep_distance) {
+    if (ll1.Distance(ll2) < timedep_distance) {
       return &timedep_reverse;
     }
   }
@@ -297,7 +339,39 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
                                                                  valhalla::Location& origin,
                                                                  valhalla::Location& destination,
                                                                  const std::string& costing,
-                                                                 const Options& options) {
+                                                                 Api& api) {
+  const auto& options = api.options();
+  // the expansion of each algorithm is timed on its own, e.g. thor.bidirectional_astar
+  std::string phase = "thor.";
+  for (const char* c = path_algorithm->name(); *c; ++c) {
+    if (*c == '*') {
+      phase += "star";
+    } else {
+      phase.push_back(std::tolower(static_cast<unsigned char>(*c)));
+    }
+  }
+  const auto expand = [&]() {
+    std::vector<std::vector<PathInfo>> found;
+    {
+      auto _ = measure_phase(api, phase);
+      VALHALLA_TRACE(search_start, path_algorithm->name());
+      found =
+          path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+      VALHALLA_TRACE(search_done, path_algorithm->name(), path_algorithm->LabelCount());
+    }
+    record_phase_amount(api, phase, "labels", path_algorithm->LabelCount());
+    record_phase_amount(api, phase, "hierarchy_pruned", path_algorithm->HierarchyPrunedCount());
+    record_phase_amount(api, phase, "queue_redistributions",
+                        path_algorithm->QueueRedistributions());
+    search_counters.set_searches(search_counters.searches() + 1);
+    search_counters.set_labels(search_counters.labels() + path_algorithm->LabelCount());
+    search_counters.set_hierarchy_pruned(search_counters.hierarchy_pruned() +
+                                         path_algorithm->HierarchyPrunedCount());
+    search_counters.set_queue_redistributions(search_counters.queue_redistributions() +
+                                              path_algorithm->QueueRedistributions());
+    return found;
+  };
+
   // Find the path.
   valhalla::sif::cost_ptr_t cost = mode_costing[static_cast<uint32_t>(mode)];
 
@@ -307,7 +381,7 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
   cost->set_allow_destination_only(path_algorithm == &bidir_astar ? false : true);
 
   cost->set_pass(0);
-  auto paths = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+  auto paths = expand();
 
   // Check if we should run a second pass pedestrian route with different A*
   // (to look for better routes where a ferry is taken)
@@ -338,8 +412,7 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
     cost->set_allow_conditional_destination(true);
     path_algorithm->set_not_thru_pruning(false);
     // Get the best path. Return if not empty (else return the original path)
-    auto relaxed_paths =
-        path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+    auto relaxed_paths = expand();
     if (!relaxed_paths.empty()) {
       return relaxed_paths;
     }
@@ -363,6 +436,7 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
     // Get the algorithm type for this location pair
     thor::PathAlgorithm* path_algorithm =
         this->get_path_algorithm(costing, *origin, *destination, options);
+    mark_used(*path_algorithm);
     path_algorithm->Clear();
     algorithms.push_back(path_algorithm->name());
     LOG_INFO(std::string("algorithm::") + path_algorithm->name());
@@ -375,7 +449,7 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
     }
 
     // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
+    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, api);
     if (temp_paths.empty())
       return false;
 
@@ -451,9 +525,12 @@ void thor_worker_t::path_arrive_by(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
-        TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(), path.end(),
-                              *origin, *destination, leg, algorithms, interrupt, edge_trimming,
-                              intermediates);
+        {
+          auto _ = measure_phase(api, "thor.trip_leg_builder");
+          TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
+                                path.end(), *origin, *destination, leg, algorithms, interrupt,
+                                edge_trimming, intermediates);
+        }
 
         // advance the time for the next destination (i.e. algo origin) by the waiting_secs
         // of this origin (i.e. algo destination)
@@ -536,6 +613,7 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
     // Get the algorithm type for this location pair
     thor::PathAlgorithm* path_algorithm =
         this->get_path_algorithm(costing, *origin, *destination, options);
+    mark_used(*path_algorithm);
     path_algorithm->Clear();
     algorithms.push_back(path_algorithm->name());
     LOG_INFO(std::string("algorithm::") + path_algorithm->name());
@@ -547,7 +625,7 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
                         [&last_edge](const auto& edge) { return edge.graph_id() != last_edge; });
     }
     // Get best path and keep it
-    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, options);
+    auto temp_paths = this->get_path(path_algorithm, *origin, *destination, costing, api);
     if (temp_paths.empty())
       return false;
 
@@ -604,9 +682,12 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
           route->mutable_legs()->Reserve(options.locations_size());
         }
         auto& leg = *route->mutable_legs()->Add();
-        thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
-                                    path.end(), *origin, *destination, leg, algorithms, interrupt,
-                                    edge_trimming, {std::next(origin), destination});
+        {
+          auto _ = measure_phase(api, "thor.trip_leg_builder");
+          thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, path.begin(),
+                                      path.end(), *origin, *destination, leg, algorithms, interrupt,
+                                      edge_trimming, {std::next(origin), destination});
+        }
 
         path.clear();
         edge_trimming.clear();
@@ -665,6 +746,155 @@ void thor_worker_t::path_depart_at(Api& api, const std::string& costing) {
   *api.mutable_options()->mutable_locations() = std::move(correlated);
 }
 
+bool thor_worker_t::path_legs_in_parallel(Api& api, const std::string& costing) {
+  // The legs only stand alone if none of them depends on the path of the one before it: every
+  // location has to be a break (no leg merging) and those in between may not be break_through
+  // (which pins the edge a leg starts on to the one the leg before ended on), no time is
+  // propagated from one leg to the next and there are no alternates to line up across legs
+  const auto& options = api.options();
+  const auto leg_count = static_cast<size_t>(options.locations_size()) - 1;
+  if (leg_workers.empty() || leg_count < 2 || options.alternates() > 0 ||
+      (options.date_time_type() != Options::invariant &&
+       !options.locations(0).date_time().empty())) {
+    return false;
+  }
+  for (int i = 0; i < options.locations_size(); ++i) {
+    const auto& location = options.locations(i);
+    const bool end = i == 0 || i == options.locations_size() - 1;
+    if (!is_break_point(location) || (!end && is_through_point(location))) {
+      return false;
+    }
+  }
+
+  // Each leg is a two location request of its own
+  std::vector<Api> legs(leg_count);
+  for (size_t i = 0; i < leg_count; ++i) {
+    auto& leg_options = *legs[i].mutable_options();
+    leg_options = options;
+    leg_options.mutable_locations()->Clear();
+    leg_options.mutable_locations()->Add()->CopyFrom(options.locations(i));
+    leg_options.mutable_locations()->Add()->CopyFrom(options.locations(i + 1));
+  }
+
+  // The legs are handed out one at a time to this thread and the leg workers, a leg that finds no
+  // route sends the whole request back through the serial path which can retry the intermediate
+  // locations without their low reachability candidates
+  std::atomic<size_t> next_leg(0);
+  std::atomic<bool> failed(false);
+  const auto route_legs = [&](thor_worker_t& worker) {
+    for (size_t i = next_leg++; i < leg_count; i = next_leg++) {
+      try {
+        worker.path_depart_at(legs[i], costing);
+      } catch (const valhalla_exception_t& e) {
+        if (e.code != 442) {
+          throw;
+        }
+        failed = true;
+        next_leg = leg_count;
+      }
+    }
+  };
+
+  // this thread routes the legs of the first slot and idle threads of the shared pool those of
+  // the leg workers
+  const size_t thread_count = std::min(leg_workers.size() + 1, leg_count);
+  midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+    try {
+      if (slot == 0) {
+        route_legs(*this);
+      } else {
+        auto& worker = *leg_workers[slot - 1];
+        worker.parse_costing(api);
+        worker.controller = controller;
+        route_legs(worker);
+      }
+    } catch (...) {
+      // make the other slots run out of legs
+      next_leg = leg_count;
+      throw;
+    }
+  });
+  if (failed) {
+    return false;
+  }
+
+  // Stitch the legs back together in order along with their correlated locations
+  auto& locations = *api.mutable_options()->mutable_locations();
+  auto& route = *api.mutable_trip()->mutable_routes()->Add();
+  route.mutable_legs()->Reserve(leg_count);
+  for (size_t i = 0; i < leg_count; ++i) {
+    locations.Mutable(i)->Swap(legs[i].mutable_options()->mutable_locations(0));
+    route.mutable_legs()->Add()->Swap(legs[i].mutable_trip()->mutable_routes(0)->mutable_legs(0));
+  }
+  locations.Mutable(leg_count)->Swap(legs.back().mutable_options()->mutable_locations(1));
+
+  // the timings of the phases of each leg go with the rest of the request
+  auto& statistics = *api.mutable_info()->mutable_statistics();
+  for (auto& leg : legs) {
+    for (auto& stat : *leg.mutable_info()->mutable_statistics()) {
+      statistics.Add()->Swap(&stat);
+    }
+  }
+  return true;
+}
+
+void thor_worker_t::path_comparisons(Api& api, std::vector<Api>& comparisons) {
+  // The comparisons are handed out one at a time to this thread and the leg workers, each drops the
+  // candidates of the locations which only the other costings can use before routing
+  std::atomic<size_t> next_comparison(0);
+  const auto route_comparisons = [&](thor_worker_t& worker) {
+    for (size_t i = next_comparison++; i < comparisons.size(); i = next_comparison++) {
+      auto& comparison = comparisons[i];
+      const auto costing = worker.parse_costing(comparison);
+      const auto& mode_cost = worker.mode_costing[static_cast<size_t>(worker.mode)];
+      auto& reader = *worker.reader;
+      for (auto& location : *comparison.mutable_options()->mutable_locations()) {
+        remove_path_edges(location, [&](const valhalla::PathEdge& candidate) {
+          graph_tile_ptr tile;
+          const auto* edge = reader.directededge(GraphId(candidate.graph_id()), tile);
+          return !edge || !mode_cost->Allowed(edge, tile, kDisallowShortcut);
+        });
+        if (location.correlation().edges_size() == 0) {
+          throw valhalla_exception_t{171};
+        }
+      }
+      if (comparison.options().date_time_type() == Options::arrive_by) {
+        worker.path_arrive_by(comparison, costing);
+      } else {
+        worker.path_depart_at(comparison, costing);
+      }
+    }
+  };
+
+  const size_t thread_count = std::min(leg_workers.size() + 1, comparisons.size());
+  midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+    try {
+      if (slot == 0) {
+        route_comparisons(*this);
+      } else {
+        auto& worker = *leg_workers[slot - 1];
+        worker.controller = controller;
+        route_comparisons(worker);
+      }
+    } catch (...) {
+      // make the other slots run out of comparisons
+      next_comparison = comparisons.size();
+      throw;
+    }
+  });
+
+  // The routes follow the one of the costing of the request in the order of the comparisons, the
+  // timings of their phases go with the rest of the request
+  auto& statistics = *api.mutable_info()->mutable_statistics();
+  for (auto& comparison : comparisons) {
+    api.mutable_trip()->mutable_routes()->Add()->Swap(
+        comparison.mutable_trip()->mutable_routes(0));
+    for (auto& stat : *comparison.mutable_info()->mutable_statistics()) {
+      statistics.Add()->Swap(&stat);
+    }
+  }
+}
+
 /**
  * Offset a time by some number of seconds, optionally taking into account timezones at the origin &
  * destination.
@@ -27,11 +27,33 @@ namespace {
 using end_edge_t = std::pair<valhalla::PathEdge, float>;
 using end_node_t = std::unordered_map<GraphId, end_edge_t>;
 
-// Data type to record edges and transitions that have been followed for each shape
-// index and hierarchy level. First entry in the pair is the index (from the node's
-// starting directed edge index) of the directed edge. The second entry in the pair
-// is the transition index.
-using followed_edges_t = std::vector<std::vector<std::pair<uint32_t, uint32_t>>>;
+// Records the edges and transitions that have been followed for each shape index and
+// hierarchy level. First entry in the pair is the index (from the node's starting
+// directed edge index) of the directed edge. The second entry in the pair is the
+// transition index. The levels of all the shape indices are kept in one array.
+struct followed_edges_t {
+  void reset(size_t shape_size) {
+    levels = TileHierarchy::get_max_level();
+    followed.assign(shape_size * levels, {0, 0});
+  }
+
+  std::pair<uint32_t, uint32_t>& operator()(size_t index, uint32_t level) {
+    return followed[index * levels + level];
+  }
+
+  size_t levels = 0;
+  std::vector<std::pair<uint32_t, uint32_t>> followed;
+};
+
+// The input shape as plain points, the distances along it and the followed edges. These
+// are kept per thread so that, once they have grown to the longest shape seen, walking a
+// shape does not allocate for them at all
+struct walk_scratch_t {
+  std::vector<valhalla::midgard::PointLL> points;
+  // distance from the previous shape point and accumulated distance from the start
+  std::vector<std::pair<float, float>> distances;
+  followed_edges_t followed_edges;
+};
 
 // Total distance match delta
 constexpr float kTotalDistanceEpsilon = 5.0f;
@@ -105,7 +127,8 @@ bool expand_from_node(const mode_costing_t& mode_costing,
                       const TravelMode& mode,
                       GraphReader& reader,
                       const google::protobuf::RepeatedPtrField<valhalla::Location>& shape,
-                      std::vector<std::pair<float, float>>& distances,
+                      const std::vector<valhalla::midgard::PointLL>& points,
+                      const std::vector<std::pair<float, float>>& distances,
                       const valhalla::baldr::TimeInfo& time_info,
                       const bool use_timestamps,
                       size_t& correlated_index,
@@ -130,15 +153,18 @@ bool expand_from_node(const mode_costing_t& mode_costing,
 
   // Get the last edge followed from this index
   uint32_t level = node.level();
-  uint32_t start_de = followed_edges[correlated_index][level].first;
+  auto& followed = followed_edges(correlated_index, level);
+  uint32_t start_de = followed.first;
 
-  // Iterate through directed edges from this node
+  // Iterate through directed edges from this node. Most end nodes are in the same tile
+  // as the node so we only look up a tile when the end node is in a different one
   const NodeInfo* nodeinfo = tile->node(node);
   GraphId edge_id(node.tileid(), level, nodeinfo->edge_index());
   const DirectedEdge* de = tile->directededge(nodeinfo->edge_index());
+  graph_tile_ptr end_node_tile = tile;
   for (uint32_t i = start_de; i < nodeinfo->edge_count(); i++, de++, ++edge_id) {
     // Mark the directed edge as already followed
-    followed_edges[correlated_index][level].first = i;
+    followed.first = i;
 
     // Skip shortcuts and transit connection edges
     // TODO - later might allow transit connections for multi-modal
@@ -154,8 +180,7 @@ bool expand_from_node(const mode_costing_t& mode_costing,
     }
 
     // Get the end node LL and set up the length comparison
-    graph_tile_ptr end_node_tile = reader.GetGraphTile(de->endnode());
-    if (end_node_tile == nullptr) {
+    if (!reader.GetGraphTile(de->endnode(), end_node_tile)) {
       continue;
     }
     valhalla::midgard::PointLL de_end_ll = end_node_tile->get_node_ll(de->endnode());
@@ -165,15 +190,15 @@ bool expand_from_node(const mode_costing_t& mode_costing,
     // the current edge. Increment to the next shape point after the correlated index.
     size_t index = correlated_index + 1;
     float length = 0.0f;
-    while (index < shape.size()) {
+    while (index < points.size()) {
       // Exclude edge if length along shape is longer than the edge length
-      length += distances.at(index).first;
+      length += distances[index].first;
       if (length > de_length) {
         break;
       }
 
       // Found a match if shape equals directed edge LL within tolerance
-      if (to_ll(shape.Get(index).ll()).ApproximatelyEqual(de_end_ll) &&
+      if (points[index].ApproximatelyEqual(de_end_ll) &&
           de->length() < length_comparison(length, true)) {
 
         // Figure out what time it is right now, the first iteration is a no-op
@@ -215,9 +240,10 @@ bool expand_from_node(const mode_costing_t& mode_costing,
                            turn};
 
         // Continue walking shape to find the end edge...
-        if (expand_from_node(mode_costing, mode, reader, shape, distances, time_info, use_timestamps,
-                             index, end_node_tile, de->endnode(), end_nodes, prev_edge_label, elapsed,
-                             path_infos, false, end_node, followed_edges)) {
+        if (expand_from_node(mode_costing, mode, reader, shape, points, distances, time_info,
+                             use_timestamps, index, end_node_tile, de->endnode(), end_nodes,
+                             prev_edge_label, elapsed, path_infos, false, end_node,
+                             followed_edges)) {
           return true;
         } else {
           // Match failed along this edge, pop the last entry off path_infos as well as what it
@@ -232,20 +258,20 @@ bool expand_from_node(const mode_costing_t& mode_costing,
   }
 
   // Get the last transition followed from this index
-  uint32_t start_trans = followed_edges[correlated_index][level].second;
+  uint32_t start_trans = followed.second;
 
   // Handle transitions - expand from the transition end nodes
   if (!from_transition && nodeinfo->transition_count() > 0) {
     const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
     for (uint32_t i = start_trans; i < nodeinfo->transition_count(); ++i, ++trans) {
-      followed_edges[correlated_index][level].second = i;
-      graph_tile_ptr end_node_tile = reader.GetGraphTile(trans->endnode());
-      if (end_node_tile == nullptr) {
+      followed.second = i;
+      if (!reader.GetGraphTile(trans->endnode(), end_node_tile)) {
         continue;
       }
-      if (expand_from_node(mode_costing, mode, reader, shape, distances, time_info, use_timestamps,
-                           correlated_index, end_node_tile, trans->endnode(), end_nodes,
-                           prev_edge_label, elapsed, path_infos, true, end_node, followed_edges)) {
+      if (expand_from_node(mode_costing, mode, reader, shape, points, distances, time_info,
+                           use_timestamps, correlated_index, end_node_tile, trans->endnode(),
+                           end_nodes, prev_edge_label, elapsed, path_infos, true, end_node,
+                           followed_edges)) {
         return true;
       }
     }
@@ -305,23 +331,31 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
     throw std::runtime_error("Invalid shape - less than 2 points");
   }
 
+  // Take the shape points out of the locations once rather than at every comparison
+  thread_local walk_scratch_t scratch;
+  auto& points = scratch.points;
+  points.clear();
+  points.reserve(options.shape_size());
+  for (const auto& location : options.shape()) {
+    points.push_back(to_ll(location.ll()));
+  }
+
   // Form distances between shape points and accumulated distance from start to each shape point
   float total_distance = 0.0f;
-  std::vector<std::pair<float, float>> distances;
+  auto& distances = scratch.distances;
+  distances.clear();
+  distances.reserve(points.size());
   distances.push_back(std::make_pair(0.0f, 0.0f));
-  for (size_t i = 1; i < options.shape_size(); i++) {
-    float d = to_ll(options.shape(i).ll()).Distance(to_ll(options.shape(i - 1).ll()));
+  for (size_t i = 1; i < points.size(); i++) {
+    float d = points[i].Distance(points[i - 1]);
     total_distance += d;
     distances.push_back(std::make_pair(d, total_distance));
   }
 
   // Keep a record of followed edges and transition from each shape index (for each hierarchy level) -
   // this prevents doubling back and causing an infinite loop (could be due to transitions)
-  followed_edges_t followed_edges;
-  followed_edges.resize(options.shape_size());
-  for (auto& f : followed_edges) {
-    f.resize(TileHierarchy::get_max_level());
-  }
+  auto& followed_edges = scratch.followed_edges;
+  followed_edges.reset(points.size());
 
   // Process and validate end edges (can be more than 1). Create a map of
   // the end edges' start nodes and the edge information.
@@ -371,16 +405,16 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
     const NodeInfo* nodeinfo = nullptr;
 
     // Loop over shape to form path from matching edges
-    while (index < options.shape_size()) {
+    while (index < points.size()) {
 
       // bail on this edge if the length of input we checked is already longer than the edge
-      length += distances.at(index).first;
+      length += distances[index].first;
       if (length > de_length) {
         break;
       }
 
       // Check if shape is within tolerance at the end node
-      if (to_ll(options.shape(index).ll()).ApproximatelyEqual(de_end_ll) &&
+      if (points[index].ApproximatelyEqual(de_end_ll) &&
           de_remaining_length < length_comparison(length, true)) {
 
         // Figure out what time it is right now, the first iteration is a no-op
@@ -422,9 +456,10 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
 
         // Continue walking shape to find the end node
         GraphId end_node;
-        if (expand_from_node(mode_costing, mode, reader, options.shape(), distances, time_info,
-                             options.use_timestamps(), index, end_node_tile, de->endnode(), end_nodes,
-                             prev_edge_label, elapsed, path_infos, false, end_node, followed_edges)) {
+        if (expand_from_node(mode_costing, mode, reader, options.shape(), points, distances,
+                             time_info, options.use_timestamps(), index, end_node_tile,
+                             de->endnode(), end_nodes, prev_edge_label, elapsed, path_infos, false,
+                             end_node, followed_edges)) {
           // Find the edge we stopped on at the destination, if we didnt find it the greedy algorithm
           // hit a local maximum (made the wrong choice), TODO: we could rollback and try more
           auto n = end_nodes.find(end_node);
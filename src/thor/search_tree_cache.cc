@@ -0,0 +1,300 @@
+#include "thor/search_tree_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+// the same as the one of the time distance matrix, the target is the origin of the search
+bool IsTrivial(const uint64_t& edgeid,
+               const valhalla::Location& origin,
+               const valhalla::Location& destination) {
+  for (const auto& destination_edge : destination.correlation().edges()) {
+    if (destination_edge.graph_id() == edgeid) {
+      for (const auto& origin_edge : origin.correlation().edges()) {
+        if (origin_edge.graph_id() == edgeid &&
+            origin_edge.percent_along() <= destination_edge.percent_along()) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+SearchTree::SearchTree(const valhalla::Location& target,
+                       const std::shared_ptr<sif::DynamicCost>& costing,
+                       const sif::travel_mode_t mode,
+                       const float max_matrix_distance,
+                       const bool invariant,
+                       GraphReader& graphreader)
+    : target_(target), invariant_(invariant), frontier_(0.f), exhausted_(false) {
+  mode_ = mode;
+  costing_ = costing;
+  time_info_ = TimeInfo::make(target_, graphreader, &tz_cache_);
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+  adjacencylist_.reuse(0.0f, current_cost_threshold_, costing_->UnitSize(), &edgelabels_);
+  SetOrigin<ExpansionType::reverse>(graphreader, target_, time_info_);
+}
+
+uint32_t SearchTree::Grow(GraphReader& graphreader) {
+  if (exhausted_) {
+    return kInvalidLabel;
+  }
+
+  uint32_t predindex = adjacencylist_.pop();
+  if (predindex == kInvalidLabel) {
+    exhausted_ = true;
+    return kInvalidLabel;
+  }
+
+  // origin labels are not marked permanent so that loops around the block still work
+  EdgeLabel pred = edgelabels_[predindex];
+  if (pred.origin()) {
+    origin_labels_[pred.edgeid()].push_back(predindex);
+  } else {
+    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+  }
+  frontier_ = pred.cost().cost;
+
+  // the label still counts but nothing beyond the threshold is expanded
+  if (pred.cost().cost > current_cost_threshold_) {
+    exhausted_ = true;
+    return predindex;
+  }
+
+  Expand<ExpansionType::reverse>(graphreader, pred.endnode(), pred, predindex, false, time_info_,
+                                 invariant_);
+  return predindex;
+}
+
+std::vector<TimeDistance>
+SearchTree::Query(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+                  GraphReader& graphreader) {
+  // what is known about each source so far
+  struct source_t {
+    Cost best_cost{kMaxCost, kMaxCost};
+    uint32_t distance = 0;
+    GraphId best_edge;
+    float threshold = 0.f;
+    uint32_t pending = 0;
+    bool settled = false;
+  };
+  std::vector<source_t> found(sources.size());
+
+  // looks for the cheapest settled label of an edge of a source, returns false if there is none yet
+  const auto reach = [&](const uint32_t source_index, const GraphId& edgeid,
+                         const float remainder) {
+    auto& source = found[source_index];
+    bool reached = false;
+    const auto consider = [&](const EdgeLabel& pred) {
+      reached = true;
+      graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+      const DirectedEdge* edge = tile->directededge(edgeid);
+      uint8_t flow_sources;
+      Cost cost =
+          pred.cost() - (costing_->EdgeCost(edge, tile, time_info_, flow_sources) * remainder);
+      if (cost.cost < source.best_cost.cost) {
+        source.best_cost = cost;
+        source.distance = pred.path_distance() - (edge->length() * remainder);
+        source.best_edge = edgeid;
+      }
+    };
+
+    auto status = edgestatus_.Get(edgeid);
+    if (status.set() == EdgeSet::kPermanent) {
+      consider(edgelabels_[status.index()]);
+    }
+    auto origin = origin_labels_.find(edgeid);
+    if (origin != origin_labels_.end() && IsTrivial(edgeid, target_, sources.Get(source_index))) {
+      for (auto label : origin->second) {
+        consider(edgelabels_[label]);
+      }
+    }
+    return reached;
+  };
+
+  // the sources with a path ordered by best cost + threshold, past which they are settled
+  std::vector<std::pair<float, uint32_t>> settle_heap;
+  const auto improved = [&](const uint32_t source_index) {
+    const auto& source = found[source_index];
+    if (source.best_cost.cost != kMaxCost) {
+      settle_heap.emplace_back(source.best_cost.cost + source.threshold, source_index);
+      std::push_heap(settle_heap.begin(), settle_heap.end(), std::greater<>());
+    }
+  };
+
+  // the same destination edges a time distance matrix would set up, answered from the tree so far
+  std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, float>>> waiting;
+  uint32_t unsettled = 0;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(sources.size()); ++i) {
+    const auto& location = sources.Get(i);
+    auto& source = found[i];
+    if (location.ll().lat() == target_.ll().lat() && location.ll().lng() == target_.ll().lng()) {
+      source.best_cost = Cost{0.f, 0.f};
+      source.settled = true;
+      continue;
+    }
+
+    std::vector<std::pair<GraphId, float>> edges;
+    for (const auto& edge : location.correlation().edges()) {
+      GraphId edgeid(edge.graph_id());
+      if (costing_->AvoidAsDestinationEdge(edgeid, edge.percent_along())) {
+        continue;
+      }
+      graph_tile_ptr tile = graphreader.GetGraphTile(edgeid);
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      float c = costing_->EdgeCost(directededge, tile).cost;
+      c += edge.distance();
+      source.threshold = std::max(source.threshold, c);
+      edges.emplace_back(graphreader.GetOpposingEdgeId(edgeid), edge.percent_along());
+    }
+    for (const auto& edge : edges) {
+      if (!reach(i, edge.first, edge.second)) {
+        waiting[edge.first].emplace_back(i, edge.second);
+        ++source.pending;
+      }
+    }
+    if (source.pending) {
+      improved(i);
+      ++unsettled;
+    } else {
+      source.settled = true;
+    }
+  }
+
+  // grow the tree until every source has all its edges settled or the search moved beyond them
+  int n = 0;
+  while (unsettled) {
+    while (!settle_heap.empty() && settle_heap.front().first < frontier_) {
+      const auto& entry = settle_heap.front();
+      auto& source = found[entry.second];
+      if (!source.settled && source.best_cost.cost + source.threshold == entry.first) {
+        source.settled = true;
+        --unsettled;
+      }
+      std::pop_heap(settle_heap.begin(), settle_heap.end(), std::greater<>());
+      settle_heap.pop_back();
+    }
+    if (!unsettled) {
+      break;
+    }
+
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
+    uint32_t predindex = Grow(graphreader);
+    if (predindex == kInvalidLabel) {
+      break;
+    }
+    auto edge_waiting = waiting.find(edgelabels_[predindex].edgeid());
+    if (edge_waiting == waiting.end()) {
+      continue;
+    }
+
+    // the sources which reached this edge stop waiting for it
+    auto& edge_sources = edge_waiting->second;
+    const GraphId edgeid(edge_waiting->first);
+    for (auto waiting_source = edge_sources.begin(); waiting_source != edge_sources.end();) {
+      const auto source_index = waiting_source->first;
+      auto& source = found[source_index];
+      if (!source.settled) {
+        const auto before = source.best_cost.cost;
+        if (!reach(source_index, edgeid, waiting_source->second)) {
+          ++waiting_source;
+          continue;
+        }
+        if (source.best_cost.cost < before) {
+          improved(source_index);
+        }
+        if (--source.pending == 0) {
+          source.settled = true;
+          --unsettled;
+        }
+      }
+      waiting_source = edge_sources.erase(waiting_source);
+    }
+  }
+
+  std::vector<TimeDistance> td;
+  td.reserve(found.size());
+  for (const auto& source : found) {
+    auto date_time = get_date_time(target_.date_time(), time_info_.timezone_index, source.best_edge,
+                                   graphreader, static_cast<uint64_t>(source.best_cost.secs + .5f));
+    td.emplace_back(source.best_cost.secs, source.distance, date_time);
+  }
+  return td;
+}
+
+bool SearchTreeCache::cacheable(const Options& options) const {
+  return max_trees_ && options.targets_size() == 1 && options.sources_size() > 1 &&
+         options.matrix_locations() >= static_cast<uint32_t>(options.sources_size()) &&
+         !options.departure_times_size() && options.date_time_type() != Options::current &&
+         options.targets(0).date_time() != "current";
+}
+
+std::string SearchTreeCache::key(const Options& options) {
+  // the same options must always serialize to the same bytes, map fields otherwise wouldnt
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream stream(&key);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    options.targets(0).SerializeToCodedStream(&coded);
+    auto costing = options.costings().find(options.costing_type());
+    if (costing != options.costings().end()) {
+      costing->second.SerializeToCodedStream(&coded);
+    }
+    coded.WriteVarint32(options.costing_type());
+    coded.WriteVarint32(options.date_time_type());
+  }
+  return key;
+}
+
+SearchTree* SearchTreeCache::find(const std::string& key) {
+  auto found = index_.find(key);
+  if (found == index_.end())
+    return nullptr;
+
+  auto entry = found->second;
+  if (ttl_ && clock_t::now() > entry->expires) {
+    erase(entry);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry);
+  return entry->tree.get();
+}
+
+SearchTree* SearchTreeCache::insert(const std::string& key, std::unique_ptr<SearchTree> tree) {
+  auto found = index_.find(key);
+  if (found != index_.end())
+    erase(found->second);
+
+  while (entries_.size() >= max_trees_ && !entries_.empty())
+    erase(std::prev(entries_.end()));
+
+  entries_.push_front({key, std::move(tree), clock_t::now() + std::chrono::seconds(ttl_)});
+  index_.emplace(entries_.front().key, entries_.begin());
+  return entries_.front().tree.get();
+}
+
+void SearchTreeCache::erase(std::list<entry_t>::iterator entry) {
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -1,8 +1,35 @@
 #include "thor/worker.h"
 
+namespace {
+
+using namespace valhalla;
+
+// what the algorithm learned about the travel modes it has searched with
+void add_label_reservations(SearchCounters& counters, const thor::PathAlgorithm& algorithm) {
+  static const std::vector<std::pair<sif::travel_mode_t, std::string>> kModes{
+      {sif::travel_mode_t::kDrive, "drive"},
+      {sif::travel_mode_t::kPedestrian, "pedestrian"},
+      {sif::travel_mode_t::kBicycle, "bicycle"},
+      {sif::travel_mode_t::kPublicTransit, "transit"},
+  };
+  for (const auto& mode : kModes) {
+    const auto& stats = algorithm.label_reservation().stats(mode.first);
+    if (stats.searches == 0) {
+      continue;
+    }
+    auto* reservation = counters.add_label_reservations();
+    reservation->set_algorithm(algorithm.name());
+    reservation->set_travel_mode(mode.second);
+    reservation->set_searches(stats.searches);
+    reservation->set_labels_per_km(stats.labels_per_km);
+  }
+}
+
+} // namespace
+
 namespace valhalla {
 namespace thor {
-void thor_worker_t::status(Api&) const {
+void thor_worker_t::status(Api& request) const {
 #ifdef HAVE_HTTP
   // if we are in the process of shutting down we signal that here
   // should react by draining traffic (though they are likely doing this as they are usually the ones
@@ -11,6 +38,19 @@ void thor_worker_t::status(Api&) const {
     throw valhalla_exception_t{402};
   }
 #endif
+
+  // what the tile cache and the searches did is only returned if explicitly asked for
+  if (!request.options().verbose() || !allow_verbose)
+    return;
+
+  auto* counters = add_service_counters(request, service_name(), *reader);
+  *counters->mutable_search() = search_counters;
+  add_allocation_counters(*counters);
+  for (const PathAlgorithm* algorithm :
+       std::initializer_list<const PathAlgorithm*>{&bidir_astar, &timedep_forward, &timedep_reverse,
+                                                   &bss_astar, &bss_bidir_astar}) {
+    add_label_reservations(*counters->mutable_search(), *algorithm);
+  }
 }
 } // namespace thor
 } // namespace valhalla
@@ -38,7 +38,8 @@ TimeDistanceBSSMatrix::TimeDistanceBSSMatrix(const boost::property_tree::ptree&
     : settled_count_(0), current_cost_threshold_(0),
       max_reserved_labels_count_(config.get<uint32_t>("max_reserved_labels_count_dijkstras",
                                                       kInitialEdgeLabelCountDijkstras)),
-      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)) {
+      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)),
+      interrupt_(nullptr) {
 }
 
 float TimeDistanceBSSMatrix::GetCostThreshold(const float max_matrix_distance) const {
@@ -215,7 +216,13 @@ std::vector<TimeDistance> TimeDistanceBSSMatrix::ComputeMatrix(
 
     // Find shortest path
     graph_tile_ptr tile;
+    int n = 0;
     while (true) {
+      // Allow this process to be aborted
+      if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+        (*interrupt_)();
+      }
+
       // Get next element from adjacency list. Check that it is valid. An
       // invalid label indicates there are no edges that can be expanded.
       uint32_t predindex = adjacencylist_.pop();
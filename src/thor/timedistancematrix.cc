@@ -1,6 +1,9 @@
 #include "thor/timedistancematrix.h"
+#include "midgard/executor.h"
 #include "midgard/logging.h"
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <vector>
 
 using namespace valhalla::baldr;
@@ -32,7 +35,17 @@ TimeDistanceMatrix::TimeDistanceMatrix(const boost::property_tree::ptree& config
     : mode_(travel_mode_t::kDrive), settled_count_(0), current_cost_threshold_(0),
       max_reserved_labels_count_(config.get<uint32_t>("max_reserved_labels_count_dijkstras",
                                                       kInitialEdgeLabelCountDijkstras)),
-      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)) {
+      clear_reserved_memory_(config.get<bool>("clear_reserved_memory", false)),
+      unfound_count_(0), label_count_(0), interrupt_(nullptr) {
+  // Extra matrices for computing rows in parallel, they only get to run once readers are set
+  const auto threads = config.get<uint32_t>("matrix_threads", 1);
+  if (threads > 1) {
+    auto worker_config = config;
+    worker_config.put("matrix_threads", 1);
+    for (uint32_t i = 1; i < threads; ++i) {
+      workers_.emplace_back(new TimeDistanceMatrix(worker_config));
+    }
+  }
 }
 
 // Compute a cost threshold in seconds based on average speed for the travel mode.
@@ -195,97 +208,168 @@ std::vector<TimeDistance> TimeDistanceMatrix::ComputeMatrix(
     const float max_matrix_distance,
     const uint32_t matrix_locations,
     const bool invariant) {
-  uint32_t bucketsize = costing_->UnitSize();
   auto time_infos = SetTime(origins, graphreader);
+  label_count_ = 0;
+  for (auto& worker : workers_) {
+    worker->label_count_ = 0;
+  }
 
-  // Initialize destinations once for all origins
-  InitDestinations<expansion_direction>(graphreader, destinations);
-
+  // Insert one-to-many into many-to-many, rows are sources and columns are targets
   std::vector<TimeDistance> many_to_many(origins.size() * destinations.size());
-  for (size_t origin_index = 0; origin_index < origins.size(); ++origin_index) {
-    // reserve some space for the next dijkstras (will be cleared at the end of the loop)
-    edgelabels_.reserve(max_reserved_labels_count_);
-    auto& origin = origins.Get(origin_index);
-    const auto& time_info = time_infos[origin_index];
-
-    std::vector<TimeDistance> one_to_many;
-    current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
-
-    // Construct adjacency list. Set bucket size and cost range based on DynamicCost.
-    adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
-
-    // Initialize the origin and set the available destination edges
-    settled_count_ = 0;
-    SetOrigin<expansion_direction>(graphreader, origin, time_info);
-    SetDestinationEdges();
-
-    // Find shortest path
-    graph_tile_ptr tile;
-    while (true) {
-      // Get next element from adjacency list. Check that it is valid. An
-      // invalid label indicates there are no edges that can be expanded.
-      uint32_t predindex = adjacencylist_.pop();
-      if (predindex == kInvalidLabel) {
-        // Can not expand any further...
-        one_to_many = FormTimeDistanceMatrix(graphreader, origin.date_time(),
-                                             time_info.timezone_index, GraphId{});
-        break;
+  const auto insert = [&](const size_t origin_index, const std::vector<TimeDistance>& one_to_many) {
+    for (size_t dest_index = 0; dest_index < destinations.size(); dest_index++) {
+      size_t index = FORWARD ? origin_index * destinations.size() + dest_index
+                             : dest_index * origins.size() + origin_index;
+      many_to_many[index] = one_to_many[dest_index];
+    }
+  };
+
+  // With a single thread everything happens right here
+  const size_t thread_count = std::min<size_t>(this->thread_count(), origins.size());
+  if (thread_count <= 1) {
+    // Initialize destinations once for all origins
+    InitDestinations<expansion_direction>(graphreader, destinations);
+    for (size_t origin_index = 0; origin_index < origins.size(); ++origin_index) {
+      insert(origin_index, ComputeOneToMany<expansion_direction>(origins.Get(origin_index),
+                                                                 time_infos[origin_index],
+                                                                 destinations, graphreader,
+                                                                 max_matrix_distance,
+                                                                 matrix_locations, invariant));
+    }
+    return many_to_many;
+  }
+
+  // Otherwise the origins are handed out one at a time to this thread and the workers, each of
+  // which has its own labels, adjacency list, edge status, destinations and graph reader
+  std::atomic<size_t> next_origin(0);
+  const auto compute_rows = [&](TimeDistanceMatrix& matrix, baldr::GraphReader& reader) {
+    matrix.mode_ = mode_;
+    matrix.costing_ = costing_;
+    matrix.InitDestinations<expansion_direction>(reader, destinations);
+    for (size_t origin_index = next_origin++; origin_index < origins.size();
+         origin_index = next_origin++) {
+      insert(origin_index, matrix.ComputeOneToMany<expansion_direction>(origins.Get(origin_index),
+                                                                        time_infos[origin_index],
+                                                                        destinations, reader,
+                                                                        max_matrix_distance,
+                                                                        matrix_locations,
+                                                                        invariant));
+    }
+  };
+
+  // this thread takes the first slot and idle threads of the shared pool the workers' slots
+  try {
+    midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+      try {
+        if (slot == 0) {
+          compute_rows(*this, graphreader);
+        } else {
+          compute_rows(*workers_[slot - 1], *thread_readers_[slot - 1]);
+        }
+      } catch (...) {
+        // make the other slots run out of origins
+        next_origin = origins.size();
+        throw;
       }
+    });
+  } catch (...) {
+    for (auto& worker : workers_) {
+      worker->clear();
+    }
+    throw;
+  }
+  for (auto& worker : workers_) {
+    worker->clear();
+  }
 
-      // Copy the EdgeLabel for use in costing
-      EdgeLabel pred = edgelabels_[predindex];
+  return many_to_many;
+}
 
-      // Remove label from adjacency list, mark it as permanently labeled.
+template <const ExpansionType expansion_direction, const bool FORWARD>
+std::vector<TimeDistance> TimeDistanceMatrix::ComputeOneToMany(
+    const valhalla::Location& origin,
+    const baldr::TimeInfo& time_info,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& destinations,
+    baldr::GraphReader& graphreader,
+    const float max_matrix_distance,
+    const uint32_t matrix_locations,
+    const bool invariant) {
+  uint32_t bucketsize = costing_->UnitSize();
 
-      // Mark the edge as permanently labeled. Do not do this for an origin
-      // edge. Otherwise loops/around the block cases will not work
-      if (!pred.origin()) {
-        edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
-      }
+  // reserve some space for the next dijkstras (will be cleared at the end)
+  edgelabels_.reserve(max_reserved_labels_count_);
 
-      // Identify any destinations on this edge
-      auto destedge = dest_edges_.find(pred.edgeid());
-      if (destedge != dest_edges_.end()) {
-        // Update any destinations along this edge. Return if all destinations
-        // have been settled or the requested amount of destinations has been found
-        tile = graphreader.GetGraphTile(pred.edgeid());
-        const DirectedEdge* edge = tile->directededge(pred.edgeid());
-        if (UpdateDestinations(origin, destinations, destedge->second, edge, tile, pred, time_info,
-                               matrix_locations)) {
-          one_to_many = FormTimeDistanceMatrix(graphreader, origin.date_time(),
-                                               time_info.timezone_index, pred.edgeid());
-          break;
-        }
-      }
+  std::vector<TimeDistance> one_to_many;
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+
+  // Construct adjacency list. Set bucket size and cost range based on DynamicCost.
+  adjacencylist_.reuse(0.0f, current_cost_threshold_, bucketsize, &edgelabels_);
+
+  // Initialize the origin and set the available destination edges
+  settled_count_ = 0;
+  unfound_count_ = destinations_.size();
+  SetOrigin<expansion_direction>(graphreader, origin, time_info);
+  SetDestinationEdges();
+
+  // Find shortest path
+  graph_tile_ptr tile;
+  int n = 0;
+  while (true) {
+    // Allow this process to be aborted
+    if (interrupt_ && (++n % kInterruptIterationsInterval) == 0) {
+      (*interrupt_)();
+    }
+
+    // Get next element from adjacency list. Check that it is valid. An
+    // invalid label indicates there are no edges that can be expanded.
+    uint32_t predindex = adjacencylist_.pop();
+    if (predindex == kInvalidLabel) {
+      // Can not expand any further...
+      one_to_many = FormTimeDistanceMatrix(graphreader, origin.date_time(), time_info.timezone_index,
+                                           GraphId{});
+      break;
+    }
 
-      // Terminate when we are beyond the cost threshold
-      if (pred.cost().cost > current_cost_threshold_) {
+    // Copy the EdgeLabel for use in costing
+    EdgeLabel pred = edgelabels_[predindex];
+
+    // Remove label from adjacency list, mark it as permanently labeled.
+
+    // Mark the edge as permanently labeled. Do not do this for an origin
+    // edge. Otherwise loops/around the block cases will not work
+    if (!pred.origin()) {
+      edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+    }
+
+    // Identify any destinations on this edge
+    auto destedge = dest_edges_.find(pred.edgeid());
+    if (destedge != dest_edges_.end()) {
+      // Update any destinations along this edge. Return if all destinations
+      // have been settled or the requested amount of destinations has been found
+      tile = graphreader.GetGraphTile(pred.edgeid());
+      const DirectedEdge* edge = tile->directededge(pred.edgeid());
+      if (UpdateDestinations(origin, destinations, destedge->second, edge, tile, pred, time_info,
+                             matrix_locations)) {
         one_to_many = FormTimeDistanceMatrix(graphreader, origin.date_time(),
                                              time_info.timezone_index, pred.edgeid());
         break;
       }
-
-      // Expand forward from the end node of the predecessor edge.
-      Expand<expansion_direction>(graphreader, pred.endnode(), pred, predindex, false, time_info,
-                                  invariant);
     }
 
-    // Insert one-to-many into many-to-many
-    if (FORWARD) {
-      for (size_t target_index = 0; target_index < destinations.size(); target_index++) {
-        size_t index = origin_index * origins.size() + target_index;
-        many_to_many[index] = one_to_many[target_index];
-      }
-    } else {
-      for (size_t source_index = 0; source_index < destinations.size(); source_index++) {
-        size_t index = source_index * origins.size() + origin_index;
-        many_to_many[index] = one_to_many[source_index];
-      }
+    // Terminate when we are beyond the cost threshold
+    if (pred.cost().cost > current_cost_threshold_) {
+      one_to_many = FormTimeDistanceMatrix(graphreader, origin.date_time(), time_info.timezone_index,
+                                           pred.edgeid());
+      break;
     }
-    reset();
+
+    // Expand forward from the end node of the predecessor edge.
+    Expand<expansion_direction>(graphreader, pred.endnode(), pred, predindex, false, time_info,
+                                invariant);
   }
 
-  return many_to_many;
+  reset();
+  return one_to_many;
 }
 
 template std::vector<TimeDistance> TimeDistanceMatrix::ComputeMatrix<ExpansionType::forward, true>(
@@ -303,6 +387,37 @@ template std::vector<TimeDistance> TimeDistanceMatrix::ComputeMatrix<ExpansionTy
     const uint32_t matrix_locations,
     const bool invariant);
 
+std::vector<TimeDistance> TimeDistanceMatrix::SourceToTargetAtTimes(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    baldr::GraphReader& graphreader,
+    const sif::mode_costing_t& mode_costing,
+    const sif::travel_mode_t mode,
+    const float max_matrix_distance,
+    const google::protobuf::RepeatedPtrField<std::string>& departure_times,
+    const uint32_t matrix_locations) {
+  LOG_INFO("matrix::TimeDistanceMatrix at " + std::to_string(departure_times.size()) + " times");
+
+  // Set the mode and costing
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+
+  // Every source departs once at each time, the rows of a time follow those of the time before
+  google::protobuf::RepeatedPtrField<valhalla::Location> origins;
+  origins.Reserve(source_location_list.size() * departure_times.size());
+  for (const auto& departure_time : departure_times) {
+    for (const auto& source : source_location_list) {
+      auto* origin = origins.Add();
+      origin->CopyFrom(source);
+      origin->set_date_time(departure_time);
+    }
+  }
+
+  // Departure times only make sense searching forward, which also keeps each slice in row order
+  return ComputeMatrix<ExpansionType::forward>(origins, target_location_list, graphreader,
+                                               max_matrix_distance, matrix_locations, false);
+}
+
 // Add edges at the origin to the adjacency list
 template <const ExpansionType expansion_direction, const bool FORWARD>
 void TimeDistanceMatrix::SetOrigin(GraphReader& graphreader,
@@ -480,14 +595,29 @@ bool TimeDistanceMatrix::UpdateDestinations(
     auto settle_dest = [&]() {
       dest.dest_edges_available.erase(dest_available);
       if (dest.dest_edges_available.empty()) {
+        if (dest.best_cost.cost == kMaxCost) {
+          unfound_count_--;
+        }
         dest.settled = true;
         settled_count_++;
       }
     };
 
+    // and when finding a better path to it
+    auto improve_dest = [&](const Cost& cost, const uint32_t distance) {
+      if (dest.best_cost.cost == kMaxCost) {
+        unfound_count_--;
+      }
+      dest.best_cost = cost;
+      dest.distance = distance;
+      settle_heap_.emplace_back(cost.cost + dest.threshold, dest_idx);
+      std::push_heap(settle_heap_.begin(), settle_heap_.end(), std::greater<>());
+      threshold_heap_.emplace_back(cost.cost + dest.threshold, dest_idx);
+      std::push_heap(threshold_heap_.begin(), threshold_heap_.end());
+    };
+
     if (origin.ll().lat() == dest_loc.ll().lat() && origin.ll().lng() == dest_loc.ll().lng()) {
-      dest.best_cost = Cost{0.f, 0.f};
-      dest.distance = 0;
+      improve_dest(Cost{0.f, 0.f}, 0);
       settle_dest();
       continue;
     }
@@ -507,8 +637,7 @@ bool TimeDistanceMatrix::UpdateDestinations(
     Cost newcost =
         pred.cost() - (costing_->EdgeCost(edge, tile, time_info, flow_sources) * remainder);
     if (newcost.cost < dest.best_cost.cost) {
-      dest.best_cost = newcost;
-      dest.distance = pred.path_distance() - (edge->length() * remainder);
+      improve_dest(newcost, pred.path_distance() - (edge->length() * remainder));
     }
 
     // Erase this edge from further consideration. Mark this destination as
@@ -516,38 +645,32 @@ bool TimeDistanceMatrix::UpdateDestinations(
     settle_dest();
   }
 
+  // An entry of the heaps is current if its destination is unsettled and it still has that cost
+  const auto current = [this](const std::pair<float, uint32_t>& entry) {
+    const auto& d = destinations_[entry.second];
+    return !d.settled && d.best_cost.cost + d.threshold == entry.first;
+  };
+
   // Settle any destinations where current cost is above the destination's
   // best cost + threshold. This helps remove destinations where one edge
   // cannot be reached (e.g. on a cul-de-sac or where turn restrictions apply).
-  // Update the cost threshold if at least one path to all destinations has
-  // been found.
-  bool allfound = true;
-  float maxcost = 0.0f;
-
-  for (auto& d : destinations_) {
-    // Skip any settled destinations
-    if (d.settled) {
-      continue;
-    }
-
-    // Do not update cost threshold if no path to this destination
-    // has been found
-    if (d.best_cost.cost == kMaxCost) {
-      allfound = false;
-    } else {
-      // Settle any destinations above their threshold and update maxcost
-      if ((d.best_cost.cost + d.threshold) < pred.cost().cost) {
-        d.settled = true;
-        settled_count_++;
-      }
-      maxcost = std::max(maxcost, d.best_cost.cost + d.threshold);
+  while (!settle_heap_.empty() && settle_heap_.front().first < pred.cost().cost) {
+    if (current(settle_heap_.front())) {
+      destinations_[settle_heap_.front().second].settled = true;
+      settled_count_++;
     }
+    std::pop_heap(settle_heap_.begin(), settle_heap_.end(), std::greater<>());
+    settle_heap_.pop_back();
   }
 
   // Update cost threshold for early termination if at least one path has
   // been found to each destination
-  if (allfound) {
-    current_cost_threshold_ = maxcost;
+  if (unfound_count_ == 0) {
+    while (!threshold_heap_.empty() && !current(threshold_heap_.front())) {
+      std::pop_heap(threshold_heap_.begin(), threshold_heap_.end());
+      threshold_heap_.pop_back();
+    }
+    current_cost_threshold_ = threshold_heap_.empty() ? 0.0f : threshold_heap_.front().first;
   }
 
   // Return true if the settled count equals the number of destinations or
@@ -569,5 +692,19 @@ std::vector<TimeDistance> TimeDistanceMatrix::FormTimeDistanceMatrix(GraphReader
   return td;
 }
 
+// the search trees kept between matrices grow a reverse search themselves
+template void TimeDistanceMatrix::SetOrigin<ExpansionType::reverse, false>(
+    GraphReader& graphreader,
+    const valhalla::Location& origin,
+    const TimeInfo& time_info);
+template void
+TimeDistanceMatrix::Expand<ExpansionType::reverse, false>(GraphReader& graphreader,
+                                                          const GraphId& node,
+                                                          const EdgeLabel& pred,
+                                                          const uint32_t pred_idx,
+                                                          const bool from_transition,
+                                                          const baldr::TimeInfo& time_info,
+                                                          const bool invariant);
+
 } // namespace thor
 } // namespace valhalla
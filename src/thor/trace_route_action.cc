@@ -1,6 +1,7 @@
 #include "thor/worker.h"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <unordered_map>
@@ -10,6 +11,7 @@
 #include "baldr/attributes_controller.h"
 #include "meili/map_matcher.h"
 #include "meili/match_result.h"
+#include "midgard/executor.h"
 #include "midgard/util.h"
 #include "thor/map_matcher.h"
 #include "thor/route_matcher.h"
@@ -155,8 +157,11 @@ void thor_worker_t::route_match(Api& request) {
       assert(dest != options.mutable_shape()->end());
       // Form the trip path based on mode costing, origin, destination, and path edges
       auto& leg = *request.mutable_trip()->mutable_routes()->Add()->mutable_legs()->Add();
-      thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, pleg.begin(),
-                                  pleg.end(), *origin, *dest, leg, {"edge_walk"}, interrupt);
+      {
+        auto _ = measure_phase(request, "thor.trip_leg_builder");
+        thor::TripLegBuilder::Build(options, controller, *reader, mode_costing, pleg.begin(),
+                                    pleg.end(), *origin, *dest, leg, {"edge_walk"}, interrupt);
+      }
       // Next leg
       origin = dest;
     }
@@ -184,7 +189,11 @@ thor_worker_t::map_match(Api& request) {
   int topk = request.options().action() == Options::trace_attributes
                  ? request.options().alternates() + 1
                  : 1;
-  auto topk_match_results = matcher->OfflineMatch(trace, topk);
+  auto topk_match_results = topk == 1 ? match_parts_in_parallel(options)
+                                      : std::vector<meili::MatchResults>{};
+  if (topk_match_results.empty()) {
+    topk_match_results = matcher->OfflineMatch(trace, topk);
+  }
 
   // Process each score/match result
   std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>> map_match_results;
@@ -250,6 +259,68 @@ thor_worker_t::map_match(Api& request) {
   return map_match_results;
 }
 
+std::vector<meili::MatchResults> thor_worker_t::match_parts_in_parallel(const Options& options) {
+  // The osrm serializer looks up the candidates of the matched states in this worker's matcher
+  if (leg_workers.empty() ||
+      (options.action() == Options::trace_route && options.format() == Options::osrm)) {
+    return {};
+  }
+  const auto firsts = meili::FindBreakages(matcher->config(), trace);
+  const auto part_count = firsts.size();
+  if (part_count < 2) {
+    return {};
+  }
+
+  // The parts are handed out one at a time to this thread and the leg workers, a part without any
+  // candidates sends the whole trace back through the serial match which can match around it
+  std::vector<std::vector<meili::MatchResults>> parts(part_count);
+  std::atomic<size_t> next_part(0);
+  std::atomic<bool> failed(false);
+  const auto match_parts = [&](meili::MapMatcher& part_matcher) {
+    for (size_t i = next_part++; i < part_count; i = next_part++) {
+      const auto end = i + 1 < part_count ? trace.begin() + firsts[i + 1] : trace.end();
+      const std::vector<meili::Measurement> measurements(trace.begin() + firsts[i], end);
+      try {
+        parts[i] = part_matcher.OfflineMatch(measurements);
+      } catch (const valhalla_exception_t& e) {
+        if (e.code != 443) {
+          throw;
+        }
+        failed = true;
+        next_part = part_count;
+      }
+    }
+  };
+  const size_t thread_count = std::min(leg_workers.size() + 1, part_count);
+  midgard::executor_t::shared().run(thread_count, [&](uint32_t slot) {
+    try {
+      if (slot == 0) {
+        match_parts(*matcher);
+      } else {
+        auto& worker = *leg_workers[slot - 1];
+        worker.matcher.reset(worker.matcher_factory.Create(options));
+        match_parts(*worker.matcher);
+      }
+    } catch (...) {
+      // make the other slots run out of parts
+      next_part = part_count;
+      throw;
+    }
+  });
+  if (failed) {
+    return {};
+  }
+
+  std::vector<meili::MatchResults> best_parts;
+  best_parts.reserve(part_count);
+  for (auto& part : parts) {
+    best_parts.emplace_back(std::move(part.front()));
+  }
+  std::vector<meili::MatchResults> match_results;
+  match_results.emplace_back(meili::JoinMatchResults(std::move(best_parts)));
+  return match_results;
+}
+
 void thor_worker_t::build_trace(
     const std::deque<std::pair<std::vector<PathInfo>, std::vector<const meili::EdgeSegment*>>>& paths,
     std::vector<meili::MatchResult>& match_results,
@@ -330,6 +401,7 @@ void thor_worker_t::build_trace(
 
   // actually build the leg and add it to the route
   auto& leg = *request.mutable_trip()->add_routes()->add_legs();
+  auto _ = measure_phase(request, "thor.trip_leg_builder");
   thor::TripLegBuilder::Build(options, controller, matcher->graphreader(), mode_costing,
                               path_edges.begin(), path_edges.end(), *origin_location,
                               *destination_location, leg, {"map_snap"}, interrupt, edge_trimming);
@@ -414,9 +486,12 @@ void thor_worker_t::build_route(
 
     // actually build the leg and add it to the route
     auto& leg = *route->mutable_legs()->Add();
-    TripLegBuilder::Build(options, controller, matcher->graphreader(), mode_costing,
-                          path.first.cbegin(), path.first.cend(), *origin_location,
-                          *destination_location, leg, {"map_snap"}, interrupt, edge_trimming);
+    {
+      auto _ = measure_phase(request, "thor.trip_leg_builder");
+      TripLegBuilder::Build(options, controller, matcher->graphreader(), mode_costing,
+                            path.first.cbegin(), path.first.cend(), *origin_location,
+                            *destination_location, leg, {"map_snap"}, interrupt, edge_trimming);
+    }
 
     if (path.second.back()->discontinuity) {
       ++route_index;
@@ -171,6 +171,7 @@ valhalla::TripLeg_Closure* fetch_or_create_closure_annotation(TripLeg& leg) {
  * @param edge_seconds
  * @param cut_for_traffic
  * @param incidents
+ * @param shape_attributes  whether any of the shape attributes were requested
  */
 void SetShapeAttributes(const AttributesController& controller,
                         const graph_tile_ptr& tile,
@@ -183,18 +184,17 @@ void SetShapeAttributes(const AttributesController& controller,
                         double tgt_pct,
                         double edge_seconds,
                         bool cut_for_traffic,
-                        const valhalla::baldr::IncidentResult& incidents) {
+                        const valhalla::baldr::IncidentResult& incidents,
+                        const bool shape_attributes) {
   // TODO: if this is a transit edge then the costing will throw
 
   // bail if nothing to do
-  if (!cut_for_traffic && incidents.start_index == incidents.end_index &&
-      !controller.category_attribute_enabled(kShapeAttributesCategory)) {
+  if (!cut_for_traffic && incidents.start_index == incidents.end_index && !shape_attributes) {
     return;
   }
 
   // initialize shape_attributes once
-  if (!leg.has_shape_attributes() &&
-      controller.category_attribute_enabled(kShapeAttributesCategory)) {
+  if (!leg.has_shape_attributes() && shape_attributes) {
     leg.mutable_shape_attributes();
   }
 
@@ -775,6 +775,35 @@ void AddIntersectingEdges(const AttributesController& controller,
   }
 }
 
+/**
+ * Adds the elevation along the part of the edge used by the path, in the direction the path goes
+ * and at about the spacing of the samples of the profile stored with the edge. Nothing is added
+ * when the edge has no profile.
+ * @param trip_edge      the edge of the trip path
+ * @param profile        the elevation profile along the shape of the edge
+ * @param directededge   the directed edge, its shape goes the other way if it isnt forward
+ * @param start_pct      where the path enters the edge
+ * @param end_pct        where the path leaves the edge
+ */
+void AddElevation(TripLeg_Edge* trip_edge,
+                  const ElevationProfile& profile,
+                  const DirectedEdge* directededge,
+                  const double start_pct,
+                  const double end_pct) {
+  if (profile.empty()) {
+    return;
+  }
+  const double begin = directededge->forward() ? start_pct : 1.0 - start_pct;
+  const double end = directededge->forward() ? end_pct : 1.0 - end_pct;
+  const uint32_t count =
+      std::max<uint32_t>(2, std::ceil(std::abs(end - begin) * (profile.size() - 1)) + 1);
+  auto* elevation = trip_edge->mutable_elevation();
+  elevation->Reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    elevation->Add(profile.at(begin + (end - begin) * i / (count - 1)));
+  }
+}
+
 /**
  * Add trip edge. (TODO more comments)
  * @param  controller         Controller to determine which attributes to set.
@@ -791,6 +820,7 @@ void AddIntersectingEdges(const AttributesController& controller,
  * @param  start_node_idx     The start node index
  * @param  has_junction_name  True if named junction exists, false otherwise
  * @param  start_tile         The start tile of the start node
+ * @param  edge_signs         Whether any of the sign attributes were requested
  *
  */
 TripLeg_Edge* AddTripEdge(const AttributesController& controller,
@@ -809,7 +839,8 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
                           const bool has_junction_name,
                           const graph_tile_ptr& start_tile,
                           const uint8_t restrictions_idx,
-                          float elapsed_secs) {
+                          float elapsed_secs,
+                          const bool edge_signs) {
 
   // Index of the directed edge within the tile
   uint32_t idx = edge.id();
@@ -868,7 +899,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
 #endif
 
   // Set the signs (if the directed edge has sign information) and if requested
-  if (directededge->sign()) {
+  if (directededge->sign() && edge_signs) {
     // Add the edge signs
     std::unordered_map<uint32_t, std::pair<uint8_t, std::string>> pronunciations;
     std::vector<SignInfo> edge_signs = graphtile->GetSigns(idx, pronunciations);
@@ -879,7 +910,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   // Process the named junctions at nodes
-  if (has_junction_name && start_tile) {
+  if (has_junction_name && start_tile && edge_signs) {
     // Add the node signs
     std::unordered_map<uint32_t, std::pair<uint8_t, std::string>> pronunciations;
     std::vector<SignInfo> node_signs = start_tile->GetSigns(start_node_idx, pronunciations, true);
@@ -982,10 +1013,14 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   if (directededge->access_restriction() && restrictions_idx != kInvalidRestriction) {
-    const std::vector<baldr::AccessRestriction>& restrictions =
-        graphtile->GetAccessRestrictions(edge.id(), costing->access_mode());
-    trip_edge->mutable_restriction()->set_type(
-        static_cast<uint32_t>(restrictions[restrictions_idx].type()));
+    // the index counts only the restrictions for the access mode of the costing
+    uint32_t index = 0;
+    for (const auto& restriction : graphtile->access_restrictions(edge.id())) {
+      if ((restriction.modes() & costing->access_mode()) && index++ == restrictions_idx) {
+        trip_edge->mutable_restriction()->set_type(static_cast<uint32_t>(restriction.type()));
+        break;
+      }
+    }
   }
 
   trip_edge->set_has_time_restrictions(restrictions_idx != kInvalidRestriction);
@@ -1123,7 +1158,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   if (directededge->laneconnectivity() && controller(kEdgeLaneConnectivity)) {
-    auto laneconnectivity = graphtile->GetLaneConnectivity(idx);
+    const auto laneconnectivity = graphtile->lane_connections(idx);
     trip_edge->mutable_lane_connectivity()->Reserve(laneconnectivity.size());
     for (const auto& l : laneconnectivity) {
       TripLeg_LaneConnectivity* path_lane = trip_edge->add_lane_connectivity();
@@ -1467,6 +1502,16 @@ void TripLegBuilder::Build(
     tp_dest->set_side_of_street(GetTripLegSideOfStreet(end_sos));
   }
 
+  // Work out once which parts of the leg were requested so that a leg of little more than its shape
+  // skips the lookups of all the other parts on every edge
+  const bool edge_attributes = controller.category_attribute_enabled(kEdgeCategory);
+  const bool edge_signs = controller.category_attribute_enabled(kEdgeSignCategory);
+  const bool intersecting_edges =
+      controller.category_attribute_enabled(kNodeIntersectingEdgeCategory);
+  const bool shape_attributes = controller.category_attribute_enabled(kShapeAttributesCategory);
+  const bool with_incidents = controller(kIncidents);
+  const bool with_osmchangeset = controller(kOsmChangeset);
+
   // Structures to process admins
   std::unordered_map<AdminInfo, uint32_t, AdminInfo::AdminInfoHasher> admin_info_map;
   std::vector<AdminInfo> admin_info_list;
@@ -1511,7 +1556,7 @@ void TripLegBuilder::Build(
     }
     const NodeInfo* node = start_tile->node(startnode);
 
-    if (osmchangeset == 0 && controller(kOsmChangeset)) {
+    if (osmchangeset == 0 && with_osmchangeset) {
       osmchangeset = start_tile->header()->dataset_id();
     }
 
@@ -1573,12 +1618,15 @@ void TripLegBuilder::Build(
     multimodal_builder.Build(trip_node, edge_itr->trip_id, node, startnode, directededge, edge,
                              start_tile, graphtile, mode_costing, controller, graphreader);
 
-    // Add edge to the trip node and set its attributes
+    // Add edge to the trip node and set its attributes, if none were requested it stays empty
     TripLeg_Edge* trip_edge =
-        AddTripEdge(controller, edge, edge_itr->trip_id, multimodal_builder.block_id, mode,
-                    travel_type, costing, directededge, node->drive_on_right(), trip_node, graphtile,
-                    time_info, startnode.id(), node->named_intersection(), start_tile,
-                    edge_itr->restriction_index, edge_itr->elapsed_cost.secs);
+        edge_attributes
+            ? AddTripEdge(controller, edge, edge_itr->trip_id, multimodal_builder.block_id, mode,
+                          travel_type, costing, directededge, node->drive_on_right(), trip_node,
+                          graphtile, time_info, startnode.id(), node->named_intersection(),
+                          start_tile, edge_itr->restriction_index, edge_itr->elapsed_cost.secs,
+                          edge_signs)
+            : trip_node->mutable_edge();
 
     // some information regarding shape/length trimming
     float trim_start_pct = is_first_edge ? start_pct : 0;
@@ -1586,12 +1634,12 @@ void TripLegBuilder::Build(
 
     // Some edges at the beginning and end of the path and at intermediate locations will need trimmed
     uint32_t begin_index = is_first_edge ? 0 : trip_shape.size() - 1;
-    auto edgeinfo = graphtile->edgeinfo(directededge);
+    const auto& shape = graphreader.edge_shape(graphtile, directededge);
     auto trimming = edge_trimming.end();
     if (!edge_trimming.empty() &&
         (trimming = edge_trimming.find(edge_index)) != edge_trimming.end()) {
       // Get edge shape and reverse it if directed edge is not forward.
-      auto edge_shape = edgeinfo.shape();
+      auto edge_shape = shape;
       if (!directededge->forward()) {
         std::reverse(edge_shape.begin(), edge_shape.end());
       }
@@ -1638,7 +1686,7 @@ void TripLegBuilder::Build(
     } // We need to clip the shape if its at the beginning or end
     else if (is_first_edge || is_last_edge) {
       // Get edge shape and reverse it if directed edge is not forward.
-      auto edge_shape = edgeinfo.shape();
+      auto edge_shape = shape;
       if (!directededge->forward()) {
         std::reverse(edge_shape.begin(), edge_shape.end());
       }
@@ -1658,9 +1706,9 @@ void TripLegBuilder::Build(
     } // Just get the shape in there in the right direction no clipping needed
     else {
       if (directededge->forward()) {
-        trip_shape.insert(trip_shape.end(), edgeinfo.shape().begin() + 1, edgeinfo.shape().end());
+        trip_shape.insert(trip_shape.end(), shape.begin() + 1, shape.end());
       } else {
-        trip_shape.insert(trip_shape.end(), edgeinfo.shape().rbegin() + 1, edgeinfo.shape().rend());
+        trip_shape.insert(trip_shape.end(), shape.rbegin() + 1, shape.rend());
       }
     }
 
@@ -1669,6 +1717,12 @@ void TripLegBuilder::Build(
     trip_edge->set_source_along_edge(trim_start_pct);
     trip_edge->set_target_along_edge(trim_end_pct);
 
+    // Set the elevation along the part of the edge we used if requested
+    if (controller(kEdgeElevation)) {
+      AddElevation(trip_edge, graphtile->edgeinfo(directededge).elevation_profile(), directededge,
+                   trim_start_pct, trim_end_pct);
+    }
+
     // We need the total offset from the beginning of leg for the intermediate locations
     auto previous_total_distance = total_distance;
     total_distance += directededge->length() * (trim_end_pct - trim_start_pct);
@@ -1704,14 +1758,17 @@ void TripLegBuilder::Build(
       edge_seconds -= std::prev(edge_itr)->elapsed_cost.secs;
 
     // Set shape attributes, sending incidents enables them in the pbf
-    auto incidents = controller(kIncidents) ? graphreader.GetIncidents(edge_itr->edgeid, graphtile)
-                                            : valhalla::baldr::IncidentResult{};
-
-    graph_tile_ptr end_node_tile = graphtile;
-    graphreader.GetGraphTile(directededge->endnode(), end_node_tile);
-    SetShapeAttributes(controller, graphtile, end_node_tile, directededge, trip_shape, begin_index,
-                       trip_path, trim_start_pct, trim_end_pct, edge_seconds,
-                       costing->flow_mask() & kCurrentFlowMask, incidents);
+    auto incidents = with_incidents ? graphreader.GetIncidents(edge_itr->edgeid, graphtile)
+                                    : valhalla::baldr::IncidentResult{};
+
+    const bool cut_for_traffic = costing->flow_mask() & kCurrentFlowMask;
+    if (shape_attributes || cut_for_traffic || incidents.start_index != incidents.end_index) {
+      graph_tile_ptr end_node_tile = graphtile;
+      graphreader.GetGraphTile(directededge->endnode(), end_node_tile);
+      SetShapeAttributes(controller, graphtile, end_node_tile, directededge, trip_shape,
+                         begin_index, trip_path, trim_start_pct, trim_end_pct, edge_seconds,
+                         cut_for_traffic, incidents, shape_attributes);
+    }
 
     // Set begin shape index if requested
     if (controller(kEdgeBeginShapeIndex)) {
@@ -1729,7 +1786,7 @@ void TripLegBuilder::Build(
 
     // Add the intersecting edges at the node. Skip it if the node was an inner node (excluding start
     // node and end node) of a shortcut that was recovered.
-    if (startnode.Is_Valid() && !edge_itr->start_node_is_recovered) {
+    if (intersecting_edges && startnode.Is_Valid() && !edge_itr->start_node_is_recovered) {
       AddIntersectingEdges(controller, start_tile, node, directededge, prev_de, prior_opp_local_index,
                            graphreader, trip_node);
     }
@@ -1740,7 +1797,7 @@ void TripLegBuilder::Build(
     startnode = directededge->endnode();
 
     // Save the opposing edge as the previous DirectedEdge (for name consistency)
-    if (!directededge->IsTransitLine()) {
+    if (intersecting_edges && !directededge->IsTransitLine()) {
       graph_tile_ptr t2 =
           directededge->leaves_tile() ? graphreader.GetGraphTile(directededge->endnode()) : graphtile;
       if (t2 == nullptr) {
@@ -20,7 +20,7 @@ UnidirectionalAStar<expansion_direction, FORWARD>::UnidirectionalAStar(
                                          kInitialEdgeLabelCountAstar),
                     config.get<bool>("clear_reserved_memory", false)),
       max_label_count_(std::numeric_limits<uint32_t>::max()), mode_(travel_mode_t::kDrive),
-      travel_type_(0), access_mode_{kAutoAccess} {
+      travel_type_(0), hierarchy_pruned_(0), access_mode_{kAutoAccess} {
 }
 
 // Default constructor
@@ -34,17 +34,19 @@ template UnidirectionalAStar<ExpansionType::reverse>::UnidirectionalAStar(
 // Clear the temporary information generated during path construction.
 template <const ExpansionType expansion_direction, const bool FORWARD>
 void UnidirectionalAStar<expansion_direction, FORWARD>::Clear() {
+  label_reservation_.Record(LabelCount());
+
   // Clear the edge labels and destination list. Reset the adjacency list
   // and clear edge status.
   auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-  if (edgelabels_.size() > reservation) {
+  if (edgelabels_.capacity() > reservation) {
     edgelabels_.resize(reservation);
     edgelabels_.shrink_to_fit();
   }
   edgelabels_.clear();
   destinations_.clear();
   adjacencylist_.clear();
-  edgestatus_.clear();
+  edgestatus_.clear(reservation);
 
   // Set the ferry flag to false
   has_ferry_ = false;
@@ -116,10 +118,13 @@ bool UnidirectionalAStar<expansion_direction, FORWARD>::Expand(GraphReader& grap
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
       // if this is a downward transition (ups are always allowed) AND we are no longer allowed OR
       // we cant get the tile at that level (local extracts could have this problem) THEN bail
-      graph_tile_ptr trans_tile = nullptr;
-      if ((!trans->up() &&
-           hierarchy_limits_[trans->endnode().level()].StopExpanding(pred.distance())) ||
-          !(trans_tile = graphreader.GetGraphTile(trans->endnode()))) {
+      if (!trans->up() &&
+          hierarchy_limits_[trans->endnode().level()].StopExpanding(pred.distance())) {
+        ++hierarchy_pruned_;
+        continue;
+      }
+      graph_tile_ptr trans_tile = graphreader.GetGraphTile(trans->endnode());
+      if (!trans_tile) {
         continue;
       }
       // setup for expansion at this level
@@ -540,6 +545,7 @@ std::vector<std::vector<PathInfo>> UnidirectionalAStar<expansion_direction, FORW
     // Do not expand based on hierarchy level based on number of upward
     // transitions and distance to the destination
     if (hierarchy_limits_[pred.endnode().level()].StopExpanding(dist2dest)) {
+      ++hierarchy_pruned_;
       continue;
     }
 
@@ -584,18 +590,22 @@ void UnidirectionalAStar<expansion_direction, FORWARD>::Init(const midgard::Poin
     astarheuristic_.Init(origll, costing_->AStarCostFactor());
     mincost = astarheuristic_.Get(destll);
   }
-  edgelabels_.reserve(std::min(max_reserved_labels_count_, kInitialEdgeLabelCountAstar));
+  edgelabels_.reserve(
+      label_reservation_.Estimate(mode_, origll.Distance(destll),
+                                  std::min(max_reserved_labels_count_, kInitialEdgeLabelCountAstar),
+                                  max_reserved_labels_count_));
 
   // Construct adjacency list, clear edge status.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
   adjacencylist_.reuse(mincost, range, bucketsize, &edgelabels_);
-  edgestatus_.clear();
+  edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
 
   // Get hierarchy limits from the costing. Get a copy since we increment
   // transition counts (i.e., this is not a const reference).
   hierarchy_limits_ = costing_->GetHierarchyLimits();
+  hierarchy_pruned_ = 0;
 }
 
 // Modulate the hierarchy expansion within distance based on density at
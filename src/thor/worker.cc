@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <sstream>
@@ -10,6 +11,7 @@
 #include "midgard/logging.h"
 #include "midgard/util.h"
 #include "thor/isochrone.h"
+#include "thor/request_coalescer.h"
 #include "thor/worker.h"
 #include "tyr/actor.h"
 
@@ -57,6 +59,15 @@ std::string serialize_to_pbf(Api& request) {
   }
   return buf;
 };
+
+// The stats belong to the request that collected them so a cached route is serialized without them
+// and the stats of each request answered with it are appended. Concatenated messages are merged
+// when parsed
+std::string take_stats_pbf(Api& request) {
+  Api stats;
+  stats.mutable_info()->mutable_statistics()->Swap(request.mutable_info()->mutable_statistics());
+  return serialize_to_pbf(stats);
+}
 #endif
 
 } // namespace
@@ -68,13 +79,20 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
                              const std::shared_ptr<baldr::GraphReader>& graph_reader)
     : service_worker_t(config), mode(valhalla::sif::TravelMode::kPedestrian),
       bidir_astar(config.get_child("thor")), bss_astar(config.get_child("thor")),
-      multi_modal_astar(config.get_child("thor")), timedep_forward(config.get_child("thor")),
+      bss_bidir_astar(config.get_child("thor")),
+      multi_modal_astar(config.get_child("thor")), connection_scan(config.get_child("thor")),
+      timedep_forward(config.get_child("thor")),
       timedep_reverse(config.get_child("thor")), costmatrix_(config.get_child("thor")),
       time_distance_matrix_(config.get_child("thor")),
       time_distance_bss_matrix_(config.get_child("thor")), isochrone_gen(config.get_child("thor")),
       reader(graph_reader ? graph_reader
                           : std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"))),
-      matcher_factory(config, reader), controller{} {
+      matcher_factory(config, reader), controller{}, centroid_gen(config.get_child("thor")),
+      response_cache(config.get<size_t>("thor.response_cache_size", 0),
+                     config.get<uint32_t>("thor.response_cache_ttl", 0)),
+      search_trees(config.get<size_t>("thor.search_tree_cache_size", 0),
+                   config.get<uint32_t>("thor.search_tree_ttl", 0)),
+      coalesce_requests(config.get<bool>("thor.coalesce_requests", true)) {
 
   // Select the matrix algorithm based on the conf file (defaults to
   // select_optimal if not present)
@@ -85,7 +103,9 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
         kv.first == "max_timedep_distance_matrix" || kv.first == "max_alternates" ||
         kv.first == "max_exclude_polygons_length" || kv.first == "skadi" || kv.first == "trace" ||
         kv.first == "isochrone" || kv.first == "centroid" || kv.first == "status" ||
-        kv.first == "max_distance_disable_hierarchy_culling") {
+        kv.first == "max_distance_disable_hierarchy_culling" ||
+        kv.first == "max_matrix_departure_times" || kv.first == "max_expansion_edges" ||
+        kv.first == "max_comparisons") {
       continue;
     }
 
@@ -103,6 +123,66 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
 
   max_timedep_distance =
       config.get<float>("service_limits.max_timedep_distance", kDefaultMaxTimeDependentDistance);
+  bidirectional_timedep_distance =
+      config.get<float>("thor.bidirectional_timedep_distance", max_timedep_distance);
+  max_expansion_edges = config.get<uint32_t>("service_limits.max_expansion_edges", 0);
+  use_connection_scan =
+      config.get<std::string>("thor.multimodal_algorithm", "astar") == "connection_scan";
+  use_bidirectional_bss =
+      config.get<std::string>("thor.bikeshare_algorithm", "astar") == "bidirectional_astar";
+
+  // the distances of the nodes from the landmarks the tile build wrote tighten the A* heuristic
+  bidir_astar.set_landmarks(
+      baldr::LandmarkDistances::Map(config.get<std::string>("mjolnir.landmarks", "")));
+  matrix_table = MatrixTable::Map(config.get<std::string>("thor.matrix_table", ""));
+
+  optimizer_threads = config.get<uint32_t>("thor.optimizer_threads", 1);
+  optimizer_max_time = config.get<uint32_t>("thor.optimizer_max_time", 1000);
+  max_reserved_algorithms = config.get<size_t>("thor.max_reserved_algorithms", 0);
+  allow_verbose = config.get<bool>("service_limits.status.allow_verbose", false);
+
+  // Extra matrix threads need readers of their own, these share the process wide tile cache
+  auto matrix_threads = config.get<uint32_t>("thor.matrix_threads", 1);
+  if (matrix_threads > 1) {
+    auto reader_config = config.get_child("mjolnir");
+    reader_config.put("global_synchronized_cache", true);
+    for (uint32_t i = 1; i < matrix_threads; ++i) {
+      matrix_readers.emplace_back(std::make_shared<baldr::GraphReader>(reader_config));
+    }
+    time_distance_matrix_.set_thread_readers(matrix_readers);
+    costmatrix_.set_thread_readers(matrix_readers);
+    centroid_gen.set_thread_readers(matrix_readers);
+  }
+
+  // Extra threads for the legs of an optimized route or the locations of per location isochrones
+  // need workers of their own (path algorithms, costing and reader), these also share the process
+  // wide tile cache
+  auto leg_threads = config.get<uint32_t>("thor.optimized_route_threads", 1);
+  if (leg_threads > 1) {
+    auto leg_config = config;
+    leg_config.erase("statsd");
+    leg_config.put("mjolnir.global_synchronized_cache", true);
+    leg_config.put("thor.matrix_threads", 1);
+    leg_config.put("thor.optimized_route_threads", 1);
+    leg_config.put("thor.response_cache_size", 0);
+    leg_config.put("thor.search_tree_cache_size", 0);
+    leg_config.put("thor.matrix_table", "");
+    leg_config.get_child("mjolnir").erase("warmup");
+    for (uint32_t i = 1; i < leg_threads; ++i) {
+      leg_workers.emplace_back(new thor_worker_t(leg_config));
+    }
+  }
+
+  // live traffic changes the answers so forget them when traffic changes
+  if (config.get<size_t>("thor.response_cache_size", 0)) {
+    reader->AddTrafficObserver([this](const std::vector<GraphId>&) { response_cache.clear(); });
+  }
+  if (config.get<size_t>("thor.search_tree_cache_size", 0)) {
+    reader->AddTrafficObserver([this](const std::vector<GraphId>&) { search_trees.clear(); });
+  }
+
+  // read the busy tiles before taking any traffic
+  warm_up(*reader, config, service_name());
 
   // signal that the worker started successfully
   started();
@@ -120,7 +200,7 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
   // get request info and make sure to record any metrics before we are done
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Thor Request " + std::to_string(info.id));
-  Api request;
+  Api& request = api_arena.next();
   prime_server::worker_t::result_t result{true, {}, {}};
   try {
     // crack open the original request
@@ -131,27 +211,67 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
     }
     const auto& options = request.options();
 
-    // Set the interrupt function
-    service_worker_t::set_interrupt(&interrupt_function);
+    // Set the interrupt function, it also stops the request at its deadline
+    service_worker_t::set_interrupt(watch_deadline(request, &interrupt_function, 446));
+
+    // identical requests are answered from the cache, after any traffic updates have cleared it
+    const auto count_hit = [&](const std::string& stat) {
+      auto* hit = request.mutable_info()->mutable_statistics()->Add();
+      hit->set_key(Options_Action_Enum_Name(options.action()) + ".info.thor." + stat);
+      hit->set_value(1);
+      hit->set_type(count);
+    };
+    std::string cache_key;
+    const std::string* cached = nullptr;
+    const bool cacheable = response_cache.cacheable(request);
+    if (cacheable) {
+      reader->PollTrafficUpdates();
+      cache_key = ResponseCache::key(request);
+      cached = response_cache.find(cache_key);
+      if (cached)
+        count_hit("response_cache_hit");
+    }
+
+    // or else share the response of an identical request in flight at the same time
+    const bool coalesce = coalesce_requests && !cached && RequestCoalescer::coalescable(request);
+    if (coalesce && cache_key.empty())
+      cache_key = ResponseCache::key(request);
+    const auto respond = [&](const std::function<std::string()>& action) -> std::string {
+      if (cached)
+        return *cached;
+      bool shared = false;
+      auto response =
+          coalesce ? RequestCoalescer::share(cache_key, action, interrupt, shared) : action();
+      if (shared)
+        count_hit("coalesced");
+      if (cacheable)
+        response_cache.insert(cache_key, response);
+      return response;
+    };
 
     // do request specific processing
     switch (options.action()) {
       case Options::sources_to_targets:
-        result = to_response(matrix(request), info, request);
+        result = to_response(respond([&]() { return matrix(request); }), info, request);
         break;
-      case Options::optimized_route: {
-        optimized_route(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+      case Options::optimized_route:
+      case Options::route: {
+        // the stats belong to this request, the route is cached and shared without them
+        std::string stats;
+        auto response = respond([&]() {
+          if (options.action() == Options::route)
+            route(request);
+          else
+            optimized_route(request);
+          stats = take_stats_pbf(request);
+          return serialize_to_pbf(request);
+        });
+        result.messages.emplace_back(response + (stats.empty() ? take_stats_pbf(request) : stats));
         break;
       }
       case Options::isochrone:
-        result = to_response(isochrones(request), info, request);
+        result = to_response(respond([&]() { return isochrones(request); }), info, request);
         break;
-      case Options::route: {
-        route(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
-        break;
-      }
       case Options::trace_route: {
         trace_route(request);
         result.messages.emplace_back(serialize_to_pbf(request));
@@ -311,22 +431,73 @@ void thor_worker_t::cleanup() {
   timedep_forward.Clear();
   timedep_reverse.Clear();
   multi_modal_astar.Clear();
+  connection_scan.Clear();
   bss_astar.Clear();
+  bss_bidir_astar.Clear();
   trace.clear();
   costmatrix_.clear();
   time_distance_matrix_.clear();
   time_distance_bss_matrix_.clear();
   isochrone_gen.Clear();
   centroid_gen.Clear();
+  // only the most recently used algorithms keep what they reserved for their next search
+  while (used_algorithms.size() > max_reserved_algorithms) {
+    used_algorithms.front().second();
+    used_algorithms.pop_front();
+  }
   matcher_factory.ClearFullCache();
+  // in between requests is when a replaced extract can be switched to
+  reader->UpdateExtract();
   if (reader->OverCommitted()) {
     reader->Trim();
   }
+  for (auto& matrix_reader : matrix_readers) {
+    matrix_reader->UpdateExtract();
+    if (matrix_reader->OverCommitted()) {
+      matrix_reader->Trim();
+    }
+  }
+  for (auto& leg_worker : leg_workers) {
+    leg_worker->cleanup();
+  }
+}
+
+void thor_worker_t::mark_used(PathAlgorithm& algorithm) {
+  mark_used(&algorithm, [&algorithm]() { algorithm.Release(); });
+}
+
+void thor_worker_t::mark_used(Dijkstras& algorithm) {
+  mark_used(&algorithm, [&algorithm]() { algorithm.Release(); });
+}
+
+void thor_worker_t::mark_used(TimeDistanceMatrix& algorithm) {
+  mark_used(&algorithm, [&algorithm]() { algorithm.release(); });
+}
+
+void thor_worker_t::mark_used(TimeDistanceBSSMatrix& algorithm) {
+  mark_used(&algorithm, [&algorithm]() { algorithm.release(); });
+}
+
+void thor_worker_t::mark_used(const void* algorithm, std::function<void()> release) {
+  if (!max_reserved_algorithms) {
+    return;
+  }
+  // move it to the back if it was used before, otherwise add it there
+  auto used = std::find_if(used_algorithms.begin(), used_algorithms.end(),
+                           [algorithm](const auto& used) { return used.first == algorithm; });
+  if (used != used_algorithms.end()) {
+    used_algorithms.splice(used_algorithms.end(), used_algorithms, used);
+  } else {
+    used_algorithms.emplace_back(algorithm, std::move(release));
+  }
 }
 
 void thor_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
   interrupt = interrupt_function;
   reader->SetInterrupt(interrupt);
+  for (auto& matrix_reader : matrix_readers) {
+    matrix_reader->SetInterrupt(interrupt);
+  }
 }
 } // namespace thor
 } // namespace valhalla
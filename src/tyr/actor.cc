@@ -1,10 +1,18 @@
 #include "tyr/actor.h"
 #include "baldr/rapidjson_utils.h"
 #include "loki/worker.h"
+#include "midgard/executor.h"
 #include "odin/worker.h"
+#include "sif/costfactory.h"
+#include "sif/recost.h"
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 using namespace valhalla;
 using namespace valhalla::loki;
 using namespace valhalla::thor;
@@ -15,12 +23,25 @@ namespace tyr {
 
 struct actor_t::pimpl_t {
   pimpl_t(const boost::property_tree::ptree& config)
-      : reader(new baldr::GraphReader(config.get_child("mjolnir"))), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+      : config(config), reader(new baldr::GraphReader(config.get_child("mjolnir"))),
+        loki_worker(config, reader), thor_worker(config, reader), odin_worker(config) {
   }
   pimpl_t(const boost::property_tree::ptree& config, baldr::GraphReader& graph_reader)
-      : reader(&graph_reader, [](baldr::GraphReader*) {}), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+      : config(config), reader(&graph_reader, [](baldr::GraphReader*) {}),
+        loki_worker(config, reader), thor_worker(config, reader), odin_worker(config) {
+  }
+  // the batch threads get actors of their own on the global synchronized tile cache
+  std::vector<std::shared_ptr<actor_t>>& batch_actors() {
+    if (batch_actors_.empty()) {
+      auto batch_config = config;
+      batch_config.put("mjolnir.global_synchronized_cache", true);
+      auto threads = std::max(1u, config.get<uint32_t>("meili.batch_threads",
+                                                       std::thread::hardware_concurrency()));
+      for (uint32_t i = 0; i < threads; ++i) {
+        batch_actors_.emplace_back(std::make_shared<actor_t>(batch_config, true));
+      }
+    }
+    return batch_actors_;
   }
   void set_interrupts(const std::function<void()>* interrupt_function) {
     loki_worker.set_interrupt(interrupt_function);
@@ -31,11 +52,15 @@ struct actor_t::pimpl_t {
     loki_worker.cleanup();
     thor_worker.cleanup();
     odin_worker.cleanup();
+    api_arena.reset();
   }
+  boost::property_tree::ptree config;
   std::shared_ptr<baldr::GraphReader> reader;
   loki::loki_worker_t loki_worker;
   thor::thor_worker_t thor_worker;
   odin_worker_t odin_worker;
+  api_arena_t api_arena;
+  std::vector<std::shared_ptr<actor_t>> batch_actors_;
 };
 
 actor_t::actor_t(const boost::property_tree::ptree& config, bool auto_cleanup)
@@ -89,10 +114,9 @@ std::string
 actor_t::route(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::route, *api);
@@ -113,10 +137,9 @@ std::string
 actor_t::locate(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::locate, *api);
@@ -133,10 +156,9 @@ std::string
 actor_t::matrix(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::sources_to_targets, *api);
@@ -156,10 +178,9 @@ std::string actor_t::optimized_route(const std::string& request_str,
                                      Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::optimized_route, *api);
@@ -180,10 +201,9 @@ std::string
 actor_t::isochrone(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::isochrone, *api);
@@ -203,10 +223,9 @@ std::string actor_t::trace_route(const std::string& request_str,
                                  Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::trace_route, *api);
@@ -228,10 +247,9 @@ std::string actor_t::trace_attributes(const std::string& request_str,
                                       Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::trace_attributes, *api);
@@ -246,14 +264,126 @@ std::string actor_t::trace_attributes(const std::string& request_str,
   return json;
 }
 
+void actor_t::trace_attributes(const std::vector<std::string>& requests,
+                               const std::function<void(size_t, const std::string&)>& callback,
+                               const std::function<void()>* interrupt) {
+  auto& actors = pimpl->batch_actors();
+  std::atomic<size_t> next_request(0);
+  std::mutex callback_lock;
+  std::exception_ptr exception;
+
+  // each thread takes the next trace until they are all done
+  auto work = [&](actor_t& actor) {
+    try {
+      for (size_t i = next_request++; i < requests.size(); i = next_request++) {
+        Api api;
+        std::string result;
+        try {
+          result = actor.trace_attributes(requests[i], interrupt, &api);
+        } catch (const valhalla_exception_t& e) {
+          actor.cleanup();
+          result = serialize_error(e, api);
+        } catch (const std::exception& e) {
+          actor.cleanup();
+          result = serialize_error({499, std::string(e.what())}, api);
+        }
+        std::lock_guard<std::mutex> lock(callback_lock);
+        callback(i, result);
+      }
+    } catch (...) {
+      // anything else (interrupt or the callback) stops the whole batch
+      actor.cleanup();
+      std::lock_guard<std::mutex> lock(callback_lock);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      next_request = requests.size();
+    }
+  };
+
+  // no point in more threads than traces, this thread takes the first actor and idle threads of
+  // the shared pool the others
+  midgard::executor_t::shared().run(std::min(actors.size(), requests.size()),
+                                    [&](uint32_t slot) { work(*actors[slot]); });
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void actor_t::recost(
+    const std::vector<std::vector<baldr::GraphId>>& paths,
+    const std::vector<Costing>& costings,
+    const std::function<void(size_t, size_t, const std::vector<sif::Cost>&)>& callback,
+    const std::function<void()>* interrupt) {
+  // the costings only get read so all the threads can share them
+  sif::CostFactory factory;
+  std::vector<sif::cost_ptr_t> costs;
+  costs.reserve(costings.size());
+  for (const auto& costing : costings) {
+    costs.emplace_back(factory.Create(costing));
+  }
+
+  auto& actors = pimpl->batch_actors();
+  std::atomic<size_t> next_path(0);
+  std::mutex callback_lock;
+  std::exception_ptr exception;
+
+  // each thread takes the next path until they are all done
+  auto work = [&](actor_t& actor) {
+    auto& reader = *actor.pimpl->reader;
+    std::vector<sif::Cost> elapsed;
+    try {
+      for (size_t i = next_path++; i < paths.size(); i = next_path++) {
+        if (interrupt) {
+          (*interrupt)();
+        }
+        for (size_t j = 0; j < costs.size(); ++j) {
+          auto edge = paths[i].cbegin();
+          elapsed.clear();
+          try {
+            sif::recost_forward(
+                reader, *costs[j],
+                [&]() { return edge == paths[i].cend() ? baldr::GraphId{} : *edge++; },
+                [&](const sif::EdgeLabel& label) { elapsed.push_back(label.cost()); });
+          } catch (const std::runtime_error&) {
+            // the costing can't get through this path
+            elapsed.clear();
+          }
+          std::lock_guard<std::mutex> lock(callback_lock);
+          callback(i, j, elapsed);
+        }
+        if (reader.OverCommitted()) {
+          reader.Trim();
+        }
+      }
+    } catch (...) {
+      // anything else (interrupt or the callback) stops the whole batch
+      std::lock_guard<std::mutex> lock(callback_lock);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      next_path = paths.size();
+    }
+  };
+
+  // no point in more threads than paths, this thread takes the first actor and idle threads of
+  // the shared pool the others
+  midgard::executor_t::shared().run(std::min(actors.size(), paths.size()),
+                                    [&](uint32_t slot) { work(*actors[slot]); });
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
 std::string
 actor_t::height(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::height, *api);
@@ -271,10 +401,9 @@ std::string actor_t::transit_available(const std::string& request_str,
                                        Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::transit_available, *api);
@@ -291,10 +420,9 @@ std::string
 actor_t::expansion(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::expansion, *api);
@@ -317,10 +445,9 @@ std::string
 actor_t::centroid(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::centroid, *api);
@@ -341,10 +468,9 @@ std::string
 actor_t::status(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
-  // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
+  // if the caller doesn't want a copy we'll use one from the arena
   if (!api) {
-    api = &dummy;
+    api = &pimpl->api_arena.next();
   }
   // parse the request
   ParseApi(request_str, Options::status, *api);
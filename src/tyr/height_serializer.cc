@@ -1,6 +1,5 @@
-#include <sstream>
+#include <cmath>
 
-#include "baldr/json.h"
 #include "skadi/sample.h"
 #include "tyr/serializers.h"
 
@@ -10,51 +9,63 @@ using namespace valhalla::baldr;
 
 namespace {
 
-json::ArrayPtr serialize_range_height(const std::vector<double>& ranges,
-                                      const std::vector<double>& heights,
-                                      const uint32_t precision,
-                                      const double no_data_value) {
-  auto array = json::array({});
+// heights are written with a fixed number of decimals, without any when the precision is 0
+void serialize_posting(const double height,
+                       const uint32_t precision,
+                       const double no_data_value,
+                       rapidjson::writer_wrapper_t& writer) {
+  if (height == no_data_value) {
+    writer(nullptr);
+  } else if (precision == 0) {
+    writer(static_cast<int64_t>(std::round(height)));
+  } else {
+    const double scale = std::pow(10.0, precision);
+    writer(std::round(height * scale) / scale);
+  }
+}
+
+void serialize_range_height(const std::vector<double>& ranges,
+                            const std::vector<double>& heights,
+                            const uint32_t precision,
+                            const double no_data_value,
+                            rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("range_height");
   // for each posting
   auto range = ranges.cbegin();
 
   for (const auto height : heights) {
-    auto element = json::array({json::fixed_t{*range, 0}});
-    if (height == no_data_value) {
-      element->push_back(nullptr);
-    } else {
-      element->push_back({json::fixed_t{height, precision}});
-    }
-    array->push_back(element);
+    writer.start_array();
+    writer(static_cast<int64_t>(std::round(*range)));
+    serialize_posting(height, precision, no_data_value, writer);
+    writer.end_array();
     ++range;
   }
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_height(const std::vector<double>& heights,
-                                const uint32_t precision,
-                                const double no_data_value) {
-  auto array = json::array({});
-
+void serialize_height(const std::vector<double>& heights,
+                      const uint32_t precision,
+                      const double no_data_value,
+                      rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("height");
   for (const auto height : heights) {
     // add all heights's to an array
-    if (height == no_data_value) {
-      array->push_back(nullptr);
-    } else {
-      array->push_back({json::fixed_t{height, precision}});
-    }
+    serialize_posting(height, precision, no_data_value, writer);
   }
-
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
-  auto array = json::array({});
+void serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape,
+                     rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("shape");
+  writer.set_precision(6);
   for (const auto& p : shape) {
-    array->emplace_back(json::map(
-        {{"lon", json::fixed_t{p.ll().lng(), 6}}, {"lat", json::fixed_t{p.ll().lat(), 6}}}));
+    writer.start_object();
+    writer("lat", p.ll().lat());
+    writer("lon", p.ll().lng());
+    writer.end_object();
   }
-  return array;
+  writer.end_array();
 }
 
 } // namespace
@@ -68,40 +79,50 @@ namespace tyr {
   "range_height": [ [0,303], [8467,275], [25380,198] ]
 }
 */
-std::string serializeHeight(const Api& request,
+std::string serializeHeight(Api& request,
                             const std::vector<double>& heights,
                             const std::vector<double>& ranges) {
-  auto json = json::map({});
+  // the pbf gets the raw heights and ranges, the shape is in the options already
+  if (request.options().format() == Options::pbf) {
+    auto& height = *request.mutable_height();
+    height.mutable_heights()->Add(heights.begin(), heights.end());
+    height.mutable_ranges()->Add(ranges.begin(), ranges.end());
+    return serializePbf(request);
+  }
+
+  // stream the json straight into a buffer, reserve 4k bytes
+  rapidjson::writer_wrapper_t writer(4096);
+  writer.start_object();
+
+  // send back the shape first
+  if (request.options().has_encoded_polyline_case()) {
+    writer("encoded_polyline", request.options().encoded_polyline());
+  } else {
+    serialize_shape(request.options().shape(), writer);
+  }
 
   // get the precision to use for returned heights
   uint32_t precision = request.options().height_precision();
+  writer.set_precision(precision);
 
   // get the distances between the postings
   if (ranges.size()) {
-    json = json::map({{"range_height", serialize_range_height(ranges, heights, precision,
-                                                              skadi::get_no_data_value())}});
+    serialize_range_height(ranges, heights, precision, skadi::get_no_data_value(), writer);
   } // just the postings
   else {
-    json = json::map({{"height", serialize_height(heights, precision, skadi::get_no_data_value())}});
-  }
-  // send back the shape as well
-  if (request.options().has_encoded_polyline_case()) {
-    json->emplace("encoded_polyline", request.options().encoded_polyline());
-  } else {
-    json->emplace("shape", serialize_shape(request.options().shape()));
+    serialize_height(heights, precision, skadi::get_no_data_value(), writer);
   }
   if (request.options().has_id_case()) {
-    json->emplace("id", request.options().id());
+    writer("id", request.options().id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    json->emplace("warnings", serializeWarnings(request));
+    serializeWarnings(request, writer);
   }
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_object();
+  return writer.get_buffer();
 }
 } // namespace tyr
 } // namespace valhalla
@@ -4,6 +4,7 @@
 #include "midgard/pointll.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <utility>
@@ -12,16 +13,63 @@ using namespace valhalla::baldr::json;
 
 namespace {
 using rgba_t = std::tuple<float, float, float>;
+using intervals_t = std::vector<valhalla::midgard::GriddedData<2>::contour_interval_t>;
+using contours_t = valhalla::midgard::GriddedData<2>::contours_t;
+
+// Fill out the contours of the response, the pbf is serialized from the whole Api object
+void serialize_pbf(valhalla::Api& request,
+                   const intervals_t& intervals,
+                   const contours_t& contours,
+                   const std::vector<uint32_t>& interval_locations) {
+  using valhalla::Isochrone;
+  auto& isochrone = *request.mutable_isochrone();
+  for (size_t contour_index = 0; contour_index < intervals.size(); ++contour_index) {
+    const auto& interval = intervals[contour_index];
+    auto* pbf_interval = isochrone.add_intervals();
+    pbf_interval->set_metric(std::get<2>(interval) == "time" ? Isochrone::Interval::time
+                                                             : Isochrone::Interval::distance);
+    pbf_interval->set_threshold(std::get<1>(interval));
+    pbf_interval->set_color(std::get<3>(interval));
+    if (!interval_locations.empty()) {
+      pbf_interval->set_location_index(interval_locations[contour_index]);
+    }
+
+    // each feature is a contour made up of one or more rings (or a line)
+    for (const auto& feature : contours[contour_index]) {
+      auto* pbf_contour = pbf_interval->add_contours();
+      for (const auto& ring : feature) {
+        auto* coords = pbf_contour->add_geometries()->mutable_coords();
+        coords->Reserve(ring.size() * 2);
+        for (const auto& coord : ring) {
+          coords->Add(static_cast<int32_t>(std::round(coord.first * 1e6)));
+          coords->Add(static_cast<int32_t>(std::round(coord.second * 1e6)));
+        }
+      }
+    }
+  }
 }
+} // namespace
 
 namespace valhalla {
 namespace tyr {
 
-std::string serializeIsochrones(const Api& request,
+std::string serializeIsochrones(Api& request,
                                 std::vector<midgard::GriddedData<2>::contour_interval_t>& intervals,
                                 midgard::GriddedData<2>::contours_t& contours,
                                 bool polygons,
-                                bool show_locations) {
+                                bool show_locations,
+                                const std::vector<uint32_t>& interval_locations) {
+  if (request.options().format() == Options::pbf) {
+    serialize_pbf(request, intervals, contours, interval_locations);
+    return serializePbf(request);
+  }
+
+  // the colors are picked for the intervals of each location
+  const size_t location_intervals =
+      interval_locations.empty() ? intervals.size()
+                                 : std::count(interval_locations.begin(), interval_locations.end(),
+                                              interval_locations.front());
+
   // for each contour interval
   int i = 0;
   auto features = array({});
@@ -36,7 +84,7 @@ std::string serializeIsochrones(const Api& request,
       hex << "#" << std::get<3>(interval);
     } // or we computed it..
     else {
-      auto h = i * (150.f / intervals.size());
+      auto h = (i % location_intervals) * (150.f / location_intervals);
       auto c = .5f;
       auto x = c * (1 - std::abs(std::fmod(h / 60.f, 2.f) - 1));
       auto m = .25f;
@@ -67,22 +115,27 @@ std::string serializeIsochrones(const Api& request,
         }
       }
       // add a feature
+      auto properties = map({
+          {"metric", std::get<2>(interval)},
+          {"contour", baldr::json::float_t{std::get<1>(interval)}},
+          {"color", hex.str()},               // lines
+          {"fill", hex.str()},                // geojson.io polys
+          {"fillColor", hex.str()},           // leaflet polys
+          {"opacity", fixed_t{.33f, 2}},      // lines
+          {"fill-opacity", fixed_t{.33f, 2}}, // geojson.io polys
+          {"fillOpacity", fixed_t{.33f, 2}},  // leaflet polys
+      });
+      if (!interval_locations.empty()) {
+        properties->emplace("location_index",
+                            static_cast<uint64_t>(interval_locations[contour_index]));
+      }
       features->emplace_back(map({
           {"type", std::string("Feature")},
           {"geometry", map({
                            {"type", std::string(polygons ? "Polygon" : "LineString")},
                            {"coordinates", geom},
                        })},
-          {"properties", map({
-                             {"metric", std::get<2>(interval)},
-                             {"contour", baldr::json::float_t{std::get<1>(interval)}},
-                             {"color", hex.str()},               // lines
-                             {"fill", hex.str()},                // geojson.io polys
-                             {"fillColor", hex.str()},           // leaflet polys
-                             {"opacity", fixed_t{.33f, 2}},      // lines
-                             {"fill-opacity", fixed_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fixed_t{.33f, 2}},  // leaflet polys
-                         })},
+          {"properties", properties},
       }));
     }
   }
@@ -132,6 +185,49 @@ std::string serializeIsochrones(const Api& request,
     feature_collection->emplace("id", request.options().id());
   }
 
+  // the nearest location of each cell as a raster
+  if (request.has_isochrone() && request.isochrone().has_catchments()) {
+    const auto& catchments = request.isochrone().catchments();
+    auto locations = array({});
+    locations->reserve(catchments.locations_size());
+    for (auto location : catchments.locations()) {
+      locations->emplace_back(static_cast<int64_t>(location));
+    }
+    feature_collection->emplace("catchments",
+                                map({
+                                    {"min_lon", fixed_t{catchments.min_lon(), 6}},
+                                    {"min_lat", fixed_t{catchments.min_lat(), 6}},
+                                    {"cell_size", fixed_t{catchments.cell_size(), 6}},
+                                    {"columns", static_cast<uint64_t>(catchments.columns())},
+                                    {"rows", static_cast<uint64_t>(catchments.rows())},
+                                    {"locations", locations},
+                                }));
+  }
+
+  // the time and distance to each cell instead of contours
+  if (request.has_isochrone() && request.isochrone().has_raster()) {
+    const auto& raster = request.isochrone().raster();
+    auto times = array({});
+    times->reserve(raster.times_size());
+    for (auto time : raster.times()) {
+      times->emplace_back(fixed_t{time, 2});
+    }
+    auto distances = array({});
+    distances->reserve(raster.distances_size());
+    for (auto distance : raster.distances()) {
+      distances->emplace_back(fixed_t{distance, 2});
+    }
+    feature_collection->emplace("raster", map({
+                                              {"min_lon", fixed_t{raster.min_lon(), 6}},
+                                              {"min_lat", fixed_t{raster.min_lat(), 6}},
+                                              {"cell_size", fixed_t{raster.cell_size(), 6}},
+                                              {"columns", static_cast<uint64_t>(raster.columns())},
+                                              {"rows", static_cast<uint64_t>(raster.rows())},
+                                              {"times", times},
+                                              {"distances", distances},
+                                          }));
+  }
+
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
     feature_collection->emplace("warnings", serializeWarnings(request));
@@ -2,6 +2,7 @@
 #include "baldr/openlr.h"
 #include "tyr/serializers.h"
 #include <cstdint>
+#include <sstream>
 
 using namespace valhalla;
 using namespace valhalla::midgard;
@@ -52,8 +53,23 @@ linear_reference(const baldr::DirectedEdge* de, float percent_along, const EdgeI
       .toBase64();
 }
 
-json::ArrayPtr serialize_edges(const PathLocation& location, GraphReader& reader, bool verbose) {
-  auto array = json::array({});
+// the graph objects only know how to build json trees, those are written as is
+template <class T> std::string to_json(const T& json) {
+  std::stringstream ss;
+  ss << *json;
+  return ss.str();
+}
+
+const char* side_of_street(const PathLocation::PathEdge& edge) {
+  return edge.sos == PathLocation::LEFT ? "left"
+                                        : (edge.sos == PathLocation::RIGHT ? "right" : "neither");
+}
+
+void serialize_edges(const PathLocation& location,
+                     GraphReader& reader,
+                     bool verbose,
+                     rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("edges");
   for (const auto& edge : location.edges) {
     try {
       // get the osm way id
@@ -64,64 +80,70 @@ json::ArrayPtr serialize_edges(const PathLocation& location, GraphReader& reader
       if (verbose) {
         // live traffic information
         const volatile auto& traffic = tile->trafficspeed(directed_edge);
-        auto live_speed = traffic.json();
 
         // incident information
         if (traffic.has_incidents) {
           // TODO: incidents
         }
 
+        // basic rest of it plus edge metadata
+        auto reference = linear_reference(directed_edge, edge.percent_along, edge_info);
+        writer.start_object();
+        writer.set_precision(6);
+        writer("correlated_lat", edge.projected.lat());
+        writer("correlated_lon", edge.projected.lng());
+        writer("side_of_street", side_of_street(edge));
+        writer.set_precision(5);
+        writer("percent_along", edge.percent_along);
+        writer.set_precision(1);
+        writer("distance", edge.distance);
+        writer("heading", edge.projected_heading);
+        writer("outbound_reach", static_cast<int64_t>(edge.outbound_reach));
+        writer("inbound_reach", static_cast<int64_t>(edge.inbound_reach));
+        writer.start_object("edge_id");
+        writer("level", static_cast<uint64_t>(edge.id.level()));
+        writer("tile_id", static_cast<uint64_t>(edge.id.tileid()));
+        writer("id", static_cast<uint64_t>(edge.id.id()));
+        writer("value", static_cast<uint64_t>(edge.id.value));
+        writer.end_object();
+        writer.raw("edge", to_json(directed_edge->json()));
+        writer.raw("edge_info", to_json(edge_info.json()));
+        writer("linear_reference", reference);
+
         // historical traffic information
-        auto predicted_speeds = json::array({});
+        writer.start_array("predicted_speeds");
         if (directed_edge->has_predicted_speed()) {
           for (auto sec = 0; sec < midgard::kSecondsPerWeek; sec += 5 * midgard::kSecPerMinute) {
-            predicted_speeds->emplace_back(
-                static_cast<uint64_t>(tile->GetSpeed(directed_edge, kPredictedFlowMask, sec)));
+            writer(static_cast<uint64_t>(tile->GetSpeed(directed_edge, kPredictedFlowMask, sec)));
           }
         }
-
-        // basic rest of it plus edge metadata
-        array->emplace_back(json::map({
-            {"correlated_lat", json::fixed_t{edge.projected.lat(), 6}},
-            {"correlated_lon", json::fixed_t{edge.projected.lng(), 6}},
-            {"side_of_street",
-             edge.sos == PathLocation::LEFT
-                 ? std::string("left")
-                 : (edge.sos == PathLocation::RIGHT ? std::string("right") : std::string("neither"))},
-            {"percent_along", json::fixed_t{edge.percent_along, 5}},
-            {"distance", json::fixed_t{edge.distance, 1}},
-            {"heading", json::fixed_t{edge.projected_heading, 1}},
-            {"outbound_reach", static_cast<int64_t>(edge.outbound_reach)},
-            {"inbound_reach", static_cast<int64_t>(edge.inbound_reach)},
-            {"edge_id", edge.id.json()},
-            {"edge", directed_edge->json()},
-            {"edge_info", edge_info.json()},
-            {"linear_reference", linear_reference(directed_edge, edge.percent_along, edge_info)},
-            {"predicted_speeds", predicted_speeds},
-            {"live_speed", live_speed},
-        }));
+        writer.end_array();
+        writer.raw("live_speed", to_json(traffic.json()));
+        writer.end_object();
       } // they want it lean and mean
       else {
-        array->emplace_back(json::map({
-            {"way_id", static_cast<uint64_t>(edge_info.wayid())},
-            {"correlated_lat", json::fixed_t{edge.projected.lat(), 6}},
-            {"correlated_lon", json::fixed_t{edge.projected.lng(), 6}},
-            {"side_of_street",
-             edge.sos == PathLocation::LEFT
-                 ? std::string("left")
-                 : (edge.sos == PathLocation::RIGHT ? std::string("right") : std::string("neither"))},
-            {"percent_along", json::fixed_t{edge.percent_along, 5}},
-        }));
+        writer.start_object();
+        writer("way_id", static_cast<uint64_t>(edge_info.wayid()));
+        writer.set_precision(6);
+        writer("correlated_lat", edge.projected.lat());
+        writer("correlated_lon", edge.projected.lng());
+        writer("side_of_street", side_of_street(edge));
+        writer.set_precision(5);
+        writer("percent_along", edge.percent_along);
+        writer.end_object();
       }
     } catch (...) {
       // this really shouldnt ever get hit
       LOG_WARN("Expected edge not found in graph but found by loki::search!");
     }
   }
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_nodes(const PathLocation& location, GraphReader& reader, bool verbose) {
+void serialize_nodes(const PathLocation& location,
+                     GraphReader& reader,
+                     bool verbose,
+                     rapidjson::writer_wrapper_t& writer) {
   // get the nodes we need
   std::unordered_set<uint64_t> nodes;
   for (const auto& e : location.edges) {
@@ -130,51 +152,56 @@ json::ArrayPtr serialize_nodes(const PathLocation& location, GraphReader& reader
     }
   }
   // ad them into an array of json
-  auto array = json::array({});
+  writer.start_array("nodes");
   for (auto node_id : nodes) {
     GraphId n(node_id);
     graph_tile_ptr tile = reader.GetGraphTile(n);
     auto* node_info = tile->node(n);
-    json::MapPtr node;
     if (verbose) {
-      node = node_info->json(tile);
+      auto node = node_info->json(tile);
       node->emplace("node_id", n.json());
+      writer.raw(to_json(node));
     } else {
       midgard::PointLL node_ll = tile->get_node_ll(n);
-      node = json::map({
-          {"lon", json::fixed_t{node_ll.first, 6}}, {"lat", json::fixed_t{node_ll.second, 6}},
-          // TODO: osm_id
-      });
+      writer.start_object();
+      writer.set_precision(6);
+      writer("lon", node_ll.first);
+      writer("lat", node_ll.second);
+      // TODO: osm_id
+      writer.end_object();
     }
-    array->emplace_back(node);
   }
-  // give them back
-  return array;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const PathLocation& location, GraphReader& reader, bool verbose) {
+void serialize(const PathLocation& location,
+               GraphReader& reader,
+               bool verbose,
+               rapidjson::writer_wrapper_t& writer) {
   // serialze all the edges
-  auto m = json::map({
-      {"edges", serialize_edges(location, reader, verbose)},
-      {"nodes", serialize_nodes(location, reader, verbose)},
-      {"input_lat", json::fixed_t{location.latlng_.lat(), 6}},
-      {"input_lon", json::fixed_t{location.latlng_.lng(), 6}},
-  });
-  return m;
+  writer.start_object();
+  serialize_edges(location, reader, verbose, writer);
+  serialize_nodes(location, reader, verbose, writer);
+  writer.set_precision(6);
+  writer("input_lat", location.latlng_.lat());
+  writer("input_lon", location.latlng_.lng());
+  writer.end_object();
 }
 
-json::MapPtr serialize(const midgard::PointLL& ll, const std::string& reason, bool verbose) {
-  auto m = json::map({
-      {"edges", static_cast<std::nullptr_t>(nullptr)},
-      {"nodes", static_cast<std::nullptr_t>(nullptr)},
-      {"input_lat", json::fixed_t{ll.lat(), 6}},
-      {"input_lon", json::fixed_t{ll.lng(), 6}},
-  });
+void serialize(const midgard::PointLL& ll,
+               const std::string& reason,
+               bool verbose,
+               rapidjson::writer_wrapper_t& writer) {
+  writer.start_object();
+  writer("edges", nullptr);
+  writer("nodes", nullptr);
+  writer.set_precision(6);
+  writer("input_lat", ll.lat());
+  writer("input_lon", ll.lng());
   if (verbose) {
-    m->emplace("reason", reason);
+    writer("reason", reason);
   }
-
-  return m;
+  writer.end_object();
 }
 } // namespace
 
@@ -185,19 +212,19 @@ std::string serializeLocate(const Api& request,
                             const std::vector<baldr::Location>& locations,
                             const std::unordered_map<baldr::Location, PathLocation>& projections,
                             GraphReader& reader) {
-  auto json = json::array({});
+  rapidjson::writer_wrapper_t writer(4096);
+  writer.start_array();
   for (const auto& location : locations) {
-    try {
-      json->emplace_back(serialize(projections.at(location), reader, request.options().verbose()));
-    } catch (const std::exception& e) {
-      json->emplace_back(
-          serialize(location.latlng_, "No data found for location", request.options().verbose()));
+    auto projection = projections.find(location);
+    if (projection != projections.cend()) {
+      serialize(projection->second, reader, request.options().verbose(), writer);
+    } else {
+      serialize(location.latlng_, "No data found for location", request.options().verbose(),
+                writer);
     }
   }
-
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_array();
+  return writer.get_buffer();
 }
 
 } // namespace tyr
@@ -1,6 +1,7 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
-#include "baldr/json.h"
 #include "proto_conversions.h"
 #include "thor/matrix_common.h"
 #include "tyr/serializers.h"
@@ -12,69 +13,108 @@ using namespace valhalla::thor;
 
 namespace {
 
-json::ArrayPtr
-serialize_duration(const std::vector<TimeDistance>& tds, size_t start_td, const size_t td_count) {
-  auto time = json::array({});
+// distances are rounded to meters (or thousandths of a mile) before being written so the output
+// does not depend on how the writer cuts off the remaining decimals
+double round_distance(const float distance, const double distance_scale) {
+  return std::round(distance * distance_scale * 1000.0) / 1000.0;
+}
+
+void serialize_duration(const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for time in matrix result
     if (tds[i].time != kMaxCost) {
-      time->emplace_back(static_cast<uint64_t>(tds[i].time));
+      writer(static_cast<uint64_t>(tds[i].time));
     } else {
-      time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return time;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_distance(const std::vector<TimeDistance>& tds,
-                                  size_t start_td,
-                                  const size_t td_count,
-                                  const size_t /* source_index */,
-                                  const size_t /* target_index */,
-                                  double distance_scale) {
-  auto distance = json::array({});
+void serialize_distance(const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        double distance_scale,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance in matrix result
     if (tds[i].time != kMaxCost) {
-      distance->emplace_back(json::fixed_t{tds[i].dist * distance_scale, 3});
+      writer(round_distance(tds[i].dist, distance_scale));
     } else {
-      distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
+    }
+  }
+  writer.end_array();
+}
+
+// calls serialize_row with the index of each source and of its first cell. with departure times
+// the matrix of each time comes after the one before and its rows are wrapped in an array
+template <typename row_serializer_t>
+void serialize_rows(const Options& options,
+                    rapidjson::writer_wrapper_t& writer,
+                    const row_serializer_t& serialize_row) {
+  const size_t source_count = options.sources_size();
+  const size_t slice_count = std::max(options.departure_times_size(), 1);
+  for (size_t slice = 0; slice < slice_count; ++slice) {
+    if (options.departure_times_size()) {
+      writer.start_array();
+    }
+    for (size_t source_index = 0; source_index < source_count; ++source_index) {
+      serialize_row(source_index, (slice * source_count + source_index) * options.targets_size());
+    }
+    if (options.departure_times_size()) {
+      writer.end_array();
+    }
+  }
+}
+
+void serialize_departure_times(const Options& options, rapidjson::writer_wrapper_t& writer) {
+  if (options.departure_times_size()) {
+    writer.start_array("departure_times");
+    for (const auto& departure_time : options.departure_times()) {
+      writer(departure_time);
     }
+    writer.end_array();
   }
-  return distance;
 }
 } // namespace
 
 namespace osrm_serializers {
 
 // Serialize route response in OSRM compatible format.
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale,
-                       MatrixType matrix_type) {
-  auto json = json::map({});
-  auto time = json::array({});
-  auto distance = json::array({});
+void serialize(const Api& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale,
+               MatrixType matrix_type,
+               rapidjson::writer_wrapper_t& writer) {
   const auto& options = request.options();
 
   // If here then the matrix succeeded. Set status code to OK and serialize
   // waypoints (locations).
-  json->emplace("code", std::string("Ok"));
-  json->emplace("sources", osrm::waypoints(options.sources()));
-  json->emplace("destinations", osrm::waypoints(options.targets()));
-
-  for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    time->emplace_back(serialize_duration(time_distances, source_index * options.targets_size(),
-                                          options.targets_size()));
-    distance->emplace_back(serialize_distance(time_distances, source_index * options.targets_size(),
-                                              options.targets_size(), source_index, 0,
-                                              distance_scale));
-  }
-  json->emplace("durations", time);
-  json->emplace("distances", distance);
-  json->emplace("algorithm",
-                std::string(matrix_type == MatrixType::Cost ? "costmatrix" : "timedistancematrix"));
-  return json;
+  writer("code", "Ok");
+  osrm::waypoints("sources", options.sources(), writer);
+  osrm::waypoints("destinations", options.targets(), writer);
+
+  writer.start_array("durations");
+  serialize_rows(options, writer, [&](size_t, size_t start_td) {
+    serialize_duration(time_distances, start_td, options.targets_size(), writer);
+  });
+  writer.end_array();
+
+  writer.set_precision(3);
+  writer.start_array("distances");
+  serialize_rows(options, writer, [&](size_t, size_t start_td) {
+    serialize_distance(time_distances, start_td, options.targets_size(), distance_scale, writer);
+  });
+  writer.end_array();
+
+  serialize_departure_times(options, writer);
+  writer("algorithm", matrix_type == MatrixType::Cost ? "costmatrix" : "timedistancematrix");
 }
 } // namespace osrm_serializers
 
@@ -85,115 +125,181 @@ valhalla output looks like this:
 
 */
 
-json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated) {
-  auto input_locs = json::array({});
-  for (size_t i = 0; i < correlated.size(); i++) {
-    input_locs->emplace_back(json::map({{"lat", json::fixed_t{correlated.Get(i).ll().lat(), 6}},
-                                        {"lon", json::fixed_t{correlated.Get(i).ll().lng(), 6}}}));
+void locations(const char* name,
+               const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated,
+               rapidjson::writer_wrapper_t& writer) {
+  // the locations are wrapped in one more array
+  writer.start_array(name);
+  writer.start_array();
+  writer.set_precision(6);
+  for (const auto& location : correlated) {
+    writer.start_object();
+    writer("lat", location.ll().lat());
+    writer("lon", location.ll().lng());
+    writer.end_object();
   }
-  return input_locs;
+  writer.end_array();
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
-                             size_t start_td,
-                             const size_t td_count,
-                             const size_t source_index,
-                             const size_t target_index,
-                             double distance_scale) {
-  auto row = json::array({});
+void serialize_row(const std::vector<TimeDistance>& tds,
+                   size_t start_td,
+                   const size_t td_count,
+                   const size_t source_index,
+                   const size_t target_index,
+                   double distance_scale,
+                   rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance & time in matrix
     // result
-    json::MapPtr map;
+    writer.start_object();
+    writer("from_index", static_cast<uint64_t>(source_index));
+    writer("to_index", static_cast<uint64_t>(target_index + (i - start_td)));
     if (tds[i].time != kMaxCost) {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<uint64_t>(tds[i].time)},
-                       {"distance", json::fixed_t{tds[i].dist * distance_scale, 3}}});
+      writer("time", static_cast<uint64_t>(tds[i].time));
+      writer("distance", round_distance(tds[i].dist, distance_scale));
       if (!tds[i].date_time.empty()) {
-        map->emplace("date_time", tds[i].date_time);
+        writer("date_time", tds[i].date_time);
       }
     } else {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<std::nullptr_t>(nullptr)},
-                       {"distance", static_cast<std::nullptr_t>(nullptr)}});
+      writer("time", nullptr);
+      writer("distance", nullptr);
     }
-    row->emplace_back(map);
+    writer.end_object();
   }
-  return row;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale,
-                       MatrixType matrix_type) {
-  auto json = json::map({});
+void serialize(const Api& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale,
+               MatrixType matrix_type,
+               rapidjson::writer_wrapper_t& writer) {
   const auto& options = request.options();
 
   if (options.verbose()) {
-    json::ArrayPtr matrix = json::array({});
-    for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-      matrix->emplace_back(serialize_row(time_distances, source_index * options.targets_size(),
-                                         options.targets_size(), source_index, 0, distance_scale));
-    }
-
-    json->emplace("sources_to_targets", matrix);
+    writer.set_precision(3);
+    writer.start_array("sources_to_targets");
+    serialize_rows(options, writer, [&](size_t source_index, size_t start_td) {
+      serialize_row(time_distances, start_td, options.targets_size(), source_index, 0,
+                    distance_scale, writer);
+    });
+    writer.end_array();
 
-    json->emplace("targets", json::array({locations(options.targets())}));
-    json->emplace("sources", json::array({locations(options.sources())}));
+    locations("targets", options.targets(), writer);
+    locations("sources", options.sources(), writer);
   } // slim it down
   else {
-    auto matrix = json::map({});
-    auto time = json::array({});
-    auto distance = json::array({});
-
-    for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-      time->emplace_back(serialize_duration(time_distances, source_index * options.targets_size(),
-                                            options.targets_size()));
-      distance->emplace_back(serialize_distance(time_distances, source_index * options.targets_size(),
-                                                options.targets_size(), source_index, 0,
-                                                distance_scale));
-    }
-    matrix->emplace("distances", distance);
-    matrix->emplace("durations", time);
+    writer.start_object("sources_to_targets");
+    writer.set_precision(3);
+    writer.start_array("distances");
+    serialize_rows(options, writer, [&](size_t, size_t start_td) {
+      serialize_distance(time_distances, start_td, options.targets_size(), distance_scale, writer);
+    });
+    writer.end_array();
 
-    json->emplace("sources_to_targets", matrix);
+    writer.start_array("durations");
+    serialize_rows(options, writer, [&](size_t, size_t start_td) {
+      serialize_duration(time_distances, start_td, options.targets_size(), writer);
+    });
+    writer.end_array();
+    writer.end_object();
   }
 
-  json->emplace("units", Options_Units_Enum_Name(options.units()));
-  json->emplace("algorithm",
-                std::string(matrix_type == MatrixType::Cost ? "costmatrix" : "timedistancematrix"));
+  serialize_departure_times(options, writer);
+  writer("units", Options_Units_Enum_Name(options.units()));
+  writer("algorithm", matrix_type == MatrixType::Cost ? "costmatrix" : "timedistancematrix");
 
   if (options.has_id_case()) {
-    json->emplace("id", options.id());
+    writer("id", options.id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    json->emplace("warnings", valhalla::tyr::serializeWarnings(request));
+    valhalla::tyr::serializeWarnings(request, writer);
   }
-
-  return json;
 }
 } // namespace valhalla_serializers
 
+namespace pbf_serializers {
+
+// Fill out the matrix of the response, the pbf is serialized from the whole Api object
+void serialize(Api& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale,
+               MatrixType matrix_type) {
+  auto& matrix = *request.mutable_matrix();
+  matrix.set_algorithm(matrix_type == MatrixType::Cost ? Matrix::CostMatrix
+                                                       : Matrix::TimeDistanceMatrix);
+  if (request.options().compact_matrix()) {
+    // small differences between neighbouring targets make for short varints
+    const auto columns = std::max(request.options().targets_size(), 1);
+    matrix.mutable_time_deltas()->Reserve(time_distances.size());
+    matrix.mutable_distance_deltas()->Reserve(time_distances.size());
+    int64_t prev_time = 0, prev_dist = 0;
+    for (size_t i = 0; i < time_distances.size(); ++i) {
+      if (i % columns == 0) {
+        prev_time = prev_dist = 0;
+      }
+      const auto& td = time_distances[i];
+      const int64_t time = td.time == kMaxCost ? 0 : int64_t(td.time) + 1;
+      const int64_t dist = td.time == kMaxCost ? 0 : int64_t(td.dist) + 1;
+      matrix.add_time_deltas(static_cast<int32_t>(time - prev_time));
+      matrix.add_distance_deltas(static_cast<int32_t>(dist - prev_dist));
+      prev_time = time;
+      prev_dist = dist;
+    }
+  } else {
+    matrix.mutable_times()->Reserve(time_distances.size());
+    matrix.mutable_distances()->Reserve(time_distances.size());
+    for (const auto& td : time_distances) {
+      // a route was not found between this source and target
+      if (td.time == kMaxCost) {
+        matrix.add_times(-1.f);
+        matrix.add_distances(-1.f);
+      } else {
+        matrix.add_times(td.time);
+        matrix.add_distances(td.dist * distance_scale);
+      }
+    }
+  }
+
+  const bool has_date_time =
+      std::any_of(time_distances.begin(), time_distances.end(),
+                  [](const TimeDistance& td) { return !td.date_time.empty(); });
+
+  // date times are only filled out if there were any at all
+  if (has_date_time) {
+    for (const auto& td : time_distances) {
+      matrix.add_date_times(td.time == kMaxCost ? std::string() : td.date_time);
+    }
+  }
+}
+} // namespace pbf_serializers
+
 namespace valhalla {
 namespace tyr {
 
-std::string serializeMatrix(const Api& request,
+std::string serializeMatrix(Api& request,
                             const std::vector<TimeDistance>& time_distances,
                             double distance_scale,
                             MatrixType matrix_type) {
+  if (request.options().format() == Options::pbf) {
+    pbf_serializers::serialize(request, time_distances, distance_scale, matrix_type);
+    return serializePbf(request);
+  }
 
-  auto json =
-      request.options().format() == Options::osrm
-          ? osrm_serializers::serialize(request, time_distances, distance_scale, matrix_type)
-          : valhalla_serializers::serialize(request, time_distances, distance_scale, matrix_type);
-
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  // every cell of the matrix takes at least 20 bytes
+  rapidjson::writer_wrapper_t writer(time_distances.size() * 20 + 1024);
+  writer.start_object();
+  if (request.options().format() == Options::osrm) {
+    osrm_serializers::serialize(request, time_distances, distance_scale, matrix_type, writer);
+  } else {
+    valhalla_serializers::serialize(request, time_distances, distance_scale, matrix_type, writer);
+  }
+  writer.end_object();
+  return writer.get_buffer();
 }
 
 } // namespace tyr
@@ -0,0 +1,170 @@
+#include "tyr/pipeline.h"
+#include "midgard/logging.h"
+#include "tyr/serializers.h"
+
+using namespace valhalla;
+
+namespace valhalla {
+namespace tyr {
+
+pipeline_worker_t::pipeline_worker_t(const boost::property_tree::ptree& config,
+                                     const std::shared_ptr<baldr::GraphReader>& graph_reader)
+    : service_worker_t(config),
+      reader(graph_reader ? graph_reader
+                          : std::make_shared<baldr::GraphReader>(config.get_child("mjolnir"))),
+      loki_worker(config, reader), thor_worker(config, reader), odin_worker(config) {
+  // signal that the worker started successfully
+  started();
+}
+
+pipeline_worker_t::~pipeline_worker_t() {
+}
+
+std::string pipeline_worker_t::act(Api& request) {
+  // errors which arent ours are reported as coming from the stage that threw them
+  stage_error_code = 199;
+  loki_worker.check_action(request);
+  loki_worker.admit(request);
+
+  switch (request.options().action()) {
+    case Options::route:
+      loki_worker.route(request);
+      stage_error_code = 499;
+      thor_worker.route(request);
+      stage_error_code = 299;
+      return odin_worker.narrate(request);
+    case Options::centroid:
+      loki_worker.route(request);
+      stage_error_code = 499;
+      thor_worker.centroid(request);
+      stage_error_code = 299;
+      return odin_worker.narrate(request);
+    case Options::locate:
+      return loki_worker.locate(request);
+    case Options::sources_to_targets:
+      loki_worker.matrix(request);
+      stage_error_code = 499;
+      return thor_worker.matrix(request);
+    case Options::optimized_route:
+      loki_worker.matrix(request);
+      stage_error_code = 499;
+      thor_worker.optimized_route(request);
+      stage_error_code = 299;
+      return odin_worker.narrate(request);
+    case Options::isochrone:
+      loki_worker.isochrones(request);
+      stage_error_code = 499;
+      return thor_worker.isochrones(request);
+    case Options::trace_route:
+      loki_worker.trace(request);
+      stage_error_code = 499;
+      thor_worker.trace_route(request);
+      stage_error_code = 299;
+      return odin_worker.narrate(request);
+    case Options::trace_attributes:
+      loki_worker.trace(request);
+      stage_error_code = 499;
+      return thor_worker.trace_attributes(request);
+    case Options::height:
+      return loki_worker.height(request);
+    case Options::transit_available:
+      return loki_worker.transit_available(request);
+    case Options::expansion:
+      if (request.options().expansion_action() == Options::route) {
+        loki_worker.route(request);
+      } else {
+        loki_worker.isochrones(request);
+      }
+      stage_error_code = 499;
+      return thor_worker.expansion(request);
+    case Options::status:
+      loki_worker.status(request);
+      stage_error_code = 499;
+      thor_worker.status(request);
+      stage_error_code = 299;
+      odin_worker.status(request);
+      return tyr::serializeStatus(request);
+    default:
+      // apparently you wanted something that we figured we'd support but havent written yet
+      throw valhalla_exception_t{107};
+  }
+}
+
+#ifdef HAVE_HTTP
+prime_server::worker_t::result_t
+pipeline_worker_t::work(const std::list<zmq::message_t>& job,
+                        void* request_info,
+                        const std::function<void()>& interrupt_function) {
+
+  // grab the request info and make sure to record any metrics before we are done
+  auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
+  LOG_INFO("Got Pipeline Request " + std::to_string(info.id));
+  Api& request = api_arena.next();
+  prime_server::worker_t::result_t result{false, {}, ""};
+  try {
+    // request parsing
+    stage_error_code = 199;
+    auto http_request =
+        prime_server::http_request_t::from_string(static_cast<const char*>(job.front().data()),
+                                                  job.front().size());
+    ParseApi(http_request, request);
+
+    // Set the interrupt function, it also stops the request at its deadline
+    set_interrupt(watch_deadline(request, &interrupt_function, 446));
+
+    // do all the stages of the request on the same object
+    result = to_response(act(request), info, request);
+  } catch (const valhalla_exception_t& e) {
+    LOG_WARN("400::" + std::string(e.what()) + " request_id=" + std::to_string(info.id));
+    result = serialize_error(e, info, request);
+  } catch (const std::exception& e) {
+    LOG_ERROR("400::" + std::string(e.what()) + " request_id=" + std::to_string(info.id));
+    result = serialize_error({stage_error_code, std::string(e.what())}, info, request);
+  }
+
+  // the response always goes back to the client from here
+  enqueue_statistics(request);
+
+  return result;
+}
+
+void run_service(const boost::property_tree::ptree& config) {
+  // gracefully shutdown when asked via SIGTERM
+  prime_server::quiesce(config.get<unsigned int>("httpd.service.drain_seconds", 28),
+                        config.get<unsigned int>("httpd.service.shutting_seconds", 1));
+
+  // gets requests from the http server
+  auto upstream_endpoint = config.get<std::string>("loki.service.proxy") + "_out";
+  // and returns the responses back to it
+  auto loopback_endpoint = config.get<std::string>("httpd.service.loopback");
+  auto interrupt_endpoint = config.get<std::string>("httpd.service.interrupt");
+
+  // listen for requests
+  zmq::context_t context;
+  pipeline_worker_t pipeline_worker(config);
+  prime_server::worker_t worker(context, upstream_endpoint, "ipc:///dev/null", loopback_endpoint,
+                                interrupt_endpoint,
+                                std::bind(&pipeline_worker_t::work, std::ref(pipeline_worker),
+                                          std::placeholders::_1, std::placeholders::_2,
+                                          std::placeholders::_3),
+                                std::bind(&pipeline_worker_t::cleanup, std::ref(pipeline_worker)));
+  worker.work();
+}
+#endif
+
+void pipeline_worker_t::cleanup() {
+  service_worker_t::cleanup();
+  loki_worker.cleanup();
+  thor_worker.cleanup();
+  odin_worker.cleanup();
+}
+
+void pipeline_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
+  interrupt = interrupt_function;
+  loki_worker.set_interrupt(interrupt_function);
+  thor_worker.set_interrupt(interrupt_function);
+  odin_worker.set_interrupt(interrupt_function);
+}
+
+} // namespace tyr
+} // namespace valhalla
@@ -1,3 +1,4 @@
+#include <charconv>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -169,6 +170,138 @@ std::unordered_map<std::string, std::pair<std::string, std::string>> speed_limit
     {"WS", {kSpeedLimitSignVienna, kSpeedLimitUnitsMph}},
 };
 
+// Writes json straight into a string for the parts of the response that are too numerous to
+// build as maps and arrays first, ie. the geometry and intersections of every step. Numbers and
+// strings come out the same as json::Value would write them. Clear it to reuse its buffer.
+class raw_json_writer {
+public:
+  void clear() {
+    buffer_.clear();
+    separate_ = false;
+  }
+
+  json::RawJSON get() const {
+    return json::RawJSON{buffer_};
+  }
+
+  void start_object(const char* key = nullptr) {
+    write_key(key);
+    buffer_ += '{';
+    separate_ = false;
+  }
+
+  void end_object() {
+    buffer_ += '}';
+    separate_ = true;
+  }
+
+  void start_array(const char* key = nullptr) {
+    write_key(key);
+    buffer_ += '[';
+    separate_ = false;
+  }
+
+  void end_array() {
+    buffer_ += ']';
+    separate_ = true;
+  }
+
+  void operator()(const char* key, const std::string& value) {
+    write_key(key);
+    write_string(value);
+  }
+
+  void operator()(const char* key, const uint64_t value) {
+    write_key(key);
+    char chars[20];
+    buffer_.append(chars, std::to_chars(chars, chars + sizeof(chars), value).ptr);
+  }
+
+  void operator()(const char* key, const bool value) {
+    write_key(key);
+    buffer_ += value ? "true" : "false";
+  }
+
+  void operator()(const char* key, const json::fixed_t value) {
+    write_key(key);
+    char chars[48];
+    if (std::isfinite(value.value)) {
+      if (auto* end = json::format_fixed(chars, value.value, value.precision)) {
+        buffer_.append(chars, end);
+        return;
+      }
+    }
+    std::ostringstream stream;
+    stream << value;
+    buffer_ += stream.str();
+  }
+
+  // array elements
+  template <typename T> void operator()(const T& value) {
+    (*this)(nullptr, value);
+  }
+
+private:
+  void write_key(const char* key) {
+    if (separate_) {
+      buffer_ += ',';
+    }
+    separate_ = true;
+    if (key) {
+      buffer_ += '"';
+      buffer_ += key;
+      buffer_ += "\":";
+    }
+  }
+
+  void write_string(const std::string& value) {
+    buffer_ += '"';
+    for (const auto c : value) {
+      switch (c) {
+        case '\\':
+          buffer_ += "\\\\";
+          break;
+        case '"':
+          buffer_ += "\\\"";
+          break;
+        case '/':
+          buffer_ += "\\/";
+          break;
+        case '\b':
+          buffer_ += "\\b";
+          break;
+        case '\f':
+          buffer_ += "\\f";
+          break;
+        case '\n':
+          buffer_ += "\\n";
+          break;
+        case '\r':
+          buffer_ += "\\r";
+          break;
+        case '\t':
+          buffer_ += "\\t";
+          break;
+        default:
+          if (iscntrl(c)) {
+            static const char hex[] = "0123456789ABCDEF";
+            const auto byte = static_cast<unsigned char>(c);
+            buffer_ += "\\u00";
+            buffer_ += hex[byte >> 4];
+            buffer_ += hex[byte & 0xf];
+          } else {
+            buffer_ += c;
+          }
+          break;
+      }
+    }
+    buffer_ += '"';
+  }
+
+  std::string buffer_;
+  bool separate_ = false;
+};
+
 namespace osrm_serializers {
 /*
 OSRM output is described in: http://project-osrm.org/docs/v5.5.1/api/
@@ -247,27 +380,31 @@ void route_summary(json::MapPtr& route, const valhalla::Api& api, bool imperial,
   }
 }
 
-// Generate leg shape in geojson format.
-json::MapPtr geojson_shape(const std::vector<PointLL> shape) {
-  auto geojson = json::map({});
-  auto coords = json::array({});
-  coords->reserve(shape.size());
+// Write shape as a geojson linestring. The last point can be repeated to make a linestring of the
+// single point of an arrival.
+template <class container_t>
+void geojson_shape(raw_json_writer& writer, const container_t& shape, bool repeat_last = false) {
+  writer.start_object();
+  writer("type", std::string("LineString"));
+  writer.start_array("coordinates");
+  auto write_point = [&writer](const PointLL& p) {
+    writer.start_array();
+    writer(json::fixed_t{p.lng(), DIGITS_PRECISION});
+    writer(json::fixed_t{p.lat(), DIGITS_PRECISION});
+    writer.end_array();
+  };
   for (const auto& p : shape) {
-    coords->emplace_back(json::array(
-        {json::fixed_t{p.lng(), DIGITS_PRECISION}, json::fixed_t{p.lat(), DIGITS_PRECISION}}));
+    write_point(p);
+  }
+  if (repeat_last && shape.size()) {
+    write_point(*std::prev(shape.end()));
   }
-  geojson->emplace("type", std::string("LineString"));
-  geojson->emplace("coordinates", std::move(coords));
-  return geojson;
+  writer.end_array();
+  writer.end_object();
 }
 
 // Generate full shape of the route.
-std::vector<PointLL> full_shape(const valhalla::DirectionsRoute& directions,
-                                const valhalla::Options& options) {
-  // If just one leg and it we want polyline6 then we just return the encoded leg shape
-  if (directions.legs().size() == 1 && options.shape_format() == polyline6) {
-    return midgard::decode<std::vector<PointLL>>(directions.legs().begin()->shape());
-  }
+std::vector<PointLL> full_shape(const valhalla::DirectionsRoute& directions) {
   // TODO: there is a tricky way to do this... since the end of each leg is the same as the
   // beginning we essentially could just peel off the first encoded shape point of all the legs (but
   // the first) this way we wouldn't really have to do any decoding (would be far faster). it might
@@ -315,16 +452,24 @@ std::vector<PointLL> simplified_shape(const valhalla::DirectionsRoute& direction
 
 void route_geometry(json::MapPtr& route,
                     const valhalla::DirectionsRoute& directions,
-                    const valhalla::Options& options) {
+                    const valhalla::Options& options,
+                    raw_json_writer& writer) {
   std::vector<PointLL> shape;
   if (options.has_generalize_case() && options.generalize() == 0.0f) {
     shape = simplified_shape(directions);
   } else if (!options.has_generalize_case() ||
              (options.has_generalize_case() && options.generalize() > 0.0f)) {
-    shape = full_shape(directions, options);
+    // If just one leg and we want polyline6 then the encoded leg shape is the geometry
+    if (directions.legs().size() == 1 && options.shape_format() == polyline6) {
+      route->emplace("geometry", directions.legs().begin()->shape());
+      return;
+    }
+    shape = full_shape(directions);
   }
   if (options.shape_format() == geojson) {
-    route->emplace("geometry", geojson_shape(shape));
+    writer.clear();
+    geojson_shape(writer, shape);
+    route->emplace("geometry", writer.get());
   } else {
     int precision = options.shape_format() == polyline6 ? 1e6 : 1e5;
     route->emplace("geometry", midgard::encode(shape, precision));
@@ -430,110 +575,107 @@ struct IntersectionEdges {
 };
 
 // Add intersections along a step/maneuver.
-json::ArrayPtr intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
-                             valhalla::odin::EnhancedTripLeg* etp,
-                             const std::vector<PointLL>& shape,
-                             uint32_t& count,
-                             const bool arrive_maneuver,
-                             const baldr::AttributesController& controller) {
+json::RawJSON intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
+                            valhalla::odin::EnhancedTripLeg* etp,
+                            const std::vector<PointLL>& shape,
+                            uint32_t& count,
+                            const bool arrive_maneuver,
+                            const baldr::AttributesController& controller,
+                            raw_json_writer& writer) {
   // Iterate through the nodes/intersections of the path for this maneuver
   count = 0;
-  auto intersections = json::array({});
+  writer.clear();
+  writer.start_array();
+  std::vector<IntersectionEdges> edges;
   uint32_t n = arrive_maneuver ? maneuver.end_path_index() + 1 : maneuver.end_path_index();
-  EnhancedTripLeg_Node* prev_node = nullptr;
+  std::unique_ptr<EnhancedTripLeg_Node> next_node;
+  if (maneuver.begin_path_index() < n) {
+    next_node = etp->GetEnhancedNode(maneuver.begin_path_index());
+  }
   for (uint32_t i = maneuver.begin_path_index(); i < n; i++) {
-    auto intersection = json::map({});
+    writer.start_object();
 
     // Get the node and current edge from the enhanced trip path
     // NOTE: curr_edge does not exist for the arrive maneuver
-    auto node = etp->GetEnhancedNode(i);
+    auto node = std::move(next_node);
     auto curr_edge = etp->GetCurrEdge(i);
     auto prev_edge = etp->GetPrevEdge(i);
 
     // Add the node location (lon, lat). Use the last shape point for
     // the arrive step
-    auto loc = json::array({});
     size_t shape_index = arrive_maneuver ? shape.size() - 1 : curr_edge->begin_shape_index();
     PointLL ll = shape[shape_index];
-    loc->emplace_back(json::fixed_t{ll.lng(), 6});
-    loc->emplace_back(json::fixed_t{ll.lat(), 6});
-    intersection->emplace("location", loc);
-    intersection->emplace("geometry_index", static_cast<uint64_t>(shape_index));
+    writer.start_array("location");
+    writer(json::fixed_t{ll.lng(), 6});
+    writer(json::fixed_t{ll.lat(), 6});
+    writer.end_array();
+    writer("geometry_index", static_cast<uint64_t>(shape_index));
 
     // Add index into admin list
     if (controller(kNodeAdminIndex)) {
-      intersection->emplace("admin_index", static_cast<uint64_t>(node->admin_index()));
+      writer("admin_index", static_cast<uint64_t>(node->admin_index()));
     }
 
     if (!arrive_maneuver && controller(kEdgeIsUrban)) {
-      intersection->emplace("is_urban", curr_edge->is_urban());
+      writer("is_urban", curr_edge->is_urban());
     }
 
-    auto toll_collection = json::map({});
-    if (node->type() == TripLeg_Node::kTollBooth) {
-      toll_collection->emplace("type", std::string("toll_booth"));
-    } else if (node->type() == TripLeg_Node::kTollGantry) {
-      toll_collection->emplace("type", std::string("toll_gantry"));
+    if (node->type() == TripLeg_Node::kTollBooth || node->type() == TripLeg_Node::kTollGantry) {
+      writer.start_object("toll_collection");
+      writer("type", std::string(node->type() == TripLeg_Node::kTollBooth ? "toll_booth"
+                                                                           : "toll_gantry"));
+      writer.end_object();
     }
-    if (!toll_collection->empty())
-      intersection->emplace("toll_collection", toll_collection);
 
     if (node->cost().transition_cost().seconds() > 0)
-      intersection->emplace("turn_duration",
-                            json::fixed_t{node->cost().transition_cost().seconds(), 3});
+      writer("turn_duration", json::fixed_t{node->cost().transition_cost().seconds(), 3});
     if (node->cost().transition_cost().cost() > 0)
-      intersection->emplace("turn_weight", json::fixed_t{node->cost().transition_cost().cost(), 3});
-    auto next_node = i + 1 < n ? etp->GetEnhancedNode(i + 1) : nullptr;
+      writer("turn_weight", json::fixed_t{node->cost().transition_cost().cost(), 3});
+    next_node = i + 1 < n ? etp->GetEnhancedNode(i + 1) : nullptr;
     if (next_node) {
       auto secs = next_node->cost().elapsed_cost().seconds() - node->cost().elapsed_cost().seconds();
       auto cost = next_node->cost().elapsed_cost().cost() - node->cost().elapsed_cost().cost();
       if (secs > 0)
-        intersection->emplace("duration", json::fixed_t{secs, 3});
+        writer("duration", json::fixed_t{secs, 3});
       if (cost > 0)
-        intersection->emplace("weight", json::fixed_t{cost, 3});
+        writer("weight", json::fixed_t{cost, 3});
     }
 
     // TODO: add recosted durations to the intersection?
 
     // Add rest_stop when passing by a rest_area or service_area
     if (i > 0 && !arrive_maneuver) {
-      auto rest_stop = json::map({});
       for (uint32_t m = 0; m < node->intersecting_edge_size(); m++) {
         auto intersecting_edge = node->GetIntersectingEdge(m);
         bool routeable = intersecting_edge->IsTraversableOutbound(curr_edge->travel_mode());
+        if (!routeable || (intersecting_edge->use() != TripLeg_Use_kRestAreaUse &&
+                           intersecting_edge->use() != TripLeg_Use_kServiceAreaUse)) {
+          continue;
+        }
 
-        std::string sign_text;
+        writer.start_object("rest_stop");
+        writer("type", std::string(intersecting_edge->use() == TripLeg_Use_kRestAreaUse
+                                       ? "rest_area"
+                                       : "service_area"));
         if (intersecting_edge->has_sign()) {
-          const valhalla::TripSign& trip_leg_sign = intersecting_edge->sign();
           // I've looked at the results from guide_destinations(), destinations(), and
           // exit_destinations(). exit_destinations() does not contain rest-area names.
           // guide_destinations() and destinations() return the same string value for
           // the rest area name. So I've decided to use guide_destinations().
-          sign_text = destinations(trip_leg_sign);
-        }
-
-        if (routeable && intersecting_edge->use() == TripLeg_Use_kRestAreaUse) {
-          rest_stop->emplace("type", std::string("rest_area"));
+          std::string sign_text = destinations(intersecting_edge->sign());
           if (!sign_text.empty()) {
-            rest_stop->emplace("name", sign_text);
+            writer("name", sign_text);
           }
-          intersection->emplace("rest_stop", rest_stop);
-          break;
-        } else if (routeable && intersecting_edge->use() == TripLeg_Use_kServiceAreaUse) {
-          rest_stop->emplace("type", std::string("service_area"));
-          if (!sign_text.empty()) {
-            rest_stop->emplace("name", sign_text);
-          }
-          intersection->emplace("rest_stop", rest_stop);
-          break;
         }
+        writer.end_object();
+        break;
       }
     }
 
     // Get bearings and access to outgoing intersecting edges. Do not add
     // any intersecting edges for the first depart intersection and for
     // the arrival step.
-    std::vector<IntersectionEdges> edges;
+    edges.clear();
 
     // Add the edge departing the node
     if (!arrive_maneuver) {
@@ -556,10 +698,6 @@ json::ArrayPtr intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
       edges.emplace_back(((prior_heading + 180) % 360), entry, true, false);
     }
 
-    // Create bearing and entry output
-    auto bearings = json::array({});
-    auto entries = json::array({});
-
     // Sort edges by increasing bearing and update the in/out edge indexes
     std::sort(edges.begin(), edges.end());
     uint32_t incoming_index, outgoing_index;
@@ -570,27 +708,35 @@ json::ArrayPtr intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
       if (edges[n].out_edge) {
         outgoing_index = n;
       }
-      bearings->emplace_back(static_cast<uint64_t>(edges[n].bearing));
-      entries->emplace_back(edges[n].routeable);
     }
 
     // Add the index of the input edge and output edge
     if (i > 0) {
-      intersection->emplace("in", static_cast<uint64_t>(incoming_index));
+      writer("in", static_cast<uint64_t>(incoming_index));
     }
     if (!arrive_maneuver) {
-      intersection->emplace("out", static_cast<uint64_t>(outgoing_index));
+      writer("out", static_cast<uint64_t>(outgoing_index));
     }
 
-    intersection->emplace("entry", entries);
-    intersection->emplace("bearings", bearings);
+    // Add bearing and entry output
+    writer.start_array("entry");
+    for (const auto& edge : edges) {
+      writer(edge.routeable);
+    }
+    writer.end_array();
+    writer.start_array("bearings");
+    for (const auto& edge : edges) {
+      writer(static_cast<uint64_t>(edge.bearing));
+    }
+    writer.end_array();
 
     // Add tunnel_name for tunnels
     if (!arrive_maneuver) {
       if (curr_edge->tunnel() && !curr_edge->tagged_value().empty()) {
         for (uint32_t t = 0; t < curr_edge->tagged_value().size(); ++t) {
           if (curr_edge->tagged_value().Get(t).type() == TaggedValue_Type_kTunnel) {
-            intersection->emplace("tunnel_name", curr_edge->tagged_value().Get(t).value());
+            writer("tunnel_name", curr_edge->tagged_value().Get(t).value());
+            break;
           }
         }
       }
@@ -599,29 +745,27 @@ json::ArrayPtr intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
     // Add classes based on the first edge after the maneuver (not needed
     // for arrive maneuver).
     if (!arrive_maneuver) {
-      std::vector<std::string> classes;
-      if (curr_edge->tunnel()) {
-        classes.push_back("tunnel");
-      }
-      if (maneuver.portions_toll() || curr_edge->toll()) {
-        classes.push_back("toll");
-      }
-      if (curr_edge->road_class() == valhalla::RoadClass::kMotorway) {
-        classes.push_back("motorway");
-      }
-      if (curr_edge->use() == TripLeg::Use::TripLeg_Use_kFerryUse) {
-        classes.push_back("ferry");
-      }
-
-      if (curr_edge->destination_only()) {
-        classes.push_back("restricted");
-      }
-      if (classes.size() > 0) {
-        auto class_list = json::array({});
-        for (const auto& cl : classes) {
-          class_list->emplace_back(cl);
+      bool toll = maneuver.portions_toll() || curr_edge->toll();
+      bool motorway = curr_edge->road_class() == valhalla::RoadClass::kMotorway;
+      bool ferry = curr_edge->use() == TripLeg::Use::TripLeg_Use_kFerryUse;
+      if (curr_edge->tunnel() || toll || motorway || ferry || curr_edge->destination_only()) {
+        writer.start_array("classes");
+        if (curr_edge->tunnel()) {
+          writer(std::string("tunnel"));
         }
-        intersection->emplace("classes", class_list);
+        if (toll) {
+          writer(std::string("toll"));
+        }
+        if (motorway) {
+          writer(std::string("motorway"));
+        }
+        if (ferry) {
+          writer(std::string("ferry"));
+        }
+        if (curr_edge->destination_only()) {
+          writer(std::string("restricted"));
+        }
+        writer.end_array();
       }
     }
 
@@ -630,73 +774,74 @@ json::ArrayPtr intersections(const valhalla::DirectionsLeg::Maneuver& maneuver,
     // Verify that turn lanes are not non-directional
     if (prev_edge && (prev_edge->turn_lanes_size() > 0) && prev_edge->HasActiveTurnLane() &&
         !prev_edge->HasNonDirectionalTurnLane()) {
-      auto lanes = json::array({});
+      writer.start_array("lanes");
       for (const auto& turn_lane : prev_edge->turn_lanes()) {
-        auto lane = json::map({});
+        writer.start_object();
         // Process 'valid' & 'active' flags
         bool is_active = turn_lane.state() == TurnLane::kActive;
         // an active lane is also valid
         bool is_valid = is_active || turn_lane.state() == TurnLane::kValid;
-        lane->emplace("active", is_active);
-        lane->emplace("valid", is_valid);
+        writer("active", is_active);
+        writer("valid", is_valid);
         // Add valid_indication for a valid & active lanes
         if (turn_lane.state() != TurnLane::kInvalid) {
-          lane->emplace("valid_indication", turn_lane_direction(turn_lane.active_direction()));
+          writer("valid_indication", turn_lane_direction(turn_lane.active_direction()));
         }
 
         // Process 'indications' array - add indications from left to right
-        auto indications = json::array({});
+        writer.start_array("indications");
         uint16_t mask = turn_lane.directions_mask();
 
         // TODO make map for lane mask to osrm indication string
 
         // reverse (left u-turn)
         if (mask & kTurnLaneReverse && prev_edge->drive_on_right()) {
-          indications->emplace_back(osrmconstants::kModifierUturn);
+          writer(osrmconstants::kModifierUturn);
         }
         // sharp_left
         if (mask & kTurnLaneSharpLeft) {
-          indications->emplace_back(osrmconstants::kModifierSharpLeft);
+          writer(osrmconstants::kModifierSharpLeft);
         }
         // left
         if (mask & kTurnLaneLeft) {
-          indications->emplace_back(osrmconstants::kModifierLeft);
+          writer(osrmconstants::kModifierLeft);
         }
         // slight_left
         if (mask & kTurnLaneSlightLeft) {
-          indications->emplace_back(osrmconstants::kModifierSlightLeft);
+          writer(osrmconstants::kModifierSlightLeft);
         }
         // through
         if (mask & kTurnLaneThrough) {
-          indications->emplace_back(osrmconstants::kModifierStraight);
+          writer(osrmconstants::kModifierStraight);
         }
         // slight_right
         if (mask & kTurnLaneSlightRight) {
-          indications->emplace_back(osrmconstants::kModifierSlightRight);
+          writer(osrmconstants::kModifierSlightRight);
         }
         // right
         if (mask & kTurnLaneRight) {
-          indications->emplace_back(osrmconstants::kModifierRight);
+          writer(osrmconstants::kModifierRight);
         }
         // sharp_right
         if (mask & kTurnLaneSharpRight) {
-          indications->emplace_back(osrmconstants::kModifierSharpRight);
+          writer(osrmconstants::kModifierSharpRight);
         }
         // reverse (right u-turn)
         if (mask & kTurnLaneReverse && !prev_edge->drive_on_right()) {
-          indications->emplace_back(osrmconstants::kModifierUturn);
+          writer(osrmconstants::kModifierUturn);
         }
-        lane->emplace("indications", std::move(indications));
-        lanes->emplace_back(std::move(lane));
+        writer.end_array();
+        writer.end_object();
       }
-      intersection->emplace("lanes", std::move(lanes));
+      writer.end_array();
     }
 
     // Add the intersection to the JSON array
-    intersections->emplace_back(intersection);
+    writer.end_object();
     count++;
   }
-  return intersections;
+  writer.end_array();
+  return writer.get();
 }
 
 // Add exits (exit numbers) along a step/maneuver.
@@ -1208,19 +1353,25 @@ void maneuver_geometry(json::MapPtr& step,
                        const uint32_t end_idx,
                        const std::vector<PointLL>& shape,
                        bool is_arrive_maneuver,
-                       const valhalla::Options& options) {
+                       const valhalla::Options& options,
+                       raw_json_writer& writer) {
   // Must add one to the end range since maneuver end shape index is exclusive
-  std::vector<PointLL> maneuver_shape(shape.begin() + begin_idx, shape.begin() + end_idx + 1);
-  // Last maneuver shape is a linestring with two identical points at the destination
-  if (is_arrive_maneuver) {
-    maneuver_shape.push_back(shape.back());
-  }
+  const midgard::iterable_t<const PointLL> maneuver_shape(shape.data() + begin_idx,
+                                                          shape.data() + end_idx + 1);
 
+  // Last maneuver shape is a linestring with two identical points at the destination
   if (options.shape_format() == geojson) {
-    step->emplace("geometry", geojson_shape(maneuver_shape));
+    writer.clear();
+    geojson_shape(writer, maneuver_shape, is_arrive_maneuver);
+    step->emplace("geometry", writer.get());
   } else {
     int precision = options.shape_format() == polyline6 ? 1e6 : 1e5;
-    step->emplace("geometry", midgard::encode(maneuver_shape, precision));
+    auto encoded = midgard::encode(maneuver_shape, precision);
+    if (is_arrive_maneuver) {
+      // the last point repeated is a zero offset in both coordinates
+      encoded += "??";
+    }
+    step->emplace("geometry", std::move(encoded));
   }
 }
 
@@ -1316,7 +1467,8 @@ json::ArrayPtr serialize_legs(const google::protobuf::RepeatedPtrField<valhalla:
                               google::protobuf::RepeatedPtrField<valhalla::TripLeg>& path_legs,
                               bool imperial,
                               const valhalla::Options& options,
-                              const baldr::AttributesController& controller) {
+                              const baldr::AttributesController& controller,
+                              raw_json_writer& writer) {
   auto output_legs = json::array({});
   output_legs->reserve(path_legs.size());
 
@@ -1365,7 +1517,7 @@ json::ArrayPtr serialize_legs(const google::protobuf::RepeatedPtrField<valhalla:
 
       // Add geometry for this maneuver
       maneuver_geometry(step, maneuver.begin_shape_index(), maneuver.end_shape_index(), shape,
-                        arrive_maneuver, options);
+                        arrive_maneuver, options, writer);
 
       // Add mode, driving side, weight, distance, duration, name
       double distance = units_to_meters(maneuver.length(), !imperial);
@@ -1502,7 +1654,7 @@ json::ArrayPtr serialize_legs(const google::protobuf::RepeatedPtrField<valhalla:
 
       // Add intersections
       step->emplace("intersections", intersections(maneuver, &etp, shape, prev_intersection_count,
-                                                   arrive_maneuver, controller));
+                                                   arrive_maneuver, controller, writer));
 
       // Add step
       prev_rotary = rotary;
@@ -1695,6 +1847,9 @@ std::string serialize(valhalla::Api& api) {
   std::vector<std::vector<std::string>> route_leg_summaries =
       summarize_route_legs(api.directions().routes());
 
+  // Geometry and intersections are written straight to json, reusing one buffer throughout
+  raw_json_writer writer;
+
   // For each route...
   for (int i = 0; i < api.trip().routes_size(); ++i) {
     // Create a route to add to the array
@@ -1709,7 +1864,7 @@ std::string serialize(valhalla::Api& api) {
     route_references(route, api.trip().routes(i), options);
 
     // Concatenated route geometry
-    route_geometry(route, api.directions().routes(i), options);
+    route_geometry(route, api.directions().routes(i), options, writer);
 
     // Other route summary information
     route_summary(route, api, imperial, i);
@@ -1717,7 +1872,7 @@ std::string serialize(valhalla::Api& api) {
     // Serialize route legs
     route->emplace("legs", serialize_legs(api.directions().routes(i).legs(), route_leg_summaries[i],
                                           *api.mutable_trip()->mutable_routes(i)->mutable_legs(),
-                                          imperial, options, controller));
+                                          imperial, options, controller, writer));
 
     routes->emplace_back(std::move(route));
   }
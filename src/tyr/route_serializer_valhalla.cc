@@ -544,10 +544,14 @@ std::string serialize(const Api& api) {
   // build up the json object, reserve 4k bytes
   rapidjson::writer_wrapper_t writer(4096);
 
+  // the routes after the first are alternates or those of the other costings to compare with
+  const auto& comparisons = api.options().comparisons();
+  const char* others = comparisons.empty() ? "alternates" : "comparisons";
+
   // for each route
   for (int i = 0; i < api.directions().routes_size(); ++i) {
     if (i == 1) {
-      writer.start_array("alternates");
+      writer.start_array(others);
     }
 
     // the route itself
@@ -573,6 +577,13 @@ std::string serialize(const Api& api) {
 
     writer.end_object(); // trip
 
+    // which costing a comparison is, by its name if it has one
+    if (i > 0 && i <= comparisons.size()) {
+      const auto& comparison = comparisons.Get(i - 1);
+      writer("costing", comparison.has_name_case() ? comparison.name()
+                                                   : Costing_Enum_Name(comparison.type()));
+    }
+
     // leave space for alternates by closing this one outside the loop
     if (i > 0) {
       writer.end_object();
@@ -580,7 +591,7 @@ std::string serialize(const Api& api) {
   }
 
   if (api.directions().routes_size() > 1) {
-    writer.end_array(); // alternates
+    writer.end_array(); // alternates or comparisons
   }
 
   if (api.options().has_id_case()) {
@@ -135,6 +135,79 @@ std::string serializeStatus(Api& request) {
     rapidjson::SetValueByPointer(status_doc, "/bbox", bbox_doc, alloc);
   }
 
+  // the counters of each service the request went through
+  if (request.status().counters_size()) {
+    rapidjson::Value counters_list(rapidjson::kArrayType);
+    for (const auto& counters : request.status().counters()) {
+      rapidjson::Value service(rapidjson::kObjectType);
+      service.AddMember("service", rapidjson::Value().SetString(counters.service(), alloc), alloc);
+      const auto& cache = counters.tile_cache();
+      rapidjson::Value tile_cache(rapidjson::kObjectType);
+      tile_cache.AddMember("hits", rapidjson::Value().SetUint64(cache.hits()), alloc);
+      tile_cache.AddMember("misses", rapidjson::Value().SetUint64(cache.misses()), alloc);
+      tile_cache.AddMember("evictions", rapidjson::Value().SetUint64(cache.evictions()), alloc);
+      tile_cache.AddMember("tiles_loaded", rapidjson::Value().SetUint64(cache.tiles_loaded()),
+                           alloc);
+      tile_cache.AddMember("bytes_loaded", rapidjson::Value().SetUint64(cache.bytes_loaded()),
+                           alloc);
+      tile_cache.AddMember("load_ms", rapidjson::Value().SetDouble(cache.load_ms()), alloc);
+      service.AddMember("tile_cache", tile_cache, alloc);
+      if (counters.has_search()) {
+        const auto& search = counters.search();
+        rapidjson::Value search_counters(rapidjson::kObjectType);
+        search_counters.AddMember("searches", rapidjson::Value().SetUint64(search.searches()),
+                                  alloc);
+        search_counters.AddMember("labels", rapidjson::Value().SetUint64(search.labels()), alloc);
+        search_counters.AddMember("hierarchy_pruned",
+                                  rapidjson::Value().SetUint64(search.hierarchy_pruned()), alloc);
+        search_counters.AddMember("queue_redistributions",
+                                  rapidjson::Value().SetUint64(search.queue_redistributions()),
+                                  alloc);
+        if (search.label_reservations_size()) {
+          rapidjson::Value reservations(rapidjson::kArrayType);
+          for (const auto& reservation : search.label_reservations()) {
+            rapidjson::Value r(rapidjson::kObjectType);
+            r.AddMember("algorithm", rapidjson::Value().SetString(reservation.algorithm(), alloc),
+                        alloc);
+            r.AddMember("travel_mode",
+                        rapidjson::Value().SetString(reservation.travel_mode(), alloc), alloc);
+            r.AddMember("searches", rapidjson::Value().SetUint64(reservation.searches()), alloc);
+            r.AddMember("labels_per_km",
+                        rapidjson::Value().SetDouble(reservation.labels_per_km()), alloc);
+            reservations.PushBack(r, alloc);
+          }
+          search_counters.AddMember("label_reservations", reservations, alloc);
+        }
+        service.AddMember("search", search_counters, alloc);
+      }
+      if (counters.has_warmup()) {
+        const auto& warmup = counters.warmup();
+        rapidjson::Value warmup_counters(rapidjson::kObjectType);
+        warmup_counters.AddMember("tiles", rapidjson::Value().SetUint64(warmup.tiles()), alloc);
+        warmup_counters.AddMember("bytes", rapidjson::Value().SetUint64(warmup.bytes()), alloc);
+        warmup_counters.AddMember("ms", rapidjson::Value().SetDouble(warmup.ms()), alloc);
+        service.AddMember("warmup", warmup_counters, alloc);
+      }
+      if (counters.has_allocations()) {
+        const auto& allocations = counters.allocations();
+        rapidjson::Value allocation_counters(rapidjson::kObjectType);
+        allocation_counters.AddMember("requests",
+                                      rapidjson::Value().SetUint64(allocations.requests()), alloc);
+        allocation_counters.AddMember("allocations",
+                                      rapidjson::Value().SetUint64(allocations.allocations()),
+                                      alloc);
+        allocation_counters.AddMember("bytes", rapidjson::Value().SetUint64(allocations.bytes()),
+                                      alloc);
+        allocation_counters.AddMember("max_peak_bytes",
+                                      rapidjson::Value().SetUint64(allocations.max_peak_bytes()),
+                                      alloc);
+        service.AddMember("allocations", allocation_counters, alloc);
+      }
+      counters_list.GetArray().PushBack(service, alloc);
+    }
+    status_doc.AddMember("counters", counters_list, alloc);
+  }
+
   return rapidjson::to_string(status_doc);
 }
 
@@ -210,6 +283,18 @@ std::string serializePbf(Api& request) {
       case Options::status:
         selection.set_status(true);
         break;
+      case Options::isochrone:
+        selection.set_isochrone(true);
+        break;
+      case Options::sources_to_targets:
+        selection.set_matrix(true);
+        break;
+      case Options::height:
+        selection.set_height(true);
+        break;
+      case Options::expansion:
+        selection.set_expansion(true);
+        break;
       // should never get here, actions which dont have pbf yet return json
       default:
         throw std::logic_error("Requested action is not yet serializable as pbf");
@@ -231,6 +316,14 @@ std::string serializePbf(Api& request) {
     request.clear_directions();
   if (!selection.status())
     request.clear_status();
+  if (!selection.isochrone())
+    request.clear_isochrone();
+  if (!selection.matrix())
+    request.clear_matrix();
+  if (!selection.height())
+    request.clear_height();
+  if (!selection.expansion())
+    request.clear_expansion();
   if (!selection.options())
     request.clear_options();
 
@@ -306,6 +399,53 @@ waypoint(const valhalla::Location& location, bool is_tracepoint, bool is_optimiz
   return waypoint;
 }
 
+// Stream a location (waypoint) in OSRM compatible format, same as above without building a tree
+void waypoint(const valhalla::Location& location,
+              rapidjson::writer_wrapper_t& writer,
+              bool is_tracepoint,
+              bool is_optimized) {
+  writer.start_object();
+
+  // Output location as a lon,lat array. Note this is the projected
+  // lon,lat on the nearest road.
+  writer.set_precision(6);
+  writer.start_array("location");
+  writer(location.correlation().edges(0).ll().lng());
+  writer(location.correlation().edges(0).ll().lat());
+  writer.end_array();
+
+  // Add street name.
+  bool has_name =
+      location.correlation().edges_size() && location.correlation().edges(0).names_size();
+  writer("name", has_name ? location.correlation().edges(0).names(0) : std::string());
+
+  // Add distance in meters from the input location to the nearest
+  // point on the road used in the route
+  writer.set_precision(3);
+  writer("distance", to_ll(location.ll()).Distance(to_ll(location.correlation().edges(0).ll())));
+
+  // If the location was used for a tracepoint we trigger extra serialization
+  if (is_tracepoint) {
+    writer("alternatives_count", static_cast<uint64_t>(location.correlation().edges_size() - 1));
+    if (location.correlation().waypoint_index() == numeric_limits<uint32_t>::max()) {
+      writer("waypoint_index", nullptr);
+    } else {
+      writer("waypoint_index", static_cast<uint64_t>(location.correlation().waypoint_index()));
+    }
+    writer("matchings_index", static_cast<uint64_t>(location.correlation().route_index()));
+  }
+
+  // If the location was used for optimized route we add trips_index and waypoint
+  // index (index of the waypoint in the trip)
+  if (is_optimized) {
+    int trips_index = 0; // TODO
+    writer("trips_index", static_cast<uint64_t>(trips_index));
+    writer("waypoint_index", static_cast<uint64_t>(location.correlation().waypoint_index()));
+  }
+
+  writer.end_object();
+}
+
 // Serialize locations (called waypoints in OSRM). Waypoints are described here:
 //     http://project-osrm.org/docs/v5.5.1/api/#waypoint-object
 json::ArrayPtr waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
@@ -321,6 +461,21 @@ json::ArrayPtr waypoints(const google::protobuf::RepeatedPtrField<valhalla::Loca
   return waypoints;
 }
 
+void waypoints(const char* name,
+               const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               rapidjson::writer_wrapper_t& writer,
+               bool is_tracepoint) {
+  writer.start_array(name);
+  for (const auto& location : locations) {
+    if (location.correlation().edges().size() == 0) {
+      writer(nullptr);
+    } else {
+      waypoint(location, writer, is_tracepoint);
+    }
+  }
+  writer.end_array();
+}
+
 json::ArrayPtr waypoints(const valhalla::Trip& trip) {
   auto waypoints = json::array({});
   // For multi-route the same waypoints are used for all routes.
@@ -124,6 +124,16 @@ void serialize_edges(const AttributesController& controller,
           writer("mean_elevation", static_cast<int64_t>(mean));
         }
       }
+      if (controller(kEdgeElevation) && edge.elevation_size() > 0) {
+        // Convert to feet if units are miles
+        const float to_units = options.units() == Options::miles ? kFeetPerMeter : 1.f;
+        writer.set_precision(1);
+        writer.start_array("elevation");
+        for (const auto elevation : edge.elevation()) {
+          writer(elevation * to_units);
+        }
+        writer.end_array();
+      }
       if (controller(kEdgeWayId)) {
         writer("way_id", static_cast<uint64_t>(edge.way_id()));
       }
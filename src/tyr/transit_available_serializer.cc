@@ -1,7 +1,6 @@
 #include <cstdint>
 #include <unordered_set>
 
-#include "baldr/json.h"
 #include "tyr/serializers.h"
 
 using namespace valhalla;
@@ -9,13 +8,15 @@ using namespace valhalla::baldr;
 
 namespace {
 
-json::MapPtr serialize(const PathLocation& location, bool istransit) {
-  // serialze all the edges
-  auto json = json::map({{"input_lat", json::fixed_t{location.latlng_.lat(), 6}},
-                         {"input_lon", json::fixed_t{location.latlng_.lng(), 6}},
-                         {"radius", static_cast<uint64_t>(location.radius_)}});
-  json->emplace("istransit", istransit);
-  return json;
+void serialize(const baldr::Location& location,
+               bool istransit,
+               rapidjson::writer_wrapper_t& writer) {
+  writer.start_object();
+  writer("input_lat", location.latlng_.lat());
+  writer("input_lon", location.latlng_.lng());
+  writer("radius", static_cast<uint64_t>(location.radius_));
+  writer("istransit", istransit);
+  writer.end_object();
 }
 } // namespace
 
@@ -25,13 +26,14 @@ namespace tyr {
 std::string serializeTransitAvailable(const Api& /* request */,
                                       const std::vector<baldr::Location>& locations,
                                       const std::unordered_set<baldr::Location>& found) {
-  auto json = json::array({});
+  rapidjson::writer_wrapper_t writer(1024);
+  writer.set_precision(6);
+  writer.start_array();
   for (const auto& location : locations) {
-    json->emplace_back(serialize(location, found.find(location) != found.cend()));
+    serialize(location, found.find(location) != found.cend(), writer);
   }
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_array();
+  return writer.get_buffer();
 }
 
 } // namespace tyr
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+using action_t = std::string (tyr::actor_t::*)(const std::string&,
+                                               const std::function<void()>*,
+                                               Api*);
+const std::unordered_map<std::string, action_t> kActions{
+    {"route", &tyr::actor_t::route},
+    {"sources_to_targets", &tyr::actor_t::matrix},
+    {"optimized_route", &tyr::actor_t::optimized_route},
+    {"isochrone", &tyr::actor_t::isochrone},
+};
+
+// what one worker thread did in a round
+struct worker_result_t {
+  std::vector<double> latencies_ms; // of the requests which succeeded
+  size_t failed = 0;
+  baldr::GraphReader::CacheStats before{};
+  baldr::GraphReader::CacheStats after{};
+};
+
+// the latency below which the given fraction of the sorted latencies are
+double percentile(const std::vector<double>& sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+  return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+std::string fixed(double value, int precision = 2) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(precision) << value;
+  return ss.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  boost::property_tree::ptree pt;
+  std::vector<std::string> input_files;
+  std::vector<size_t> thread_counts;
+  std::string action_name;
+  size_t passes;
+
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_benchmark_thor",
+      "valhalla_benchmark_thor " VALHALLA_VERSION "\n\n"
+      "valhalla_benchmark_thor replays a corpus of requests, one json request per line, on a\n"
+      "number of threads which each have their own actor and graph reader. Each thread count is a\n"
+      "round which starts with cold tile caches. For every round it reports the throughput, the\n"
+      "latency percentiles and what the tile caches of the readers did, including how often they\n"
+      "waited for each other when they share the global synchronized cache.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>())
+      ("i,inline-config", "Inline json config.", cxxopts::value<std::string>())
+      ("t,threads", "Comma separated thread counts, one round for each.", cxxopts::value<std::vector<size_t>>(thread_counts)->default_value(std::to_string(std::thread::hardware_concurrency())))
+      ("a,action", "The action of the requests: route, sources_to_targets, optimized_route or isochrone.", cxxopts::value<std::string>(action_name)->default_value("route"))
+      ("p,passes", "How many times each round replays the corpus.", cxxopts::value<size_t>(passes)->default_value("1"))
+      ("cache", "Overrides the tile cache type of the config: flat, simple or lru.", cxxopts::value<std::string>())
+      ("synchronized", "Makes the readers share the global synchronized tile cache.", cxxopts::value<bool>()->default_value("false"))
+      ("shards", "Overrides mjolnir.global_cache_shards.", cxxopts::value<size_t>())
+      ("max-cache-size", "Overrides mjolnir.max_cache_size in bytes.", cxxopts::value<size_t>())
+      ("input_files", "positional arguments", cxxopts::value<std::vector<std::string>>(input_files));
+    // clang-format on
+
+    options.parse_positional({"input_files"});
+    options.positional_help("REQUESTS.TXT");
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_benchmark_thor " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (!result.count("input_files")) {
+      std::cerr << "Input file is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    if (!kActions.count(action_name)) {
+      std::cerr << "Unsupported action " << action_name << "\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    // Read the config file
+    if (result.count("inline-config")) {
+      std::stringstream ss;
+      ss << result["inline-config"].as<std::string>();
+      rapidjson::read_json(ss, pt);
+    } else if (result.count("config") &&
+               filesystem::is_regular_file(result["config"].as<std::string>())) {
+      rapidjson::read_json(result["config"].as<std::string>(), pt);
+    } else {
+      std::cerr << "Configuration is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    // the cache settings to compare
+    if (result.count("cache")) {
+      const auto cache = result["cache"].as<std::string>();
+      if (cache != "flat" && cache != "simple" && cache != "lru") {
+        std::cerr << "Unsupported cache " << cache << "\n\n" << options.help() << "\n\n";
+        return EXIT_FAILURE;
+      }
+      pt.put("mjolnir.use_lru_mem_cache", cache == "lru");
+      pt.put("mjolnir.use_simple_mem_cache", cache == "simple");
+    }
+    if (result["synchronized"].as<bool>()) {
+      pt.put("mjolnir.global_synchronized_cache", true);
+    }
+    if (result.count("shards")) {
+      pt.put("mjolnir.global_cache_shards", result["shards"].as<size_t>());
+    }
+    if (result.count("max-cache-size")) {
+      pt.put("mjolnir.max_cache_size", result["max-cache-size"].as<size_t>());
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // configure logging
+  auto logging_subtree = pt.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                                   std::unordered_map<std::string, std::string>>(
+        logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // the corpus
+  std::vector<std::string> requests;
+  for (const auto& file : input_files) {
+    std::ifstream stream(file);
+    if (!stream) {
+      LOG_ERROR("Could not open " + file);
+      return EXIT_FAILURE;
+    }
+    std::string line;
+    while (std::getline(stream, line)) {
+      if (!line.empty()) {
+        requests.emplace_back(std::move(line));
+      }
+    }
+  }
+  if (requests.empty()) {
+    LOG_ERROR("There are no requests to replay");
+    return EXIT_FAILURE;
+  }
+
+  const auto action = kActions.at(action_name);
+  const bool shared_cache = pt.get<bool>("mjolnir.global_synchronized_cache", false);
+  double first_throughput = 0;
+  for (auto threads : thread_counts) {
+    threads = std::max<size_t>(threads, 1);
+
+    // the readers and actors are made before the clock starts, their caches start out cold
+    std::vector<std::unique_ptr<baldr::GraphReader>> readers;
+    std::vector<std::unique_ptr<tyr::actor_t>> actors;
+    for (size_t i = 0; i < threads; ++i) {
+      readers.emplace_back(new baldr::GraphReader(pt.get_child("mjolnir")));
+      readers.back()->Clear();
+      actors.emplace_back(new tyr::actor_t(pt, *readers.back(), true));
+    }
+
+    // each thread takes the next request until the passes over the corpus are done
+    std::atomic<size_t> next(0);
+    std::vector<worker_result_t> results(threads);
+    auto work = [&](size_t i) {
+      auto& result = results[i];
+      result.before = readers[i]->GetCacheStats();
+      for (size_t r = next++; r < requests.size() * passes; r = next++) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+          ((*actors[i]).*action)(requests[r % requests.size()], nullptr, nullptr);
+          std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - start;
+          result.latencies_ms.push_back(elapsed.count());
+        } catch (...) {
+          actors[i]->cleanup();
+          ++result.failed;
+        }
+      }
+      result.after = readers[i]->GetCacheStats();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; ++i) {
+      pool.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    // add up what the threads did, a shared cache reports the same evictions to every reader
+    std::vector<double> latencies;
+    size_t failed = 0;
+    uint64_t hits = 0, misses = 0, loaded = 0, evictions = 0, lock_waits = 0;
+    double load_ms = 0;
+    for (const auto& result : results) {
+      latencies.insert(latencies.end(), result.latencies_ms.begin(), result.latencies_ms.end());
+      failed += result.failed;
+      hits += result.after.hits - result.before.hits;
+      misses += result.after.misses - result.before.misses;
+      loaded += result.after.tiles_loaded - result.before.tiles_loaded;
+      load_ms += result.after.load_ms - result.before.load_ms;
+      lock_waits += result.after.lock_waits - result.before.lock_waits;
+      auto evicted = result.after.evictions - result.before.evictions;
+      evictions = shared_cache ? std::max(evictions, evicted) : evictions + evicted;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const double throughput = latencies.size() / wall.count();
+    if (first_throughput == 0) {
+      first_throughput = throughput;
+    }
+    const auto lookups = std::max<uint64_t>(hits + misses, 1);
+
+    LOG_INFO("Threads: " + std::to_string(threads));
+    LOG_INFO("--------------------------------");
+    LOG_INFO("Requests: " + std::to_string(latencies.size()) + " succeeded, " +
+             std::to_string(failed) + " failed in " + fixed(wall.count()) + "s");
+    LOG_INFO("Throughput: " + fixed(throughput) + " requests/s (" +
+             fixed(first_throughput > 0 ? throughput / first_throughput : 0) +
+             "x the first round)");
+    LOG_INFO("Latency: p50 " + fixed(percentile(latencies, .5)) + "ms, p90 " +
+             fixed(percentile(latencies, .9)) + "ms, p99 " + fixed(percentile(latencies, .99)) +
+             "ms, max " + fixed(latencies.empty() ? 0 : latencies.back()) + "ms");
+    LOG_INFO("Tile cache: " + std::to_string(hits) + " hits, " + std::to_string(misses) +
+             " misses (" + fixed(100. * hits / lookups) + "% hit), " + std::to_string(loaded) +
+             " tiles loaded in " + fixed(load_ms) + "ms, " + std::to_string(evictions) +
+             " evictions");
+    LOG_INFO("Cache contention: " + std::to_string(lock_waits) + " lock waits (" +
+             fixed(1000. * lock_waits / lookups) + " per 1000 lookups)");
+    LOG_INFO("--------------------------------\n\n");
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/constants.h"
+#include "midgard/logging.h"
+#include "thor/matrix_table.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+using valhalla::thor::MatrixTable;
+
+namespace {
+
+// the departures are in the first week of 2024 which starts on a monday, far enough in the past
+// that the times are those of the predicted speeds rather than live traffic
+std::string departure(const uint32_t second_of_week) {
+  char date_time[32];
+  std::snprintf(date_time, sizeof(date_time), "2024-01-%02uT%02u:%02u",
+                1 + second_of_week / midgard::kSecondsPerDay,
+                (second_of_week % midgard::kSecondsPerDay) / 3600, (second_of_week % 3600) / 60);
+  return date_time;
+}
+
+// the matrix of all the locations to all the locations, at a departure time or without one
+std::vector<MatrixTable::entry_t> build(tyr::actor_t& actor,
+                                        const rapidjson::Document& request,
+                                        const std::string& date_time,
+                                        Api& api) {
+  rapidjson::Document doc;
+  doc.CopyFrom(request, doc.GetAllocator());
+  auto& allocator = doc.GetAllocator();
+  for (const auto* member : {"sources", "targets", "format", "compact_matrix", "date_time"}) {
+    doc.RemoveMember(member);
+  }
+  doc.AddMember("sources", rapidjson::Value(request["locations"], allocator), allocator);
+  doc.AddMember("targets", rapidjson::Value(request["locations"], allocator), allocator);
+  doc.RemoveMember("locations");
+  // whole seconds and meters
+  doc.AddMember("format", "pbf", allocator);
+  doc.AddMember("compact_matrix", true, allocator);
+  if (!date_time.empty()) {
+    rapidjson::Value departure(rapidjson::kObjectType);
+    departure.AddMember("type", 1, allocator);
+    departure.AddMember("value", rapidjson::Value(date_time, allocator), allocator);
+    doc.AddMember("date_time", departure, allocator);
+  }
+
+  api.Clear();
+  actor.matrix(rapidjson::to_string(doc), nullptr, &api);
+  const auto& matrix = api.matrix();
+  const auto columns = static_cast<size_t>(api.options().targets_size());
+  std::vector<MatrixTable::entry_t> entries(matrix.time_deltas_size());
+  int64_t time = 0, dist = 0;
+  for (int i = 0; i < matrix.time_deltas_size(); ++i) {
+    if (i % columns == 0) {
+      time = dist = 0;
+    }
+    time += matrix.time_deltas(i);
+    dist += matrix.distance_deltas(i);
+    // the values are one more than the seconds and meters, 0 when there is no route
+    if (time == 0) {
+      entries[i] = {MatrixTable::kUnreachable, MatrixTable::kUnreachable};
+    } else {
+      entries[i] = {static_cast<uint32_t>(time - 1), static_cast<uint32_t>(dist - 1)};
+    }
+  }
+  return entries;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string config, json, input_file, output;
+  uint32_t bucket_minutes;
+
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_build_matrix_table",
+      "valhalla_build_matrix_table " VALHALLA_VERSION "\n\n"
+      "valhalla_build_matrix_table works out the times and distances between all the pairs of a\n"
+      "fixed set of locations, e.g. the depots and delivery zones of a fleet, for one costing and\n"
+      "writes them to a table. With the table as thor.matrix_table the matrices with these\n"
+      "locations look their pairs up and only search for the other locations. The request is\n"
+      "that of a matrix with the set as its locations rather than sources and targets. With\n"
+      "--bucket-minutes the table also has the matrices departing at the start of each slot of\n"
+      "the week on predicted speeds, these answer the departures closest to them.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>(config))
+      ("j,json", "The request, e.g. '{\"locations\":[{\"lat\":52.51,\"lon\":13.38},{\"lat\":52.52,\"lon\":13.41}],\"costing\":\"auto\"}'.", cxxopts::value<std::string>(json))
+      ("i,input", "A file with the request instead of --json.", cxxopts::value<std::string>(input_file))
+      ("b,bucket-minutes", "The length of the departure slots, 0 for a table without departure times.", cxxopts::value<uint32_t>(bucket_minutes)->default_value("0"))
+      ("o,output", "The file to write the table to.", cxxopts::value<std::string>(output)->default_value("matrix_table.bin"));
+    // clang-format on
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_build_matrix_table " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (!filesystem::is_regular_file(config)) {
+      std::cerr << "Configuration file is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    if (!input_file.empty()) {
+      std::ifstream file(input_file);
+      std::stringstream contents;
+      contents << file.rdbuf();
+      json = contents.str();
+    }
+    if (json.empty()) {
+      std::cerr << "A request is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  rapidjson::Document request;
+  request.Parse(json.c_str());
+  if (request.HasParseError() || !request.IsObject() || !request.HasMember("locations") ||
+      !request["locations"].IsArray() || request["locations"].Empty()) {
+    LOG_ERROR("The request needs the locations of the table");
+    return EXIT_FAILURE;
+  }
+  const size_t count = request["locations"].Size();
+
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config, pt);
+  auto logging_subtree = pt.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                                   std::unordered_map<std::string, std::string>>(
+        logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+  // every pair has to be searched for rather than looked up in an older table
+  pt.put("thor.matrix_table", "");
+  pt.put("thor.response_cache_size", 0);
+  pt.put("thor.search_tree_cache_size", 0);
+  const auto costing = rapidjson::get<std::string>(request, "/costing", "auto");
+  pt.put("service_limits." + costing + ".max_matrix_location_pairs", count * count);
+  tyr::actor_t actor(pt, true);
+
+  // the first bucket is without a departure time, then one per slot of the week
+  const uint32_t bucket_seconds = bucket_minutes * 60;
+  const uint32_t slots =
+      bucket_seconds ? (midgard::kSecondsPerWeek + bucket_seconds - 1) / bucket_seconds : 0;
+  std::vector<std::vector<MatrixTable::entry_t>> buckets;
+  std::vector<MatrixTable::location_t> locations;
+  uint64_t key = 0;
+  try {
+    for (uint32_t bucket = 0; bucket <= slots; ++bucket) {
+      Api api;
+      const auto date_time = bucket ? departure((bucket - 1) * bucket_seconds) : "";
+      buckets.push_back(build(actor, request, date_time, api));
+      if (bucket == 0) {
+        key = MatrixTable::Key(api.options());
+        for (const auto& location : api.options().sources()) {
+          locations.push_back(MatrixTable::Round(location));
+        }
+      }
+      LOG_INFO("Built bucket " + std::to_string(bucket) + " of " + std::to_string(slots) +
+               (date_time.empty() ? "" : " departing " + date_time));
+    }
+  } catch (const valhalla_exception_t& e) {
+    LOG_ERROR("The matrix failed: " + std::to_string(e.code) + " " + e.message);
+    return EXIT_FAILURE;
+  } catch (const std::exception& e) {
+    LOG_ERROR(std::string("The matrix failed: ") + e.what());
+    return EXIT_FAILURE;
+  }
+
+  if (!MatrixTable::Write(output, key, bucket_seconds, locations, buckets)) {
+    LOG_ERROR("Could not write the table to " + output);
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Wrote the table of " + std::to_string(count) + " locations to " + output);
+  return EXIT_SUCCESS;
+}
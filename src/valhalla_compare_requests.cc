@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+using action_t = std::string (tyr::actor_t::*)(const std::string&,
+                                               const std::function<void()>*,
+                                               Api*);
+const std::unordered_map<std::string, action_t> kActions{
+    {"route", &tyr::actor_t::route},
+    {"sources_to_targets", &tyr::actor_t::matrix},
+    {"optimized_route", &tyr::actor_t::optimized_route},
+    {"isochrone", &tyr::actor_t::isochrone},
+    {"trace_route", &tyr::actor_t::trace_route},
+    {"trace_attributes", &tyr::actor_t::trace_attributes},
+};
+
+// what one side did with one request
+struct outcome_t {
+  double ms = 0;       // the fastest of the repeats
+  double labels = 0;   // created by the path algorithms, 0 if the action doesn't count them
+  double seconds = -1; // the time of the first route, -1 if there are no directions
+  std::string response;
+  std::string error;
+};
+
+outcome_t run(tyr::actor_t& actor, action_t action, const std::string& request, size_t repeats) {
+  outcome_t outcome;
+  outcome.ms = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < repeats; ++i) {
+    Api api;
+    auto start = std::chrono::steady_clock::now();
+    try {
+      outcome.response = (actor.*action)(request, nullptr, &api);
+    } catch (const valhalla_exception_t& e) {
+      actor.cleanup();
+      outcome.error = std::to_string(e.code) + " " + e.message;
+    } catch (const std::exception& e) {
+      actor.cleanup();
+      outcome.error = e.what();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    outcome.ms = std::min(outcome.ms, elapsed.count());
+
+    // the work and the result only need to be looked at once
+    if (i == 0) {
+      for (const auto& stat : api.info().statistics()) {
+        const std::string suffix = ".labels";
+        if (stat.key().size() > suffix.size() &&
+            stat.key().compare(stat.key().size() - suffix.size(), suffix.size(), suffix) == 0) {
+          outcome.labels += stat.value();
+        }
+      }
+      if (api.directions().routes_size() > 0) {
+        outcome.seconds = 0;
+        for (const auto& leg : api.directions().routes(0).legs()) {
+          outcome.seconds += leg.summary().time();
+        }
+      }
+    }
+  }
+  return outcome;
+}
+
+std::string fixed(double value, int precision = 2) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(precision) << value;
+  return ss.str();
+}
+
+double percentile(std::vector<double> values, double fraction) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  auto rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+  return values[std::min(std::max<size_t>(rank, 1), values.size()) - 1];
+}
+
+boost::property_tree::ptree read_config(const std::string& path) {
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(path, pt);
+  // the global synchronized cache is one per process, both sides would read the same tiles
+  pt.put("mjolnir.global_synchronized_cache", false);
+  // the repeats have to compute their responses
+  pt.put("thor.response_cache_size", 0);
+  return pt;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string config_a, config_b, action_name, output;
+  std::vector<std::string> input_files;
+  size_t repeats, worst;
+  double threshold;
+
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_compare_requests",
+      "valhalla_compare_requests " VALHALLA_VERSION "\n\n"
+      "valhalla_compare_requests replays a corpus of requests, one json request per line, against\n"
+      "two configurations, e.g. an old and a new tileset or different settings, to check a change\n"
+      "for performance regressions before it is rolled out. Each request is run on both sides in\n"
+      "turn. It reports the latency of both sides, the requests which got slower than the\n"
+      "threshold, the labels the path algorithms created and the requests whose responses differ.\n"
+      "To compare two builds write the per request results of each with --output and diff\n"
+      "them.\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("a,config-a", "Path to the json configuration of the baseline.", cxxopts::value<std::string>(config_a))
+      ("b,config-b", "Path to the json configuration to compare with the baseline.", cxxopts::value<std::string>(config_b))
+      ("action", "The action of the requests: route, sources_to_targets, optimized_route, isochrone, trace_route or trace_attributes.", cxxopts::value<std::string>(action_name)->default_value("route"))
+      ("r,repeat", "How many times each request is run on each side, the fastest run counts.", cxxopts::value<size_t>(repeats)->default_value("3"))
+      ("threshold", "Percent by which a request has to be slower to count as a regression.", cxxopts::value<double>(threshold)->default_value("10"))
+      ("worst", "How many of the worst regressions to list.", cxxopts::value<size_t>(worst)->default_value("10"))
+      ("o,output", "File to write the results of every request to as csv.", cxxopts::value<std::string>(output))
+      ("input_files", "positional arguments", cxxopts::value<std::vector<std::string>>(input_files));
+    // clang-format on
+
+    options.parse_positional({"input_files"});
+    options.positional_help("REQUESTS.TXT");
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_compare_requests " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (!result.count("input_files")) {
+      std::cerr << "Input file is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    if (!filesystem::is_regular_file(config_a) || !filesystem::is_regular_file(config_b)) {
+      std::cerr << "Both configurations are required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    if (!kActions.count(action_name)) {
+      std::cerr << "Unsupported action " << action_name << "\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const auto pt_a = read_config(config_a);
+  const auto pt_b = read_config(config_b);
+
+  // configure logging
+  auto logging_subtree = pt_a.get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                                   std::unordered_map<std::string, std::string>>(
+        logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // the corpus
+  std::vector<std::string> requests;
+  for (const auto& file : input_files) {
+    std::ifstream stream(file);
+    if (!stream) {
+      LOG_ERROR("Could not open " + file);
+      return EXIT_FAILURE;
+    }
+    std::string line;
+    while (std::getline(stream, line)) {
+      if (!line.empty()) {
+        requests.emplace_back(std::move(line));
+      }
+    }
+  }
+
+  std::ofstream csv;
+  if (!output.empty()) {
+    csv.open(output);
+    if (!csv) {
+      LOG_ERROR("Could not open " + output);
+      return EXIT_FAILURE;
+    }
+    csv << "request,ms_a,ms_b,delta_percent,labels_a,labels_b,seconds_a,seconds_b,result\n";
+  }
+
+  // each request runs on one side and then the other so that both see the same conditions
+  const auto action = kActions.at(action_name);
+  tyr::actor_t actor_a(pt_a, true);
+  tyr::actor_t actor_b(pt_b, true);
+  std::vector<double> ms_a, ms_b;
+  std::vector<std::pair<double, size_t>> regressions;
+  double labels_a = 0, labels_b = 0;
+  size_t different = 0, failed_a = 0, failed_b = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    const auto a = run(actor_a, action, requests[i], std::max<size_t>(repeats, 1));
+    const auto b = run(actor_b, action, requests[i], std::max<size_t>(repeats, 1));
+    ms_a.push_back(a.ms);
+    ms_b.push_back(b.ms);
+    labels_a += a.labels;
+    labels_b += b.labels;
+    failed_a += !a.error.empty();
+    failed_b += !b.error.empty();
+
+    std::string result = "same";
+    if (a.error != b.error) {
+      result = a.error.empty() ? "failed_b" : (b.error.empty() ? "failed_a" : "different_error");
+    } else if (a.response != b.response) {
+      result = "different";
+    }
+    different += result != "same";
+
+    const double delta = a.ms > 0 ? 100. * (b.ms - a.ms) / a.ms : 0;
+    if (delta > threshold) {
+      regressions.emplace_back(delta, i);
+    }
+    if (csv.is_open()) {
+      csv << i << ',' << fixed(a.ms, 3) << ',' << fixed(b.ms, 3) << ',' << fixed(delta) << ','
+          << a.labels << ',' << b.labels << ',' << fixed(a.seconds) << ',' << fixed(b.seconds)
+          << ',' << result << '\n';
+    }
+  }
+
+  double total_a = 0, total_b = 0;
+  for (size_t i = 0; i < ms_a.size(); ++i) {
+    total_a += ms_a[i];
+    total_b += ms_b[i];
+  }
+  const auto change = [](double a, double b) {
+    return (b >= a ? "+" : "") + fixed(a > 0 ? 100. * (b - a) / a : 0) + "%";
+  };
+
+  LOG_INFO("Requests: " + std::to_string(requests.size()) + ", " + std::to_string(failed_a) +
+           " failed on a, " + std::to_string(failed_b) + " failed on b");
+  LOG_INFO("Total: " + fixed(total_a) + "ms on a, " + fixed(total_b) + "ms on b (" +
+           change(total_a, total_b) + ")");
+  for (const auto& p : {std::make_pair("p50", .5), std::make_pair("p90", .9),
+                        std::make_pair("p99", .99)}) {
+    const auto pa = percentile(ms_a, p.second), pb = percentile(ms_b, p.second);
+    LOG_INFO(std::string(p.first) + ": " + fixed(pa) + "ms on a, " + fixed(pb) + "ms on b (" +
+             change(pa, pb) + ")");
+  }
+  LOG_INFO("Labels: " + fixed(labels_a, 0) + " on a, " + fixed(labels_b, 0) + " on b (" +
+           change(labels_a, labels_b) + ")");
+  LOG_INFO("Different results: " + std::to_string(different));
+  LOG_INFO("Regressions over " + fixed(threshold, 1) + "%: " + std::to_string(regressions.size()));
+  std::sort(regressions.rbegin(), regressions.rend());
+  for (size_t i = 0; i < std::min(worst, regressions.size()); ++i) {
+    const auto r = regressions[i].second;
+    LOG_INFO("  request " + std::to_string(r) + ": " + fixed(ms_a[r]) + "ms -> " + fixed(ms_b[r]) +
+             "ms (+" + fixed(regressions[i].first) + "%)");
+  }
+
+  return EXIT_SUCCESS;
+}
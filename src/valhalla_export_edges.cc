@@ -9,8 +9,12 @@
 #include "midgard/logging.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cxxopts.hpp>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -20,31 +24,34 @@ using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 
 // global options instead of passing them around
-std::string row_separator, column_separator, config;
+std::string row_separator, column_separator, config, output;
 bool ferries, unnamed;
+unsigned int num_threads;
 
 namespace {
 
-// a place we can mark what edges we've seen, even for the planet we should need < 100mb
+// a place we can mark what edges we've seen, even for the planet we should need < 100mb. the
+// threads share it so marking is atomic, only one of them can ever claim an edge
 struct bitset_t {
-  bitset_t(size_t size) {
-    bits.resize(std::ceil(size / 64.0));
+  bitset_t(size_t size) : bits(std::ceil(size / 64.0)) {
   }
-  void set(const uint64_t id) {
+  // returns false if the id was already marked
+  bool set(const uint64_t id) {
     if (id >= bits.size() * 64) {
       throw std::runtime_error("id out of bounds");
     }
-    bits[id / 64] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    const auto bit = static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
+    return !(bits[id / 64].fetch_or(bit) & bit);
   }
   bool get(const uint64_t id) const {
     if (id >= bits.size() * 64) {
       throw std::runtime_error("id out of bounds");
     }
-    return bits[id / 64] & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
+    return bits[id / 64].load() & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
   }
 
 protected:
-  std::vector<uint64_t> bits;
+  std::vector<std::atomic<uint64_t>> bits;
 };
 
 // often we need both the edge id and the directed edge, so lets have something to represent that
@@ -71,8 +78,9 @@ edge_t opposing(GraphReader& reader, graph_tile_ptr tile, const GraphId& edge_id
   return {opp_id, opp_edge};
 }
 
+// find the next like-named edge and claim it so no other thread exports it
 edge_t next(const std::unordered_map<GraphId, uint64_t>& tile_set,
-            const bitset_t& edge_set,
+            bitset_t& edge_set,
             GraphReader& reader,
             graph_tile_ptr& tile,
             const edge_t& edge,
@@ -107,7 +115,8 @@ edge_t next(const std::unordered_map<GraphId, uint64_t>& tile_set,
     // names have to match
     auto candidate_names = tile->edgeinfo(candidate.e).GetNames();
     if (names.size() == candidate_names.size() &&
-        std::equal(names.cbegin(), names.cend(), candidate_names.cbegin())) {
+        std::equal(names.cbegin(), names.cend(), candidate_names.cbegin()) &&
+        edge_set.set(tile_set.find(tile->id())->second + id.id())) {
       return candidate;
     }
   }
@@ -137,113 +146,51 @@ void extend(GraphReader& reader,
   shape.splice(shape.end(), more);
 }
 
-} // namespace
-
-// program entry point
-int main(int argc, char* argv[]) {
-
-  try {
-    // clang-format off
-    cxxopts::Options options(
-      "valhalla_export_edges",
-      "valhalla_export_edges " VALHALLA_VERSION "\n\n"
-      "valhalla_export_edges is a simple command line test tool which\n"
-      "dumps information about each graph edge.\n\n");
-
-    using namespace std::string_literals;
-    options.add_options()
-      ("h,help", "Print this help message.")
-      ("v,version", "Print the version of this software.")
-      ("c,column", "What separator to use between columns [default=\\0].", cxxopts::value<std::string>(column_separator)->default_value("\0"s))
-      ("r,row", "What separator to use between row [default=\\n].", cxxopts::value<std::string>(row_separator)->default_value("\n"))
-      ("f,ferries", "Export ferries as well [default=false]", cxxopts::value<bool>(ferries)->default_value("false"))
-      ("u,unnamed", "Export unnamed edges as well [default=false]", cxxopts::value<bool>(unnamed)->default_value("false"))
-      ("config", "positional argument", cxxopts::value<std::string>(config));
-    // clang-format on
-
-    options.parse_positional({"config"});
-    options.positional_help("Config file path");
-    auto result = options.parse(argc, argv);
-
-    if (result.count("help")) {
-      std::cout << options.help() << "\n";
-      return EXIT_SUCCESS;
-    }
-
-    if (result.count("version")) {
-      std::cout << "valhalla_export_edges " << VALHALLA_VERSION << "\n";
-      return EXIT_SUCCESS;
-    }
-
-    if (!result.count("config") || !filesystem::is_regular_file(filesystem::path(config))) {
-      std::cerr << "Configuration file is required\n\n" << options.help() << "\n\n";
-      return EXIT_FAILURE;
-    }
-  } catch (const cxxopts::OptionException& e) {
-    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  // parse the config
-  boost::property_tree::ptree pt;
-  rapidjson::read_json(config.c_str(), pt);
-
-  // configure logging
-  valhalla::midgard::logging::Configure({{"type", "std_err"}, {"color", "true"}});
-
-  // get something we can use to fetch tiles
-  valhalla::baldr::GraphReader reader(pt.get_child("mjolnir"));
-
-  // keep the global number of edges encountered at the point we encounter each tile
-  // this allows an edge to have a sequential global id and makes storing it very small
-  LOG_INFO("Enumerating edges...");
-  std::unordered_map<GraphId, uint64_t> tile_set(kMaxGraphTileId * TileHierarchy::levels().size());
-  uint64_t edge_count = 0;
-  for (const auto& level : TileHierarchy::levels()) {
-    for (uint32_t i = 0; i < level.tiles.TileCount(); ++i) {
-      GraphId tile_id{i, level.level, 0};
-      if (reader.DoesTileExist(tile_id)) {
-        // TODO: just read the header, parsing the whole thing isnt worth it at this point
-        tile_set.emplace(tile_id, edge_count);
-        auto tile = reader.GetGraphTile(tile_id);
-        assert(tile);
-        edge_count += tile->header()->directededgecount();
-        reader.Clear();
-      }
-    }
+// state the exporting threads share
+struct export_t {
+  export_t(const boost::property_tree::ptree& config,
+           const std::unordered_map<GraphId, uint64_t>& tile_set,
+           uint64_t edge_count)
+      : config(config), tile_set(tile_set), tiles(tile_set.begin(), tile_set.end()),
+        edge_set(edge_count), edge_count(edge_count) {
   }
+  const boost::property_tree::ptree& config;
+  const std::unordered_map<GraphId, uint64_t>& tile_set;
+  std::vector<std::pair<GraphId, uint64_t>> tiles;
+  std::atomic<size_t> next_tile{0};
+  bitset_t edge_set;
+  uint64_t edge_count;
+  std::atomic<uint64_t> set{0};
+  std::atomic<int> progress{-1};
+  std::mutex output_lock;
+};
 
-  // this is how we know what i've touched and what we havent
-  bitset_t edge_set(edge_count);
-
-  // TODO: we could parallelize this and it might be quite a bit faster but if we really want to
-  // maximize continuous edges we need to avoid the lady and the tramp scenario where two threads
-  // are
-  // consuming the same stretch of road at the same time
-
-  // for each tile
-  LOG_INFO("Exporting " + std::to_string(edge_count) + " edges");
-  int progress = -1;
-  uint64_t set = 0;
-  for (const auto& tile_count_pair : tile_set) {
+// exports the like-named stretches of road starting in the tiles the thread takes. a stretch can
+// run into one another thread is exporting from its other end, the edges are claimed atomically so
+// where the two meet both of them stop and the road comes out in two rows rather than twice
+void export_tiles(export_t& state, std::ostream& out, bool shared_out) {
+  GraphReader reader(state.config);
+  auto& edge_set = state.edge_set;
+  const auto& tile_set = state.tile_set;
+  std::string row;
+  for (size_t k = state.next_tile++; k < state.tiles.size(); k = state.next_tile++) {
+    const auto& tile_count_pair = state.tiles[k];
+    uint64_t set = 0;
     // for each edge in the tile
     reader.Clear();
     auto tile = reader.GetGraphTile(tile_count_pair.first);
     assert(tile);
     for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
-      // we've seen this one already
-      if (edge_set.get(tile_count_pair.second + i)) {
-        continue;
-      }
-
       // TODO: dont mark transition edges since we may need to use them to change levels multiple
       // times maybe we should mark them though once every normal edge connected there has been
       // marked
 
-      // make sure we dont ever look at this again
+      // make sure we dont ever look at this again, unless we've seen this one already
+      if (!edge_set.set(tile_count_pair.second + i)) {
+        continue;
+      }
       edge_t edge{tile_count_pair.first, tile->directededge(i)};
       edge.i.set_id(i);
-      edge_set.set(tile_count_pair.second + i);
       ++set;
 
       // these wont have opposing edges that we care about
@@ -252,12 +199,14 @@ int main(int argc, char* argv[]) {
         continue;
       }
 
-      // get the opposing edge as well (ensure a valid edge is returned)
+      // get the opposing edge as well (ensure a valid edge is returned), if another thread got to
+      // it first that thread is exporting this road
       edge_t opposing_edge = opposing(reader, tile, edge);
-      if (opposing_edge.e == nullptr) {
+      if (opposing_edge.e == nullptr ||
+          !edge_set.set(tile_set.find(opposing_edge.i.Tile_Base())->second +
+                        opposing_edge.i.id())) {
         continue;
       }
-      edge_set.set(tile_set.find(opposing_edge.i.Tile_Base())->second + opposing_edge.i.id());
       ++set;
 
       // shortcuts arent real and maybe we dont want ferries
@@ -289,13 +238,15 @@ int main(int argc, char* argv[]) {
       auto t = tile;
       while ((edge = next(tile_set, edge_set, reader, t, edge, names))) {
         // mark them to never be used again
-        edge_set.set(tile_set.find(edge.i.Tile_Base())->second + edge.i.id());
         edge_t other = opposing(reader, t, edge);
+        ++set;
         if (other.e == nullptr) {
           continue;
         }
-        edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id());
-        set += 2;
+        if (!edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id())) {
+          break;
+        }
+        ++set;
         // keep this
         edges.push_back(edge);
       }
@@ -304,13 +255,15 @@ int main(int argc, char* argv[]) {
       edge = opposing_edge;
       while ((edge = next(tile_set, edge_set, reader, t, edge, names))) {
         // mark them to never be used again
-        edge_set.set(tile_set.find(edge.i.Tile_Base())->second + edge.i.id());
         edge_t other = opposing(reader, t, edge);
+        ++set;
         if (other.e == nullptr) {
           continue;
         }
-        edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id());
-        set += 2;
+        if (!edge_set.set(tile_set.find(other.i.Tile_Base())->second + other.i.id())) {
+          break;
+        }
+        ++set;
         // keep this
         edges.push_front(other);
       }
@@ -322,25 +275,148 @@ int main(int argc, char* argv[]) {
       }
 
       // output it as: shape,name,name,...
-      auto encoded = encode(shape);
-      std::cout << encoded << column_separator;
+      row = encode(shape);
+      row += column_separator;
       for (const auto& name : names) {
-        std::cout << name << (&name == &names.back() ? "" : column_separator);
+        row += name;
+        row += &name == &names.back() ? "" : column_separator;
+      }
+      row += row_separator;
+      if (shared_out) {
+        std::lock_guard<std::mutex> lock(state.output_lock);
+        out << row;
+        out.flush();
+      } else {
+        out << row;
       }
-      std::cout << row_separator;
-      std::cout.flush();
     }
 
     // check progress
-    int procent = (100.f * set) / edge_count;
+    int procent = (100.f * (state.set += set)) / state.edge_count;
+    int progress = state.progress.load();
+    while (procent > progress && !state.progress.compare_exchange_weak(progress, procent)) {
+    }
     if (procent > progress) {
-      LOG_INFO(std::to_string(progress = procent) + "%");
+      LOG_INFO(std::to_string(procent) + "%");
+    }
+  }
+}
+
+} // namespace
+
+// program entry point
+int main(int argc, char* argv[]) {
+
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_export_edges",
+      "valhalla_export_edges " VALHALLA_VERSION "\n\n"
+      "valhalla_export_edges is a simple command line test tool which\n"
+      "dumps information about each graph edge.\n\n");
+
+    using namespace std::string_literals;
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,column", "What separator to use between columns [default=\\0].", cxxopts::value<std::string>(column_separator)->default_value("\0"s))
+      ("r,row", "What separator to use between row [default=\\n].", cxxopts::value<std::string>(row_separator)->default_value("\n"))
+      ("f,ferries", "Export ferries as well [default=false]", cxxopts::value<bool>(ferries)->default_value("false"))
+      ("u,unnamed", "Export unnamed edges as well [default=false]", cxxopts::value<bool>(unnamed)->default_value("false"))
+      ("o,output", "Write the rows of each thread to its own file <output>.<thread> rather than to stdout.", cxxopts::value<std::string>(output)->default_value(""))
+      ("j,concurrency", "Number of threads to use.", cxxopts::value<unsigned int>(num_threads)->default_value(std::to_string(std::thread::hardware_concurrency())))
+      ("config", "positional argument", cxxopts::value<std::string>(config));
+    // clang-format on
+
+    options.parse_positional({"config"});
+    options.positional_help("Config file path");
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_export_edges " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (!result.count("config") || !filesystem::is_regular_file(filesystem::path(config))) {
+      std::cerr << "Configuration file is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // parse the config
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(config.c_str(), pt);
+
+  // configure logging
+  valhalla::midgard::logging::Configure({{"type", "std_err"}, {"color", "true"}});
+
+  // get something we can use to fetch tiles
+  valhalla::baldr::GraphReader reader(pt.get_child("mjolnir"));
+
+  // keep the global number of edges encountered at the point we encounter each tile
+  // this allows an edge to have a sequential global id and makes storing it very small
+  LOG_INFO("Enumerating edges...");
+  std::unordered_map<GraphId, uint64_t> tile_set(kMaxGraphTileId * TileHierarchy::levels().size());
+  uint64_t edge_count = 0;
+  for (const auto& level : TileHierarchy::levels()) {
+    for (uint32_t i = 0; i < level.tiles.TileCount(); ++i) {
+      GraphId tile_id{i, level.level, 0};
+      if (reader.DoesTileExist(tile_id)) {
+        // TODO: just read the header, parsing the whole thing isnt worth it at this point
+        tile_set.emplace(tile_id, edge_count);
+        auto tile = reader.GetGraphTile(tile_id);
+        assert(tile);
+        edge_count += tile->header()->directededgecount();
+        reader.Clear();
+      }
+    }
+  }
+
+  // this is how we know what i've touched and what we havent
+  export_t state(pt.get_child("mjolnir"), tile_set, edge_count);
+
+  // each thread takes the next tile until there are none left and writes its own shard of the
+  // output, or they all take turns writing whole rows to stdout
+  num_threads = std::max(1u, num_threads);
+  LOG_INFO("Exporting " + std::to_string(edge_count) + " edges with " +
+           std::to_string(num_threads) + " threads");
+  std::vector<std::ofstream> shards(output.empty() ? 0 : num_threads);
+  for (size_t i = 0; i < shards.size(); ++i) {
+    shards[i].open(output + "." + std::to_string(i), std::ofstream::out | std::ofstream::trunc);
+    if (!shards[i]) {
+      LOG_ERROR("Could not open " + output + "." + std::to_string(i));
+      return EXIT_FAILURE;
+    }
+  }
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(num_threads);
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i]() {
+      try {
+        export_tiles(state, shards.empty() ? std::cout : shards[i], shards.empty());
+      } catch (...) { errors[i] = std::current_exception(); }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
     }
   }
   LOG_INFO("Done");
 
   for (uint64_t i = 0; i < edge_count; ++i) {
-    if (!edge_set.get(i)) {
+    if (!state.edge_set.get(i)) {
       LOG_INFO(std::to_string(i));
       break;
     }
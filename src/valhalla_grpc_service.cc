@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <grpcpp/grpcpp.h>
+
+#include "baldr/rapidjson_utils.h"
+#include "midgard/logging.h"
+#include "proto_conversions.h"
+#include "service.grpc.pb.h"
+#include "tyr/actor.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+// the actions whose responses can be serialized to an Api object
+const std::unordered_set<Options::Action> kPbfActions{
+    Options::route,     Options::optimized_route,    Options::trace_route,
+    Options::centroid,  Options::trace_attributes,   Options::status,
+    Options::isochrone, Options::sources_to_targets, Options::height,
+    Options::expansion,
+};
+
+// thrown by the interrupt once the client went away
+struct cancelled_t {};
+
+grpc::StatusCode status_code(unsigned http_code) {
+  switch (http_code) {
+    case 501:
+      return grpc::StatusCode::UNIMPLEMENTED;
+    case 503:
+      return grpc::StatusCode::UNAVAILABLE;
+    case 504:
+      return grpc::StatusCode::DEADLINE_EXCEEDED;
+    default:
+      return http_code < 500 ? grpc::StatusCode::INVALID_ARGUMENT : grpc::StatusCode::INTERNAL;
+  }
+}
+
+/**
+ * The actors answering the requests, each runs the loki, thor and odin workers of a request one
+ * after the other in the thread of the call. Calls wait for one to be idle.
+ */
+class actor_pool_t {
+public:
+  actor_pool_t(const boost::property_tree::ptree& config, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      actors_.emplace_back(new tyr::actor_t(config, true));
+      idle_.push_back(actors_.back().get());
+    }
+  }
+
+  // an idle actor, given back once the returned pointer is gone
+  std::shared_ptr<tyr::actor_t> borrow() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_changed_.wait(lock, [this]() { return !idle_.empty(); });
+    auto* actor = idle_.back();
+    idle_.pop_back();
+    return std::shared_ptr<tyr::actor_t>(actor, [this](tyr::actor_t* returned) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(returned);
+      }
+      idle_changed_.notify_one();
+    });
+  }
+
+private:
+  std::vector<std::unique_ptr<tyr::actor_t>> actors_;
+  std::vector<tyr::actor_t*> idle_;
+  std::mutex mutex_;
+  std::condition_variable idle_changed_;
+};
+
+class valhalla_service_t final : public Valhalla::Service {
+public:
+  explicit valhalla_service_t(actor_pool_t& actors) : actors_(actors) {
+  }
+
+  grpc::Status Act(grpc::ServerContext* context, const Api* request, Api* response) override {
+    Api api(*request);
+    return answer(*context, api, *response);
+  }
+
+  grpc::Status ActStream(grpc::ServerContext* context,
+                         grpc::ServerReaderWriter<Api, Api>* stream) override {
+    Api request;
+    while (stream->Read(&request)) {
+      Api response;
+      auto status = answer(*context, request, response);
+      if (ended(status)) {
+        return status;
+      }
+      if (!stream->Write(response)) {
+        return grpc::Status::CANCELLED;
+      }
+      request.Clear();
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ActBatch(grpc::ServerContext* context,
+                        const Batch* batch,
+                        grpc::ServerWriter<Api>* writer) override {
+    for (const auto& batch_request : batch->requests()) {
+      Api request(batch_request), response;
+      auto status = answer(*context, request, response);
+      if (ended(status)) {
+        return status;
+      }
+      if (!writer->Write(response)) {
+        return grpc::Status::CANCELLED;
+      }
+    }
+    return grpc::Status::OK;
+  }
+
+private:
+  // whether the call is over, the other errors only fail the request they happened on
+  static bool ended(const grpc::Status& status) {
+    return status.error_code() == grpc::StatusCode::CANCELLED ||
+           status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED;
+  }
+
+  /**
+   * Answers the request with an actor, the response is the Api object the http api returns for
+   * format=pbf or the one with the errors of the request when it fails
+   * @param context   the context of the call, its deadline and cancellation interrupt the request
+   * @param request   the request, it is used up
+   * @param response  the response
+   * @return the status of the request, the serialized response is its details when it failed
+   */
+  grpc::Status answer(grpc::ServerContext& context, Api& request, Api& response) {
+    const auto deadline = context.deadline();
+    const std::function<void()> interrupt = [&context, deadline]() {
+      if (std::chrono::system_clock::now() > deadline) {
+        throw valhalla_exception_t{446};
+      }
+      if (context.IsCancelled()) {
+        throw cancelled_t{};
+      }
+    };
+
+    request.mutable_options()->set_format(Options::pbf);
+    auto actor = actors_.borrow();
+    try {
+      if (!kPbfActions.count(request.options().action())) {
+        throw valhalla_exception_t{107, " over grpc for " +
+                                            Options_Action_Enum_Name(request.options().action())};
+      }
+      // the call may have ended while it waited for the actor
+      interrupt();
+      if (!response.ParseFromString(actor->act(request, &interrupt))) {
+        throw valhalla_exception_t{499, "Could not parse the response"};
+      }
+      return grpc::Status::OK;
+    } catch (const valhalla_exception_t& e) {
+      actor->cleanup();
+      response.ParseFromString(serialize_error(e, request));
+      return grpc::Status(status_code(e.http_code), e.message, response.SerializeAsString());
+    } catch (const cancelled_t&) {
+      actor->cleanup();
+      return grpc::Status::CANCELLED;
+    } catch (const std::exception& e) {
+      actor->cleanup();
+      response.ParseFromString(serialize_error({499, std::string(e.what())}, request));
+      return grpc::Status(grpc::StatusCode::INTERNAL, e.what(), response.SerializeAsString());
+    }
+  }
+
+  actor_pool_t& actors_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    LOG_ERROR("Usage: " + std::string(argv[0]) + " config/file.json [listen]");
+    return 1;
+  }
+
+  boost::property_tree::ptree config;
+  rapidjson::read_json(argv[1], config);
+  const auto listen = argc > 2 ? std::string(argv[2])
+                               : config.get<std::string>("grpc.listen", "0.0.0.0:50051");
+  auto workers = config.get<size_t>("grpc.workers", 0);
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const auto max_message_bytes = config.get<int>("grpc.max_message_bytes", 64 << 20);
+
+  actor_pool_t actors(config, workers);
+  valhalla_service_t service(actors);
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(listen, grpc::InsecureServerCredentials());
+  builder.SetMaxReceiveMessageSize(max_message_bytes);
+  builder.SetMaxSendMessageSize(max_message_bytes);
+  builder.RegisterService(&service);
+  auto server = builder.BuildAndStart();
+  if (!server) {
+    LOG_ERROR("Could not listen on " + listen);
+    return 1;
+  }
+  LOG_INFO("Listening on " + listen + " with " + std::to_string(workers) + " workers");
+  server->Wait();
+  return 0;
+}
@@ -190,7 +190,9 @@ int main(int argc, char* argv[]) {
         kv.first == "trace" || kv.first == "isochrone" || kv.first == "centroid" ||
         kv.first == "max_alternates" || kv.first == "max_exclude_polygons_length" ||
         kv.first == "status" || kv.first == "max_timedep_distance_matrix" ||
-        kv.first == "max_distance_disable_hierarchy_culling") {
+        kv.first == "max_distance_disable_hierarchy_culling" ||
+        kv.first == "max_matrix_departure_times" || kv.first == "max_expansion_edges" ||
+        kv.first == "max_comparisons") {
       continue;
     }
     max_matrix_distance.emplace(kv.first,
@@ -1,7 +1,6 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <list>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -21,11 +20,34 @@ using namespace prime_server;
 #endif
 
 #include "midgard/logging.h"
+#include "midgard/numa.h"
 
 #include "loki/worker.h"
 #include "odin/worker.h"
 #include "thor/worker.h"
 #include "tyr/actor.h"
+#include "tyr/pipeline.h"
+
+#ifdef HAVE_HTTP
+namespace {
+
+// starts the workers of a stage, pinned round robin to the first numa_nodes NUMA nodes if any
+void start_workers(void (*run_service)(const boost::property_tree::ptree&),
+                   const boost::property_tree::ptree& config,
+                   size_t concurrency,
+                   uint32_t numa_nodes) {
+  for (size_t i = 0; i < concurrency; ++i) {
+    std::thread([run_service, config, i, numa_nodes]() {
+      if (numa_nodes && !valhalla::midgard::numa_t::pin(i % numa_nodes)) {
+        LOG_WARN("Could not pin the worker to NUMA node " + std::to_string(i % numa_nodes));
+      }
+      run_service(config);
+    }).detach();
+  }
+}
+
+} // namespace
+#endif
 
 int main(int argc, char** argv) {
 #ifdef HAVE_HTTP
@@ -181,6 +203,13 @@ int main(int argc, char** argv) {
 
   uint32_t request_timeout = config.get<uint32_t>("httpd.service.timeout_seconds");
 
+  // how many NUMA nodes to spread the workers of each stage over, 0 to leave them unpinned
+  uint32_t numa_nodes = std::min<uint32_t>(config.get<uint32_t>("httpd.service.numa_nodes", 0),
+                                           valhalla::midgard::numa_t::nodes().size());
+  if (numa_nodes) {
+    LOG_INFO("Pinning workers to " + std::to_string(numa_nodes) + " NUMA nodes");
+  }
+
   // setup the cluster within this process
   zmq::context_t context;
   std::thread server_thread =
@@ -192,31 +221,29 @@ int main(int argc, char** argv) {
   std::thread loki_proxy_thread(
       std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
   loki_proxy_thread.detach();
-  std::list<std::thread> loki_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    loki_worker_threads.emplace_back(valhalla::loki::run_service, config);
-    loki_worker_threads.back().detach();
+
+  // every stage in one worker passing the request object along rather than its bytes
+  if (config.get<bool>("httpd.service.in_process", false)) {
+    start_workers(valhalla::tyr::run_service, config, worker_concurrency, numa_nodes);
+
+    // wait forever (or for interrupt)
+    server_thread.join();
+    return 0;
   }
 
+  start_workers(valhalla::loki::run_service, config, worker_concurrency, numa_nodes);
+
   // thor layer
   std::thread thor_proxy_thread(
       std::bind(&proxy_t::forward, proxy_t(context, thor_proxy + "_in", thor_proxy + "_out")));
   thor_proxy_thread.detach();
-  std::list<std::thread> thor_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    thor_worker_threads.emplace_back(valhalla::thor::run_service, config);
-    thor_worker_threads.back().detach();
-  }
+  start_workers(valhalla::thor::run_service, config, worker_concurrency, numa_nodes);
 
   // odin layer
   std::thread odin_proxy_thread(
       std::bind(&proxy_t::forward, proxy_t(context, odin_proxy + "_in", odin_proxy + "_out")));
   odin_proxy_thread.detach();
-  std::list<std::thread> odin_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    odin_worker_threads.emplace_back(valhalla::odin::run_service, config);
-    odin_worker_threads.back().detach();
-  }
+  start_workers(valhalla::odin::run_service, config, worker_concurrency, numa_nodes);
 
   // TODO: add multipoint accumulator
 
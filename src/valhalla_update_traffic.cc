@@ -0,0 +1,159 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <cxxopts.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "baldr/trafficupdater.h"
+#include "config.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/util.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// an edge is either its graph id value or level/tile/id
+GraphId parse_edge_id(const std::string& field) {
+  auto first = field.find('/');
+  if (first == std::string::npos) {
+    return GraphId(std::stoull(field));
+  }
+  auto second = field.find('/', first + 1);
+  if (second == std::string::npos) {
+    throw std::invalid_argument("Bad edge id " + field);
+  }
+  return GraphId(std::stoul(field.substr(first + 1, second - first - 1)),
+                 std::stoul(field.substr(0, first)), std::stoul(field.substr(second + 1)));
+}
+
+// reads lines of edge_id,speed_kph[,congestion]
+std::vector<TrafficUpdate> parse_updates(std::istream& in) {
+  std::vector<TrafficUpdate> updates;
+  std::string line, field;
+  size_t line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    try {
+      std::stringstream fields(line);
+      std::vector<std::string> parts;
+      while (std::getline(fields, field, ',')) {
+        parts.push_back(field);
+      }
+      if (parts.size() < 2 || parts.size() > 3) {
+        throw std::invalid_argument("expected edge_id,speed_kph[,congestion]");
+      }
+      updates.push_back({parse_edge_id(parts[0]),
+                         TrafficUpdater::speed(std::stoul(parts[1]),
+                                               parts.size() == 3 ? std::stoul(parts[2]) : 0)});
+    } catch (const std::exception& e) {
+      LOG_WARN("Skipping line " + std::to_string(line_number) + ": " + e.what());
+    }
+  }
+  return updates;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string config_file_path, input;
+  unsigned int num_threads;
+  uint64_t timestamp;
+  boost::property_tree::ptree pt;
+
+  try {
+    // clang-format off
+    cxxopts::Options options(
+      "valhalla_update_traffic",
+      "valhalla_update_traffic " VALHALLA_VERSION "\n\n"
+      "Writes live speeds into the traffic extract (mjolnir.traffic_extract) in place, services\n"
+      "using the extract pick them up without being restarted. Each line of the input is\n"
+      "edge_id,speed_kph[,congestion] where the edge id is either its value or level/tile/id,\n"
+      "a speed of 0 closes the edge and congestion goes from 1 (none) to 63 (most).\n\n");
+
+    options.add_options()
+      ("h,help", "Print this help message.")
+      ("v,version", "Print the version of this software.")
+      ("c,config", "Path to the json configuration file.", cxxopts::value<std::string>(config_file_path))
+      ("i,inline-config", "Inline json config.", cxxopts::value<std::string>())
+      ("f,file", "File of updates to read rather than stdin.", cxxopts::value<std::string>(input))
+      ("t,timestamp", "Seconds since epoch the speeds are from [default=now].", cxxopts::value<uint64_t>(timestamp)->default_value("0"))
+      ("j,concurrency", "Number of threads to use.", cxxopts::value<unsigned int>(num_threads)->default_value(std::to_string(std::thread::hardware_concurrency())));
+    // clang-format on
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help")) {
+      std::cout << options.help() << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    if (result.count("version")) {
+      std::cout << "valhalla_update_traffic " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+
+    // Read the config file
+    if (result.count("inline-config")) {
+      std::stringstream ss;
+      ss << result["inline-config"].as<std::string>();
+      rapidjson::read_json(ss, pt);
+    } else if (result.count("config") && filesystem::is_regular_file(config_file_path)) {
+      rapidjson::read_json(config_file_path, pt);
+    } else {
+      std::cerr << "Configuration is required\n\n" << options.help() << "\n\n";
+      return EXIT_FAILURE;
+    }
+
+    if (!pt.get_optional<std::string>("mjolnir.traffic_extract")) {
+      std::cerr << "The configuration has no mjolnir.traffic_extract\n\n";
+      return EXIT_FAILURE;
+    }
+  } catch (const cxxopts::OptionException& e) {
+    std::cout << "Unable to parse command line options because: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // configure logging
+  auto logging_subtree = pt.get_child_optional("mjolnir.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<const boost::property_tree::ptree&,
+                                                   std::unordered_map<std::string, std::string>>(
+        logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // read the updates
+  std::vector<TrafficUpdate> updates;
+  if (input.empty()) {
+    updates = parse_updates(std::cin);
+  } else {
+    std::ifstream file(input);
+    if (!file) {
+      LOG_ERROR("Could not open " + input);
+      return EXIT_FAILURE;
+    }
+    updates = parse_updates(file);
+  }
+
+  // write them
+  TrafficUpdater updater(pt.get<std::string>("mjolnir.traffic_extract"));
+  LOG_INFO("Writing " + std::to_string(updates.size()) + " speeds to " +
+           std::to_string(updater.tile_count()) + " traffic tiles");
+  const auto total = updates.size();
+  auto written = updater.update(std::move(updates), num_threads, timestamp);
+  LOG_INFO("Wrote " + std::to_string(written) + " speeds, " + std::to_string(total - written) +
+           " were of edges not in the traffic extract");
+
+  return EXIT_SUCCESS;
+}
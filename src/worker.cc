@@ -1,14 +1,22 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include <typeinfo>
 #include <unordered_map>
 
+#include "baldr/compression_utils.h"
 #include "baldr/datetime.h"
 #include "baldr/graphconstants.h"
 #include "baldr/location.h"
 #include "loki/worker.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
+#include "midgard/tracepoints.h"
 #include "midgard/util.h"
 #include "odin/util.h"
 #include "odin/worker.h"
@@ -35,6 +43,7 @@ constexpr const char* HTTP_405 = "Method Not Allowed";
 constexpr const char* HTTP_500 = "Internal Server Error";
 constexpr const char* HTTP_501 = "Not Implemented";
 constexpr const char* HTTP_503 = "Service Unavailable";
+constexpr const char* HTTP_504 = "Gateway Timeout";
 constexpr const char* OSRM_INVALID_URL = R"({"code":"InvalidUrl","message":"URL string is invalid."})";
 constexpr const char* OSRM_INVALID_SERVICE = R"({"code":"InvalidService","message":"Service name is invalid."})";
 constexpr const char* OSRM_INVALID_OPTIONS = R"({"code":"InvalidOptions","message":"Options are invalid."})";
@@ -42,6 +51,8 @@ constexpr const char* OSRM_INVALID_VALUE = R"({"code":"InvalidValue","message":"
 constexpr const char* OSRM_NO_ROUTE = R"({"code":"NoRoute","message":"Impossible route between points"})";
 constexpr const char* OSRM_NO_SEGMENT = R"({"code":"NoSegment","message":"One of the supplied input coordinates could not snap to street segment."})";
 constexpr const char* OSRM_SHUTDOWN = R"({"code":"ServiceUnavailable","message":"The service is shutting down."})";
+constexpr const char* OSRM_TIMED_OUT = R"({"code":"ServiceUnavailable","message":"The request took longer than its timeout."})";
+constexpr const char* OSRM_OVERLOADED = R"({"code":"ServiceUnavailable","message":"The service is too busy for this request."})";
 constexpr const char* OSRM_SERVER_ERROR = R"({"code":"InvalidUrl","message":"Failed to serialize route."})";
 constexpr const char* OSRM_DISTANCE_EXCEEDED = R"({"code":"DistanceExceeded","message":"Path distance exceeds the max distance limit."})";
 constexpr const char* OSRM_PERIMETER_EXCEEDED = R"({"code":"PerimeterExceeded","message":"Perimeter of avoid polygons exceeds the max limit."})";
@@ -70,6 +81,7 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {126, {126, "No shape provided", 400, HTTP_400, OSRM_INVALID_OPTIONS, "shape_required"}},
     {127, {127, "Recostings require a valid costing parameter", 400, HTTP_400, OSRM_INVALID_OPTIONS, "recosting_parse_failed"}},
     {128, {128, "Recostings require a unique 'name' field for each recosting", 400, HTTP_400, OSRM_INVALID_OPTIONS, "no_recosting_duplicate_names"}},
+    {129, {129, "Comparisons require a valid costing parameter", 400, HTTP_400, OSRM_INVALID_OPTIONS, "comparison_parse_failed"}},
     {130, {130, "Failed to parse location", 400, HTTP_400, OSRM_INVALID_VALUE, "location_parse_failed"}},
     {131, {131, "Failed to parse source", 400, HTTP_400, OSRM_INVALID_VALUE, "source_parse_failed"}},
     {132, {132, "Failed to parse target", 400, HTTP_400, OSRM_INVALID_VALUE, "target_parse_failed"}},
@@ -83,6 +95,7 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {142, {142, "Arrive by not implemented for isochrones", 501, HTTP_501, OSRM_INVALID_VALUE, "no_arrive_by_isochrones"}},
     {143, {143, "ignore_closures in costing and exclude_closures in search_filter cannot both be specified", 400, HTTP_400, OSRM_INVALID_VALUE, "closures_conflict"}},
     {144, {144, "Action does not support expansion", 400, HTTP_400, OSRM_INVALID_VALUE, "no_action_for_expansion"}},
+    {145, {145, "Comparisons are only supported by routes of a single mode without alternates", 400, HTTP_400, OSRM_INVALID_OPTIONS, "comparisons_not_supported"}},
     {150, {150, "Exceeded max locations", 400, HTTP_400, OSRM_INVALID_VALUE, "too_many_locations"}},
     {151, {151, "Exceeded max time", 400, HTTP_400, OSRM_INVALID_VALUE, "too_large_time"}},
     {152, {152, "Exceeded max contours", 400, HTTP_400, OSRM_INVALID_VALUE, "too_many_contours"}},
@@ -101,9 +114,14 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {165, {165, "Date and time required for destination for date_type of invariant", 400, HTTP_400, OSRM_INVALID_OPTIONS, "missing_invariant_date"}},
     {167, {167, "Exceeded maximum circumference for exclude_polygons", 400, HTTP_400, OSRM_PERIMETER_EXCEEDED, "too_large_polygon"}},
     {168, {168, "Invalid expansion property type", 400, HTTP_400, OSRM_INVALID_OPTIONS, "invalid_expansion_property"}},
+    {169, {169, "Invalid instruction type", 400, HTTP_400, OSRM_INVALID_OPTIONS, "invalid_instruction_type"}},
     {170, {170, "Locations are in unconnected regions. Go check/edit the map at osm.org", 400, HTTP_400, OSRM_NO_ROUTE, "impossible_route"}},
     {171, {171, "No suitable edges near location", 400, HTTP_400, OSRM_NO_SEGMENT, "no_edges_near"}},
     {172, {172, "Exceeded breakage distance for all pairs", 400, HTTP_400, OSRM_BREAKAGE_EXCEEDED, "too_large_breakage_distance"}},
+    {173, {173, "Exceeded max departure times", 400, HTTP_400, OSRM_INVALID_VALUE, "too_many_departure_times"}},
+    {174, {174, "The service is too busy for this request, try again later", 503, HTTP_503, OSRM_OVERLOADED, "too_busy"}},
+    {175, {175, "The request took longer than its timeout", 504, HTTP_504, OSRM_TIMED_OUT, "timed_out"}},
+    {176, {176, "Exceeded max comparisons", 400, HTTP_400, OSRM_INVALID_OPTIONS, "too_many_comparisons"}},
     {199, {199, "Unknown", 400, HTTP_400, OSRM_INVALID_URL, "unknown"}},
     {200, {200, "Failed to parse intermediate request format", 500, HTTP_500, OSRM_INVALID_URL, "pbf_parse_failed"}},
     {201, {201, "Failed to parse TripLeg", 500, HTTP_500, OSRM_INVALID_URL, "trip_parse_failed"}},
@@ -136,6 +154,7 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {443, {443, "Exact route match algorithm failed to find path", 400, HTTP_400, OSRM_NO_SEGMENT, "shape_match_failed"}},
     {444, {444, "Map Match algorithm failed to find path", 400, HTTP_400, OSRM_NO_SEGMENT, "map_match_failed"}},
     {445, {445, "Shape match algorithm specification in api request is incorrect. Please see documentation for valid shape_match input.", 400, HTTP_400, OSRM_INVALID_URL, "wrong_match_type"}},
+    {446, {446, "The request took longer than its timeout", 504, HTTP_504, OSRM_TIMED_OUT, "timed_out"}},
     {499, {499, "Unknown", 400, HTTP_400, OSRM_INVALID_URL, "unknown"}},
     {503, {503, "Leg count mismatch", 400, HTTP_400, OSRM_INVALID_URL, "wrong_number_of_legs"}},
 };
@@ -156,12 +175,20 @@ const std::unordered_map<int, std::string> warning_codes = {
   {204, R"("exclude_polygons" received invalid input, ignoring exclude_polygons)"},
   {205, R"("disable_hierarchy_pruning" exceeded the max distance, ignoring disable_hierarchy_pruning)"},
   {206, R"(CostMatrix does not consider "targets" with "date_time" set, ignoring date_time)"},
+  {207, R"("departure_times" are not supported by the bikeshare matrix, ignoring departure_times)"},
   // 3xx is used when costing options were specified but we had to change them internally for some reason
   {300, R"(Many:Many CostMatrix was requested, but server only allows 1:Many TimeDistanceMatrix)"},
   {301, R"(1:Many TimeDistanceMatrix was requested, but server only allows Many:Many CostMatrix)"},
 };
 // clang-format on
 
+// milliseconds since the epoch, what the deadlines of requests are in
+uint64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
 rapidjson::Document from_string(const std::string& json, const valhalla_exception_t& e) {
   rapidjson::Document d;
   if (json.empty()) {
@@ -638,8 +665,10 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
   // so that we serialize correctly at the end we fix up any request discrepancies
   if (options.format() == Options::pbf) {
     const std::unordered_set<Options::Action> pbf_actions{
-        Options::route,    Options::optimized_route,  Options::trace_route,
-        Options::centroid, Options::trace_attributes, Options::status,
+        Options::route,     Options::optimized_route,    Options::trace_route,
+        Options::centroid,  Options::trace_attributes,   Options::status,
+        Options::isochrone, Options::sources_to_targets, Options::height,
+        Options::expansion,
     };
     // if its not a pbf supported action we reset to json
     if (pbf_actions.count(options.action()) == 0) {
@@ -658,8 +687,18 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
   // Whether or not to run isochrones in reverse in absence of time dependence
   options.set_reverse(rapidjson::get<bool>(doc, "/reverse", false));
 
+  // Whether isochrones are computed for each location on its own and whether the nearest location
+  // of each cell is wanted
+  options.set_per_location(rapidjson::get<bool>(doc, "/per_location", false));
+  options.set_catchments(rapidjson::get<bool>(doc, "/catchments", false));
+  // Whether isochrones return the grid rather than contours
+  options.set_raster(rapidjson::get<bool>(doc, "/raster", false));
+
+  // Whether the response has the time each phase of the request took in a Server-Timing header
+  options.set_timings(rapidjson::get<bool>(doc, "/timings", false));
+
   auto language = rapidjson::get_optional<std::string>(doc, "/language");
-  if (language && odin::get_locales().find(*language) != odin::get_locales().end()) {
+  if (language && odin::is_locale_supported(*language)) {
     options.set_language(*language);
   }
   if (!options.has_language_case()) {
@@ -678,6 +717,20 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
     options.set_directions_type(directions_type);
   }
 
+  // which instructions to form, all of them if not specified
+  auto instruction_types = rapidjson::get_child_optional(doc, "/instruction_types");
+  if (instruction_types && instruction_types->IsArray()) {
+    options.clear_instruction_types();
+    Options::InstructionType instruction_type;
+    for (const auto& type : instruction_types->GetArray()) {
+      if (!type.IsString() ||
+          !Options_InstructionType_Enum_Parse(type.GetString(), &instruction_type)) {
+        throw valhalla_exception_t{169, type.IsString() ? type.GetString() : ""};
+      }
+      options.add_instruction_types(instruction_type);
+    }
+  }
+
   // costing defaults to none which is only valid for locate
   auto costing_str =
       rapidjson::get<std::string>(doc, "/costing",
@@ -937,6 +990,12 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
     options.set_verbose(rapidjson::get(doc, "/verbose", options.verbose()));
   }
 
+  // the client stops waiting for the response after the timeout so the request is abandoned then
+  auto timeout = rapidjson::get_optional<float>(doc, "/timeout");
+  if (timeout && *timeout > 0) {
+    options.set_deadline(now_ms() + static_cast<uint64_t>(*timeout * 1000));
+  }
+
   // Parse all of the costing options in their specified order
   sif::ParseCosting(doc, "/costing_options", options);
 
@@ -959,6 +1018,22 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
     // TODO: throw if not all names are unique?
   }
 
+  // parse any other costings to route the same locations with
+  auto comparisons = rapidjson::get_child_optional(doc, "/comparisons");
+  if (comparisons && comparisons->IsArray()) {
+    for (size_t i = 0; i < comparisons->GetArray().Size(); ++i) {
+      std::string key = "/comparisons/" + std::to_string(i);
+      try {
+        sif::ParseCosting(doc, key, options.add_comparisons());
+      } catch (const valhalla_exception_t& e) {
+        if (e.code != 127) {
+          throw;
+        }
+        throw valhalla_exception_t{129};
+      }
+    }
+  }
+
   // get the locations in there
   parse_locations(doc, api, "locations", 130, ignore_closures, had_date_time);
 
@@ -996,6 +1071,27 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
     options.set_matrix_locations(std::numeric_limits<uint32_t>::max());
   }
 
+  // whole seconds and meters delta encoded per source in the pbf matrix
+  options.set_compact_matrix(
+      rapidjson::get<bool>(doc, "/compact_matrix", options.compact_matrix()));
+
+  // departure times of a matrix for each of them
+  auto departure_times = rapidjson::get_child_optional(doc, "/departure_times");
+  if (departure_times && departure_times->IsArray()) {
+    options.clear_departure_times();
+    for (const auto& departure_time : departure_times->GetArray()) {
+      if (!departure_time.IsString() || !baldr::DateTime::is_iso_valid(departure_time.GetString()))
+        throw valhalla_exception_t{162};
+      options.add_departure_times(departure_time.GetString());
+    }
+  } // if it was there in the pbf already
+  else if (options.departure_times_size()) {
+    for (const auto& departure_time : options.departure_times()) {
+      if (!baldr::DateTime::is_iso_valid(departure_time))
+        throw valhalla_exception_t{162};
+    }
+  }
+
   // get the avoid polygons in there
   auto rings_req =
       rapidjson::get_child_optional(doc, doc.HasMember("avoid_polygons") ? "/avoid_polygons"
@@ -1057,6 +1153,12 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
   // should the expansion track opposites?
   options.set_skip_opposites(rapidjson::get<bool>(doc, "/skip_opposites", options.skip_opposites()));
 
+  // how many edges of the expansion to track at most and whether to only track every nth one
+  options.set_expansion_max_edges(
+      rapidjson::get<uint32_t>(doc, "/max_edges", options.expansion_max_edges()));
+  options.set_expansion_sample_interval(
+      rapidjson::get<uint32_t>(doc, "/sample_interval", options.expansion_sample_interval()));
+
   // get the contours in there
   parse_contours(doc, options.mutable_contours());
 
@@ -1136,7 +1238,7 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
       // we renamed `edge.tagged_names` to `thor::kEdgeTaggedValues` and do it for backward
       // compatibility
       if (attribute == "edge.tagged_names") {
-        attribute = baldr::kEdgeTaggedValues;
+        attribute = baldr::AttributesController::name(baldr::kEdgeTaggedValues);
       }
       options.add_filter_attributes(attribute);
     }
@@ -1171,6 +1273,66 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api) {
                 {valhalla::Options_Format_Enum_Name(options.format()), allocator}, allocator);
 }
 
+#ifdef HAVE_HTTP
+// smaller responses fit in a packet or two anyway so they aren't worth the cpu
+constexpr size_t kMinGzipBytes = 1024;
+
+// whether gzip is among the codings of an Accept-Encoding header and not ruled out with q=0
+bool accepts_gzip(const std::string& accept_encoding) {
+  float gzip = -1.f, any = -1.f;
+  std::istringstream codings(accept_encoding);
+  std::string coding;
+  while (std::getline(codings, coding, ',')) {
+    // the quality is 1 unless there is a q parameter
+    float quality = 1.f;
+    auto params = coding.find(';');
+    if (params != std::string::npos) {
+      auto q = coding.find("q=", params);
+      if (q != std::string::npos) {
+        quality = std::strtof(coding.c_str() + q + 2, nullptr);
+      }
+      coding.resize(params);
+    }
+    coding.erase(0, coding.find_first_not_of(" \t"));
+    coding.erase(coding.find_last_not_of(" \t") + 1);
+    std::transform(coding.begin(), coding.end(), coding.begin(), ::tolower);
+    if (coding == "gzip" || coding == "x-gzip") {
+      gzip = quality;
+    } else if (coding == "*") {
+      any = quality;
+    }
+  }
+  // naming gzip explicitly trumps the wildcard
+  return (gzip >= 0.f ? gzip : any) > 0.f;
+}
+
+std::string gzip(const std::string& uncompressed) {
+  auto deflate_src = [&uncompressed](z_stream& s) {
+    s.next_in = reinterpret_cast<Byte*>(const_cast<char*>(uncompressed.data()));
+    s.avail_in = static_cast<unsigned int>(uncompressed.size());
+    return Z_FINISH;
+  };
+
+  // json compresses well so start at a fraction of the input and double from there
+  std::string compressed;
+  auto deflate_dst = [&compressed, &uncompressed](z_stream& s) {
+    auto size = compressed.size();
+    if (s.total_out < size) {
+      compressed.resize(s.total_out);
+    } else {
+      compressed.resize(size ? size * 2 : uncompressed.size() / 4 + 64);
+      s.next_out = reinterpret_cast<Byte*>(&compressed[size]);
+      s.avail_out = static_cast<unsigned int>(compressed.size() - size);
+    }
+  };
+
+  if (!baldr::deflate(deflate_src, deflate_dst, Z_BEST_SPEED)) {
+    throw std::runtime_error("Could not gzip the response");
+  }
+  return compressed;
+}
+#endif
+
 } // namespace
 
 namespace valhalla {
@@ -1267,6 +1429,12 @@ void ParseApi(const http_request_t& request, valhalla::Api& api) {
   api.Clear();
   api.mutable_info()->set_is_service(true);
 
+  // remember if the client can take the response compressed
+  auto accept_encoding = request.headers.find("Accept-Encoding");
+  if (accept_encoding != request.headers.end() && accepts_gzip(accept_encoding->second)) {
+    api.mutable_info()->set_accepts_gzip(true);
+  }
+
   // get the action
   Options::Action action = static_cast<Options::Action>(Options::Action_ARRAYSIZE);
   if (!request.path.empty())
@@ -1325,6 +1493,13 @@ void ParseApi(const http_request_t& request, valhalla::Api& api) {
     document.AddMember({kv.first, allocator}, array, allocator);
   }
 
+  // a client that only accepts protobuf gets it without asking for it in the request too
+  auto accept = request.headers.find("Accept");
+  if (accept != request.headers.end() && accept->second == worker::PBF_MIME.second &&
+      document.IsObject() && !document.HasMember("format")) {
+    document.AddMember("format", "pbf", allocator);
+  }
+
   // parse out the options
   from_json(document, action, api);
 }
@@ -1357,21 +1532,50 @@ to_response(const std::string& data, http_request_info_t& request_info, const Ap
   if (fmt == Options::gpx)
     headers.insert(ATTACHMENT);
 
+  // the time each phase took so far, browsers show these with the request
+  if (request.options().timings()) {
+    std::string timings;
+    const std::string suffix = ".latency_ms";
+    for (const auto& stat : request.info().statistics()) {
+      const auto& key = stat.key();
+      auto info = key.find(".info.");
+      if (stat.type() != timing || info == std::string::npos || key.size() < suffix.size() ||
+          key.compare(key.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        continue;
+      }
+      std::ostringstream entry;
+      entry << (timings.empty() ? "" : ", ")
+            << key.substr(info + 6, key.size() - suffix.size() - info - 6) << ";dur=" << std::fixed
+            << std::setprecision(3) << stat.value();
+      timings += entry.str();
+    }
+    if (!timings.empty()) {
+      headers.emplace("Server-Timing", timings);
+    }
+  }
+
   // jsonp needs wrapped in a javascript function call
-  worker_t::result_t result{false, std::list<std::string>(), ""};
+  std::string body;
   if (request.options().has_jsonp_case()) {
     headers.insert(worker::JS_MIME); // reset content type to javascript
     std::ostringstream stream;
     stream << request.options().jsonp() << '(';
     stream << data;
     stream << ')';
+    body = stream.str();
+  } // everything else is bytes already
+  const auto& bytes = request.options().has_jsonp_case() ? body : data;
 
-    http_response_t response(200, "OK", stream.str(), headers);
+  // large responses go out compressed if the client takes that, caches have to tell them apart
+  worker_t::result_t result{false, std::list<std::string>(), ""};
+  if (request.info().accepts_gzip() && bytes.size() >= kMinGzipBytes) {
+    headers.emplace("Content-Encoding", "gzip");
+    headers.emplace("Vary", "Accept-Encoding");
+    http_response_t response(200, "OK", gzip(bytes), headers);
     response.from_info(request_info);
     result.messages.emplace_back(response.to_string());
-  } // everything else is bytes already
-  else {
-    http_response_t response(200, "OK", data, headers);
+  } else {
+    http_response_t response(200, "OK", bytes, headers);
     response.from_info(request_info);
     result.messages.emplace_back(response.to_string());
   }
@@ -1405,21 +1609,74 @@ struct statsd_client_t : public Statsd::StatsdClient {
   std::vector<std::string> tags;
 };
 
-service_worker_t::service_worker_t(const boost::property_tree::ptree& conf) : interrupt(nullptr) {
+api_arena_t::api_arena_t(size_t initial_block_size)
+    : initial_block_(initial_block_size), arena_([this]() {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = initial_block_.data();
+        options.initial_block_size = initial_block_.size();
+        // long routes need many megabytes, let the blocks grow so they stay few
+        options.max_block_size = std::max(options.max_block_size, initial_block_.size());
+        return options;
+      }()) {
+}
+Api& api_arena_t::next() {
+  arena_.Reset();
+  return *google::protobuf::Arena::CreateMessage<Api>(&arena_);
+}
+void api_arena_t::reset() {
+  arena_.Reset();
+}
+
+service_worker_t::service_worker_t(const boost::property_tree::ptree& conf)
+    : interrupt(nullptr), default_timeout(0) {
   if (conf.count("statsd")) {
     statsd_client = std::make_unique<statsd_client_t>(conf);
   }
+  // the server gives up on requests after its timeout, there is no point working on them any longer
+  const auto timeout_seconds = conf.get<int>("httpd.service.timeout_seconds", -1);
+  if (timeout_seconds > 0) {
+    default_timeout = timeout_seconds * 1000ull;
+  }
 }
 service_worker_t::~service_worker_t() {
 }
 void service_worker_t::set_interrupt(const std::function<void()>* interrupt_function) {
   interrupt = interrupt_function;
 }
+const std::function<void()>*
+service_worker_t::watch_deadline(Api& request,
+                                 const std::function<void()>* interrupt_function,
+                                 unsigned timeout_code) {
+  auto& options = *request.mutable_options();
+  const auto now = now_ms();
+  if (default_timeout && (!options.deadline() || options.deadline() > now + default_timeout)) {
+    options.set_deadline(now + default_timeout);
+  }
+  if (!options.deadline()) {
+    return interrupt_function;
+  }
+
+  // dont even start on requests which waited in the queue until their deadline
+  const auto deadline = options.deadline();
+  if (now > deadline) {
+    throw valhalla_exception_t{timeout_code};
+  }
+  deadline_interrupt = [interrupt_function, deadline, timeout_code]() {
+    if (interrupt_function) {
+      (*interrupt_function)();
+    }
+    if (now_ms() > deadline) {
+      throw valhalla_exception_t{timeout_code};
+    }
+  };
+  return &deadline_interrupt;
+}
 void service_worker_t::cleanup() {
   if (statsd_client) {
     // sends metrics to statsd server over udp
     statsd_client->flush();
   }
+  api_arena.reset();
 }
 void service_worker_t::enqueue_statistics(Api& api) const {
   // nothing to do without stats
@@ -1456,10 +1713,150 @@ void service_worker_t::enqueue_statistics(Api& api) const {
   }
 }
 
+void record_phase(Api& api, const std::string& phase, double milliseconds) {
+  const auto& action = Options_Action_Enum_Name(api.options().action());
+  auto* stat = api.mutable_info()->mutable_statistics()->Add();
+  stat->set_key(action + ".info." + phase + ".latency_ms");
+  stat->set_value(milliseconds);
+  stat->set_type(timing);
+}
+
+midgard::Finally<std::function<void()>> measure_phase(Api& api, const std::string& phase) {
+  auto start = std::chrono::steady_clock::now();
+  auto mark = midgard::allocation_stats_t::start();
+  VALHALLA_TRACE(phase_start, phase.c_str());
+  return midgard::Finally<std::function<void()>>([&api, phase, start, mark]() {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    VALHALLA_TRACE(phase_done, phase.c_str(), static_cast<uint64_t>(elapsed.count() * 1000));
+    record_phase(api, phase, elapsed.count());
+    if (midgard::allocation_stats_t::enabled)
+      record_allocations(api, phase, midgard::allocation_stats_t::since(mark));
+  });
+}
+
+void record_phase_amount(Api& api,
+                         const std::string& phase,
+                         const std::string& metric,
+                         double amount) {
+  const auto& action = Options_Action_Enum_Name(api.options().action());
+  auto* stat = api.mutable_info()->mutable_statistics()->Add();
+  stat->set_key(action + ".info." + phase + "." + metric);
+  stat->set_value(amount);
+  stat->set_type(timing);
+}
+
+void record_allocations(Api& api,
+                        const std::string& phase,
+                        const midgard::allocation_stats_t& allocations) {
+  record_phase_amount(api, phase, "allocations", allocations.allocations);
+  record_phase_amount(api, phase, "allocated_bytes", allocations.bytes);
+  record_phase_amount(api, phase, "peak_bytes", allocations.peak_bytes);
+}
+
+void record_tile_cache(Api& api,
+                       const std::string& service,
+                       const baldr::GraphReader::CacheStats& before,
+                       const baldr::GraphReader::CacheStats& after) {
+  const auto& action = Options_Action_Enum_Name(api.options().action());
+  auto add = [&](const char* counter, uint64_t amount) {
+    if (amount == 0)
+      return;
+    auto* stat = api.mutable_info()->mutable_statistics()->Add();
+    stat->set_key(action + ".info." + service + ".tile_cache." + counter);
+    stat->set_value(amount);
+    stat->set_type(count);
+  };
+  add("hits", after.hits - before.hits);
+  add("misses", after.misses - before.misses);
+  add("evictions", after.evictions - before.evictions);
+  add("tiles_loaded", after.tiles_loaded - before.tiles_loaded);
+  add("bytes_loaded", after.bytes_loaded - before.bytes_loaded);
+  if (after.tiles_loaded != before.tiles_loaded)
+    record_phase(api, service + ".tile_load", after.load_ms - before.load_ms);
+}
+
+ServiceCounters* add_service_counters(Api& api,
+                                      const std::string& service,
+                                      const baldr::GraphReader& reader) {
+  auto stats = reader.GetCacheStats();
+  auto* counters = api.mutable_status()->add_counters();
+  counters->set_service(service);
+  auto* tile_cache = counters->mutable_tile_cache();
+  tile_cache->set_hits(stats.hits);
+  tile_cache->set_misses(stats.misses);
+  tile_cache->set_evictions(stats.evictions);
+  tile_cache->set_tiles_loaded(stats.tiles_loaded);
+  tile_cache->set_bytes_loaded(stats.bytes_loaded);
+  tile_cache->set_load_ms(stats.load_ms);
+  const auto& warmup_stats = reader.GetWarmupStats();
+  if (warmup_stats.tiles > 0) {
+    auto* warmup = counters->mutable_warmup();
+    warmup->set_tiles(warmup_stats.tiles);
+    warmup->set_bytes(warmup_stats.bytes);
+    warmup->set_ms(warmup_stats.ms);
+  }
+  return counters;
+}
+
+void warm_up(baldr::GraphReader& reader,
+             const boost::property_tree::ptree& config,
+             const std::string& service) {
+  const auto list = config.get<std::string>("mjolnir.warmup.tiles", "");
+  if (list.empty()) {
+    return;
+  }
+  std::ifstream file(list);
+  if (!file) {
+    LOG_WARN("Could not open the warm up tile list " + list);
+    return;
+  }
+
+  // the tiles and how often they are used, if the list says
+  std::vector<std::pair<uint64_t, baldr::GraphId>> tiles;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string tile;
+    uint64_t uses = 0;
+    if (!(fields >> tile) || tile.front() == '#') {
+      continue;
+    }
+    fields >> uses;
+    try {
+      if (tile.find('.') != std::string::npos) {
+        tiles.emplace_back(uses, baldr::GraphTile::GetTileId(tile));
+      } else {
+        const auto slashes = std::count(tile.begin(), tile.end(), '/');
+        tiles.emplace_back(uses, baldr::GraphId(slashes == 1 ? tile + "/0" : tile));
+      }
+    } catch (const std::exception&) { LOG_WARN("Skipping " + tile + " in the warm up tile list"); }
+  }
+  std::stable_sort(tiles.begin(), tiles.end(),
+                   [](const auto& a, const auto& b) { return a.first > b.first; });
+  const auto max_tiles = config.get<size_t>("mjolnir.warmup.max_tiles", 0);
+  if (max_tiles > 0 && tiles.size() > max_tiles) {
+    tiles.resize(max_tiles);
+  }
+  std::vector<baldr::GraphId> tile_ids;
+  tile_ids.reserve(tiles.size());
+  for (const auto& tile : tiles) {
+    tile_ids.push_back(tile.second);
+  }
+
+  const auto threads = config.get<size_t>("mjolnir.warmup.threads",
+                                          std::max(1u, std::thread::hardware_concurrency()));
+  const auto stats = reader.Warmup(tile_ids, threads);
+  LOG_INFO("Warmed up " + service + " with " + std::to_string(stats.tiles) + " tiles, " +
+           std::to_string(stats.bytes >> 20) + "MB in " + std::to_string(stats.ms) + "ms");
+}
+
 midgard::Finally<std::function<void()>> service_worker_t::measure_scope_time(Api& api) const {
   // we copy the captures that could go out of scope
   auto start = std::chrono::steady_clock::now();
-  return midgard::Finally<std::function<void()>>([this, &api, start]() {
+  const auto* reader = graph_reader();
+  auto cache_stats = reader ? reader->GetCacheStats() : baldr::GraphReader::CacheStats{};
+  auto mark = midgard::allocation_stats_t::start();
+  return midgard::Finally<std::function<void()>>([this, &api, start, reader, cache_stats, mark]() {
     auto elapsed = std::chrono::steady_clock::now() - start;
     auto e = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(elapsed).count();
     const auto& action = Options_Action_Enum_Name(api.options().action());
@@ -1468,9 +1865,32 @@ midgard::Finally<std::function<void()>> service_worker_t::measure_scope_time(Api
     stat->set_key(action + ".info." + service_name() + ".latency_ms");
     stat->set_value(e);
     stat->set_type(timing);
+
+    if (reader)
+      record_tile_cache(api, service_name(), cache_stats, reader->GetCacheStats());
+
+    if (midgard::allocation_stats_t::enabled) {
+      const auto allocations = midgard::allocation_stats_t::since(mark);
+      record_allocations(api, service_name(), allocations);
+      ++allocation_totals.requests;
+      allocation_totals.allocations += allocations.allocations;
+      allocation_totals.bytes += allocations.bytes;
+      allocation_totals.max_peak_bytes =
+          std::max(allocation_totals.max_peak_bytes, allocations.peak_bytes);
+    }
   });
 }
 
+void service_worker_t::add_allocation_counters(ServiceCounters& counters) const {
+  if (!midgard::allocation_stats_t::enabled)
+    return;
+  auto* allocations = counters.mutable_allocations();
+  allocations->set_requests(allocation_totals.requests);
+  allocations->set_allocations(allocation_totals.allocations);
+  allocations->set_bytes(allocation_totals.bytes);
+  allocations->set_max_peak_bytes(allocation_totals.max_peak_bytes);
+}
+
 void service_worker_t::started() {
   if (statsd_client) {
     statsd_client->count("none.info." + service_name() + ".worker_started", 1, 1.f,
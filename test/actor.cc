@@ -2,6 +2,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "tyr/actor.h"
 
@@ -78,6 +79,56 @@ TEST(Actor, TraceAttributes) {
   EXPECT_THROW(actor.trace_attributes(request, &interrupt), test_exception_t);
 }
 
+TEST(Actor, ArenaApi) {
+  // without auto cleanup the arena is only reset when the next request starts
+  tyr::actor_t actor(conf, false);
+  const std::string request = R"({"locations":[{"lat":40.546115,"lon":-76.385076,"type":"break"},
+        {"lat":40.544232,"lon":-76.385752,"type":"break"}],"costing":"auto"})";
+  Api api;
+  const auto expected = actor.route(request, nullptr, &api);
+  actor.cleanup();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(actor.route(request), expected);
+  }
+  actor.cleanup();
+  EXPECT_EQ(actor.route(request), expected);
+}
+
+TEST(Actor, TraceAttributesBatch) {
+  auto batch_conf = conf;
+  batch_conf.put("meili.batch_threads", 3);
+  tyr::actor_t actor(batch_conf, true);
+  const std::string good = R"({"shape":[{"lat":40.546115,"lon":-76.385076},
+        {"lat":40.544232,"lon":-76.385752}],"costing":"auto","shape_match":"map_snap"})";
+  const std::string bad = R"({"shape":[],"costing":"auto","shape_match":"map_snap"})";
+  const auto expected = actor.trace_attributes(good);
+
+  // every trace comes back once, the failed one as an error
+  std::vector<std::string> requests(10, good);
+  requests[4] = bad;
+  std::vector<std::string> results(requests.size());
+  for (int batch = 0; batch < 2; ++batch) {
+    std::vector<int> counts(requests.size(), 0);
+    actor.trace_attributes(requests, [&](size_t i, const std::string& result) {
+      ++counts[i];
+      results[i] = result;
+    });
+    for (size_t i = 0; i < requests.size(); ++i) {
+      EXPECT_EQ(counts[i], 1);
+      if (i == 4) {
+        EXPECT_NE(results[i].find("error_code"), std::string::npos);
+      } else {
+        EXPECT_EQ(results[i], expected);
+      }
+    }
+  }
+
+  // an interrupt aborts the whole batch
+  std::function<void()> interrupt = [] { throw test_exception_t{}; };
+  EXPECT_THROW(actor.trace_attributes(requests, [](size_t, const std::string&) {}, &interrupt),
+               test_exception_t);
+}
+
 // TODO: test the rest of them
 
 } // namespace
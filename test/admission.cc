@@ -0,0 +1,121 @@
+#include "loki/admission.h"
+#include "worker.h"
+
+#include <chrono>
+#include <thread>
+
+#include "test.h"
+
+using namespace valhalla;
+using namespace valhalla::loki;
+
+namespace {
+
+Options matrix(size_t count) {
+  Options options;
+  options.set_action(Options::sources_to_targets);
+  for (size_t i = 0; i < count; ++i) {
+    auto* source = options.add_sources()->mutable_ll();
+    source->set_lat(52.0 + i * 0.01);
+    source->set_lng(13.0);
+    auto* target = options.add_targets()->mutable_ll();
+    target->set_lat(52.0);
+    target->set_lng(13.0 + i * 0.01);
+  }
+  return options;
+}
+
+Options locate() {
+  Options options;
+  options.set_action(Options::locate);
+  auto* ll = options.add_locations()->mutable_ll();
+  ll->set_lat(52.0);
+  ll->set_lng(13.0);
+  return options;
+}
+
+AdmissionControl make_admission(double expensive_cost, double throughput, double max_wait) {
+  boost::property_tree::ptree config;
+  config.put("expensive_cost", expensive_cost);
+  config.put("throughput", throughput);
+  config.put("max_wait", max_wait);
+  return AdmissionControl(config);
+}
+
+TEST(Admission, Estimate) {
+  Options route;
+  route.set_action(Options::route);
+  for (double lat : {52.0, 52.1, 52.0}) {
+    auto* ll = route.add_locations()->mutable_ll();
+    ll->set_lat(lat);
+    ll->set_lng(13.0);
+  }
+  // two legs of about 11km each
+  EXPECT_NEAR(AdmissionControl::estimate(route), 22.2, 0.5);
+
+  // more sources and targets spread further cost more
+  EXPECT_GT(AdmissionControl::estimate(matrix(50)), AdmissionControl::estimate(matrix(10)));
+
+  Options isochrone;
+  isochrone.set_action(Options::isochrone);
+  isochrone.set_costing_type(Costing::auto_);
+  *isochrone.add_locations() = route.locations(0);
+  isochrone.add_contours()->set_time(10);
+  const auto ten_minutes = AdmissionControl::estimate(isochrone);
+  isochrone.add_contours()->set_time(60);
+  EXPECT_NEAR(AdmissionControl::estimate(isochrone), ten_minutes * 36, 1);
+  isochrone.set_costing_type(Costing::pedestrian);
+  EXPECT_LT(AdmissionControl::estimate(isochrone), ten_minutes);
+
+  EXPECT_EQ(AdmissionControl::estimate(locate()), 0);
+}
+
+TEST(Admission, DisabledAdmitsEverything) {
+  AdmissionControl::reset();
+  auto admission = make_admission(1, 1, 0);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_NO_THROW(admission.admit(matrix(50)));
+  }
+}
+
+TEST(Admission, ShedsExpensiveRequestsWhenBusy) {
+  AdmissionControl::reset();
+  const auto expensive = matrix(50);
+  const auto cost = AdmissionControl::estimate(expensive);
+  // the service gets through one expensive request every 10 seconds and they may wait 15
+  auto admission = make_admission(cost, cost / 10, 15);
+
+  EXPECT_NO_THROW(admission.admit(expensive));
+  EXPECT_NO_THROW(admission.admit(expensive));
+  try {
+    admission.admit(expensive);
+    FAIL() << "The third expensive request should have been shed";
+  } catch (const valhalla_exception_t& e) {
+    EXPECT_EQ(e.code, 174);
+    EXPECT_EQ(e.http_code, 503);
+  }
+
+  // cheap requests still get through
+  EXPECT_NO_THROW(admission.admit(locate()));
+  EXPECT_NO_THROW(admission.admit(matrix(2)));
+}
+
+TEST(Admission, BacklogDrains) {
+  AdmissionControl::reset();
+  const auto expensive = matrix(50);
+  const auto cost = AdmissionControl::estimate(expensive);
+  // one expensive request every 100 milliseconds, none may wait
+  auto admission = make_admission(cost, cost * 10, 0.001);
+
+  EXPECT_NO_THROW(admission.admit(expensive));
+  EXPECT_THROW(admission.admit(expensive), valhalla_exception_t);
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  EXPECT_NO_THROW(admission.admit(expensive));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
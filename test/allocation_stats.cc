@@ -0,0 +1,60 @@
+#include "midgard/allocation_stats.h"
+
+#include "test.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+TEST(AllocationStats, Nothing) {
+  auto mark = allocation_stats_t::start();
+  const auto stats = allocation_stats_t::since(mark);
+  EXPECT_EQ(stats.allocations, 0);
+  EXPECT_EQ(stats.bytes, 0);
+  EXPECT_EQ(stats.peak_bytes, 0);
+}
+
+TEST(AllocationStats, Nested) {
+  auto outer = allocation_stats_t::start();
+  auto big = std::make_unique<std::vector<char>>(1 << 20);
+  big.reset();
+
+  auto inner = allocation_stats_t::start();
+  std::vector<char> small(1 << 10);
+  const auto inner_stats = allocation_stats_t::since(inner);
+  const auto outer_stats = allocation_stats_t::since(outer);
+
+  if (!allocation_stats_t::enabled) {
+    EXPECT_EQ(outer_stats.allocations, 0);
+    EXPECT_EQ(outer_stats.bytes, 0);
+    EXPECT_EQ(outer_stats.peak_bytes, 0);
+    return;
+  }
+
+  EXPECT_EQ(inner_stats.allocations, 1);
+  EXPECT_GE(inner_stats.bytes, 1 << 10);
+  EXPECT_LT(inner_stats.peak_bytes, 1 << 20);
+  // the outer peak is that of the big vector even though it was gone before the inner one started
+  EXPECT_EQ(outer_stats.allocations, 3);
+  EXPECT_GE(outer_stats.bytes, (1 << 20) + (1 << 10));
+  EXPECT_GE(outer_stats.peak_bytes, 1 << 20);
+}
+
+TEST(AllocationStats, PerThread) {
+  auto mark = allocation_stats_t::start();
+  std::thread([]() { std::vector<char> elsewhere(1 << 20); }).join();
+  const auto stats = allocation_stats_t::since(mark);
+  // only the thread itself is counted here, not what it allocated
+  EXPECT_LT(stats.bytes, 1 << 20);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
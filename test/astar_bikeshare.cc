@@ -31,9 +31,9 @@ const auto conf =
     test::make_config("test/data/paris_bss_tiles", {{"loki.service_defaults.radius", "10"}});
 
 struct route_tester {
-  route_tester()
-      : reader(std::make_shared<GraphReader>(conf.get_child("mjolnir"))), loki_worker(conf, reader),
-        thor_worker(conf, reader), odin_worker(conf) {
+  explicit route_tester(const bpt::ptree& config = conf)
+      : reader(std::make_shared<GraphReader>(config.get_child("mjolnir"))),
+        loki_worker(config, reader), thor_worker(config, reader), odin_worker(config) {
   }
   Api test(const std::string& request_json) {
     Api request;
@@ -337,6 +337,49 @@ TEST(AstarBss, test_BSSConnections_on_Pedestrian_and_Bicycle) {
                expected_bss_ref, expected_shape);
 }
 
+/*
+ * The bidirectional search rents and returns bikes where the unidirectional one does
+ */
+TEST(AstarBss, test_Bidirectional) {
+  auto bidirectional_conf = conf;
+  bidirectional_conf.put("thor.bikeshare_algorithm", "bidirectional_astar");
+  route_tester unidirectional, bidirectional(bidirectional_conf);
+
+  const std::vector<std::string> requests = {
+      R"({"locations":[{"lat":48.864655,"lon":2.361374},{"lat":48.859608,"lon":2.36117}],
+          "costing":"bikeshare",
+          "costing_options":{"pedestrian":{"bss_rent_cost":0,"bss_rent_penalty":0},
+                             "bicycle"   :{"bss_return_cost":0,"bss_return_penalty":0}}})",
+      R"({"locations":[{"lat":48.8601411,"lon":2.3716413},{"lat":48.8594916,"lon":2.3602581}],
+          "costing":"bikeshare",
+          "costing_options":{"pedestrian":{"bss_rent_cost":0,"bss_rent_penalty":0},
+                             "bicycle"   :{"bss_return_cost":0,"bss_return_penalty":0}}})",
+      R"({"locations":[{"lat":48.865020,"lon":2.369113},{"lat":48.859782,"lon":2.36101}],
+          "costing":"bikeshare",
+          "costing_options":{"pedestrian":{"bss_rent_cost":1800,"bss_rent_penalty":0},
+                             "bicycle"   :{"bss_return_cost":1800,"bss_return_penalty":0}}})",
+  };
+
+  const auto travel_modes = [](const Api& api) {
+    std::vector<int> modes;
+    for (const auto& m : api.directions().routes(0).legs(0).maneuver()) {
+      modes.push_back(m.travel_mode());
+    }
+    modes.erase(std::unique(modes.begin(), modes.end()), modes.end());
+    return modes;
+  };
+
+  for (const auto& request : requests) {
+    auto expected = unidirectional.test(request);
+    auto result = bidirectional.test(request);
+    EXPECT_EQ(travel_modes(result), travel_modes(expected)) << request;
+    const auto expected_time = expected.directions().routes(0).legs(0).summary().time();
+    EXPECT_NEAR(result.directions().routes(0).legs(0).summary().time(), expected_time,
+                expected_time * 0.05)
+        << request;
+  }
+}
+
 class AstarBSSTest : public thor::AStarBSSAlgorithm {
 public:
   explicit AstarBSSTest(const boost::property_tree::ptree& config = {}) : AStarBSSAlgorithm(config) {
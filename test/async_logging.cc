@@ -0,0 +1,67 @@
+#include "midgard/logging.h"
+
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace valhalla::midgard;
+
+namespace {
+
+TEST(AsyncLogging, EveryLineIsWrittenOrCounted) {
+  // get rid of it first so we don't append
+  std::remove("test/async_file_log_test.log");
+
+  // a tiny queue so that the threads below outpace the writer
+  logging::Configure({{"type", "file"},
+                      {"file_name", "test/async_file_log_test.log"},
+                      {"async", "true"},
+                      {"async_queue_size", "16"},
+                      {"async_flush_interval", "10"}});
+
+  // start up some threads which log as fast as they can
+  const size_t threads = 4, lines = 2500;
+  std::vector<std::future<void>> results;
+  for (size_t i = 0; i < threads; ++i) {
+    results.emplace_back(std::async(std::launch::async, [] {
+      for (size_t j = 0; j < lines; ++j) {
+        logging::Log("a line which should be whole", " [CUSTOM] ");
+      }
+    }));
+  }
+  for (auto& result : results) {
+    result.get();
+  }
+
+  // give the writer time to catch up and report what it dropped
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  std::ifstream file("test/async_file_log_test.log");
+  std::string line;
+  size_t written = 0, dropped = 0;
+  while (std::getline(file, line)) {
+    if (line.find(" [CUSTOM] a line which should be whole") != std::string::npos) {
+      // lines of different threads never end up mixed together
+      EXPECT_EQ(line.size(), 26 + std::string(" [CUSTOM] a line which should be whole").size());
+      ++written;
+      continue;
+    }
+    auto pos = line.find(" [WARN] Dropped ");
+    ASSERT_NE(pos, std::string::npos) << line;
+    dropped += std::stoul(line.substr(pos + 16));
+  }
+  EXPECT_GT(written, 0);
+  EXPECT_EQ(written + dropped, threads * lines);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -27,9 +27,11 @@ TEST(AttrController, TestArgCtor) {
 void TryDisableAll() {
   AttributesController controller;
   controller.disable_all();
-  for (auto& pair : controller.attributes) {
-    // If any pair value is true then throw error
-    EXPECT_FALSE(pair.second) << ("Incorrect disable_all value for " + pair.first);
+  for (uint16_t i = 0; i < kAttributeCount; ++i) {
+    // If any attribute is enabled then throw error
+    const auto key = static_cast<Attribute>(i);
+    EXPECT_FALSE(controller(key))
+        << ("Incorrect disable_all value for " + AttributesController::name(key));
   }
 }
 
@@ -55,15 +57,15 @@ TEST(AttrController, TestNodeAttributeEnabled) {
   TryCategoryAttributeEnabled(controller, kNodeCategory, false);
 
   // Test one node enabled
-  controller.attributes.at(kNodeType) = true;
+  controller.attributes[kNodeType] = true;
   TryCategoryAttributeEnabled(controller, kNodeCategory, true);
 
   // Test some node enabled
-  controller.attributes.at(kNodeType) = false;
-  controller.attributes.at(kNodeIntersectingEdgeBeginHeading) = true;
-  controller.attributes.at(kNodeTransitPlatformInfoType) = true;
-  controller.attributes.at(kNodeElapsedTime) = true;
-  controller.attributes.at(kNodeFork) = true;
+  controller.attributes[kNodeType] = false;
+  controller.attributes[kNodeIntersectingEdgeBeginHeading] = true;
+  controller.attributes[kNodeTransitPlatformInfoType] = true;
+  controller.attributes[kNodeElapsedTime] = true;
+  controller.attributes[kNodeFork] = true;
   TryCategoryAttributeEnabled(controller, kNodeCategory, true);
 }
 
@@ -78,17 +80,56 @@ TEST(AttrController, TestAdminAttributeEnabled) {
   TryCategoryAttributeEnabled(controller, kAdminCategory, false);
 
   // Test one admin enabled
-  controller.attributes.at(kAdminCountryCode) = true;
+  controller.attributes[kAdminCountryCode] = true;
   TryCategoryAttributeEnabled(controller, kAdminCategory, true);
 
   // Test some admin enabled
-  controller.attributes.at(kAdminCountryCode) = false;
-  controller.attributes.at(kAdminCountryText) = true;
-  controller.attributes.at(kAdminStateCode) = false;
-  controller.attributes.at(kAdminStateText) = true;
+  controller.attributes[kAdminCountryCode] = false;
+  controller.attributes[kAdminCountryText] = true;
+  controller.attributes[kAdminStateCode] = false;
+  controller.attributes[kAdminStateText] = true;
   TryCategoryAttributeEnabled(controller, kAdminCategory, true);
 }
 
+TEST(AttrController, TestNames) {
+  // every attribute is found by its own name and no two attributes share a name
+  for (uint16_t i = 0; i < kAttributeCount; ++i) {
+    const auto key = static_cast<Attribute>(i);
+    Attribute found;
+    ASSERT_TRUE(AttributesController::find(AttributesController::name(key), found));
+    EXPECT_EQ(found, key) << AttributesController::name(key);
+  }
+  EXPECT_EQ(AttributesController::name(kEdgeTaggedValues), "edge.tagged_values");
+  EXPECT_EQ(AttributesController::name(kShape), "shape");
+
+  Attribute found;
+  EXPECT_FALSE(AttributesController::find("edge.tagged_names", found));
+  EXPECT_FALSE(AttributesController::find("edge.", found));
+}
+
+TEST(AttrController, TestFilters) {
+  valhalla::Options options;
+  options.set_filter_action(valhalla::FilterAction::include);
+  options.add_filter_attributes("edge.is_urban");
+  options.add_filter_attributes("not.an.attribute");
+  AttributesController include(options);
+  EXPECT_TRUE(include(kEdgeIsUrban));
+  EXPECT_TRUE(include(kEdgeNames));
+
+  AttributesController strict(options, true);
+  EXPECT_TRUE(strict(kEdgeIsUrban));
+  EXPECT_FALSE(strict(kEdgeNames));
+  EXPECT_EQ(strict.attributes.count(), 1u);
+
+  options.set_filter_action(valhalla::FilterAction::exclude);
+  options.clear_filter_attributes();
+  options.add_filter_attributes("edge.names");
+  AttributesController exclude(options);
+  EXPECT_FALSE(exclude(kEdgeNames));
+  EXPECT_TRUE(exclude(kEdgeLength));
+  EXPECT_FALSE(exclude(kEdgeIsUrban));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -5,7 +5,8 @@ import os
 from pathlib import Path
 import re
 import unittest
-from valhalla import Actor, get_config
+from concurrent.futures import ThreadPoolExecutor
+from valhalla import Actor, ActorPool, get_config
 
 
 PWD = Path(os.path.dirname(os.path.abspath(__file__)))
@@ -123,3 +124,63 @@ class TestBindings(unittest.TestCase):
         with self.assertRaises(RuntimeError) as e:
             actor.route(json.dumps({"locations":[{"lat":52.08813,"lon":5.03231},{"lat":52.09987,"lon":5.14913}],"costing":"bicycle","directions_options":{"language":"ru-RU"}}))
         self.assertIn('exceeds the max distance limit', str(e.exception))
+
+    def test_actor_pool(self):
+        config = get_config(self.tiles_path, self.extract_path)
+        with open(self.config_path, 'w') as f:
+            json.dump(config, f, indent=2)
+
+        pool = ActorPool(str(self.config_path), 2)
+        self.assertEqual(pool.size, 2)
+        query = {"locations": [{"lat": 52.08813, "lon": 5.03231}, {"lat": 52.09987, "lon": 5.14913}],
+                 "costing": "auto"}
+        expected = self.actor.route(query)['trip']['summary']['length']
+
+        # more threads than actors, they wait for one to be free
+        with ThreadPoolExecutor(max_workers=4) as executor:
+            routes = list(executor.map(pool.route, [query] * 8))
+        for route in routes:
+            self.assertEqual(route['trip']['summary']['length'], expected)
+
+        # an actor whose request failed goes back to the pool
+        pool = ActorPool(str(self.config_path), 1)
+        with self.assertRaises(RuntimeError):
+            pool.route({"locations": query["locations"], "costing": "nope"})
+        self.assertIn('trip', pool.route(query))
+
+    def test_actor_pool_batches(self):
+        config = get_config(self.tiles_path, self.extract_path)
+        with open(self.config_path, 'w') as f:
+            json.dump(config, f, indent=2)
+        pool = ActorPool(str(self.config_path), 2)
+
+        locations = [{"lat": 52.08813, "lon": 5.03231}, {"lat": 52.09987, "lon": 5.14913}]
+        query = {"locations": locations, "costing": "auto"}
+        bad = {"locations": locations[:1], "costing": "auto"}
+        pbf = dict(query, format="pbf")
+        responses = pool.batch("route", [query, json.dumps(query), bad, pbf])
+        self.assertEqual(len(responses), 4)
+        self.assertIn('trip', responses[0])
+        self.assertIsInstance(responses[1], str)
+        self.assertIn('error_code', responses[2])
+        self.assertIsInstance(responses[3], bytes)
+        self.assertGreater(len(responses[3]), 0)
+
+        try:
+            import numpy as np
+        except ImportError:
+            return
+        coords = np.array([[loc["lon"], loc["lat"]] for loc in locations])
+        times, distances = pool.matrix_arrays(coords, coords, json.dumps({"costing": "auto"}))
+        self.assertEqual(times.shape, (2, 2))
+        self.assertEqual(distances.shape, (2, 2))
+        self.assertEqual(times[0][0], 0)
+        self.assertGreater(times[0][1], 0)
+        self.assertGreater(distances[1][0], 0)
+
+        shapes = pool.trace_arrays("trace_route", [coords, coords[::-1]],
+                                   json.dumps({"costing": "auto", "shape_match": "map_snap"}))
+        self.assertEqual(len(shapes), 2)
+        for shape in shapes:
+            self.assertIsInstance(shape, bytes)
+            self.assertGreater(len(shape), 0)
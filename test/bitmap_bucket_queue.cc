@@ -0,0 +1,217 @@
+#include "baldr/bitmap_bucket_queue.h"
+#include "baldr/double_bucket_queue.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "test.h"
+
+using namespace std;
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+struct simple_label {
+  float c;
+  float sortcost() const {
+    return c;
+  }
+};
+
+void TryAddRemove(const std::vector<uint32_t>& costs,
+                  const std::vector<uint32_t>& expectedorder,
+                  const float range = 10000) {
+  std::vector<simple_label> edgelabels;
+
+  uint32_t i = 0;
+  BitmapBucketQueue<simple_label> adjlist(0, range, 1, &edgelabels);
+  for (auto cost : costs) {
+    edgelabels.emplace_back(simple_label{static_cast<float>(cost)});
+    adjlist.add(i);
+    ++i;
+  }
+  for (auto expected : expectedorder) {
+    uint32_t labelindex = adjlist.pop();
+    ASSERT_NE(labelindex, baldr::kInvalidLabel) << "TryAddRemove: ran out of labels";
+    EXPECT_EQ(edgelabels[labelindex].sortcost(), (float)expected)
+        << "TryAddRemove: expected order test failed";
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel) << "TryAddRemove: expected an empty queue";
+}
+
+TEST(BitmapBucketQueue, TestInvalidConstruction) {
+  std::vector<simple_label> edgelabels;
+  EXPECT_THROW(BitmapBucketQueue<simple_label> adjlist(0, 10000, 0, &edgelabels), runtime_error)
+      << "Invalid bucket size not caught";
+  EXPECT_THROW(BitmapBucketQueue<simple_label> adjlist(0, 0.0f, 1, &edgelabels), runtime_error)
+      << "Invalid cost range not caught";
+}
+
+TEST(BitmapBucketQueue, TestAddRemove) {
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005,
+                                 758, 167, 258, 16442, 278,  111111000};
+  std::vector<uint32_t> expectedorder = costs;
+  std::sort(expectedorder.begin(), expectedorder.end());
+  TryAddRemove(costs, expectedorder);
+  // A tiny range pushes almost everything through the coarse buckets and the overflow bucket
+  TryAddRemove(costs, expectedorder, 10);
+}
+
+TEST(BitmapBucketQueue, TestClear) {
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005,
+                                 758, 167, 258, 16442, 278,  111111000};
+  std::vector<simple_label> edgelabels;
+  BitmapBucketQueue<simple_label> adjlist(0, 10000, 50, &edgelabels);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    edgelabels.emplace_back(simple_label{static_cast<float>(costs[i])});
+    adjlist.add(i);
+  }
+  adjlist.clear();
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel)
+      << "TryClear: failed to return invalid edge index after Clear";
+
+  // The queue must be usable again after clear and reuse
+  adjlist.reuse(0, 100, 1, &edgelabels);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    adjlist.add(i);
+  }
+  std::vector<uint32_t> expectedorder = costs;
+  std::sort(expectedorder.begin(), expectedorder.end());
+  for (auto expected : expectedorder) {
+    const auto labelindex = adjlist.pop();
+    ASSERT_NE(labelindex, baldr::kInvalidLabel);
+    EXPECT_EQ(edgelabels[labelindex].sortcost(), (float)expected);
+  }
+  EXPECT_EQ(adjlist.pop(), baldr::kInvalidLabel);
+}
+
+TEST(BitmapBucketQueue, RC4FloatPrecisionErrors) {
+  std::vector<uint32_t> costs = {1320209856};
+  TryAddRemove(costs, costs);
+}
+
+TEST(BitmapBucketQueue, TestSameOrderAsDoubleBucketQueue) {
+  // With a bucket size of 1 and integer costs both queues must hand out the same costs in the
+  // same order, whatever path the labels take on the way
+  std::mt19937 gen(42);
+  std::vector<simple_label> costs;
+  for (size_t i = 0; i < 5000; ++i) {
+    costs.push_back({std::floor(test::rand01(gen) * 1000000.f)});
+  }
+  DoubleBucketQueue<simple_label> dbqueue(0, 500, 1, &costs);
+  BitmapBucketQueue<simple_label> bmqueue(0, 500, 1, &costs);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    dbqueue.add(i);
+    bmqueue.add(i);
+  }
+  for (size_t i = 0; i < costs.size(); ++i) {
+    const auto expected = dbqueue.pop();
+    const auto actual = bmqueue.pop();
+    ASSERT_NE(actual, baldr::kInvalidLabel);
+    EXPECT_EQ(costs[expected].sortcost(), costs[actual].sortcost());
+  }
+  EXPECT_EQ(bmqueue.pop(), baldr::kInvalidLabel);
+}
+
+void TryRemove(BitmapBucketQueue<simple_label>& bmqueue,
+               std::unordered_set<uint32_t>& addedLabels,
+               const std::vector<simple_label>& costs) {
+  auto previous_cost = -std::numeric_limits<float>::infinity();
+  const size_t num_to_remove = addedLabels.size();
+  for (size_t i = 0; i < num_to_remove; ++i) {
+    const auto top = bmqueue.pop();
+    ASSERT_NE(top, baldr::kInvalidLabel)
+        << "TryRemove: expected " + std::to_string(num_to_remove) + " labels to remove";
+    EXPECT_EQ(addedLabels.erase(top), 1u) << "TryRemove: label returned twice";
+    const auto cost = costs[top].sortcost();
+    EXPECT_LE(previous_cost, cost) << "TryRemove: expected order test failed";
+    previous_cost = cost;
+  }
+  EXPECT_EQ(bmqueue.pop(), baldr::kInvalidLabel) << "Simulation: expect list to be empty";
+}
+
+void TrySimulation(BitmapBucketQueue<simple_label>& bmqueue,
+                   std::vector<simple_label>& costs,
+                   size_t loop_count,
+                   size_t expansion_size,
+                   size_t max_increment_cost) {
+  // Track all label indexes in the queue
+  std::unordered_set<uint32_t> addedLabels;
+
+  const uint32_t idx = costs.size();
+  costs.push_back({10.f});
+  bmqueue.add(idx);
+  std::mt19937 gen(loop_count);
+  for (size_t i = 0; i < loop_count; i++) {
+    const auto key = bmqueue.pop();
+    if (key == baldr::kInvalidLabel) {
+      break;
+    }
+
+    const auto min_cost = costs[key].sortcost();
+    // Must be the minimal one among the tracked labels
+    for (auto k : addedLabels) {
+      EXPECT_LE(min_cost, costs[k].sortcost()) << "Simulation: minimal cost expected";
+    }
+    addedLabels.erase(key);
+
+    for (size_t j = 0; j < expansion_size; j++) {
+      const auto newcost = std::floor(min_cost + 1 + test::rand01(gen) * max_increment_cost);
+      if (j % 2 == 0 && !addedLabels.empty()) {
+        // Decrease cost
+        const auto idx = *std::next(addedLabels.begin(), test::rand01(gen) * (addedLabels.size()));
+        if (newcost < costs[idx].sortcost()) {
+          bmqueue.decrease(idx, newcost);
+          costs[idx] = {newcost};
+        }
+      } else {
+        // Add new label
+        const uint32_t idx = costs.size();
+        costs.push_back({newcost});
+        bmqueue.add(idx);
+        addedLabels.insert(idx);
+      }
+    }
+  }
+
+  TryRemove(bmqueue, addedLabels, costs);
+}
+
+TEST(BitmapBucketQueue, TestSimulation) {
+  {
+    std::vector<simple_label> costs;
+    BitmapBucketQueue<simple_label> bmqueue1(0, 100000, 1, &costs);
+    TrySimulation(bmqueue1, costs, 1000, 10, 1000);
+  }
+
+  {
+    std::vector<simple_label> costs;
+    BitmapBucketQueue<simple_label> bmqueue2(0, 100000, 1, &costs);
+    TrySimulation(bmqueue2, costs, 222, 40, 100);
+  }
+
+  {
+    std::vector<simple_label> costs;
+    BitmapBucketQueue<simple_label> bmqueue3(0, 1000, 1, &costs);
+    TrySimulation(bmqueue3, costs, 333, 60, 100);
+  }
+
+  {
+    // Increments far larger than the range exercise the coarse buckets and the overflow bucket
+    std::vector<simple_label> costs;
+    BitmapBucketQueue<simple_label> bmqueue4(0, 50, 1, &costs);
+    TrySimulation(bmqueue4, costs, 2000, 5, 10000);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
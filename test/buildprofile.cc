@@ -0,0 +1,80 @@
+#include "baldr/rapidjson_utils.h"
+#include "filesystem.h"
+#include "mjolnir/buildprofile.h"
+
+#include "test.h"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+boost::property_tree::ptree make_config(const std::string& report) {
+  boost::property_tree::ptree config;
+  config.put("mjolnir.tile_dir", "test/data/buildprofile_tiles");
+  config.put("mjolnir.concurrency", 2);
+  config.put("mjolnir.build_profile", report);
+  return config;
+}
+
+// keeps the cpu busy for a moment so the stage has something to measure
+void busy(std::chrono::milliseconds duration) {
+  auto end = std::chrono::steady_clock::now() + duration;
+  volatile uint64_t sum = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    sum = sum + 1;
+  }
+}
+
+TEST(BuildProfile, StagesInTheOrderTheyRan) {
+  BuildProfile profile(make_config(""));
+  profile.Start(BuildStage::kParseWays);
+  busy(std::chrono::milliseconds(50));
+  // starting a stage ends the one before it
+  profile.Start(BuildStage::kParseNodes);
+  busy(std::chrono::milliseconds(20));
+  profile.Stop();
+  // stopping twice does not add anything
+  profile.Stop();
+
+  const auto& stages = profile.stages();
+  ASSERT_EQ(stages.size(), 2);
+  EXPECT_EQ(stages[0].stage, BuildStage::kParseWays);
+  EXPECT_EQ(stages[1].stage, BuildStage::kParseNodes);
+  EXPECT_GE(stages[0].wall_secs, 0.05);
+  EXPECT_GT(stages[0].cpu_secs, 0);
+  EXPECT_GT(stages[0].peak_rss_bytes, 0);
+  EXPECT_GT(stages[0].thread_utilization, 0);
+  // one thread busy out of the two configured
+  EXPECT_LE(stages[0].thread_utilization, 0.75);
+  // the parsing stages do not count tiles
+  EXPECT_EQ(stages[0].tiles, 0);
+}
+
+TEST(BuildProfile, ReportWritesJson) {
+  const std::string report_file = "test/data/buildprofile.json";
+  filesystem::remove(report_file);
+  BuildProfile profile(make_config(report_file));
+  profile.Start(BuildStage::kInitialize);
+  profile.Start(BuildStage::kConstructEdges);
+  busy(std::chrono::milliseconds(10));
+  profile.Report();
+
+  boost::property_tree::ptree report;
+  rapidjson::read_json(report_file, report);
+  EXPECT_EQ(report.get<unsigned int>("concurrency"), 2);
+  EXPECT_GT(report.get<double>("wall_secs"), 0);
+  const auto& stages = report.get_child("stages");
+  ASSERT_EQ(stages.size(), 2);
+  EXPECT_EQ(stages.front().second.get<std::string>("stage"), "initialize");
+  EXPECT_EQ(stages.back().second.get<std::string>("stage"), "constructedges");
+  for (const auto& key : {"wall_secs", "cpu_secs", "peak_rss_bytes", "bytes_read", "bytes_written",
+                          "tiles", "tiles_per_sec", "thread_utilization"}) {
+    EXPECT_TRUE(stages.back().second.count(key)) << key;
+  }
+}
+
+} // namespace
@@ -67,6 +67,43 @@ TEST(Compression, roundtrip) {
       << "decompressed doesn't match string before compression";
 }
 
+TEST(Compression, dictionary) {
+  // the zlib wrapper takes a preset dictionary, gzip doesnt
+  const std::string dictionary = "a gzipped bottle with a message in it";
+  std::string message = "message in a gzipped bottle";
+  std::string deflated;
+  EXPECT_FALSE(
+      valhalla::baldr::deflate(std::bind(deflate_src, std::placeholders::_1, std::ref(message)),
+                               std::bind(deflate_dst, std::placeholders::_1, std::ref(deflated)),
+                               Z_BEST_COMPRESSION, true, dictionary));
+  deflated.clear();
+  EXPECT_TRUE(
+      valhalla::baldr::deflate(std::bind(deflate_src, std::placeholders::_1, std::ref(message)),
+                               std::bind(deflate_dst, std::placeholders::_1, std::ref(deflated)),
+                               Z_BEST_COMPRESSION, false, dictionary))
+      << "Can't deflate string with a dictionary";
+
+  // it cant be inflated without the dictionary or with another one
+  std::string inflated;
+  EXPECT_FALSE(
+      valhalla::baldr::inflate(std::bind(inflate_src, std::placeholders::_1, std::ref(deflated)),
+                               std::bind(inflate_dst, std::placeholders::_1, std::ref(inflated))));
+  inflated.clear();
+  EXPECT_FALSE(
+      valhalla::baldr::inflate(std::bind(inflate_src, std::placeholders::_1, std::ref(deflated)),
+                               std::bind(inflate_dst, std::placeholders::_1, std::ref(inflated)),
+                               "some other dictionary"));
+
+  // but with the right one
+  inflated.clear();
+  EXPECT_TRUE(
+      valhalla::baldr::inflate(std::bind(inflate_src, std::placeholders::_1, std::ref(deflated)),
+                               std::bind(inflate_dst, std::placeholders::_1, std::ref(inflated)),
+                               dictionary))
+      << "failed to inflate string with its dictionary";
+  EXPECT_EQ(inflated, message);
+}
+
 TEST(Compression, fail_deflate) {
   auto deflate_src_fail = [](z_stream& s) -> int {
     throw std::runtime_error("you cant catch me");
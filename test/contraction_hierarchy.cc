@@ -0,0 +1,193 @@
+#include "thor/contraction_hierarchy.h"
+
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "test.h"
+
+using namespace valhalla::thor;
+
+namespace {
+
+using Edge = ContractionHierarchy::Edge;
+
+// Plain Dijkstra to check the hierarchy against
+float dijkstra(uint32_t node_count, const std::vector<Edge>& edges, uint32_t source, uint32_t target) {
+  std::vector<std::vector<const Edge*>> out(node_count);
+  for (const auto& edge : edges) {
+    out[edge.from].push_back(&edge);
+  }
+  std::vector<float> distance(node_count, std::numeric_limits<float>::infinity());
+  using entry_t = std::pair<float, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+  distance[source] = 0.f;
+  queue.emplace(0.f, source);
+  while (!queue.empty()) {
+    const auto current = queue.top();
+    queue.pop();
+    if (current.second == target) {
+      return current.first;
+    }
+    if (current.first > distance[current.second]) {
+      continue;
+    }
+    for (const auto* edge : out[current.second]) {
+      const float cost = current.first + edge->weight;
+      if (cost < distance[edge->to]) {
+        distance[edge->to] = cost;
+        queue.emplace(cost, edge->to);
+      }
+    }
+  }
+  return std::numeric_limits<float>::infinity();
+}
+
+// A grid with random weights, some one way streets and a few missing links
+std::vector<Edge> make_grid(uint32_t width, uint32_t height, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::vector<Edge> edges;
+  const auto add = [&](uint32_t a, uint32_t b) {
+    const float r = test::rand01(gen);
+    if (r < 0.05f) {
+      return;
+    }
+    const float weight = std::floor(1.f + test::rand01(gen) * 100.f);
+    if (r < 0.15f) {
+      edges.push_back({a, b, weight, edges.size()});
+    } else if (r < 0.25f) {
+      edges.push_back({b, a, weight, edges.size()});
+    } else {
+      edges.push_back({a, b, weight, edges.size()});
+      edges.push_back({b, a, weight, edges.size()});
+    }
+  };
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t node = y * width + x;
+      if (x + 1 < width) {
+        add(node, node + 1);
+      }
+      if (y + 1 < height) {
+        add(node, node + width);
+      }
+    }
+  }
+  return edges;
+}
+
+void check_path(const std::vector<Edge>& edges,
+                uint32_t source,
+                uint32_t target,
+                const ContractionHierarchy::Path& path) {
+  float cost = 0.f;
+  uint32_t node = source;
+  for (const auto id : path.edges) {
+    ASSERT_LT(id, edges.size());
+    const auto& edge = edges[id];
+    ASSERT_EQ(edge.from, node) << "Unpacked path is not connected";
+    cost += edge.weight;
+    node = edge.to;
+  }
+  EXPECT_EQ(node, target);
+  EXPECT_FLOAT_EQ(cost, path.cost);
+}
+
+TEST(ContractionHierarchy, SmallGraph) {
+  //  0 -> 1 -> 2 -> 3 with a slower direct 0 -> 3 and a faster 1 -> 3
+  std::vector<Edge> edges = {{0, 1, 1.f, 10}, {1, 2, 1.f, 11}, {2, 3, 1.f, 12},
+                             {0, 3, 5.f, 13}, {1, 3, 1.5f, 14}};
+  const auto ch = ContractionHierarchy::Build(4, edges);
+  EXPECT_EQ(ch.node_count(), 4);
+
+  ContractionHierarchy::Path path;
+  ASSERT_TRUE(ch.Query(0, 3, path));
+  EXPECT_FLOAT_EQ(path.cost, 2.5f);
+  EXPECT_EQ(path.edges, (std::vector<uint64_t>{10, 14}));
+
+  ASSERT_TRUE(ch.Query(2, 2, path));
+  EXPECT_EQ(path.cost, 0.f);
+  EXPECT_TRUE(path.edges.empty());
+
+  // Everything is one way
+  EXPECT_FALSE(ch.Query(3, 0, path));
+}
+
+TEST(ContractionHierarchy, InvalidInput) {
+  EXPECT_THROW(ContractionHierarchy::Build(2, {{0, 2, 1.f, 0}}), std::runtime_error);
+  EXPECT_THROW(ContractionHierarchy::Build(2, {{0, 1, -1.f, 0}}), std::runtime_error);
+  const auto ch = ContractionHierarchy::Build(2, {{0, 1, 1.f, 0}});
+  ContractionHierarchy::Path path;
+  EXPECT_THROW(ch.Query(0, 5, path), std::runtime_error);
+}
+
+TEST(ContractionHierarchy, MatchesDijkstra) {
+  const uint32_t width = 25, height = 20;
+  for (uint32_t seed = 0; seed < 3; ++seed) {
+    const auto edges = make_grid(width, height, seed);
+    // A small witness limit makes for more shortcuts, which must not change any result
+    for (uint32_t witness_nodes : {5u, 500u}) {
+      const auto ch = ContractionHierarchy::Build(width * height, edges, witness_nodes);
+      std::mt19937 gen(seed);
+      for (int i = 0; i < 200; ++i) {
+        const uint32_t source = gen() % (width * height);
+        const uint32_t target = gen() % (width * height);
+        const float expected = dijkstra(width * height, edges, source, target);
+        ContractionHierarchy::Path path;
+        const bool found = ch.Query(source, target, path);
+        ASSERT_EQ(found, expected != std::numeric_limits<float>::infinity())
+            << source << " -> " << target;
+        if (found) {
+          EXPECT_FLOAT_EQ(path.cost, expected) << source << " -> " << target;
+          check_path(edges, source, target, path);
+        }
+      }
+    }
+  }
+}
+
+TEST(ContractionHierarchy, ParallelEdgesAndLoops) {
+  std::vector<Edge> edges = {{0, 1, 3.f, 0}, {0, 1, 2.f, 1}, {1, 1, 0.f, 2},
+                             {1, 2, 4.f, 3}, {1, 2, 1.f, 4}, {2, 0, 1.f, 5}};
+  const auto ch = ContractionHierarchy::Build(3, edges);
+  ContractionHierarchy::Path path;
+  ASSERT_TRUE(ch.Query(0, 2, path));
+  EXPECT_FLOAT_EQ(path.cost, 3.f);
+  EXPECT_EQ(path.edges, (std::vector<uint64_t>{1, 4}));
+  ASSERT_TRUE(ch.Query(1, 0, path));
+  EXPECT_FLOAT_EQ(path.cost, 2.f);
+  EXPECT_EQ(path.edges, (std::vector<uint64_t>{4, 5}));
+}
+
+TEST(ContractionHierarchy, WriteRead) {
+  const uint32_t width = 10, height = 10;
+  const auto edges = make_grid(width, height, 7);
+  const auto ch = ContractionHierarchy::Build(width * height, edges);
+  const std::string file = "test/data/contraction_hierarchy.bin";
+  ch.Write(file);
+  const auto loaded = ContractionHierarchy::Read(file);
+  std::remove(file.c_str());
+
+  EXPECT_EQ(loaded.node_count(), ch.node_count());
+  EXPECT_EQ(loaded.shortcut_count(), ch.shortcut_count());
+  for (uint32_t source = 0; source < width * height; source += 7) {
+    for (uint32_t target = 0; target < width * height; target += 11) {
+      ContractionHierarchy::Path expected, actual;
+      ASSERT_EQ(ch.Query(source, target, expected), loaded.Query(source, target, actual));
+      EXPECT_EQ(expected.cost, actual.cost);
+      EXPECT_EQ(expected.edges, actual.edges);
+    }
+  }
+
+  EXPECT_THROW(ContractionHierarchy::Read("test/data/does_not_exist.bin"), std::runtime_error);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
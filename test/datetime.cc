@@ -701,6 +701,41 @@ TEST(DateTime, DiffCaching) {
   EXPECT_GE(cache.size(), test_cases.size());
 }
 
+TEST(DateTime, CachedOffsets) {
+  // sweep across the transitions of zones with and without dst, negative and part hour offsets and
+  // check the cached conversions against converting with the date library directly
+  const auto& tzdb = DateTime::get_tz_db();
+  for (const auto* name : {"America/New_York", "Europe/Berlin", "Asia/Kolkata", "Asia/Kathmandu",
+                           "Australia/Lord_Howe", "America/St_Johns", "Etc/UTC"}) {
+    const auto* tz = tzdb.from_index(tzdb.to_index(name));
+    ASSERT_NE(tz, nullptr) << name;
+    // 2016-01-01 through 2017-12-31 in steps of under 7 hours, so every hour of the day is hit
+    for (uint64_t seconds = 1451606400; seconds < 1514764800; seconds += 24931) {
+      const auto zoned = date::make_zoned(tz, date::sys_seconds(std::chrono::seconds(seconds)));
+      std::ostringstream expected;
+      expected << date::format("%FT%R%z", zoned);
+      auto expected_date = expected.str();
+      expected_date.insert(19, 1, ':');
+
+      EXPECT_EQ(DateTime::seconds_to_date(seconds, tz), expected_date) << name << " " << seconds;
+      EXPECT_EQ(DateTime::seconds_to_date(seconds, tz, false), expected_date.substr(0, 16));
+      EXPECT_EQ(DateTime::utc_offset(seconds, tz), zoned.get_info().offset.count());
+
+      const auto local = zoned.get_local_time();
+      const auto days = date::floor<date::days>(local);
+      const auto second_of_week =
+          static_cast<uint32_t>((date::weekday(days) - date::Sunday).count() *
+                                    valhalla::midgard::kSecondsPerDay +
+                                (local - days).count());
+      EXPECT_EQ(DateTime::second_of_week(seconds, tz), second_of_week) << name << " " << seconds;
+    }
+  }
+
+  EXPECT_EQ(DateTime::seconds_to_date_utc(1597241829), "2020-08-12T14:17:09Z");
+  EXPECT_EQ(DateTime::seconds_to_date_utc(0), "1970-01-01T00:00:00Z");
+  EXPECT_EQ(DateTime::utc_offset(1597241829, nullptr), 0);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
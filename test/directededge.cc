@@ -16,6 +16,10 @@ TEST(DirectedEdge, test_sizeof) {
   EXPECT_EQ(sizeof(DirectedEdge), kDirectedEdgeExpectedSize);
 }
 
+TEST(DirectedEdge, test_hot_sizeof) {
+  EXPECT_EQ(sizeof(DirectedEdgeHot), 16);
+}
+
 TEST(DirectedEdge, TestWriteRead) {
   // Test building a directed edge and reading back values
   DirectedEdge directededge;
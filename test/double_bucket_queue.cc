@@ -80,6 +80,28 @@ TEST(DoubleBucketQueue, TestClear) {
   TryClear(costs);
 }
 
+TEST(DoubleBucketQueue, Redistributions) {
+  std::vector<simple_label> edgelabels;
+  DoubleBucketQueue<simple_label> adjlist(0, 100, 1, &edgelabels);
+  // one cost within the buckets and two beyond them, each in a range of its own
+  for (auto cost : {50.f, 150.f, 450.f}) {
+    edgelabels.emplace_back(simple_label{cost});
+    adjlist.add(edgelabels.size() - 1);
+  }
+  EXPECT_EQ(adjlist.redistributions(), 0);
+  EXPECT_EQ(edgelabels[adjlist.pop()].sortcost(), 50.f);
+  EXPECT_EQ(adjlist.redistributions(), 0);
+  EXPECT_EQ(edgelabels[adjlist.pop()].sortcost(), 150.f);
+  EXPECT_EQ(adjlist.redistributions(), 1);
+  EXPECT_EQ(edgelabels[adjlist.pop()].sortcost(), 450.f);
+  EXPECT_EQ(adjlist.redistributions(), 2);
+
+  // setting the queue up again starts the count over
+  adjlist.clear();
+  adjlist.reuse(0, 100, 1, &edgelabels);
+  EXPECT_EQ(adjlist.redistributions(), 0);
+}
+
 TEST(DoubleBucketQueue, RC4FloatPrecisionErrors) {
   // Tests what happens when the internal floats in DoubleBucketQueue loses
   // precision
@@ -1,4 +1,5 @@
 #include "test.h"
+#include <algorithm>
 #include <cstdint>
 
 #include <fstream>
@@ -100,6 +101,54 @@ TEST(EdgeInfoBuilder, TestWriteRead) {
   }
 }
 
+TEST(EdgeInfoBuilder, ElevationProfile) {
+  EdgeInfoBuilder eibuilder;
+  eibuilder.set_wayid(42);
+  eibuilder.set_shape(std::vector<PointLL>{{-76.3002, 40.0433}, {-76.3036, 40.043}});
+
+  // no profile unless there are samples at both ends
+  eibuilder.set_elevation({100.f});
+  auto memblock = ToFileAndBack(eibuilder);
+  EXPECT_TRUE(EdgeInfo(memblock.get(), nullptr, 0).elevation_profile().empty());
+  EXPECT_EQ(EdgeInfo(memblock.get(), nullptr, 0).elevation_profile().at(0.5), kNoElevationData);
+
+  // the steep part is more than the encoding can take in one step, the next samples catch up
+  std::vector<float> elevation{-10.1f, 0.f, 3.3f, 60.f, 61.f, 61.f, 40.2f};
+  eibuilder.set_elevation(elevation);
+  memblock = ToFileAndBack(eibuilder);
+  EdgeInfo ei(memblock.get(), nullptr, 0);
+  EXPECT_EQ(ei.wayid(), 42);
+  EXPECT_EQ(ei.shape().size(), 2);
+
+  auto profile = ei.elevation_profile();
+  ASSERT_EQ(profile.size(), elevation.size());
+  std::vector<float> decoded(profile.begin(), profile.end());
+  ASSERT_EQ(decoded.size(), elevation.size());
+  for (size_t i = 0; i < elevation.size(); ++i) {
+    if (i == 3) {
+      EXPECT_NEAR(decoded[i], 3.3f + 127 * kElevationProfileBinSize, kElevationProfileBinSize);
+    } else {
+      EXPECT_NEAR(decoded[i], elevation[i], kElevationProfileBinSize) << "index " << i;
+    }
+  }
+
+  // interpolated between the samples
+  EXPECT_NEAR(profile.at(0), -10.f, kElevationProfileBinSize);
+  EXPECT_NEAR(profile.at(1), 40.2f, kElevationProfileBinSize);
+  EXPECT_NEAR(profile.at(1.5 / 6), 1.65f, kElevationProfileBinSize);
+  EXPECT_NEAR(profile.at(5.5 / 6), 50.6f, kElevationProfileBinSize);
+
+  // it survives being read back into a builder
+  EdgeInfoBuilder copy;
+  copy.set_wayid(ei.wayid());
+  copy.set_encoded_shape(ei.encoded_shape());
+  copy.set_encoded_elevation(ei.encoded_elevation());
+  EXPECT_EQ(copy.SizeOf(), eibuilder.SizeOf());
+  memblock = ToFileAndBack(copy);
+  auto copied = EdgeInfo(memblock.get(), nullptr, 0).elevation_profile();
+  EXPECT_TRUE(std::equal(copied.begin(), copied.end(), profile.begin(), profile.end()));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
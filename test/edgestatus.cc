@@ -66,6 +66,65 @@ TEST(EdgeStatus, TestStatus) {
   TryGet(edgestatus, GraphId(555, 3, 1), EdgeSet::kUnreachedOrReset);
 }
 
+TEST(EdgeStatus, ReuseAcrossClears) {
+  EdgeStatus edgestatus;
+
+  GraphTileHeader header;
+  header.set_directededgecount(1000);
+  test_tile* tt = new test_tile;
+  tt->header_ = &header;
+  graph_tile_ptr tile{tt};
+
+  for (uint32_t round = 0; round < 5; ++round) {
+    // everything from the last round has to look unreached again
+    TryGet(edgestatus, GraphId(555, 1, 10), EdgeSet::kUnreachedOrReset);
+    TryGet(edgestatus, GraphId(555, 1, 20), EdgeSet::kUnreachedOrReset);
+    TryGet(edgestatus, GraphId(556, 1, 10), EdgeSet::kUnreachedOrReset);
+    EXPECT_THROW(edgestatus.Update(GraphId(555, 1, 10), EdgeSet::kPermanent), std::runtime_error);
+
+    edgestatus.Set(GraphId(555, 1, 10), EdgeSet::kTemporary, round, tile);
+    edgestatus.Set(GraphId(556, 1, 10), EdgeSet::kTemporary, round + 1, tile, 3);
+    EXPECT_EQ(edgestatus.Get(GraphId(555, 1, 10)).index(), round);
+    EXPECT_EQ(edgestatus.Get(GraphId(556, 1, 10), 3).index(), round + 1);
+    // different path ids don't share their statuses
+    TryGet(edgestatus, GraphId(556, 1, 10), EdgeSet::kUnreachedOrReset);
+
+    edgestatus.Update(GraphId(555, 1, 10), EdgeSet::kPermanent);
+    TryGet(edgestatus, GraphId(555, 1, 10), EdgeSet::kPermanent);
+
+    // pointers handed out are the same array the getters see
+    auto* ptr = edgestatus.GetPtr(GraphId(555, 1, 20), tile);
+    *ptr = {EdgeSet::kSkipped, 7};
+    TryGet(edgestatus, GraphId(555, 1, 20), EdgeSet::kSkipped);
+    EXPECT_EQ(ptr - edgestatus.GetPtr(GraphId(555, 1, 10), tile), 10);
+
+    // keep the arrays around for the next round
+    edgestatus.clear(2000);
+  }
+
+  // a reservation too small for what's allocated releases the arrays but still resets
+  edgestatus.Set(GraphId(555, 1, 10), EdgeSet::kPermanent, 1, tile);
+  edgestatus.clear(10);
+  TryGet(edgestatus, GraphId(555, 1, 10), EdgeSet::kUnreachedOrReset);
+  edgestatus.Set(GraphId(555, 1, 10), EdgeSet::kPermanent, 1, tile);
+  edgestatus.clear();
+  TryGet(edgestatus, GraphId(555, 1, 10), EdgeSet::kUnreachedOrReset);
+}
+
+TEST(EdgeStatus, Move) {
+  GraphTileHeader header;
+  header.set_directededgecount(100);
+  test_tile* tt = new test_tile;
+  tt->header_ = &header;
+  graph_tile_ptr tile{tt};
+
+  EdgeStatus edgestatus;
+  edgestatus.Set(GraphId(555, 1, 10), EdgeSet::kTemporary, 5, tile);
+  EdgeStatus moved(std::move(edgestatus));
+  TryGet(moved, GraphId(555, 1, 10), EdgeSet::kTemporary);
+  EXPECT_EQ(moved.Get(GraphId(555, 1, 10)).index(), 5);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
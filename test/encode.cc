@@ -620,6 +620,41 @@ TEST(Encode, VarInt) {
                   {58.26482, -169.02219}});
 }
 
+TEST(Encode, AppendToBuffer) {
+  const container_t first = {{-76.3002, 40.0433}, {-76.3036, 40.043}};
+  const container_t second = {{41.37084, -5.03016}, {76.8342, 42.01251}};
+
+  // encoding appends to whatever is in the buffer already
+  std::string buffer = "prefix";
+  encode(first, buffer);
+  EXPECT_EQ(buffer, "prefix" + encode(first));
+  buffer.clear();
+  encode(second, buffer);
+  EXPECT_EQ(buffer, encode(second));
+
+  buffer.clear();
+  encode7(first, buffer);
+  encode7(second, buffer);
+  EXPECT_EQ(buffer, encode7(first) + encode7(second));
+}
+
+TEST(Encode, Rounding) {
+  // halfway values round away from zero no matter their sign
+  EXPECT_EQ(encode(container_t{{0.5, -0.5}}, 1), encode(container_t{{1, -1}}, 1));
+  EXPECT_EQ(encode(container_t{{2.5, -2.5}}, 1), encode(container_t{{3, -3}}, 1));
+  EXPECT_EQ(encode(container_t{{0.49999, -0.49999}}, 1), encode(container_t{{0, 0}}, 1));
+  EXPECT_EQ(encode7(container_t{{1.5, -1.5}}, 1), encode7(container_t{{2, -2}}, 1));
+}
+
+TEST(Encode, Malformed) {
+  // the last number is cut off, short and long enough to take the checked and unchecked paths
+  EXPECT_THROW(decode<container_t>(std::string("~~")), std::runtime_error);
+  EXPECT_THROW(decode<container_t>(std::string("gq`kkAny~opCvQnsE~~")), std::runtime_error);
+  EXPECT_THROW(decode<container_t>(std::string(16, '~')), std::runtime_error);
+  EXPECT_THROW(decode7<container_t>(std::string(2, '\xff')), std::runtime_error);
+  EXPECT_THROW(decode7<container_t>(std::string(16, '\xff')), std::runtime_error);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -144,6 +144,34 @@ TEST(EnhancedTripPathCalculateRightLeftIntersectingEdgeCounts, SharpLeftRightLef
                                               IntersectingEdgeCounts(5, 0, 0, 0, 1, 1, 0, 0));
 }
 
+TEST(EnhancedTripPathCalculateRightLeftIntersectingEdgeCounts, SummarizedNode) {
+  // Nodes of a leg share their intersecting edge summary, the counts must match a lone node
+  TripLeg leg;
+  TripLeg_Node* node = leg.add_node();
+  node->mutable_edge()->set_begin_heading(5);
+  TripLeg_IntersectingEdge* ie1 = node->add_intersecting_edge();
+  ie1->set_begin_heading(355);
+  ie1->set_driveability(TripLeg_Traversability_kBoth);
+  TripLeg_IntersectingEdge* ie2 = node->add_intersecting_edge();
+  ie2->set_begin_heading(90);
+  ie2->set_driveability(TripLeg_Traversability_kBackward);
+  leg.add_node();
+
+  EnhancedTripLeg etp(leg);
+  for (int i = 0; i < 2; ++i) {
+    TryCalculateRightLeftIntersectingEdgeCounts(0, etp.GetEnhancedNode(0),
+                                                IntersectingEdgeCounts(1, 0, 0, 0, 1, 1, 1, 1));
+  }
+  TryCalculateRightLeftIntersectingEdgeCounts(0, std::make_unique<EnhancedTripLeg_Node>(node),
+                                              IntersectingEdgeCounts(1, 0, 0, 0, 1, 1, 1, 1));
+
+  auto enhanced_node = etp.GetEnhancedNode(0);
+  EXPECT_TRUE(enhanced_node->HasTraversableIntersectingEdge(TravelMode::kDrive));
+  EXPECT_TRUE(enhanced_node->HasTraversableOutboundIntersectingEdge(TravelMode::kDrive));
+  EXPECT_FALSE(enhanced_node->HasTraversableIntersectingEdge(TravelMode::kPedestrian));
+  EXPECT_FALSE(etp.GetEnhancedNode(1)->HasTraversableIntersectingEdge(TravelMode::kDrive));
+}
+
 TEST(EnhancedTripPathDefaultTurnLaneState, True) {
   TripLeg_Edge edge;
   edge.add_turn_lanes()->set_directions_mask(kTurnLaneLeft);
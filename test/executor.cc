@@ -0,0 +1,126 @@
+#include "midgard/executor.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// the pattern of the callers, tasks are taken from a shared counter by every slot
+void run_tasks(executor_t& executor,
+               uint32_t slots,
+               std::vector<int>& done,
+               std::vector<std::atomic<int>>& slot_runs) {
+  std::atomic<size_t> next(0);
+  executor.run(slots, [&](uint32_t slot) {
+    ++slot_runs[slot];
+    for (size_t i = next++; i < done.size(); i = next++) {
+      ++done[i];
+    }
+  });
+}
+
+TEST(Executor, AllTasksOnce) {
+  executor_t executor(4);
+  for (uint32_t slots : {1u, 2u, 4u, 8u}) {
+    std::vector<int> done(1000, 0);
+    std::vector<std::atomic<int>> slot_runs(slots);
+    run_tasks(executor, slots, done, slot_runs);
+    EXPECT_EQ(std::accumulate(done.begin(), done.end(), 0), 1000);
+    EXPECT_EQ(*std::min_element(done.begin(), done.end()), 1);
+    // the calling thread always runs, the others at most once
+    EXPECT_EQ(slot_runs[0], 1);
+    for (auto& runs : slot_runs) {
+      EXPECT_LE(runs, 1);
+    }
+  }
+}
+
+TEST(Executor, NoThreads) {
+  executor_t executor(0);
+  EXPECT_EQ(executor.threads(), 0);
+  std::vector<int> done(100, 0);
+  std::vector<std::atomic<int>> slot_runs(4);
+  run_tasks(executor, 4, done, slot_runs);
+  EXPECT_EQ(std::accumulate(done.begin(), done.end(), 0), 100);
+  EXPECT_EQ(slot_runs[0], 1);
+  EXPECT_EQ(slot_runs[1] + slot_runs[2] + slot_runs[3], 0);
+}
+
+TEST(Executor, BusyPool) {
+  // with every thread of the pool taken the caller does all the work and doesnt wait for them
+  executor_t executor(1);
+  std::atomic<bool> release(false);
+  std::thread blocker([&]() {
+    executor.run(2, [&](uint32_t slot) {
+      while (slot == 1 && !release) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  });
+  while (true) {
+    std::vector<int> done(10, 0);
+    std::vector<std::atomic<int>> slot_runs(2);
+    run_tasks(executor, 2, done, slot_runs);
+    EXPECT_EQ(std::accumulate(done.begin(), done.end(), 0), 10);
+    // once the blocker holds the only thread of the pool nothing else gets it
+    if (slot_runs[1] == 0)
+      break;
+  }
+  release = true;
+  blocker.join();
+}
+
+TEST(Executor, Exceptions) {
+  executor_t executor(4);
+  for (uint32_t thrower : {0u, 3u}) {
+    std::atomic<size_t> next(0);
+    std::atomic<bool> thrown(false);
+    try {
+      executor.run(4, [&](uint32_t slot) {
+        for (size_t i = next++; i < 1000; i = next++) {
+          // whichever slot gets there, the pool may not have started all slots yet
+          if (i == 500 && (slot == thrower || !thrown.exchange(true))) {
+            next = 1000;
+            throw std::runtime_error("failed");
+          }
+        }
+      });
+      FAIL() << "Expected the exception to be rethrown";
+    } catch (const std::runtime_error& e) { EXPECT_STREQ(e.what(), "failed"); }
+  }
+
+  // and the pool is still usable
+  std::vector<int> done(100, 0);
+  std::vector<std::atomic<int>> slot_runs(4);
+  run_tasks(executor, 4, done, slot_runs);
+  EXPECT_EQ(std::accumulate(done.begin(), done.end(), 0), 100);
+}
+
+TEST(Executor, Nested) {
+  // a slot may itself split its work, it never waits on slots which did not start
+  auto& executor = executor_t::shared();
+  std::atomic<size_t> total(0);
+  executor.run(4, [&](uint32_t) {
+    std::vector<int> done(100, 0);
+    std::vector<std::atomic<int>> slot_runs(4);
+    run_tasks(executor, 4, done, slot_runs);
+    total += std::accumulate(done.begin(), done.end(), 0);
+  });
+  EXPECT_GE(total, 100);
+  EXPECT_EQ(total % 100, 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,6 +26,47 @@ TEST(Factory, Register) {
   auto truck = factory.Create(Costing::truck);
 }
 
+TEST(Factory, SharedCostings) {
+  Options options;
+  const rapidjson::Document doc;
+  sif::ParseCosting(doc, "/costing_options", options);
+  options.set_costing_type(Costing::auto_);
+  CostFactory factory;
+
+  // every request gets a costing of its own
+  auto first = factory.Create(options);
+  auto second = factory.Create(options);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(first->travel_mode(), second->travel_mode());
+  EXPECT_EQ(first->access_mode(), second->access_mode());
+
+  // what one request does to its costing doesnt reach the others
+  first->set_pass(1);
+  first->set_allow_destination_only(false);
+  first->GetHierarchyLimits().front().max_up_transitions = 7;
+  auto third = factory.Create(options);
+  EXPECT_EQ(third->pass(), 0);
+  EXPECT_EQ(third->GetHierarchyLimits().front().max_up_transitions,
+            second->GetHierarchyLimits().front().max_up_transitions);
+
+  // excluded edges are only in the costing of the request which excludes them
+  auto* excluded = options.mutable_costings()->find(Costing::auto_)->second.mutable_options();
+  auto* edge = excluded->add_exclude_edges();
+  edge->set_id(baldr::GraphId(1, 2, 3));
+  edge->set_percent_along(0.5);
+  auto excluding = factory.Create(options);
+  EXPECT_TRUE(excluding->IsUserAvoidEdge(baldr::GraphId(1, 2, 3)));
+  excluded->clear_exclude_edges();
+  EXPECT_FALSE(factory.Create(options)->IsUserAvoidEdge(baldr::GraphId(1, 2, 3)));
+
+  // other options make other costings
+  excluded->set_disable_hierarchy_pruning(true);
+  EXPECT_EQ(factory.Create(options)->GetHierarchyLimits().front().max_up_transitions,
+            kUnlimitedTransitions);
+  EXPECT_NE(factory.Create(Costing::auto_)->GetHierarchyLimits().front().max_up_transitions,
+            kUnlimitedTransitions);
+}
+
 // TODO: add many more tests!
 
 } // namespace
@@ -2,13 +2,24 @@
 
 #include "baldr/connectivity_map.h"
 #include "baldr/graphreader.h"
+#include "baldr/memory_budget.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 
+#include <atomic>
+#include <chrono>
 #include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <unistd.h>
 
 #include "test.h"
 
+#if !defined(VALHALLA_SOURCE_DIR)
+#define VALHALLA_SOURCE_DIR
+#endif
+
 using namespace valhalla::baldr;
 
 namespace {
@@ -64,6 +75,66 @@ TEST(SimpleCache, CacheLimitsNoOvercommitAfterClear) {
   EXPECT_FALSE(cache.OverCommitted());
 }
 
+TEST(SimpleCache, SetMaxSize) {
+  auto cache = make_cache(10);
+  cache.cache_size_ = 8;
+  EXPECT_FALSE(cache.OverCommitted());
+  cache.SetMaxSize(5);
+  EXPECT_TRUE(cache.OverCommitted());
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+}
+
+TEST(MemoryBudget, ParsesCgroupFiles) {
+  EXPECT_EQ(memory_budget_t::ParseBytes("1073741824\n"), 1073741824);
+  EXPECT_EQ(memory_budget_t::ParseBytes("max\n"), 0);
+  EXPECT_EQ(memory_budget_t::ParseBytes(""), 0);
+  EXPECT_FLOAT_EQ(memory_budget_t::ParsePressure(
+                      "some avg10=12.50 avg60=3.00 avg300=1.00 total=1234\n"
+                      "full avg10=2.00 avg60=1.00 avg300=0.50 total=123\n"),
+                  12.5f);
+  EXPECT_FLOAT_EQ(memory_budget_t::ParsePressure(""), 0.f);
+}
+
+TEST(MemoryBudget, SharesShrinkAndGrow) {
+  constexpr size_t GB = 1024 * 1024 * 1024;
+  constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+  auto budget = std::make_shared<memory_budget_t>(0.5f, 10.f, std::chrono::seconds(0));
+
+  // without a reading the caches keep their own limit
+  EXPECT_EQ(budget->Limit(3 * GB, false), 3 * GB);
+
+  // half of 8GB split between the caches of their own, the global cache gets all of it
+  budget->Update({8 * GB, 1 * GB, 0.f});
+  auto share = budget->Join();
+  EXPECT_EQ(budget->Limit(unlimited, false), 4 * GB);
+  {
+    auto other = budget->Join();
+    EXPECT_EQ(budget->Limit(unlimited, false), 2 * GB);
+    EXPECT_EQ(budget->Limit(unlimited, true), 4 * GB);
+  }
+  EXPECT_EQ(budget->Limit(unlimited, false), 4 * GB);
+  EXPECT_EQ(budget->Limit(1 * GB, false), 1 * GB) << "The configured size is the most";
+
+  // pressure halves it, so does nearly running out of memory, then it grows back in steps
+  budget->Update({8 * GB, 1 * GB, 50.f});
+  EXPECT_EQ(budget->Limit(unlimited, false), 2 * GB);
+  budget->Update({8 * GB, 15 * GB / 2, 0.f});
+  EXPECT_EQ(budget->Limit(unlimited, false), 1 * GB);
+  budget->Update({8 * GB, 1 * GB, 0.f});
+  EXPECT_EQ(budget->Limit(unlimited, false), 3 * GB / 2);
+  for (int i = 0; i < 10; ++i) {
+    budget->Update({8 * GB, 1 * GB, 0.f});
+  }
+  EXPECT_EQ(budget->Limit(unlimited, false), 4 * GB);
+
+  // but never below what a route needs
+  for (int i = 0; i < 10; ++i) {
+    budget->Update({1 * GB, 1 * GB, 90.f});
+  }
+  EXPECT_EQ(budget->Limit(unlimited, false), memory_budget_t::kMinCacheSize);
+}
+
 void touch_tile(const uint32_t tile_id, const std::string& tile_dir, uint8_t level) {
   auto suffix = GraphTile::FileSuffix({tile_id, level, 0});
   auto fullpath = tile_dir + filesystem::path::preferred_separator + suffix;
@@ -130,7 +201,19 @@ TEST(ConnectivityMap, Basic) {
     EXPECT_NE(conn.get_color({a2, level.level, 0}), conn.get_color({d0, level.level, 0}))
         << "a is disjoint from d";
 
+    // the stored colors are mapped without the tiles
+    const std::string conn_file = "test/gphrdr_test_connectivity.bin";
+    conn.Store(conn_file);
     filesystem::remove_all(tile_dir);
+    auto mapped_pt = pt;
+    mapped_pt.put("connectivity_map", conn_file);
+    connectivity_map_t mapped(mapped_pt);
+    for (auto tile : {a0, a1, a2, b0, c0, d0, d1}) {
+      EXPECT_EQ(mapped.get_color({tile, level.level, 0}), conn.get_color({tile, level.level, 0}));
+    }
+    EXPECT_EQ(mapped.to_image(level.level), conn.to_image(level.level));
+    EXPECT_TRUE(mapped.has_data(level.level));
+    filesystem::remove(conn_file);
   }
 }
 
@@ -381,6 +464,7 @@ TEST(CacheLruHard, InsertWithEvictionBasic) {
   EXPECT_TRUE(cache.Contains(tile2_id));
   EXPECT_TRUE(cache.Contains(tile3_id));
   EXPECT_TRUE(cache.Contains(tile4_id));
+  EXPECT_EQ(cache.Evictions(), 1);
 
   // Now we access an entry that would be evicted next
   // to promote its position in the LRU list and change eviction order
@@ -399,6 +483,7 @@ TEST(CacheLruHard, InsertWithEvictionBasic) {
   EXPECT_FALSE(cache.Contains(tile3_id));
   EXPECT_TRUE(cache.Contains(tile4_id));
   EXPECT_TRUE(cache.Contains(tile5_id));
+  EXPECT_EQ(cache.Evictions(), 2);
 
   EXPECT_EQ(cache.Get(tile1_id), nullptr);
   EXPECT_EQ(cache.Get(tile3_id), nullptr);
@@ -406,6 +491,10 @@ TEST(CacheLruHard, InsertWithEvictionBasic) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
   CheckGraphTile(cache.Get(tile4_id), tile4_id, tile4_size);
   CheckGraphTile(cache.Get(tile5_id), tile5_id, tile5_size);
+
+  // Clearing the cache evicts the tiles left in it
+  cache.Clear();
+  EXPECT_EQ(cache.Evictions(), 5);
 }
 
 TEST(CacheLruHard, OverwriteSameSize) {
@@ -888,6 +977,503 @@ TEST(CacheLruSoft, TrimOnExactlyFullCache) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
 }
 
+TEST(GraphReader, Warmup) {
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/data/utrecht_tiles");
+  GraphReader reader(pt);
+  const auto tile_set = reader.GetTileSet();
+  ASSERT_FALSE(tile_set.empty());
+
+  // repeated tiles are read once and missing ones are skipped
+  std::vector<GraphId> tile_ids(tile_set.begin(), tile_set.end());
+  tile_ids.push_back(tile_ids.front());
+  tile_ids.emplace_back(0, 0, 0);
+  auto stats = reader.Warmup(tile_ids, 3);
+  EXPECT_EQ(stats.tiles, tile_set.size());
+  EXPECT_GT(stats.bytes, 0);
+  EXPECT_EQ(reader.GetCacheStats().tiles_loaded, tile_set.size());
+
+  // all of them are in the cache now
+  for (const auto& tile_id : tile_set) {
+    EXPECT_NE(reader.GetGraphTile(tile_id), nullptr);
+  }
+  EXPECT_EQ(reader.GetCacheStats().hits, tile_set.size());
+  EXPECT_EQ(reader.GetCacheStats().misses, 0);
+
+  // so warming up again has nothing to do
+  EXPECT_EQ(reader.Warmup(tile_ids, 3).tiles, 0);
+  EXPECT_EQ(reader.GetWarmupStats().tiles, tile_set.size());
+}
+
+TEST(GraphReader, TileUsage) {
+  const std::string usage_file = "test/data/utrecht_tile_usage.txt";
+  filesystem::remove(usage_file);
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/data/utrecht_tiles");
+  pt.put("tile_usage.file", usage_file);
+  pt.put("tile_usage.sample_rate", 2);
+  std::vector<GraphId> tile_ids;
+  {
+    GraphReader reader(pt);
+    const auto tile_set = reader.GetTileSet();
+    tile_ids.assign(tile_set.begin(), tile_set.end());
+    ASSERT_GE(tile_ids.size(), 2);
+    // every other access is counted
+    for (int i = 0; i < 6; ++i) {
+      reader.GetGraphTile(tile_ids[0]);
+    }
+    for (int i = 0; i < 2; ++i) {
+      reader.GetGraphTile(tile_ids[1]);
+    }
+    // the usage is written once the last reader sharing it goes away
+    GraphReader other(pt);
+    other.GetGraphTile(tile_ids[1]);
+    other.GetGraphTile(tile_ids[1]);
+    EXPECT_FALSE(filesystem::exists(usage_file));
+  }
+
+  std::ifstream usage(usage_file);
+  std::string line;
+  ASSERT_TRUE(std::getline(usage, line));
+  EXPECT_EQ(line, std::to_string(tile_ids[0].level()) + "/" +
+                      std::to_string(tile_ids[0].tileid()) + " 3");
+  ASSERT_TRUE(std::getline(usage, line));
+  EXPECT_EQ(line, std::to_string(tile_ids[1].level()) + "/" +
+                      std::to_string(tile_ids[1].tileid()) + " 2");
+  EXPECT_FALSE(std::getline(usage, line));
+  usage.close();
+  filesystem::remove(usage_file);
+}
+
+TEST(ShardedCache, PutGet) {
+  ShardedTileCache cache(4000, 4, false, TileCacheLRU::MemoryLimitControl::SOFT);
+  EXPECT_EQ(cache.ShardCount(), 4);
+
+  std::vector<GraphId> ids;
+  for (uint32_t i = 0; i < 8; ++i) {
+    ids.emplace_back(i * 100, 2, 0);
+    auto tile = cache.Put(ids.back(), graph_tile_ptr{new TestGraphTile(ids.back(), 10)}, 10);
+    CheckGraphTile(tile, ids.back(), 10);
+  }
+  EXPECT_FALSE(cache.OverCommitted());
+
+  for (const auto& id : ids) {
+    EXPECT_TRUE(cache.Contains(id));
+    CheckGraphTile(cache.Get(id), id, 10);
+    // any id in the same tile maps to the same shard
+    EXPECT_TRUE(cache.Contains(GraphId(id.tileid(), id.level(), 42)));
+  }
+  EXPECT_FALSE(cache.Contains(GraphId(12345, 2, 0)));
+
+  cache.Clear();
+  for (const auto& id : ids) {
+    EXPECT_FALSE(cache.Contains(id));
+    EXPECT_EQ(cache.Get(id), nullptr);
+  }
+}
+
+TEST(ShardedCache, CopiesShareShards) {
+  ShardedTileCache cache(4000, 3, true, TileCacheLRU::MemoryLimitControl::HARD);
+  ShardedTileCache copy(cache);
+
+  GraphId id(100, 1, 0);
+  copy.Put(id, graph_tile_ptr{new TestGraphTile(id, 123)}, 123);
+  EXPECT_TRUE(cache.Contains(id));
+  CheckGraphTile(cache.Get(id), id, 123);
+
+  cache.Clear();
+  EXPECT_FALSE(copy.Contains(id));
+}
+
+TEST(ShardedCache, TrimOnlyOvercommittedShards) {
+  // 2 shards with 500 bytes each
+  ShardedTileCache cache(1000, 2, false, TileCacheLRU::MemoryLimitControl::SOFT);
+
+  // find two tiles which land in different shards and overfill the shard of the first
+  GraphId big(0, 2, 0);
+  GraphId small;
+  for (uint32_t i = 1; i < 100 && !small.Is_Valid(); ++i) {
+    GraphId candidate(i, 2, 0);
+    cache.Put(candidate, graph_tile_ptr{new TestGraphTile(candidate, 10)}, 10);
+    cache.Put(big, graph_tile_ptr{new TestGraphTile(big, 600)}, 600);
+    if (cache.OverCommitted()) {
+      cache.Trim();
+      if (cache.Contains(candidate))
+        small = candidate;
+    }
+    cache.Clear();
+  }
+  ASSERT_TRUE(small.Is_Valid()) << "Expected some tile to land in the other shard";
+
+  cache.Put(small, graph_tile_ptr{new TestGraphTile(small, 10)}, 10);
+  cache.Put(big, graph_tile_ptr{new TestGraphTile(big, 600)}, 600);
+  EXPECT_TRUE(cache.OverCommitted());
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_FALSE(cache.Contains(big));
+  CheckGraphTile(cache.Get(small), small, 10);
+}
+
+TEST(ShardedCache, ConcurrentAccess) {
+  ShardedTileCache cache(1000000, 8, true, TileCacheLRU::MemoryLimitControl::HARD);
+
+  // each thread works on its own set of tiles but they all share the shards
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t]() {
+      for (uint32_t i = 0; i < 1000; ++i) {
+        GraphId id(t * 1000 + i, 2, 0);
+        cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+        EXPECT_TRUE(cache.Contains(id));
+        CheckGraphTile(cache.Get(id), id, 100);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_FALSE(cache.OverCommitted());
+}
+
+TEST(ShardedCache, Factory) {
+  boost::property_tree::ptree pt;
+  pt.put("global_synchronized_cache", true);
+  pt.put("global_cache_shards", 4);
+  std::unique_ptr<TileCache> a(TileCacheFactory::createTileCache(pt));
+  std::unique_ptr<TileCache> b(TileCacheFactory::createTileCache(pt));
+  ASSERT_NE(dynamic_cast<ShardedTileCache*>(a.get()), nullptr);
+  EXPECT_EQ(dynamic_cast<ShardedTileCache*>(a.get())->ShardCount(), 4);
+
+  // both readers see the same global cache
+  GraphId id(5, 1, 0);
+  a->Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+  EXPECT_TRUE(b->Contains(id));
+  b->Clear();
+}
+
+TEST(SynchronizedCache, CountsLockWaits) {
+  SimpleTileCache shared(1000);
+  std::mutex mutex;
+  SynchronizedTileCache cache(shared, mutex);
+  GraphId id(5, 1, 0);
+  cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+  CheckGraphTile(cache.Get(id), id, 10);
+  EXPECT_EQ(cache.LockWaits(), 0);
+
+  // another thread holds the cache while we get the tile
+  std::unique_lock<std::mutex> held(mutex);
+  std::thread waiter([&cache, &id]() { CheckGraphTile(cache.Get(id), id, 10); });
+  while (cache.LockWaits() == 0)
+    std::this_thread::yield();
+  held.unlock();
+  waiter.join();
+  EXPECT_EQ(cache.LockWaits(), 1);
+
+  // caches which aren't shared never wait
+  EXPECT_EQ(shared.LockWaits(), 0);
+}
+
+TEST(SynchronizedCache, EpochsKeepTheirOwnTiles) {
+  boost::property_tree::ptree pt;
+  pt.put("global_synchronized_cache", true);
+  pt.put("use_lru_mem_cache", true);
+  std::unique_ptr<TileCache> old_epoch(TileCacheFactory::createTileCache(pt, 100));
+  GraphId id(5, 1, 0);
+  old_epoch->Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+
+  // the cache of a replaced extract is dropped by the factory but not by its readers
+  std::unique_ptr<TileCache> new_epoch(TileCacheFactory::createTileCache(pt, 101));
+  EXPECT_FALSE(new_epoch->Contains(id));
+  CheckGraphTile(old_epoch->Get(id), id, 10);
+  std::unique_ptr<TileCache> same_epoch(TileCacheFactory::createTileCache(pt, 101));
+  new_epoch->Put(id, graph_tile_ptr{new TestGraphTile(id, 20)}, 20);
+  CheckGraphTile(same_epoch->Get(id), id, 20);
+  CheckGraphTile(old_epoch->Get(id), id, 10);
+}
+
+TEST(ShardedCache, CopiesCountTheirOwnLockWaits) {
+  ShardedTileCache cache(1000, 2, false, TileCacheLRU::MemoryLimitControl::SOFT);
+  ShardedTileCache copy(cache);
+  std::vector<std::thread> threads;
+  for (auto* c : {&cache, &copy}) {
+    threads.emplace_back([c]() {
+      for (uint32_t i = 0; i < 1000; ++i) {
+        GraphId id(i % 10, 2, 0);
+        c->Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+        c->Get(id);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  // whether they waited depends on the scheduling, a fresh copy hasn't waited yet
+  EXPECT_LE(cache.LockWaits(), 2000);
+  EXPECT_LE(copy.LockWaits(), 2000);
+  EXPECT_EQ(ShardedTileCache(cache).LockWaits(), 0);
+}
+
+TEST(ClockCache, PutGet) {
+  ClockTileCache cache(1000);
+  std::vector<GraphId> ids;
+  for (uint32_t i = 0; i < 8; ++i) {
+    ids.emplace_back(i * 100, 2, 0);
+    auto tile = cache.Put(ids.back(), graph_tile_ptr{new TestGraphTile(ids.back(), 10)}, 10);
+    CheckGraphTile(tile, ids.back(), 10);
+  }
+  EXPECT_FALSE(cache.OverCommitted());
+
+  for (const auto& id : ids) {
+    EXPECT_TRUE(cache.Contains(id));
+    CheckGraphTile(cache.Get(id), id, 10);
+    EXPECT_TRUE(cache.Contains(GraphId(id.tileid(), id.level(), 42)));
+  }
+  EXPECT_FALSE(cache.Contains(GraphId(12345, 2, 0)));
+  EXPECT_EQ(cache.Get(GraphId(12345, 2, 0)), nullptr);
+
+  // putting a tile again replaces it
+  cache.Put(ids[0], graph_tile_ptr{new TestGraphTile(ids[0], 20)}, 20);
+  CheckGraphTile(cache.Get(ids[0]), ids[0], 20);
+
+  cache.Clear();
+  EXPECT_EQ(cache.Evictions(), ids.size());
+  for (const auto& id : ids) {
+    EXPECT_FALSE(cache.Contains(id));
+    EXPECT_EQ(cache.Get(id), nullptr);
+  }
+}
+
+TEST(ClockCache, EvictsTilesNotUsedSinceTheLastSweep) {
+  // room for 4 tiles
+  ClockTileCache cache(40);
+  std::vector<GraphId> ids;
+  for (uint32_t i = 0; i < 4; ++i) {
+    ids.emplace_back(i, 2, 0);
+    cache.Put(ids.back(), graph_tile_ptr{new TestGraphTile(ids.back(), 10)}, 10);
+  }
+
+  // the used tiles get a second chance so the first one which wasn't used goes
+  cache.Get(ids[0]);
+  cache.Get(ids[1]);
+  GraphId id(100, 2, 0);
+  cache.Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_EQ(cache.Evictions(), 1);
+  EXPECT_TRUE(cache.Contains(ids[0]));
+  EXPECT_TRUE(cache.Contains(ids[1]));
+  EXPECT_FALSE(cache.Contains(ids[2]));
+  EXPECT_TRUE(cache.Contains(ids[3]));
+  CheckGraphTile(cache.Get(id), id, 10);
+
+  // a big tile makes room for itself
+  GraphId big(200, 2, 0);
+  cache.Put(big, graph_tile_ptr{new TestGraphTile(big, 30)}, 30);
+  EXPECT_FALSE(cache.OverCommitted());
+  CheckGraphTile(cache.Get(big), big, 30);
+
+  // one bigger than the cache overcommits it until trimmed
+  GraphId huge(300, 2, 0);
+  cache.Put(huge, graph_tile_ptr{new TestGraphTile(huge, 50)}, 50);
+  EXPECT_TRUE(cache.OverCommitted());
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_FALSE(cache.Contains(huge));
+}
+
+TEST(ClockCache, ConcurrentAccess) {
+  ClockTileCache cache(1000000);
+  ClockTileCache copy(cache);
+
+  // each thread works on its own set of tiles, half of them through the copy, while the others
+  // keep adding entries
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &copy, t]() {
+      auto& c = t % 2 ? cache : copy;
+      for (uint32_t i = 0; i < 2000; ++i) {
+        GraphId id(t * 2000 + i / 2, 2, 0);
+        auto tile = c.Get(id);
+        if (!tile)
+          tile = c.Put(id, graph_tile_ptr{new TestGraphTile(id, 100)}, 100);
+        CheckGraphTile(tile, id, 100);
+        EXPECT_TRUE(c.Contains(id));
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_FALSE(cache.OverCommitted());
+  EXPECT_EQ(copy.Evictions(), 0);
+  // only the puts can have waited
+  EXPECT_LE(cache.LockWaits() + copy.LockWaits(), 4000);
+}
+
+TEST(ClockCache, Factory) {
+  boost::property_tree::ptree pt;
+  pt.put("use_clock_mem_cache", true);
+  std::unique_ptr<TileCache> local(TileCacheFactory::createTileCache(pt));
+  EXPECT_NE(dynamic_cast<ClockTileCache*>(local.get()), nullptr);
+
+  pt.put("global_synchronized_cache", true);
+  std::unique_ptr<TileCache> a(TileCacheFactory::createTileCache(pt));
+  std::unique_ptr<TileCache> b(TileCacheFactory::createTileCache(pt));
+  ASSERT_NE(dynamic_cast<ClockTileCache*>(a.get()), nullptr);
+
+  // both readers see the same global cache
+  GraphId id(5, 1, 0);
+  a->Put(id, graph_tile_ptr{new TestGraphTile(id, 10)}, 10);
+  EXPECT_TRUE(b->Contains(id));
+  b->Clear();
+  EXPECT_FALSE(a->Contains(id));
+}
+
+// Serves header only tiles for every url but the one of the missing tile and counts the requests
+struct counting_tile_getter_t : public tile_getter_t {
+  explicit counting_tile_getter_t(const GraphId& missing) : missing(missing) {
+  }
+  response_t get(const std::string& url) override {
+    ++requests;
+    response_t response;
+    const auto id = GraphTile::GetTileId(url);
+    if (id != missing) {
+      GraphTileHeader header;
+      header.set_graphid(id);
+      header.set_end_offset(sizeof(GraphTileHeader));
+      const auto* bytes = reinterpret_cast<const char*>(&header);
+      response.bytes_.assign(bytes, bytes + sizeof(header));
+      response.status_ = status_code_t::SUCCESS;
+    }
+    return response;
+  }
+  const GraphId missing;
+  std::atomic<size_t> requests{0};
+};
+
+TEST(GraphReader, Prefetch) {
+  const auto& tiles = TileHierarchy::levels().back().tiles;
+  const uint8_t level = TileHierarchy::levels().back().level;
+  const GraphId center(tiles.TileId(100, 100), level, 0);
+  const GraphId missing(tiles.TileId(101, 101), level, 0);
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_url", "http://localhost/{tilePath}");
+  pt.put("tile_prefetch_threads", 2);
+  auto getter = std::make_unique<counting_tile_getter_t>(missing);
+  auto* counter = getter.get();
+  GraphReader reader(pt, std::move(getter));
+
+  // Asking twice must not queue anything twice
+  reader.PrefetchNeighbors(center);
+  reader.PrefetchNeighbors(center);
+  for (int32_t row = 99; row <= 101; ++row) {
+    for (int32_t col = 99; col <= 101; ++col) {
+      const GraphId id(tiles.TileId(col, row), level, 0);
+      const auto tile = reader.GetGraphTile(id);
+      if (id == missing) {
+        EXPECT_EQ(tile, nullptr);
+        continue;
+      }
+      ASSERT_NE(tile, nullptr);
+      EXPECT_EQ(tile->id(), id);
+    }
+  }
+  // Whether a prefetch thread or the reader got to a tile first, it was only downloaded once
+  EXPECT_EQ(counter->requests, 9);
+
+  // Cached tiles are not prefetched again
+  reader.Prefetch({center});
+  EXPECT_NE(reader.GetGraphTile(center), nullptr);
+  EXPECT_EQ(counter->requests, 9);
+
+  // The tiles on the line are there no matter if they were prefetched
+  const auto a = tiles.Center(center.tileid());
+  const auto b = tiles.Center(tiles.TileId(110, 100));
+  reader.PrefetchCorridor(a, b);
+  for (const auto& l : TileHierarchy::levels()) {
+    const auto tile = reader.GetGraphTile(b, l.level);
+    ASSERT_NE(tile, nullptr);
+    EXPECT_EQ(tile->id(), TileHierarchy::GetGraphId(b, l.level));
+  }
+
+  // Tiles nobody picked up are dropped, the reader keeps working
+  reader.Trim();
+  EXPECT_NE(reader.GetGraphTile(a, level), nullptr);
+}
+
+TEST(GraphReader, SharedMemoryCache) {
+  const auto& tiles = TileHierarchy::levels().back().tiles;
+  const uint8_t level = TileHierarchy::levels().back().level;
+  const GraphId id(tiles.TileId(100, 100), level, 0);
+  const std::string segment = "/valhalla_test_graphreader_" + std::to_string(getpid());
+  shm_tile_cache_t::remove(segment);
+
+  boost::property_tree::ptree pt;
+  pt.put("tile_url", "http://localhost/{tilePath}");
+  pt.put("shared_memory_cache", segment);
+  pt.put("max_cache_size", 1 << 20);
+
+  // the first reader downloads the tile and puts it in shared memory
+  auto getter = std::make_unique<counting_tile_getter_t>(GraphId());
+  auto* counter = getter.get();
+  GraphReader first(pt, std::move(getter));
+  auto tile = first.GetGraphTile(id);
+  ASSERT_NE(tile, nullptr);
+  EXPECT_EQ(tile->id(), id);
+  EXPECT_EQ(counter->requests, 1);
+
+  // a reader with its own cache, like one of another process, finds it there
+  auto other_getter = std::make_unique<counting_tile_getter_t>(GraphId());
+  auto* other_counter = other_getter.get();
+  GraphReader second(pt, std::move(other_getter));
+  tile = second.GetGraphTile(id);
+  ASSERT_NE(tile, nullptr);
+  EXPECT_EQ(tile->id(), id);
+  EXPECT_EQ(other_counter->requests, 0);
+
+  shm_tile_cache_t::remove(segment);
+}
+
+TEST(GraphReader, EdgeShapeCache) {
+  auto conf = test::make_config(VALHALLA_SOURCE_DIR "test/traffic_matcher_tiles");
+  const size_t max_size = 4096;
+  conf.put("mjolnir.edge_shape_cache_size", max_size);
+  GraphReader reader(conf.get_child("mjolnir"));
+  const auto tile_id = *reader.GetTileSet(TileHierarchy::levels().back().level).begin();
+  const auto tile = reader.GetGraphTile(tile_id);
+  ASSERT_NE(tile, nullptr);
+  ASSERT_GT(tile->header()->directededgecount(), 1);
+
+  // hits hand back the same shape without decoding it again
+  const auto* edge = tile->directededge(0);
+  const auto* first = &reader.edge_shape(tile, edge);
+  EXPECT_EQ(*first, tile->edgeinfo(edge).shape());
+  EXPECT_EQ(&reader.edge_shape(tile, edge), first);
+
+  // every shape is right while the older ones get evicted
+  for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+    edge = tile->directededge(i);
+    EXPECT_EQ(reader.edge_shape(tile, edge), tile->edgeinfo(edge).shape());
+  }
+  edge = tile->directededge(0);
+  EXPECT_EQ(reader.edge_shape(tile, edge), tile->edgeinfo(edge).shape());
+
+  // the cache keeps to its byte limit
+  EdgeShapeCache cache(max_size);
+  for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+    cache.Get(tile, tile->directededge(i));
+    EXPECT_LE(cache.Size(), max_size);
+  }
+  EXPECT_GT(cache.Size(), 0);
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0);
+
+  // without a cache shapes are decoded every time
+  GraphReader uncached(test::make_config(VALHALLA_SOURCE_DIR "test/traffic_matcher_tiles")
+                           .get_child("mjolnir"));
+  EXPECT_EQ(uncached.edge_shape(tile, edge), tile->edgeinfo(edge).shape());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
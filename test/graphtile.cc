@@ -1,7 +1,9 @@
 #include <cstdint>
 
 #include "baldr/graphtile.h"
+#include "filesystem.h"
 
+#include <fstream>
 #include <vector>
 
 #include "test.h"
@@ -21,6 +23,24 @@ struct testable_graphtile : public valhalla::baldr::GraphTile {
   }
 };
 
+// a tile with nothing but access restrictions, signs and lane connections in it
+struct testable_attributes : public valhalla::baldr::GraphTile {
+  testable_attributes(std::vector<AccessRestriction>& restrictions,
+                      std::vector<Sign>& signs,
+                      std::vector<LaneConnectivity>& lanes) {
+    header_ = new GraphTileHeader();
+    header_->set_access_restriction_count(restrictions.size());
+    header_->set_signcount(signs.size());
+    access_restrictions_ = restrictions.data();
+    signs_ = signs.data();
+    lane_connectivity_ = lanes.data();
+    lane_connectivity_size_ = lanes.size() * sizeof(LaneConnectivity);
+  }
+  ~testable_attributes() {
+    delete header_;
+  }
+};
+
 TEST(Graphtile, FileSuffix) {
   EXPECT_EQ(GraphTile::FileSuffix(GraphId(2, 2, 0)), "2/000/000/002.gph");
   EXPECT_EQ(GraphTile::FileSuffix(GraphId(4, 2, 0)), "2/000/000/004.gph");
@@ -103,6 +123,52 @@ private:
   const std::vector<char> memory_;
 };
 
+TEST(GraphTile, AttributeSpans) {
+  const auto car = kAutoAccess, truck = kTruckAccess;
+  std::vector<AccessRestriction> restrictions{{1, AccessType::kMaxHeight, truck, 3},
+                                              {4, AccessType::kTimedDenied, car, 1},
+                                              {4, AccessType::kMaxWeight, truck, 20},
+                                              {4, AccessType::kTimedAllowed, car | truck, 2},
+                                              {9, AccessType::kMaxWidth, car, 2}};
+  std::vector<Sign> signs{{0, Sign::Type::kExitNumber, false, false, 0},
+                          {2, Sign::Type::kExitBranch, false, false, 0},
+                          {2, Sign::Type::kExitToward, false, false, 0}};
+  std::vector<LaneConnectivity> lanes{{3, 10, "1", "1"}, {3, 11, "2", "1|2"}, {5, 12, "1", "2"}};
+  testable_attributes tile(restrictions, signs, lanes);
+
+  // the spans cover every attribute of the index in place and nothing else
+  auto in_place = tile.access_restrictions(4);
+  ASSERT_EQ(in_place.size(), 3);
+  EXPECT_EQ(in_place.begin(), restrictions.data() + 1);
+  EXPECT_EQ(tile.access_restrictions(0).size(), 0);
+  EXPECT_EQ(tile.access_restrictions(5).size(), 0);
+  EXPECT_EQ(tile.access_restrictions(9).size(), 1);
+  EXPECT_EQ(tile.access_restrictions(10).size(), 0);
+  EXPECT_EQ(tile.signs(2).size(), 2);
+  EXPECT_EQ(tile.signs(2).begin(), signs.data() + 1);
+  EXPECT_EQ(tile.signs(1).size(), 0);
+  EXPECT_EQ(tile.lane_connections(3).size(), 2);
+  EXPECT_EQ(tile.lane_connections(5).begin(), lanes.data() + 2);
+  EXPECT_EQ(tile.lane_connections(4).size(), 0);
+
+  // and the copies still only have the restrictions of the modes asked for, in the same order
+  const auto for_car = tile.GetAccessRestrictions(4, car);
+  ASSERT_EQ(for_car.size(), 2);
+  EXPECT_EQ(for_car[0].type(), AccessType::kTimedDenied);
+  EXPECT_EQ(for_car[1].type(), AccessType::kTimedAllowed);
+  EXPECT_EQ(tile.GetAccessRestrictions(4, truck).size(), 2);
+  EXPECT_EQ(tile.GetLaneConnectivity(3).size(), 2);
+
+  // nothing to look through at all
+  std::vector<AccessRestriction> no_restrictions;
+  std::vector<Sign> no_signs;
+  std::vector<LaneConnectivity> no_lanes;
+  testable_attributes empty(no_restrictions, no_signs, no_lanes);
+  EXPECT_EQ(empty.access_restrictions(4).size(), 0);
+  EXPECT_EQ(empty.signs(2).size(), 0);
+  EXPECT_EQ(empty.lane_connections(3).size(), 0);
+}
+
 TEST(GraphTileIntegrity, SizeZero) {
   EXPECT_THROW(GraphTile::Create(GraphId(), std::make_unique<const TestGraphMemory>(0)),
                std::runtime_error);
@@ -128,6 +194,36 @@ TEST(GraphTileIntegrity, SizeLessThanPayload) {
                std::runtime_error);
 }
 
+TEST(GraphTile, MemoryMapped) {
+  // A tile which is nothing but its header is enough to go through the loading paths
+  const std::string tile_dir = "test/data/graphtile_mmap";
+  const GraphId id(49, 0, 0);
+  const std::string file_name = tile_dir + filesystem::path::preferred_separator +
+                                GraphTile::FileSuffix(id);
+  filesystem::create_directories(filesystem::path(file_name).parent_path());
+
+  GraphTileHeader header;
+  header.set_graphid(id);
+  header.set_end_offset(sizeof(GraphTileHeader));
+  {
+    std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+  const auto read = GraphTile::Create(tile_dir, id);
+  const auto mapped = GraphTile::Create(tile_dir, id, nullptr, true);
+  ASSERT_NE(read, nullptr);
+  ASSERT_NE(mapped, nullptr);
+  EXPECT_EQ(mapped->id(), read->id());
+  EXPECT_EQ(mapped->header()->end_offset(), read->header()->end_offset());
+  EXPECT_EQ(memcmp(mapped->header(), read->header(), sizeof(GraphTileHeader)), 0);
+
+  // Missing tiles come back empty either way
+  EXPECT_EQ(GraphTile::Create(tile_dir, GraphId(50, 0, 0), nullptr, true), nullptr);
+
+  filesystem::remove_all(tile_dir);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -2,12 +2,16 @@
 
 #include "baldr/graphid.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/encoded.h"
 #include "midgard/pointll.h"
+#include "mjolnir/complexrestrictionbuilder.h"
 #include "mjolnir/graphtilebuilder.h"
+#include <algorithm>
 #include <fstream>
 #include <streambuf>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #if !defined(VALHALLA_SOURCE_DIR)
@@ -276,6 +280,230 @@ TEST(GraphTileBuilder, TestAddBins) {
   }
 }
 
+void assert_hot_edges_match(const GraphTile& tile) {
+  for (size_t i = 0; i < tile.header()->directededgecount(); ++i) {
+    const auto* edge = tile.directededge(i);
+    const auto hot = tile.hot_directededge(i);
+    ASSERT_EQ(hot.endnode(), edge->endnode());
+    ASSERT_EQ(hot.opp_index(), edge->opp_index());
+    ASSERT_EQ(hot.leaves_tile(), edge->leaves_tile());
+    ASSERT_EQ(hot.is_shortcut(), edge->is_shortcut());
+    ASSERT_EQ(hot.classification(), edge->classification());
+    ASSERT_EQ(hot.use(), edge->use());
+    ASSERT_EQ(hot.length(), edge->length());
+    ASSERT_EQ(hot.speed(), edge->speed());
+    ASSERT_EQ(hot.forwardaccess(), edge->forwardaccess());
+    ASSERT_EQ(hot.reverseaccess(), edge->reverseaccess());
+    ASSERT_EQ(hot.restrictions(), edge->restrictions());
+  }
+}
+
+TEST(GraphTileBuilder, TestAddHotDirectedEdges) {
+  for (const auto& test_tile :
+       std::list<std::pair<std::string, size_t>>{{"744/881.gph", 744881}, {"744/885.gph", 744885}}) {
+    // tiles without them read the hot attributes from the directed edges
+    GraphId id(test_tile.second, 2, 0);
+    auto t = GraphTile::Create(VALHALLA_SOURCE_DIR "test/data/bin_tiles/no_bin", id);
+    ASSERT_TRUE(t && t->header()) << "Couldn't load test tile";
+    ASSERT_FALSE(t->header()->has_hot_directededge());
+    assert_hot_edges_match(*t);
+
+    // they are appended after everything else, which is left as it was
+    std::string hot_dir = "test/data/bin_tiles/hot";
+    GraphTileBuilder::AddHotDirectedEdges(hot_dir, t);
+    auto hot = GraphTile::Create(hot_dir, id);
+    ASSERT_TRUE(hot && hot->header()->has_hot_directededge());
+    EXPECT_EQ(hot->header()->hot_directededge_offset() % 8, 0);
+    EXPECT_GE(hot->header()->hot_directededge_offset(), t->header()->end_offset());
+    EXPECT_EQ(hot->header()->end_offset(), hot->header()->hot_directededge_offset() +
+                                               t->header()->directededgecount() *
+                                                   sizeof(DirectedEdgeHot));
+    EXPECT_EQ(memcmp(reinterpret_cast<const char*>(t->header()) + sizeof(GraphTileHeader),
+                     reinterpret_cast<const char*>(hot->header()) + sizeof(GraphTileHeader),
+                     t->header()->end_offset() - sizeof(GraphTileHeader)),
+              0);
+    for (uint32_t i = 0; i < t->header()->directededgecount(); ++i) {
+      EXPECT_EQ(hot->GetLaneConnectivity(i).size(), t->GetLaneConnectivity(i).size());
+    }
+    assert_hot_edges_match(*hot);
+
+    // adding them again refreshes them in place
+    GraphTileBuilder::AddHotDirectedEdges(hot_dir, hot);
+    auto again = GraphTile::Create(hot_dir, id);
+    EXPECT_EQ(again->header()->end_offset(), hot->header()->end_offset());
+    assert_hot_edges_match(*again);
+
+    // and updating the directed edges keeps them in step
+    GraphTileBuilder builder(hot_dir, id, false);
+    std::vector<NodeInfo> nodes(again->GetNodes().begin(), again->GetNodes().end());
+    std::vector<DirectedEdge> edges(again->GetDirectedEdges().begin(),
+                                    again->GetDirectedEdges().end());
+    for (auto& edge : edges) {
+      edge.set_speed(edge.speed() / 2);
+    }
+    builder.Update(nodes, edges);
+    auto updated = GraphTile::Create(hot_dir, id);
+    ASSERT_TRUE(updated->header()->has_hot_directededge());
+    EXPECT_EQ(updated->directededge(size_t(0))->speed(), edges.front().speed());
+    assert_hot_edges_match(*updated);
+  }
+}
+
+// the restrictions of an edge the way they were found before they were indexed
+std::vector<const ComplexRestriction*>
+scan_restrictions(const GraphTile& tile, bool forward, const GraphId& id, uint64_t modes) {
+  const auto* header = tile.header();
+  const char* data = reinterpret_cast<const char*>(header);
+  const char* begin = data + (forward ? header->complex_restriction_forward_offset()
+                                      : header->complex_restriction_reverse_offset());
+  const char* end = data + (forward ? header->complex_restriction_reverse_offset()
+                                    : header->edgeinfo_offset());
+  std::vector<const ComplexRestriction*> restrictions;
+  while (begin < end) {
+    const auto* cr = reinterpret_cast<const ComplexRestriction*>(begin);
+    if ((forward ? cr->to_graphid() : cr->from_graphid()) == id && (cr->modes() & modes)) {
+      restrictions.push_back(cr);
+    }
+    begin += cr->SizeOf();
+  }
+  return restrictions;
+}
+
+void assert_restrictions_match(const GraphTile& tile) {
+  for (uint32_t i = 0; i < tile.header()->directededgecount(); ++i) {
+    GraphId edgeid(tile.id().tileid(), tile.id().level(), i);
+    for (const bool forward : {true, false}) {
+      for (const uint64_t modes : {kAutoAccess, kPedestrianAccess, kAllAccess}) {
+        const auto expected = scan_restrictions(tile, forward, edgeid, modes);
+        const auto restrictions = tile.GetRestrictions(forward, edgeid, modes);
+        ASSERT_EQ(restrictions.size(), expected.size());
+        ASSERT_TRUE(std::equal(restrictions.begin(), restrictions.end(), expected.begin()));
+      }
+    }
+  }
+}
+
+TEST(GraphTileBuilder, TestRestrictionIndex) {
+  // copy a test tile somewhere it can be rebuilt
+  GraphId id(744881, 2, 0);
+  std::string restriction_dir = "test/data/bin_tiles/restrictions";
+  GraphTileBuilder::AddBins(restriction_dir,
+                            GraphTile::Create(VALHALLA_SOURCE_DIR "test/data/bin_tiles/no_bin",
+                                              id),
+                            {});
+
+  // add restrictions out of the order of the edges they are looked up by
+  {
+    GraphTileBuilder builder(restriction_dir, id, true);
+    ASSERT_GT(builder.header()->directededgecount(), 8);
+    const std::vector<std::tuple<uint32_t, uint32_t, uint16_t>> restrictions{
+        {1, 5, kAutoAccess}, {2, 1, kPedestrianAccess}, {3, 5, kPedestrianAccess},
+        {4, 3, kAutoAccess}, {1, 5, kAutoAccess | kPedestrianAccess}, {8, 7, kAutoAccess},
+    };
+    for (const auto& r : restrictions) {
+      ComplexRestrictionBuilder restriction;
+      restriction.set_from_id({id.tileid(), id.level(), std::get<0>(r)});
+      restriction.set_to_id({id.tileid(), id.level(), std::get<1>(r)});
+      restriction.set_via_list({{id.tileid(), id.level(), std::get<0>(r) + 1}});
+      restriction.set_type(RestrictionType::kNoEntry);
+      restriction.set_modes(std::get<2>(r));
+      builder.AddForwardComplexRestriction(restriction);
+      builder.AddReverseComplexRestriction(restriction);
+    }
+    builder.StoreTileData();
+  }
+
+  // lookups through the index stored in the tile find what scanning all of them does
+  auto tile = GraphTile::Create(restriction_dir, id);
+  ASSERT_NE(tile->header()->complex_restriction_index_offset(), 0);
+  EXPECT_EQ(tile->GetRestrictions(true, {id.tileid(), id.level(), 5}, kAutoAccess).size(), 2);
+  EXPECT_EQ(tile->GetRestrictions(true, {id.tileid(), id.level(), 5}, kAllAccess).size(), 3);
+  EXPECT_EQ(tile->GetRestrictions(false, {id.tileid(), id.level(), 1}, kAllAccess).size(), 2);
+  EXPECT_TRUE(tile->GetRestrictions(true, {id.tileid(), id.level(), 2}, kAllAccess).empty());
+  EXPECT_TRUE(tile->GetRestrictions(true, {id.tileid(), id.level(), 7}, kBicycleAccess).empty());
+  assert_restrictions_match(*tile);
+
+  // and so do the ones through the index built for tiles that don't have one
+  std::ifstream file(restriction_dir + "/2/000/744/881.gph", std::ios::binary);
+  std::vector<char> memory((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  reinterpret_cast<GraphTileHeader*>(memory.data())->set_complex_restriction_index_offset(0);
+  auto old_tile = GraphTile::Create(id, std::move(memory));
+  EXPECT_EQ(old_tile->GetRestrictions(true, {id.tileid(), id.level(), 5}, kAllAccess).size(), 3);
+  assert_restrictions_match(*old_tile);
+}
+
+TEST(GraphTileBuilder, TestTextDictionary) {
+  std::string test_dir = "test/data/text_dictionary_tiles";
+  ::filesystem::remove_all(test_dir);
+  GraphId id(0, 2, 0);
+  auto store = [&](std::shared_ptr<const TextDictionary> dictionary) {
+    GraphTileBuilder builder(test_dir, id, false);
+    builder.directededges().emplace_back();
+    bool added = false;
+    builder.AddEdgeInfo(0, GraphId(0, 2, 0), GraphId(0, 2, 1), 1234, 555, 0, 120,
+                        std::list<PointLL>{{0, 0}, {1, 1}}, {"Main Street", "Elm Street"},
+                        {"1xyz tunnel"}, {}, 0, added);
+    builder.AddSigns(0, {{Sign::Type::kExitNumber, false, false, false, 0, 0, "95"},
+                         {Sign::Type::kExitToward, false, false, false, 0, 0, "Boston"}});
+    builder.AddAdmin("Country", "State", "CC", "ST");
+    builder.set_text_dictionary(std::move(dictionary));
+    builder.StoreTileData();
+  };
+  auto check = [&](const GraphTile& tile) {
+    auto names = tile.edgeinfo(tile.directededge(0)).GetNames();
+    ASSERT_EQ(names.size(), 2);
+    EXPECT_EQ(names[0], "Main Street");
+    EXPECT_EQ(names[1], "Elm Street");
+    EXPECT_EQ(tile.edgeinfo(tile.directededge(0)).GetTags().find(TaggedValue::kTunnel)->second,
+              "xyz tunnel");
+    auto signs = tile.GetSigns(0);
+    ASSERT_EQ(signs.size(), 2);
+    EXPECT_EQ(signs[0].text(), "95");
+    EXPECT_EQ(signs[1].text(), "Boston");
+    auto admin = tile.admininfo(1);
+    EXPECT_EQ(admin.country_text(), "Country");
+    EXPECT_EQ(admin.state_text(), "State");
+  };
+  const std::string shared("\0Elm Street\0Boston\0State\0", 25);
+  auto dictionary = std::make_shared<const TextDictionary>(
+      std::vector<char>(shared.begin(), shared.end()));
+  EXPECT_EQ(dictionary->find("Boston"), 12);
+  EXPECT_EQ(dictionary->find("Main Street"), TextDictionary::kNotFound);
+
+  // the tile only keeps the text which isn't in the dictionary
+  store(nullptr);
+  const auto plain_size = GraphTile::Create(test_dir, id)->textlist().size();
+  store(dictionary);
+  TextDictionary::Register(dictionary);
+  auto tile = GraphTile::Create(test_dir, id);
+  ASSERT_TRUE(tile);
+  EXPECT_EQ(tile->header()->shared_textlist_size(), dictionary->size());
+  EXPECT_EQ(tile->header()->shared_textlist_checksum(), dictionary->checksum());
+  const auto textlist = tile->textlist();
+  const std::string own_text(textlist.begin(), textlist.end());
+  EXPECT_EQ(own_text.find("Elm Street"), std::string::npos);
+  EXPECT_NE(own_text.find("Main Street"), std::string::npos);
+  EXPECT_LT(textlist.size(), plain_size);
+  check(*tile);
+
+  // deserializing it brings all of the text back into the tile
+  {
+    GraphTileBuilder builder(test_dir, id, true);
+    builder.StoreTileData();
+  }
+  tile = GraphTile::Create(test_dir, id);
+  EXPECT_EQ(tile->header()->shared_textlist_size(), 0);
+  check(*tile);
+
+  // a tile can't be read without the dictionary it was built with
+  store(dictionary);
+  TextDictionary::Register(std::make_shared<const TextDictionary>(std::vector<char>(1, '\0')));
+  EXPECT_THROW(GraphTile::Create(test_dir, id), std::runtime_error);
+  TextDictionary::Register(nullptr);
+  EXPECT_THROW(GraphTile::Create(test_dir, id), std::runtime_error);
+}
+
 struct fake_tile : public GraphTile {
 public:
   fake_tile(const std::string& plyenc_shape) {
@@ -78,6 +78,39 @@ TEST(GriddedData, Basic) {
   */
 }
 
+TEST(GriddedData, SparseBlocks) {
+  // 100x100 cells, the blocks are only there where something was set
+  GriddedData<1> g({0, 0, 100, 100}, 1, {100.f});
+  EXPECT_EQ(g.BlockCount(), 0);
+  EXPECT_EQ(g.Value(g.TileId(50, 50))[0], 100.f);
+
+  g.SetIfLessThan(g.TileId(50, 50), {10.f});
+  g.SetIfLessThan(g.TileId(51, 50), {20.f});
+  g.SetIfLessThan(g.TileId(51, 50), {30.f});
+  g.SetIfLessThan(-1, {0.f});
+  EXPECT_EQ(g.BlockCount(), 1);
+  EXPECT_EQ(g.Value(g.TileId(50, 50))[0], 10.f);
+  EXPECT_EQ(g.Value(g.TileId(51, 50))[0], 20.f);
+  EXPECT_EQ(g.Value(g.TileId(52, 50))[0], 100.f);
+  EXPECT_EQ(g.Value(g.TileId(0, 0))[0], 100.f);
+  g.SetIfLessThan(g.TileId(99, 99), {5.f});
+  EXPECT_EQ(g.BlockCount(), 2);
+
+  // a new grid reuses the blocks and starts out with the new value
+  g.Reset({0, 0, 50, 50}, 1, {60.f});
+  EXPECT_EQ(g.Value(g.TileId(10, 10))[0], 60.f);
+  g.SetIfLessThan(g.TileId(10, 10), {1.f});
+  g.SetIfLessThan(g.TileId(49, 49), {2.f});
+  EXPECT_EQ(g.BlockCount(), 2);
+  EXPECT_EQ(g.Value(g.TileId(10, 11))[0], 60.f);
+  EXPECT_EQ(g.Value(g.TileId(49, 49))[0], 2.f);
+
+  // blocks above the reservation are freed
+  g.ReleaseBlocks(1);
+  EXPECT_EQ(g.BlockCount(), 1);
+  EXPECT_EQ(g.Value(g.TileId(10, 10))[0], 60.f);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
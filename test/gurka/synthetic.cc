@@ -0,0 +1,402 @@
+#include "synthetic.h"
+
+#include "filesystem.h"
+#include "midgard/constants.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/logging.h"
+#include "mjolnir/util.h"
+#include "test.h"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace valhalla {
+namespace gurka {
+namespace synthetic {
+
+namespace {
+
+using tags_t = std::vector<std::pair<std::string, std::string>>;
+
+// a fixed timestamp so that the same network always gives the same bytes
+constexpr time_t kTimestamp = 1577836800;
+// flush the objects to the pbf every so many bytes
+constexpr size_t kBufferSize = 16 * 1024 * 1024;
+// metres between the nodes of a motorway and between its carriageways
+constexpr double kMotorwaySegment = 1000;
+constexpr double kCarriagewayOffset = 15;
+
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// splitmix64, unlike the standard distributions it draws the same numbers everywhere
+struct random_t {
+  uint64_t state;
+  double next() {
+    state += 0x9e3779b97f4a7c15ULL;
+    return (mix(state) >> 11) * 0x1.0p-53;
+  }
+};
+
+enum class street_t { residential, primary, secondary };
+
+// the perimeter of a city is secondary, every nth street in it primary
+street_t classify(const network_options& options, uint32_t street) {
+  if (street == 0 || street == options.blocks)
+    return street_t::secondary;
+  return street % options.arterial_every == 0 ? street_t::primary : street_t::residential;
+}
+
+const char* highway(street_t street) {
+  switch (street) {
+    case street_t::primary:
+      return "primary";
+    case street_t::secondary:
+      return "secondary";
+    default:
+      return "residential";
+  }
+}
+
+// where everything is, ids are handed out in the order the objects are written
+struct layout_t {
+  explicit layout_t(const network_options& options)
+      : options(options), side(options.blocks + 1), city_nodes(side * side),
+        city_ways(2 * options.blocks * side),
+        lng_scale(midgard::DistanceApproximator<midgard::PointLL>::MetersPerLngDegree(
+            options.origin.lat())),
+        gap(options.city_spacing - options.blocks * options.block_size),
+        segments(std::max(1.0, std::ceil(gap / kMotorwaySegment))) {
+    for (uint32_t cy = 0; cy < options.cities_y; ++cy) {
+      for (uint32_t cx = 0; cx < options.cities_x; ++cx) {
+        if (cx + 1 < options.cities_x)
+          motorways.push_back({city_node(cx, cy, options.blocks / 2, options.blocks),
+                               city_node(cx + 1, cy, options.blocks / 2, 0)});
+        if (cy + 1 < options.cities_y)
+          motorways.push_back({city_node(cx, cy, options.blocks, options.blocks / 2),
+                               city_node(cx, cy + 1, 0, options.blocks / 2)});
+      }
+    }
+  }
+
+  uint64_t city(uint32_t cx, uint32_t cy) const {
+    return static_cast<uint64_t>(cy) * options.cities_x + cx;
+  }
+  uint64_t cities() const {
+    return static_cast<uint64_t>(options.cities_x) * options.cities_y;
+  }
+
+  // intersection i blocks north and j blocks east of the corner of a city
+  uint64_t city_node(uint32_t cx, uint32_t cy, uint32_t i, uint32_t j) const {
+    return 1 + city(cx, cy) * city_nodes + static_cast<uint64_t>(i) * side + j;
+  }
+  // the block east of intersection i, j and the one north of it
+  uint64_t east_way(uint64_t city, uint32_t i, uint32_t j) const {
+    return 1 + city * city_ways + static_cast<uint64_t>(i) * options.blocks + j;
+  }
+  uint64_t north_way(uint64_t city, uint32_t i, uint32_t j) const {
+    const auto east_ways = static_cast<uint64_t>(options.blocks) * side;
+    return 1 + city * city_ways + east_ways + static_cast<uint64_t>(j) * options.blocks + i;
+  }
+  // the nodes in between the ends of the carriageways of the motorways come after the cities
+  uint64_t motorway_node(size_t motorway, bool back, uint32_t k) const {
+    return 1 + cities() * city_nodes + (motorway * 2 + back) * (segments - 1) + k;
+  }
+  uint64_t motorway_way(size_t motorway, bool back) const {
+    return 1 + cities() * city_ways + motorway * 2 + back;
+  }
+
+  midgard::PointLL offset(double east, double north) const {
+    return {options.origin.lng() + east / lng_scale,
+            options.origin.lat() + north / midgard::kMetersPerDegreeLat};
+  }
+  std::pair<double, double> corner(uint32_t cx, uint32_t cy) const {
+    return {cx * options.city_spacing, cy * options.city_spacing};
+  }
+
+  const network_options& options;
+  uint32_t side;
+  uint64_t city_nodes;
+  uint64_t city_ways;
+  double lng_scale;
+  double gap;
+  uint32_t segments;
+  // the end nodes of each motorway, west to east or south to north
+  std::vector<std::pair<uint64_t, uint64_t>> motorways;
+};
+
+// writes the objects in batches as the buffer fills up
+struct writer_t {
+  explicit writer_t(const std::string& filename)
+      : header(make_header()), writer(osmium::io::File{filename, "pbf"}, header,
+                                      osmium::io::overwrite::allow, osmium::io::fsync::no),
+        buffer(kBufferSize, osmium::memory::Buffer::auto_grow::yes) {
+  }
+
+  static osmium::io::Header make_header() {
+    osmium::io::Header header;
+    header.set("generator", "valhalla-synthetic-network");
+    return header;
+  }
+
+  void flush(bool force = false) {
+    if (buffer.committed() > kBufferSize || (force && buffer.committed())) {
+      writer(std::move(buffer));
+      buffer = osmium::memory::Buffer(kBufferSize, osmium::memory::Buffer::auto_grow::yes);
+    }
+  }
+
+  void node(uint64_t id, const midgard::PointLL& ll) {
+    using namespace osmium::builder::attr;
+    osmium::builder::add_node(buffer, _id(id), _version(1), _timestamp(kTimestamp),
+                              _location(osmium::Location{ll.lng(), ll.lat()}));
+    flush();
+  }
+
+  void way(uint64_t id, const std::vector<uint64_t>& nodes, const tags_t& tags) {
+    using namespace osmium::builder::attr;
+    std::vector<osmium::object_id_type> refs(nodes.begin(), nodes.end());
+    osmium::builder::add_way(buffer, _id(id), _version(1), _cid(1001), _timestamp(kTimestamp),
+                             _nodes(refs), _tags(tags));
+    flush();
+  }
+
+  void restriction(uint64_t id, uint64_t from, uint64_t via, uint64_t to, const char* type) {
+    using namespace osmium::builder::attr;
+    std::vector<member_type> members = {
+        {osmium::item_type::way, static_cast<osmium::object_id_type>(from), "from"},
+        {osmium::item_type::node, static_cast<osmium::object_id_type>(via), "via"},
+        {osmium::item_type::way, static_cast<osmium::object_id_type>(to), "to"}};
+    osmium::builder::add_relation(buffer, _id(id), _version(1), _timestamp(kTimestamp),
+                                  _members(members),
+                                  _tags(tags_t{{"type", "restriction"}, {"restriction", type}}));
+    flush();
+  }
+
+  void close() {
+    flush(true);
+    writer.close();
+  }
+
+  osmium::io::Header header;
+  osmium::io::Writer writer;
+  osmium::memory::Buffer buffer;
+};
+
+} // namespace
+
+std::string city(uint32_t x, uint32_t y) {
+  return "city_" + std::to_string(x) + "_" + std::to_string(y);
+}
+
+network_stats build_pbf(const network_options& options, const std::string& filename) {
+  if (!options.cities_x || !options.cities_y || options.blocks < 2 || !options.arterial_every ||
+      options.block_size <= 0) {
+    throw std::invalid_argument("A synthetic network needs cities of at least 2 blocks");
+  }
+  if (options.city_spacing <= options.blocks * options.block_size) {
+    throw std::invalid_argument("The cities of a synthetic network overlap");
+  }
+
+  const layout_t layout(options);
+  network_stats stats;
+  writer_t writer(filename);
+
+  // the intersections of the cities, the ones inside the perimeter are moved around a bit
+  random_t jitter{options.seed};
+  for (uint32_t cy = 0; cy < options.cities_y; ++cy) {
+    for (uint32_t cx = 0; cx < options.cities_x; ++cx) {
+      const auto corner = layout.corner(cx, cy);
+      for (uint32_t i = 0; i <= options.blocks; ++i) {
+        for (uint32_t j = 0; j <= options.blocks; ++j) {
+          double east = corner.first + j * options.block_size;
+          double north = corner.second + i * options.block_size;
+          if (i && j && i < options.blocks && j < options.blocks) {
+            east += (jitter.next() - 0.5) * options.jitter * options.block_size;
+            north += (jitter.next() - 0.5) * options.jitter * options.block_size;
+          }
+          writer.node(layout.city_node(cx, cy, i, j), layout.offset(east, north));
+          ++stats.nodes;
+        }
+      }
+    }
+  }
+
+  // the motorways between the cities, the carriageways a little to the right of the middle
+  const auto position = [&](uint64_t node) {
+    const auto city = (node - 1) / layout.city_nodes;
+    const auto index = (node - 1) % layout.city_nodes;
+    const auto corner = layout.corner(city % options.cities_x, city / options.cities_x);
+    return std::make_pair(corner.first + (index % layout.side) * options.block_size,
+                          corner.second + (index / layout.side) * options.block_size);
+  };
+  for (size_t m = 0; m < layout.motorways.size(); ++m) {
+    const auto a = position(layout.motorways[m].first);
+    const auto b = position(layout.motorways[m].second);
+    const double length = std::hypot(b.first - a.first, b.second - a.second);
+    const double right_east = (b.second - a.second) / length * kCarriagewayOffset;
+    const double right_north = -(b.first - a.first) / length * kCarriagewayOffset;
+    for (int back = 0; back < 2; ++back) {
+      const double sign = back ? -1 : 1;
+      for (uint32_t k = 0; k + 1 < layout.segments; ++k) {
+        double t = static_cast<double>(k + 1) / layout.segments;
+        if (back)
+          t = 1 - t;
+        writer.node(layout.motorway_node(m, back, k),
+                    layout.offset(a.first + (b.first - a.first) * t + sign * right_east,
+                                  a.second + (b.second - a.second) * t + sign * right_north));
+        ++stats.nodes;
+      }
+    }
+  }
+
+  // the blocks of the cities, some residential ones are missing or one way
+  random_t gaps{mix(options.seed ^ 0x5bd1e995ULL)};
+  const auto block = [&](uint64_t id, uint64_t from, uint64_t to, street_t street,
+                         const std::string& name) {
+    tags_t tags{{"highway", highway(street)}, {"name", name}};
+    if (street == street_t::residential) {
+      if (gaps.next() < options.gap_ratio)
+        return;
+      if (gaps.next() < options.oneway_ratio) {
+        tags.emplace_back("oneway", "yes");
+        if (id % 2)
+          std::swap(from, to);
+      }
+    } else {
+      tags.emplace_back("maxspeed", street == street_t::primary ? "50" : "40");
+    }
+    writer.way(id, {from, to}, tags);
+    ++stats.ways;
+  };
+  for (uint32_t cy = 0; cy < options.cities_y; ++cy) {
+    for (uint32_t cx = 0; cx < options.cities_x; ++cx) {
+      const auto c = layout.city(cx, cy);
+      const auto prefix = city(cx, cy) + " ";
+      for (uint32_t i = 0; i <= options.blocks; ++i) {
+        for (uint32_t j = 0; j < options.blocks; ++j) {
+          block(layout.east_way(c, i, j), layout.city_node(cx, cy, i, j),
+                layout.city_node(cx, cy, i, j + 1), classify(options, i),
+                prefix + "Street " + std::to_string(i));
+        }
+      }
+      for (uint32_t j = 0; j <= options.blocks; ++j) {
+        for (uint32_t i = 0; i < options.blocks; ++i) {
+          block(layout.north_way(c, i, j), layout.city_node(cx, cy, i, j),
+                layout.city_node(cx, cy, i + 1, j), classify(options, j),
+                prefix + "Avenue " + std::to_string(j));
+        }
+      }
+    }
+  }
+  for (size_t m = 0; m < layout.motorways.size(); ++m) {
+    for (int back = 0; back < 2; ++back) {
+      std::vector<uint64_t> nodes{back ? layout.motorways[m].second : layout.motorways[m].first};
+      for (uint32_t k = 0; k + 1 < layout.segments; ++k) {
+        nodes.push_back(layout.motorway_node(m, back, k));
+      }
+      nodes.push_back(back ? layout.motorways[m].first : layout.motorways[m].second);
+      writer.way(layout.motorway_way(m, back), nodes,
+                 {{"highway", "motorway"},
+                  {"oneway", "yes"},
+                  {"maxspeed", "110"},
+                  {"name", "A" + std::to_string(m + 1)}});
+      ++stats.ways;
+    }
+  }
+
+  // no left turns from the east bound blocks into the north bound ones where arterials cross
+  random_t turns{mix(options.seed ^ 0x27d4eb2fULL)};
+  uint64_t relation_id = 1;
+  for (uint32_t cy = 0; cy < options.cities_y; ++cy) {
+    for (uint32_t cx = 0; cx < options.cities_x; ++cx) {
+      const auto c = layout.city(cx, cy);
+      for (uint32_t i = 1; i < options.blocks; ++i) {
+        for (uint32_t j = 1; j < options.blocks; ++j) {
+          if (classify(options, i) != street_t::primary ||
+              classify(options, j) != street_t::primary ||
+              turns.next() >= options.restriction_ratio) {
+            continue;
+          }
+          writer.restriction(relation_id++, layout.east_way(c, i, j - 1),
+                             layout.city_node(cx, cy, i, j), layout.north_way(c, i, j),
+                             "no_left_turn");
+          ++stats.restrictions;
+        }
+      }
+    }
+  }
+
+  writer.close();
+  return stats;
+}
+
+map buildtiles(const network_options& options, const boost::property_tree::ptree& config) {
+  map result{config, {}};
+  auto workdir = config.get<std::string>("mjolnir.tile_dir");
+
+  // Sanity check so that we don't blow away / by mistake
+  if (workdir == "/") {
+    throw std::runtime_error("Can't use / for tests, as we need to clean it out first");
+  }
+
+  if (filesystem::exists(workdir))
+    filesystem::remove_all(workdir);
+  filesystem::create_directories(workdir);
+
+  auto pbf_filename = workdir + "/synthetic.pbf";
+  std::cerr << "[          ] generating synthetic PBF at " << pbf_filename << std::endl;
+  auto stats = build_pbf(options, pbf_filename);
+  std::cerr << "[          ] building tiles of " << stats.nodes << " nodes and " << stats.ways
+            << " ways in " << workdir << std::endl;
+  midgard::logging::Configure({{"type", ""}});
+
+  mjolnir::build_tile_set(result.config, {pbf_filename}, mjolnir::BuildStage::kInitialize,
+                          mjolnir::BuildStage::kValidate, false);
+
+  // the centers of the cities, at most half the jitter away from their intersections
+  const layout_t layout(options);
+  for (uint32_t cy = 0; cy < options.cities_y; ++cy) {
+    for (uint32_t cx = 0; cx < options.cities_x; ++cx) {
+      const auto corner = layout.corner(cx, cy);
+      const double half = options.blocks / 2 * options.block_size;
+      result.nodes[city(cx, cy)] = layout.offset(corner.first + half, corner.second + half);
+    }
+  }
+
+  // live traffic on a share of the edges, the same ones for the same seed
+  if (options.traffic_ratio > 0) {
+    result.config.put("mjolnir.traffic_extract", workdir + "/traffic.tar");
+    test::build_live_traffic_data(result.config);
+    test::customize_live_traffic_data(result.config, [&options](baldr::GraphReader&,
+                                                                baldr::TrafficTile& tile, int index,
+                                                                baldr::TrafficSpeed* current) {
+      random_t edge{mix(options.seed ^ (tile.header->tile_id << 21) ^ index)};
+      if (edge.next() >= options.traffic_ratio)
+        return;
+      const auto speed = static_cast<uint32_t>(10 + edge.next() * 80);
+      current->breakpoint1 = 255;
+      current->overall_encoded_speed = speed >> 1;
+      current->encoded_speed1 = speed >> 1;
+    });
+  }
+
+  return result;
+}
+
+} // namespace synthetic
+} // namespace gurka
+} // namespace valhalla
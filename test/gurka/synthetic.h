@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gurka.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace valhalla {
+namespace gurka {
+namespace synthetic {
+
+/**
+ * What the generated network looks like. Cities are square grids of streets laid out on a grid of
+ * their own and neighbouring cities are joined by motorways, one carriageway each way. Every few
+ * streets of a city is a primary arterial and the streets around it are secondary, the rest are
+ * residential, so the graph has all three hierarchy levels. The same options and seed always give
+ * the same network, so benchmarks can sweep the size and locality of the graph reproducibly.
+ */
+struct network_options {
+  // seeds everything that is left to chance
+  uint64_t seed = 1;
+  // south west corner of the south west city
+  midgard::PointLL origin{5.0, 52.0};
+  // how many cities there are along each side
+  uint32_t cities_x = 2;
+  uint32_t cities_y = 2;
+  // metres between the south west corners of neighbouring cities
+  double city_spacing = 20000;
+  // how many blocks there are along each side of a city and how long a block is in metres
+  uint32_t blocks = 10;
+  double block_size = 150;
+  // every nth street of a city is an arterial
+  uint32_t arterial_every = 5;
+  // how far intersections are moved around, as a fraction of the block size
+  double jitter = 0.2;
+  // the share of the residential blocks which are missing or one way
+  double gap_ratio = 0.05;
+  double oneway_ratio = 0.1;
+  // the share of the intersections of two arterials with a turn restriction
+  double restriction_ratio = 0.1;
+  // the share of the edges with live traffic, 0 for no traffic extract at all
+  double traffic_ratio = 0;
+};
+
+/**
+ * How much was generated
+ */
+struct network_stats {
+  uint64_t nodes = 0;
+  uint64_t ways = 0;
+  uint64_t restrictions = 0;
+};
+
+/**
+ * Writes the OSM PBF of a network. The objects are written as they are generated so that the
+ * whole network is never in memory, which allows for networks of continental size.
+ *
+ * @param options   what the network looks like
+ * @param filename  the pbf to write
+ * @return how many nodes, ways and restrictions were written
+ */
+network_stats build_pbf(const network_options& options, const std::string& filename);
+
+/**
+ * Generates a network and builds its tiles with the regular mjolnir pipeline. When the options ask
+ * for traffic, a live traffic extract with speeds on that share of the edges is written next to the
+ * tiles and mjolnir.traffic_extract points at it.
+ *
+ * @param options  what the network looks like
+ * @param config   the mjolnir section is used to build the tiles in mjolnir.tile_dir, which is
+ *                 cleaned out first
+ * @return the config and the centers of the cities, named city_<x>_<y>, to route between
+ */
+map buildtiles(const network_options& options, const boost::property_tree::ptree& config);
+
+/**
+ * @return the node name of the center of a city
+ */
+std::string city(uint32_t x, uint32_t y);
+
+} // namespace synthetic
+} // namespace gurka
+} // namespace valhalla
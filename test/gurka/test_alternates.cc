@@ -40,6 +40,41 @@ TEST(Alternates, test_short_route) {
       << "Wrong second alternative route";
 }
 
+TEST(Alternates, test_plateau) {
+  // the shortest route is split into many edges, each of which the searches connect on
+  const std::string ascii_map = R"(
+               E---------F
+               |         |
+       A-------B-J-K-L-M-C-------D
+    )";
+
+  const gurka::ways ways = {
+      {"AB", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"BJ", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"JK", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"KL", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"LM", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"MC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+      {"CD", {{"highway", "primary"}, {"maxspeed", "60"}}},
+
+      {"BEFC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 1000);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/alternates_plateau");
+
+  auto result =
+      gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto", {{"/alternates", "2"}});
+  const auto paths = gurka::detail::get_paths(result);
+
+  // the candidates on the shortest route form it again, only the detour is an alternative
+  ASSERT_EQ(paths.size(), 2) << "Unexpected number of routes";
+  EXPECT_EQ(paths[0], std::vector<std::string>({"AB", "BJ", "JK", "KL", "LM", "MC", "CD"}))
+      << "Wrong shortest route";
+  EXPECT_EQ(paths[1], std::vector<std::string>({"AB", "BEFC", "CD"}))
+      << "Wrong alternative route";
+}
+
 TEST(Alternates, test_long_route) {
   const std::string ascii_map = R"(
                              E---------------------------F
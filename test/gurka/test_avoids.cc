@@ -8,6 +8,7 @@
 #include "baldr/graphconstants.h"
 #include "baldr/graphreader.h"
 #include "loki/polygon_search.h"
+#include "midgard/aabb2.h"
 #include "midgard/pointll.h"
 #include "mjolnir/graphtilebuilder.h"
 #include "sif/costfactory.h"
@@ -282,6 +283,45 @@ TEST_F(AvoidTest, TestAvoidShortcutsTruck) {
   ASSERT_EQ(found_shortcuts, 2);
 }
 
+TEST_F(AvoidTest, TestAvoidPolygonCoveringBins) {
+  valhalla::Options options;
+  options.set_costing_type(valhalla::Costing::auto_);
+  auto& co = (*options.mutable_costings())[Costing::auto_];
+  co.set_type(valhalla::Costing::auto_);
+  const auto costing = valhalla::sif::CostFactory{}.Create(co);
+  GraphReader reader(avoid_map.config.get_child("mjolnir"));
+
+  // a box around the whole map, the small one only has bins crossed by its boundary while the
+  // large one covers whole bins, both must exclude every edge
+  const auto& first = avoid_map.nodes.begin()->second;
+  vm::AABB2<vm::PointLL> box(first, first);
+  for (const auto& node : avoid_map.nodes) {
+    box.Expand(vm::AABB2<vm::PointLL>(node.second, node.second));
+  }
+  auto box_rings = [&box](double margin) {
+    google::protobuf::RepeatedPtrField<valhalla::Ring> rings;
+    auto* ring = rings.Add();
+    for (const auto& coord : std::vector<vm::PointLL>{{box.minx() - margin, box.miny() - margin},
+                                                      {box.maxx() + margin, box.miny() - margin},
+                                                      {box.maxx() + margin, box.maxy() + margin},
+                                                      {box.minx() - margin, box.maxy() + margin}}) {
+      auto* ll = ring->add_coords();
+      ll->set_lat(coord.lat());
+      ll->set_lng(coord.lng());
+    }
+    return rings;
+  };
+
+  auto small = vl::edges_in_rings(box_rings(0.0001), reader, costing, 100000);
+  auto large = vl::edges_in_rings(box_rings(0.2), reader, costing, 1000000);
+  EXPECT_FALSE(small.empty());
+  EXPECT_EQ(small, large);
+
+  // the same with threads and with the rings prepared before
+  EXPECT_EQ(vl::edges_in_rings(box_rings(0.0001), reader, costing, 100000, 4), small);
+  EXPECT_EQ(vl::edges_in_rings(box_rings(0.2), reader, costing, 1000000, 4), large);
+}
+
 TEST_P(AvoidTest, TestAvoidLocation) {
   // avoid the location on "High road"
   std::vector<vm::PointLL> avoid_locs{avoid_map.nodes["x"]};
@@ -0,0 +1,85 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class BidirectionalTimeDependent : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static gurka::map bidirectional_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 500;
+
+    const std::string ascii_map = R"(
+      A----B----C----D
+      |    |    |    |
+      E----F----G----H
+      |    |    |    |
+      I----J----K----L
+    )";
+
+    const gurka::ways ways = {{"ABCD", {{"highway", "primary"}}},
+                              {"EFGH", {{"highway", "residential"}}},
+                              {"IJKL", {{"highway", "secondary"}}},
+                              {"AEI", {{"highway", "residential"}}},
+                              {"BFJ", {{"highway", "residential"}}},
+                              {"CGK", {{"highway", "residential"}}},
+                              {"DHL", {{"highway", "tertiary"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_bidirectional_timedep");
+    bidirectional_map = map;
+    bidirectional_map.config.put("thor.bidirectional_timedep_distance", 0);
+  }
+};
+
+gurka::map BidirectionalTimeDependent::map = {};
+gurka::map BidirectionalTimeDependent::bidirectional_map = {};
+
+TEST_F(BidirectionalTimeDependent, DepartAt) {
+  const std::unordered_map<std::string, std::string> options = {
+      {"/date_time/type", "1"},
+      {"/date_time/value", "2021-11-08T08:00"},
+  };
+  const auto unidirectional = gurka::do_action(Options::route, map, {"A", "L"}, "auto", options);
+  const auto bidirectional =
+      gurka::do_action(Options::route, bidirectional_map, {"A", "L"}, "auto", options);
+
+  ASSERT_EQ(unidirectional.trip().routes(0).legs(0).algorithms(0), "time_dependent_forward_a*");
+  ASSERT_EQ(bidirectional.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+  EXPECT_EQ(gurka::detail::get_paths(bidirectional), gurka::detail::get_paths(unidirectional));
+  EXPECT_NEAR(bidirectional.directions().routes(0).legs(0).summary().time(),
+              unidirectional.directions().routes(0).legs(0).summary().time(), 0.1);
+}
+
+TEST_F(BidirectionalTimeDependent, ArriveBy) {
+  const std::unordered_map<std::string, std::string> options = {
+      {"/date_time/type", "2"},
+      {"/date_time/value", "2021-11-08T08:00"},
+  };
+  const auto unidirectional = gurka::do_action(Options::route, map, {"A", "L"}, "auto", options);
+  const auto bidirectional =
+      gurka::do_action(Options::route, bidirectional_map, {"A", "L"}, "auto", options);
+
+  ASSERT_EQ(unidirectional.trip().routes(0).legs(0).algorithms(0), "time_dependent_reverse_a*");
+  ASSERT_EQ(bidirectional.trip().routes(0).legs(0).algorithms(0), "bidirectional_a*");
+  EXPECT_EQ(gurka::detail::get_paths(bidirectional), gurka::detail::get_paths(unidirectional));
+  EXPECT_NEAR(bidirectional.directions().routes(0).legs(0).summary().time(),
+              unidirectional.directions().routes(0).legs(0).summary().time(), 0.1);
+
+  // both derive the same departure from the arrival
+  EXPECT_EQ(bidirectional.trip().routes(0).legs(0).location(0).date_time(),
+            unidirectional.trip().routes(0).legs(0).location(0).date_time());
+}
+
+TEST_F(BidirectionalTimeDependent, ShortRoutesStayUnidirectional) {
+  auto short_map = map;
+  short_map.config.put("thor.bidirectional_timedep_distance", 100000);
+  const auto result =
+      gurka::do_action(Options::route, short_map, {"A", "L"}, "auto",
+                       {{"/date_time/type", "1"}, {"/date_time/value", "2021-11-08T08:00"}});
+  EXPECT_EQ(result.trip().routes(0).legs(0).algorithms(0), "time_dependent_forward_a*");
+}
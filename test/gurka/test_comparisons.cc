@@ -0,0 +1,75 @@
+#include "gurka.h"
+#include "test.h"
+
+using namespace valhalla;
+
+class Comparisons : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+       A-------B---------C-------D
+               |         |
+               |         |
+               E---------F
+    )";
+
+    const gurka::ways ways = {
+        {"AB", {{"highway", "primary"}, {"maxspeed", "60"}}},
+        {"BC", {{"highway", "primary"}, {"maxspeed", "60"}, {"hgv", "no"}}},
+        {"CD", {{"highway", "primary"}, {"maxspeed", "60"}}},
+        {"BEFC", {{"highway", "primary"}, {"maxspeed", "60"}}},
+    };
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/comparisons");
+  }
+};
+
+gurka::map Comparisons::map = {};
+
+TEST_F(Comparisons, RoutePerCosting) {
+  std::string json;
+  auto result = gurka::do_action(Options::route, map, {"A", "D"}, "auto",
+                                 {{"/comparisons/0/costing", "truck"},
+                                  {"/comparisons/1/costing", "auto"},
+                                  {"/comparisons/1/name", "auto_again"}},
+                                 {}, &json);
+  const auto paths = gurka::detail::get_paths(result);
+  ASSERT_EQ(paths.size(), 3) << "Expected a route per costing";
+  EXPECT_EQ(paths[0], std::vector<std::string>({"AB", "BC", "CD"}));
+  EXPECT_EQ(paths[1], std::vector<std::string>({"AB", "BEFC", "CD"})) << "Trucks can't use BC";
+  EXPECT_EQ(paths[2], paths[0]);
+
+  // the routes after the first are named by their costing
+  rapidjson::Document response;
+  response.Parse(json.c_str());
+  ASSERT_FALSE(response.HasParseError());
+  EXPECT_FALSE(response.HasMember("alternates"));
+  ASSERT_TRUE(response.HasMember("comparisons"));
+  const auto comparisons = response["comparisons"].GetArray();
+  ASSERT_EQ(comparisons.Size(), 2);
+  EXPECT_EQ(std::string(comparisons[0]["costing"].GetString()), "truck");
+  EXPECT_EQ(std::string(comparisons[1]["costing"].GetString()), "auto_again");
+  EXPECT_TRUE(comparisons[0].HasMember("trip"));
+}
+
+TEST_F(Comparisons, Unsupported) {
+  const auto request = [](const std::unordered_map<std::string, std::string>& options) {
+    try {
+      gurka::do_action(Options::route, map, {"A", "D"}, "auto", options);
+    } catch (const valhalla_exception_t& e) { return e.code; }
+    return 0u;
+  };
+
+  EXPECT_EQ(request({{"/comparisons/0/costing", "truck"}, {"/alternates", "1"}}), 145);
+  EXPECT_EQ(request({{"/comparisons/0/costing", "multimodal"}}), 145);
+  EXPECT_EQ(request({{"/comparisons/0/name", "truck"}}), 129);
+
+  std::unordered_map<std::string, std::string> too_many;
+  for (size_t i = 0; i < 5; ++i) {
+    too_many["/comparisons/" + std::to_string(i) + "/costing"] = "truck";
+  }
+  EXPECT_EQ(request(too_many), 176);
+}
@@ -0,0 +1,72 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class DirectionsThreads : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static gurka::map threaded_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A----B----C----D
+      |    |    |    |
+      E----F----G----H
+      |    |    |    |
+      I----J----K----L
+    )";
+
+    const gurka::ways ways = {{"ABCD", {{"highway", "primary"}, {"name", "North Street"}}},
+                              {"EFGH", {{"highway", "residential"}, {"name", "Middle Street"}}},
+                              {"IJKL", {{"highway", "primary"}, {"name", "South Street"}}},
+                              {"AEI", {{"highway", "residential"}, {"name", "West Avenue"}}},
+                              {"BFJ", {{"highway", "residential"}, {"name", "Second Avenue"}}},
+                              {"CGK", {{"highway", "residential"}, {"name", "Third Avenue"}}},
+                              {"DHL", {{"highway", "residential"}, {"name", "East Avenue"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_directions_threads");
+    threaded_map = map;
+    threaded_map.config.put("odin.directions_threads", 4);
+  }
+
+  // the directions of every leg of every route are the same and in the same order
+  void expect_same_directions(const Api& serial, const Api& threaded) {
+    ASSERT_EQ(threaded.directions().routes_size(), serial.directions().routes_size());
+    for (int r = 0; r < serial.directions().routes_size(); ++r) {
+      const auto& serial_legs = serial.directions().routes(r).legs();
+      const auto& threaded_legs = threaded.directions().routes(r).legs();
+      ASSERT_EQ(threaded_legs.size(), serial_legs.size());
+      for (int l = 0; l < serial_legs.size(); ++l) {
+        EXPECT_EQ(threaded_legs.Get(l).SerializeAsString(), serial_legs.Get(l).SerializeAsString())
+            << "route " << r << " leg " << l;
+      }
+    }
+  }
+};
+
+gurka::map DirectionsThreads::map = {};
+gurka::map DirectionsThreads::threaded_map = {};
+
+TEST_F(DirectionsThreads, LegsKeepTheirOrder) {
+  const std::vector<std::string> waypoints = {"A", "L", "C", "I", "F", "H", "D", "J"};
+  const auto serial = gurka::do_action(Options::route, map, waypoints, "auto");
+  const auto threaded = gurka::do_action(Options::route, threaded_map, waypoints, "auto");
+  ASSERT_EQ(threaded.directions().routes(0).legs_size(), static_cast<int>(waypoints.size()) - 1);
+  expect_same_directions(serial, threaded);
+  for (int l = 0; l < threaded.directions().routes(0).legs_size(); ++l) {
+    EXPECT_EQ(threaded.directions().routes(0).legs(l).leg_id(), static_cast<uint32_t>(l));
+  }
+}
+
+TEST_F(DirectionsThreads, Alternates) {
+  const std::unordered_map<std::string, std::string> options = {{"/alternates", "2"}};
+  const auto serial = gurka::do_action(Options::route, map, {"A", "L"}, "auto", options);
+  const auto threaded = gurka::do_action(Options::route, threaded_map, {"A", "L"}, "auto", options);
+  expect_same_directions(serial, threaded);
+}
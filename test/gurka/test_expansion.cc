@@ -121,6 +121,78 @@ TEST_F(ExpansionTest, NoAction) {
   };
 }
 
+TEST_F(ExpansionTest, MaxEdges) {
+  // only the first 4 of the 11 edges are tracked
+  std::string res;
+  gurka::do_action(Options::expansion, expansion_map, {"A"}, "auto",
+                   {{"/action", "isochrone"},
+                    {"/contours/0/time", "10"},
+                    {"/max_edges", "4"},
+                    {"/expansion_properties/0", "costs"}},
+                   {}, &res);
+
+  rapidjson::Document res_doc;
+  res_doc.Parse(res.c_str());
+  auto feat = res_doc["features"][0].GetObject();
+  EXPECT_EQ(feat["geometry"]["coordinates"].GetArray().Size(), 4);
+  EXPECT_EQ(feat["properties"]["costs"].GetArray().Size(), 4);
+  EXPECT_TRUE(res_doc["properties"]["truncated"].GetBool());
+}
+
+TEST_F(ExpansionTest, MaxEdgesOfService) {
+  // the service limit applies when the request asks for more
+  auto map = expansion_map;
+  map.config.put("service_limits.max_expansion_edges", "5");
+  std::string res;
+  gurka::do_action(Options::expansion, map, {"A"}, "auto",
+                   {{"/action", "isochrone"}, {"/contours/0/time", "10"}, {"/max_edges", "8"}}, {},
+                   &res);
+
+  rapidjson::Document res_doc;
+  res_doc.Parse(res.c_str());
+  EXPECT_EQ(res_doc["features"][0]["geometry"]["coordinates"].GetArray().Size(), 5);
+  EXPECT_TRUE(res_doc["properties"]["truncated"].GetBool());
+}
+
+TEST_F(ExpansionTest, SampleInterval) {
+  // every other one of the 11 edges
+  std::string res;
+  gurka::do_action(Options::expansion, expansion_map, {"A"}, "auto",
+                   {{"/action", "isochrone"},
+                    {"/contours/0/time", "10"},
+                    {"/sample_interval", "2"},
+                    {"/expansion_properties/0", "edge_ids"}},
+                   {}, &res);
+
+  rapidjson::Document res_doc;
+  res_doc.Parse(res.c_str());
+  auto feat = res_doc["features"][0].GetObject();
+  EXPECT_EQ(feat["geometry"]["coordinates"].GetArray().Size(), 6);
+  EXPECT_EQ(feat["properties"]["edge_ids"].GetArray().Size(), 6);
+  EXPECT_FALSE(res_doc["properties"].HasMember("truncated"));
+}
+
+TEST_F(ExpansionTest, Pbf) {
+  auto api = gurka::do_action(Options::expansion, expansion_map, {"A"}, "auto",
+                              {{"/action", "isochrone"},
+                               {"/contours/0/time", "10"},
+                               {"/format", "pbf"},
+                               {"/expansion_properties/0", "statuses"},
+                               {"/expansion_properties/1", "distances"}});
+
+  const auto& expansion = api.expansion();
+  EXPECT_EQ(expansion.algorithm(), "dijkstras");
+  ASSERT_EQ(expansion.geometries_size(), 11);
+  EXPECT_EQ(expansion.statuses_size(), 11);
+  EXPECT_EQ(expansion.distances_size(), 11);
+  EXPECT_EQ(expansion.costs_size(), 0);
+  EXPECT_FALSE(expansion.truncated());
+  for (const auto& geometry : expansion.geometries()) {
+    EXPECT_GE(geometry.coords_size(), 4);
+    EXPECT_EQ(geometry.coords_size() % 2, 0);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(ExpandPropsTest,
                          ExpansionTest,
                          ::testing::Values(std::vector<std::string>{"statuses"},
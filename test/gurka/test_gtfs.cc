@@ -768,6 +768,14 @@ TEST(GtfsExample, MakeTile) {
             tile->GetNextDeparture(edge.lineid(), 21600, // 06:00 am
                                    dt_day, dt_dow, date_before_tile, false, false);
         EXPECT_EQ(dep->elapsed_time(), 180);
+        // the departure is found from within its own hour and nothing departs days later
+        const auto* again = tile->GetNextDeparture(edge.lineid(), dep->departure_time(), dt_day,
+                                                   dt_dow, date_before_tile, false, false);
+        ASSERT_NE(again, nullptr);
+        EXPECT_EQ(again->departure_time(), dep->departure_time());
+        EXPECT_EQ(tile->GetNextDeparture(edge.lineid(), 3 * kSecondsPerDay, dt_day, dt_dow,
+                                         date_before_tile, false, false),
+                  nullptr);
         const auto shape = tile->edgeinfo(&edge).encoded_shape();
         EXPECT_FALSE(shape.empty());
         dep->routeindex();
@@ -960,6 +968,55 @@ TEST(GtfsExample, route_trip4) {
   EXPECT_EQ(transit_info.onestop_id(), f2_name + "_" + r2_id);
 }
 
+TEST(GtfsExample, route_trip4_connection_scan) {
+  // the same trip scanning the timetable gets on and off at the same times
+  auto scan_map = map;
+  scan_map.config.put("thor.multimodal_algorithm", "connection_scan");
+  valhalla::Api res =
+      gurka::do_action(valhalla::Options::route, scan_map, {"g", "h"}, "multimodal",
+                       {{"/date_time/type", "1"},
+                        {"/date_time/value", "2023-02-27T22:50"},
+                        {"/costing_options/pedestrian/transit_start_end_max_distance", "20000"}});
+
+  ASSERT_EQ(res.directions().routes().size(), 1);
+  const auto& leg = res.directions().routes(0).legs(0);
+  EXPECT_NEAR(leg.summary().time(), 8529.033, 60);
+
+  const auto& transit_info = leg.maneuver(2).transit_info();
+  EXPECT_EQ(leg.maneuver(2).type(), DirectionsLeg_Maneuver_Type_kTransit);
+  EXPECT_EQ(transit_info.transit_stops(0).departure_date_time(), "2023-02-27T23:58-05:00");
+  EXPECT_EQ(transit_info.transit_stops(1).arrival_date_time(), "2023-02-28T00:02-05:00");
+  EXPECT_EQ(transit_info.headsign(), "grüß gott!");
+  EXPECT_EQ(transit_info.onestop_id(), f2_name + "_" + r2_id);
+}
+
+TEST(GtfsExample, route_profile_connection_scan) {
+  // the alternates of a scan are the later departures, each getting there earlier than any later
+  auto scan_map = map;
+  scan_map.config.put("thor.multimodal_algorithm", "connection_scan");
+  valhalla::Api res =
+      gurka::do_action(valhalla::Options::route, scan_map, {"A", "G"}, "multimodal",
+                       {{"/date_time/type", "1"},
+                        {"/date_time/value", "2023-02-27T09:00"},
+                        {"/alternates", "2"},
+                        {"/costing_options/pedestrian/transit_start_end_max_distance", "20000"}});
+
+  ASSERT_EQ(res.directions().routes().size(), 3);
+  std::string departed, arrived;
+  for (const auto& route : res.directions().routes()) {
+    const auto& maneuvers = route.legs(0).maneuver();
+    auto transit = std::find_if(maneuvers.begin(), maneuvers.end(), [](const auto& maneuver) {
+      return maneuver.type() == DirectionsLeg_Maneuver_Type_kTransit;
+    });
+    ASSERT_NE(transit, maneuvers.end());
+    const auto& stops = transit->transit_info().transit_stops();
+    EXPECT_GT(stops.begin()->departure_date_time(), departed);
+    EXPECT_GT(stops.rbegin()->arrival_date_time(), arrived);
+    departed = stops.begin()->departure_date_time();
+    arrived = stops.rbegin()->arrival_date_time();
+  }
+}
+
 TEST(GtfsExample, isochrones) {
 
   auto WaypointToBoostPoint = [&](std::string waypoint) {
@@ -990,6 +1047,29 @@ TEST(GtfsExample, isochrones) {
   EXPECT_EQ(within(WaypointToBoostPoint("1"), polygon), false);
 }
 
+TEST(GtfsExample, transit_available) {
+  auto location = [](const std::string& node, int radius) {
+    const auto& ll = map.nodes[node];
+    return R"({"lat":)" + std::to_string(ll.lat()) + R"(,"lon":)" + std::to_string(ll.lng()) +
+           R"(,"radius":)" + std::to_string(radius) + "}";
+  };
+
+  // only locations with a stop within their radius have transit, B is 3km from stop 1
+  const std::string req = R"({"locations":[)" + location("1", 100) + "," + location("A", 500) +
+                          "," + location("B", 2500) + "," + location("B", 3500) + "]}";
+  std::string res_string;
+  gurka::do_action(valhalla::Options::transit_available, map, req, {}, &res_string);
+
+  rapidjson::Document res;
+  res.Parse(res_string.c_str());
+  ASSERT_TRUE(res.IsArray());
+  ASSERT_EQ(res.Size(), 4);
+  EXPECT_TRUE(res[0]["istransit"].GetBool());
+  EXPECT_FALSE(res[1]["istransit"].GetBool());
+  EXPECT_FALSE(res[2]["istransit"].GetBool());
+  EXPECT_TRUE(res[3]["istransit"].GetBool());
+}
+
 TEST(GtfsExample, status) {
   std::string req = R"({"verbose": true})";
   std::string res_string;
@@ -0,0 +1,116 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/graphreader.h"
+#include "filesystem.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+// each stretch crosses into the next local tile
+const std::string ascii_map = R"(
+    A-----B-----C-----D
+                      |
+                      E
+  )";
+
+const gurka::ways old_ways = {
+    {"AB", {{"highway", "primary"}, {"name", "One"}}},
+    {"BC", {{"highway", "primary"}, {"name", "One"}}},
+    {"CD", {{"highway", "primary"}, {"name", "One"}}},
+    {"DE", {{"highway", "residential"}, {"name", "Old"}, {"osm_id", "100"}}},
+};
+
+const gurka::ways new_ways = {
+    {"AB", {{"highway", "primary"}, {"name", "One"}}},
+    {"BC", {{"highway", "primary"}, {"name", "One"}}},
+    {"CD", {{"highway", "primary"}, {"name", "One"}}},
+    {"DE", {{"highway", "tertiary"}, {"name", "New"}, {"osm_id", "100"}}},
+};
+
+const gurka::nodelayout& get_layout() {
+  static const auto layout = gurka::detail::map_to_coordinates(ascii_map, 5000, {5.1, 52.1});
+  return layout;
+}
+
+// builds the old data into a snapshot, then the new data as an update of it
+gurka::map build_update(const std::string& name, const std::string& key, const std::string& value) {
+  const auto& layout = get_layout();
+  const std::string snapshot_dir = "test/data/incremental_build_" + name + "_snapshot";
+  filesystem::remove_all(snapshot_dir);
+  gurka::buildtiles(layout, old_ways, {}, {}, "test/data/incremental_build_" + name + "_old",
+                    {{"mjolnir.snapshot_dir", snapshot_dir}, {"mjolnir.concurrency", "1"}});
+  return gurka::buildtiles(layout, new_ways, {}, {}, "test/data/incremental_build_" + name,
+                           {{"mjolnir.snapshot_dir", snapshot_dir},
+                            {"mjolnir.concurrency", "1"},
+                            {"mjolnir.update." + key, value}});
+}
+
+// the update has to come out as if the new data had been built from scratch
+void expect_same_graph(const gurka::map& update) {
+  const auto& layout = get_layout();
+  auto full = gurka::buildtiles(layout, new_ways, {}, {}, "test/data/incremental_build_full");
+  GraphReader full_reader(full.config.get_child("mjolnir"));
+  GraphReader update_reader(update.config.get_child("mjolnir"));
+  auto tile_ids = full_reader.GetTileSet();
+  ASSERT_EQ(tile_ids, update_reader.GetTileSet());
+
+  for (const auto& tile_id : tile_ids) {
+    auto expected = full_reader.GetGraphTile(tile_id);
+    auto actual = update_reader.GetGraphTile(tile_id);
+    ASSERT_EQ(expected->header()->nodecount(), actual->header()->nodecount());
+    ASSERT_EQ(expected->header()->directededgecount(), actual->header()->directededgecount());
+    for (uint32_t i = 0; i < expected->header()->nodecount(); ++i) {
+      EXPECT_EQ(expected->node(i)->edge_index(), actual->node(i)->edge_index());
+      EXPECT_EQ(expected->node(i)->edge_count(), actual->node(i)->edge_count());
+    }
+    for (uint32_t i = 0; i < expected->header()->directededgecount(); ++i) {
+      const auto* expected_edge = expected->directededge(i);
+      const auto* actual_edge = actual->directededge(i);
+      EXPECT_EQ(expected_edge->endnode(), actual_edge->endnode());
+      EXPECT_EQ(expected_edge->opp_index(), actual_edge->opp_index());
+      EXPECT_EQ(expected_edge->classification(), actual_edge->classification());
+      EXPECT_EQ(expected_edge->length(), actual_edge->length());
+      EXPECT_EQ(expected->edgeinfo(expected_edge).GetNames(),
+                actual->edgeinfo(actual_edge).GetNames());
+    }
+  }
+
+  auto result = gurka::do_action(valhalla::Options::route, update, {"A", "E"}, "auto");
+  gurka::assert::raw::expect_path(result, {"One", "One", "One", "New"});
+}
+
+} // namespace
+
+TEST(IncrementalBuild, UpdateBbox) {
+  auto D = get_layout().at("D");
+  auto E = get_layout().at("E");
+  auto bbox = std::to_string(D.lng() - 0.001) + "," + std::to_string(E.lat() - 0.001) + "," +
+              std::to_string(D.lng() + 0.001) + "," + std::to_string(D.lat() + 0.001);
+  expect_same_graph(build_update("bbox", "bbox", bbox));
+}
+
+TEST(IncrementalBuild, UpdateOsc) {
+  const std::string osc_file = "test/data/incremental_build.osc";
+  std::ofstream osc(osc_file);
+  osc << R"(<?xml version='1.0' encoding='UTF-8'?>
+<osmChange version="0.6">
+  <modify>
+    <way id="100" version="2">
+      <tag k="highway" v="tertiary"/>
+      <tag k="name" v="New"/>
+    </way>
+  </modify>
+</osmChange>
+)";
+  osc.close();
+  expect_same_graph(build_update("osc", "osc", osc_file));
+}
+
+TEST(IncrementalBuild, UpdateNeedsSnapshot) {
+  EXPECT_THROW(gurka::buildtiles(get_layout(), new_ways, {}, {}, "test/data/incremental_build_none",
+                                 {{"mjolnir.update.tiles", "0"}}),
+               std::runtime_error);
+}
@@ -0,0 +1,73 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class InstructionTypes : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A----B----C
+           |
+           D
+    )";
+
+    const gurka::ways ways = {{"ABC", {{"highway", "primary"}, {"name", "Main Street"}}},
+                              {"BD", {{"highway", "primary"}, {"name", "Side Street"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_instruction_types");
+  }
+
+  static void expect_instructions(const valhalla::Api& result, bool text, bool verbal) {
+    const auto& maneuvers = result.directions().routes(0).legs(0).maneuver();
+    ASSERT_EQ(maneuvers.size(), 3);
+    for (const auto& maneuver : maneuvers) {
+      EXPECT_EQ(maneuver.text_instruction().empty(), !text);
+      EXPECT_EQ(maneuver.verbal_pre_transition_instruction().empty(), !verbal);
+    }
+    EXPECT_EQ(maneuvers.Get(1).verbal_succinct_transition_instruction().empty(), !verbal);
+  }
+};
+
+gurka::map InstructionTypes::map = {};
+
+TEST_F(InstructionTypes, All) {
+  const auto result = gurka::do_action(Options::route, map, {"A", "D"}, "auto");
+  expect_instructions(result, true, true);
+}
+
+TEST_F(InstructionTypes, TextOnly) {
+  const auto result = gurka::do_action(Options::route, map, {"A", "D"}, "auto",
+                                       {{"/instruction_types/0", "text"}});
+  expect_instructions(result, true, false);
+}
+
+TEST_F(InstructionTypes, VerbalOnly) {
+  const auto result = gurka::do_action(Options::route, map, {"A", "D"}, "auto",
+                                       {{"/instruction_types/0", "verbal"}});
+  expect_instructions(result, false, true);
+}
+
+TEST_F(InstructionTypes, Both) {
+  const auto result =
+      gurka::do_action(Options::route, map, {"A", "D"}, "auto",
+                       {{"/instruction_types/0", "text"}, {"/instruction_types/1", "verbal"}});
+  expect_instructions(result, true, true);
+}
+
+TEST_F(InstructionTypes, Invalid) {
+  try {
+    gurka::do_action(Options::route, map, {"A", "D"}, "auto",
+                     {{"/instruction_types/0", "subtitles"}});
+    FAIL() << "Expected valhalla_exception_t.";
+  } catch (const valhalla_exception_t& err) { EXPECT_EQ(err.code, 169); } catch (...) {
+    FAIL() << "Expected valhalla_exception_t.";
+  };
+}
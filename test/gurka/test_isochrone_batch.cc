@@ -0,0 +1,154 @@
+#include "gurka.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class IsochroneBatch : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+      A----------B----------C
+    )";
+
+    const gurka::ways ways = {
+        {"ABC", {{"highway", "residential"}}},
+    };
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_isochrone_batch",
+                            {{"service_limits.isochrone.max_locations", "2"},
+                             {"thor.optimized_route_threads", "2"}});
+  }
+};
+
+gurka::map IsochroneBatch::map = {};
+
+TEST_F(IsochroneBatch, PerLocation) {
+  std::string pbf_bytes;
+  gurka::do_action(Options::isochrone, map, {"A", "C"}, "pedestrian",
+                   {{"/contours/0/time", "5"}, {"/contours/1/time", "2"}, {"/polygons", "1"},
+                    {"/per_location", "1"}, {"/format", "pbf"}},
+                   {}, &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  ASSERT_EQ(actual.isochrone().intervals_size(), 4);
+
+  // the intervals of each location, the largest first, and each goes around its own location
+  const std::vector<std::string> locations{"A", "A", "C", "C"};
+  const std::vector<float> thresholds{5.f, 2.f, 5.f, 2.f};
+  for (int i = 0; i < actual.isochrone().intervals_size(); ++i) {
+    const auto& interval = actual.isochrone().intervals(i);
+    EXPECT_EQ(interval.location_index(), i / 2);
+    EXPECT_EQ(interval.threshold(), thresholds[i]);
+    ASSERT_GT(interval.contours_size(), 0);
+    const auto& coords = interval.contours(0).geometries(0).coords();
+    int32_t min_lon = coords[0], max_lon = coords[0];
+    for (int j = 0; j < coords.size(); j += 2) {
+      min_lon = std::min(min_lon, coords[j]);
+      max_lon = std::max(max_lon, coords[j]);
+    }
+    const auto& origin = map.nodes.at(locations[i]);
+    EXPECT_LT(min_lon, origin.lng() * 1e6);
+    EXPECT_GT(max_lon, origin.lng() * 1e6);
+    // the locations are too far apart for one to reach the other
+    const auto& other = map.nodes.at(locations[i] == "A" ? "C" : "A");
+    EXPECT_TRUE(other.lng() * 1e6 < min_lon || other.lng() * 1e6 > max_lon);
+  }
+}
+
+TEST_F(IsochroneBatch, PerLocationJson) {
+  std::string json;
+  gurka::do_action(Options::isochrone, map, {"A", "C"}, "pedestrian",
+                   {{"/contours/0/time", "2"}, {"/per_location", "1"}}, {}, &json);
+
+  rapidjson::Document doc;
+  doc.Parse(json.c_str());
+  ASSERT_FALSE(doc.HasParseError());
+  const auto& features = doc["features"];
+  ASSERT_EQ(features.Size(), 2);
+  for (rapidjson::SizeType i = 0; i < features.Size(); ++i) {
+    EXPECT_EQ(features[i]["properties"]["location_index"].GetUint64(), i);
+  }
+}
+
+TEST_F(IsochroneBatch, Catchments) {
+  std::string pbf_bytes;
+  gurka::do_action(Options::isochrone, map, {"A", "C"}, "pedestrian",
+                   {{"/contours/0/time", "5"}, {"/catchments", "1"}, {"/format", "pbf"}}, {},
+                   &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  ASSERT_TRUE(actual.isochrone().has_catchments());
+  const auto& catchments = actual.isochrone().catchments();
+  ASSERT_GT(catchments.columns(), 0);
+  ASSERT_GT(catchments.rows(), 0);
+  ASSERT_EQ(catchments.locations_size(), catchments.columns() * catchments.rows());
+
+  // the cells around each location are its own
+  auto nearest = [&catchments](const midgard::PointLL& ll) {
+    int col = (ll.lng() - catchments.min_lon()) / catchments.cell_size();
+    int row = (ll.lat() - catchments.min_lat()) / catchments.cell_size();
+    EXPECT_GE(col, 0);
+    EXPECT_LT(col, catchments.columns());
+    EXPECT_GE(row, 0);
+    EXPECT_LT(row, catchments.rows());
+    return catchments.locations(row * catchments.columns() + col);
+  };
+  EXPECT_EQ(nearest(map.nodes.at("A")), 0);
+  EXPECT_EQ(nearest(map.nodes.at("C")), 1);
+
+  // every cell has one of the locations or none
+  for (auto location : catchments.locations()) {
+    EXPECT_GE(location, -1);
+    EXPECT_LE(location, 1);
+  }
+
+  // the raster is only there when asked for
+  gurka::do_action(Options::isochrone, map, {"A", "C"}, "pedestrian",
+                   {{"/contours/0/time", "5"}, {"/format", "pbf"}}, {}, &pbf_bytes);
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  EXPECT_FALSE(actual.isochrone().has_catchments());
+}
+
+TEST_F(IsochroneBatch, Raster) {
+  std::string pbf_bytes;
+  gurka::do_action(Options::isochrone, map, {"A"}, "pedestrian",
+                   {{"/contours/0/time", "5"}, {"/raster", "1"}, {"/format", "pbf"}}, {},
+                   &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  EXPECT_EQ(actual.isochrone().intervals_size(), 0);
+  ASSERT_TRUE(actual.isochrone().has_raster());
+  const auto& raster = actual.isochrone().raster();
+  ASSERT_GT(raster.columns(), 0);
+  ASSERT_GT(raster.rows(), 0);
+  ASSERT_EQ(raster.times_size(), raster.columns() * raster.rows());
+  // there is no distance contour so there are no distances
+  EXPECT_EQ(raster.distances_size(), 0);
+
+  // the cell of the location takes no time and none takes longer than the contour
+  int col = (map.nodes.at("A").lng() - raster.min_lon()) / raster.cell_size();
+  int row = (map.nodes.at("A").lat() - raster.min_lat()) / raster.cell_size();
+  ASSERT_LT(col, raster.columns());
+  ASSERT_LT(row, raster.rows());
+  EXPECT_LT(raster.times(row * raster.columns() + col), 1.f);
+  for (auto time : raster.times()) {
+    EXPECT_TRUE(time == -1.f || (time >= 0.f && time <= 5.f));
+  }
+
+  // the json has the same raster
+  std::string json;
+  gurka::do_action(Options::isochrone, map, {"A"}, "pedestrian",
+                   {{"/contours/0/time", "5"}, {"/raster", "1"}}, {}, &json);
+  rapidjson::Document doc;
+  doc.Parse(json.c_str());
+  ASSERT_FALSE(doc.HasParseError());
+  EXPECT_EQ(doc["features"].Size(), 0);
+  EXPECT_EQ(doc["raster"]["times"].Size(), raster.times_size());
+  EXPECT_EQ(doc["raster"]["columns"].GetUint(), raster.columns());
+}
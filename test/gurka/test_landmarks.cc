@@ -0,0 +1,81 @@
+#include "baldr/landmarkdistances.h"
+#include "gurka.h"
+#include "test.h"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string kWorkdir = "test/data/gurka_landmarks";
+
+// E and F are close but the only way between them goes all the way around
+const std::string ascii_map = R"(
+    A-------B-------C
+    |               |
+    D   E       F   G
+    |   |       |   |
+    H---I       J---K
+  )";
+
+const gurka::ways ways = {
+    {"AB", {{"highway", "primary"}}},     {"BC", {{"highway", "primary"}}},
+    {"ADH", {{"highway", "secondary"}}},  {"CGK", {{"highway", "secondary"}}},
+    {"HI", {{"highway", "residential"}}}, {"EI", {{"highway", "residential"}}},
+    {"JK", {{"highway", "residential"}}}, {"FJ", {{"highway", "residential"}}},
+};
+
+} // namespace
+
+TEST(Landmarks, DistancesAreWritten) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  const auto landmarks_file = kWorkdir + "/landmarks.bin";
+  auto map = gurka::buildtiles(layout, ways, {}, {}, kWorkdir,
+                               {{"mjolnir.concurrency", "1"},
+                                {"mjolnir.landmarks", landmarks_file},
+                                {"mjolnir.landmark_count", "4"}});
+
+  auto landmarks = baldr::LandmarkDistances::Map(landmarks_file);
+  ASSERT_NE(landmarks, nullptr);
+  EXPECT_GT(landmarks->landmark_count(), 0u);
+  EXPECT_LE(landmarks->landmark_count(), 4u);
+
+  // the difference of the distances from a landmark is never more than the distance between nodes
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  const auto e = gurka::findNode(*reader, layout, "E");
+  const auto f = gurka::findNode(*reader, layout, "F");
+  const auto* e_distances = landmarks->get(e, reader->GetGraphTile(e)->header()->nodecount());
+  const auto* f_distances = landmarks->get(f, reader->GetGraphTile(f)->header()->nodecount());
+  ASSERT_NE(e_distances, nullptr);
+  ASSERT_NE(f_distances, nullptr);
+  auto result = gurka::do_action(valhalla::Options::route, map, {"E", "F"}, "auto");
+  const double meters = result.directions().routes(0).legs(0).summary().length() * 1000;
+  for (uint32_t k = 0; k < landmarks->landmark_count(); ++k) {
+    const double bound = std::abs(static_cast<double>(e_distances[k]) - f_distances[k]);
+    EXPECT_LE(bound, meters + 1);
+  }
+}
+
+TEST(Landmarks, SameRoutesWithAndWithout) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, kWorkdir,
+                               {{"mjolnir.concurrency", "1"},
+                                {"mjolnir.landmarks", kWorkdir + "/landmarks.bin"}});
+  auto without = map;
+  without.config.get_child("mjolnir").erase("landmarks");
+
+  for (const auto& waypoints : std::vector<std::vector<std::string>>{{"E", "F"},
+                                                                     {"F", "E"},
+                                                                     {"A", "K"},
+                                                                     {"H", "J"},
+                                                                     {"D", "G"}}) {
+    auto with_landmarks = gurka::do_action(valhalla::Options::route, map, waypoints, "auto");
+    auto without_landmarks =
+        gurka::do_action(valhalla::Options::route, without, waypoints, "auto");
+    EXPECT_EQ(gurka::detail::get_paths(with_landmarks), gurka::detail::get_paths(without_landmarks))
+        << waypoints.front() << " to " << waypoints.back();
+  }
+}
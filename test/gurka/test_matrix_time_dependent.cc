@@ -326,3 +326,44 @@ TEST_F(MatrixTest, TDTargets) {
   ASSERT_EQ(result.info().warnings().size(), 1);
   ASSERT_EQ(result.info().warnings().Get(0).code(), 202);
 }
+
+TEST_F(MatrixTest, DepartureTimes) {
+  rapidjson::Document res_doc;
+  std::string res;
+  const std::unordered_map<std::string, std::string> options =
+      {{"/departure_times/0", "2016-07-03T08:06"},
+       {"/departure_times/1", "2016-07-03T20:06"},
+       {"/departure_times/2", "2016-07-04T08:06"}};
+  auto result = gurka::do_action(Options::sources_to_targets, map, {"E", "L"}, {"E", "L"}, "auto",
+                                 options, nullptr, &res);
+  res_doc.Parse(res.c_str());
+  ASSERT_EQ(result.info().warnings().size(), 0);
+
+  // one whole matrix for each of the departure times, in the order of the times
+  ASSERT_EQ(res_doc["departure_times"].Size(), 3u);
+  EXPECT_EQ(std::string(res_doc["departure_times"][1].GetString()), "2016-07-03T20:06");
+  ASSERT_EQ(res_doc["sources_to_targets"].Size(), 3u);
+  for (const auto& slice : res_doc["sources_to_targets"].GetArray()) {
+    ASSERT_EQ(slice.Size(), 2u);
+    for (size_t source_index = 0; source_index < 2; ++source_index) {
+      ASSERT_EQ(slice[source_index].Size(), 2u);
+      for (size_t target_index = 0; target_index < 2; ++target_index) {
+        const auto& cell = slice[source_index][target_index];
+        EXPECT_EQ(cell["from_index"].GetUint64(), source_index);
+        EXPECT_EQ(cell["to_index"].GetUint64(), target_index);
+        EXPECT_TRUE(cell.HasMember("date_time"));
+      }
+    }
+    EXPECT_NEAR(slice[0][0]["distance"].GetFloat(), 0.f, 0.01);
+    EXPECT_NEAR(slice[1][1]["distance"].GetFloat(), 0.f, 0.01);
+  }
+  EXPECT_EQ(std::string(res_doc["algorithm"].GetString()), "timedistancematrix");
+
+  // beyond the limit of departure times
+  map.config.put("service_limits.max_matrix_departure_times", "2");
+  try {
+    gurka::do_action(Options::sources_to_targets, map, {"E", "L"}, {"E", "L"}, "auto", options);
+    FAIL() << "Expected too many departure times";
+  } catch (const valhalla_exception_t& e) { EXPECT_EQ(e.code, 173); }
+  map.config.put("service_limits.max_matrix_departure_times", "96");
+}
@@ -0,0 +1,64 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class OptimizedRoute : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A----B----C----D
+      |    |    |    |
+      E----F----G----H
+      |    |    |    |
+      I----J----K----L
+    )";
+
+    const gurka::ways ways = {{"ABCD", {{"highway", "residential"}}},
+                              {"EFGH", {{"highway", "residential"}}},
+                              {"IJKL", {{"highway", "residential"}}},
+                              {"AEI", {{"highway", "residential"}}},
+                              {"BFJ", {{"highway", "residential"}}},
+                              {"CGK", {{"highway", "residential"}}},
+                              {"DHL", {{"highway", "residential"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_optimized_route");
+  }
+};
+
+gurka::map OptimizedRoute::map = {};
+
+TEST_F(OptimizedRoute, LegsInParallel) {
+  const std::vector<std::string> waypoints = {"A", "L", "C", "I", "F", "H"};
+  const auto serial = gurka::do_action(Options::optimized_route, map, waypoints, "auto");
+
+  // the same request routed with its legs spread over several threads
+  auto threaded_map = map;
+  threaded_map.config.put("thor.optimized_route_threads", 3);
+  const auto threaded = gurka::do_action(Options::optimized_route, threaded_map, waypoints, "auto");
+
+  ASSERT_EQ(serial.trip().routes_size(), 1);
+  ASSERT_EQ(threaded.trip().routes_size(), 1);
+  const auto& serial_legs = serial.trip().routes(0).legs();
+  const auto& threaded_legs = threaded.trip().routes(0).legs();
+  ASSERT_EQ(serial_legs.size(), waypoints.size() - 1);
+  ASSERT_EQ(threaded_legs.size(), serial_legs.size());
+  for (int i = 0; i < serial_legs.size(); ++i) {
+    EXPECT_EQ(threaded_legs.Get(i).shape(), serial_legs.Get(i).shape()) << "leg " << i;
+    EXPECT_EQ(threaded_legs.Get(i).node_size(), serial_legs.Get(i).node_size()) << "leg " << i;
+  }
+
+  // the locations come back in the optimized order either way
+  ASSERT_EQ(threaded.options().locations_size(), serial.options().locations_size());
+  for (int i = 0; i < serial.options().locations_size(); ++i) {
+    EXPECT_EQ(threaded.options().locations(i).correlation().original_index(),
+              serial.options().locations(i).correlation().original_index());
+  }
+}
@@ -515,3 +515,52 @@ TEST(Standalone, HeadingNumberAutoRoute) {
   }
   // clang-format on
 }
+
+TEST(Standalone, OsrmSerializerStepGeometry) {
+  const std::string ascii_map = R"(
+    B---C---D
+    |
+    A
+  )";
+
+  const gurka::ways ways = {
+      {"AB", {{"highway", "primary"}}},
+      {"BCD", {{"highway", "primary"}}},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10, {40.7351162, -73.985719});
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/osrm_serializer_step_geometry");
+
+  // The single leg polyline is the route geometry and steps share their end and begin points
+  auto result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto");
+  auto json = gurka::convert_to_json(result, Options::Format::Options_Format_osrm);
+  EXPECT_EQ(json["routes"][0]["geometry"].GetString(),
+            result.directions().routes(0).legs(0).shape());
+  const auto& steps = json["routes"][0]["legs"][0]["steps"];
+  ASSERT_EQ(steps.Size(), 3);
+  auto depart = midgard::decode<std::vector<midgard::PointLL>>(steps[0]["geometry"].GetString());
+  auto turn = midgard::decode<std::vector<midgard::PointLL>>(steps[1]["geometry"].GetString());
+  auto arrive = midgard::decode<std::vector<midgard::PointLL>>(steps[2]["geometry"].GetString());
+  EXPECT_EQ(depart.size(), 2);
+  EXPECT_EQ(turn.size(), 3);
+  EXPECT_TRUE(depart.back().ApproximatelyEqual(turn.front()));
+  ASSERT_EQ(arrive.size(), 2);
+  EXPECT_TRUE(arrive.front().ApproximatelyEqual(turn.back()));
+  EXPECT_TRUE(arrive.back().ApproximatelyEqual(arrive.front()));
+
+  // Same for geojson, where the arrival is a linestring of the destination twice
+  result = gurka::do_action(valhalla::Options::route, map, {"A", "D"}, "auto",
+                            {{"/shape_format", "geojson"}});
+  json = gurka::convert_to_json(result, Options::Format::Options_Format_osrm);
+  EXPECT_STREQ(json["routes"][0]["geometry"]["type"].GetString(), "LineString");
+  EXPECT_EQ(json["routes"][0]["geometry"]["coordinates"].Size(), 4);
+  const auto& geojson_steps = json["routes"][0]["legs"][0]["steps"];
+  ASSERT_EQ(geojson_steps.Size(), 3);
+  EXPECT_EQ(geojson_steps[1]["geometry"]["coordinates"].Size(), 3);
+  const auto& arrival = geojson_steps[2]["geometry"]["coordinates"];
+  ASSERT_EQ(arrival.Size(), 2);
+  EXPECT_EQ(arrival[0][0].GetDouble(), arrival[1][0].GetDouble());
+  EXPECT_EQ(arrival[0][1].GetDouble(), arrival[1][1].GetDouble());
+  EXPECT_EQ(geojson_steps[2]["intersections"].Size(), 1);
+  EXPECT_EQ(geojson_steps[1]["intersections"][0]["bearings"].Size(), 2);
+}
@@ -0,0 +1,79 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+#include "baldr/graphreader.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+// the roads of each class cross several tiles of their level
+const std::string ascii_map = R"(
+    A-----B-----C-----D-----E-----F
+    |           |           |
+    G-----H-----I-----J-----K
+    |                       |
+    L-----M-----N-----O-----P
+  )";
+
+const gurka::ways ways = {
+    {"ABCDEF", {{"highway", "motorway"}, {"name", "Motorway"}}},
+    {"AG", {{"highway", "primary"}, {"name", "West"}}},
+    {"CI", {{"highway", "primary"}, {"name", "Middle"}}},
+    {"EK", {{"highway", "primary"}, {"name", "East"}}},
+    {"GHIJK", {{"highway", "secondary"}, {"name", "Secondary"}}},
+    {"GL", {{"highway", "residential"}, {"name", "Left"}}},
+    {"KP", {{"highway", "residential"}, {"name", "Right"}}},
+    {"LMNOP", {{"highway", "residential"}, {"name", "Residential"}}},
+};
+
+gurka::map build(const std::string& concurrency) {
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10000, {5.1, 52.1});
+  return gurka::buildtiles(layout, ways, {}, {}, "test/data/parallel_hierarchy_" + concurrency,
+                           {{"mjolnir.concurrency", concurrency}});
+}
+
+} // namespace
+
+// the node ids of the hierarchy and the shortcuts must not depend on how the work is split up
+TEST(ParallelHierarchy, SameGraphAnyConcurrency) {
+  auto serial = build("1");
+  auto parallel = build("4");
+  GraphReader serial_reader(serial.config.get_child("mjolnir"));
+  GraphReader parallel_reader(parallel.config.get_child("mjolnir"));
+  auto tile_ids = serial_reader.GetTileSet();
+  ASSERT_EQ(tile_ids, parallel_reader.GetTileSet());
+  ASSERT_GT(tile_ids.size(), TileHierarchy::levels().size());
+
+  size_t shortcuts = 0;
+  for (const auto& tile_id : tile_ids) {
+    auto expected = serial_reader.GetGraphTile(tile_id);
+    auto actual = parallel_reader.GetGraphTile(tile_id);
+    ASSERT_EQ(expected->header()->nodecount(), actual->header()->nodecount());
+    ASSERT_EQ(expected->header()->directededgecount(), actual->header()->directededgecount());
+    ASSERT_EQ(expected->header()->transitioncount(), actual->header()->transitioncount());
+    for (uint32_t i = 0; i < expected->header()->nodecount(); ++i) {
+      EXPECT_EQ(expected->node(i)->latlng(expected->header()->base_ll()),
+                actual->node(i)->latlng(actual->header()->base_ll()));
+      EXPECT_EQ(expected->node(i)->edge_count(), actual->node(i)->edge_count());
+    }
+    for (uint32_t i = 0; i < expected->header()->transitioncount(); ++i) {
+      EXPECT_EQ(expected->transition(i)->endnode(), actual->transition(i)->endnode());
+    }
+    for (uint32_t i = 0; i < expected->header()->directededgecount(); ++i) {
+      const auto* expected_edge = expected->directededge(i);
+      const auto* actual_edge = actual->directededge(i);
+      EXPECT_EQ(expected_edge->endnode(), actual_edge->endnode());
+      EXPECT_EQ(expected_edge->opp_index(), actual_edge->opp_index());
+      EXPECT_EQ(expected_edge->is_shortcut(), actual_edge->is_shortcut());
+      EXPECT_EQ(expected_edge->superseded(), actual_edge->superseded());
+      EXPECT_EQ(expected_edge->length(), actual_edge->length());
+      shortcuts += expected_edge->is_shortcut();
+    }
+  }
+  EXPECT_GT(shortcuts, 0);
+
+  auto result = gurka::do_action(valhalla::Options::route, parallel, {"A", "P"}, "auto");
+  EXPECT_EQ(result.trip().routes(0).legs_size(), 1);
+}
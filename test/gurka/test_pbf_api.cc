@@ -138,3 +138,137 @@ TEST(pbf_api, pbf_error) {
     api.mutable_options()->set_action(Options::route);
   }
 }
+
+class PbfOutput : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+      A----B----C
+      |    |    |
+      D----E----F
+    )";
+
+    const gurka::ways ways = {
+        {"ABC", {{"highway", "residential"}}}, {"DEF", {{"highway", "residential"}}},
+        {"AD", {{"highway", "residential"}}},  {"BE", {{"highway", "residential"}}},
+        {"CF", {{"highway", "residential"}}},
+    };
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_pbf_output");
+  }
+};
+
+gurka::map PbfOutput::map = {};
+
+TEST_F(PbfOutput, Matrix) {
+  std::string json, pbf_bytes;
+  gurka::do_action(Options::sources_to_targets, map, {"A", "F"}, {"A", "C", "F"}, "auto", {}, {},
+                   &json);
+  gurka::do_action(Options::sources_to_targets, map, {"A", "F"}, {"A", "C", "F"}, "auto",
+                   {{"/format", "pbf"}}, {}, &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  EXPECT_FALSE(actual.has_options());
+  ASSERT_TRUE(actual.has_matrix());
+  ASSERT_EQ(actual.matrix().times_size(), 6);
+  ASSERT_EQ(actual.matrix().distances_size(), 6);
+  EXPECT_EQ(actual.matrix().date_times_size(), 0);
+
+  // the same numbers as the json, which rounds them
+  rapidjson::Document doc;
+  doc.Parse(json.c_str());
+  ASSERT_FALSE(doc.HasParseError());
+  const auto& rows = doc["sources_to_targets"];
+  for (int i = 0; i < actual.matrix().times_size(); ++i) {
+    const auto& cell = rows[i / 3][i % 3];
+    EXPECT_EQ(static_cast<uint64_t>(actual.matrix().times(i)), cell["time"].GetUint64());
+    EXPECT_NEAR(actual.matrix().distances(i), cell["distance"].GetDouble(), 0.001);
+  }
+}
+
+TEST_F(PbfOutput, CompactMatrix) {
+  std::string request_json, pbf_bytes, compact_bytes;
+  gurka::do_action(Options::sources_to_targets, map, {"A", "F"}, {"A", "C", "F"}, "auto",
+                   {{"/format", "pbf"}}, {}, &pbf_bytes, &request_json);
+
+  rapidjson::Document request;
+  request.Parse(request_json.c_str());
+  ASSERT_FALSE(request.HasParseError());
+  request.AddMember("compact_matrix", true, request.GetAllocator());
+  gurka::do_action(Options::sources_to_targets, map, rapidjson::serialize(request), {},
+                   &compact_bytes);
+
+  Api expected, actual;
+  ASSERT_TRUE(expected.ParseFromString(pbf_bytes));
+  ASSERT_TRUE(actual.ParseFromString(compact_bytes));
+  EXPECT_EQ(actual.matrix().times_size(), 0);
+  EXPECT_EQ(actual.matrix().distances_size(), 0);
+  ASSERT_EQ(actual.matrix().time_deltas_size(), 6);
+  ASSERT_EQ(actual.matrix().distance_deltas_size(), 6);
+  EXPECT_LT(compact_bytes.size(), pbf_bytes.size());
+
+  // summing up each row gives back seconds and meters plus 1
+  int64_t time = 0, distance = 0;
+  for (int i = 0; i < actual.matrix().time_deltas_size(); ++i) {
+    if (i % 3 == 0) {
+      time = distance = 0;
+    }
+    time += actual.matrix().time_deltas(i);
+    distance += actual.matrix().distance_deltas(i);
+    ASSERT_GT(time, 0);
+    ASSERT_GT(distance, 0);
+    EXPECT_EQ(time - 1, static_cast<int64_t>(expected.matrix().times(i)));
+    EXPECT_NEAR(distance - 1, expected.matrix().distances(i) * 1000, 1);
+  }
+}
+
+TEST_F(PbfOutput, Isochrone) {
+  std::string pbf_bytes;
+  gurka::do_action(Options::isochrone, map, {"E"}, "pedestrian",
+                   {{"/contours/0/time", "2"}, {"/contours/1/distance", "0.1"},
+                    {"/polygons", "1"}, {"/format", "pbf"}},
+                   {}, &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  EXPECT_FALSE(actual.has_options());
+  ASSERT_EQ(actual.isochrone().intervals_size(), 2);
+  EXPECT_EQ(actual.isochrone().intervals(0).metric(), Isochrone::Interval::time);
+  EXPECT_EQ(actual.isochrone().intervals(0).threshold(), 2.f);
+  EXPECT_EQ(actual.isochrone().intervals(1).metric(), Isochrone::Interval::distance);
+  EXPECT_NEAR(actual.isochrone().intervals(1).threshold(), 0.1f, 1e-6);
+
+  // every ring is closed and goes around the origin
+  const auto& origin = map.nodes.at("E");
+  for (const auto& interval : actual.isochrone().intervals()) {
+    ASSERT_GT(interval.contours_size(), 0);
+    const auto& coords = interval.contours(0).geometries(0).coords();
+    ASSERT_GE(coords.size(), 8);
+    EXPECT_EQ(coords[0], coords[coords.size() - 2]);
+    EXPECT_EQ(coords[1], coords[coords.size() - 1]);
+    int32_t min_lon = coords[0], max_lon = coords[0];
+    for (int i = 0; i < coords.size(); i += 2) {
+      min_lon = std::min(min_lon, coords[i]);
+      max_lon = std::max(max_lon, coords[i]);
+    }
+    EXPECT_LT(min_lon, origin.lng() * 1e6);
+    EXPECT_GT(max_lon, origin.lng() * 1e6);
+  }
+}
+
+TEST_F(PbfOutput, Height) {
+  std::string pbf_bytes;
+  gurka::do_action(Options::height, map, {"A", "B", "C"}, "auto",
+                   {{"/range", "1"}, {"/format", "pbf"}}, {}, &pbf_bytes);
+
+  Api actual;
+  ASSERT_TRUE(actual.ParseFromString(pbf_bytes));
+  EXPECT_FALSE(actual.has_options());
+  ASSERT_EQ(actual.height().heights_size(), 3);
+  ASSERT_EQ(actual.height().ranges_size(), 3);
+  EXPECT_EQ(actual.height().ranges(0), 0);
+  EXPECT_NEAR(actual.height().ranges(2), map.nodes.at("A").Distance(map.nodes.at("C")), 1);
+}
@@ -0,0 +1,114 @@
+#include "gurka.h"
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+const std::string ascii_map = R"(
+    A----B----C
+         |
+         D----E
+  )";
+
+const gurka::ways ways = {
+    {"ABC", {{"highway", "primary"}}},
+    {"BDE", {{"highway", "residential"}}},
+};
+
+// the value of each statistic by its key
+std::unordered_map<std::string, double> statistics(const Api& api) {
+  std::unordered_map<std::string, double> found;
+  for (const auto& stat : api.info().statistics()) {
+    found[stat.key()] += stat.value();
+  }
+  return found;
+}
+
+} // namespace
+
+class PhaseTimings : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_phase_timings");
+  }
+};
+
+gurka::map PhaseTimings::map = {};
+
+TEST_F(PhaseTimings, Route) {
+  auto result = gurka::do_action(Options::route, map, {"A", "E"}, "auto");
+  auto found = statistics(result);
+
+  // every phase the route went through has a timing
+  for (const auto& phase : {"loki.search", "thor.bidirectional_astar", "thor.trip_leg_builder",
+                            "odin.maneuvers", "odin.narrative", "tyr.serialize"}) {
+    auto timing = found.find("route.info." + std::string(phase) + ".latency_ms");
+    ASSERT_NE(timing, found.end()) << phase;
+    EXPECT_GE(timing->second, 0.);
+  }
+
+  // and the expansion says how much work it did
+  auto labels = found.find("route.info.thor.bidirectional_astar.labels");
+  ASSERT_NE(labels, found.end());
+  EXPECT_GT(labels->second, 0.);
+}
+
+TEST_F(PhaseTimings, Matrix) {
+  auto result = gurka::do_action(Options::sources_to_targets, map, {"A", "C"}, {"D", "E"}, "auto");
+  auto found = statistics(result);
+  EXPECT_NE(found.find("sources_to_targets.info.loki.search.latency_ms"), found.end());
+  EXPECT_NE(found.find("sources_to_targets.info.tyr.serialize.latency_ms"), found.end());
+  EXPECT_TRUE(found.count("sources_to_targets.info.thor.costmatrix.latency_ms") ||
+              found.count("sources_to_targets.info.thor.timedistancematrix.latency_ms"));
+}
+
+TEST_F(PhaseTimings, SearchCounters) {
+  auto result = gurka::do_action(Options::route, map, {"A", "E"}, "auto");
+  auto found = statistics(result);
+
+  // the tiles are read from disk at first
+  EXPECT_GT(found["route.info.loki.tile_cache.misses"], 0.);
+  EXPECT_GT(found["route.info.loki.tile_cache.tiles_loaded"], 0.);
+  EXPECT_GT(found["route.info.loki.tile_cache.bytes_loaded"], 0.);
+  EXPECT_NE(found.find("route.info.loki.tile_load.latency_ms"), found.end());
+  EXPECT_GT(found["route.info.thor.tile_cache.hits"], 0.);
+
+  // the search says what the hierarchy limits and its queue did
+  EXPECT_NE(found.find("route.info.thor.bidirectional_astar.hierarchy_pruned"), found.end());
+  EXPECT_NE(found.find("route.info.thor.bidirectional_astar.queue_redistributions"), found.end());
+}
+
+TEST_F(PhaseTimings, StatusCounters) {
+  auto config = map.config;
+  config.put("service_limits.status.allow_verbose", true);
+  tyr::actor_t actor(config, true);
+  const auto& a = map.nodes.at("A");
+  const auto& e = map.nodes.at("E");
+  actor.route(R"({"costing":"auto","locations":[{"lon":)" + std::to_string(a.lng()) +
+              R"(,"lat":)" + std::to_string(a.lat()) + R"(},{"lon":)" + std::to_string(e.lng()) +
+              R"(,"lat":)" + std::to_string(e.lat()) + "}]}");
+
+  rapidjson::Document status;
+  status.Parse(actor.status(R"({"verbose":true})"));
+  ASSERT_FALSE(status.HasParseError());
+  ASSERT_TRUE(status.HasMember("counters"));
+  const auto& counters = status["counters"];
+  ASSERT_EQ(counters.Size(), 2);
+  EXPECT_STREQ(counters[0]["service"].GetString(), "loki");
+  EXPECT_STREQ(counters[1]["service"].GetString(), "thor");
+  for (const auto& service : counters.GetArray()) {
+    const auto& tile_cache = service["tile_cache"];
+    EXPECT_GT(tile_cache["hits"].GetUint64() + tile_cache["misses"].GetUint64(), 0);
+  }
+  const auto& search = counters[1]["search"];
+  EXPECT_EQ(search["searches"].GetUint64(), 1);
+  EXPECT_GT(search["labels"].GetUint64(), 0);
+
+  // without verbose there are no counters
+  status.Parse(actor.status(""));
+  EXPECT_FALSE(status.HasMember("counters"));
+}
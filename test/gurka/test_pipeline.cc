@@ -0,0 +1,83 @@
+#include "gurka.h"
+#include "test.h"
+#include "tyr/pipeline.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class Pipeline : public ::testing::Test {
+protected:
+  static gurka::map map;
+
+  static void SetUpTestSuite() {
+    const std::string ascii_map = R"(
+      A----B----C
+      |    |    |
+      D----E----F
+    )";
+
+    const gurka::ways ways = {
+        {"ABC", {{"highway", "residential"}}}, {"DEF", {{"highway", "residential"}}},
+        {"AD", {{"highway", "residential"}}},  {"BE", {{"highway", "residential"}}},
+        {"CF", {{"highway", "residential"}}},
+    };
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_pipeline");
+  }
+
+  // the pipeline answers exactly like the actor, which runs the same stages
+  static void expect_same(Options::Action action, const std::string& request_json) {
+    tyr::actor_t actor(map.config, true);
+    Api actor_request;
+    ParseApi(request_json, action, actor_request);
+    const auto expected = actor.act(actor_request);
+
+    tyr::pipeline_worker_t pipeline(map.config);
+    for (int i = 0; i < 2; ++i) {
+      Api request;
+      ParseApi(request_json, action, request);
+      EXPECT_EQ(pipeline.act(request), expected);
+      pipeline.cleanup();
+    }
+  }
+};
+
+gurka::map Pipeline::map = {};
+
+TEST_F(Pipeline, Route) {
+  std::string request_json;
+  gurka::do_action(Options::route, map, {"A", "F"}, "auto", {}, {}, nullptr, "break",
+                   &request_json);
+  expect_same(Options::route, request_json);
+}
+
+TEST_F(Pipeline, Matrix) {
+  std::string request_json;
+  gurka::do_action(Options::sources_to_targets, map, {"A", "D"}, {"C", "F"}, "auto", {}, {},
+                   nullptr, &request_json);
+  expect_same(Options::sources_to_targets, request_json);
+}
+
+TEST_F(Pipeline, Locate) {
+  std::string request_json;
+  gurka::do_action(Options::locate, map, {"B"}, "auto", {}, {}, nullptr, "break", &request_json);
+  expect_same(Options::locate, request_json);
+}
+
+TEST_F(Pipeline, UnsupportedAction) {
+  auto config = map.config;
+  config.get_child("loki.actions").clear();
+  config.get_child("loki.actions").push_back({"", boost::property_tree::ptree("locate")});
+  tyr::pipeline_worker_t pipeline(config);
+
+  Api request;
+  ParseApi(R"({"locations":[{"lat":0,"lon":0},{"lat":0,"lon":0.01}],"costing":"auto"})",
+           Options::route, request);
+  try {
+    pipeline.act(request);
+    FAIL() << "Expected valhalla_exception_t.";
+  } catch (const valhalla_exception_t& err) { EXPECT_EQ(err.code, 106); } catch (...) {
+    FAIL() << "Expected valhalla_exception_t.";
+  };
+}
@@ -742,3 +742,87 @@ TEST(recosting, api) {
     }
   }
 }
+
+TEST(recosting, batch) {
+  const std::string ascii_map = R"(A--1--B-2-3-C
+                                         |     |
+                                         |     |
+                                         4     5
+                                         |     |
+                                         |     |
+                                         D--6--E--7--F)";
+  const gurka::ways ways = {
+      {"A1B23C", {{"highway", "residential"}}},
+      {"D6E7F", {{"highway", "residential"}}},
+      {"B4D", {{"highway", "pedestrian"}}},
+      {"C5E", {{"highway", "pedestrian"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_recost_batch", build_config);
+  auto reader = std::make_shared<baldr::GraphReader>(map.config.get_child("mjolnir"));
+
+  // a path the car can take, one it can't and a couple of bogus ones
+  std::vector<std::vector<baldr::GraphId>> paths;
+  for (const auto& route : {std::vector<std::string>{"A", "C"}, {"A", "F"}}) {
+    auto api = gurka::do_action(valhalla::Options::route, map, route, "pedestrian", {}, reader);
+    paths.emplace_back();
+    for (const auto& node : api.trip().routes(0).legs(0).node()) {
+      if (node.has_edge()) {
+        paths.back().emplace_back(node.edge().id());
+      }
+    }
+  }
+  paths.push_back({});
+  paths.push_back({baldr::GraphId{123456789}});
+
+  std::vector<Costing> costings;
+  for (const auto* json : {R"({"costing":"auto"})", R"({"costing":"pedestrian"})"}) {
+    rapidjson::Document doc;
+    doc.Parse(json);
+    costings.emplace_back();
+    sif::ParseCosting(doc, "", &costings.back());
+  }
+
+  std::map<std::pair<size_t, size_t>, std::vector<sif::Cost>> results;
+  valhalla::tyr::actor_t actor(map.config, true);
+  actor.recost(paths, costings, [&](size_t path, size_t costing, const std::vector<sif::Cost>& e) {
+    EXPECT_TRUE(results.emplace(std::make_pair(path, costing), e).second);
+  });
+  ASSERT_EQ(results.size(), paths.size() * costings.size());
+
+  // the same as recosting each of them on its own
+  for (size_t i = 0; i < paths.size(); ++i) {
+    for (size_t j = 0; j < costings.size(); ++j) {
+      std::vector<sif::Cost> expected;
+      auto edge = paths[i].cbegin();
+      try {
+        sif::recost_forward(
+            *reader, *sif::CostFactory().Create(costings[j]),
+            [&]() { return edge == paths[i].cend() ? baldr::GraphId{} : *edge++; },
+            [&](const sif::EdgeLabel& label) { expected.push_back(label.cost()); });
+      } catch (const std::runtime_error&) { expected.clear(); }
+      const auto& elapsed = results[std::make_pair(i, j)];
+      ASSERT_EQ(elapsed.size(), expected.size()) << "path " << i << " costing " << j;
+      for (size_t k = 0; k < elapsed.size(); ++k) {
+        EXPECT_EQ(elapsed[k].secs, expected[k].secs);
+        EXPECT_EQ(elapsed[k].cost, expected[k].cost);
+      }
+    }
+  }
+
+  // the car can only take the first path, walking works for both of the real ones
+  auto result = [&results](size_t path, size_t costing) { return results[{path, costing}]; };
+  EXPECT_FALSE(result(0, 0).empty());
+  EXPECT_TRUE(result(1, 0).empty());
+  EXPECT_EQ(result(0, 1).size(), paths[0].size());
+  EXPECT_EQ(result(1, 1).size(), paths[1].size());
+  EXPECT_TRUE(result(2, 1).empty());
+  EXPECT_TRUE(result(3, 1).empty());
+
+  // the callback stops the batch
+  EXPECT_THROW(actor.recost(paths, costings,
+                            [](size_t, size_t, const std::vector<sif::Cost>&) {
+                              throw std::runtime_error("enough");
+                            }),
+               std::runtime_error);
+}
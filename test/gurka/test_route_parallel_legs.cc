@@ -0,0 +1,86 @@
+#include "gurka.h"
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+class RouteParallelLegs : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static gurka::map threaded_map;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A----B----C----D
+      |    |    |    |
+      E----F----G----H
+      |    |    |    |
+      I----J----K----L
+    )";
+
+    const gurka::ways ways = {{"ABCD", {{"highway", "residential"}}},
+                              {"EFGH", {{"highway", "residential"}}},
+                              {"IJKL", {{"highway", "residential"}}},
+                              {"AEI", {{"highway", "residential"}}},
+                              {"BFJ", {{"highway", "residential"}}},
+                              {"CGK", {{"highway", "residential"}}},
+                              {"DHL", {{"highway", "residential"}}}};
+
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_route_parallel_legs");
+    threaded_map = map;
+    threaded_map.config.put("thor.optimized_route_threads", 3);
+  }
+
+  void expect_same_legs(const Api& serial, const Api& threaded) {
+    ASSERT_EQ(serial.trip().routes_size(), 1);
+    ASSERT_EQ(threaded.trip().routes_size(), 1);
+    const auto& serial_legs = serial.trip().routes(0).legs();
+    const auto& threaded_legs = threaded.trip().routes(0).legs();
+    ASSERT_EQ(threaded_legs.size(), serial_legs.size());
+    for (int i = 0; i < serial_legs.size(); ++i) {
+      EXPECT_EQ(threaded_legs.Get(i).shape(), serial_legs.Get(i).shape()) << "leg " << i;
+      EXPECT_EQ(threaded_legs.Get(i).node_size(), serial_legs.Get(i).node_size()) << "leg " << i;
+    }
+    ASSERT_EQ(threaded.options().locations_size(), serial.options().locations_size());
+    for (int i = 0; i < serial.options().locations_size(); ++i) {
+      EXPECT_EQ(threaded.options().locations(i).correlation().edges_size(),
+                serial.options().locations(i).correlation().edges_size());
+    }
+  }
+};
+
+gurka::map RouteParallelLegs::map = {};
+gurka::map RouteParallelLegs::threaded_map = {};
+
+TEST_F(RouteParallelLegs, BreaksAreRoutedAtOnce) {
+  const std::vector<std::string> waypoints = {"A", "L", "C", "I", "F", "H", "D"};
+  const auto serial = gurka::do_action(Options::route, map, waypoints, "auto");
+  const auto threaded = gurka::do_action(Options::route, threaded_map, waypoints, "auto");
+  ASSERT_EQ(threaded.trip().routes(0).legs_size(), static_cast<int>(waypoints.size()) - 1);
+  expect_same_legs(serial, threaded);
+  EXPECT_EQ(gurka::detail::get_paths(threaded), gurka::detail::get_paths(serial));
+}
+
+TEST_F(RouteParallelLegs, DependentLegsStaySerial) {
+  // a break_through in between starts its leg on the edge the leg before ended on and a through
+  // location merges two legs, both have to be routed one after the other
+  const std::vector<std::string> waypoints = {"A", "L", "C", "I", "F"};
+  for (const auto& type : {"break_through", "through"}) {
+    const std::unordered_map<std::string, std::string> options = {{"/locations/2/type", type}};
+    const auto serial = gurka::do_action(Options::route, map, waypoints, "auto", options);
+    const auto threaded =
+        gurka::do_action(Options::route, threaded_map, waypoints, "auto", options);
+    expect_same_legs(serial, threaded);
+  }
+
+  // so does a departure time, it carries over from one leg to the next
+  const std::unordered_map<std::string, std::string> depart =
+      {{"/date_time/type", "1"}, {"/date_time/value", "2020-10-30T09:00"}};
+  const auto serial = gurka::do_action(Options::route, map, waypoints, "auto", depart);
+  const auto threaded = gurka::do_action(Options::route, threaded_map, waypoints, "auto", depart);
+  expect_same_legs(serial, threaded);
+}
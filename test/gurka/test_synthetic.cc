@@ -0,0 +1,75 @@
+#include "gurka.h"
+#include "synthetic.h"
+#include "test.h"
+
+#include "baldr/graphreader.h"
+#include "filesystem.h"
+
+#include <algorithm>
+#include <set>
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+
+namespace {
+
+gurka::synthetic::network_options small_network() {
+  gurka::synthetic::network_options options;
+  options.cities_x = 2;
+  options.cities_y = 1;
+  options.city_spacing = 5000;
+  options.blocks = 6;
+  options.arterial_every = 3;
+  options.restriction_ratio = 1;
+  return options;
+}
+
+} // namespace
+
+TEST(Synthetic, Reproducible) {
+  const std::string workdir = "test/data/gurka_synthetic_pbf";
+  filesystem::create_directories(workdir);
+
+  auto options = small_network();
+  const auto stats = gurka::synthetic::build_pbf(options, workdir + "/a.pbf");
+  gurka::synthetic::build_pbf(options, workdir + "/b.pbf");
+  options.seed = 2;
+  gurka::synthetic::build_pbf(options, workdir + "/c.pbf");
+
+  // 2 cities of 7 by 7 intersections and 4 inner nodes on each carriageway of the 4.1km motorway
+  EXPECT_EQ(stats.nodes, 2 * 49 + 2 * 4);
+  // both arterials only cross once in each city
+  EXPECT_EQ(stats.restrictions, 2);
+  EXPECT_GT(stats.ways, 2);
+
+  const auto a = test::load_binary_file(workdir + "/a.pbf");
+  EXPECT_EQ(a, test::load_binary_file(workdir + "/b.pbf"));
+  EXPECT_NE(a, test::load_binary_file(workdir + "/c.pbf"));
+
+  options.city_spacing = options.blocks * options.block_size;
+  EXPECT_THROW(gurka::synthetic::build_pbf(options, workdir + "/d.pbf"), std::invalid_argument);
+}
+
+TEST(Synthetic, RouteBetweenCities) {
+  auto options = small_network();
+  options.traffic_ratio = 0.5;
+  const auto map = gurka::synthetic::buildtiles(
+      options, test::make_config("test/data/gurka_synthetic", {{"mjolnir.concurrency", "1"}}));
+
+  // all three levels of the hierarchy are there
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  std::set<uint8_t> levels;
+  for (const auto& tile_id : reader.GetTileSet()) {
+    levels.insert(tile_id.level());
+  }
+  EXPECT_EQ(levels, (std::set<uint8_t>{0, 1, 2}));
+
+  // getting to the next city takes the motorway
+  auto result = gurka::do_action(Options::route, map,
+                                 {gurka::synthetic::city(0, 0), gurka::synthetic::city(1, 0)},
+                                 "auto");
+  const auto paths = gurka::detail::get_paths(result);
+  ASSERT_EQ(paths.size(), 1);
+  EXPECT_NE(std::find(paths.front().begin(), paths.front().end(), "A1"), paths.front().end());
+}
@@ -0,0 +1,96 @@
+#include "baldr/tile_shard.h"
+#include "gurka.h"
+#include "test.h"
+
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+class TileShard : public ::testing::Test {
+protected:
+  static gurka::map map;
+  static GraphId west, east;
+
+  static void SetUpTestSuite() {
+    constexpr double gridsize = 100;
+
+    const std::string ascii_map = R"(
+      A----B----C
+    )";
+
+    const gurka::ways ways = {{"AB", {{"highway", "residential"}}},
+                              {"BC", {{"highway", "residential"}}}};
+
+    // the local tiles are a quarter degree wide so the road crosses from one into the next
+    const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize, {0.2478, 0.1});
+    map = gurka::buildtiles(layout, ways, {}, {}, "test/data/gurka_tile_shard");
+
+    const auto& level = TileHierarchy::levels().back();
+    west = GraphId(level.tiles.TileId(layout.at("A")), level.level, 0);
+    east = GraphId(level.tiles.TileId(layout.at("C")), level.level, 0);
+
+    // the shard serves the western tile
+    std::ofstream list("test/data/gurka_tile_shard/shard.txt");
+    list << "# the western tile" << std::endl
+         << std::to_string(west.level()) + "/" + std::to_string(west.tileid()) << std::endl;
+  }
+};
+
+gurka::map TileShard::map = {};
+GraphId TileShard::west = {};
+GraphId TileShard::east = {};
+
+TEST_F(TileShard, OnlyServesItsRegion) {
+  ASSERT_NE(west, east);
+  auto config = map.config;
+  config.put("mjolnir.shard.tiles", "test/data/gurka_tile_shard/shard.txt");
+  GraphReader reader(config.get_child("mjolnir"));
+
+  EXPECT_NE(reader.GetGraphTile(west), nullptr);
+  EXPECT_TRUE(reader.DoesTileExist(west));
+  EXPECT_EQ(reader.GetGraphTile(east), nullptr);
+  EXPECT_FALSE(reader.DoesTileExist(east));
+  EXPECT_EQ(reader.GetTileSet(west.level()), std::unordered_set<GraphId>{west});
+
+  // the levels above are there as a whole
+  for (const auto& tile : GraphReader(map.config.get_child("mjolnir")).GetTileSet()) {
+    if (tile.level() < west.level()) {
+      EXPECT_NE(reader.GetGraphTile(tile), nullptr);
+    }
+  }
+}
+
+TEST_F(TileShard, Crossings) {
+  auto config = map.config;
+  config.put("mjolnir.shard.tiles", "test/data/gurka_tile_shard/shard.txt");
+  GraphReader reader(config.get_child("mjolnir"));
+  auto shard = tile_shard_t::get_instance("test/data/gurka_tile_shard/shard.txt");
+
+  // the road leaves the shard eastwards
+  const auto crossings = shard->Crossings(reader);
+  ASSERT_EQ(crossings.size(), 1);
+  EXPECT_EQ(crossings.front().edge.Tile_Base(), west);
+  EXPECT_EQ(crossings.front().node.Tile_Base(), east);
+  EXPECT_FALSE(shard->Contains(crossings.front().node));
+
+  // the shard of the origin reaches the boundary node, the shard of the destination goes on from
+  // it and from another node which the origin doesn't reach
+  const GraphId elsewhere(east.tileid(), east.level(), 1000);
+  const auto stitched = tile_shard_t::Stitch({{crossings.front().node, 10.f}},
+                                             {{crossings.front().node, 5.f}, {elsewhere, 1.f}});
+  EXPECT_EQ(stitched.first, crossings.front().node);
+  EXPECT_FLOAT_EQ(stitched.second, 15.f);
+}
+
+TEST(TileShardStitch, PicksTheCheapestNode) {
+  const GraphId a(1, 2, 0), b(1, 2, 1), c(2, 2, 0);
+  const auto stitched = tile_shard_t::Stitch({{a, 10.f}, {b, 3.f}, {c, 1.f}}, {{a, 1.f}, {b, 7.f}});
+  EXPECT_EQ(stitched.first, a);
+  EXPECT_FLOAT_EQ(stitched.second, 11.f);
+
+  // no common node, no route
+  EXPECT_FALSE(tile_shard_t::Stitch({{a, 1.f}}, {{c, 1.f}}).first.Is_Valid());
+  EXPECT_FALSE(tile_shard_t::Stitch({}, {}).first.Is_Valid());
+}
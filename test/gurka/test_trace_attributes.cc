@@ -116,3 +116,46 @@ TEST(Standalone, InterpolatedPoints) {
   ASSERT_EQ(result_doc["matched_points"][4]["edge_index"].GetInt(), 1);
   ASSERT_EQ(result_doc["matched_points"][5]["edge_index"].GetInt(), 1);
 }
+
+TEST(Standalone, ShapeOnlyAttributes) {
+  const std::string ascii_map = R"(
+          E
+          |
+    A-1-2-B-3-4-C
+          |
+          D
+         )";
+
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}, {"name", "Main Street"}}},
+                            {"BC", {{"highway", "primary"}, {"name", "Main Street"}}},
+                            {"DBE", {{"highway", "residential"}, {"name", "Side Street"}}}};
+
+  const double gridsize = 10;
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/shape_only_attributes");
+
+  // only the shape, none of the edges, signs or intersecting edges are looked up
+  auto api = gurka::do_action(valhalla::Options::trace_attributes, map, {"1", "2", "3", "4"},
+                              "auto",
+                              {{"/filters/action", "include"}, {"/filters/attributes/0", "shape"}},
+                              {}, nullptr, "via");
+  ASSERT_EQ(api.trip().routes(0).legs_size(), 1);
+  const auto& leg = api.trip().routes(0).legs(0);
+  EXPECT_FALSE(leg.shape().empty());
+  ASSERT_EQ(leg.node_size(), 3);
+  for (const auto& node : leg.node()) {
+    EXPECT_EQ(node.intersecting_edge_size(), 0);
+    EXPECT_EQ(node.edge().name_size(), 0);
+  }
+
+  // asking for an intersecting edge attribute brings them back
+  api = gurka::do_action(valhalla::Options::trace_attributes, map, {"1", "2", "3", "4"}, "auto",
+                         {{"/filters/action", "include"},
+                          {"/filters/attributes/0", "shape"},
+                          {"/filters/attributes/1", "node.intersecting_edge.use"},
+                          {"/filters/attributes/2", "edge.names"}},
+                         {}, nullptr, "via");
+  const auto& full_leg = api.trip().routes(0).legs(0);
+  EXPECT_EQ(full_leg.node(1).intersecting_edge_size(), 2);
+  EXPECT_EQ(full_leg.node(1).edge().name(0).value(), "Main Street");
+}
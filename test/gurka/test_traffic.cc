@@ -6,6 +6,7 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <sys/mman.h>
@@ -143,6 +144,46 @@ TEST(Traffic, BasicUpdates) {
   }
 }
 
+TEST(Traffic, PollUpdates) {
+  const std::string ascii_map = R"(
+    A----B----C
+  )";
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}}}, {"BC", {{"highway", "primary"}}}};
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  std::string tile_dir = "test/data/traffic_pollupdates";
+  auto map = gurka::buildtiles(layout, ways, {}, {}, tile_dir);
+  map.config.put("mjolnir.traffic_extract", tile_dir + "/traffic.tar");
+  test::build_live_traffic_data(map.config);
+
+  auto reader = test::make_clean_graphreader(map.config.get_child("mjolnir"));
+  std::vector<baldr::GraphId> observed;
+  reader->AddTrafficObserver(
+      [&observed](const std::vector<baldr::GraphId>& tile_ids) { observed = tile_ids; });
+
+  // the first poll only looks at where the tiles are at
+  EXPECT_TRUE(reader->PollTrafficUpdates().empty());
+  auto tile_id = std::get<0>(gurka::findEdgeByNodes(*reader, map.nodes, "A", "B")).Tile_Base();
+  EXPECT_EQ(reader->GetTrafficGeneration(tile_id), 0);
+
+  // every tile gets a new generation once its speeds are written
+  test::customize_live_traffic_data(map.config, [](baldr::GraphReader&, baldr::TrafficTile&, int,
+                                                   baldr::TrafficSpeed* current) {
+    current->overall_encoded_speed = 24 >> 1;
+    current->encoded_speed1 = 24 >> 1;
+    current->breakpoint1 = 255;
+  });
+  EXPECT_EQ(reader->GetTrafficGeneration(tile_id), 1);
+  auto updated = reader->PollTrafficUpdates();
+  ASSERT_FALSE(updated.empty());
+  EXPECT_NE(std::find(updated.begin(), updated.end(), tile_id), updated.end());
+  EXPECT_EQ(observed, updated);
+
+  // nothing changed since
+  observed.clear();
+  EXPECT_TRUE(reader->PollTrafficUpdates().empty());
+  EXPECT_TRUE(observed.empty());
+}
+
 TEST(Traffic, CutGeoms) {
 
   const std::string ascii_map = R"(
@@ -221,6 +221,27 @@ TEST(HttpTiles, test_graphreader_multiple_threads) {
   test_graphreader_tile_download(8, 2, 4);
 }
 
+TEST(HttpTiles, test_batch_download) {
+  using namespace baldr;
+
+  TestTileDownloadData params;
+  curl_tile_getter_t tile_getter(1, "", params.is_gzipped_tile);
+  // twice to go over the connections kept alive by the first batch
+  for (int i = 0; i < 2; ++i) {
+    auto tiles = GraphTile::CacheTileURLs(params.full_tile_url_pattern, params.test_tile_ids,
+                                          &tile_getter, "");
+    ASSERT_EQ(tiles.size(), params.test_tile_ids.size());
+    for (size_t j = 0; j < tiles.size(); ++j) {
+      if (params.test_tile_ids[j] == params.get_nonexistent_tile_id()) {
+        EXPECT_FALSE(tiles[j]) << "Expected no tile";
+      } else {
+        ASSERT_TRUE(tiles[j]);
+        EXPECT_EQ(tiles[j]->id(), params.test_tile_ids[j]);
+      }
+    }
+  }
+}
+
 TEST(HttpTiles, test_interrupt) {
   using namespace baldr;
 
@@ -2,7 +2,9 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -58,6 +60,45 @@ TEST(UnorderedIdTable, SerializeDeserialize) {
   EXPECT_EQ(a, b);
 }
 
+TEST(UnorderedIdTable, LargeIdsOnlyAllocateTheirPages) {
+  // ids far beyond the count of nodes only cost the pages they are in
+  UnorderedIdTable t;
+  const uint64_t base = 12000000000;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    t.set(base + i);
+  }
+  t.set(base * 100);
+  EXPECT_TRUE(t.get(base));
+  EXPECT_TRUE(t.get(base + 999));
+  EXPECT_FALSE(t.get(base + 1000));
+  EXPECT_TRUE(t.get(base * 100));
+  EXPECT_FALSE(t.get(base * 100 + 1));
+  EXPECT_LE(t.page_count(), 4);
+}
+
+TEST(UnorderedIdTable, ConcurrentSetGet) {
+  // threads setting interleaved ids which share pages
+  UnorderedIdTable t;
+  const uint64_t threads = 8, per_thread = 20000;
+  std::vector<std::thread> pool;
+  for (uint64_t i = 0; i < threads; ++i) {
+    pool.emplace_back([&t, i, threads, per_thread]() {
+      for (uint64_t j = 0; j < per_thread; ++j) {
+        auto id = (j * threads + i) * 3;
+        t.set(id);
+        EXPECT_TRUE(t.get(id));
+      }
+    });
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  for (uint64_t id = 0; id < threads * per_thread * 3; ++id) {
+    EXPECT_EQ(t.get(id), id % 3 == 0);
+  }
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
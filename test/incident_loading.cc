@@ -36,6 +36,7 @@ struct testable_singleton : public incident_singleton_t {
   }
 
   // this stuff is all static and protected here we make it public so we can test it
+  using incident_singleton_t::publish;
   using incident_singleton_t::read_tile;
   using incident_singleton_t::state_t;
   using incident_singleton_t::update_tile;
@@ -105,6 +106,34 @@ TEST_F(incident_loading, update_tile) {
   ASSERT_TRUE(state->cache.find(baldr::GraphId(0))->second == nullptr) << " tile should be null";
 }
 
+TEST_F(incident_loading, publish) {
+  std::shared_ptr<testable_singleton::state_t> state{new testable_singleton::state_t{}};
+  std::shared_ptr<const IncidentsTile> tile{new IncidentsTile()};
+  ASSERT_TRUE(testable_singleton::update_tile(state, baldr::GraphId(0), std::move(tile)));
+  ASSERT_TRUE(testable_singleton::update_tile(state, baldr::GraphId(1), {}));
+  ASSERT_FALSE(state->snapshot) << " nothing should be visible before publishing";
+
+  // only the tiles with incidents make it into the snapshot
+  testable_singleton::publish(state);
+  auto snapshot = state->snapshot;
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(snapshot->size(), 1);
+  EXPECT_TRUE(snapshot->count(baldr::GraphId(0)));
+
+  // readers holding on to a snapshot dont see later changes until the next publish
+  ASSERT_TRUE(testable_singleton::update_tile(state, baldr::GraphId(0), {}));
+  EXPECT_TRUE(snapshot->find(baldr::GraphId(0))->second);
+  testable_singleton::publish(state);
+  EXPECT_TRUE(state->snapshot->empty());
+  EXPECT_EQ(snapshot->size(), 1);
+
+  // in lock free mode readers use the cache directly
+  state->lock_free.store(true);
+  state->snapshot.reset();
+  testable_singleton::publish(state);
+  EXPECT_FALSE(state->snapshot);
+}
+
 TEST_F(incident_loading, disabled) {
   // check that it bails early
   boost::property_tree::ptree config;
@@ -304,6 +333,59 @@ TEST_F(incident_loading, watch) {
   }
 }
 
+TEST_F(incident_loading, watch_log_slots) {
+  auto log_path = scratch_dir + "log";
+  boost::property_tree::ptree config;
+  config.put("incident_log", log_path);
+  config.put("incident_max_loading_latency", 0);
+
+  // two tiles with incidents on disk
+  baldr::GraphId snake_eyes{11, 1, 0}, box_cars{66, 2, 0};
+  IncidentsTile tile;
+  auto* loc = tile.mutable_locations()->Add();
+  loc->set_edge_index(3);
+  loc->set_start_offset(0);
+  loc->set_end_offset(1);
+  for (const auto& tile_id : {snake_eyes, box_cars}) {
+    auto name = scratch_dir + baldr::GraphTile::FileSuffix(tile_id, ".pbf");
+    ASSERT_TRUE(filesystem::create_directories(filesystem::path(name).parent_path()));
+    std::ofstream f(name, std::ofstream::out | std::ofstream::binary);
+    f << tile.SerializeAsString();
+  }
+
+  // the same tile is in two slots of the log, the changes are old so only changed slots are read
+  midgard::sequence<uint64_t> log(log_path, true, 1);
+  const uint64_t old_time = static_cast<uint64_t>(time(nullptr)) - 3600;
+  log.push_back(snake_eyes | (old_time << 25));
+  log.push_back(snake_eyes | (old_time << 25));
+  log.flush();
+
+  std::shared_ptr<testable_singleton::state_t> state{new testable_singleton::state_t{}};
+  testable_singleton::watch(config, {}, state, [&](size_t i) -> bool {
+    switch (i) {
+      case 1:
+        EXPECT_TRUE(state->cache[snake_eyes]) << " the first scan reads everything in the log";
+        // one slot moves to the other tile, the first tile is still in the other slot
+        log[1] = box_cars | (old_time << 25);
+        log.flush();
+        return false;
+      case 2:
+        EXPECT_TRUE(state->cache[snake_eyes]) << " still in a slot of the log";
+        EXPECT_TRUE(state->cache[box_cars]) << " a changed slot is read even if its old";
+        // now the other slot moves too
+        log[0] = box_cars | (old_time << 25);
+        log.flush();
+        return false;
+      case 3:
+        EXPECT_FALSE(state->cache[snake_eyes]) << " no slot holds it any more";
+        EXPECT_TRUE(state->cache[box_cars]) << " should still be loaded";
+        return true;
+      default:
+        throw std::logic_error("This code should never be reached");
+    }
+  });
+}
+
 TEST_F(incident_loading, constructor) {
   boost::property_tree::ptree config;
   config.put("incident_max_loading_latency", 1);
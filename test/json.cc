@@ -74,6 +74,42 @@ TEST(JSON, Serialize) {
   EXPECT_EQ(res, ans) << "Wrong json";
 }
 
+std::string to_string(const valhalla::baldr::json::Value& value) {
+  std::stringstream ss;
+  valhalla::baldr::json::applyOutputVisitor(ss, value);
+  return ss.str();
+}
+
+TEST(JSON, FixedPrecision) {
+  using valhalla::baldr::json::fixed_t;
+  EXPECT_EQ(to_string(fixed_t{40.744377, 3}), "40.744");
+  EXPECT_EQ(to_string(fixed_t{-73.990433, 6}), "-73.990433");
+  EXPECT_EQ(to_string(fixed_t{307.5, 0}), "308");
+  EXPECT_EQ(to_string(fixed_t{12.0, 2}), "12.00");
+  EXPECT_EQ(to_string(fixed_t{0.05, 1}), "0.1");
+  EXPECT_EQ(to_string(fixed_t{0.125, 2}), "0.12");
+  EXPECT_EQ(to_string(fixed_t{-0.0001, 3}), "-0.000");
+  EXPECT_EQ(to_string(fixed_t{1e30, 2}), "1000000000000000019884624838656.00");
+  EXPECT_EQ(to_string(fixed_t{INFINITY, 2}), "\"inf\"");
+
+  // the same as the stream would have formatted them
+  for (double value = -1000.0; value < 1000.0; value += 0.0123) {
+    for (size_t precision : {0, 1, 3, 6}) {
+      std::stringstream expected;
+      expected << std::setprecision(precision) << std::fixed << value;
+      EXPECT_EQ(to_string(fixed_t{value, precision}), expected.str());
+    }
+  }
+}
+
+TEST(JSON, ShortestPrecision) {
+  using valhalla::baldr::json::float_t;
+  EXPECT_EQ(to_string(float_t{40.744377}), "40.7444");
+  EXPECT_EQ(to_string(float_t{12.0}), "12");
+  EXPECT_EQ(to_string(float_t{0.0001}), "0.0001");
+  EXPECT_EQ(to_string(float_t{1234567.0}), "1.23457e+06");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
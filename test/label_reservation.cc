@@ -0,0 +1,79 @@
+#include "thor/label_reservation.h"
+
+#include "test.h"
+
+using namespace valhalla::thor;
+using valhalla::sif::travel_mode_t;
+
+namespace {
+
+TEST(LabelReservation, FallbackDuringWarmup) {
+  LabelReservation reservation;
+  for (uint64_t i = 0; i < LabelReservation::kWarmupSearches; ++i) {
+    EXPECT_EQ(reservation.Estimate(travel_mode_t::kDrive, 9000.f, 50000, 1000000), 50000);
+    reservation.Record(10000);
+  }
+  EXPECT_EQ(reservation.stats(travel_mode_t::kDrive).searches, LabelReservation::kWarmupSearches);
+  EXPECT_DOUBLE_EQ(reservation.stats(travel_mode_t::kDrive).labels_per_km, 1000.);
+
+  // warmed up the estimate follows the distance, 1000 labels per km for 19 km plus headroom
+  EXPECT_EQ(reservation.Estimate(travel_mode_t::kDrive, 18000.f, 50000, 1000000), 23750);
+}
+
+TEST(LabelReservation, Clamped) {
+  LabelReservation reservation;
+  for (uint64_t i = 0; i < LabelReservation::kWarmupSearches; ++i) {
+    reservation.Estimate(travel_mode_t::kDrive, 0.f, 50000, 1000000);
+    reservation.Record(100);
+  }
+  EXPECT_EQ(reservation.Estimate(travel_mode_t::kDrive, 0.f, 50000, 1000000),
+            LabelReservation::kMinReservation);
+  EXPECT_EQ(reservation.Estimate(travel_mode_t::kDrive, 1e9f, 50000, 1000000), 1000000);
+  // the ceiling wins over the minimum
+  EXPECT_EQ(reservation.Estimate(travel_mode_t::kDrive, 0.f, 50000, 100), 100);
+}
+
+TEST(LabelReservation, ModesAreSeparate) {
+  LabelReservation reservation;
+  reservation.Estimate(travel_mode_t::kPedestrian, 1000.f, 5000, 1000000);
+  reservation.Record(4000);
+  EXPECT_EQ(reservation.stats(travel_mode_t::kPedestrian).searches, 1);
+  EXPECT_DOUBLE_EQ(reservation.stats(travel_mode_t::kPedestrian).labels_per_km, 2000.);
+  EXPECT_EQ(reservation.stats(travel_mode_t::kDrive).searches, 0);
+}
+
+TEST(LabelReservation, RecordedOncePerEstimate) {
+  LabelReservation reservation;
+  // nothing was estimated yet
+  reservation.Record(4000);
+  EXPECT_EQ(reservation.stats(travel_mode_t::kDrive).searches, 0);
+
+  // a search without labels is left out
+  reservation.Estimate(travel_mode_t::kDrive, 1000.f, 5000, 1000000);
+  reservation.Record(0);
+  EXPECT_EQ(reservation.stats(travel_mode_t::kDrive).searches, 0);
+
+  // clearing twice only counts the search once
+  reservation.Record(4000);
+  reservation.Record(4000);
+  EXPECT_EQ(reservation.stats(travel_mode_t::kDrive).searches, 1);
+}
+
+TEST(LabelReservation, MovingAverage) {
+  LabelReservation reservation;
+  for (uint64_t i = 0; i < LabelReservation::kWarmupSearches; ++i) {
+    reservation.Estimate(travel_mode_t::kBicycle, 0.f, 5000, 1000000);
+    reservation.Record(800);
+  }
+  // past the warmup a search moves the average by an eighth of the difference
+  reservation.Estimate(travel_mode_t::kBicycle, 0.f, 5000, 1000000);
+  reservation.Record(1600);
+  EXPECT_DOUBLE_EQ(reservation.stats(travel_mode_t::kBicycle).labels_per_km, 900.);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
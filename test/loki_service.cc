@@ -1,5 +1,6 @@
 #include "test.h"
 #include <cstdint>
+#include <limits>
 
 #include "baldr/rapidjson_utils.h"
 #include "midgard/logging.h"
@@ -101,7 +102,7 @@ const std::vector<std::pair<uint16_t, std::string>>
          R"(","tileset_last_modified":0,"available_actions":["status","centroid","expansion","transit_available","trace_attributes","trace_route","isochrone","optimized_route","sources_to_targets","height","route","locate"]})"},
         {200,
          R"({"version":")" VALHALLA_VERSION
-         R"(","tileset_last_modified":0,"available_actions":["status","centroid","expansion","transit_available","trace_attributes","trace_route","isochrone","optimized_route","sources_to_targets","height","route","locate"],"has_tiles":false,"has_admins":false,"has_timezones":false,"has_live_traffic":false,"has_transit_tiles":false,"bbox":{"features":[],"type":"FeatureCollection"}})"},
+         R"(","tileset_last_modified":0,"available_actions":["status","centroid","expansion","transit_available","trace_attributes","trace_route","isochrone","optimized_route","sources_to_targets","height","route","locate"],"has_tiles":false,"has_admins":false,"has_timezones":false,"has_live_traffic":false,"has_transit_tiles":false,"bbox":{"features":[],"type":"FeatureCollection"},"counters":[{"service":"loki","tile_cache":{"hits":0,"misses":0,"evictions":0,"tiles_loaded":0,"bytes_loaded":0,"load_ms":0.0}},{"service":"thor","tile_cache":{"hits":0,"misses":0,"evictions":0,"tiles_loaded":0,"bytes_loaded":0,"load_ms":0.0},"search":{"searches":0,"labels":0,"hierarchy_pruned":0,"queue_redistributions":0}}]})"},
         {405,
          R"({"error_code":101,"error":"Try a POST or GET request instead","status_code":405,"status":"Method Not Allowed"})"},
         {405,
@@ -595,6 +596,44 @@ TEST(LokiService, test_hierarchy_warning) {
   }
 }
 
+TEST(LokiService, test_deadline) {
+  auto cfg = make_config();
+  loki::loki_worker_t worker(cfg);
+  int interrupted = 0;
+  const std::function<void()> interrupt = [&interrupted]() { ++interrupted; };
+
+  // without a deadline the interrupt is left as it is
+  Api request;
+  EXPECT_EQ(worker.watch_deadline(request, &interrupt, 175), &interrupt);
+  EXPECT_EQ(request.options().deadline(), 0u);
+
+  // before the deadline the wrapped interrupt only calls the one it wraps
+  request.mutable_options()->set_deadline(std::numeric_limits<uint64_t>::max());
+  const auto* deadline_interrupt = worker.watch_deadline(request, &interrupt, 175);
+  ASSERT_NE(deadline_interrupt, nullptr);
+  EXPECT_NE(deadline_interrupt, &interrupt);
+  EXPECT_NO_THROW((*deadline_interrupt)());
+  EXPECT_EQ(interrupted, 1);
+
+  // once the deadline has passed the request is not even started
+  request.mutable_options()->set_deadline(1);
+  try {
+    worker.watch_deadline(request, &interrupt, 175);
+    FAIL() << "A request past its deadline should have been refused";
+  } catch (const valhalla_exception_t& e) {
+    EXPECT_EQ(e.code, 175);
+    EXPECT_EQ(e.http_code, 504);
+  }
+
+  // the service timeout is the deadline of requests without an earlier one
+  cfg.put("httpd.service.timeout_seconds", 60);
+  loki::loki_worker_t timeout_worker(cfg);
+  request.mutable_options()->set_deadline(std::numeric_limits<uint64_t>::max());
+  timeout_worker.watch_deadline(request, nullptr, 175);
+  EXPECT_LT(request.options().deadline(), std::numeric_limits<uint64_t>::max());
+  EXPECT_GT(request.options().deadline(), 60000u);
+}
+
 } // namespace
 
 class LokiServiceEnv : public ::testing::Environment {
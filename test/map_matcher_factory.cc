@@ -181,6 +181,56 @@ TEST(MapMatcherFactory, TestMapMatcher) {
   delete pedestrian_matcher;
 }
 
+TEST(MapMatcherFactory, TestCandidateGridCache) {
+  meili::CandidateGridCache cache(2);
+  const midgard::AABB2<midgard::PointLL> bbox({0, 0}, {1, 1});
+  auto grid = std::make_shared<const meili::CandidateGridCache::grid_t>(bbox, 0.1f, 0.1f);
+
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), nullptr);
+  EXPECT_EQ(cache.Put(1, 0.1f, 0.1f, grid), grid);
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), grid);
+  // grids of another cell size are kept apart
+  EXPECT_EQ(cache.Get(1, 0.2f, 0.2f), nullptr);
+
+  // the first grid put for a key wins
+  auto other = std::make_shared<const meili::CandidateGridCache::grid_t>(bbox, 0.1f, 0.1f);
+  EXPECT_EQ(cache.Put(1, 0.1f, 0.1f, other), grid);
+  EXPECT_EQ(cache.size(), 1);
+
+  // going over the limit starts over but the handed out grids stay valid
+  cache.Put(2, 0.1f, 0.1f, other);
+  cache.Put(3, 0.1f, 0.1f, other);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), nullptr);
+  EXPECT_EQ(grid->bbox(), bbox);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(MapMatcherFactory, TestSharedGridCache) {
+  auto root = test::make_config(VALHALLA_SOURCE_DIR "test/traffic_matcher_tiles");
+  const midgard::PointLL point(-76.385076, 40.546115);
+  const auto query = [&point](meili::MapMatcherFactory& factory) {
+    return factory.candidatequery().Query(point, baldr::Location::StopType::BREAK, 50 * 50);
+  };
+  meili::MapMatcherFactory factory(root);
+  const auto expected = query(factory);
+  ASSERT_FALSE(expected.empty());
+
+  // queries on the shared cache find what a query of their own finds
+  root.put("meili.grid.shared_cache", true);
+  meili::MapMatcherFactory first(root), second(root);
+  EXPECT_NE(&first.candidatequery(), &second.candidatequery());
+  for (auto* shared : {&first, &second, &first}) {
+    const auto candidates = query(*shared);
+    ASSERT_EQ(candidates.size(), expected.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      EXPECT_EQ(candidates[i].edges.size(), expected[i].edges.size());
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -6,6 +6,7 @@
 
 #include "baldr/json.h"
 #include "loki/worker.h"
+#include "meili/map_matcher_factory.h"
 #include "midgard/distanceapproximator.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
@@ -1505,6 +1506,232 @@ TEST(Mapmatch, openlr_parameter_falsy_native_api) {
     EXPECT_THROW(response.get_child("trip.linear_references"), std::runtime_error);
   }
 }
+
+TEST(Mapmatch, online_matches_offline) {
+  // get a trace from a route through utrecht
+  tyr::actor_t actor(conf, true);
+  auto route = test::json_to_pt(actor.route(
+      R"({"costing":"auto","locations":[{"lat":52.0795,"lon":5.0955},{"lat":52.0965,"lon":5.1285}]})"));
+  auto shape = midgard::decode<std::vector<PointLL>>(
+      route.get_child("trip.legs").front().second.get<std::string>("shape"));
+  shape = midgard::resample_spherical_polyline(shape, 15);
+  std::vector<meili::Measurement> measurements;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    measurements.emplace_back(shape[i], 5.f, 15.f, 1500000000 + i * 2);
+  }
+  ASSERT_GT(measurements.size(), 100);
+
+  Options options;
+  options.set_costing_type(Costing::auto_);
+  rapidjson::Document doc;
+  doc.SetObject();
+  sif::ParseCosting(doc, "/costing_options", options);
+
+  // a small lag forces the window to move on even where the paths dont converge
+  for (const auto& max_lag : {"256", "8"}) {
+    auto lag_conf = conf;
+    lag_conf.put("meili.default.max_online_lag", max_lag);
+    meili::MapMatcherFactory factory(lag_conf);
+    std::shared_ptr<meili::MapMatcher> matcher(factory.Create(options));
+    const auto offline = matcher->OfflineMatch(measurements).front().results;
+
+    // feed it in chunks and make sure the results come out as we go
+    matcher->Clear();
+    std::vector<meili::MatchResult> online;
+    for (size_t i = 0; i < measurements.size(); i += 10) {
+      std::vector<meili::Measurement> chunk(measurements.begin() + i,
+                                            measurements.begin() +
+                                                std::min(i + 10, measurements.size()));
+      auto results = matcher->OnlineMatch(chunk);
+      online.insert(online.end(), results.begin(), results.end());
+    }
+    EXPECT_GT(online.size(), measurements.size() / 2) << "Results should be final before the end";
+    auto results = matcher->FinishOnlineMatch();
+    online.insert(online.end(), results.begin(), results.end());
+    EXPECT_EQ(matcher->state_container().size(), 0);
+
+    // restarting from the converged states should find the same path, settling early might not
+    ASSERT_EQ(online.size(), offline.size());
+    if (std::string(max_lag) != "256")
+      continue;
+    for (size_t i = 0; i < online.size(); ++i) {
+      EXPECT_EQ(online[i].edgeid, offline[i].edgeid) << "Result " << i << " differs";
+      EXPECT_EQ(online[i].HasState(), offline[i].HasState()) << "Result " << i << " differs";
+    }
+  }
+}
+
+TEST(Mapmatch, parts_match_like_the_whole) {
+  // a trace through utrecht with a gap in the middle that no route can cross
+  auto break_conf = conf;
+  break_conf.put("meili.default.breakage_distance", 300);
+  tyr::actor_t actor(break_conf, true);
+  auto route = test::json_to_pt(actor.route(
+      R"({"costing":"auto","locations":[{"lat":52.0795,"lon":5.0955},{"lat":52.0965,"lon":5.1285}]})"));
+  auto shape = midgard::decode<std::vector<PointLL>>(
+      route.get_child("trip.legs").front().second.get<std::string>("shape"));
+  shape = midgard::resample_spherical_polyline(shape, 15);
+  ASSERT_GT(shape.size(), 200);
+  const auto gap = shape.size() / 2 - 50;
+  shape.erase(shape.begin() + gap, shape.begin() + gap + 100);
+  std::vector<meili::Measurement> measurements;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    measurements.emplace_back(shape[i], 5.f, 15.f, 1500000000 + i * 2);
+  }
+
+  Options options;
+  options.set_costing_type(Costing::auto_);
+  rapidjson::Document doc;
+  doc.SetObject();
+  sif::ParseCosting(doc, "/costing_options", options);
+  meili::MapMatcherFactory factory(break_conf);
+  std::shared_ptr<meili::MapMatcher> matcher(factory.Create(options));
+
+  // the trace is cut at the gap
+  const auto firsts = meili::FindBreakages(matcher->config(), measurements);
+  ASSERT_EQ(firsts.size(), 2);
+  EXPECT_EQ(firsts.back(), gap);
+
+  // and matching the parts gives what matching the whole trace gives
+  const auto whole = std::move(matcher->OfflineMatch(measurements).front());
+  std::vector<meili::MatchResults> parts;
+  parts.emplace_back(std::move(matcher->OfflineMatch({measurements.begin(),
+                                                      measurements.begin() + firsts.back()})
+                                   .front()));
+  parts.emplace_back(std::move(
+      matcher->OfflineMatch({measurements.begin() + firsts.back(), measurements.end()}).front()));
+  const auto joined = meili::JoinMatchResults(std::move(parts));
+  ASSERT_EQ(joined.results.size(), whole.results.size());
+  for (size_t i = 0; i < joined.results.size(); ++i) {
+    EXPECT_EQ(joined.results[i].edgeid, whole.results[i].edgeid) << "Result " << i << " differs";
+    EXPECT_EQ(joined.results[i].HasState(), whole.results[i].HasState())
+        << "Result " << i << " differs";
+    EXPECT_EQ(joined.results[i].ends_discontinuity, whole.results[i].ends_discontinuity);
+    EXPECT_EQ(joined.results[i].begins_discontinuity, whole.results[i].begins_discontinuity);
+  }
+  ASSERT_EQ(joined.segments.size(), whole.segments.size());
+  for (size_t i = 0; i < joined.segments.size(); ++i) {
+    EXPECT_EQ(joined.segments[i].edgeid, whole.segments[i].edgeid) << "Segment " << i << " differs";
+    EXPECT_EQ(joined.segments[i].first_match_idx, whole.segments[i].first_match_idx);
+    EXPECT_EQ(joined.segments[i].last_match_idx, whole.segments[i].last_match_idx);
+    EXPECT_EQ(joined.segments[i].discontinuity, whole.segments[i].discontinuity);
+  }
+  EXPECT_NEAR(joined.score, whole.score, whole.score * 1e-6);
+
+  // the service matches the parts on its leg workers and gets the same answer
+  std::string request = R"({"costing":"auto","shape_match":"map_snap","shape":[)";
+  for (const auto& ll : shape) {
+    request += R"({"lon":)" + std::to_string(ll.lng()) + R"(,"lat":)" + std::to_string(ll.lat()) +
+               "},";
+  }
+  request.back() = ']';
+  request += "}";
+  auto parallel_conf = break_conf;
+  parallel_conf.put("thor.optimized_route_threads", 3);
+  tyr::actor_t parallel_actor(parallel_conf, true);
+  auto serial = test::json_to_pt(actor.trace_attributes(request));
+  auto parallel = test::json_to_pt(parallel_actor.trace_attributes(request));
+  const auto& serial_points = serial.get_child("matched_points");
+  const auto& parallel_points = parallel.get_child("matched_points");
+  ASSERT_EQ(serial_points.size(), parallel_points.size());
+  for (auto s = serial_points.begin(), p = parallel_points.begin(); s != serial_points.end();
+       ++s, ++p) {
+    EXPECT_EQ(s->second.get<std::string>("type"), p->second.get<std::string>("type"));
+    EXPECT_EQ(s->second.get<uint64_t>("edge_index"), p->second.get<uint64_t>("edge_index"));
+  }
+  ASSERT_EQ(serial.get_child("edges").size(), parallel.get_child("edges").size());
+  for (auto s = serial.get_child("edges").begin(), p = parallel.get_child("edges").begin();
+       s != serial.get_child("edges").end(); ++s, ++p) {
+    EXPECT_EQ(s->second.get<uint64_t>("id"), p->second.get<uint64_t>("id"));
+  }
+}
+
+TEST(Mapmatch, route_cache_builds_trees_the_second_time) {
+  meili::RouteCache cache(3, 500.f);
+  const baldr::GraphId a(1, 0, 1), b(1, 0, 2), c(1, 0, 3);
+  auto tree = [](const baldr::GraphId& edgeid) {
+    auto tree = std::make_shared<meili::RouteTree>();
+    tree->edgeid = edgeid;
+    return tree;
+  };
+
+  // the first time only remembers the edge
+  bool build = true;
+  EXPECT_EQ(cache.find(0, a, build), nullptr);
+  EXPECT_FALSE(build);
+  EXPECT_EQ(cache.size(), 1);
+
+  // the second time asks for the tree which is then kept
+  EXPECT_EQ(cache.find(0, a, build), nullptr);
+  EXPECT_TRUE(build);
+  cache.put(0, tree(a));
+  EXPECT_NE(cache.find(0, a, build), nullptr);
+  EXPECT_FALSE(build);
+  EXPECT_EQ(cache.size(), 1);
+
+  // trees are per costing
+  EXPECT_EQ(cache.find(1, a, build), nullptr);
+  EXPECT_FALSE(build);
+  EXPECT_EQ(cache.size(), 2);
+
+  // and when full the cache starts over
+  EXPECT_EQ(cache.find(0, b, build), nullptr);
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_EQ(cache.find(0, c, build), nullptr);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.find(0, a, build), nullptr);
+  EXPECT_FALSE(build);
+}
+
+TEST(Mapmatch, route_cache_matches_like_the_search) {
+  // a trace through utrecht which is matched over and over, like the run of a bus line
+  tyr::actor_t actor(conf, true);
+  auto route = test::json_to_pt(actor.route(
+      R"({"costing":"auto","locations":[{"lat":52.0795,"lon":5.0955},{"lat":52.0965,"lon":5.1285}]})"));
+  auto shape = midgard::decode<std::vector<PointLL>>(
+      route.get_child("trip.legs").front().second.get<std::string>("shape"));
+  shape = midgard::resample_spherical_polyline(shape, 15);
+  std::vector<meili::Measurement> measurements;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    measurements.emplace_back(shape[i], 5.f, 15.f, 1500000000 + i * 2);
+  }
+
+  Options options;
+  options.set_costing_type(Costing::auto_);
+  rapidjson::Document doc;
+  doc.SetObject();
+  sif::ParseCosting(doc, "/costing_options", options);
+  meili::MapMatcherFactory factory(conf);
+  std::shared_ptr<meili::MapMatcher> matcher(factory.Create(options));
+  const auto expected = std::move(matcher->OfflineMatch(measurements).front());
+  EXPECT_EQ(factory.routecache(), nullptr);
+
+  // the first match remembers the edges, the second builds their trees and the third uses them
+  auto cache_conf = conf;
+  cache_conf.put("meili.route_cache.size", 100000);
+  meili::MapMatcherFactory cache_factory(cache_conf);
+  for (int i = 0; i < 3; ++i) {
+    std::shared_ptr<meili::MapMatcher> cache_matcher(cache_factory.Create(options));
+    const auto match = std::move(cache_matcher->OfflineMatch(measurements).front());
+    ASSERT_EQ(match.results.size(), expected.results.size());
+    for (size_t j = 0; j < match.results.size(); ++j) {
+      EXPECT_EQ(match.results[j].edgeid, expected.results[j].edgeid) << "Result " << j;
+      EXPECT_NEAR(match.results[j].distance_along, expected.results[j].distance_along, 1e-6);
+    }
+    ASSERT_EQ(match.segments.size(), expected.segments.size());
+    for (size_t j = 0; j < match.segments.size(); ++j) {
+      EXPECT_EQ(match.segments[j].edgeid, expected.segments[j].edgeid) << "Segment " << j;
+      EXPECT_NEAR(match.segments[j].source, expected.segments[j].source, 1e-6);
+      EXPECT_NEAR(match.segments[j].target, expected.segments[j].target, 1e-6);
+      EXPECT_EQ(match.segments[j].discontinuity, expected.segments[j].discontinuity);
+    }
+    EXPECT_NEAR(match.score, expected.score, expected.score * 1e-4);
+  }
+
+  // the edges along the way were kept
+  ASSERT_NE(cache_factory.routecache(), nullptr);
+  EXPECT_GT(cache_factory.routecache()->size(), 0);
+}
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -12,7 +12,8 @@ const auto fake_config = test::json_to_pt(R"({
     "mode": "auto",
     "grid": {
       "cache_size": 100500,
-      "size": 100
+      "size": 100,
+      "shared_cache": true
     },
     "default": {
       "beta": 5,
@@ -20,6 +21,7 @@ const auto fake_config = test::json_to_pt(R"({
       "gps_accuracy": 6,
       "interpolation_distance": 5,
       "max_route_distance_factor": 11,
+      "max_online_lag": 32,
       "max_route_time_factor": 10,
       "max_search_radius": 500,
       "search_radius": 10,
@@ -39,6 +41,7 @@ TEST(MapmatchConfig, check_read_all_params) {
   EXPECT_EQ(candiate_search.max_search_radius_meters, 500.f);
   EXPECT_EQ(candiate_search.grid_size, 100);
   EXPECT_EQ(candiate_search.cache_size, 100500);
+  EXPECT_TRUE(candiate_search.shared_grid_cache);
 
   // check transition params
   const auto& transition = config.transition_cost;
@@ -60,6 +63,7 @@ TEST(MapmatchConfig, check_read_all_params) {
   const auto& routing = config.routing;
   EXPECT_EQ(routing.interpolation_distance_meters, 5.f);
   EXPECT_FALSE(routing.is_interpolation_distance_customizable);
+  EXPECT_EQ(routing.max_online_lag, 32);
 }
 
 TEST(MapmatchConfig, validate_candidate_search_params) {
@@ -122,6 +126,10 @@ TEST(MapmatchConfig, validate_routing_params) {
   auto pt = fake_config;
   pt.put<float>("default.interpolation_distance", -1.f);
   EXPECT_THROW(config.Read(pt), std::exception);
+
+  pt = fake_config;
+  pt.put<int>("default.max_online_lag", 0);
+  EXPECT_THROW(config.Read(pt), std::exception);
 }
 
 } // namespace
@@ -5,10 +5,13 @@
 #include <vector>
 
 #include "baldr/rapidjson_utils.h"
+#include "filesystem.h"
 #include "loki/worker.h"
 #include "midgard/logging.h"
 #include "sif/dynamiccost.h"
 #include "thor/costmatrix.h"
+#include "thor/matrix_table.h"
+#include "thor/search_tree_cache.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
 #include "tyr/serializers.h"
@@ -308,6 +311,233 @@ TEST(Matrix, test_timedistancematrix_results_sequence) {
   }
 }
 
+TEST(Matrix, test_timedistancematrix_threads) {
+  // Fewer sources than targets, so this expands forward from the sources
+  const auto test_request_fewer_sources = R"({
+    "sources":[
+      {"lat":52.106337,"lon":5.101728},
+      {"lat":52.111276,"lon":5.089717},
+      {"lat":52.103105,"lon":5.081005}
+    ],
+    "targets":[
+      {"lat":52.106126,"lon":5.101497},
+      {"lat":52.100469,"lon":5.087099},
+      {"lat":52.103105,"lon":5.081005},
+      {"lat":52.094273,"lon":5.075254}
+    ],
+    "costing":"auto"
+  })";
+
+  loki_worker_t loki_worker(config);
+
+  // expected results are the same as `matrix_answers`, but without the last row
+  const std::vector<TimeDistance> expected_results(matrix_answers.begin(),
+                                                   matrix_answers.begin() + 12);
+
+  for (const auto* request_json : {test_request_fewer_sources, test_request}) {
+    Api request;
+    ParseApi(request_json, Options::sources_to_targets, request);
+    loki_worker.matrix(request);
+    thor_worker_t::adjust_scores(*request.mutable_options());
+
+    GraphReader reader(config.get_child("mjolnir"));
+    sif::mode_costing_t mode_costing;
+    mode_costing[0] = CreateSimpleCost(
+        request.options().costings().find(request.options().costing_type())->second);
+
+    // every thread gets its own reader
+    boost::property_tree::ptree thor_config;
+    thor_config.put("matrix_threads", 3);
+    TimeDistanceMatrix timedist_matrix(thor_config);
+    std::vector<std::shared_ptr<GraphReader>> readers;
+    for (int i = 0; i < 2; ++i) {
+      readers.emplace_back(std::make_shared<GraphReader>(config.get_child("mjolnir")));
+    }
+    timedist_matrix.set_thread_readers(readers);
+    EXPECT_EQ(timedist_matrix.thread_count(), 3);
+
+    // run it twice to make sure the workers are cleaned up in between
+    for (int run = 0; run < 2; ++run) {
+      std::vector<TimeDistance> results =
+          timedist_matrix.SourceToTarget(*request.mutable_options()->mutable_sources(),
+                                         *request.mutable_options()->mutable_targets(), reader,
+                                         mode_costing, sif::TravelMode::kDrive, 400000.0);
+      const auto& expected = request_json == test_request ? matrix_answers : expected_results;
+      ASSERT_EQ(results.size(), expected.size());
+      for (uint32_t i = 0; i < results.size(); ++i) {
+        EXPECT_NEAR(results[i].dist, expected[i].dist, kThreshold)
+            << "result " + std::to_string(i) + "'s distance is not equal to" +
+                   " the expected value for the threaded TimeDistMatrix";
+        EXPECT_NEAR(results[i].time, expected[i].time, kThreshold)
+            << "result " + std::to_string(i) +
+                   "'s time is not equal to the expected value for the threaded TimeDistMatrix";
+      }
+      timedist_matrix.clear();
+    }
+  }
+}
+
+TEST(Matrix, test_costmatrix_blocks) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  thor_worker_t::adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] =
+      CreateSimpleCost(request.options().costings().find(request.options().costing_type())->second);
+
+  // blocks of 3 split the 4 sources and 4 targets unevenly, on one thread and on 3 of them
+  for (const uint32_t threads : {1, 3}) {
+    boost::property_tree::ptree thor_config;
+    thor_config.put("costmatrix_block_size", 3);
+    thor_config.put("matrix_threads", threads);
+    CostMatrix cost_matrix(thor_config);
+    std::vector<std::shared_ptr<GraphReader>> readers;
+    for (uint32_t i = 1; i < threads; ++i) {
+      readers.emplace_back(std::make_shared<GraphReader>(config.get_child("mjolnir")));
+    }
+    cost_matrix.set_thread_readers(readers);
+
+    // run it twice to make sure the blocks are cleaned up in between
+    for (int run = 0; run < 2; ++run) {
+      std::vector<TimeDistance> results =
+          cost_matrix.SourceToTarget(*request.mutable_options()->mutable_sources(),
+                                     *request.mutable_options()->mutable_targets(), reader,
+                                     mode_costing, sif::TravelMode::kDrive, 400000.0);
+      ASSERT_EQ(results.size(), matrix_answers.size());
+      for (uint32_t i = 0; i < results.size(); ++i) {
+        EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+            << "result " + std::to_string(i) + "'s distance is not close enough" +
+                   " to expected value for the CostMatrix blocks";
+        EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+            << "result " + std::to_string(i) + "'s time is not close enough" +
+                   " to expected value for the CostMatrix blocks";
+      }
+      cost_matrix.clear();
+    }
+  }
+}
+
+TEST(Matrix, test_costmatrix_parallel_expansion) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  thor_worker_t::adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  sif::mode_costing_t mode_costing;
+  mode_costing[0] =
+      CreateSimpleCost(request.options().costings().find(request.options().costing_type())->second);
+
+  // the searches of the whole matrix on one thread
+  CostMatrix serial_matrix;
+  const auto expected = serial_matrix.SourceToTarget(*request.mutable_options()->mutable_sources(),
+                                                     *request.mutable_options()->mutable_targets(),
+                                                     reader, mode_costing, sif::TravelMode::kDrive,
+                                                     400000.0);
+
+  // and shared out to 3 threads, which has to come out exactly the same
+  boost::property_tree::ptree thor_config;
+  thor_config.put("matrix_threads", 3);
+  thor_config.put("costmatrix_parallel_locations", 1);
+  CostMatrix cost_matrix(thor_config);
+  std::vector<std::shared_ptr<GraphReader>> readers;
+  for (int i = 0; i < 2; ++i) {
+    readers.emplace_back(std::make_shared<GraphReader>(config.get_child("mjolnir")));
+  }
+  cost_matrix.set_thread_readers(readers);
+
+  // run it twice to make sure nothing is left over in between
+  for (int run = 0; run < 2; ++run) {
+    std::vector<TimeDistance> results =
+        cost_matrix.SourceToTarget(*request.mutable_options()->mutable_sources(),
+                                   *request.mutable_options()->mutable_targets(), reader,
+                                   mode_costing, sif::TravelMode::kDrive, 400000.0);
+    ASSERT_EQ(results.size(), expected.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].dist, expected[i].dist)
+          << "result " + std::to_string(i) + "'s distance differs from the serial CostMatrix";
+      EXPECT_EQ(results[i].time, expected[i].time)
+          << "result " + std::to_string(i) + "'s time differs from the serial CostMatrix";
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << "result " + std::to_string(i) + "'s distance is not close enough" +
+                 " to expected value for the parallel CostMatrix";
+    }
+    cost_matrix.clear();
+  }
+}
+
+TEST(Matrix, test_search_tree) {
+  // the fleet moves towards the pickup in between the requests, the last source doesn't move
+  const std::vector<std::string> fleets = {
+      R"({"sources":[{"lat":52.106337,"lon":5.101728},{"lat":52.111276,"lon":5.089717},
+                     {"lat":52.103948,"lon":5.06813}],
+          "targets":[{"lat":52.100469,"lon":5.087099}],"costing":"auto"})",
+      R"({"sources":[{"lat":52.103105,"lon":5.081005},{"lat":52.106126,"lon":5.101497},
+                     {"lat":52.094273,"lon":5.075254},{"lat":52.103948,"lon":5.06813}],
+          "targets":[{"lat":52.100469,"lon":5.087099}],"costing":"auto"})",
+      R"({"sources":[{"lat":52.100469,"lon":5.087099},{"lat":52.111276,"lon":5.089717}],
+          "targets":[{"lat":52.100469,"lon":5.087099}],"costing":"auto"})"};
+
+  loki_worker_t loki_worker(config);
+  GraphReader reader(config.get_child("mjolnir"));
+  std::unique_ptr<SearchTree> tree;
+  size_t labels = 0;
+  for (const auto& fleet : fleets) {
+    Api request;
+    ParseApi(fleet, Options::sources_to_targets, request);
+    loki_worker.matrix(request);
+    thor_worker_t::adjust_scores(*request.mutable_options());
+
+    sif::mode_costing_t mode_costing;
+    mode_costing[0] = CreateSimpleCost(
+        request.options().costings().find(request.options().costing_type())->second);
+    if (!tree) {
+      tree = std::make_unique<SearchTree>(request.options().targets(0), mode_costing[0],
+                                          sif::TravelMode::kDrive, 400000.0, false, reader);
+    }
+
+    // the tree only ever grows and answers what a matrix from scratch does
+    TimeDistanceMatrix timedist_matrix;
+    const auto expected =
+        timedist_matrix.SourceToTarget(*request.mutable_options()->mutable_sources(),
+                                       *request.mutable_options()->mutable_targets(), reader,
+                                       mode_costing, sif::TravelMode::kDrive, 400000.0);
+    const auto results = tree->Query(request.options().sources(), reader);
+    ASSERT_EQ(results.size(), expected.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].dist, expected[i].dist)
+          << "result " + std::to_string(i) + "'s distance differs from the TimeDistanceMatrix";
+      EXPECT_EQ(results[i].time, expected[i].time)
+          << "result " + std::to_string(i) + "'s time differs from the TimeDistanceMatrix";
+    }
+    EXPECT_GE(tree->size(), labels);
+    labels = tree->size();
+  }
+
+  // the cache keeps the most recently used trees for the same target and costing
+  Api request;
+  ParseApi(fleets.front(), Options::sources_to_targets, request);
+  SearchTreeCache cache(1);
+  EXPECT_TRUE(cache.cacheable(request.options()));
+  const auto key = SearchTreeCache::key(request.options());
+  EXPECT_EQ(cache.find(key), nullptr);
+  auto* kept = cache.insert(key, std::move(tree));
+  EXPECT_EQ(cache.find(key), kept);
+  request.mutable_options()->mutable_targets(0)->mutable_ll()->set_lat(52.1);
+  EXPECT_NE(SearchTreeCache::key(request.options()), key);
+  cache.insert(SearchTreeCache::key(request.options()), nullptr);
+  EXPECT_EQ(cache.find(key), nullptr);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_FALSE(SearchTreeCache().cacheable(request.options()));
+}
+
 // TODO: it was commented before. Why?
 TEST(Matrix, DISABLED_test_matrix_osrm) {
   loki_worker_t loki_worker(config);
@@ -499,6 +729,98 @@ TEST(Matrix, slim_matrix) {
   EXPECT_TRUE(json.HasMember("units"));
 }
 
+TEST(Matrix, matrix_table) {
+  const std::string file = "test/data/matrix_table.bin";
+  auto location = [](double lat, double lon) {
+    valhalla::Location l;
+    l.mutable_ll()->set_lat(lat);
+    l.mutable_ll()->set_lng(lon);
+    return l;
+  };
+  const auto a = location(52.1, 5.1), b = location(52.0, 5.2);
+  // b sorts before a so the rows and columns have to be reordered
+  ASSERT_TRUE(MatrixTable::Write(file, 42, 6 * 3600, {MatrixTable::Round(a), MatrixTable::Round(b)},
+                                 std::vector<std::vector<MatrixTable::entry_t>>(
+                                     29, {{0, 0}, {10, 100}, {20, 200}, {0, 0}})));
+  EXPECT_FALSE(MatrixTable::Write(file + ".dup", 42, 0,
+                                  {MatrixTable::Round(a), MatrixTable::Round(a)},
+                                  {{{0, 0}, {1, 1}, {1, 1}, {0, 0}}}));
+
+  auto table = MatrixTable::Map(file);
+  ASSERT_TRUE(table);
+  EXPECT_EQ(table->costing(), 42);
+  EXPECT_EQ(table->bucket_count(), 29);
+  ASSERT_EQ(table->Find(a), 1);
+  ASSERT_EQ(table->Find(b), 0);
+  EXPECT_EQ(table->Find(location(52.1, 5.1000004)), 1) << "Coordinates are kept to a micro degree";
+  EXPECT_EQ(table->Find(location(52.1, 5.100002)), -1);
+  EXPECT_EQ(table->Get(0, 1, 0).time, 10);
+  EXPECT_EQ(table->Get(28, 0, 1).dist, 200);
+
+  // the closest of the slots of the week, 2024-01-01 was a monday
+  EXPECT_EQ(table->Bucket(""), 0);
+  EXPECT_EQ(table->Bucket("2024-01-01T02:59"), 1);
+  EXPECT_EQ(table->Bucket("2024-01-01T03:00"), 2);
+  EXPECT_EQ(table->Bucket("2024-01-03T07:00"), 10);
+  EXPECT_EQ(table->Bucket("2024-01-07T22:00"), 1) << "Late sunday is closest to early monday";
+  EXPECT_EQ(table->Bucket("2024-01-08T00:00"), 1);
+  EXPECT_EQ(table->Bucket("current"), -1);
+
+  ASSERT_TRUE(MatrixTable::Write(file, 42, 0, {MatrixTable::Round(a)}, {{{0, 0}}}));
+  table = MatrixTable::Map(file);
+  ASSERT_TRUE(table);
+  EXPECT_EQ(table->Bucket("2024-01-01T03:00"), -1) << "No departures without slots";
+  filesystem::remove(file);
+}
+
+TEST(Matrix, matrix_table_lookup) {
+  auto request = std::string(test_request);
+  request.insert(request.rfind('}'), R"(,"format":"pbf")");
+  // the one to many searches find the same answers for a pair whichever other locations there are
+  auto search_config = config;
+  search_config.put("thor.source_to_target_algorithm", "timedistancematrix");
+  Api searched;
+  tyr::actor_t(search_config, true).matrix(request, nullptr, &searched);
+  ASSERT_EQ(searched.matrix().times_size(), 16);
+
+  // a table with the first two sources and the first target, the times in it are made up so
+  // it shows whether they were looked up
+  const auto& options = searched.options();
+  const std::string file = "test/data/matrix_table_lookup.bin";
+  std::vector<MatrixTable::entry_t> entries(9, {7, 70});
+  entries[0 * 3 + 2] = {1000, 5000};
+  entries[1 * 3 + 2] = {MatrixTable::kUnreachable, MatrixTable::kUnreachable};
+  ASSERT_TRUE(MatrixTable::Write(file, MatrixTable::Key(options), 0,
+                                 {MatrixTable::Round(options.sources(0)),
+                                  MatrixTable::Round(options.sources(1)),
+                                  MatrixTable::Round(options.targets(0))},
+                                 {entries}));
+
+  auto table_config = search_config;
+  table_config.put("thor.matrix_table", file);
+  Api looked_up;
+  tyr::actor_t(table_config, true).matrix(request, nullptr, &looked_up);
+  const auto& matrix = looked_up.matrix();
+  ASSERT_EQ(matrix.times_size(), 16);
+  EXPECT_EQ(matrix.times(0), 1000);
+  EXPECT_FLOAT_EQ(matrix.distances(0), 5);
+  EXPECT_EQ(matrix.times(4), -1);
+  for (int i = 0; i < 16; ++i) {
+    if (i != 0 && i != 4) {
+      EXPECT_EQ(matrix.times(i), searched.matrix().times(i)) << "The other pairs are searched for";
+      EXPECT_EQ(matrix.distances(i), searched.matrix().distances(i));
+    }
+  }
+
+  // another costing isn't in the table
+  auto pedestrian = request;
+  pedestrian.replace(pedestrian.find(R"("auto")"), 6, R"("pedestrian")");
+  Api other;
+  tyr::actor_t(table_config, true).matrix(pedestrian, nullptr, &other);
+  EXPECT_NE(other.matrix().times(0), 1000);
+  filesystem::remove(file);
+}
+
 int main(int argc, char* argv[]) {
   logging::Configure({{"type", ""}}); // silence logs
   testing::InitGoogleTest(&argc, argv);
@@ -1338,6 +1338,40 @@ TEST(NarrativeDictionary, test_en_US_approach_verbal_alert) {
   validate(us_customary_lengths, kExpectedUsCustomaryLengths);
 }
 
+TEST(NarrativeDictionary, test_phrase_template) {
+  PhraseTagValues values;
+  values.Set(kRelativeDirectionTag, "left");
+  values.Set(kStreetNamesTag, "Main Street");
+
+  // tags are replaced wherever they are and tags without a value are kept
+  std::string instruction;
+  PhraseTemplate("Turn <RELATIVE_DIRECTION> onto <STREET_NAMES>. Continue on <STREET_NAMES>.")
+      .Render(values, instruction);
+  EXPECT_EQ(instruction, "Turn left onto Main Street. Continue on Main Street.");
+  PhraseTemplate("<RELATIVE_DIRECTION> toward <TOWARD_SIGN>").Render(values, instruction);
+  EXPECT_EQ(instruction, "left toward <TOWARD_SIGN>");
+  PhraseTemplate("a < b <c> <STREET_NAMES").Render(values, instruction);
+  EXPECT_EQ(instruction, "a < b <c> <STREET_NAMES");
+
+  // values are not searched for tags
+  values.clear();
+  values.Set(kStreetNamesTag, "<RELATIVE_DIRECTION>");
+  values.Set(kRelativeDirectionTag, "right");
+  PhraseTemplate("<STREET_NAMES>").Render(values, instruction);
+  EXPECT_EQ(instruction, "<RELATIVE_DIRECTION>");
+}
+
+TEST(NarrativeDictionary, test_en_US_templates) {
+  const NarrativeDictionary& dictionary = GetNarrativeDictionary("en-US");
+
+  // every phrase has a template which renders it as is without values
+  std::string instruction;
+  for (const auto& phrase : dictionary.turn_subset.phrases) {
+    dictionary.turn_subset.templates.at(phrase.first).Render({}, instruction);
+    EXPECT_EQ(instruction, phrase.second);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
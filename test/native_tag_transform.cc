@@ -0,0 +1,346 @@
+#include "test.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mjolnir/graph_lua_proc.h"
+#include "mjolnir/luatagtransform.h"
+#include "mjolnir/nativetagtransform.h"
+#include "mjolnir/osmdata.h"
+
+using namespace valhalla;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// values which make the default lua script take its different branches
+const std::vector<std::pair<std::string, std::vector<std::string>>> kWayTags = {
+    {"highway",
+     {"motorway", "motorway_link", "trunk", "primary", "secondary", "tertiary", "residential",
+      "service", "track", "living_street", "footway", "pedestrian", "steps", "path", "cycleway",
+      "bridleway", "construction", "proposed", "platform", "elevator", "busway", "unclassified"}},
+    {"construction", {"primary", "residential", "footway"}},
+    {"route", {"ferry", "shuttle_train", "bicycle"}},
+    {"railway", {"rail", "platform"}},
+    {"access", {"yes", "no", "private", "destination", "psv", "emergency", "permissive", "hov"}},
+    {"vehicle", {"no", "yes"}},
+    {"motor_vehicle", {"no", "yes", "destination", "agricultural"}},
+    {"motorcar", {"no", "yes", "private"}},
+    {"hgv", {"no", "designated", "local", "destination"}},
+    {"bus", {"yes", "no"}},
+    {"taxi", {"yes", "no"}},
+    {"psv", {"yes", "no", "bus"}},
+    {"lanes:psv:forward", {"1"}},
+    {"lanes:psv:backward", {"1", "no"}},
+    {"foot", {"yes", "no", "designated"}},
+    {"pedestrian", {"no"}},
+    {"bicycle", {"yes", "no", "dismount", "designated"}},
+    {"moped", {"no", "yes"}},
+    {"mofa", {"yes"}},
+    {"motorcycle", {"no", "yes"}},
+    {"emergency", {"yes", "no"}},
+    {"service", {"driveway", "alley", "emergency_access", "parking_aisle", "siding"}},
+    {"impassable", {"yes"}},
+    {"oneway", {"yes", "-1", "no", "reversible", "alternating", "1"}},
+    {"oneway:bicycle", {"no", "yes", "-1"}},
+    {"oneway:bus", {"no", "-1"}},
+    {"oneway:psv", {"no", "yes"}},
+    {"oneway:taxi", {"no", "-1"}},
+    {"oneway:moped", {"no", "-1"}},
+    {"oneway:mofa", {"no"}},
+    {"oneway:motorcycle", {"no", "-1"}},
+    {"oneway:foot", {"no", "yes", "-1"}},
+    {"bicycle:backward", {"yes", "no"}},
+    {"bus:backward", {"yes", "designated"}},
+    {"taxi:backward", {"yes"}},
+    {"moped:backward", {"yes"}},
+    {"motorcycle:backward", {"yes"}},
+    {"foot:backward", {"yes"}},
+    {"junction", {"roundabout", "circular"}},
+    {"cycleway", {"lane", "track", "opposite", "opposite_lane", "shared_lane", "crossing"}},
+    {"cycleway:left", {"lane", "opposite_track", "shared_lane"}},
+    {"cycleway:right", {"track", "lane", "opposite"}},
+    {"cycleway:both", {"lane", "no"}},
+    {"cycleway:both:buffer", {"yes"}},
+    {"cycleway:right:buffer", {"yes"}},
+    {"busway", {"lane", "opposite_lane"}},
+    {"busway:left", {"lane"}},
+    {"busway:right", {"lane"}},
+    {"lanes:bus", {"1", "2"}},
+    {"lanes:psv", {"1", "2"}},
+    {"sac_scale", {"hiking", "mountain_hiking"}},
+    {"bicycle_road", {"yes"}},
+    {"motorroad", {"yes"}},
+    {"area", {"yes"}},
+    {"footway", {"sidewalk", "crossing"}},
+    {"conveying", {"yes"}},
+    {"segregated", {"yes", "no"}},
+    {"lit", {"yes", "no", "24/7"}},
+    {"shoulder", {"yes", "right", "left", "no"}},
+    {"shoulder:right", {"yes"}},
+    {"shoulder:left", {"yes"}},
+    {"maxspeed", {"50", "30 mph", "none", "5", "200", "signals", "100;80"}},
+    {"maxspeed:advisory", {"40"}},
+    {"maxspeed:forward", {"60 mph"}},
+    {"maxspeed:hgv", {"80"}},
+    {"wheelchair", {"yes", "no", "limited"}},
+    {"tracktype", {"grade1", "grade3", "grade5"}},
+    {"name", {"Main Street"}},
+    {"ref", {"A1"}},
+    {"unsigned_ref", {"US 1"}},
+    {"lanes", {"2", "4;3", "20", "two"}},
+    {"lanes:forward", {"1"}},
+    {"bridge", {"yes", "viaduct"}},
+    {"tunnel", {"building_passage", "no"}},
+    {"toll", {"yes", "interval"}},
+    {"seasonal", {"winter", "no"}},
+    {"hov", {"designated", "no", "yes", "lane"}},
+    {"hov:lanes", {"designated|designated", "designated|", "|designated"}},
+    {"hov:minimum", {"2", "3", "4"}},
+    {"oneway:conditional", {"yes @ (Mo-Fr 07:00-09:00)"}},
+    {"maxheight", {"3.5", "12'6\"", "2,5 m", "3..35", "default", "0x10", " 4 "}},
+    {"maxheight:physical", {"4.2"}},
+    {"maxwidth", {"2.10", "7 ft"}},
+    {"maxlength", {"12"}},
+    {"maxweight", {"3.5t", "7500 kg", "10 tons", "2000 lbs", "5.25", "12 st", "."}},
+    {"maxaxleload", {"10", "1e1"}},
+    {"maxaxles", {"3", "3.5", "many"}},
+    {"hazmat", {"no", "designated"}},
+    {"hazmat:water", {"no"}},
+    {"hgv:national_network", {"yes"}},
+    {"ncn_ref", {"4"}},
+    {"rcn", {"yes"}},
+    {"lcn_ref", {"7"}},
+    {"mtb", {"yes"}},
+    {"level", {"0;1", "-1"}},
+    {"FIXME", {"check"}},
+    {"source", {"survey"}},
+};
+
+const std::vector<std::pair<std::string, std::vector<std::string>>> kNodeTags = {
+    {"iso:3166_2", {"US-PA", "DE-BY", "US-NYC", "PA", "USPA", "GB-ENG-X", "ABCDEF"}},
+    {"access", {"yes", "no", "private", "psv", "emergency", "destination"}},
+    {"impassable", {"yes"}},
+    {"emergency", {"yes"}},
+    {"service", {"emergency_access"}},
+    {"hov", {"designated", "no"}},
+    {"hov:minimum", {"2"}},
+    {"vehicle", {"no"}},
+    {"foot", {"yes", "no", "crossing"}},
+    {"wheelchair", {"yes", "no"}},
+    {"bicycle", {"yes", "no", "crossing"}},
+    {"hgv", {"yes", "no"}},
+    {"motorcar", {"yes", "no"}},
+    {"motor_vehicle", {"yes", "no"}},
+    {"moped", {"yes", "no"}},
+    {"mofa", {"yes"}},
+    {"motorcycle", {"yes", "no"}},
+    {"bus", {"yes", "no"}},
+    {"taxi", {"yes", "no"}},
+    {"psv", {"yes", "no", "bus", "taxi"}},
+    {"barrier",
+     {"gate", "yes", "lift_gate", "bollard", "block", "sump_buster", "border_control", "toll_booth",
+      "jersey_barrier", "kerb"}},
+    {"bollard", {"rising", "removable"}},
+    {"highway",
+     {"crossing", "traffic_signals", "stop", "give_way", "toll_gantry", "elevator",
+      "motorway_junction"}},
+    {"railway", {"crossing"}},
+    {"footway", {"crossing"}},
+    {"cycleway", {"crossing"}},
+    {"crossing", {"uncontrolled"}},
+    {"payment:cash", {"yes", "no"}},
+    {"payment:coins", {"No"}},
+    {"payment:credit_cards", {"yes", "NO"}},
+    {"entrance", {"yes"}},
+    {"indoor", {"yes"}},
+    {"amenity", {"bicycle_rental"}},
+    {"shop", {"bicycle"}},
+    {"service:bicycle:rental", {"yes"}},
+    {"traffic_signals:direction", {"forward", "backward"}},
+    {"direction", {"both", "forward", "backward", "reverse", "north"}},
+    {"stop", {"all"}},
+    {"give_way", {"yes"}},
+    {"public_transport", {"stop_position"}},
+    {"name", {"Main Square"}},
+    {"junction", {"yes"}},
+    {"reference_point", {"yes"}},
+};
+
+const std::vector<std::pair<std::string, std::vector<std::string>>> kRelationTags = {
+    {"type", {"restriction", "route", "connectivity", "multipolygon"}},
+    {"restriction", {"no_left_turn", "only_straight_on", "no_entry", "give_way"}},
+    {"restriction:conditional",
+     {"no_left_turn @ (07:00-09:00)", "no_u_turn@(Mo-Fr)", "only_right_turn @", "no_turn"}},
+    {"restriction:probable", {"no_right_turn @ (Sa-Su)"}},
+    {"restriction:hgv", {"no_left_turn", "no_u_turn"}},
+    {"restriction:bus", {"only_left_turn"}},
+    {"restriction:bicycle", {"no_straight_on"}},
+    {"restriction:foot", {"no_exit"}},
+    {"route", {"bicycle", "mtb", "bus", "road"}},
+    {"network", {"ncn", "rcn", "lcn", "mtb"}},
+    {"day_on", {"Monday"}},
+    {"day_off", {"Friday"}},
+    {"ref", {"4"}},
+};
+
+// random combinations of the tags, every element gets at least one of them
+std::vector<Tags>
+make_elements(const std::vector<std::pair<std::string, std::vector<std::string>>>& vocabulary,
+              size_t count,
+              size_t max_tags) {
+  std::mt19937 generator(17);
+  std::uniform_int_distribution<size_t> key(0, vocabulary.size() - 1);
+  std::uniform_int_distribution<size_t> tag_count(1, max_tags);
+  std::vector<Tags> elements;
+  for (size_t i = 0; i < count; ++i) {
+    Tags tags;
+    for (size_t j = tag_count(generator); j > 0; --j) {
+      const auto& entry = vocabulary[key(generator)];
+      std::uniform_int_distribution<size_t> value(0, entry.second.size() - 1);
+      tags[entry.first] = entry.second[value(generator)];
+    }
+    // the main tag which decides most of the rest
+    if (i % 2 == 0) {
+      const auto& entry = vocabulary.front();
+      std::uniform_int_distribution<size_t> value(0, entry.second.size() - 1);
+      tags[entry.first] = entry.second[value(generator)];
+    }
+    elements.emplace_back(std::move(tags));
+  }
+  return elements;
+}
+
+std::string to_string(const Tags& tags) {
+  std::map<std::string, std::string> sorted(tags.begin(), tags.end());
+  std::string str;
+  for (const auto& tag : sorted) {
+    str += tag.first + "=" + tag.second + " ";
+  }
+  return str;
+}
+
+void expect_same(OSMType type,
+                 const std::vector<std::pair<std::string, std::vector<std::string>>>& vocabulary,
+                 size_t max_tags) {
+  LuaTagTransform lua(std::string(lua_graph_lua, lua_graph_lua + lua_graph_lua_len));
+  NativeTagTransform native;
+  EXPECT_EQ(lua.Transform(type, 0, {}), native.Transform(type, 0, {}));
+  for (const auto& tags : make_elements(vocabulary, 20000, max_tags)) {
+    auto expected = lua.Transform(type, 1, tags);
+    auto result = native.Transform(type, 1, tags);
+    ASSERT_EQ(to_string(expected), to_string(result)) << "for " << to_string(tags);
+  }
+}
+
+TEST(NativeTagTransform, SameWaysAsLua) {
+  expect_same(OSMType::kWay, kWayTags, 12);
+}
+
+TEST(NativeTagTransform, SameNodesAsLua) {
+  expect_same(OSMType::kNode, kNodeTags, 6);
+}
+
+TEST(NativeTagTransform, SameRelationsAsLua) {
+  expect_same(OSMType::kRelation, kRelationTags, 5);
+}
+
+TEST(NativeTagTransform, Way) {
+  NativeTagTransform native;
+  auto results = native.Transform(OSMType::kWay, 1,
+                                  {{"highway", "primary"},
+                                   {"oneway", "-1"},
+                                   {"maxspeed", "30 mph"},
+                                   {"maxheight", "12'6\""},
+                                   {"maxweight", "7500 kg"},
+                                   {"lanes", "2"}});
+  EXPECT_EQ(results["road_class"], "2");
+  EXPECT_EQ(results["default_speed"], "75");
+  EXPECT_EQ(results["use"], "0");
+  EXPECT_EQ(results["oneway"], "true");
+  EXPECT_EQ(results["oneway_reverse"], "true");
+  EXPECT_EQ(results["auto_forward"], "false");
+  EXPECT_EQ(results["auto_backward"], "true");
+  EXPECT_EQ(results["max_speed"], "48");
+  EXPECT_EQ(results["maxheight"], "3.81");
+  EXPECT_EQ(results["maxweight"], "7.5");
+  EXPECT_EQ(results["lanes"], "2");
+
+  // nothing can use it
+  EXPECT_TRUE(
+      native.Transform(OSMType::kWay, 1, {{"highway", "motorway"}, {"access", "no"}}).empty());
+  EXPECT_TRUE(native.Transform(OSMType::kWay, 1, {{"highway", "proposed"}}).empty());
+  EXPECT_TRUE(native.Transform(OSMType::kWay, 1, {{"building", "yes"}}).empty());
+}
+
+TEST(NativeTagTransform, Node) {
+  NativeTagTransform native;
+  auto results =
+      native.Transform(OSMType::kNode, 1, {{"barrier", "bollard"}, {"iso:3166_2", "US-PA"}});
+  EXPECT_EQ(results["bollard"], "true");
+  EXPECT_EQ(results["gate"], "false");
+  EXPECT_EQ(results["state_iso_code"], "PA");
+  // pedestrians, wheelchairs and bikes
+  EXPECT_EQ(results["access_mask"], std::to_string(2 | 4 | 256));
+  EXPECT_EQ(results["tagged_access"], "0");
+
+  results = native.Transform(OSMType::kNode, 1, {});
+  EXPECT_EQ(results["access_mask"], "2047");
+}
+
+TEST(NativeTagTransform, Relation) {
+  NativeTagTransform native;
+  auto results = native.Transform(OSMType::kRelation, 1,
+                                  {{"type", "restriction"},
+                                   {"restriction:conditional", "no_left_turn @ (07:00-09:00)"}});
+  EXPECT_EQ(results["restriction"], "0");
+  EXPECT_EQ(results["restriction:conditional"], "(07:00-09:00)");
+
+  results = native.Transform(OSMType::kRelation, 1,
+                             {{"type", "route"}, {"route", "bicycle"}, {"network", "rcn"}});
+  EXPECT_EQ(results["bike_network_mask"], "2");
+
+  EXPECT_TRUE(native.Transform(OSMType::kRelation, 1, {{"type", "multipolygon"}}).empty());
+}
+
+void assert_height_parses(const std::string& maxheight, float expected) {
+  NativeTagTransform native;
+  auto results =
+      native.Transform(OSMType::kWay, 1, {{"highway", "tertiary"}, {"maxheight", maxheight}});
+  ASSERT_TRUE(results.count("maxheight") == 1) << maxheight;
+  ASSERT_FLOAT_EQ(expected, std::stof(results["maxheight"])) << maxheight;
+}
+
+TEST(NativeTagTransform, Measurements) {
+  assert_height_parses("2.0", 2.0f);
+  assert_height_parses("1", 1.0f);
+  assert_height_parses("1.1 m", 1.1f);
+  assert_height_parses("2meters", 2.0f);
+  assert_height_parses("1 METERS", 1.0f);
+  assert_height_parses("100cm", 1.0f);
+  assert_height_parses("1,1", 1.1f);
+  assert_height_parses("1ft1in", 0.33f);
+  assert_height_parses("2 feet 1 inch", 0.64f);
+  assert_height_parses("1 foot 6 inches", 0.46f);
+  assert_height_parses("1.1 ft", 0.34f);
+  assert_height_parses("1'", 0.3f);
+  assert_height_parses("1.1\"", 0.03f);
+  assert_height_parses("1' 1\"", 0.33f);
+  assert_height_parses("1'1''", 0.33f);
+
+  NativeTagTransform native;
+  auto results =
+      native.Transform(OSMType::kWay, 1, {{"highway", "tertiary"}, {"maxheight", "3..35"}});
+  EXPECT_EQ(results.count("maxheight"), 0);
+  EXPECT_FALSE(results.empty());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -414,6 +414,42 @@ TEST(Search, test_opposite_in_another_tile) {
   EXPECT_EQ(nodes.size(), 1) << "Expecting to find one node";
 }
 
+TEST(Search, test_many_boxes) {
+  // make the config file
+  std::stringstream json;
+  json << "{ \"tile_dir\": \"" << test_tile_dir << "\" }";
+  boost::property_tree::ptree conf;
+  rapidjson::read_json(json, conf);
+
+  vb::GraphReader reader(conf);
+  // the boxes from the tests above, some overlapping ones and an empty one. the
+  // batched query must give each of them what it would get on its own.
+  std::vector<vm::AABB2<vm::PointLL>> boxes{
+      {{-0.0025, -0.0025}, {0.0025, 0.0025}}, {{0.0, 0.0}, {0.0051, 0.0051}},
+      {{0.0, 0.250}, {0.001, 0.253}},         {{0.5, 0.5}, {0.51, 0.51}},
+      {{0.002, 0.002}, {0.0201, 0.0201}},     {{0.0, 0.0}, {0.0201, 0.0201}},
+      {{10.0, 10.0}, {10.01, 10.01}},
+  };
+
+  auto nodes = valhalla::loki::nodes_in_bboxes(boxes, reader);
+  auto edges = valhalla::loki::edges_in_bboxes(boxes, reader);
+  ASSERT_EQ(nodes.size(), boxes.size());
+  ASSERT_EQ(edges.size(), boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    EXPECT_EQ(nodes[i], valhalla::loki::nodes_in_bbox(boxes[i], reader)) << "box " << i;
+    EXPECT_EQ(edges[i], valhalla::loki::edges_in_bbox(boxes[i], reader)) << "box " << i;
+  }
+  EXPECT_EQ(nodes[0].size(), 1);
+  EXPECT_EQ(nodes[1].size(), 4);
+  EXPECT_EQ(nodes[3].size(), 1);
+  EXPECT_TRUE(nodes[6].empty());
+  EXPECT_TRUE(edges[6].empty());
+
+  // no boxes, no results
+  EXPECT_TRUE(valhalla::loki::nodes_in_bboxes({}, reader).empty());
+  EXPECT_TRUE(valhalla::loki::edges_in_bboxes({}, reader).empty());
+}
+
 // Setup and tearown will be called only once for the entire suite
 class Env : public ::testing::Environment {
 public:
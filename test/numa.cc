@@ -0,0 +1,48 @@
+#include "midgard/numa.h"
+
+#include "test.h"
+
+#include <set>
+#include <thread>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+TEST(Numa, ParseCpuList) {
+  EXPECT_EQ(numa_t::parse_cpu_list("0-3,8,10-11\n"),
+            (std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(numa_t::parse_cpu_list("5"), (std::vector<uint32_t>{5}));
+  EXPECT_TRUE(numa_t::parse_cpu_list("").empty());
+  EXPECT_TRUE(numa_t::parse_cpu_list("\n").empty());
+}
+
+TEST(Numa, Nodes) {
+  // there is always at least one node and no cpu is on two of them
+  const auto& nodes = numa_t::nodes();
+  ASSERT_FALSE(nodes.empty());
+  std::set<uint32_t> cpus;
+  for (const auto& node : nodes) {
+    EXPECT_FALSE(node.empty());
+    for (const auto cpu : node) {
+      EXPECT_TRUE(cpus.insert(cpu).second) << "cpu " << cpu << " on two nodes";
+    }
+  }
+}
+
+TEST(Numa, Current) {
+  EXPECT_EQ(numa_t::current(), 0);
+  std::thread([]() {
+    // the node is remembered per thread, whether pinning is allowed here or not
+    numa_t::pin(static_cast<uint32_t>(numa_t::nodes().size()) * 2 + 1);
+    EXPECT_EQ(numa_t::current(), numa_t::nodes().size() > 1 ? 1 : 0);
+  }).join();
+  EXPECT_EQ(numa_t::current(), 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,6 +1,9 @@
 #include "thor/optimizer.h"
 #include "config.h"
+#include <cmath>
 #include <cstdint>
+#include <numeric>
+#include <random>
 #include <vector>
 
 #include "test.h"
@@ -35,6 +38,73 @@ TEST(Optimizer, Basic) {
   TryOptimizer(11, costs, expected_order);
 }
 
+// Asymmetric costs between random points, going one way costs a bit more than going back
+std::vector<float> RandomCosts(const uint32_t nlocs) {
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> coordinate(0.0f, 10000.0f);
+  std::vector<std::pair<float, float>> points(nlocs);
+  for (auto& point : points) {
+    point = {coordinate(random), coordinate(random)};
+  }
+  std::vector<float> costs(nlocs * nlocs);
+  for (uint32_t i = 0; i < nlocs; ++i) {
+    for (uint32_t j = 0; j < nlocs; ++j) {
+      float d = std::hypot(points[i].first - points[j].first, points[i].second - points[j].second);
+      costs[i * nlocs + j] = i < j ? d * 1.1f : d;
+    }
+  }
+  return costs;
+}
+
+float TourCost(const uint32_t nlocs,
+               const std::vector<float>& costs,
+               const std::vector<uint32_t>& tour) {
+  float c = 0;
+  for (uint32_t i = 0; i + 1 < nlocs; ++i) {
+    c += costs[tour[i] * nlocs + tour[i + 1]];
+  }
+  return c;
+}
+
+void ExpectValidTour(const uint32_t nlocs, std::vector<uint32_t> tour) {
+  ASSERT_EQ(tour.size(), nlocs);
+  EXPECT_EQ(tour.front(), 0);
+  EXPECT_EQ(tour.back(), nlocs - 1);
+  std::sort(tour.begin(), tour.end());
+  std::vector<uint32_t> all(nlocs);
+  std::iota(all.begin(), all.end(), 0);
+  EXPECT_EQ(tour, all);
+}
+
+TEST(Optimizer, ManyLocations) {
+  const uint32_t nlocs = 150;
+  const auto costs = RandomCosts(nlocs);
+
+  Optimizer single;
+  single.Seed(111111);
+  auto tour = single.Solve(nlocs, costs);
+  ExpectValidTour(nlocs, tour);
+
+  // the tour in the given order is a random one, local search should do far better than that
+  std::vector<uint32_t> in_order(nlocs);
+  std::iota(in_order.begin(), in_order.end(), 0);
+  EXPECT_LT(TourCost(nlocs, costs, tour), TourCost(nlocs, costs, in_order) / 4);
+
+  // the starts and their seeds do not depend on the threads they run on
+  Optimizer threaded(4);
+  threaded.Seed(111111);
+  EXPECT_EQ(threaded.Solve(nlocs, costs), tour);
+}
+
+TEST(Optimizer, TimeBudget) {
+  const uint32_t nlocs = 150;
+  const auto costs = RandomCosts(nlocs);
+
+  // even the shortest budget returns a complete tour
+  Optimizer optimizer(2, 1, 1000);
+  ExpectValidTour(nlocs, optimizer.Solve(nlocs, costs));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,103 @@
+#include "filesystem.h"
+#include "mjolnir/osmdata.h"
+
+#include "test.h"
+
+#include <string>
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+TEST(OSMData, SortedMultiMapLookups) {
+  BikeMultiMap bikes;
+  bikes.insert({7, OSMBike{1, 0, 0}});
+  bikes.insert({3, OSMBike{2, 0, 0}});
+  bikes.insert({7, OSMBike{4, 0, 0}});
+  bikes.sort();
+
+  // entries of a key keep the order they were added in
+  auto range = bikes.equal_range(7);
+  ASSERT_EQ(range.second - range.first, 2);
+  EXPECT_EQ(range.first->second.bike_network, 1);
+  EXPECT_EQ((range.first + 1)->second.bike_network, 4);
+  EXPECT_EQ(bikes.find(3)->second.bike_network, 2);
+
+  // missing keys, also ones between and past the present ones, end up at end() like in std maps
+  for (uint64_t missing : {0, 5, 9}) {
+    range = bikes.equal_range(missing);
+    EXPECT_EQ(range.first, bikes.end());
+    EXPECT_EQ(range.second, bikes.end());
+    EXPECT_EQ(bikes.find(missing), bikes.end());
+  }
+}
+
+TEST(OSMData, SortedIdSet) {
+  ViaSet vias;
+  vias.insert(uint64_t(1) << 40);
+  vias.insert(5);
+  vias.insert(5);
+  vias.sort();
+  EXPECT_EQ(vias.size(), 2);
+  EXPECT_NE(vias.find(5), vias.end());
+  EXPECT_NE(vias.find(uint64_t(1) << 40), vias.end());
+  EXPECT_EQ(vias.find(6), vias.end());
+}
+
+TEST(OSMData, WayRefsMergedWhenSorted) {
+  OSMData osmdata{};
+  osmdata.add_to_name_map(10, "north", "I 95");
+  osmdata.add_to_name_map(11, "west", "US 1");
+  osmdata.add_to_name_map(10, "north", "US 1");
+  osmdata.add_to_name_map(10, "south", "I 95", false);
+  // directions other than the cardinal ones are ignored
+  osmdata.add_to_name_map(12, "up", "I 95");
+  osmdata.sort();
+
+  ASSERT_EQ(osmdata.way_ref.size(), 2);
+  EXPECT_EQ(osmdata.name_offset_map.name(osmdata.way_ref.find(10)->second),
+            "I 95|North;US 1|North");
+  EXPECT_EQ(osmdata.name_offset_map.name(osmdata.way_ref.find(11)->second), "US 1|West");
+  EXPECT_EQ(osmdata.way_ref.find(12), osmdata.way_ref.end());
+  ASSERT_EQ(osmdata.way_ref_rev.size(), 1);
+  EXPECT_EQ(osmdata.name_offset_map.name(osmdata.way_ref_rev.find(10)->second), "I 95|South");
+
+  // sorting again leaves the merged refs alone
+  osmdata.sort();
+  EXPECT_EQ(osmdata.way_ref.size(), 2);
+}
+
+TEST(OSMData, TempFilesRoundTrip) {
+  OSMData osmdata{};
+  OSMRestriction restriction;
+  restriction.set_to(8);
+  osmdata.restrictions.insert({uint64_t(1) << 33, restriction});
+  osmdata.via_set.insert(uint64_t(1) << 33);
+  OSMAccessRestriction access;
+  access.set_value(42);
+  osmdata.access_restrictions.insert({2, access});
+  osmdata.bike_relations.insert({3, OSMBike{1, 0, 0}});
+  osmdata.lane_connectivity_map.insert({4, OSMLaneConnectivity{4, 5, 0, 0}});
+  osmdata.add_to_name_map(6, "east", "A 1");
+  osmdata.sort();
+
+  const std::string tile_dir = "test/data/osmdata_temp_files/";
+  filesystem::create_directories(tile_dir);
+  ASSERT_TRUE(osmdata.write_to_temp_files(tile_dir));
+  OSMData read{};
+  ASSERT_TRUE(read.read_from_temp_files(tile_dir));
+  OSMData::cleanup_temp_files(tile_dir);
+
+  ASSERT_NE(read.restrictions.find(uint64_t(1) << 33), read.restrictions.end());
+  EXPECT_EQ(read.restrictions.find(uint64_t(1) << 33)->second.to(), 8);
+  // the via ids keep all of their 64 bits
+  EXPECT_NE(read.via_set.find(uint64_t(1) << 33), read.via_set.end());
+  ASSERT_NE(read.access_restrictions.find(2), read.access_restrictions.end());
+  EXPECT_EQ(read.access_restrictions.find(2)->second.value(), 42);
+  EXPECT_EQ(read.bike_relations.find(3)->second.bike_network, 1);
+  EXPECT_EQ(read.lane_connectivity_map.find(4)->second.from_way_id, 5);
+  ASSERT_NE(read.way_ref.find(6), read.way_ref.end());
+  EXPECT_EQ(read.name_offset_map.name(read.way_ref.find(6)->second), "A 1|East");
+}
+
+} // namespace
@@ -1,7 +1,9 @@
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "baldr/compression_utils.h"
 #include "proto/options.pb.h"
 #include "proto_conversions.h"
 #include "sif/costconstants.h"
@@ -2874,6 +2876,48 @@ TEST(ParseRequest, test_operators_transit_filter) {
   test_filter_operator_parsing(costing, filter_action, filter_ids);
 }
 
+TEST(ParseRequest, test_timeout) {
+  Api request;
+  ParseApi(R"({"locations":[{"lat":0,"lon":0},{"lat":1,"lon":1}],"costing":"auto"})",
+           Options::route, request);
+  EXPECT_EQ(request.options().deadline(), 0u);
+
+  const uint64_t before = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+  request.Clear();
+  ParseApi(R"({"locations":[{"lat":0,"lon":0},{"lat":1,"lon":1}],"costing":"auto","timeout":2.5})",
+           Options::route, request);
+  EXPECT_GE(request.options().deadline(), before + 2500u);
+  EXPECT_LT(request.options().deadline(), before + 2500u + 60000u);
+}
+
+TEST(ParseRequest, test_unspecified_costings_get_defaults) {
+  // costings without options come from parsed defaults, they must match parsing empty options
+  rapidjson::Document without;
+  without.Parse(R"({"costing_options":{"auto":{"use_tolls":0.2}}})");
+  Options options;
+  sif::ParseCosting(without, "/costing_options", options);
+
+  for (auto i = Costing::Type_MIN; i <= Costing::Type_MAX; i = Costing::Type(i + 1)) {
+    const auto& costing_str = Costing_Enum_Name(i);
+    if (costing_str.empty())
+      continue;
+    rapidjson::Document with;
+    with.Parse((R"({"costing_options":{")" + costing_str + R"(":{}}})").c_str());
+    Options expected;
+    sif::ParseCosting(with, "/costing_options", expected);
+    ASSERT_NE(options.costings().find(i), options.costings().end()) << costing_str;
+    if (i == Costing::auto_) {
+      EXPECT_EQ(options.costings().find(i)->second.options().use_tolls(), 0.2f);
+      continue;
+    }
+    EXPECT_EQ(options.costings().find(i)->second.SerializeAsString(),
+              expected.costings().find(i)->second.SerializeAsString())
+        << costing_str;
+  }
+}
+
 // test disable_hierarchy_pruning
 TEST_P(HierarchyTest, TestDisableHierarchy) {
   doTest(GetParam());
@@ -2888,6 +2932,76 @@ INSTANTIATE_TEST_SUITE_P(disable_hierarchy_pruning,
                                            Costing::motorcycle,
                                            Costing::taxi));
 
+#ifdef HAVE_HTTP
+bool accepts_gzip(const std::string& accept_encoding) {
+  prime_server::http_request_t request(prime_server::method_t::POST, "/route",
+                                       R"({"locations":[{"lat":52.09,"lon":5.11},)"
+                                       R"({"lat":52.1,"lon":5.12}],"costing":"auto"})");
+  if (!accept_encoding.empty()) {
+    request.headers.emplace("Accept-Encoding", accept_encoding);
+  }
+  Api api;
+  ParseApi(request, api);
+  return api.info().accepts_gzip();
+}
+
+TEST(ParseRequest, test_accept_encoding) {
+  EXPECT_FALSE(accepts_gzip(""));
+  EXPECT_FALSE(accepts_gzip("identity"));
+  EXPECT_FALSE(accepts_gzip("br, deflate"));
+  EXPECT_FALSE(accepts_gzip("gzip;q=0"));
+  EXPECT_FALSE(accepts_gzip("*, gzip;q=0"));
+  EXPECT_TRUE(accepts_gzip("gzip"));
+  EXPECT_TRUE(accepts_gzip("deflate, GZIP;q=0.5, br"));
+  EXPECT_TRUE(accepts_gzip("br;q=1.0, *;q=0.1"));
+}
+
+TEST(ParseRequest, test_gzip_response) {
+  Api api;
+  api.mutable_options()->set_format(Options::json);
+  api.mutable_info()->set_accepts_gzip(true);
+  prime_server::http_request_info_t info{};
+
+  // small responses go out as they are
+  auto response = to_response(R"({"trip":{}})", info, api).messages.front();
+  EXPECT_EQ(response.find("Content-Encoding"), std::string::npos);
+
+  std::string json = "[";
+  for (int i = 0; i < 1000; ++i) {
+    json += (i ? "," : "") + std::to_string(i);
+  }
+  json += "]";
+  response = to_response(json, info, api).messages.front();
+  EXPECT_NE(response.find("Content-Encoding: gzip\r\n"), std::string::npos);
+  EXPECT_NE(response.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+
+  // the body inflates back to the json
+  auto body = response.substr(response.find("\r\n\r\n") + 4);
+  EXPECT_LT(body.size(), json.size());
+  std::string inflated;
+  size_t inflated_size = 0;
+  auto src = [&body](z_stream& s) {
+    s.next_in = reinterpret_cast<Byte*>(&body[0]);
+    s.avail_in = static_cast<unsigned int>(body.size());
+  };
+  auto dst = [&inflated, &inflated_size](z_stream& s) {
+    inflated_size = s.total_out;
+    inflated.resize(s.total_out + 4096);
+    s.next_out = reinterpret_cast<Byte*>(&inflated[s.total_out]);
+    s.avail_out = 4096;
+    return Z_NO_FLUSH;
+  };
+  ASSERT_TRUE(baldr::inflate(src, dst));
+  inflated.resize(inflated_size);
+  EXPECT_EQ(inflated, json);
+
+  // unless the client didn't ask for it
+  api.mutable_info()->set_accepts_gzip(false);
+  response = to_response(json, info, api).messages.front();
+  EXPECT_EQ(response.find("Content-Encoding"), std::string::npos);
+}
+#endif
+
 } // namespace
 
 int main(int argc, char* argv[]) {
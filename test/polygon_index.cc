@@ -0,0 +1,58 @@
+#include "mjolnir/admin.h"
+
+#include "test.h"
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+PolygonIndex::Area square(uint32_t tz_index, double minx, double miny, double size) {
+  PolygonIndex::Area area{};
+  area.tz_index = tz_index;
+  boost::geometry::read_wkt("MULTIPOLYGON(((" + std::to_string(minx) + " " + std::to_string(miny) +
+                                ", " + std::to_string(minx) + " " + std::to_string(miny + size) +
+                                ", " + std::to_string(minx + size) + " " +
+                                std::to_string(miny + size) + ", " + std::to_string(minx + size) +
+                                " " + std::to_string(miny) + ", " + std::to_string(minx) + " " +
+                                std::to_string(miny) + ")))",
+                            area.geom);
+  return area;
+}
+
+TEST(PolygonIndex, IntersectingInLoadOrder) {
+  std::vector<PolygonIndex::Area> areas;
+  areas.push_back(square(3, 0, 0, 10));
+  areas.push_back(square(1, 5, 5, 10));
+  areas.push_back(square(2, 20, 20, 1));
+  // an L whose bounding box covers the tile below but whose polygon does not
+  PolygonIndex::Area l{};
+  l.tz_index = 4;
+  boost::geometry::read_wkt("MULTIPOLYGON(((30 0, 30 10, 31 10, 31 1, 40 1, 40 0, 30 0)))", l.geom);
+  areas.push_back(l);
+  PolygonIndex index(std::move(areas));
+  ASSERT_EQ(index.size(), 4);
+
+  auto found = index.Intersecting(AABB2<PointLL>(6, 6, 7, 7));
+  ASSERT_EQ(found.size(), 2);
+  EXPECT_EQ(found[0]->tz_index, 3);
+  EXPECT_EQ(found[1]->tz_index, 1);
+
+  EXPECT_TRUE(index.Intersecting(AABB2<PointLL>(35, 5, 36, 6)).empty());
+  EXPECT_EQ(index.Intersecting(AABB2<PointLL>(35, 0.5, 36, 6)).size(), 1);
+  EXPECT_TRUE(index.Intersecting(AABB2<PointLL>(50, 50, 51, 51)).empty());
+}
+
+TEST(PolygonIndex, TimeZonesOfTile) {
+  std::vector<PolygonIndex::Area> areas;
+  areas.push_back(square(7, 0, 0, 10));
+  areas.push_back(square(8, 10, 0, 10));
+  PolygonIndex index(std::move(areas));
+
+  auto polys = GetTimeZones(index, AABB2<PointLL>(9, 1, 11, 2));
+  ASSERT_EQ(polys.size(), 2);
+  EXPECT_EQ(GetMultiPolyId(polys, PointLL(9.5, 1.5)), 7);
+  EXPECT_EQ(GetMultiPolyId(polys, PointLL(10.5, 1.5)), 8);
+  EXPECT_EQ(GetMultiPolyId(polys, PointLL(25, 1.5)), 0);
+}
+
+} // namespace
@@ -2,6 +2,8 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <list>
+#include <random>
 #include <vector>
 
 #include "midgard/point2.h"
@@ -157,6 +159,40 @@ TEST(Polyline2, TestGeneralizeSimplification) {
   }
 }
 
+TEST(Polyline2, TestGeneralizeLongShape) {
+  // a long random walk generalized as a vector and as a list, twice to reuse the scratch space
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> step(-0.001, 0.001);
+  std::vector<PointLL> shape;
+  PointLL ll(5.1079374, 52.0887174);
+  for (size_t i = 0; i < 5000; ++i) {
+    ll = PointLL(ll.lng() + step(gen), ll.lat() + step(gen));
+    shape.push_back(ll);
+  }
+  const std::unordered_set<size_t> exclusions{10, 2500, 4998};
+
+  auto vector_shape = shape;
+  Polyline2<PointLL>::Generalize(vector_shape, 30.0, exclusions);
+  std::list<PointLL> list_shape(shape.begin(), shape.end());
+  Polyline2<PointLL>::Generalize(list_shape, 30.0, exclusions);
+  auto again = shape;
+  Polyline2<PointLL>::Generalize(again, 30.0, exclusions);
+
+  ASSERT_LT(vector_shape.size(), shape.size());
+  EXPECT_EQ(vector_shape, std::vector<PointLL>(list_shape.begin(), list_shape.end()));
+  EXPECT_EQ(vector_shape, again);
+  EXPECT_EQ(vector_shape.front(), shape.front());
+  EXPECT_EQ(vector_shape.back(), shape.back());
+  for (auto idx : exclusions) {
+    EXPECT_NE(std::find(vector_shape.begin(), vector_shape.end(), shape[idx]), vector_shape.end());
+  }
+
+  // every point left out is within the tolerance of the generalized shape
+  for (const auto& p : shape) {
+    EXPECT_LE(std::get<1>(p.ClosestPoint(vector_shape)), 30.0);
+  }
+}
+
 TEST(Polyline2, PeuckerSelfIntersectionTest1) {
   // These are real-world coordinates pulled off an isochrone polygon with gen_factor=0.
   // Using the raw Douglas-Peucker algorithm results in a self-intersection (using a
@@ -1,4 +1,6 @@
+#include <cmath>
 #include <iostream>
+#include <random>
 
 #include "baldr/predictedspeeds.h"
 #include "midgard/util.h"
@@ -254,6 +256,27 @@ TEST(PredictedSpeeds, test_compress_decompress_accuracy) {
   EXPECT_LE(max_diff, 2.f) << "Low decompression accuracy"; // <= 2 KPH
 }
 
+TEST(PredictedSpeeds, test_decompress_matches_reference) {
+  // random coefficients in the range seen in real profiles
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> dis(-300, 300);
+  std::array<int16_t, kCoefficientCount> coefficients;
+  for (auto& c : coefficients)
+    c = static_cast<int16_t>(dis(gen));
+  coefficients[0] = 2000;
+
+  for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
+    // straight DCT-III in double precision
+    double expected = coefficients[0] / std::sqrt(2.0);
+    for (uint32_t c = 1; c < kCoefficientCount; ++c)
+      expected += coefficients[c] * std::cos(M_PI / kBucketsPerWeek * (bucket + 0.5) * c);
+    expected *= std::sqrt(2.0 / kBucketsPerWeek);
+
+    ASSERT_NEAR(decompress_speed_bucket(coefficients.data(), bucket), expected, 0.01)
+        << "bucket " << bucket;
+  }
+}
+
 struct EncoderDecoderTest : public ::testing::Test {
   EncoderDecoderTest() {
     // fill in coefficients
@@ -281,6 +304,22 @@ TEST_F(EncoderDecoderTest, test_speeds_decoder) {
   // check decoded values
   ASSERT_TRUE(std::equal(coefficients.begin(), coefficients.end(), my_coefficients.begin()))
       << "Incorrect decoded coefficients";
+
+  // the padding may be missing and white space is skipped
+  auto unpadded = encoded.substr(0, encoded.find('=')) + "\r\n";
+  unpadded.insert(100, " ");
+  EXPECT_EQ(decode_compressed_speeds(unpadded), coefficients);
+}
+
+TEST_F(EncoderDecoderTest, test_speeds_decoder_errors) {
+  // too few or too many coefficients
+  EXPECT_THROW(decode_compressed_speeds(encoded.substr(0, 100)), std::runtime_error);
+  EXPECT_THROW(decode_compressed_speeds(encoded.substr(0, encoded.find('=')) + "AAAA"),
+               std::runtime_error);
+  // not base64
+  auto invalid = encoded;
+  invalid[10] = '!';
+  EXPECT_THROW(decode_compressed_speeds(invalid), std::runtime_error);
 }
 
 } // namespace
@@ -123,6 +123,131 @@ TEST(Reach, transition_misscount) {
   EXPECT_EQ(reach.outbound, 7);
 }
 
+TEST(Reach, stored_in_tiles) {
+  const std::string ascii_map = R"(
+      b--c--d--j
+      |  |  |
+      |  |  |
+      a--f--e--k
+      |  |
+      |  |
+      g--h--i
+    )";
+
+  const gurka::ways ways = {
+      {"abcdefaghie", {{"highway", "residential"}, {"name", "abcdefaghie"}}},
+      {"cfh", {{"highway", "tertiary"}, {"name", "cfh"}}},
+      {"dj", {{"highway", "service"}, {"oneway", "yes"}, {"name", "dj"}}},
+      {"ek", {{"highway", "footway"}, {"name", "ek"}}},
+  };
+
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/stored_reach",
+                               {{"mjolnir.concurrency", "1"}, {"mjolnir.reach_limit", "5"}});
+
+  // every edge has the same reach as what loki would compute at runtime
+  baldr::GraphReader reader(map.config.get_child("mjolnir"));
+  sif::CostFactory factory;
+  loki::Reach reach_finder;
+  size_t edges = 0;
+  for (const auto costing_type : {Costing::auto_, Costing::pedestrian, Costing::bicycle}) {
+    Api request;
+    auto& options = *request.mutable_options();
+    options.set_costing_type(costing_type);
+    rapidjson::Document doc;
+    doc.SetObject();
+    sif::ParseCosting(doc, "/costing_options", options);
+    auto cost = factory.Create(options);
+
+    ReachCache cache;
+    cache.use_costing(options);
+    ASSERT_TRUE(cache.has_stored());
+
+    for (auto tile_id : reader.GetTileSet()) {
+      auto tile = reader.GetGraphTile(tile_id);
+      ASSERT_TRUE(tile->header()->has_ext_directededge());
+      for (GraphId edge_id = tile_id; edge_id.id() < tile->header()->directededgecount();
+           ++edge_id) {
+        const auto* edge = tile->directededge(edge_id);
+        auto expected = reach_finder(edge, edge_id, 5, reader, cost);
+        directed_reach stored{};
+        ASSERT_TRUE(cache.find_stored(tile, edge_id, 5, stored));
+        EXPECT_EQ(stored.outbound, expected.outbound);
+        EXPECT_EQ(stored.inbound, expected.inbound);
+        // the stored limit is an upper bound on what can be asked for
+        ASSERT_TRUE(cache.find_stored(tile, edge_id, 3, stored));
+        EXPECT_EQ(stored.outbound, std::min<uint32_t>(expected.outbound, 3));
+        EXPECT_FALSE(cache.find_stored(tile, edge_id, 6, stored));
+        ++edges;
+      }
+    }
+
+    // anything but the default costing has to compute it
+    options.mutable_costings()->find(costing_type)->second.mutable_options()->set_ignore_oneways(
+        true);
+    cache.use_costing(options);
+    EXPECT_FALSE(cache.has_stored());
+  }
+  EXPECT_GT(edges, 0);
+
+  // adding the reach to the tiles must not have broken the rest of the tile
+  auto result = gurka::do_action(Options::route, map, {"a", "j"}, "auto");
+  gurka::assert::raw::expect_path(result, {"abcdefaghie", "abcdefaghie", "abcdefaghie", "dj"});
+}
+
+TEST(Reach, cache) {
+  Options options;
+  options.set_costing_type(Costing::auto_);
+  (*options.mutable_costings())[Costing::auto_].set_type(Costing::auto_);
+  (*options.mutable_costings())[Costing::auto_].mutable_options();
+
+  GraphId edge_id(1, 2, 3);
+  directed_reach reach{};
+
+  // nothing is remembered until the cache is bound to a costing
+  ReachCache cache(2);
+  cache.insert(edge_id, 50, {10, 20});
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.find(edge_id, 50, reach));
+
+  cache.use_costing(options);
+  cache.insert(edge_id, 50, {10, 20});
+  ASSERT_TRUE(cache.find(edge_id, 50, reach));
+  EXPECT_EQ(reach.outbound, 10);
+  EXPECT_EQ(reach.inbound, 20);
+  // it was computed for another max reach
+  EXPECT_FALSE(cache.find(edge_id, 25, reach));
+
+  // a different costing doesnt see it but the original one still does
+  options.mutable_costings()->find(Costing::auto_)->second.mutable_options()->set_use_highways(.1f);
+  cache.use_costing(options);
+  EXPECT_FALSE(cache.find(edge_id, 50, reach));
+  options.mutable_costings()->find(Costing::auto_)->second.mutable_options()->clear_use_highways();
+  cache.use_costing(options);
+  EXPECT_TRUE(cache.find(edge_id, 50, reach));
+
+  // excluded edges are particular to a request so they disable it
+  options.mutable_costings()->find(Costing::auto_)->second.mutable_options()->add_exclude_edges();
+  cache.use_costing(options);
+  EXPECT_FALSE(cache.find(edge_id, 50, reach));
+  options.mutable_costings()->find(Costing::auto_)->second.mutable_options()->clear_exclude_edges();
+
+  // its bounded
+  cache.use_costing(options);
+  cache.insert(GraphId(1, 2, 4), 50, {1, 1});
+  EXPECT_EQ(cache.size(), 2);
+  cache.insert(GraphId(1, 2, 5), 50, {1, 1});
+  EXPECT_EQ(cache.size(), 1);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+
+  // and can be turned off
+  ReachCache disabled;
+  disabled.use_costing(options);
+  disabled.insert(edge_id, 50, {10, 20});
+  EXPECT_FALSE(disabled.find(edge_id, 50, reach));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -26,7 +26,11 @@ const auto conf = test::make_config("test/data/utrecht_tiles");
 
 // expose the constructor
 struct testable_recovery : public shortcut_recovery_t {
-  testable_recovery(GraphReader* reader) : shortcut_recovery_t(reader) {
+  testable_recovery(GraphReader* reader, const std::string& index_file = "")
+      : shortcut_recovery_t(reader, index_file) {
+  }
+  bool indexed() const {
+    return index;
   }
 };
 
@@ -131,6 +135,39 @@ TEST(RecoverShortcut, test_recover_shortcut_edges_cache) {
   recover(true);
 }
 
+TEST(RecoverShortcut, test_recover_shortcut_edges_index) {
+  GraphReader graphreader(conf.get_child("mjolnir"));
+  const std::string index_file = "test/data/utrecht_shortcuts.bin";
+  graphreader.WriteShortcutIndex(index_file);
+  testable_recovery indexed{nullptr, index_file};
+  ASSERT_TRUE(indexed.indexed());
+
+  // the index has what recovering them on the fly gives
+  testable_recovery on_the_fly{nullptr};
+  size_t shortcuts = 0;
+  for (const auto& level : TileHierarchy::levels()) {
+    if (level.level > 1)
+      continue;
+    for (const auto tileid : graphreader.GetTileSet(level.level)) {
+      auto tile = graphreader.GetGraphTile(tileid);
+      GraphId edgeid{tileid};
+      for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i, ++edgeid) {
+        if (!tile->directededge(i)->is_shortcut())
+          continue;
+        EXPECT_EQ(indexed.get(edgeid, graphreader), on_the_fly.get(edgeid, graphreader));
+        ++shortcuts;
+      }
+    }
+  }
+  EXPECT_GT(shortcuts, 0);
+
+  // an index which is cut short is not used
+  filesystem::resize_file(index_file, sizeof(uint64_t) * 5);
+  testable_recovery truncated{nullptr, index_file};
+  EXPECT_FALSE(truncated.indexed());
+  filesystem::remove(index_file);
+}
+
 TEST(GetShortcut, check_false_negatives) {
   GraphReader reader(conf.get_child("mjolnir"));
 
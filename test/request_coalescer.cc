@@ -0,0 +1,130 @@
+#include "thor/request_coalescer.h"
+#include "worker.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+using namespace valhalla;
+using namespace valhalla::thor;
+
+namespace {
+
+TEST(RequestCoalescer, coalescable) {
+  Api request;
+  for (auto action : {Options::route, Options::optimized_route, Options::sources_to_targets,
+                      Options::isochrone}) {
+    request.mutable_options()->set_action(action);
+    EXPECT_TRUE(RequestCoalescer::coalescable(request));
+  }
+  for (auto action : {Options::status, Options::trace_route, Options::expansion}) {
+    request.mutable_options()->set_action(action);
+    EXPECT_FALSE(RequestCoalescer::coalescable(request));
+  }
+}
+
+// runs the first request until the second one waits for it, then lets the first one finish with the
+// given outcome and returns what the second one ended up with
+struct concurrent_t {
+  std::atomic<int> computed{0};
+  bool first_shared = true;
+  bool second_shared = true;
+
+  std::string run(const std::string& key, const std::function<std::string()>& finish_first) {
+    std::promise<void> waiting;
+    std::atomic<bool> signalled{false};
+    const std::function<void()> interrupt = [&]() {
+      if (!signalled.exchange(true)) {
+        waiting.set_value();
+      }
+    };
+
+    auto first = std::async(std::launch::async, [&]() {
+      return RequestCoalescer::share(
+          key,
+          [&]() {
+            ++computed;
+            auto second = std::async(std::launch::async, [&]() {
+              return RequestCoalescer::share(
+                  key,
+                  [&]() {
+                    ++computed;
+                    return std::string("second");
+                  },
+                  &interrupt, second_shared);
+            });
+            waiting.get_future().wait();
+            second_response = std::move(second);
+            return finish_first();
+          },
+          nullptr, first_shared);
+    });
+    try {
+      first.get();
+    } catch (...) {}
+    return second_response.get();
+  }
+
+  std::future<std::string> second_response;
+};
+
+TEST(RequestCoalescer, identical_requests_share) {
+  concurrent_t requests;
+  EXPECT_EQ(requests.run("a", []() { return std::string("first"); }), "first");
+  EXPECT_EQ(requests.computed, 1);
+  EXPECT_FALSE(requests.first_shared);
+  EXPECT_TRUE(requests.second_shared);
+
+  // nothing is kept once the requests are answered
+  bool shared = true;
+  EXPECT_EQ(RequestCoalescer::share(
+                "a", []() { return std::string("again"); }, nullptr, shared),
+            "again");
+  EXPECT_FALSE(shared);
+}
+
+TEST(RequestCoalescer, different_requests_dont_share) {
+  bool shared = true;
+  EXPECT_EQ(RequestCoalescer::share(
+                "b",
+                [&]() {
+                  bool other_shared = true;
+                  auto other = RequestCoalescer::share(
+                      "c", []() { return std::string("c"); }, nullptr, other_shared);
+                  EXPECT_FALSE(other_shared);
+                  return other + "b";
+                },
+                nullptr, shared),
+            "cb");
+  EXPECT_FALSE(shared);
+}
+
+TEST(RequestCoalescer, errors_are_shared) {
+  concurrent_t requests;
+  EXPECT_THROW(requests.run("d", []() -> std::string { throw valhalla_exception_t{442}; }),
+               valhalla_exception_t);
+  EXPECT_EQ(requests.computed, 1);
+}
+
+TEST(RequestCoalescer, interrupted_requests_are_computed_again) {
+  concurrent_t timed_out;
+  EXPECT_EQ(timed_out.run("e", []() -> std::string { throw valhalla_exception_t{446}; }),
+            "second");
+  EXPECT_EQ(timed_out.computed, 2);
+  EXPECT_FALSE(timed_out.second_shared);
+
+  concurrent_t interrupted;
+  EXPECT_EQ(interrupted.run("f", []() -> std::string { throw std::runtime_error("interrupted"); }),
+            "second");
+  EXPECT_EQ(interrupted.computed, 2);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+#include "thor/response_cache.h"
+
+#include "test.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace valhalla;
+using namespace valhalla::thor;
+
+namespace {
+
+Api make_request(Options::Action action, double lat) {
+  Api request;
+  request.mutable_options()->set_action(action);
+  request.mutable_options()->set_costing_type(Costing::auto_);
+  auto* location = request.mutable_options()->mutable_locations()->Add();
+  location->mutable_ll()->set_lat(lat);
+  location->mutable_ll()->set_lng(5.1);
+  return request;
+}
+
+TEST(ResponseCache, cacheable) {
+  ResponseCache disabled;
+  EXPECT_FALSE(disabled.cacheable(make_request(Options::route, 52.1)));
+
+  ResponseCache cache(1 << 20);
+  EXPECT_TRUE(cache.cacheable(make_request(Options::route, 52.1)));
+  EXPECT_TRUE(cache.cacheable(make_request(Options::optimized_route, 52.1)));
+  EXPECT_TRUE(cache.cacheable(make_request(Options::sources_to_targets, 52.1)));
+  EXPECT_FALSE(cache.cacheable(make_request(Options::status, 52.1)));
+  EXPECT_FALSE(cache.cacheable(make_request(Options::trace_route, 52.1)));
+
+  // the answer changes with the clock
+  auto request = make_request(Options::route, 52.1);
+  request.mutable_options()->set_date_time_type(Options::depart_at);
+  request.mutable_options()->mutable_locations(0)->set_date_time("2026-10-15T08:00");
+  EXPECT_TRUE(cache.cacheable(request));
+  request.mutable_options()->mutable_locations(0)->set_date_time("current");
+  EXPECT_FALSE(cache.cacheable(request));
+  request = make_request(Options::sources_to_targets, 52.1);
+  request.mutable_options()->mutable_sources()->Add()->set_date_time("current");
+  EXPECT_FALSE(cache.cacheable(request));
+}
+
+TEST(ResponseCache, key) {
+  auto a = make_request(Options::route, 52.1);
+  auto b = make_request(Options::route, 52.1);
+  EXPECT_EQ(ResponseCache::key(a), ResponseCache::key(b));
+
+  // anything that can change the response changes the key
+  EXPECT_NE(ResponseCache::key(a), ResponseCache::key(make_request(Options::route, 52.2)));
+  EXPECT_NE(ResponseCache::key(a),
+            ResponseCache::key(make_request(Options::optimized_route, 52.1)));
+  b.mutable_info()->mutable_warnings()->Add()->set_code(100);
+  EXPECT_NE(ResponseCache::key(a), ResponseCache::key(b));
+
+  // but stats collected on the way do not
+  b = make_request(Options::route, 52.1);
+  b.mutable_info()->mutable_statistics()->Add()->set_key("route.info.loki.latency_ms");
+  EXPECT_EQ(ResponseCache::key(a), ResponseCache::key(b));
+  b.mutable_options()->set_deadline(1234567890123);
+  EXPECT_EQ(ResponseCache::key(a), ResponseCache::key(b));
+}
+
+TEST(ResponseCache, lru) {
+  ResponseCache cache(30);
+  cache.insert("a", std::string(9, 'a'));
+  cache.insert("b", std::string(9, 'b'));
+  cache.insert("c", std::string(9, 'c'));
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_EQ(cache.bytes(), 30);
+
+  // using a makes b the least recently used one
+  ASSERT_NE(cache.find("a"), nullptr);
+  EXPECT_EQ(*cache.find("a"), std::string(9, 'a'));
+  cache.insert("d", std::string(4, 'd'));
+  EXPECT_EQ(cache.find("b"), nullptr);
+  EXPECT_NE(cache.find("a"), nullptr);
+  EXPECT_NE(cache.find("c"), nullptr);
+  EXPECT_EQ(*cache.find("d"), "dddd");
+  EXPECT_EQ(cache.bytes(), 25);
+
+  // replacing an entry keeps one copy of it
+  cache.insert("d", "dd");
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_EQ(*cache.find("d"), "dd");
+  EXPECT_EQ(cache.bytes(), 23);
+
+  // too large to ever fit
+  cache.insert("e", std::string(30, 'e'));
+  EXPECT_EQ(cache.find("e"), nullptr);
+  EXPECT_EQ(cache.size(), 3);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.bytes(), 0);
+  EXPECT_EQ(cache.find("a"), nullptr);
+}
+
+TEST(ResponseCache, ttl) {
+  ResponseCache cache(1 << 10, 1);
+  cache.insert("a", "response");
+  EXPECT_NE(cache.find("a"), nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  EXPECT_EQ(cache.find("a"), nullptr);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
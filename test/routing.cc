@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <vector>
 // -*- mode: c++ -*-
 #include "meili/routing.h"
 
@@ -212,6 +213,38 @@ TEST(Routing, TestRoutePathIterator) {
   EXPECT_EQ(it5, the_end) << "TestRoutePathIterator: wrong advance";
 }
 
+TEST(Routing, TestSharedLabelSet) {
+  // Two expansions in a row into the same label set, like the states of one column do
+  meili::LabelSet labelset(100);
+  sif::TravelMode travelmode = static_cast<sif::TravelMode>(0);
+  baldr::DirectedEdge de;
+
+  std::vector<uint32_t> origins, targets;
+  for (int expansion = 0; expansion < 2; ++expansion) {
+    labelset.put(0, travelmode, nullptr);
+    const auto origin = labelset.pop();
+    ASSERT_NE(origin, baldr::kInvalidLabel) << "the origin must be queued again after a reset";
+    labelset.put(1, baldr::GraphId(), 0.f, 1.f, {1.f + expansion, 0.f}, 0.f, 1.f + expansion,
+                 origin, &de, travelmode, -1);
+    const auto target = labelset.pop();
+    ASSERT_NE(target, baldr::kInvalidLabel) << "the destination must be queued again after a reset";
+    EXPECT_EQ(labelset.pop(), baldr::kInvalidLabel);
+    labelset.clear_queue();
+    labelset.clear_status();
+    origins.push_back(origin);
+    targets.push_back(target);
+  }
+
+  // The labels of the first expansion are still there to recover its path
+  EXPECT_NE(origins[0], origins[1]);
+  for (int expansion = 0; expansion < 2; ++expansion) {
+    meili::RoutePathIterator it(&labelset, targets[expansion]), the_end(&labelset);
+    EXPECT_EQ(it->cost().cost, 1.f + expansion);
+    EXPECT_EQ(std::next(it), meili::RoutePathIterator(&labelset, origins[expansion]));
+    EXPECT_EQ(std::next(it, 2), the_end);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
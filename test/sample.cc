@@ -4,11 +4,14 @@
 #include "baldr/compression_utils.h"
 #include "midgard/sequence.h"
 #include "midgard/util.h"
+#include "microtar.h"
 
 #include <cmath>
 #include <fstream>
+#include <iterator>
 #include <list>
 #include <lz4frame.h>
+#include <thread>
 
 #include "test.h"
 
@@ -118,6 +121,89 @@ TEST(Sample, getlz4) {
   _get("test/data/samplelz4");
 };
 
+TEST(Sample, get_all_matches_get) {
+  skadi::sample s("test/data/sample");
+
+  // postings bouncing between a tile with data and ones without, so they have to be regrouped,
+  // including the bottom row of the tile which has nothing below it
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 100; ++i) {
+    postings.emplace_back(-76.55 + i * 0.001, 40.7 + i * 0.0005);
+    postings.emplace_back(-75.5 + i * 0.001, 40.7);
+    if (i % 10 == 0) {
+      postings.emplace_back(-76.9 + i * 0.001, 40.0);
+    }
+  }
+
+  auto heights = s.get_all(postings);
+  ASSERT_EQ(heights.size(), postings.size());
+  size_t with_data = 0;
+  for (size_t i = 0; i < postings.size(); ++i) {
+    EXPECT_EQ(heights[i], s.get(postings[i])) << "Posting " << i;
+    with_data += heights[i] != skadi::get_no_data_value();
+  }
+  EXPECT_GT(with_data, 100);
+}
+
+TEST(Sample, concurrent_unpack) {
+  // every thread asks for the same compressed tile at once, only one of them should unpack it and
+  // all of them should get the same heights
+  skadi::sample s("test/data/samplegz");
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 100; ++i) {
+    postings.emplace_back(-76.55 + i * 0.001, 40.7 + i * 0.0005);
+  }
+  std::vector<std::vector<double>> heights(8);
+  std::vector<std::thread> threads;
+  for (auto& h : heights) {
+    threads.emplace_back([&s, &postings, &h]() {
+      for (int i = 0; i < 10; ++i) {
+        h = s.get_all(postings);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  skadi::sample reference("test/data/sample");
+  const auto expected = reference.get_all(postings);
+  for (const auto& h : heights) {
+    EXPECT_EQ(h, expected);
+  }
+}
+
+TEST(Sample, extract) {
+  // tar up the raw tile from the create_tile test
+  std::vector<char> tile;
+  {
+    std::ifstream file("test/data/sample/N40/N40W077.hgt", std::ios::binary);
+    tile.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  ASSERT_EQ(tile.size(), 3601 * 3601 * sizeof(int16_t));
+  mtar_t tar;
+  ASSERT_EQ(mtar_open(&tar, "test/data/sample_extract.tar", "w"), MTAR_ESUCCESS);
+  ASSERT_EQ(mtar_write_file_header(&tar, "N40/N40W077.hgt", tile.size()), MTAR_ESUCCESS);
+  ASSERT_EQ(mtar_write_data(&tar, tile.data(), tile.size()), MTAR_ESUCCESS);
+  mtar_finalize(&tar);
+  mtar_close(&tar);
+
+  // without a directory all of the data has to come from the extract
+  boost::property_tree::ptree config;
+  config.put("additional_data.elevation_extract", "test/data/sample_extract.tar");
+  skadi::sample s(config);
+  EXPECT_NEAR(490, s.get(std::make_pair(-76.503915, 40.678783)), 1.0);
+
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 100; ++i) {
+    postings.emplace_back(-76.55 + i * 0.001, 40.7 + i * 0.0005);
+  }
+  skadi::sample reference("test/data/sample");
+  EXPECT_EQ(s.get_all(postings), reference.get_all(postings));
+  EXPECT_EQ(s.get(std::make_pair(-75.5, 40.5)), skadi::get_no_data_value());
+
+  filesystem::remove("test/data/sample_extract.tar");
+}
+
 struct testable_sample_t : public skadi::sample {
   testable_sample_t(const std::string& dir) : sample(dir) {
     {
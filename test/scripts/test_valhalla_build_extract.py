@@ -127,6 +127,26 @@ class TestBuildExtract(unittest.TestCase):
         gj_fp.unlink()
         gj_dir.rmdir()
 
+    def test_order_tiles_by_usage(self):
+        # bogus tile dir
+        tile_dir = Path("/home/")
+        paths = [tile_base_to_path(*input_tuple, tile_dir) for input_tuple in (
+            (8, 50, 0),
+            (12, 54, 1),
+            (20, 59, 2),
+            (20.25, 59, 2),
+        )]
+        ids = [valhalla_build_extract.get_tile_id(str(p.relative_to(tile_dir))) for p in paths]
+
+        # the last tile is the most used, the second one next and the unused keep their order
+        usage_fp = TILE_PATH.joinpath('test_tile_usage.txt')
+        with open(usage_fp, 'w') as f:
+            for i, uses in ((3, 10), (1, 2)):
+                f.write(f"{ids[i] & 7}/{ids[i] >> 3} {uses}\n")
+        ordered = valhalla_build_extract.order_tiles_by_usage(paths, usage_fp, tile_dir)
+        usage_fp.unlink()
+        self.assertListEqual(ordered, [paths[3], paths[1], paths[0], paths[2]])
+
     def test_create_extracts(self):
         config = {"mjolnir": {"tile_dir": str(TILE_PATH), "tile_extract": str(EXTRACT_PATH),
                               "traffic_extract": str(TRAFFIC_PATH)}}
@@ -143,6 +163,42 @@ class TestBuildExtract(unittest.TestCase):
         exp_tuples = ((1536, 25568, 26416), (28672, 410441, 65552), (95232, 6549282, 604608))
         self.check_tar(TRAFFIC_PATH, exp_tuples, tile_count * INDEX_BIN_SIZE)
 
+    def test_create_compressed_extracts(self):
+        extract_path = TILE_PATH.joinpath('compressed_tiles.tar')
+        traffic_path = TILE_PATH.joinpath('compressed_traffic.tar')
+        config = {"mjolnir": {"tile_dir": str(TILE_PATH), "tile_extract": str(extract_path),
+                              "traffic_extract": str(traffic_path)}}
+
+        tile_paths = sorted(TILE_PATH.rglob('*.gph'))
+        valhalla_build_extract.create_extracts(config, True, tile_paths, True, 4096)
+
+        # every tile in the index inflates to what is in the tile dir
+        with open(extract_path, 'rb') as f:
+            f.seek(tarfile.BLOCKSIZE)
+            dictionary_size, tile_count = struct.unpack(
+                valhalla_build_extract.COMPRESSED_INDEX_HEADER_FORMAT,
+                f.read(valhalla_build_extract.COMPRESSED_INDEX_HEADER_SIZE))
+            self.assertEqual(dictionary_size, 4096)
+            self.assertEqual(tile_count, len(tile_paths))
+            dictionary = f.read(dictionary_size)
+            entries = [struct.unpack(valhalla_build_extract.COMPRESSED_INDEX_BIN_FORMAT,
+                                     f.read(valhalla_build_extract.COMPRESSED_INDEX_BIN_SIZE))
+                       for _ in range(tile_count)]
+            tiles = {valhalla_build_extract.get_tile_id(str(t.relative_to(TILE_PATH))): t
+                     for t in tile_paths}
+            for offset, tile_id, size, inflated_size, _ in entries:
+                f.seek(offset)
+                inflated = valhalla_build_extract.inflate_tile(f.read(size), dictionary)
+                self.assertEqual(len(inflated), inflated_size)
+                self.assertEqual(inflated, tiles[tile_id].read_bytes())
+
+        # the traffic extract is the same as for an uncompressed one
+        exp_tuples = ((1536, 25568, 26416), (28672, 410441, 65552), (95232, 6549282, 604608))
+        self.check_tar(traffic_path, exp_tuples, len(tile_paths) * INDEX_BIN_SIZE)
+
+        extract_path.unlink()
+        traffic_path.unlink()
+
     def check_tar(self, p: Path, exp_tuples, end_index):
         with open(p, 'r+b') as f:
             f.seek(tarfile.BLOCKSIZE)
@@ -10,6 +10,7 @@
 #include "baldr/pathlocation.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
+#include "loki/bin_index.h"
 #include "midgard/pointll.h"
 #include "midgard/vector2.h"
 #include "sif/nocost.h"
@@ -456,6 +457,70 @@ TEST(Search, test_search_cutoff) {
   search(x, 2, 0);
 }
 
+TEST(Search, test_batch_matches_single) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  valhalla::baldr::GraphReader reader(conf);
+  const auto costing = create_costing();
+
+  // a grid of locations over the whole graph so that many of them share bins and get advanced to
+  // new ones at different times while the batch is searched
+  std::vector<Location> locations;
+  for (double lon = -.05; lon <= .25; lon += .0125) {
+    for (double lat = -.05; lat <= .25; lat += .0125) {
+      locations.emplace_back(PointLL{lon, lat}, Location::StopType::BREAK, 0, 0, 0);
+    }
+  }
+
+  const auto batch = Search(locations, reader, costing);
+  for (const auto& location : locations) {
+    const auto single = Search({location}, reader, costing);
+    ASSERT_EQ(batch.count(location), single.count(location));
+    if (single.empty())
+      continue;
+    const auto& expected = single.at(location);
+    const auto& actual = batch.at(location);
+    ASSERT_EQ(expected.edges.size(), actual.edges.size());
+    EXPECT_TRUE(expected.shares_edges(actual));
+  }
+}
+
+TEST(Search, test_bin_index_matches_plain) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  valhalla::baldr::GraphReader reader(conf);
+  const auto costing = create_costing();
+  BinIndex bin_index(1);
+
+  // skipping far away edges must not change what is found, with or without a radius or reach
+  for (unsigned long radius : {0ul, 2000ul}) {
+    for (unsigned int reach : {0u, 3u}) {
+      std::vector<Location> locations;
+      for (double lon = -.05; lon <= .25; lon += .0125) {
+        for (double lat = -.05; lat <= .25; lat += .0125) {
+          locations.emplace_back(PointLL{lon, lat}, Location::StopType::BREAK, reach, reach,
+                                 radius);
+        }
+      }
+
+      const auto plain = Search(locations, reader, costing);
+      const auto indexed = Search(locations, reader, costing, nullptr, &bin_index);
+      ASSERT_EQ(plain.size(), indexed.size());
+      for (const auto& result : plain) {
+        const auto& expected = result.second;
+        const auto& actual = indexed.at(result.first);
+        ASSERT_EQ(expected.edges.size(), actual.edges.size());
+        EXPECT_TRUE(expected.shares_edges(actual));
+        for (size_t i = 0; i < expected.edges.size(); ++i) {
+          EXPECT_EQ(expected.edges[i].projected, actual.edges[i].projected);
+          EXPECT_EQ(expected.edges[i].distance, actual.edges[i].distance);
+        }
+      }
+    }
+  }
+  EXPECT_EQ(bin_index.size(), 1);
+}
+
 } // namespace
 
 // Setup and tearown will be called only once for the entire suite121
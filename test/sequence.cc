@@ -1,5 +1,7 @@
 #include "midgard/sequence.h"
+#include <algorithm>
 #include <cstdint>
+#include <random>
 
 #include "test.h"
 
@@ -70,6 +72,69 @@ TEST(Sequence, Iterator) {
   EXPECT_EQ(i.position(), 0) << "Pre-decrement operator wasn't right";
 }
 
+void sort_randomly(const uint64_t count, size_t memory_budget, uint32_t threads) {
+  std::string file_name = "random_nodes.nd";
+  {
+    std::mt19937_64 generator(count);
+    sequence<osm_node> sequence(file_name, true);
+    for (uint64_t i = 0; i < count; ++i)
+      sequence.push_back({generator() % (count / 2), 0.f, 0.f, static_cast<uint32_t>(i)});
+    sequence.sort([](const osm_node& a, const osm_node& b) { return a.id < b.id; }, memory_budget,
+                  threads);
+  }
+
+  // everything is still there and in order
+  sequence<osm_node> sequence(file_name, false);
+  ASSERT_EQ(sequence.size(), count);
+  std::vector<bool> seen(count, false);
+  uint64_t last = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    osm_node node = *sequence[i];
+    ASSERT_LE(last, node.id);
+    last = node.id;
+    ASSERT_FALSE(seen[node.attributes]);
+    seen[node.attributes] = true;
+  }
+  EXPECT_FALSE(filesystem::exists(file_name + ".tmp"));
+}
+
+TEST(Sequence, SortInMemory) {
+  sort_randomly(1000, 1024 * 1024, 4);
+  sort_randomly(300001, 1024 * 1024 * 512, 4);
+}
+
+TEST(Sequence, SortExternal) {
+  sort_randomly(1000, 1024, 1);
+  sort_randomly(300001, 1024 * 1024, 1);
+  sort_randomly(600001, 1024 * 1024 * 4, 3);
+}
+
+TEST(Sequence, MemMapAdvice) {
+  const std::string file_name = "advised.bin";
+  {
+    mem_map<char> map;
+    map.create(file_name, 3 * 4096 + 100);
+    std::fill(map.get(), map.get() + map.size(), 'x');
+  }
+  mem_map<char> map;
+  map.map_readonly(file_name, 3 * 4096 + 100);
+  EXPECT_TRUE(map.advise(POSIX_MADV_RANDOM));
+  EXPECT_TRUE(map.advise(POSIX_MADV_WILLNEED, 4096 + 10, 20));
+  // ranges past the end of the map are cut off at it and ranges beyond it are nothing
+  EXPECT_TRUE(map.advise(POSIX_MADV_NORMAL, 2 * 4096, 1 << 20));
+  EXPECT_FALSE(map.advise(POSIX_MADV_NORMAL, 1 << 20, 1));
+  EXPECT_FALSE(map.lock(1 << 20, 1));
+  // huge pages and locking depend on the kernel and the limits of the process, they must not
+  // disturb the contents either way
+  map.advise_huge_pages();
+  map.populate();
+  if (map.lock(100, 5000)) {
+    EXPECT_EQ(munlock(map.get(), 2 * 4096), 0);
+  }
+  const auto unchanged = std::count(map.get(), map.get() + map.size(), 'x');
+  EXPECT_EQ(static_cast<size_t>(unchanged), map.size());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
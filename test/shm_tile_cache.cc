@@ -0,0 +1,113 @@
+#include "baldr/shm_tile_cache.h"
+
+#include "test.h"
+
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// a segment of its own for each test so they don't see each others tiles
+struct segment_t {
+  explicit segment_t(const std::string& test)
+      : name("/valhalla_test_" + test + "_" + std::to_string(getpid())) {
+    shm_tile_cache_t::remove(name);
+  }
+  ~segment_t() {
+    shm_tile_cache_t::remove(name);
+  }
+  const std::string name;
+};
+
+std::vector<char> bytes(size_t size, char value) {
+  return std::vector<char>(size, value);
+}
+
+TEST(ShmTileCache, InsertFind) {
+  segment_t segment("insert_find");
+  shm_tile_cache_t cache(segment.name, 1 << 20);
+  EXPECT_EQ(cache.used(), 0);
+
+  GraphId id(100, 2, 0);
+  EXPECT_EQ(cache.find(id).first, nullptr);
+  auto tile = bytes(1000, 'a');
+  EXPECT_TRUE(cache.insert(id, tile.data(), tile.size()));
+  auto found = cache.find(id);
+  ASSERT_NE(found.first, nullptr);
+  EXPECT_EQ(std::string(found.first, found.second), std::string(tile.begin(), tile.end()));
+  EXPECT_GE(cache.used(), tile.size());
+
+  // a tile is only added once
+  auto other = bytes(500, 'b');
+  EXPECT_FALSE(cache.insert(id, other.data(), other.size()));
+  EXPECT_EQ(cache.find(id).second, tile.size());
+  EXPECT_EQ(cache.find(GraphId(101, 2, 0)).first, nullptr);
+}
+
+TEST(ShmTileCache, SharedBetweenAttachments) {
+  segment_t segment("shared");
+  shm_tile_cache_t a(segment.name, 1 << 20);
+  // another attachment, like one of another process, keeps the size the segment was made with
+  shm_tile_cache_t b(segment.name, 1 << 24);
+  EXPECT_EQ(a.capacity(), b.capacity());
+
+  GraphId id(7, 1, 0);
+  auto tile = bytes(300, 'c');
+  EXPECT_TRUE(a.insert(id, tile.data(), tile.size()));
+  auto found = b.find(id);
+  ASSERT_NE(found.first, nullptr);
+  EXPECT_EQ(std::string(found.first, found.second), std::string(tile.begin(), tile.end()));
+
+  // the readers of a process share one attachment
+  auto instance = shm_tile_cache_t::get_instance(segment.name, 1 << 20);
+  ASSERT_NE(instance, nullptr);
+  EXPECT_EQ(instance, shm_tile_cache_t::get_instance(segment.name, 1 << 20));
+  EXPECT_NE(instance->find(id).first, nullptr);
+}
+
+TEST(ShmTileCache, Full) {
+  segment_t segment("full");
+  shm_tile_cache_t cache(segment.name, 1 << 16);
+  auto tile = bytes(cache.capacity() / 2 + 1, 'd');
+  EXPECT_TRUE(cache.insert(GraphId(1, 2, 0), tile.data(), tile.size()));
+  EXPECT_FALSE(cache.insert(GraphId(2, 2, 0), tile.data(), tile.size()));
+  EXPECT_EQ(cache.find(GraphId(2, 2, 0)).first, nullptr);
+  EXPECT_NE(cache.find(GraphId(1, 2, 0)).first, nullptr);
+  EXPECT_LE(cache.used(), cache.capacity());
+}
+
+TEST(ShmTileCache, ConcurrentInserts) {
+  segment_t segment("concurrent");
+  shm_tile_cache_t cache(segment.name, 1 << 22);
+
+  // the threads race to add the same tiles, each ends up there once with the bytes of a thread
+  std::vector<std::thread> threads;
+  for (char t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t]() {
+      auto tile = bytes(100, 'a' + t);
+      for (uint32_t i = 0; i < 300; ++i) {
+        cache.insert(GraphId(i, 2, 0), tile.data(), tile.size());
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  for (uint32_t i = 0; i < 300; ++i) {
+    auto found = cache.find(GraphId(i, 2, 0));
+    ASSERT_NE(found.first, nullptr);
+    ASSERT_EQ(found.second, 100);
+    EXPECT_EQ(std::string(found.first, found.second), std::string(100, found.first[0]));
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -103,6 +103,7 @@ TEST(StreetnameUs, TestGetPostCardinalDir) {
 
 void TryGetBaseName(const StreetNameUs& street_name, const std::string& base_name) {
   EXPECT_EQ(base_name, street_name.GetBaseName()) << street_name.value() + ": Incorrect GetBaseName";
+  EXPECT_EQ(base_name, street_name.BaseName()) << street_name.value() + ": Incorrect BaseName";
 }
 
 TEST(StreetnameUs, TestGetBaseName) {
@@ -32,6 +32,7 @@ void TryFindCommonStreetNames(const StreetNamesUs& lhs,
                               const StreetNamesUs& expected) {
   std::unique_ptr<StreetNames> computed = lhs.FindCommonStreetNames(rhs);
   EXPECT_EQ(computed->ToString(), expected.ToString()) << "FindCommonStreetNames";
+  EXPECT_EQ(lhs.CountCommonStreetNames(rhs), computed->size()) << "CountCommonStreetNames";
 }
 
 TEST(StreetnamesUs, TestFindCommonStreetNames) {
@@ -55,6 +56,7 @@ void TryFindCommonBaseNames(const StreetNamesUs& lhs,
                             const StreetNamesUs& expected) {
   std::unique_ptr<StreetNames> computed = lhs.FindCommonBaseNames(rhs);
   EXPECT_EQ(computed->ToString(), expected.ToString()) << "FindCommonBaseNames";
+  EXPECT_EQ(lhs.CountCommonBaseNames(rhs), computed->size()) << "CountCommonBaseNames";
 }
 
 TEST(StreetnamesUs, TestFindCommonBaseNames) {
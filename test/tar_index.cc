@@ -1,8 +1,15 @@
 #include "test.h"
 
+#include "baldr/compression_utils.h"
 #include "baldr/graphreader.h"
+#include "mjolnir/extractbuilder.h"
 #include <boost/property_tree/ptree.hpp>
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
 namespace vb = valhalla::baldr;
 
 class TestGraphReader : vb::GraphReader {
@@ -37,3 +44,134 @@ TEST(TarIndexer, CheckScanTar) {
 
   ASSERT_NE(reader_tar.tile_extract_->checksum, 0);
 }
+
+namespace {
+
+// writes one regular file into a tar, its data padded to whole blocks
+void write_member(std::ofstream& tar, const std::string& name, const std::string& data) {
+  valhalla::midgard::tar::header_t header{};
+  std::strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+  std::snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+  std::snprintf(header.size, sizeof(header.size), "%011llo",
+                static_cast<unsigned long long>(data.size()));
+  std::snprintf(header.mtime, sizeof(header.mtime), "%011o", 0);
+  header.typeflag = '0';
+  std::memcpy(header.magic, "ustar", sizeof(header.magic));
+  std::memset(header.chksum, ' ', sizeof(header.chksum));
+  unsigned int sum = 0;
+  for (size_t i = 0; i < sizeof(header); ++i) {
+    sum += reinterpret_cast<const unsigned char*>(&header)[i];
+  }
+  std::snprintf(header.chksum, sizeof(header.chksum) - 1, "%06o", sum);
+  tar.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  tar.write(data.data(), data.size());
+  const std::string padding((sizeof(header) - data.size() % sizeof(header)) % sizeof(header), 0);
+  tar.write(padding.data(), padding.size());
+}
+
+std::string deflate_tile(std::string tile, const std::string& dictionary) {
+  std::string deflated;
+  auto src_func = [&tile](z_stream& s) -> int {
+    s.next_in = reinterpret_cast<Byte*>(&tile[0]);
+    s.avail_in = static_cast<unsigned int>(tile.size());
+    return Z_FINISH;
+  };
+  auto dst_func = [&deflated](z_stream& s) -> void {
+    auto size = deflated.size();
+    if (s.total_out < size) {
+      deflated.resize(s.total_out);
+    } else {
+      deflated.resize(size + 4096);
+      s.next_out = reinterpret_cast<Byte*>(&deflated[0] + size);
+      s.avail_out = 4096;
+    }
+  };
+  EXPECT_TRUE(vb::deflate(src_func, dst_func, Z_BEST_COMPRESSION, false, dictionary));
+  return deflated;
+}
+
+} // namespace
+
+TEST(TarIndexer, CompressedExtract) {
+  // deflate every tile of the tile dir on its own into a tar, with a dictionary out of the first
+  GraphReader reader_dir(config_dir.get_child("mjolnir"));
+  const auto tile_ids = reader_dir.GetTileSet();
+  ASSERT_FALSE(tile_ids.empty());
+  std::vector<std::pair<vb::GraphId, std::string>> tiles;
+  for (const auto& tile_id : tile_ids) {
+    std::ifstream file("test/data/utrecht_tiles/" + vb::GraphTile::FileSuffix(tile_id),
+                       std::ios::binary);
+    tiles.emplace_back(tile_id, std::string(std::istreambuf_iterator<char>(file), {}));
+  }
+  const auto dictionary = tiles.front().second.substr(0, 3000);
+
+  // the index is the first member, its entries follow the dictionary padded to 8 bytes
+  const std::string extract = "test/data/utrecht_tiles/compressed_tiles.tar";
+  std::string index(8 + 3000 + 24 * tiles.size(), 0);
+  const uint32_t index_header[] = {static_cast<uint32_t>(dictionary.size()),
+                                   static_cast<uint32_t>(tiles.size())};
+  std::memcpy(&index[0], index_header, sizeof(index_header));
+  std::memcpy(&index[8], dictionary.data(), dictionary.size());
+  {
+    std::ofstream tar(extract, std::ios::binary | std::ios::trunc);
+    write_member(tar, "compressed_index.bin", index);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      const auto deflated = deflate_tile(tiles[i].second, dictionary);
+      const uint64_t offset = static_cast<uint64_t>(tar.tellp()) + 512;
+      const uint32_t entry[] = {static_cast<uint32_t>(tiles[i].first.value),
+                                static_cast<uint32_t>(deflated.size()),
+                                static_cast<uint32_t>(tiles[i].second.size()), 0};
+      std::memcpy(&index[8 + 3000 + 24 * i], &offset, sizeof(offset));
+      std::memcpy(&index[8 + 3000 + 24 * i + sizeof(offset)], entry, sizeof(entry));
+      write_member(tar, vb::GraphTile::FileSuffix(tiles[i].first), deflated);
+    }
+    // rewrite the index now that the offsets are known, and end the tar
+    tar.write(std::string(1024, 0).data(), 1024);
+    tar.seekp(0);
+    write_member(tar, "compressed_index.bin", index);
+  }
+
+  // the tiles read from the extract are the same bytes as the ones from the tile dir
+  auto config = test::make_config("test/data/utrecht_tiles", {{"mjolnir.tile_extract", extract}});
+  TestGraphReader reader_tar(config.get_child("mjolnir"));
+  ASSERT_EQ(reader_tar.tile_extract_->tiles.size(), tiles.size());
+  ASSERT_EQ(reader_tar.tile_extract_->inflated_sizes.size(), tiles.size());
+  EXPECT_EQ(reader_tar.tile_extract_->dictionary, dictionary);
+  for (const auto& tile : tiles) {
+    auto tar_tile = reader_tar.GetGraphTile(tile.first);
+    ASSERT_NE(tar_tile, nullptr);
+    ASSERT_EQ(tar_tile->header()->end_offset(), tile.second.size());
+    EXPECT_EQ(memcmp(tar_tile->header(), tile.second.data(), tile.second.size()), 0);
+  }
+
+  std::remove(extract.c_str());
+}
+
+TEST(TarIndexer, BuiltExtract) {
+  // package the tile dir the way the end of the tile build does
+  const std::string extract = "test/data/utrecht_tiles/built_tiles.tar";
+  auto config = test::make_config("test/data/utrecht_tiles", {{"mjolnir.tile_extract", extract},
+                                                              {"mjolnir.build_extract", "true"},
+                                                              {"mjolnir.concurrency", "4"}});
+  valhalla::mjolnir::ExtractBuilder::Build(config);
+
+  // it has an index for all the tiles, each of them on a page of its own and the same bytes
+  TestGraphReader reader_tar(config.get_child("mjolnir"));
+  GraphReader reader_dir(config_dir.get_child("mjolnir"));
+  const auto tile_ids = reader_dir.GetTileSet();
+  ASSERT_FALSE(tile_ids.empty());
+  ASSERT_EQ(reader_tar.tile_extract_->tiles.size(), tile_ids.size());
+  const char* begin = reader_tar.tile_extract_->archive->mm.get();
+  for (const auto& tile_id : tile_ids) {
+    const auto& position = reader_tar.tile_extract_->tiles.at(tile_id.value);
+    EXPECT_EQ((position.first - begin) % 4096, 0);
+    std::ifstream file("test/data/utrecht_tiles/" + vb::GraphTile::FileSuffix(tile_id),
+                       std::ios::binary);
+    const std::string bytes(std::istreambuf_iterator<char>(file), {});
+    ASSERT_EQ(position.second, bytes.size());
+    EXPECT_EQ(memcmp(position.first, bytes.data(), bytes.size()), 0);
+    EXPECT_NE(reader_tar.GetGraphTile(tile_id), nullptr);
+  }
+
+  std::remove(extract.c_str());
+}
@@ -550,6 +550,8 @@ void customize_live_traffic_data(const boost::property_tree::ptree& config,
             const_cast<valhalla::baldr::TrafficSpeed*>(tile.speeds + index);
         setter_cb(reader, tile, index, current);
       }
+      // let readers know this tile changed
+      tile.header->generation = tile.header->generation + 1;
       mtar_next(&tar);
     }
   }
@@ -0,0 +1,100 @@
+#include "mjolnir/tilepipeline.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+const GraphId a(1, 2, 0);
+const GraphId b(2, 2, 0);
+const GraphId c(3, 2, 0);
+
+TEST(TilePipeline, NextInTheOrderDone) {
+  TilePipeline pipeline({a, b, c});
+  pipeline.Done(b);
+  pipeline.Done(a);
+  // tiles which were not pending or were done already are ignored
+  pipeline.Done(b);
+  pipeline.Done(GraphId(4, 2, 0));
+  pipeline.Close();
+
+  GraphId tile_id;
+  ASSERT_TRUE(pipeline.Next(tile_id));
+  EXPECT_EQ(tile_id, b);
+  ASSERT_TRUE(pipeline.Next(tile_id));
+  EXPECT_EQ(tile_id, a);
+  // c was never written so closing the pipeline ends it
+  EXPECT_FALSE(pipeline.Next(tile_id));
+}
+
+TEST(TilePipeline, WaitForPending) {
+  TilePipeline pipeline({a, b});
+  // tiles which are not built are there already
+  pipeline.Wait(c);
+
+  std::atomic<bool> waited(false);
+  std::thread waiter([&]() {
+    pipeline.Wait(a);
+    waited = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(waited);
+  pipeline.Done(a);
+  waiter.join();
+  EXPECT_TRUE(waited);
+
+  // closing releases the waits for tiles which never come
+  std::thread closer([&pipeline]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pipeline.Close();
+  });
+  pipeline.Wait(b);
+  closer.join();
+}
+
+TEST(TilePipeline, ConsumersTakeEachTileOnce) {
+  std::unordered_set<GraphId> tiles;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    tiles.emplace(i, 2, 0);
+  }
+  TilePipeline pipeline(tiles);
+
+  std::vector<std::atomic<int>> taken(tiles.size());
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 4; ++i) {
+    consumers.emplace_back([&]() {
+      GraphId tile_id;
+      while (pipeline.Next(tile_id)) {
+        ++taken[tile_id.tileid()];
+      }
+    });
+  }
+  std::vector<std::thread> producers;
+  for (uint32_t i = 0; i < 4; ++i) {
+    producers.emplace_back([&pipeline, i]() {
+      for (uint32_t tile = i; tile < 1000; tile += 4) {
+        pipeline.Done(GraphId(tile, 2, 0));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  pipeline.Close();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+
+  for (const auto& count : taken) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+} // namespace
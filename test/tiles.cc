@@ -4,6 +4,7 @@
 #include "midgard/pointll.h"
 #include "midgard/util.h"
 
+#include <algorithm>
 #include <random>
 
 #include "test.h"
@@ -346,6 +347,60 @@ TEST(Tiles, test_random_linestring) {
   }
 }
 
+TEST(Tiles, test_intersect_into_buffer) {
+  Tiles<Point2> t(AABB2<Point2>{-10, -10, 10, 10}, 1, 5);
+  std::mt19937 generator;
+  std::uniform_real_distribution<> distribution(-12, 12);
+  std::vector<Tiles<Point2>::cell_t> cells;
+  for (int i = 0; i < 500; ++i) {
+    std::vector<Point2> linestring;
+    for (int j = 0; j < 20; ++j)
+      linestring.emplace_back(distribution(generator), distribution(generator));
+
+    // the buffer is appended to and gets the same cells as the map
+    cells.assign(1, {-1, 0});
+    t.Intersect(linestring, cells);
+    ASSERT_EQ(cells.front().first, -1);
+    intersect_t from_buffer;
+    for (auto cell = std::next(cells.begin()); cell != cells.end(); ++cell) {
+      from_buffer[cell->first].insert(cell->second);
+      ASSERT_NE(*cell, *std::prev(cell)) << "Consecutive cells should differ";
+    }
+    intersect_t from_map;
+    for (const auto& tile : t.Intersect(linestring))
+      from_map[tile.first].insert(tile.second.begin(), tile.second.end());
+    ASSERT_EQ(from_buffer, from_map);
+  }
+
+  // the cells come in the order the linestring crosses them
+  cells.clear();
+  t.Intersect(std::vector<Point2>{{-9.9, -9.9}, {-7.9, -9.9}}, cells);
+  ASSERT_EQ(cells.size(), 11);
+  for (size_t i = 0; i < cells.size(); ++i)
+    EXPECT_EQ(cells[i], Tiles<Point2>::cell_t(i / 5, i % 5));
+}
+
+TEST(Tiles, test_ellipse_into_buffer) {
+  Tiles<PointLL> t(AABB2<PointLL>{-180, -90, 180, 90}, 1);
+  std::mt19937 generator;
+  std::uniform_real_distribution<> distribution(-20, 20);
+  std::vector<int32_t> tiles;
+  for (int i = 0; i < 200; ++i) {
+    Ellipse<PointLL> ellipse({distribution(generator), distribution(generator)},
+                             {distribution(generator), distribution(generator)},
+                             std::abs(distribution(generator)) / 4);
+    tiles.assign(1, -1);
+    t.TileList(ellipse, tiles);
+    ASSERT_EQ(tiles.front(), -1);
+    std::vector<int32_t> expected = t.TileList(ellipse);
+    std::sort(expected.begin(), expected.end());
+    std::sort(tiles.begin() + 1, tiles.end());
+    ASSERT_TRUE(std::equal(tiles.begin() + 1, tiles.end(), expected.begin(), expected.end()));
+    for (auto tile : expected)
+      ASSERT_NE(ellipse.DoesIntersect(t.TileBounds(tile)), IntersectCase::kOutside);
+  }
+}
+
 template <class coord_t>
 std::pair<int32_t, int32_t> to_xy(std::tuple<int32_t, unsigned short, float> tile,
                                   const Tiles<coord_t>& t) {
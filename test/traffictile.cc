@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include "baldr/graphtile.h"
 #include "baldr/traffictile.h"
+#include "baldr/trafficupdater.h"
+#include "filesystem.h"
+#include "microtar.h"
+#include "midgard/sequence.h"
 
 namespace {
 class UnmanagedGraphMemory : public valhalla::baldr::GraphMemory {
@@ -45,12 +50,18 @@ TEST(Traffic, TileConstruction) {
   EXPECT_EQ(speed.get_speed(0), 98);
   EXPECT_EQ(speed.get_speed(1), UNKNOWN_TRAFFIC_SPEED_RAW << 1);
 
+  // Writers bump the generation after updating the speeds
+  EXPECT_EQ(tile.generation(), 0);
+  testdata.header.generation = 5;
+  EXPECT_EQ(tile.generation(), 5);
+
   // Verify the version
   EXPECT_EQ(3, TRAFFIC_TILE_VERSION);
   // Test with an invalid version
   testdata.header.traffic_tile_version = 78;
   auto const volatile& invalid_speed = tile.trafficspeed(2);
   EXPECT_FALSE(invalid_speed.speed_valid());
+  EXPECT_EQ(tile.generation(), 0);
 }
 
 TEST(Traffic, NullTileConstruction) {
@@ -116,6 +127,74 @@ TEST(Traffic, SpeedValid) {
   EXPECT_EQ(speed.encoded_speed1, 0);
 }
 
+TEST(Traffic, Updater) {
+  using namespace valhalla::baldr;
+  const std::string extract = "test/data/traffic_updater.tar";
+
+  // two empty traffic tiles of 3 and 5 edges
+  const GraphId tile_a(5, 2, 0), tile_b(7, 1, 0);
+  mtar_t tar;
+  ASSERT_EQ(mtar_open(&tar, extract.c_str(), "w"), MTAR_ESUCCESS);
+  for (const auto& tile : {std::make_pair(tile_a, 3u), std::make_pair(tile_b, 5u)}) {
+    std::string data(sizeof(TrafficTileHeader) + tile.second * sizeof(TrafficSpeed), '\0');
+    auto* header = reinterpret_cast<TrafficTileHeader*>(&data[0]);
+    header->tile_id = tile.first;
+    header->directed_edge_count = tile.second;
+    header->traffic_tile_version = TRAFFIC_TILE_VERSION;
+    const auto name = GraphTile::FileSuffix(tile.first);
+    ASSERT_EQ(mtar_write_file_header(&tar, name.c_str(), data.size()), MTAR_ESUCCESS);
+    ASSERT_EQ(mtar_write_data(&tar, data.data(), data.size()), MTAR_ESUCCESS);
+  }
+  mtar_finalize(&tar);
+  mtar_close(&tar);
+
+  {
+    TrafficUpdater updater(extract);
+    EXPECT_EQ(updater.tile_count(), 2);
+    auto written = updater.update({{GraphId(5, 2, 1), TrafficUpdater::speed(50, 10)},
+                                   {GraphId(7, 1, 4), TrafficUpdater::speed(0)},
+                                   {GraphId(5, 2, 1), TrafficUpdater::speed(80)},
+                                   {GraphId(5, 2, 3), TrafficUpdater::speed(30)},
+                                   {GraphId(9, 0, 0), TrafficUpdater::speed(30)}},
+                                  2, 1234);
+    // one edge is beyond the tile and another in a tile which isnt in the extract
+    EXPECT_EQ(written, 3);
+  }
+
+  // read them back the way the services do
+  valhalla::midgard::tar readback(extract);
+  auto speeds = [&](const GraphId& tile_id) {
+    const auto& entry = readback.contents.at(GraphTile::FileSuffix(tile_id));
+    return reinterpret_cast<const TrafficTileHeader*>(entry.first);
+  };
+  const auto* a = speeds(tile_a);
+  const auto* a_speeds = reinterpret_cast<const TrafficSpeed*>(a + 1);
+  EXPECT_EQ(a->generation, 1);
+  EXPECT_EQ(a->last_update, 1234);
+  EXPECT_FALSE(a_speeds[0].speed_valid());
+  // the last update of the edge wins
+  EXPECT_TRUE(a_speeds[1].speed_valid());
+  EXPECT_EQ(a_speeds[1].get_overall_speed(), 80);
+  EXPECT_EQ(a_speeds[1].get_speed(0), 80);
+  EXPECT_EQ(a_speeds[1].congestion1, UNKNOWN_CONGESTION_VAL);
+  EXPECT_FALSE(a_speeds[1].closed());
+  EXPECT_FALSE(a_speeds[2].speed_valid());
+
+  const auto* b = speeds(tile_b);
+  const auto* b_speeds = reinterpret_cast<const TrafficSpeed*>(b + 1);
+  EXPECT_EQ(b->generation, 1);
+  EXPECT_TRUE(b_speeds[4].closed());
+  EXPECT_FALSE(b_speeds[3].speed_valid());
+
+  // congestion is kept and speeds are clamped
+  auto congested = TrafficUpdater::speed(1000, 70);
+  EXPECT_EQ(congested.get_overall_speed(), MAX_TRAFFIC_SPEED_KPH);
+  EXPECT_EQ(congested.congestion1, MAX_CONGESTION_VAL);
+  EXPECT_TRUE(congested.closed(0));
+
+  filesystem::remove(extract);
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,4 +1,8 @@
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include "mjolnir/uniquenames.h"
 
@@ -45,6 +49,47 @@ TEST(UniqueNames, TestAddAndIndex) {
   EXPECT_EQ(names.name(index6), "I-95 N");
 }
 
+TEST(UniqueNames, WriteAndRead) {
+  UniqueNames names;
+  std::vector<std::string> added;
+  for (int i = 0; i < 1000; ++i) {
+    added.push_back("Street " + std::to_string(i));
+    EXPECT_EQ(names.index(added.back()), i + 1);
+  }
+  ASSERT_TRUE(names.Write("test_unique_names.bin"));
+
+  // The names come back at the same indexes and new ones continue after them
+  UniqueNames mapped;
+  mapped.index("gone after reading");
+  ASSERT_TRUE(mapped.Read("test_unique_names.bin"));
+  EXPECT_EQ(mapped.Size(), 1000);
+  EXPECT_EQ(mapped.name(0), "");
+  EXPECT_EQ(mapped.name(5000), "");
+  for (size_t i = 0; i < added.size(); ++i) {
+    EXPECT_EQ(mapped.name(i + 1), added[i]);
+    EXPECT_EQ(mapped.index(added[i]), i + 1);
+  }
+  EXPECT_EQ(mapped.index("gone after reading"), 1001);
+  EXPECT_EQ(mapped.index(std::string("with\0null", 9)), 1002);
+  EXPECT_EQ(mapped.name(1002), std::string("with\0null", 9));
+
+  // Writing over the mapped file keeps all of the names
+  ASSERT_TRUE(mapped.Write("test_unique_names.bin"));
+  EXPECT_EQ(mapped.name(7), added[6]);
+  UniqueNames reread;
+  ASSERT_TRUE(reread.Read("test_unique_names.bin"));
+  EXPECT_EQ(reread.Size(), 1002);
+  EXPECT_EQ(reread.index("gone after reading"), 1001);
+  EXPECT_EQ(reread.name(1000), added.back());
+  EXPECT_EQ(reread.index("new"), 1003);
+
+  // Files which are not names are refused
+  std::ofstream("test_unique_names.bin") << "not names";
+  EXPECT_FALSE(reread.Read("test_unique_names.bin"));
+  EXPECT_EQ(reread.name(1003), "new");
+  std::remove("test_unique_names.bin");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
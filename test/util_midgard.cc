@@ -765,6 +765,38 @@ TEST(UtilMidgard, TriangleContains) {
   EXPECT_FALSE(triangle_contains(a, b, c, PointLL{(c.x() + b.x()) / 2, (c.y() + b.y()) / 2}));
 }
 
+TEST(UtilMidgard, HilbertIndex) {
+  EXPECT_EQ(hilbert_index(0, 0, 1), 0);
+  EXPECT_EQ(hilbert_index(0, 1, 1), 1);
+  EXPECT_EQ(hilbert_index(1, 1, 1), 2);
+  EXPECT_EQ(hilbert_index(1, 0, 1), 3);
+
+  // every cell is on the curve once and each one is next to the one before it
+  constexpr uint32_t order = 5, side = 1u << order;
+  std::vector<std::pair<uint32_t, uint32_t>> cells(side * side, {side, side});
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const auto index = hilbert_index(x, y, order);
+      ASSERT_LT(index, cells.size());
+      EXPECT_EQ(cells[index].first, side) << "index " << index << " twice";
+      cells[index] = {x, y};
+    }
+  }
+  EXPECT_EQ(cells.front(), std::make_pair(0u, 0u));
+  EXPECT_EQ(cells.back(), std::make_pair(side - 1, 0u));
+  for (size_t i = 1; i < cells.size(); ++i) {
+    const int dx =
+        std::abs(static_cast<int>(cells[i].first) - static_cast<int>(cells[i - 1].first));
+    const int dy =
+        std::abs(static_cast<int>(cells[i].second) - static_cast<int>(cells[i - 1].second));
+    EXPECT_EQ(dx + dy, 1) << "index " << i;
+  }
+
+  // the full 32 bits of each coordinate fit
+  EXPECT_EQ(hilbert_index(std::numeric_limits<uint32_t>::max(), 0, 32),
+            std::numeric_limits<uint64_t>::max());
+}
+
 TEST(UtilMidgard, PolygonArea) {
   std::vector<PointLL> a{{1, 1}, {2, 2}, {3, 1}};
   {
@@ -781,6 +813,45 @@ TEST(UtilMidgard, PolygonArea) {
   }
 }
 
+TEST(UtilMidgard, ProjectorClosestSegment) {
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> offset(-0.001, 0.001);
+  shape_soa_t shape;
+  for (size_t n = 2; n < 40; ++n) {
+    projector_t projector(PointLL(13.26 + offset(generator), 38.15 + offset(generator)));
+    std::vector<PointLL> points;
+    for (size_t i = 0; i < n; ++i) {
+      points.emplace_back(13.26 + offset(generator), 38.15 + offset(generator));
+    }
+    // zero length segments project to their only point
+    points[n / 2] = points[n / 2 - 1];
+    auto encoded = encode7(points);
+    Shape7Decoder<PointLL> decoder(encoded.c_str(), encoded.size());
+    shape.decode(decoder);
+    ASSERT_EQ(shape.size(), n);
+
+    // surveying the segments one at a time keeps the first closest one
+    size_t expected_segment = 0;
+    PointLL expected_point;
+    double expected_distance = std::numeric_limits<double>::max();
+    for (size_t i = 0; i + 1 < n; ++i) {
+      auto point = projector(shape.point(i), shape.point(i + 1));
+      auto distance = projector.approx.DistanceSquared(point);
+      if (distance < expected_distance) {
+        expected_segment = i;
+        expected_point = point;
+        expected_distance = distance;
+      }
+    }
+
+    PointLL point;
+    double distance;
+    EXPECT_EQ(projector.closest_segment(shape, point, distance), expected_segment);
+    EXPECT_EQ(point, expected_point);
+    EXPECT_EQ(distance, expected_distance);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -17,6 +17,24 @@ TEST(UtilOdin, test_get_locales) {
   EXPECT_NE(init.find("en-US"), init.cend()) << "Should find 'en-US' locales file";
 }
 
+TEST(UtilOdin, test_get_locale) {
+  // an alias shares the dictionary of its locale
+  const auto en_us = get_locale("en-US");
+  ASSERT_NE(en_us, nullptr);
+  EXPECT_EQ(en_us->GetLanguageTag(), "en-US");
+  EXPECT_EQ(get_locale("en"), en_us);
+  EXPECT_EQ(get_locale("xx-XX"), nullptr);
+
+  EXPECT_TRUE(is_locale_supported("de"));
+  EXPECT_TRUE(is_locale_supported("de-DE"));
+  EXPECT_FALSE(is_locale_supported("xx-XX"));
+
+  // loading them all hands out the same dictionaries
+  preload_locales({"de", "xx-XX"});
+  EXPECT_EQ(get_locales().at("en-US"), en_us);
+  EXPECT_EQ(get_locales().at("de"), get_locale("de-DE"));
+}
+
 void try_get_formatted_time(const std::string& date_time,
                             const std::string& expected_date_time,
                             const std::locale& locale) {
@@ -0,0 +1,66 @@
+#include "baldr/verbal_text_pattern.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+
+namespace {
+
+using Pattern = VerbalTextPattern;
+
+TEST(VerbalTextPattern, TestGreedyGivesBack) {
+  // (\bCR)([ -])([[:alpha:]]{1,2})?(\d{1,4})([[:alpha:]]{1,2})?\b ignoring case
+  Pattern county({Pattern::WordBoundary(1), Pattern::Text(1, "CR"),
+                  Pattern::Set(2, Pattern::Chars(" -")),
+                  Pattern::Set(3, Pattern::Letters(), 1, 2).Optional(),
+                  Pattern::Set(4, Pattern::Digits(), 1, 4),
+                  Pattern::Set(5, Pattern::Letters(), 1, 2).Optional(), Pattern::WordBoundary(0)},
+                 true);
+  EXPECT_EQ(county.Replace("cr 12A", "County Route $3$4$5"), "County Route 12A");
+  EXPECT_EQ(county.Replace("CR-A12 North", "County Route $3$4$5"), "County Route A12 North");
+  EXPECT_EQ(county.Replace("CR 12ABC", "County Route $3$4$5"), "CR 12ABC");
+  EXPECT_EQ(county.Replace("CR 12345", "County Route $3$4$5"), "CR 12345");
+  EXPECT_EQ(county.Replace("OCR 12", "County Route $3$4$5"), "OCR 12");
+}
+
+TEST(VerbalTextPattern, TestGroups) {
+  // (\D*)(\d+)(st|nd|rd|th)?(\D*) ignoring case
+  Pattern numbers({Pattern::Set(1, Pattern::NonDigits(), 0, Pattern::kUnbounded),
+                   Pattern::Set(2, Pattern::Digits(), 1, Pattern::kUnbounded),
+                   Pattern::AnyText(3, {"st", "nd", "rd", "th"}).Optional(),
+                   Pattern::Set(4, Pattern::NonDigits(), 0, Pattern::kUnbounded)},
+                  true);
+  const std::string text = "West 42ND Street 7";
+  Pattern::Match match;
+  ASSERT_TRUE(numbers.Search(text, 0, match));
+  EXPECT_EQ(match[1].str(), "West ");
+  EXPECT_EQ(match[2].str(), "42");
+  EXPECT_TRUE(match[3].matched);
+  EXPECT_EQ(match[3].str(), "ND");
+  EXPECT_EQ(match[4].str(), " Street ");
+  ASSERT_TRUE(numbers.Search(text, match[0].end, match));
+  EXPECT_TRUE(match[1].matched);
+  EXPECT_EQ(match[1].str(), "");
+  EXPECT_EQ(match[2].str(), "7");
+  EXPECT_FALSE(match[3].matched);
+  EXPECT_FALSE(numbers.Search("No numbers", 0, match));
+}
+
+TEST(VerbalTextPattern, TestAnchors) {
+  // (^|\D)([1-9]{1,2})(000$)
+  Pattern thousand({Pattern::BeginOrSet(1, Pattern::NonDigits()),
+                    Pattern::Set(2, Pattern::Range('1', '9'), 1, 2), Pattern::Text(3, "000"),
+                    Pattern::End(3)});
+  EXPECT_EQ(thousand.Replace("2000", "$1$2 thousand"), "2 thousand");
+  EXPECT_EQ(thousand.Replace("Road 12000", "$1$2 thousand"), "Road 12 thousand");
+  EXPECT_EQ(thousand.Replace("Road 112000", "$1$2 thousand"), "Road 112000");
+  EXPECT_EQ(thousand.Replace("2000 Road", "$1$2 thousand"), "2000 Road");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -536,6 +536,173 @@ TEST(ViterbiSearch, TestTopKSearch) {
   }
 }
 
+TEST(ViterbiSearch, TestListViterbiSearch) {
+  for (size_t i = 0; i < 20; ++i) {
+    const auto& columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(1, 10),
+        // emission costs
+        std::uniform_int_distribution<int>(1, 10),
+        generate_column_counts(4,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(1, 5)));
+
+    std::vector<std::vector<StateId>> stateids(columns.size());
+    for (StateId::Time time = 0; time < columns.size(); time++) {
+      for (uint32_t idx = 0; idx < columns[time].size(); idx++) {
+        stateids[time].emplace_back(time, idx);
+      }
+    }
+    ListViterbiSearch lvs(stateids, EmissionCostModel(columns), TransitionCostModel(columns));
+
+    // every path comes out once in the order of its cost
+    std::vector<StateId> path;
+    for (const auto& pc : sort_all_paths(columns)) {
+      const auto cost = lvs.Next(path);
+      validate_path(columns, path);
+      EXPECT_EQ(cost, pc.cost()) << "Wrong cost for the next path";
+      EXPECT_EQ(total_cost(columns, path), pc.cost()) << "Wrong total cost of the next path";
+    }
+    EXPECT_LT(lvs.Next(path), 0) << "There should be no more paths";
+    EXPECT_TRUE(path.empty());
+  }
+}
+
+TEST(ViterbiSearch, TestConvergedStateId) {
+  for (size_t i = 0; i < 20; ++i) {
+    auto columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(0, 50),
+        // emission costs
+        std::uniform_int_distribution<int>(0, 100),
+        generate_column_counts(200,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(1, 5)));
+
+    ViterbiSearch vs;
+    vs.set_emission_cost_model(EmissionCostModel(columns));
+    vs.set_transition_cost_model(TransitionCostModel(columns));
+
+    // add the columns one at a time like an online match would
+    std::vector<StateId> converged;
+    for (StateId::Time time = 0; time < columns.size(); time++) {
+      for (uint32_t idx = 0; idx < columns[time].size(); idx++) {
+        vs.AddStateId(StateId(time, idx));
+      }
+      vs.SearchWinner(time);
+      const auto stateid = vs.ConvergedStateId();
+      if (stateid.IsValid()) {
+        EXPECT_LE(stateid.time(), time);
+        // a single state column is somewhere every path has to go through
+        if (columns[time].size() == 1) {
+          EXPECT_EQ(stateid, StateId(time, 0));
+        }
+        converged.push_back(stateid);
+      }
+    }
+    EXPECT_FALSE(converged.empty());
+
+    // whatever converged along the way has to be on the final best path
+    std::vector<StateId> path;
+    std::copy(vs.SearchPathVS(columns.size() - 1), vs.PathEnd(), std::back_inserter(path));
+    std::reverse(path.begin(), path.end());
+    for (const auto& stateid : converged) {
+      EXPECT_EQ(path[stateid.time()], stateid);
+    }
+  }
+}
+
+TEST(ViterbiSearch, TestReuseAcrossTraces) {
+  ViterbiSearch reused;
+  for (size_t i = 0; i < 10; ++i) {
+    const auto columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(0, 50),
+        // emission costs
+        std::uniform_int_distribution<int>(0, 100),
+        generate_column_counts(50,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(0, 8)));
+
+    // the labels left over from the previous trace must not leak into this one
+    reused.Clear();
+    ViterbiSearch fresh;
+    for (auto* vs : {&reused, &fresh}) {
+      vs->set_emission_cost_model(EmissionCostModel(columns));
+      vs->set_transition_cost_model(TransitionCostModel(columns));
+      AddColumns(*vs, columns);
+    }
+
+    const StateId::Time time = columns.size() - 1;
+    for (int search = 0; search < 2; ++search) {
+      std::vector<StateId> expected, path;
+      std::copy(fresh.SearchPathVS(time), fresh.PathEnd(), std::back_inserter(expected));
+      std::copy(reused.SearchPathVS(time), reused.PathEnd(), std::back_inserter(path));
+      EXPECT_EQ(path, expected);
+      // and neither must the labels of the previous search
+      reused.ClearSearch();
+      fresh.ClearSearch();
+    }
+  }
+}
+
+TEST(ViterbiSearch, TestBeamSearch) {
+  for (size_t i = 0; i < 10; ++i) {
+    const auto columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(0, 50),
+        // emission costs
+        std::uniform_int_distribution<int>(0, 100),
+        generate_column_counts(100,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(1, 10)));
+
+    ViterbiSearch full, wide, narrow, cheap;
+    wide.set_beam(10, 0);
+    narrow.set_beam(1, 0);
+    cheap.set_beam(0, 20);
+    for (auto* vs : {&full, &wide, &narrow, &cheap}) {
+      vs->set_emission_cost_model(EmissionCostModel(columns));
+      vs->set_transition_cost_model(TransitionCostModel(columns));
+      AddColumns(*vs, columns);
+    }
+
+    // only compare paths going through every column
+    const auto unbroken = [&columns](const ViterbiSearch& vs, const std::vector<StateId>& path) {
+      if (path.size() != columns.size() || !path.front().IsValid()) {
+        return false;
+      }
+      for (size_t time = 1; time < path.size(); ++time) {
+        if (vs.Predecessor(path[time]) != path[time - 1]) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    const StateId::Time time = columns.size() - 1;
+    std::vector<StateId> expected, path;
+    std::copy(full.SearchPathVS(time), full.PathEnd(), std::back_inserter(expected));
+    std::reverse(expected.begin(), expected.end());
+
+    // a beam as wide as the columns prunes nothing
+    std::copy(wide.SearchPathVS(time), wide.PathEnd(), std::back_inserter(path));
+    std::reverse(path.begin(), path.end());
+    EXPECT_EQ(path, expected);
+
+    // narrower ones may miss the best path but whatever they find is a path and no cheaper
+    for (auto* vs : {&narrow, &cheap}) {
+      path.clear();
+      std::copy(vs->SearchPathVS(time), vs->PathEnd(), std::back_inserter(path));
+      std::reverse(path.begin(), path.end());
+      if (unbroken(full, expected) && unbroken(*vs, path)) {
+        validate_path(columns, path);
+        EXPECT_GE(total_cost(columns, path), total_cost(columns, expected));
+      }
+    }
+  }
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
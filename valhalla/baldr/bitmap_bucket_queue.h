@@ -0,0 +1,388 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/graphconstants.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace valhalla {
+namespace baldr {
+
+namespace detail {
+
+/**
+ * Index of the lowest set bit of a non-zero word.
+ * @param  word  the word to scan, must not be 0
+ * @return the index of the lowest set bit
+ */
+inline uint32_t lowest_bit(const uint64_t word) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<uint32_t>(index);
+#else
+  return static_cast<uint32_t>(__builtin_ctzll(word));
+#endif
+}
+
+} // namespace detail
+
+/**
+ * Bitmap indexed bucket queue - a drop-in alternative to DoubleBucketQueue with the same interface
+ * and the same approximate ordering (labels within a bucket come out in LIFO order).
+ *
+ * It differs in two ways:
+ *  - an occupancy bitmap is kept next to the low level buckets so that finding the next non-empty
+ *    bucket checks 64 buckets per word instead of walking them one by one
+ *  - instead of a single overflow bucket, which DoubleBucketQueue scans and partitions in full
+ *    every time the low level buckets run dry, costs beyond the current range go into a ring of
+ *    kRingSize coarse buckets one range wide, again with an occupancy mask. When the low level
+ *    buckets run dry only the next coarse bucket is redistributed. Only costs further out than the
+ *    ring end up in a final overflow bucket, which is pulled into the ring as the range advances.
+ *    A decrease out of a coarse bucket leaves a stale entry behind instead of searching for it,
+ *    stale entries are dropped when the coarse bucket is distributed
+ *
+ * Every label index is moved at most a handful of times no matter how far the costs spread out,
+ * which is what makes the difference on long routes where the overflow path is hot.
+ */
+template <typename label_t> class BitmapBucketQueue final {
+public:
+  // Number of coarse buckets (each one range wide) beyond the current range
+  static constexpr uint32_t kRingSize = 64;
+
+  /**
+   * Default c-tor creates empty object that needs to be initialized with `reuse` method
+   */
+  BitmapBucketQueue() {
+    reuse(0.f, 1.f, 1, nullptr);
+  }
+
+  /**
+   * Constructor given a minimum cost, a range of costs held within the
+   * bucket sort, and a bucket size. All costs above mincost + range are
+   * stored in coarse buckets.
+   * @param mincost    Minimum cost. Used to create the initial range for
+   *                   bucket sorting.
+   * @param range      Cost range for low-level buckets.
+   * @param bucketsize Bucket size (range of costs within same bucket).
+   *                   Must be an integer value.
+   * @param labelcontainer  Container of labels with sortcosts.
+   */
+  BitmapBucketQueue(const float mincost,
+                    const float range,
+                    const uint32_t bucketsize,
+                    const std::vector<label_t>* labelcontainer) {
+    reuse(mincost, range, bucketsize, labelcontainer);
+  }
+
+  BitmapBucketQueue(BitmapBucketQueue&&) = default;
+  BitmapBucketQueue& operator=(BitmapBucketQueue&&) = default;
+  BitmapBucketQueue(const BitmapBucketQueue&) = delete;
+  BitmapBucketQueue& operator=(const BitmapBucketQueue&) = delete;
+
+  /**
+   * The same as c-tor, but without buffers reallocation. Before call this
+   * method you should clean up the current state (call `clear`).
+   * @param mincost    Minimum cost. Used to create the initial range for
+   *                   bucket sorting.
+   * @param range      Cost range for low-level buckets.
+   * @param bucketsize Bucket size (range of costs within same bucket).
+   *                   Must be an integer value.
+   * @param labelcontainer  Container of labels with sortcosts.
+   */
+  void reuse(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const std::vector<label_t>* labelcontainer) {
+    labelcontainer_ = labelcontainer;
+    // We need at least a bucketsize of 1 or more
+    if (bucketsize < 1) {
+      throw std::runtime_error("Bucketsize must be 1 or greater");
+    }
+
+    // We need at least a bucketrange of something larger than 0
+    if (range <= 0.f) {
+      throw std::runtime_error("Bucketrange must be greater than 0");
+    }
+
+    // Adjust min cost to be the start of a bucket
+    const uint32_t c = static_cast<uint32_t>(mincost);
+    origin_ = (c - (c % bucketsize));
+    inv_ = 1.0 / bucketsize;
+
+    // Allocate the low-level buckets and their occupancy bits
+    bucketcount_ = static_cast<uint32_t>(range / bucketsize) + 1;
+    buckets_.resize(bucketcount_);
+    occupied_.assign((bucketcount_ + 63) / 64, 0);
+
+    window_ = 0;
+    current_ = 0;
+    ring_mask_ = 0;
+    overflow_min_window_ = 0;
+  }
+
+  /**
+   * Clear all labels from the low-level buckets, the coarse buckets and the overflow bucket
+   */
+  void clear() {
+    for (size_t word = 0; word < occupied_.size(); ++word) {
+      for (uint64_t bits = occupied_[word]; bits; bits &= bits - 1) {
+        buckets_[word * 64 + detail::lowest_bit(bits)].clear();
+      }
+      occupied_[word] = 0;
+    }
+    for (uint64_t bits = ring_mask_; bits; bits &= bits - 1) {
+      ring_[detail::lowest_bit(bits)].clear();
+    }
+    ring_mask_ = 0;
+    overflowbucket_.clear();
+
+    // Reset current bucket and cost
+    window_ = 0;
+    current_ = 0;
+    overflow_min_window_ = 0;
+  }
+
+  /**
+   * Adds a label index to the bucketed sort. Adds it to the appropriate bucket
+   * given the cost. If the cost is < the current bucket cost then the label is
+   * placed in the current bucket to prevent underflow.
+   * @param   label  Label index to add to the queue.
+   */
+  void add(const uint32_t label) {
+    insert(label, (*labelcontainer_)[label].sortcost());
+  }
+
+  /**
+   * The specified label index now has a smaller cost.  Reorders it in the
+   * sorted bucket list.
+   * @param  label        Label index to reorder.
+   * @param  newcost      New sort cost.
+   */
+  void decrease(const uint32_t label, const float newcost) {
+    // Nothing needs to be done if old cost and the new cost are in the same buckets.
+    const uint64_t prevabsolute = absolute_bucket((*labelcontainer_)[label].sortcost());
+    bucket_t& prevbucket = get_bucket(prevabsolute);
+    const uint64_t newabsolute = absolute_bucket(newcost);
+    if (&prevbucket == &get_bucket(newabsolute)) {
+      if (&prevbucket == &overflowbucket_) {
+        // Staying in the overflow bucket, but it may now be the cheapest one in there
+        overflow_min_window_ = std::min(overflow_min_window_, newabsolute / bucketcount_);
+      }
+      return;
+    }
+
+    // Coarse buckets can hold a whole range worth of labels so searching them is avoided. The
+    // stale entry is left behind and skipped when the coarse bucket is distributed, because by
+    // then the label cost no longer falls within that range
+    if (prevabsolute / bucketcount_ == window_ || &prevbucket == &overflowbucket_) {
+      auto found = std::find(prevbucket.begin(), prevbucket.end(), label);
+      if (found != prevbucket.end()) {
+        prevbucket.erase(found);
+      }
+    }
+    insert_absolute(label, newabsolute);
+  }
+
+  /**
+   * Removes the lowest cost label index from the sorted buckets.
+   * @return  Returns the label index of the lowest cost label. Returns
+   *          kInvalidLabel if the buckets are empty.
+   */
+  uint32_t pop() {
+    while (!find_current()) {
+      // The low level buckets are empty, move on to the next range
+      if (!advance()) {
+        return baldr::kInvalidLabel;
+      }
+    }
+
+    // Return label from lowest non-empty bucket
+    bucket_t& bucket = buckets_[current_];
+    const uint32_t label = bucket.back();
+    bucket.pop_back();
+    return label;
+  }
+
+private:
+  double origin_;        // Cost at the start of the very first bucket
+  double inv_;           // 1/bucketsize (so we can avoid division)
+  uint32_t bucketcount_; // Number of low level buckets, i.e. buckets per range
+  uint64_t window_;      // Which range (counted from origin_) the low level buckets hold
+  uint32_t current_;     // Index of the current low level bucket
+
+  // Low level buckets and a bit per bucket which is set when it may hold labels
+  buckets_t buckets_;
+  std::vector<uint64_t> occupied_;
+
+  // Coarse buckets for the next kRingSize ranges, indexed by range modulo kRingSize
+  std::array<bucket_t, kRingSize> ring_;
+  uint64_t ring_mask_;
+
+  // Anything beyond the ring and the lowest range found in there
+  bucket_t overflowbucket_;
+  uint64_t overflow_min_window_;
+
+  // Access to a container of labels to get cost given the label index.
+  const std::vector<label_t>* labelcontainer_;
+
+  /**
+   * @param  cost  Cost.
+   * @return the bucket a cost falls into counting from the origin, costs lower than the current
+   *         bucket are clamped to it
+   */
+  uint64_t absolute_bucket(const float cost) const {
+    const uint64_t current = window_ * bucketcount_ + current_;
+    const double offset = (cost - origin_) * inv_;
+    return offset <= current ? current : static_cast<uint64_t>(offset);
+  }
+
+  /**
+   * Returns the bucket given the absolute bucket index of a cost.
+   * @param  absolute  absolute bucket index
+   * @return Returns the bucket that the cost lies within.
+   */
+  bucket_t& get_bucket(const uint64_t absolute) {
+    const uint64_t window = absolute / bucketcount_;
+    if (window == window_) {
+      return buckets_[absolute % bucketcount_];
+    }
+    if (window - window_ <= kRingSize) {
+      return ring_[window % kRingSize];
+    }
+    return overflowbucket_;
+  }
+
+  void insert(const uint32_t label, const float cost) {
+    insert_absolute(label, absolute_bucket(cost));
+  }
+
+  void insert_absolute(const uint32_t label, const uint64_t absolute) {
+    const uint64_t window = absolute / bucketcount_;
+    if (window == window_) {
+      const uint32_t index = absolute % bucketcount_;
+      buckets_[index].push_back(label);
+      occupied_[index / 64] |= uint64_t(1) << (index % 64);
+    } else if (window - window_ <= kRingSize) {
+      ring_[window % kRingSize].push_back(label);
+      ring_mask_ |= uint64_t(1) << (window % kRingSize);
+    } else {
+      if (overflowbucket_.empty() || window < overflow_min_window_) {
+        overflow_min_window_ = window;
+      }
+      overflowbucket_.push_back(label);
+    }
+  }
+
+  /**
+   * Moves current_ to the lowest non-empty low level bucket, skipping a word at a time over the
+   * empty ones. Bits of buckets which were emptied by decrease are cleared along the way.
+   * @return  Returns false if the low-level buckets are all empty.
+   */
+  bool find_current() {
+    size_t word = current_ / 64;
+    uint64_t bits = occupied_[word] & (~uint64_t(0) << (current_ % 64));
+    while (true) {
+      while (bits == 0) {
+        if (++word == occupied_.size()) {
+          current_ = bucketcount_ - 1;
+          return false;
+        }
+        bits = occupied_[word];
+      }
+      const uint32_t index = word * 64 + detail::lowest_bit(bits);
+      if (!buckets_[index].empty()) {
+        current_ = index;
+        return true;
+      }
+      occupied_[word] &= ~(uint64_t(1) << (index % 64));
+      bits &= bits - 1;
+    }
+  }
+
+  /**
+   * Moves the low level buckets on to the next range that holds labels and distributes that
+   * range's coarse bucket into them.
+   * @return  Returns false if there are no more labels anywhere.
+   */
+  bool advance() {
+    while (true) {
+      if (ring_mask_ == 0) {
+        if (overflowbucket_.empty()) {
+          return false;
+        }
+        // Jump ahead so that the cheapest overflow labels land in the ring
+        window_ = overflow_min_window_ - 1;
+        current_ = bucketcount_ - 1;
+        pull_overflow();
+        continue;
+      }
+
+      // Find the nearest coarse bucket, rotating the mask so that it starts at window_ + 1
+      const uint32_t start = (window_ + 1) % kRingSize;
+      const uint64_t rotated =
+          start == 0 ? ring_mask_ : (ring_mask_ >> start) | (ring_mask_ << (kRingSize - start));
+      window_ += 1 + detail::lowest_bit(rotated);
+      current_ = 0;
+
+      // Spread its labels over the low level buckets
+      const uint32_t slot = window_ % kRingSize;
+      ring_mask_ &= ~(uint64_t(1) << slot);
+      bucket_t& coarse = ring_[slot];
+      const double window_start = static_cast<double>(window_) * bucketcount_;
+      for (const auto label : coarse) {
+        // Skip labels which were moved to a cheaper bucket by decrease. Their cost now lies below
+        // this range, which absolute_bucket would hide by clamping it to the current bucket
+        const double offset = ((*labelcontainer_)[label].sortcost() - origin_) * inv_;
+        if (offset >= window_start) {
+          insert_absolute(label, static_cast<uint64_t>(offset));
+        }
+      }
+      coarse.clear();
+
+      // The ring now reaches one range further
+      pull_overflow();
+      if (find_current()) {
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Moves the overflow labels which now fall within the ring (or the current range) out of the
+   * overflow bucket. overflow_min_window_ is only a lower bound since decrease may have taken the
+   * cheapest ones out, so it is recomputed here.
+   */
+  void pull_overflow() {
+    if (overflowbucket_.empty() || overflow_min_window_ > window_ + kRingSize) {
+      return;
+    }
+    uint64_t min_window = std::numeric_limits<uint64_t>::max();
+    auto remaining =
+        std::remove_if(overflowbucket_.begin(), overflowbucket_.end(), [&](const uint32_t label) {
+          const uint64_t absolute = absolute_bucket((*labelcontainer_)[label].sortcost());
+          const uint64_t window = absolute / bucketcount_;
+          if (window - window_ <= kRingSize) {
+            insert_absolute(label, absolute);
+            return true;
+          }
+          min_window = std::min(min_window, window);
+          return false;
+        });
+    overflowbucket_.erase(remaining, overflowbucket_.end());
+    overflow_min_window_ = min_window;
+  }
+};
+
+} // namespace baldr
+} // namespace valhalla
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -248,6 +249,98 @@ protected:
   // TODO - Maybe but need to consider the fact that we may add more date time data.
 };
 
+/**
+ * The complex restrictions of an edge for some access modes, as found in a tile. It walks the
+ * offsets of the restrictions for that edge in the sorted index of the tile's restrictions and
+ * skips the ones for other modes, without copying anything.
+ */
+class ComplexRestrictions {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ComplexRestriction*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ComplexRestriction**;
+    using reference = ComplexRestriction*;
+
+    iterator(const uint32_t* offset, const uint32_t* end, char* restrictions, uint64_t modes)
+        : offset_(offset), end_(end), restrictions_(restrictions), modes_(modes) {
+      skip();
+    }
+
+    ComplexRestriction* operator*() const {
+      return reinterpret_cast<ComplexRestriction*>(restrictions_ + *offset_);
+    }
+
+    iterator& operator++() {
+      ++offset_;
+      skip();
+      return *this;
+    }
+
+    bool operator==(const iterator& other) const {
+      return offset_ == other.offset_;
+    }
+
+    bool operator!=(const iterator& other) const {
+      return offset_ != other.offset_;
+    }
+
+  private:
+    void skip() {
+      while (offset_ != end_ && !((**this)->modes() & modes_)) {
+        ++offset_;
+      }
+    }
+
+    const uint32_t* offset_;
+    const uint32_t* end_;
+    char* restrictions_;
+    uint64_t modes_;
+  };
+
+  /**
+   * Constructor
+   * @param  begin         the first offset of the restrictions of the edge
+   * @param  end           one past the last offset of the restrictions of the edge
+   * @param  restrictions  the list of restrictions the offsets are into
+   * @param  modes         the access modes to keep the restrictions of
+   */
+  ComplexRestrictions(const uint32_t* begin,
+                      const uint32_t* end,
+                      char* restrictions,
+                      uint64_t modes)
+      : begin_(begin), end_(end), restrictions_(restrictions), modes_(modes) {
+  }
+
+  iterator begin() const {
+    return iterator(begin_, end_, restrictions_, modes_);
+  }
+
+  iterator end() const {
+    return iterator(end_, end_, restrictions_, modes_);
+  }
+
+  bool empty() const {
+    return begin() == end();
+  }
+
+  size_t size() const {
+    return std::distance(begin(), end());
+  }
+
+  ComplexRestriction* front() const {
+    return *begin();
+  }
+
+private:
+  const uint32_t* begin_;
+  const uint32_t* end_;
+  char* restrictions_;
+  uint64_t modes_;
+};
+
 } // namespace baldr
 } // namespace valhalla
 
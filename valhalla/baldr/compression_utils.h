@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <string>
 #include <zlib.h>
 
 namespace valhalla {
@@ -11,20 +12,24 @@ namespace baldr {
  * @param dst_func  function which modifies the stream to write more output
  * @param level     what compression level to use
  * @param gzip      whether or not to write a gzip header instead of a zlib one
+ * @param dictionary  preset dictionary to deflate with, only usable with the zlib wrapper
  * @return          returns true if the stream was successfully inflated, false otherwise
  */
 bool deflate(const std::function<int(z_stream&)>& src_func,
              const std::function<void(z_stream&)>& dst_func,
              int level = Z_BEST_COMPRESSION,
-             bool gzip = true);
+             bool gzip = true,
+             const std::string& dictionary = {});
 
 /* Inflates gzip or zlib wrapped deflated data
  * @param src_func  function which modifies the stream to read more input
  * @param dst_func  function which modifies the stream to write more output
+ * @param dictionary  preset dictionary the data was deflated with, if any
  * @return          returns true if the stream was successfully inflated, false otherwise
  */
 bool inflate(const std::function<void(z_stream&)>& src_func,
-             const std::function<int(z_stream&)>& dst_func);
+             const std::function<int(z_stream&)>& dst_func,
+             const std::string& dictionary = {});
 
 } // namespace baldr
 } // namespace valhalla
\ No newline at end of file
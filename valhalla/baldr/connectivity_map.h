@@ -3,6 +3,7 @@
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/pathlocation.h>
+#include <valhalla/midgard/sequence.h>
 
 #include <cstdint>
 #include <unordered_map>
@@ -16,7 +17,9 @@ class connectivity_map_t {
 public:
   /**
    * Constructs the connectivity map
-   * @param pt   the ptree sub child labeled mjolnir in the valhalla json config
+   * @param pt   the ptree sub child labeled mjolnir in the valhalla json config. If its
+   *             connectivity_map is a file written by Store it is mapped instead of going through
+   *             the tileset
    * @param graphreader optional pointer to the graph reader to use. If null, then the reader will be
    * constructed using pt.
    */
@@ -73,14 +76,46 @@ public:
    * @return Returns true if the level has data, false if it does not (no tiles present)
    */
   bool has_data(const uint32_t level) const {
-    auto c = colors.find(level);
-    return (c == colors.end()) ? false : c->second.size() > 0;
+    auto c = level_colors(level);
+    return c.first != c.second;
   }
 
+  /**
+   * Writes the colors of the tiles to a file the services can map when they start instead of going
+   * through the tileset. The file is written next to file_name and moved over it when complete so
+   * that it is safe to replace a file which is mapped
+   *
+   * @param file_name where to write the colors
+   */
+  void Store(const std::string& file_name) const;
+
 private:
+  struct tile_color_t {
+    uint32_t level;
+    uint32_t tileid;
+    uint64_t color;
+  };
+
+  /**
+   * Maps the colors written by Store, leaves nothing mapped if the file is not complete
+   * @param file_name the file to map
+   * @return true if the colors are mapped
+   */
+  bool map_colors(const std::string& file_name);
+
+  /**
+   * @param level the hierarchy level
+   * @return the range of colors of the tiles of the level sorted by tile id
+   */
+  std::pair<const tile_color_t*, const tile_color_t*> level_colors(const uint32_t level) const;
+
   uint32_t transit_level;
-  // this is a map(tile_level, map(tile_id, tile_color))
-  std::unordered_map<uint32_t, std::unordered_map<uint32_t, size_t>> colors;
+  // the colors of the tiles sorted by level and then tile id, either the ones made from the tileset
+  // or the ones in the mapped file
+  std::vector<tile_color_t> built;
+  midgard::mem_map<char> mapped;
+  const tile_color_t* colors_begin;
+  const tile_color_t* colors_end;
 };
 } // namespace baldr
 } // namespace valhalla
@@ -35,6 +35,21 @@ struct curler_t {
                                bool gzipped,
                                const interrupt_t* interrupt) const;
 
+  /**
+   * Fetch several urls at once. The transfers run concurrently over pooled keep-alive connections
+   * and, where the server supports it, are multiplexed over a single HTTP/2 connection
+   *
+   * @param  urls               the urls to fetch
+   * @param  http_codes         the codes we got back for each url, 0 if there was no response
+   * @param  gzipped            whether to request for gzip compressed data
+   * @param  interrupt          throws if request should be interrupted
+   * @return the bytes we fetched for each url, in the same order as the urls
+   */
+  std::vector<std::vector<char>> operator()(const std::vector<std::string>& urls,
+                                            std::vector<long>& http_codes,
+                                            bool gzipped,
+                                            const interrupt_t* interrupt) const;
+
   /**
    * Allow only moves and forbid copies. We don't want
    * several curlers to share the same state to completely exclude
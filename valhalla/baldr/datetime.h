@@ -140,14 +140,17 @@ void seconds_to_date(const uint64_t origin_seconds,
  * @param seconds since epoch in UTC zone
  * @return formated string like: 2020-08-12T14:17:09Z
  */
-inline std::string seconds_to_date_utc(const uint64_t seconds) {
-  std::stringstream ss;
-  std::chrono::seconds secs(seconds);
-  date::sys_seconds timestamp(secs);
-  auto t = std::chrono::system_clock::to_time_t(timestamp);
-  ss << std::put_time(std::gmtime(&t), "%FT%TZ");
-  return ss.str();
-}
+std::string seconds_to_date_utc(const uint64_t seconds);
+
+/**
+ * Get the offset from UTC of a timezone at a point in time. The offsets are cached per thread and
+ * timezone along with the range of time over which they apply, so only the first time in each
+ * range looks up the timezone.
+ * @param   seconds      seconds since epoch
+ * @param   time_zone    timezone
+ * @return  Returns the offset from UTC in seconds, 0 without a timezone.
+ */
+int32_t utc_offset(const uint64_t seconds, const date::time_zone* time_zone);
 
 /**
  * Get the dow mask.
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_BALDR_DIRECTEDEDGE_H_
 #define VALHALLA_BALDR_DIRECTEDEDGE_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/graphid.h>
@@ -1282,13 +1283,187 @@ protected:
 
 /**
  * Extended directed edge attribution. This structure provides the ability to add extra
- * attribution per directed edge without breaking backward compatibility. For now this structure
- * is unused.
+ * attribution per directed edge without breaking backward compatibility. For now it holds the
+ * reach of the edge (see loki::Reach) precomputed at build time for the default costings of the
+ * auto, pedestrian and bicycle modes.
  */
 class DirectedEdgeExt {
+public:
+  /**
+   * Get the maximum reach the stored reach was computed up to. Reach below this value is exact
+   * while reach equal to it means at least that much. 0 means no reach was stored.
+   * @return  Returns the maximum reach the stored reach was computed up to.
+   */
+  uint32_t reach_limit() const {
+    return reach_limit_;
+  }
+
+  /**
+   * Sets the maximum reach the stored reach was computed up to.
+   * @param  limit  the maximum reach, at most kMaxStoredReach
+   */
+  void set_reach_limit(const uint32_t limit) {
+    reach_limit_ = std::min(limit, kMaxStoredReach);
+  }
+
+  /**
+   * Get the stored outbound reach of the edge for the default costing of the given mode.
+   * @param  access  one of kAutoAccess, kPedestrianAccess or kBicycleAccess
+   * @return  Returns the outbound reach, 0 if none is stored for this mode
+   */
+  uint32_t outbound_reach(const uint32_t access) const {
+    switch (access) {
+      case kAutoAccess:
+        return auto_outbound_reach_;
+      case kPedestrianAccess:
+        return pedestrian_outbound_reach_;
+      case kBicycleAccess:
+        return bicycle_outbound_reach_;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Get the stored inbound reach of the edge for the default costing of the given mode.
+   * @param  access  one of kAutoAccess, kPedestrianAccess or kBicycleAccess
+   * @return  Returns the inbound reach, 0 if none is stored for this mode
+   */
+  uint32_t inbound_reach(const uint32_t access) const {
+    switch (access) {
+      case kAutoAccess:
+        return auto_inbound_reach_;
+      case kPedestrianAccess:
+        return pedestrian_inbound_reach_;
+      case kBicycleAccess:
+        return bicycle_inbound_reach_;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Sets the reach of the edge for the default costing of the given mode. Values are clamped to
+   * the reach limit.
+   * @param  access    one of kAutoAccess, kPedestrianAccess or kBicycleAccess
+   * @param  outbound  the outbound reach
+   * @param  inbound   the inbound reach
+   */
+  void set_reach(const uint32_t access, const uint32_t outbound, const uint32_t inbound) {
+    const uint32_t out = std::min(outbound, static_cast<uint32_t>(reach_limit_));
+    const uint32_t in = std::min(inbound, static_cast<uint32_t>(reach_limit_));
+    switch (access) {
+      case kAutoAccess:
+        auto_outbound_reach_ = out;
+        auto_inbound_reach_ = in;
+        break;
+      case kPedestrianAccess:
+        pedestrian_outbound_reach_ = out;
+        pedestrian_inbound_reach_ = in;
+        break;
+      case kBicycleAccess:
+        bicycle_outbound_reach_ = out;
+        bicycle_inbound_reach_ = in;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Largest reach that fits in the stored fields
+  static constexpr uint32_t kMaxStoredReach = 255;
 
 protected:
-  uint64_t spare0_ : 64;
+  uint64_t reach_limit_ : 8;               // Reach the values below were computed up to
+  uint64_t auto_outbound_reach_ : 8;       // Outbound reach for default auto costing
+  uint64_t auto_inbound_reach_ : 8;        // Inbound reach for default auto costing
+  uint64_t pedestrian_outbound_reach_ : 8; // Outbound reach for default pedestrian costing
+  uint64_t pedestrian_inbound_reach_ : 8;  // Inbound reach for default pedestrian costing
+  uint64_t bicycle_outbound_reach_ : 8;    // Outbound reach for default bicycle costing
+  uint64_t bicycle_inbound_reach_ : 8;     // Inbound reach for default bicycle costing
+  uint64_t spare0_ : 8;
+};
+
+/**
+ * The attributes of a directed edge that graph searches look at for every edge they expand,
+ * packed into 16 bytes. Tiles can store an array of these beside the directed edges so that
+ * expansions walk a compact array instead of the full records (see GraphTile::hot_directededge).
+ * Everything else, including what costing needs, stays in the DirectedEdge.
+ */
+class DirectedEdgeHot {
+public:
+  /**
+   * Copies the hot attributes out of a directed edge.
+   * @param  edge  the directed edge
+   */
+  explicit DirectedEdgeHot(const DirectedEdge& edge)
+      : endnode_(edge.endnode().value), opp_index_(edge.opp_index()),
+        leaves_tile_(edge.leaves_tile()), is_shortcut_(edge.is_shortcut()),
+        classification_(static_cast<uint64_t>(edge.classification())),
+        use_(static_cast<uint64_t>(edge.use())), length_(edge.length()), speed_(edge.speed()),
+        forwardaccess_(edge.forwardaccess()), reverseaccess_(edge.reverseaccess()),
+        restrictions_(edge.restrictions()) {
+  }
+
+  GraphId endnode() const {
+    return GraphId(endnode_);
+  }
+
+  uint32_t opp_index() const {
+    return opp_index_;
+  }
+
+  bool leaves_tile() const {
+    return leaves_tile_;
+  }
+
+  bool is_shortcut() const {
+    return is_shortcut_;
+  }
+
+  RoadClass classification() const {
+    return static_cast<RoadClass>(classification_);
+  }
+
+  Use use() const {
+    return static_cast<Use>(use_);
+  }
+
+  uint32_t length() const {
+    return length_;
+  }
+
+  uint32_t speed() const {
+    return speed_;
+  }
+
+  uint32_t forwardaccess() const {
+    return forwardaccess_;
+  }
+
+  uint32_t reverseaccess() const {
+    return reverseaccess_;
+  }
+
+  uint32_t restrictions() const {
+    return restrictions_;
+  }
+
+protected:
+  // 1st 8-byte word
+  uint64_t endnode_ : 46;       // End node of the directed edge
+  uint64_t opp_index_ : 7;      // Opposing directed edge index
+  uint64_t leaves_tile_ : 1;    // Does directed edge end in a different tile?
+  uint64_t is_shortcut_ : 1;    // True if this edge is a shortcut
+  uint64_t classification_ : 3; // Classification/importance of the road/path
+  uint64_t use_ : 6;            // Specific use types
+
+  // 2nd 8-byte word
+  uint64_t length_ : 24;        // Length in meters
+  uint64_t speed_ : 8;          // Speed (kph)
+  uint64_t forwardaccess_ : 12; // Access (bit mask) in forward direction
+  uint64_t reverseaccess_ : 12; // Access (bit mask) in reverse direction
+  uint64_t restrictions_ : 8;   // Restrictions - mask of local edge indexes at the end node
 };
 
 } // namespace baldr
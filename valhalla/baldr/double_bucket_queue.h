@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdint>
 #include <valhalla/baldr/graphconstants.h>
+#include <valhalla/midgard/tracepoints.h>
 #include <valhalla/midgard/util.h>
 #include <vector>
 
@@ -95,6 +96,7 @@ public:
 
     // Set the current bucket to the lowest cost low level bucket
     currentbucket_ = buckets_.begin();
+    redistributions_ = 0;
   }
 
   /**
@@ -174,6 +176,16 @@ public:
     return label;
   }
 
+  /**
+   * Returns how many times the low-level buckets ran out and were refilled from the overflow
+   * bucket since the queue was last set up. Many of them mean the bucket range is too small for
+   * the costs of the search.
+   * @return  Returns the number of redistributions.
+   */
+  uint32_t redistributions() const {
+    return redistributions_;
+  }
+
 private:
   float bucketrange_; // Total range of costs in lower level buckets
   float bucketsize_;  // Bucket size (range of costs in same bucket)
@@ -194,6 +206,9 @@ private:
   // Access to a container of labels to get cost given the label index.
   const std::vector<label_t>* labelcontainer_;
 
+  // How many times the overflow bucket was emptied into the low-level buckets
+  uint32_t redistributions_;
+
   /**
    * Returns the bucket given the cost.
    * @param  cost  Cost.
@@ -223,6 +238,8 @@ private:
    * low level buckets.
    */
   void empty_overflow() {
+    ++redistributions_;
+    VALHALLA_TRACE(queue_redistribution, overflowbucket_.size());
     // Get the minimum label so we can figure out where the new range should be
     auto itr =
         std::min_element(overflowbucket_.begin(), overflowbucket_.end(),
@@ -1,7 +1,9 @@
 #ifndef VALHALLA_BALDR_EDGEINFO_H_
 #define VALHALLA_BALDR_EDGEINFO_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <map>
 #include <string>
 #include <tuple>
@@ -26,6 +28,103 @@ constexpr float kElevationBinSize = 2.0f;
 constexpr float kMinElevation = -500.0f;
 constexpr float kMaxElevation = kMinElevation + (kElevationBinSize * kMaxStoredElevation);
 
+// Elevation profiles are stored in bins of a quarter meter, the first sample as its bin and every
+// other one as the difference to the one before it
+constexpr float kElevationProfileBinSize = 0.25f;
+constexpr uint32_t kMaxElevationSamples = 65535;
+
+/**
+ * The elevation along an edge, sampled evenly from the start to the end of its shape. It is a view
+ * into the tile which decodes the samples as it is iterated so reading it never allocates.
+ */
+class ElevationProfile {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = float;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const float*;
+    using reference = float;
+
+    const_iterator(const int8_t* deltas,
+                   const uint32_t index,
+                   const uint32_t size,
+                   const int32_t bin)
+        : deltas_(deltas), index_(index), size_(size), bin_(bin) {
+    }
+    float operator*() const {
+      return kMinElevation + bin_ * kElevationProfileBinSize;
+    }
+    const_iterator& operator++() {
+      // there is one difference less than there are samples
+      if (++index_ < size_) {
+        bin_ += deltas_[index_ - 1];
+      }
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return index_ != other.index_;
+    }
+
+  protected:
+    const int8_t* deltas_;
+    uint32_t index_;
+    uint32_t size_;
+    int32_t bin_;
+  };
+
+  /**
+   * An edge without a profile
+   */
+  ElevationProfile() : deltas_(nullptr), size_(0), first_bin_(0) {
+  }
+
+  /**
+   * @param encoded  pointer to the encoded profile within the tile
+   */
+  explicit ElevationProfile(const char* encoded);
+
+  /**
+   * @return the number of samples, 0 if the edge has no profile and otherwise at least 2
+   */
+  uint32_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const_iterator begin() const {
+    return const_iterator(deltas_, 0, size_, first_bin_);
+  }
+  const_iterator end() const {
+    return const_iterator(deltas_, size_, size_, 0);
+  }
+
+  /**
+   * Get the elevation part way along the shape of the edge, interpolated between the samples.
+   * @param  percent_along  how far along the shape, from 0 to 1
+   * @return the elevation in meters, kNoElevationData if the edge has no profile
+   */
+  float at(const double percent_along) const;
+
+  /**
+   * @return the size in bytes of the encoded profile with the given number of samples
+   */
+  static size_t encoded_size(const uint32_t samples) {
+    return samples < 2 ? 0 : 2 * sizeof(uint16_t) + samples - 1;
+  }
+
+protected:
+  const int8_t* deltas_;
+  uint32_t size_;
+  int32_t first_bin_;
+};
+
 // Name information. Information about names added to the names list within
 // the tile. A name can have a textual representation followed by optional
 // fields that provide additional information about the name.
@@ -80,8 +179,14 @@ public:
    * @param  ptr  Pointer to a bit of memory that has the info for this edge
    * @param  names_list  Pointer to the start of the text/names list.
    * @param  names_list_length  Length (bytes) of the text/names list.
+   * @param  shared_list  Pointer to the text dictionary the tile was built with, if any.
+   * @param  shared_list_length  Length (bytes) of the text dictionary.
    */
-  EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length);
+  EdgeInfo(char* ptr,
+           const char* names_list,
+           const size_t names_list_length,
+           const char* shared_list = nullptr,
+           const size_t shared_list_length = 0);
 
   /**
    * Destructor
@@ -107,6 +212,21 @@ public:
     return kMinElevation + (ei_.mean_elevation_ * kElevationBinSize);
   }
 
+  /**
+   * Get the elevation profile along the shape of the edge. It is only there when the tile was built
+   * with elevation, tunnels and ferries have none.
+   * @return  Returns the profile, empty if the edge has none.
+   */
+  ElevationProfile elevation_profile() const {
+    return ei_.has_elevation_ ? ElevationProfile(encoded_elevation_) : ElevationProfile();
+  }
+
+  /**
+   * Returns the encoded elevation profile, empty if the edge has none.
+   * @return  Returns the encoded elevation profile.
+   */
+  std::string encoded_elevation() const;
+
   /**
    * Get the bike network mask for this directed edge.
    * @return  Returns the bike network mask for this directed edge.
@@ -259,7 +379,8 @@ public:
     uint32_t encoded_shape_size_ : 16; // How many bytes long the encoded shape is
     uint32_t extended_wayid1_ : 8;     // Next next byte of the way id
     uint32_t extended_wayid_size_ : 2; // How many more bytes the way id is stored in
-    uint32_t spare0_ : 2;              // not used
+    uint32_t has_elevation_ : 1;       // Whether an elevation profile follows the way id
+    uint32_t spare0_ : 1;              // not used
   };
 
 protected:
@@ -276,6 +397,9 @@ protected:
   uint8_t extended_wayid2_;
   uint8_t extended_wayid3_;
 
+  // The encoded elevation profile of the edge, if it has one
+  const char* encoded_elevation_;
+
   // Lng, lat shape of the edge
   mutable std::vector<midgard::PointLL> shape_;
 
@@ -285,6 +409,19 @@ protected:
   // The size of the names list
   size_t names_list_length_;
 
+  // The text dictionary the tile was built with, the offsets past it are into the names list
+  const char* shared_list_;
+  size_t shared_list_length_;
+
+  const char* text(const uint32_t offset) const {
+    return offset < shared_list_length_ ? shared_list_ + offset
+                                        : names_list_ + (offset - shared_list_length_);
+  }
+
+  size_t text_size() const {
+    return shared_list_length_ + names_list_length_;
+  }
+
   // for fast access to tag values stored in names list
   mutable std::multimap<TaggedValue, std::string> tag_cache_;
   mutable bool tag_cache_ready_ = false;
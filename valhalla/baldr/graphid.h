@@ -250,4 +250,13 @@ inline std::string to_string(const valhalla::baldr::GraphId& id) {
 }
 } // namespace std
 
+namespace valhalla {
+namespace midgard {
+template <typename Key> struct flat_hash;
+
+// the hash above mixes all 64 bits already so the flat containers use it as is
+template <> struct flat_hash<baldr::GraphId> : public std::hash<baldr::GraphId> {};
+} // namespace midgard
+} // namespace valhalla
+
 #endif // VALHALLA_BALDR_GRAPHID_H_
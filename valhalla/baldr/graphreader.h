@@ -1,18 +1,26 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <limits>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/memory_budget.h>
+#include <valhalla/baldr/shm_tile_cache.h>
+#include <valhalla/baldr/tile_shard.h>
 #include <valhalla/baldr/tilegetter.h>
 #include <valhalla/baldr/tilehierarchy.h>
 
@@ -82,6 +90,13 @@ public:
    */
   virtual bool OverCommitted() const = 0;
 
+  /**
+   * Changes how large the cache may get, e.g. as the memory available to the process changes. The
+   * cache only gets back within a lower limit once it is trimmed or as tiles are put.
+   * @param max_size  the new maximum size of the cache
+   */
+  virtual void SetMaxSize(size_t max_size) = 0;
+
   /**
    * Clears the cache.
    */
@@ -92,6 +107,22 @@ public:
    *  Some implementations may simply clear the entire cache
    */
   virtual void Trim() = 0;
+
+  /**
+   * Returns how many tiles the cache has dropped so far, whether to stay within its limit or
+   * because it was cleared or trimmed.
+   * @return the number of evicted tiles
+   */
+  virtual size_t Evictions() const = 0;
+
+  /**
+   * Returns how many times getting or putting a tile had to wait for another thread to let go of
+   * the cache. Caches which aren't shared between threads never wait.
+   * @return the number of contended lock acquisitions of this instance
+   */
+  virtual size_t LockWaits() const {
+    return 0;
+  }
 };
 
 /**
@@ -140,6 +171,12 @@ public:
    */
   bool OverCommitted() const override;
 
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
   /**
    * Clears the cache.
    */
@@ -151,6 +188,12 @@ public:
    */
   void Trim() override;
 
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
 protected:
   inline uint32_t get_offset(const GraphId& graphid) const {
     return graphid.level() < 4 ? index_offsets_[graphid.level()] + graphid.tileid()
@@ -176,6 +219,9 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -224,6 +270,12 @@ public:
    */
   bool OverCommitted() const override;
 
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
   /**
    * Clears the cache.
    */
@@ -235,6 +287,12 @@ public:
    */
   void Trim() override;
 
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
 protected:
   // The actual cached GraphTile objects
   std::unordered_map<uint64_t, graph_tile_ptr> cache_;
@@ -244,6 +302,9 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -299,6 +360,12 @@ public:
    */
   bool OverCommitted() const override;
 
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
   /**
    * Clears the cache.
    */
@@ -310,6 +377,12 @@ public:
    */
   void Trim() override;
 
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
 protected:
   struct KeyValue {
     KeyValue(GraphId id_, graph_tile_ptr tile_) : id(id_), tile(std::move(tile_)) {
@@ -352,6 +425,9 @@ protected:
 
   // The max cache size in bytes
   size_t max_cache_size_;
+
+  // The number of tiles dropped from the cache
+  size_t evictions_;
 };
 
 /**
@@ -364,8 +440,11 @@ public:
    * Constructor.
    * @param cache reference to an external cache
    * @param mutex reference to an external mutex
+   * @param owner keeps the external cache and mutex alive as long as this instance, if they need it
    */
-  SynchronizedTileCache(TileCache& cache, std::mutex& mutex);
+  SynchronizedTileCache(TileCache& cache,
+                        std::mutex& mutex,
+                        std::shared_ptr<const void> owner = nullptr);
   /**
    * Reserves enough cache to hold (max_cache_size / tile_size) items.
    * @param tile_size appeoximate size of one tile
@@ -400,6 +479,12 @@ public:
    */
   bool OverCommitted() const override;
 
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
   /**
    * Clears the cache.
    */
@@ -411,9 +496,236 @@ public:
    */
   void Trim() override;
 
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
+  /**
+   * Returns how many times getting or putting a tile had to wait for another thread.
+   * @return the number of contended lock acquisitions of this instance
+   */
+  size_t LockWaits() const override {
+    return lock_waits_.load(std::memory_order_relaxed);
+  }
+
 private:
   TileCache& cache_;
   std::mutex& mutex_ref_;
+  std::shared_ptr<const void> owner_;
+  mutable std::atomic<size_t> lock_waits_;
+};
+
+/**
+ * TileCache which spreads its tiles over a number of independently locked shards so that
+ * concurrent readers of different tiles don't contend on a single mutex. Copies of the cache share
+ * the same shards, which lets every GraphReader in a process hold its own instance of the global
+ * cache. The memory limit is split evenly over the shards so each one keeps the semantics of the
+ * underlying cache with respect to eviction and over commitment.
+ * It is thread-safe.
+ */
+class ShardedTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size     maximum size of the cache, summed over all shards
+   * @param shard_count  number of independently locked shards
+   * @param use_lru      whether the shards are LRU caches or simple hash map caches
+   * @param mem_control  strategy the LRU shards use to control their memory
+   */
+  ShardedTileCache(size_t max_size,
+                   size_t shard_count,
+                   bool use_lru,
+                   TileCacheLRU::MemoryLimitControl mem_control);
+
+  /**
+   * Copy constructor, the copy shares the shards but counts its own lock waits.
+   * @param other  the cache whose shards to share
+   */
+  ShardedTileCache(const ShardedTileCache& other);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if any of the shards is over committed with respect to its share of the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Trims only the shards which are over committed, the others keep their tiles
+   */
+  void Trim() override;
+
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
+  /**
+   * Returns how many times getting or putting a tile had to wait for another thread.
+   * @return the number of contended lock acquisitions of this instance
+   */
+  size_t LockWaits() const override {
+    return lock_waits_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the number of shards the tiles are spread over
+   */
+  size_t ShardCount() const {
+    return shards_->size();
+  }
+
+protected:
+  struct shard_t {
+    std::mutex mutex;
+    std::unique_ptr<TileCache> cache;
+  };
+
+  inline shard_t& get_shard(const GraphId& graphid) const {
+    // mix the bits of the tile id so that neighboring tiles land in different shards
+    uint64_t hash = graphid.Tile_Base().value * 0x9E3779B97F4A7C15ull;
+    return *(*shards_)[(hash >> 32) % shards_->size()];
+  }
+
+  std::shared_ptr<std::vector<std::unique_ptr<shard_t>>> shards_;
+  mutable std::atomic<size_t> lock_waits_;
+};
+
+/**
+ * TileCache which evicts with the CLOCK algorithm, an approximation of LRU in which a hit only sets
+ * the reference bit of its tile rather than moving it to the head of a list. Tiles are found
+ * through a flat index over all the tile ids, like the FlatTileCache, so getting a tile takes no
+ * lock on the cache: it only pins its entry for as long as it takes to copy the pointer. Misses
+ * take the cache lock to put their tile and while at it sweep the clock hand over the entries,
+ * giving the referenced ones a second chance and evicting the others until the tile fits. Copies
+ * of the cache share its tiles so every GraphReader in a process can hold its own instance.
+ * It is thread-safe, though tiles handed out to several threads need thread safe reference
+ * counts (ENABLE_THREAD_SAFE_TILE_REF_COUNT) as they do with any of the shared caches.
+ */
+class ClockTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size  maximum size of the cache
+   */
+  ClockTileCache(size_t max_size);
+
+  /**
+   * Copy constructor, the copy shares the tiles but counts its own lock waits.
+   * @param other  the cache whose tiles to share
+   */
+  ClockTileCache(const ClockTileCache& other);
+
+  /**
+   * Entries are made as tiles are put so there is nothing to reserve.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache, evicting tiles until it fits.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId and mark it as recently used.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large, which only happens for a tile larger than the limit.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Changes how large the cache may get, it gets back within a lower limit once trimmed.
+   * @param max_size  the new maximum size of the cache
+   */
+  void SetMaxSize(size_t max_size) override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Evicts tiles the clock hand comes across until the cache is within its limit
+   */
+  void Trim() override;
+
+  /**
+   * Returns how many tiles the cache has dropped so far.
+   * @return the number of evicted tiles
+   */
+  size_t Evictions() const override;
+
+  /**
+   * Returns how many times putting a tile had to wait for another thread, getting one never does.
+   * @return the number of contended lock acquisitions of this instance
+   */
+  size_t LockWaits() const override {
+    return lock_waits_.load(std::memory_order_relaxed);
+  }
+
+protected:
+  struct state_t;
+
+  std::shared_ptr<state_t> state_;
+  mutable std::atomic<size_t> lock_waits_;
 };
 
 /**
@@ -426,8 +738,63 @@ public:
   /**
    * Constructs tile cache.
    * @param pt  Property tree listing the configuration for the cahce configuration
+   * @param epoch  the tile extract the global caches hold the tiles of, see UpdateExtract
+   */
+  static TileCache* createTileCache(const boost::property_tree::ptree& pt, uint64_t epoch = 0);
+};
+
+/**
+ * LRU cache of decoded edge shapes keyed by tile and edgeinfo offset, bounded in bytes. It lets the
+ * shapes of popular edges be decoded once rather than every time an EdgeInfo is asked for one.
+ * Entries are keyed on the edgeinfo so both directions of an edge share their shape
+ */
+class EdgeShapeCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size  maximum size of the cache in bytes, 0 disables caching
+   */
+  explicit EdgeShapeCache(size_t max_size) : max_size_(max_size), size_(0) {
+  }
+
+  /**
+   * Get the decoded shape of an edge, in the direction it is encoded in the edgeinfo.
+   * Hits do not allocate and the storage of evicted shapes is recycled for new ones.
+   * @param tile  the tile the edge is in
+   * @param edge  the directed edge
+   * @return the shape, valid until the next call to Get or Clear
+   */
+  const std::vector<midgard::PointLL>& Get(const graph_tile_ptr& tile, const DirectedEdge* edge);
+
+  /**
+   * @return the number of bytes the cached shapes take up
+   */
+  size_t Size() const {
+    return size_;
+  }
+
+  /**
+   * Clears the cache.
    */
-  static TileCache* createTileCache(const boost::property_tree::ptree& pt);
+  void Clear();
+
+protected:
+  struct Entry {
+    uint64_t key;
+    std::vector<midgard::PointLL> shape;
+  };
+
+  static size_t EntrySize(const std::vector<midgard::PointLL>& shape) {
+    return sizeof(Entry) + shape.size() * sizeof(midgard::PointLL);
+  }
+
+  size_t max_size_;
+  size_t size_;
+  // most recently used at the front
+  std::list<Entry> lru_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+  // decoding space for shapes that are not cached
+  std::vector<midgard::PointLL> scratch_;
 };
 
 /**
@@ -469,6 +836,50 @@ public:
     return !tile_extract_->traffic_tiles.empty();
   }
 
+  using traffic_observer_t = std::function<void(const std::vector<GraphId>& tile_ids)>;
+
+  /**
+   * Registers a callback which is handed the ids of the live traffic tiles that PollTrafficUpdates
+   * found to be updated, so that state derived from their speeds can be refreshed. UpdateExtract
+   * hands it an empty list when all of the tiles were replaced
+   * @param observer  the callback
+   */
+  void AddTrafficObserver(traffic_observer_t observer) {
+    traffic_observers_.emplace_back(std::move(observer));
+  }
+
+  /**
+   * Compares the generation of every live traffic tile against what it was the last time this
+   * reader was polled and notifies the observers of the ones that changed. Only the tile headers
+   * are looked at. The first poll just records the current generations and reports nothing.
+   * @return the ids of the live traffic tiles updated since the last poll
+   */
+  std::vector<GraphId> PollTrafficUpdates();
+
+  /**
+   * Switches to the tile and traffic extract loaded last if mjolnir.extract_reload_seconds has the
+   * files watched and a replacement was loaded in the background since the last switch. The tiles
+   * handed out before stay valid, they hold on to the extract they came from, but the tile cache is
+   * replaced and the traffic observers are handed an empty list of tiles to say that the whole
+   * tileset changed. Call it in between requests, everything derived from the tiles is stale after.
+   * The incidents are not reloaded.
+   * @return whether the reader switched to another extract
+   */
+  bool UpdateExtract();
+
+  /**
+   * @return how many times the extract of this reader was replaced since the process started
+   */
+  uint64_t ExtractEpoch() const {
+    return extract_snapshot_ ? extract_snapshot_->epoch : 0;
+  }
+
+  /**
+   * @param tile_id  the id of the tile
+   * @return the generation of the live traffic tile, 0 if there is no such tile
+   */
+  uint32_t GetTrafficGeneration(const GraphId& tile_id) const;
+
   /**
    * Get a pointer to a graph tile object given a GraphId.
    * @param graphid  the graphid of the tile
@@ -509,11 +920,41 @@ public:
     return GetGraphTile(pointll, TileHierarchy::levels().back().level);
   }
 
+  /**
+   * Asks the background loaders to read tiles ahead of time so that a later GetGraphTile does not
+   * have to wait on the disk or the network for them. Tiles which are cached or being loaded
+   * already are skipped. Does nothing unless mjolnir.tile_prefetch_threads is set and tiles come
+   * from a tile_dir or a tile_url (tar extracts are memory mapped anyway).
+   * @param tile_ids  the tiles to load, most urgent first
+   */
+  void Prefetch(const std::vector<GraphId>& tile_ids);
+
+  /**
+   * Prefetches the tiles surrounding the given one on the same level. Meant to be called for every
+   * node a search expands, tiles whose neighbors were requested already return right away.
+   * @param graphid  any id within the tile the search is currently in
+   */
+  void PrefetchNeighbors(const GraphId& graphid) {
+    if (prefetcher_ && graphid.Tile_Base() != last_prefetched_tile_) {
+      PrefetchNeighborsOf(graphid.Tile_Base());
+    }
+  }
+
+  /**
+   * Prefetches the tiles, on all levels, under the straight line between two points. Those close
+   * to either end are requested first since that is where a search between them starts out.
+   * @param a  one end of the corridor
+   * @param b  the other end of the corridor
+   */
+  void PrefetchCorridor(const midgard::PointLL& a, const midgard::PointLL& b);
+
   /**
    * Clears the cache
    */
   virtual void Clear() {
     cache_->Clear();
+    shape_cache_.Clear();
+    DropPrefetched();
   }
 
   /**
@@ -521,7 +962,9 @@ public:
    * In some cases may even remove the entire cache.
    */
   virtual void Trim() {
+    FitMemoryBudget();
     cache_->Trim();
+    DropPrefetched();
   }
 
   /**
@@ -537,9 +980,63 @@ public:
    * @return true if the cache is over committed with respect to the limit
    */
   virtual bool OverCommitted() const {
+    FitMemoryBudget();
     return cache_->OverCommitted();
   }
 
+  /**
+   * Counters of how the reader got at its tiles. They only ever go up, the difference between two
+   * snapshots is what a stretch of work cost.
+   */
+  struct CacheStats {
+    uint64_t hits;         // tiles found in the cache
+    uint64_t misses;       // tiles not found in the cache, whether they could be loaded or not
+    uint64_t evictions;    // tiles dropped by the cache, which other readers may share
+    uint64_t tiles_loaded; // tiles loaded into the cache
+    uint64_t bytes_loaded; // what the loaded tiles were charged to the cache
+    double load_ms;        // the time spent loading tiles
+    uint64_t lock_waits;   // times the reader waited for other threads sharing its cache
+  };
+
+  /**
+   * Returns the tile cache counters of this reader
+   * @return the counters as of now
+   */
+  CacheStats GetCacheStats() const {
+    auto stats = cache_stats_;
+    stats.evictions = cache_->Evictions();
+    stats.lock_waits = cache_->LockWaits();
+    return stats;
+  }
+
+  /**
+   * What warming up the reader before a service takes traffic did
+   */
+  struct WarmupStats {
+    uint64_t tiles; // tiles read, those of an extract had their pages read
+    uint64_t bytes; // bytes read
+    double ms;      // the time it took
+  };
+
+  /**
+   * Reads tiles before a service takes traffic so that its first requests do not wait on the disk
+   * or the network for them. Tiles from a tile_dir or tile_url are loaded by the given number of
+   * threads and put in the cache until it is full. The pages of tiles in a tar extract are read so
+   * that they are resident. Tiles which are cached already are skipped.
+   * @param tile_ids  the tiles to read, most wanted first
+   * @param threads   how many threads to read them with
+   * @return what this warm up did, GetWarmupStats adds up all of them
+   */
+  WarmupStats Warmup(const std::vector<GraphId>& tile_ids, size_t threads);
+
+  /**
+   * Returns what warming up the reader did
+   * @return the warm up counters, all 0 if the reader was not warmed up
+   */
+  const WarmupStats& GetWarmupStats() const {
+    return warmup_stats_;
+  }
+
   /**
    * Convenience method to get an opposing directed edge.
    * @param  edgeid  Graph Id of the directed edge.
@@ -699,6 +1196,13 @@ public:
    */
   std::vector<GraphId> RecoverShortcut(const GraphId& shortcutid);
 
+  /**
+   * Recovers the edges of all the shortcuts in the tileset and writes them to an index file.
+   * Readers configured with the index map it rather than recovering the shortcuts themselves.
+   * @param  index_file  where to write the index
+   */
+  void WriteShortcutIndex(const std::string& index_file);
+
   /**
    * Convenience method to get the relative edge density (from the
    * begin node of an edge).
@@ -861,6 +1365,17 @@ public:
    */
   std::string encoded_edge_shape(const valhalla::baldr::GraphId& edgeid);
 
+  /**
+   * Get the decoded shape of an edge from the reader's shape cache (mjolnir.edge_shape_cache_size)
+   * @param tile  the tile the edge is in
+   * @param edge  the directed edge
+   * @return the shape in the direction of the edgeinfo, valid until the next call
+   */
+  const std::vector<midgard::PointLL>& edge_shape(const graph_tile_ptr& tile,
+                                                  const DirectedEdge* edge) {
+    return shape_cache_.Get(tile, edge);
+  }
+
   /**
    * Gets back a set of available tiles
    * @return  returns the list of available tiles
@@ -952,13 +1467,32 @@ protected:
     std::shared_ptr<midgard::tar> archive;
     std::shared_ptr<midgard::tar> traffic_archive;
     uint64_t checksum;
+    // Compressed extracts deflate every tile on its own, these are the sizes they inflate to and
+    // the preset dictionary they were deflated with. Empty for plain extracts
+    std::unordered_map<uint64_t, uint32_t> inflated_sizes;
+    std::string dictionary;
   };
   std::shared_ptr<const tile_extract_t> tile_extract_;
+  // the readers on the global synchronized cache also share one extract per tar file
   static std::shared_ptr<const GraphReader::tile_extract_t>
-  get_extract_instance(const boost::property_tree::ptree& pt);
+  get_extract_instance(const boost::property_tree::ptree& pt, bool traffic_readonly);
+
+  // An extract loaded again after its files were replaced, with the shortcut recovery for it
+  struct extract_snapshot_t {
+    uint64_t epoch;
+    std::shared_ptr<const tile_extract_t> extract;
+    // empty to use the process wide shortcut recovery, which recovers on the fly if not filled
+    std::function<std::vector<GraphId>(const GraphId&, GraphReader&)> recover_shortcut;
+  };
+  std::shared_ptr<const extract_snapshot_t> extract_snapshot_;
+  // Watches the extract files, only present if mjolnir.extract_reload_seconds is set
+  struct extract_reloader_t;
+  std::shared_ptr<extract_reloader_t> extract_reloader_;
 
   // Information about where the tiles are kept
   const std::string tile_dir_;
+  // Whether tiles in the tile_dir are memory mapped rather than read into the heap
+  const bool tile_dir_mmap_;
 
   // Stuff for getting at remote tiles
   std::unique_ptr<tile_getter_t> tile_getter_;
@@ -970,7 +1504,97 @@ protected:
 
   std::unique_ptr<TileCache> cache_;
 
+  // The memory the tile caches of the process may take, only present if
+  // mjolnir.cache_memory_fraction is set. The cache is kept within the share of this reader, or
+  // all of it for the global cache, and never above max_cache_size
+  std::shared_ptr<memory_budget_t> memory_budget_;
+  std::shared_ptr<void> memory_share_;
+  size_t max_cache_size_{0};
+  bool global_cache_{false};
+  mutable size_t cache_limit_{0};
+
+  /**
+   * Changes the maximum size of the cache to what the memory budget allows at the moment.
+   */
+  void FitMemoryBudget() const {
+    if (!memory_budget_) {
+      return;
+    }
+    const auto limit = memory_budget_->Limit(max_cache_size_, global_cache_);
+    if (limit != cache_limit_) {
+      cache_->SetMaxSize(limit);
+      cache_limit_ = limit;
+    }
+  }
+
+  // Tiles shared with the other processes on the host, only for tiles from disk or the url
+  std::shared_ptr<shm_tile_cache_t> shm_cache_;
+
+  // The region of a sharded deployment this reader serves, all of the tiles if not sharded
+  std::shared_ptr<const tile_shard_t> shard_;
+
+  // Decoded shapes of recently used edges
+  EdgeShapeCache shape_cache_;
+
+  // Hits, misses and loads of the tile cache, the evictions and lock waits are asked of the cache
+  CacheStats cache_stats_{};
+
+  // What warming up the reader did
+  WarmupStats warmup_stats_{};
+
   bool enable_incidents_;
+
+  /**
+   * Reads a tile from the tile_dir or, failing that, the tile_url without touching the cache. Safe
+   * to call from the prefetch threads.
+   * @param base  the base graphid of the tile
+   * @param size  the size to charge the cache with for this tile
+   * @return the tile or nullptr if it could not be found
+   */
+  graph_tile_ptr LoadGraphTile(const GraphId& base, size_t& size);
+
+  /**
+   * Gets a tile out of the tile extract without touching the cache. The tiles of a compressed
+   * extract are inflated onto the heap, the others point into the mapped tar.
+   * @param base  the base graphid of the tile
+   * @param size  the size to charge the cache with for this tile
+   * @return the tile or nullptr if it is not in the extract or could not be inflated
+   */
+  graph_tile_ptr LoadExtractTile(const GraphId& base, size_t& size) const;
+
+  /**
+   * Same as LoadGraphTile for several tiles, the ones which have to be downloaded are fetched in
+   * one batch.
+   * @param bases  the base graphids of the tiles
+   * @param sizes  the size to charge the cache with for each tile
+   * @return the tiles in the order of the graphids, nullptr for the ones which could not be found
+   */
+  std::vector<graph_tile_ptr> LoadGraphTiles(const std::vector<GraphId>& bases,
+                                             std::vector<size_t>& sizes);
+
+  // Requests the neighbors of a tile unless that was done already
+  void PrefetchNeighborsOf(const GraphId& tile_id);
+
+  // Forgets which tiles were prefetched and frees the loaded ones nobody asked for
+  void DropPrefetched();
+
+  // One in every tile_usage_sample_rate_ tile accesses is counted, if mjolnir.tile_usage is set
+  struct tile_usage_t;
+  std::shared_ptr<tile_usage_t> tile_usage_;
+  uint32_t tile_usage_sample_rate_ = 0;
+  uint32_t tile_usage_countdown_ = 0;
+
+  // Live traffic tile generations as of the last poll and who to tell when they change
+  std::unordered_map<uint64_t, uint32_t> traffic_generations_;
+  bool traffic_polled_ = false;
+  std::vector<traffic_observer_t> traffic_observers_;
+
+  // Background loaders, only present if prefetching is enabled. Declared last so that the threads
+  // are stopped before any of the state they use goes away
+  struct tile_prefetcher_t;
+  std::shared_ptr<tile_prefetcher_t> prefetcher_;
+  GraphId last_prefetched_tile_;
+  std::unordered_set<GraphId> prefetched_tiles_;
 };
 
 // Given the Location relation, return the full metadata
@@ -18,6 +18,7 @@
 #include <valhalla/baldr/predictedspeeds.h>
 #include <valhalla/baldr/sign.h>
 #include <valhalla/baldr/signinfo.h>
+#include <valhalla/baldr/textdictionary.h>
 #include <valhalla/baldr/traffictile.h>
 #include <valhalla/baldr/transitdeparture.h>
 #include <valhalla/baldr/transitroute.h>
@@ -59,11 +60,15 @@ public:
    * into memory.
    * @param  tile_dir   Tile directory.
    * @param  graphid    GraphId (tileid and level)
+   * @param  traffic_memory  Memory of the traffic tile, if any
+   * @param  memory_map Map uncompressed tile files read-only instead of reading them. The file must
+   *                    not be rewritten in place while the tile is in use
    * @return nullptr if the tile could not be loaded. may throw
    */
   static graph_tile_ptr Create(const std::string& tile_dir,
                                const GraphId& graphid,
-                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr);
+                               std::unique_ptr<const GraphMemory>&& traffic_memory = nullptr,
+                               bool memory_map = false);
 
   /**
    * Constructs with a given the graph Id, pointer to the tile data, and the
@@ -97,6 +102,19 @@ public:
                                      tile_getter_t* tile_getter,
                                      const std::string& cache_location);
 
+  /**
+   * Constructs several tiles given a url pattern, fetching them all in one batch
+   * @param  tile_url URL of tile
+   * @param  graphids Tile Ids
+   * @param  tile_getter object that will handle tile downloading
+   * @param  cache_location directory to cache the downloaded tiles in, empty to not cache them
+   * @return the tiles in the order of the graphids, nullptr for the ones which could not be had
+   */
+  static std::vector<graph_tile_ptr> CacheTileURLs(const std::string& tile_url,
+                                                   const std::vector<GraphId>& graphids,
+                                                   tile_getter_t* tile_getter,
+                                                   const std::string& cache_location);
+
   /**
    * Construct a tile given a url for the tile using curl
    * @param  tile_data graph tile raw bytes
@@ -224,6 +242,22 @@ public:
         " directededgecount= " + std::to_string(header_->directededgecount()));
   }
 
+  /**
+   * Get the attributes of an edge that searches look at for every edge they expand. They come
+   * from the compact array of them when the tile has one and from the directed edge otherwise.
+   * @param  idx  Index of the directed edge within the current tile.
+   * @return  Returns the hot attributes of the edge.
+   */
+  DirectedEdgeHot hot_directededge(const size_t idx) const {
+    if (idx < header_->directededgecount()) {
+      return hot_directededges_ ? hot_directededges_[idx] : DirectedEdgeHot(directededges_[idx]);
+    }
+    throw std::runtime_error(
+        "GraphTile DirectedEdge index out of bounds: " + std::to_string(header_->graphid().tileid()) +
+        "," + std::to_string(header_->graphid().level()) + "," + std::to_string(idx) +
+        " directededgecount= " + std::to_string(header_->directededgecount()));
+  }
+
   /**
    * Get a pointer to an edge extension .
    * @param  edge  GraphId of the directed edge.
@@ -402,10 +436,10 @@ public:
    * @param   forward - do we want the restrictions in reverse order?
    * @param   id - edge id
    * @param   modes - access modes
-   * @return  Returns the vector of complex restrictions in the order requested
-   *          based on the id and modes.
+   * @return  Returns the complex restrictions in the order requested based on the id and
+   *          modes. They point into the tile so they are only good as long as it is.
    */
-  std::vector<ComplexRestriction*>
+  ComplexRestrictions
   GetRestrictions(const bool forward, const GraphId id, const uint64_t modes) const;
 
   /**
@@ -465,6 +499,15 @@ public:
    */
   std::string GetName(const uint32_t textlist_offset) const;
 
+  /**
+   * Gets the text list of the tile, null terminated strings one after the other. The text which
+   * the tile shares through a text dictionary isn't in it.
+   * @return  Returns the bytes of the text list.
+   */
+  midgard::iterable_t<const char> textlist() const {
+    return {textlist_, textlist_size_};
+  }
+
   /**
    * Convenience method to get the signs for an edge given the directed
    * edge index.
@@ -488,6 +531,14 @@ public:
            std::unordered_map<uint32_t, std::pair<uint8_t, std::string>>& index_pronunciation_map,
            bool signs_on_node = false) const;
 
+  /**
+   * Get the signs of a directed edge or node as they are stored in the tile, without copying them
+   * or looking up their text.
+   * @param  idx  Directed edge or node index.
+   * @return  Returns the signs with that index, both those at the edge and those at the node.
+   */
+  midgard::iterable_t<const Sign> signs(const uint32_t idx) const;
+
   /**
    * Get the next departure given the directed edge Id and the current
    * time (seconds from midnight). TODO - what if crosses midnight?
@@ -528,6 +579,13 @@ public:
    */
   std::unordered_map<uint32_t, TransitDeparture*> GetTransitDepartures() const;
 
+  /**
+   * Get the departures of a line, sorted by departure time.
+   * @param   lineid  Transit Line Id
+   * @return  Returns the departures of the line, none if the line has none in this tile.
+   */
+  midgard::iterable_t<const TransitDeparture> GetLineDepartures(const uint32_t lineid) const;
+
   /**
    * Get the stop onestop Ids in this tile.
    * @return  Returns a map of transit stops with onestop Ids as the key and
@@ -583,6 +641,14 @@ public:
   std::vector<AccessRestriction> GetAccessRestrictions(const uint32_t edgeid,
                                                        const uint32_t access) const;
 
+  /**
+   * Get the access restrictions of a directed edge for all modes as they are stored in the tile,
+   * without copying them. Filtering them by the modes of interest is up to the caller.
+   * @param   idx  Directed edge index.
+   * @return  Returns the access restrictions of the edge.
+   */
+  midgard::iterable_t<const AccessRestriction> access_restrictions(const uint32_t idx) const;
+
   /**
    * Get an iteratable list of GraphIds given a bin in the tile
    * @param  column the bin's column
@@ -605,6 +671,14 @@ public:
    */
   std::vector<LaneConnectivity> GetLaneConnectivity(const uint32_t idx) const;
 
+  /**
+   * Get the lane connections ending on a directed edge as they are stored in the tile, without
+   * copying them.
+   * @param  idx  Directed edge index.
+   * @return  Returns the lane connections ending on this edge.
+   */
+  midgard::iterable_t<const LaneConnectivity> lane_connections(const uint32_t idx) const;
+
   /**
    * Convenience method for use with costing to get the speed for an edge given the directed
    * edge and a time (seconds since start of the week). If the current speed of the edge
@@ -752,7 +826,7 @@ public:
    */
   std::vector<uint16_t> turnlanes(const uint32_t idx) const {
     uint32_t offset = turnlanes_offset(idx);
-    return (offset > 0) ? TurnLanes::lanemasks(textlist_ + offset) : std::vector<uint16_t>();
+    return (offset > 0) ? TurnLanes::lanemasks(text(offset)) : std::vector<uint16_t>();
   }
 
   /**
@@ -804,6 +878,10 @@ protected:
   // Id as the directed edge.
   DirectedEdgeExt* ext_directededges_{};
 
+  // Hot attributes of the directed edges, indexed by the same Id as the directed edge. Only set
+  // when the tile has them
+  DirectedEdgeHot* hot_directededges_{};
+
   // Access restrictions, 1 or more per edge id
   AccessRestriction* access_restrictions_{};
 
@@ -845,6 +923,15 @@ protected:
   // Size of the complex restrictions in the reverse direction
   std::size_t complex_restriction_reverse_size_{};
 
+  // Offsets of the forward and reverse complex restrictions within their lists, sorted by the
+  // edge they are looked up by. They point to the index stored in the tile or, for tiles without
+  // one, to the index built when the tile is loaded
+  const uint32_t* complex_restriction_forward_index_{};
+  std::size_t complex_restriction_forward_count_{};
+  const uint32_t* complex_restriction_reverse_index_{};
+  std::size_t complex_restriction_reverse_count_{};
+  std::vector<uint32_t> complex_restriction_index_;
+
   // List of edge info structures. Since edgeinfo is not fixed size we
   // use offsets in directed edges.
   char* edgeinfo_{};
@@ -859,6 +946,21 @@ protected:
   // Number of bytes in the text/name list
   std::size_t textlist_size_{};
 
+  // The text dictionary the tile was built with, if any. Text offsets below its size are into it
+  // and the rest are into the text list after subtracting its size
+  std::shared_ptr<const TextDictionary> shared_text_;
+  const char* shared_textlist_{};
+  std::size_t shared_textlist_size_{};
+
+  const char* text(const uint32_t offset) const {
+    return offset < shared_textlist_size_ ? shared_textlist_ + offset
+                                          : textlist_ + (offset - shared_textlist_size_);
+  }
+
+  std::size_t text_size() const {
+    return shared_textlist_size_ + textlist_size_;
+  }
+
   // List of edge graph ids. The list is broken up in bins which have
   // indices in the tile header.
   GraphId* edge_bins_{};
@@ -878,6 +980,17 @@ protected:
   // Map of route one stops in this tile.
   std::unordered_map<std::string, std::list<GraphId>> route_one_stops;
 
+  // The departures of a line and, for each hour of the day, the first of them which leaves or, for
+  // a frequency schedule, ends at or after the start of the hour
+  struct LineDepartures {
+    uint32_t begin;
+    uint32_t end;
+    std::vector<uint32_t> hours;
+  };
+
+  // The departures of each line in this tile
+  std::unordered_map<uint32_t, LineDepartures> line_departures_;
+
   // Map of operator one stops in this tile.
   std::unordered_map<std::string, std::list<GraphId>> oper_one_stops;
 
@@ -933,6 +1046,28 @@ protected:
    */
   void AssociateOneStopIds(const GraphId& graphid);
 
+  /**
+   * Indexes the departures of each line by the hour of the day so that finding the next departure
+   * of a line does not have to search through the departures of all lines.
+   */
+  void IndexDepartures();
+
+  /**
+   * Indexes the complex restrictions by the edge they are looked up by, for tiles that were built
+   * without the index of them.
+   */
+  void IndexRestrictions();
+
+  /**
+   * Finds the first departure of a line which leaves or, for a frequency schedule, ends at or
+   * after the given time.
+   * @param  lineid        Transit Line Id
+   * @param  current_time  Current time (seconds from midnight).
+   * @param  end           Set to one past the last departure of the line
+   * @return Returns the index of the departure or end if there is none.
+   */
+  uint32_t FirstDeparture(const uint32_t lineid, const uint32_t current_time, uint32_t& end) const;
+
   /** Decrompresses tile bytes into the internal graphtile byte buffer
    * @param  graphid     the id of the tile to be decompressed
    * @param  compressed  the compressed bytes
@@ -940,6 +1075,19 @@ protected:
    *         the uncompressed data, or nullptr
    */
   static graph_tile_ptr DecompressTile(const GraphId& graphid, const std::vector<char>& compressed);
+
+  /**
+   * Turns a downloaded tile into a graphtile and caches its bytes on disk
+   * @param  graphid         the id of the tile that was downloaded
+   * @param  tile_getter     the getter the tile was downloaded with
+   * @param  cache_location  directory to cache the tile in, empty to not cache it
+   * @param  result          the response, its bytes are moved into the tile
+   * @return the tile or nullptr if the download failed
+   */
+  static graph_tile_ptr FromResponse(const GraphId& graphid,
+                                     const tile_getter_t* tile_getter,
+                                     const std::string& cache_location,
+                                     tile_getter_t::response_t& result);
 };
 
 } // namespace baldr
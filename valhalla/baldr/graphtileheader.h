@@ -18,7 +18,7 @@ namespace baldr {
 // something to the tile simply subtract one from this number and add it
 // just before the empty_slots_ array below. NOTE that it can ONLY be an
 // offset in bytes and NOT a bitfield or union or anything of that sort
-constexpr size_t kEmptySlots = 11;
+constexpr size_t kEmptySlots = 7;
 
 // Maximum size of the version string (stored as a fixed size
 // character array so the GraphTileHeader size remains fixed).
@@ -590,6 +590,75 @@ public:
     tile_size_ = offset;
   }
 
+  /**
+   * Does this tile have the compact array of hot directed edge attributes.
+   * @return  Returns true if the tile has the hot directed edges
+   */
+  bool has_hot_directededge() const {
+    return hot_directededge_offset_ != 0;
+  }
+
+  /**
+   * Gets the offset to the hot directed edges (see DirectedEdgeHot) within the tile.
+   * @return  Returns the offset to the hot directed edges, 0 when the tile has none.
+   */
+  uint32_t hot_directededge_offset() const {
+    return hot_directededge_offset_;
+  }
+
+  /**
+   * Sets the offset to the hot directed edges within the tile.
+   * @param offset Offset to the hot directed edges, 0 to mark the tile as having none.
+   */
+  void set_hot_directededge_offset(const uint32_t offset) {
+    hot_directededge_offset_ = offset;
+  }
+
+  /**
+   * Gets the offset to the index of the complex restrictions within the tile. The index is
+   * the forward and the reverse restriction counts followed by the offsets of the restrictions
+   * within their lists, sorted by the edge they are looked up by.
+   * @return  Returns the offset to the index, 0 when the tile has none.
+   */
+  uint32_t complex_restriction_index_offset() const {
+    return complex_restriction_index_offset_;
+  }
+
+  /**
+   * Sets the offset to the index of the complex restrictions within the tile.
+   * @param offset Offset to the index, 0 to mark the tile as having none.
+   */
+  void set_complex_restriction_index_offset(const uint32_t offset) {
+    complex_restriction_index_offset_ = offset;
+  }
+
+  /**
+   * Gets the size of the text dictionary the tile shares its text with. Text offsets below it
+   * are into the dictionary, the ones past it are into the text list of the tile.
+   * @return  Returns the size of the dictionary in bytes, 0 when the tile has all of its text.
+   */
+  uint32_t shared_textlist_size() const {
+    return shared_textlist_size_;
+  }
+
+  /**
+   * Gets the crc32 of the text dictionary the tile shares its text with.
+   * @return  Returns the checksum the dictionary has to match for the tile to be read.
+   */
+  uint32_t shared_textlist_checksum() const {
+    return shared_textlist_checksum_;
+  }
+
+  /**
+   * Sets the size and checksum of the text dictionary the tile shares its text with.
+   * @param size      Size of the dictionary in bytes, 0 if the tile has all of its text.
+   * @param checksum  crc32 of the dictionary.
+   */
+  void set_shared_textlist(const uint32_t size, const uint32_t checksum) {
+    shared_textlist_size_ = size;
+    shared_textlist_checksum_ = checksum;
+  }
+
 protected:
   // TODO when c++20 bitfields can be initialized here
   // GraphId (tileid and level) of this tile. Data quality metrics.
@@ -689,6 +758,16 @@ protected:
   // GraphTile data size in bytes
   uint32_t tile_size_ = 0;
 
+  // Offset to the hot directed edge attributes (0 if the tile doesn't have them)
+  uint32_t hot_directededge_offset_ = 0;
+
+  // Offset to the index of the complex restrictions (0 if the tile doesn't have one)
+  uint32_t complex_restriction_index_offset_ = 0;
+
+  // Size and checksum of the text dictionary the tile shares its text with (0 if it doesn't)
+  uint32_t shared_textlist_size_ = 0;
+  uint32_t shared_textlist_checksum_ = 0;
+
   // Marks the end of this version of the tile with the rest of the slots
   // being available for growth. If you want to use one of the empty slots,
   // simply add a uint32_t some_offset_; just above empty_slots_ and decrease
@@ -3,6 +3,7 @@
 
 #include <boost/variant.hpp>
 #include <cctype>
+#include <charconv>
 #include <cinttypes>
 #include <cmath>
 #include <cstddef>
@@ -166,8 +167,46 @@ private:
   char fill;
 };
 
+// Write a finite value with a fixed number of decimal places using integer arithmetic, which is a
+// lot cheaper than going through the stream's locale and manipulators. Rounds like printf does,
+// ties to even. Returns the end of what was written or nullptr when the value is too large.
+inline char* format_fixed(char* first, long double value, size_t precision) {
+  if (precision > 17) {
+    return nullptr;
+  }
+  uint64_t power = 1;
+  for (size_t i = 0; i < precision; ++i) {
+    power *= 10;
+  }
+  const long double scaled = std::nearbyint(std::fabs(value) * power);
+  if (!(scaled < 1e19L)) {
+    return nullptr;
+  }
+
+  // printf keeps the sign of negative values that round to zero, so do we
+  const auto digits = static_cast<uint64_t>(scaled);
+  if (std::signbit(value)) {
+    *first++ = '-';
+  }
+  first = std::to_chars(first, first + 20, digits / power).ptr;
+  if (precision > 0) {
+    *first++ = '.';
+    auto fraction = digits % power;
+    for (auto* digit = first + precision - 1; digit >= first; --digit) {
+      *digit = static_cast<char>('0' + fraction % 10);
+      fraction /= 10;
+    }
+    first += precision;
+  }
+  return first;
+}
+
 inline std::ostream& operator<<(std::ostream& stream, const fixed_t& fp) {
   if (std::isfinite(fp.value)) {
+    char buffer[48];
+    if (auto* end = format_fixed(buffer, fp.value, fp.precision)) {
+      return stream.write(buffer, end - buffer);
+    }
     stream << std::setprecision(fp.precision) << std::fixed << fp.value;
   } else {
     stream << std::setprecision(fp.precision) << std::fixed << '"' << fp.value << '"';
@@ -178,7 +217,15 @@ inline std::ostream& operator<<(std::ostream& stream, const fixed_t& fp) {
 inline std::ostream& operator<<(std::ostream& stream, const float_t& fp) {
   // precision defaults to 6 according to lib stdc++
   if (std::isfinite(fp.value)) {
+#if defined(__cpp_lib_to_chars)
+    // formats like printf's %g does, without the stream's locale and manipulators
+    char buffer[32];
+    auto result =
+        std::to_chars(buffer, buffer + sizeof(buffer), fp.value, std::chars_format::general, 6);
+    return stream.write(buffer, result.ptr - buffer);
+#else
     stream << std::setprecision(6) << std::defaultfloat << fp.value;
+#endif
   } else {
     stream << std::setprecision(6) << std::defaultfloat << '"' << fp.value << '"';
   }
@@ -0,0 +1,78 @@
+#ifndef VALHALLA_BALDR_LANDMARKDISTANCES_H_
+#define VALHALLA_BALDR_LANDMARKDISTANCES_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The shortest road distances between a few landmark nodes on the edge of the graph and every node
+ * of the road levels. By the triangle inequality the difference between the distances of two nodes
+ * from a landmark is a lower bound of the distance between them, which is tighter than the straight
+ * line distance wherever the roads have to go around something. The distances ignore the direction
+ * and access of the edges so that they are lower bounds for any costing.
+ *
+ * The file is this header, the tiles sorted by id with where their nodes start and then for each
+ * node the distance in meters from each landmark.
+ */
+class LandmarkDistances {
+public:
+  static constexpr uint64_t kVersion = 1;
+  // the node can't be reached from the landmark
+  static constexpr uint32_t kUnreachable = 0xffffffff;
+
+  struct header_t {
+    uint64_t version;
+    uint64_t landmark_count;
+    uint64_t tile_count;
+    uint64_t node_count;
+  };
+
+  struct tile_t {
+    uint64_t tile_id;
+    // index of the first node of the tile in the distances
+    uint64_t offset;
+    uint32_t node_count;
+    uint32_t spare;
+  };
+
+  /**
+   * Maps the distances written by the tile build.
+   * @param  file_name  The file with the distances.
+   * @return Returns the distances, nullptr if the file is not complete or not of this version.
+   */
+  static std::shared_ptr<const LandmarkDistances> Map(const std::string& file_name);
+
+  uint32_t landmark_count() const {
+    return landmark_count_;
+  }
+
+  /**
+   * Gets the distances of a node from the landmarks.
+   * @param  node        The node.
+   * @param  node_count  The number of nodes in the tile of the node, to tell the distances of
+   *                     another build of the tile apart.
+   * @return Returns the distances from each landmark, nullptr if the node isn't in the file.
+   */
+  const uint32_t* get(const GraphId& node, const uint32_t node_count) const;
+
+protected:
+  LandmarkDistances() = default;
+
+  midgard::mem_map<char> mapped_;
+  uint32_t landmark_count_;
+  const tile_t* tiles_begin_;
+  const tile_t* tiles_end_;
+  const uint32_t* distances_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_LANDMARKDISTANCES_H_
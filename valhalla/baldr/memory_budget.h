@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * The memory the tile caches of a process may take up altogether, a fraction of the memory limit
+ * of its cgroup or of the memory of the machine if it has none. The readers with caches of their
+ * own split it between them, readers on a global cache give all of it to that cache.
+ *
+ * The memory is looked at again every few seconds. While the cgroup is under memory pressure (the
+ * PSI stall share) or nearly out of memory the budget halves at every look and once it isn't it
+ * grows back a step at a time, so many workers filling their caches at once shrink them all
+ * rather than get the process killed.
+ */
+class memory_budget_t : public std::enable_shared_from_this<memory_budget_t> {
+public:
+  // What the budget is worked out from
+  struct reading_t {
+    size_t limit = 0;     // the bytes the process may use, 0 if unknown
+    size_t used = 0;      // how many of those are in use
+    float pressure = 0.f; // the share (percent) of the last 10s some tasks stalled on memory
+  };
+
+  // Below this a cache can't keep the tiles of a route anymore
+  static constexpr size_t kMinCacheSize = 64 * 1024 * 1024;
+
+  /**
+   * Constructor.
+   * @param fraction      the fraction of the memory limit the caches may take
+   * @param max_pressure  above which memory pressure (percent) the budget shrinks
+   * @param interval      how often to look at the memory, 0 only updates on Update()
+   */
+  memory_budget_t(float fraction, float max_pressure, std::chrono::seconds interval);
+
+  ~memory_budget_t();
+
+  /**
+   * The budget of the process for the mjolnir configuration, shared by all the readers.
+   * @param pt  the mjolnir configuration
+   * @return the budget or nullptr if cache_memory_fraction doesn't enable one
+   */
+  static std::shared_ptr<memory_budget_t> get(const boost::property_tree::ptree& pt);
+
+  /**
+   * Takes a share of the budget for a cache of its own.
+   * @return the share, it is given back once this is gone
+   */
+  std::shared_ptr<void> Join();
+
+  /**
+   * How large a cache may currently get.
+   * @param max_size  the configured maximum size of the cache, the budget never exceeds it
+   * @param shared    whether the cache is the global one rather than a share of the budget
+   * @return the maximum size of the cache
+   */
+  size_t Limit(size_t max_size, bool shared) const;
+
+  /**
+   * Works out the budget again from a reading of the memory.
+   * @param reading  the memory limit, its use and the memory pressure
+   */
+  void Update(const reading_t& reading);
+
+  /**
+   * Reads the memory limit, use and pressure of the cgroup of the process (v2 or v1) falling back
+   * to /proc/meminfo and /proc/pressure/memory.
+   * @return the reading, with zeros for whatever couldn't be read
+   */
+  static reading_t Read();
+
+  /**
+   * @param contents  the contents of a cgroup memory file, e.g. memory.max
+   * @return the bytes in it, 0 for "max" or anything unreadable
+   */
+  static size_t ParseBytes(const std::string& contents);
+
+  /**
+   * @param contents  the contents of a PSI file, e.g. memory.pressure
+   * @return the avg10 of its "some" line, 0 if there is none
+   */
+  static float ParsePressure(const std::string& contents);
+
+protected:
+  const float fraction_;
+  const float max_pressure_;
+  // the budget at full scale and how much of it is given out at the moment
+  std::atomic<size_t> budget_;
+  std::atomic<float> scale_;
+  std::atomic<size_t> shares_;
+
+  bool done_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+};
+
+} // namespace baldr
+} // namespace valhalla
@@ -2,6 +2,7 @@
 #define VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 
 #include <array>
+#include <string_view>
 #include <valhalla/midgard/util.h>
 
 namespace valhalla {
@@ -45,7 +46,7 @@ std::string encode_compressed_speeds(const int16_t* coefficients);
  * @param encoded   base64-encoded string (length must be equal to 400).
  * @return  Transformed speed buckets.
  */
-std::array<int16_t, kCoefficientCount> decode_compressed_speeds(const std::string& encoded);
+std::array<int16_t, kCoefficientCount> decode_compressed_speeds(std::string_view encoded);
 
 /**
  * Class to access predicted speed information within a tile.
@@ -421,6 +421,16 @@ public:
   inline void operator()(const std::nullptr_t) {
     writer.Null();
   }
+
+  // writes an already serialized json value as is
+  inline void raw(const char* key, const std::string& json) {
+    writer.String(key);
+    writer.RawValue(json.c_str(), json.size(), rapidjson::kObjectType);
+  }
+
+  inline void raw(const std::string& json) {
+    writer.RawValue(json.c_str(), json.size(), rapidjson::kObjectType);
+  }
 };
 
 } // namespace rapidjson
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Tiles kept in a POSIX shared memory segment which all the processes on a host attach to, so that
+ * a tile read from disk or downloaded by one of them is there for all the others rather than each
+ * one loading and inflating its own copy. The segment holds an open addressing index of the tiles
+ * followed by their bytes. Processes add tiles by bumping the end of the bytes and claiming a slot
+ * of the index with compare and swap, finding a tile takes no lock at all.
+ *
+ * Tiles are never evicted or moved so that processes can use them in place for as long as they
+ * like: once the segment is full tiles just aren't added anymore. The segment outlives the
+ * processes, it has to be removed when the tiles change.
+ */
+class shm_tile_cache_t {
+public:
+  /**
+   * Attaches to the segment, creating it if no process did so far.
+   * @param  name  name of the segment, like /valhalla_tiles
+   * @param  size  size of the segment in bytes, one which exists already keeps its size
+   * @throws std::runtime_error if the segment can't be opened or mapped
+   */
+  shm_tile_cache_t(const std::string& name, size_t size);
+
+  ~shm_tile_cache_t();
+
+  shm_tile_cache_t(const shm_tile_cache_t&) = delete;
+  shm_tile_cache_t& operator=(const shm_tile_cache_t&) = delete;
+
+  /**
+   * The attachment of the process to the segment, made on first use and shared by all its readers.
+   * @param  name  name of the segment
+   * @param  size  size of the segment in bytes
+   * @return the attachment or nullptr if the segment can't be attached to
+   */
+  static std::shared_ptr<shm_tile_cache_t> get_instance(const std::string& name, size_t size);
+
+  /**
+   * Removes the segment, processes attached to it keep it until they detach.
+   * @param  name  name of the segment
+   * @return whether there was a segment to remove
+   */
+  static bool remove(const std::string& name);
+
+  /**
+   * Finds the bytes of a tile.
+   * @param  base  the base id of the tile
+   * @return the bytes and their size, nullptr if the tile isn't in the segment (yet)
+   */
+  std::pair<char*, size_t> find(const GraphId& base) const;
+
+  /**
+   * Copies the bytes of a tile into the segment.
+   * @param  base  the base id of the tile
+   * @param  data  the bytes of the tile
+   * @param  size  the number of bytes
+   * @return whether the tile was added, not if it's there already or doesn't fit anymore
+   */
+  bool insert(const GraphId& base, const char* data, size_t size);
+
+  /**
+   * @return how many bytes of tiles the segment holds
+   */
+  size_t used() const;
+
+  /**
+   * @return how many bytes of tiles the segment can hold
+   */
+  size_t capacity() const;
+
+protected:
+  struct header_t;
+  struct slot_t;
+
+  slot_t* slots() const;
+  char* data() const;
+
+  std::string name_;
+  char* memory_;
+  size_t size_;
+  header_t* header_;
+};
+
+} // namespace baldr
+} // namespace valhalla
@@ -4,6 +4,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include <valhalla/proto/common.pb.h>
 
@@ -57,6 +58,13 @@ public:
 
   virtual std::string GetBaseName() const;
 
+  /**
+   * Returns the name without its directional prefix and suffix, like GetBaseName but as a view
+   * into value() so that comparing names copies nothing.
+   * @return the base name, valid for as long as this street name
+   */
+  virtual std::string_view BaseName() const;
+
   virtual bool HasSameBaseName(const StreetName& rhs) const;
 
 protected:
@@ -31,6 +31,8 @@ public:
 
   std::string GetBaseName() const override;
 
+  std::string_view BaseName() const override;
+
   bool HasSameBaseName(const StreetName& rhs) const override;
 
 protected:
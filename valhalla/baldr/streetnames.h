@@ -39,6 +39,20 @@ public:
   virtual std::unique_ptr<StreetNames>
   FindCommonBaseNames(const StreetNames& other_street_names) const;
 
+  /**
+   * Counts the names which FindCommonStreetNames would find, without making a list of them.
+   * @param  other_street_names  the names to compare with
+   * @return how many of these names are also in the other names
+   */
+  size_t CountCommonStreetNames(const StreetNames& other_street_names) const;
+
+  /**
+   * Counts the names which FindCommonBaseNames would find, without making a list of them.
+   * @param  other_street_names  the names to compare with
+   * @return how many of these names have the same base name as one of the other names
+   */
+  size_t CountCommonBaseNames(const StreetNames& other_street_names) const;
+
   virtual std::unique_ptr<StreetNames> GetRouteNumbers() const;
   virtual std::unique_ptr<StreetNames> GetNonRouteNumbers() const;
 };
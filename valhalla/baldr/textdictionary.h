@@ -0,0 +1,89 @@
+#ifndef VALHALLA_BALDR_TEXTDICTIONARY_H_
+#define VALHALLA_BALDR_TEXTDICTIONARY_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Text shared by many tiles. Names, refs and sign text repeat across thousands of tiles, so
+ * instead of every tile keeping a copy of them in its text list, the tiles built with a dictionary
+ * only keep the text which isn't in it. Text offsets below the size of the dictionary are into the
+ * dictionary and the ones past it are into the text list of the tile, so the tile keeps the size
+ * and checksum of the dictionary it was built with and can only be read with that one.
+ *
+ * Like a text list the dictionary is null terminated strings one after the other, starting with
+ * the empty string at offset 0.
+ */
+class TextDictionary {
+public:
+  static constexpr uint32_t kNotFound = 0xffffffff;
+
+  /**
+   * Constructor.
+   * @param  text  The strings of the dictionary, each of them null terminated.
+   */
+  explicit TextDictionary(std::vector<char>&& text);
+
+  /**
+   * Reads a dictionary from a file.
+   * @param  file_name  Path to the dictionary.
+   * @return Returns the dictionary, throws if it can't be read.
+   */
+  static std::shared_ptr<const TextDictionary> Load(const std::string& file_name);
+
+  /**
+   * Writes the dictionary to a file.
+   * @param  file_name  Path to write it to.
+   */
+  void Store(const std::string& file_name) const;
+
+  /**
+   * Makes this the dictionary the tiles of this process are read and built with.
+   * @param  dictionary  The dictionary, nullptr to go back to tiles which have all of their text.
+   */
+  static void Register(std::shared_ptr<const TextDictionary> dictionary);
+
+  /**
+   * Gets the dictionary the tiles of this process are read and built with.
+   * @return Returns the registered dictionary, nullptr if there is none.
+   */
+  static std::shared_ptr<const TextDictionary> Registered();
+
+  const char* data() const {
+    return text_.data();
+  }
+
+  uint32_t size() const {
+    return static_cast<uint32_t>(text_.size());
+  }
+
+  uint32_t checksum() const {
+    return checksum_;
+  }
+
+  /**
+   * Finds a string in the dictionary. The first call indexes all of the strings.
+   * @param  text  The string to look for.
+   * @return Returns the offset of the string in the dictionary, kNotFound if it isn't in it.
+   */
+  uint32_t find(const std::string& text) const;
+
+protected:
+  std::vector<char> text_;
+  uint32_t checksum_;
+
+  mutable std::once_flag indexed_;
+  mutable std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TEXTDICTIONARY_H_
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+class GraphReader;
+
+/**
+ * The region one node of a sharded deployment serves, as a set of tiles of the local level. A
+ * reader of a shard only has the local (and transit) tiles of its region while the tiles of the
+ * levels above cover the whole graph, so the memory of a node goes down with the number of shards
+ * but any route can still leave the region on the highway levels.
+ *
+ * A route between two shards is stitched together at the nodes where the local edges of one shard
+ * lead into the other: the shard of the origin finds the costs to get to those nodes, the shard of
+ * the destination the costs to get from them and the cheapest sum is the route.
+ */
+class tile_shard_t {
+public:
+  // A local edge leaving the shard and the node in another shard it ends at
+  struct crossing_t {
+    GraphId edge;
+    GraphId node;
+  };
+
+  /**
+   * Constructor.
+   * @param  tileids  the ids of the local level tiles in the shard
+   */
+  explicit tile_shard_t(std::unordered_set<uint32_t> tileids);
+
+  /**
+   * Reads the tiles of a shard from a list with one tile per line, either as level/tileid, as
+   * tile path or as the tile id alone. Tiles of other levels than the local one are skipped.
+   * @param  file  the list of tiles
+   * @return the shard
+   * @throws std::runtime_error if the list can't be read
+   */
+  static tile_shard_t from_file(const std::string& file);
+
+  /**
+   * The shard read from the list, read once and shared by all the readers of the process.
+   * @param  file  the list of tiles
+   * @return the shard
+   * @throws std::runtime_error if the list can't be read
+   */
+  static std::shared_ptr<const tile_shard_t> get_instance(const std::string& file);
+
+  /**
+   * @param  tile  a tile or any id in it
+   * @return whether the shard has the tile, tiles of the levels above the local one it always has
+   */
+  bool Contains(const GraphId& tile) const;
+
+  /**
+   * @return the number of local level tiles in the shard
+   */
+  size_t size() const {
+    return tileids_.size();
+  }
+
+  /**
+   * Finds the local edges which leave the shard, the nodes they end at are where routes to other
+   * shards are stitched together.
+   * @param  reader  reader of the shard
+   * @return the edges leaving the shard and the nodes they lead to
+   */
+  std::vector<crossing_t> Crossings(GraphReader& reader) const;
+
+  /**
+   * Stitches the costs one shard found to its boundary nodes to the costs another shard found from
+   * them on.
+   * @param  to_boundary    the costs from the origin to the boundary nodes
+   * @param  from_boundary  the costs from the boundary nodes to the destination
+   * @return the boundary node the cheapest route goes through and its cost, an invalid node if
+   *         no boundary node was reached from both sides
+   */
+  static std::pair<GraphId, float> Stitch(const std::unordered_map<GraphId, float>& to_boundary,
+                                          const std::unordered_map<GraphId, float>& from_boundary);
+
+protected:
+  std::unordered_set<uint32_t> tileids_;
+};
+
+} // namespace baldr
+} // namespace valhalla
@@ -36,6 +36,19 @@ public:
    * */
   virtual response_t get(const std::string& url) = 0;
 
+  /**
+   * Makes requests to several urls and returns their responses in the same order. Implementations
+   * which can overlap the requests should override this, by default they are made one by one.
+   * */
+  virtual std::vector<response_t> get_multi(const std::vector<std::string>& urls) {
+    std::vector<response_t> responses;
+    responses.reserve(urls.size());
+    for (const auto& url : urls) {
+      responses.emplace_back(get(url));
+    }
+    return responses;
+  }
+
   /**
    * Whether tiles are with .gz extension.
    */
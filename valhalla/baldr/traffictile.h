@@ -187,7 +187,7 @@ struct TrafficTileHeader {
   uint64_t last_update; // seconds since epoch
   uint32_t directed_edge_count;
   uint32_t traffic_tile_version;
-  uint32_t spare2;
+  uint32_t generation; // bumped by writers once they are done updating the speeds in the tile
   uint32_t spare3;
 };
 
@@ -262,6 +262,13 @@ public:
     return header != nullptr;
   }
 
+  // Returns the generation of the speeds in this tile, 0 for tiles which were never updated
+  uint32_t generation() const {
+    return header != nullptr && header->traffic_tile_version == TRAFFIC_TILE_VERSION
+               ? header->generation
+               : 0;
+  }
+
 private:
   std::unique_ptr<const GraphMemory> memory_;
 
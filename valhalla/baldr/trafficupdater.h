@@ -0,0 +1,76 @@
+#ifndef VALHALLA_BALDR_TRAFFICUPDATER_H_
+#define VALHALLA_BALDR_TRAFFICUPDATER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/traffictile.h>
+
+namespace valhalla {
+namespace midgard {
+struct tar;
+}
+namespace baldr {
+
+/**
+ * The live speed of a single directed edge.
+ */
+struct TrafficUpdate {
+  GraphId edge_id;
+  TrafficSpeed speed;
+};
+
+/**
+ * Writes live speeds straight into the memory mapped traffic extract (mjolnir.traffic_extract),
+ * the same file the services read them from. Every speed is written as a single 64 bit store so a
+ * reader never sees half of an update. Once the speeds of a tile are written its last update time
+ * is set and its generation is bumped, which is how readers learn that the tile changed.
+ */
+class TrafficUpdater {
+public:
+  /**
+   * Maps the traffic tiles of the extract for writing.
+   * @param traffic_extract  path to the traffic tar, throws if it can't be opened
+   */
+  explicit TrafficUpdater(const std::string& traffic_extract);
+  ~TrafficUpdater();
+
+  /**
+   * Writes the speeds of the edges, the tiles are updated in parallel. When an edge is in the
+   * updates more than once the last of them wins.
+   * @param updates    the speeds of the edges
+   * @param threads    how many threads write the tiles
+   * @param timestamp  the seconds since epoch the speeds are from, 0 for now
+   * @return the number of speeds written, the others are of edges which aren't in the extract
+   */
+  size_t update(std::vector<TrafficUpdate> updates, uint32_t threads = 1, uint64_t timestamp = 0);
+
+  /**
+   * @return the number of traffic tiles in the extract
+   */
+  size_t tile_count() const {
+    return tiles_.size();
+  }
+
+  /**
+   * Makes the speed of an edge which is the same along its whole length.
+   * @param kph         the speed, 0 closes the edge and more than kMaxTrafficSpeed is clamped
+   * @param congestion  0 if unknown or 1 (no congestion) to 63 (most congested)
+   * @return the traffic speed
+   */
+  static TrafficSpeed speed(uint32_t kph, uint32_t congestion = UNKNOWN_CONGESTION_VAL);
+
+protected:
+  std::unique_ptr<midgard::tar> extract_;
+  // the traffic tiles in the extract by their tile id
+  std::unordered_map<GraphId, std::pair<char*, size_t>> tiles_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TRAFFICUPDATER_H_
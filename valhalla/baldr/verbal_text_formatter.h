@@ -1,18 +1,15 @@
 #ifndef VALHALLA_BALDR_VERBAL_TEXT_FORMATTER_H_
 #define VALHALLA_BALDR_VERBAL_TEXT_FORMATTER_H_
 
-#include <regex>
 #include <string>
 
+#include <valhalla/baldr/verbal_text_pattern.h>
 #include <valhalla/odin/markup_formatter.h>
 #include <valhalla/odin/sign.h>
 
 namespace valhalla {
 namespace baldr {
 
-// Regular expression to find numbers
-const std::regex kNumberSplitRegex("(\\D*)(\\d+)(\\D*)");
-
 /**
  * The generic verbal text formatter class that prepares strings for use with
  * a text-to-speech engine.
@@ -57,7 +54,7 @@ public:
   virtual std::string Format(const std::string& text) const;
 
 protected:
-  virtual std::string ProcessNumberSplitMatch(const std::smatch& m) const;
+  virtual std::string ProcessNumberSplitMatch(const VerbalTextPattern::Match& m) const;
 
   virtual std::string FormNumberSplitTts(const std::string& source) const;
 
@@ -3,16 +3,11 @@
 
 #include <valhalla/baldr/verbal_text_formatter_us.h>
 
-#include <array>
 #include <string>
-#include <utility>
 
 namespace valhalla {
 namespace baldr {
 
-const std::regex kColoradoRegex("(\\bCO)([ -])(\\d{1,3})", std::regex_constants::icase);
-const std::string kColoradoOutPattern = "Colorado $3";
-
 /**
  * The Colorado, US specific verbal text formatter class that prepares strings
  * for use with a text-to-speech engine.
@@ -1,23 +1,13 @@
 #ifndef VALHALLA_BALDR_VERBAL_TEXT_FORMATTER_US_TX_H_
 #define VALHALLA_BALDR_VERBAL_TEXT_FORMATTER_US_TX_H_
 
-#include <array>
 #include <string>
-#include <utility>
 
 #include <valhalla/baldr/verbal_text_formatter_us.h>
 
 namespace valhalla {
 namespace baldr {
 
-// Farm to Market
-const std::regex kFmRegex("(\\bF[ -]?M)([ -])?(\\d{1,4})", std::regex_constants::icase);
-const std::string kFmOutPattern = "Farm to Market Road $3";
-
-// Ranch to Market
-const std::regex kRmRegex("(\\bR[ -]?M)([ -])?(\\d{1,4})", std::regex_constants::icase);
-const std::string kRmOutPattern = "Ranch to Market Road $3";
-
 /**
  * The Texas, US specific verbal text formatter class that prepares strings
  * for use with a text-to-speech engine.
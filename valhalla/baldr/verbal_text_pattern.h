@@ -0,0 +1,152 @@
+#ifndef VALHALLA_BALDR_VERBAL_TEXT_PATTERN_H_
+#define VALHALLA_BALDR_VERBAL_TEXT_PATTERN_H_
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A pattern the verbal text formatters look for in street names and signs. It covers the few
+ * regular expression features they need, the elements are given one after the other rather than
+ * parsed from a regular expression. Searching and replacing behave as std::regex_search and
+ * std::regex_replace do with the ECMAScript grammar: elements repeat greedily and give back what
+ * they took when the rest of the pattern does not match, alternatives are tried in order and the
+ * leftmost match wins. Character classes and word boundaries are ASCII only, like those of the
+ * classic locale.
+ */
+class VerbalTextPattern {
+public:
+  using CharSet = std::bitset<256>;
+
+  // As many as there are, * and + rather than {n,m}
+  static constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+
+  /**
+   * One part of a pattern. Consecutive elements with the same group number make up a group which
+   * can be referred to as $n in a replacement, group 0 is none.
+   */
+  struct Element {
+    enum class Type : uint8_t {
+      kChars,        // from min to max of the characters in the set
+      kText,         // one of the texts
+      kWordBoundary, // \b
+      kBegin,        // ^
+      kEnd,          // $
+      kBeginOrChars  // (^|[set])
+    };
+
+    Type type;
+    uint8_t group;
+    size_t min;
+    size_t max;
+    bool optional; // the group is followed by ? and need not take part in a match
+    CharSet chars;
+    std::vector<std::string> texts;
+
+    /**
+     * @return  a copy of the element which may be left out of a match, its group is then not
+     *          matched
+     */
+    Element Optional() const {
+      Element element(*this);
+      element.optional = true;
+      return element;
+    }
+  };
+
+  /**
+   * What one group of a match took, modelled after std::sub_match.
+   */
+  struct Group {
+    bool matched = false;
+    size_t begin = 0;
+    size_t end = 0;
+    const std::string* text = nullptr;
+
+    std::string str() const {
+      return matched ? text->substr(begin, end - begin) : std::string();
+    }
+  };
+
+  /**
+   * The groups of a match, group 0 is the whole match.
+   */
+  class Match {
+  public:
+    const Group& operator[](const size_t group) const {
+      return groups_[group];
+    }
+
+  protected:
+    friend class VerbalTextPattern;
+    std::array<Group, 8> groups_;
+  };
+
+  static CharSet Chars(const std::string& chars);
+  static CharSet Range(const char first, const char last);
+  static CharSet Digits();
+  static CharSet NonDigits();
+  static CharSet Letters();
+
+  static Element Set(const uint8_t group,
+                     const CharSet& chars,
+                     const size_t min = 1,
+                     const size_t max = 1);
+  static Element Text(const uint8_t group, const std::string& text);
+  static Element AnyText(const uint8_t group, const std::vector<std::string>& texts);
+  static Element WordBoundary(const uint8_t group);
+  static Element Begin(const uint8_t group);
+  static Element End(const uint8_t group);
+  static Element BeginOrSet(const uint8_t group, const CharSet& chars);
+
+  /**
+   * Constructor.
+   * @param  elements     the parts of the pattern in order
+   * @param  ignore_case  whether texts are compared without regard to ASCII case
+   */
+  VerbalTextPattern(std::initializer_list<Element> elements, const bool ignore_case = false);
+
+  /**
+   * Finds the first match which starts at or after the position.
+   * @param  text      the text to search
+   * @param  position  where to start searching, the text before still counts for \b and ^
+   * @param  match     the groups of the match if there is one, they refer to the text
+   * @return true if a match was found
+   */
+  bool Search(const std::string& text, const size_t position, Match& match) const;
+
+  /**
+   * Replaces every match in the text with the format, in which $n stands for what group n took.
+   * @param  text    the text to search
+   * @param  format  the replacement
+   * @return the text with the matches replaced
+   */
+  std::string Replace(const std::string& text, const std::string& format) const;
+
+protected:
+  static constexpr size_t kMaxElements = 8;
+
+  // Where each element started and ended in a match, the one past the last is where it ended
+  using Spans = std::array<std::pair<size_t, size_t>, kMaxElements + 1>;
+
+  // Matches the elements from the index on at the position and records where each one went
+  bool MatchAt(const std::string& text, const size_t index, const size_t position, Spans& spans)
+      const;
+
+  std::vector<Element> elements_;
+  bool ignore_case_;
+  uint8_t groups_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_VERBAL_TEXT_PATTERN_H_
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/proto/options.pb.h>
+
+namespace valhalla {
+namespace loki {
+
+/**
+ * Sheds expensive requests before they are searched and routed when the service already has more
+ * work than it can get through within a deadline, so that a few huge matrices or isochrones cannot
+ * keep every worker busy while cheap requests time out behind them.
+ *
+ * The cost of a request is a rough estimate of the kilometers of road it makes the path algorithms
+ * go through. The costs of the admitted requests make up a backlog shared by every worker of the
+ * process which drains at the configured throughput. A request estimated to cost at least the
+ * expensive cost is refused when the backlog would take longer than the max wait to drain. Cheap
+ * requests are always admitted but still count towards the backlog.
+ */
+class AdmissionControl {
+public:
+  /**
+   * @param config  the loki.admission part of the config, a max_wait of 0 admits every request
+   */
+  explicit AdmissionControl(const boost::property_tree::ptree& config);
+
+  /**
+   * Admits the request and adds its cost to the backlog.
+   * @param options  the options of the parsed request
+   * @throws valhalla_exception_t 174 when the request is expensive and the backlog is too long
+   */
+  void admit(const Options& options);
+
+  /**
+   * Estimates the cost of a request from its action, locations, contours and costing.
+   * @param options  the options of the parsed request
+   * @return the cost in kilometers of road, 0 for requests which do not search the graph
+   */
+  static double estimate(const Options& options);
+
+  /**
+   * Empties the backlog shared by the workers of the process.
+   */
+  static void reset();
+
+protected:
+  // the cost from which requests are expensive
+  double expensive_cost_;
+  // the cost the service gets through per second
+  double throughput_;
+  // the longest the backlog may take to drain before expensive requests are refused, in seconds
+  double max_wait_;
+};
+
+} // namespace loki
+} // namespace valhalla
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace loki {
+
+/**
+ * Finer spatial information about the edges in the bins of the graph tiles. A tile only bins its
+ * edges on a kBinsDim x kBinsDim grid so in a dense city center a single bin can list thousands of
+ * edges and the search would decode and project onto every one of their shapes. Keeping the
+ * bounding box of each of those edges lets the search skip the ones which cannot possibly be
+ * closer than what it already found, which makes its cost follow the edges near the location
+ * rather than the population of the bin.
+ *
+ * The boxes are worked out from the edge shapes the first time a bin is searched and kept across
+ * requests. Shapes do not change with live traffic so there is nothing to invalidate. When the
+ * cache is full it is cleared, like the simple tile cache.
+ */
+class BinIndex {
+public:
+  // rounded outwards to floats so that the box always contains the decoded shape
+  struct box_t {
+    float minx;
+    float miny;
+    float maxx;
+    float maxy;
+
+    /**
+     * @return the point in the box which is closest to ll, ll itself when it is inside of it
+     */
+    midgard::PointLL closest(const midgard::PointLL& ll) const {
+      return {std::min(std::max(ll.lng(), static_cast<double>(minx)), static_cast<double>(maxx)),
+              std::min(std::max(ll.lat(), static_cast<double>(miny)), static_cast<double>(maxy))};
+    }
+  };
+
+  /**
+   * @param max_bins  how many bins to keep the boxes of, 0 disables the index
+   */
+  explicit BinIndex(size_t max_bins = 0) : max_bins_(max_bins) {
+  }
+
+  /**
+   * Gets the boxes of the edges in a bin of a tile, building them if this is the first time
+   * @param tile    the tile whose bin it is
+   * @param bin     the index of the bin in the tile
+   * @param reader  to get at the shapes of edges which are binned here but live in another tile
+   * @return the boxes in the same order as GraphTile::GetBin lists the edges, nullptr when the
+   *         index is disabled. valid until the next call
+   */
+  const std::vector<box_t>*
+  get(const graph_tile_ptr& tile, uint16_t bin, baldr::GraphReader& reader);
+
+  void clear() {
+    bins_.clear();
+  }
+
+  size_t size() const {
+    return bins_.size();
+  }
+
+protected:
+  size_t max_bins_;
+  std::unordered_map<uint64_t, std::vector<box_t>> bins_;
+};
+
+} // namespace loki
+} // namespace valhalla
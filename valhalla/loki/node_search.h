@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <valhalla/baldr/graphreader.h>
+#include <vector>
 
 namespace valhalla {
 namespace loki {
@@ -27,6 +28,30 @@ std::vector<baldr::GraphId> nodes_in_bbox(const midgard::AABB2<midgard::PointLL>
 std::vector<baldr::GraphId> edges_in_bbox(const midgard::AABB2<midgard::PointLL>& bbox,
                                           baldr::GraphReader& reader);
 
+/**
+ * Find nodes within each of the given bounding boxes in the route network. The
+ * tiles and bins shared by several boxes are only searched once.
+ *
+ * @param  bboxes  bounding boxes in which to look for nodes.
+ * @param  reader  graph reader object to use for loading tiles.
+ * @return nodes   for each bounding box, in the same order, the nodes which are in it.
+ */
+std::vector<std::vector<baldr::GraphId>>
+nodes_in_bboxes(const std::vector<midgard::AABB2<midgard::PointLL>>& bboxes,
+                baldr::GraphReader& reader);
+
+/**
+ * Find edges that intersect each of the given bounding boxes in the route
+ * network. The tiles and bins shared by several boxes are only searched once.
+ *
+ * @param  bboxes  bounding boxes in which to look for edges.
+ * @param  reader  graph reader object to use for loading tiles.
+ * @return edges   for each bounding box, in the same order, the edges which intersect it.
+ */
+std::vector<std::vector<baldr::GraphId>>
+edges_in_bboxes(const std::vector<midgard::AABB2<midgard::PointLL>>& bboxes,
+                baldr::GraphReader& reader);
+
 } // namespace loki
 } // namespace valhalla
 
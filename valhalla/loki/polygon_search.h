@@ -13,13 +13,15 @@ namespace loki {
  *
  * @param rings The (optionally closed) rings to intersect edges with
  * @param reader GraphReader instance
+ * @param threads How many threads may test the edges against the rings
  *
  */
 std::unordered_set<valhalla::baldr::GraphId>
 edges_in_rings(const google::protobuf::RepeatedPtrField<valhalla::Ring>& rings,
                baldr::GraphReader& reader,
                const std::shared_ptr<sif::DynamicCost>& costing,
-               float max_length);
+               float max_length,
+               uint32_t threads = 1);
 
 } // namespace loki
 } // namespace valhalla
@@ -5,6 +5,11 @@
 #include <valhalla/loki/search.h>
 #include <valhalla/thor/dijkstras.h>
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+
 constexpr uint8_t kInbound = 1;
 constexpr uint8_t kOutbound = 2;
 
@@ -32,6 +37,134 @@ struct directed_reach {
   uint32_t inbound : 16;
 };
 
+/**
+ * Remembers reach results across requests so that popular edges (airports, stations, downtowns)
+ * are not expanded again for every location that lands on them. Results are only valid for the
+ * costing they were computed with so the cache is bound to a costing via use_costing before each
+ * request. A costing with user excluded edges is unique to its request and disables the cache.
+ * Live traffic can close edges which changes reach, so the owner should clear the cache whenever
+ * traffic is updated. When the cache is full it is cleared, like the simple tile cache.
+ *
+ * When the request uses the default auto, pedestrian or bicycle costing the reach may also have
+ * been stored in the tiles at build time (see mjolnir::ReachBuilder), find_stored looks it up.
+ */
+class ReachCache {
+public:
+  explicit ReachCache(size_t max_size = 0) : max_size_(max_size) {
+  }
+
+  /**
+   * Binds the cache to the costing of the request which is about to use it
+   * @param options     the request options after the costing is parsed and exclusions are applied
+   * @param use_stored  whether reach stored in the tiles may be used for default costings, it
+   *                    doesnt know about live traffic closures
+   */
+  void use_costing(const Options& options, bool use_stored = true);
+
+  /**
+   * @return true if the tiles may have the reach stored for the current costing
+   */
+  bool has_stored() const {
+    return stored_access_ != 0;
+  }
+
+  /**
+   * @return true if the reach of the edge was stored in the tile at build time for the current
+   * costing, up to at least max reach
+   */
+  bool find_stored(const graph_tile_ptr& tile,
+                   const baldr::GraphId& edge_id,
+                   uint32_t max_reach,
+                   directed_reach& reach) const {
+    if (!stored_access_ || !tile || !tile->header()->has_ext_directededge())
+      return false;
+    const auto* ext = tile->ext_directededge(edge_id);
+    if (ext->reach_limit() < max_reach)
+      return false;
+    reach.outbound = std::min(ext->outbound_reach(stored_access_), max_reach);
+    reach.inbound = std::min(ext->inbound_reach(stored_access_), max_reach);
+    return true;
+  }
+
+  /**
+   * @return true if the reach of the edge is known for the current costing and max reach
+   */
+  bool find(const baldr::GraphId& edge_id, uint32_t max_reach, directed_reach& reach) const {
+    if (!costing_key_)
+      return false;
+    auto found = reaches_.find(key_t{costing_key_, edge_id, max_reach});
+    if (found == reaches_.cend())
+      return false;
+    reach = found->second;
+    return true;
+  }
+
+  /**
+   * Remembers the reach of the edge for the current costing and max reach
+   */
+  void insert(const baldr::GraphId& edge_id, uint32_t max_reach, const directed_reach& reach) {
+    if (!costing_key_)
+      return;
+    if (reaches_.size() >= max_size_)
+      reaches_.clear();
+    reaches_.emplace(key_t{costing_key_, edge_id, max_reach}, reach);
+  }
+
+  void clear() {
+    reaches_.clear();
+  }
+
+  /**
+   * Counts an expansion which found the reach of an edge that was neither stored nor cached
+   * @param elapsed  how long the expansion took
+   */
+  void add_expansion(std::chrono::steady_clock::duration elapsed) {
+    ++expansions_;
+    expansion_time_ += elapsed;
+  }
+
+  /**
+   * @return the number of expansions and their milliseconds since the last call
+   */
+  std::pair<size_t, double> take_expansions() {
+    std::pair<size_t, double> taken{expansions_,
+                                    std::chrono::duration<double, std::milli>(expansion_time_)
+                                        .count()};
+    expansions_ = 0;
+    expansion_time_ = {};
+    return taken;
+  }
+
+  size_t size() const {
+    return reaches_.size();
+  }
+
+protected:
+  struct key_t {
+    uint64_t costing;
+    uint64_t edge_id;
+    uint32_t max_reach;
+    bool operator==(const key_t& other) const {
+      return costing == other.costing && edge_id == other.edge_id && max_reach == other.max_reach;
+    }
+  };
+  struct key_hasher_t {
+    size_t operator()(const key_t& key) const {
+      auto seed = std::hash<uint64_t>{}(key.edge_id);
+      seed ^= key.costing + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      seed ^= key.max_reach + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      return seed;
+    }
+  };
+
+  size_t max_size_;
+  uint64_t costing_key_{};
+  uint32_t stored_access_{};
+  std::unordered_map<key_t, directed_reach, key_hasher_t> reaches_;
+  size_t expansions_{};
+  std::chrono::steady_clock::duration expansion_time_{};
+};
+
 class Reach : public thor::Dijkstras {
 public:
   Reach();
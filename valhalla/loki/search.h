@@ -13,6 +13,9 @@
 namespace valhalla {
 namespace loki {
 
+class ReachCache;
+class BinIndex;
+
 /**
  * Find an location within the route network given an input location
  * same tiled route data and a search strategy
@@ -22,13 +25,37 @@ namespace loki {
  * proper cache
  * @param costing        a costing object by which we can determine which portions of the graph are
  *                       accessable and therefor potential candidates
+ * @param reach_cache    optional cache of reach results kept across requests for the costing
+ * @param bin_index      optional boxes of the edges in the bins, kept across requests, which let
+ *                       the search skip the edges of a bin that are too far away to matter
  * @return pathLocations the correlated data with in the tile that matches the inputs. If a
  * projection is not found, it will not have any entry in the returned value.
  */
 std::unordered_map<baldr::Location, baldr::PathLocation>
 Search(const std::vector<baldr::Location>& locations,
        baldr::GraphReader& reader,
-       const std::shared_ptr<sif::DynamicCost>& costing);
+       const std::shared_ptr<sif::DynamicCost>& costing,
+       ReachCache* reach_cache = nullptr,
+       BinIndex* bin_index = nullptr);
+
+/**
+ * Same as above but for several costings at once, the edges any of them allow are candidates so
+ * that one correlation serves the searches of all of them. Each search has to drop the candidates
+ * its costing doesn't allow. The reach of an edge is found with the first costing that allows it.
+ *
+ * @param locations      the positions which need to be correlated to the route network
+ * @param reader         and object used to access tiled route data
+ * @param costings       the costings, the reach cache and the search filters are for the first one
+ * @param reach_cache    optional cache of reach results kept across requests for the first costing
+ * @param bin_index      optional boxes of the edges in the bins, kept across requests
+ * @return pathLocations the correlated data with in the tile that matches the inputs
+ */
+std::unordered_map<baldr::Location, baldr::PathLocation>
+Search(const std::vector<baldr::Location>& locations,
+       baldr::GraphReader& reader,
+       const std::vector<std::shared_ptr<sif::DynamicCost>>& costings,
+       ReachCache* reach_cache = nullptr,
+       BinIndex* bin_index = nullptr);
 
 } // namespace loki
 } // namespace valhalla
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/location.h>
+
+namespace valhalla {
+namespace loki {
+
+/**
+ * The transit stops of the transit tiles, sorted by latitude so that the ones around a location are
+ * a binary search away instead of a walk over all the nodes of the tiles. The stops of a tile are
+ * gathered the first time it is looked at and kept from then on, transit only changes with the
+ * tiles so there is nothing to invalidate.
+ */
+class TransitStopIndex {
+public:
+  struct stop_t {
+    float lat;
+    float lng;
+  };
+
+  /**
+   * Gets the stops of a transit tile, gathering them if this is the first time
+   * @param tile_id  the transit tile
+   * @param reader   to get at the tile
+   * @return the stations, egresses and platforms of the tile sorted by latitude, empty if there is
+   *         no such tile. valid until the next call
+   */
+  const std::vector<stop_t>& get(const baldr::GraphId& tile_id, baldr::GraphReader& reader);
+
+  /**
+   * Finds out for many locations at once whether there is transit around them. A location with a
+   * radius needs a stop within the radius, one without a stop in the transit tile it is in.
+   * @param locations  the locations to look around
+   * @param reader     to get at the transit tiles
+   * @return one flag per location
+   */
+  std::vector<bool> has_stops(const std::vector<baldr::Location>& locations,
+                              baldr::GraphReader& reader);
+
+  void clear() {
+    tiles_.clear();
+  }
+
+  size_t size() const {
+    return tiles_.size();
+  }
+
+protected:
+  std::unordered_map<uint32_t, std::vector<stop_t>> tiles_;
+};
+
+} // namespace loki
+} // namespace valhalla
@@ -11,6 +11,10 @@
 #include <valhalla/baldr/location.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/baldr/rapidjson_utils.h>
+#include <valhalla/loki/admission.h>
+#include <valhalla/loki/bin_index.h>
+#include <valhalla/loki/reach.h>
+#include <valhalla/loki/transit_stop_index.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/proto/options.pb.h>
 #include <valhalla/sif/costfactory.h>
@@ -36,6 +40,19 @@ public:
 #endif
   virtual void cleanup() override;
 
+  /**
+   * Throws if the action of the request is not one of the configured loki.actions
+   * @param request  the parsed request
+   */
+  void check_action(const Api& request) const;
+
+  /**
+   * Throws if the request is expensive and the service already has too much work queued, see
+   * AdmissionControl
+   * @param request  the parsed request
+   */
+  void admit(const Api& request);
+
   std::string locate(Api& request);
   void route(Api& request);
   void matrix(Api& request);
@@ -55,6 +72,14 @@ protected:
   void parse_costing(Api& request, bool allow_none = false);
   void locations_from_shape(Api& request);
   void check_hierarchy_distance(Api& request);
+  // the costings of the comparisons of a route request, after checking that they are allowed
+  std::vector<sif::cost_ptr_t> parse_comparisons(Api& request);
+  // correlates the locations to the graph, timing the search and the reach expansions it needed.
+  // the edges the costings of the comparisons allow are candidates too
+  std::unordered_map<baldr::Location, baldr::PathLocation>
+  search(Api& request,
+         const std::vector<baldr::Location>& locations,
+         const std::vector<sif::cost_ptr_t>& comparisons = {});
 
   void init_locate(Api& request);
   void init_route(Api& request);
@@ -75,9 +100,12 @@ protected:
   std::unordered_map<std::string, float> max_distance;
   std::unordered_map<std::string, float> max_matrix_distance;
   size_t max_timedep_dist_matrix;
+  size_t max_matrix_departure_times;
   std::unordered_map<std::string, float> max_matrix_locations;
   size_t max_exclude_locations;
   float max_exclude_polygons_length;
+  // how many threads test the edges near exclude_polygons against them
+  uint32_t exclude_polygons_threads;
   unsigned int max_reachability;
   unsigned int default_reachability;
   unsigned int max_radius;
@@ -102,7 +130,12 @@ protected:
   skadi::sample sample;
   size_t max_elevation_shape;
   float min_resample;
+  ReachCache reach_cache;
+  BinIndex bin_index;
+  TransitStopIndex transit_stops;
+  AdmissionControl admission;
   unsigned int max_alternates;
+  size_t max_comparisons;
   bool allow_verbose;
 
   // add max_distance_disable_hierarchy_culling
@@ -112,6 +145,9 @@ private:
   std::string service_name() const override {
     return "loki";
   }
+  const baldr::GraphReader* graph_reader() const override {
+    return reader.get();
+  }
 };
 } // namespace loki
 } // namespace valhalla
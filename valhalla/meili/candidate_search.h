@@ -4,7 +4,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -34,11 +37,59 @@ public:
                                                  const sif::cost_ptr_t& costing = nullptr) const = 0;
 };
 
-class CandidateGridQuery final : public CandidateQuery {
+// Grids indexed for candidate queries, kept per bin within a graph tile and per cell size. A single
+// cache can back the candidate queries of many workers: grids are never modified once they are put
+// into the cache, so they are handed out read only and outlive eviction for as long as a query still
+// holds them
+class CandidateGridCache final {
 public:
   using grid_t = GridRangeQuery<baldr::GraphId, midgard::PointLL>;
 
-  CandidateGridQuery(baldr::GraphReader& reader, float cell_width, float cell_height);
+  // max_size is the number of grids kept, once it is exceeded the whole cache is cleared
+  explicit CandidateGridCache(size_t max_size) : max_size_(max_size) {
+  }
+
+  std::shared_ptr<const grid_t> Get(int32_t bin_id, float cell_width, float cell_height) const;
+
+  // Returns the grid that ends up in the cache, which is the one another worker put first if it beat
+  // us to indexing the same bin
+  std::shared_ptr<const grid_t>
+  Put(int32_t bin_id, float cell_width, float cell_height, std::shared_ptr<const grid_t> grid);
+
+  size_t size() const;
+
+  void Clear();
+
+private:
+  struct key_t {
+    int32_t bin_id;
+    float cell_width;
+    float cell_height;
+    bool operator==(const key_t& other) const {
+      return bin_id == other.bin_id && cell_width == other.cell_width &&
+             cell_height == other.cell_height;
+    }
+  };
+
+  struct key_hash_t {
+    size_t operator()(const key_t& key) const;
+  };
+
+  size_t max_size_;
+  mutable std::mutex mutex_;
+  std::unordered_map<key_t, std::shared_ptr<const grid_t>, key_hash_t> grids_;
+};
+
+class CandidateGridQuery final : public CandidateQuery {
+public:
+  using grid_t = CandidateGridCache::grid_t;
+
+  // Grids are indexed on first use and kept by this query. If a shared cache is passed they are looked
+  // up there first and grids this query indexes are put there for other queries to use
+  CandidateGridQuery(baldr::GraphReader& reader,
+                     float cell_width,
+                     float cell_height,
+                     std::shared_ptr<CandidateGridCache> shared_cache = nullptr);
 
   ~CandidateGridQuery() override;
 
@@ -64,7 +115,7 @@ public:
                                            edgeids.end(), costing);
   }
 
-  std::unordered_map<baldr::GraphId, grid_t>::size_type size() const {
+  size_t size() const {
     return grid_cache_.size();
   }
 
@@ -87,9 +138,12 @@ private:
   float cell_height_;
 
   // Grid cache - cached per "bin" within a graph tile
-  mutable std::unordered_map<int32_t, grid_t> grid_cache_;
+  mutable std::unordered_map<int32_t, std::shared_ptr<const grid_t>> grid_cache_;
 
   baldr::GraphReader& reader_;
+
+  // Cache shared with other queries, may be null
+  std::shared_ptr<CandidateGridCache> shared_cache_;
 };
 
 } // namespace meili
@@ -23,6 +23,8 @@ struct Config {
 
     size_t cache_size = 100240;
     size_t grid_size = 500;
+    // share the grids between all matcher factories of the process instead of one cache each
+    bool shared_grid_cache = false;
 
     void Read(const boost::property_tree::ptree& params);
   };
@@ -42,6 +44,10 @@ struct Config {
     float turn_penalty_factor = 200.f;
     // define if 'turn_penalty_factor' option can be reassigned with user request
     bool is_turn_penalty_factor_customizable = true;
+    // how many edges to keep the shortest path trees out of, 0 disables the cache
+    size_t route_cache_size = 0;
+    // how far (meters) the kept trees reach, longer transitions search the graph
+    float route_cache_distance = 500.f;
 
     void Read(const boost::property_tree::ptree& params);
   };
@@ -62,6 +68,12 @@ struct Config {
     float interpolation_distance_meters = 10.f;
     // define if 'interpolation_distance' option can be reassigned with user request
     bool is_interpolation_distance_customizable = false;
+    // maximum number of matched measurements online matching keeps before forcing a result
+    size_t max_online_lag = 256;
+    // how many states of a column the viterbi search extends at most, 0 extends all of them
+    size_t beam_width = 0;
+    // how much more than the best state of a column a state may cost to be extended, 0 disables it
+    float beam_cost = 0.f;
 
     void Read(const boost::property_tree::ptree& params);
   };
@@ -21,6 +21,10 @@ Project(const midgard::projector_t& p,
         midgard::Shape7Decoder<midgard::PointLL>& shape,
         double snap_distance = 0.0);
 
+// same as above on an already decoded shape, which must not be empty
+std::tuple<midgard::PointLL, double, typename std::vector<midgard::PointLL>::size_type, double>
+Project(const midgard::projector_t& p, midgard::shape_soa_t& shape, double snap_distance = 0.0);
+
 } // namespace helpers
 } // namespace meili
 } // namespace valhalla
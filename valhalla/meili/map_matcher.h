@@ -28,7 +28,9 @@ public:
              baldr::GraphReader& graphreader,
              CandidateQuery& candidatequery,
              const sif::mode_costing_t& mode_costing,
-             sif::TravelMode travelmode);
+             sif::TravelMode travelmode,
+             RouteCache* route_cache = nullptr,
+             size_t costing_key = 0);
 
   ~MapMatcher();
 
@@ -69,6 +71,29 @@ public:
   std::vector<MatchResults> OfflineMatch(const std::vector<Measurement>& measurements,
                                          uint32_t k = 1);
 
+  /**
+   * Match a trace which arrives in chunks. Results are only handed back once all the paths the
+   * search could still take agree on them, after which the states behind them are dropped. This
+   * keeps the memory bounded by how far back the paths disagree (at most max_online_lag matched
+   * measurements) rather than by the length of the trace. Call Clear() before starting a new trace
+   * and FinishOnlineMatch() after its last chunk.
+   *
+   * Note that the state ids of the results refer to states which may have already been dropped so
+   * they should only be used to tell matched results from interpolated ones.
+   *
+   * @param measurements  the next chunk of the trace
+   * @return the results that became final with this chunk, in the order of the trace
+   */
+  std::vector<MatchResult> OnlineMatch(const std::vector<Measurement>& measurements);
+
+  /**
+   * Finish an online match returning the results for the rest of the trace. The matcher is cleared
+   * afterwards so it can be used for the next trace.
+   *
+   * @return the remaining results, in the order of the trace
+   */
+  std::vector<MatchResult> FinishOnlineMatch();
+
   /**
    * Set a callback that will throw when the map-matching should be aborted
    * @param interrupt_callback  the function to periodically call to see if we should abort
@@ -79,14 +104,19 @@ public:
   }
 
 private:
-  std::unordered_map<StateId::Time, std::vector<Measurement>>
-  AppendMeasurements(const std::vector<Measurement>& measurements);
+  using interpolated_t = std::unordered_map<StateId::Time, std::vector<Measurement>>;
+
+  void AppendMeasurements(const std::vector<Measurement>& measurements,
+                          interpolated_t& interpolated,
+                          bool match_last);
 
   StateId::Time AppendMeasurement(const Measurement& measurement, const float sq_max_search_radius);
 
   void RemoveRedundancies(const std::vector<StateId>& result,
                           const std::vector<MatchResult>& results);
 
+  void RestartOnlineMatch(StateId::Time time, const StateId& stateid);
+
   Config config_;
 
   baldr::GraphReader& graphreader_;
@@ -109,6 +139,9 @@ private:
   EmissionCostModel emission_cost_model_;
 
   TransitionCostModel transition_cost_model_;
+
+  // Measurements of the online match which were interpolated rather than matched
+  interpolated_t online_interpolated_;
 };
 
 /**
@@ -135,6 +168,27 @@ bool MergeRoute(const State& source,
 std::vector<EdgeSegment> ConstructRoute(const MapMatcher& mapmatcher,
                                         const std::vector<MatchResult>& match_results);
 
+/**
+ * Finds where OfflineMatch breaks the path of a trace because two measurements in a row are too far
+ * apart for any route between their candidates to fit within the breakage distance. Nothing is
+ * routed across such a cut so each part of the trace matches on its own exactly as it would within
+ * the whole trace, which lets the parts be matched separately and joined with JoinMatchResults.
+ * @param config        the config of the matchers which will match the parts
+ * @param measurements  the trace
+ * @return the index of the first measurement of each part, just {0} when there is nothing to cut
+ */
+std::vector<size_t> FindBreakages(const Config& config,
+                                  const std::vector<Measurement>& measurements);
+
+/**
+ * Joins the best matches of the parts of a trace back into the one OfflineMatch would give for the
+ * whole trace. The state ids of the results still refer to the matchers of the parts so they should
+ * only be used to tell matched results from interpolated ones.
+ * @param parts  the matches of the parts in the order of the trace
+ * @return the match of the whole trace
+ */
+MatchResults JoinMatchResults(std::vector<MatchResults>&& parts);
+
 template <typename segment_iterator_t>
 std::vector<std::vector<midgard::PointLL>> ConstructRouteShapes(baldr::GraphReader& graphreader,
                                                                 segment_iterator_t begin,
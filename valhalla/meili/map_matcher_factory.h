@@ -14,6 +14,7 @@
 #include <valhalla/meili/candidate_search.h>
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/map_matcher.h>
+#include <valhalla/meili/route_cache.h>
 
 namespace valhalla {
 namespace meili {
@@ -33,6 +34,11 @@ public:
     return *candidatequery_;
   }
 
+  // nullptr when meili.route_cache.size is 0
+  RouteCache* routecache() {
+    return route_cache_.get();
+  }
+
   MapMatcher* Create(const Options& options);
 
   MapMatcher* Create(const Costing::Type costing_type) {
@@ -59,6 +65,8 @@ private:
   sif::CostFactory cost_factory_;
 
   std::shared_ptr<CandidateGridQuery> candidatequery_;
+
+  std::shared_ptr<RouteCache> route_cache_;
 };
 
 } // namespace meili
@@ -50,6 +50,15 @@ public:
     return heap_.size();
   }
 
+  // Iterate the labels in no particular order
+  typename Heap::const_iterator begin() const {
+    return heap_.begin();
+  }
+
+  typename Heap::const_iterator end() const {
+    return heap_.end();
+  }
+
 protected:
   Heap heap_;
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/meili/routing.h>
+
+namespace valhalla {
+namespace meili {
+
+/**
+ * Keeps the shortest path trees out of the edges map matching routes from, so that the transitions
+ * out of an edge which traces keep coming back to, like the roads of a bus line or a trace which is
+ * matched again, do not search the graph every time. A tree answers for any point along its edge
+ * as long as it reaches as far as the search from that point would go.
+ *
+ * Trees are kept per costing since the paths depend on it. A tree is only built the second time
+ * its edge is asked for so that the edges which are passed once do not pay for a whole tree. When
+ * the cache is full it is cleared, like the candidate grids. Live traffic changes the times of the
+ * paths so the owner clears it when traffic changes.
+ */
+class RouteCache {
+public:
+  /**
+   * @param max_size  how many edges to keep trees of (or remember having been asked for)
+   * @param distance  how far the trees reach from the beginning of their edge
+   */
+  RouteCache(size_t max_size, float distance) : max_size_(max_size), distance_(distance), size_(0) {
+  }
+
+  float distance() const {
+    return distance_;
+  }
+
+  /**
+   * Looks up the tree of an edge
+   * @param costing  identifies the costing the tree has to be for
+   * @param edgeid   the edge the paths start on
+   * @param build    set to whether the caller should build the tree and put it in
+   * @return the tree, nullptr when there is none
+   */
+  route_tree_ptr_t find(size_t costing, const baldr::GraphId& edgeid, bool& build);
+
+  /**
+   * Keeps a tree
+   * @param costing  identifies the costing the tree is for
+   * @param tree     the tree
+   */
+  void put(size_t costing, route_tree_ptr_t tree);
+
+  void clear() {
+    trees_.clear();
+    size_ = 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+protected:
+  size_t max_size_;
+  float distance_;
+  size_t size_;
+  // costing to edge to tree, which is nullptr for an edge which was asked for once
+  std::unordered_map<size_t, std::unordered_map<uint64_t, route_tree_ptr_t>> trees_;
+};
+
+} // namespace meili
+} // namespace valhalla
@@ -4,6 +4,8 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <vector>
@@ -13,6 +15,7 @@
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/midgard/distanceapproximator.h>
+#include <valhalla/midgard/flat_hash.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/sif/costconstants.h>
 #include <valhalla/sif/dynamiccost.h>
@@ -134,6 +137,27 @@ public:
     nodeid_ = id;
   }
 
+  /**
+   * Moves a label of a path which was found from one point along its first edge onto the same path
+   * from another point along that edge. The cost of the part of the edge between the two points
+   * is taken off and the label is hung off a predecessor in another label set.
+   * @param predecessor  the index of the predecessor in the other label set
+   * @param offset       the cost of the part of the first edge the path no longer goes over
+   */
+  void Rebase(const uint32_t predecessor, const sif::Cost& offset) {
+    predecessor_ = predecessor;
+    cost_ -= offset;
+    sortcost_ -= offset.cost;
+  }
+
+  /**
+   * Set the source distance, for the first label of a rebased path.
+   * @param source  the source distance (0-1).
+   */
+  void set_source(const float source) {
+    source_ = source;
+  }
+
 private:
   // Must be mutually exclusive, i.e. nodeid.Is_Valid() XOR dest != kInvalidDestination
   baldr::GraphId nodeid_;
@@ -263,20 +287,52 @@ public:
     dest_status_.clear();
   }
 
+  /**
+   * Add a label as it is, without queueing it. Used to put together the paths of a finished search.
+   * @return  Returns the index of the label.
+   */
+  uint32_t append(const Label& label) {
+    labels_.push_back(label);
+    return labels_.size() - 1;
+  }
+
+  /**
+   * Get the number of labels.
+   * @return  Returns the number of labels in the set.
+   */
+  size_t size() const {
+    return labels_.size();
+  }
+
 private:
   baldr::DoubleBucketQueue<Label> queue_;                  // Priority queue
-  std::unordered_map<baldr::GraphId, Status> node_status_; // Node status
-  std::unordered_map<uint16_t, Status> dest_status_;       // Destination status
+  midgard::flat_map<baldr::GraphId, Status> node_status_; // Node status
+  midgard::flat_map<uint16_t, Status> dest_status_;       // Destination status
   std::vector<Label> labels_;                              // Label list.
 };
 
 using labelset_ptr_t = std::shared_ptr<LabelSet>;
 
+/**
+ * The shortest paths out of a single edge from (just past) its beginning, as far as a distance.
+ * The origin is the first label and every node the search settled has exactly one label.
+ */
+struct RouteTree {
+  baldr::GraphId edgeid;
+  // every node closer than this to the beginning of the edge has a label
+  float distance;
+  labelset_ptr_t labelset;
+  midgard::flat_map<baldr::GraphId, uint32_t> nodes;
+};
+
+using route_tree_ptr_t = std::shared_ptr<const RouteTree>;
+
 /**
  * Find the shortest paths between an origin and a set of destinations.
  * @param reader            a graph reader for tile access
  * @param destinations      a vector of locations, usually the origin is at index 0 an the rest are
- *                          destinations
+ *                          destinations. with only the origin the search settles everything within
+ *                          max_dist
  * @param origin_idx        the index of the origin location in the destinations vector
  * @param labelset          labelset to associate with this computation for later look up/path
  *                          recovery
@@ -304,6 +360,51 @@ find_shortest_path(baldr::GraphReader& reader,
                    const float max_dist,
                    const float max_time);
 
+/**
+ * Find the shortest paths out of an edge, from just past its beginning to as far as max_dist.
+ * @param reader           a graph reader for tile access
+ * @param edgeid           the edge the paths start on
+ * @param costing          used for checking access/restrictions
+ * @param turn_cost_table  array of turn costs based on turn angle
+ * @param max_dist         how far to allow the expansion to run
+ * @return the tree of paths
+ */
+route_tree_ptr_t build_route_tree(baldr::GraphReader& reader,
+                                  const baldr::GraphId& edgeid,
+                                  const sif::cost_ptr_t& costing,
+                                  const float turn_cost_table[181],
+                                  const float max_dist);
+
+/**
+ * Find the shortest paths between an origin and a set of destinations like find_shortest_path
+ * does, but out of the trees of the origin edges instead of searching the graph. The origin has to
+ * be along its edges and the trees have to reach as far as the search would go from it.
+ * @param reader           a graph reader for tile access
+ * @param destinations     a vector of locations, the origin is at index 0 and the rest are
+ *                         destinations
+ * @param labelset         an empty labelset to put the paths in for later look up/path recovery
+ * @param costing          used for checking access/restrictions
+ * @param edgelabel        the last label from the previous expansion that lead to this one
+ * @param turn_cost_table  array of turn costs based on turn angle
+ * @param max_dist         how far the search would be allowed to run
+ * @param max_time         how long the search would be allowed to run
+ * @param get_tree         gets the tree of an edge, nullptr if there is none
+ * @param results          filled with destination index to label index like find_shortest_path
+ * @return false if the trees cannot stand in for the search, in which case the graph must be
+ *         searched
+ */
+bool find_shortest_path_in_trees(
+    baldr::GraphReader& reader,
+    const std::vector<baldr::PathLocation>& destinations,
+    labelset_ptr_t labelset,
+    const sif::cost_ptr_t& costing,
+    const Label* edgelabel,
+    const float turn_cost_table[181],
+    const float max_dist,
+    const float max_time,
+    const std::function<route_tree_ptr_t(const baldr::GraphId&)>& get_tree,
+    std::unordered_map<uint16_t, uint32_t>& results);
+
 // Route path iterator. Methods to assist recovering route paths from Labels.
 class RoutePathIterator {
 public:
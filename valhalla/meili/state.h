@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <valhalla/baldr/pathlocation.h>
+#include <valhalla/midgard/flat_hash.h>
 #include <valhalla/meili/measurement.h>
 #include <valhalla/meili/routing.h>
 #include <valhalla/meili/stateid.h>
@@ -83,7 +84,7 @@ private:
 
   mutable std::shared_ptr<LabelSet> labelset_;
 
-  mutable std::unordered_map<StateId, uint32_t> label_idx_;
+  mutable midgard::flat_map<StateId, uint32_t> label_idx_;
 };
 
 class StateContainer {
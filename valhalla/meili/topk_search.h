@@ -1,6 +1,7 @@
 #ifndef MMP_TOPK_SEAECH_H_
 #define MMP_TOPK_SEAECH_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -163,6 +164,66 @@ private:
   std::unordered_set<StateId> removed_origins_;
 };
 
+/**
+ * Ranks the paths through the columns of states by their cost, best first. One viterbi pass over
+ * the columns finds the best path into every state. After that the next best path into a state
+ * comes from the next best path into the predecessor its last path went through or from the best
+ * path into one of its other predecessors, which is worked out on demand (the recursive
+ * enumeration algorithm of Jimenez and Marzal). So the kth path costs a walk back over the columns
+ * rather than another search over the whole trellis as with TopKSearch.
+ */
+class ListViterbiSearch {
+public:
+  /**
+   * Finds the best path into every state
+   * @param columns                the states at each time, a path takes one state from each
+   * @param emission_cost_model    the cost of a state, negative if the state can't be used
+   * @param transition_cost_model  the cost from a state to one in the next column, negative if
+   *                               there is no way between them
+   */
+  ListViterbiSearch(const std::vector<std::vector<StateId>>& columns,
+                    const IEmissionCostModel& emission_cost_model,
+                    const ITransitionCostModel& transition_cost_model);
+
+  /**
+   * Gets the next best path through all of the columns
+   * @param path  the states of the path in order of time
+   * @return the cost of the path, negative when there are no more paths
+   */
+  double Next(std::vector<StateId>& path);
+
+private:
+  // a path into a state, by the path into a state in the previous column it extends
+  struct path_t {
+    double cost;
+    uint32_t predecessor;
+    uint32_t rank;
+    float transition_cost;
+  };
+
+  struct node_t {
+    StateId stateid;
+    float emission_cost;
+    // the states in the previous column that have a way to this one, with its cost
+    std::vector<std::pair<uint32_t, float>> predecessors;
+    // the paths into this state found so far, best first
+    std::vector<path_t> paths;
+    // a heap of the paths which could be the next best
+    std::vector<path_t> candidates;
+    bool expanded;
+    bool exhausted;
+  };
+
+  bool HasPath(size_t time, uint32_t index, uint32_t rank);
+
+  void NextPath(size_t time, uint32_t index);
+
+  // the last column has a single node which ends every path
+  std::vector<std::vector<node_t>> columns_;
+
+  uint32_t next_rank_;
+};
+
 } // namespace meili
 } // namespace valhalla
 
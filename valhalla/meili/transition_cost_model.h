@@ -2,10 +2,14 @@
 #define MMP_TRANSITION_COST_MODEL_H_
 
 #include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/measurement.h>
+#include <valhalla/meili/route_cache.h>
 #include <valhalla/meili/state.h>
 #include <valhalla/meili/topk_search.h>
 #include <valhalla/meili/viterbi_search.h>
@@ -34,7 +38,9 @@ public:
                       const StateContainer& container,
                       const sif::mode_costing_t& mode_costing,
                       const sif::TravelMode travelmode,
-                      const Config::TransitionCost& config);
+                      const Config::TransitionCost& config,
+                      RouteCache* route_cache = nullptr,
+                      size_t costing_key = 0);
 
   // we use the difference between the original two measurements and the distance along the route
   // network to compute a transition cost of a given candidate, transition_time may be added if
@@ -51,6 +57,9 @@ public:
 
   float operator()(const StateId& lhs, const StateId& rhs) const;
 
+  // Forget the label sets and destinations of the previous trace
+  void Clear();
+
 private:
   void UpdateRoute(const StateId& lhs, const StateId& rhs) const;
 
@@ -93,6 +102,20 @@ private:
   float turn_cost_table_[181];
 
   bool match_on_restrictions_{false};
+
+  // The trees of the edges traces keep routing from, shared by the matchers of a factory, and
+  // what tells the trees of this costing apart
+  RouteCache* route_cache_{nullptr};
+  size_t costing_key_{0};
+
+  // The label set the states of a column route into, by the time of the column, along with the
+  // time of the column it routes to
+  mutable std::vector<std::pair<StateId::Time, labelset_ptr_t>> column_labelsets_;
+
+  // The destinations of the last routed column, the origin goes at the front
+  mutable StateId::Time destinations_time_{kInvalidTime};
+  mutable std::vector<baldr::PathLocation> locations_;
+  mutable std::vector<StateId> unreached_stateids_;
 };
 
 } // namespace meili
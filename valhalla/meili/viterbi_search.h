@@ -2,12 +2,13 @@
 #ifndef MMP_VITERBI_SEARCH_H_
 #define MMP_VITERBI_SEARCH_H_
 
+#include <functional>
+#include <limits>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
-#include <valhalla/meili/priority_queue.h>
 #include <valhalla/meili/stateid.h>
 
 namespace valhalla {
@@ -170,7 +171,56 @@ public:
   StateId Predecessor(const StateId& stateid) const override;
   double AccumulatedCost(const StateId& stateid) const override;
 
+  /**
+   * Find the latest state that all the paths the search can still extend pass through. The path
+   * up to this state can't change anymore no matter which states are added to later columns.
+   *
+   * @return the converged state or an invalid one if the paths haven't converged yet
+   */
+  StateId ConvergedStateId() const;
+
+  /**
+   * Prune the search like a beam search, for throughput over accuracy. Of the states of a column
+   * only the cheapest width ones which cost at most cost more than the winner of the column get
+   * their successors added, the others keep their cost but are dead ends. Neither of them changes
+   * the winners as long as the best path goes through such states. 0 disables either limit.
+   *
+   * @param width  how many states of a column to extend at most
+   * @param cost   how much more than the winner of its column a state may cost to be extended
+   */
+  void set_beam(size_t width, double cost) {
+    beam_width_ = width;
+    beam_cost_ = cost;
+  }
+
 private:
+  // The search state of a state ID. Slots are kept per column in the same order as
+  // states_by_time, so the labels of a search live in a few contiguous arrays which are reset
+  // and reused by the next search rather than allocated per scanned state
+  struct Slot {
+    double costsofar;    // the best cost so far, final once scanned
+    StateId predecessor; // the predecessor the best cost came from
+    bool queued;
+    bool scanned;
+  };
+
+  // An entry in the binary heap, it is stale once its state is scanned or reached more cheaply
+  struct QueueEntry {
+    double costsofar;
+    StateId stateid;
+    // Reversed so that std::push_heap and std::pop_heap keep the cheapest on top
+    bool operator<(const QueueEntry& rhs) const {
+      return costsofar > rhs.costsofar;
+    }
+  };
+
+  Slot* FindSlot(const StateId& stateid);
+  const Slot* FindSlot(const StateId& stateid) const;
+  // Whether the entry is the label its state is queued with
+  bool IsLive(const QueueEntry& entry) const;
+  // Queue a label unless its state is already queued or scanned with a lower or equal cost
+  void PushLabel(double costsofar, const StateId& stateid, const StateId& predecessor);
+  void ClearQueue();
   // Initialize labels from a column and push them into priority queue
   void InitQueue(const std::vector<StateId>& column);
   void AddSuccessorsToQueue(const StateId& stateid);
@@ -178,9 +228,14 @@ private:
   constexpr static bool IsInvalidCost(double cost);
 
   std::vector<std::vector<StateId>> unreached_states_by_time;
-  std::unordered_map<StateId, StateLabel> scanned_labels_;
-  SPQueue<StateLabel> queue_;
+  // May have more columns than states_by_time, those left over from earlier searches
+  std::vector<std::vector<Slot>> slots_by_time_;
+  std::vector<QueueEntry> queue_;
   StateId::Time earliest_time_{0};
+  // How many states of each column were scanned, for the beam width
+  std::vector<size_t> scanned_by_time_;
+  size_t beam_width_{0};
+  double beam_cost_{0};
 };
 } // namespace meili
 } // namespace valhalla
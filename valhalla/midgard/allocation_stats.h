@@ -0,0 +1,58 @@
+#ifndef VALHALLA_MIDGARD_ALLOCATION_STATS_H_
+#define VALHALLA_MIDGARD_ALLOCATION_STATS_H_
+
+#include <cstdint>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * What the calling thread allocated with operator new over some stretch of work. Only builds with
+ * ENABLE_ALLOCATION_STATS hook operator new, everything is 0 in other builds. The hook counts the
+ * usable size of each block per thread, so a block freed by another thread than the one which
+ * allocated it lowers the live bytes of the thread which freed it.
+ */
+class allocation_stats_t {
+public:
+  // whether operator new is hooked in this build
+#ifdef ENABLE_ALLOCATION_STATS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  /**
+   * Where the counters of a thread were when a measurement started
+   */
+  struct mark_t {
+    uint64_t allocations;
+    uint64_t bytes;
+    int64_t live;
+    int64_t peak;
+  };
+
+  // how many blocks and bytes were allocated and the most bytes live at once above the start
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t peak_bytes = 0;
+
+  /**
+   * Starts measuring on the calling thread. Measurements nest, the peak of an inner one is tracked
+   * on top of that of the outer ones.
+   * @return the mark to end the measurement with
+   */
+  static mark_t start();
+
+  /**
+   * Ends the measurement of the mark, which has to happen on the thread that started it and in
+   * the reverse order marks were started in.
+   * @param  mark  what start returned
+   * @return what the thread allocated since the mark
+   */
+  static allocation_stats_t since(const mark_t& mark);
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_ALLOCATION_STATS_H_
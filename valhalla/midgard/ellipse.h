@@ -74,6 +74,12 @@ public:
     return center_;
   }
 
+  /**
+   * Get the axis-aligned bounding box of the ellipse.
+   * @return Returns the smallest box containing the ellipse.
+   */
+  AABB2<coord_t> BoundingBox() const;
+
 private:
   coord_t center_;
   float a; // Half length of major axis
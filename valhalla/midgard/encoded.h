@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -22,6 +23,11 @@ constexpr size_t DIGITS_PRECISION = 6;
 namespace valhalla {
 namespace midgard {
 
+// the most characters a 32 bit number takes with 5 bits per character (polyline) and with
+// 7 bits per byte (varint). as long as that many are left a decoder can skip the end checks
+constexpr size_t kMaxPolylineChars = 7;
+constexpr size_t kMaxVarintBytes = 5;
+
 template <typename Point> class Shape7Decoder {
 public:
   Shape7Decoder(const char* begin, const size_t size, const double precision = DECODE_PRECISION)
@@ -45,16 +51,28 @@ private:
 
   int32_t next(const int32_t previous) noexcept(false) {
     int32_t byte, shift = 0, result = 0;
-    do {
-      if (empty()) {
+    if (static_cast<size_t>(end - begin) >= kMaxVarintBytes) {
+      // the number ends before the buffer does unless it is malformed
+      do {
+        byte = int32_t(*begin++);
+        result |= (byte & 0x7f) << shift;
+        shift += 7;
+      } while ((byte & 0x80) && shift < 7 * int32_t(kMaxVarintBytes));
+      if (byte & 0x80) {
         throw std::runtime_error("Bad encoded polyline");
       }
-      // take the least significant 7 bits shifted into place
-      byte = int32_t(*begin++);
-      result |= (byte & 0x7f) << shift;
-      shift += 7;
-      // if the most significant bit is set there is more to this number
-    } while (byte & 0x80);
+    } else {
+      do {
+        if (empty()) {
+          throw std::runtime_error("Bad encoded polyline");
+        }
+        // take the least significant 7 bits shifted into place
+        byte = int32_t(*begin++);
+        result |= (byte & 0x7f) << shift;
+        shift += 7;
+        // if the most significant bit is set there is more to this number
+      } while (byte & 0x80);
+    }
     // handle the bit flipping and add to previous since its an offset
     return previous + ((result & 1 ? ~result : result) >> 1);
   }
@@ -84,16 +102,28 @@ private:
   int32_t next(const int32_t previous) noexcept(false) {
     // grab each 5 bits and mask it in where it belongs using the shift
     int byte, shift = 0, result = 0;
-    do {
-      if (empty()) {
+    if (static_cast<size_t>(end - begin) >= kMaxPolylineChars) {
+      // the number ends before the buffer does unless it is malformed
+      do {
+        byte = int32_t(*begin++) - 63;
+        result |= (byte & 0x1f) << shift;
+        shift += 5;
+      } while (byte >= 0x20 && shift < 5 * int(kMaxPolylineChars));
+      if (byte >= 0x20) {
         throw std::runtime_error("Bad encoded polyline");
       }
-      // take the least significant 5 bits shifted into place
-      byte = int32_t(*begin++) - 63;
-      result |= (byte & 0x1f) << shift;
-      shift += 5;
-      // if the most significant bit is set there is more to this number
-    } while (byte >= 0x20);
+    } else {
+      do {
+        if (empty()) {
+          throw std::runtime_error("Bad encoded polyline");
+        }
+        // take the least significant 5 bits shifted into place
+        byte = int32_t(*begin++) - 63;
+        result |= (byte & 0x1f) << shift;
+        shift += 5;
+        // if the most significant bit is set there is more to this number
+      } while (byte >= 0x20);
+    }
     // handle the bit flipping and add to previous since its an offset
     return previous + (result & 1 ? ~(result >> 1) : (result >> 1));
   }
@@ -157,6 +187,88 @@ container_t decode7(const std::string& encoded, const double precision = DECODE_
   return decode7<container_t>(encoded.c_str(), encoded.length(), precision);
 }
 
+namespace detail {
+
+// same as std::round (halfway cases away from zero) for anything that fits in an int but without
+// the library call, the difference to the truncated value is exact
+inline int quantize(const double value) {
+  auto quantized = static_cast<int64_t>(value);
+  const double remainder = value - static_cast<double>(quantized);
+  quantized += (remainder >= 0.5) - (remainder <= -0.5);
+  return static_cast<int>(quantized);
+}
+
+// write 5 bit chunks of the number offset into printable characters
+inline char* write_polyline(const int number, char* output) {
+  // move the bits left 1 position and flip all the bits if it was a negative number
+  auto bits = number < 0 ? ~(static_cast<unsigned int>(number) << 1)
+                         : (static_cast<unsigned int>(number) << 1);
+  while (bits >= 0x20) {
+    *output++ = static_cast<char>((0x20 | (bits & 0x1f)) + 63);
+    bits >>= 5;
+  }
+  // write the last chunk
+  *output++ = static_cast<char>(bits + 63);
+  return output;
+}
+
+// write 7 bit chunks of the number, the most significant bit marks that more are coming
+inline char* write_varint(const int number, char* output) {
+  // get the sign bit down on the least significant end to
+  // make the most significant bits mostly zeros
+  auto bits = number < 0 ? ~(static_cast<unsigned int>(number) << 1)
+                         : (static_cast<unsigned int>(number) << 1);
+  while (bits > 0x7f) {
+    *output++ = static_cast<char>(0x80 | (bits & 0x7f));
+    bits >>= 7;
+  }
+  // write the last chunk
+  *output++ = static_cast<char>(bits);
+  return output;
+}
+
+// grows the output by the most a container of points can take, writes the deltas between the
+// points straight into it and trims it back down to what was written
+template <class container_t, size_t max_chars, char* (*write)(int, char*)>
+void encode(const container_t& points, std::string& output, const int precision) {
+  const size_t start = output.size();
+  output.resize(start + points.size() * 2 * max_chars);
+  char* out = &output[start];
+
+  // this is an offset encoding so we remember the last point we saw
+  int last_lon = 0, last_lat = 0;
+  // for each point
+  for (const auto& p : points) {
+    // shift the decimal point x places to the right and round
+    int lon = quantize(static_cast<double>(p.first) * precision);
+    int lat = quantize(static_cast<double>(p.second) * precision);
+    // encode each coordinate, lat first for some reason
+    out = write(lat - last_lat, out);
+    out = write(lon - last_lon, out);
+    // remember the last one we encountered
+    last_lon = lon;
+    last_lat = lat;
+  }
+  output.resize(out - output.data());
+}
+
+} // namespace detail
+
+/**
+ * Polyline encode a container of points and append it to a string, which can be reused across
+ * calls to avoid allocating
+ *
+ * @param points    the list of points to encode
+ * @param output    the string to append the encoded points to
+ * @param precision Precision of the encoded polyline. Defaults to 6 digit precision.
+ */
+template <class container_t>
+void encode(const container_t& points,
+            std::string& output,
+            const int precision = ENCODE_PRECISION) {
+  detail::encode<container_t, kMaxPolylineChars, detail::write_polyline>(points, output, precision);
+}
+
 /**
  * Polyline encode a container of points into a string suitable for web use
  * Note: newer versions of this algorithm allow one to specify a zoom level
@@ -168,44 +280,26 @@ container_t decode7(const std::string& encoded, const double precision = DECODE_
  */
 template <class container_t>
 std::string encode(const container_t& points, const int precision = ENCODE_PRECISION) {
-  // a place to keep the output
   std::string output;
-  // unless the shape is very course you should probably only need about 3 bytes
-  // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    // move the bits left 1 position and flip all the bits if it was a negative number
-    number = number < 0 ? ~(static_cast<unsigned int>(number) << 1) : (number << 1);
-    // write 5 bit chunks of the number
-    while (number >= 0x20) {
-      int nextValue = (0x20 | (number & 0x1f)) + 63;
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 5;
-    }
-    // write the last chunk
-    number += 63;
-    output.push_back(static_cast<char>(number));
-  };
-
-  // this is an offset encoding so we remember the last point we saw
-  int last_lon = 0, last_lat = 0;
-  // for each point
-  for (const auto& p : points) {
-    // shift the decimal point 5 places to the right and truncate
-    int lon = static_cast<int>(round(static_cast<double>(p.first) * precision));
-    int lat = static_cast<int>(round(static_cast<double>(p.second) * precision));
-    // encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
-    // remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
-  }
+  encode(points, output, precision);
   return output;
 }
 
+/**
+ * Varint encode a container of points and append it to a string, which can be reused across
+ * calls to avoid allocating
+ *
+ * @param points    the list of points to encode
+ * @param output    the string to append the encoded points to
+ * @param precision Precision of the encoding. Defaults to 6 digit precision.
+ */
+template <class container_t>
+void encode7(const container_t& points,
+             std::string& output,
+             const int precision = ENCODE_PRECISION) {
+  detail::encode<container_t, kMaxVarintBytes, detail::write_varint>(points, output, precision);
+}
+
 /**
  * Varint encode a container of points into a string
  *
@@ -214,42 +308,8 @@ std::string encode(const container_t& points, const int precision = ENCODE_PRECI
  */
 template <class container_t>
 std::string encode7(const container_t& points, const int precision = ENCODE_PRECISION) {
-  // a place to keep the output
   std::string output;
-  // unless the shape is very course you should probably only need about 3 bytes
-  // per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  // handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    // get the sign bit down on the least significant end to
-    // make the most significant bits mostly zeros
-    number = number < 0 ? ~(static_cast<unsigned int>(number) << 1) : number << 1;
-    // we take 7 bits of this at a time
-    while (number > 0x7f) {
-      // marking the most significant bit means there are more pieces to come
-      int nextValue = (0x80 | (number & 0x7f));
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 7;
-    }
-    // write the last chunk
-    output.push_back(static_cast<char>(number & 0x7f));
-  };
-
-  // this is an offset encoding so we remember the last point we saw
-  int last_lon = 0, last_lat = 0;
-  // for each point
-  for (const auto& p : points) {
-    // shift the decimal point x places to the right and truncate
-    int lon = static_cast<int>(round(static_cast<double>(p.first) * precision));
-    int lat = static_cast<int>(round(static_cast<double>(p.second) * precision));
-    // encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
-    // remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
-  }
+  encode7(points, output, precision);
   return output;
 }
 
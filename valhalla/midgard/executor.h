@@ -0,0 +1,84 @@
+#ifndef VALHALLA_MIDGARD_EXECUTOR_H_
+#define VALHALLA_MIDGARD_EXECUTOR_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * A pool of threads that lends itself to the parts of a request which can be split across threads,
+ * the rows of a matrix, the starts of the tour optimizer or the legs of an optimized route. Each of
+ * those hands out its work through a shared counter to a number of slots, each slot with state of
+ * its own (a graph reader, a path algorithm). The calling thread always takes the first slot and
+ * idle threads of the pool take the others.
+ *
+ * Spawning threads per request oversubscribes the cores when many requests split their work at
+ * once. A pool shared by every worker of the process instead bounds the helper threads by the
+ * cores: when the service is idle a request spreads out and when it is busy each request runs on
+ * its own thread, whatever the mix of requests is.
+ */
+class executor_t {
+public:
+  /**
+   * @param threads  number of threads in the pool, with 0 all work runs on the calling thread
+   */
+  explicit executor_t(uint32_t threads);
+  ~executor_t();
+
+  executor_t(const executor_t&) = delete;
+  executor_t& operator=(const executor_t&) = delete;
+
+  /**
+   * @return the pool shared by the whole process, it has a thread per core
+   */
+  static executor_t& shared();
+
+  /**
+   * Runs the work of slot 0 on the calling thread and that of slots 1 to slots - 1 on idle threads
+   * of the pool, then waits for the slots which started to return. The work must take its tasks
+   * from something shared so that the calling thread alone finishes all of them when no thread of
+   * the pool is free, slots which did not start by then are dropped. The first exception thrown by
+   * any slot is rethrown, the work should make the other slots run out of tasks when one throws.
+   * @param slots  the number of slots, each slot runs at most once
+   * @param work   runs the tasks of the slot it is called with
+   */
+  void run(uint32_t slots, const std::function<void(uint32_t)>& work);
+
+  uint32_t threads() const {
+    return static_cast<uint32_t>(threads_.size());
+  }
+
+protected:
+  struct batch_t {
+    const std::function<void(uint32_t)>* work;
+    uint32_t running;
+    std::exception_ptr error;
+    std::condition_variable done;
+  };
+
+  struct job_t {
+    batch_t* batch;
+    uint32_t slot;
+  };
+
+  void loop();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<job_t> jobs_;
+  bool stopping_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_EXECUTOR_H_
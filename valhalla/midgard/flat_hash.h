@@ -0,0 +1,33 @@
+#ifndef VALHALLA_MIDGARD_FLAT_HASH_H_
+#define VALHALLA_MIDGARD_FLAT_HASH_H_
+
+#include <robin_hood.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * The hash of the flat containers. It is robin_hood's, which mixes whatever std::hash gives, unless
+ * a key type specializes it with a hash that is mixed well enough to be used as is (see GraphId).
+ */
+template <typename Key> struct flat_hash : public robin_hood::hash<Key> {};
+
+/**
+ * Open addressing hash map keeping its entries in one array, for the maps of the hot paths (edge
+ * status, shared edges, bins and the like). Compared to std::unordered_map there is no allocation
+ * per entry and a lookup mostly touches a single cache line, but inserting can move the entries so
+ * references and iterators into the map do not survive an insertion.
+ */
+template <typename Key, typename T, typename Hash = flat_hash<Key>>
+using flat_map = robin_hood::unordered_flat_map<Key, T, Hash>;
+
+/**
+ * Open addressing hash set keeping its entries in one array, with the same caveats as flat_map.
+ */
+template <typename Key, typename Hash = flat_hash<Key>>
+using flat_set = robin_hood::unordered_flat_set<Key, Hash>;
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_FLAT_HASH_H_
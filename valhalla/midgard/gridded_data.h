@@ -3,10 +3,12 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <functional>
 #include <limits>
-#include <list>
-#include <map>
+#include <memory>
+#include <unordered_map>
+#include <valhalla/midgard/executor.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/polyline2.h>
 #include <valhalla/midgard/tiles.h>
@@ -40,8 +42,42 @@ public:
    * @param   value     Value to initialize data with.
    */
   GriddedData(const AABB2<PointLL>& bounds, const float tilesize, const value_type& value)
-      : Tiles<PointLL>(bounds, tilesize), max_value_(value),
-        data_(this->nrows_ * this->ncolumns_, value) {
+      : Tiles<PointLL>(bounds, tilesize), used_blocks_(0) {
+    Reset(bounds, tilesize, value);
+  }
+
+  /**
+   * Starts over with a new grid which reads as the given value everywhere. The blocks of the old
+   * grid are kept to be reused by the new one so that a grid which is reset for every request does
+   * not allocate once it has grown to the size the requests need.
+   * @param   bounds    Bounding box
+   * @param   tilesize  Tile size
+   * @param   value     Value to initialize data with.
+   */
+  void Reset(const AABB2<PointLL>& bounds, const float tilesize, const value_type& value) {
+    Tiles<PointLL>::operator=(Tiles<PointLL>(bounds, tilesize));
+    max_value_ = value;
+    block_columns_ = (this->ncolumns_ + kBlockSize - 1) >> kBlockBits;
+    block_index_.assign(block_columns_ * ((this->nrows_ + kBlockSize - 1) >> kBlockBits), kNoBlock);
+    used_blocks_ = 0;
+  }
+
+  /**
+   * Clears the grid so it reads as its initial value everywhere and frees the blocks which are
+   * not needed to keep the given number around for the next grid.
+   * @param  reserved  the number of blocks to keep allocated
+   */
+  void ReleaseBlocks(const size_t reserved) {
+    std::fill(block_index_.begin(), block_index_.end(), kNoBlock);
+    used_blocks_ = 0;
+    blocks_.resize(std::min(blocks_.size(), reserved));
+  }
+
+  /**
+   * @return the number of blocks of cells allocated, those in use and those kept for reuse
+   */
+  size_t BlockCount() const {
+    return blocks_.size();
   }
 
   /**
@@ -49,21 +85,44 @@ public:
    * value set at the grid location. Verifies that the tile is valid.
    * @param  tile_id  Tile Id to set value for.
    * @param  value    Value to set at the tile/grid location.
-   * @param  get_data Functor to get the desired data value
-   * @param  set_data Functor to set the desired data value
    */
   inline void SetIfLessThan(const int tile_id, const value_type& value) {
-    if (tile_id >= 0 && tile_id < data_.size()) {
-      auto& current_value = data_[tile_id];
+    if (tile_id >= 0 && tile_id < this->nrows_ * this->ncolumns_) {
+      auto row = tile_id / this->ncolumns_;
+      auto col = tile_id - row * this->ncolumns_;
+      auto& current_value = Cell(col, row);
       for (size_t i = 0; i < dimensions_t; ++i) {
         current_value[i] = std::min(value[i], current_value[i]);
       }
     }
   }
 
-  using contour_t = std::list<PointLL>;
-  using feature_t = std::list<contour_t>;
-  using contours_t = std::vector<std::list<feature_t>>;
+  /**
+   * Set the value at a specified tile Id whatever the current value is. Verifies that the tile is
+   * valid.
+   * @param  tile_id  Tile Id to set value for.
+   * @param  value    Value to set at the tile/grid location.
+   */
+  inline void Set(const int tile_id, const value_type& value) {
+    if (tile_id >= 0 && tile_id < this->nrows_ * this->ncolumns_) {
+      auto row = tile_id / this->ncolumns_;
+      Cell(tile_id - row * this->ncolumns_, row) = value;
+    }
+  }
+
+  /**
+   * Get the value at a specified tile Id, tiles no value was set in have the initial value.
+   * @param  tile_id  Tile Id to get the value of, it must be valid.
+   * @return the value at the tile/grid location
+   */
+  const value_type& Value(const int tile_id) const {
+    auto row = tile_id / this->ncolumns_;
+    return Value(tile_id - row * this->ncolumns_, row);
+  }
+
+  using contour_t = std::vector<PointLL>;
+  using feature_t = std::vector<contour_t>;
+  using contours_t = std::vector<std::vector<feature_t>>;
   // dimension, value (seconds/meters), name (time/distance), color
   using contour_interval_t = std::tuple<size_t, float, std::string, std::string>;
   /**
@@ -73,6 +132,7 @@ public:
    * Generate contour lines from the gridded data.
    * contours is an ordered list of contour interval values
    * Derivation from the C code version of CONREC by Paul Bourke: http://paulbourke.net/papers/conrec/
+   * Each interval is traced, joined and cleaned up on its own so the intervals run in parallel.
    *
    * @param contour_intervals    the values at which the contour lines should occur
    *                             basically the lines on the measuring stick.
@@ -93,27 +153,139 @@ public:
     // sort the contours first on the metric index then on the values with the bigger contours first
     std::sort(intervals.begin(), intervals.end(), std::greater<>());
 
-    // Values at tile corners and center (0 element is center)
-    int sh[5];
-    typename PointLL::first_type s[5]; // Values at the tile corners and center
-    PointLL tile_corners[5];           // PointLL at tile corners and center
-    int m1, m2, m3;                    // Indices into the tile corners
-    PointLL from_pt, to_pt;            // The intersection points in the tile
-    int tile_inc[4] = {0, 1, this->ncolumns_ + 1, this->ncolumns_};
+    // If the generalization value equals kOptimalGeneralization then set
+    // the generalization factor to 1/4 of the grid size
+    float gen_factor = generalize;
+    if (generalize == kOptimalGeneralization) {
+      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
+    }
 
-    // Find the intersection along a tile edge
-    auto intersect = [&tile_corners, &s](int p1, int p2) {
-      auto ds = s[p2] - s[p1];
-      return PointLL((s[p2] * tile_corners[p1].first - s[p1] * tile_corners[p2].first) / ds,
-                     (s[p2] * tile_corners[p1].second - s[p1] * tile_corners[p2].second) / ds);
+    // sampling the bottom left corner means everything is skewed
+    auto h = this->tilesize_ / 2;
+
+    // we need something to hold each iso-line
+    contours_t contours(intervals.size());
+    std::atomic<size_t> next_interval(0);
+    auto work = [&](uint32_t) {
+      std::vector<segment_t> segments;
+      for (size_t i; (i = next_interval++) < intervals.size();) {
+        segments.clear();
+        Trace(std::get<0>(intervals[i]), std::get<1>(intervals[i]), segments);
+        auto lines = Join(segments);
+
+        // they only wanted rings
+        if (rings_only) {
+          lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                     [](const contour_t& line) {
+                                       return line.front() != line.back();
+                                     }),
+                      lines.end());
+        }
+        // sort them by area (maybe length would be sufficient?) biggest first
+        std::vector<std::pair<typename PointLL::first_type, contour_t>> sorted;
+        sorted.reserve(lines.size());
+        for (auto& line : lines) {
+          auto area = polygon_area(line);
+          sorted.emplace_back(area, std::move(line));
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+          return std::abs(a.first) > std::abs(b.first);
+        });
+
+        // they only want the most significant ones!
+        lines.clear();
+        for (auto& line : sorted) {
+          if (denoise > 0.f && std::abs(line.first / sorted.front().first) < denoise) {
+            continue;
+          }
+          // clean up the lines
+          if (gen_factor > 0.f) {
+            Polyline2<PointLL>::Generalize(line.second, gen_factor, {},
+                                           /* avoid_self_intersections */ true);
+          }
+          // remove points and lines
+          if (line.second.size() < 4) {
+            continue;
+          }
+          // unskew the coordinates
+          for (auto& coord : line.second) {
+            coord.first += h;
+            coord.second += h;
+          }
+          lines.push_back(std::move(line.second));
+        }
+
+        // if they just wanted linestrings we need only one per feature
+        auto& collection = contours[i];
+        if (rings_only) {
+          collection.emplace_back(std::move(lines));
+        } else {
+          for (auto& linestring : lines) {
+            collection.emplace_back(feature_t{std::move(linestring)});
+          }
+        }
+      }
     };
+    executor_t::shared().run(static_cast<uint32_t>(intervals.size()), work);
 
+    return contours;
+  }
+
+protected:
+  // The cells are stored in square blocks which are only allocated once a value is set in one of
+  // their cells, an expansion only touches the part of the grid around its roads
+  static constexpr int32_t kBlockBits = 5;
+  static constexpr int32_t kBlockSize = 1 << kBlockBits;
+  static constexpr uint32_t kNoBlock = std::numeric_limits<uint32_t>::max();
+  using block_t = std::unique_ptr<value_type[]>;
+
+  value_type max_value_;              // Maximum value stored in the tile
+  int32_t block_columns_;             // Number of blocks across the grid
+  std::vector<uint32_t> block_index_; // Index of the block of each part of the grid or kNoBlock
+  std::vector<block_t> blocks_;       // The blocks in use first then the ones kept for reuse
+  size_t used_blocks_;                // Number of blocks in use
+
+  // The value of a cell, the initial value if its block was never written
+  const value_type& Value(const int32_t col, const int32_t row) const {
+    auto index = block_index_[(row >> kBlockBits) * block_columns_ + (col >> kBlockBits)];
+    if (index == kNoBlock) {
+      return max_value_;
+    }
+    return blocks_[index][((row & (kBlockSize - 1)) << kBlockBits) + (col & (kBlockSize - 1))];
+  }
+
+  // The cell to write a value to, allocates or reuses a block for it if needed
+  value_type& Cell(const int32_t col, const int32_t row) {
+    auto& index = block_index_[(row >> kBlockBits) * block_columns_ + (col >> kBlockBits)];
+    if (index == kNoBlock) {
+      if (used_blocks_ == blocks_.size()) {
+        blocks_.emplace_back(new value_type[kBlockSize * kBlockSize]);
+      }
+      std::fill_n(blocks_[used_blocks_].get(), kBlockSize * kBlockSize, max_value_);
+      index = static_cast<uint32_t>(used_blocks_++);
+    }
+    return blocks_[index][((row & (kBlockSize - 1)) << kBlockBits) + (col & (kBlockSize - 1))];
+  }
+
+  // one piece of a contour line, oriented so that the lower values are on its left
+  using segment_t = std::pair<PointLL, PointLL>;
+
+  /**
+   * Traces one contour value through the cells of the grid with the triangles of CONREC and appends
+   * the segments it crosses them with, in the order of the cells. Each cell is looked at on its own
+   * so this only reads the grid and the work of different contour values can run at the same time.
+   *
+   * @param metric_index   which of the dimensions the contour is for
+   * @param contour_value  the value of the contour
+   * @param segments       the segments of the contour are appended to this
+   */
+  void Trace(const size_t metric_index,
+             const float contour_value,
+             std::vector<segment_t>& segments) const {
     // In the tight loop below, we need to decide where a contour intersects the triangles that make
     // up the given tile. this works out to a number of discrete cases which we lookup using the table
-    // below. based on the case we perform the appropriate intersection. to avoid branching we store
-    // the intersection operation for each case in an array and perform the correct one by calling the
-    // function stored in the array
-    int case_table[3][3][3] = {
+    // below. based on the case we perform the appropriate intersection
+    static constexpr int case_table[3][3][3] = {
         {{0, 0, 8}, {0, 2, 5}, {7, 6, 9}},
         {{0, 3, 4}, {1, 0, 1}, {4, 3, 0}},
         {{9, 6, 7}, {5, 2, 0}, {8, 0, 0}},
@@ -135,283 +307,206 @@ public:
     // "A linear ring MUST follow the right-hand rule with respect to the area it
     // bounds, i.e., exterior rings are counterclockwise, and holes are clockwise."  (c)
     // (c) https://tools.ietf.org/html/rfc7946#section-3.1.6
-    bool swap_table[3][3][3] = {
+    static constexpr bool swap_table[3][3][3] = {
         {{false, false, true}, {false, true, true}, {true, false, false}},
         {{false, true, false}, {true, false, false}, {true, false, false}},
         {{true, true, false}, {false, false, false}, {false, false, false}},
     };
-    std::array<std::function<void()>, 10> cases{
-        [&]() {},
-        // Line between vertices 1 and 2
-        [&]() {
-          from_pt = tile_corners[m1];
-          to_pt = tile_corners[m2];
-        },
-        // Line between vertices 2 and 3
-        [&]() {
-          from_pt = tile_corners[m2];
-          to_pt = tile_corners[m3];
-        },
-        // Line between vertices 3 and 1
-        [&]() {
-          from_pt = tile_corners[m3];
-          to_pt = tile_corners[m1];
-        },
-        // Line between vertex 1 and side 2-3
-        [&]() {
-          from_pt = tile_corners[m1];
-          to_pt = intersect(m2, m3);
-        },
-        // Line between vertex 2 and side 3-1
-        [&]() {
-          from_pt = tile_corners[m2];
-          to_pt = intersect(m3, m1);
-        },
-        // Line between vertex 3 and side 1-2
-        [&]() {
-          from_pt = tile_corners[m3];
-          to_pt = intersect(m1, m2);
-        },
-        // Line between sides 1-2 and 2-3
-        [&]() {
-          from_pt = intersect(m1, m2);
-          to_pt = intersect(m2, m3);
-        },
-        // Line between sides 2-3 and 3-1
-        [&]() {
-          from_pt = intersect(m2, m3);
-          to_pt = intersect(m3, m1);
-        },
-        // Line between sides 3-1 and 1-2
-        [&]() {
-          from_pt = intersect(m3, m1);
-          to_pt = intersect(m1, m2);
-        },
+
+    // Values at tile corners and center (0 element is center)
+    int sh[5];
+    typename PointLL::first_type s[5]; // Values at the tile corners and center
+    PointLL tile_corners[5];           // PointLL at tile corners and center
+    PointLL from_pt, to_pt;            // The intersection points in the tile
+    const int tile_inc[4] = {0, 1, this->ncolumns_ + 1, this->ncolumns_};
+    const int tile_col[4] = {0, 1, 1, 0};
+    const int tile_row[4] = {0, 0, 1, 1};
+
+    // Find the intersection along a tile edge
+    auto intersect = [&tile_corners, &s](int p1, int p2) {
+      auto ds = s[p2] - s[p1];
+      return PointLL((s[p2] * tile_corners[p1].first - s[p1] * tile_corners[p2].first) / ds,
+                     (s[p2] * tile_corners[p1].second - s[p1] * tile_corners[p2].second) / ds);
     };
 
-    // which metrics do we need contours for
-    auto _ = std::make_pair(intervals.cbegin(), intervals.cend());
-    std::vector<decltype(_)> metrics{std::move(_)};
-    for (auto interval = intervals.cbegin(); interval != intervals.cend(); ++interval) {
-      if (std::get<0>(*interval) != std::get<0>(*metrics.back().first)) {
-        metrics.back().second = interval;
-        metrics.emplace_back(interval, intervals.cend());
-      }
-    }
+    // For each cell, skipping the outer rim since its out of bounds
+    for (int row = 1; row < this->nrows_ - 1; ++row) {
+      for (int col = 1; col < this->ncolumns_ - 1; ++col) {
+        int tileid = this->TileId(col, row);
+        auto cell1 = Value(col, row)[metric_index];
+        auto cell2 = Value(col, row + 1)[metric_index];
+        auto cell3 = Value(col + 1, row)[metric_index];
+        auto cell4 = Value(col + 1, row + 1)[metric_index];
+        auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
+        auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
+
+        // we skip this cell if the contour value would not intersect it
+        if (contour_value < dmin || contour_value > dmax) {
+          continue;
+        }
 
-    // we need something to hold each iso-line
-    contours_t contours(intervals.size(), std::list<feature_t>{feature_t{}});
-
-    // and something to find them quickly
-    using contour_lookup_t = std::map<PointLL, typename feature_t::iterator>;
-    // store begins and ends of the segments separately not to loose segment orientation
-    std::vector<contour_lookup_t> begin_lookups(intervals.size());
-    std::vector<contour_lookup_t> end_lookups(intervals.size());
-    // TODO: preallocate the lookups for each interval
-
-    // For each metric we tracked
-    for (const auto& metric : metrics) {
-      size_t metric_index = std::get<0>(*metric.first);
-
-      // For each cell, skipping the outer rim since its out of bounds
-      for (int row = 1; row < this->nrows_ - 1; ++row) {
-        for (int col = 1; col < this->ncolumns_ - 1; ++col) {
-          int tileid = this->TileId(col, row);
-          auto cell1 = data_[tileid][metric_index];
-          auto cell2 = data_[tileid + this->ncolumns_][metric_index];     // TileId(col,   row+1)];
-          auto cell3 = data_[tileid + 1][metric_index];                   // TileId(col+1, row)];
-          auto cell4 = data_[tileid + this->ncolumns_ + 1][metric_index]; // TileId(col+1, row+1)];
-          auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
-          auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
-
-          // Continue if outside the range of contour values for this metric_index
-          if (dmax < std::get<1>(*std::prev(metric.second)) || dmin > std::get<1>(*metric.first)) {
-            continue;
+        for (int m = 4; m > 0; m--) {
+          int newtileid = tileid + tile_inc[m - 1];
+          // Make sure the tile corner value is not set to the max_value
+          // (messes up the intersect method). Set a value slightly above
+          // the contour (e.g. 1 minute higher).
+          // TODO - the value 1 is a bit of a hack.
+          float nd = Value(col + tile_col[m - 1], row + tile_row[m - 1])[metric_index];
+          s[m] = nd < max_value_[metric_index] ? nd - contour_value : 1.0f;
+          tile_corners[m] = this->Base(newtileid);
+          sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
+        }
+        s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+        tile_corners[0] = this->Center(tileid);
+        sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
+
+        /*
+         Note: at this stage the relative heights of the corners and the
+         centre are in the h array, and the corresponding coordinates are
+         in the xh and yh arrays. The centre of the box is indexed by 0
+         and the 4 corners by 1 to 4 as shown below.
+         Each triangle is then indexed by the parameter m, and the 3
+         vertices of each triangle are indexed by parameters m1,m2,and m3.
+         It is assumed that the centre of the box is always vertex 2
+         though this is important only when all 3 vertices lie exactly on
+         the same contour level, in which case only the side of the box
+         is drawn.
+            vertex 4 +-------------------+ vertex 3
+                     | \               / |
+                     |   \    m-3    /   |
+                     |     \       /     |
+                     |       \   /       |
+                     |  m=2    X   m=2   |       the centre is vertex 0
+                     |       /   \       |
+                     |     /       \     |
+                     |   /    m=1    \   |
+                     | /               \ |
+            vertex 1 +-------------------+ vertex 2
+        */
+
+        // Scan each triangle in the box
+        for (int m = 1; m <= 4; m++) {
+          // figure out which intersection we need to do
+          int m1 = m;
+          int m2 = 0;
+          int m3 = (m != 4) ? m + 1 : 1;
+          int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+          bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+
+          // do the intersection
+          switch (case_index) {
+            // there is no intersection of this triangle
+            case 0:
+              continue;
+            // Line between vertices 1 and 2
+            case 1:
+              from_pt = tile_corners[m1];
+              to_pt = tile_corners[m2];
+              break;
+            // Line between vertices 2 and 3
+            case 2:
+              from_pt = tile_corners[m2];
+              to_pt = tile_corners[m3];
+              break;
+            // Line between vertices 3 and 1
+            case 3:
+              from_pt = tile_corners[m3];
+              to_pt = tile_corners[m1];
+              break;
+            // Line between vertex 1 and side 2-3
+            case 4:
+              from_pt = tile_corners[m1];
+              to_pt = intersect(m2, m3);
+              break;
+            // Line between vertex 2 and side 3-1
+            case 5:
+              from_pt = tile_corners[m2];
+              to_pt = intersect(m3, m1);
+              break;
+            // Line between vertex 3 and side 1-2
+            case 6:
+              from_pt = tile_corners[m3];
+              to_pt = intersect(m1, m2);
+              break;
+            // Line between sides 1-2 and 2-3
+            case 7:
+              from_pt = intersect(m1, m2);
+              to_pt = intersect(m2, m3);
+              break;
+            // Line between sides 2-3 and 3-1
+            case 8:
+              from_pt = intersect(m2, m3);
+              to_pt = intersect(m3, m1);
+              break;
+            // Line between sides 3-1 and 1-2
+            default:
+              from_pt = intersect(m3, m1);
+              to_pt = intersect(m1, m2);
+              break;
           }
 
-          // For each requested contour value
-          for (size_t i = 0; i < intervals.size(); ++i) {
-            // some setup to process this contour
-            auto& begin_lookup = begin_lookups[i];
-            auto& end_lookup = end_lookups[i];
-            auto& contour = contours[i];
-            auto contour_value = std::get<1>(intervals[i]);
-
-            // we skip this contour if its interested in a different metric_index or its value
-            // would not intersect this cell
-            if (std::get<0>(intervals[i]) != metric_index || contour_value < dmin ||
-                contour_value > dmax) {
-              continue;
-            }
-
-            for (int m = 4; m > 0; m--) {
-              int newtileid = tileid + tile_inc[m - 1];
-              // Make sure the tile corner value is not set to the max_value
-              // (messes up the intersect method). Set a value slightly above
-              // the contour (e.g. 1 minute higher).
-              // TODO - the value 1 is a bit of a hack.
-              float nd = data_[newtileid][metric_index];
-              s[m] = nd < max_value_[metric_index] ? nd - contour_value : 1.0f;
-              tile_corners[m] = this->Base(newtileid);
-              sh[m] = (s[m] > 0.0f) - (s[m] < 0.0f); // pos = 1, neg = -1, 0 = 0
-            }
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-            sh[0] = (s[0] > 0.0f) - (s[0] < 0.0f); // pos = 1, neg = -1, 0 = 0
-
-            /*
-             Note: at this stage the relative heights of the corners and the
-             centre are in the h array, and the corresponding coordinates are
-             in the xh and yh arrays. The centre of the box is indexed by 0
-             and the 4 corners by 1 to 4 as shown below.
-             Each triangle is then indexed by the parameter m, and the 3
-             vertices of each triangle are indexed by parameters m1,m2,and m3.
-             It is assumed that the centre of the box is always vertex 2
-             though this is important only when all 3 vertices lie exactly on
-             the same contour level, in which case only the side of the box
-             is drawn.
-                vertex 4 +-------------------+ vertex 3
-                         | \               / |
-                         |   \    m-3    /   |
-                         |     \       /     |
-                         |       \   /       |
-                         |  m=2    X   m=2   |       the centre is vertex 0
-                         |       /   \       |
-                         |     /       \     |
-                         |   /    m=1    \   |
-                         | /               \ |
-                vertex 1 +-------------------+ vertex 2
-            */
-
-            // Scan each triangle in the box
-            for (int m = 1; m <= 4; m++) {
-              // figure out which intersection we need to do
-              m1 = m;
-              m2 = 0;
-              m3 = (m != 4) ? m + 1 : 1;
-              int case_index = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-              bool swap_points = swap_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
-
-              // there is no intersection of this triangle
-              if (case_index == 0) {
-                continue;
-              }
-
-              // do the intersection, assigns to pt1 and pt2 inside lambdas defined above
-              cases[case_index]();
-
-              // this isnt a segment..
-              if (from_pt == to_pt) {
-                continue;
-              }
-              if (swap_points) {
-                std::swap(from_pt, to_pt);
-              }
-
-              // see if we have anything to connect this segment to
-              typename contour_lookup_t::iterator end_lookup_it = end_lookup.find(from_pt);
-              typename contour_lookup_t::iterator begin_lookup_it = begin_lookup.find(to_pt);
-
-              if (end_lookup_it != end_lookup.end() && begin_lookup_it != begin_lookup.end()) {
-                // we want to merge two records
-                //   first_segment                               second_segment
-                // (... ------> from_pt) + (from_pt, to_pt) + (to_pt ------> ...)
-                auto first_segment = end_lookup_it->second;
-                auto second_segment = begin_lookup_it->second;
-                end_lookup.erase(end_lookup_it);
-                begin_lookup.erase(begin_lookup_it);
-
-                // this segment is now a ring
-                if (first_segment == second_segment) {
-                  first_segment->push_back(first_segment->front());
-                  continue;
-                }
-
-                end_lookup[second_segment->back()] = first_segment;
-                first_segment->splice(first_segment->end(), *second_segment);
-                contour.front().erase(second_segment);
-              } else if (end_lookup_it != end_lookup.end()) {
-                // (... ------> from_pt) + (from_pt, to_pt)
-                end_lookup_it->second->push_back(to_pt);
-                end_lookup.emplace(to_pt, end_lookup_it->second);
-                end_lookup.erase(end_lookup_it);
-              } else if (begin_lookup_it != begin_lookup.end()) {
-                // (from_pt, to_pt) + (to_pt ------> ...)
-                begin_lookup_it->second->push_front(from_pt);
-                begin_lookup.emplace(from_pt, begin_lookup_it->second);
-                begin_lookup.erase(begin_lookup_it);
-              } else {
-                // this is an orphan segment for now
-                contour.front().push_front(contour_t{from_pt, to_pt});
-                begin_lookup.emplace(from_pt, contour.front().begin());
-                end_lookup.emplace(to_pt, contour.front().begin());
-              }
-            }
-          } // Each contour
-        }   // Each tile col
-      }     // Each tile row
-    }       // Each dimension of the grid
+          // this isnt a segment..
+          if (from_pt == to_pt) {
+            continue;
+          }
+          if (swap_points) {
+            std::swap(from_pt, to_pt);
+          }
+          segments.emplace_back(from_pt, to_pt);
+        }
+      } // Each tile col
+    }   // Each tile row
+  }
 
-    // If the generalization value equals kOptimalGeneralization then set
-    // the generalization factor to 1/4 of the grid size
-    float gen_factor = generalize;
-    if (generalize == kOptimalGeneralization) {
-      gen_factor = this->tilesize_ * 0.25f * kMetersPerDegreeLat;
+  /**
+   * Joins the segments of a contour into lines. The segments are hashed by the point they start at
+   * so that each line is followed from one segment to the next in a single pass over them. Open
+   * lines begin where no segment ends. A ring begins and ends where its segment traced last ends,
+   * that is where merging the segments one by one as they are traced would have closed it.
+   *
+   * @param segments  the segments of the contour in the order they were traced
+   * @return the lines, rings have the same point at the front and the back
+   */
+  static std::vector<contour_t> Join(const std::vector<segment_t>& segments) {
+    // segments are found by the points they start at and whether a point is the end of another
+    constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    std::unordered_map<PointLL, uint32_t> starts(segments.size());
+    std::unordered_map<PointLL, uint32_t> ends(segments.size());
+    for (uint32_t i = 0; i < segments.size(); ++i) {
+      starts.emplace(segments[i].first, i);
+      ends.emplace(segments[i].second, i);
     }
+    auto next = [&starts, kNone](const PointLL& point) {
+      auto found = starts.find(point);
+      return found == starts.cend() ? kNone : found->second;
+    };
 
-    // some info about the area the image covers
-    auto c = this->TileBounds().Center();
-    auto h = this->tilesize_ / 2;
-    // for each contour
-    for (auto& collection : contours) {
-      auto& contour = collection.front();
-      // they only wanted rings
-      if (rings_only) {
-        contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+    std::vector<contour_t> lines;
+    std::vector<bool> used(segments.size(), false);
+    // lines which are not rings have a segment no other segment leads to
+    for (uint32_t i = 0; i < segments.size(); ++i) {
+      if (used[i] || ends.count(segments[i].first)) {
+        continue;
       }
-      // sort them by area (maybe length would be sufficient?) biggest first
-      std::unordered_map<const contour_t*, typename PointLL::first_type> cache(contour.size());
-      std::for_each(contour.cbegin(), contour.cend(),
-                    [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
-      contour.sort([&cache](const contour_t& a, const contour_t& b) {
-        return std::abs(cache[&a]) > std::abs(cache[&b]);
-      });
-
-      // they only want the most significant ones!
-      if (denoise > 0.f) {
-        contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
-          return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
-        });
+      lines.emplace_back(contour_t{segments[i].first});
+      for (auto j = i; j != kNone && !used[j]; j = next(segments[j].second)) {
+        used[j] = true;
+        lines.back().push_back(segments[j].second);
       }
-      // clean up the lines
-      for (auto& line : contour) {
-        if (gen_factor > 0.f) {
-          Polyline2<PointLL>::Generalize(line, gen_factor, {}, /* avoid_self_intersections */ true);
-        }
-        // sampling the bottom left corner means everything is skewed, so unskew it
-        for (auto& coord : line) {
-          coord.first += h;
-          coord.second += h;
-        }
+    }
+    // what is left are rings, the last segment of each is the first one we meet going backwards
+    for (uint32_t i = segments.size(); i-- > 0;) {
+      if (used[i]) {
+        continue;
       }
-      // remove points and lines
-      contour.remove_if([](const contour_t& line) { return line.size() < 4; });
-
-      // if they just wanted linestrings we need only one per feature
-      if (!rings_only) {
-        for (auto& linestring : contour) {
-          collection.push_back({std::move(linestring)});
-        }
-        collection.pop_front();
+      lines.emplace_back(contour_t{segments[i].second});
+      for (auto j = next(segments[i].second); j != kNone && !used[j]; j = next(segments[j].second)) {
+        used[j] = true;
+        lines.back().push_back(segments[j].second);
       }
     }
-
-    return contours;
+    return lines;
   }
-
-protected:
-  value_type max_value_;         // Maximum value stored in the tile
-  std::vector<value_type> data_; // Data value within each tile
 };
 
 } // namespace midgard
@@ -50,6 +50,10 @@ void Log(const std::string&, const std::string& custom_directive = " [TRACE] ");
 // try something like:
 // logging::Configure({ {"type", "std_out"}, {"color", ""} })
 // logging::Configure({ {"type", "file"}, {"file_name", "test.log"}, {"reopen_interval", "1"} })
+// any of the std_out, std_err or file loggers can write on their own thread so that logging
+// never blocks on the output, lines are dropped and counted if they come faster than they are written
+// logging::Configure({ {"type", "file"}, {"file_name", "test.log"}, {"async", "true"},
+//                      {"async_queue_size", "8192"}, {"async_flush_interval", "100"} })
 void Configure(const LoggingConfig& config);
 
 // guarding against redefinitions
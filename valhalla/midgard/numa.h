@@ -0,0 +1,47 @@
+#ifndef VALHALLA_MIDGARD_NUMA_H_
+#define VALHALLA_MIDGARD_NUMA_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * The NUMA nodes (sockets) of the machine and the cpus on each, as the kernel lists them. Threads
+ * of a worker pinned to the cpus of a node allocate their memory on that node, so a tile cache per
+ * node keeps the tiles a worker reads next to it rather than across the interconnect.
+ */
+class numa_t {
+public:
+  /**
+   * @return the cpus of each node, a single node with all the cpus where the kernel doesn't list
+   *         any (other platforms or no NUMA)
+   */
+  static const std::vector<std::vector<uint32_t>>& nodes();
+
+  /**
+   * Pins the calling thread to the cpus of the node and remembers the node for the thread.
+   * @param  node  the node, taken modulo the number of nodes
+   * @return whether the thread could be pinned, it is remembered either way
+   */
+  static bool pin(uint32_t node);
+
+  /**
+   * @return the node the calling thread was pinned to, 0 for threads which weren't
+   */
+  static uint32_t current();
+
+  /**
+   * Parses a cpu list like 0-3,8,10-11 as the kernel writes them.
+   * @param  list  the cpu list
+   * @return the cpus in it
+   */
+  static std::vector<uint32_t> parse_cpu_list(const std::string& list);
+};
+
+} // namespace midgard
+} // namespace valhalla
+
+#endif // VALHALLA_MIDGARD_NUMA_H_
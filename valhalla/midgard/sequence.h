@@ -10,12 +10,14 @@
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -253,7 +255,86 @@ public:
     return file_name;
   }
 
+  /**
+   * Advises the kernel how a range of the map will be read, the range is widened to whole pages.
+   * @param  advice  one of the POSIX_MADV_* values
+   * @param  offset  where the range starts in bytes from the start of the map
+   * @param  bytes   how long the range is, it ends at the end of the map at most
+   * @return whether the kernel took the advice
+   */
+  bool advise(int advice, size_t offset = 0, size_t bytes = std::numeric_limits<size_t>::max()) {
+#if defined(_WIN32)
+    return false;
+#else
+    auto range = pages(offset, bytes);
+    return range.second && posix_madvise(range.first, range.second, advice) == 0;
+#endif
+  }
+
+  /**
+   * Asks for the map to be backed by transparent huge pages, which cover it with far fewer TLB
+   * entries. Kernels only do so for file mappings when built to, elsewhere this does nothing.
+   * @return whether the kernel took the advice
+   */
+  bool advise_huge_pages() {
+#if defined(MADV_HUGEPAGE) && !defined(_WIN32)
+    auto range = pages(0, std::numeric_limits<size_t>::max());
+    return range.second && madvise(range.first, range.second, MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Faults the whole map in up front by reading a byte of every page, like MAP_POPULATE would
+   * have when mapping it.
+   */
+  void populate() const {
+#if !defined(_WIN32)
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const volatile char* bytes = static_cast<const char*>(ptr);
+    char sum = 0;
+    for (size_t offset = 0; offset < count * sizeof(T); offset += page) {
+      sum += bytes[offset];
+    }
+    (void)sum;
+#endif
+  }
+
+  /**
+   * Locks a range of the map in memory so that reading it never faults, the range is widened to
+   * whole pages. The process has to be allowed to lock that much (RLIMIT_MEMLOCK).
+   * @param  offset  where the range starts in bytes from the start of the map
+   * @param  bytes   how long the range is, it ends at the end of the map at most
+   * @return whether the range could be locked
+   */
+  bool lock(size_t offset, size_t bytes) {
+#if defined(_WIN32)
+    return false;
+#else
+    auto range = pages(offset, bytes);
+    return range.second && mlock(range.first, range.second) == 0;
+#endif
+  }
+
 protected:
+  // the whole pages which cover the byte range of the map
+  std::pair<char*, size_t> pages(size_t offset, size_t bytes) const {
+    const size_t size = count * sizeof(T);
+    if (!ptr || offset >= size) {
+      return {nullptr, 0};
+    }
+    bytes = std::min(bytes, size - offset);
+#if defined(_WIN32)
+    const size_t page = 4096;
+#else
+    const size_t page = sysconf(_SC_PAGESIZE);
+#endif
+    char* base = static_cast<char*>(ptr);
+    const size_t begin = offset / page * page;
+    return {base + begin, offset + bytes - begin};
+  }
+
   void* ptr;
   size_t count;
   std::string file_name;
@@ -325,72 +406,115 @@ public:
     return npos;
   }
 
-  // sort the file based on the predicate, and outputs to output_seq
+  // sort the file based on the predicate
   //
-  // Strategy is to first sort sub-ranges of length buffer_size in place.
-  // These should all fit in memory. Then, merge the sub-ranges into the
-  // output sequence via priority queue.
+  // Strategy is an external merge sort. The file is read in chunks of at most memory_budget bytes,
+  // each chunk is cut into one run per thread and the runs are sorted in parallel. When the whole
+  // file fits in one chunk the runs are merged straight back into the file, otherwise each chunk
+  // is written out to a temporary file and all of the runs are merged from there via priority
+  // queue. Both the file and the runs are only ever read and written front to back, so the sort
+  // streams through the page cache rather than jumping around in a file larger than memory.
   void sort(const std::function<bool(const T&, const T&)>& predicate,
-            size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
+            size_t memory_budget = 1024 * 1024 * 512,
+            uint32_t threads = 1) {
     flush();
     // if no elements we are done
-    if (memmap.size() == 0) {
+    const size_t count = memmap.size();
+    if (count == 0) {
       return;
     }
 
-    // If there wont be any merging we may as well take the simple approach
-    if (buffer_size > memmap.size() + write_buffer.size()) {
-      std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
+    // how big the chunks and the runs within them are, small inputs arent worth a thread. every
+    // chunk is made of whole runs so that the merge finds a run at each multiple of the run size
+    size_t chunk_size = std::min(count, std::max<size_t>(1, memory_budget / sizeof(T)));
+    threads = static_cast<uint32_t>(
+        std::max<size_t>(1, std::min<size_t>(threads, chunk_size / (1024 * 64))));
+    const size_t run_size = (chunk_size + threads - 1) / threads;
+    chunk_size = std::min(count, run_size * threads);
+
+    // a single run is simply sorted in place
+    if (run_size == count) {
+      std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + count, predicate);
       return;
     }
+    std::vector<T> chunk;
+    chunk.reserve(chunk_size);
+
+    // sorts each run of the chunk on a thread of its own
+    auto sort_runs = [&predicate, run_size](std::vector<T>& elements) {
+      std::vector<std::thread> sorters;
+      for (size_t i = run_size; i < elements.size(); i += run_size) {
+        sorters.emplace_back([&predicate, &elements, i, run_size]() {
+          std::sort(elements.begin() + i,
+                    elements.begin() + std::min(elements.size(), i + run_size), predicate);
+        });
+      }
+      std::sort(elements.begin(), elements.begin() + std::min(elements.size(), run_size),
+                predicate);
+      for (auto& sorter : sorters) {
+        sorter.join();
+      }
+    };
 
+    // the sorted runs are either in memory or in a temporary file
+    const T* runs = nullptr;
+    mem_map<T> run_map;
     auto tmp_path = filesystem::path(file_name).replace_filename(
         filesystem::path(file_name).filename().string() + ".tmp");
-    {
-      // we need a temporary sequence to merge the sorted subsections into
-      sequence<T> output_seq(tmp_path.string(), true);
-
-      // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
-      // Pq keeps track of element and its index.
-      auto cmp = [&predicate](const std::pair<T, size_t>& a, std::pair<T, size_t>& b) {
-        return predicate(b.first, a.first);
-      };
-      std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)> pq(
-          cmp);
-
-      // Sort the subsections
-      for (size_t i = 0; i < memmap.size(); i += buffer_size) {
-        std::sort(static_cast<T*>(memmap) + i,
-                  static_cast<T*>(memmap) + std::min(memmap.size(), i + buffer_size), predicate);
-        pq.emplace(*at(i), i);
-      }
-
-      // Perform the merge
-      while (!pq.empty()) {
-        auto tmp = pq.top();
-        pq.pop();
-        output_seq.push_back(tmp.first);
-        size_t new_idx = tmp.second + 1;
-        if (new_idx % buffer_size != 0 && new_idx < memmap.size()) {
-          pq.emplace(*at(new_idx), new_idx);
+    if (chunk_size == count) {
+      // it all fits so we dont need to go to disk
+      chunk.assign(static_cast<const T*>(memmap), static_cast<const T*>(memmap) + count);
+      sort_runs(chunk);
+      runs = chunk.data();
+    } else {
+      // write the sorted chunks one after the other into a temporary file
+      {
+        std::ofstream run_file(tmp_path.string(), std::ios::binary | std::ios::trunc);
+        for (size_t i = 0; i < count; i += chunk_size) {
+          chunk.assign(static_cast<const T*>(memmap) + i,
+                       static_cast<const T*>(memmap) + std::min(count, i + chunk_size));
+          sort_runs(chunk);
+          run_file.write(static_cast<const char*>(static_cast<const void*>(chunk.data())),
+                         chunk.size() * sizeof(T));
+        }
+        if (!run_file) {
+          throw std::runtime_error("sequence: " + tmp_path.string() + ": " + strerror(errno));
         }
       }
-      output_seq.flush();
+      // we need the memory for the merge
+      std::vector<T>().swap(chunk);
+      run_map.map(tmp_path.string(), count, POSIX_MADV_NORMAL, true);
+      runs = run_map;
+    }
+
+    // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
+    // Pq keeps track of element and its index.
+    auto cmp = [&predicate](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+      return predicate(b.first, a.first);
+    };
+    std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)> pq(
+        cmp);
+    for (size_t i = 0; i < count; i += run_size) {
+      pq.emplace(runs[i], i);
+    }
+
+    // Perform the merge, right back into the file
+    T* output = memmap;
+    while (!pq.empty()) {
+      auto tmp = pq.top();
+      pq.pop();
+      *output++ = tmp.first;
+      size_t new_idx = tmp.second + 1;
+      if (new_idx % run_size != 0 && new_idx < count) {
+        pq.emplace(runs[new_idx], new_idx);
+      }
     }
 
-    // Forget about this file for a second so we can swap in the temp file
-    file.reset();
-    memmap.unmap();
-
-    // Move the sorted result back into place
-    filesystem::remove(file_name);
-    filesystem::rename(tmp_path, file_name);
-
-    // Reload the sequence
-    sequence<T> reloaded(file_name, false);
-    std::swap(file, reloaded.file);
-    std::swap(memmap, reloaded.memmap);
-    return;
+    // the runs are of no further use
+    if (run_map.get()) {
+      run_map.unmap();
+      filesystem::remove(tmp_path);
+    }
   }
 
   // perform an volatile operation on all the items of this sequence
@@ -7,6 +7,8 @@
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/constants.h>
@@ -353,6 +355,15 @@ public:
    */
   std::vector<int32_t> TileList(const Ellipse<coord_t>& ellipse) const;
 
+  /**
+   * Get the list of tiles that lie within the specified ellipse like TileList does but append
+   * them to a list the caller can reuse across calls. The tiles within the bounding box of the
+   * ellipse are tested row by row.
+   * @param  ellipse  Ellipse
+   * @param  tiles    The tiles that are within or intersect the ellipse are appended to it.
+   */
+  void TileList(const Ellipse<coord_t>& ellipse, std::vector<int32_t>& tiles) const;
+
   /**
    * Color a "connectivity map" starting with a sparse map of uncolored tiles.
    * Any 2 tiles that have a connected path between them will have the same
@@ -372,6 +383,20 @@ public:
   std::unordered_map<int32_t, std::unordered_set<unsigned short>>
   Intersect(const container_t& line_string) const;
 
+  // a tile id and the index of a sub cell within it
+  using cell_t = std::pair<int32_t, unsigned short>;
+
+  /**
+   * Intersect the linestring with the tiles like Intersect does but append the tiles and sub cells
+   * to a list the caller can reuse across calls rather than building a map. They are appended in
+   * the order the linestring crosses them, a cell is only there more than once if the linestring
+   * comes back to it.
+   * @param line_string  the linestring to be tested against the cells
+   * @param cells        the intersected tiles and sub cells are appended to it
+   */
+  template <class container_t>
+  void Intersect(const container_t& line_string, std::vector<cell_t>& cells) const;
+
   /**
    * Intersect the bounding box with the tiles to see which tiles and sub-cells
    * (a.k.a bins) it intersects with. This can be used to reduce the number of
@@ -394,6 +419,15 @@ public:
   ClosestFirst(const coord_t& seed) const;
 
 protected:
+  /**
+   * Walks the sub cells crossed by each segment of the linestring.
+   * @param line_string  the linestring
+   * @param set_cell     called with the global column and row of each sub cell crossed, returns
+   *                     true if the cell is outside of the tiles
+   */
+  template <class container_t, class set_cell_t>
+  void Rasterize(const container_t& line_string, set_cell_t&& set_cell) const;
+
   // Does the tile bounds wrap in the x direction (e.g. at longitude = 180)
   bool wrapx_;
 
@@ -0,0 +1,44 @@
+#ifndef VALHALLA_MIDGARD_TRACEPOINTS_H_
+#define VALHALLA_MIDGARD_TRACEPOINTS_H_
+
+/**
+ * Static tracepoints (USDT probes) of the valhalla provider, for perf, bpftrace or systemtap to
+ * attach to in a running service, e.g.
+ *
+ *   bpftrace -e 'usdt:./valhalla_service:valhalla:tile_load { @us = hist(arg2); }'
+ *
+ * Builds with ENABLE_TRACEPOINTS put a nop and a note in the binary for each, which is all they
+ * cost until something attaches besides working out the arguments. Other builds compile them away,
+ * the arguments included, so these should be cheap and free of side effects.
+ *
+ * The probes and their arguments:
+ *   tile_load(tile id, bytes, microseconds)                   a tile read on a cache miss
+ *   tile_evict(tile id, bytes)                                the LRU cache dropped a tile
+ *   cache_clear(tiles)                                        a tile cache was emptied
+ *   queue_redistribution(labels)                              the overflow bucket was refilled
+ *   search_start(algorithm)                                   a path algorithm or matrix started
+ *   search_done(algorithm, labels)                            and its expansion finished
+ *   map_match_column(measurement index, candidates)           a column of the map matcher
+ *   phase_start(phase)                                        a phase of measure_phase started
+ *   phase_done(phase, microseconds)                           and finished, e.g. tyr.serialize
+ * Strings are passed as char pointers.
+ */
+#ifdef ENABLE_TRACEPOINTS
+#include <sys/sdt.h>
+#define VALHALLA_TRACE(probe, ...) STAP_PROBEV(valhalla, probe, ##__VA_ARGS__)
+#else
+namespace valhalla {
+namespace midgard {
+// keeps the arguments of compiled away tracepoints used
+template <typename... Args> inline void untraced(const Args&...) {
+}
+} // namespace midgard
+} // namespace valhalla
+#define VALHALLA_TRACE(probe, ...)                                                                 \
+  do {                                                                                             \
+    if (false)                                                                                     \
+      valhalla::midgard::untraced(__VA_ARGS__);                                                    \
+  } while (false)
+#endif
+
+#endif // VALHALLA_MIDGARD_TRACEPOINTS_H_
@@ -566,6 +566,44 @@ using ring_t = std::list<PointLL>;
 using polygon_t = std::list<ring_t>;
 polygon_t to_boundary(const std::unordered_set<uint32_t>& region, const Tiles<PointLL>& tiles);
 
+/**
+ * A shape decoded into separate arrays of longitudes and latitudes so that projector_t can survey
+ * all of its segments in a single pass. Reuse one for many shapes to avoid allocating every time
+ */
+struct shape_soa_t {
+  template <typename decoder_t> void decode(decoder_t& shape) {
+    lons.clear();
+    lats.clear();
+    while (!shape.empty()) {
+      const auto p = shape.pop();
+      lons.push_back(p.lng());
+      lats.push_back(p.lat());
+    }
+  }
+
+  void assign(const std::vector<PointLL>& shape) {
+    lons.resize(shape.size());
+    lats.resize(shape.size());
+    for (size_t i = 0; i < shape.size(); ++i) {
+      lons[i] = shape[i].lng();
+      lats[i] = shape[i].lat();
+    }
+  }
+
+  size_t size() const {
+    return lons.size();
+  }
+
+  PointLL point(size_t i) const {
+    return {lons[i], lats[i]};
+  }
+
+  std::vector<double> lons;
+  std::vector<double> lats;
+  // squared distance to each segment, scratch space for projector_t
+  std::vector<double> sq_distances;
+};
+
 /**
  * A place where we can share the projecting of a single point onto any number of geometries
  * where the point is long lived and we survey many many shape segments such as is done in
@@ -573,7 +611,8 @@ polygon_t to_boundary(const std::unordered_set<uint32_t>& region, const Tiles<Po
  * */
 struct projector_t {
   projector_t(const PointLL& ll)
-      : lon_scale(cos(ll.lat() * kRadPerDegD)), lat(ll.lat()), lng(ll.lng()), approx(ll) {
+      : lon_scale(cos(ll.lat() * kRadPerDegD)), lat(ll.lat()), lng(ll.lng()), approx(ll),
+        m_per_lng_degree(approx.GetLngScale() * kMetersPerDegreeLat) {
   }
 
   // non default constructible and move only type
@@ -615,11 +654,49 @@ struct projector_t {
     return {u.first + bx * scale, u.second + by * scale};
   }
 
+  // Find the segment of a shape with at least 2 points that is closest to the point, the first one
+  // if there is a tie, and its projected point and squared distance. Every segment is projected the
+  // way operator() does it but without branches and into a separate lane so that the loop
+  // vectorizes. The winner is projected once more with operator() so that the result is exactly
+  // what surveying the segments one at a time gives
+  size_t closest_segment(shape_soa_t& shape, PointLL& point, double& sq_distance) const {
+    const size_t segments = shape.size() - 1;
+    shape.sq_distances.resize(segments);
+    const double* lons = shape.lons.data();
+    const double* lats = shape.lats.data();
+    double* sq_distances = shape.sq_distances.data();
+    for (size_t i = 0; i < segments; ++i) {
+      const double bx = lons[i + 1] - lons[i];
+      const double by = lats[i + 1] - lats[i];
+      const double bx2 = bx * lon_scale;
+      const double sq = bx2 * bx2 + by * by;
+      const double scale = (lng - lons[i]) * lon_scale * bx2 + (lat - lats[i]) * by;
+      // zero length segments come out of the first case, so the division is only ever thrown away
+      const double t = scale / sq;
+      const double x = scale <= 0.0 ? lons[i] : (scale >= sq ? lons[i + 1] : lons[i] + bx * t);
+      const double y = scale <= 0.0 ? lats[i] : (scale >= sq ? lats[i + 1] : lats[i] + by * t);
+      const double dy = (y - lat) * kMetersPerDegreeLat;
+      const double dx = (x - lng) * m_per_lng_degree;
+      sq_distances[i] = dy * dy + dx * dx;
+    }
+
+    size_t closest = 0;
+    for (size_t i = 1; i < segments; ++i) {
+      if (sq_distances[i] < sq_distances[closest]) {
+        closest = i;
+      }
+    }
+    point = (*this)(shape.point(closest), shape.point(closest + 1));
+    sq_distance = approx.DistanceSquared(point);
+    return closest;
+  }
+
   // critical data
   double lon_scale;
   double lat;
   double lng;
   DistanceApproximator<PointLL> approx;
+  double m_per_lng_degree;
 };
 
 /**
@@ -635,6 +712,16 @@ struct projector_t {
 template <typename coord_t>
 bool triangle_contains(const coord_t& a, const coord_t& b, const coord_t& c, const coord_t& p);
 
+/**
+ * Where a cell of a square grid falls along the Hilbert curve through the grid. Cells which are
+ * close along the curve are close on the grid, so ordering by it keeps neighbors together.
+ * @param  x      column of the cell
+ * @param  y      row of the cell
+ * @param  order  the grid is 2^order cells on a side, at most 32
+ * @return the index of the cell along the curve
+ */
+uint64_t hilbert_index(uint32_t x, uint32_t y, const uint32_t order);
+
 /**
  * Convert the input units, in either imperial or metric, into meters.
  * @param   units_km_or_mi (kms or miles), to convert to meters
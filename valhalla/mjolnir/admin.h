@@ -2,14 +2,18 @@
 #define VALHALLA_MJOLNIR_ADMIN_H_
 
 #include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/geometry/io/wkt/wkt.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <vector>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/pointll.h>
@@ -25,6 +29,54 @@ namespace mjolnir {
 typedef boost::geometry::model::d2::point_xy<double> point_type;
 typedef boost::geometry::model::polygon<point_type> polygon_type;
 typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+typedef boost::geometry::model::box<point_type> box_type;
+
+/**
+ * The admin or time zone polygons of a db loaded into memory in one go, with an r-tree over their
+ * bounding boxes which is bulk loaded (packed) at once. It is built before the tiles are and shared
+ * read only by all the threads building them, so that they don't each run spatial queries against
+ * the db for every tile.
+ */
+class PolygonIndex {
+public:
+  // An admin area (or a time zone, which only has the tz index and the polygon)
+  struct Area {
+    std::string country_name;
+    std::string state_name;
+    std::string country_iso;
+    std::string state_iso;
+    bool drive_on_right;
+    bool allow_intersection_names;
+    uint32_t tz_index;
+    multi_polygon_type geom;
+  };
+
+  /**
+   * Packs the r-tree over the areas.
+   * @param  areas  the areas in the order the lookups should return them in
+   */
+  explicit PolygonIndex(std::vector<Area> areas);
+
+  /**
+   * Get the areas whose polygons intersect the bounding box.
+   * @param  aabb  bb of the tile
+   * @return the areas in the order they were loaded in
+   */
+  std::vector<const Area*> Intersecting(const AABB2<PointLL>& aabb) const;
+
+  size_t size() const {
+    return areas_.size();
+  }
+
+protected:
+  using value_type = std::pair<box_type, uint32_t>;
+
+  std::vector<Area> areas_;
+  boost::geometry::index::rtree<value_type, boost::geometry::index::rstar<16>> rtree_;
+};
+
+// Polygons of the areas intersecting a tile by their admin or tz index, pointing into the index
+using polygon_refs = std::multimap<uint32_t, const multi_polygon_type*>;
 
 /**
  * Get the dbhandle of a sqlite db.  Used for timezones and admins DBs.
@@ -51,6 +103,42 @@ uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys
  */
 uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys, const PointLL& ll);
 
+/**
+ * Get the polygon index from the polygons an index found for a tile, see above.
+ * @param  polys      polys of the tile.
+ * @param  ll         point that needs to be checked.
+ * @param  graphtile  graphtilebuilder that is used to determine if we are a country poly or not.
+ */
+uint32_t GetMultiPolyId(const polygon_refs& polys, const PointLL& ll, GraphTileBuilder& graphtile);
+
+/**
+ * Get the polygon index from the polygons an index found for a tile, see above.
+ * @param  polys      polys of the tile.
+ * @param  ll         point that needs to be checked.
+ */
+uint32_t GetMultiPolyId(const polygon_refs& polys, const PointLL& ll);
+
+/**
+ * Load all the admin polys (states then countries) of the db into an index.
+ * @param  db_handle    sqlite3 db handle
+ * @return the index or nullptr without a db
+ */
+std::shared_ptr<const PolygonIndex> LoadAdmins(sqlite3* db_handle);
+
+/**
+ * Load all the timezone polys of the db into an index.
+ * @param  db_handle    sqlite3 db handle
+ * @return the index or nullptr without a db
+ */
+std::shared_ptr<const PolygonIndex> LoadTimeZones(sqlite3* db_handle);
+
+/**
+ * Get the timezone polys from the index
+ * @param  timezones    the timezone index
+ * @param  aabb         bb of the tile
+ */
+polygon_refs GetTimeZones(const PolygonIndex& timezones, const AABB2<PointLL>& aabb);
+
 /**
  * Get the timezone polys from the db
  * @param  db_handle    sqlite3 db handle
@@ -92,6 +180,23 @@ GetAdminInfo(sqlite3* db_handle,
              const AABB2<PointLL>& aabb,
              GraphTileBuilder& tilebuilder);
 
+/**
+ * Get the admin polys from the index that intersect with the tile bounding box and add their
+ * admins to the tile, just like the db query above.
+ * @param  admins           the admin index
+ * @param  drive_on_right   unordered map that indicates if a country drives on right side of the
+ * road
+ * @param  allow_intersection_names   unordered map that indicates if we call out intersections
+ * names for this country
+ * @param  aabb             bb of the tile
+ * @param  tilebuilder      Graph tile builder
+ */
+polygon_refs GetAdminInfo(const PolygonIndex& admins,
+                          std::unordered_map<uint32_t, bool>& drive_on_right,
+                          std::unordered_map<uint32_t, bool>& allow_intersection_names,
+                          const AABB2<PointLL>& aabb,
+                          GraphTileBuilder& tilebuilder);
+
 /**
  * Get all the country access records from the db and save them to a map.
  * @param  db_handle    sqlite3 db handle
@@ -0,0 +1,93 @@
+#ifndef VALHALLA_MJOLNIR_BUILDPROFILE_H
+#define VALHALLA_MJOLNIR_BUILDPROFILE_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <valhalla/mjolnir/util.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Measures what each stage of a tile build costs so that changes in build performance show up from
+ * one build to the next. Stages are measured one after the other, starting a stage ends the one
+ * before it. At the end of the build the report goes to the log, as json to the file named by
+ * mjolnir.build_profile and as gauges to statsd if the config has a statsd host.
+ */
+class BuildProfile {
+public:
+  struct Stage {
+    BuildStage stage;
+    double wall_secs;
+    double cpu_secs;
+    // the peak of the process during the stage, or of the whole build where it cannot be reset
+    uint64_t peak_rss_bytes;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    // the tiles on disk after the stages which work on tiles, 0 for the others
+    uint64_t tiles;
+    double tiles_per_sec;
+    // the cpu time over the wall time of all the threads the build is configured to use
+    double thread_utilization;
+  };
+
+  /**
+   * @param config  the build config, its mjolnir section says where the tiles are and how many
+   *                threads the build uses
+   */
+  explicit BuildProfile(const boost::property_tree::ptree& config);
+
+  /**
+   * Ends the running stage if there is one and starts measuring the given one.
+   * @param stage  the stage which starts now
+   */
+  void Start(BuildStage stage);
+
+  /**
+   * Ends the running stage if there is one.
+   */
+  void Stop();
+
+  /**
+   * Ends the running stage and reports all the stages measured.
+   */
+  void Report();
+
+  /**
+   * @return the stages measured so far in the order they ran
+   */
+  const std::vector<Stage>& stages() const {
+    return stages_;
+  }
+
+  /**
+   * @return the report as json, the stages in the order they ran
+   */
+  std::string ToJson() const;
+
+protected:
+  // what the process used up to a point in time
+  struct Usage {
+    std::chrono::steady_clock::time_point time;
+    double cpu_secs;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+  };
+  static Usage Sample();
+
+  boost::property_tree::ptree config_;
+  unsigned int concurrency_;
+  bool running_;
+  BuildStage stage_;
+  Usage start_;
+  std::vector<Stage> stages_;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_BUILDPROFILE_H
@@ -44,6 +44,20 @@ public:
    */
   void set_mean_elevation(const float mean_elev);
 
+  /**
+   * Set the elevation profile, the samples are evenly spaced from the start to the end of the
+   * shape. Each sample is kept within a quarter meter unless the slope between two of them is
+   * steeper than the encoding allows, the samples after it catch up.
+   * @param  elevation  Elevation samples in meters, fewer than 2 removes the profile.
+   */
+  void set_elevation(const std::vector<float>& elevation);
+
+  /**
+   * Set the encoded elevation profile as it is stored in a tile.
+   * @param  encoded_elevation  Encoded elevation profile
+   */
+  void set_encoded_elevation(const std::string& encoded_elevation);
+
   /**
    * Sets the speed limit in KPH.
    * @param  speed_limit  Speed limit in KPH.
@@ -71,6 +85,14 @@ public:
    */
   void set_name_info_list(const std::vector<baldr::NameInfo>& name_info);
 
+  /**
+   * Get the name info for names used by this edge
+   * @return  Returns the list of street name info.
+   */
+  const std::vector<baldr::NameInfo>& name_info_list() const {
+    return name_info_list_;
+  }
+
   /**
    * Add name info to the list.
    * @param  info  Adds name information to the list.
@@ -117,6 +139,9 @@ protected:
   // Lat,lng shape of the edge
   std::string encoded_shape_;
 
+  // Elevation along the shape of the edge
+  std::string encoded_elevation_;
+
   friend std::ostream& operator<<(std::ostream& os, const EdgeInfoBuilder& id);
 };
 
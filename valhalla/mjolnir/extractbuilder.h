@@ -0,0 +1,29 @@
+#ifndef VALHALLA_MJOLNIR_EXTRACTBUILDER_H
+#define VALHALLA_MJOLNIR_EXTRACTBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to package the finished tiles of mjolnir.tile_dir into an indexed tar extract, the
+ * same one valhalla_build_extract writes, without a separate pass over the tiles afterwards.
+ */
+class ExtractBuilder {
+public:
+  /**
+   * Writes the tiles to mjolnir.tile_extract when mjolnir.build_extract is set. The extract starts
+   * with the index.bin the readers find the tiles with. The whole layout is known up front from
+   * the sizes of the tiles so every thread copies its tiles into their place on its own, and the
+   * bytes of every tile start on a page of their own so that it can be mapped on its own. The
+   * extract is written next to the old one and replaces it at the end.
+   * @param config  Config file to set ExtractBuilder properties
+   */
+  static void Build(const boost::property_tree::ptree& config);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_EXTRACTBUILDER_H
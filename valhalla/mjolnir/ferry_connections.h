@@ -2,6 +2,7 @@
 #define VALHALLA_MJOLNIR_FERRY_CONNECTIONS_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -64,18 +65,25 @@ struct NodeStatusInfo {
  */
 uint32_t GetBestNonFerryClass(const std::map<Edge, size_t>& edges);
 
+// Gets the best classification of the edges at a node as seen by an expansion
+using BestClassFunction = std::function<uint32_t(const std::map<Edge, size_t>&)>;
+
 /**
  * Form the shortest path from the start node until a node that
- * touches the specified road classification.
+ * touches the specified road classification. Nothing is written to the
+ * edges so paths can be formed on several threads at once.
+ * @return  Returns the indexes of the edges along the paths, the ones with a
+ *          worse classification than kFerryUpClass are to be reclassified.
  */
-uint32_t ShortestPath(const uint32_t start_node_idx,
-                      const uint32_t node_idx,
-                      sequence<OSMWay>& ways,
-                      sequence<OSMWayNode>& way_nodes,
-                      sequence<Edge>& edges,
-                      sequence<Node>& nodes,
-                      const bool inbound,
-                      const bool remove_dest_only);
+std::vector<size_t> ShortestPath(const uint32_t start_node_idx,
+                                 const uint32_t node_idx,
+                                 sequence<OSMWay>& ways,
+                                 sequence<OSMWayNode>& way_nodes,
+                                 sequence<Edge>& edges,
+                                 sequence<Node>& nodes,
+                                 const bool inbound,
+                                 const bool remove_dest_only,
+                                 const BestClassFunction& best_class = GetBestNonFerryClass);
 
 /**
  * Check if the ferry included in this node bundle is short. Must be
@@ -91,12 +99,14 @@ bool ShortFerry(const uint32_t node_index,
 
 /**
  * Reclassify edges from a ferry along the shortest path to the
- * specified road classification.
+ * specified road classification. The paths are formed on the given number
+ * of threads.
  */
 void ReclassifyFerryConnections(const std::string& ways_file,
                                 const std::string& way_nodes_file,
                                 const std::string& nodes_file,
-                                const std::string& edges_file);
+                                const std::string& edges_file,
+                                const unsigned int concurrency = 1);
 
 } // namespace mjolnir
 } // namespace valhalla
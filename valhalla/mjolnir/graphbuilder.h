@@ -17,6 +17,8 @@ namespace mjolnir {
 
 using boost::property_tree::ptree;
 
+class TilePipeline;
+
 /**
  * Class used to construct temporary data used to build the initial graph.
  */
@@ -37,6 +39,8 @@ public:
    * in memory
    * @param  pronunciation_file             where to store the to pronunciations so they are not
    * in memory
+   * @param  tiles                          the tiles to build and the index of their first node
+   * @param  pipeline                       if given each tile is marked done in it once written
    */
   static void Build(const boost::property_tree::ptree& pt,
                     const OSMData& osmdata,
@@ -47,7 +51,8 @@ public:
                     const std::string& complex_from_restriction_file,
                     const std::string& complex_to_restriction_file,
                     const std::string& pronunciation_file,
-                    const std::map<baldr::GraphId, size_t>& tiles);
+                    const std::map<baldr::GraphId, size_t>& tiles,
+                    TilePipeline* pipeline = nullptr);
 
   static std::map<baldr::GraphId, size_t> BuildEdges(const ptree& conf,
                                                      const std::string& ways_file,
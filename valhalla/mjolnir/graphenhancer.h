@@ -3,11 +3,15 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
+#include <unordered_set>
+#include <valhalla/baldr/graphid.h>
 #include <valhalla/mjolnir/osmdata.h>
 
 namespace valhalla {
 namespace mjolnir {
 
+class TilePipeline;
+
 /**
  * Class used to enhance graph tile information at the local level.
  */
@@ -18,10 +22,15 @@ public:
    * @param pt          property tree containing the hierarchy configuration
    * @param osmdata     OSM data used to enhance the turn lanes.
    * @param access_file where to store the access tags so they are not in memory
+   * @param tiles       the local tiles to enhance, nullptr for all of them
+   * @param pipeline    if given the tiles to enhance are taken from it as they are built, and reads
+   *                    of tiles not built yet wait for them
    */
   static void Enhance(const boost::property_tree::ptree& pt,
                       const OSMData& osmdata,
-                      const std::string& access_file);
+                      const std::string& access_file,
+                      const std::unordered_set<baldr::GraphId>* tiles = nullptr,
+                      TilePipeline* pipeline = nullptr);
 };
 
 } // namespace mjolnir
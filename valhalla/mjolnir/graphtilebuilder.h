@@ -20,6 +20,7 @@
 #include <valhalla/baldr/nodetransition.h>
 #include <valhalla/baldr/sign.h>
 #include <valhalla/baldr/signinfo.h>
+#include <valhalla/baldr/textdictionary.h>
 #include <valhalla/baldr/transitdeparture.h>
 #include <valhalla/baldr/transitroute.h>
 #include <valhalla/baldr/transitschedule.h>
@@ -75,6 +76,18 @@ public:
    */
   void Update(const std::vector<NodeInfo>& nodes, const std::vector<DirectedEdge>& directededges);
 
+  /**
+   * Update a graph tile with new nodes, directed edges and directed edge extensions. The
+   * extensions may be added to a tile which did not have them, in which case the rest of the
+   * tile contents move back and their offsets in the header are updated.
+   * @param nodes Updated list of nodes
+   * @param directededges Updated list of edges.
+   * @param directededges_ext Updated list of edge extensions, empty to write none
+   */
+  void Update(const std::vector<NodeInfo>& nodes,
+              const std::vector<DirectedEdge>& directededges,
+              const std::vector<DirectedEdgeExt>& directededges_ext);
+
   /**
    * Get the current list of node builders.
    * @return  Returns the node info builders.
@@ -289,6 +302,30 @@ public:
    */
   void set_mean_elevation(const uint32_t offset, const float elev);
 
+  /**
+   * Set the elevation profile of the EdgeInfo given the edge info offset. This requires a
+   * serialized tile builder and changes the size of the EdgeInfo, call UpdateEdgeInfoOffsets
+   * once all of them are set.
+   * @param offset Edge info offset.
+   * @param elevation Elevation samples evenly spaced along the shape.
+   */
+  void set_elevation(const uint32_t offset, const std::vector<float>& elevation);
+
+  /**
+   * Lays the EdgeInfos out again after their sizes changed and points the directed edges at
+   * their new offsets. This requires a serialized tile builder.
+   */
+  void UpdateEdgeInfoOffsets();
+
+  /**
+   * Leave the text which is in the text dictionary out of the tile when it is stored. The
+   * dictionary has to be registered to read the tile, see baldr/textdictionary.h.
+   * @param  dictionary  The text dictionary.
+   */
+  void set_text_dictionary(std::shared_ptr<const TextDictionary> dictionary) {
+    text_dictionary_ = std::move(dictionary);
+  }
+
   /**
    * Add a name to the text list.
    * @param  name  Name/text to add.
@@ -440,6 +477,15 @@ public:
                       const graph_tile_ptr& tile,
                       const std::array<std::vector<GraphId>, kBinCount>& more_bins);
 
+  /**
+   * Writes the compact array of the hot attributes of the directed edges (see DirectedEdgeHot)
+   * to the end of the tile, or refreshes the one the tile already has. Everything else is copied
+   * directly. Updates of the directed edges keep the array in step afterwards
+   * @param tile_dir   Base tile directory
+   * @param tile       the tile that gets the hot directed edges
+   */
+  static void AddHotDirectedEdges(const std::string& tile_dir, const graph_tile_ptr& tile);
+
   /**
    * Get the turn lane builder at the specified index.
    * @param  idx  Index of the turn lane builder.
@@ -513,6 +559,9 @@ protected:
   // Write all textlist items to specified stream
   void SerializeTextListToOstream(std::ostream& out) const;
 
+  // Change the text offsets of the edge names, signs, turn lanes and admins
+  void RemapText(const std::unordered_map<uint32_t, uint32_t>& offsets);
+
   // Base tile directory
   std::string tile_dir_;
 
@@ -583,6 +632,9 @@ protected:
   // Text list. List of names used within this tile
   std::list<std::string> textlistbuilder_;
 
+  // The text dictionary the tile is stored with, if any
+  std::shared_ptr<const TextDictionary> text_dictionary_;
+
   // List of lane connectivity records.
   std::vector<LaneConnectivity> lane_connectivity_builder_;
 
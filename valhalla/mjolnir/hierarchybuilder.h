@@ -14,7 +14,8 @@ class HierarchyBuilder {
 public:
   /**
    * Build the set of hierarchies based on the TileHierarchy configuration
-   * and the current local hierarchy.
+   * and the current local hierarchy. The nodes are associated and the tiles
+   * formed in parallel with mjolnir.concurrency threads.
    * @param  pt              Configuration property tree
    * @param  new_to_old_bin  Filename of the new to old node association file
    * @param  old_to_new_bin  Filename for the old to new node association file.
@@ -0,0 +1,69 @@
+#ifndef VALHALLA_MJOLNIR_INCREMENTALBUILDER_H
+#define VALHALLA_MJOLNIR_INCREMENTALBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_set>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Lets a build redo the build and enhance stages only for the local level tiles touched by an
+ * update of the osm data. All other local tiles are copied from a snapshot of those stages which
+ * an earlier build left in mjolnir.snapshot_dir. The stages before (parsing, constructing the
+ * edges) and after (filter through validate) still run over the whole graph, they need all of it.
+ *
+ * The update is given in mjolnir.update as an osc file of the changes, a bbox or a list of local
+ * tile ids. Unchanged tiles are rebuilt along with it when they have edges to its tiles, those
+ * edges point at nodes whose ids may have moved.
+ */
+class IncrementalBuilder {
+public:
+  /**
+   * @param pt  the whole config
+   * @return true if the config asks to update only part of the local tiles
+   */
+  static bool Updating(const boost::property_tree::ptree& pt);
+
+  /**
+   * Works out the local level tiles an update touches.
+   * @param pt              the whole config
+   * @param tiles           the first node index of each tile in the nodes file
+   * @param ways_file       where the ways of the new data are
+   * @param way_nodes_file  where the nodes of those ways are, sorted by way index
+   * @param edges_file      where the edges between the nodes are
+   * @return the tiles to rebuild
+   */
+  static std::unordered_set<baldr::GraphId>
+  AffectedTiles(const boost::property_tree::ptree& pt,
+                const std::map<baldr::GraphId, size_t>& tiles,
+                const std::string& ways_file,
+                const std::string& way_nodes_file,
+                const std::string& edges_file);
+
+  /**
+   * Copies the local tiles of the snapshot that are not rebuilt into the tile_dir.
+   * @param pt        the whole config
+   * @param affected  the tiles which are rebuilt
+   */
+  static void RestoreSnapshot(const boost::property_tree::ptree& pt,
+                              const std::unordered_set<baldr::GraphId>& affected);
+
+  /**
+   * Copies the enhanced local tiles of the tile_dir into the snapshot, if there is one.
+   * @param pt        the whole config
+   * @param affected  the tiles which were rebuilt, nullptr if all of them were
+   */
+  static void StoreSnapshot(const boost::property_tree::ptree& pt,
+                            const std::unordered_set<baldr::GraphId>* affected);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_INCREMENTALBUILDER_H
@@ -0,0 +1,28 @@
+#ifndef VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+#define VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to write the distances of every node of the road levels from a few landmarks, which
+ * the path algorithms use to tighten their A* heuristic, see baldr/landmarkdistances.h.
+ */
+class LandmarkBuilder {
+public:
+  /**
+   * Picks mjolnir.landmark_count landmarks around the edge of the graph and writes the road
+   * distance of every node from each of them to mjolnir.landmarks. Does nothing when
+   * mjolnir.landmarks isn't set. The graph must be complete since the distances cross tile and
+   * hierarchy boundaries.
+   * @param config  Config file to set LandmarkBuilder properties
+   */
+  static void Build(const boost::property_tree::ptree& config);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_LANDMARKBUILDER_H
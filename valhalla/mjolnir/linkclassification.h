@@ -10,13 +10,15 @@ namespace mjolnir {
 
 // Reclassify links (ramps and turn channels). OSM usually classifies links as
 // the best classification, while to more effectively create shortcuts it is
-// better to "downgrade" link edges to the lower classification.
+// better to "downgrade" link edges to the lower classification. The exits are
+// found and their link graphs are built on the given number of threads.
 void ReclassifyLinks(const std::string& ways_file,
                      const std::string& nodes_file,
                      const std::string& edges_file,
                      const std::string& way_nodes_file,
                      const OSMData& osmdata,
-                     bool infer_turn_channels);
+                     bool infer_turn_channels,
+                     unsigned int concurrency = 1);
 } // namespace mjolnir
 } // namespace valhalla
 #endif // VALHALLA_MJOLNIR_LINK_CLASSIFICATION_H_
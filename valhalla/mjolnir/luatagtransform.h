@@ -8,18 +8,18 @@ extern "C" {
 }
 
 #include <valhalla/mjolnir/osmdata.h>
+#include <valhalla/mjolnir/tagtransform.h>
 
 #include <string>
-#include <unordered_map>
 
 namespace valhalla {
 namespace mjolnir {
 
-using Tags = std::unordered_map<std::string, std::string>;
-
 /**
+ * Runs the nodes_proc, ways_proc and rels_proc functions of a lua script over the tags. A lua state
+ * is not thread safe so every thread parsing tags needs its own instance.
  */
-class LuaTagTransform {
+class LuaTagTransform : public TagTransform {
 public:
   /**
    * Constructor
@@ -27,9 +27,9 @@ public:
    */
   LuaTagTransform(const std::string& lua);
 
-  ~LuaTagTransform();
+  ~LuaTagTransform() override;
 
-  Tags Transform(OSMType type, uint64_t osmid, const Tags& tags);
+  Tags Transform(OSMType type, uint64_t osmid, const Tags& tags) override;
 
 protected:
   lua_State* state_;
@@ -0,0 +1,24 @@
+#ifndef VALHALLA_MJOLNIR_NATIVETAGTRANSFORM_H
+#define VALHALLA_MJOLNIR_NATIVETAGTRANSFORM_H
+
+#include <valhalla/mjolnir/osmdata.h>
+#include <valhalla/mjolnir/tagtransform.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * The default tag transformation of lua/graph.lua written in c++. It gives the same results as
+ * running that script through the LuaTagTransform without the cost of building a lua table for
+ * every element and calling into the interpreter. It holds no state so it is safe to share it
+ * between threads. Changes to lua/graph.lua have to be made here as well.
+ */
+class NativeTagTransform : public TagTransform {
+public:
+  Tags Transform(OSMType type, uint64_t osmid, const Tags& tags) override;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_NATIVETAGTRANSFORM_H
@@ -249,6 +249,15 @@ node_bundle collect_node_edges(const sequence<Node>::iterator& node_itr,
                                sequence<Node>& nodes,
                                sequence<Edge>& edges);
 
+/**
+ * Split the nodes into contiguous ranges which start at the first node of a bundle so that each
+ * range can be walked with collect_node_edges on its own thread.
+ * @param  nodes  The nodes to split.
+ * @param  count  The number of ranges wanted.
+ * @return The start of each range followed by the end of the last one.
+ */
+std::vector<size_t> split_node_bundles(sequence<Node>& nodes, size_t count);
+
 } // namespace mjolnir
 } // namespace valhalla
 #endif // VALHALLA_MJOLNIR_NODE_EXPANDER_H_
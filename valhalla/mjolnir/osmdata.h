@@ -1,11 +1,13 @@
 #ifndef VALHALLA_MJOLNIR_OSMDATA_H
 #define VALHALLA_MJOLNIR_OSMDATA_H
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <valhalla/mjolnir/osmaccessrestriction.h>
@@ -42,15 +44,146 @@ struct OSMLaneConnectivity {
   uint32_t from_lanes_index; // Index to string in UniqueNames
 };
 
+/**
+ * A multimap kept as one flat vector of key/value pairs. Entries are appended while parsing and
+ * sorted by key once with sort(), lookups are binary searches from then on. Compared to a node
+ * based hash map this saves the per entry allocations and pointers and the whole thing can be
+ * written to and read from disk as one block.
+ */
+template <typename K, typename V> class SortedMultiMap {
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  /**
+   * Appends an entry, it can only be looked up once the map is sorted again.
+   */
+  void insert(const value_type& entry) {
+    entries_.push_back(entry);
+  }
+
+  /**
+   * Sorts the entries by key. Entries with the same key keep the order they were inserted in.
+   */
+  void sort() {
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const value_type& a, const value_type& b) { return a.first < b.first; });
+  }
+
+  /**
+   * @return the entries with the key, a range of end() when there are none just like the std maps
+   */
+  std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    auto range = std::equal_range(entries_.cbegin(), entries_.cend(), value_type{key, V{}},
+                                  [](const value_type& a, const value_type& b) {
+                                    return a.first < b.first;
+                                  });
+    return range.first == range.second ? std::make_pair(end(), end()) : range;
+  }
+
+  /**
+   * @return the first entry with the key or end()
+   */
+  const_iterator find(const K& key) const {
+    return equal_range(key).first;
+  }
+
+  const_iterator begin() const {
+    return entries_.cbegin();
+  }
+  const_iterator end() const {
+    return entries_.cend();
+  }
+  size_t size() const {
+    return entries_.size();
+  }
+  bool empty() const {
+    return entries_.empty();
+  }
+  void clear() {
+    entries_.clear();
+  }
+
+  // the underlying entries, for bulk reading and writing them
+  std::vector<value_type>& entries() {
+    return entries_;
+  }
+  const std::vector<value_type>& entries() const {
+    return entries_;
+  }
+
+protected:
+  std::vector<value_type> entries_;
+};
+
+/**
+ * A set of ids kept as a flat vector, sorted and deduplicated once with sort() and binary searched
+ * from then on.
+ */
+class SortedIdSet {
+public:
+  using const_iterator = std::vector<uint64_t>::const_iterator;
+
+  /**
+   * Appends an id, it can only be looked up once the set is sorted again.
+   */
+  void insert(const uint64_t id) {
+    ids_.push_back(id);
+  }
+
+  /**
+   * Sorts the ids and drops the duplicates.
+   */
+  void sort() {
+    std::sort(ids_.begin(), ids_.end());
+    ids_.erase(std::unique(ids_.begin(), ids_.end()), ids_.end());
+  }
+
+  /**
+   * @return the id or end() when it is not in the set
+   */
+  const_iterator find(const uint64_t id) const {
+    auto found = std::lower_bound(ids_.cbegin(), ids_.cend(), id);
+    return found != ids_.cend() && *found == id ? found : ids_.cend();
+  }
+
+  const_iterator begin() const {
+    return ids_.cbegin();
+  }
+  const_iterator end() const {
+    return ids_.cend();
+  }
+  size_t size() const {
+    return ids_.size();
+  }
+  void clear() {
+    ids_.clear();
+  }
+
+  // the underlying ids, for bulk reading and writing them
+  std::vector<uint64_t>& ids() {
+    return ids_;
+  }
+  const std::vector<uint64_t>& ids() const {
+    return ids_;
+  }
+
+protected:
+  std::vector<uint64_t> ids_;
+};
+
 // Data types used within OSMData
-using RestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMRestriction>;
-using ViaSet = std::unordered_set<uint64_t>;
-using AccessRestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMAccessRestriction>;
-using BikeMultiMap = std::unordered_multimap<uint64_t, OSMBike>;
-using OSMLaneConnectivityMultiMap = std::unordered_multimap<uint64_t, OSMLaneConnectivity>;
+using RestrictionsMultiMap = SortedMultiMap<uint64_t, OSMRestriction>;
+using ViaSet = SortedIdSet;
+using AccessRestrictionsMultiMap = SortedMultiMap<uint64_t, OSMAccessRestriction>;
+using BikeMultiMap = SortedMultiMap<uint64_t, OSMBike>;
+using OSMLaneConnectivityMultiMap = SortedMultiMap<uint64_t, OSMLaneConnectivity>;
 
-// OSMString map uses the way Id as the key and the name index into UniqueNames as the value
-using OSMStringMap = std::unordered_map<uint64_t, uint32_t>;
+// OSMString map uses the way Id as the key and the name index into UniqueNames as the value. Each
+// way has at most one entry once the data is sorted, see OSMData::sort.
+using OSMStringMap = SortedMultiMap<uint64_t, uint32_t>;
 
 /**
  * Simple container for OSM data.
@@ -83,6 +216,13 @@ struct OSMData {
                        const std::string& reference,
                        const bool forward = true);
 
+  /**
+   * Sorts the relation data by way id so that it can be looked up, merges the refs the relations
+   * added to the same way into one. Has to be called after parsing added to the data and before
+   * anything looks it up.
+   */
+  void sort();
+
   /**
    * Cleanup temporary files.
    */
@@ -101,7 +241,7 @@ struct OSMData {
   // Stores simple restrictions. Indexed by the from way Id
   RestrictionsMultiMap restrictions;
 
-  // unordered set used to find out if a wayid is included in any vias for complex restrictions
+  // set used to find out if a wayid is included in any vias for complex restrictions
   ViaSet via_set;
 
   // Stores access restrictions. Indexed by the from way Id.
@@ -81,8 +81,13 @@ struct Callback {
 class Parser {
 public:
   Parser() = delete;
-  // parse the pbf file for the things you are interested in
-  static void parse(std::ifstream& file, const Interest interest, Callback& callback);
+  // parse the pbf file for the things you are interested in. blocks are inflated and decoded on
+  // up to threads background threads but the callback is always invoked from the calling thread
+  // in file order so consumers that rely on the sorting of the pbf still work
+  static void parse(std::ifstream& file,
+                    const Interest interest,
+                    Callback& callback,
+                    unsigned int threads = 1);
   // clean up protobuf library level memory, this will make protobuf unusable after its called
   static void free();
 };
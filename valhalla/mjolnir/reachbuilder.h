@@ -0,0 +1,27 @@
+#ifndef VALHALLA_MJOLNIR_REACHBUILDER_H
+#define VALHALLA_MJOLNIR_REACHBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to store the reach of every directed edge in the extended directed edge
+ * attributes of the graph tiles, for the default auto, pedestrian and bicycle costings.
+ */
+class ReachBuilder {
+public:
+  /**
+   * Computes and stores the reach of all edges up to mjolnir.reach_limit. Does nothing when
+   * the limit is 0. The graph must be complete and validated since the reach expansions cross
+   * tile and hierarchy boundaries.
+   * @param config  Config file to set ReachBuilder properties
+   */
+  static void Build(const boost::property_tree::ptree& config);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_REACHBUILDER_H
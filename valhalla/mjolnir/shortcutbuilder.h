@@ -13,9 +13,18 @@ namespace mjolnir {
 class ShortcutBuilder {
 public:
   /**
-   * Build the shortcut edges.
+   * Build the shortcut edges. The tiles of each level are shared out to
+   * mjolnir.concurrency threads.
+   * @param pt  the whole config
    */
   static void Build(const boost::property_tree::ptree& pt);
+
+  /**
+   * Writes the edges each shortcut supersedes to the index named by mjolnir.shortcut_index so that
+   * the services do not have to recover them. Needs the opposing edges so it runs after validation.
+   * @param pt  the whole config
+   */
+  static void BuildIndex(const boost::property_tree::ptree& pt);
 };
 
 } // namespace mjolnir
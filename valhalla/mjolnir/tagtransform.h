@@ -0,0 +1,29 @@
+#ifndef VALHALLA_MJOLNIR_TAGTRANSFORM_H
+#define VALHALLA_MJOLNIR_TAGTRANSFORM_H
+
+#include <valhalla/mjolnir/osmdata.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace valhalla {
+namespace mjolnir {
+
+using Tags = std::unordered_map<std::string, std::string>;
+
+/**
+ * Turns the raw OSM tags of a node, way or relation into the keys and values the graph parser
+ * understands. An empty result means the element is of no interest for routing.
+ */
+class TagTransform {
+public:
+  virtual ~TagTransform() = default;
+
+  virtual Tags Transform(OSMType type, uint64_t osmid, const Tags& tags) = 0;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_TAGTRANSFORM_H
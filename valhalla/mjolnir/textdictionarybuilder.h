@@ -0,0 +1,28 @@
+#ifndef VALHALLA_MJOLNIR_TEXTDICTIONARYBUILDER_H
+#define VALHALLA_MJOLNIR_TEXTDICTIONARYBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to move the text which repeats across tiles into a text dictionary shared by all of
+ * them, see baldr/textdictionary.h.
+ */
+class TextDictionaryBuilder {
+public:
+  /**
+   * Builds the text dictionary at mjolnir.text_dictionary out of the text found in more than one
+   * tile, or reuses it if the file is already there, and stores all the tiles again without the
+   * text which is in it. Does nothing when mjolnir.text_dictionary isn't set. Has to run before
+   * the edge bins are added since storing a tile drops them.
+   * @param config  Config file to set TextDictionaryBuilder properties
+   */
+  static void Build(const boost::property_tree::ptree& config);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_TEXTDICTIONARYBUILDER_H
@@ -0,0 +1,82 @@
+#ifndef VALHALLA_MJOLNIR_TILEPIPELINE_H
+#define VALHALLA_MJOLNIR_TILEPIPELINE_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Hands the tiles one stage writes to the next stage as soon as each of them is on disk, so the
+ * next stage can start before the first one has finished all of them. The first stage marks each
+ * tile it wrote as done and closes the pipeline when it stops, the next stage takes the done tiles
+ * one by one. Reads of tiles the first stage has yet to write wait until they are done.
+ */
+class TilePipeline {
+public:
+  /**
+   * @param tiles  the tiles the first stage is going to write
+   */
+  explicit TilePipeline(std::unordered_set<baldr::GraphId> tiles);
+
+  /**
+   * Marks a tile as written, wakes whoever waits for it.
+   * @param tile_id  the tile which is on disk now
+   */
+  void Done(const baldr::GraphId& tile_id);
+
+  /**
+   * Marks the end of the first stage, succeeded or not. Tiles still pending are never written so
+   * nobody waits for them anymore.
+   */
+  void Close();
+
+  /**
+   * Blocks until the tile is written, returns straight away for tiles which are not pending.
+   * @param tile_id  the tile to wait for
+   */
+  void Wait(const baldr::GraphId& tile_id);
+
+  /**
+   * Blocks until there is a written tile nobody took yet.
+   * @param tile_id  the written tile
+   * @return false once the pipeline is closed and all its written tiles were taken
+   */
+  bool Next(baldr::GraphId& tile_id);
+
+protected:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::unordered_set<baldr::GraphId> pending_;
+  std::deque<baldr::GraphId> done_;
+  bool closed_;
+};
+
+/**
+ * A GraphReader which waits for the tiles of a pipeline to be written before reading them.
+ */
+class PipelineGraphReader : public baldr::GraphReader {
+public:
+  PipelineGraphReader(const boost::property_tree::ptree& pt, TilePipeline& pipeline);
+
+  bool DoesTileExist(const baldr::GraphId& graphid) const override;
+
+  baldr::graph_tile_ptr GetGraphTile(const baldr::GraphId& graphid) override;
+
+  using baldr::GraphReader::GetGraphTile;
+
+protected:
+  TilePipeline& pipeline_;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_TILEPIPELINE_H
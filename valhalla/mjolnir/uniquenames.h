@@ -1,19 +1,22 @@
 #ifndef VALHALLA_MJOLNIR_UNIQUENAMES_H
 #define VALHALLA_MJOLNIR_UNIQUENAMES_H
 
-#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <valhalla/midgard/sequence.h>
+
 namespace valhalla {
 namespace mjolnir {
 
-using NamesMap = std::unordered_map<std::string, uint32_t>;
-
 /**
- * Class to hold a list of unique names and indexes to them.
+ * Class to hold a list of unique names and indexes to them. The names are appended back to back
+ * into one buffer and found again through an open addressing table of their indexes, rather than
+ * each being its own allocation in a map. A list written to file can be mapped back in as it is,
+ * the names in the file are used where they are and only names added afterwards go in memory.
  */
 class UniqueNames {
 public:
@@ -21,8 +24,7 @@ public:
    * Constructor.
    */
   UniqueNames() {
-    // Insert dummy so index 0 is never used
-    index("");
+    Clear();
   }
 
   /**
@@ -31,54 +33,69 @@ public:
    * @param  name  Name.
    * @return  Returns an index into the unique list of names.
    */
-  uint32_t index(const std::string& name) {
-    // Find the name in the map. If it is there return the index.
-    auto it = names_.find(name);
-    if (it != names_.end()) {
-      return it->second;
-    } else {
-      // Not in the map, add index and update
-      it = names_.insert(it, NamesMap::value_type(name, 0));
-      indexes_.push_back(it);
-      uint32_t index = indexes_.size() - 1;
-      it->second = index;
-      return index;
-    }
-  }
+  uint32_t index(const std::string& name);
 
   /**
    * Get a name given an index. Returns an empty string if the index is out of range.
    * @param  index  Index into the unique name list.
    * @return  Returns the name
    */
-  const std::string& name(const uint32_t index) const {
-    return (index < (uint32_t)indexes_.size()) ? indexes_[index]->first : indexes_[0]->first;
-  }
+  std::string name(const uint32_t index) const;
 
   /**
    * Clear the names and indexes.
    */
-  void Clear() {
-    names_.clear();
-    indexes_.clear();
-  }
+  void Clear();
 
   /**
    * Get the size - number of names. Since a blank name is added as the first unique name this
-   * returns the size of the map - 1.
+   * returns the number of indexes - 1.
    * @return  Returns the number of unique names.
    */
   size_t Size() const {
-    return names_.size() - 1;
+    return mapped_count_ + offsets_.size() - 2;
   }
 
+  /**
+   * Writes the names, their offsets and the table of indexes to file.
+   * @param  file_name  The file to write
+   * @return  Returns true if the file could be written
+   */
+  bool Write(const std::string& file_name);
+
+  /**
+   * Replaces the names with the ones in a file written by Write. The file is mapped rather than
+   * read back in, only the table of indexes is copied.
+   * @param  file_name  The file to map
+   * @return  Returns true if the file could be mapped
+   */
+  bool Read(const std::string& file_name);
+
 protected:
-  // Map of names to indexes
-  NamesMap names_;
+  // Where the characters of the name at the index start and how many there are
+  std::pair<const char*, size_t> view(const uint32_t index) const;
+
+  // The slot of the table which has the name or the empty one where it goes
+  size_t find(const std::string& name, const uint32_t hash) const;
+
+  // Doubles the table and puts the indexes back in
+  void grow();
+
+  // Copies the mapped names into memory so the file can be written over
+  void unmap();
+
+  // A file written by Write, its names are the first indexes
+  std::shared_ptr<midgard::mem_map<char>> mapped_;
+  uint32_t mapped_count_;
+  const uint64_t* mapped_offsets_;
+  const char* mapped_names_;
+
+  // The names added since, each ends where the next begins
+  std::vector<char> names_;
+  std::vector<uint64_t> offsets_;
 
-  // List of entries into the map
-  using nameiter = NamesMap::iterator;
-  std::vector<nameiter> indexes_;
+  // Open addressing table of indexes with the upper half of their hash above them
+  std::vector<uint64_t> slots_;
 };
 
 } // namespace mjolnir
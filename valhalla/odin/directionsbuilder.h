@@ -1,6 +1,7 @@
 #ifndef VALHALLA_ODIN_DIRECTIONSBUILDER_H_
 #define VALHALLA_ODIN_DIRECTIONSBUILDER_H_
 
+#include <cstdint>
 #include <list>
 
 #include <valhalla/odin/enhancedtrippath.h>
@@ -24,10 +25,12 @@ public:
    * calls PopulateDirectionsLeg to transform the maneuver list into the
    * trip directions.
    *
-   * @param api   the protobuf object containing the request, the path and a place
-   *              to store the resulting directions
+   * @param api      the protobuf object containing the request, the path and a place
+   *                 to store the resulting directions
+   * @param threads  how many legs, of the route and its alternates, may be narrated at the
+   *                 same time on the shared executor, the directions keep the order of the legs
    */
-  static void Build(Api& api, const MarkupFormatter& markup_formatter);
+  static void Build(Api& api, const MarkupFormatter& markup_formatter, const uint32_t threads = 1);
 
 protected:
   /**
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_ODIN_ENHANCEDTRIPPATH_H_
 #define VALHALLA_ODIN_ENHANCEDTRIPPATH_H_
 
+#include <array>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -23,6 +24,7 @@ class EnhancedTripLeg;
 class EnhancedTripLeg_Edge;
 class EnhancedTripLeg_Node;
 class EnhancedTripLeg_Admin;
+struct IntersectingEdgeSummary;
 
 class EnhancedTripLeg {
 public:
@@ -118,6 +120,9 @@ public:
 
 protected:
   TripLeg& trip_path_;
+
+  // What the intersecting edges at each node add up to, worked out the first time it is needed
+  std::vector<IntersectingEdgeSummary> xedge_summaries_;
 };
 
 class EnhancedTripLeg_Edge {
@@ -561,9 +566,26 @@ struct IntersectingEdgeCounts {
   uint32_t left_similar_traversable_outbound;
 };
 
+/**
+ * Which of the intersecting edges at a node are traversable, and traversable outbound, in each
+ * travel mode along with the last right/left counts calculated at the node. Bit i of a mask is
+ * intersecting edge i, nodes with more intersecting edges than that are never summarized.
+ */
+struct IntersectingEdgeSummary {
+  static constexpr int kMaxIntersectingEdges = 64;
+
+  bool summarized = false;
+  std::array<uint64_t, TravelMode_ARRAYSIZE> traversable{};
+  std::array<uint64_t, TravelMode_ARRAYSIZE> traversable_outbound{};
+
+  // The heading and travel mode the counts were last calculated for
+  std::optional<std::pair<uint32_t, TravelMode>> counts_for;
+  IntersectingEdgeCounts counts;
+};
+
 class EnhancedTripLeg_Node {
 public:
-  EnhancedTripLeg_Node(TripLeg_Node* mutable_node);
+  EnhancedTripLeg_Node(TripLeg_Node* mutable_node, IntersectingEdgeSummary* summary = nullptr);
 
   int intersecting_edge_size() const {
     return mutable_node_->intersecting_edge_size();
@@ -743,7 +765,18 @@ public:
   std::string ToString() const;
 
 protected:
+  bool IsIntersectingEdgeTraversable(int index, const TravelMode travel_mode);
+  bool IsIntersectingEdgeTraversableOutbound(int index, const TravelMode travel_mode);
+
+  // Summarizes the intersecting edges if there is a summary that has not been filled out yet
+  void Summarize();
+
+  void CountRightLeftIntersectingEdges(uint32_t from_heading,
+                                       const TravelMode travel_mode,
+                                       IntersectingEdgeCounts& xedge_counts);
+
   TripLeg_Node* mutable_node_;
+  IntersectingEdgeSummary* summary_;
 };
 
 class EnhancedTripLeg_Admin {
@@ -163,8 +163,87 @@ constexpr auto kLevelTag = "<LEVEL>";
 namespace valhalla {
 namespace odin {
 
+/**
+ * The values to replace the tags of a phrase with. The value strings are kept between
+ * phrases so that forming an instruction does not need to allocate them again.
+ */
+class PhraseTagValues {
+public:
+  /**
+   * Sets the value of the specified tag.
+   *
+   * @param  tag    The phrase tag, for example kStreetNamesTag.
+   * @param  value  The value to replace the tag with.
+   */
+  void Set(const char* tag, const std::string& value) {
+    if (count_ == values_.size()) {
+      values_.emplace_back();
+    }
+    values_[count_].first = tag;
+    values_[count_].second.assign(value);
+    ++count_;
+  }
+
+  /**
+   * Returns the value of the specified tag or nullptr if it was not set.
+   */
+  const std::string* Find(const std::string& tag) const {
+    for (size_t i = 0; i < count_; ++i) {
+      if (tag == values_[i].first) {
+        return &values_[i].second;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Forgets all the values but keeps their strings for reuse.
+   */
+  void clear() {
+    count_ = 0;
+  }
+
+protected:
+  std::vector<std::pair<const char*, std::string>> values_;
+  size_t count_ = 0;
+};
+
+/**
+ * A phrase split into its literal text and its tags when the dictionary is loaded so
+ * that an instruction is formed in a single pass over the phrase.
+ */
+class PhraseTemplate {
+public:
+  PhraseTemplate() = default;
+
+  /**
+   * Splits the specified phrase into text and tags, a tag is any <UPPER_CASE> word.
+   *
+   * @param  phrase  The tagged phrase, for example "Turn <RELATIVE_DIRECTION>."
+   */
+  explicit PhraseTemplate(const std::string& phrase);
+
+  /**
+   * Forms the instruction from this phrase by replacing its tags with the specified
+   * values. Tags without a value are kept as they are.
+   *
+   * @param  values       The values of the tags.
+   * @param  instruction  The instruction to form, its storage is reused.
+   */
+  void Render(const PhraseTagValues& values, std::string& instruction) const;
+
+protected:
+  struct Token {
+    std::string text;
+    bool is_tag;
+  };
+  std::vector<Token> tokens_;
+  size_t text_size_ = 0;
+};
+
 struct PhraseSet {
   std::unordered_map<std::string, std::string> phrases;
+  std::unordered_map<std::string, PhraseTemplate> templates;
 };
 
 struct StartSubset : PhraseSet {
@@ -635,6 +635,17 @@ protected:
   bool IsWithinVerbalMultiCueBounds(Maneuver& maneuver);
 
   std::string FormBssManeuverType(DirectionsLeg_Maneuver_BssManeuverType);
+
+  /**
+   * Forms the instruction from the specified tagged phrase and the tag values set in
+   * tag_values_, which are cleared afterwards.
+   *
+   * @param subset The phrase set of the instruction.
+   * @param phrase_id The id of the tagged phrase within the set.
+   * @param instruction The instruction to form.
+   */
+  void FormPhrase(const PhraseSet& subset, uint8_t phrase_id, std::string& instruction);
+
   /**
    * Combines a simple preposition and a definite article for certain languages.
    */
@@ -659,6 +670,9 @@ protected:
   const NarrativeDictionary& dictionary_;
   MarkupFormatter markup_formatter_; // No ref - need our own non-const copy
   bool articulated_preposition_enabled_;
+  bool text_instructions_;
+  bool verbal_instructions_;
+  PhraseTagValues tag_values_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
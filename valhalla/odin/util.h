@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <locale>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -74,9 +75,36 @@ std::string get_localized_time(const std::string& date_time, const std::locale&
  */
 std::string get_localized_date(const std::string& date_time, const std::locale& locale);
 
-using locales_singleton_t = std::unordered_map<std::string, std::shared_ptr<NarrativeDictionary>>;
 /**
- * Returns locale strings mapped to NarrativeDictionaries containing parsed narrative information
+ * Returns the NarrativeDictionary of a locale, the dictionary is parsed from its json the first
+ * time the locale or one of its aliases is asked for and shared by every thread from then on
+ *
+ * @param   locale the locale string or one of its aliases
+ * @return  the dictionary of the locale or nullptr if there is no such locale
+ */
+std::shared_ptr<const NarrativeDictionary> get_locale(const std::string& locale);
+
+/**
+ * Returns whether there is a narrative for the locale without loading its dictionary
+ *
+ * @param   locale the locale string or one of its aliases
+ * @return  true if the locale or alias is known
+ */
+bool is_locale_supported(const std::string& locale);
+
+/**
+ * Loads the dictionaries of the locales up front so the first request in each of them does not
+ * pay for parsing it, unknown locales are logged and skipped
+ *
+ * @param   locales the locale strings or aliases to load
+ */
+void preload_locales(const std::vector<std::string>& locales);
+
+using locales_singleton_t =
+    std::unordered_map<std::string, std::shared_ptr<const NarrativeDictionary>>;
+/**
+ * Returns locale strings mapped to NarrativeDictionaries containing parsed narrative information.
+ * This loads the dictionary of every locale, use get_locale to load only the ones needed
  *
  * @return the map of locales to NarrativeDictionaries
  */
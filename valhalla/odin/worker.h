@@ -32,6 +32,8 @@ public:
 
 protected:
   MarkupFormatter markup_formatter_;
+  // how many legs of a route and its alternates are narrated at the same time
+  uint32_t directions_threads_;
 
 private:
   std::string service_name() const override {
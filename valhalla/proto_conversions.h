@@ -275,6 +275,7 @@ bool Location_Type_Enum_Parse(const std::string& type, Location::Type* t);
 const std::string& Location_Type_Enum_Name(const Location::Type t);
 const std::string& Location_SideOfStreet_Enum_Name(const Location::SideOfStreet s);
 bool Options_ExpansionProperties_Enum_Parse(const std::string& prop, Options::ExpansionProperties* a);
+bool Options_InstructionType_Enum_Parse(const std::string& type, Options::InstructionType* t);
 bool Options_ExpansionAction_Enum_Parse(const std::string& action, Options::Action* a);
 
 std::pair<std::string, std::string>
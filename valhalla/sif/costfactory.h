@@ -4,6 +4,9 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/proto/options.pb.h>
@@ -23,6 +26,11 @@ namespace sif {
 
 /**
  * Generic factory class for creating objects based on type name.
+ *
+ * Building a costing parses its options and fills in its tables of factors, yet most requests use
+ * the same few options. So each costing is built once for all of the requests with the same
+ * options and every request gets a copy of it, only the edges the request excludes are added to
+ * the copy. The costings which were built are kept per factory, each worker has its own.
  */
 class CostFactory {
 public:
@@ -56,6 +64,7 @@ public:
   void Register(const Costing::Type costing, factory_function_t function) {
     factory_funcs_.erase(costing);
     factory_funcs_.emplace(costing, function);
+    prototypes_.clear();
   }
 
   /**
@@ -94,8 +103,42 @@ public:
       auto costing_str = Costing_Enum_Name(costing.type());
       throw std::runtime_error("No costing method found for '" + costing_str + "'");
     }
-    // create the cost using the function pointer
-    return itr->second(costing);
+
+    // the excluded edges are particular to the request, the rest of the options are shared
+    const auto& exclude_edges = costing.options().exclude_edges();
+    Costing shared_costing;
+    if (!exclude_edges.empty()) {
+      shared_costing = costing;
+      shared_costing.mutable_options()->clear_exclude_edges();
+    }
+    const auto& shared = exclude_edges.empty() ? costing : shared_costing;
+
+    // create the cost using the function pointer unless we already did for these options
+    std::string key;
+    shared.SerializeToString(&key);
+    auto prototype = prototypes_.find(key);
+    if (prototype == prototypes_.end()) {
+      if (prototypes_.size() >= kMaxPrototypes) {
+        prototypes_.clear();
+      }
+      prototype = prototypes_.emplace(std::move(key), itr->second(shared)).first;
+    }
+    auto cost = prototype->second->Clone();
+    if (!cost) {
+      prototypes_.erase(prototype);
+      return itr->second(costing);
+    }
+
+    // add what is particular to the request to the copy
+    if (!exclude_edges.empty()) {
+      std::vector<AvoidEdge> edges;
+      edges.reserve(exclude_edges.size());
+      for (const auto& edge : exclude_edges) {
+        edges.push_back({baldr::GraphId(edge.id()), edge.percent_along()});
+      }
+      cost->AddUserAvoidEdges(edges);
+    }
+    return cost;
   }
 
   mode_costing_t CreateModeCosting(const Options& options, TravelMode& mode) {
@@ -119,7 +162,12 @@ public:
   }
 
 private:
+  // how many differently optioned costings are kept before starting over
+  static constexpr size_t kMaxPrototypes = 256;
+
   std::map<const Costing::Type, factory_function_t> factory_funcs_;
+  // the costings which were built by their serialized options, they are only ever copied
+  mutable std::unordered_map<std::string, cost_ptr_t> prototypes_;
 };
 
 } // namespace sif
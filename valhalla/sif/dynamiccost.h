@@ -21,6 +21,7 @@
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/edgestatus.h>
 
+#include <array>
 #include <memory>
 #include <rapidjson/document.h>
 #include <unordered_map>
@@ -153,9 +154,17 @@ public:
 
   virtual ~DynamicCost();
 
-  DynamicCost(const DynamicCost&) = delete;
   DynamicCost& operator=(const DynamicCost&) = delete;
 
+  /**
+   * Copies the costing as it is, the factory hands out copies of a costing built once for all the
+   * requests with the same options. Costings which can't be copied return nullptr.
+   * @return a copy of this costing
+   */
+  virtual std::shared_ptr<DynamicCost> Clone() const {
+    return nullptr;
+  }
+
   /**
    * Does the costing method allow multiple passes (with relaxed
    * hierarchy limits).
@@ -463,7 +472,7 @@ public:
         (!forward && (edge->start_restriction() & access_mode()))) {
       // Get complex restrictions. Return false if no restrictions are found
       auto restrictions = tile->GetRestrictions(forward, edgeid, access_mode());
-      if (restrictions.size() == 0) {
+      if (restrictions.empty()) {
         return false;
       }
 
@@ -572,20 +581,23 @@ public:
     if (ignore_restrictions_ || !(edge->access_restriction() & access_mode))
       return true;
 
-    const std::vector<baldr::AccessRestriction>& restrictions =
-        tile->GetAccessRestrictions(edgeid.id(), access_mode);
-
     bool time_allowed = false;
 
-    for (size_t i = 0; i < restrictions.size(); ++i) {
-      const auto& restriction = restrictions[i];
+    // The restrictions are read in place, i counts the ones for this access mode so that the index
+    // matches what GetAccessRestrictions returns
+    size_t i = 0;
+    for (const auto& restriction : tile->access_restrictions(edgeid.id())) {
+      if (!(restriction.modes() & access_mode)) {
+        continue;
+      }
+      const size_t index = i++;
       // Compare the time to the time-based restrictions
       baldr::AccessType access_type = restriction.type();
       if (access_type == baldr::AccessType::kTimedAllowed ||
           access_type == baldr::AccessType::kTimedDenied ||
           access_type == baldr::AccessType::kDestinationAllowed) {
         // TODO: if(i > baldr::kInvalidRestriction) LOG_ERROR("restriction index overflow");
-        restriction_idx = static_cast<uint8_t>(i);
+        restriction_idx = static_cast<uint8_t>(index);
 
         if (access_type == baldr::AccessType::kTimedAllowed)
           time_allowed = true;
@@ -897,6 +909,9 @@ public:
   }
 
 protected:
+  // only the costings themselves copy costings, see Clone
+  DynamicCost(const DynamicCost&) = default;
+
   /**
    * Calculate `track` costs based on tracks preference.
    * @param use_tracks value of tracks preference in range [0; 1]
@@ -965,6 +980,13 @@ protected:
   float track_penalty_;            // Penalty (seconds) to use tracks
   float service_penalty_;          // Penalty (seconds) to use a generic service road
 
+  // Transition costs precomputed from the ones above by set_transition_tables(). Nodes are keyed
+  // by their type and access flags (see node_class()), edges by the use they enter
+  static constexpr size_t kNodeClasses = 1 << 6;
+  static constexpr size_t kUses = 1 << 6;
+  std::array<sif::Cost, kNodeClasses> node_transition_costs_;
+  std::array<sif::Cost, kUses> use_transition_costs_;
+
   // A mask which determines which flow data the costing should use from the tile
   uint8_t flow_mask_;
 
@@ -1090,6 +1112,48 @@ protected:
     exclude_unpaved_ = costing_options.exclude_unpaved();
 
     exclude_cash_only_tolls_ = costing_options.exclude_cash_only_tolls();
+
+    set_transition_tables();
+  }
+
+  /**
+   * The class of a node in the node transition cost table, its type and access flags.
+   * @param node Node at the intersection where the edge transition occurs.
+   * @return Returns the index into node_transition_costs_.
+   */
+  static uint32_t node_class(const baldr::NodeInfo* node) {
+    return (static_cast<uint32_t>(node->type()) << 2) | (node->private_access() << 1) |
+           node->tagged_access();
+  }
+
+  /**
+   * Precomputes the costs of the transitions which only depend on the node (country crossing,
+   * gates, private access and bike share) and of entering an edge of a use (ferries, alleys, living
+   * streets, tracks and service roads) so base_transition_cost only looks them up. Costings which
+   * change any of these costs after get_base_costs() need to call it again.
+   */
+  void set_transition_tables() {
+    for (uint32_t i = 0; i < kNodeClasses; ++i) {
+      const auto type = static_cast<baldr::NodeType>(i >> 2);
+      const bool private_access = i & 2, tagged_access = i & 1;
+      sif::Cost c;
+      c += country_crossing_cost_ * (type == baldr::NodeType::kBorderControl);
+      c += gate_cost_ * (type == baldr::NodeType::kGate) * (!tagged_access);
+      c += private_access_cost_ *
+           (type == baldr::NodeType::kGate || type == baldr::NodeType::kBollard) * private_access;
+      c += bike_share_cost_ * (type == baldr::NodeType::kBikeShare);
+      node_transition_costs_[i] = c;
+    }
+
+    use_transition_costs_.fill({});
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kFerry)] = ferry_transition_cost_;
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kRailFerry)] =
+        rail_ferry_transition_cost_;
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kAlley)].cost = alley_penalty_;
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kLivingStreet)].cost =
+        living_street_penalty_;
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kTrack)].cost = track_penalty_;
+    use_transition_costs_[static_cast<size_t>(baldr::Use::kServiceRoad)].cost = service_penalty_;
   }
 
   /**
@@ -1115,36 +1179,20 @@ protected:
                                  const baldr::DirectedEdge* edge,
                                  const predecessor_t* pred,
                                  const uint32_t idx) const {
-    // Cases with both time and penalty: country crossing, ferry, rail_ferry, gate, toll booth
-    sif::Cost c;
-    c += country_crossing_cost_ * (node->type() == baldr::NodeType::kBorderControl);
-    c += gate_cost_ * (node->type() == baldr::NodeType::kGate) * (!node->tagged_access());
-    c += private_access_cost_ *
-         (node->type() == baldr::NodeType::kGate || node->type() == baldr::NodeType::kBollard) *
-         node->private_access();
-    c += bike_share_cost_ * (node->type() == baldr::NodeType::kBikeShare);
+    // Cases with both time and penalty: country crossing, gate, bike share and toll booth
+    sif::Cost c = node_transition_costs_[node_class(node)];
     c += toll_booth_cost_ *
          (node->type() == baldr::NodeType::kTollBooth || (edge->toll() && !pred->toll()));
-    c += ferry_transition_cost_ *
-         (edge->use() == baldr::Use::kFerry && pred->use() != baldr::Use::kFerry);
-    c += rail_ferry_transition_cost_ *
-         (edge->use() == baldr::Use::kRailFerry && pred->use() != baldr::Use::kRailFerry);
+
+    // Entering a ferry or rail ferry (time and penalty), an alley, living street, track or service
+    // road (penalty only). Do not penalize internal roads that are marked as service.
+    c += use_transition_costs_[static_cast<size_t>(edge->use())] *
+         (edge->use() != pred->use()) *
+         (edge->use() != baldr::Use::kServiceRoad || !edge->internal());
 
     // Additional penalties without any time cost
     c.cost += destination_only_penalty_ * (edge->destonly() && !pred->destonly());
-    c.cost +=
-        alley_penalty_ * (edge->use() == baldr::Use::kAlley && pred->use() != baldr::Use::kAlley);
     c.cost += maneuver_penalty_ * (!edge->link() && !edge->name_consistency(idx));
-    c.cost += living_street_penalty_ *
-              (edge->use() == baldr::Use::kLivingStreet && pred->use() != baldr::Use::kLivingStreet);
-    c.cost +=
-        track_penalty_ * (edge->use() == baldr::Use::kTrack && pred->use() != baldr::Use::kTrack);
-
-    if (edge->use() == baldr::Use::kServiceRoad && pred->use() != baldr::Use::kServiceRoad) {
-      // Do not penalize internal roads that are marked as service.
-      if (!edge->internal())
-        c.cost += service_penalty_;
-    }
 
     // shortest ignores any penalties in favor of path length
     c.cost *= !shortest_;
@@ -66,7 +66,9 @@ struct HierarchyLimits {
    * @param  dist  Distance (meters) from the destination.
    * @return  Returns true if expansion at this hierarchy level should stop.
    */
-  bool StopExpanding(const float dist) const;
+  bool StopExpanding(const float dist) const {
+    return up_transition_count > max_up_transitions && dist > expansion_within_dist;
+  }
 
   /**
    * Determine if expansion of a hierarchy level should be stopped once
@@ -64,6 +64,14 @@ protected:
    */
   template <class coord_t> double get(const coord_t& coord, tile_data& tile);
 
+  /**
+   * Looks up a tile in the cache, fetching it from the remote source if need be
+   * @param index  the tile index
+   * @param tile   the tile, output value
+   * @return true if the tile has data
+   */
+  bool get_tile(uint16_t index, tile_data& tile);
+
   /**
    * @return A tile index value from a coordinate
    */
@@ -101,6 +109,12 @@ private:
    */
   void cache_initialisation(const std::string& source_path);
 
+  /**
+   * @brief memory maps a tar of elevation tiles, its tiles are used directly from the mapping
+   * @param[in] extract_path  Path to the tar built by valhalla_build_elevation_extract.
+   */
+  void extract_initialisation(const std::string& extract_path);
+
   std::mutex cache_lck;
   std::string url_;
   std::unique_ptr<baldr::tile_getter_t> remote_loader_;
@@ -2,10 +2,21 @@
 
 #include <vector>
 
+#include "midgard/flat_hash.h"
 #include "thor/bidirectional_astar.h"
 
 namespace valhalla {
 namespace thor {
+
+// Most paths the sharing of a candidate is checked against, one bit of a mask each
+constexpr size_t kMaxSharedPaths = 64;
+
+// The edges of the paths already chosen, each with the mask of the paths it is on
+struct shared_edges_t {
+  midgard::flat_map<baldr::GraphId, uint64_t> paths;
+  size_t path_count = 0;
+};
+
 float get_max_sharing(const valhalla::Location& origin, const valhalla::Location& destination);
 
 void filter_alternates_by_stretch(std::vector<CandidateConnection>& connections);
@@ -13,7 +24,7 @@ void filter_alternates_by_stretch(std::vector<CandidateConnection>& connections)
 bool validate_alternate_by_stretch(const std::vector<PathInfo>& optimal_path,
                                    const std::vector<PathInfo>& candidate_path);
 
-bool validate_alternate_by_sharing(std::vector<std::unordered_set<baldr::GraphId>>& shared_edgeids,
+bool validate_alternate_by_sharing(shared_edges_t& shared_edges,
                                    const std::vector<std::vector<PathInfo>>& paths,
                                    const std::vector<PathInfo>& candidate_path,
                                    float at_most_shared);
@@ -65,6 +65,12 @@ public:
   virtual const char* name() const override {
     return "a*_bike_share_station";
   }
+  virtual size_t LabelCount() const override {
+    return edgelabels_.size();
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_.redistributions();
+  }
 
   /**
    * Clear the temporary information generated during path construction.
@@ -1,6 +1,13 @@
 #ifndef VALHALLA_THOR_ASTARHEURISTIC_H_
 #define VALHALLA_THOR_ASTARHEURISTIC_H_
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/landmarkdistances.h>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -17,7 +24,7 @@ public:
   /**
    * Constructor.
    */
-  AStarHeuristic() : distapprox_({}), costfactor_(1.0f) {
+  AStarHeuristic() : distapprox_({}), costfactor_(1.0f), landmarks_(nullptr) {
   }
 
   /**
@@ -33,6 +40,34 @@ public:
   void Init(const midgard::PointLL& ll, const float factor) {
     distapprox_.SetTestPoint(ll);
     costfactor_ = factor;
+    landmarks_ = nullptr;
+  }
+
+  /**
+   * Tightens the heuristic of the nodes in the landmark distances until the next Init. The
+   * destination must be within the given distance of one of the targets, so every place the path
+   * can end has to be covered by them.
+   * @param  landmarks  Landmark distances, see baldr/landmarkdistances.h.
+   * @param  targets    The distances from the landmarks of nodes near the destination, each with
+   *                    how far the destination is from the node at most.
+   */
+  void SetLandmarks(const baldr::LandmarkDistances* landmarks,
+                    const std::vector<std::pair<const uint32_t*, float>>& targets) {
+    landmarks_ = landmarks;
+    lower_.assign(landmarks->landmark_count(), std::numeric_limits<double>::max());
+    upper_.assign(landmarks->landmark_count(), std::numeric_limits<double>::lowest());
+    for (uint32_t k = 0; k < landmarks->landmark_count(); ++k) {
+      for (const auto& target : targets) {
+        // the landmark says nothing about the destination if it can't reach it
+        if (target.first[k] == baldr::LandmarkDistances::kUnreachable) {
+          lower_[k] = std::numeric_limits<double>::lowest();
+          upper_[k] = std::numeric_limits<double>::max();
+          break;
+        }
+        lower_[k] = std::min<double>(lower_[k], target.first[k] - target.second);
+        upper_[k] = std::max<double>(upper_[k], target.first[k] + target.second);
+      }
+    }
   }
 
   /**
@@ -77,10 +112,53 @@ public:
     return dist * costfactor_;
   }
 
+  /**
+   * Get the A* heuristic given the lat,lng of a node, tightened with the landmark distances of the
+   * node if they are set. The distance returned via the argument is the one to the lat,lng.
+   * @param   ll          Lat,lng of the node
+   * @param   node        The node
+   * @param   node_count  Number of nodes in the tile of the node
+   * @param   dist        Distance (meters) to the destination.
+   * @return  Returns an estimate of the cost to the destination.
+   *          For A* shortest path this MUST UNDERESTIMATE the true cost.
+   */
+  float Get(const midgard::PointLL& ll,
+            const baldr::GraphId& node,
+            const uint32_t node_count,
+            float& dist) const {
+    dist = sqrtf(distapprox_.DistanceSquared(ll));
+    if (!landmarks_) {
+      return dist * costfactor_;
+    }
+    return std::max(dist, LandmarkDistance(node, node_count)) * costfactor_;
+  }
+
 private:
+  /**
+   * The largest lower bound of the distance to the destination of the landmarks.
+   */
+  float LandmarkDistance(const baldr::GraphId& node, const uint32_t node_count) const {
+    const auto* distances = landmarks_->get(node, node_count);
+    if (!distances) {
+      return 0.f;
+    }
+    double bound = 0;
+    for (uint32_t k = 0; k < landmarks_->landmark_count(); ++k) {
+      if (distances[k] != baldr::LandmarkDistances::kUnreachable) {
+        bound = std::max({bound, lower_[k] - distances[k], distances[k] - upper_[k]});
+      }
+    }
+    return static_cast<float>(bound);
+  }
+
   midgard::DistanceApproximator<midgard::PointLL> distapprox_; // Distance approximation
   float costfactor_; // Cost factor - ensures the cost estimate
                      // underestimates the true cost.
+
+  // Landmark distances and per landmark the range of the distances of the destination
+  const baldr::LandmarkDistances* landmarks_;
+  std::vector<double> lower_;
+  std::vector<double> upper_;
 };
 
 } // namespace thor
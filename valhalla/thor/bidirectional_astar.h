@@ -78,12 +78,29 @@ public:
   virtual const char* name() const override {
     return "bidirectional_a*";
   }
+  virtual size_t LabelCount() const override {
+    return edgelabels_forward_.size() + edgelabels_reverse_.size();
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_forward_.redistributions() + adjacencylist_reverse_.redistributions();
+  }
+  virtual size_t HierarchyPrunedCount() const override {
+    return hierarchy_pruned_;
+  }
 
   /**
    * Clear the temporary information generated during path construction.
    */
   void Clear() override;
 
+  /**
+   * Sets the landmark distances which tighten the A* heuristics of the searches.
+   * @param  landmarks  Landmark distances of the graph, nullptr to use the distance alone.
+   */
+  void set_landmarks(std::shared_ptr<const baldr::LandmarkDistances> landmarks) {
+    landmarks_ = std::move(landmarks);
+  }
+
 protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
@@ -101,11 +118,14 @@ protected:
   std::vector<sif::HierarchyLimits> hierarchy_limits_forward_;
   std::vector<sif::HierarchyLimits> hierarchy_limits_reverse_;
   bool ignore_hierarchy_limits_;
+  // How many expansions the hierarchy limits cut off in either direction
+  size_t hierarchy_pruned_;
 
   // A* heuristic
   float cost_diff_;
   AStarHeuristic astarheuristic_forward_;
   AStarHeuristic astarheuristic_reverse_;
+  std::shared_ptr<const baldr::LandmarkDistances> landmarks_;
 
   // Vector of edge labels (requires access by index).
   std::vector<sif::BDEdgeLabel> edgelabels_forward_;
@@ -229,6 +249,8 @@ protected:
    * @param   origin       The origin location
    * @param   destination  The destination location
    * @param   time_info    What time is it when we start the route
+   * @param   reverse_time_info  What time is it when we end the route, the start is derived from
+   *                             it for routes which only have a time at the destination
    * @return  Returns the path infos, a list of GraphIds representing the
    *          directed edges along the path - ordered from origin to
    *          destination - along with travel modes and elapsed time.
@@ -237,7 +259,8 @@ protected:
                                               const Options& options,
                                               const valhalla::Location& origin,
                                               const valhalla::Location& dest,
-                                              const baldr::TimeInfo& time_info);
+                                              const baldr::TimeInfo& time_info,
+                                              const baldr::TimeInfo& reverse_time_info);
 
   /**
    * Modify default (optimized for unidirectional search) hierarchy limits.
@@ -0,0 +1,199 @@
+#ifndef VALHALLA_THOR_BIDIRECTIONAL_ASTAR_BSS_H_
+#define VALHALLA_THOR_BIDIRECTIONAL_ASTAR_BSS_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+#include <valhalla/thor/astarheuristic.h>
+#include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/pathinfo.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Bidirectional A* for bike share routes. Both searches start walking and may switch between
+ * walking and cycling at bike share stations, each search keeps the labels of both modes apart.
+ * The searches connect on an edge reached in the same mode by both of them.
+ */
+class BidirectionalAStarBSS : public PathAlgorithm {
+public:
+  /**
+   * Constructor.
+   * @param config A config object of key, value pairs
+   */
+  explicit BidirectionalAStarBSS(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Destructor
+   */
+  virtual ~BidirectionalAStarBSS();
+
+  /**
+   * Form path between and origin and destination location walking and riding shared bikes.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  mode_costing  An array of costing methods, one per TravelMode.
+   * @param  mode     Travel mode from the origin.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const sif::mode_costing_t& mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  /**
+   * Returns the name of the algorithm
+   * @return the name of the algorithm
+   */
+  virtual const char* name() const override {
+    return "bidirectional_a*_bike_share_station";
+  }
+  virtual size_t LabelCount() const override {
+    return edgelabels_forward_.size() + edgelabels_reverse_.size();
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_forward_.redistributions() + adjacencylist_reverse_.redistributions();
+  }
+
+  /**
+   * Clear the temporary information generated during path construction.
+   */
+  void Clear() override;
+
+protected:
+  // Costing of each mode
+  std::shared_ptr<sif::DynamicCost> pedestrian_costing_;
+  std::shared_ptr<sif::DynamicCost> bicycle_costing_;
+
+  // A* heuristic for the forward and reverse search
+  AStarHeuristic astarheuristic_forward_;
+  AStarHeuristic astarheuristic_reverse_;
+
+  // Vector of edge labels (requires access by index).
+  std::vector<sif::BDEdgeLabel> edgelabels_forward_;
+  std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
+
+  // Adjacency list for forward and reverse search
+  baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_forward_;
+  baldr::DoubleBucketQueue<sif::BDEdgeLabel> adjacencylist_reverse_;
+
+  // Edge status of each mode for the forward and reverse search
+  EdgeStatus pedestrian_edgestatus_forward_;
+  EdgeStatus bicycle_edgestatus_forward_;
+  EdgeStatus pedestrian_edgestatus_reverse_;
+  EdgeStatus bicycle_edgestatus_reverse_;
+
+  // Threshold to stop the search once a connection has been found, and the difference of the A*
+  // heuristics at the origin so the sort costs of both searches compare
+  float cost_threshold_;
+  float cost_diff_;
+
+  // Where the origin and destination are along their edges
+  std::unordered_map<uint64_t, float> origin_percents_;
+  std::unordered_map<uint64_t, float> destination_percents_;
+
+  // Best connection found so far, on an edge reached in the same mode by both searches
+  CandidateConnection best_connection_;
+  sif::TravelMode connection_mode_;
+
+  /**
+   * Initialize the A* heuristics and adjacency lists for both the forward
+   * and reverse search.
+   * @param  origll  Lat,lng of the origin.
+   * @param  destll  Lat,lng of the destination.
+   */
+  void Init(const midgard::PointLL& origll, const midgard::PointLL& destll);
+
+  /**
+   * The costing and edge status of a mode in one search direction.
+   */
+  const std::shared_ptr<sif::DynamicCost>& costing(const sif::TravelMode mode) const {
+    return mode == sif::TravelMode::kPedestrian ? pedestrian_costing_ : bicycle_costing_;
+  }
+  EdgeStatus& edgestatus(const bool forward, const sif::TravelMode mode) {
+    if (forward) {
+      return mode == sif::TravelMode::kPedestrian ? pedestrian_edgestatus_forward_
+                                                  : bicycle_edgestatus_forward_;
+    }
+    return mode == sif::TravelMode::kPedestrian ? pedestrian_edgestatus_reverse_
+                                                : bicycle_edgestatus_reverse_;
+  }
+
+  /**
+   * Expand from a node in the forward direction in the given mode, and in the other mode too when
+   * the node is a bike share station unless this is called for that.
+   */
+  void ExpandForward(baldr::GraphReader& graphreader,
+                     const baldr::GraphId& node,
+                     const sif::BDEdgeLabel& pred,
+                     const uint32_t pred_idx,
+                     const sif::TravelMode mode,
+                     const bool from_transition,
+                     const bool from_bss);
+
+  /**
+   * Expand from a node in the reverse direction in the given mode, and in the other mode too when
+   * the node is a bike share station unless this is called for that.
+   */
+  void ExpandReverse(baldr::GraphReader& graphreader,
+                     const baldr::GraphId& node,
+                     const sif::BDEdgeLabel& pred,
+                     const uint32_t pred_idx,
+                     const baldr::DirectedEdge* opp_pred_edge,
+                     const sif::TravelMode mode,
+                     const bool from_transition,
+                     const bool from_bss);
+
+  /**
+   * Add edges at the origin to the forward adjacency list, walking.
+   */
+  void SetOrigin(baldr::GraphReader& graphreader, valhalla::Location& origin);
+
+  /**
+   * Add destination edges to the reverse path adjacency list, walking.
+   */
+  void SetDestination(baldr::GraphReader& graphreader, const valhalla::Location& dest);
+
+  /**
+   * The edge of a label of one search is reached in the same mode by the other search. Keeps the
+   * connection if it is the best so far and lowers the cost threshold.
+   */
+  void SetConnection(baldr::GraphReader& graphreader,
+                     const sif::BDEdgeLabel& fwd_pred,
+                     const sif::BDEdgeLabel& rev_pred);
+
+  /**
+   * Cost of the whole path through a connection, a negative cost if the origin and destination are
+   * on the edge of the connection but the wrong way around.
+   */
+  sif::Cost ConnectionCost(baldr::GraphReader& graphreader,
+                           const sif::BDEdgeLabel& fwd_pred,
+                           const sif::BDEdgeLabel& rev_pred);
+
+  /**
+   * Form the path from the best connection.
+   */
+  std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_BIDIRECTIONAL_ASTAR_BSS_H_
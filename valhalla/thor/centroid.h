@@ -1,11 +1,18 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <limits>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <functional>
 #include <utility>
 #include <vector>
 
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/midgard/flat_hash.h>
 #include <valhalla/midgard/util.h>
 #include <valhalla/sif/costconstants.h>
 #include <valhalla/sif/dynamiccost.h>
@@ -80,6 +87,64 @@ template <> struct hash<valhalla::thor::PathIntersection> {
 namespace valhalla {
 namespace thor {
 
+/**
+ * The edges settled by the expansions of groups of locations running on separate threads. The map
+ * is split into shards with a lock each so the threads rarely wait on each other. Once an edge is
+ * settled by all locations the most expensive of its paths bounds the cost up to which the
+ * expansions need to go, the edge with the cheapest such path is the centroid.
+ */
+class SharedIntersections {
+public:
+  /**
+   * @param location_count  the number of paths we are tracking
+   */
+  explicit SharedIntersections(uint8_t location_count);
+
+  /**
+   * Adds an edge settled by a path
+   * @param edge_id  the settled edge
+   * @param opp_id   its opposing edge
+   * @param path_id  the index of the location whose path settled it
+   * @param cost     the cost of the path to it
+   */
+  void AddPath(uint64_t edge_id, uint64_t opp_id, uint8_t path_id, float cost);
+
+  /**
+   * @return the cost beyond which settling more edges cannot lead to a better centroid
+   */
+  float bound() const {
+    return bound_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Makes all expansions stop, e.g. when one of them failed
+   */
+  void Stop() {
+    bound_ = std::numeric_limits<float>::lowest();
+  }
+
+  /**
+   * @return the best intersection so far, with the paths that reached it
+   */
+  PathIntersection best() const {
+    std::lock_guard<std::mutex> lock(best_mutex_);
+    return best_;
+  }
+
+protected:
+  struct shard_t {
+    std::mutex mutex;
+    // the intersection and the cost of the most expensive path to it
+    midgard::flat_map<uint64_t, std::pair<PathIntersection, float>> intersections;
+  };
+  std::array<shard_t, 64> shards_;
+  uint8_t location_count_;
+
+  mutable std::mutex best_mutex_;
+  PathIntersection best_;
+  std::atomic<float> bound_;
+};
+
 /**
  * TODO: explain this better and more accurately, the claim about minimum isnt quite accurate
  * A best first (dijkstras) path algorithm which given a set of locations, will find the set of paths
@@ -91,6 +156,29 @@ namespace thor {
  */
 class Centroid : public thor::Dijkstras {
 public:
+  /**
+   * Constructor.
+   * @param config  A config object of key, value pairs, with matrix_threads more than 1 the
+   *                locations are expanded in groups on that many threads
+   */
+  explicit Centroid(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Sets the graph readers used by the extra threads, one reader per thread. These should share a
+   * tile cache (global_synchronized_cache).
+   * @param readers  one reader per extra thread, only as many threads as readers are used
+   */
+  void set_thread_readers(const std::vector<std::shared_ptr<baldr::GraphReader>>& readers) {
+    thread_readers_ = readers;
+  }
+
+  /**
+   * @return the number of threads the locations may be expanded on, including the calling thread
+   */
+  uint32_t thread_count() const {
+    return 1 + static_cast<uint32_t>(std::min(workers_.size(), thread_readers_.size()));
+  }
+
   /**
    * Returns a path for each location to a common intersection point (centroid) of all locations paths
    * such that each path is the shortest path to that common intersection point
@@ -166,13 +254,32 @@ protected:
   std::vector<std::vector<PathInfo>>
   FormPaths(const ExpansionType& expansion_type,
             const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
-            const label_container_t& labels,
+            label_container_t Dijkstras::*labels,
             baldr::GraphReader& reader,
             valhalla::Location& centroid) const;
 
+  /**
+   * Expands the locations in groups, one per thread, each group's expansion interleaving the paths
+   * of its locations like a single expansion does. The expansions share the settled edges and stop
+   * once they are beyond the cost of the best centroid so far.
+   */
+  template <const ExpansionType expansion_direction>
+  void ComputeGroups(google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+                     baldr::GraphReader& reader,
+                     const sif::mode_costing_t& costings,
+                     const sif::TravelMode mode,
+                     const uint32_t group_count);
+
+  /**
+   * @return the expansion of a group of locations, the first group is this expansion itself
+   */
+  const Centroid& group(const uint8_t group) const {
+    return group == 0 ? *this : *workers_[group - 1];
+  }
+
   // the key is the edge id and the value is the label indices for each location
   // we store both directions of the edge to avoid strange uturns at the centroid
-  std::unordered_set<PathIntersection> intersections_;
+  midgard::flat_set<PathIntersection> intersections_;
 
   // track the best intersection so far so we can return partial results
   PathIntersection best_intersection_{baldr::kInvalidGraphId, baldr::kInvalidGraphId,
@@ -180,6 +287,18 @@ protected:
 
   // number of paths we are tracking
   uint8_t location_count_;
+
+  // Expansions (each with their own labels, queue and edge status) and readers for the extra
+  // threads which expand groups of the locations
+  std::vector<std::unique_ptr<Centroid>> workers_;
+  std::vector<std::shared_ptr<baldr::GraphReader>> thread_readers_;
+
+  // when the locations are expanded in groups, the edges settled by all groups, the number of
+  // groups and which one this expansion is. location i is path i / group_count_ of group
+  // i % group_count_
+  SharedIntersections* shared_ = nullptr;
+  uint8_t group_count_ = 1;
+  uint8_t group_ = 0;
 };
 
 } // namespace thor
@@ -0,0 +1,265 @@
+#ifndef VALHALLA_THOR_CONNECTION_SCAN_H_
+#define VALHALLA_THOR_CONNECTION_SCAN_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/proto/common.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+#include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/pathinfo.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Transit routing over the timetable rather than over the graph. The departures of the transit
+ * lines around the origin and destination are flattened into connections, each a ride from one
+ * stop to the next, which are scanned once in order of departure. Walking only happens to the
+ * stops near the origin, from the stops near the destination and between stops when changing
+ * lines, each a short pedestrian search. Routes are the earliest arrival, the costing only decides
+ * which walks and transit lines may be used.
+ *
+ * With alternates it answers a profile query: the scan is repeated for each later departure within
+ * an hour of the requested time, latest first, keeping the arrival times of the later runs. Every
+ * run which gets to the destination earlier than all of the later departures adds a journey, the
+ * alternates are the ones leaving soonest after the requested time.
+ */
+class ConnectionScan : public PathAlgorithm {
+public:
+  /**
+   * Constructor.
+   * @param config A config object of key, value pairs
+   */
+  explicit ConnectionScan(const boost::property_tree::ptree& config = {});
+
+  /**
+   * Destructor
+   */
+  virtual ~ConnectionScan();
+
+  /**
+   * Form the earliest arriving multi-modal path between the origin and destination. With
+   * alternates in the options the journeys leaving after it which arrive earlier than any leaving
+   * later than them are returned too.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  mode_costing  An array of costing methods, one per TravelMode.
+   * @param  mode     Travel mode from the origin.
+   * @param  options  The request options
+   * @return  Returns the path edges (and elapsed time/modes at end of each edge) of each journey.
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const sif::mode_costing_t& mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  /**
+   * Returns the name of the algorithm
+   * @return the name of the algorithm
+   */
+  virtual const char* name() const override {
+    return "ConnectionScan";
+  }
+  virtual size_t LabelCount() const override {
+    return walk_labels_.size() + scanned_;
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_.redistributions();
+  }
+
+  /**
+   * Clear the temporary information generated during path construction.
+   */
+  void Clear() override;
+
+protected:
+  // How a stop, or the destination, was reached
+  enum class Via : uint8_t { kNone, kAccess, kRide, kWalk };
+
+  // The earliest time at a stop and how it was reached. After a ride it names the connection it
+  // got off at and the one the trip was boarded at, after a walk the stop it came from and the walk
+  // label at this stop, from the origin only that walk label
+  struct reach_t {
+    uint32_t time = baldr::kInvalidLabel;
+    Via via = Via::kNone;
+    uint32_t first = baldr::kInvalidLabel;
+    uint32_t second = baldr::kInvalidLabel;
+  };
+
+  // A stop and the earliest times at it. Trips can be boarded once a transfer has been made, so
+  // the earliest time to board is kept apart from the earliest time to get off at the stop
+  struct stop_t {
+    baldr::GraphId node;
+    reach_t arrival;
+    reach_t boarding;
+  };
+
+  // A ride on one run of a trip from a stop to the next
+  struct connection_t {
+    uint32_t departure; // seconds from midnight leaving the from stop
+    uint32_t arrival;   // seconds from midnight getting to the to stop
+    uint32_t from;      // index of the stop it leaves
+    uint32_t to;        // index of the stop it gets to
+    uint64_t run;       // the trip and, for frequency schedules, which run of it
+    uint32_t tripid;
+    baldr::GraphId edgeid; // the transit line edge it rides
+  };
+
+  // A walk between stops
+  struct footpath_t {
+    uint32_t to;    // index of the stop it gets to
+    uint32_t secs;  // walking time
+    uint32_t label; // the walk label at the stop it gets to
+  };
+
+  uint32_t max_walking_dist_;
+  uint32_t max_transfer_distance_;
+  uint32_t start_time_;
+
+  // Seconds to make a transfer, at the same stop, entering a stop from the street and entering a
+  // stop after walking from another one
+  uint32_t stay_secs_;
+  uint32_t enter_secs_;
+  uint32_t transfer_secs_;
+
+  // Labels of every walk of the request. Each walk has its own run of labels
+  std::vector<sif::EdgeLabel> walk_labels_;
+  baldr::DoubleBucketQueue<sif::EdgeLabel> adjacencylist_;
+  EdgeStatus edgestatus_;
+
+  // Destinations, id and cost
+  std::unordered_map<uint64_t, sif::Cost> destinations_;
+
+  // The stops with connections and the connections sorted by departure
+  std::vector<stop_t> stops_;
+  std::unordered_map<uint64_t, uint32_t> stop_index_;
+  std::vector<connection_t> connections_;
+  size_t scanned_;
+
+  // The runs of trips boarded in the current scan and the connection each was boarded at
+  std::unordered_map<uint64_t, uint32_t> boarded_;
+
+  // Walking from the stops near the destination. The time and the walk label at each stop, the
+  // labels of this walk run backwards from the destination
+  std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> egress_;
+
+  // Walking between stops, found the first time a stop is got off at
+  std::unordered_map<uint32_t, std::vector<footpath_t>> footpaths_;
+
+  // The earliest arrival at the destination and the stop it was walked to from, kInvalidLabel if
+  // walked to from the origin
+  uint32_t best_time_;
+  uint32_t best_stop_;
+
+  // Walking from the origin straight to the destination
+  uint32_t direct_time_;
+  uint32_t direct_label_;
+
+  /**
+   * Walks from the labels in the adjacency list until the distance runs out. Stops are not walked
+   * through, the first label to get to each stop is kept.
+   * @param  graphreader   Graph reader
+   * @param  pc            Pedestrian costing
+   * @param  max_distance  Meters the walk may cover
+   * @param  reached       Filled with the walk label at each stop node it reached
+   */
+  void Walk(baldr::GraphReader& graphreader,
+            const sif::cost_ptr_t& pc,
+            const uint32_t max_distance,
+            std::unordered_map<uint64_t, uint32_t>& reached);
+
+  /**
+   * Adds the edges leaving a node to the adjacency list, the edges of the end nodes of its
+   * transitions too unless this is called from a transition.
+   */
+  void ExpandWalk(baldr::GraphReader& graphreader,
+                  const baldr::GraphId& node,
+                  const sif::EdgeLabel& pred,
+                  const uint32_t pred_idx,
+                  const sif::cost_ptr_t& pc,
+                  const uint32_t max_distance,
+                  const bool from_transition);
+
+  /**
+   * Walks from the origin to the stops around it, and to the destination if it is close enough.
+   */
+  std::unordered_map<uint64_t, uint32_t> WalkFromOrigin(baldr::GraphReader& graphreader,
+                                                        valhalla::Location& origin,
+                                                        const valhalla::Location& destination,
+                                                        const sif::cost_ptr_t& pc);
+
+  /**
+   * Walks backwards from the destination to the stops around it.
+   */
+  void WalkToDestination(baldr::GraphReader& graphreader,
+                         const valhalla::Location& destination,
+                         const sif::cost_ptr_t& pc);
+
+  /**
+   * Gets the footpaths from a stop to the other stops within the transfer distance.
+   */
+  const std::vector<footpath_t>&
+  Footpaths(baldr::GraphReader& graphreader, const sif::cost_ptr_t& pc, const uint32_t stop);
+
+  /**
+   * Flattens the departures of the transit lines in the box which run on the day of the request,
+   * are allowed by the transit costing and leave between the start and the end, into connections.
+   */
+  void LoadConnections(baldr::GraphReader& graphreader,
+                       const midgard::AABB2<midgard::PointLL>& box,
+                       const sif::cost_ptr_t& tc,
+                       const std::string& date_time,
+                       const uint32_t end_time);
+
+  /**
+   * Index of the stop at a node, adding the stop if it is new.
+   */
+  uint32_t StopIndex(const baldr::GraphId& node);
+
+  /**
+   * Scans the connections leaving from the given time on, relaxing the footpaths and the walks to
+   * the destination of every stop got off at earlier than before.
+   */
+  void Scan(baldr::GraphReader& graphreader, const sif::cost_ptr_t& pc, const uint32_t from_time);
+
+  /**
+   * Lowers the times at a stop, returns true if the arrival time was lowered.
+   */
+  bool Reach(const uint32_t stop, const reach_t& arrival, const uint32_t boarding_delay);
+
+  /**
+   * Follows the labels back from the destination to the origin.
+   */
+  std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader);
+
+  /**
+   * Appends the edges of a walk, its labels are followed back from the given one.
+   * @param  reverse  Whether the labels walk backwards from the destination
+   */
+  void AppendWalk(baldr::GraphReader& graphreader,
+                  const uint32_t label,
+                  const uint32_t start_time,
+                  const bool reverse,
+                  std::vector<PathInfo>& path);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CONNECTION_SCAN_H_
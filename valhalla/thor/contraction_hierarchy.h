@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Contraction hierarchy over a directed graph with fixed edge weights.
+ *
+ * Nodes are contracted one by one in order of importance (edge difference plus the number of
+ * already contracted neighbors). Whenever removing a node would lengthen a shortest path between
+ * two of its neighbors a shortcut arc is added in its place, unless a bounded witness search finds
+ * a path around it that is no longer. The result answers shortest path queries with two small
+ * searches which only ever go up in the hierarchy, and shortcuts are unpacked back into the
+ * original edges afterwards.
+ *
+ * The weights are fixed at preprocessing time, so this only suits one costing with fixed options
+ * and no time dependence. Turn costs and restrictions are not modeled.
+ */
+class ContractionHierarchy {
+public:
+  static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+  // An edge of the input graph. The id is whatever the caller uses to identify the edge (a GraphId
+  // value for example) and is what is handed back when paths are unpacked
+  struct Edge {
+    uint32_t from;
+    uint32_t to;
+    float weight;
+    uint64_t id;
+  };
+
+  // The result of a query. Edges holds the ids of the original edges along the path in order
+  struct Path {
+    float cost;
+    std::vector<uint64_t> edges;
+  };
+
+  ContractionHierarchy() = default;
+
+  /**
+   * Contracts the given graph.
+   * @param node_count        number of nodes, edges refer to them by index in [0, node_count)
+   * @param edges             the edges of the graph, weights must be finite and non-negative
+   * @param max_witness_nodes maximum number of nodes settled by one witness search. Lower values
+   *                          build faster but may add superfluous shortcuts
+   * @return the contracted hierarchy
+   */
+  static ContractionHierarchy
+  Build(uint32_t node_count, const std::vector<Edge>& edges, uint32_t max_witness_nodes = 500);
+
+  /**
+   * Loads a hierarchy written by Write.
+   * @param file  path of the file to read
+   * @return the hierarchy
+   */
+  static ContractionHierarchy Read(const std::string& file);
+
+  /**
+   * Writes the hierarchy to a file so that it need not be contracted again.
+   * @param file  path of the file to write
+   */
+  void Write(const std::string& file) const;
+
+  /**
+   * Finds the shortest path between two nodes.
+   * @param source  index of the origin node
+   * @param target  index of the destination node
+   * @param path    on success the cost and the original edges along the path
+   * @return true if the target can be reached from the source
+   */
+  bool Query(uint32_t source, uint32_t target, Path& path) const;
+
+  /**
+   * @return the number of nodes in the hierarchy
+   */
+  uint32_t node_count() const {
+    return static_cast<uint32_t>(rank_.size());
+  }
+
+  /**
+   * @return the number of shortcut arcs added during contraction
+   */
+  uint32_t shortcut_count() const {
+    return shortcut_count_;
+  }
+
+  /**
+   * @param node  index of the node
+   * @return the position of the node in the contraction order, higher means more important
+   */
+  uint32_t rank(uint32_t node) const {
+    return rank_[node];
+  }
+
+protected:
+  // An original edge or a shortcut. Shortcuts refer to the two arcs they replace, originals keep
+  // the id of the edge
+  struct Arc {
+    uint32_t from;
+    uint32_t to;
+    float weight;
+    uint32_t first;  // first arc of a shortcut, kInvalidIndex if this is an original edge
+    uint32_t second; // second arc of a shortcut
+    uint64_t id;
+  };
+
+  // Search from the source along arcs leading up in rank (forward) or from the target along arcs
+  // arriving from higher ranked nodes (backward). Both are kept as offsets into an index array
+  void BuildSearchGraph();
+
+  // Appends the original edges of an arc to the path
+  void Unpack(uint32_t arc, std::vector<uint64_t>& edges) const;
+
+  std::vector<uint32_t> rank_;
+  std::vector<Arc> arcs_;
+  std::vector<uint32_t> up_offsets_;
+  std::vector<uint32_t> up_arcs_;
+  std::vector<uint32_t> down_offsets_;
+  std::vector<uint32_t> down_arcs_;
+  uint32_t shortcut_count_ = 0;
+};
+
+} // namespace thor
+} // namespace valhalla
@@ -2,6 +2,7 @@
 #define VALHALLA_THOR_COSTMATRIX_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -16,6 +17,7 @@
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/matrix_common.h>
+#include <valhalla/thor/pathalgorithm.h>
 #include <valhalla/thor/pathinfo.h>
 
 namespace valhalla {
@@ -94,6 +96,12 @@ public:
    * @param  mode                  Travel mode to use.
    * @param  max_matrix_distance   Maximum arc-length distance for current mode.
    * @return time/distance from origin index to all other locations
+   *
+   * With more sources or targets than costmatrix_block_size the matrix is computed one block of
+   * at most that many sources and targets at a time, so that only the labels of a block are held
+   * at once. The blocks are shared out to the threads when matrix_threads is more than 1. A matrix
+   * computed whole with at least costmatrix_parallel_locations sources and targets instead shares
+   * out the steps of the searches of each direction to the threads.
    */
   std::vector<TimeDistance>
   SourceToTarget(google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
@@ -105,12 +113,45 @@ public:
                  const bool has_time = false,
                  const bool invariant = false);
 
+  /**
+   * Returns how many edge labels the last matrix created on all of its threads, it is reported with
+   * its timing
+   * @return the number of edge labels
+   */
+  size_t LabelCount() const {
+    size_t count = label_count_;
+    for (const auto& worker : workers_) {
+      count += worker->label_count_;
+    }
+    return count;
+  }
+
   /**
    * Clear the temporary information generated during time+distance
    * matrix construction.
    */
   void clear();
 
+  /**
+   * Sets the graph readers used by the extra threads computing blocks or searching when
+   * matrix_threads is more than 1. Each thread needs a reader of its own, these should share a tile
+   * cache.
+   * @param readers  one reader per extra thread, only as many threads as readers are used
+   */
+  void set_thread_readers(const std::vector<std::shared_ptr<baldr::GraphReader>>& readers) {
+    thread_readers_ = readers;
+  }
+
+  /**
+   * Set a callback that will throw when the matrix computation should be aborted. Only the calling
+   * thread calls it, the extra threads stop once it throws.
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
 protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
@@ -123,6 +164,9 @@ protected:
 
   uint32_t max_reserved_labels_count_;
 
+  // Edge labels the searches of the current matrix created on this thread
+  size_t label_count_;
+
   // Number of source and target locations that can be expanded
   uint32_t source_count_;
   uint32_t remaining_sources_;
@@ -156,6 +200,73 @@ protected:
   // when doing timezone differencing a timezone cache speeds up the computation
   baldr::DateTime::tz_sys_info_cache_t tz_cache_;
 
+  // Most sources and targets computed at once, larger matrices are split into blocks. 0 computes
+  // every matrix whole
+  uint32_t block_size_;
+
+  // Extra matrices and their graph readers for computing blocks in parallel
+  std::vector<std::unique_ptr<CostMatrix>> workers_;
+  std::vector<std::shared_ptr<baldr::GraphReader>> thread_readers_;
+
+  // Threads searching a matrix computed whole and the fewest sources plus targets to use them for
+  uint32_t matrix_threads_;
+  uint32_t parallel_locations_;
+
+  // While the searches of one direction run in parallel the status of the other direction and the
+  // marked target edges are shared between them. Their updates are kept by the location searching
+  // and made in the order of the locations once the step is done, see Expand
+  bool deferred_;
+  std::vector<std::vector<std::pair<uint32_t, int>>> deferred_status_;
+  std::vector<std::vector<baldr::GraphId>> deferred_targets_;
+
+  // the function to periodically call to see if the computation should be aborted
+  const std::function<void()>* interrupt_;
+
+  /**
+   * Computes the whole matrix between the sources and targets in one go, see SourceToTarget.
+   */
+  std::vector<TimeDistance>
+  ComputeMatrix(google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                baldr::GraphReader& graphreader,
+                const sif::mode_costing_t& mode_costing,
+                const sif::travel_mode_t mode,
+                const float max_matrix_distance,
+                const bool has_time,
+                const bool invariant,
+                const uint32_t threads = 1);
+
+  /**
+   * Runs one step of the searches of every source or every target. With more than one slot the
+   * steps are shared out to this thread and idle threads of the shared pool, each with a graph
+   * reader of its own, and finished one location after the other once they are all done.
+   * Otherwise each step is finished right after it. Either way the outcome is the same.
+   * @param  count        the number of sources or targets
+   * @param  slots        the most threads to use
+   * @param  graphreader  the graph reader of this thread
+   * @param  search       runs the step of a location with the reader of its thread
+   * @param  finish       makes the updates of a location which touch the other locations
+   */
+  void Expand(const uint32_t count,
+              const uint32_t slots,
+              baldr::GraphReader& graphreader,
+              const std::function<void(uint32_t, baldr::GraphReader&)>& search,
+              const std::function<void(uint32_t)>& finish);
+
+  /**
+   * Computes the matrix between the sources and targets block by block, on this thread and the
+   * workers, and puts the blocks together, see SourceToTarget.
+   */
+  std::vector<TimeDistance>
+  ComputeBlocks(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                baldr::GraphReader& graphreader,
+                const sif::mode_costing_t& mode_costing,
+                const sif::travel_mode_t mode,
+                const float max_matrix_distance,
+                const bool has_time,
+                const bool invariant);
+
   /**
    * Get the cost threshold based on the current mode and the max arc-length distance
    * for that mode.
@@ -195,10 +306,28 @@ protected:
 
   /**
    * Update status when a connection is found.
-   * @param  source  Source index
-   * @param  target  Target index
+   * @param  source   Source index
+   * @param  target   Target index
+   * @param  forward  Whether the forward search found it, the status of the other direction waits
+   *                  while the searches run in parallel
+   */
+  void UpdateStatus(const uint32_t source, const uint32_t target, const bool forward);
+
+  /**
+   * Removes the target from the locations the source has left to find.
+   * @param  source     Source index
+   * @param  target     Target index
+   * @param  threshold  The threshold the source continues with if it was the last one
+   */
+  void UpdateSourceStatus(const uint32_t source, const uint32_t target, const int threshold);
+
+  /**
+   * Removes the source from the locations the target has left to find.
+   * @param  source     Source index
+   * @param  target     Target index
+   * @param  threshold  The threshold the target continues with if it was the last one
    */
-  void UpdateStatus(const uint32_t source, const uint32_t target);
+  void UpdateTargetStatus(const uint32_t source, const uint32_t target, const int threshold);
 
   /**
    * Iterate the backward search from the target/destination location.
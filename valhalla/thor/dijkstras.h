@@ -50,6 +50,16 @@ public:
    */
   virtual void Clear();
 
+  /**
+   * Clear the temporary memory and release what is otherwise kept reserved for the next expansion
+   */
+  void Release() {
+    const bool clear_reserved_memory = clear_reserved_memory_;
+    clear_reserved_memory_ = true;
+    Clear();
+    clear_reserved_memory_ = clear_reserved_memory;
+  }
+
   /**
    * Compute the best first graph traversal from a list locations
    * @param expansion_type  What type of expansion should be run
@@ -76,6 +86,15 @@ public:
     expansion_callback_ = expansion_callback;
   }
 
+  /**
+   * Set a callback that will throw when the expansion should be aborted
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
 protected:
   /**
    * Compute the best first graph traversal from a list of origin locations
@@ -163,7 +182,8 @@ protected:
   // separately from the other paths
   bool multipath_;
 
-  // TODO: add an interrupt here so that the caller can abort the main loop externally
+  // the function to periodically call to see if the expansion should be aborted
+  const std::function<void()>* interrupt_;
 
   /**
    * Initialization prior to computing the graph expansion
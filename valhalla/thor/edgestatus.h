@@ -1,8 +1,10 @@
 #pragma once
 
-#include <unordered_map>
+#include <vector>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
+#include <valhalla/midgard/flat_hash.h>
 
 // handy macro for shifting the 7bit path index value so that it can be or'd with the tile/level id
 #define SHIFT_path_id(x) (static_cast<uint32_t>(x) << 25u)
@@ -50,6 +52,11 @@ struct EdgeStatusInfo {
  * edges within arrays for each tile. This allows the path algorithms to get
  * a pointer to the first edge status and iterate that pointer over sequential
  * edges. This reduces the number of map lookups.
+ *
+ * The arrays are kept around between searches and are stamped with the generation of the search
+ * which last initialized them. Clearing just bumps the generation, an array from an older
+ * generation is treated as if it didn't exist and is only re-initialized when it's touched again.
+ * How much memory is kept around this way is bounded by the reservation passed to clear().
  */
 class EdgeStatus {
 public:
@@ -58,29 +65,29 @@ public:
    */
   EdgeStatus() = default;
 
-  // in order no to delete objects twice in destructor we should explicitly
-  // forbid copying
+  // the cached lookup points into the arrays so copying would leave it dangling
   EdgeStatus(const EdgeStatus&) = delete;
   EdgeStatus& operator=(const EdgeStatus&) = delete;
   EdgeStatus(EdgeStatus&&) = default;
   EdgeStatus& operator=(EdgeStatus&&) = default;
 
   /**
-   * Destructor. Delete any allocated EdgeStatusInfo arrays.
-   */
-  ~EdgeStatus() {
-    clear();
-  }
-
-  /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Reset the status of all edges. The per tile arrays are kept for reuse by the next search as
+   * long as they hold no more than the reserved amount of edge statuses in total, otherwise they
+   * are released.
+   * @param  reservation  maximum number of edge statuses to keep allocated for reuse
    */
-  void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto& iter : edgestatus_) {
-      delete[] iter.second;
+  void clear(const size_t reservation = 0) {
+    last_statuses_ = nullptr;
+    if (reserved_ > reservation) {
+      edgestatus_.clear();
+      reserved_ = 0;
+    }
+    // when the generation wraps around we can no longer tell the old arrays apart
+    if (++generation_ == 0) {
+      edgestatus_.clear();
+      reserved_ = 0;
     }
-    edgestatus_.clear();
   }
 
   /**
@@ -98,16 +105,7 @@ public:
            const graph_tile_ptr& tile,
            const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    Acquire(edgeid.tile_value() | SHIFT_path_id(path_id), tile)[edgeid.id()] = {set, index};
   }
 
   /**
@@ -120,9 +118,9 @@ public:
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
+    auto* statuses = Find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    if (statuses) {
+      statuses[edgeid.id()].set_ = static_cast<uint32_t>(set);
     } else {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
@@ -137,8 +135,24 @@ public:
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid, const uint8_t path_id = 0) const {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const auto* statuses = Find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    return statuses ? statuses[edgeid.id()] : EdgeStatusInfo();
+  }
+
+  /**
+   * Get the status info of a directed edge without remembering the tile it is in, so that many
+   * threads can look at the status of a search which is not running at the time.
+   * @param   edgeid     GraphId of the directed edge.
+   * @param  path_id     Identifies which path the edge status belongs to when tracking multiple paths
+   * @return  Returns edge status info.
+   */
+  EdgeStatusInfo GetShared(const baldr::GraphId& edgeid, const uint8_t path_id = 0) const {
+    assert(path_id <= baldr::kMaxMultiPathId);
+    auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
+    if (p == edgestatus_.end() || p->second.generation != generation_) {
+      return EdgeStatusInfo();
+    }
+    return p->second.statuses[edgeid.id()];
   }
 
   /**
@@ -154,23 +168,73 @@ public:
   EdgeStatusInfo*
   GetPtr(const baldr::GraphId& edgeid, const graph_tile_ptr& tile, const uint8_t path_id = 0) {
     assert(path_id <= baldr::kMaxMultiPathId);
-    const auto p = edgestatus_.find(edgeid.tile_value() | SHIFT_path_id(path_id));
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value() | SHIFT_path_id(path_id),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
-    }
+    return &Acquire(edgeid.tile_value() | SHIFT_path_id(path_id), tile)[edgeid.id()];
   }
 
 private:
+  struct TileStatus {
+    uint32_t generation = 0;
+    std::vector<EdgeStatusInfo> statuses;
+  };
+
+  /**
+   * Finds the statuses of a tile if they were initialized during the current generation.
+   * @param  key  the tile and path id
+   * @return pointer to the first status in the tile or nullptr if it wasn't touched yet
+   */
+  EdgeStatusInfo* Find(const uint32_t key) const {
+    // consecutive lookups mostly hit the same tile so skip the hashing for those
+    if (last_statuses_ && last_key_ == key) {
+      return last_statuses_;
+    }
+    auto p = edgestatus_.find(key);
+    if (p == edgestatus_.end() || p->second.generation != generation_) {
+      return nullptr;
+    }
+    last_key_ = key;
+    last_statuses_ = p->second.statuses.data();
+    return last_statuses_;
+  }
+
+  /**
+   * Finds the statuses of a tile, (re)initializing them if they weren't touched during the current
+   * generation.
+   * @param  key   the tile and path id
+   * @param  tile  graph tile used to size the array
+   * @return pointer to the first status in the tile
+   */
+  EdgeStatusInfo* Acquire(const uint32_t key, const graph_tile_ptr& tile) {
+    if (auto* statuses = Find(key)) {
+      return statuses;
+    }
+    // either a brand new tile or one left over from a previous generation
+    auto& tile_status = edgestatus_[key];
+    const size_t count = tile->header()->directededgecount();
+    reserved_ += count;
+    reserved_ -= tile_status.statuses.size();
+    tile_status.generation = generation_;
+    tile_status.statuses.assign(count, EdgeStatusInfo());
+    last_key_ = key;
+    last_statuses_ = tile_status.statuses.data();
+    return last_statuses_;
+  }
+
   // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
-  // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  // values are arrays of EdgeStatusInfo (sized based on the directed edge
+  // count within the tile) along with the generation they belong to. The
+  // map is flat so its entries move when it grows, the arrays they own don't.
+  // Lookups from const methods hand out pointers to the arrays, hence mutable.
+  mutable midgard::flat_map<uint32_t, TileStatus> edgestatus_;
+
+  // The last tile we looked up and its array, only ever one of the current generation
+  mutable uint32_t last_key_ = 0;
+  mutable EdgeStatusInfo* last_statuses_ = nullptr;
+
+  // Generation of the current search
+  uint32_t generation_ = 0;
+
+  // Total number of edge statuses held by all arrays
+  size_t reserved_ = 0;
 };
 
 } // namespace thor
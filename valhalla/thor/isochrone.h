@@ -1,6 +1,7 @@
 #ifndef VALHALLA_THOR_ISOCHRONE_H_
 #define VALHALLA_THOR_ISOCHRONE_H_
 
+#include <array>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -41,6 +42,12 @@ public:
   virtual ~Isochrone() {
   }
 
+  /**
+   * Clear the temporary memory, the blocks of the grid are kept for the next isochrone up to
+   * the reserved count.
+   */
+  virtual void Clear() override;
+
   /**
    * Compute an isochrone grid. This creates and populates a lat,lon grid with
    * time taken to reach each grid point. This gridded data is then contoured
@@ -71,6 +78,23 @@ public:
     inner_expansion_callback_ = callback;
   }
 
+  /**
+   * Fills out the nearest location of each cell of the grid which the last expansion reached
+   * within the largest contour. The nearest location is only tracked when the request asks for
+   * catchments, it is decided on time if the request has time contours and on distance if not.
+   *
+   * @param catchments  the raster, cropped to the cells which were reached
+   */
+  void Catchments(valhalla::Isochrone::Catchments& catchments) const;
+
+  /**
+   * Fills out the time and distance to each cell of the grid of the last expansion, cells which
+   * were not reached within the largest contour of a metric get -1 for it.
+   *
+   * @param raster  the raster, cropped to the cells which were reached
+   */
+  void Raster(valhalla::Isochrone::Raster& raster) const;
+
 protected:
   // when we expand up to a node we color the cells of the grid that the edge that ends at the
   // node touches
@@ -93,8 +117,47 @@ protected:
   float max_seconds_;
   float max_meters_;
   std::shared_ptr<midgard::GriddedData<2>> isotile_;
+  // reused to find the cells crossed by each segment of the shapes
+  std::vector<midgard::PointLL> segment_;
+  std::vector<midgard::Tiles<midgard::PointLL>::cell_t> crossed_cells_;
+  size_t max_reserved_grid_blocks_;
+  std::array<float, 2> contour_limits_; // the largest time and distance contours, -1 if none
   expansion_callback_t inner_expansion_callback_;
 
+  // For catchments the location each label comes from and the nearest location of each cell
+  std::unique_ptr<midgard::GriddedData<1>> catchments_;
+  size_t catchment_metric_; // which dimension of the isotile decides the nearest location
+  ExpansionType expansion_type_;
+  uint32_t location_; // the location the label being expanded comes from
+  std::vector<uint32_t> label_locations_;
+  // the locations at the edges of the labels the expansion starts with, in the order of the labels
+  std::unordered_map<baldr::GraphId, std::pair<std::vector<uint32_t>, size_t>> seed_locations_;
+
+  /**
+   * Prepares tracking the nearest location of each cell if the request asks for catchments.
+   * @param  api            Request information
+   * @param  reader         Graph reader to find opposing edges with
+   * @param  expansion_type Which type of expansion is about to run
+   */
+  void InitializeCatchments(const valhalla::Api& api,
+                            baldr::GraphReader& reader,
+                            const ExpansionType expansion_type);
+
+  /**
+   * @param  label  a label of the expansion
+   * @return the index of the location the label comes from
+   */
+  uint32_t LocationOf(const sif::EdgeLabel& label);
+
+  /**
+   * Sets the time and distance of a cell if they are less than what it has, for catchments the
+   * cell also takes the location being expanded if that decreased the metric they are decided on.
+   * @param  tile_id  the cell to set
+   * @param  minutes  the time to reach the cell
+   * @param  km       the distance to reach the cell
+   */
+  void MarkTile(const int tile_id, const float minutes, const float km);
+
   /**
    * Constructs the isotile - 2-D gridded data containing the time
    * to get to each lat,lng tile.
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <valhalla/sif/costconstants.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Learns how many edge labels the searches of a path algorithm create for the straight line
+ * distance between their locations, per travel mode, so that the next search reserves about what
+ * it will need up front. A short route then doesn't reserve for a long one and a long route
+ * doesn't grow (and copy) its labels over and over while it expands.
+ *
+ * The labels per kilometer of each mode are a running mean over the first searches and a moving
+ * average after that, so they follow the tiles and requests of the deployment.
+ */
+class LabelReservation {
+public:
+  // Searches of a mode before their statistics are trusted, the fallback is reserved until then
+  static constexpr uint64_t kWarmupSearches = 8;
+  // Reserved on top of the estimate so that searches a bit above the average don't grow
+  static constexpr float kHeadroom = 1.25f;
+  // Never reserve less than this
+  static constexpr uint32_t kMinReservation = 1024;
+
+  struct stats_t {
+    uint64_t searches = 0;
+    double labels_per_km = 0;
+  };
+
+  /**
+   * How many labels a search is expected to create, with some headroom.
+   * @param  mode      travel mode of the search
+   * @param  distance  straight line distance between the locations in meters
+   * @param  fallback  what to reserve while the mode has too few searches to go by
+   * @param  ceiling   the most that may be reserved
+   * @return the number of labels to reserve
+   */
+  uint32_t Estimate(const sif::travel_mode_t mode,
+                    const float distance,
+                    const uint32_t fallback,
+                    const uint32_t ceiling) {
+    last_mode_ = mode;
+    last_distance_ = distance;
+    const auto& stats = stats_[index(mode)];
+    const double estimate = stats.searches < kWarmupSearches
+                                ? fallback
+                                : stats.labels_per_km * (distance / 1000. + 1.) * kHeadroom;
+    return static_cast<uint32_t>(
+        std::min<double>(std::max<double>(estimate, kMinReservation), ceiling));
+  }
+
+  /**
+   * Learns from the search the last estimate was made for, a search without labels (one which
+   * didn't run or was already recorded) is left out.
+   * @param  labels  how many labels the search created
+   */
+  void Record(const size_t labels) {
+    if (labels == 0 || last_distance_ < 0) {
+      return;
+    }
+    auto& stats = stats_[index(last_mode_)];
+    const double labels_per_km = labels / (last_distance_ / 1000. + 1.);
+    ++stats.searches;
+    const double weight = 1. / std::min(stats.searches, kWarmupSearches);
+    stats.labels_per_km += (labels_per_km - stats.labels_per_km) * weight;
+    last_distance_ = -1;
+  }
+
+  /**
+   * @param  mode  travel mode
+   * @return what was learned about the searches of the mode so far
+   */
+  const stats_t& stats(const sif::travel_mode_t mode) const {
+    return stats_[index(mode)];
+  }
+
+protected:
+  static size_t index(const sif::travel_mode_t mode) {
+    return std::min<size_t>(static_cast<size_t>(mode), kModeCount - 1);
+  }
+
+  static constexpr size_t kModeCount = static_cast<size_t>(sif::travel_mode_t::kMaxTravelMode);
+
+  std::array<stats_t, kModeCount> stats_{};
+  sif::travel_mode_t last_mode_ = sif::travel_mode_t::kDrive;
+  float last_distance_ = -1;
+};
+
+} // namespace thor
+} // namespace valhalla
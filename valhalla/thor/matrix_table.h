@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <valhalla/midgard/sequence.h>
+#include <valhalla/proto/options.pb.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * The times and distances between all pairs of a fixed set of locations, e.g. the depots and the
+ * delivery zones of a fleet, worked out ahead of time by valhalla_build_matrix_table. A matrix with
+ * some of these locations looks the pairs of them up and only searches for the others.
+ *
+ * A table is for one costing with its options. Its first bucket is the matrix without a departure
+ * time, the others are those departing at the start of each slot of the week (on predicted speeds)
+ * which serve the departures closest to them.
+ *
+ * The file is this header, the locations sorted by their coordinates and then the buckets, each a
+ * row per source location with an entry per target location.
+ */
+class MatrixTable {
+public:
+  static constexpr uint64_t kVersion = 1;
+  // no route was found between the two locations
+  static constexpr uint32_t kUnreachable = 0xffffffff;
+
+  struct header_t {
+    uint64_t version;
+    // the Key of the options the table was built with
+    uint64_t costing;
+    uint32_t location_count;
+    uint32_t bucket_count;
+    // the length of the departure slots, 0 without any
+    uint32_t bucket_seconds;
+    uint32_t spare;
+  };
+
+  // in millionths of a degree
+  struct location_t {
+    int32_t lat;
+    int32_t lon;
+
+    bool operator<(const location_t& other) const {
+      return lat < other.lat || (lat == other.lat && lon < other.lon);
+    }
+    bool operator==(const location_t& other) const {
+      return lat == other.lat && lon == other.lon;
+    }
+  };
+
+  struct entry_t {
+    uint32_t time; // seconds
+    uint32_t dist; // meters
+  };
+
+  /**
+   * Maps a table written by valhalla_build_matrix_table.
+   * @param  file_name  The file with the table.
+   * @return Returns the table, nullptr if the file is not complete or not of this version.
+   */
+  static std::shared_ptr<const MatrixTable> Map(const std::string& file_name);
+
+  /**
+   * Writes a table.
+   * @param  file_name       The file to write.
+   * @param  costing         The Key of the options the table was built with.
+   * @param  bucket_seconds  The length of the departure slots, 0 without any.
+   * @param  locations       The locations, each only once.
+   * @param  buckets         For each bucket the entries of every source and target location pair
+   *                         in the order of the locations, all the targets of a source together.
+   * @return Returns true if the table was written.
+   */
+  static bool Write(const std::string& file_name,
+                    const uint64_t costing,
+                    const uint32_t bucket_seconds,
+                    const std::vector<location_t>& locations,
+                    const std::vector<std::vector<entry_t>>& buckets);
+
+  /**
+   * The key of the costing of a request and its options, tables only answer requests with the key
+   * they were built with.
+   */
+  static uint64_t Key(const Options& options);
+
+  /**
+   * @return the coordinates of a location as they are kept in tables
+   */
+  static location_t Round(const valhalla::Location& location);
+
+  uint64_t costing() const {
+    return costing_;
+  }
+
+  uint32_t bucket_count() const {
+    return bucket_count_;
+  }
+
+  /**
+   * @return the index of a location in the table, -1 if it isn't in it
+   */
+  int32_t Find(const valhalla::Location& location) const;
+
+  /**
+   * Gets the bucket which serves a departure.
+   * @param  date_time  The local departure time (e.g. 2024-05-06T08:30), empty for none.
+   * @return Returns the bucket, -1 if the table has none for the departure.
+   */
+  int32_t Bucket(const std::string& date_time) const;
+
+  const entry_t& Get(const uint32_t bucket, const uint32_t source, const uint32_t target) const {
+    return entries_[(static_cast<uint64_t>(bucket) * location_count_ + source) * location_count_ +
+                    target];
+  }
+
+protected:
+  MatrixTable() = default;
+
+  midgard::mem_map<char> mapped_;
+  uint64_t costing_;
+  uint32_t location_count_;
+  uint32_t bucket_count_;
+  uint32_t bucket_seconds_;
+  const location_t* locations_;
+  const entry_t* entries_;
+};
+
+} // namespace thor
+} // namespace valhalla
@@ -67,6 +67,12 @@ public:
   virtual const char* name() const override {
     return "Multimodal";
   }
+  virtual size_t LabelCount() const override {
+    return edgelabels_.size();
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_.redistributions();
+  }
 
   /**
    * Clear the temporary information generated during path construction.
@@ -2,6 +2,7 @@
 #define VALHALLA_THOR_OPTIMIZER_H_
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <random>
 #include <vector>
@@ -9,35 +10,43 @@
 namespace valhalla {
 namespace thor {
 
-// Annealing factor - the rate at which temperature is reduced between each
-// annealing step. Recommend setting this to a value between 0.85 and 0.95.
-// Cool too slowly and the probability of escaping local optima decreases and
-// setting too high takes longer to converge on a solution.
-constexpr float kCoolingRate = 0.93f;
-
-// Alteration type.
-// kRotate  - Alters a portion of the tour by rotating the locations about
-//            a middle point. The middle location becomes the new start
-//            location in the range.
-// kReverse - Alters the tour by reversing the locations in the tour between
-//            a start and end location.
-enum AlterationType { kRotate, kReverse };
-
-// Simple structure with 3 values describing a possible tour alteration
-struct TourAlteration {
-  uint32_t start;     // Index of 1st location
-  uint32_t mid;       // Index of middle location (for rotate)
-  uint32_t end;       // Index of 2nd location
-  AlterationType alt; // Type of alteration
-};
+// Number of tours that are built and improved by local search, the first one
+// is the plain nearest neighbor tour and the others are randomized versions of
+// it. The best of them is returned.
+constexpr uint32_t kDefaultOptimizerStarts = 16;
+
+// Randomized starts pick the next location among this many nearest ones
+constexpr uint32_t kNearestCandidates = 3;
+
+// Longest run of consecutive locations moved at once by Or-opt
+constexpr uint32_t kMaxOrOptLength = 3;
+
+// Smallest cost change considered an improvement, avoids cycling on float noise
+constexpr float kMinImprovement = 1e-3f;
 
 /**
- * Optimization method using simulated annealing. Optimizes the order of
- * locations - keeping the first location (origin) and last location
- * (destination) fixed.
+ * Optimizes the order of locations - keeping the first location (origin) and
+ * last location (destination) fixed. Each start builds a tour with a nearest
+ * neighbor heuristic and improves it with 2-opt and Or-opt moves until no move
+ * lowers its cost. Starts can run on several threads and stop early once the
+ * time budget is spent.
  */
 class Optimizer {
 public:
+  /**
+   * Constructor.
+   * @param  threads      Number of threads to run the starts on.
+   * @param  max_time_ms  Time budget in milliseconds, 0 means no limit. Once spent no
+   *                      more starts are run and the best tour so far is returned.
+   * @param  starts       Number of tours to build and improve.
+   */
+  Optimizer(const uint32_t threads = 1,
+            const uint32_t max_time_ms = 0,
+            const uint32_t starts = kDefaultOptimizerStarts)
+      : threads_(std::max(threads, 1u)), max_time_ms_(max_time_ms),
+        starts_(std::max(starts, 1u)), seed_(std::random_device{}()) {
+  }
+
   /**
    * Optimize the tour through a set of locations given the cost matrix
    * among all locations. The first location (origin) and last location
@@ -50,55 +59,63 @@ public:
   std::vector<uint32_t> Solve(const uint32_t count, const std::vector<float>& costs);
 
   /**
-   * Seed the random number generator. This is used by tests to create a
-   * repeatable sequence.
+   * Seed the random number generators of the randomized starts. This is used
+   * by tests to create a repeatable sequence.
    * @param  seed  Seed to use for the random number generator.
    */
   void Seed(const uint32_t seed) {
-    random_generator_.seed(seed);
+    seed_ = seed;
   }
 
 protected:
-  // Random number generation: 0 <= r < 1
-  std::mt19937_64 random_generator_;
-  std::uniform_real_distribution<float> uniform_distribution_{0.0, 1.0};
-
-  uint32_t ntry_;                   // # of attempts (for debugging)
-  uint32_t count_;                  // # of locations
-  uint32_t attempts_;               // # of attempts per annealing cycle
-  uint32_t successes_;              // # of success per annealing cycle
-  float best_cost_;                 // Current best cost
-  std::vector<uint32_t> tour_;      // Current tour (order of locations)
-  std::vector<uint32_t> best_tour_; // Best tour so far
-
-  /*
-   * Perform the annealing process.
-   * @param  costs        2-D cost matrix.
-   * @param  temperature  Current temperature.
-   * @return Returns number of successes.
+  using clock_t = std::chrono::steady_clock;
+
+  uint32_t threads_;     // # of threads to run the starts on
+  uint32_t max_time_ms_; // Time budget, 0 for none
+  uint32_t starts_;      // # of tours built and improved
+  uint32_t seed_;        // Seed of the randomized starts
+  uint32_t count_;       // # of locations
+
+  /**
+   * Build a tour with a nearest neighbor heuristic. The destination is only
+   * appended once all the other locations are visited.
+   * @param  costs   2-D cost matrix.
+   * @param  random  Random number generator to pick among the nearest candidates,
+   *                 the plain nearest neighbor tour is built if null.
+   * @return Returns the tour.
    */
-  uint32_t Anneal(const std::vector<float>& costs, float temperature);
+  std::vector<uint32_t> NearestNeighborTour(const std::vector<float>& costs,
+                                            std::mt19937* random) const;
 
   /**
-   * Select a potential alteration of the tour.
-   * @return  Returns a candidate tour alteration: type and location indexes.
+   * Improve a tour with 2-opt and Or-opt moves until neither finds a better
+   * tour or the deadline passes.
+   * @param  costs     2-D cost matrix.
+   * @param  tour      Tour to improve in place.
+   * @param  deadline  Time after which the search stops, ignored without a time budget.
    */
-  TourAlteration GetTourAlteration();
+  void LocalSearch(const std::vector<float>& costs,
+                   std::vector<uint32_t>& tour,
+                   const clock_t::time_point& deadline) const;
 
   /**
-   * Get the temperature difference (based on change in tour cost) given
-   * an alteration to the tour.
-   * @param  costs       2-D cost matrix.
-   * @param  alteration  Tour alteration.
-   * @return Returns the cost difference.
+   * Apply the first improving 2-opt move found: reverse the locations between
+   * two positions. The costs are not assumed to be symmetric so the reversed
+   * part of the tour is costed in its new direction.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve in place.
+   * @return Returns true if the tour was improved.
    */
-  float TemperatureDifference(const std::vector<float>& costs, const TourAlteration& alteration);
+  bool TwoOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
 
   /**
-   * Create a random initial tour. The first and last locations must remain
-   * fixed as the tour begin and end locations do not change.
+   * Apply the first improving Or-opt move found: move a run of up to
+   * kMaxOrOptLength consecutive locations elsewhere in the tour.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve in place.
+   * @return Returns true if the tour was improved.
    */
-  void CreateRandomTour();
+  bool OrOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
 
   /**
    * Get the cost for the specified tour (order of locations).
@@ -120,23 +137,6 @@ protected:
   float Cost(const std::vector<float>& costs, const uint32_t loc1, const uint32_t loc2) const {
     return costs[(loc1 * count_) + loc2];
   }
-
-  /**
-   * Get a random location. Makes sure it isn't the first or last location
-   * (which are fixed).
-   * @return  Returns the index of a random location.
-   */
-  uint32_t get_random_location() {
-    return static_cast<uint32_t>(r01() * (count_ - 2) + 1);
-  }
-
-  /**
-   * Convenience method to return a random floating point value: 0 <= r < 1
-   * @return  Returns a random value between 0 and 1.
-   */
-  float r01() {
-    return uniform_distribution_(random_generator_);
-  }
 };
 
 } // namespace thor
@@ -13,6 +13,7 @@
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/label_reservation.h>
 #include <valhalla/thor/pathinfo.h>
 
 namespace valhalla {
@@ -72,11 +73,51 @@ public:
    */
   virtual const char* name() const = 0;
 
+  /**
+   * Returns how many edge labels the last expansion created, it is reported with its timing
+   * @return the number of edge labels
+   */
+  virtual size_t LabelCount() const = 0;
+
+  /**
+   * Returns how many times the last expansion refilled its queue from the overflow bucket
+   * @return the number of queue redistributions
+   */
+  virtual size_t QueueRedistributions() const = 0;
+
+  /**
+   * Returns how many expansions the hierarchy limits cut off during the last search, it stays 0
+   * for algorithms which do not use them
+   * @return the number of edges pruned by the hierarchy limits
+   */
+  virtual size_t HierarchyPrunedCount() const {
+    return 0;
+  }
+
+  /**
+   * Returns what the algorithm learned about how many edge labels its searches need
+   * @return the label reservation statistics per travel mode
+   */
+  const LabelReservation& label_reservation() const {
+    return label_reservation_;
+  }
+
   /**
    * Clear the temporary information generated during path construction.
    */
   virtual void Clear() = 0;
 
+  /**
+   * Clear the temporary information and release the memory otherwise kept reserved for the next
+   * path construction.
+   */
+  void Release() {
+    const bool clear_reserved_memory = clear_reserved_memory_;
+    clear_reserved_memory_ = true;
+    Clear();
+    clear_reserved_memory_ = clear_reserved_memory;
+  }
+
   /**
    * Set a callback that will throw when the path computation should be aborted
    * @param interrupt_callback  the function to periodically call to see if
@@ -150,6 +191,9 @@ protected:
   // if `true` clean reserved memory for edge labels
   bool clear_reserved_memory_;
 
+  // sizes the edge labels of a search from the distance between its locations
+  LabelReservation label_reservation_;
+
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
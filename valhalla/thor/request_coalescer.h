@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <valhalla/proto/api.pb.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Lets identical requests which are in flight at the same time wait on a single computation rather
+ * than each searching the graph, retries and dashboards often send the same request many times
+ * within milliseconds. Requests are identical when their keys are, see ResponseCache::key. Unlike
+ * the response cache nothing is kept once the computation is done, the next identical request
+ * computes its response again, so no answer is ever older than the request it is given to.
+ *
+ * The requests in flight are shared by every worker of the process.
+ */
+class RequestCoalescer {
+public:
+  /**
+   * @return true if identical concurrent requests of the action may share their response
+   */
+  static bool coalescable(const Api& request);
+
+  /**
+   * Computes the response of the request unless an identical request is already computing it, in
+   * which case its response is waited for instead. When that computation fails with an error of
+   * the request itself the error is rethrown, when it was interrupted or timed out the response is
+   * computed again, by the first of the waiting requests while the others wait on that one.
+   * @param key        the key of the request
+   * @param compute    computes the response of the request
+   * @param interrupt  called while waiting, it throws when the request should stop waiting
+   * @param shared     set to whether the response was computed for another request
+   * @return the response of the request
+   */
+  static std::string share(const std::string& key,
+                           const std::function<std::string()>& compute,
+                           const std::function<void()>* interrupt,
+                           bool& shared);
+};
+
+} // namespace thor
+} // namespace valhalla
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <valhalla/proto/api.pb.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Remembers the responses of recent route, optimized route and matrix requests so that identical
+ * requests, retries or dashboards asking for the same origins and destinations, are answered without
+ * searching again. Requests are keyed by their options, including the locations loki correlated to
+ * the graph, and the warnings loki attached, which end up in the response. Requests leaving at the
+ * current time are not cached since their answer changes with the clock.
+ *
+ * The tiles do not change under a running worker but live traffic does, so the owner should clear
+ * the cache whenever traffic is updated. Entries may also expire after a time to live. The cache is
+ * bounded by the bytes of its keys and responses and drops the least recently used entries first.
+ */
+class ResponseCache {
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * @param max_size  maximum number of bytes of keys and responses kept, 0 disables the cache
+   * @param ttl       seconds after which an entry is no longer served, 0 for no limit
+   */
+  explicit ResponseCache(size_t max_size = 0, uint32_t ttl = 0) : max_size_(max_size), ttl_(ttl) {
+  }
+
+  /**
+   * @return true if the cache is enabled and the request may be answered from it
+   */
+  bool cacheable(const Api& request) const;
+
+  /**
+   * @return the key of the request, its deterministically serialized options but for the deadline
+   * and its warnings
+   */
+  static std::string key(const Api& request);
+
+  /**
+   * @return the cached response for the key or nullptr if there is none or it expired. The pointer
+   * is valid until the next insert or clear
+   */
+  const std::string* find(const std::string& key);
+
+  /**
+   * Remembers the response to the request with this key, evicting the least recently used entries
+   * to make room for it. Responses larger than the whole cache are not kept
+   */
+  void insert(const std::string& key, std::string response);
+
+  void clear() {
+    index_.clear();
+    entries_.clear();
+    bytes_ = 0;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  size_t bytes() const {
+    return bytes_;
+  }
+
+protected:
+  struct entry_t {
+    std::string key;
+    std::string response;
+    clock_t::time_point expires;
+  };
+
+  void erase(std::list<entry_t>::iterator entry);
+
+  size_t max_size_;
+  uint32_t ttl_;
+  size_t bytes_{};
+  // most recently used first, the index points into the list nodes which never move
+  std::list<entry_t> entries_;
+  std::unordered_map<std::string_view, std::list<entry_t>::iterator> index_;
+};
+
+} // namespace thor
+} // namespace valhalla
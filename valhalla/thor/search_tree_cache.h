@@ -0,0 +1,153 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/time_info.h>
+#include <valhalla/proto/options.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/matrix_common.h>
+#include <valhalla/thor/timedistancematrix.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * The reverse search of a many to one TimeDistanceMatrix from its target, kept so that it can be
+ * asked about other sources later. The search only grows as far as the sources asked about need it
+ * to, so sources which moved a little since the last time are mostly answered from the edges it
+ * already settled and otherwise from a few more. The answers are those a TimeDistanceMatrix from
+ * scratch would give, the search just does not start over.
+ */
+class SearchTree : public TimeDistanceMatrix {
+public:
+  /**
+   * Sets the target up, nothing is expanded until the tree is queried
+   * @param  target               the target location, correlated to the graph
+   * @param  costing              the costing of the search, it must not change while the tree lives
+   * @param  mode                 travel mode of the costing
+   * @param  max_matrix_distance  maximum arc-length distance for the mode
+   * @param  invariant            whether invariant time was requested
+   * @param  graphreader          to look up the timezone of the target and its edges
+   */
+  SearchTree(const valhalla::Location& target,
+             const std::shared_ptr<sif::DynamicCost>& costing,
+             const sif::travel_mode_t mode,
+             const float max_matrix_distance,
+             const bool invariant,
+             baldr::GraphReader& graphreader);
+
+  /**
+   * Finds the time and distance from each of the sources to the target, growing the search until
+   * they are all settled or it runs out of edges within the cost threshold.
+   * @param  sources      the source locations, correlated to the graph
+   * @param  graphreader  to expand the search with
+   * @return time/distance from each source to the target in the order of the sources
+   */
+  std::vector<TimeDistance>
+  Query(const google::protobuf::RepeatedPtrField<valhalla::Location>& sources,
+        baldr::GraphReader& graphreader);
+
+  /**
+   * @return the number of edge labels of the search so far
+   */
+  size_t size() const {
+    return edgelabels_.size();
+  }
+
+protected:
+  /**
+   * Settles the next edge of the search and expands from it
+   * @return the index of the label settled or kInvalidLabel when the search can't grow any more
+   */
+  uint32_t Grow(baldr::GraphReader& graphreader);
+
+  valhalla::Location target_;
+  baldr::TimeInfo time_info_;
+  bool invariant_;
+
+  // cost of the last label settled, every edge cheaper than it was settled already
+  float frontier_;
+  // whether the adjacency list ran out or the cost threshold was reached
+  bool exhausted_;
+  // origin labels are not marked permanent in the edge status so the settled ones are kept here
+  std::unordered_map<uint64_t, std::vector<uint32_t>> origin_labels_;
+};
+
+/**
+ * Keeps the search trees of the single target matrix requests of a worker between requests, so
+ * that asking about the same target with sources which moved, like a fleet of vehicles to a
+ * pickup every few seconds, does not search from scratch every time. Trees are keyed by their
+ * target and costing, expire after a time to live and the least recently used ones are dropped
+ * to keep at most the configured number of them.
+ *
+ * Like the response cache the owner should clear it whenever traffic is updated.
+ */
+class SearchTreeCache {
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  /**
+   * @param max_trees  most trees kept, 0 disables the cache
+   * @param ttl        seconds after which a tree is no longer used, 0 for no limit
+   */
+  explicit SearchTreeCache(size_t max_trees = 0, uint32_t ttl = 0)
+      : max_trees_(max_trees), ttl_(ttl) {
+  }
+
+  /**
+   * @return true if the cache is enabled and the matrix is a many to one the trees can answer
+   */
+  bool cacheable(const Options& options) const;
+
+  /**
+   * @return the key of the tree of the matrix, its target, costing and time options
+   */
+  static std::string key(const Options& options);
+
+  /**
+   * @return the tree with this key or nullptr if there is none or it expired. The pointer is valid
+   * until the next insert or clear
+   */
+  SearchTree* find(const std::string& key);
+
+  /**
+   * Keeps the tree under this key, dropping the least recently used ones to make room for it
+   * @return the tree
+   */
+  SearchTree* insert(const std::string& key, std::unique_ptr<SearchTree> tree);
+
+  void clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+protected:
+  struct entry_t {
+    std::string key;
+    std::unique_ptr<SearchTree> tree;
+    clock_t::time_point expires;
+  };
+
+  void erase(std::list<entry_t>::iterator entry);
+
+  size_t max_trees_;
+  uint32_t ttl_;
+  // most recently used first, the index points into the list nodes which never move
+  std::list<entry_t> entries_;
+  std::unordered_map<std::string_view, std::list<entry_t>::iterator> index_;
+};
+
+} // namespace thor
+} // namespace valhalla
@@ -79,8 +79,8 @@ public:
    */
   inline void clear() {
     auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-    if (edgelabels_.size() > reservation) {
-      edgelabels_.resize(max_reserved_labels_count_);
+    if (edgelabels_.capacity() > reservation) {
+      edgelabels_.resize(reservation);
       edgelabels_.shrink_to_fit();
     }
     reset();
@@ -88,6 +88,26 @@ public:
     dest_edges_.clear();
   };
 
+  /**
+   * Clear the temporary information and release the memory otherwise kept reserved for the next
+   * matrix.
+   */
+  void release() {
+    const bool clear_reserved_memory = clear_reserved_memory_;
+    clear_reserved_memory_ = true;
+    clear();
+    clear_reserved_memory_ = clear_reserved_memory;
+  }
+
+  /**
+   * Set a callback that will throw when the matrix computation should be aborted
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
 protected:
   // Number of destinations that have been found and settled (least cost path
   // computed).
@@ -124,13 +144,16 @@ protected:
   // has a vector of indexes into the destinations vector
   std::unordered_map<uint64_t, std::vector<uint32_t>> dest_edges_;
 
+  // the function to periodically call to see if the computation should be aborted
+  const std::function<void()>* interrupt_;
+
   /**
    * Reset all origin-specific information
    */
   inline void reset() {
     auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-    if (edgelabels_.size() > reservation) {
-      edgelabels_.resize(max_reserved_labels_count_);
+    if (edgelabels_.capacity() > reservation) {
+      edgelabels_.resize(reservation);
       edgelabels_.shrink_to_fit();
     }
     edgelabels_.clear();
@@ -143,8 +166,8 @@ protected:
     adjacencylist_.clear();
 
     // Clear the edge status flags
-    pedestrian_edgestatus_.clear();
-    bicycle_edgestatus_.clear();
+    pedestrian_edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
+    bicycle_edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
   };
 
   /**
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_THOR_TIMEDISTANCEMATRIX_H_
 #define VALHALLA_THOR_TIMEDISTANCEMATRIX_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -74,21 +75,106 @@ public:
     }
   };
 
+  /**
+   * Forms a time distance matrix from the set of source locations to the set of target locations
+   * for each of the departure times. The locations are only correlated once, every source at
+   * every departure time is a row of its own and the rows of all the times are shared out to the
+   * threads together.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @param  departure_times       The times to depart from the sources at.
+   * @param  matrix_locations      Number of matrix locations to satisfy a one to many request.
+   *
+   * @return time/distance from all sources to all targets departing at the first time, followed by
+   *         those departing at the second time and so on
+   */
+  std::vector<TimeDistance>
+  SourceToTargetAtTimes(
+      const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+      google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                        baldr::GraphReader& graphreader,
+                        const sif::mode_costing_t& mode_costing,
+                        const sif::travel_mode_t mode,
+                        const float max_matrix_distance,
+                        const google::protobuf::RepeatedPtrField<std::string>& departure_times,
+                        const uint32_t matrix_locations = kAllLocations);
+
+  /**
+   * Returns how many edge labels the last matrix created on all of its threads, it is reported with
+   * its timing
+   * @return the number of edge labels
+   */
+  size_t LabelCount() const {
+    size_t count = label_count_;
+    for (const auto& worker : workers_) {
+      count += worker->label_count_;
+    }
+    return count;
+  }
+
   /**
    * Clear the temporary information generated during time+distance
    * matrix construction.
    */
   inline void clear() {
     auto reservation = clear_reserved_memory_ ? 0 : max_reserved_labels_count_;
-    if (edgelabels_.size() > reservation) {
-      edgelabels_.resize(max_reserved_labels_count_);
+    if (edgelabels_.capacity() > reservation) {
+      edgelabels_.resize(reservation);
       edgelabels_.shrink_to_fit();
     }
     reset();
     destinations_.clear();
     dest_edges_.clear();
+    for (auto& worker : workers_) {
+      worker->clear();
+    }
   };
 
+  /**
+   * Clear the temporary information and release the memory otherwise kept reserved for the next
+   * matrix, that of the workers of the extra threads too.
+   */
+  void release() {
+    const bool clear_reserved_memory = clear_reserved_memory_;
+    clear_reserved_memory_ = true;
+    clear();
+    clear_reserved_memory_ = clear_reserved_memory;
+    for (auto& worker : workers_) {
+      worker->release();
+    }
+  }
+
+  /**
+   * Sets the graph readers used by the extra threads when matrix_threads is more than 1. Each
+   * thread needs a reader of its own, these should share a tile cache (global_synchronized_cache)
+   * so the threads do not load the same tiles over and over.
+   * @param readers  one reader per extra thread, only as many threads as readers are used
+   */
+  void set_thread_readers(const std::vector<std::shared_ptr<baldr::GraphReader>>& readers) {
+    thread_readers_ = readers;
+  }
+
+  /**
+   * Set a callback that will throw when the matrix computation should be aborted. Only the calling
+   * thread calls it, the extra threads stop once it throws.
+   * @param interrupt_callback  the function to periodically call to see if
+   *                            we should abort
+   */
+  void set_interrupt(const std::function<void()>* interrupt_callback) {
+    interrupt_ = interrupt_callback;
+  }
+
+  /**
+   * @return the number of threads a matrix may be computed with, including the calling thread
+   */
+  uint32_t thread_count() const {
+    return 1 + static_cast<uint32_t>(std::min(workers_.size(), thread_readers_.size()));
+  }
+
 protected:
   // Number of destinations that have been found and settled (least cost path
   // computed).
@@ -103,6 +189,21 @@ protected:
   // List of destinations
   std::vector<Destination> destinations_;
 
+  // Number of unsettled destinations without any path found so far, the cost threshold is only
+  // lowered once this reaches 0
+  uint32_t unfound_count_;
+
+  // Edge labels the searches from the origins of the current matrix created on this thread
+  size_t label_count_;
+
+  // Heaps of (best cost + threshold, destination index) of the destinations with a path, the first
+  // settles the cheapest ones the search has moved beyond and the second gives the most expensive
+  // one for the cost threshold. An entry is stale once its destination is settled or its best cost
+  // improved, which pushes a new entry. This keeps settling destinations from looking at all of
+  // them every time a destination edge is reached
+  std::vector<std::pair<float, uint32_t>> settle_heap_;
+  std::vector<std::pair<float, uint32_t>> threshold_heap_;
+
   // Current costing mode
   std::shared_ptr<sif::DynamicCost> costing_;
 
@@ -124,6 +225,14 @@ protected:
   // when doing timezone differencing a timezone cache speeds up the computation
   baldr::DateTime::tz_sys_info_cache_t tz_cache_;
 
+  // Matrices (each with their own labels, queue and edge status) and readers for the extra threads
+  // which compute rows of the matrix in parallel with the calling thread
+  std::vector<std::unique_ptr<TimeDistanceMatrix>> workers_;
+  std::vector<std::shared_ptr<baldr::GraphReader>> thread_readers_;
+
+  // the function to periodically call to see if the computation should be aborted
+  const std::function<void()>* interrupt_;
+
   /**
    * Reset all origin-specific information
    */
@@ -132,15 +241,18 @@ protected:
     for (auto& dest : destinations_) {
       dest.reset();
     }
+    settle_heap_.clear();
+    threshold_heap_.clear();
 
     // Clear the edge labels
+    label_count_ += edgelabels_.size();
     edgelabels_.clear();
 
     // Clear elements from the adjacency list
     adjacencylist_.clear();
 
-    // Clear the edge status flags
-    edgestatus_.clear();
+    // Clear the edge status flags, keeping the arrays around for the next origin
+    edgestatus_.clear(clear_reserved_memory_ ? 0 : max_reserved_labels_count_);
   };
 
   /**
@@ -157,6 +269,28 @@ protected:
                 const uint32_t matrix_locations = kAllLocations,
                 const bool invariant = false);
 
+  /**
+   * Runs the expansion from a single origin. InitDestinations must have been called before.
+   * @param  origin               The origin location.
+   * @param  time_info            Time info of the origin.
+   * @param  destinations         List of destination locations.
+   * @param  graphreader          Graph reader for accessing routing graph.
+   * @param  max_matrix_distance  Maximum arc-length distance for current mode.
+   * @param  matrix_locations     Number of destinations that must be found.
+   * @param  invariant            Whether invariant time was requested.
+   * @return time/distance from the origin to all destinations
+   */
+  template <const ExpansionType expansion_direction,
+            const bool FORWARD = expansion_direction == ExpansionType::forward>
+  std::vector<TimeDistance>
+  ComputeOneToMany(const valhalla::Location& origin,
+                   const baldr::TimeInfo& time_info,
+                   const google::protobuf::RepeatedPtrField<valhalla::Location>& destinations,
+                   baldr::GraphReader& graphreader,
+                   const float max_matrix_distance,
+                   const uint32_t matrix_locations,
+                   const bool invariant);
+
   /**
    * Expand from the node along the forward search path. Immediately expands
    * from the end node of any transition edge (so no transition edges are added
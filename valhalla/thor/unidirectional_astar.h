@@ -72,6 +72,15 @@ public:
       return "time_dependent_reverse_a*";
     }
   }
+  virtual size_t LabelCount() const override {
+    return edgelabels_.size();
+  }
+  virtual size_t QueueRedistributions() const override {
+    return adjacencylist_.redistributions();
+  }
+  virtual size_t HierarchyPrunedCount() const override {
+    return hierarchy_pruned_;
+  }
 
   /**
    * Set a maximum label count. The path algorithm terminates if this
@@ -172,6 +181,8 @@ protected:
 
   // Hierarchy limits.
   std::vector<sif::HierarchyLimits> hierarchy_limits_;
+  // How many expansions the hierarchy limits cut off
+  size_t hierarchy_pruned_;
 
   // A* heuristic
   AStarHeuristic astarheuristic_;
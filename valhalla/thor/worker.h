@@ -2,7 +2,11 @@
 #define __VALHALLA_THOR_SERVICE_H__
 
 #include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <boost/property_tree/ptree.hpp>
@@ -21,10 +25,15 @@
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/astar_bss.h>
 #include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/bidirectional_astar_bss.h>
 #include <valhalla/thor/centroid.h>
+#include <valhalla/thor/connection_scan.h>
 #include <valhalla/thor/costmatrix.h>
 #include <valhalla/thor/isochrone.h>
+#include <valhalla/thor/matrix_table.h>
 #include <valhalla/thor/multimodal.h>
+#include <valhalla/thor/response_cache.h>
+#include <valhalla/thor/search_tree_cache.h>
 #include <valhalla/thor/timedistancebssmatrix.h>
 #include <valhalla/thor/timedistancematrix.h>
 #include <valhalla/thor/triplegbuilder.h>
@@ -77,7 +86,7 @@ protected:
                                                     Location& origin,
                                                     Location& destination,
                                                     const std::string& costing,
-                                                    const Options& options);
+                                                    Api& api);
   void log_admin(const TripLeg&);
   thor::PathAlgorithm* get_path_algorithm(const std::string& routetype,
                                           const Location& origin,
@@ -92,12 +101,42 @@ protected:
    * @return the match results and scores
    */
   std::vector<std::tuple<float, float, std::vector<meili::MatchResult>>> map_match(Api& request);
+  /**
+   * Matches the parts of the trace between its breakages on this thread and the leg workers
+   * @param options  the options of the request to match
+   * @return the best match of the whole trace, nothing when the trace can't be matched that way
+   */
+  std::vector<meili::MatchResults> match_parts_in_parallel(const Options& options);
 
   void path_arrive_by(Api& api, const std::string& costing);
   void path_depart_at(Api& api, const std::string& costing);
+  bool path_legs_in_parallel(Api& api, const std::string& costing);
+  /**
+   * Routes the locations of the request with each of the costings of its comparisons on this thread
+   * and the leg workers and adds their routes to the trip after the one routed already
+   * @param api          the request whose trip gets the routes of the comparisons
+   * @param comparisons  a request per comparison, with the locations correlated for all of them
+   */
+  void path_comparisons(Api& api, std::vector<Api>& comparisons);
+  std::string
+  isochrones_per_location(Api& request,
+                          std::vector<midgard::GriddedData<2>::contour_interval_t>& contours,
+                          const ExpansionType expansion_type);
   void parse_measurements(const Api& request);
   std::string parse_costing(const Api& request);
 
+  /**
+   * Marks an algorithm as used by the current request. Once a request is done only the
+   * max_reserved_algorithms most recently used ones keep the memory they reserve for their next
+   * search, cleanup releases that of the others. Nothing is tracked without such a limit.
+   * @param algorithm  the algorithm about to search
+   */
+  void mark_used(PathAlgorithm& algorithm);
+  void mark_used(Dijkstras& algorithm);
+  void mark_used(TimeDistanceMatrix& algorithm);
+  void mark_used(TimeDistanceBSSMatrix& algorithm);
+  void mark_used(const void* algorithm, std::function<void()> release);
+
   void build_route(
       const std::deque<std::pair<std::vector<PathInfo>, std::vector<const meili::EdgeSegment*>>>&
           paths,
@@ -120,7 +159,9 @@ protected:
   // Path algorithms (TODO - perhaps use a map?))
   BidirectionalAStar bidir_astar;
   AStarBSSAlgorithm bss_astar;
+  BidirectionalAStarBSS bss_bidir_astar;
   MultiModalPathAlgorithm multi_modal_astar;
+  ConnectionScan connection_scan;
   TimeDepForward timedep_forward;
   TimeDepReverse timedep_reverse;
 
@@ -130,19 +171,54 @@ protected:
   TimeDistanceBSSMatrix time_distance_bss_matrix_;
 
   Isochrone isochrone_gen;
+  // the algorithms which keep memory reserved for their next search, least recently used first,
+  // with what releases it and how many of them may keep it (0 for all of them)
+  std::list<std::pair<const void*, std::function<void()>>> used_algorithms;
+  size_t max_reserved_algorithms;
   std::shared_ptr<meili::MapMatcher> matcher;
   float max_timedep_distance;
+  // from how far apart time dependent routes search from both ends rather than one
+  float bidirectional_timedep_distance;
+  // how many edges an expansion request may track at most (0 for no limit)
+  uint32_t max_expansion_edges;
+  // whether multimodal routes scan the timetable rather than search the graph
+  bool use_connection_scan;
+  // whether bike share routes search from both ends
+  bool use_bidirectional_bss;
+  uint32_t optimizer_threads;
+  uint32_t optimizer_max_time;
   std::unordered_map<std::string, float> max_matrix_distance;
   SOURCE_TO_TARGET_ALGORITHM source_to_target_algorithm;
   std::shared_ptr<baldr::GraphReader> reader;
+  // readers for the extra threads of the matrices and the centroid
+  std::vector<std::shared_ptr<baldr::GraphReader>> matrix_readers;
+  // workers for the extra threads routing the legs of a route or an optimized route or expanding
+  // the locations of per location isochrones
+  std::vector<std::unique_ptr<thor_worker_t>> leg_workers;
   meili::MapMatcherFactory matcher_factory;
   baldr::AttributesController controller;
   Centroid centroid_gen;
+  // responses of recent requests, cleared when live traffic is updated
+  ResponseCache response_cache;
+  // reverse searches of recent single target matrices, kept across requests and cleared when live
+  // traffic is updated
+  SearchTreeCache search_trees;
+  // the times and distances between the locations of the matrices asked for all the time, built
+  // ahead of time
+  std::shared_ptr<const MatrixTable> matrix_table;
+  // whether identical requests in flight at the same time share a single computation
+  bool coalesce_requests;
+  // what the path algorithms did since the worker started, the status action reports them
+  SearchCounters search_counters;
+  bool allow_verbose;
 
 private:
   std::string service_name() const override {
     return "thor";
   }
+  const baldr::GraphReader* graph_reader() const override {
+    return reader.get();
+  }
 };
 
 } // namespace thor
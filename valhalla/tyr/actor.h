@@ -2,11 +2,14 @@
 #define VALHALLA_TYR_ACTOR_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/costconstants.h>
 
 namespace valhalla {
 namespace tyr {
@@ -76,7 +79,10 @@ public:
   /**
    * Perform the matrix action and return json or protobuf depending on which was requested. The
    * request may either be in the form of a json string provided by the request_str parameter or
-   * contained in the api parameter as a deserialized protobuf object
+   * contained in the api parameter as a deserialized protobuf object. With
+   * thor.search_tree_cache_size set, the search of a many to one matrix is kept by the actor until
+   * thor.search_tree_ttl passes or traffic is updated, so that asking again about the same target
+   * with sources which moved, like a fleet of vehicles to a pickup, only grows that search
    * @param request_str  json string if json input is being used empty otherwise
    * @param interrupt    allows the underlying computation to be aborted via the functor throwing
    * @param api          protobuffer object which can contain the input request via the options object
@@ -143,6 +149,39 @@ public:
                                const std::function<void()>* interrupt = nullptr,
                                Api* api = nullptr);
 
+  /**
+   * Perform the trace_attributes action for a batch of traces. The traces are handed out to a pool
+   * of meili.batch_threads threads. Each thread has workers of its own which are kept between
+   * batches, and whose graphreaders share the mjolnir global synchronized tile cache. Every result
+   * is passed to the callback as soon as its trace is done, so they come back in no particular
+   * order. A trace that fails gets its serialized error as its result rather than failing the batch.
+   * @param requests   json strings, one per trace
+   * @param callback   called with the index of a request and its result, one call at a time
+   * @param interrupt  allows the underlying computation to be aborted via the functor throwing, it
+   *                   will be called from all of the threads
+   */
+  void trace_attributes(const std::vector<std::string>& requests,
+                        const std::function<void(size_t, const std::string&)>& callback,
+                        const std::function<void()>* interrupt = nullptr);
+
+  /**
+   * Recost a batch of paths under a batch of costings, every path under every costing, without
+   * searching the graph. The paths are handed out to the same threads as the batches of traces,
+   * whose graphreaders share the mjolnir global synchronized tile cache. A thread recosts its path
+   * under all of the costings in turn, so the tiles of the path are only ever fetched once.
+   * @param paths      the edges of each path in the order they are traversed
+   * @param costings   the costings, parsed like the recostings of a request (sif::ParseCosting)
+   * @param callback   called with the index of a path, the index of a costing and the elapsed cost
+   *                   at the end of each edge of the path, or nothing if the costing can't traverse
+   *                   the path, one call at a time and in no particular order
+   * @param interrupt  allows the underlying computation to be aborted via the functor throwing, it
+   *                   will be called from all of the threads
+   */
+  void recost(const std::vector<std::vector<baldr::GraphId>>& paths,
+              const std::vector<Costing>& costings,
+              const std::function<void(size_t, size_t, const std::vector<sif::Cost>&)>& callback,
+              const std::function<void()>* interrupt = nullptr);
+
   /**
    * Perform the height action and return json or protobuf depending on which was requested. The
    * request may either be in the form of a json string provided by the request_str parameter or
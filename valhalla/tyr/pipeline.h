@@ -0,0 +1,69 @@
+#ifndef VALHALLA_TYR_PIPELINE_H_
+#define VALHALLA_TYR_PIPELINE_H_
+
+#include <memory>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/loki/worker.h>
+#include <valhalla/odin/worker.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/thor/worker.h>
+#include <valhalla/worker.h>
+
+namespace valhalla {
+namespace tyr {
+
+#ifdef HAVE_HTTP
+/**
+ * Runs a pipeline worker taking requests from the loki proxy and answering them to the http server
+ * @param config  used to configure the loki/thor/odin stages and their graphreader
+ */
+void run_service(const boost::property_tree::ptree& config);
+#endif
+
+/**
+ * Runs the loki, thor and odin stages of a request one after the other on the same request object.
+ * When every stage lives in the same process this saves serializing the request to bytes and
+ * parsing it again between each of them, as well as the hops through their proxies.
+ */
+class pipeline_worker_t : public service_worker_t {
+public:
+  pipeline_worker_t(const boost::property_tree::ptree& config,
+                    const std::shared_ptr<baldr::GraphReader>& graph_reader = {});
+  virtual ~pipeline_worker_t();
+#ifdef HAVE_HTTP
+  virtual prime_server::worker_t::result_t work(const std::list<zmq::message_t>& job,
+                                                void* request_info,
+                                                const std::function<void()>& interrupt) override;
+#endif
+  virtual void cleanup() override;
+
+  /**
+   * Runs all the stages of the action in the request options
+   * @param request  the parsed request, filled out as the stages process it
+   * @return json or pbf bytes depending on what was specified in the options object
+   */
+  std::string act(Api& request);
+
+  void set_interrupt(const std::function<void()>* interrupt) override;
+
+protected:
+  std::shared_ptr<baldr::GraphReader> reader;
+  loki::loki_worker_t loki_worker;
+  thor::thor_worker_t thor_worker;
+  odin::odin_worker_t odin_worker;
+  // the code of unexpected errors, it depends on which stage is running
+  unsigned stage_error_code;
+
+private:
+  std::string service_name() const override {
+    return "pipeline";
+  }
+};
+
+} // namespace tyr
+} // namespace valhalla
+
+#endif // VALHALLA_TYR_PIPELINE_H_
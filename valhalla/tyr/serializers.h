@@ -30,7 +30,7 @@ std::string serializeDirections(Api& request);
 /**
  * Turn a time distance matrix into json that one can look up location pair results from
  */
-std::string serializeMatrix(const Api& request,
+std::string serializeMatrix(Api& request,
                             const std::vector<thor::TimeDistance>& time_distances,
                             double distance_scale,
                             thor::MatrixType matrix_type);
@@ -38,14 +38,17 @@ std::string serializeMatrix(const Api& request,
 /**
  * Turn grid data contours into geojson
  *
- * @param grid_contours    the contours generated from the grid
- * @param colors           the #ABC123 hex string color used in geojson fill color
+ * @param grid_contours       the contours generated from the grid
+ * @param colors              the #ABC123 hex string color used in geojson fill color
+ * @param interval_locations  for isochrones per location the location of each interval, the
+ *                            intervals of each location come one after the other
  */
-std::string serializeIsochrones(const Api& request,
+std::string serializeIsochrones(Api& request,
                                 std::vector<midgard::GriddedData<2>::contour_interval_t>& intervals,
                                 midgard::GriddedData<2>::contours_t& contours,
                                 bool polygons = true,
-                                bool show_locations = false);
+                                bool show_locations = false,
+                                const std::vector<uint32_t>& interval_locations = {});
 
 /**
  * Turn heights and ranges into a height response
@@ -54,7 +57,7 @@ std::string serializeIsochrones(const Api& request,
  * @param heights  The actual height at each shape point
  * @param ranges   The distances between each point. If this is empty no ranges are serialized
  */
-std::string serializeHeight(const Api& request,
+std::string serializeHeight(Api& request,
                             const std::vector<double>& heights,
                             const std::vector<double>& ranges = {});
 
@@ -136,6 +139,10 @@ namespace osrm {
  */
 valhalla::baldr::json::MapPtr
 waypoint(const valhalla::Location& location, bool is_tracepoint = false, bool is_optimized = false);
+void waypoint(const valhalla::Location& location,
+              rapidjson::writer_wrapper_t& writer,
+              bool is_tracepoint = false,
+              bool is_optimized = false);
 
 /*
  * Serialize locations into osrm waypoints
@@ -144,6 +151,10 @@ valhalla::baldr::json::ArrayPtr
 waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
           bool tracepoints = false);
 valhalla::baldr::json::ArrayPtr waypoints(const valhalla::Trip& locations);
+void waypoints(const char* name,
+               const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               rapidjson::writer_wrapper_t& writer,
+               bool tracepoints = false);
 valhalla::baldr::json::ArrayPtr intermediate_waypoints(const valhalla::TripLeg& leg);
 
 void serializeIncidentProperties(rapidjson::Writer<rapidjson::StringBuffer>& writer,
@@ -1,9 +1,12 @@
 #ifndef __VALHALLA_SERVICE_H__
 #define __VALHALLA_SERVICE_H__
 #include <string>
+#include <vector>
 
+#include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/json.h>
 #include <valhalla/baldr/rapidjson_utils.h>
+#include <valhalla/midgard/allocation_stats.h>
 #include <valhalla/midgard/util.h>
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/valhalla.h>
@@ -78,6 +81,95 @@ std::string serialize_error(const valhalla_exception_t& exception, Api& options)
 // function to add warnings to proto info object
 void add_warning(valhalla::Api& api, unsigned code);
 
+/**
+ * Adds the time one phase of the request took to its statistics, they go to statsd along with the
+ * latency of each service. Phases are named by the service and then what it does, e.g. loki.search
+ *
+ * @param api           the request whose statistics get the timing
+ * @param phase         the name of the phase
+ * @param milliseconds  how long the phase took
+ */
+void record_phase(Api& api, const std::string& phase, double milliseconds);
+
+/**
+ * Times one phase of the request from now until the returned object goes out of scope
+ *
+ * @param api    the request whose statistics get the timing
+ * @param phase  the name of the phase
+ * @return an object whose destructor records the elapsed time since construction
+ */
+midgard::Finally<std::function<void()>> measure_phase(Api& api, const std::string& phase);
+
+/**
+ * Adds how much work a phase did to the statistics of the request, e.g. the labels an expansion
+ * created. It goes to statsd as a timing so that its distribution is kept rather than only its
+ * last value
+ *
+ * @param api     the request whose statistics get the amount
+ * @param phase   the name of the phase
+ * @param metric  what was counted
+ * @param amount  how much of it
+ */
+void record_phase_amount(Api& api,
+                         const std::string& phase,
+                         const std::string& metric,
+                         double amount);
+
+/**
+ * Adds what a phase allocated to the statistics of the request as the amounts allocations,
+ * allocated_bytes and peak_bytes of the phase. Only builds with ENABLE_ALLOCATION_STATS measure
+ * them, measure_phase and the latency of each service record them there
+ *
+ * @param api          the request whose statistics get the amounts
+ * @param phase        the name of the phase or of the service
+ * @param allocations  what the phase allocated
+ */
+void record_allocations(Api& api,
+                        const std::string& phase,
+                        const midgard::allocation_stats_t& allocations);
+
+/**
+ * Adds what the tile cache of a reader did between two snapshots of its counters to the statistics
+ * of the request. The hits, misses, evictions and loads go to statsd as counts keyed
+ * action.info.service.tile_cache.counter and the time spent loading as a tile_load phase
+ *
+ * @param api      the request whose statistics get the counters
+ * @param service  the name of the service which owns the reader
+ * @param before   the counters when the service started on the request
+ * @param after    the counters when it was done with it
+ */
+void record_tile_cache(Api& api,
+                       const std::string& service,
+                       const baldr::GraphReader::CacheStats& before,
+                       const baldr::GraphReader::CacheStats& after);
+
+/**
+ * Adds the tile cache counters of a service since it started to the status of the request
+ *
+ * @param api      the status request
+ * @param service  the name of the service which owns the reader
+ * @param reader   the reader of the service
+ * @return the counters of the service so that more can be added to them
+ */
+ServiceCounters* add_service_counters(Api& api,
+                                      const std::string& service,
+                                      const baldr::GraphReader& reader);
+
+/**
+ * Reads the tiles listed in the file named by mjolnir.warmup.tiles with mjolnir.warmup.threads
+ * threads so that a service does not take traffic on cold tiles. Each line of the list is a tile
+ * id, level/tileid, or a tile path and may be followed by how often the tile is used, as in a
+ * heatmap or the mjolnir.tile_usage file, in which case the most used tiles are read first. Only
+ * the first mjolnir.warmup.max_tiles are read if that is set. Does nothing without a list
+ *
+ * @param reader   the reader of the service
+ * @param config   the whole config
+ * @param service  the name of the service, for the log
+ */
+void warm_up(baldr::GraphReader& reader,
+             const boost::property_tree::ptree& config,
+             const std::string& service);
+
 #ifdef HAVE_HTTP
 prime_server::worker_t::result_t serialize_error(const valhalla_exception_t& exception,
                                                  prime_server::http_request_info_t& request_info,
@@ -95,6 +187,38 @@ prime_server::worker_t::result_t to_response(const std::string& data,
                                              const Api& options);
 #endif
 
+/**
+ * Keeps the protobuf objects of one request after another on the same arena. A request object and
+ * everything hanging off of it (legs, nodes, maneuvers...) is carved out of a few large blocks
+ * rather than being allocated piece by piece, and all of it is let go at once when the next
+ * request starts. The first block is owned by this object so it is reused across requests
+ */
+class api_arena_t {
+public:
+  /**
+   * @param initial_block_size  the size of the block which is kept from request to request
+   */
+  explicit api_arena_t(size_t initial_block_size = kInitialBlockSize);
+
+  /**
+   * Frees everything that was allocated for the previous request and creates a new request object.
+   * References to the previous one are invalid afterwards
+   * @return the new request object
+   */
+  Api& next();
+
+  /**
+   * Frees everything that was allocated for the last request
+   */
+  void reset();
+
+  static constexpr size_t kInitialBlockSize = 1 << 20;
+
+private:
+  std::vector<char> initial_block_;
+  google::protobuf::Arena arena_;
+};
+
 struct statsd_client_t;
 class service_worker_t {
 public:
@@ -133,6 +257,21 @@ public:
    */
   virtual void set_interrupt(const std::function<void()>* interrupt);
 
+  /**
+   * Gives the request the default deadline of the service unless it already has an earlier one and
+   * wraps the interrupt so that it also throws once the deadline has passed. Path algorithms call
+   * the interrupt every few thousand expansions, so a request which runs out of time stops soon
+   * after instead of working on a response nobody waits for anymore.
+   * @param  request       the request, its deadline is set from the default timeout if need be
+   * @param  interrupt     the interrupt of prime_server, may be null
+   * @param  timeout_code  the code of the error thrown once the deadline has passed
+   * @return the interrupt to use for the request
+   * @throws valhalla_exception_t with the timeout code if the deadline has already passed
+   */
+  const std::function<void()>* watch_deadline(Api& request,
+                                              const std::function<void()>* interrupt,
+                                              unsigned timeout_code);
+
 protected:
   /**
    * This converts each protobuf stat into a string and adds it to the queue of unsent stats
@@ -154,13 +293,43 @@ protected:
    */
   midgard::Finally<std::function<void()>> measure_scope_time(Api& api) const;
 
+  /**
+   * Adds what the requests measured by measure_scope_time allocated so far to the status counters
+   * of the service, only builds with ENABLE_ALLOCATION_STATS have any
+   *
+   * @param counters  the status counters of the service
+   */
+  void add_allocation_counters(ServiceCounters& counters) const;
+
+  /**
+   * Returns the reader whose tile cache counters are recorded along with the time each action
+   * takes, services which do not read tiles have none
+   */
+  virtual const baldr::GraphReader* graph_reader() const {
+    return nullptr;
+  }
+
   /**
    * Signals the start of the worker, sends statsd message if so configured
    */
   void started();
 
   const std::function<void()>* interrupt;
+  // the interrupt wrapped to check the deadline of the request, see watch_deadline
+  std::function<void()> deadline_interrupt;
+  // milliseconds a request may take when it has no earlier deadline, 0 for no limit
+  uint64_t default_timeout;
   std::unique_ptr<statsd_client_t> statsd_client;
+  // what the requests of this worker allocated, a worker handles one request at a time
+  struct allocation_totals_t {
+    uint64_t requests = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t max_peak_bytes = 0;
+  };
+  mutable allocation_totals_t allocation_totals;
+  // where the request object of each job lives, it is reset in cleanup
+  api_arena_t api_arena;
 };
 } // namespace valhalla
 